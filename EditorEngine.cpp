@@ -1,6 +1,7 @@
 #include "EditorEngine.h"
 #include "Objects/Settings.h"
 #include "Objects/SystemVariableManager.h"
+#include "Objects/StartupTimeline.h"
 
 namespace ed
 {
@@ -8,14 +9,20 @@ namespace ed
 		m_ui(&m_interface, wnd, gl),
 		m_interface(&m_ui)
 	{
+		StartupTimeline::Instance().Mark("UI");
+
+		// projects can use the items & languages that plugins add so these have to be loaded before the template
 		m_interface.Plugins.Init(&m_interface, &m_ui); // load plugins (TODO: maybe move this to the splash screen)
+		StartupTimeline::Instance().Mark("Plugins");
 	}
 	void EditorEngine::Create()
 	{
 		m_ui.LoadSettings();
+		StartupTimeline::Instance().Mark("Settings & themes");
 
-		// load template
+		// load template - only queues the shaders, they are compiled on the workers
 		m_interface.Pipeline.New();
+		StartupTimeline::Instance().Mark("Template");
 	}
 	void EditorEngine::OnEvent(const SDL_Event& e)
 	{
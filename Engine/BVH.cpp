@@ -0,0 +1,141 @@
+#include "BVH.h"
+#include "Ray.h"
+
+#include <algorithm>
+#include <limits>
+
+#define BVH_LEAF_SIZE 4
+#define BVH_STACK_SIZE 64
+
+namespace ed
+{
+	namespace eng
+	{
+		static inline const glm::vec3& getPosition(const void* vertices, size_t stride, unsigned int index)
+		{
+			return *(const glm::vec3*)((const char*)vertices + index * stride);
+		}
+		static inline bool intersectNode(const glm::vec3& minb, const glm::vec3& maxb, const glm::vec3& orig, const glm::vec3& invDir, float maxDist)
+		{
+			glm::vec3 t0 = (minb - orig) * invDir;
+			glm::vec3 t1 = (maxb - orig) * invDir;
+			glm::vec3 tmin = glm::min(t0, t1);
+			glm::vec3 tmax = glm::max(t0, t1);
+
+			float enter = std::max<float>(std::max<float>(tmin.x, tmin.y), std::max<float>(tmin.z, 0.0f));
+			float exit = std::min<float>(std::min<float>(tmax.x, tmax.y), std::min<float>(tmax.z, maxDist));
+
+			return enter <= exit;
+		}
+
+		void BVH::Build(const void* vertices, size_t stride, const unsigned int* indices, size_t triCount)
+		{
+			Clear();
+
+			if (triCount == 0)
+				return;
+
+			std::vector<glm::vec3> centroids(triCount);
+			m_tris.resize(triCount);
+			for (unsigned int i = 0; i < triCount; i++) {
+				m_tris[i] = i;
+				centroids[i] = (getPosition(vertices, stride, indices[i * 3 + 0]) +
+					getPosition(vertices, stride, indices[i * 3 + 1]) +
+					getPosition(vertices, stride, indices[i * 3 + 2])) / 3.0f;
+			}
+
+			m_nodes.reserve(2 * (triCount / BVH_LEAF_SIZE) + 1);
+			m_nodes.push_back(Node());
+			m_build(0, 0, triCount, vertices, stride, indices, centroids);
+		}
+		void BVH::Clear()
+		{
+			m_nodes.clear();
+			m_tris.clear();
+		}
+		void BVH::m_build(unsigned int node, unsigned int start, unsigned int count, const void* vertices, size_t stride, const unsigned int* indices, const std::vector<glm::vec3>& centroids)
+		{
+			glm::vec3 minb(std::numeric_limits<float>::infinity()), maxb(-std::numeric_limits<float>::infinity());
+			glm::vec3 cmin = minb, cmax = maxb;
+			for (unsigned int i = start; i < start + count; i++) {
+				unsigned int tri = m_tris[i];
+				for (int j = 0; j < 3; j++) {
+					const glm::vec3& pos = getPosition(vertices, stride, indices[tri * 3 + j]);
+					minb = glm::min(minb, pos);
+					maxb = glm::max(maxb, pos);
+				}
+				cmin = glm::min(cmin, centroids[tri]);
+				cmax = glm::max(cmax, centroids[tri]);
+			}
+
+			m_nodes[node].Min = minb;
+			m_nodes[node].Max = maxb;
+
+			// split along the longest axis of the centroid bounds
+			glm::vec3 extent = cmax - cmin;
+			int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+			if (count <= BVH_LEAF_SIZE || extent[axis] <= 0.0f) {
+				m_nodes[node].Start = start;
+				m_nodes[node].Count = count;
+				return;
+			}
+
+			unsigned int half = count / 2;
+			std::nth_element(m_tris.begin() + start, m_tris.begin() + start + half, m_tris.begin() + start + count, [&](unsigned int a, unsigned int b) {
+				return centroids[a][axis] < centroids[b][axis];
+			});
+
+			unsigned int left = m_nodes.size();
+			m_nodes.push_back(Node());
+			m_nodes.push_back(Node());
+			m_nodes[node].Start = left;
+			m_nodes[node].Count = 0;
+
+			m_build(left, start, half, vertices, stride, indices, centroids);
+			m_build(left + 1, start + half, count - half, vertices, stride, indices, centroids);
+		}
+		bool BVH::Intersect(glm::vec3 orig, glm::vec3 dir, const void* vertices, size_t stride, const unsigned int* indices, float& distHit, float maxDist) const
+		{
+			if (m_nodes.empty())
+				return false;
+
+			dir = glm::normalize(dir);
+			glm::vec3 invDir = 1.0f / dir;
+
+			bool hit = false;
+			float best = maxDist;
+
+			unsigned int stack[BVH_STACK_SIZE];
+			int stackSize = 0;
+			stack[stackSize++] = 0;
+
+			while (stackSize > 0) {
+				const Node& node = m_nodes[stack[--stackSize]];
+				if (!intersectNode(node.Min, node.Max, orig, invDir, best))
+					continue;
+
+				if (node.Count > 0) {
+					for (unsigned int i = node.Start; i < node.Start + node.Count; i++) {
+						unsigned int tri = m_tris[i];
+						float triDist;
+						if (ray::IntersectTriangle(orig, dir,
+								getPosition(vertices, stride, indices[tri * 3 + 0]),
+								getPosition(vertices, stride, indices[tri * 3 + 1]),
+								getPosition(vertices, stride, indices[tri * 3 + 2]), triDist) && triDist < best) {
+							best = triDist;
+							hit = true;
+						}
+					}
+				} else if (stackSize + 2 <= BVH_STACK_SIZE) {
+					stack[stackSize++] = node.Start + 1;
+					stack[stackSize++] = node.Start;
+				}
+			}
+
+			if (hit)
+				distHit = best;
+
+			return hit;
+		}
+	}
+}
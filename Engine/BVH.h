@@ -0,0 +1,37 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace ed
+{
+	namespace eng
+	{
+		// bounding volume hierarchy over an indexed triangle list - only the tree is stored,
+		// the vertex data is passed to each call (position = first member of each vertex)
+		class BVH
+		{
+		public:
+			void Build(const void* vertices, size_t stride, const unsigned int* indices, size_t triCount);
+			void Clear();
+
+			// closest hit that is nearer than maxDist
+			bool Intersect(glm::vec3 orig, glm::vec3 dir, const void* vertices, size_t stride, const unsigned int* indices, float& distHit, float maxDist) const;
+
+			inline bool IsEmpty() const { return m_nodes.empty(); }
+
+		private:
+			struct Node
+			{
+				glm::vec3 Min;
+				unsigned int Start; // first triangle or left child (right child = Start + 1)
+				glm::vec3 Max;
+				unsigned int Count; // 0 -> inner node
+			};
+
+			void m_build(unsigned int node, unsigned int start, unsigned int count, const void* vertices, size_t stride, const unsigned int* indices, const std::vector<glm::vec3>& centroids);
+
+			std::vector<Node> m_nodes;
+			std::vector<unsigned int> m_tris;
+		};
+	}
+}
@@ -0,0 +1,504 @@
+#include "CompressedTexture.h"
+
+#include <algorithm>
+#include <fstream>
+#include <string.h>
+
+#define HEADER_READ_SIZE 512
+#define MAX_TEXTURE_SIZE 65536 // larger dimensions are treated as a broken header
+
+namespace ed
+{
+	namespace eng
+	{
+		struct FormatInfo
+		{
+			GLenum InternalFormat;
+			int BlockWidth, BlockHeight, BlockSize; // 1x1 blocks for the uncompressed formats
+		};
+
+		static inline uint32_t readU32(const std::vector<unsigned char>& data, size_t offset)
+		{
+			if (offset + 4 > data.size())
+				return 0;
+			return data[offset] | (data[offset + 1] << 8) | (data[offset + 2] << 16) | ((uint32_t)data[offset + 3] << 24);
+		}
+		static inline uint64_t readU64(const std::vector<unsigned char>& data, size_t offset)
+		{
+			return readU32(data, offset) | ((uint64_t)readU32(data, offset + 4) << 32);
+		}
+		static inline uint32_t fourCC(const char* str)
+		{
+			return str[0] | (str[1] << 8) | (str[2] << 16) | ((uint32_t)str[3] << 24);
+		}
+		static inline size_t getLevelSize(const FormatInfo& fmt, glm::ivec2 size)
+		{
+			size_t blocksX = (size.x + fmt.BlockWidth - 1) / fmt.BlockWidth;
+			size_t blocksY = (size.y + fmt.BlockHeight - 1) / fmt.BlockHeight;
+			return blocksX * blocksY * fmt.BlockSize;
+		}
+		static inline glm::ivec2 getLevelDimensions(glm::ivec2 size, int level)
+		{
+			return glm::ivec2(std::max<int>(size.x >> level, 1), std::max<int>(size.y >> level, 1));
+		}
+		// checks the size & counts from a KTX header - returns the error or nullptr, levels past the 1x1 one are dropped
+		static const char* checkLayout(glm::ivec2 size, uint32_t faces, uint32_t& levels)
+		{
+			if (size.x <= 0 || size.y <= 0 || size.x > MAX_TEXTURE_SIZE || size.y > MAX_TEXTURE_SIZE)
+				return "invalid texture size";
+			if (faces != 1 && faces != 6)
+				return "only 2D textures and cube maps are supported";
+
+			uint32_t maxLevels = 1;
+			for (int s = std::max(size.x, size.y); s > 1; s >>= 1)
+				maxLevels++;
+			levels = std::min(std::max<uint32_t>(levels, 1), maxLevels);
+
+			return nullptr;
+		}
+		static bool getFormatInfo(GLenum internalFormat, FormatInfo& info)
+		{
+			info.InternalFormat = internalFormat;
+			info.BlockWidth = info.BlockHeight = 4;
+
+			switch (internalFormat) {
+			case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+			case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+			case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+			case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+			case GL_COMPRESSED_RED_RGTC1:
+			case GL_COMPRESSED_SIGNED_RED_RGTC1:
+				info.BlockSize = 8;
+				return true;
+			case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+			case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+			case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT:
+			case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+			case GL_COMPRESSED_RG_RGTC2:
+			case GL_COMPRESSED_SIGNED_RG_RGTC2:
+			case GL_COMPRESSED_RGBA_BPTC_UNORM:
+			case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+			case GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
+			case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+				info.BlockSize = 16;
+				return true;
+			case GL_RGBA8:
+			case GL_SRGB8_ALPHA8:
+				info.BlockWidth = info.BlockHeight = 1;
+				info.BlockSize = 4;
+				return true;
+			}
+
+			// ASTC - 0x93B0 (4x4) ... 0x93BD (12x12), sRGB variants start at 0x93D0
+			static const int astcBlocks[14][2] = {
+				{ 4, 4 }, { 5, 4 }, { 5, 5 }, { 6, 5 }, { 6, 6 }, { 8, 5 }, { 8, 6 },
+				{ 8, 8 }, { 10, 5 }, { 10, 6 }, { 10, 8 }, { 10, 10 }, { 12, 10 }, { 12, 12 }
+			};
+			int astcIndex = -1;
+			if (internalFormat >= GL_COMPRESSED_RGBA_ASTC_4x4_KHR && internalFormat <= GL_COMPRESSED_RGBA_ASTC_12x12_KHR)
+				astcIndex = internalFormat - GL_COMPRESSED_RGBA_ASTC_4x4_KHR;
+			else if (internalFormat >= GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR && internalFormat <= GL_COMPRESSED_SRGB8_ALPHA8_ASTC_12x12_KHR)
+				astcIndex = internalFormat - GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR;
+
+			if (astcIndex >= 0 && astcIndex < 14) {
+				info.BlockWidth = astcBlocks[astcIndex][0];
+				info.BlockHeight = astcBlocks[astcIndex][1];
+				info.BlockSize = 16;
+				return true;
+			}
+
+			return false;
+		}
+		static GLenum getFormatFromDXGI(uint32_t dxgi)
+		{
+			switch (dxgi) {
+			case 28: return GL_RGBA8;									// R8G8B8A8_UNORM
+			case 29: return GL_SRGB8_ALPHA8;							// R8G8B8A8_UNORM_SRGB
+			case 71: return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;			// BC1_UNORM
+			case 72: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT;		// BC1_UNORM_SRGB
+			case 74: return GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;			// BC2_UNORM
+			case 75: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT;		// BC2_UNORM_SRGB
+			case 77: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;			// BC3_UNORM
+			case 78: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;		// BC3_UNORM_SRGB
+			case 80: return GL_COMPRESSED_RED_RGTC1;					// BC4_UNORM
+			case 81: return GL_COMPRESSED_SIGNED_RED_RGTC1;				// BC4_SNORM
+			case 83: return GL_COMPRESSED_RG_RGTC2;						// BC5_UNORM
+			case 84: return GL_COMPRESSED_SIGNED_RG_RGTC2;				// BC5_SNORM
+			case 95: return GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT;		// BC6H_UF16
+			case 96: return GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT;		// BC6H_SF16
+			case 98: return GL_COMPRESSED_RGBA_BPTC_UNORM;				// BC7_UNORM
+			case 99: return GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;		// BC7_UNORM_SRGB
+			}
+			return 0;
+		}
+		static GLenum getFormatFromVulkan(uint32_t vk)
+		{
+			switch (vk) {
+			case 37: return GL_RGBA8;									// R8G8B8A8_UNORM
+			case 43: return GL_SRGB8_ALPHA8;							// R8G8B8A8_SRGB
+			case 131: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;			// BC1_RGB_UNORM_BLOCK
+			case 132: return GL_COMPRESSED_SRGB_S3TC_DXT1_EXT;			// BC1_RGB_SRGB_BLOCK
+			case 133: return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;			// BC1_RGBA_UNORM_BLOCK
+			case 134: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT;	// BC1_RGBA_SRGB_BLOCK
+			case 135: return GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;			// BC2_UNORM_BLOCK
+			case 136: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT;	// BC2_SRGB_BLOCK
+			case 137: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;			// BC3_UNORM_BLOCK
+			case 138: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;	// BC3_SRGB_BLOCK
+			case 139: return GL_COMPRESSED_RED_RGTC1;					// BC4_UNORM_BLOCK
+			case 140: return GL_COMPRESSED_SIGNED_RED_RGTC1;			// BC4_SNORM_BLOCK
+			case 141: return GL_COMPRESSED_RG_RGTC2;					// BC5_UNORM_BLOCK
+			case 142: return GL_COMPRESSED_SIGNED_RG_RGTC2;				// BC5_SNORM_BLOCK
+			case 143: return GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT;		// BC6H_UFLOAT_BLOCK
+			case 144: return GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT;		// BC6H_SFLOAT_BLOCK
+			case 145: return GL_COMPRESSED_RGBA_BPTC_UNORM;				// BC7_UNORM_BLOCK
+			case 146: return GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;		// BC7_SRGB_BLOCK
+			}
+
+			// ASTC_4x4_UNORM_BLOCK (157) ... ASTC_12x12_SRGB_BLOCK (184) - UNORM and SRGB alternate
+			if (vk >= 157 && vk <= 184) {
+				uint32_t index = (vk - 157) / 2;
+				bool srgb = (vk - 157) % 2 == 1;
+				return (srgb ? GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR : GL_COMPRESSED_RGBA_ASTC_4x4_KHR) + index;
+			}
+
+			return 0;
+		}
+		static bool readFile(const std::string& path, std::vector<unsigned char>& data, bool headerOnly)
+		{
+			std::ifstream file(path, std::ios::binary | std::ios::ate);
+			if (!file.is_open())
+				return false;
+
+			size_t size = file.tellg();
+			if (headerOnly)
+				size = std::min<size_t>(size, HEADER_READ_SIZE);
+
+			data.resize(size);
+			file.seekg(0, std::ios::beg);
+			file.read((char*)data.data(), size);
+
+			return true;
+		}
+
+		CompressedTexture::CompressedTexture()
+		{
+			Size = glm::ivec2(0, 0);
+			InternalFormat = 0;
+			Format = GL_RGBA;
+			Type = GL_UNSIGNED_BYTE;
+			Compressed = true;
+			LevelCount = FaceCount = 0;
+		}
+		bool CompressedTexture::IsSupportedFile(const std::string& path)
+		{
+			size_t dot = path.find_last_of('.');
+			if (dot == std::string::npos)
+				return false;
+
+			std::string ext = path.substr(dot + 1);
+			std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+
+			return ext == "dds" || ext == "ktx" || ext == "ktx2";
+		}
+		bool CompressedTexture::LoadFromFile(const std::string& path, bool headerOnly)
+		{
+			Levels.clear();
+			m_error = "";
+
+			std::vector<unsigned char> file;
+			if (!readFile(path, file, headerOnly)) {
+				m_error = "failed to open the file";
+				return false;
+			}
+
+			static const unsigned char ktxID[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+			static const unsigned char ktx2ID[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+			bool ret = false;
+			if (file.size() >= 4 && readU32(file, 0) == fourCC("DDS "))
+				ret = m_loadDDS(file, headerOnly);
+			else if (file.size() >= 12 && memcmp(file.data(), ktxID, 12) == 0)
+				ret = m_loadKTX(file, headerOnly);
+			else if (file.size() >= 12 && memcmp(file.data(), ktx2ID, 12) == 0)
+				ret = m_loadKTX2(file, headerOnly);
+			else
+				m_error = "unknown file format";
+
+			if (ret) {
+				FormatInfo info;
+				Compressed = InternalFormat != GL_RGBA8 && InternalFormat != GL_SRGB8_ALPHA8;
+				if (!getFormatInfo(InternalFormat, info)) {
+					m_error = "unsupported texture format";
+					ret = false;
+				}
+			}
+
+			return ret;
+		}
+		bool CompressedTexture::IsFormatSupported()
+		{
+			if (InternalFormat >= GL_COMPRESSED_RGBA_ASTC_4x4_KHR && InternalFormat <= GL_COMPRESSED_SRGB8_ALPHA8_ASTC_12x12_KHR)
+				return GLEW_KHR_texture_compression_astc_ldr;
+
+			switch (InternalFormat) {
+			case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+			case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+			case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+			case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+				return GLEW_EXT_texture_compression_s3tc;
+			case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+			case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+			case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT:
+			case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+				return GLEW_EXT_texture_compression_s3tc && GLEW_EXT_texture_sRGB;
+			case GL_COMPRESSED_RGBA_BPTC_UNORM:
+			case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+			case GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
+			case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+				return GLEW_ARB_texture_compression_bptc;
+			}
+
+			return true; // RGTC and RGBA8 are core in 3.3
+		}
+		void CompressedTexture::Upload(GLenum target, int face)
+		{
+			for (int i = 0; i < LevelCount; i++) {
+				const Level& level = Levels[face * LevelCount + i];
+				if (Compressed)
+					glCompressedTexImage2D(target, i, InternalFormat, level.Size.x, level.Size.y, 0, level.Data.size(), level.Data.data());
+				else
+					glTexImage2D(target, i, InternalFormat, level.Size.x, level.Size.y, 0, Format, Type, level.Data.data());
+			}
+		}
+		bool CompressedTexture::m_loadDDS(const std::vector<unsigned char>& file, bool headerOnly)
+		{
+			// DDS_HEADER starts after the magic number
+			if (file.size() < 128 || readU32(file, 4) != 124) {
+				m_error = "invalid DDS header";
+				return false;
+			}
+
+			Size = glm::ivec2(readU32(file, 16), readU32(file, 12));
+			LevelCount = std::max<int>(readU32(file, 28), 1);
+			uint32_t pfFlags = readU32(file, 80);
+			uint32_t pfFourCC = readU32(file, 84);
+			uint32_t caps2 = readU32(file, 112);
+			size_t offset = 128;
+
+			FaceCount = (caps2 & 0x200) ? 6 : 1; // DDSCAPS2_CUBEMAP
+			Format = GL_RGBA;
+			Type = GL_UNSIGNED_BYTE;
+
+			if (pfFlags & 0x4) { // DDPF_FOURCC
+				if (pfFourCC == fourCC("DXT1")) InternalFormat = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+				else if (pfFourCC == fourCC("DXT3")) InternalFormat = GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+				else if (pfFourCC == fourCC("DXT5")) InternalFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+				else if (pfFourCC == fourCC("ATI1") || pfFourCC == fourCC("BC4U")) InternalFormat = GL_COMPRESSED_RED_RGTC1;
+				else if (pfFourCC == fourCC("BC4S")) InternalFormat = GL_COMPRESSED_SIGNED_RED_RGTC1;
+				else if (pfFourCC == fourCC("ATI2") || pfFourCC == fourCC("BC5U")) InternalFormat = GL_COMPRESSED_RG_RGTC2;
+				else if (pfFourCC == fourCC("BC5S")) InternalFormat = GL_COMPRESSED_SIGNED_RG_RGTC2;
+				else if (pfFourCC == fourCC("DX10")) {
+					// DDS_HEADER_DXT10
+					if (file.size() < 148) {
+						m_error = "invalid DX10 header";
+						return false;
+					}
+
+					InternalFormat = getFormatFromDXGI(readU32(file, 128));
+					if (readU32(file, 136) & 0x4) // DDS_RESOURCE_MISC_TEXTURECUBE
+						FaceCount = 6;
+					offset = 148;
+				}
+			} else if ((pfFlags & 0x40) && readU32(file, 88) == 32) { // DDPF_RGB, 32 bits
+				InternalFormat = GL_RGBA8;
+				if (readU32(file, 92) == 0x00FF0000) // red mask -> BGRA
+					Format = GL_BGRA;
+			}
+
+			if (InternalFormat == 0) {
+				m_error = "unsupported DDS pixel format";
+				return false;
+			}
+
+			if (headerOnly)
+				return true;
+
+			FormatInfo info;
+			if (!getFormatInfo(InternalFormat, info)) {
+				m_error = "unsupported DDS pixel format";
+				return false;
+			}
+
+			// faces are stored one after another, each with its whole mip chain
+			for (int face = 0; face < FaceCount; face++) {
+				for (int i = 0; i < LevelCount; i++) {
+					Level level;
+					level.Size = getLevelDimensions(Size, i);
+					size_t levelSize = getLevelSize(info, level.Size);
+
+					if (offset + levelSize > file.size()) {
+						m_error = "DDS file is too small";
+						return false;
+					}
+
+					level.Data.assign(file.begin() + offset, file.begin() + offset + levelSize);
+					Levels.push_back(level);
+					offset += levelSize;
+				}
+			}
+
+			return true;
+		}
+		bool CompressedTexture::m_loadKTX(const std::vector<unsigned char>& file, bool headerOnly)
+		{
+			if (file.size() < 64 || readU32(file, 12) != 0x04030201) {
+				m_error = "invalid or big endian KTX header";
+				return false;
+			}
+
+			uint32_t glType = readU32(file, 16);
+			uint32_t glFormat = readU32(file, 24);
+			InternalFormat = readU32(file, 28);
+			Size = glm::ivec2(std::min<uint32_t>(readU32(file, 36), MAX_TEXTURE_SIZE + 1), std::max<uint32_t>(std::min<uint32_t>(readU32(file, 40), MAX_TEXTURE_SIZE + 1), 1));
+			uint32_t faces = readU32(file, 52), levels = readU32(file, 56);
+			uint32_t kvSize = readU32(file, 60);
+
+			if (const char* error = checkLayout(Size, faces, levels)) {
+				m_error = error;
+				return false;
+			}
+			FaceCount = faces;
+			LevelCount = levels;
+
+			// uncompressed KTX files must be RGBA8 so that the rest of the pipeline can treat them as such
+			if (glType != 0) {
+				if (glType != GL_UNSIGNED_BYTE || (glFormat != GL_RGBA && glFormat != GL_BGRA)) {
+					m_error = "only RGBA8 is supported for uncompressed KTX files";
+					return false;
+				}
+				Format = glFormat;
+				Type = GL_UNSIGNED_BYTE;
+				if (InternalFormat == GL_RGBA)
+					InternalFormat = GL_RGBA8;
+			}
+
+			if (headerOnly)
+				return true;
+
+			FormatInfo info;
+			if (!getFormatInfo(InternalFormat, info)) {
+				m_error = "unsupported KTX pixel format";
+				return false;
+			}
+
+			Levels.resize(FaceCount * LevelCount);
+
+			size_t offset = 64 + (size_t)kvSize;
+			for (int i = 0; i < LevelCount; i++) {
+				if (offset > file.size() || file.size() - offset < 4) {
+					m_error = "KTX file is too small";
+					return false;
+				}
+				uint32_t imageSize = readU32(file, offset); // size of one face
+				offset += 4;
+
+				glm::ivec2 levelDims = getLevelDimensions(Size, i);
+				if (imageSize != getLevelSize(info, levelDims)) {
+					m_error = "KTX mip level " + std::to_string(i) + " has the wrong size";
+					return false;
+				}
+
+				for (int face = 0; face < FaceCount; face++) {
+					if (offset > file.size() || imageSize > file.size() - offset) {
+						m_error = "KTX file is too small";
+						return false;
+					}
+
+					Level& level = Levels[face * LevelCount + i];
+					level.Size = levelDims;
+					level.Data.assign(file.begin() + offset, file.begin() + offset + imageSize);
+
+					offset += (imageSize + 3) & ~3; // cube padding
+				}
+				offset = (offset + 3) & ~3; // mip padding
+			}
+
+			return true;
+		}
+		bool CompressedTexture::m_loadKTX2(const std::vector<unsigned char>& file, bool headerOnly)
+		{
+			if (file.size() < 80) {
+				m_error = "invalid KTX2 header";
+				return false;
+			}
+
+			InternalFormat = getFormatFromVulkan(readU32(file, 12));
+			Size = glm::ivec2(std::min<uint32_t>(readU32(file, 20), MAX_TEXTURE_SIZE + 1), std::max<uint32_t>(std::min<uint32_t>(readU32(file, 24), MAX_TEXTURE_SIZE + 1), 1));
+			uint32_t faces = readU32(file, 36), levels = readU32(file, 40);
+			uint32_t supercompression = readU32(file, 44);
+
+			if (const char* error = checkLayout(Size, faces, levels)) {
+				m_error = error;
+				return false;
+			}
+			FaceCount = faces;
+			LevelCount = levels;
+
+			if (InternalFormat == 0) {
+				m_error = "unsupported KTX2 vkFormat";
+				return false;
+			}
+			if (supercompression != 0) {
+				m_error = "supercompressed (BasisLZ/Zstandard) KTX2 files are not supported";
+				return false;
+			}
+
+			Format = GL_RGBA;
+			Type = GL_UNSIGNED_BYTE;
+
+			if (headerOnly)
+				return true;
+
+			FormatInfo info;
+			if (!getFormatInfo(InternalFormat, info)) {
+				m_error = "unsupported KTX2 vkFormat";
+				return false;
+			}
+
+			// level index - 3 uint64 per level right after the header
+			if (80 + (size_t)LevelCount * 24 > file.size()) {
+				m_error = "KTX2 file is too small";
+				return false;
+			}
+
+			Levels.resize(FaceCount * LevelCount);
+
+			for (int i = 0; i < LevelCount; i++) {
+				uint64_t levelOffset = readU64(file, 80 + i * 24);
+				uint64_t levelLength = readU64(file, 80 + i * 24 + 8);
+
+				// the faces of the first layer come first
+				glm::ivec2 levelDims = getLevelDimensions(Size, i);
+				uint64_t faceLength = getLevelSize(info, levelDims);
+				if (levelLength < faceLength * FaceCount) {
+					m_error = "KTX2 mip level " + std::to_string(i) + " has the wrong size";
+					return false;
+				}
+				if (levelOffset > file.size() || levelLength > file.size() - levelOffset) {
+					m_error = "KTX2 file is too small";
+					return false;
+				}
+
+				for (int face = 0; face < FaceCount; face++) {
+					Level& level = Levels[face * LevelCount + i];
+					level.Size = levelDims;
+
+					size_t start = levelOffset + face * faceLength;
+					level.Data.assign(file.begin() + start, file.begin() + start + faceLength);
+				}
+			}
+
+			return true;
+		}
+	}
+}
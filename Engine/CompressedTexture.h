@@ -0,0 +1,60 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/glew.h>
+#if defined(__APPLE__)
+	#include <OpenGL/gl.h>
+#else
+	#include <GL/gl.h>
+#endif
+
+namespace ed
+{
+	namespace eng
+	{
+		// DDS, KTX and KTX2 files with their stored mip chain - the data is uploaded as is (BC1-7, ASTC or RGBA8)
+		class CompressedTexture
+		{
+		public:
+			CompressedTexture();
+
+			struct Level
+			{
+				glm::ivec2 Size;
+				std::vector<unsigned char> Data;
+			};
+
+			static bool IsSupportedFile(const std::string& path); // check the extension
+
+			// headerOnly -> only fill the format, size and level/face count
+			bool LoadFromFile(const std::string& path, bool headerOnly = false);
+
+			// is the format supported by the current GL context
+			bool IsFormatSupported();
+
+			// upload the levels of one face to the bound texture
+			void Upload(GLenum target, int face);
+
+			inline const std::string& GetError() { return m_error; }
+
+			glm::ivec2 Size;
+			GLenum InternalFormat;
+			GLenum Format, Type; // only used by the uncompressed formats
+			bool Compressed;
+			int LevelCount, FaceCount;
+			std::vector<Level> Levels; // [face * LevelCount + level]
+
+		private:
+			bool m_loadDDS(const std::vector<unsigned char>& file, bool headerOnly);
+			bool m_loadKTX(const std::vector<unsigned char>& file, bool headerOnly);
+			bool m_loadKTX2(const std::vector<unsigned char>& file, bool headerOnly);
+
+			std::string m_error;
+		};
+	}
+}
@@ -0,0 +1,118 @@
+#include "FramePacer.h"
+#include <algorithm>
+#include <thread>
+
+#include <SDL2/SDL_video.h>
+
+namespace ed
+{
+	namespace eng
+	{
+		FramePacer::FramePacer()
+		{
+			m_target = 0.0f;
+			m_period = Clock::duration::zero();
+			m_started = false;
+			m_sampleIndex = 0;
+		}
+		void FramePacer::SetTarget(float fps)
+		{
+			if (fps == m_target)
+				return;
+
+			m_target = fps;
+			m_period = fps > 0.0f ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / fps)) : Clock::duration::zero();
+			m_next = Clock::now() + m_period;
+		}
+		void FramePacer::Wait()
+		{
+			if (m_target > 0.0f) {
+				const auto spin = std::chrono::microseconds(FRAME_PACER_SPIN_TIME);
+
+				Clock::time_point now = Clock::now();
+				while (m_next - now > spin) {
+					std::this_thread::sleep_for(m_next - now - spin);
+					now = Clock::now();
+				}
+				while (now < m_next) {
+					std::this_thread::yield();
+					now = Clock::now();
+				}
+
+				m_advance(now);
+			}
+
+			m_record(Clock::now());
+		}
+		bool FramePacer::Ready()
+		{
+			Clock::time_point now = Clock::now();
+			if (m_target > 0.0f) {
+				// the caller only checks once per its own frame - a frame that is almost due is made now instead of a whole frame later
+				if (now + std::chrono::microseconds(FRAME_PACER_SPIN_TIME / 2) < m_next)
+					return false;
+				m_advance(now);
+			}
+
+			m_record(now);
+			return true;
+		}
+		FramePacer::Stats FramePacer::GetStats()
+		{
+			Stats ret;
+			if (m_samples.empty())
+				return ret;
+
+			std::vector<float> sorted = m_samples;
+			std::sort(sorted.begin(), sorted.end());
+
+			float sum = 0.0f;
+			for (float s : sorted)
+				sum += s;
+
+			auto percentile = [&](float p) { return sorted[std::min<size_t>(sorted.size() - 1, (size_t)(p * sorted.size()))]; };
+
+			ret.Mean = sum / sorted.size();
+			ret.P50 = percentile(0.50f);
+			ret.P95 = percentile(0.95f);
+			ret.P99 = percentile(0.99f);
+			ret.Max = sorted.back();
+			ret.Samples = sorted.size();
+
+			return ret;
+		}
+		void FramePacer::ResetStats()
+		{
+			m_samples.clear();
+			m_sampleIndex = 0;
+			m_started = false;
+		}
+		void FramePacer::ApplyVSync(bool vsync, bool adaptive)
+		{
+			if (vsync && adaptive && SDL_GL_SetSwapInterval(-1) == 0)
+				return;
+			SDL_GL_SetSwapInterval(vsync);
+		}
+		void FramePacer::m_advance(Clock::time_point now)
+		{
+			// deadlines are kept on a fixed grid so that the errors don't add up, but a long stall doesn't cause a burst of frames
+			m_next += m_period;
+			if (m_next <= now)
+				m_next = now + m_period;
+		}
+		void FramePacer::m_record(Clock::time_point now)
+		{
+			if (m_started) {
+				float time = std::chrono::duration<float>(now - m_last).count();
+				if (m_samples.size() < FRAME_PACER_SAMPLES)
+					m_samples.push_back(time);
+				else
+					m_samples[m_sampleIndex] = time;
+				m_sampleIndex = (m_sampleIndex + 1) % FRAME_PACER_SAMPLES;
+			}
+
+			m_last = now;
+			m_started = true;
+		}
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <chrono>
+#include <vector>
+
+#define FRAME_PACER_SAMPLES 240		// frame times kept for the statistics
+#define FRAME_PACER_SPIN_TIME 2000	// us before the deadline in which the pacer stops sleeping and spins
+
+namespace ed
+{
+	namespace eng
+	{
+		// keeps a steady frame rate - sleeps for most of the wait and spins for the rest since sleeping isn't precise
+		class FramePacer
+		{
+		public:
+			struct Stats
+			{
+				Stats() { Mean = P50 = P95 = P99 = Max = 0.0f; Samples = 0; }
+				float Mean, P50, P95, P99, Max; // frame times in seconds
+				int Samples;
+			};
+
+			FramePacer();
+
+			// fps <= 0 turns the limit off
+			void SetTarget(float fps);
+			inline float GetTarget() { return m_target; }
+
+			// blocks until the next frame is due
+			void Wait();
+
+			// doesn't block, returns true if a frame should be made now
+			bool Ready();
+
+			Stats GetStats();
+			void ResetStats();
+
+			// 1 = vsync, -1 = adaptive vsync (late frames are swapped immediately), falls back to vsync if the driver doesn't support it
+			static void ApplyVSync(bool vsync, bool adaptive);
+
+		private:
+			typedef std::chrono::steady_clock Clock;
+
+			void m_advance(Clock::time_point now);
+			void m_record(Clock::time_point now);
+
+			float m_target;
+			Clock::duration m_period;
+			Clock::time_point m_next;
+			Clock::time_point m_last;
+			bool m_started;
+
+			std::vector<float> m_samples;
+			int m_sampleIndex;
+		};
+	}
+}
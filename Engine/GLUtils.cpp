@@ -1,11 +1,32 @@
 #include "GLUtils.h"
+#include "../Objects/Settings.h"
 #include <sstream>
+#include <string.h>
 #include <string>
+#include <vector>
+#include <unordered_set>
 
 namespace ed
 {
 	namespace gl
 	{
+		std::vector<std::string> debugGroups; // only the pushed groups
+		int debugGroupDepth = 0; // including the groups that weren't pushed
+		bool debugGroupsForced = false;
+		MessageStack* debugOutput = nullptr;
+		std::unordered_set<GLuint> debugReported;
+
+		void GLAPIENTRY debugMessageCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam)
+		{
+			if (debugOutput == nullptr || debugReported.count(id))
+				return;
+			debugReported.insert(id); // the same warning is usually issued every frame
+
+			// the messages are shown next to the pipeline item that was being rendered
+			std::string group = debugGroups.empty() ? "OpenGL" : debugGroups[0];
+			debugOutput->Add(MessageStack::Type::Warning, group, std::string(message, length < 0 ? strlen(message) : length));
+		}
+
 		GLuint CreateSimpleFramebuffer(GLint width, GLint height, GLuint& texColor, GLuint& texDepth, GLuint fmt)
 		{
 			// create a texture for color information
@@ -191,5 +212,55 @@ namespace ed
 
 			return ret;
 		}
+
+		void SetObjectLabel(GLenum identifier, GLuint name, const std::string& label)
+		{
+			if (GLEW_KHR_debug && name != 0)
+				glObjectLabel(identifier, name, label.size(), label.c_str());
+		}
+		void PushDebugGroup(const std::string& name)
+		{
+			debugGroupDepth++;
+			if (!GLEW_KHR_debug || !(Settings::Instance().Debug.GPUMarkers || debugGroupsForced))
+				return;
+
+			glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, debugGroups.size(), name.size(), name.c_str());
+			debugGroups.push_back(name);
+		}
+		void PopDebugGroup()
+		{
+			// markers can't be turned on or off in the middle of a frame - the depth only keeps the unpushed groups balanced
+			if (debugGroupDepth-- > (int)debugGroups.size() || debugGroups.empty())
+				return;
+
+			glPopDebugGroup();
+			debugGroups.pop_back();
+		}
+		void ForceDebugGroups(bool force)
+		{
+			debugGroupsForced = force;
+		}
+		void UpdateDebugOutput(MessageStack* msgs)
+		{
+			MessageStack* output = (GLEW_KHR_debug && Settings::Instance().Debug.GPUMarkers) ? msgs : nullptr;
+			if (output == debugOutput)
+				return;
+
+			if (output != nullptr) {
+				// synchronous so that the callback runs on the main thread while the right group is pushed
+				glEnable(GL_DEBUG_OUTPUT);
+				glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+				glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_FALSE);
+				glDebugMessageControl(GL_DONT_CARE, GL_DEBUG_TYPE_PERFORMANCE, GL_DONT_CARE, 0, nullptr, GL_TRUE);
+				glDebugMessageCallback(debugMessageCallback, nullptr);
+				debugReported.clear();
+			} else {
+				glDebugMessageCallback(nullptr, nullptr);
+				glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+				glDisable(GL_DEBUG_OUTPUT);
+			}
+
+			debugOutput = output;
+		}
 	}
 }
\ No newline at end of file
@@ -31,5 +31,19 @@ namespace ed
 		void CreateVAO(GLuint &geoVAO, GLuint geoVBO, const std::vector<InputLayoutItem> &ilayout, GLuint geoEBO = 0, GLuint bufVBO = 0, std::vector<ed::ShaderVariable::ValueType> types = std::vector<ed::ShaderVariable::ValueType>());
 
 		std::vector<InputLayoutItem> CreateDefaultInputLayout();
+
+		// KHR_debug - names the objects and structures the frame for RenderDoc, Nsight, etc...
+		void SetObjectLabel(GLenum identifier, GLuint name, const std::string& label);
+		void PushDebugGroup(const std::string& name); // only pushed when Settings::Debug.GPUMarkers is turned on
+		void PopDebugGroup();
+		void ForceDebugGroups(bool force); // push the groups even when the markers are turned off (RenderDoc captures)
+		void UpdateDebugOutput(MessageStack* msgs); // routes the driver's performance warnings to the message stack when the markers are on
+
+		class DebugGroup
+		{
+		public:
+			inline DebugGroup(const std::string& name) { PushDebugGroup(name); }
+			inline ~DebugGroup() { PopDebugGroup(); }
+		};
 	}
 }
\ No newline at end of file
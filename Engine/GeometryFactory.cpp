@@ -22,8 +22,23 @@ namespace ed
 			20 * 20 * 6,/* SPHERE */
 			6,		/* PLANE */
 			6,		/* SCREEQUADNDC */
+			0,		/* GENERATED */
+			0,		/* CAPTURED */
 		};
 
+		bool GeometryFactory::GetHalfSize(int type, const glm::vec3& size, glm::vec3& halfSize)
+		{
+			switch (type) {
+			case pipe::GeometryItem::Cube: halfSize = size * 0.5f; break;
+			case pipe::GeometryItem::Circle: halfSize = glm::vec3(size.x, size.y, 0.0f); break;
+			case pipe::GeometryItem::Plane: halfSize = glm::vec3(size.x * 0.5f, size.y * 0.5f, 0.0f); break;
+			case pipe::GeometryItem::Sphere: halfSize = glm::vec3(size.x); break;
+			case pipe::GeometryItem::Triangle: halfSize = glm::vec3(size.x / tan(glm::radians(30.0f)), size.x, 0.0f); break;
+			default: return false;
+			}
+			return true;
+		}
+
 		void generateFace(GLfloat* verts, float radius, float sx, float sy, int x, int y)
 		{
 			float phi = y * sy;
@@ -21,7 +21,11 @@ namespace ed
 				glm::vec4 Color;
 			};
 
-			static const int VertexCount[7];
+			static const int VertexCount[9]; // Generated & Captured items have their own counts
+
+			// half size of the local space bounds - type & size are pipe::GeometryItem's Type and Size,
+			// returns false for the screen quads since they aren't transformed by the camera & for the generated & captured geometry
+			static bool GetHalfSize(int type, const glm::vec3& size, glm::vec3& halfSize);
 
 			static unsigned int CreateCube(unsigned int& vbo, float sx, float sy, float sz, const std::vector<InputLayoutItem>& inp);
 			static unsigned int CreateCircle(unsigned int& vbo, float rx, float ry, const std::vector<InputLayoutItem>& inp);
@@ -0,0 +1,133 @@
+#include "JobScheduler.h"
+#include <algorithm>
+
+namespace ed
+{
+	namespace eng
+	{
+		static thread_local int currentWorker = -1;
+
+		JobScheduler::JobScheduler(int threadCount)
+		{
+			m_exit = false;
+			m_next = 0;
+			m_pending = 0;
+
+			// leave one core for the UI thread
+			if (threadCount <= 0)
+				threadCount = std::max<int>(1, (int)std::thread::hardware_concurrency() - 1);
+
+			for (int i = 0; i < threadCount; i++)
+				m_workers.push_back(std::unique_ptr<Worker>(new Worker()));
+			for (int i = 0; i < threadCount; i++)
+				m_workers[i]->Thread = new std::thread(&JobScheduler::m_run, this, i);
+		}
+		JobScheduler::~JobScheduler()
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_sleepMutex);
+				m_exit = true;
+			}
+			m_signal.notify_all();
+
+			for (auto& worker : m_workers) {
+				worker->Thread->join();
+				delete worker->Thread;
+			}
+		}
+		void JobScheduler::Add(const std::function<void()>& task, JobPriority priority, const CancelToken& token)
+		{
+			// the worker's own jobs stay on it, they usually touch the same data
+			int index = currentWorker;
+			if (index < 0)
+				index = m_next++ % m_workers.size();
+
+			{
+				Worker* worker = m_workers[index].get();
+				std::lock_guard<std::mutex> lock(worker->Mutex);
+				worker->Queues[(int)priority].push_back({ task, token });
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(m_sleepMutex);
+				m_pending++;
+			}
+			m_signal.notify_one();
+		}
+		void JobScheduler::Complete(const std::function<void()>& task)
+		{
+			std::lock_guard<std::mutex> lock(m_completionMutex);
+			m_completions.push_back(task);
+		}
+		void JobScheduler::RunCompletions()
+		{
+			std::vector<std::function<void()>> tasks;
+			{
+				std::lock_guard<std::mutex> lock(m_completionMutex);
+				if (m_completions.empty())
+					return;
+				tasks.swap(m_completions);
+			}
+
+			// the tasks can add new completions, those wait for the next call
+			for (const auto& task : tasks)
+				task();
+		}
+		int JobScheduler::GetCurrentWorker()
+		{
+			return currentWorker;
+		}
+		void JobScheduler::m_run(int index)
+		{
+			currentWorker = index;
+
+			while (true) {
+				{
+					std::unique_lock<std::mutex> lock(m_sleepMutex);
+					m_signal.wait(lock, [&]() { return m_exit || m_pending > 0; });
+					if (m_exit)
+						return;
+				}
+
+				Job job;
+				if (!m_take(index, job)) {
+					// another worker took the job between the wake up & the lookup
+					std::this_thread::yield();
+					continue;
+				}
+				m_pending--;
+
+				if (!job.Token.IsCancelled())
+					job.Task();
+			}
+		}
+		bool JobScheduler::m_take(int index, Job& job)
+		{
+			for (int p = 0; p < (int)JobPriority::Count; p++) {
+				// newest own job first, it's the most likely to still be in the cache
+				{
+					Worker* own = m_workers[index].get();
+					std::lock_guard<std::mutex> lock(own->Mutex);
+					if (!own->Queues[p].empty()) {
+						job = std::move(own->Queues[p].back());
+						own->Queues[p].pop_back();
+						return true;
+					}
+				}
+
+				// oldest job of the other workers
+				for (int i = 1; i < m_workers.size(); i++) {
+					Worker* other = m_workers[(index + i) % m_workers.size()].get();
+					std::lock_guard<std::mutex> lock(other->Mutex);
+					if (!other->Queues[p].empty()) {
+						job = std::move(other->Queues[p].front());
+						other->Queues[p].pop_front();
+						return true;
+					}
+				}
+			}
+
+			return false;
+		}
+	}
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+namespace ed
+{
+	namespace eng
+	{
+		// the higher priorities are always taken first, by every worker
+		enum class JobPriority
+		{
+			Interactive, // shader compilation, debugger
+			Loading,	 // project, texture & model loading
+			Export,		 // saving images, sequences & objects
+			Background,	 // update checks & other work that nobody waits for
+			Count
+		};
+
+		// copies share the flag - a job that was cancelled before it started is dropped, the running ones can poll it
+		class CancelToken
+		{
+		public:
+			CancelToken() {} // never cancelled
+			static inline CancelToken Create()
+			{
+				CancelToken ret;
+				ret.m_flag = std::make_shared<std::atomic<bool>>(false);
+				return ret;
+			}
+
+			inline void Cancel()
+			{
+				if (m_flag != nullptr)
+					*m_flag = true;
+			}
+			inline bool IsCancelled() const { return m_flag != nullptr && *m_flag; }
+
+		private:
+			std::shared_ptr<std::atomic<bool>> m_flag;
+		};
+
+		// one set of worker threads for all of the background work - every worker has its own queues, the jobs that
+		// a worker adds go to its own queues and idle workers steal from the others
+		// ThreadPool is the front end that most of the code uses, it limits & waits for a group of jobs
+		class JobScheduler
+		{
+		public:
+			static inline JobScheduler& Instance()
+			{
+				static JobScheduler ret;
+				return ret;
+			}
+
+			JobScheduler(int threadCount = 0); // 0 -> number of cores - 1
+			~JobScheduler();				   // jobs that haven't started yet are dropped
+
+			void Add(const std::function<void()>& task, JobPriority priority, const CancelToken& token = CancelToken());
+
+			// the tasks run on the GL thread in the next RunCompletions(), in the order they were added
+			void Complete(const std::function<void()>& task);
+			void RunCompletions();
+
+			inline int GetThreadCount() { return m_workers.size(); }
+			static int GetCurrentWorker(); // index of the worker that runs the calling thread, -1 on other threads
+
+		private:
+			struct Job
+			{
+				std::function<void()> Task;
+				CancelToken Token;
+			};
+			struct Worker
+			{
+				std::mutex Mutex;
+				std::deque<Job> Queues[(int)JobPriority::Count];
+				std::thread* Thread;
+			};
+
+			void m_run(int index);
+			bool m_take(int index, Job& job);
+
+			std::vector<std::unique_ptr<Worker>> m_workers;
+			std::atomic<unsigned int> m_next; // worker that gets the next job from another thread
+
+			std::atomic<int> m_pending;
+			std::mutex m_sleepMutex;
+			std::condition_variable m_signal;
+			bool m_exit;
+
+			std::mutex m_completionMutex;
+			std::vector<std::function<void()>> m_completions;
+		};
+	}
+}
@@ -0,0 +1,135 @@
+#include "MappedFile.h"
+#include <stdio.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <ghc/filesystem.hpp>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#define MAPPED_FILE_PAGE_SIZE 4096
+
+namespace ed
+{
+	namespace eng
+	{
+		MappedFile::MappedFile()
+		{
+			m_data = nullptr;
+			m_size = 0;
+			m_isEmpty = false;
+#ifdef _WIN32
+			m_file = m_mapping = nullptr;
+#endif
+		}
+		MappedFile::~MappedFile()
+		{
+			Close();
+		}
+		bool MappedFile::Open(const std::string& path)
+		{
+			Close();
+
+#ifdef _WIN32
+			HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+			if (file == INVALID_HANDLE_VALUE)
+				return false;
+
+			LARGE_INTEGER size;
+			if (!GetFileSizeEx(file, &size)) {
+				CloseHandle(file);
+				return false;
+			}
+
+			m_file = file;
+			m_size = (size_t)size.QuadPart;
+			if (m_size == 0) {
+				m_isEmpty = true;
+				return true;
+			}
+
+			m_mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+			if (m_mapping != nullptr)
+				m_data = (char*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+			int fd = open(path.c_str(), O_RDONLY);
+			if (fd < 0)
+				return false;
+
+			struct stat info;
+			if (fstat(fd, &info) != 0) {
+				close(fd);
+				return false;
+			}
+
+			m_size = (size_t)info.st_size;
+			if (m_size == 0) {
+				close(fd);
+				m_isEmpty = true;
+				return true;
+			}
+
+			void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			close(fd); // the mapping keeps its own reference
+
+			if (data != MAP_FAILED) {
+				m_data = (char*)data;
+				madvise(m_data, m_size, MADV_SEQUENTIAL);
+			}
+#endif
+
+			if (m_data == nullptr) {
+				Close();
+				return false;
+			}
+
+			return true;
+		}
+		void MappedFile::Close()
+		{
+#ifdef _WIN32
+			if (m_data != nullptr)
+				UnmapViewOfFile(m_data);
+			if (m_mapping != nullptr)
+				CloseHandle(m_mapping);
+			if (m_file != nullptr)
+				CloseHandle(m_file);
+			m_file = m_mapping = nullptr;
+#else
+			if (m_data != nullptr)
+				munmap(m_data, m_size);
+#endif
+
+			m_data = nullptr;
+			m_size = 0;
+			m_isEmpty = false;
+		}
+		void MappedFile::Prefetch(size_t offset, size_t size)
+		{
+			if (m_data == nullptr || offset >= m_size)
+				return;
+
+			size_t end = (size > m_size - offset) ? m_size : offset + size;
+
+			volatile char sink = 0;
+			for (size_t i = offset; i < end; i += MAPPED_FILE_PAGE_SIZE)
+				sink += m_data[i];
+			(void)sink;
+		}
+
+		bool ReplaceFileWith(const std::string& path, const std::string& temp)
+		{
+#ifdef _WIN32
+			// the paths are UTF-8
+			std::wstring wtemp = ghc::filesystem::path(temp).wstring(), wpath = ghc::filesystem::path(path).wstring();
+			return MoveFileExW(wtemp.c_str(), wpath.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+			return ::rename(temp.c_str(), path.c_str()) == 0;
+#endif
+		}
+	}
+}
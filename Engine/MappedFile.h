@@ -0,0 +1,44 @@
+#pragma once
+#include <string>
+#include <stddef.h>
+
+namespace ed
+{
+	namespace eng
+	{
+		// read only view of a whole file - pages are only read from the disk when they're touched
+		class MappedFile
+		{
+		public:
+			MappedFile();
+			~MappedFile();
+
+			MappedFile(const MappedFile&) = delete;
+			MappedFile& operator=(const MappedFile&) = delete;
+
+			bool Open(const std::string& path);
+			void Close();
+
+			// touches every page so that the reads happen on the calling thread
+			void Prefetch(size_t offset = 0, size_t size = (size_t)-1);
+
+			inline bool IsOpen() { return m_data != nullptr || m_isEmpty; }
+			inline const char* GetData() { return m_data; }
+			inline size_t GetSize() { return m_size; }
+
+		private:
+			char* m_data;
+			size_t m_size;
+			bool m_isEmpty; // empty files can't be mapped
+
+#ifdef _WIN32
+			void* m_file;
+			void* m_mapping;
+#endif
+		};
+
+		// moves temp onto path in one step, an existing file at path is replaced - the temp-then-rename saves use this because
+		// rename() fails on Windows when the target exists
+		bool ReplaceFileWith(const std::string& path, const std::string& temp);
+	}
+}
@@ -1,5 +1,6 @@
 #include "Model.h"
 #include "../Objects/Logger.h"
+#include "../Objects/VAOCache.h"
 
 #ifdef _WIN32
 #include <windows.h>
@@ -12,18 +13,124 @@
 #endif
 
 #include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <string.h>
+#include <unordered_map>
+#include <climits>
+#include <math.h>
+#include <ghc/filesystem.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#define MODEL_CACHE_EXT ".sedmesh"
+#define MODEL_CACHE_VERSION 3 // 3 -> models with bones aren't cached
 
 namespace ed
 {
 	namespace eng
 	{
+		// <model path>.sedmesh: header, then for each mesh: name length, vertex count, index count, name, vertices, indices
+		struct ModelCacheHeader
+		{
+			char Magic[4]; // SEDM
+			uint32_t Version;
+			uint32_t Optimized;
+			uint32_t MeshCount;
+			uint64_t SourceSize;
+			int64_t SourceTime;
+		};
+
+		static bool getSourceInfo(const std::string& path, uint64_t& size, int64_t& time)
+		{
+			std::error_code ec;
+			size = ghc::filesystem::file_size(path, ec);
+			if (ec)
+				return false;
+			time = ghc::filesystem::last_write_time(path, ec).time_since_epoch().count();
+			return !ec;
+		}
+
+		static glm::mat4 toMat4(const aiMatrix4x4& mat)
+		{
+			// aiMatrix4x4 is row major
+			return glm::mat4(mat.a1, mat.b1, mat.c1, mat.d1,
+				mat.a2, mat.b2, mat.c2, mat.d2,
+				mat.a3, mat.b3, mat.c3, mat.d3,
+				mat.a4, mat.b4, mat.c4, mat.d4);
+		}
+
+		// renumber the vertices in the order in which the index buffer first uses them (unused vertices are dropped)
+		static void optimizeVertexFetch(std::vector<Model::Mesh::Vertex>& vertices, std::vector<Model::Mesh::Influence>& skin, std::vector<unsigned int>& indices)
+		{
+			std::vector<unsigned int> remap(vertices.size(), UINT_MAX);
+			std::vector<Model::Mesh::Vertex> ordered;
+			std::vector<Model::Mesh::Influence> orderedSkin;
+			ordered.reserve(vertices.size());
+			orderedSkin.reserve(skin.size());
+
+			for (auto& index : indices) {
+				if (remap[index] == UINT_MAX) {
+					remap[index] = ordered.size();
+					ordered.push_back(vertices[index]);
+					if (!skin.empty())
+						orderedSkin.push_back(skin[index]);
+				}
+				index = remap[index];
+			}
+
+			vertices = std::move(ordered);
+			skin = std::move(orderedSkin);
+		}
+
+		// keyframes are sorted by time, times outside of the track clamp to the first/last key
+		template <typename T, typename F>
+		static T sampleTrack(const std::vector<std::pair<float, T>>& keys, float time, F interpolate)
+		{
+			if (keys.size() == 1 || time <= keys.front().first)
+				return keys.front().second;
+			if (time >= keys.back().first)
+				return keys.back().second;
+
+			auto next = std::upper_bound(keys.begin(), keys.end(), time, [](float t, const std::pair<float, T>& key) { return t < key.first; });
+			auto prev = next - 1;
+			float factor = (time - prev->first) / std::max(next->first - prev->first, 1e-6f);
+			return interpolate(prev->second, next->second, factor);
+		}
+
+		// vertex clustering - every vertex is snapped to the first vertex that landed in the same grid cell
+		static void simplifyMesh(const Model::Mesh& mesh, int grid, glm::vec3 minBound, glm::vec3 maxBound, std::vector<unsigned int>& out)
+		{
+			glm::vec3 cellSize = glm::max(maxBound - minBound, glm::vec3(1e-6f)) / (float)grid;
+
+			std::unordered_map<uint64_t, unsigned int> cells;
+			std::vector<unsigned int> remap(mesh.Vertices.size());
+			for (unsigned int i = 0; i < mesh.Vertices.size(); i++) {
+				glm::ivec3 cell = glm::clamp(glm::ivec3((mesh.Vertices[i].Position - minBound) / cellSize), glm::ivec3(0), glm::ivec3(grid - 1));
+				uint64_t key = ((uint64_t)cell.x * grid + cell.y) * grid + cell.z;
+				remap[i] = cells.insert(std::make_pair(key, i)).first->second;
+			}
+
+			out.clear();
+			for (size_t i = 0; i + 2 < mesh.Indices.size(); i += 3) {
+				unsigned int a = remap[mesh.Indices[i]], b = remap[mesh.Indices[i + 1]], c = remap[mesh.Indices[i + 2]];
+				if (a == b || b == c || a == c)
+					continue;
+
+				out.push_back(a);
+				out.push_back(b);
+				out.push_back(c);
+			}
+		}
+
 		Model::Mesh::Mesh(const std::string& name, std::vector<Model::Mesh::Vertex> vertices, std::vector<unsigned int> indices, std::vector<Model::Mesh::Texture> textures)
 		{
 			Name = name;
-			Vertices = vertices;
-			Indices = indices;
-			Textures = textures;
-			m_setup();
+			Vertices = std::move(vertices);
+			Indices = std::move(indices);
+			Textures = std::move(textures);
+			VAO = VBO = EBO = 0;
+			BindVBO = SkinBuffer = 0;
+			MeshletBuffer = MeshletVertexBuffer = MeshletPrimitiveBuffer = 0;
 		}
 		void Model::Mesh::m_setup()
 		{
@@ -32,13 +139,17 @@ namespace ed
 			glGenBuffers(1, &EBO);
 			glBindVertexArray(VAO);
 
+			// the posed vertices of skinned meshes are written by a compute shader every time the pose changes
 			glBindBuffer(GL_ARRAY_BUFFER, VBO);
-			glBufferData(GL_ARRAY_BUFFER, Vertices.size() * sizeof(Vertex), &Vertices[0],
-				GL_STATIC_DRAW);
+			glBufferData(GL_ARRAY_BUFFER, Vertices.size() * sizeof(Vertex), Vertices.data(),
+				Skin.empty() ? GL_STATIC_DRAW : GL_DYNAMIC_COPY);
 
 			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-			glBufferData(GL_ELEMENT_ARRAY_BUFFER, Indices.size() * sizeof(unsigned int),
-				&Indices[0], GL_STATIC_DRAW);
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, (Indices.size() + LODIndices.size()) * sizeof(unsigned int),
+				nullptr, GL_STATIC_DRAW);
+			glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, Indices.size() * sizeof(unsigned int), Indices.data());
+			if (!LODIndices.empty())
+				glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, Indices.size() * sizeof(unsigned int), LODIndices.size() * sizeof(unsigned int), LODIndices.data());
 
 			// vertex positions
 			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Model::Mesh::Vertex), (void*)0);
@@ -53,34 +164,154 @@ namespace ed
 			glEnableVertexAttribArray(2);
 
 			glBindVertexArray(0);
+
+			if (!Skin.empty()) {
+				glGenBuffers(1, &BindVBO);
+				glBindBuffer(GL_SHADER_STORAGE_BUFFER, BindVBO);
+				glBufferData(GL_SHADER_STORAGE_BUFFER, Vertices.size() * sizeof(Vertex), Vertices.data(), GL_STATIC_DRAW);
+
+				glGenBuffers(1, &SkinBuffer);
+				glBindBuffer(GL_SHADER_STORAGE_BUFFER, SkinBuffer);
+				glBufferData(GL_SHADER_STORAGE_BUFFER, Skin.size() * sizeof(Influence), Skin.data(), GL_STATIC_DRAW);
+				glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+			}
+
+			if (!Meshlets.empty()) {
+				glGenBuffers(1, &MeshletBuffer);
+				glBindBuffer(GL_SHADER_STORAGE_BUFFER, MeshletBuffer);
+				glBufferData(GL_SHADER_STORAGE_BUFFER, Meshlets.size() * sizeof(Meshlet), Meshlets.data(), GL_STATIC_DRAW);
+
+				glGenBuffers(1, &MeshletVertexBuffer);
+				glBindBuffer(GL_SHADER_STORAGE_BUFFER, MeshletVertexBuffer);
+				glBufferData(GL_SHADER_STORAGE_BUFFER, MeshletVertices.size() * sizeof(unsigned int), MeshletVertices.data(), GL_STATIC_DRAW);
+
+				glGenBuffers(1, &MeshletPrimitiveBuffer);
+				glBindBuffer(GL_SHADER_STORAGE_BUFFER, MeshletPrimitiveBuffer);
+				glBufferData(GL_SHADER_STORAGE_BUFFER, MeshletPrimitives.size() * sizeof(unsigned int), MeshletPrimitives.data(), GL_STATIC_DRAW);
+				glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+			}
 		}
-		void Model::Mesh::Draw(bool instanced, int iCount)
+		void Model::Mesh::GetDrawRange(int lod, unsigned int& offset, unsigned int& count) const
 		{
+			offset = 0;
+			count = Indices.size();
+			if (lod > 0 && !LODs.empty()) {
+				const LOD& level = LODs[std::min<int>(lod, LODs.size()) - 1];
+				offset = level.Offset;
+				count = level.Count;
+			}
+		}
+		void Model::Mesh::Draw(bool instanced, int iCount, int lod)
+		{
+			unsigned int offset, count;
+			GetDrawRange(lod, offset, count);
+
 			// draw mesh
 			glBindVertexArray(VAO);
 
+			void* start = (void*)(offset * sizeof(unsigned int));
 			if (instanced)
-				glDrawElementsInstanced(GL_TRIANGLES, Indices.size(), GL_UNSIGNED_INT, nullptr, iCount);
+				glDrawElementsInstanced(GL_TRIANGLES, count, GL_UNSIGNED_INT, start, iCount);
 			else
-				glDrawElements(GL_TRIANGLES, Indices.size(), GL_UNSIGNED_INT, 0);
+				glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, start);
+		}
+
+		void Model::Mesh::m_bindMeshlets(int countLoc)
+		{
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MODEL_MESHLET_BINDING + 0, VBO);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MODEL_MESHLET_BINDING + 1, MeshletBuffer);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MODEL_MESHLET_BINDING + 2, MeshletVertexBuffer);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MODEL_MESHLET_BINDING + 3, MeshletPrimitiveBuffer);
+			if (countLoc != -1)
+				glUniform1ui(countLoc, Meshlets.size());
 		}
+		void Model::Mesh::DrawMeshlets(unsigned int meshletsPerTask, int countLoc)
+		{
+			if (Meshlets.empty())
+				return;
+
+			m_bindMeshlets(countLoc);
 
+#ifdef GL_NV_mesh_shader
+			meshletsPerTask = std::max(meshletsPerTask, 1u);
+			glDrawMeshTasksNV(0, (Meshlets.size() + meshletsPerTask - 1) / meshletsPerTask);
+#endif
+		}
+		void Model::Mesh::DrawMeshletsIndirect(long long offset, int countLoc)
+		{
+			if (Meshlets.empty())
+				return;
+
+			m_bindMeshlets(countLoc);
+
+#ifdef GL_NV_mesh_shader
+			glDrawMeshTasksIndirectNV((GLintptr)offset);
+#endif
+		}
+
+		Model::Model()
+		{
+			BoneBuffer = 0;
+			PosedAnimation = -2;
+			PosedTime = 0.0f;
+		}
 		Model::~Model()
 		{
 			for (int i = 0; i < Meshes.size(); i++) {
-				glDeleteVertexArrays(1, &Meshes[i].VAO);
+				VAOCache::Instance().Release(Meshes[i].VAO);
 				glDeleteBuffers(1, &Meshes[i].VBO);
 				glDeleteBuffers(1, &Meshes[i].EBO);
+				if (Meshes[i].BindVBO != 0) {
+					glDeleteBuffers(1, &Meshes[i].BindVBO);
+					glDeleteBuffers(1, &Meshes[i].SkinBuffer);
+				}
+				if (Meshes[i].MeshletBuffer != 0) {
+					glDeleteBuffers(1, &Meshes[i].MeshletBuffer);
+					glDeleteBuffers(1, &Meshes[i].MeshletVertexBuffer);
+					glDeleteBuffers(1, &Meshes[i].MeshletPrimitiveBuffer);
+				}
 			}
+			if (BoneBuffer != 0)
+				glDeleteBuffers(1, &BoneBuffer);
 		}
 
-		bool Model::LoadFromFile(const std::string& path)
+		bool Model::LoadFromFile(const std::string& path, bool optimize, bool useCache)
+		{
+			if (!Import(path, optimize, useCache))
+				return false;
+
+			Upload();
+
+			return true;
+		}
+		bool Model::Import(const std::string& path, bool optimize, bool useCache)
 		{
 			ed::Logger::Get().Log("Loading a 3D model " + path);
 
+			Meshes.clear();
+			Nodes.clear();
+			Bones.clear();
+			Animations.clear();
+			Directory = path.substr(0, path.find_last_of("/\\"));
+
+			// skip Assimp if the processed meshes were already stored
+			if (useCache && m_readCache(path, optimize)) {
+				ed::Logger::Get().Log("Loaded the 3D model " + path + " from the mesh cache");
+				m_findBounds();
+				m_buildTrees();
+				if (optimize)
+					m_buildLODs();
+				m_buildMeshlets();
+				return true;
+			}
+
+			unsigned int flags = aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_LimitBoneWeights;
+			if (optimize)
+				flags |= aiProcess_JoinIdenticalVertices | aiProcess_ImproveCacheLocality | aiProcess_OptimizeMeshes;
+
 			// read file via ASSIMP
 			Assimp::Importer importer;
-			const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs);
+			const aiScene* scene = importer.ReadFile(path, flags);
 			
 			// check for errors
 			if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
@@ -89,13 +320,121 @@ namespace ed
 				return false;
 			}
 
-			Directory = path.substr(0, path.find_last_of("/\\"));
+			// the bones reference the nodes by name
+			m_processHierarchy(scene->mRootNode, -1);
 			m_processNode(scene->mRootNode, scene);
+			if (IsSkinned())
+				m_processAnimations(scene);
+			else
+				Nodes.clear();
+
+			if (optimize)
+				for (auto& mesh : Meshes)
+					optimizeVertexFetch(mesh.Vertices, mesh.Skin, mesh.Indices);
 
 			m_findBounds();
+			m_buildTrees();
+			if (optimize)
+				m_buildLODs();
+			m_buildMeshlets();
+
+			// the cache only stores the meshes
+			if (useCache && !IsSkinned())
+				m_writeCache(path, optimize);
+
+			return true;
+		}
+		void Model::Upload()
+		{
+			for (auto& mesh : Meshes)
+				if (mesh.VAO == 0)
+					mesh.m_setup();
+
+			if (IsSkinned() && BoneBuffer == 0) {
+				glGenBuffers(1, &BoneBuffer);
+				glBindBuffer(GL_SHADER_STORAGE_BUFFER, BoneBuffer);
+				glBufferData(GL_SHADER_STORAGE_BUFFER, Bones.size() * sizeof(glm::mat4), nullptr, GL_DYNAMIC_DRAW);
+				glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+			}
+		}
+		bool Model::m_readCache(const std::string& path, bool optimize)
+		{
+			uint64_t srcSize = 0;
+			int64_t srcTime = 0;
+			if (!getSourceInfo(path, srcSize, srcTime))
+				return false;
+
+			std::ifstream file(path + MODEL_CACHE_EXT, std::ios::binary | std::ios::ate);
+			if (!file.is_open())
+				return false;
+
+			uint64_t cacheSize = file.tellg();
+			file.seekg(0, std::ios::beg);
+
+			ModelCacheHeader header;
+			if (!file.read((char*)&header, sizeof(header)) || memcmp(header.Magic, "SEDM", 4) != 0 ||
+				header.Version != MODEL_CACHE_VERSION || header.Optimized != (uint32_t)optimize ||
+				header.SourceSize != srcSize || header.SourceTime != srcTime)
+				return false;
+
+			uint64_t remaining = cacheSize - sizeof(header);
+			for (uint32_t i = 0; i < header.MeshCount; i++) {
+				uint32_t counts[3]; // name length, vertex count, index count
+				if (!file.read((char*)counts, sizeof(counts))) {
+					Meshes.clear();
+					return false;
+				}
+
+				uint64_t dataSize = counts[0] + (uint64_t)counts[1] * sizeof(Mesh::Vertex) + (uint64_t)counts[2] * sizeof(unsigned int);
+				if (dataSize + sizeof(counts) > remaining) {
+					Meshes.clear();
+					return false;
+				}
+				remaining -= dataSize + sizeof(counts);
+
+				// read straight into the buffers that get uploaded to the VBO/EBO
+				std::string name(counts[0], '\0');
+				std::vector<Mesh::Vertex> vertices(counts[1]);
+				std::vector<unsigned int> indices(counts[2]);
+				file.read(&name[0], counts[0]);
+				file.read((char*)vertices.data(), vertices.size() * sizeof(Mesh::Vertex));
+				file.read((char*)indices.data(), indices.size() * sizeof(unsigned int));
+
+				if (!file) {
+					Meshes.clear();
+					return false;
+				}
+
+				Meshes.push_back(Mesh(name, std::move(vertices), std::move(indices), std::vector<Mesh::Texture>()));
+			}
 
 			return true;
 		}
+		void Model::m_writeCache(const std::string& path, bool optimize)
+		{
+			ModelCacheHeader header;
+			memcpy(header.Magic, "SEDM", 4);
+			header.Version = MODEL_CACHE_VERSION;
+			header.Optimized = optimize;
+			header.MeshCount = Meshes.size();
+			if (!getSourceInfo(path, header.SourceSize, header.SourceTime))
+				return;
+
+			std::ofstream file(path + MODEL_CACHE_EXT, std::ios::binary);
+			if (!file.is_open()) {
+				ed::Logger::Get().Log("Failed to write the mesh cache for " + path);
+				return;
+			}
+
+			file.write((const char*)&header, sizeof(header));
+			for (const auto& mesh : Meshes) {
+				uint32_t counts[3] = { (uint32_t)mesh.Name.size(), (uint32_t)mesh.Vertices.size(), (uint32_t)mesh.Indices.size() };
+				file.write((const char*)counts, sizeof(counts));
+				file.write(mesh.Name.data(), mesh.Name.size());
+				file.write((const char*)mesh.Vertices.data(), mesh.Vertices.size() * sizeof(Mesh::Vertex));
+				file.write((const char*)mesh.Indices.data(), mesh.Indices.size() * sizeof(unsigned int));
+			}
+		}
 		void Model::m_findBounds()
 		{
 			m_minBound = glm::vec3(std::numeric_limits<float>::infinity());
@@ -112,6 +451,180 @@ namespace ed
 				}
 			}
 		}
+		void Model::m_buildTrees()
+		{
+			for (auto& mesh : Meshes)
+				mesh.Tree.Build(mesh.Vertices.data(), sizeof(Mesh::Vertex), mesh.Indices.data(), mesh.Indices.size() / 3);
+		}
+		void Model::m_buildLODs()
+		{
+			std::vector<unsigned int> simplified;
+			for (auto& mesh : Meshes) {
+				mesh.LODs.clear();
+				mesh.LODIndices.clear();
+
+				size_t triCount = mesh.Indices.size() / 3;
+				if (triCount < MODEL_LOD_MIN_TRIANGLES)
+					continue;
+
+				glm::vec3 minBound(std::numeric_limits<float>::infinity()), maxBound(-std::numeric_limits<float>::infinity());
+				for (const auto& v : mesh.Vertices) {
+					minBound = glm::min(minBound, v.Position);
+					maxBound = glm::max(maxBound, v.Position);
+				}
+
+				// each level should have roughly a quarter of the triangles of the previous one
+				int grid = std::max<int>(4, sqrt((double)triCount) / 2);
+				size_t lastCount = triCount;
+				while (mesh.LODs.size() < MODEL_LOD_MAX && grid >= 2) {
+					simplifyMesh(mesh, grid, minBound, maxBound, simplified);
+					grid /= 2;
+
+					size_t count = simplified.size() / 3;
+					if (count == 0)
+						break;
+					if (count >= lastCount * 0.8)
+						continue; // not worth the memory
+
+					Mesh::LOD level;
+					level.Offset = mesh.Indices.size() + mesh.LODIndices.size();
+					level.Count = simplified.size();
+					mesh.LODs.push_back(level);
+					mesh.LODIndices.insert(mesh.LODIndices.end(), simplified.begin(), simplified.end());
+
+					lastCount = count;
+				}
+			}
+		}
+		void Model::m_buildMeshlets()
+		{
+			// nothing could draw them
+#ifdef GL_NV_mesh_shader
+			if (!GLEW_NV_mesh_shader)
+				return;
+#else
+			return;
+#endif
+
+			for (auto& mesh : Meshes) {
+				mesh.Meshlets.clear();
+				mesh.MeshletVertices.clear();
+				mesh.MeshletPrimitives.clear();
+
+				// the triangles are taken in index order, which already is cache friendly for the optimized models
+				std::vector<int> local(mesh.Vertices.size(), -1); // vertex -> index in the current meshlet
+				Mesh::Meshlet cur;
+				auto begin = [&]() {
+					cur.VertexOffset = mesh.MeshletVertices.size();
+					cur.VertexCount = 0;
+					cur.PrimitiveOffset = mesh.MeshletPrimitives.size();
+					cur.PrimitiveCount = 0;
+				};
+				auto finish = [&]() {
+					if (cur.PrimitiveCount == 0)
+						return;
+
+					glm::vec3 minBound(std::numeric_limits<float>::infinity()), maxBound(-std::numeric_limits<float>::infinity());
+					for (unsigned int i = 0; i < cur.VertexCount; i++) {
+						unsigned int v = mesh.MeshletVertices[cur.VertexOffset + i];
+						minBound = glm::min(minBound, mesh.Vertices[v].Position);
+						maxBound = glm::max(maxBound, mesh.Vertices[v].Position);
+						local[v] = -1;
+					}
+
+					glm::vec3 center = (minBound + maxBound) * 0.5f;
+					float radius = 0.0f;
+					for (unsigned int i = 0; i < cur.VertexCount; i++)
+						radius = std::max(radius, glm::length(mesh.Vertices[mesh.MeshletVertices[cur.VertexOffset + i]].Position - center));
+					cur.Bounds = glm::vec4(center, radius);
+
+					mesh.Meshlets.push_back(cur);
+				};
+
+				begin();
+				for (size_t t = 0; t + 2 < mesh.Indices.size(); t += 3) {
+					const unsigned int* tri = &mesh.Indices[t];
+
+					int added = (local[tri[0]] == -1) + (local[tri[1]] == -1) + (local[tri[2]] == -1);
+					if (cur.VertexCount + added > MODEL_MESHLET_VERTICES || cur.PrimitiveCount >= MODEL_MESHLET_TRIANGLES) {
+						finish();
+						begin();
+					}
+
+					unsigned int packed = 0;
+					for (int k = 0; k < 3; k++) {
+						if (local[tri[k]] == -1) {
+							local[tri[k]] = cur.VertexCount++;
+							mesh.MeshletVertices.push_back(tri[k]);
+						}
+						packed |= local[tri[k]] << (k * 8);
+					}
+					mesh.MeshletPrimitives.push_back(packed);
+					cur.PrimitiveCount++;
+				}
+				finish();
+			}
+		}
+		bool Model::Intersect(glm::vec3 orig, glm::vec3 dir, float& distHit, float maxDist)
+		{
+			bool hit = false;
+			for (auto& mesh : Meshes) {
+				float meshDist;
+				if (mesh.Tree.Intersect(orig, dir, mesh.Vertices.data(), sizeof(Mesh::Vertex), mesh.Indices.data(), meshDist, maxDist)) {
+					maxDist = distHit = meshDist;
+					hit = true;
+				}
+			}
+			return hit;
+		}
+		std::vector<std::string> Model::GetAnimationNames()
+		{
+			std::vector<std::string> ret;
+			for (const auto& anim : Animations)
+				ret.push_back(anim.Name);
+			return ret;
+		}
+		int Model::FindAnimation(const std::string& name)
+		{
+			if (name.empty())
+				return -1;
+			for (int i = 0; i < Animations.size(); i++)
+				if (Animations[i].Name == name)
+					return i;
+			return -1;
+		}
+		void Model::Animate(int anim, float seconds, std::vector<glm::mat4>& out)
+		{
+			std::vector<glm::mat4> global(Nodes.size());
+			for (int i = 0; i < Nodes.size(); i++)
+				global[i] = Nodes[i].Transform;
+
+			if (anim >= 0 && anim < Animations.size()) {
+				const Animation& data = Animations[anim];
+				float ticks = seconds * data.TicksPerSecond;
+				if (data.Duration > 0.0f)
+					ticks = fmod(std::max(ticks, 0.0f), data.Duration);
+
+				for (const auto& channel : data.Channels) {
+					glm::vec3 pos = channel.Positions.empty() ? glm::vec3(0.0f) : sampleTrack(channel.Positions, ticks, [](const glm::vec3& a, const glm::vec3& b, float t) { return glm::mix(a, b, t); });
+					glm::quat rot = channel.Rotations.empty() ? glm::quat(1.0f, 0.0f, 0.0f, 0.0f) : sampleTrack(channel.Rotations, ticks, [](const glm::quat& a, const glm::quat& b, float t) { return glm::slerp(a, b, t); });
+					glm::vec3 scale = channel.Scales.empty() ? glm::vec3(1.0f) : sampleTrack(channel.Scales, ticks, [](const glm::vec3& a, const glm::vec3& b, float t) { return glm::mix(a, b, t); });
+
+					global[channel.Node] = glm::translate(glm::mat4(1.0f), pos) * glm::mat4_cast(rot) * glm::scale(glm::mat4(1.0f), scale);
+				}
+			}
+
+			for (int i = 0; i < Nodes.size(); i++)
+				if (Nodes[i].Parent >= 0)
+					global[i] = global[Nodes[i].Parent] * global[i];
+
+			// keep the root's transform out of it, the static meshes don't have it either
+			glm::mat4 rootInverse = Nodes.empty() ? glm::mat4(1.0f) : glm::inverse(Nodes[0].Transform);
+
+			out.resize(Bones.size());
+			for (int i = 0; i < Bones.size(); i++)
+				out[i] = rootInverse * global[Bones[i].Node] * Bones[i].Offset;
+		}
 		std::vector<std::string> Model::GetMeshNames()
 		{
 			std::vector<std::string> ret;
@@ -119,10 +632,41 @@ namespace ed
 				ret.push_back(Meshes[i].Name);
 			return ret;
 		}
-		void Model::Draw(bool inst, int iCount)
+		void Model::Draw(bool inst, int iCount, int lod)
 		{
 			for (unsigned int i = 0; i < Meshes.size(); i++)
-				Meshes[i].Draw(inst, iCount);
+				Meshes[i].Draw(inst, iCount, lod);
+		}
+		int Model::GetLODCount()
+		{
+			size_t ret = 0;
+			for (const auto& mesh : Meshes)
+				ret = std::max<size_t>(ret, mesh.LODs.size());
+			return ret + 1;
+		}
+		int Model::GetTriangleCount(int lod)
+		{
+			int ret = 0;
+			for (const auto& mesh : Meshes) {
+				if (lod <= 0 || mesh.LODs.empty())
+					ret += mesh.Indices.size() / 3;
+				else
+					ret += mesh.LODs[std::min<int>(lod, mesh.LODs.size()) - 1].Count / 3;
+			}
+			return ret;
+		}
+		int Model::PickLOD(float pixels)
+		{
+			float target = pixels * pixels / MODEL_LOD_PIXELS_PER_TRIANGLE;
+			for (int lod = GetLODCount() - 1; lod > 0; lod--)
+				if (GetTriangleCount(lod) >= target)
+					return lod;
+			return 0;
+		}
+		void Model::DrawMeshlets(unsigned int meshletsPerTask, int countLoc)
+		{
+			for (auto& mesh : Meshes)
+				mesh.DrawMeshlets(meshletsPerTask, countLoc);
 		}
 		void Model::Draw(const std::string & mesh)
 		{
@@ -130,6 +674,63 @@ namespace ed
 				if (Meshes[i].Name == mesh)
 					Meshes[i].Draw();
 		}
+		void Model::m_processHierarchy(aiNode* node, int parent)
+		{
+			Node data;
+			data.Name = node->mName.data;
+			data.Parent = parent;
+			data.Transform = toMat4(node->mTransformation);
+
+			int index = Nodes.size();
+			Nodes.push_back(data);
+
+			for (unsigned int i = 0; i < node->mNumChildren; i++)
+				m_processHierarchy(node->mChildren[i], index);
+		}
+		int Model::m_findNode(const std::string& name)
+		{
+			for (int i = 0; i < Nodes.size(); i++)
+				if (Nodes[i].Name == name)
+					return i;
+			return -1;
+		}
+		void Model::m_processAnimations(const aiScene* scene)
+		{
+			for (unsigned int i = 0; i < scene->mNumAnimations; i++) {
+				aiAnimation* anim = scene->mAnimations[i];
+
+				Animation data;
+				data.Name = anim->mName.length > 0 ? anim->mName.data : ("Animation " + std::to_string(i));
+				data.Duration = anim->mDuration;
+				data.TicksPerSecond = anim->mTicksPerSecond > 0.0 ? anim->mTicksPerSecond : 25.0f; // Assimp's default
+
+				for (unsigned int c = 0; c < anim->mNumChannels; c++) {
+					aiNodeAnim* track = anim->mChannels[c];
+
+					Animation::Channel channel;
+					channel.Node = m_findNode(track->mNodeName.data);
+					if (channel.Node == -1)
+						continue;
+
+					for (unsigned int k = 0; k < track->mNumPositionKeys; k++) {
+						const aiVectorKey& key = track->mPositionKeys[k];
+						channel.Positions.push_back(std::make_pair((float)key.mTime, glm::vec3(key.mValue.x, key.mValue.y, key.mValue.z)));
+					}
+					for (unsigned int k = 0; k < track->mNumRotationKeys; k++) {
+						const aiQuatKey& key = track->mRotationKeys[k];
+						channel.Rotations.push_back(std::make_pair((float)key.mTime, glm::quat(key.mValue.w, key.mValue.x, key.mValue.y, key.mValue.z)));
+					}
+					for (unsigned int k = 0; k < track->mNumScalingKeys; k++) {
+						const aiVectorKey& key = track->mScalingKeys[k];
+						channel.Scales.push_back(std::make_pair((float)key.mTime, glm::vec3(key.mValue.x, key.mValue.y, key.mValue.z)));
+					}
+
+					data.Channels.push_back(std::move(channel));
+				}
+
+				Animations.push_back(std::move(data));
+			}
+		}
 		void Model::m_processNode(aiNode * node, const aiScene * scene)
 		{
 			for (unsigned int i = 0; i < node->mNumMeshes; i++)
@@ -148,6 +749,9 @@ namespace ed
 			std::vector<unsigned int> indices;
 			std::vector<Model::Mesh::Texture> textures;
 
+			vertices.reserve(mesh->mNumVertices);
+			indices.reserve(mesh->mNumFaces * 3);
+
 			// walk through each of the mesh's vertices
 			for (unsigned int i = 0; i < mesh->mNumVertices; i++)
 			{
@@ -221,13 +825,61 @@ namespace ed
 					indices.push_back(face.mIndices[j]);
 			}
 
+			// bones - the influences are sorted by weight and limited by aiProcess_LimitBoneWeights
+			std::vector<Model::Mesh::Influence> skin;
+			if (mesh->HasBones()) {
+				Model::Mesh::Influence none;
+				none.Bones = glm::uvec4(0);
+				none.Weights = glm::vec4(0.0f);
+				skin.resize(mesh->mNumVertices, none);
+
+				std::vector<int> used(mesh->mNumVertices, 0);
+				for (unsigned int b = 0; b < mesh->mNumBones; b++) {
+					aiBone* bone = mesh->mBones[b];
+
+					int node = m_findNode(bone->mName.data);
+					if (node == -1)
+						continue;
+
+					// meshes can share bones
+					int index = -1;
+					for (int i = 0; i < Bones.size(); i++)
+						if (Bones[i].Node == node)
+							index = i;
+					if (index == -1) {
+						Bone data;
+						data.Node = node;
+						data.Offset = toMat4(bone->mOffsetMatrix);
+						index = Bones.size();
+						Bones.push_back(data);
+					}
+
+					for (unsigned int w = 0; w < bone->mNumWeights; w++) {
+						unsigned int vert = bone->mWeights[w].mVertexId;
+						if (vert >= skin.size() || used[vert] >= MODEL_MAX_BONE_INFLUENCES)
+							continue;
+						skin[vert].Bones[used[vert]] = index;
+						skin[vert].Weights[used[vert]] = bone->mWeights[w].mWeight;
+						used[vert]++;
+					}
+				}
+
+				for (auto& infl : skin) {
+					float sum = infl.Weights.x + infl.Weights.y + infl.Weights.z + infl.Weights.w;
+					if (sum > 0.0f)
+						infl.Weights /= sum;
+				}
+			}
+
 			// process materials
 			aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
 
 			// TODO: textures
 
 			// return a mesh object created from the extracted mesh data
-			return Model::Mesh(mesh->mName.data, vertices, indices, textures);
+			Model::Mesh ret(mesh->mName.data, std::move(vertices), std::move(indices), std::move(textures));
+			ret.Skin = std::move(skin);
+			return ret;
 		}
 	}
 }
\ No newline at end of file
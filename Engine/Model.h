@@ -1,7 +1,18 @@
 #pragma once
+#include "BVH.h"
 #include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
 #include <string>
 #include <vector>
+#include <limits>
+
+#define MODEL_LOD_MAX 4						// max number of simplified levels per mesh
+#define MODEL_LOD_MIN_TRIANGLES 4096		// smaller meshes don't get LODs
+#define MODEL_LOD_PIXELS_PER_TRIANGLE 4.0f	// screen area (in pixels) that a triangle should cover when the LOD is picked automatically
+#define MODEL_MAX_BONE_INFLUENCES 4			// bones per vertex, Assimp drops the lightest ones
+#define MODEL_MESHLET_VERTICES 64			// meshlet limits that GL_NV_mesh_shader works best with
+#define MODEL_MESHLET_TRIANGLES 126
+#define MODEL_MESHLET_BINDING 8				// first of the 4 SSBO bindings that a mesh shader reads the meshlets from
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
@@ -30,6 +41,21 @@ namespace ed
 					unsigned int ID;
 					std::string Type;
 				};
+				struct LOD
+				{
+					unsigned int Offset, Count; // offset into the EBO & index count
+				};
+				struct Influence
+				{
+					glm::uvec4 Bones;	// indices into Model::Bones
+					glm::vec4 Weights; // sum up to 1, or to 0 if the vertex isn't skinned
+				};
+				struct Meshlet
+				{
+					unsigned int VertexOffset, VertexCount;		  // into MeshletVertices
+					unsigned int PrimitiveOffset, PrimitiveCount; // into MeshletPrimitives
+					glm::vec4 Bounds;							  // bounding sphere - center, radius
+				};
 
 				std::string Name;
 
@@ -37,34 +63,130 @@ namespace ed
 				std::vector<unsigned int> Indices;
 				std::vector<Texture> Textures;
 
+				// simplified index lists, stored after Indices in the EBO - Indices is always the full detail level
+				std::vector<LOD> LODs;
+				std::vector<unsigned int> LODIndices;
+
+				BVH Tree; // used for picking, built when the model is imported
+
+				// one per vertex, empty if the mesh has no bones
+				std::vector<Influence> Skin;
+
+				// the full detail level split into small clusters, only built if the GPU has mesh shaders - a mesh shader pass binds
+				// the VBO (18 floats per vertex), Meshlets, MeshletVertices & MeshletPrimitives to MODEL_MESHLET_BINDING + 0, 1, 2, 3
+				std::vector<Meshlet> Meshlets;
+				std::vector<unsigned int> MeshletVertices;	 // indices into Vertices
+				std::vector<unsigned int> MeshletPrimitives; // a triangle per uint - 3 8-bit indices into the meshlet's vertices
+
 				Mesh(const std::string& name, std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures);
 
-				void Draw(bool instanced = false, int iCount = 0);
+				// lod -> 0 is the full detail, levels that the mesh doesn't have fall back to its coarsest one
+				void Draw(bool instanced = false, int iCount = 0, int lod = 0);
+				void GetDrawRange(int lod, unsigned int& offset, unsigned int& count) const; // in indices
+				// uniform SHADERed_MeshletCount (if countLoc != -1) gets the mesh's meshlet count
+				void DrawMeshlets(unsigned int meshletsPerTask, int countLoc = -1);
+				void DrawMeshletsIndirect(long long offset, int countLoc = -1); // the command comes from the bound GL_DRAW_INDIRECT_BUFFER
 
 				unsigned int VAO, VBO, EBO;
+				unsigned int BindVBO, SkinBuffer; // skinned meshes only - the bind pose vertices & the influences, VBO holds the posed vertices
+				unsigned int MeshletBuffer, MeshletVertexBuffer, MeshletPrimitiveBuffer; // 0 if the mesh has no meshlets
 
 			private:
+				friend class Model;
 				void m_setup();
+				void m_bindMeshlets(int countLoc);
+			};
+
+			struct Node
+			{
+				std::string Name;
+				int Parent;			 // index into Nodes, parents come before their children
+				glm::mat4 Transform; // relative to the parent
+			};
+			struct Bone
+			{
+				int Node;
+				glm::mat4 Offset; // mesh space -> bone space
+			};
+			struct Animation
+			{
+				struct Channel
+				{
+					int Node;
+					std::vector<std::pair<float, glm::vec3>> Positions; // (time in ticks, value)
+					std::vector<std::pair<float, glm::quat>> Rotations;
+					std::vector<std::pair<float, glm::vec3>> Scales;
+				};
+
+				std::string Name;
+				float Duration; // in ticks
+				float TicksPerSecond;
+				std::vector<Channel> Channels;
 			};
 
+			Model();
 			~Model();
 
 			std::vector<Mesh> Meshes;
 			std::string Directory;
 
+			// skeleton & animations, only imported for meshes that have bones
+			std::vector<Node> Nodes;
+			std::vector<Bone> Bones;
+			std::vector<Animation> Animations;
+			unsigned int BoneBuffer; // SSBO with a mat4 per bone
+
+			// pose that the skinned meshes' VBOs hold, written by ModelSkinner - animation -1 is the bind pose, -2 -> not posed yet
+			int PosedAnimation;
+			float PosedTime;
+
 			std::vector<std::string> GetMeshNames();
-			bool LoadFromFile(const std::string& path);
-			void Draw(bool instanced = false, int iCount = 0);
+			// optimize -> run Assimp's vertex cache & mesh optimization steps (meshes might get merged), reorder the
+			//				vertices for fetch locality and generate the LODs
+			// useCache -> read/write a binary copy of the processed meshes next to the model file
+			bool LoadFromFile(const std::string& path, bool optimize = false, bool useCache = false);
+
+			// CPU part of LoadFromFile - doesn't touch GL so it can run on a worker thread
+			bool Import(const std::string& path, bool optimize = false, bool useCache = false);
+			// create the GL buffers for the imported meshes
+			void Upload();
+			void Draw(bool instanced = false, int iCount = 0, int lod = 0);
 			void Draw(const std::string& mesh);
 
+			inline bool HasMeshlets() { return !Meshes.empty() && !Meshes[0].Meshlets.empty(); }
+			void DrawMeshlets(unsigned int meshletsPerTask, int countLoc = -1);
+
+			// number of detail levels, including the full one
+			int GetLODCount();
+			int GetTriangleCount(int lod = 0);
+			// coarsest level that still has enough triangles for the given projected size (in pixels)
+			int PickLOD(float pixels);
+
 			inline glm::vec3 GetMinBound() { return m_minBound; }
 			inline glm::vec3 GetMaxBound() { return m_maxBound; }
 
+			inline bool IsSkinned() { return !Bones.empty(); }
+			std::vector<std::string> GetAnimationNames();
+			int FindAnimation(const std::string& name); // -1 if there is no such animation
+			// bone matrices (mesh space -> posed model space) at the given time, the animation loops - anim = -1 -> bind pose
+			void Animate(int anim, float seconds, std::vector<glm::mat4>& out);
+
+			// closest triangle hit (in model space) that is nearer than maxDist
+			bool Intersect(glm::vec3 orig, glm::vec3 dir, float& distHit, float maxDist = std::numeric_limits<float>::infinity());
+
 		private:
 			void m_findBounds();
 
 			glm::vec3 m_minBound, m_maxBound;
+			void m_buildTrees();
+			void m_buildLODs();
+			void m_buildMeshlets();
+			bool m_readCache(const std::string& path, bool optimize);
+			void m_writeCache(const std::string& path, bool optimize);
 			void m_processNode(aiNode* node, const aiScene* scene);
+			void m_processHierarchy(aiNode* node, int parent);
+			void m_processAnimations(const aiScene* scene);
+			int m_findNode(const std::string& name);
 			Model::Mesh m_processMesh(aiMesh* mesh, const aiScene* scene);
 		};
 	}
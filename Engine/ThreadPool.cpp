@@ -0,0 +1,71 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+namespace ed
+{
+	namespace eng
+	{
+		ThreadPool::ThreadPool(JobPriority priority, int maxConcurrency)
+		{
+			int workers = JobScheduler::Instance().GetThreadCount();
+
+			m_state = std::make_shared<State>();
+			m_state->Priority = priority;
+			m_state->MaxConcurrency = maxConcurrency <= 0 ? workers : std::min(maxConcurrency, workers);
+			m_state->Active = 0;
+			m_state->Cancelled = false;
+		}
+		ThreadPool::~ThreadPool()
+		{
+			Cancel();
+		}
+		void ThreadPool::Add(const std::function<void()>& task)
+		{
+			std::lock_guard<std::mutex> lock(m_state->Mutex);
+			m_state->Tasks.push(task);
+
+			if (m_state->Active < m_state->MaxConcurrency) {
+				m_state->Active++;
+				m_submit(m_state);
+			}
+		}
+		void ThreadPool::Cancel()
+		{
+			std::unique_lock<std::mutex> lock(m_state->Mutex);
+			m_state->Cancelled = true;
+			m_state->Tasks = std::queue<std::function<void()>>();
+			m_state->Signal.wait(lock, [&]() { return m_state->Active == 0; });
+			m_state->Cancelled = false;
+		}
+		void ThreadPool::m_submit(const std::shared_ptr<State>& state)
+		{
+			std::shared_ptr<State> ref = state;
+			JobScheduler::Instance().Add([ref]() { m_runNext(ref); }, state->Priority);
+		}
+		void ThreadPool::m_runNext(const std::shared_ptr<State>& state)
+		{
+			std::function<void()> task;
+			{
+				std::lock_guard<std::mutex> lock(state->Mutex);
+				if (state->Cancelled || state->Tasks.empty()) {
+					state->Active--;
+					state->Signal.notify_all();
+					return;
+				}
+
+				task = state->Tasks.front();
+				state->Tasks.pop();
+			}
+
+			task();
+
+			std::lock_guard<std::mutex> lock(state->Mutex);
+			if (!state->Cancelled && !state->Tasks.empty())
+				m_submit(state);
+			else {
+				state->Active--;
+				state->Signal.notify_all();
+			}
+		}
+	}
+}
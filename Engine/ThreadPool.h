@@ -0,0 +1,44 @@
+#pragma once
+#include <queue>
+#include <mutex>
+#include <memory>
+#include <functional>
+#include <condition_variable>
+#include "JobScheduler.h"
+
+namespace ed
+{
+	namespace eng
+	{
+		// a group of tasks that run on the JobScheduler's workers - at most maxConcurrency of them at the same time
+		// the pool is re-queued after every task so that jobs with a higher priority don't wait for the whole group
+		class ThreadPool
+		{
+		public:
+			ThreadPool(JobPriority priority = JobPriority::Loading, int maxConcurrency = 0); // 0 -> all of the workers
+			~ThreadPool(); // waits for the running tasks, the ones that haven't started yet are dropped
+
+			void Add(const std::function<void()>& task);
+			void Cancel(); // same as the destructor, the pool can be used again afterwards
+
+			inline int GetThreadCount() { return m_state->MaxConcurrency; }
+
+		private:
+			struct State
+			{
+				std::mutex Mutex;
+				std::condition_variable Signal;
+				std::queue<std::function<void()>> Tasks;
+				JobPriority Priority;
+				int MaxConcurrency;
+				int Active; // tasks that are running or are queued in the scheduler
+				bool Cancelled;
+			};
+
+			static void m_submit(const std::shared_ptr<State>& state);
+			static void m_runNext(const std::shared_ptr<State>& state);
+
+			std::shared_ptr<State> m_state;
+		};
+	}
+}
@@ -6,13 +6,13 @@ namespace ed
 	{
 		Timer::Timer()
 		{
-			m_start = std::chrono::system_clock::now();
+			m_start = std::chrono::steady_clock::now();
 			m_pause = false;
 			m_pauseTime = 0;
 		}
 		float Timer::Restart()
 		{
-			std::chrono::time_point<std::chrono::system_clock> end = std::chrono::system_clock::now();
+			std::chrono::time_point<std::chrono::steady_clock> end = std::chrono::steady_clock::now();
 
 			float ret = 0;
 			if (m_pause)
@@ -29,7 +29,7 @@ namespace ed
 		}
 		float Timer::GetElapsedTime()
 		{
-			std::chrono::time_point<std::chrono::system_clock> end = std::chrono::system_clock::now();
+			std::chrono::time_point<std::chrono::steady_clock> end = std::chrono::steady_clock::now();
 
 			float ret = 0;
 			if (m_pause)
@@ -43,13 +43,13 @@ namespace ed
 		{
 			if (!m_pause) {
 				m_pause = true;
-				m_pauseStart = std::chrono::system_clock::now();
+				m_pauseStart = std::chrono::steady_clock::now();
 			}
 		}
 		void Timer::Resume()
 		{
 			if (m_pause) {
-				std::chrono::time_point<std::chrono::system_clock> end = std::chrono::system_clock::now();
+				std::chrono::time_point<std::chrono::steady_clock> end = std::chrono::steady_clock::now();
 
 				m_pauseTime += std::chrono::duration_cast<std::chrono::microseconds>(end - m_pauseStart).count() / 1000000.0f;
 				m_pause = false;
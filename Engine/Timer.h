@@ -19,8 +19,8 @@ namespace ed
 			inline bool IsPaused() { return m_pause; }
 
 		private:
-			std::chrono::time_point<std::chrono::system_clock> m_start;
-			std::chrono::time_point<std::chrono::system_clock> m_pauseStart;
+			std::chrono::time_point<std::chrono::steady_clock> m_start;
+			std::chrono::time_point<std::chrono::steady_clock> m_pauseStart;
 			float m_pauseTime;
 			bool m_pause;
 		};
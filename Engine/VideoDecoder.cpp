@@ -0,0 +1,430 @@
+#include "VideoDecoder.h"
+#include "../Objects/Logger.h"
+
+#include <algorithm>
+#include <math.h>
+
+#ifdef SHADERED_VIDEO
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libavdevice/avdevice.h>
+#include <libavutil/hwcontext.h>
+#include <libavutil/imgutils.h>
+#include <libswscale/swscale.h>
+}
+#endif
+
+#if defined(_WIN32)
+	#define VIDEO_CAPTURE_FORMAT "dshow"
+	#define VIDEO_CAPTURE_DEVICE "video=" // dshow needs the name of the device
+#elif defined(__APPLE__)
+	#define VIDEO_CAPTURE_FORMAT "avfoundation"
+	#define VIDEO_CAPTURE_DEVICE "0:none"
+#else
+	#define VIDEO_CAPTURE_FORMAT "v4l2"
+	#define VIDEO_CAPTURE_DEVICE "/dev/video0"
+#endif
+
+namespace ed
+{
+	namespace eng
+	{
+#ifdef SHADERED_VIDEO
+		static enum AVPixelFormat getHardwareFormat(AVCodecContext* ctx, const enum AVPixelFormat* formats)
+		{
+			int hwFormat = *(int*)ctx->opaque;
+			for (const enum AVPixelFormat* fmt = formats; *fmt != AV_PIX_FMT_NONE; fmt++)
+				if (*fmt == hwFormat)
+					return *fmt;
+
+			// the hardware can't decode this stream -> let ffmpeg pick a software format
+			return avcodec_default_get_format(ctx, formats);
+		}
+		static int interruptRead(void* stop)
+		{
+			return ((std::atomic<bool>*)stop)->load() ? 1 : 0;
+		}
+#endif
+
+		VideoDecoder::VideoDecoder()
+		{
+			m_format = nullptr;
+			m_codec = nullptr;
+			m_hwDevice = nullptr;
+			m_sws = nullptr;
+			m_stream = -1;
+			m_hwFormat = -1;
+			m_timeBase = 0.0;
+			m_startTime = 0;
+			m_size = glm::ivec2(0, 0);
+			m_duration = 0.0;
+			m_frameRate = 0.0;
+			m_live = false;
+			m_queueDepth = VIDEO_FRAME_QUEUE;
+			m_head = m_count = 0;
+			m_seekRequested = false;
+			m_seekTime = 0.0;
+			m_eof = false;
+			m_stop = false;
+		}
+		VideoDecoder::~VideoDecoder()
+		{
+			Close();
+		}
+
+		bool VideoDecoder::IsSupported()
+		{
+#ifdef SHADERED_VIDEO
+			return true;
+#else
+			return false;
+#endif
+		}
+		const char* VideoDecoder::GetDefaultDevice()
+		{
+			return VIDEO_CAPTURE_DEVICE;
+		}
+
+		bool VideoDecoder::Open(const std::string& path, int queueDepth)
+		{
+			return m_open(path, nullptr, queueDepth);
+		}
+		bool VideoDecoder::OpenDevice(const std::string& device, int queueDepth)
+		{
+			return m_open(device, VIDEO_CAPTURE_FORMAT, queueDepth);
+		}
+		bool VideoDecoder::m_open(const std::string& url, const char* inputFormat, int queueDepth)
+		{
+			Close();
+
+#ifdef SHADERED_VIDEO
+			m_live = inputFormat != nullptr;
+			m_stop = false;
+
+			m_format = avformat_alloc_context();
+			m_format->interrupt_callback.callback = interruptRead;
+			m_format->interrupt_callback.opaque = &m_stop;
+
+			int ret = 0;
+			if (m_live) {
+				avdevice_register_all();
+
+				auto input = av_find_input_format(inputFormat);
+				if (input == nullptr) {
+					ed::Logger::Get().Log(std::string("FFmpeg was built without the ") + inputFormat + " capture input", true);
+					avformat_free_context(m_format);
+					m_format = nullptr;
+					return false;
+				}
+
+				ret = avformat_open_input(&m_format, url.c_str(), input, nullptr);
+			} else
+				ret = avformat_open_input(&m_format, url.c_str(), nullptr, nullptr);
+
+			if (ret < 0) {
+				ed::Logger::Get().Log((m_live ? "Failed to open capture device " : "Failed to open video file ") + url, true);
+				m_format = nullptr; // freed by avformat_open_input
+				return false;
+			}
+			if (avformat_find_stream_info(m_format, nullptr) < 0) {
+				ed::Logger::Get().Log("Failed to read the stream info of " + url, true);
+				Close();
+				return false;
+			}
+
+			m_stream = av_find_best_stream(m_format, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+			if (m_stream < 0) {
+				ed::Logger::Get().Log("No video stream in " + url, true);
+				Close();
+				return false;
+			}
+
+			AVStream* stream = m_format->streams[m_stream];
+			const AVCodec* decoder = avcodec_find_decoder(stream->codecpar->codec_id);
+			if (decoder == nullptr) {
+				ed::Logger::Get().Log("No decoder for the video stream in " + url, true);
+				Close();
+				return false;
+			}
+
+			m_codec = avcodec_alloc_context3(decoder);
+			avcodec_parameters_to_context(m_codec, stream->codecpar);
+
+			// use the first hardware decoder that can be created, software decoding otherwise
+			for (int i = 0;; i++) {
+				const AVCodecHWConfig* config = avcodec_get_hw_config(decoder, i);
+				if (config == nullptr)
+					break;
+
+				if ((config->methods & AV_CODEC_HW_CONFIG_METHOD_HW_DEVICE_CTX) && av_hwdevice_ctx_create(&m_hwDevice, config->device_type, nullptr, nullptr, 0) >= 0) {
+					m_hwFormat = config->pix_fmt;
+					m_codec->hw_device_ctx = av_buffer_ref(m_hwDevice);
+					m_codec->opaque = &m_hwFormat;
+					m_codec->get_format = getHardwareFormat;
+					break;
+				}
+			}
+
+			if (avcodec_open2(m_codec, decoder, nullptr) < 0) {
+				ed::Logger::Get().Log("Failed to open the video decoder for " + url, true);
+				Close();
+				return false;
+			}
+
+			m_timeBase = av_q2d(stream->time_base);
+			m_startTime = stream->start_time == AV_NOPTS_VALUE ? 0 : stream->start_time;
+			m_size = glm::ivec2(m_codec->width, m_codec->height);
+
+			AVRational rate = av_guess_frame_rate(m_format, stream, nullptr);
+			m_frameRate = (rate.num > 0 && rate.den > 0) ? av_q2d(rate) : 30.0;
+
+			if (!m_live) {
+				if (stream->duration != AV_NOPTS_VALUE)
+					m_duration = stream->duration * m_timeBase;
+				else if (m_format->duration != AV_NOPTS_VALUE)
+					m_duration = m_format->duration / (double)AV_TIME_BASE;
+			}
+
+			if (m_size.x <= 0 || m_size.y <= 0) {
+				ed::Logger::Get().Log("Invalid video size in " + url, true);
+				Close();
+				return false;
+			}
+
+			m_queueDepth = std::max<int>(1, std::min<int>(queueDepth, VIDEO_FRAME_QUEUE_MAX));
+			m_frames.resize(m_queueDepth);
+			for (int i = 0; i < m_queueDepth; i++) {
+				m_frames[i].PTS = -1.0;
+				m_frames[i].Pixels.resize(m_size.x * m_size.y * 4);
+			}
+
+			ed::Logger::Get().Log("Opened " + std::string(m_live ? "capture device " : "video ") + url + (m_hwFormat != -1 ? " (hardware decoding)" : " (software decoding)"));
+
+			m_thread = std::thread(&VideoDecoder::m_run, this);
+
+			return true;
+#else
+			ed::Logger::Get().Log("Failed to open " + url + " - SHADERed was built without video support", true);
+			return false;
+#endif
+		}
+		void VideoDecoder::Close()
+		{
+			if (m_thread.joinable()) {
+				{
+					std::unique_lock<std::mutex> lock(m_mutex);
+					m_stop = true;
+				}
+				m_wake.notify_one();
+				m_thread.join();
+			}
+
+#ifdef SHADERED_VIDEO
+			if (m_sws != nullptr)
+				sws_freeContext(m_sws);
+			if (m_codec != nullptr)
+				avcodec_free_context(&m_codec);
+			if (m_hwDevice != nullptr)
+				av_buffer_unref(&m_hwDevice);
+			if (m_format != nullptr)
+				avformat_close_input(&m_format);
+#endif
+
+			m_format = nullptr;
+			m_codec = nullptr;
+			m_hwDevice = nullptr;
+			m_sws = nullptr;
+			m_stream = -1;
+			m_hwFormat = -1;
+			m_head = m_count = 0;
+			m_seekRequested = false;
+			m_eof = false;
+
+			m_frames.clear();
+		}
+
+		bool VideoDecoder::GetFrame(double time, double& pts, const std::function<void(const unsigned char*)>& copy)
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			if (m_duration > 0.0) {
+				time = fmod(time, m_duration);
+				if (time < 0.0)
+					time += m_duration;
+			}
+
+			if (m_format == nullptr || m_seekRequested || m_count == 0) {
+				// reached the end or the decoder stopped
+				if (m_format != nullptr && m_count == 0 && m_eof && !m_live)
+					m_seek(time);
+				return false;
+			}
+
+			if (m_live) {
+				// the front frame was already shown -> move on to the next one that arrived
+				if (m_count > 1 && m_frames[m_head].PTS == pts) {
+					m_head = (m_head + 1) % m_queueDepth;
+					m_count--;
+					m_wake.notify_one();
+				}
+			} else {
+				double frameTime = 1.0 / m_frameRate;
+
+				// jumped back (or looped around)
+				if (time < m_frames[m_head].PTS - frameTime) {
+					m_seek(time);
+					return false;
+				}
+
+				// drop the frames that are already late, the front frame is always kept
+				bool dropped = false;
+				while (m_count > 1 && m_frames[(m_head + 1) % m_queueDepth].PTS <= time + frameTime * 0.5) {
+					m_head = (m_head + 1) % m_queueDepth;
+					m_count--;
+					dropped = true;
+				}
+				if (dropped)
+					m_wake.notify_one();
+
+				// jumped too far ahead to catch up by decoding
+				if (m_count == 1 && !m_eof && time - m_frames[m_head].PTS > 1.0) {
+					m_seek(time);
+					return false;
+				}
+			}
+
+			const Frame& frame = m_frames[m_head];
+			if (frame.PTS == pts)
+				return false;
+
+			pts = frame.PTS;
+			copy(frame.Pixels.data());
+
+			return true;
+		}
+
+		void VideoDecoder::m_seek(double time)
+		{
+			m_seekRequested = true;
+			m_seekTime = time;
+			m_wake.notify_one();
+		}
+		void VideoDecoder::m_run()
+		{
+#ifdef SHADERED_VIDEO
+			AVPacket* packet = av_packet_alloc();
+			AVFrame* frame = av_frame_alloc();
+			AVFrame* swFrame = av_frame_alloc();
+			double skipUntil = -1.0;
+			int64_t captured = 0;
+
+			while (true) {
+				bool seek = false;
+				double seekTime = 0.0;
+				int slot = 0;
+
+				{
+					std::unique_lock<std::mutex> lock(m_mutex);
+
+					// devices don't wait for the playback, the oldest frame is overwritten instead
+					m_wake.wait(lock, [&] { return m_stop || m_seekRequested || (!m_eof && (m_live || m_count < m_queueDepth)); });
+
+					if (m_stop)
+						break;
+
+					if (m_seekRequested) {
+						seek = true;
+						seekTime = m_seekTime;
+					} else
+						slot = (m_head + m_count) % m_queueDepth;
+				}
+
+				if (seek) {
+					av_seek_frame(m_format, m_stream, m_startTime + (int64_t)(seekTime / m_timeBase), AVSEEK_FLAG_BACKWARD);
+					avcodec_flush_buffers(m_codec);
+					skipUntil = seekTime - 0.5 / m_frameRate;
+
+					std::unique_lock<std::mutex> lock(m_mutex);
+					m_head = m_count = 0;
+					m_eof = false;
+					if (m_seekTime == seekTime) // no other seek was requested in the meantime
+						m_seekRequested = false;
+					continue;
+				}
+
+				int ret = avcodec_receive_frame(m_codec, frame);
+				if (ret == AVERROR(EAGAIN)) {
+					if (av_read_frame(m_format, packet) < 0)
+						avcodec_send_packet(m_codec, nullptr); // drain the decoder at the end of the file
+					else {
+						if (packet->stream_index == m_stream)
+							avcodec_send_packet(m_codec, packet);
+						av_packet_unref(packet);
+					}
+					continue;
+				} else if (ret < 0) {
+					std::unique_lock<std::mutex> lock(m_mutex);
+					m_eof = true;
+					continue;
+				}
+
+				// device timestamps aren't reliable, the frames are only numbered
+				int64_t timestamp = frame->best_effort_timestamp;
+				double pts = 0.0;
+				if (m_live)
+					pts = (captured++) / m_frameRate;
+				else if (timestamp != AV_NOPTS_VALUE)
+					pts = (timestamp - m_startTime) * m_timeBase;
+
+				// decoding from the last keyframe to the seek target
+				if (pts < skipUntil) {
+					av_frame_unref(frame);
+					continue;
+				}
+				skipUntil = -1.0;
+
+				AVFrame* src = frame;
+				if (m_hwFormat != -1 && frame->format == m_hwFormat) {
+					if (av_hwframe_transfer_data(swFrame, frame, 0) < 0) {
+						av_frame_unref(frame);
+						continue;
+					}
+					src = swFrame;
+				}
+
+				m_sws = sws_getCachedContext(m_sws, src->width, src->height, (AVPixelFormat)src->format,
+					m_size.x, m_size.y, AV_PIX_FMT_RGBA, SWS_BILINEAR, nullptr, nullptr, nullptr);
+
+				if (m_live) {
+					std::unique_lock<std::mutex> lock(m_mutex);
+					if (m_count == m_queueDepth) {
+						m_head = (m_head + 1) % m_queueDepth;
+						m_count--;
+					}
+					slot = (m_head + m_count) % m_queueDepth;
+				}
+
+				// the slot behind the queue isn't touched by GetFrame, no need to hold the lock while converting
+				Frame& out = m_frames[slot];
+				uint8_t* dst[4] = { out.Pixels.data(), nullptr, nullptr, nullptr };
+				int dstStride[4] = { m_size.x * 4, 0, 0, 0 };
+				if (m_sws != nullptr)
+					sws_scale(m_sws, src->data, src->linesize, 0, src->height, dst, dstStride);
+				out.PTS = pts;
+
+				av_frame_unref(swFrame);
+				av_frame_unref(frame);
+
+				std::unique_lock<std::mutex> lock(m_mutex);
+				if (!m_seekRequested)
+					m_count++;
+			}
+
+			av_frame_free(&swFrame);
+			av_frame_free(&frame);
+			av_packet_free(&packet);
+#endif
+		}
+	}
+}
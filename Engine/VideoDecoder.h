@@ -0,0 +1,91 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <functional>
+#include <atomic>
+#include <condition_variable>
+
+#define VIDEO_FRAME_QUEUE 4 // decoded frames that the decoder thread can be ahead of the playback
+#define VIDEO_FRAME_QUEUE_MAX 16
+
+struct AVFormatContext;
+struct AVCodecContext;
+struct AVBufferRef;
+struct SwsContext;
+
+namespace ed
+{
+	namespace eng
+	{
+		// decodes a video file or a capture device to RGBA frames on a background thread - FFmpeg is only
+		// linked when SHADERed is built with the SHADERED_VIDEO CMake option, Open() fails otherwise
+		class VideoDecoder
+		{
+		public:
+			VideoDecoder();
+			~VideoDecoder();
+
+			static bool IsSupported();
+
+			bool Open(const std::string& path, int queueDepth = VIDEO_FRAME_QUEUE);
+			// webcams, capture cards... through v4l2/dshow/avfoundation - the frames are shown in the order they
+			// arrive, at most queueDepth of them are kept (lower -> less latency, higher -> less dropped frames)
+			bool OpenDevice(const std::string& device, int queueDepth = 1);
+			void Close();
+
+			static const char* GetDefaultDevice();
+
+			inline glm::ivec2 GetSize() { return m_size; }
+			inline double GetDuration() { return m_duration; }
+			inline double GetFrameRate() { return m_frameRate; }
+			inline bool IsHardwareDecoded() { return m_hwFormat != -1; }
+			inline bool IsLive() { return m_live; }
+			inline int GetQueueDepth() { return m_queueDepth; }
+
+			// calls copy with the RGBA pixels of the frame that should be shown at time (in seconds, wrapped
+			// around the duration) if it's ready and pts isn't its timestamp already - pts is then updated
+			// jumping back or far ahead makes the decoder seek, the frames are skipped until it catches up
+			// capture devices ignore the time and advance by one queued frame per call
+			bool GetFrame(double time, double& pts, const std::function<void(const unsigned char*)>& copy);
+
+		private:
+			struct Frame
+			{
+				double PTS;
+				std::vector<unsigned char> Pixels;
+			};
+
+			bool m_open(const std::string& url, const char* inputFormat, int queueDepth);
+			void m_run();
+			void m_seek(double time); // call with m_mutex locked
+
+			AVFormatContext* m_format;
+			AVCodecContext* m_codec;
+			AVBufferRef* m_hwDevice;
+			SwsContext* m_sws;
+			int m_stream;
+			int m_hwFormat; // AVPixelFormat of the hardware frames, -1 -> software decoding
+			double m_timeBase;
+			int64_t m_startTime;
+
+			glm::ivec2 m_size;
+			double m_duration, m_frameRate;
+			bool m_live;
+
+			// ring of decoded frames, m_head is the one that's shown
+			std::vector<Frame> m_frames;
+			int m_queueDepth;
+			int m_head, m_count;
+			bool m_seekRequested, m_eof;
+			double m_seekTime;
+
+			std::thread m_thread;
+			std::mutex m_mutex;
+			std::condition_variable m_wake;
+			std::atomic<bool> m_stop; // also interrupts a blocking read from a device
+		};
+	}
+}
@@ -10,6 +10,9 @@
 #include "UI/ObjectListUI.h"
 #include "UI/MessageOutputUI.h"
 #include "UI/PixelInspectUI.h"
+#include "UI/ProfilerUI.h"
+#include "UI/MemoryUI.h"
+#include "UI/ShaderTraceUI.h"
 #include "UI/PipelineUI.h"
 #include "UI/PropertyUI.h"
 #include "UI/PreviewUI.h"
@@ -23,26 +26,37 @@
 #include "UI/Debug/ValuesUI.h"
 #include "UI/Debug/WatchUI.h"
 #include "Objects/Logger.h"
+#include "Objects/ProfilerZones.h"
 #include "Objects/Names.h"
 #include "Objects/Settings.h"
 #include "Objects/ThemeContainer.h"
+#include "Objects/FontAtlasCache.h"
 #include "Objects/CameraSnapshots.h"
 #include "Objects/Export/ExportCPP.h"
 #include "Objects/KeyboardShortcuts.h"
 #include "Objects/FunctionVariableManager.h"
 #include "Objects/SystemVariableManager.h"
+#include "Objects/VideoEncoder.h"
+#include "Objects/ProjectArchive.h"
+#include "Objects/RenderDocCapture.h"
+#include "Objects/RemotePreview.h"
+#include "Objects/InputRecorder.h"
+#include "Objects/TiledRender.h"
+#include "Objects/ImageDownsampler.h"
+#include "Objects/HDRImageWriter.h"
+#include "Objects/FrameProfiler.h"
+#include "Objects/TraceRecorder.h"
+#include "Objects/ObjectExporter.h"
+#include "Engine/ThreadPool.h"
+#include "Engine/FramePacer.h"
+#include "Objects/PluginAPI/PluginProfiler.h"
 
 #include <fstream>
+#include <mutex>
+#include <condition_variable>
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include <stb/stb_image_write.h>
 
-#define STBIR_DEFAULT_FILTER_DOWNSAMPLE   STBIR_FILTER_CATMULLROM
-#define STB_IMAGE_RESIZE_IMPLEMENTATION
-#include <stb/stb_image_resize.h>
-/*	STBIR_FILTER_CUBICBSPLINE
-	STBIR_FILTER_CATMULLROM
-	STBIR_FILTER_MITCHELL		*/
-
 #include <ghc/filesystem.hpp>
 
 #if defined(__APPLE__)
@@ -58,14 +72,67 @@
 
 #define getByte(value, n) (value >> (n*8) & 0xFF)
 
+// video encoders for the sequence export (ffmpeg names) and the container used when the path has an image extension
+const char* VIDEO_CODEC_NAMES[] = { "libx264", "libx265", "libvpx-vp9", "prores_ks", "mpeg4" };
+const char* VIDEO_CODEC_CONTAINERS[] = { "mp4", "mp4", "webm", "mov", "avi" };
+const char* VIDEO_PIXEL_FORMATS[] = { "yuv420p", "yuv444p", "yuv422p10le", "yuv444p10le" };
+
 namespace ed
 {
+	// what a saved preview reads back - the HDR formats read the float / 16 bit data of the textures
+	struct PreviewReadback
+	{
+		GLenum Type, Format; // glGetTexImage's type & the format of the downsampled texture
+		int PixelSize;
+		std::vector<std::pair<std::string, GLuint>> Layers; // the first one is the image, the rest are EXR layers
+	};
+	static PreviewReadback getPreviewReadback(InterfaceManager* data, const std::string& ext, bool png16, int exrType, bool exrLayers, int source, const glm::ivec2& size)
+	{
+		PreviewReadback ret;
+		ret.Type = GL_UNSIGNED_BYTE;
+		ret.Format = GL_RGBA8;
+		ret.PixelSize = 4;
+		if (ext == "exr") {
+			ret.Type = exrType == 0 ? GL_HALF_FLOAT : GL_FLOAT;
+			ret.Format = exrType == 0 ? GL_RGBA16F : GL_RGBA32F;
+			ret.PixelSize = exrType == 0 ? 8 : 16;
+		} else if (ext == "png" && png16) {
+			ret.Type = GL_UNSIGNED_SHORT;
+			ret.Format = GL_RGBA16;
+			ret.PixelSize = 8;
+		}
+
+		// only the render textures that have the size of the image can be saved
+		std::vector<std::pair<std::string, GLuint>> textures;
+		textures.push_back(std::make_pair("Window", data->Renderer.GetTexture()));
+		int index = 0;
+		for (ObjectManagerItem* item : data->Objects.GetItemDataList()) {
+			if (item->RT == nullptr)
+				continue;
+
+			index++;
+			if (item->RT->CalculateSize(size.x, size.y) == size) {
+				textures.push_back(std::make_pair(item->Name, item->Texture));
+				if (index == source)
+					std::swap(textures[0], textures.back());
+			} else if (index == source)
+				Logger::Get().Log(item->Name + " doesn't have the size of the saved image, the window is saved instead", true);
+		}
+
+		ret.Layers.push_back(std::make_pair(std::string(), textures[0].second));
+		if (ext == "exr" && exrLayers)
+			ret.Layers.insert(ret.Layers.end(), textures.begin() + 1, textures.end());
+
+		return ret;
+	}
+
 	GUIManager::GUIManager(ed::InterfaceManager* objects, SDL_Window* wnd, SDL_GLContext* gl)
 	{
 		m_data = objects;
 		m_wnd = wnd;
 		m_gl  = gl;
 		m_settingsBkp = new Settings();
+		m_history = new ProjectHistory(objects);
 		m_previewSaveSize = glm::ivec2(1920, 1080);
 		m_savePreviewPopupOpened = false;
 		m_optGroup = 0;
@@ -74,12 +141,17 @@ namespace ed
 		m_cachedFontSize = 15;
 		m_performanceMode = false;
 		m_perfModeFake = false;
+		m_windowVisible = true;
 		m_fontNeedsUpdate = false;
 		m_isCreateItemPopupOpened = false;
 		m_isCreateCubemapOpened = false;
+		m_isCreateTexArrayOpened = false;
 		m_isCreateRTOpened = false;
 		m_isCreateBufferOpened = false;
+		m_isCreateCaptureOpened = false;
+		m_isConnectRemoteOpened = false;
 		m_isNewProjectPopupOpened = false;
+		m_traceSeconds = 5.0f;
 		m_isUpdateNotificationOpened = false;
 		m_isRecordCameraSnapshotOpened = false;
 		m_exportAsCPPOpened = false;
@@ -88,11 +160,23 @@ namespace ed
 		m_wasPausedPrior = true;
 		m_savePreviewSeq = false;
 		m_cacheProjectModified = false;
+		m_recoveryTimer = 0.0f;
 		m_isCreateImg3DOpened = false;
 		m_isInfoOpened = false;
 		m_savePreviewSeqDuration = 5.5f;
 		m_savePreviewSeqFPS = 30;
+		m_savePreviewVideo = false;
+		m_savePreviewVideoCodec = 0;
+		m_savePreviewVideoBitrate = 20000;
+		m_savePreviewVideoFormat = 0;
 		m_savePreviewSupersample = 0;
+		m_savePreviewTiled = false;
+		m_savePreviewTileSize = TILED_RENDER_DEFAULT_TILE;
+		m_savePreviewSource = 0;
+		m_savePreview16Bit = false;
+		m_savePreviewExrLayers = false;
+		m_savePreviewExrType = 0;
+		m_savePreviewExrCompression = 2;
 		m_iconFontLarge = nullptr;
 		m_expcppBackend = 0;
 		m_expcppCmakeFiles = true;
@@ -100,6 +184,8 @@ namespace ed
 		m_expcppImage = true;
 		m_expcppMemoryShaders = true;
 		m_expcppCopyImages = true;
+		m_expcppOptimized = false;
+		m_expcppBenchmark = false;
 		memset(&m_expcppProjectName[0], 0, 64*sizeof(char));
 		strcpy(m_expcppProjectName, "ShaderProject");
 		m_expcppSavePath = "./export.cpp";
@@ -111,7 +197,7 @@ namespace ed
 		Logger::Get().Log("Initializing Dear ImGUI");
 		
 		// set vsync on startup
-		SDL_GL_SetSwapInterval(Settings::Instance().General.VSync);
+		eng::FramePacer::ApplyVSync(Settings::Instance().General.VSync, Settings::Instance().General.AdaptiveVSync);
 
 		// Initialize imgui
 		ImGui::CreateContext();
@@ -140,6 +226,9 @@ namespace ed
 		m_views.push_back(new PipelineUI(this, objects, "Pipeline"));
 		m_views.push_back(new PropertyUI(this, objects, "Properties"));
 		m_views.push_back(new PixelInspectUI(this, objects, "Pixel Inspect"));
+		m_views.push_back(new ProfilerUI(this, objects, "Profiler", false));
+		m_views.push_back(new MemoryUI(this, objects, "Memory", false));
+		m_views.push_back(new ShaderTraceUI(this, objects, "Shader Trace", false));
 
 		m_debugViews.push_back(new DebugWatchUI(this, objects, "Watch"));
 		m_debugViews.push_back(new DebugValuesUI(this, objects, "Variables"));
@@ -193,6 +282,13 @@ namespace ed
 
 		Logger::Get().Log("Shutting down UI");
 
+		// the snapshots are only needed after a crash
+		if (m_recovery.HasSnapshot())
+			m_recovery.Discard();
+
+		RemoteClient::Instance().Disconnect(); // deletes the GL texture
+		ObjectExporter::Instance().Finish();
+
 		for (auto& view : m_views)
 			delete view;
 		for (auto& dview : m_debugViews)
@@ -202,12 +298,62 @@ namespace ed
 		delete m_objectPrev;
 		delete m_createUI;
 		delete m_settingsBkp;
+		delete m_history;
 
 		ImGui_ImplSDL2_Shutdown();
 		ImGui_ImplOpenGL3_Shutdown();
 		ImGui::DestroyContext();
 	}
 
+	void GUIManager::m_saveRecoverySnapshot()
+	{
+		ED_ZONE("GUIManager::m_saveRecoverySnapshot");
+
+		// projects that were never saved don't have a directory for the snapshot
+		std::string project = m_data->Parser.GetOpenedFile();
+		if (project != m_recoveryProject && m_recovery.HasSnapshot())
+			m_recovery.Discard();
+		m_recoveryProject = project;
+		if (project.empty())
+			return;
+
+		std::vector<std::pair<std::string, std::string>> unsaved;
+		((CodeEditorUI*)Get(ViewID::Code))->GetUnsavedFiles(unsaved);
+
+		if (!m_data->Parser.IsProjectModified() && unsaved.empty()) {
+			if (m_recovery.HasSnapshot())
+				m_recovery.Discard();
+			m_recoveryFiles.clear();
+			return;
+		}
+
+		// only the serialization happens on this thread - the worker gets the files that changed as new strings
+		std::map<std::string, std::shared_ptr<const std::string>> files;
+		auto share = [&](const std::string& path, std::string& data) {
+			auto last = m_recoveryFiles.find(path);
+			if (last != m_recoveryFiles.end() && *last->second == data)
+				files[path] = last->second;
+			else
+				files[path] = std::make_shared<const std::string>(std::move(data));
+		};
+
+		std::vector<std::pair<std::string, std::string>> sources;
+		for (auto& file : unsaved) {
+			std::string copy = ProjectRecovery::GetSourcePath(project, file.first);
+			sources.push_back(std::make_pair(file.first, copy));
+			share(m_data->Parser.GetProjectPath(copy), file.second);
+		}
+
+		std::string xml = m_data->Parser.ExportRecoverySnapshot(sources);
+		share(ProjectRecovery::GetSnapshotPath(project), xml);
+
+		std::vector<ProjectRecovery::File> snapshot;
+		for (const auto& file : files)
+			snapshot.push_back({ file.first, file.second });
+		m_recovery.Write(snapshot);
+
+		m_recoveryFiles.swap(files);
+	}
 	void GUIManager::OnEvent(const SDL_Event& e)
 	{
 		m_imguiHandleEvent(e);
@@ -233,9 +379,9 @@ namespace ed
 			if (!file.empty() && dotPos != std::string::npos) {
 				std::string ext = file.substr(dotPos + 1);
 
-				const std::vector<std::string> imgExt = { "png", "jpeg", "jpg", "bmp", "gif", "psd", "pic", "pnm", "hdr", "tga" };
+				const std::vector<std::string> imgExt = { "png", "jpeg", "jpg", "bmp", "gif", "psd", "pic", "pnm", "hdr", "tga", "dds", "ktx", "ktx2" };
 				const std::vector<std::string> sndExt = { "ogg", "wav", "flac", "aiff", "raw" }; // TODO: more file ext
-				const std::vector<std::string> projExt = { "sprj" };
+				const std::vector<std::string> projExt = { "sprj", PROJECT_ARCHIVE_EXTENSION };
 
 				if (std::count(projExt.begin(), projExt.end(), ext) > 0) {
 					bool cont = true;
@@ -474,6 +620,13 @@ namespace ed
 	}
 	void GUIManager::Update(float delta)
 	{
+		ED_ZONE("GUIManager::Update");
+
+		PluginProfiler::Instance().EndFrame();
+		m_data->Plugins.FinishJobs();
+		eng::JobScheduler::Instance().RunCompletions();
+		ObjectExporter::Instance().Update();
+
 		// add star to the titlebar if project was modified
 		if (m_cacheProjectModified != m_data->Parser.IsProjectModified()) {
 			std::string projName = m_data->Parser.GetOpenedFile();
@@ -495,7 +648,22 @@ namespace ed
 			m_cacheProjectModified = m_data->Parser.IsProjectModified();
 		}
 
+		// the edits made in the last frame become undo steps once the widgets are released
+		m_history->Update(ImGui::IsAnyItemActive());
+
 		Settings& settings = Settings::Instance();
+
+		if (settings.General.Recovery) {
+			m_recoveryTimer += delta;
+			if (m_recoveryTimer >= RECOVERY_INTERVAL) {
+				m_recoveryTimer = 0.0f;
+				m_saveRecoverySnapshot();
+			}
+		}
+
+		// apply the shaders that finished compiling in the background
+		m_data->Renderer.UpdateCompilation();
+
 		m_performanceMode = m_perfModeFake;
 
 		// update audio textures
@@ -520,31 +688,57 @@ namespace ed
 			ImFontAtlas* fonts = ImGui::GetIO().Fonts;
 			fonts->Clear();
 
-			ImFont* font = fonts->AddFontFromFileTTF(m_cachedFont.c_str(), m_cachedFontSize * Settings::Instance().DPIScale);
+			float fontSize = m_cachedFontSize * Settings::Instance().DPIScale;
+			float edFontSize = edFont.second * Settings::Instance().DPIScale;
+			float iconLargeSize = (TOOLBAR_HEIGHT/2) * Settings::Instance().DPIScale;
+			static const ImWchar icon_ranges[] = { 0xea5b, 0xf026, 0 };
+
+			// rasterizing the atlas is a big part of the startup on high DPI displays - it is stored in the cache with the programs
+			bool useCache = Settings::Instance().General.ProgramCache;
+			uint64_t cacheKey = FontAtlasCache::Hash({ { m_cachedFont, fontSize }, { edFont.first, edFontSize }, { "data/icofont.ttf", iconLargeSize } },
+				"merged icons;oversampleH=1;" + std::to_string(icon_ranges[0]) + "-" + std::to_string(icon_ranges[1]));
+
+			ImFont* font = nullptr;
+			ImFont* edFontPtr = nullptr;
+			if (useCache && FontAtlasCache::Load(cacheKey, fonts, 3)) {
+				font = fonts->Fonts[0];
+				edFontPtr = fonts->Fonts[1];
+				m_iconFontLarge = fonts->Fonts[2];
+			} else {
+				fonts->Flags &= ~ImFontAtlasFlags_NoMouseCursors; // set by FontAtlasCache::Load()
 
-			// icon font
-  			ImGuiIO& io = ImGui::GetIO();
-			ImFontConfig config;
-			config.MergeMode = true;
-  			static const ImWchar icon_ranges[] = { 0xea5b, 0xf026, 0 };
-			io.Fonts->AddFontFromFileTTF("data/icofont.ttf", m_cachedFontSize * Settings::Instance().DPIScale, &config, icon_ranges);
-			
-			ImFont* edFontPtr = fonts->AddFontFromFileTTF(edFont.first.c_str(), edFont.second * Settings::Instance().DPIScale);
+				font = fonts->AddFontFromFileTTF(m_cachedFont.c_str(), fontSize);
 
-			if (font == nullptr || edFontPtr == nullptr) {
-				fonts->Clear();
-				font = fonts->AddFontDefault();
-				edFontPtr = fonts->AddFontDefault();
+				// icon font
+  				ImGuiIO& io = ImGui::GetIO();
+				ImFontConfig config;
+				config.MergeMode = true;
+				config.OversampleH = 1; // icons don't need the subpixel positioning, this cuts the atlas rasterization a lot
+				io.Fonts->AddFontFromFileTTF("data/icofont.ttf", fontSize, &config, icon_ranges);
 
-				Logger::Get().Log("Failed to load fonts", true);
-			}
+				edFontPtr = fonts->AddFontFromFileTTF(edFont.first.c_str(), edFontSize);
+
+				bool failed = font == nullptr || edFontPtr == nullptr;
+				if (failed) {
+					fonts->Clear();
+					font = fonts->AddFontDefault();
+					edFontPtr = fonts->AddFontDefault();
+
+					Logger::Get().Log("Failed to load fonts", true);
+				}
 
-			// icon font large
-			ImFontConfig configIconsLarge;
-			m_iconFontLarge = io.Fonts->AddFontFromFileTTF("data/icofont.ttf", (TOOLBAR_HEIGHT/2) * Settings::Instance().DPIScale, &configIconsLarge, icon_ranges);
+				// icon font large
+				ImFontConfig configIconsLarge;
+				configIconsLarge.OversampleH = 1;
+				m_iconFontLarge = io.Fonts->AddFontFromFileTTF("data/icofont.ttf", iconLargeSize, &configIconsLarge, icon_ranges);
+
+				fonts->Build();
+
+				if (useCache && !failed && m_iconFontLarge != nullptr)
+					FontAtlasCache::Save(cacheKey, fonts);
+			}
 
 			ImGui::GetIO().FontDefault = font;
-			fonts->Build();
 
 			ImGui_ImplOpenGL3_DestroyFontsTexture();
 			ImGui_ImplOpenGL3_CreateFontsTexture();
@@ -586,20 +780,8 @@ namespace ed
 			ImGui::DockSpace(dockspace_id, ImVec2(0.0f, 0.0f), ImGuiDockNodeFlags_None);
 		}
 
-		// rebuild
-		if (((CodeEditorUI*)Get(ViewID::Code))->TrackedFilesNeedUpdate()) {
-			std::vector<bool> needsUpdate = ((CodeEditorUI*)Get(ViewID::Code))->TrackedNeedsUpdate();
-			std::vector<PipelineItem*> passes = m_data->Pipeline.GetList();
-			int ind = 0;
-			if (needsUpdate.size() >= passes.size()) {
-				for (PipelineItem*& pass : passes) {
-					if (needsUpdate[ind])
-						m_data->Renderer.Recompile(pass->Name);
-					ind++;
-				}
-			}
-			((CodeEditorUI*)Get(ViewID::Code))->EmptyTrackedFiles();
-		}
+		// rebuild the stages whose files changed on the disk
+		((CodeEditorUI*)Get(ViewID::Code))->UpdateTrackedFiles();
 		((CodeEditorUI*)Get(ViewID::Code))->UpdateAutoRecompileItems();
 
 		// menu
@@ -705,6 +887,11 @@ namespace ed
 				ImGui::EndMenu();
 			}
 			if (ImGui::BeginMenu("Project")) {
+				if (ImGui::MenuItem("Undo", KeyboardShortcuts::Instance().GetString("Project.Undo").c_str(), false, m_history->CanUndo()))
+					m_history->Undo();
+				if (ImGui::MenuItem("Redo", KeyboardShortcuts::Instance().GetString("Project.Redo").c_str(), false, m_history->CanRedo()))
+					m_history->Redo();
+				ImGui::Separator();
 				if (ImGui::MenuItem("Rebuild project", KeyboardShortcuts::Instance().GetString("Project.Rebuild").c_str())) {
 					((CodeEditorUI*)Get(ViewID::Code))->SaveAll();
 
@@ -714,6 +901,70 @@ namespace ed
 				}
 				if (ImGui::MenuItem("Render", KeyboardShortcuts::Instance().GetString("Preview.SaveImage").c_str()))
 					m_savePreviewPopupOpened = true;
+				if (ImGui::MenuItem("Capture frame in RenderDoc", KeyboardShortcuts::Instance().GetString("Preview.RenderDocCapture").c_str(), false, RenderDocCapture::Instance().IsAvailable()))
+					RenderDocCapture::Instance().Request();
+				if (ImGui::BeginMenu("Share preview")) {
+					if (UIHelper::CreateShareMenuItems(""))
+						m_data->Parser.ModifyProject();
+					ImGui::EndMenu();
+				}
+				if (ImGui::BeginMenu("Input recording")) {
+					InputRecorder& recorder = InputRecorder::Instance();
+					if (recorder.IsRecording()) {
+						if (ImGui::MenuItem("Stop recording"))
+							recorder.StopRecording();
+					} else if (ImGui::MenuItem("Start recording", nullptr, false, !recorder.IsReplaying()))
+						recorder.StartRecording();
+
+					if (recorder.IsReplaying()) {
+						if (ImGui::MenuItem("Stop replay"))
+							recorder.StopReplay();
+					} else if (ImGui::MenuItem("Replay", nullptr, false, recorder.GetFrameCount() > 0 && !recorder.IsRecording())) {
+						m_data->Renderer.Pause(false); // the frames are only replayed while the preview renders
+						recorder.StartReplay();
+					}
+
+					ImGui::Separator();
+					if (ImGui::MenuItem("Save...", nullptr, false, recorder.GetFrameCount() > 0 && !recorder.IsRecording())) {
+						std::string file;
+						if (UIHelper::GetSaveFileDialog(file, "sedi"))
+							recorder.Save(file);
+					}
+					if (ImGui::MenuItem("Load...", nullptr, false, !recorder.IsRecording())) {
+						std::string file;
+						if (UIHelper::GetOpenFileDialog(file, "sedi"))
+							recorder.Load(file);
+					}
+
+					if (recorder.GetFrameCount() > 0)
+						ImGui::TextDisabled("%d frames, %.2fs", recorder.GetFrameCount(), recorder.GetDuration());
+					ImGui::EndMenu();
+				}
+				if (ImGui::BeginMenu("Record trace")) {
+					TraceRecorder& tracer = TraceRecorder::Instance();
+					if (tracer.IsRecording()) {
+						if (ImGui::MenuItem("Stop recording"))
+							tracer.Stop();
+						ImGui::TextDisabled("%.1fs left", tracer.GetRemaining());
+					} else {
+						ImGui::PushItemWidth(100 * Settings::Instance().DPIScale);
+						if (ImGui::InputFloat("seconds", &m_traceSeconds, 1.0f, 5.0f, "%.1f"))
+							m_traceSeconds = std::max(m_traceSeconds, 0.1f);
+						ImGui::PopItemWidth();
+
+						if (ImGui::MenuItem("Start recording...")) {
+							std::string file;
+							if (UIHelper::GetSaveFileDialog(file, "json"))
+								tracer.Start(file, m_traceSeconds);
+						}
+					}
+					ImGui::EndMenu();
+				}
+				if (RemoteClient::Instance().IsConnected()) {
+					if (ImGui::MenuItem("Disconnect from remote renderer"))
+						RemoteClient::Instance().Disconnect();
+				} else if (ImGui::MenuItem("Connect to remote renderer"))
+					m_isConnectRemoteOpened = true;
 				if (ImGui::BeginMenu("Create")) {
 					if (ImGui::MenuItem("Shader Pass", KeyboardShortcuts::Instance().GetString("Project.NewShaderPass").c_str()))
 						this->CreateNewShaderPass();
@@ -726,8 +977,20 @@ namespace ed
 						this->CreateNewTexture();
 					if (ImGui::MenuItem("Cubemap", KeyboardShortcuts::Instance().GetString("Project.NewCubeMap").c_str()))
 						this->CreateNewCubemap();
+					if (ImGui::MenuItem("Texture array"))
+						this->CreateNewTextureArray();
+					if (ImGui::MenuItem("Virtual texture", nullptr, false, VirtualTexture::IsSupported()))
+						this->CreateNewVirtualTexture();
+					if (ImGui::MenuItem("Environment map", nullptr, false, EnvironmentMap::IsSupported()))
+						this->CreateNewEnvironment();
+					if (ImGui::MenuItem("Image sequence"))
+						this->CreateNewImageSequence();
 					if (ImGui::MenuItem("Audio", KeyboardShortcuts::Instance().GetString("Project.NewAudio").c_str()))
 						this->CreateNewAudio();
+					if (ImGui::MenuItem("Video", nullptr, false, eng::VideoDecoder::IsSupported()))
+						this->CreateNewVideo();
+					if (ImGui::MenuItem("Capture device", nullptr, false, eng::VideoDecoder::IsSupported()))
+						this->CreateNewCaptureDevice();
 					if (ImGui::MenuItem("Render Texture", KeyboardShortcuts::Instance().GetString("Project.NewRenderTexture").c_str()))
 						this->CreateNewRenderTexture();
 					if (ImGui::MenuItem("Buffer", KeyboardShortcuts::Instance().GetString("Project.NewBuffer").c_str()))
@@ -875,22 +1138,38 @@ namespace ed
 			ImGui::EndMainMenuBar();
 		}
 
-		if (m_performanceMode)
+		// the pipeline isn't executed while nobody can see the preview
+		bool previewShown = false;
+		if (m_performanceMode && m_windowVisible) {
 			((PreviewUI*)Get(ViewID::Preview))->Update(delta);
+			previewShown = true;
+		}
 
 		ImGui::End();
 
 
+		// only measure GPU times while someone is looking at them
+		m_data->Renderer.GetProfiler().SetEnabled((Get(ViewID::Profiler)->Visible && !m_performanceMode) || TraceRecorder::Instance().IsRecording());
+		FrameProfiler::Instance().SetEnabled((Get(ViewID::Profiler)->Visible || FrameProfiler::Instance().ShowOverlay) && !m_performanceMode);
+
 		if (!m_performanceMode) {
 			for (auto& view : m_views)
 				if (view->Visible) {
+					FrameProfiler::ViewScope viewScope(view->Name);
 					ImGui::SetNextWindowSizeConstraints(ImVec2(80, 80), ImVec2(m_width*2, m_height*2));
-					if (ImGui::Begin(view->Name.c_str(), &view->Visible)) view->Update(delta);
+					if (ImGui::Begin(view->Name.c_str(), &view->Visible)) {
+						// a docked preview behind another tab doesn't get here
+						bool isPreview = view == Get(ViewID::Preview);
+						if (!isPreview || m_windowVisible)
+							view->Update(delta);
+						previewShown |= isPreview && m_windowVisible;
+					}
 					ImGui::End();
 				}
 			if (m_data->Debugger.IsDebugging()) {
 				for (auto& dview : m_debugViews)
 					if (dview->Visible) {
+						FrameProfiler::ViewScope viewScope(dview->Name);
 						ImGui::SetNextWindowSizeConstraints(ImVec2(80, 80), ImVec2(m_width * 2, m_height * 2));
 						if (ImGui::Begin(dview->Name.c_str(), &dview->Visible)) dview->Update(delta);
 						ImGui::End();
@@ -898,12 +1177,19 @@ namespace ed
 			}
 
 			m_data->Plugins.Update(delta);
+
+			FrameProfiler::ViewScope codeScope(Get(ViewID::Code)->Name);
 			Get(ViewID::Code)->Update(delta);
 		}
 
+		if (!previewShown)
+			((PreviewUI*)Get(ViewID::Preview))->UpdateHidden(delta);
+
 		// object preview
-		if (((ed::ObjectPreviewUI*)m_objectPrev)->ShouldRun() && !m_performanceMode)
+		if (((ed::ObjectPreviewUI*)m_objectPrev)->ShouldRun() && !m_performanceMode) {
+			FrameProfiler::ViewScope viewScope(m_objectPrev->Name);
 			m_objectPrev->Update(delta);
+		}
 
 		// handle the "build occured" event
 		if (settings.General.AutoOpenErrorWindow && m_data->Messages.BuildOccured) {
@@ -952,12 +1238,30 @@ namespace ed
 			m_isCreateCubemapOpened = false;
 		}
 
+		// open popup for creating texture array
+		if (m_isCreateTexArrayOpened) {
+			ImGui::OpenPopup("Create texture array##main_create_texarray");
+			m_isCreateTexArrayOpened = false;
+		}
+
 		// open popup for creating buffer
 		if (m_isCreateBufferOpened) {
 			ImGui::OpenPopup("Create buffer##main_create_buffer");
 			m_isCreateBufferOpened = false;
 		}
 
+		// open popup for creating capture device
+		if (m_isCreateCaptureOpened) {
+			ImGui::OpenPopup("Create capture device##main_create_capture");
+			m_isCreateCaptureOpened = false;
+		}
+
+		// open popup for connecting to a remote renderer
+		if (m_isConnectRemoteOpened) {
+			ImGui::OpenPopup("Connect to remote renderer##main_connect_remote");
+			m_isConnectRemoteOpened = false;
+		}
+
 		// open popup for creating image
 		if (m_isCreateImgOpened) {
 			ImGui::OpenPopup("Create image##main_create_img");
@@ -1088,6 +1392,44 @@ namespace ed
 			ImGui::EndPopup();
 		}
 
+		// Create texture array popup
+		ImGui::SetNextWindowSize(ImVec2(430 * Settings::Instance().DPIScale, 300 * Settings::Instance().DPIScale), ImGuiCond_Once);
+		if (ImGui::BeginPopupModal("Create texture array##main_create_texarray")) {
+			static char buf[65] = { 0 };
+			ImGui::InputText("Name", buf, 64);
+
+			static std::vector<std::string> layers;
+
+			ImGui::TextWrapped("All layers must be images of the same size.");
+			ImGui::BeginChild("##main_texarray_layers", ImVec2(0, -ImGui::GetFrameHeightWithSpacing() * 2));
+			for (int i = 0; i < layers.size(); i++) {
+				ImGui::Text("%d: %s", i, layers[i].c_str());
+				ImGui::SameLine();
+				ImGui::SetCursorPosX(ImGui::GetWindowWidth() - 70);
+				if (ImGui::Button(("Remove##texarray_layer" + std::to_string(i)).c_str())) {
+					layers.erase(layers.begin() + i);
+					i--;
+				}
+			}
+			ImGui::EndChild();
+
+			if (ImGui::Button("Add layer")) {
+				std::string file;
+				if (UIHelper::GetOpenFileDialog(file, "png;bmp;jpg,jpeg;tga"))
+					layers.push_back(m_data->Parser.GetRelativePath(file));
+			}
+
+			if (ImGui::Button("Ok") && strlen(buf) > 0 && !m_data->Objects.Exists(buf)) {
+				if (m_data->Objects.CreateTextureArray(buf, layers)) {
+					layers.clear();
+					ImGui::CloseCurrentPopup();
+				}
+			}
+			ImGui::SameLine();
+			if (ImGui::Button("Cancel")) ImGui::CloseCurrentPopup();
+			ImGui::EndPopup();
+		}
+
 		// Create RT popup
 		ImGui::SetNextWindowSize(ImVec2(430 * Settings::Instance().DPIScale, 175 * Settings::Instance().DPIScale), ImGuiCond_Once);
 		if (ImGui::BeginPopupModal("Create RT##main_create_rt")) {
@@ -1146,6 +1488,50 @@ namespace ed
 			ImGui::EndPopup();
 		}
 
+		// Create capture device popup
+		ImGui::SetNextWindowSize(ImVec2(430 * Settings::Instance().DPIScale, 175 * Settings::Instance().DPIScale), ImGuiCond_Once);
+		if (ImGui::BeginPopupModal("Create capture device##main_create_capture")) {
+			static char buf[MAX_PATH] = { 0 };
+			static int queue = 1;
+			if (buf[0] == 0)
+				strcpy(buf, eng::VideoDecoder::GetDefaultDevice());
+
+			ImGui::InputText("Device", buf, MAX_PATH - 1);
+			ImGui::DragInt("Queue depth", &queue, 0.1f, 1, VIDEO_FRAME_QUEUE_MAX);
+			if (ImGui::IsItemHovered())
+				ImGui::SetTooltip("Frames that are buffered before they are shown - 1 for the lowest latency, more to drop less frames");
+
+			if (ImGui::Button("Ok")) {
+				if (m_data->Objects.CreateCaptureDevice(buf, queue))
+					ImGui::CloseCurrentPopup();
+			}
+			ImGui::SameLine();
+			if (ImGui::Button("Cancel")) ImGui::CloseCurrentPopup();
+			ImGui::EndPopup();
+		}
+
+		// Connect to remote renderer popup
+		ImGui::SetNextWindowSize(ImVec2(430 * Settings::Instance().DPIScale, 200 * Settings::Instance().DPIScale), ImGuiCond_Once);
+		if (ImGui::BeginPopupModal("Connect to remote renderer##main_connect_remote")) {
+			static char host[256] = { 0 };
+			static int port = REMOTE_DEFAULT_PORT;
+			static char token[65] = { 0 };
+
+			ImGui::InputText("Host", host, 255);
+			ImGui::InputInt("Port", &port);
+			port = std::max(1, std::min(port, 65535));
+			ImGui::InputText("Token", token, 64, ImGuiInputTextFlags_Password);
+			ImGui::TextDisabled("The server is started with SHADERed --serve project.sprj --port %d and logs its token", port);
+
+			if (ImGui::Button("Ok")) {
+				if (RemoteClient::Instance().Connect(host, port, token))
+					ImGui::CloseCurrentPopup();
+			}
+			ImGui::SameLine();
+			if (ImGui::Button("Cancel")) ImGui::CloseCurrentPopup();
+			ImGui::EndPopup();
+		}
+
 		// Create empty image popup
 		ImGui::SetNextWindowSize(ImVec2(430 * Settings::Instance().DPIScale, 175 * Settings::Instance().DPIScale), ImGuiCond_Once);
 		if (ImGui::BeginPopupModal("Create image##main_create_img"))
@@ -1170,22 +1556,49 @@ namespace ed
 		}
 
 		// Create empty 3D image
-		ImGui::SetNextWindowSize(ImVec2(430 * Settings::Instance().DPIScale, 175 * Settings::Instance().DPIScale), ImGuiCond_Once);
+		ImGui::SetNextWindowSize(ImVec2(430 * Settings::Instance().DPIScale, 300 * Settings::Instance().DPIScale), ImGuiCond_Once);
 		if (ImGui::BeginPopupModal("Create 3D image##main_create_img3D"))
 		{
 			static char buf[65] = { 0 };
 			static glm::ivec3 size(0, 0, 0);
+			static std::vector<std::string> slices;
 
 			ImGui::InputText("Name", buf, 64);
-			ImGui::DragInt3("Size", glm::value_ptr(size));
-			if (size.x <= 0) size.x = 1;
-			if (size.y <= 0) size.y = 1;
-			if (size.z <= 0) size.z = 1;
+			if (slices.empty()) {
+				ImGui::DragInt3("Size", glm::value_ptr(size));
+				if (size.x <= 0) size.x = 1;
+				if (size.y <= 0) size.y = 1;
+				if (size.z <= 0) size.z = 1;
+			} else
+				ImGui::TextWrapped("The size is taken from the slices - all of them must be images of the same size.");
+
+			// optional - the slices are loaded in the background once the image exists
+			ImGui::BeginChild("##main_img3D_slices", ImVec2(0, -ImGui::GetFrameHeightWithSpacing() * 2));
+			for (int i = 0; i < slices.size(); i++) {
+				ImGui::Text("%d: %s", i, slices[i].c_str());
+				ImGui::SameLine();
+				ImGui::SetCursorPosX(ImGui::GetWindowWidth() - 70);
+				if (ImGui::Button(("Remove##img3D_slice" + std::to_string(i)).c_str())) {
+					slices.erase(slices.begin() + i);
+					i--;
+				}
+			}
+			ImGui::EndChild();
+
+			if (ImGui::Button("Add slice")) {
+				std::string file;
+				if (UIHelper::GetOpenFileDialog(file, "png;bmp;jpg,jpeg;tga"))
+					slices.push_back(m_data->Parser.GetRelativePath(file));
+			}
 
 			if (ImGui::Button("Ok"))
 			{
-				if (m_data->Objects.CreateImage3D(buf, size))
+				if (m_data->Objects.CreateImage3D(buf, slices.empty() ? size : glm::ivec3(1, 1, 1))) {
+					if (!slices.empty())
+						m_data->Objects.LoadImage3DSlices(buf, slices);
+					slices.clear();
 					ImGui::CloseCurrentPopup();
+				}
 			}
 			ImGui::SameLine();
 			if (ImGui::Button("Cancel"))
@@ -1245,6 +1658,9 @@ namespace ed
 			ImGui::TextWrapped("KeysWASD (vec4) - W, A, S or D keys state");
 			ImGui::TextWrapped("Mouse (vec4) - vec4(x,y,left,right) updated every frame");
 			ImGui::TextWrapped("MouseButton (vec4) - vec4(viewX,viewY,clickX,clickY) updated only when left mouse button is down");
+			ImGui::TextWrapped("ViewLeft, ViewRight (mat4) - View of the left & right eye, see the project's eye separation");
+			ImGui::TextWrapped("ProjectionLeft, ProjectionRight (mat4) - off-axis Projection of the left & right eye");
+			ImGui::TextWrapped("ViewProjectionLeft, ViewProjectionRight (mat4) - Projection*View of the left & right eye");
 
 			ImGui::NewLine();
 			ImGui::Separator();
@@ -1318,7 +1734,7 @@ namespace ed
 			ImGui::TextWrapped("Path: %s", m_previewSavePath.c_str());
 			ImGui::SameLine();
 			if (ImGui::Button("...##save_prev_path"))
-				UIHelper::GetSaveFileDialog(m_previewSavePath, "png;jpg,jpeg;bmp;tga");
+				UIHelper::GetSaveFileDialog(m_previewSavePath, "png;exr;jpg,jpeg;bmp;tga");
 			
 			ImGui::Text("Width: ");
 			ImGui::SameLine();
@@ -1338,6 +1754,65 @@ namespace ed
 			ImGui::Combo("##save_prev_ssmp", &m_savePreviewSupersample, " 1x\0 2x\0 4x\0 8x\0");
 			ImGui::Unindent(105);
 
+			ImGui::Text("Tiled: ");
+			ImGui::SameLine();
+			ImGui::Indent(105);
+			ImGui::Checkbox("##save_prev_tiled", &m_savePreviewTiled);
+			if (ImGui::IsItemHovered())
+				ImGui::SetTooltip("Render the image in tiles - always used for images larger than the maximum texture size");
+			if (m_savePreviewTiled) {
+				ImGui::SameLine();
+				ImGui::InputInt("##save_prev_tilesize", &m_savePreviewTileSize, 256, 1024);
+				m_savePreviewTileSize = std::max(64, m_savePreviewTileSize);
+			}
+			ImGui::Unindent(105);
+
+			ImGui::Separator();
+			if (ImGui::CollapsingHeader("HDR")) {
+				ImGui::TextWrapped("Float render textures can be saved as linear EXR or 16 bit PNG");
+
+				/* SOURCE */
+				std::string sourceNames = "Window";
+				sourceNames.push_back(0);
+				for (ObjectManagerItem* item : m_data->Objects.GetItemDataList())
+					if (item->RT != nullptr) {
+						sourceNames += item->Name;
+						sourceNames.push_back(0);
+					}
+				sourceNames.push_back(0);
+
+				ImGui::Text("Source:");
+				ImGui::SameLine();
+				ImGui::PushItemWidth(-1);
+				ImGui::Combo("##save_prev_source", &m_savePreviewSource, sourceNames.c_str());
+				ImGui::PopItemWidth();
+
+				/* 16 BIT PNG */
+				ImGui::Text("16 bit PNG:");
+				ImGui::SameLine();
+				ImGui::Checkbox("##save_prev_png16", &m_savePreview16Bit);
+
+				/* EXR */
+				ImGui::Text("EXR pixels:");
+				ImGui::SameLine();
+				ImGui::PushItemWidth(-1);
+				ImGui::Combo("##save_prev_exrtype", &m_savePreviewExrType, "Half\0Float\0");
+				ImGui::PopItemWidth();
+
+				ImGui::Text("EXR compression:");
+				ImGui::SameLine();
+				ImGui::PushItemWidth(-1);
+				ImGui::Combo("##save_prev_exrcomp", &m_savePreviewExrCompression, "None\0ZIPS\0ZIP\0");
+				ImGui::PopItemWidth();
+
+				ImGui::Text("EXR layers:");
+				ImGui::SameLine();
+				ImGui::Checkbox("##save_prev_exrlayers", &m_savePreviewExrLayers);
+				if (ImGui::IsItemHovered())
+					ImGui::SetTooltip("Add the other render textures with the size of the image as layers");
+			}
+			ImGui::Separator();
+
 			ImGui::Separator();
 			if (ImGui::CollapsingHeader("Sequence")) {
 				ImGui::TextWrapped("Export a sequence of images");
@@ -1366,6 +1841,39 @@ namespace ed
 				ImGui::DragInt("##save_prev_seqfps", &m_savePreviewSeqFPS);
 				ImGui::PopItemWidth();
 
+				/* VIDEO */
+				ImGui::Text("Video:");
+				ImGui::SameLine();
+				ImGui::Checkbox("##save_prev_video", &m_savePreviewVideo);
+
+				if (m_savePreviewSeq && !m_savePreviewVideo) {
+					ImGui::PushItemFlag(ImGuiItemFlags_Disabled, true);
+					ImGui::PushStyleVar(ImGuiStyleVar_Alpha, ImGui::GetStyle().Alpha * 0.5f);
+				}
+
+				ImGui::Text("Codec:");
+				ImGui::SameLine();
+				ImGui::PushItemWidth(-1);
+				ImGui::Combo("##save_prev_vcodec", &m_savePreviewVideoCodec, VIDEO_CODEC_NAMES, HARRAYSIZE(VIDEO_CODEC_NAMES));
+				ImGui::PopItemWidth();
+
+				ImGui::Text("Bitrate (kbit/s):");
+				ImGui::SameLine();
+				ImGui::PushItemWidth(-1);
+				ImGui::DragInt("##save_prev_vbitrate", &m_savePreviewVideoBitrate, 100.0f, 0, 1000000);
+				ImGui::PopItemWidth();
+
+				ImGui::Text("Pixel format:");
+				ImGui::SameLine();
+				ImGui::PushItemWidth(-1);
+				ImGui::Combo("##save_prev_vfmt", &m_savePreviewVideoFormat, VIDEO_PIXEL_FORMATS, HARRAYSIZE(VIDEO_PIXEL_FORMATS));
+				ImGui::PopItemWidth();
+
+				if (m_savePreviewSeq && !m_savePreviewVideo) {
+					ImGui::PopItemFlag();
+					ImGui::PopStyleVar();
+				}
+
 				if (!m_savePreviewSeq) {
 					ImGui::PopItemFlag();
 					ImGui::PopStyleVar();
@@ -1432,8 +1940,18 @@ namespace ed
 				int actualSizeX = m_previewSaveSize.x * sizeMulti;
 				int actualSizeY = m_previewSaveSize.y * sizeMulti;
 
+				// the saved image shouldn't contain passes that are still compiling
+				m_data->Renderer.WaitForCompilation();
+
+				// images larger than a texture can only be rendered in tiles
+				bool tiled = m_savePreviewTiled || TiledRender::IsTooLarge(actualSizeX, actualSizeY);
+
 				// normal render
 				if (!m_savePreviewSeq) {
+					std::string ext = m_previewSavePath.substr(m_previewSavePath.find_last_of('.')+1);
+					PreviewReadback readback = getPreviewReadback(m_data, ext, m_savePreview16Bit, m_savePreviewExrType, m_savePreviewExrLayers, m_savePreviewSource, glm::ivec2(actualSizeX, actualSizeY));
+					bool tiledHDR = tiled && (readback.Type != GL_UNSIGNED_BYTE || readback.Layers[0].second != m_data->Renderer.GetTexture());
+
 					if (actualSizeX > 0 && actualSizeY > 0) {
 						SystemVariableManager::Instance().CopyState();
 						
@@ -1443,43 +1961,52 @@ namespace ed
 						SystemVariableManager::Instance().SetMousePosition(m_savePreviewMouse.x, m_savePreviewMouse.y);
 						SystemVariableManager::Instance().SetMouse(m_savePreviewMouse.x, m_savePreviewMouse.y, m_savePreviewMouse.z, m_savePreviewMouse.w);
 						
-						m_data->Renderer.Render(actualSizeX, actualSizeY);
+						if (tiledHDR)
+							Logger::Get().Log("HDR images and render textures can't be rendered in tiles", true);
+						else if (tiled)
+							TiledRender::Save(&m_data->Renderer, m_previewSavePath, m_previewSaveSize.x, m_previewSaveSize.y, sizeMulti, m_savePreviewTileSize);
+						else
+							m_data->Renderer.Render(actualSizeX, actualSizeY);
 
 						SystemVariableManager::Instance().AdvanceTimer(m_savePreviewCachedTime - m_savePreviewTimeDelta);
 					}
 
-					unsigned char* pixels = (unsigned char*)malloc(actualSizeX * actualSizeY * 4);
-					unsigned char* outPixels = nullptr;
-					
-					if (sizeMulti != 1)
-						outPixels = (unsigned char*)malloc(m_previewSaveSize.x * m_previewSaveSize.y * 4);
-					else outPixels = pixels;
-
-
-					GLuint tex = m_data->Renderer.GetTexture();
-					glBindTexture(GL_TEXTURE_2D, tex);
-					glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
-					glBindTexture(GL_TEXTURE_2D, 0);
+					// the tiles were already written to the file
+					if (!tiled) {
+						size_t layerSize = (size_t)m_previewSaveSize.x * m_previewSaveSize.y * readback.PixelSize;
+						unsigned char* outPixels = (unsigned char*)calloc(layerSize * readback.Layers.size(), 1);
 
-					// resize image
-					if (sizeMulti != 1) {
-						stbir_resize_uint8(pixels, actualSizeX, actualSizeY, actualSizeX * 4,
-							outPixels, m_previewSaveSize.x, m_previewSaveSize.y, m_previewSaveSize.x * 4, 4);
-					}
+						// supersampled images are shrunk on the GPU so only the final size is read back
+						std::vector<HDRImageWriter::Layer> layers;
+						for (int i = 0; i < readback.Layers.size(); i++) {
+							GLuint tex = readback.Layers[i].second;
+							if (sizeMulti != 1)
+								tex = ImageDownsampler::Instance().Downsample(tex, glm::ivec2(actualSizeX, actualSizeY), sizeMulti, readback.Format);
 
-					std::string ext = m_previewSavePath.substr(m_previewSavePath.find_last_of('.')+1);
+							if (tex != 0) {
+								glBindTexture(GL_TEXTURE_2D, tex);
+								glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, readback.Type, outPixels + i * layerSize);
+								glBindTexture(GL_TEXTURE_2D, 0);
+							}
 
-					if (ext == "jpg" || ext == "jpeg")
-						stbi_write_jpg(m_previewSavePath.c_str(), m_previewSaveSize.x, m_previewSaveSize.y, 4, outPixels, 100);
-					else if (ext == "bmp")
-						stbi_write_bmp(m_previewSavePath.c_str(), m_previewSaveSize.x, m_previewSaveSize.y, 4, outPixels);
-					else if (ext == "tga")
-						stbi_write_tga(m_previewSavePath.c_str(), m_previewSaveSize.x, m_previewSaveSize.y, 4, outPixels);
-					else
-						stbi_write_png(m_previewSavePath.c_str(), m_previewSaveSize.x, m_previewSaveSize.y, 4, outPixels, m_previewSaveSize.x * 4);
+							layers.push_back({ readback.Layers[i].first, outPixels + i * layerSize });
+						}
 
-					if (sizeMulti != 1) free(outPixels);
-					free(pixels);
+						if (ext == "exr")
+							HDRImageWriter::WriteEXR(m_previewSavePath, m_previewSaveSize.x, m_previewSaveSize.y, layers, (HDRImageWriter::PixelType)m_savePreviewExrType, (HDRImageWriter::Compression)m_savePreviewExrCompression);
+						else if (readback.Type == GL_UNSIGNED_SHORT)
+							HDRImageWriter::WritePNG16(m_previewSavePath, m_previewSaveSize.x, m_previewSaveSize.y, (uint16_t*)outPixels);
+						else if (ext == "jpg" || ext == "jpeg")
+							stbi_write_jpg(m_previewSavePath.c_str(), m_previewSaveSize.x, m_previewSaveSize.y, 4, outPixels, 100);
+						else if (ext == "bmp")
+							stbi_write_bmp(m_previewSavePath.c_str(), m_previewSaveSize.x, m_previewSaveSize.y, 4, outPixels);
+						else if (ext == "tga")
+							stbi_write_tga(m_previewSavePath.c_str(), m_previewSaveSize.x, m_previewSaveSize.y, 4, outPixels);
+						else
+							stbi_write_png(m_previewSavePath.c_str(), m_previewSaveSize.x, m_previewSaveSize.y, 4, outPixels, m_previewSaveSize.x * 4);
+
+						free(outPixels);
+					}
 				}
 				else { // sequence render
 
@@ -1492,138 +2019,210 @@ namespace ed
 						
 						float curTime = 0.0f;
 						
-						GLuint tex = m_data->Renderer.GetTexture();
-						
 						size_t lastDot = m_previewSavePath.find_last_of('.');
 						std::string ext = lastDot == std::string::npos ? "png" : m_previewSavePath.substr(lastDot+1);
 						std::string filename = m_previewSavePath;
 						
-						// allow only one %??d
-						bool inFormat = false;
-						int lastFormatPos = -1;
-						int formatCount = 0;
-						for (int i = 0; i < filename.size(); i++) {
-							if (filename[i] == '%') {
-								inFormat = true;
-								lastFormatPos = i;
-								continue;
-							}
+						// video: one file, image extensions are replaced with the codec's container
+						VideoEncoder video;
+						if (m_savePreviewVideo) {
+							if (lastDot == std::string::npos || ext == "png" || ext == "exr" || ext == "jpg" || ext == "jpeg" || ext == "bmp" || ext == "tga")
+								filename = filename.substr(0, lastDot) + "." + VIDEO_CODEC_CONTAINERS[m_savePreviewVideoCodec];
 
-							if (inFormat) {
-								if (isdigit(filename[i])) { }
-								else {
-									if (filename[i] != '%' &&
-										((filename[i] == 'd' && formatCount > 0) ||
-											(filename[i] != 'd')))
-									{
-										filename.insert(lastFormatPos, 1, '%');
-									}
+							video.Open(filename, m_previewSaveSize.x, m_previewSaveSize.y, m_savePreviewSeqFPS, VIDEO_CODEC_NAMES[m_savePreviewVideoCodec], m_savePreviewVideoBitrate, VIDEO_PIXEL_FORMATS[m_savePreviewVideoFormat]);
+						}
+						else {
+							// allow only one %??d
+							bool inFormat = false;
+							int lastFormatPos = -1;
+							int formatCount = 0;
+							for (int i = 0; i < filename.size(); i++) {
+								if (filename[i] == '%') {
+									inFormat = true;
+									lastFormatPos = i;
+									continue;
+								}
 
-									if (filename[i] == 'd')
-										formatCount++;
-									inFormat = false;
+								if (inFormat) {
+									if (isdigit(filename[i])) { }
+									else {
+										if (filename[i] != '%' &&
+											((filename[i] == 'd' && formatCount > 0) ||
+												(filename[i] != 'd')))
+										{
+											filename.insert(lastFormatPos, 1, '%');
+										}
+
+										if (filename[i] == 'd')
+											formatCount++;
+										inFormat = false;
+									}
 								}
 							}
-						}
 
-						// no %d found? add one
-						if (formatCount == 0)
-							filename.insert(lastDot == std::string::npos ? filename.size() : lastDot, "%d"); // frame%d
+							// no %d found? add one
+							if (formatCount == 0)
+								filename.insert(lastDot == std::string::npos ? filename.size() : lastDot, "%d"); // frame%d
+						}
 					
 						SystemVariableManager::Instance().AdvanceTimer(m_savePreviewCachedTime - m_savePreviewTimeDelta);
 						SystemVariableManager::Instance().SetTimeDelta(seqDelta);
 
 						stbi_write_png_compression_level = 5; // set to lowest compression level
 
-						int tCount = std::thread::hardware_concurrency();
-						tCount = tCount == 0 ? 2 : tCount;
+						// the encoders share the workers with the rest of the background work
+						int tCount = eng::JobScheduler::Instance().GetThreadCount();
+
+						// frames are read back through a ring of PBOs so that we don't stall on the GPU every frame
+						const int pboCount = 3;
+						int outW = m_previewSaveSize.x, outH = m_previewSaveSize.y;
+						PreviewReadback readback = getPreviewReadback(m_data, m_savePreviewVideo ? std::string() : ext, m_savePreview16Bit, m_savePreviewExrType, m_savePreviewExrLayers, m_savePreviewSource, glm::ivec2(actualSizeX, actualSizeY));
+						size_t layerSize = (size_t)outW * outH * readback.PixelSize;
+						size_t frameSize = layerSize * readback.Layers.size(); // the frames are downsampled before the readback
+						GLuint pbos[pboCount];
+						GLsync fences[pboCount] = { 0 };
+						int pboFrame[pboCount];
+						glGenBuffers(pboCount, pbos);
+						for (int i = 0; i < pboCount; i++) {
+							glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[i]);
+							glBufferData(GL_PIXEL_PACK_BUFFER, frameSize, NULL, GL_STREAM_READ);
+							pboFrame[i] = -1;
+						}
+						glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+						// pixel buffers that aren't used by the encoders - we block on this list when the encoders can't keep up
+						int bufferCount = tCount * 2;
+						std::vector<unsigned char*> pixels(bufferCount);
+						std::vector<int> freeBuffers;
+						std::mutex bufferMutex;
+						std::condition_variable bufferSignal;
+						for (int i = 0; i < bufferCount; i++) {
+							pixels[i] = (unsigned char*)malloc(frameSize);
+							freeBuffers.push_back(i);
+						}
+
+						// frames have to reach the video encoder in order so they all go through one thread
+						eng::ThreadPool encoders(eng::JobPriority::Export, m_savePreviewVideo ? 1 : 0);
+
+						// copy the finished PBO to a free buffer and hand it to the encoders
+						auto encodeFrame = [&](int pbo) {
+							int buffer = 0;
+							{
+								std::unique_lock<std::mutex> lock(bufferMutex);
+								bufferSignal.wait(lock, [&]() { return !freeBuffers.empty(); });
+								buffer = freeBuffers.back();
+								freeBuffers.pop_back();
+							}
 
-						unsigned char** pixels = new unsigned char*[tCount];
-						unsigned char** outPixels = new unsigned char* [tCount];
-						int* curFrame = new int[tCount];
-						bool* needsUpdate = new bool[tCount];
-						std::thread** threadPool = new std::thread*[tCount];
-						std::atomic<bool> isOver = false;
+							while (glClientWaitSync(fences[pbo], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED);
+							glDeleteSync(fences[pbo]);
+							fences[pbo] = 0;
 
-						for (int i = 0; i < tCount; i++) {
-							curFrame[i] = 0;
-							needsUpdate[i] = true;
-							pixels[i] = (unsigned char*)malloc(actualSizeX * actualSizeY * 4);
-							
-							if (sizeMulti != 1) outPixels[i] = (unsigned char*)malloc(m_previewSaveSize.x * m_previewSaveSize.y * 4);
-							else outPixels[i] = nullptr;
+							int frame = pboFrame[pbo];
+							pboFrame[pbo] = -1;
+
+							glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[pbo]);
+							void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, frameSize, GL_MAP_READ_BIT);
+							if (data != nullptr) {
+								memcpy(pixels[buffer], data, frameSize);
+								glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+							}
+							glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
 
-							threadPool[i] = new std::thread([ext, filename, sizeMulti, actualSizeX, actualSizeY, &outPixels, &pixels, &needsUpdate, &curFrame, &isOver](int worker, int w, int h) {
+							if (data == nullptr) {
+								Logger::Get().Log("Failed to read back frame " + std::to_string(frame), true);
+
+								std::lock_guard<std::mutex> lock(bufferMutex);
+								freeBuffers.push_back(buffer);
+								return;
+							}
+
+							encoders.Add([&, buffer, frame]() {
 								char prevSavePath[MAX_PATH];
-								while (!isOver) {
-									if (needsUpdate[worker])
-										continue;
-
-									// resize image
-									if (sizeMulti != 1) {
-										stbir_resize_uint8(pixels[worker], actualSizeX, actualSizeY, actualSizeX * 4,
-											outPixels[worker], w, h, w * 4, 4);
-									} else outPixels[worker] = pixels[worker];
-
-									sprintf(prevSavePath, filename.c_str(), curFrame[worker]);
-									
-									if (ext == "jpg" || ext == "jpeg")
-										stbi_write_jpg(prevSavePath, w, h, 4, outPixels[worker], 100);
+
+								if (m_savePreviewVideo)
+									video.Write(pixels[buffer]); // does nothing if ffmpeg couldn't be started
+								else {
+									sprintf(prevSavePath, filename.c_str(), frame);
+
+									// the encoders already run in parallel, one thread per EXR
+									if (ext == "exr") {
+										std::vector<HDRImageWriter::Layer> layers;
+										for (int i = 0; i < readback.Layers.size(); i++)
+											layers.push_back({ readback.Layers[i].first, pixels[buffer] + i * layerSize });
+										HDRImageWriter::WriteEXR(prevSavePath, outW, outH, layers, (HDRImageWriter::PixelType)m_savePreviewExrType, (HDRImageWriter::Compression)m_savePreviewExrCompression, 1);
+									}
+									else if (readback.Type == GL_UNSIGNED_SHORT)
+										HDRImageWriter::WritePNG16(prevSavePath, outW, outH, (uint16_t*)pixels[buffer]);
+									else if (ext == "jpg" || ext == "jpeg")
+										stbi_write_jpg(prevSavePath, outW, outH, 4, pixels[buffer], 100);
 									else if (ext == "bmp")
-										stbi_write_bmp(prevSavePath, w, h, 4, outPixels[worker]);
+										stbi_write_bmp(prevSavePath, outW, outH, 4, pixels[buffer]);
 									else if (ext == "tga")
-										stbi_write_tga(prevSavePath, w, h, 4, outPixels[worker]);
+										stbi_write_tga(prevSavePath, outW, outH, 4, pixels[buffer]);
 									else
-										stbi_write_png(prevSavePath, w, h, 4, outPixels[worker], w * 4);
-								
-									needsUpdate[worker] = true;
+										stbi_write_png(prevSavePath, outW, outH, 4, pixels[buffer], outW * 4);
 								}
-							}, i, m_previewSaveSize.x, m_previewSaveSize.y);
-						}
 
-						int globalFrame = 0;
-						while (curTime < m_savePreviewSeqDuration) {
-							int hasWork = -1;
-							for (int i = 0; i < tCount; i++) 
-								if (needsUpdate[i]) {
-									hasWork = i;
-									break;
+								{
+									std::lock_guard<std::mutex> lock(bufferMutex);
+									freeBuffers.push_back(buffer);
 								}
+								bufferSignal.notify_one();
+							});
+						};
 
-							if (hasWork == -1)
-								continue;
+						int globalFrame = 0;
+						while (curTime < m_savePreviewSeqDuration) {
+							// the PBO we are about to reuse holds a frame from pboCount frames ago
+							int pbo = globalFrame % pboCount;
+							if (pboFrame[pbo] != -1)
+								encodeFrame(pbo);
 
 							SystemVariableManager::Instance().CopyState();
 							SystemVariableManager::Instance().SetFrameIndex(m_savePreviewFrameIndex + globalFrame);
 							
 							m_data->Renderer.Render(actualSizeX, actualSizeY);
 
-							glBindTexture(GL_TEXTURE_2D, tex);
-							glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels[hasWork]);
+							// EXR layers are stored one after another in the PBO
+							glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[pbo]);
+							for (int i = 0; i < readback.Layers.size(); i++) {
+								GLuint readTex = readback.Layers[i].second;
+								if (sizeMulti != 1)
+									readTex = ImageDownsampler::Instance().Downsample(readTex, glm::ivec2(actualSizeX, actualSizeY), sizeMulti, readback.Format);
+
+								glBindTexture(GL_TEXTURE_2D, readTex);
+								glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, readback.Type, (void*)(i * layerSize));
+							}
+							glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
 							glBindTexture(GL_TEXTURE_2D, 0);
 
+							fences[pbo] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+							pboFrame[pbo] = globalFrame;
+
 							SystemVariableManager::Instance().AdvanceTimer(seqDelta);
 
 							curTime += seqDelta;
-							curFrame[hasWork] = globalFrame;
-							needsUpdate[hasWork] = false;
 							globalFrame++;
 						}
-						isOver = true;
-						
-						for (int i = 0; i < tCount; i++) {
-							if (threadPool[i]->joinable())
-								threadPool[i]->join();
-							free(pixels[i]);
-							if (sizeMulti != 1)
-								free(outPixels[i]);
-							delete threadPool[i];
+
+						// frames that are still in flight (oldest first)
+						for (int i = 0; i < pboCount; i++) {
+							int pbo = (globalFrame + i) % pboCount;
+							if (pboFrame[pbo] != -1)
+								encodeFrame(pbo);
 						}
-						delete[] pixels;
-						delete[] outPixels;
-						delete[] curFrame;
-						delete[] needsUpdate;
-						delete[] threadPool;
+
+						// wait for the encoders to finish
+						{
+							std::unique_lock<std::mutex> lock(bufferMutex);
+							bufferSignal.wait(lock, [&]() { return freeBuffers.size() == bufferCount; });
+						}
+						video.Close();
+
+						glDeleteBuffers(pboCount, pbos);
+						for (int i = 0; i < bufferCount; i++)
+							free(pixels[i]);
 
 						stbi_write_png_compression_level = 8; // set back to default compression level
 					}
@@ -1641,7 +2240,7 @@ namespace ed
 		}
 
 		// Export as C++ app
-		ImGui::SetNextWindowSize(ImVec2(450 * Settings::Instance().DPIScale, 300 * Settings::Instance().DPIScale));
+		ImGui::SetNextWindowSize(ImVec2(450 * Settings::Instance().DPIScale, 350 * Settings::Instance().DPIScale));
 		if (ImGui::BeginPopupModal("Export as C++ project##main_export_as_cpp")) {
 			// output file
 			ImGui::TextWrapped("Output file: %s", m_expcppSavePath.c_str());
@@ -1679,6 +2278,16 @@ namespace ed
 			ImGui::SameLine();
 			ImGui::Checkbox("##expcpp_copy_images", &m_expcppCopyImages);
 
+			// cache the programs & don't upload the constant uniforms every frame
+			ImGui::Text("Optimize for performance: ");
+			ImGui::SameLine();
+			ImGui::Checkbox("##expcpp_optimized", &m_expcppOptimized);
+
+			// benchmark target that prints the GPU time of each pass
+			ImGui::Text("Generate benchmark target: ");
+			ImGui::SameLine();
+			ImGui::Checkbox("##expcpp_benchmark", &m_expcppBenchmark);
+
 			// backend
 			ImGui::Text("Backend: ");
 			ImGui::SameLine();
@@ -1694,7 +2303,7 @@ namespace ed
 
 			// export || cancel
 			if (ImGui::Button("Export")) {
-				m_expcppError = ExportCPP::Export(m_data, m_expcppSavePath, !m_expcppMemoryShaders, m_expcppCmakeFiles, m_expcppProjectName, m_expcppCmakeModules, m_expcppImage, m_expcppCopyImages);
+				m_expcppError = ExportCPP::Export(m_data, m_expcppSavePath, !m_expcppMemoryShaders, m_expcppCmakeFiles, m_expcppProjectName, m_expcppCmakeModules, m_expcppImage, m_expcppCopyImages, m_expcppOptimized, m_expcppBenchmark);
 				if (!m_expcppError)
 					ImGui::CloseCurrentPopup();
 			}
@@ -1741,6 +2350,21 @@ namespace ed
 				m_isUpdateNotificationOpened = false;
 		}
 
+		// progress of the objects that are being saved
+		if (ObjectExporter::Instance().IsBusy()) {
+			const float DISTANCE = 15.0f;
+			ImGuiIO& io = ImGui::GetIO();
+			float bottom = io.DisplaySize.y - DISTANCE - (m_isUpdateNotificationOpened ? ImGui::GetFrameHeightWithSpacing() * 2 : 0.0f);
+			ImGui::SetNextWindowPos(ImVec2(io.DisplaySize.x - DISTANCE, bottom), ImGuiCond_Always, ImVec2(1.0f, 1.0f));
+			if (ImGui::Begin("##exportNotification", nullptr, ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoSavedSettings | ImGuiWindowFlags_NoFocusOnAppearing | ImGuiWindowFlags_NoNav)) {
+				for (const auto& status : ObjectExporter::Instance().GetStatus()) {
+					ImGui::Text("Saving %s", status.Name.c_str());
+					ImGui::ProgressBar(status.Progress, ImVec2(200 * Settings::Instance().DPIScale, 0), status.Reading ? "Reading back" : nullptr);
+				}
+			}
+			ImGui::End();
+		}
+
 		// render ImGUI
 		ImGui::Render();
 	}
@@ -1825,10 +2449,14 @@ namespace ed
 	}
 	void GUIManager::Render()
 	{
+		ED_ZONE("GUIManager::Render");
+		ED_GPU_ZONE("UI");
+
 		ImDrawData *drawData = ImGui::GetDrawData();
 		if (drawData != NULL) {
-			// actually render to back buffer
-			ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+			// actually render to back buffer - the ImGui frame is still finished while the window can't be seen
+			if (m_windowVisible)
+				ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
 			// Update and Render additional Platform Windows
 			if (ImGui::GetIO().ConfigFlags & ImGuiConfigFlags_ViewportsEnable) {
@@ -1852,6 +2480,7 @@ namespace ed
 	void GUIManager::ResetWorkspace()
 	{
 		m_data->Renderer.FlushCache();
+		m_history->Clear();
 		((CodeEditorUI*)Get(ViewID::Code))->CloseAll();
 		((PinnedUI*)Get(ViewID::Pinned))->CloseAll();
 		((PreviewUI*)Get(ViewID::Preview))->Pick(nullptr);
@@ -1876,10 +2505,13 @@ namespace ed
 		std::ifstream data("data/gui.dat");
 
 		if (data.is_open()) {
+			// files saved before a view was added are shorter - the missing views keep their defaults
 			for (auto& view : m_views)
-				view->Visible = data.get();
+				if (data.peek() != EOF)
+					view->Visible = data.get();
 			for (auto& dview : m_debugViews)
-				dview->Visible = data.get();
+				if (data.peek() != EOF)
+					dview->Visible = data.get();
 
 			data.close();
 		}
@@ -1910,7 +2542,7 @@ namespace ed
 	bool GUIManager::SaveAsProject(bool restoreCached)
 	{
 		std::string file;
-		bool success = UIHelper::GetSaveFileDialog(file, "sprj");
+		bool success = UIHelper::GetSaveFileDialog(file, "sprj;" PROJECT_ARCHIVE_EXTENSION);
 
 		if (success) {
 			m_data->Parser.SaveAs(file, true);
@@ -1984,7 +2616,7 @@ namespace ed
 	}
 	void GUIManager::CreateNewTexture() {
 		std::string path;
-		bool success = UIHelper::GetOpenFileDialog(path, "png;jpg;jpeg;bmp");
+		bool success = UIHelper::GetOpenFileDialog(path, "png;jpg;jpeg;bmp;dds;ktx;ktx2");
 		
 		if (!success)
 			return;
@@ -2005,6 +2637,52 @@ namespace ed
 		if (!file.empty())
 			m_data->Objects.CreateAudio(file);
 	}
+	void GUIManager::CreateNewVirtualTexture() {
+		std::string path;
+		bool success = UIHelper::GetOpenFileDialog(path, "png;jpg;jpeg;bmp;tga;hdr");
+
+		if (!success)
+			return;
+
+		std::string file = m_data->Parser.GetRelativePath(path);
+		if (!file.empty())
+			m_data->Objects.CreateVirtualTexture(file);
+	}
+	void GUIManager::CreateNewEnvironment() {
+		std::string path;
+		bool success = UIHelper::GetOpenFileDialog(path, "hdr;exr");
+
+		if (!success)
+			return;
+
+		std::string file = m_data->Parser.GetRelativePath(path);
+		if (!file.empty())
+			m_data->Objects.CreateEnvironment(file);
+	}
+	void GUIManager::CreateNewImageSequence() {
+		std::string path;
+		bool success = UIHelper::GetOpenFileDialog(path, "png;jpg;jpeg;bmp;tga");
+
+		if (!success)
+			return;
+
+		// the chosen file is the first frame
+		std::string file = m_data->Parser.GetRelativePath(path);
+		if (!file.empty())
+			m_data->Objects.CreateImageSequence(file);
+	}
+	void GUIManager::CreateNewVideo() {
+		std::string path;
+		bool success = UIHelper::GetOpenFileDialog(path, "mp4;mkv;webm;mov;avi");
+
+		if (!success)
+			return;
+
+		std::string file = m_data->Parser.GetRelativePath(path);
+
+		if (!file.empty())
+			m_data->Objects.CreateVideo(file);
+	}
 
 	void GUIManager::m_setupShortcuts()
 	{
@@ -2019,6 +2697,14 @@ namespace ed
 		KeyboardShortcuts::Instance().SetCallback("Project.Save", [=]() {
 			this->Save();
 		});
+		KeyboardShortcuts::Instance().SetCallback("Project.Undo", [=]() {
+			if (!ImGui::GetIO().WantTextInput) // text fields have their own undo
+				m_history->Undo();
+		});
+		KeyboardShortcuts::Instance().SetCallback("Project.Redo", [=]() {
+			if (!ImGui::GetIO().WantTextInput)
+				m_history->Redo();
+		});
 		KeyboardShortcuts::Instance().SetCallback("Project.SaveAs", [=]() {
 			SaveAsProject(true);
 		});
@@ -2086,6 +2772,9 @@ namespace ed
 		KeyboardShortcuts::Instance().SetCallback("Preview.SaveImage", [=]() {
 			m_savePreviewPopupOpened = true;
 		});
+		KeyboardShortcuts::Instance().SetCallback("Preview.RenderDocCapture", [=]() {
+			RenderDocCapture::Instance().Request();
+		});
 
 		// WORKSPACE
 		KeyboardShortcuts::Instance().SetCallback("Workspace.PerformanceMode", [=]() {
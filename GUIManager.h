@@ -1,6 +1,8 @@
 #pragma once
 #include "Objects/KeyboardShortcuts.h"
 #include "Objects/UpdateChecker.h"
+#include "Objects/ProjectRecovery.h"
+#include "Objects/ProjectHistory.h"
 
 #include <SDL2/SDL_video.h>
 #include <SDL2/SDL_events.h>
@@ -29,6 +31,8 @@ namespace ed
 		Pipeline,
 		Properties,
 		PixelInspect,
+		Profiler,
+		Memory,
 		DebugWatch,
 		DebugValues,
 		DebugFunctionStack,
@@ -58,7 +62,13 @@ namespace ed
 		void CreateNewShaderPass();
 		void CreateNewTexture();
 		inline void CreateNewCubemap() { m_isCreateCubemapOpened = true; }
+		inline void CreateNewTextureArray() { m_isCreateTexArrayOpened = true; }
 		void CreateNewAudio();
+		void CreateNewVideo();
+		void CreateNewVirtualTexture();
+		void CreateNewEnvironment();
+		void CreateNewImageSequence();
+		inline void CreateNewCaptureDevice() { m_isCreateCaptureOpened = true; }
 		inline void CreateNewRenderTexture() { m_isCreateRTOpened = true; }
 		inline void CreateNewBuffer() { m_isCreateBufferOpened = true; }
 		inline void CreateNewImage() { m_isCreateImgOpened = true; }
@@ -69,6 +79,7 @@ namespace ed
 
 		inline bool IsPerformanceMode() { return m_performanceMode; }
 		inline void SetPerformanceMode(bool mode) { m_perfModeFake = mode; }
+		inline void SetWindowVisible(bool visible) { m_windowVisible = visible; } // false while minimized or hidden
 
 		void StopDebugging();
 
@@ -103,10 +114,19 @@ namespace ed
 
 		bool m_cacheProjectModified;
 
+		// recovery snapshots written by m_recovery - the unchanged files are handed over without a copy
+		float m_recoveryTimer;
+		std::string m_recoveryProject;
+		std::map<std::string, std::shared_ptr<const std::string>> m_recoveryFiles;
+		void m_saveRecoverySnapshot();
+
 		bool m_isCreateItemPopupOpened, m_isCreateRTOpened,
-			m_isCreateCubemapOpened, m_isNewProjectPopupOpened,
+			m_isCreateCubemapOpened, m_isCreateTexArrayOpened, m_isNewProjectPopupOpened,
 			m_isAboutOpen, m_isCreateBufferOpened, m_isCreateImgOpened,
-			m_isInfoOpened, m_isCreateImg3DOpened, m_isRecordCameraSnapshotOpened;
+			m_isInfoOpened, m_isCreateImg3DOpened, m_isRecordCameraSnapshotOpened, m_isCreateCaptureOpened,
+			m_isConnectRemoteOpened;
+
+		float m_traceSeconds; // length of the trace recordings
 
 		bool m_isUpdateNotificationOpened;
 		sf::Clock m_updateNotifyClock;
@@ -120,6 +140,11 @@ namespace ed
 		float m_savePreviewTime, m_savePreviewCachedTime, m_savePreviewTimeDelta;
 		int m_savePreviewFrameIndex, m_savePreviewCachedFIndex;
 		int m_savePreviewSupersample;
+		bool m_savePreviewTiled;
+		int m_savePreviewTileSize;
+		int m_savePreviewSource; // 0 -> window, i -> i-th render texture
+		bool m_savePreview16Bit, m_savePreviewExrLayers;
+		int m_savePreviewExrType, m_savePreviewExrCompression;
 		bool m_savePreviewWASD[4];
 		glm::vec4 m_savePreviewMouse;
 		std::string m_previewSavePath;
@@ -132,14 +157,19 @@ namespace ed
 		bool m_expcppImage;
 		bool m_expcppMemoryShaders;
 		bool m_expcppCopyImages;
+		bool m_expcppOptimized;
+		bool m_expcppBenchmark;
 		char m_expcppProjectName[64];
 		std::string m_expcppSavePath;
 		
 		bool m_savePreviewSeq;
 		float m_savePreviewSeqDuration;
 		int m_savePreviewSeqFPS;
+		bool m_savePreviewVideo;
+		int m_savePreviewVideoCodec, m_savePreviewVideoBitrate, m_savePreviewVideoFormat;
 
 		bool m_performanceMode, m_perfModeFake;
+		bool m_windowVisible;
 		sf::Clock m_perfModeClock;
 
 		std::string m_selectedTemplate;
@@ -150,6 +180,8 @@ namespace ed
 		CreateItemUI* m_createUI;
 
 		UpdateChecker m_updateCheck;
+		ProjectRecovery m_recovery;
+		ProjectHistory* m_history;
 
 		InterfaceManager* m_data;
 		SDL_Window* m_wnd;
@@ -0,0 +1,1197 @@
+#include "HeadlessRenderer.h"
+#include "InterfaceManager.h"
+#include "Objects/Logger.h"
+#include "Objects/Settings.h"
+#include "Objects/VideoEncoder.h"
+#include "Objects/MicroBenchmark.h"
+#include "Objects/StartupTimeline.h"
+#include "Objects/SystemVariableManager.h"
+#include "Objects/RemotePreview.h"
+
+#include <SDL2/SDL.h>
+#include <stb/stb_image_write.h>
+#include <ghc/filesystem.hpp>
+#include <pugixml/src/pugixml.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <fstream>
+#include <iomanip>
+#include <stdio.h>
+#include <string.h>
+
+namespace ed
+{
+	static bool isVideoExtension(const std::string& ext)
+	{
+		return ext == "mp4" || ext == "mkv" || ext == "mov" || ext == "avi" || ext == "webm";
+	}
+	static std::string getExtension(const std::string& path)
+	{
+		size_t lastDot = path.find_last_of('.');
+		return lastDot == std::string::npos ? "" : path.substr(lastDot + 1);
+	}
+
+	// free video memory in KB, -1 if the driver doesn't expose it
+	static int getFreeVRAM()
+	{
+		GLint mem[4] = { -1, -1, -1, -1 };
+		if (GLEW_NVX_gpu_memory_info)
+			glGetIntegerv(GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, mem);
+		else if (GLEW_ATI_meminfo)
+			glGetIntegerv(GL_TEXTURE_FREE_MEMORY_ATI, mem);
+		return mem[0];
+	}
+	static std::string escapeJSON(const std::string& str)
+	{
+		std::string ret;
+		for (char c : str) {
+			if (c == '"' || c == '\\')
+				ret += '\\';
+			if ((unsigned char)c >= 0x20)
+				ret += c;
+		}
+		return ret;
+	}
+
+	// the remote render server runs until Ctrl+C
+	static std::atomic<bool> stopServing(false);
+	static void stopServingHandler(int)
+	{
+		stopServing = true;
+	}
+
+	// only the shaders that the project uses can be overwritten by the client
+	static bool isProjectShader(InterfaceManager* data, const std::string& path)
+	{
+		for (PipelineItem* item : data->Pipeline.GetList()) {
+			if (item->Type == PipelineItem::ItemType::ShaderPass) {
+				pipe::ShaderPass* pass = (pipe::ShaderPass*)item->Data;
+				if (path == pass->VSPath || path == pass->PSPath || (pass->GSUsed && path == pass->GSPath))
+					return true;
+				if (pass->MSUsed && (path == pass->MSPath || (pass->TSUsed && path == pass->TSPath)))
+					return true;
+			}
+			else if (item->Type == PipelineItem::ItemType::ComputePass) {
+				if (path == ((pipe::ComputePass*)item->Data)->Path)
+					return true;
+			}
+			else if (item->Type == PipelineItem::ItemType::AudioPass) {
+				if (path == ((pipe::AudioPass*)item->Data)->Path)
+					return true;
+			}
+		}
+		return false;
+	}
+
+	HeadlessRenderer::HeadlessRenderer()
+	{
+		m_output = "frame%d.png";
+		m_frames = 1;
+		m_fps = 60;
+		m_frameStart = 0;
+		m_frameEnd = -1;
+		m_sliceIndex = 0;
+		m_sliceCount = 1;
+		m_warmup = 0;
+		m_converge = false;
+		m_startTime = 0.0f;
+		m_startFrameIndex = 0;
+		m_size = glm::ivec2(1920, 1080);
+		m_freeVRAM = -1;
+		m_wnd = nullptr;
+		m_glContext = nullptr;
+		m_microbench = false;
+		m_serving = false;
+		m_port = REMOTE_DEFAULT_PORT;
+		m_validateStrict = false;
+	}
+	bool HeadlessRenderer::IsRequested(int argc, char* argv[])
+	{
+		for (int i = 1; i < argc; i++)
+			if (strcmp(argv[i], "--render") == 0 || strcmp(argv[i], "--stitch") == 0 || strcmp(argv[i], "--microbench") == 0 || strcmp(argv[i], "--serve") == 0 || strcmp(argv[i], "--validate") == 0)
+				return true;
+		return false;
+	}
+	bool HeadlessRenderer::ParseArguments(int argc, char* argv[], const std::string& cmdDir)
+	{
+		bool hasStart = false, hasFrames = false;
+
+		for (int i = 1; i < argc; i++) {
+			std::string arg = argv[i];
+			bool hasValue = i + 1 < argc;
+
+			if (arg == "--render" && hasValue)
+				m_project = argv[++i];
+			else if (arg == "--serve" && hasValue) {
+				m_project = argv[++i];
+				m_serving = true;
+			}
+			else if (arg == "--port" && hasValue) {
+				m_port = atoi(argv[++i]);
+				if (m_port <= 0 || m_port > 65535) {
+					Logger::Get().Log("Invalid --port argument", true);
+					return false;
+				}
+			}
+			else if (arg == "--bind" && hasValue)
+				m_bindAddress = argv[++i];
+			else if (arg == "--token" && hasValue)
+				m_token = argv[++i];
+			else if (arg == "--out" && hasValue)
+				m_output = argv[++i];
+			else if (arg == "--manifest" && hasValue)
+				m_manifest = argv[++i];
+			else if (arg == "--benchmark" && hasValue)
+				m_benchmark = argv[++i];
+			else if (arg == "--frames" && hasValue) {
+				m_frames = std::max(1, atoi(argv[++i]));
+				hasFrames = true;
+			}
+			else if (arg == "--replay" && hasValue)
+				m_replayPath = argv[++i];
+			else if (arg == "--fps" && hasValue)
+				m_fps = std::max(1, atoi(argv[++i]));
+			else if (arg == "--frame-start" && hasValue) {
+				m_frameStart = std::max(0, atoi(argv[++i]));
+				hasStart = true;
+			}
+			else if (arg == "--frame-end" && hasValue)
+				m_frameEnd = atoi(argv[++i]);
+			else if (arg == "--warmup" && hasValue)
+				m_warmup = std::max(0, atoi(argv[++i]));
+			else if (arg == "--converge")
+				m_converge = true;
+			else if (arg == "--time" && hasValue)
+				m_startTime = atof(argv[++i]);
+			else if (arg == "--frame-index" && hasValue)
+				m_startFrameIndex = atoi(argv[++i]);
+			else if (arg == "--slice" && hasValue) {
+				if (sscanf(argv[++i], "%d/%d", &m_sliceIndex, &m_sliceCount) != 2 || m_sliceCount <= 0 || m_sliceIndex < 0 || m_sliceIndex >= m_sliceCount) {
+					Logger::Get().Log("Invalid --slice argument, expected INDEX/COUNT", true);
+					return false;
+				}
+			}
+			else if (arg == "--size" && hasValue) {
+				if (sscanf(argv[++i], "%dx%d", &m_size.x, &m_size.y) != 2 || m_size.x <= 0 || m_size.y <= 0) {
+					Logger::Get().Log("Invalid --size argument, expected WIDTHxHEIGHT", true);
+					return false;
+				}
+			}
+			else if (arg == "--microbench") {
+				m_microbench = true;
+				if (hasValue && strncmp(argv[i + 1], "--", 2) != 0)
+					m_microbenchFilter = argv[++i];
+			}
+			else if (arg == "--microbench-out" && hasValue)
+				m_microbenchOut = argv[++i];
+			else if (arg == "--validate" && hasValue) {
+				while (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0)
+					m_validatePaths.push_back(argv[++i]);
+			}
+			else if (arg == "--report" && hasValue)
+				m_validateReport = argv[++i];
+			else if (arg == "--strict")
+				m_validateStrict = true;
+			else if (arg == "--stitch" && hasValue) {
+				m_stitchOutput = argv[++i];
+
+				// everything after the output file is a manifest
+				while (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0)
+					m_stitchManifests.push_back(argv[++i]);
+			}
+			else {
+				Logger::Get().Log("Unknown or incomplete command line argument " + arg, true);
+				return false;
+			}
+		}
+
+		// paths are relative to the directory SHADERed was started from, not the working directory
+		auto makeAbsolute = [&](std::string& path) {
+			if (!path.empty() && ghc::filesystem::path(path).is_relative())
+				path = (ghc::filesystem::path(cmdDir) / path).generic_string();
+		};
+
+		if (m_microbench) {
+			makeAbsolute(m_microbenchOut);
+			return true;
+		}
+
+		if (!m_validatePaths.empty()) {
+			for (auto& path : m_validatePaths)
+				makeAbsolute(path);
+			makeAbsolute(m_validateReport);
+			return true;
+		}
+
+		if (!m_stitchOutput.empty()) {
+			if (m_stitchManifests.empty()) {
+				Logger::Get().Log("No manifests given to --stitch", true);
+				return false;
+			}
+
+			makeAbsolute(m_stitchOutput);
+			for (auto& manifest : m_stitchManifests)
+				makeAbsolute(manifest);
+
+			return true;
+		}
+
+		if (m_project.empty()) {
+			Logger::Get().Log("No project given to --render", true);
+			return false;
+		}
+
+		if (m_serving) {
+			makeAbsolute(m_project);
+			return true;
+		}
+
+		// the whole recording unless the frame count is given
+		if (!m_replayPath.empty()) {
+			makeAbsolute(m_replayPath);
+			if (!m_replay.Load(m_replayPath))
+				return false;
+			if (!hasFrames)
+				m_frames = m_replay.GetFrameCount();
+		}
+
+		// frame range: --frame-start/--frame-end > --slice > --frames
+		if (m_frameEnd < 0 && !hasStart && m_sliceCount > 1) {
+			int perSlice = (m_frames + m_sliceCount - 1) / m_sliceCount;
+			m_frameStart = m_sliceIndex * perSlice;
+			m_frameEnd = std::min(m_frames, m_frameStart + perSlice) - 1;
+		}
+		else if (m_frameEnd < 0)
+			m_frameEnd = m_frameStart + m_frames - 1;
+
+		if (m_frameEnd < m_frameStart) {
+			Logger::Get().Log("The frame range is empty", true);
+			return false;
+		}
+
+		makeAbsolute(m_project);
+		makeAbsolute(m_output);
+		makeAbsolute(m_manifest);
+		makeAbsolute(m_benchmark);
+
+		return true;
+	}
+	int HeadlessRenderer::Run()
+	{
+		if (m_microbench)
+			return m_runMicroBenchmarks();
+		if (!m_stitchOutput.empty())
+			return m_stitch();
+		if (m_serving)
+			return m_serve();
+		if (!m_validatePaths.empty())
+			return m_validate();
+
+		return m_render();
+	}
+	bool HeadlessRenderer::m_createContext()
+	{
+		// use the offscreen video driver when there is no display
+		if (SDL_Init(SDL_INIT_TIMER) < 0 || (SDL_VideoInit(NULL) < 0 && SDL_VideoInit("offscreen") < 0)) {
+			Logger::Get().Log("Failed to initialize SDL2 video: " + std::string(SDL_GetError()), true);
+			return false;
+		}
+
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+
+		m_wnd = SDL_CreateWindow("SHADERed", 0, 0, 1, 1, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+		m_glContext = m_wnd == nullptr ? nullptr : SDL_GL_CreateContext(m_wnd);
+		if (m_glContext == nullptr) {
+			Logger::Get().Log("Failed to create an OpenGL context: " + std::string(SDL_GetError()), true);
+			m_destroyContext();
+			return false;
+		}
+		SDL_GL_MakeCurrent(m_wnd, m_glContext);
+		glEnable(GL_DEPTH_TEST);
+		glEnable(GL_STENCIL_TEST);
+
+		glewExperimental = true;
+		if (glewInit() != GLEW_OK) {
+			Logger::Get().Log("Failed to initialize GLEW", true);
+			m_destroyContext();
+			return false;
+		}
+
+		return true;
+	}
+	void HeadlessRenderer::m_destroyContext()
+	{
+		if (m_glContext != nullptr)
+			SDL_GL_DeleteContext(m_glContext);
+		if (m_wnd != nullptr)
+			SDL_DestroyWindow(m_wnd);
+		m_glContext = nullptr;
+		m_wnd = nullptr;
+
+		SDL_Quit();
+	}
+	int HeadlessRenderer::m_render()
+	{
+		StartupTimeline& startup = StartupTimeline::Instance();
+
+		if (!m_createContext())
+			return 1;
+		startup.Mark("OpenGL context");
+
+		Settings::Instance().Load();
+		Settings::Instance().Preview.SkipIdleFrames = false; // every frame has to go through the GPU
+		startup.Mark("Settings");
+
+		m_freeVRAM = getFreeVRAM();
+
+		int ret = 0;
+		int rendered = 0;
+		std::vector<std::string> files;
+
+		InterfaceManager* data = new InterfaceManager(nullptr); // plugins need the GUI so they are not loaded
+		data->Renderer.AllowComputeShaders(GLEW_ARB_compute_shader);
+		data->Parser.Open(m_project);
+		startup.Mark("Project");
+
+		if (data->Parser.GetOpenedFile().empty()) {
+			Logger::Get().Log("Failed to open " + m_project, true);
+			ret = 1;
+		}
+		else {
+			SystemVariableManager& systemVM = SystemVariableManager::Instance();
+			float delta = 1.0f / m_fps;
+
+			// first render caches the pipeline and starts compiling the shaders
+			auto compileStart = std::chrono::high_resolution_clock::now();
+			data->Renderer.Render(m_size.x, m_size.y);
+			data->Renderer.WaitForCompilation();
+			float compileTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - compileStart).count();
+
+			startup.Mark("Shader compilation");
+
+			// textures were decoded while the shaders compiled
+			data->Objects.WaitForLoading();
+			startup.Mark("Textures");
+			startup.Finish();
+
+			for (const auto& msg : data->Messages.GetMessages())
+				if (msg.MType == MessageStack::Type::Error) {
+					printf("%s: %s\n", msg.Group.c_str(), msg.Text.c_str());
+					ret = 2;
+				}
+
+			systemVM.GetTimeClock().Pause();
+			systemVM.SetTimeDelta(delta);
+
+			if (!m_benchmark.empty()) {
+				// a benchmark of a broken project is meaningless
+				if (ret == 0)
+					ret = m_runBenchmark(data, compileTime);
+			} else {
+				std::string ext = getExtension(m_output);
+				bool isVideo = isVideoExtension(ext);
+
+				// every slice of a video is its own file - %d is replaced with the first frame
+				std::string filename = m_output;
+				if (!isVideo && filename.find('%') == std::string::npos && m_frameEnd > m_frameStart) {
+					size_t lastDot = filename.find_last_of('.');
+					filename.insert(lastDot == std::string::npos ? filename.size() : lastDot, "%d");
+				}
+
+				char framePath[MAX_PATH];
+				VideoEncoder video;
+				if (isVideo) {
+					snprintf(framePath, MAX_PATH, filename.c_str(), m_frameStart);
+					files.push_back(framePath);
+
+					if (!video.Open(framePath, m_size.x, m_size.y, m_fps, ext == "webm" ? "libvpx-vp9" : "libx264", 0, "yuv420p"))
+						ret = 1;
+				}
+
+				unsigned char* pixels = (unsigned char*)malloc(m_size.x * m_size.y * 4);
+
+				// frames before the range are only rendered to rebuild the state that depends on previous frames (feedback rts, ...)
+				int firstFrame = std::max(0, m_frameStart - m_warmup);
+				for (int f = firstFrame; f <= m_frameEnd && ret != 1; f++) {
+					m_applyFrame(data, f, delta);
+
+					data->Objects.Update(delta);
+					data->Renderer.Render(m_size.x, m_size.y);
+
+					if (f < m_frameStart)
+						continue;
+
+					// same time & input, the accumulating passes only get a new SampleIndex
+					if (m_converge) {
+						Accumulator& accumulator = data->Renderer.GetAccumulator();
+						unsigned int samples = 0, target = 0;
+						bool accumulating = accumulator.GetProgress(samples, target);
+						if (accumulating && target == 0 && f == m_frameStart)
+							Logger::Get().Log("An accumulating pass doesn't have a sample count, --converge can't wait for it", true);
+
+						while (accumulating && target != 0 && !accumulator.IsConverged()) {
+							data->Renderer.Render(m_size.x, m_size.y);
+							accumulating = accumulator.GetProgress(samples, target);
+						}
+					}
+
+					glBindTexture(GL_TEXTURE_2D, data->Renderer.GetTexture());
+					glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+					glBindTexture(GL_TEXTURE_2D, 0);
+
+					if (isVideo) {
+						if (!video.Write(pixels))
+							ret = 1;
+					}
+					else {
+						snprintf(framePath, MAX_PATH, filename.c_str(), f);
+
+						int written = 0;
+						if (ext == "jpg" || ext == "jpeg")
+							written = stbi_write_jpg(framePath, m_size.x, m_size.y, 4, pixels, 100);
+						else if (ext == "bmp")
+							written = stbi_write_bmp(framePath, m_size.x, m_size.y, 4, pixels);
+						else if (ext == "tga")
+							written = stbi_write_tga(framePath, m_size.x, m_size.y, 4, pixels);
+						else
+							written = stbi_write_png(framePath, m_size.x, m_size.y, 4, pixels, m_size.x * 4);
+
+						if (written)
+							files.push_back(framePath);
+						else {
+							Logger::Get().Log("Failed to write " + std::string(framePath), true);
+							ret = 1;
+						}
+					}
+
+					if (ret != 1)
+						rendered++;
+				}
+
+				if (isVideo && !video.Close() && ret == 0)
+					ret = 1;
+
+				free(pixels);
+			}
+		}
+
+		delete data;
+
+		m_destroyContext();
+
+		if (!m_manifest.empty() && !m_writeManifest(files, rendered, ret != 1) && ret == 0)
+			ret = 1;
+
+		return ret;
+	}
+	int HeadlessRenderer::m_runBenchmark(InterfaceManager* data, float compileTime)
+	{
+		StartupTimeline& startup = StartupTimeline::Instance();
+
+		struct Timings
+		{
+			float Min, Average, Median, P95, Max;
+		};
+		auto summarize = [](std::vector<float> samples) -> Timings {
+			Timings ret = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+			if (samples.empty())
+				return ret;
+
+			std::sort(samples.begin(), samples.end());
+			float sum = 0.0f;
+			for (float s : samples)
+				sum += s;
+
+			ret.Min = samples.front();
+			ret.Max = samples.back();
+			ret.Average = sum / samples.size();
+			ret.Median = samples[samples.size() / 2];
+			ret.P95 = samples[std::min<size_t>(samples.size() - 1, samples.size() * 95 / 100)];
+			return ret;
+		};
+
+		SystemVariableManager& systemVM = SystemVariableManager::Instance();
+		GPUProfiler& profiler = data->Renderer.GetProfiler();
+		float delta = 1.0f / m_fps;
+
+		int measured = m_frameEnd - m_frameStart + 1;
+		std::vector<float> cpuTimes(measured), gpuTimes(measured);
+		std::vector<GLuint> queries(measured);
+		glGenQueries(measured, queries.data());
+
+		int minFreeVRAM = m_freeVRAM;
+		profiler.SetEnabled(true);
+
+		// unlike the image sequence, the warmup frames come before the measured ones
+		int measureStart = m_frameStart + m_warmup;
+		for (int f = m_frameStart; f < measureStart + measured; f++) {
+			m_applyFrame(data, f, delta);
+
+			// warmup frames shouldn't end up in the per pass stats
+			if (f == measureStart)
+				profiler.ResetStats();
+
+			int index = f - measureStart;
+			auto frameStart = std::chrono::high_resolution_clock::now();
+			if (index >= 0)
+				glBeginQuery(GL_TIME_ELAPSED, queries[index]);
+
+			data->Objects.Update(delta);
+			data->Renderer.Render(m_size.x, m_size.y);
+
+			if (index >= 0) {
+				glEndQuery(GL_TIME_ELAPSED);
+				cpuTimes[index] = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - frameStart).count();
+			}
+
+			int freeVRAM = getFreeVRAM();
+			if (freeVRAM >= 0 && freeVRAM < minFreeVRAM)
+				minFreeVRAM = freeVRAM;
+		}
+
+		// the queries are only read once everything has finished so that the measured frames never stall
+		glFinish();
+		for (int i = 0; i < measured; i++) {
+			GLuint64 elapsed = 0;
+			glGetQueryObjectui64v(queries[i], GL_QUERY_RESULT, &elapsed);
+			gpuTimes[i] = elapsed / 1000000.0f;
+		}
+		glDeleteQueries(measured, queries.data());
+		profiler.BeginFrame(); // collect the results of the last frame
+
+		Timings cpu = summarize(cpuTimes);
+		Timings gpu = summarize(gpuTimes);
+
+		const RenderTargetPool::Stats& rtStats = data->Renderer.GetRenderTargetStats();
+		float rtMemory = (rtStats.Dedicated + rtStats.Allocated) / (1024.0f * 1024.0f);
+		float peakVRAM = m_freeVRAM < 0 ? -1.0f : (m_freeVRAM - minFreeVRAM) / 1024.0f;
+
+		// passes and the items inside of them
+		std::vector<std::pair<PipelineItem*, PipelineItem*>> items; // (item, owner)
+		for (PipelineItem* pass : data->Pipeline.GetList()) {
+			items.push_back(std::make_pair(pass, nullptr));
+
+			std::vector<PipelineItem*>* children = nullptr;
+			if (pass->Type == PipelineItem::ItemType::ShaderPass)
+				children = &((pipe::ShaderPass*)pass->Data)->Items;
+			else if (pass->Type == PipelineItem::ItemType::PluginItem)
+				children = &((pipe::PluginItemData*)pass->Data)->Items;
+
+			if (children != nullptr)
+				for (PipelineItem* child : *children)
+					if (child->Type != PipelineItem::ItemType::RenderState)
+						items.push_back(std::make_pair(child, pass));
+		}
+
+		std::string ext = getExtension(m_benchmark);
+		std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+
+		std::ofstream report(m_benchmark);
+		if (!report.is_open()) {
+			Logger::Get().Log("Failed to write the benchmark report " + m_benchmark, true);
+			return 1;
+		}
+		report << std::fixed << std::setprecision(4); // never in scientific notation
+
+		if (ext == "csv") {
+			report << "metric,name,min,average,median,p95,max" << std::endl;
+
+			auto writeTimings = [&](const char* metric, const std::string& name, const Timings& t) {
+				report << metric << ",\"" << name << "\"," << t.Min << "," << t.Average << "," << t.Median << "," << t.P95 << "," << t.Max << std::endl;
+			};
+			writeTimings("cpu_frame_ms", "", cpu);
+			writeTimings("gpu_frame_ms", "", gpu);
+			for (const auto& item : items)
+				if (profiler.Has(item.first)) {
+					const GPUProfiler::Stats& stats = profiler.Get(item.first);
+					std::string name = item.second == nullptr ? item.first->Name : std::string(item.second->Name) + "/" + item.first->Name;
+					report << "pass_gpu_ms,\"" << name << "\"," << stats.Min << "," << stats.Average << ",," << "," << stats.Max << std::endl;
+				}
+			report << "compile_ms,,," << compileTime << ",,," << std::endl;
+			report << "startup_ms,,," << startup.GetTotal() << ",,," << std::endl;
+			for (const auto& phase : startup.GetPhases())
+				report << "startup_phase_ms,\"" << phase.Name << "\",," << phase.Duration << ",,," << std::endl;
+			report << "vram_peak_mb,,," << peakVRAM << ",,," << std::endl;
+			report << "render_texture_mb,,," << rtMemory << ",,," << std::endl;
+		} else {
+			auto writeTimings = [&](const Timings& t) {
+				report << "{ \"min\": " << t.Min << ", \"average\": " << t.Average << ", \"median\": " << t.Median << ", \"p95\": " << t.P95 << ", \"max\": " << t.Max << " }";
+			};
+
+			report << "{" << std::endl;
+			report << "\t\"project\": \"" << escapeJSON(m_project) << "\"," << std::endl;
+			report << "\t\"renderer\": \"" << escapeJSON((const char*)glGetString(GL_RENDERER)) << "\"," << std::endl;
+			report << "\t\"vendor\": \"" << escapeJSON((const char*)glGetString(GL_VENDOR)) << "\"," << std::endl;
+			report << "\t\"version\": \"" << escapeJSON((const char*)glGetString(GL_VERSION)) << "\"," << std::endl;
+			report << "\t\"width\": " << m_size.x << "," << std::endl;
+			report << "\t\"height\": " << m_size.y << "," << std::endl;
+			report << "\t\"warmup_frames\": " << m_warmup << "," << std::endl;
+			report << "\t\"measured_frames\": " << measured << "," << std::endl;
+			report << "\t\"compile_ms\": " << compileTime << "," << std::endl;
+			report << "\t\"startup_ms\": " << startup.GetTotal() << "," << std::endl;
+			report << "\t\"startup\": [";
+			for (size_t i = 0; i < startup.GetPhases().size(); i++) {
+				const StartupTimeline::Phase& phase = startup.GetPhases()[i];
+				report << (i == 0 ? "" : ",") << std::endl;
+				report << "\t\t{ \"name\": \"" << escapeJSON(phase.Name) << "\", \"start\": " << phase.Start << ", \"duration\": " << phase.Duration << " }";
+			}
+			report << std::endl << "\t]," << std::endl;
+			report << "\t\"cpu_frame_ms\": ";
+			writeTimings(cpu);
+			report << "," << std::endl;
+			report << "\t\"gpu_frame_ms\": ";
+			writeTimings(gpu);
+			report << "," << std::endl;
+			report << "\t\"passes\": [";
+			bool first = true;
+			for (const auto& item : items) {
+				if (!profiler.Has(item.first))
+					continue;
+
+				const GPUProfiler::Stats& stats = profiler.Get(item.first);
+				report << (first ? "" : ",") << std::endl;
+				report << "\t\t{ \"name\": \"" << escapeJSON(item.first->Name) << "\", ";
+				if (item.second != nullptr)
+					report << "\"pass\": \"" << escapeJSON(item.second->Name) << "\", ";
+				report << "\"min\": " << stats.Min << ", \"average\": " << stats.Average << ", \"max\": " << stats.Max << " }";
+				first = false;
+			}
+			report << std::endl << "\t]," << std::endl;
+			report << "\t\"vram_peak_mb\": " << peakVRAM << "," << std::endl;
+			report << "\t\"render_texture_mb\": " << rtMemory << std::endl;
+			report << "}" << std::endl;
+		}
+
+		printf("CPU frame time: %.3f ms (min %.3f, max %.3f)\n", cpu.Average, cpu.Min, cpu.Max);
+		printf("GPU frame time: %.3f ms (min %.3f, max %.3f)\n", gpu.Average, gpu.Min, gpu.Max);
+		printf("Compile time: %.1f ms\n", compileTime);
+
+		return 0;
+	}
+	void HeadlessRenderer::m_applyFrame(InterfaceManager* data, int frame, float delta)
+	{
+		SystemVariableManager& systemVM = SystemVariableManager::Instance();
+		systemVM.CopyState();
+
+		// the recorded frame sets the time, the frame index and the input
+		if (m_replay.GetFrameCount() > 0) {
+			m_replay.Apply(frame, &data->Renderer, &data->Pipeline, &data->Objects);
+			return;
+		}
+
+		// time & frame index only depend on the frame number so every slice matches a single long render
+		systemVM.SetFrameIndex(m_startFrameIndex + frame);
+		systemVM.AdvanceTimer((m_startTime + frame * delta) - systemVM.GetTime());
+	}
+	int HeadlessRenderer::m_runMicroBenchmarks()
+	{
+		// ProjectParser & ShaderVariableContainer need a context
+		if (!m_createContext())
+			return 1;
+
+		Settings::Instance().Load();
+
+		InterfaceManager* data = new InterfaceManager(nullptr);
+
+		MicroBenchmark bench(data);
+		bench.Run(m_microbenchFilter);
+
+		int ret = 0;
+		if (!m_microbenchOut.empty() && !bench.Save(m_microbenchOut))
+			ret = 1;
+
+		delete data;
+
+		m_destroyContext();
+
+		return ret;
+	}
+	int HeadlessRenderer::m_serve()
+	{
+		if (!m_createContext())
+			return 1;
+
+		Settings::Instance().Load();
+		Settings::Instance().Preview.SkipIdleFrames = false;
+
+		InterfaceManager* data = new InterfaceManager(nullptr);
+		data->Renderer.AllowComputeShaders(GLEW_ARB_compute_shader);
+		data->Parser.Open(m_project);
+
+		RemoteServer server;
+		if (data->Parser.GetOpenedFile().empty() || !server.Start(m_port, m_bindAddress, m_token)) {
+			if (data->Parser.GetOpenedFile().empty())
+				Logger::Get().Log("Failed to open " + m_project, true);
+			delete data;
+			m_destroyContext();
+			return 1;
+		}
+
+		signal(SIGINT, stopServingHandler);
+		signal(SIGTERM, stopServingHandler);
+
+		SystemVariableManager& systemVM = SystemVariableManager::Instance();
+		glm::ivec2 size = m_size; // until the client sends its viewport size
+
+		// the frames are sent with 16 bit sizes
+		GLint maxSize = 0;
+		glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+		maxSize = std::min<GLint>(maxSize, 65535);
+		bool paused = false, dirty = false;
+		unsigned int frameIndex = 0;
+
+		// the frames are read back through a PBO so that the render loop never waits for the GPU
+		GLuint pbo = 0;
+		GLsync fence = nullptr;
+		glm::ivec2 readSize(0, 0);
+		glGenBuffers(1, &pbo);
+
+		auto frameDuration = std::chrono::microseconds(1000000 / m_fps);
+		auto lastFrame = std::chrono::steady_clock::now();
+		while (!stopServing) {
+			auto frameStart = std::chrono::steady_clock::now();
+			float delta = std::chrono::duration<float>(frameStart - lastFrame).count();
+			lastFrame = frameStart;
+
+			if (!server.IsConnected()) {
+				SDL_Delay(50);
+				continue;
+			}
+
+			bool changed = false;
+
+			remote::InputState input;
+			if (server.GetInput(input)) {
+				if (input.Viewport.x > 0 && input.Viewport.y > 0)
+					size = glm::min(input.Viewport, glm::ivec2(maxSize));
+				systemVM.SetViewportSize(size.x, size.y);
+				systemVM.SetMousePosition(input.MousePosition.x, input.MousePosition.y);
+				systemVM.SetMouse(input.Mouse.x, input.Mouse.y, input.Mouse.z, input.Mouse.w);
+				systemVM.SetMouseButton(input.MouseButton.x, input.MouseButton.y, input.MouseButton.z, input.MouseButton.w);
+				systemVM.SetKeysWASD(input.WASD.x, input.WASD.y, input.WASD.z, input.WASD.w);
+
+				Settings::Instance().Project.FPCamera = input.FPCamera;
+				if (input.FPCamera) {
+					FirstPersonCamera* cam = (FirstPersonCamera*)systemVM.GetCamera();
+					cam->SetPosition(input.CameraPosition.x, input.CameraPosition.y, input.CameraPosition.z);
+					cam->SetYaw(input.CameraRotation.x);
+					cam->SetPitch(input.CameraRotation.y);
+				} else {
+					ArcBallCamera* cam = (ArcBallCamera*)systemVM.GetCamera();
+					cam->SetDistance(input.CameraPosition.x);
+					cam->SetPitch(input.CameraRotation.x);
+					cam->SetYaw(input.CameraRotation.y);
+					cam->SetRoll(input.CameraRotation.z);
+				}
+
+				if (input.Paused != paused) {
+					paused = input.Paused;
+					data->Renderer.Pause(paused);
+				}
+				changed = true;
+			}
+
+			for (const auto& edit : server.GetEdits()) {
+				if (!isProjectShader(data, edit.Path)) {
+					Logger::Get().Log("Ignored an edit of " + edit.Path + ", the project doesn't use it", true);
+					continue;
+				}
+
+				data->Parser.SaveProjectFile(edit.Path, edit.Source);
+				data->Renderer.RecompileFile(edit.Path.c_str());
+				changed = true;
+			}
+
+			// a paused client still sees the results of its edits
+			if (!paused || changed) {
+				systemVM.CopyState();
+				systemVM.SetFrameIndex(frameIndex++);
+				systemVM.SetTimeDelta(delta);
+
+				data->Objects.Update(delta);
+				data->Renderer.Render(size.x, size.y);
+				dirty = true;
+			}
+
+			if (fence != nullptr && glClientWaitSync(fence, 0, 0) != GL_TIMEOUT_EXPIRED) {
+				glDeleteSync(fence);
+				fence = nullptr;
+
+				glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+				unsigned char* pixels = (unsigned char*)glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+				if (pixels != nullptr) {
+					server.SendFrame(pixels, readSize.x, readSize.y);
+					glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+				}
+				glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+			}
+			else if (fence == nullptr && dirty && server.CanSendFrame()) {
+				dirty = false;
+
+				glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+				if (readSize != size) {
+					readSize = size;
+					glBufferData(GL_PIXEL_PACK_BUFFER, readSize.x * readSize.y * 4, nullptr, GL_STREAM_READ);
+				}
+
+				glBindTexture(GL_TEXTURE_2D, data->Renderer.GetTexture());
+				glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+				glBindTexture(GL_TEXTURE_2D, 0);
+				glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+				fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			}
+
+			auto elapsed = std::chrono::steady_clock::now() - frameStart;
+			if (elapsed < frameDuration)
+				SDL_Delay(std::chrono::duration_cast<std::chrono::milliseconds>(frameDuration - elapsed).count());
+		}
+
+		Logger::Get().Log("Stopping the remote render server");
+
+		server.Stop();
+
+		if (fence != nullptr)
+			glDeleteSync(fence);
+		glDeleteBuffers(1, &pbo);
+
+		delete data;
+
+		m_destroyContext();
+
+		return 0;
+	}
+	int HeadlessRenderer::m_validate()
+	{
+		// directories are searched for projects
+		std::vector<std::string> projects;
+		for (const std::string& path : m_validatePaths) {
+			std::error_code ec;
+			if (ghc::filesystem::is_directory(path, ec)) {
+				for (const auto& entry : ghc::filesystem::recursive_directory_iterator(path, ec))
+					if (entry.is_regular_file() && entry.path().extension() == ".sprj")
+						projects.push_back(entry.path().generic_string());
+			} else
+				projects.push_back(path);
+		}
+		std::sort(projects.begin(), projects.end());
+
+		if (projects.empty()) {
+			Logger::Get().Log("No projects were found to --validate", true);
+			return 1;
+		}
+
+		if (!m_createContext())
+			return 1;
+
+		Settings::Instance().Load();
+		Settings::Instance().Preview.SkipIdleFrames = false;
+
+		std::vector<Validation> results;
+		int errors = 0, warnings = 0;
+		for (const std::string& project : projects) {
+			auto start = std::chrono::steady_clock::now();
+
+			Validation result;
+			result.Project = project;
+
+			InterfaceManager* data = new InterfaceManager(nullptr);
+			data->Renderer.AllowComputeShaders(GLEW_ARB_compute_shader);
+			data->Parser.Open(project);
+			result.Opened = !data->Parser.GetOpenedFile().empty();
+
+			if (result.Opened) {
+				// the first frame caches the pipeline - the passes are transcompiled on the workers and linked on the driver's threads
+				data->Renderer.Render(64, 64);
+				data->Renderer.WaitForCompilation();
+
+				for (PipelineItem* item : data->Pipeline.GetList())
+					result.Passes.push_back(item->Name);
+				for (const auto& msg : data->Messages.GetMessages())
+					if (msg.MType != MessageStack::Type::Message)
+						result.Messages.push_back(msg);
+			}
+
+			delete data;
+
+			result.Time = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+			int projectErrors = result.Opened ? 0 : 1;
+			for (const auto& msg : result.Messages) {
+				if (msg.MType == MessageStack::Type::Error)
+					projectErrors++;
+				else
+					warnings++;
+
+				printf("%s: %s (%s%s): %s\n", project.c_str(), msg.MType == MessageStack::Type::Error ? "error" : "warning", msg.Group.c_str(),
+					msg.Line > 0 ? (", line " + std::to_string(msg.Line)).c_str() : "", msg.Text.c_str());
+			}
+			if (!result.Opened)
+				printf("%s: error: failed to open the project\n", project.c_str());
+			errors += projectErrors;
+
+			results.push_back(result);
+		}
+
+		m_destroyContext();
+
+		printf("%d project(s), %d error(s), %d warning(s)\n", (int)projects.size(), errors, warnings);
+
+		if (!m_validateReport.empty() && !m_writeValidationReport(results))
+			return 1;
+
+		return (errors > 0 || (m_validateStrict && warnings > 0)) ? 2 : 0;
+	}
+	bool HeadlessRenderer::m_writeValidationReport(const std::vector<Validation>& results)
+	{
+		static const char* STAGE_NAMES[] = { "vertex", "pixel", "geometry", "compute" };
+
+		std::string ext = getExtension(m_validateReport);
+		std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+
+		// JUnit: a test suite per project & a test case per pass
+		if (ext == "xml") {
+			pugi::xml_document doc;
+			pugi::xml_node root = doc.append_child("testsuites");
+			root.append_attribute("name").set_value("SHADERed validation");
+
+			int totalTests = 0, totalFailures = 0;
+			for (const Validation& result : results) {
+				pugi::xml_node suite = root.append_child("testsuite");
+				suite.append_attribute("name").set_value(result.Project.c_str());
+				suite.append_attribute("time").set_value(result.Time / 1000.0f);
+
+				std::vector<std::string> cases = result.Passes;
+				if (!result.Opened)
+					cases.push_back("open");
+				for (const auto& msg : result.Messages)
+					if (std::find(cases.begin(), cases.end(), msg.Group) == cases.end())
+						cases.push_back(msg.Group);
+
+				int failures = 0;
+				for (const std::string& name : cases) {
+					pugi::xml_node test = suite.append_child("testcase");
+					test.append_attribute("name").set_value(name.c_str());
+					test.append_attribute("classname").set_value(result.Project.c_str());
+
+					std::string errorText, warningText;
+					for (const auto& msg : result.Messages) {
+						if (msg.Group != name)
+							continue;
+						std::string line = (msg.Line > 0 ? "line " + std::to_string(msg.Line) + ": " : "") + msg.Text + "\n";
+						if (msg.MType == MessageStack::Type::Error)
+							errorText += line;
+						else
+							warningText += line;
+					}
+					if (!result.Opened && name == "open")
+						errorText = "Failed to open the project\n";
+
+					if (!errorText.empty()) {
+						pugi::xml_node failure = test.append_child("failure");
+						failure.append_attribute("message").set_value(errorText.substr(0, errorText.find('\n')).c_str());
+						failure.text().set(errorText.c_str());
+						failures++;
+					}
+					if (!warningText.empty())
+						test.append_child("system-out").text().set(warningText.c_str());
+				}
+
+				suite.append_attribute("tests").set_value((int)cases.size());
+				suite.append_attribute("failures").set_value(failures);
+				totalTests += cases.size();
+				totalFailures += failures;
+			}
+			root.append_attribute("tests").set_value(totalTests);
+			root.append_attribute("failures").set_value(totalFailures);
+
+			if (!doc.save_file(m_validateReport.c_str())) {
+				Logger::Get().Log("Failed to write the validation report " + m_validateReport, true);
+				return false;
+			}
+			return true;
+		}
+
+		std::ofstream report(m_validateReport);
+		if (!report.is_open()) {
+			Logger::Get().Log("Failed to write the validation report " + m_validateReport, true);
+			return false;
+		}
+		report << std::fixed << std::setprecision(2);
+
+		report << "{" << std::endl;
+		report << "\t\"projects\": [";
+		for (size_t i = 0; i < results.size(); i++) {
+			const Validation& result = results[i];
+			report << (i == 0 ? "" : ",") << std::endl;
+			report << "\t\t{" << std::endl;
+			report << "\t\t\t\"path\": \"" << escapeJSON(result.Project) << "\"," << std::endl;
+			report << "\t\t\t\"opened\": " << (result.Opened ? "true" : "false") << "," << std::endl;
+			report << "\t\t\t\"time_ms\": " << result.Time << "," << std::endl;
+			report << "\t\t\t\"messages\": [";
+			for (size_t j = 0; j < result.Messages.size(); j++) {
+				const MessageStack::Message& msg = result.Messages[j];
+				report << (j == 0 ? "" : ",") << std::endl;
+				report << "\t\t\t\t{ \"type\": \"" << (msg.MType == MessageStack::Type::Error ? "error" : "warning") << "\", \"pass\": \"" << escapeJSON(msg.Group) << "\"";
+				if (msg.Shader >= 0 && msg.Shader < 4)
+					report << ", \"stage\": \"" << STAGE_NAMES[msg.Shader] << "\"";
+				if (msg.Line > 0)
+					report << ", \"line\": " << msg.Line;
+				report << ", \"text\": \"" << escapeJSON(msg.Text) << "\" }";
+			}
+			report << std::endl << "\t\t\t]" << std::endl;
+			report << "\t\t}";
+		}
+		report << std::endl << "\t]" << std::endl;
+		report << "}" << std::endl;
+
+		return true;
+	}
+	bool HeadlessRenderer::m_writeManifest(const std::vector<std::string>& files, int rendered, bool success)
+	{
+		pugi::xml_document doc;
+		pugi::xml_node root = doc.append_child("manifest");
+		root.append_attribute("version").set_value(1);
+
+		pugi::xml_node projectNode = root.append_child("project");
+		projectNode.append_attribute("path").set_value(m_project.c_str());
+
+		pugi::xml_node outputNode = root.append_child("output");
+		outputNode.append_attribute("path").set_value(m_output.c_str());
+		outputNode.append_attribute("width").set_value(m_size.x);
+		outputNode.append_attribute("height").set_value(m_size.y);
+		outputNode.append_attribute("fps").set_value(m_fps);
+		outputNode.append_attribute("time").set_value(m_startTime);
+		outputNode.append_attribute("frameindex").set_value(m_startFrameIndex);
+
+		pugi::xml_node sliceNode = root.append_child("slice");
+		sliceNode.append_attribute("start").set_value(m_frameStart);
+		sliceNode.append_attribute("end").set_value(m_frameEnd);
+		sliceNode.append_attribute("rendered").set_value(rendered);
+		sliceNode.append_attribute("status").set_value(success && rendered == m_frameEnd - m_frameStart + 1 ? "ok" : "failed");
+
+		pugi::xml_node filesNode = root.append_child("files");
+		for (const auto& file : files)
+			filesNode.append_child("file").append_attribute("path").set_value(file.c_str());
+
+		if (!doc.save_file(m_manifest.c_str())) {
+			Logger::Get().Log("Failed to write the manifest " + m_manifest, true);
+			return false;
+		}
+
+		return true;
+	}
+	int HeadlessRenderer::m_stitch()
+	{
+		struct Slice
+		{
+			int Start, End;
+			std::string Pattern, Extension;
+			std::vector<std::string> Files;
+		};
+		std::vector<Slice> slices;
+		int width = 0, height = 0, fps = 0;
+
+		for (const auto& path : m_stitchManifests) {
+			pugi::xml_document doc;
+			if (!doc.load_file(path.c_str())) {
+				Logger::Get().Log("Failed to load the manifest " + path, true);
+				return 1;
+			}
+
+			pugi::xml_node root = doc.child("manifest");
+			pugi::xml_node outputNode = root.child("output");
+			pugi::xml_node sliceNode = root.child("slice");
+
+			if (strcmp(sliceNode.attribute("status").as_string(), "ok") != 0) {
+				Logger::Get().Log("Slice " + path + " didn't finish rendering", true);
+				return 1;
+			}
+
+			// all slices have to come from the same render
+			if (fps == 0) {
+				width = outputNode.attribute("width").as_int();
+				height = outputNode.attribute("height").as_int();
+				fps = outputNode.attribute("fps").as_int();
+			}
+			else if (width != outputNode.attribute("width").as_int() || height != outputNode.attribute("height").as_int() || fps != outputNode.attribute("fps").as_int()) {
+				Logger::Get().Log("Slice " + path + " has a different size or frame rate", true);
+				return 1;
+			}
+
+			Slice slice;
+			slice.Start = sliceNode.attribute("start").as_int();
+			slice.End = sliceNode.attribute("end").as_int();
+			slice.Pattern = outputNode.attribute("path").as_string();
+			slice.Extension = getExtension(slice.Pattern);
+			for (pugi::xml_node fileNode : root.child("files").children("file"))
+				slice.Files.push_back(fileNode.attribute("path").as_string());
+
+			slices.push_back(slice);
+		}
+
+		std::sort(slices.begin(), slices.end(), [](const Slice& a, const Slice& b) { return a.Start < b.Start; });
+		for (int i = 1; i < slices.size(); i++)
+			if (slices[i].Start != slices[i - 1].End + 1) {
+				Logger::Get().Log("Frames " + std::to_string(slices[i - 1].End + 1) + " to " + std::to_string(slices[i].Start - 1) + " are missing", true);
+				return 1;
+			}
+
+		// every file has to reach the output
+		std::string listPath = m_stitchOutput + ".txt";
+		std::ofstream list(listPath);
+		for (const auto& slice : slices) {
+			bool isVideo = isVideoExtension(slice.Extension);
+			for (const auto& file : slice.Files) {
+				if (!ghc::filesystem::exists(file)) {
+					Logger::Get().Log("File " + file + " is missing", true);
+					return 1;
+				}
+
+				// quotes in the path are closed, escaped & reopened
+				std::string escaped;
+				for (char c : file)
+					escaped += c == '\'' ? std::string("'\\''") : std::string(1, c);
+				list << "file '" << escaped << "'" << std::endl;
+				if (!isVideo)
+					list << "duration " << (1.0f / fps) << std::endl;
+			}
+		}
+		list.close();
+
+		// image slices that were rendered into one directory don't need a video
+		if (!isVideoExtension(getExtension(m_stitchOutput))) {
+			std::error_code errCode;
+			ghc::filesystem::remove(listPath, errCode);
+			printf("All %d frames are present\n", slices.back().End - slices.front().Start + 1);
+			return 0;
+		}
+
+		std::vector<std::string> args = { "-y", "-loglevel", "error", "-f", "concat", "-safe", "0", "-i", listPath };
+		if (isVideoExtension(slices[0].Extension)) {
+			args.push_back("-c"); // no need to encode again
+			args.push_back("copy");
+		} else {
+			args.insert(args.end(), { "-r", std::to_string(fps), "-pix_fmt", "yuv420p" });
+		}
+		args.push_back(m_stitchOutput);
+
+		Logger::Get().Log("Stitching the slices");
+		int ret = VideoEncoder::RunFFmpeg(args);
+
+		std::error_code errCode;
+		ghc::filesystem::remove(listPath, errCode);
+
+		if (ret != 0) {
+			Logger::Get().Log("ffmpeg failed to stitch the slices", true);
+			return 1;
+		}
+
+		return 0;
+	}
+}
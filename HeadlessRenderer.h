@@ -0,0 +1,87 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include <SDL2/SDL.h>
+#include "Objects/InputRecorder.h"
+#include "Objects/MessageStack.h"
+
+namespace ed
+{
+	class InterfaceManager;
+
+	// renders a project without creating the UI:
+	// SHADERed --render project.sprj --frames 600 --size 1920x1080 --out frames/%d.png --fps 60
+	// a long sequence can be split between machines with --frame-start/--frame-end (or --slice K/N) and --manifest,
+	// SHADERed --stitch out.mp4 slice0.xml slice1.xml ... joins the slices back together
+	// SHADERed --render project.sprj --benchmark report.json --warmup 60 --frames 600 measures the project instead of saving the frames
+	// --replay session.sedi drives --render & --benchmark with an input recording from the GUI instead of a fixed time step
+	// --converge draws every saved frame until the accumulating passes reach their sample count
+	// SHADERed --microbench [filter] [--microbench-out results.json] times the CPU hot spots without a project
+	// SHADERed --serve project.sprj --port 7310 [--bind address] [--token secret] [--fps 60] renders for a remote SHADERed client until
+	// it is interrupted - it listens on 127.0.0.1 unless --bind is given, the client has to send the token (a random one is logged if
+	// --token is missing) but the stream isn't encrypted so other machines should still reach it through a tunnel
+	// SHADERed --validate projects/ a.sprj ... [--report report.json|report.xml] [--strict] compiles every pass of the projects
+	// and exits with 2 if any of them has an error (or a warning with --strict), .xml reports are written as JUnit
+	class HeadlessRenderer
+	{
+	public:
+		HeadlessRenderer();
+
+		static bool IsRequested(int argc, char* argv[]);
+
+		bool ParseArguments(int argc, char* argv[], const std::string& cmdDir);
+		int Run(); // returns the exit code
+
+	private:
+		bool m_createContext();
+		void m_destroyContext();
+		SDL_Window* m_wnd;
+		SDL_GLContext m_glContext;
+
+		int m_render();
+		int m_stitch();
+		int m_runBenchmark(InterfaceManager* data, float compileTime);
+		int m_runMicroBenchmarks();
+		int m_serve();
+		int m_validate();
+		bool m_writeManifest(const std::vector<std::string>& files, int rendered, bool success);
+
+		std::string m_project, m_output, m_manifest, m_benchmark;
+		std::string m_replayPath;
+		InputRecorder m_replay;
+		void m_applyFrame(InterfaceManager* data, int frame, float delta); // the time & input of a frame
+		int m_frames, m_fps;
+		int m_frameStart, m_frameEnd; // inclusive
+		int m_sliceIndex, m_sliceCount;
+		int m_warmup;
+		bool m_converge;
+		float m_startTime;
+		int m_startFrameIndex;
+		glm::ivec2 m_size;
+		int m_freeVRAM; // KB, before the project was loaded
+
+		std::string m_stitchOutput;
+		std::vector<std::string> m_stitchManifests;
+
+		bool m_microbench;
+		std::string m_microbenchFilter, m_microbenchOut;
+
+		bool m_serving;
+		int m_port;
+		std::string m_bindAddress, m_token;
+
+		struct Validation
+		{
+			std::string Project;
+			bool Opened;
+			float Time; // ms
+			std::vector<std::string> Passes;
+			std::vector<MessageStack::Message> Messages; // errors & warnings
+		};
+		std::vector<std::string> m_validatePaths; // projects & directories with projects
+		std::string m_validateReport;
+		bool m_validateStrict;
+		bool m_writeValidationReport(const std::vector<Validation>& results);
+	};
+}
@@ -19,7 +19,8 @@ namespace ed
 		Pipeline(&Parser),
 		Objects(&Parser, &Renderer),
 		Parser(&Pipeline, &Objects, &Renderer, &Plugins, &Messages, &Debugger, gui),
-		Debugger(&Objects, &Renderer)
+		Debugger(&Objects, &Renderer),
+		DebugRegion(&Objects, &Renderer, &Debugger)
 	{
 		m_ui = gui;
 	}
@@ -97,12 +98,8 @@ namespace ed
 		ed::ShaderLanguage lang = ShaderTranscompiler::GetShaderTypeFromExtension(pass->VSPath);
 		std::string vsSrc = Parser.LoadProjectFile(pass->VSPath);
 		bool vsCompiled = Debugger.SetSource(lang, sd::ShaderType::Vertex, lang == ed::ShaderLanguage::GLSL ? "main" : pass->VSEntry, vsSrc);
-		if (vsCompiled) {
-			for (int i = 0; i < vertCount; i++) {
-				Debugger.InitEngine(pixel, i);
-				Debugger.Fetch(i); // run the shader
-			}
-		}
+		if (vsCompiled)
+			Debugger.RunVertexStage(pixel);
 		else ret = false;
 
 		// getting the debugger's ps output
@@ -118,7 +115,7 @@ namespace ed
 			else ret = false;
 		}
 
-		pixel.Discarded = Debugger.Engine.IsDiscarded();
+		pixel.Discarded = Debugger.Engine->IsDiscarded();
 		pixel.Fetched = vsCompiled && psCompiled;
 
 		return ret;
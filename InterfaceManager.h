@@ -1,6 +1,7 @@
 #pragma once
 #include "Objects/PluginAPI/PluginManager.h"
 #include "Objects/DebugInformation.h"
+#include "Objects/Debug/RegionDebugger.h"
 #include "Objects/PipelineManager.h"
 #include "Objects/ObjectManager.h"
 #include "Objects/ProjectParser.h"
@@ -30,6 +31,7 @@ namespace ed
 		ProjectParser Parser;
 		MessageStack Messages;
 		DebugInformation Debugger;
+		RegionDebugger DebugRegion;
 
 	private:
 		GUIManager* m_ui;
@@ -0,0 +1,289 @@
+#include "Accumulator.h"
+#include "Logger.h"
+#include "../Engine/GLUtils.h"
+
+#include <algorithm>
+#include <string>
+
+const char* ACCUMULATE_VS = R"(
+#version 330
+
+void main()
+{
+	// full screen triangle
+	vec2 uv = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+	gl_Position = vec4(uv * 2.0f - 1.0f, 0.0f, 1.0f);
+}
+)";
+
+const char* ACCUMULATE_PS = R"(
+#version 330
+
+uniform sampler2D tex;
+
+out vec4 outColor;
+
+void main()
+{
+	outColor = texelFetch(tex, ivec2(gl_FragCoord.xy), 0);
+}
+)";
+
+namespace ed
+{
+	Accumulator::Accumulator()
+	{
+		m_signature = 0;
+		m_program = m_vao = 0;
+		m_fbo[0] = m_fbo[1] = 0;
+	}
+	Accumulator::~Accumulator()
+	{
+		Clear();
+		if (m_program != 0) {
+			glDeleteProgram(m_program);
+			glDeleteVertexArrays(1, &m_vao);
+			glDeleteFramebuffers(2, m_fbo);
+		}
+	}
+	bool Accumulator::m_init()
+	{
+		GLchar msg[1024];
+
+		GLuint vs = gl::CompileShader(GL_VERTEX_SHADER, ACCUMULATE_VS);
+		GLuint ps = gl::CompileShader(GL_FRAGMENT_SHADER, ACCUMULATE_PS);
+		bool compiled = gl::CheckShaderCompilationStatus(vs, msg) && gl::CheckShaderCompilationStatus(ps, msg);
+		if (!compiled) {
+			Logger::Get().Log("Failed to compile the accumulation shader: " + std::string(msg), true);
+			glDeleteShader(vs);
+			glDeleteShader(ps);
+			return false;
+		}
+
+		m_program = glCreateProgram();
+		gl::SetObjectLabel(GL_PROGRAM, m_program, "Accumulation");
+		glAttachShader(m_program, vs);
+		glAttachShader(m_program, ps);
+		glLinkProgram(m_program);
+		glDeleteShader(vs);
+		glDeleteShader(ps);
+
+		if (!gl::CheckShaderLinkStatus(m_program, msg)) {
+			Logger::Get().Log("Failed to link the accumulation shader: " + std::string(msg), true);
+			glDeleteProgram(m_program);
+			m_program = 0;
+			return false;
+		}
+
+		glUseProgram(m_program);
+		glUniform1i(glGetUniformLocation(m_program, "tex"), 0);
+		glUseProgram(0);
+
+		glGenVertexArrays(1, &m_vao);
+		glGenFramebuffers(2, m_fbo);
+
+		return true;
+	}
+	void Accumulator::Validate(uint64_t signature)
+	{
+		if (signature == m_signature)
+			return;
+
+		m_signature = signature;
+		Reset();
+	}
+	void Accumulator::Reset()
+	{
+		for (auto& state : m_states)
+			state.second.Samples = 0;
+	}
+	unsigned int Accumulator::GetSampleCount(pipe::ShaderPass* pass)
+	{
+		auto state = m_states.find(pass);
+		return state == m_states.end() ? 0 : state->second.Samples;
+	}
+	bool Accumulator::IsDone(pipe::ShaderPass* pass)
+	{
+		auto state = m_states.find(pass);
+		if (state == m_states.end() || pass->AccumulateSamples <= 0 || state->second.Samples < (unsigned int)pass->AccumulateSamples)
+			return false;
+
+		// the render textures were recreated since the last sample
+		return std::equal(pass->RenderTextures, pass->RenderTextures + MAX_RENDER_TEXTURES, state->second.Targets);
+	}
+	void Accumulator::Add(pipe::ShaderPass* pass, const glm::ivec2& size)
+	{
+		if (m_program == 0 && !m_init())
+			return;
+
+		State& state = m_states[pass];
+		state.Target = std::max(pass->AccumulateSamples, 0);
+
+		// starts over with new textures when the render textures change
+		if (state.Size != size || !std::equal(pass->RenderTextures, pass->RenderTextures + MAX_RENDER_TEXTURES, state.Targets)) {
+			m_free(state);
+			for (int i = 0; i < MAX_RENDER_TEXTURES && pass->RenderTextures[i] != 0; i++) {
+				glGenTextures(1, &state.Textures[i]);
+				glBindTexture(GL_TEXTURE_2D, state.Textures[i]);
+				glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, size.x, size.y, 0, GL_RGBA, GL_FLOAT, nullptr);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+				gl::SetObjectLabel(GL_TEXTURE, state.Textures[i], "Accumulation");
+			}
+			glBindTexture(GL_TEXTURE_2D, 0);
+
+			memcpy(state.Targets, pass->RenderTextures, sizeof(state.Targets));
+			state.Size = size;
+			state.Samples = 0;
+		}
+
+		// passes without a render state item inherit the state of the previous pass - it has to stay the way it was
+		GLboolean blend = glIsEnabled(GL_BLEND), cull = glIsEnabled(GL_CULL_FACE), depth = glIsEnabled(GL_DEPTH_TEST), stencil = glIsEnabled(GL_STENCIL_TEST), scissor = glIsEnabled(GL_SCISSOR_TEST);
+		GLint polygonMode[2], blendEq[2], blendFunc[4];
+		GLfloat blendColor[4];
+		GLboolean colorMask[4];
+		glGetIntegerv(GL_POLYGON_MODE, polygonMode);
+		glGetIntegerv(GL_BLEND_EQUATION_RGB, &blendEq[0]);
+		glGetIntegerv(GL_BLEND_EQUATION_ALPHA, &blendEq[1]);
+		glGetIntegerv(GL_BLEND_SRC_RGB, &blendFunc[0]);
+		glGetIntegerv(GL_BLEND_DST_RGB, &blendFunc[1]);
+		glGetIntegerv(GL_BLEND_SRC_ALPHA, &blendFunc[2]);
+		glGetIntegerv(GL_BLEND_DST_ALPHA, &blendFunc[3]);
+		glGetFloatv(GL_BLEND_COLOR, blendColor);
+		glGetBooleanv(GL_COLOR_WRITEMASK, colorMask);
+
+		// average = sample * w + average * (1 - w), the first sample replaces whatever the texture had
+		float weight = 1.0f / (state.Samples + 1);
+		glEnable(GL_BLEND);
+		glBlendEquation(GL_FUNC_ADD);
+		glBlendFunc(GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA);
+		glBlendColor(0.0f, 0.0f, 0.0f, weight);
+		glDisable(GL_CULL_FACE);
+		glDisable(GL_DEPTH_TEST);
+		glDisable(GL_STENCIL_TEST);
+		glDisable(GL_SCISSOR_TEST);
+		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+		glViewport(0, 0, size.x, size.y);
+		glUseProgram(m_program);
+		glBindVertexArray(m_vao);
+		glActiveTexture(GL_TEXTURE0);
+		glBindFramebuffer(GL_FRAMEBUFFER, m_fbo[1]);
+		glDrawBuffer(GL_COLOR_ATTACHMENT0);
+		for (int i = 0; i < MAX_RENDER_TEXTURES && state.Textures[i] != 0; i++) {
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, state.Textures[i], 0);
+			glBindTexture(GL_TEXTURE_2D, state.Targets[i]);
+			glDrawArrays(GL_TRIANGLES, 0, 3);
+		}
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		glBindVertexArray(0);
+		glUseProgram(0);
+
+		if (blend) glEnable(GL_BLEND); else glDisable(GL_BLEND);
+		if (cull) glEnable(GL_CULL_FACE);
+		if (depth) glEnable(GL_DEPTH_TEST);
+		if (stencil) glEnable(GL_STENCIL_TEST);
+		if (scissor) glEnable(GL_SCISSOR_TEST);
+		glBlendEquationSeparate(blendEq[0], blendEq[1]);
+		glBlendFuncSeparate(blendFunc[0], blendFunc[1], blendFunc[2], blendFunc[3]);
+		glBlendColor(blendColor[0], blendColor[1], blendColor[2], blendColor[3]);
+		glPolygonMode(GL_FRONT_AND_BACK, polygonMode[0]);
+		glColorMask(colorMask[0], colorMask[1], colorMask[2], colorMask[3]);
+
+		state.Samples++;
+		m_copy(state);
+	}
+	void Accumulator::Restore(pipe::ShaderPass* pass)
+	{
+		auto state = m_states.find(pass);
+		if (state != m_states.end() && state->second.Samples > 0)
+			m_copy(state->second);
+	}
+	void Accumulator::m_copy(const State& state)
+	{
+		// blits are scissored too
+		GLboolean scissor = glIsEnabled(GL_SCISSOR_TEST);
+		glDisable(GL_SCISSOR_TEST);
+
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fbo[0]);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_fbo[1]);
+		glReadBuffer(GL_COLOR_ATTACHMENT0);
+		glDrawBuffer(GL_COLOR_ATTACHMENT0);
+		for (int i = 0; i < MAX_RENDER_TEXTURES && state.Textures[i] != 0; i++) {
+			glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, state.Textures[i], 0);
+			glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, state.Targets[i], 0);
+			glBlitFramebuffer(0, 0, state.Size.x, state.Size.y, 0, 0, state.Size.x, state.Size.y, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+		}
+		glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+		glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		if (scissor)
+			glEnable(GL_SCISSOR_TEST);
+	}
+	bool Accumulator::GetProgress(unsigned int& samples, unsigned int& target)
+	{
+		if (m_states.empty())
+			return false;
+
+		// a pass without a limit is never done, it is shown before the ones that are
+		bool found = false;
+		for (const auto& state : m_states) {
+			const State& s = state.second;
+			bool less = true;
+			if (found && (s.Target == 0) != (target == 0))
+				less = s.Target == 0;
+			else if (found && s.Target == 0)
+				less = s.Samples < samples;
+			else if (found)
+				less = (uint64_t)s.Samples * target < (uint64_t)samples * s.Target;
+
+			if (less) {
+				samples = s.Samples;
+				target = s.Target;
+				found = true;
+			}
+		}
+		return true;
+	}
+	bool Accumulator::IsConverged()
+	{
+		if (m_states.empty())
+			return false;
+
+		for (const auto& state : m_states)
+			if (state.second.Target == 0 || state.second.Samples < state.second.Target)
+				return false;
+		return true;
+	}
+	void Accumulator::Release(pipe::ShaderPass* pass)
+	{
+		auto state = m_states.find(pass);
+		if (state == m_states.end())
+			return;
+
+		m_free(state->second);
+		m_states.erase(state);
+	}
+	void Accumulator::Clear()
+	{
+		for (auto& state : m_states)
+			m_free(state.second);
+		m_states.clear();
+	}
+	void Accumulator::GetTextures(std::vector<GLuint>& out)
+	{
+		for (const auto& state : m_states)
+			for (int i = 0; i < MAX_RENDER_TEXTURES && state.second.Textures[i] != 0; i++)
+				out.push_back(state.second.Textures[i]);
+	}
+	void Accumulator::m_free(State& state)
+	{
+		for (int i = 0; i < MAX_RENDER_TEXTURES; i++)
+			if (state.Textures[i] != 0)
+				glDeleteTextures(1, &state.Textures[i]);
+		memset(state.Textures, 0, sizeof(state.Textures));
+	}
+}
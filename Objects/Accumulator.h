@@ -0,0 +1,69 @@
+#pragma once
+#include "PipelineItem.h"
+
+#include <unordered_map>
+#include <vector>
+#include <stdint.h>
+#include <glm/glm.hpp>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/glew.h>
+#if defined(__APPLE__)
+	#include <OpenGL/gl.h>
+#else
+	#include <GL/gl.h>
+#endif
+
+namespace ed
+{
+	// progressive rendering for the shader passes with pipe::ShaderPass::Accumulate - every frame's output is blended
+	// into a RGBA32F running average (weight 1 / (n + 1)) which is then copied back to the pass' render textures,
+	// the shaders get the number of the sample through SystemShaderVariable::SampleIndex to pick their random numbers
+	class Accumulator
+	{
+	public:
+		Accumulator();
+		~Accumulator();
+
+		// the inputs of the frame (camera, variables, shaders, size...) - a different signature starts every pass over
+		void Validate(uint64_t signature);
+		void Reset();
+
+		unsigned int GetSampleCount(pipe::ShaderPass* pass); // samples in the average = SampleIndex of the next one
+		bool IsDone(pipe::ShaderPass* pass); // reached pass->AccumulateSamples, the pass doesn't have to be drawn anymore
+
+		void Add(pipe::ShaderPass* pass, const glm::ivec2& size); // blends the render textures in & writes the average back
+		void Restore(pipe::ShaderPass* pass); // writes the average back, something could have drawn over the render textures
+
+		// the least converged pass, false if nothing accumulates - target 0 = no limit
+		bool GetProgress(unsigned int& samples, unsigned int& target);
+		bool IsConverged(); // every accumulating pass reached its target
+
+		void Release(pipe::ShaderPass* pass);
+		void Clear();
+
+		void GetTextures(std::vector<GLuint>& out); // the RGBA32F running averages, for the memory panel
+
+	private:
+		struct State
+		{
+			State() { memset(Textures, 0, sizeof(Textures)); memset(Targets, 0, sizeof(Targets)); Size = glm::ivec2(0, 0); Samples = Target = 0; }
+
+			GLuint Textures[MAX_RENDER_TEXTURES]; // running averages
+			GLuint Targets[MAX_RENDER_TEXTURES]; // render textures they were made for
+			glm::ivec2 Size;
+			unsigned int Samples, Target;
+		};
+
+		bool m_init();
+		void m_free(State& state);
+		void m_copy(const State& state); // average -> render textures
+
+		std::unordered_map<pipe::ShaderPass*, State> m_states;
+		uint64_t m_signature;
+
+		GLuint m_program, m_vao, m_fbo[2]; // read & draw
+	};
+}
@@ -16,42 +16,51 @@ namespace ed
 		m_pitch = 0;
 		m_yaw = 0;
 		m_roll = 0;
+		m_changed = true;
 	}
 	void ArcBallCamera::SetDistance(float d)
 	{
 		m_distance = glm::clamp(d, ArcBallCamera::MinDistance, ArcBallCamera::MaxDistance);
+		m_changed = true;
 	}
 	void ArcBallCamera::Move(float d)
 	{
 		m_distance = glm::clamp(m_distance + d, ArcBallCamera::MinDistance, ArcBallCamera::MaxDistance);
+		m_changed = true;
 	}
 	void ArcBallCamera::Yaw(float rx)
 	{
 		m_yaw = fmod(m_yaw - rx, 360.0f);
 		if (m_yaw < 0.0)
 			m_yaw += 360.0f;
+		m_changed = true;
 	}
 	void ArcBallCamera::Pitch(float ry)
 	{
 		m_pitch = glm::clamp(m_pitch + ry, -ArcBallCamera::MaxRotationY, ArcBallCamera::MaxRotationY);
+		m_changed = true;
 	}
 	void ArcBallCamera::Roll(float rz)
 	{
 		m_roll = fmod(m_roll + rz, 360.0f);
 		if (m_roll < 0.0)
 			m_roll += 360.0f;
+		m_changed = true;
 	}
 	void ArcBallCamera::SetYaw(float r)
 	{
 		m_yaw = r;
+		m_changed = true;
 	}
 	void ArcBallCamera::SetPitch(float r)
 	{
 		m_pitch = r;
+		m_changed = true;
 	}
 	void ArcBallCamera::SetRoll(float r)
 	{
 		m_roll = r;
+		m_changed = true;
 	}
 	glm::vec4 ArcBallCamera::GetViewDirection()
 	{
@@ -77,6 +86,9 @@ namespace ed
 	}
 	glm::mat4 ArcBallCamera::GetMatrix()
 	{
+		if (!m_changed)
+			return m_matrix;
+
 		glm::vec4 pos(0, 0, -m_distance, 0);
 		glm::vec4 up(0, 1, 0, 0);
 		glm::mat4 rotaMat = glm::yawPitchRoll(glm::radians(m_yaw), glm::radians(m_pitch), glm::radians(m_roll));
@@ -84,6 +96,9 @@ namespace ed
 		up = rotaMat * up;
 		pos = rotaMat * pos;
 
-		return glm::lookAt(glm::vec3(pos), glm::vec3(0, 0, 0), glm::vec3(up));
+		m_matrix = glm::lookAt(glm::vec3(pos), glm::vec3(0, 0, 0), glm::vec3(up));
+		m_changed = false;
+
+		return m_matrix;
 	}
 }
\ No newline at end of file
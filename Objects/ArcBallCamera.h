@@ -41,11 +41,16 @@ namespace ed
 			this->m_yaw = arc.m_yaw;
 			this->m_pitch = arc.m_pitch;
 			this->m_roll = arc.m_roll;
+			this->m_changed = true;
 			return *this;
 		}
 
 	private:
 		float m_distance;
 		float m_yaw, m_pitch, m_roll;
+
+		// view matrix is only rebuilt after the camera moved
+		bool m_changed;
+		glm::mat4 m_matrix;
 	};
 }
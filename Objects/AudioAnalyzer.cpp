@@ -1,7 +1,18 @@
 #include "AudioAnalyzer.h"
+#include "ProfilerZones.h"
 
 #define _USE_MATH_DEFINES
 #include <math.h>
+#include <string.h>
+#include <algorithm>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+	#include <xmmintrin.h>
+	#define AUDIO_FFT_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	#include <arm_neon.h>
+	#define AUDIO_FFT_NEON
+#endif
 
 const float ed::AudioAnalyzer::Smooth[] = { 1.0f, 1.0f, 1.0f, 1.0f, 1.0f };
 const float ed::AudioAnalyzer::Gravity = 0.0006f;
@@ -17,6 +28,30 @@ namespace ed
 	{
 		m_sensitivity = 1.0;
 		m_isSetup = 0;
+
+		int bits = 0;
+		while ((1 << bits) < SampleCount)
+			bits++;
+
+		for (int i = 0; i < SampleCount; i++) {
+			int rev = 0;
+			for (int b = 0; b < bits; b++)
+				rev |= ((i >> b) & 1) << (bits - 1 - b);
+			m_bitReverse[i] = rev;
+		}
+
+		// e^(-2*pi*i*k/L) for every stage, stored right after each other
+		for (int len = 2; len <= SampleCount; len *= 2)
+			for (int k = 0; k < len / 2; k++) {
+				double angle = -2.0 * M_PI * k / len;
+				m_twiddleRe[len / 2 + k] = cos(angle);
+				m_twiddleIm[len / 2 + k] = sin(angle);
+			}
+		m_twiddleRe[0] = m_twiddleIm[0] = 0.0f;
+
+		// Hann window, scaled by 2 to keep the average level of the unwindowed input
+		for (int i = 0; i < WindowSize; i++)
+			m_window[i] = 1.0 - cos(2.0 * M_PI * i / (WindowSize - 1));
 	}
 
 	AudioAnalyzer::~AudioAnalyzer()
@@ -51,34 +86,40 @@ namespace ed
 	}
 	double* AudioAnalyzer::FFT(sf::SoundBuffer& file, int curSample)
 	{
-		int rate = file.getSampleRate();
 		int channels = file.getChannelCount();
 		int samplersPerChannel = file.getSampleCount() / channels;
-		const sf::Int16* samples = file.getSamples();
-		curSample *= channels;
+		curSample = std::max(std::min(curSample, samplersPerChannel), 0);
+
+		return FFT(file.getSamples() + curSample * channels, samplersPerChannel - curSample, channels, file.getSampleRate());
+	}
+	double* AudioAnalyzer::FFT(const sf::Int16* samples, int count, int channels, int rate)
+	{
+		ED_ZONE("AudioAnalyzer::FFT");
+
+		int total = count * channels;
 
 		if (m_isSetup != rate) {
 			m_setup(rate);
 			m_isSetup = rate;
 		}
 
-		// Spliting channels
+		// Spliting channels - written straight to their bit reversed positions
+		memset(m_re, 0, sizeof(m_re));
+		memset(m_im, 0, sizeof(m_im));
 		int n = 0;
-		std::valarray<std::complex<double>> fftIn(SampleCount);
 		for (int i = 0; i < SampleCount / 2; i += 2) {
-			if (curSample + i > samplersPerChannel*channels || curSample + i + 1 > samplersPerChannel * channels)
-				continue;
+			if (i + 1 >= total)
+				break;
 
-			fftIn[n] = (samples[curSample + i] + samples[curSample + i + 1]) / 2; // TODO: Add stereo option
+			m_re[m_bitReverse[n]] = (samples[i] + samples[i + 1]) / 2 * m_window[n]; // TODO: Add stereo option
 			n++;
-			if (n == SampleCount - 1) n = 0;
 		}
 
 		// Run fftw
-		m_fftAlgorithm(fftIn);
+		m_fftAlgorithm(m_re, m_im);
 
 		// Separate fftw output
-		m_seperateFreqBands(&fftIn[0], BufferOutSize, m_lcf, m_hcf, m_smoothing, m_sensitivity, BufferOutSize);
+		m_seperateFreqBands(m_re, m_im, BufferOutSize, m_lcf, m_hcf, m_smoothing, m_sensitivity);
 
 		/* Processing */
 		// Waves
@@ -132,45 +173,79 @@ namespace ed
 
 		return &m_fftOut[0];
 	}
-	void AudioAnalyzer::m_fftAlgorithm(std::valarray<std::complex<double>>& input)
+	void AudioAnalyzer::m_fftAlgorithm(float* re, float* im)
 	{
-		const int len = input.size();
-		if (len <= 1) return;
-
-		std::valarray<std::complex<double>> even = input[std::slice(0, len / 2, 2)];
-		std::valarray<std::complex<double>>  odd = input[std::slice(1, len / 2, 2)];
-
-		m_fftAlgorithm(even);
-		m_fftAlgorithm(odd);
+		// first two stages as one radix-4 pass - their twiddles are 1 and -i
+		for (int i = 0; i < SampleCount; i += 4) {
+			float r0 = re[i] + re[i + 1], i0 = im[i] + im[i + 1];
+			float r1 = re[i] - re[i + 1], i1 = im[i] - im[i + 1];
+			float r2 = re[i + 2] + re[i + 3], i2 = im[i + 2] + im[i + 3];
+			float r3 = re[i + 2] - re[i + 3], i3 = im[i + 2] - im[i + 3];
+
+			re[i] = r0 + r2;		im[i] = i0 + i2;
+			re[i + 2] = r0 - r2;	im[i + 2] = i0 - i2;
+			re[i + 1] = r1 + i3;	im[i + 1] = i1 - r3; // r1 + (-i) * (r3 + i*i3)
+			re[i + 3] = r1 - i3;	im[i + 3] = i1 + r3;
+		}
 
-		for (int i = 0; i < len / 2; i++)
-		{
-			std::complex<double> temp = std::polar(1.0, (double)-2 * M_PI * i / len) * odd[i];
-			input[i] = even[i] + temp;
-			input[i + len / 2] = even[i] - temp;
+		// radix-2 stages, 4 butterflies at once
+		for (int len = 8; len <= SampleCount; len *= 2) {
+			int half = len / 2;
+			const float* wr = &m_twiddleRe[half];
+			const float* wi = &m_twiddleIm[half];
+
+			for (int start = 0; start < SampleCount; start += len) {
+				float* ar = re + start;
+				float* ai = im + start;
+				float* br = ar + half;
+				float* bi = ai + half;
+
+				for (int k = 0; k < half; k += 4) {
+#if defined(AUDIO_FFT_SSE)
+					__m128 twr = _mm_loadu_ps(wr + k), twi = _mm_loadu_ps(wi + k);
+					__m128 xr = _mm_loadu_ps(br + k), xi = _mm_loadu_ps(bi + k);
+					__m128 tr = _mm_sub_ps(_mm_mul_ps(xr, twr), _mm_mul_ps(xi, twi));
+					__m128 ti = _mm_add_ps(_mm_mul_ps(xr, twi), _mm_mul_ps(xi, twr));
+					__m128 yr = _mm_loadu_ps(ar + k), yi = _mm_loadu_ps(ai + k);
+					_mm_storeu_ps(br + k, _mm_sub_ps(yr, tr));
+					_mm_storeu_ps(bi + k, _mm_sub_ps(yi, ti));
+					_mm_storeu_ps(ar + k, _mm_add_ps(yr, tr));
+					_mm_storeu_ps(ai + k, _mm_add_ps(yi, ti));
+#elif defined(AUDIO_FFT_NEON)
+					float32x4_t twr = vld1q_f32(wr + k), twi = vld1q_f32(wi + k);
+					float32x4_t xr = vld1q_f32(br + k), xi = vld1q_f32(bi + k);
+					float32x4_t tr = vmlsq_f32(vmulq_f32(xr, twr), xi, twi);
+					float32x4_t ti = vmlaq_f32(vmulq_f32(xr, twi), xi, twr);
+					float32x4_t yr = vld1q_f32(ar + k), yi = vld1q_f32(ai + k);
+					vst1q_f32(br + k, vsubq_f32(yr, tr));
+					vst1q_f32(bi + k, vsubq_f32(yi, ti));
+					vst1q_f32(ar + k, vaddq_f32(yr, tr));
+					vst1q_f32(ai + k, vaddq_f32(yi, ti));
+#else
+					for (int j = k; j < k + 4; j++) {
+						float tr = br[j] * wr[j] - bi[j] * wi[j];
+						float ti = br[j] * wi[j] + bi[j] * wr[j];
+						br[j] = ar[j] - tr;
+						bi[j] = ai[j] - ti;
+						ar[j] += tr;
+						ai[j] += ti;
+					}
+#endif
+				}
+			}
 		}
 	}
-	void AudioAnalyzer::m_seperateFreqBands(std::complex<double>* in, int n, int* lcf, int* hcf, float* k, double sensitivity, int in_samples)
+	void AudioAnalyzer::m_seperateFreqBands(const float* re, const float* im, int n, int* lcf, int* hcf, float* k, double sensitivity)
 	{
-		double* peak = new double[n];
-		double* y = new double[in_samples];
-		double temp;
-
 		for (int i = 0; i < n; i++) {
-			peak[i] = 0;
+			double peak = 0;
 
-			for (int j = lcf[i]; j <= hcf[i]; j++) {
-				y[j] = sqrt(in[j].real() * in[j].real() + in[j].imag() * in[j].imag());
-				peak[i] += y[j];
-			}
+			for (int j = lcf[i]; j <= hcf[i]; j++)
+				peak += sqrtf(re[j] * re[j] + im[j] * im[j]);
 
-
-			peak[i] = peak[i] / (hcf[i] - lcf[i] + 1);
-			temp = peak[i] * sensitivity * k[i] / 1000000;
+			peak = peak / (hcf[i] - lcf[i] + 1);
+			double temp = peak * sensitivity * k[i] / 1000000;
 			m_fftOut[i] = temp / 100.0;
 		}
-
-		delete[] peak;
-		delete[] y;
 	}
 }
\ No newline at end of file
@@ -1,7 +1,6 @@
 #pragma once
 #include <vector>
-#include <valarray>
-#include <complex>
+#include <stdint.h>
 
 #include <SFML/Audio/SoundBuffer.hpp>
 
@@ -17,16 +16,19 @@ namespace ed
 		static const int HighFrequency = 18000;
 		static const int LowFrequency = 20;
 		static const float LogScale;
+		static const int WindowSize = SampleCount / 4; // samples that are taken from the track, the rest is zero padding
 
 	public:
 		AudioAnalyzer();
 		~AudioAnalyzer();
 
 		double* FFT(sf::SoundBuffer& file, int curSample);
+		// samples = interleaved samples starting at the playing position, count = frames that can be read from them
+		double* FFT(const sf::Int16* samples, int count, int channels, int rate);
 
 	private:
-		void m_fftAlgorithm(std::valarray<std::complex<double>>& x);
-		void m_seperateFreqBands(std::complex<double>* in, int n, int* lcf, int* hcf, float* k, double sensitivity, int in_samples);
+		void m_fftAlgorithm(float* re, float* im); // in place, the input has to be in bit reversed order
+		void m_seperateFreqBands(const float* re, const float* im, int n, int* lcf, int* hcf, float* k, double sensitivity);
 
 		int m_isSetup;
 		void m_setup(int rate);
@@ -41,5 +43,11 @@ namespace ed
 
 		double m_fftOut[SampleCount];
 		double m_sensitivity;
+
+		/* FFT tables & buffers - split real/imaginary parts so that 4 butterflies fit in one SIMD register */
+		float m_re[SampleCount], m_im[SampleCount];
+		float m_twiddleRe[SampleCount], m_twiddleIm[SampleCount]; // stage with length L uses [L/2, L)
+		float m_window[WindowSize];
+		uint16_t m_bitReverse[SampleCount];
 	};
 }
\ No newline at end of file
@@ -1,8 +1,11 @@
 #include "AudioShaderStream.h"
 #include "ShaderTranscompiler.h"
+#include "Settings.h"
 #include "../Engine/GeometryFactory.h"
 #include "../Engine/GLUtils.h"
+#include <SFML/Audio/OutputSoundFile.hpp>
 #include <vector>
+#include <algorithm>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
@@ -11,33 +14,65 @@ namespace ed
 	AudioShaderStream::AudioShaderStream()
 	{
 		m_fboBuffers = GL_COLOR_ATTACHMENT0;
-		m_curTime = 0.0f;
-		
-		memset(m_pixels, 0, sizeof(char) * 1024);
-		m_needsUpdate = false;
+		m_fsRectVAO = m_fsRectVBO = 0;
+		m_fbo = m_rt = m_depth = 0;
+		m_shader = m_svarCurTimeLoc = m_svarRowLengthLoc = 0;
+
+		m_blockSize = m_blockCount = 0;
+		m_write = m_read = 0;
+		m_issued = 0;
+		m_holding = false;
+
+		m_generation = 0;
+		m_resetSample = 0;
+		m_playSample = 0;
+		m_renderGeneration = 0;
+		m_renderSample = 0;
 
-		initialize(2, 44100);
+		initialize(2, AUDIO_SHADER_SAMPLE_RATE);
 	}
 	AudioShaderStream::~AudioShaderStream()
 	{
-		gl::FreeSimpleFramebuffer(m_fbo, m_rt, m_depth);
+		stop();
+
+		m_release();
 		glDeleteVertexArrays(1, &m_fsRectVAO);
 		glDeleteBuffers(1, &m_fsRectVBO);
 		glDeleteProgram(m_shader);
-		stop();
 	}
 	
 	bool AudioShaderStream::onGetData(Chunk& data)
 	{
-		m_mutex.lock();
+		unsigned int read = m_read.load(std::memory_order_relaxed);
 
-		data.samples = m_audio;
-		data.sampleCount = 1024*2;
+		// SFML copied the previous block by now
+		if (m_holding) {
+			read++;
+			m_read.store(read, std::memory_order_release);
+			m_holding = false;
+		}
+
+		// skip the blocks that were rendered before a seek or a recompile
+		unsigned int generation = m_generation.load(std::memory_order_acquire);
+		unsigned int write = m_write.load(std::memory_order_acquire);
+		while (read != write && m_blocks[read % m_blocks.size()].Generation != generation) {
+			read++;
+			m_read.store(read, std::memory_order_release);
+		}
+
+		// the renderer fell behind - play silence instead of waiting for it
+		if (read == write) {
+			data.samples = m_silence.data();
+			data.sampleCount = m_silence.size();
+			return true;
+		}
 
-		m_curTime += 1024.0f/44100.0f;
-		m_needsUpdate = true;
+		const Block& block = m_blocks[read % m_blocks.size()];
+		data.samples = block.Samples.data();
+		data.sampleCount = block.Samples.size();
 
-		m_mutex.unlock();
+		m_playSample = block.Start + block.Samples.size() / 2;
+		m_holding = true;
 
 		return true;
 	}
@@ -65,9 +100,10 @@ namespace ed
 				cbuffer vars : register(b15)
 				{
 					float sedCurrentTime;
+					float sedRowLength;
 				};
 				float4 main(PSInput inp) : SV_TARGET {
-					float time = sedCurrentTime + inp.Pos.x / 44100.0f;
+					float time = sedCurrentTime + (inp.Pos.x + floor(inp.Pos.y) * sedRowLength) / 44100.0f;
 					float2 v = mainSound(time);
 					return float4(v.x, v.y, 0, 0); // TODO: put 4 samples in one pixel
 				}
@@ -76,8 +112,9 @@ namespace ed
 			psCodeIn += R"(
 				out vec4 fragColor;
 				uniform float sedCurrentTime;
+				uniform float sedRowLength;
 				void main() {
-					float time = sedCurrentTime + gl_FragCoord.x / 44100.0f;
+					float time = sedCurrentTime + (gl_FragCoord.x + floor(gl_FragCoord.y) * sedRowLength) / 44100.0f;
 					vec2 v = mainSound(time);
 					fragColor = vec4(v.x, v.y, 0, 0); // TODO: put 4 samples in one pixel
 				}
@@ -113,6 +150,8 @@ namespace ed
 		}
 
 		// create a shader program for cubemap preview
+		if (m_shader != 0)
+			glDeleteProgram(m_shader);
 		m_shader = glCreateProgram();
 		glAttachShader(m_shader, audioVS);
 		glAttachShader(m_shader, audioPS);
@@ -126,49 +165,274 @@ namespace ed
 		glDeleteShader(audioVS);
 		glDeleteShader(audioPS);
 
-		m_fsRectVAO = ed::eng::GeometryFactory::CreateScreenQuadNDC(m_fsRectVBO, gl::CreateDefaultInputLayout());
-		m_fbo = gl::CreateSimpleFramebuffer(1024, 1, m_rt, m_depth, GL_RGBA32F);
+		if (m_fsRectVAO == 0)
+			m_fsRectVAO = ed::eng::GeometryFactory::CreateScreenQuadNDC(m_fsRectVBO, gl::CreateDefaultInputLayout());
+
+		// a playing stream already has its blocks
+		if (m_blocks.empty())
+			m_allocate(Settings::Instance().Preview.AudioBlockSize, Settings::Instance().Preview.AudioBlocksAhead);
 
 		m_svarCurTimeLoc = glGetUniformLocation(m_shader, "sedCurrentTime");
+		m_svarRowLengthLoc = glGetUniformLocation(m_shader, "sedRowLength");
+
+		// blocks rendered with the old shader are dropped, the new one continues from what's being played
+		m_reset(m_playSample);
 
 		if (getStatus() != sf::SoundSource::Status::Playing)
 			play();
 	}
 	void AudioShaderStream::renderAudio()
 	{
-		if (!m_needsUpdate)
+		if (m_shader == 0 || m_blocks.empty())
 			return;
-		
-		m_mutex.lock();
+
+		// the ring can only be replaced while the audio thread isn't running
+		Settings& settings = Settings::Instance();
+		if ((m_blockSize != settings.Preview.AudioBlockSize || m_blockCount != settings.Preview.AudioBlocksAhead) && getStatus() != sf::SoundSource::Status::Paused) {
+			bool isPlaying = getStatus() == sf::SoundSource::Status::Playing;
+			uint64_t position = m_playSample;
+
+			stop();
+			m_allocate(settings.Preview.AudioBlockSize, settings.Preview.AudioBlocksAhead);
+			m_reset(position);
+
+			if (isPlaying)
+				play();
+		}
+
+		unsigned int generation = m_generation.load(std::memory_order_acquire);
+		if (generation != m_renderGeneration) {
+			m_renderGeneration = generation;
+			m_renderSample = m_resetSample;
+		}
+
+		// publish the finished readbacks in order
+		while (m_write.load(std::memory_order_relaxed) != m_issued && m_completeBlock())
+			;
+
+		// render ahead - the slot that the audio thread is reading from is never overwritten
+		while (m_issued - m_read.load(std::memory_order_acquire) < (unsigned int)m_blockCount)
+			m_issueBlock();
+	}
+	bool AudioShaderStream::renderToFile(const std::string& path, float start, float duration)
+	{
+		if (m_shader == 0 || m_fsRectVAO == 0 || duration <= 0.0f)
+			return false;
+
+		sf::OutputSoundFile file;
+		if (!file.openFromFile(path, AUDIO_SHADER_SAMPLE_RATE, 2))
+			return false;
+
+		// the samples are laid out row by row in one wide target
+		GLint maxSize = 0;
+		glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+		int width = std::min<int>(AUDIO_SHADER_EXPORT_WIDTH, maxSize);
+		int height = AUDIO_SHADER_EXPORT_ROWS;
+		int batchSize = width * height;
+
+		GLuint rt = 0, depth = 0;
+		GLuint fbo = gl::CreateSimpleFramebuffer(width, height, rt, depth, GL_RGBA32F);
+
+		// two batches in flight - one is converted and written while the GPU renders the next one
+		GLuint pbos[2];
+		GLsync fences[2] = { 0, 0 };
+		glGenBuffers(2, pbos);
+		for (int i = 0; i < 2; i++) {
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[i]);
+			glBufferData(GL_PIXEL_PACK_BUFFER, batchSize * 2 * sizeof(float), nullptr, GL_STREAM_READ);
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		std::vector<sf::Int16> samples(batchSize * 2);
+
+		uint64_t first = (uint64_t)(std::max(0.0f, start) * AUDIO_SHADER_SAMPLE_RATE);
+		uint64_t total = (uint64_t)(duration * AUDIO_SHADER_SAMPLE_RATE);
+		uint64_t batchCount = (total + batchSize - 1) / batchSize;
+
+		glUseProgram(m_shader);
+		glUniform1f(m_svarRowLengthLoc, (float)width);
+		glBindVertexArray(m_fsRectVAO);
+		glViewport(0, 0, width, height);
+
+		bool ret = true;
+		for (uint64_t b = 0; b <= batchCount && ret; b++) {
+			if (b < batchCount) {
+				int slot = b % 2;
+
+				glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+				glDrawBuffers(1, &m_fboBuffers);
+				glClearBufferfi(GL_DEPTH_STENCIL, 0, 1.0f, 0);
+				glClearBufferfv(GL_COLOR, 0, glm::value_ptr(glm::vec4(0.0f, 0.0f, 0.0f, 0.0f)));
+
+				glUniform1f(m_svarCurTimeLoc, (float)((first + b * batchSize) / (double)AUDIO_SHADER_SAMPLE_RATE));
+				glDrawArrays(GL_TRIANGLES, 0, 6);
+
+				glReadBuffer(GL_COLOR_ATTACHMENT0);
+				glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[slot]);
+				glReadPixels(0, 0, width, height, GL_RG, GL_FLOAT, 0);
+				glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+				fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			}
+
+			if (b == 0)
+				continue;
+
+			int slot = (b - 1) % 2;
+
+			GLenum status = GL_TIMEOUT_EXPIRED;
+			while (status == GL_TIMEOUT_EXPIRED)
+				status = glClientWaitSync(fences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+			glDeleteSync(fences[slot]);
+			fences[slot] = 0;
+
+			if (status == GL_WAIT_FAILED) {
+				ret = false;
+				break;
+			}
+
+			int count = std::min<uint64_t>(batchSize, total - (b - 1) * batchSize);
+
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[slot]);
+			const float* pixels = (const float*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, count * 2 * sizeof(float), GL_MAP_READ_BIT);
+			if (pixels != nullptr) {
+				for (int s = 0; s < count * 2; s++)
+					samples[s] = std::max(-1.0f, std::min(1.0f, pixels[s])) * INT16_MAX;
+				glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+
+				file.write(samples.data(), count * 2);
+			} else
+				ret = false;
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		}
+
+		for (int i = 0; i < 2; i++)
+			if (fences[i] != 0)
+				glDeleteSync(fences[i]);
+		glDeleteBuffers(2, pbos);
+		gl::FreeSimpleFramebuffer(fbo, rt, depth);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glBindVertexArray(0);
+
+		return ret;
+	}
+	void AudioShaderStream::onSeek(sf::Time timeOffset)
+	{
+		m_reset(timeOffset.asMicroseconds() * AUDIO_SHADER_SAMPLE_RATE / 1000000);
+	}
+	void AudioShaderStream::m_allocate(int blockSize, int blockCount)
+	{
+		m_release();
+
+		m_blockSize = blockSize;
+		m_blockCount = blockCount;
+
+		m_fbo = gl::CreateSimpleFramebuffer(blockSize, 1, m_rt, m_depth, GL_RGBA32F);
+
+		m_blocks.resize(blockCount);
+		for (Block& block : m_blocks) {
+			block.Samples.assign(blockSize * 2, 0);
+			block.Start = 0;
+			block.Generation = 0;
+		}
+
+		// only the left and right channel are read back
+		m_pbos.resize(blockCount);
+		glGenBuffers(blockCount, m_pbos.data());
+		for (GLuint pbo : m_pbos) {
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+			glBufferData(GL_PIXEL_PACK_BUFFER, blockSize * 2 * sizeof(float), nullptr, GL_STREAM_READ);
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		m_fences.assign(blockCount, 0);
+		m_silence.assign(blockSize * 2, 0);
+
+		m_write = m_read = 0;
+		m_issued = 0;
+		m_holding = false;
+	}
+	void AudioShaderStream::m_release()
+	{
+		for (GLsync fence : m_fences)
+			if (fence != 0)
+				glDeleteSync(fence);
+		if (!m_pbos.empty())
+			glDeleteBuffers(m_pbos.size(), m_pbos.data());
+		if (m_fbo != 0)
+			gl::FreeSimpleFramebuffer(m_fbo, m_rt, m_depth);
+
+		m_fences.clear();
+		m_pbos.clear();
+		m_blocks.clear();
+		m_fbo = m_rt = m_depth = 0;
+		m_blockSize = m_blockCount = 0;
+	}
+	void AudioShaderStream::m_reset(uint64_t sample)
+	{
+		m_resetSample = sample;
+		m_playSample = sample;
+		m_generation.fetch_add(1, std::memory_order_release);
+	}
+	void AudioShaderStream::m_issueBlock()
+	{
+		int slot = m_issued % m_blockCount;
+
+		Block& block = m_blocks[slot];
+		block.Start = m_renderSample;
+		block.Generation = m_renderGeneration;
 
 		glUseProgram(m_shader);
 		glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
 		glDrawBuffers(1, &m_fboBuffers);
 		glClearBufferfi(GL_DEPTH_STENCIL, 0, 1.0f, 0);
 		glClearBufferfv(GL_COLOR, 0, glm::value_ptr(glm::vec4(0.0f, 0.0f, 0.0f, 0.0f)));
-		glViewport(0, 0, 1024, 1);
+		glViewport(0, 0, m_blockSize, 1);
 
-		glUniform1f(m_svarCurTimeLoc, m_curTime);
+		glUniform1f(m_svarCurTimeLoc, (float)(m_renderSample / (double)AUDIO_SHADER_SAMPLE_RATE));
+		glUniform1f(m_svarRowLengthLoc, (float)m_blockSize);
 		glBindVertexArray(m_fsRectVAO);
 		glDrawArrays(GL_TRIANGLES, 0, 6);
 
+		// the copy into the PBO doesn't stall, the data is mapped once the fence is signaled
+		glReadBuffer(GL_COLOR_ATTACHMENT0);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbos[slot]);
+		glReadPixels(0, 0, m_blockSize, 1, GL_RG, GL_FLOAT, 0);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
 		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-		glBindTexture(GL_TEXTURE_2D, m_rt);
-		glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, m_pixels);
-		glBindTexture(GL_TEXTURE_2D, 0);
-
-		for (int s = 0; s < 1024; s++) {
-			int off = s * 4;
-			m_audio[s*2] = m_pixels[off + 0] * INT16_MAX;
-			m_audio[s*2+1] = m_pixels[off + 1] * INT16_MAX;
-		}
 
-		m_needsUpdate = false;
-		
-		m_mutex.unlock();
+		m_fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+		m_renderSample += m_blockSize;
+		m_issued++;
 	}
-	void AudioShaderStream::onSeek(sf::Time timeOffset)
+	bool AudioShaderStream::m_completeBlock()
 	{
-		m_curTime = timeOffset.asSeconds();
+		unsigned int write = m_write.load(std::memory_order_relaxed);
+		int slot = write % m_blockCount;
+
+		GLenum status = glClientWaitSync(m_fences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+			return false;
+
+		glDeleteSync(m_fences[slot]);
+		m_fences[slot] = 0;
+
+		Block& block = m_blocks[slot];
+
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbos[slot]);
+		const float* pixels = (const float*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, m_blockSize * 2 * sizeof(float), GL_MAP_READ_BIT);
+		if (pixels != nullptr) {
+			for (int s = 0; s < m_blockSize * 2; s++)
+				block.Samples[s] = std::max(-1.0f, std::min(1.0f, pixels[s])) * INT16_MAX;
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		} else
+			std::fill(block.Samples.begin(), block.Samples.end(), 0);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		m_write.store(write + 1, std::memory_order_release);
+
+		return true;
 	}
 }
\ No newline at end of file
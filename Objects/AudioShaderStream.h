@@ -3,6 +3,7 @@
 #include <string>
 #include <vector>
 #include <atomic>
+#include <stdint.h>
 #include <GL/glew.h>
 #if defined(__APPLE__)
 	#include <OpenGL/gl.h>
@@ -14,8 +15,14 @@
 #include "ShaderMacro.h"
 #include "ProjectParser.h"
 
+#define AUDIO_SHADER_SAMPLE_RATE 44100
+#define AUDIO_SHADER_EXPORT_WIDTH 8192 // samples per row of the offline render target
+#define AUDIO_SHADER_EXPORT_ROWS 32
+
 namespace ed
 {
+	// blocks are rendered ahead on the main thread and read back through PBOs, the audio thread
+	// only takes the finished blocks from a single producer / single consumer ring and never waits
 	class AudioShaderStream : public sf::SoundStream
 	{
 		virtual bool onGetData(Chunk& data);
@@ -28,19 +35,46 @@ namespace ed
 		void compileFromShaderSource(ProjectParser* project, MessageStack* msgs, const std::string& str, std::vector<ed::ShaderMacro>& macros, bool isHLSL = false);
 		void renderAudio();
 
+		// renders the samples offline in large batches, the caller binds the pass' resources & variables
+		bool renderToFile(const std::string& path, float start, float duration);
+
 		inline GLuint getShader() { return m_shader; }
 
 	private:
-		std::atomic<bool> m_needsUpdate;
-		sf::Mutex m_mutex;
+		struct Block
+		{
+			std::vector<sf::Int16> Samples; // interleaved stereo
+			uint64_t Start;					// index of the first sample
+			unsigned int Generation;
+		};
+
+		void m_allocate(int blockSize, int blockCount); // stream must be stopped
+		void m_release();
+		void m_reset(uint64_t sample); // drop the blocks that were already rendered and continue from the sample
+		void m_issueBlock();
+		bool m_completeBlock(); // false if the oldest readback isn't done yet
 
-		float m_curTime;
 		GLuint m_fboBuffers;
 		GLuint m_fsRectVAO, m_fsRectVBO;
 		GLuint m_fbo, m_rt, m_depth;
-		GLuint m_shader, m_svarCurTimeLoc;
+		GLuint m_shader, m_svarCurTimeLoc, m_svarRowLengthLoc;
+
+		int m_blockSize, m_blockCount;
+		std::vector<Block> m_blocks;
+		std::vector<GLuint> m_pbos;
+		std::vector<GLsync> m_fences;
+		std::vector<sf::Int16> m_silence; // played when the renderer falls behind
+
+		// ring positions - m_write is only changed by the main thread, m_read only by the audio thread
+		std::atomic<unsigned int> m_write, m_read;
+		unsigned int m_issued; // blocks with a readback in flight are in [m_write, m_issued)
+		bool m_holding;		   // SFML is still playing the block at m_read
 
-		sf::Int16 m_audio[1024*2];
-		float m_pixels[1024*4];
+		// seeks and recompiles restart the rendering at m_resetSample
+		std::atomic<unsigned int> m_generation;
+		std::atomic<uint64_t> m_resetSample;
+		std::atomic<uint64_t> m_playSample; // first sample after the block that was handed out last
+		unsigned int m_renderGeneration;
+		uint64_t m_renderSample;
 	};
 }
\ No newline at end of file
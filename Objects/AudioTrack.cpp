@@ -0,0 +1,252 @@
+#include "AudioTrack.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace ed
+{
+	AudioTrack::AudioTrack()
+	{
+		m_buffer = nullptr;
+		m_sound = nullptr;
+		m_music = nullptr;
+		m_file = nullptr;
+		m_windowStart = 0;
+	}
+	AudioTrack::~AudioTrack()
+	{
+		Stop();
+
+		delete m_sound;
+		delete m_buffer;
+		delete m_music;
+		delete m_file;
+	}
+	bool AudioTrack::ShouldStream(const sf::InputSoundFile& file)
+	{
+		return file.getDuration().asSeconds() >= AUDIO_STREAM_DURATION;
+	}
+	bool AudioTrack::Open(const std::string& path)
+	{
+		sf::InputSoundFile* file = new sf::InputSoundFile();
+		if (!file->openFromFile(path)) {
+			delete file;
+			return false;
+		}
+
+		if (!ShouldStream(*file)) {
+			std::vector<sf::Int16> samples(file->getSampleCount());
+			bool loaded = file->read(samples.data(), samples.size()) == samples.size() &&
+				Load(samples.data(), samples.size(), file->getChannelCount(), file->getSampleRate());
+			delete file;
+			return loaded;
+		}
+
+		sf::Music* music = new sf::Music();
+		if (!music->openFromFile(path)) {
+			delete music;
+			delete file;
+			return false;
+		}
+
+		m_music = music;
+		m_file = file;
+		m_path = path;
+		m_window.clear();
+		m_windowStart = 0;
+
+		return true;
+	}
+	bool AudioTrack::Load(const sf::Int16* samples, size_t sampleCount, unsigned int channels, unsigned int sampleRate)
+	{
+		sf::SoundBuffer* buffer = new sf::SoundBuffer();
+		if (!buffer->loadFromSamples(samples, sampleCount, channels, sampleRate)) {
+			delete buffer;
+			return false;
+		}
+
+		m_buffer = buffer;
+		m_sound = new sf::Sound();
+		m_sound->setBuffer(*m_buffer);
+
+		return true;
+	}
+	void AudioTrack::Play()
+	{
+		if (m_music != nullptr)
+			m_music->play();
+		else if (m_sound != nullptr)
+			m_sound->play();
+	}
+	void AudioTrack::Pause()
+	{
+		if (m_music != nullptr)
+			m_music->pause();
+		else if (m_sound != nullptr)
+			m_sound->pause();
+	}
+	void AudioTrack::Stop()
+	{
+		if (IsPlaying()) {
+			if (m_music != nullptr)
+				m_music->stop();
+			else
+				m_sound->stop();
+		}
+	}
+	bool AudioTrack::IsPlaying()
+	{
+		if (m_music != nullptr)
+			return m_music->getStatus() == sf::SoundSource::Playing;
+		return m_sound != nullptr && m_sound->getStatus() == sf::SoundSource::Playing;
+	}
+	void AudioTrack::SetLoop(bool loop)
+	{
+		if (m_music != nullptr)
+			m_music->setLoop(loop);
+		else if (m_sound != nullptr)
+			m_sound->setLoop(loop);
+	}
+	void AudioTrack::SetVolume(float volume)
+	{
+		if (m_music != nullptr)
+			m_music->setVolume(volume);
+		else if (m_sound != nullptr)
+			m_sound->setVolume(volume);
+	}
+	float AudioTrack::GetOffset()
+	{
+		if (m_music != nullptr)
+			return m_music->getPlayingOffset().asSeconds();
+		if (m_sound != nullptr)
+			return m_sound->getPlayingOffset().asSeconds();
+		return 0.0f;
+	}
+	void AudioTrack::SetOffset(float seconds)
+	{
+		if (m_music != nullptr)
+			m_music->setPlayingOffset(sf::seconds(seconds));
+		else if (m_sound != nullptr)
+			m_sound->setPlayingOffset(sf::seconds(seconds));
+	}
+	unsigned int AudioTrack::GetChannelCount()
+	{
+		if (m_file != nullptr)
+			return m_file->getChannelCount();
+		return m_buffer != nullptr ? m_buffer->getChannelCount() : 1;
+	}
+	unsigned int AudioTrack::GetSampleRate()
+	{
+		if (m_file != nullptr)
+			return m_file->getSampleRate();
+		return m_buffer != nullptr ? m_buffer->getSampleRate() : 44100;
+	}
+	sf::Uint64 AudioTrack::GetFrameCount()
+	{
+		if (m_file != nullptr)
+			return m_file->getSampleCount() / GetChannelCount();
+		return m_buffer != nullptr ? m_buffer->getSampleCount() / GetChannelCount() : 0;
+	}
+	float AudioTrack::GetDuration()
+	{
+		if (m_file != nullptr)
+			return m_file->getDuration().asSeconds();
+		return m_buffer != nullptr ? m_buffer->getDuration().asSeconds() : 0.0f;
+	}
+	size_t AudioTrack::GetMemory()
+	{
+		if (m_buffer != nullptr)
+			return m_buffer->getSampleCount() * sizeof(sf::Int16);
+		return m_window.capacity() * sizeof(sf::Int16);
+	}
+	const sf::Int16* AudioTrack::GetSamples(sf::Uint64 frame, int& count)
+	{
+		unsigned int channels = GetChannelCount();
+		sf::Uint64 frames = GetFrameCount();
+		if (frame >= frames) {
+			count = 0;
+			return nullptr;
+		}
+		count = (int)std::min<sf::Uint64>(count, frames - frame);
+
+		if (m_buffer != nullptr)
+			return m_buffer->getSamples() + frame * channels;
+		if (m_file == nullptr)
+			return nullptr;
+
+		sf::Uint64 windowFrames = m_window.size() / channels;
+		if (frame >= m_windowStart && frame + count <= m_windowStart + windowFrames)
+			return m_window.data() + (frame - m_windowStart) * channels;
+
+		// playing forward - the samples after the playhead are kept & the decoder continues where it stopped,
+		// anything else (seeking, looping) moves the decoder
+		size_t keep = 0;
+		if (frame >= m_windowStart && frame < m_windowStart + windowFrames) {
+			keep = (m_windowStart + windowFrames - frame) * channels;
+			std::copy(m_window.end() - keep, m_window.end(), m_window.begin());
+		} else
+			m_file->seek(frame * channels);
+
+		size_t size = std::max<size_t>((size_t)GetSampleRate() * AUDIO_STREAM_WINDOW, count) * channels;
+		m_window.resize(size);
+		size_t read = (size_t)m_file->read(m_window.data() + keep, size - keep);
+		m_window.resize(keep + read);
+		m_windowStart = frame;
+
+		count = std::min<int>(count, (int)(m_window.size() / channels));
+		return count > 0 ? m_window.data() : nullptr;
+	}
+	bool AudioTrack::ReadTrack(int rate, std::vector<float>& out)
+	{
+		unsigned int channels = GetChannelCount();
+		sf::Uint64 frames = GetFrameCount();
+		size_t step = rate > 0 ? std::max<size_t>(GetSampleRate() / rate, 1) : 1;
+
+		out.clear();
+		out.reserve((size_t)(frames / step) + 1);
+
+		float peak = 0.0f;
+		size_t inStep = 0;
+		auto add = [&](const sf::Int16* samples, size_t count) {
+			for (size_t i = 0; i + channels <= count; i += channels) {
+				float sum = 0.0f;
+				for (unsigned int c = 0; c < channels; c++)
+					sum += samples[i + c];
+				float value = sum / (channels * (float)INT16_MAX);
+
+				if (rate <= 0) {
+					out.push_back(value);
+					continue;
+				}
+
+				peak = std::max(peak, std::abs(value));
+				if (++inStep == step) {
+					out.push_back(std::min(peak, 1.0f));
+					peak = 0.0f;
+					inStep = 0;
+				}
+			}
+		};
+
+		if (m_buffer != nullptr)
+			add(m_buffer->getSamples(), (size_t)m_buffer->getSampleCount());
+		else if (m_file != nullptr) {
+			// the window of the playing decoder stays where it is
+			sf::InputSoundFile file;
+			if (!file.openFromFile(m_path))
+				return false;
+
+			std::vector<sf::Int16> chunk((size_t)GetSampleRate() * channels);
+			sf::Uint64 read = 0;
+			while ((read = file.read(chunk.data(), chunk.size())) > 0)
+				add(chunk.data(), (size_t)read);
+		} else
+			return false;
+
+		if (inStep > 0)
+			out.push_back(std::min(peak, 1.0f));
+
+		return !out.empty();
+	}
+}
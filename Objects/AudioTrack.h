@@ -0,0 +1,63 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include <SFML/Audio/InputSoundFile.hpp>
+#include <SFML/Audio/Music.hpp>
+#include <SFML/Audio/Sound.hpp>
+#include <SFML/Audio/SoundBuffer.hpp>
+
+#define AUDIO_STREAM_DURATION 600.0f // seconds, longer tracks are decoded while they play instead of being loaded at once
+#define AUDIO_STREAM_WINDOW 2		 // seconds of samples that are decoded ahead of the playhead of a streamed track
+
+namespace ed
+{
+	// player of an audio object - short tracks are decoded into a sf::SoundBuffer, long ones are played from the
+	// file by sf::Music while a second decoder keeps a window of samples after the playhead for the FFT & the waveform
+	class AudioTrack
+	{
+	public:
+		AudioTrack();
+		~AudioTrack();
+
+		static bool ShouldStream(const sf::InputSoundFile& file);
+
+		bool Open(const std::string& path); // streams the long files
+		bool Load(const sf::Int16* samples, size_t sampleCount, unsigned int channels, unsigned int sampleRate);
+
+		void Play();
+		void Pause();
+		void Stop();
+		bool IsPlaying();
+		void SetLoop(bool loop);
+		void SetVolume(float volume); // 0 - 100
+
+		float GetOffset(); // seconds
+		void SetOffset(float seconds);
+
+		inline bool IsStreamed() { return m_music != nullptr; }
+		unsigned int GetChannelCount();
+		unsigned int GetSampleRate();
+		sf::Uint64 GetFrameCount(); // samples per channel
+		float GetDuration(); // seconds
+		size_t GetMemory(); // bytes of decoded samples
+
+		// interleaved samples from the given frame, count = frames that are needed & that can be read from the
+		// returned pointer - it stays valid until the next call
+		const sf::Int16* GetSamples(sf::Uint64 frame, int& count);
+
+		// whole track mixed down to mono - rate = 0: every sample in [-1, 1], otherwise the peak of each 1/rate
+		// seconds in [0, 1]; streamed tracks are decoded from the file by a separate decoder
+		bool ReadTrack(int rate, std::vector<float>& out);
+
+	private:
+		sf::SoundBuffer* m_buffer;
+		sf::Sound* m_sound;
+
+		sf::Music* m_music;
+		std::string m_path;
+		sf::InputSoundFile* m_file;
+		std::vector<sf::Int16> m_window;
+		sf::Uint64 m_windowStart; // frame of m_window[0]
+	};
+}
@@ -4,6 +4,7 @@ namespace ed
 {
 	std::vector<std::string> CameraSnapshots::Names = std::vector<std::string>();
 	std::vector<glm::mat4> CameraSnapshots::Matrices = std::vector<glm::mat4>();
+	unsigned int CameraSnapshots::Generation = 0;
 
 	glm::mat4 CameraSnapshots::Get(const std::string& name)
 	{
@@ -18,6 +19,7 @@ namespace ed
 			if (Names[i] == name) {
 				Names.erase(Names.begin() + i);
 				Matrices.erase(Matrices.begin() + i);
+				Generation++;
 				break;
 			}
 	}
@@ -25,11 +27,13 @@ namespace ed
 	{
 		Names.push_back(name);
 		Matrices.push_back(mat);
+		Generation++;
 	}
 	void CameraSnapshots::Clear()
 	{
 		Names.clear();
 		Matrices.clear();
+		Generation++;
 	}
 	const std::vector<std::string>& CameraSnapshots::GetList()
 	{
@@ -19,5 +19,6 @@ namespace ed
 
 		static std::vector<std::string> Names;
 		static std::vector<glm::mat4> Matrices;
+		static unsigned int Generation; // changes whenever a snapshot is added or removed
 	};
 }
\ No newline at end of file
@@ -0,0 +1,14 @@
+#pragma once
+#include <glm/glm.hpp>
+
+namespace ed
+{
+	// blue (0) -> green -> red (1)
+	inline glm::vec3 GetHeatmapColor(float t)
+	{
+		t = glm::clamp(t, 0.0f, 1.0f);
+		if (t < 0.5f)
+			return glm::mix(glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f), t * 2.0f);
+		return glm::mix(glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), t * 2.0f - 1.0f);
+	}
+}
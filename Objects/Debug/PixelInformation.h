@@ -19,6 +19,8 @@ namespace ed
 			RenderTextureIndex = 0;
 			InstanceID = 0;
 			VertexID = 0;
+			for (int i = 0; i < 3; i++)
+				ClipPosition[i] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
 		}
 		glm::vec4 Color; // actual pixel color
 		glm::vec4 DebuggerColor; // Color generated by the debugger - this way users can see if the ShaderDebugger is executing code correctly... going to leave this here until I improve ShaderDebugger
@@ -40,5 +42,6 @@ namespace ed
 		int VertexCount; // 1 for point, 2 for line, 3 for triangle, etc...
 		eng::Model::Mesh::Vertex Vertex[3]; // vertices that are responsible for this pixel
 		std::unordered_map<std::string, bv_variable> VertexShaderOutput[3];
+		glm::vec4 ClipPosition[3]; // gl_Position/SV_Position of the vertices, read from VertexShaderOutput once
 	};
 }
\ No newline at end of file
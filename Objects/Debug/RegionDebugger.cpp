@@ -0,0 +1,260 @@
+#include "RegionDebugger.h"
+#include "Heatmap.h"
+#include <ShaderDebugger/Utils.h>
+#include <algorithm>
+#include <limits>
+#include <mutex>
+
+#define REGION_MAX_WORKERS 8 // every worker keeps its own copy of the bound textures
+
+namespace ed
+{
+	RegionDebugger::Job::~Job()
+	{
+		for (auto& px : Pixels)
+			for (int i = 0; i < 3; i++)
+				for (auto& out : px.VertexShaderOutput[i])
+					bv_variable_deinitialize(&out.second);
+	}
+
+	RegionDebugger::RegionDebugger(ObjectManager* objs, RenderEngine* renderer, DebugInformation* debugger)
+		: m_pool(eng::JobPriority::Interactive)
+	{
+		m_objs = objs;
+		m_renderer = renderer;
+		m_debugger = debugger;
+
+		m_tex = 0;
+		m_rect = glm::ivec4(0);
+		m_targetSize = glm::ivec2(1);
+		m_range = glm::vec2(0.0f);
+		m_mode = Mode::Output;
+		m_visible = true;
+
+		m_lineOwner = nullptr;
+		m_linePixels = 0;
+	}
+	RegionDebugger::~RegionDebugger()
+	{
+		Clear();
+	}
+	bool RegionDebugger::Start(PixelInformation& pixel, ed::ShaderLanguage lang, const std::string& entry, const std::string& src, glm::ivec2 targetSize, int size, Mode mode, const std::string& watch)
+	{
+		Cancel();
+		m_error = "";
+
+		if (!pixel.Fetched || pixel.VertexCount != 3) {
+			m_error = "Fetch the pixel before debugging the area around it.";
+			return false;
+		}
+		if (mode == Mode::Watch && watch.empty()) {
+			m_error = "Enter the expression that should be evaluated for each pixel.";
+			return false;
+		}
+
+		std::shared_ptr<Job> job = std::make_shared<Job>();
+		job->Type = mode;
+		job->Watch = watch;
+		job->Owner = pixel.Owner;
+		job->TargetSize = glm::max(targetSize, glm::ivec2(1));
+		job->RowsDone = 0;
+		job->Cancel = false;
+		job->Scalar = false;
+
+		// block centered around the pixel, clipped to the render target
+		glm::ivec2 rectStart = glm::clamp(pixel.Coordinate - size / 2, glm::ivec2(0), job->TargetSize - 1);
+		glm::ivec2 rectEnd = glm::min(rectStart + size, job->TargetSize);
+		job->Rect = glm::ivec4(rectStart, rectEnd - rectStart);
+
+		job->Values.resize(job->Rect.z * job->Rect.w, glm::vec4(0.0f));
+		job->Covered.resize(job->Rect.z * job->Rect.w, 0);
+
+		int workerCount = std::max<int>(1, std::min<int>(std::min<int>(m_pool.GetThreadCount(), REGION_MAX_WORKERS), job->Rect.w));
+
+		// the worker VMs are set up here since the uniforms and textures are read from the GPU
+		job->Pixels.resize(workerCount);
+		job->LineSteps.resize(mode == Mode::Steps ? workerCount : 0);
+		for (int i = 0; i < workerCount; i++) {
+			PixelInformation& px = job->Pixels[i];
+			px = pixel;
+			for (int v = 0; v < 3; v++)
+				for (auto& out : px.VertexShaderOutput[v])
+					out.second = bv_variable_copy(out.second);
+
+			DebugInformation* dbg = new DebugInformation(m_objs, m_renderer);
+			job->Workers.push_back(std::unique_ptr<DebugInformation>(dbg));
+
+			if (!dbg->SetSource(lang, sd::ShaderType::Pixel, entry, src)) {
+				m_error = dbg->Engine->GetLastError();
+				return false;
+			}
+
+			dbg->SetVertexOutputDescription(m_debugger->GetVertexOutputDescription());
+			dbg->InitEngine(px);
+		}
+
+		m_job = job;
+		for (int i = 0; i < workerCount; i++)
+			m_pool.Add([job, i]() { m_run(job, i); });
+
+		return true;
+	}
+	void RegionDebugger::Cancel()
+	{
+		if (m_job != nullptr) {
+			m_job->Cancel = true;
+			m_job = nullptr;
+		}
+	}
+	void RegionDebugger::Clear()
+	{
+		Cancel();
+
+		if (m_tex != 0) {
+			glDeleteTextures(1, &m_tex);
+			m_tex = 0;
+		}
+
+		m_lineSteps.clear();
+		m_lineOwner = nullptr;
+		m_linePixels = 0;
+	}
+	void RegionDebugger::Update()
+	{
+		if (m_job == nullptr || m_job->RowsDone < m_job->Rect.w)
+			return;
+
+		std::shared_ptr<Job> job = m_job;
+		m_job = nullptr;
+
+		m_mode = job->Type;
+		m_rect = job->Rect;
+		m_targetSize = job->TargetSize;
+
+		// the workers counted their own rows
+		if (job->Type == Mode::Steps) {
+			m_lineSteps.clear();
+			for (const auto& steps : job->LineSteps) {
+				if (steps.size() > m_lineSteps.size())
+					m_lineSteps.resize(steps.size(), 0);
+				for (size_t i = 0; i < steps.size(); i++)
+					m_lineSteps[i] += steps[i];
+			}
+			m_lineOwner = job->Owner;
+			m_linePixels = std::count(job->Covered.begin(), job->Covered.end(), 1);
+		}
+
+		// scalars are shown as a heatmap over the range found in this block
+		bool heatmap = job->Type == Mode::Steps || job->Scalar;
+		m_range = glm::vec2(std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity());
+		for (size_t i = 0; i < job->Values.size(); i++)
+			if (job->Covered[i]) {
+				m_range.x = std::min<float>(m_range.x, job->Values[i].x);
+				m_range.y = std::max<float>(m_range.y, job->Values[i].x);
+			}
+		if (m_range.x > m_range.y)
+			m_range = glm::vec2(0.0f);
+
+		std::vector<unsigned char> data(job->Values.size() * 4, 0);
+		for (size_t i = 0; i < job->Values.size(); i++) {
+			if (!job->Covered[i])
+				continue;
+
+			glm::vec4 color = job->Values[i];
+			if (heatmap) {
+				float t = m_range.y > m_range.x ? (color.x - m_range.x) / (m_range.y - m_range.x) : 0.0f;
+				color = glm::vec4(GetHeatmapColor(t), 1.0f);
+			}
+			color = glm::clamp(color, glm::vec4(0.0f), glm::vec4(1.0f));
+
+			data[i * 4 + 0] = color.r * 255;
+			data[i * 4 + 1] = color.g * 255;
+			data[i * 4 + 2] = color.b * 255;
+			data[i * 4 + 3] = 255;
+		}
+
+		if (m_tex == 0) {
+			glGenTextures(1, &m_tex);
+			glBindTexture(GL_TEXTURE_2D, m_tex);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		} else
+			glBindTexture(GL_TEXTURE_2D, m_tex);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_rect.z, m_rect.w, 0, GL_RGBA, GL_UNSIGNED_BYTE, data.data());
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		m_visible = true;
+	}
+	void RegionDebugger::m_run(std::shared_ptr<Job> job, int worker)
+	{
+		static std::mutex immediateMutex;
+
+		DebugInformation* dbg = job->Workers[worker].get();
+		int workerCount = job->Workers.size();
+
+		for (int y = worker; y < job->Rect.w && !job->Cancel; y += workerCount) {
+			for (int x = 0; x < job->Rect.z && !job->Cancel; x++) {
+				glm::ivec2 coord(job->Rect.x + x, job->Rect.y + y);
+				glm::vec2 rel = (glm::vec2(coord) + 0.5f) / glm::vec2(job->TargetSize);
+
+				// only the pixels covered by the fetched primitive have valid inputs
+				if (!dbg->SetPixelPosition(coord, rel))
+					continue;
+
+				size_t index = y * job->Rect.z + x;
+
+				if (job->Type == Mode::Steps) {
+					std::vector<unsigned int>& lines = job->LineSteps[worker];
+
+					int steps = 0;
+					while (!job->Cancel && dbg->Engine->Step()) {
+						int line = dbg->Engine->GetCurrentLine();
+						if (line >= 0) {
+							if (line >= lines.size())
+								lines.resize(line + 1, 0);
+							lines[line]++;
+						}
+						steps++;
+					}
+
+					job->Values[index] = glm::vec4((float)steps);
+				}
+				else {
+					dbg->Fetch();
+					if (dbg->Engine->IsDiscarded())
+						continue;
+
+					if (job->Type == Mode::Output)
+						job->Values[index] = job->Pixels[worker].DebuggerColor;
+					else {
+						// expressions go through the shader compiler which isn't guaranteed to be reentrant
+						bv_variable val;
+						{
+							std::lock_guard<std::mutex> lock(immediateMutex);
+							val = dbg->Engine->Immediate(job->Watch);
+						}
+						if (val.type == bv_type_uchar || val.type == bv_type_char) // branch taken -> green, not taken -> red
+							job->Values[index] = bv_variable_get_uchar(val) ? glm::vec4(0.0f, 1.0f, 0.0f, 1.0f) : glm::vec4(1.0f, 0.0f, 0.0f, 1.0f);
+						else if (val.type == bv_type_float) {
+							job->Values[index] = glm::vec4(bv_variable_get_float(val));
+							job->Scalar = true;
+						}
+						else if (bv_type_is_integer(val.type)) {
+							job->Values[index] = glm::vec4((float)bv_variable_get_int(val));
+							job->Scalar = true;
+						}
+						else if (val.type == bv_type_object)
+							job->Values[index] = sd::AsVector<4, float>(val);
+						bv_variable_deinitialize(&val);
+					}
+				}
+
+				job->Covered[index] = 1;
+			}
+
+			job->RowsDone++;
+		}
+	}
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../DebugInformation.h"
+#include "../../Engine/ThreadPool.h"
+
+namespace ed
+{
+	// runs the pixel shader in the debugger VM for a block of pixels around an already fetched pixel
+	// and stores the results in a texture that the preview draws on top of the render
+	class RegionDebugger
+	{
+	public:
+		enum class Mode
+		{
+			Output,	// color returned by the shader
+			Watch,	// value of an expression after the shader finishes (booleans -> green/red)
+			Steps	// number of steps the VM needed for the pixel, also summed up per source line
+		};
+
+		RegionDebugger(ObjectManager* objs, RenderEngine* renderer, DebugInformation* debugger);
+		~RegionDebugger();
+
+		// compiles the shader and reads the textures on the main thread, the VM runs on the workers
+		bool Start(PixelInformation& pixel, ed::ShaderLanguage lang, const std::string& entry, const std::string& src, glm::ivec2 targetSize, int size, Mode mode, const std::string& watch = "");
+		void Cancel();
+		void Clear();
+
+		// uploads the results once every row has been processed
+		void Update();
+
+		inline bool IsRunning() { return m_job != nullptr; }
+		inline float GetProgress() { return m_job == nullptr ? 1.0f : m_job->RowsDone / (float)m_job->Rect.w; }
+		inline const std::string& GetLastError() { return m_error; }
+
+		inline GLuint GetTexture() { return m_tex; }
+		inline const glm::ivec4& GetRect() { return m_rect; } // x, y, width, height in the target's pixels
+		inline const glm::ivec2& GetTargetSize() { return m_targetSize; }
+		inline const glm::vec2& GetRange() { return m_range; } // lowest and highest scalar value in the block
+		inline Mode GetMode() { return m_mode; }
+
+		inline bool IsVisible() { return m_visible && m_tex != 0; }
+		inline void SetVisible(bool visible) { m_visible = visible; }
+
+		// steps of the last Mode::Steps run per line of the pixel shader (index = the debugger's line, the same as the
+		// editor's breakpoints use), these stay until the next Steps run or Clear()
+		inline const std::vector<unsigned int>& GetLineSteps() { return m_lineSteps; }
+		inline PipelineItem* GetLineOwner() { return m_lineOwner; }
+		inline int GetLinePixels() { return m_linePixels; }
+
+	private:
+		struct Job
+		{
+			~Job();
+
+			Mode Type;
+			std::string Watch;
+			PipelineItem* Owner;
+			glm::ivec4 Rect;
+			glm::ivec2 TargetSize;
+
+			// each worker owns its VM and a copy of the pixel the VM points to
+			std::vector<std::unique_ptr<DebugInformation>> Workers;
+			std::vector<PixelInformation> Pixels;
+
+			std::vector<glm::vec4> Values;
+			std::vector<unsigned char> Covered;
+			std::vector<std::vector<unsigned int>> LineSteps; // [worker][line]
+
+			std::atomic<int> RowsDone;
+			std::atomic<bool> Cancel;
+			std::atomic<bool> Scalar; // watch expression returned a float/int
+		};
+
+		static void m_run(std::shared_ptr<Job> job, int worker);
+
+		ObjectManager* m_objs;
+		RenderEngine* m_renderer;
+		DebugInformation* m_debugger;
+
+		std::shared_ptr<Job> m_job;
+		std::string m_error;
+
+		GLuint m_tex;
+		glm::ivec4 m_rect;
+		glm::ivec2 m_targetSize;
+		glm::vec2 m_range;
+		Mode m_mode;
+		bool m_visible;
+
+		std::vector<unsigned int> m_lineSteps;
+		PipelineItem* m_lineOwner;
+		int m_linePixels;
+
+		eng::ThreadPool m_pool; // keep this last so that the workers stop before anything else is destroyed
+	};
+}
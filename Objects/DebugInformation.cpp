@@ -1,5 +1,7 @@
 #include "DebugInformation.h"
 #include "SystemVariableManager.h"
+#include "Hash.h"
+#include "ShaderTrace.h"
 #include <ShaderDebugger/HLSLCompiler.h>
 #include <ShaderDebugger/HLSLLibrary.h>
 #include <ShaderDebugger/GLSLCompiler.h>
@@ -220,6 +222,34 @@ namespace ed
 		m_argsFetch.capacity = 0;
 		m_argsFetch.data = nullptr;
 		m_isDebugging = false;
+
+		// an engine always exists, even before anything was compiled
+		CachedProgram empty;
+		empty.Key = 0;
+		empty.Engine = new sd::ShaderDebugger();
+		empty.LastUsed = 0;
+		m_programs.push_back(empty);
+		m_programClock = 0;
+		m_programKey = 0;
+		Engine = empty.Engine;
+	}
+	DebugInformation::~DebugInformation()
+	{
+		m_cleanTextures(sd::ShaderType::Vertex);
+		m_cleanTextures(sd::ShaderType::Pixel);
+		if (m_args.data != nullptr)
+			bv_stack_delete_memory(&m_args);
+		if (m_argsFetch.data != nullptr)
+			bv_stack_delete_memory(&m_argsFetch);
+		ClearWatchList();
+
+		for (CachedProgram& prog : m_programs)
+			delete prog.Engine;
+
+		for (VertexBatch& batch : m_vertexBatches)
+			for (int i = 0; i < 3; i++)
+				for (auto& out : batch.Outputs[i])
+					bv_variable_deinitialize(&out.second);
 	}
 	bool DebugInformation::SetSource(ed::ShaderLanguage lang, sd::ShaderType stage, const std::string& entry, const std::string& src)
 	{
@@ -229,52 +259,104 @@ namespace ed
 		m_stage = stage;
 		m_entry = entry;
 
+		uint64_t key = HashString(src, HashString(entry + ";" + std::to_string((int)lang) + ";" + std::to_string((int)stage)));
+		if (key == 0)
+			key = 1;
+
+		CachedProgram* cached = nullptr;
+		for (CachedProgram& prog : m_programs)
+			if (prog.Key == key)
+				cached = &prog;
+
+		bool compiled = cached != nullptr;
+		if (cached == nullptr) {
+			// reuse the engine of a failed compile or the least recently used one
+			if (m_programs.size() < DEBUG_PROGRAM_CACHE_SIZE) {
+				CachedProgram prog;
+				prog.Key = 0;
+				prog.Engine = new sd::ShaderDebugger();
+				prog.LastUsed = 0;
+				m_programs.push_back(prog);
+			}
+
+			cached = &m_programs[0];
+			for (CachedProgram& prog : m_programs) {
+				if (prog.Key == 0) {
+					cached = &prog;
+					break;
+				}
+				if (prog.LastUsed < cached->LastUsed)
+					cached = &prog;
+			}
+
+			// a fresh engine - nothing of the evicted program (globals, semantics) is left over
+			delete cached->Engine;
+			cached->Engine = new sd::ShaderDebugger();
+			cached->Key = 0;
+		}
+		cached->LastUsed = ++m_programClock;
+		Engine = cached->Engine;
+
 		if (lang == ed::ShaderLanguage::HLSL) {
-			ret = Engine.SetSource<sd::HLSLCompiler>(stage, src, entry, 0, m_libHLSL);
+			ret = compiled || Engine->SetSource<sd::HLSLCompiler>(stage, src, entry, 0, m_libHLSL);
 			
 			if (ret) {
 				if (stage == sd::ShaderType::Vertex) {
-					bv_variable svPosition = sd::Common::create_float4(Engine.GetProgram());
+					bv_variable svPosition = sd::Common::create_float4(Engine->GetProgram());
 					
-					Engine.SetSemanticValue("SV_VertexID", bv_variable_create_int(0));
-					Engine.SetSemanticValue("SV_Position", svPosition);
+					Engine->SetSemanticValue("SV_VertexID", bv_variable_create_int(0));
+					Engine->SetSemanticValue("SV_Position", svPosition);
 
 					bv_variable_deinitialize(&svPosition);
 				}
 				else if (stage == sd::ShaderType::Pixel) {
-					Engine.SetSemanticValue("SV_IsFrontFace", bv_variable_create_uchar(0));
+					Engine->SetSemanticValue("SV_IsFrontFace", bv_variable_create_uchar(0));
 				}
 			}
 		}
 		else {
-			ret = Engine.SetSource<sd::GLSLCompiler>(stage, src, entry, 0, m_libGLSL);
+			// the VM doesn't know about the trace buffer, the lines stay the same
+			std::string code = src;
+			if (!compiled)
+				ShaderTrace::Strip(code);
+
+			ret = compiled || Engine->SetSource<sd::GLSLCompiler>(stage, code, entry, 0, m_libGLSL);
 
 			// TODO: check if built-in variables have been redeclared
 			// TODO: add other variables too
 			if (ret) {
 				if (stage == sd::ShaderType::Vertex) {
-					Engine.AddGlobal("gl_VertexID");
-					Engine.SetGlobalValue("gl_VertexID", bv_variable_create_int(0));
-
-					Engine.AddGlobal("gl_InstanceID");
-					Engine.SetGlobalValue("gl_InstanceID", bv_variable_create_int(0));
-
-					Engine.AddGlobal("gl_Position");
-					Engine.SetGlobalValue("gl_Position", "vec4", glm::vec4(0.0f));
+					if (!compiled) {
+						Engine->AddGlobal("gl_VertexID");
+						Engine->AddGlobal("gl_InstanceID");
+						Engine->AddGlobal("gl_Position");
+					}
+					Engine->SetGlobalValue("gl_VertexID", bv_variable_create_int(0));
+					Engine->SetGlobalValue("gl_InstanceID", bv_variable_create_int(0));
+					Engine->SetGlobalValue("gl_Position", "vec4", glm::vec4(0.0f));
 				}
 				else if (stage == sd::ShaderType::Pixel) {
-					Engine.AddGlobal("gl_FragCoord");
-					Engine.SetGlobalValue("gl_FragCoord", "vec4", glm::vec4(0.0f));
-
-					Engine.AddGlobal("gl_FrontFacing");
-					Engine.SetGlobalValue("gl_FrontFacing", bv_variable_create_uchar(0));
+					if (!compiled) {
+						Engine->AddGlobal("gl_FragCoord");
+						Engine->AddGlobal("gl_FrontFacing");
+					}
+					Engine->SetGlobalValue("gl_FragCoord", "vec4", glm::vec4(0.0f));
+					Engine->SetGlobalValue("gl_FrontFacing", bv_variable_create_uchar(0));
 				}
 			}
 		}
 
+		if (ret)
+			cached->Key = key;
+		m_programKey = ret ? key : 0;
+
 		return ret;
 	}
 	glm::vec2 DebugInformation::GetVertexScreenPosition(PixelInformation& pixel, int id)
+	{
+		return getScreenCoord(pixel.ClipPosition[id]);
+	}
+	glm::vec4 DebugInformation::m_getClipPosition(PixelInformation& pixel, int id)
 	{
 		/* INPUTS */
 		// look for arguments when using HLSL
@@ -302,14 +384,123 @@ namespace ed
 				glPos = sd::AsVector<4, float>(obj->prop[posInd]);
 			}
 
-			return getScreenCoord(glPos);
+			return glPos;
 		}
 		// look for global variables when using GLSL
-		else {
-			glm::vec4 glPos = sd::AsVector<4, float>(pixel.VertexShaderOutput[id]["gl_Position"]);
+		else
+			return sd::AsVector<4, float>(pixel.VertexShaderOutput[id]["gl_Position"]);
+	}
+	uint64_t DebugInformation::m_getVertexBatchKey(PixelInformation& pixel)
+	{
+		int count = std::max(pixel.VertexCount, 1);
+		int vertexBase = (pixel.VertexID / count) * count;
+
+		uint64_t key = HashData(&m_programKey, sizeof(m_programKey));
+		key = HashData(&pixel.Object, sizeof(pixel.Object), key);
+		key = HashData(&vertexBase, sizeof(vertexBase), key);
+		key = HashData(&pixel.InstanceID, sizeof(pixel.InstanceID), key);
+
+		// the vertices are read from the GPU again for every fetch
+		for (int i = 0; i < 3; i++) {
+			const eng::Model::Mesh::Vertex& vert = pixel.Vertex[i];
+			key = HashData(glm::value_ptr(vert.Position), sizeof(glm::vec3), key);
+			key = HashData(glm::value_ptr(vert.Normal), sizeof(glm::vec3), key);
+			key = HashData(glm::value_ptr(vert.TexCoords), sizeof(glm::vec2), key);
+			key = HashData(glm::value_ptr(vert.Tangent), sizeof(glm::vec3), key);
+			key = HashData(glm::value_ptr(vert.Binormal), sizeof(glm::vec3), key);
+			key = HashData(glm::value_ptr(vert.Color), sizeof(glm::vec4), key);
+		}
+
+		// the transform of the object goes into the system variables
+		if (pixel.Object->Type == PipelineItem::ItemType::Geometry) {
+			pipe::GeometryItem* geo = (pipe::GeometryItem*)pixel.Object->Data;
+			key = HashData(glm::value_ptr(geo->Position), sizeof(glm::vec3), key);
+			key = HashData(glm::value_ptr(geo->Rotation), sizeof(glm::vec3), key);
+			key = HashData(glm::value_ptr(geo->Scale), sizeof(glm::vec3), key);
+		} else if (pixel.Object->Type == PipelineItem::ItemType::Model) {
+			pipe::Model* mdl = (pipe::Model*)pixel.Object->Data;
+			key = HashData(glm::value_ptr(mdl->Position), sizeof(glm::vec3), key);
+			key = HashData(glm::value_ptr(mdl->Rotation), sizeof(glm::vec3), key);
+			key = HashData(glm::value_ptr(mdl->Scale), sizeof(glm::vec3), key);
+		}
 
-			return getScreenCoord(glPos);
+		// values that the variables had in the last frame & the ones that this item overrides
+		pipe::ShaderPass* pass = (pipe::ShaderPass*)pixel.Owner->Data;
+		for (ShaderVariable* var : pass->Variables.GetVariables())
+			key = HashData(var->Data, ShaderVariable::GetSize(var->GetType()), key);
+
+		auto& itemVarValues = m_renderer->GetItemVariableValues();
+		for (const auto& itemVar : itemVarValues)
+			if (itemVar.Item == pixel.Object)
+				key = HashData(itemVar.NewValue->Data, ShaderVariable::GetSize(itemVar.NewValue->GetType()), key);
+
+		return key;
+	}
+	bool DebugInformation::RunVertexStage(PixelInformation& pixel)
+	{
+		if (m_stage != sd::ShaderType::Vertex || m_programKey == 0)
+			return false;
+
+		int count = std::min(std::max(pixel.VertexCount, 1), 3);
+		uint64_t key = m_getVertexBatchKey(pixel);
+
+		for (int i = 0; i < 3; i++) {
+			for (auto& out : pixel.VertexShaderOutput[i])
+				bv_variable_deinitialize(&out.second);
+			pixel.VertexShaderOutput[i].clear();
+		}
+
+		for (VertexBatch& batch : m_vertexBatches) {
+			if (batch.Key != key)
+				continue;
+
+			for (int i = 0; i < 3; i++) {
+				for (const auto& out : batch.Outputs[i])
+					pixel.VertexShaderOutput[i][out.first] = bv_variable_copy(out.second);
+				pixel.ClipPosition[i] = batch.ClipPosition[i];
+			}
+			m_vsOutput = batch.Description;
+			batch.LastUsed = ++m_programClock;
+
+			return true;
+		}
+
+		// the whole primitive in one go
+		for (int i = 0; i < count; i++) {
+			InitEngine(pixel, i);
+			Fetch(i);
 		}
+		for (int i = 0; i < count; i++)
+			pixel.ClipPosition[i] = m_getClipPosition(pixel, i);
+
+		// keep a copy for the next pixel
+		VertexBatch* slot = nullptr;
+		if (m_vertexBatches.size() < DEBUG_VERTEX_CACHE_SIZE) {
+			m_vertexBatches.push_back(VertexBatch());
+			slot = &m_vertexBatches.back();
+		} else {
+			slot = &m_vertexBatches[0];
+			for (VertexBatch& batch : m_vertexBatches)
+				if (batch.LastUsed < slot->LastUsed)
+					slot = &batch;
+
+			for (int i = 0; i < 3; i++) {
+				for (auto& out : slot->Outputs[i])
+					bv_variable_deinitialize(&out.second);
+				slot->Outputs[i].clear();
+			}
+		}
+
+		slot->Key = key;
+		for (int i = 0; i < 3; i++) {
+			for (const auto& out : pixel.VertexShaderOutput[i])
+				slot->Outputs[i][out.first] = bv_variable_copy(out.second);
+			slot->ClipPosition[i] = pixel.ClipPosition[i];
+		}
+		slot->Description = m_vsOutput;
+		slot->LastUsed = ++m_programClock;
+
+		return true;
 	}
 	void DebugInformation::InitEngine(PixelInformation& pixel, int id)
 	{
@@ -361,7 +552,7 @@ namespace ed
 		pass->Variables.Bind(pixel.Object);
 
 		/* UNIFORMS */
-		const auto& globals = Engine.GetCompiler()->GetGlobals();
+		const auto& globals = Engine->GetCompiler()->GetGlobals();
 		const auto& passUniforms = pass->Variables.GetVariables();
 		const std::vector<GLuint>& srvs = m_objs->GetBindList(pixel.Owner);
 		int samplerId = 0;
@@ -398,7 +589,7 @@ namespace ed
 						glBindTexture(GL_TEXTURE_2D, 0);
 
 						// set and cache
-						Engine.SetGlobalValue(glob.Name, glob.Type, tex);
+						Engine->SetGlobalValue(glob.Name, glob.Type, tex);
 						m_textures[m_stage].push_back(tex);
 					}
 
@@ -442,7 +633,7 @@ namespace ed
 						glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
 
 						// set and cache
-						Engine.SetGlobalValue(glob.Name, glob.Type, cube);
+						Engine->SetGlobalValue(glob.Name, glob.Type, cube);
 						m_cubemaps[m_stage].push_back(cube);
 					}
 
@@ -456,22 +647,22 @@ namespace ed
 							bv_variable varValue;
 							switch (valType) {
 							case ShaderVariable::ValueType::Boolean1: varValue = bv_variable_create_uchar(var->AsBoolean()); break;
-							case ShaderVariable::ValueType::Boolean2: varValue = sd::Common::create_bool2(Engine.GetProgram(), glm::make_vec2<bool>(var->AsBooleanPtr())); break;
-							case ShaderVariable::ValueType::Boolean3: varValue = sd::Common::create_bool3(Engine.GetProgram(), glm::make_vec3<bool>(var->AsBooleanPtr())); break;
-							case ShaderVariable::ValueType::Boolean4: varValue = sd::Common::create_bool4(Engine.GetProgram(), glm::make_vec4<bool>(var->AsBooleanPtr())); break;
+							case ShaderVariable::ValueType::Boolean2: varValue = sd::Common::create_bool2(Engine->GetProgram(), glm::make_vec2<bool>(var->AsBooleanPtr())); break;
+							case ShaderVariable::ValueType::Boolean3: varValue = sd::Common::create_bool3(Engine->GetProgram(), glm::make_vec3<bool>(var->AsBooleanPtr())); break;
+							case ShaderVariable::ValueType::Boolean4: varValue = sd::Common::create_bool4(Engine->GetProgram(), glm::make_vec4<bool>(var->AsBooleanPtr())); break;
 							case ShaderVariable::ValueType::Integer1: varValue = bv_variable_create_int(var->AsInteger()); break;
-							case ShaderVariable::ValueType::Integer2: varValue = sd::Common::create_int2(Engine.GetProgram(), glm::make_vec2<int>(var->AsIntegerPtr())); break;
-							case ShaderVariable::ValueType::Integer3: varValue = sd::Common::create_int3(Engine.GetProgram(), glm::make_vec3<int>(var->AsIntegerPtr())); break;
-							case ShaderVariable::ValueType::Integer4: varValue = sd::Common::create_int4(Engine.GetProgram(), glm::make_vec4<int>(var->AsIntegerPtr())); break;
+							case ShaderVariable::ValueType::Integer2: varValue = sd::Common::create_int2(Engine->GetProgram(), glm::make_vec2<int>(var->AsIntegerPtr())); break;
+							case ShaderVariable::ValueType::Integer3: varValue = sd::Common::create_int3(Engine->GetProgram(), glm::make_vec3<int>(var->AsIntegerPtr())); break;
+							case ShaderVariable::ValueType::Integer4: varValue = sd::Common::create_int4(Engine->GetProgram(), glm::make_vec4<int>(var->AsIntegerPtr())); break;
 							case ShaderVariable::ValueType::Float1: varValue = bv_variable_create_float(var->AsFloat()); break;
-							case ShaderVariable::ValueType::Float2: varValue = sd::Common::create_float2(Engine.GetProgram(), glm::make_vec2<float>(var->AsFloatPtr())); break;
-							case ShaderVariable::ValueType::Float3: varValue = sd::Common::create_float3(Engine.GetProgram(), glm::make_vec3<float>(var->AsFloatPtr())); break;
-							case ShaderVariable::ValueType::Float4: varValue = sd::Common::create_float4(Engine.GetProgram(), glm::make_vec4<float>(var->AsFloatPtr())); break;
-							case ShaderVariable::ValueType::Float2x2: varValue = sd::Common::create_mat(Engine.GetProgram(), m_lang == ed::ShaderLanguage::GLSL ? "mat2" : "float2x2", new sd::Matrix(glm::make_mat2x2(var->AsFloatPtr()), 2, 2)); break;
-							case ShaderVariable::ValueType::Float3x3: varValue = sd::Common::create_mat(Engine.GetProgram(), m_lang == ed::ShaderLanguage::GLSL ? "mat3" : "float3x3", new sd::Matrix(glm::make_mat3x3(var->AsFloatPtr()), 3, 3)); break;
-							case ShaderVariable::ValueType::Float4x4: varValue = sd::Common::create_mat(Engine.GetProgram(), m_lang == ed::ShaderLanguage::GLSL ? "mat4" : "float4x4", new sd::Matrix(glm::make_mat4x4(var->AsFloatPtr()), 4, 4)); break;
+							case ShaderVariable::ValueType::Float2: varValue = sd::Common::create_float2(Engine->GetProgram(), glm::make_vec2<float>(var->AsFloatPtr())); break;
+							case ShaderVariable::ValueType::Float3: varValue = sd::Common::create_float3(Engine->GetProgram(), glm::make_vec3<float>(var->AsFloatPtr())); break;
+							case ShaderVariable::ValueType::Float4: varValue = sd::Common::create_float4(Engine->GetProgram(), glm::make_vec4<float>(var->AsFloatPtr())); break;
+							case ShaderVariable::ValueType::Float2x2: varValue = sd::Common::create_mat(Engine->GetProgram(), m_lang == ed::ShaderLanguage::GLSL ? "mat2" : "float2x2", new sd::Matrix(glm::make_mat2x2(var->AsFloatPtr()), 2, 2)); break;
+							case ShaderVariable::ValueType::Float3x3: varValue = sd::Common::create_mat(Engine->GetProgram(), m_lang == ed::ShaderLanguage::GLSL ? "mat3" : "float3x3", new sd::Matrix(glm::make_mat3x3(var->AsFloatPtr()), 3, 3)); break;
+							case ShaderVariable::ValueType::Float4x4: varValue = sd::Common::create_mat(Engine->GetProgram(), m_lang == ed::ShaderLanguage::GLSL ? "mat4" : "float4x4", new sd::Matrix(glm::make_mat4x4(var->AsFloatPtr()), 4, 4)); break;
 							}
-							Engine.SetGlobalValue(glob.Name, varValue);
+							Engine->SetGlobalValue(glob.Name, varValue);
 
 							bv_variable_deinitialize(&varValue);
 
@@ -485,8 +676,8 @@ namespace ed
 		/* INPUTS */
 		// look for arguments when using HLSL
 		if (m_lang == ed::ShaderLanguage::HLSL) {
-			const auto& funcs = Engine.GetCompiler()->GetFunctions();
-			const auto& structs = Engine.GetCompiler()->GetStructures();
+			const auto& funcs = Engine->GetCompiler()->GetFunctions();
+			const auto& structs = Engine->GetCompiler()->GetStructures();
 			std::vector<sd::Variable> args;
 
 			for (const auto& f : funcs)
@@ -495,21 +686,11 @@ namespace ed
 					break;
 				}
 
-			if (m_args.data != nullptr) {
-				bv_stack_delete_memory(&m_args);
-				m_args.data = nullptr;
-			}
-			if (m_argsFetch.data != nullptr) {
-				bv_stack_delete_memory(&m_argsFetch);
-				m_argsFetch.data = nullptr;
-			}
-
-			m_args = bv_stack_create();
-			m_argsFetch = bv_stack_create();
+			m_resetArguments();
 
 			if (m_stage == sd::ShaderType::Vertex) {
-				Engine.SetSemanticValue("SV_VertexID", bv_variable_create_int(vertexBase + id));
-				Engine.SetSemanticValue("SV_InstanceID", bv_variable_create_int(m_pixel->InstanceID));
+				Engine->SetSemanticValue("SV_VertexID", bv_variable_create_int(vertexBase + id));
+				Engine->SetSemanticValue("SV_InstanceID", bv_variable_create_int(m_pixel->InstanceID));
 				
 				// setting instance buffer values
 				if (isInstanced && instanceBuffer != nullptr) {
@@ -522,7 +703,8 @@ namespace ed
 					for (int i = 0; i < bufFormatList.size(); i++)
 						perRowSize += ShaderVariable::GetSize(bufFormatList[i]);
 
-					// update the data
+					// update the data - GPU only buffers get a CPU copy first
+					m_objs->FetchBufferData(instanceBuffer);
 					glBindBuffer(GL_SHADER_STORAGE_BUFFER, instanceBuffer->ID);
 					glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, instanceBuffer->Size, instanceBuffer->Data);
 					glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
@@ -540,8 +722,8 @@ namespace ed
 							for (int i = 0; i < str.Members.size(); i++) {
 								sd::Variable memb = str.Members[i];
 								if (!semanticExists(memb.Semantic, pass)) {
-									bv_variable varVal = fetchBufferElement(Engine.GetProgram(), m_lang, instanceBuffer->Data, bufFormatList[instItemIndex], m_pixel->InstanceID, perRowSize, instCurOffset);
-									Engine.SetSemanticValue(memb.Semantic, varVal);
+									bv_variable varVal = fetchBufferElement(Engine->GetProgram(), m_lang, instanceBuffer->Data, bufFormatList[instItemIndex], m_pixel->InstanceID, perRowSize, instCurOffset);
+									Engine->SetSemanticValue(memb.Semantic, varVal);
 									bv_variable_deinitialize(&varVal);
 
 									instCurOffset += ShaderVariable::GetSize(bufFormatList[instItemIndex]);
@@ -553,8 +735,8 @@ namespace ed
 						// vectors, scalars, etc..
 						else {
 							if (!semanticExists(arg.Semantic, pass)) {
-								bv_variable varVal = fetchBufferElement(Engine.GetProgram(), m_lang, instanceBuffer->Data, bufFormatList[instItemIndex], m_pixel->InstanceID, perRowSize, instCurOffset);
-								Engine.SetSemanticValue(arg.Semantic, varVal);
+								bv_variable varVal = fetchBufferElement(Engine->GetProgram(), m_lang, instanceBuffer->Data, bufFormatList[instItemIndex], m_pixel->InstanceID, perRowSize, instCurOffset);
+								Engine->SetSemanticValue(arg.Semantic, varVal);
 								bv_variable_deinitialize(&varVal);
 
 								instCurOffset += ShaderVariable::GetSize(bufFormatList[instItemIndex]);
@@ -568,7 +750,7 @@ namespace ed
 				for (const auto& arg : args) {
 					// structures
 					if (arg.Semantic.empty()) {
-						bv_variable varValue = bv_variable_create_object(bv_program_get_object_info(Engine.GetProgram(), arg.Type.c_str()));
+						bv_variable varValue = bv_variable_create_object(bv_program_get_object_info(Engine->GetProgram(), arg.Type.c_str()));
 						bv_object* varObj = bv_variable_get_object(varValue);
 
 						sd::Structure str;
@@ -580,7 +762,7 @@ namespace ed
 
 						for (int i = 0; i < str.Members.size(); i++) {
 							sd::Variable memb = str.Members[i];
-							varObj->prop[i] = applySemantic(&Engine, m_pixel, m_stage, memb.Semantic, memb.Type, id);
+							varObj->prop[i] = applySemantic(Engine, m_pixel, m_stage, memb.Semantic, memb.Type, id);
 						}
 
 						bv_stack_push(&m_argsFetch, bv_variable_copy(varValue));
@@ -588,99 +770,17 @@ namespace ed
 					}
 					// vectors, scalars, etc..
 					else {
-						bv_variable varValue = applySemantic(&Engine, m_pixel, m_stage, arg.Semantic, arg.Type, id);
+						bv_variable varValue = applySemantic(Engine, m_pixel, m_stage, arg.Semantic, arg.Type, id);
 
 						bv_stack_push(&m_argsFetch, bv_variable_copy(varValue));
 						bv_stack_push(&m_args, varValue);
 					}
 				}
 			}
-			else if (m_stage == sd::ShaderType::Pixel) {
-				// TODO: vertex count
-				glm::vec4 glPos[3];
-				bv_object* obj[3];
-
-				// getting objects and SV_Positions
-				int posInd = 0;
-				for (const auto& memb : m_vsOutput.Members) {
-					std::string smn = memb.Semantic;
-					std::transform(smn.begin(), smn.end(), smn.begin(), ::tolower);
-
-					if (smn == "sv_position")
-						break;
-					posInd++;
-				}
-				if (m_vsOutput.Name.empty())
-					posInd = -1;
-				for (int i = 0; i < m_pixel->VertexCount; i++) {
-					if (posInd == -1)
-						glPos[i] = sd::AsVector<4, float>(m_pixel->VertexShaderOutput[i]["return"]);
-					else {
-						obj[i] = bv_variable_get_object(m_pixel->VertexShaderOutput[i]["return"]);
-						glPos[i] = sd::AsVector<4, float>(obj[i]->prop[posInd]);
-					}
-				}
-
-				// weigths
-				glm::vec2 scrnPos1 = getScreenCoord(glPos[0]);
-				glm::vec2 scrnPos2 = getScreenCoord(glPos[1]);
-				glm::vec2 scrnPos3 = getScreenCoord(glPos[2]);
-				glm::vec3 weights = getWeights(scrnPos1, scrnPos2, scrnPos3, m_pixel->RelativeCoordinate);
-				weights *= glm::vec3(1.0f / glPos[0].w, 1.0f / glPos[1].w, 1.0f / glPos[2].w);
-
-				// setting semantics
-				int propId = 0;
-				for (const auto& memb : m_vsOutput.Members) {
-					bv_variable ival = memb.Flat ? obj[2]->prop[propId] : interpolateValues(Engine.GetProgram(), obj[0]->prop[propId], obj[1]->prop[propId], obj[2]->prop[propId], weights);
-					Engine.SetSemanticValue(memb.Semantic, ival);
-					bv_variable_deinitialize(&ival);
-					propId++;
-				}
-
-				// set sv_position (TODO: seems to be wrong values)
-				float f = 1.0f, n = 0.0f;
-				float interW = (glPos[0].w * weights.x + glPos[1].w * weights.y + glPos[2].w * weights.z) * (weights.x + weights.y + weights.z);
-				float interZ = (glPos[0].z * weights.x + glPos[1].z * weights.y + glPos[2].z * weights.z) * (weights.x + weights.y + weights.z);
-				float Zd = interZ / interW;
-				float Zw = n + Zd * (f-n);
-				bv_variable svPosVal = sd::Common::create_float4(Engine.GetProgram(), glm::vec4(m_pixel->Coordinate.x, m_pixel->Coordinate.y, Zw, interW));
-				Engine.SetSemanticValue("SV_Position", svPosVal);
-				bv_variable_deinitialize(&svPosVal);
-
-				if (m_pixel->VertexShaderOutput[0].count("return")) {
-					for (const auto& arg : args) {
-						// structures
-						if (arg.Semantic.empty()) {
-							bv_variable varValue = bv_variable_create_object(bv_program_get_object_info(Engine.GetProgram(), arg.Type.c_str()));
-							bv_object* varObj = bv_variable_get_object(varValue);
-
-							sd::Structure str;
-							for (const auto& s : structs)
-								if (s.Name == arg.Type) {
-									str = s;
-									break;
-								}
-
-							for (int i = 0; i < str.Members.size(); i++) {
-								sd::Variable memb = str.Members[i];
-								varObj->prop[i] = applySemantic(&Engine, m_pixel, m_stage, memb.Semantic, memb.Type, id);
-							}
-
-							bv_stack_push(&m_argsFetch, bv_variable_copy(varValue));
-							bv_stack_push(&m_args, varValue);
-						}
-						// vectors, scalars, etc..
-						else {
-							bv_variable varValue = applySemantic(&Engine, m_pixel, m_stage, arg.Semantic, arg.Type, id);
-
-							bv_stack_push(&m_argsFetch, bv_variable_copy(varValue));
-							bv_stack_push(&m_args, varValue);
-						}
-					}
-				}
-			}
+			else if (m_stage == sd::ShaderType::Pixel)
+				m_setPixelInputs(id);
 
-			Engine.SetArguments(&m_args);
+			Engine->SetArguments(&m_args);
 		}
 		// look for global variables when using GLSL
 		else {
@@ -690,7 +790,7 @@ namespace ed
 						if (glob.InputSlot < pass->InputLayout.size()) {
 							const InputLayoutItem& item = pass->InputLayout[glob.InputSlot];
 
-							bv_variable varValue = bv_variable_create_object(bv_program_get_object_info(Engine.GetProgram(), glob.Type.c_str()));
+							bv_variable varValue = bv_variable_create_object(bv_program_get_object_info(Engine->GetProgram(), glob.Type.c_str()));
 							bv_object* obj = bv_variable_get_object(varValue);
 
 							glm::vec4 inpValue(m_pixel->Vertex[id].Position, 1.0f);
@@ -705,7 +805,7 @@ namespace ed
 							for (int p = 0; p < obj->type->props.name_count; p++)
 								obj->prop[p] = bv_variable_create_float(inpValue[p]); // TODO: cast to int, etc...
 
-							Engine.SetGlobalValue(glob.Name, varValue);
+							Engine->SetGlobalValue(glob.Name, varValue);
 
 							bv_variable_deinitialize(&varValue);
 						}
@@ -722,84 +822,221 @@ namespace ed
 									instCurOffset = perRowSize;
 							}
 
-							// update the data
+							// update the data - GPU only buffers get a CPU copy first
+							m_objs->FetchBufferData(instanceBuffer);
 							glBindBuffer(GL_SHADER_STORAGE_BUFFER, instanceBuffer->ID);
 							glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, instanceBuffer->Size, instanceBuffer->Data);
 							glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 
-							bv_variable varVal = fetchBufferElement(Engine.GetProgram(), m_lang, instanceBuffer->Data, bufFormatList[fmtIndex], m_pixel->InstanceID, perRowSize, instCurOffset);
-							Engine.SetGlobalValue(glob.Name, varVal);
+							bv_variable varVal = fetchBufferElement(Engine->GetProgram(), m_lang, instanceBuffer->Data, bufFormatList[fmtIndex], m_pixel->InstanceID, perRowSize, instCurOffset);
+							Engine->SetGlobalValue(glob.Name, varVal);
 							bv_variable_deinitialize(&varVal);
 						}
 					}
 				}
 
-				Engine.SetGlobalValue("gl_VertexID", bv_variable_create_int(vertexBase + id));
-				Engine.SetGlobalValue("gl_InstanceID", bv_variable_create_int(m_pixel->InstanceID));
+				Engine->SetGlobalValue("gl_VertexID", bv_variable_create_int(vertexBase + id));
+				Engine->SetGlobalValue("gl_InstanceID", bv_variable_create_int(m_pixel->InstanceID));
 			}
-			else if (m_stage == sd::ShaderType::Pixel) {
-				glm::vec4 glPos1 = sd::AsVector<4, float>(m_pixel->VertexShaderOutput[0]["gl_Position"]);
-				glm::vec4 glPos2 = sd::AsVector<4, float>(m_pixel->VertexShaderOutput[1]["gl_Position"]);
-				glm::vec4 glPos3 = sd::AsVector<4, float>(m_pixel->VertexShaderOutput[2]["gl_Position"]);
+			else if (m_stage == sd::ShaderType::Pixel)
+				m_setPixelInputs(id);
+		}
 
-				glm::vec2 scrnPos1 = getScreenCoord(glPos1);
-				glm::vec2 scrnPos2 = getScreenCoord(glPos2);
-				glm::vec2 scrnPos3 = getScreenCoord(glPos3);
 
-				glm::vec3 weights = getWeights(scrnPos1, scrnPos2, scrnPos3, m_pixel->RelativeCoordinate);
-				weights *= glm::vec3(1.0f / glPos1.w, 1.0f / glPos2.w, 1.0f / glPos3.w);
-				
-				for (const auto& glob : globals) {
-					if (glob.Storage == sd::Variable::StorageType::In) {
-						if (m_pixel->VertexShaderOutput[0].count(glob.Name)) {
-							
-							// TODO: vertex count
-							bv_variable var1 = m_pixel->VertexShaderOutput[0][glob.Name];
-							bv_variable var2 = m_pixel->VertexShaderOutput[1][glob.Name];
-							bv_variable var3 = m_pixel->VertexShaderOutput[2][glob.Name];
 
-							// last vertex convention
-							bv_variable varValue = glob.Flat ? bv_variable_copy(var3) : interpolateValues(Engine.GetProgram(), var1, var2, var3, weights);
+		// return old values
+		if (pixel.Object->Type == PipelineItem::ItemType::Geometry || pixel.Object->Type == PipelineItem::ItemType::Model)
+			for (int k = 0; k < itemVarValues.size(); k++)
+				if (itemVarValues[k].Item == pixel.Object)
+					itemVarValues[k].Variable->Data = itemVarValues[k].OldValue;
+	}
+	void DebugInformation::m_setPixelInputs(int id)
+	{
+		// interpolated inputs and the fragment position - these only depend on m_pixel and the vertex shader output
+		if (m_lang == ed::ShaderLanguage::HLSL) {
+			const auto& funcs = Engine->GetCompiler()->GetFunctions();
+			const auto& structs = Engine->GetCompiler()->GetStructures();
+			std::vector<sd::Variable> args;
 
-							Engine.SetGlobalValue(glob.Name, varValue);
+			for (const auto& f : funcs)
+				if (f.Name == m_entry) {
+					args = f.Arguments;
+					break;
+				}
 
-							bv_variable_deinitialize(&varValue);
+			// TODO: vertex count
+			glm::vec4 glPos[3];
+			bv_object* obj[3];
+
+			// getting objects and SV_Positions
+			int posInd = 0;
+			for (const auto& memb : m_vsOutput.Members) {
+				std::string smn = memb.Semantic;
+				std::transform(smn.begin(), smn.end(), smn.begin(), ::tolower);
+
+				if (smn == "sv_position")
+					break;
+				posInd++;
+			}
+			if (m_vsOutput.Name.empty())
+				posInd = -1;
+			for (int i = 0; i < m_pixel->VertexCount; i++) {
+				glPos[i] = m_pixel->ClipPosition[i];
+				if (posInd != -1)
+					obj[i] = bv_variable_get_object(m_pixel->VertexShaderOutput[i]["return"]);
+			}
+
+			// weigths
+			glm::vec2 scrnPos1 = getScreenCoord(glPos[0]);
+			glm::vec2 scrnPos2 = getScreenCoord(glPos[1]);
+			glm::vec2 scrnPos3 = getScreenCoord(glPos[2]);
+			glm::vec3 weights = getWeights(scrnPos1, scrnPos2, scrnPos3, m_pixel->RelativeCoordinate);
+			weights *= glm::vec3(1.0f / glPos[0].w, 1.0f / glPos[1].w, 1.0f / glPos[2].w);
+
+			// setting semantics
+			int propId = 0;
+			for (const auto& memb : m_vsOutput.Members) {
+				bv_variable ival = memb.Flat ? obj[2]->prop[propId] : interpolateValues(Engine->GetProgram(), obj[0]->prop[propId], obj[1]->prop[propId], obj[2]->prop[propId], weights);
+				Engine->SetSemanticValue(memb.Semantic, ival);
+				bv_variable_deinitialize(&ival);
+				propId++;
+			}
+
+			// set sv_position (TODO: seems to be wrong values)
+			float f = 1.0f, n = 0.0f;
+			float interW = (glPos[0].w * weights.x + glPos[1].w * weights.y + glPos[2].w * weights.z) * (weights.x + weights.y + weights.z);
+			float interZ = (glPos[0].z * weights.x + glPos[1].z * weights.y + glPos[2].z * weights.z) * (weights.x + weights.y + weights.z);
+			float Zd = interZ / interW;
+			float Zw = n + Zd * (f-n);
+			bv_variable svPosVal = sd::Common::create_float4(Engine->GetProgram(), glm::vec4(m_pixel->Coordinate.x, m_pixel->Coordinate.y, Zw, interW));
+			Engine->SetSemanticValue("SV_Position", svPosVal);
+			bv_variable_deinitialize(&svPosVal);
+
+			if (m_pixel->VertexShaderOutput[0].count("return")) {
+				for (const auto& arg : args) {
+					// structures
+					if (arg.Semantic.empty()) {
+						bv_variable varValue = bv_variable_create_object(bv_program_get_object_info(Engine->GetProgram(), arg.Type.c_str()));
+						bv_object* varObj = bv_variable_get_object(varValue);
+
+						sd::Structure str;
+						for (const auto& s : structs)
+							if (s.Name == arg.Type) {
+								str = s;
+								break;
+							}
+
+						for (int i = 0; i < str.Members.size(); i++) {
+							sd::Variable memb = str.Members[i];
+							varObj->prop[i] = applySemantic(Engine, m_pixel, m_stage, memb.Semantic, memb.Type, id);
 						}
+
+						bv_stack_push(&m_argsFetch, bv_variable_copy(varValue));
+						bv_stack_push(&m_args, varValue);
+					}
+					// vectors, scalars, etc..
+					else {
+						bv_variable varValue = applySemantic(Engine, m_pixel, m_stage, arg.Semantic, arg.Type, id);
+
+						bv_stack_push(&m_argsFetch, bv_variable_copy(varValue));
+						bv_stack_push(&m_args, varValue);
 					}
 				}
+			}
+		}
+		else {
+			const auto& globals = Engine->GetCompiler()->GetGlobals();
 
-				// TODO: clip control
-				float f = 1.0f, n = 0.0f;
-				float s = (f - n) / 2;
-				float b = (f + n) / 2;
+			glm::vec4 glPos1 = m_pixel->ClipPosition[0];
+			glm::vec4 glPos2 = m_pixel->ClipPosition[1];
+			glm::vec4 glPos3 = m_pixel->ClipPosition[2];
+
+			glm::vec2 scrnPos1 = getScreenCoord(glPos1);
+			glm::vec2 scrnPos2 = getScreenCoord(glPos2);
+			glm::vec2 scrnPos3 = getScreenCoord(glPos3);
+
+			glm::vec3 weights = getWeights(scrnPos1, scrnPos2, scrnPos3, m_pixel->RelativeCoordinate);
+			weights *= glm::vec3(1.0f / glPos1.w, 1.0f / glPos2.w, 1.0f / glPos3.w);
+			
+			for (const auto& glob : globals) {
+				if (glob.Storage == sd::Variable::StorageType::In) {
+					if (m_pixel->VertexShaderOutput[0].count(glob.Name)) {
+						
+						// TODO: vertex count
+						bv_variable var1 = m_pixel->VertexShaderOutput[0][glob.Name];
+						bv_variable var2 = m_pixel->VertexShaderOutput[1][glob.Name];
+						bv_variable var3 = m_pixel->VertexShaderOutput[2][glob.Name];
 
-				float interW = (glPos1.w * weights.x + glPos2.w * weights.y + glPos3.w * weights.z) * (weights.x + weights.y + weights.z);
-				float interZ = (glPos1.z * weights.x + glPos2.z * weights.y + glPos3.z * weights.z) * (weights.x + weights.y + weights.z);
-				float Zd = interZ / interW;
-				float Zw = s * Zd + b;
-				Engine.SetGlobalValue("gl_FragCoord", "vec4", glm::vec4(m_pixel->Coordinate.x, m_pixel->Coordinate.y, Zw, interW));
+						// last vertex convention
+						bv_variable varValue = glob.Flat ? bv_variable_copy(var3) : interpolateValues(Engine->GetProgram(), var1, var2, var3, weights);
+
+						Engine->SetGlobalValue(glob.Name, varValue);
+
+						bv_variable_deinitialize(&varValue);
+					}
+				}
 			}
+
+			// TODO: clip control
+			float f = 1.0f, n = 0.0f;
+			float s = (f - n) / 2;
+			float b = (f + n) / 2;
+
+			float interW = (glPos1.w * weights.x + glPos2.w * weights.y + glPos3.w * weights.z) * (weights.x + weights.y + weights.z);
+			float interZ = (glPos1.z * weights.x + glPos2.z * weights.y + glPos3.z * weights.z) * (weights.x + weights.y + weights.z);
+			float Zd = interZ / interW;
+			float Zw = s * Zd + b;
+			Engine->SetGlobalValue("gl_FragCoord", "vec4", glm::vec4(m_pixel->Coordinate.x, m_pixel->Coordinate.y, Zw, interW));
 		}
+	}
+	bool DebugInformation::SetPixelPosition(glm::ivec2 coord, glm::vec2 rel)
+	{
+		if (m_pixel == nullptr || m_stage != sd::ShaderType::Pixel || m_pixel->VertexCount != 3)
+			return false;
 
+		// skip the pixels that the primitive doesn't cover
+		glm::vec3 weights = getWeights(GetVertexScreenPosition(*m_pixel, 0), GetVertexScreenPosition(*m_pixel, 1), GetVertexScreenPosition(*m_pixel, 2), rel);
+		if (weights.x < -1e-4f || weights.y < -1e-4f || weights.z < -1e-4f)
+			return false;
 
+		m_pixel->Coordinate = coord;
+		m_pixel->RelativeCoordinate = rel;
 
-		// return old values
-		if (pixel.Object->Type == PipelineItem::ItemType::Geometry || pixel.Object->Type == PipelineItem::ItemType::Model)
-			for (int k = 0; k < itemVarValues.size(); k++)
-				if (itemVarValues[k].Item == pixel.Object)
-					itemVarValues[k].Variable->Data = itemVarValues[k].OldValue;
+		if (m_lang == ed::ShaderLanguage::HLSL) {
+			m_resetArguments();
+			m_setPixelInputs();
+			Engine->SetArguments(&m_args);
+		}
+		else
+			m_setPixelInputs();
+
+		return true;
+	}
+	void DebugInformation::m_resetArguments()
+	{
+		if (m_args.data != nullptr) {
+			bv_stack_delete_memory(&m_args);
+			m_args.data = nullptr;
+		}
+		if (m_argsFetch.data != nullptr) {
+			bv_stack_delete_memory(&m_argsFetch);
+			m_argsFetch.data = nullptr;
+		}
+
+		m_args = bv_stack_create();
+		m_argsFetch = bv_stack_create();
 	}
 	void DebugInformation::Fetch(int id)
 	{
-		bv_variable returnValue = Engine.Execute(m_entry, &m_argsFetch);
+		bv_variable returnValue = Engine->Execute(m_entry, &m_argsFetch);
 
 		if (m_stage == sd::ShaderType::Vertex) {
 			if (m_lang == ed::ShaderLanguage::HLSL) {
 				m_pixel->VertexShaderOutput[id]["return"] = bv_variable_copy(returnValue);
 
 				// cache the output structure description
-				const auto& structs = Engine.GetCompiler()->GetStructures();
-				const auto& funcs = Engine.GetCompiler()->GetFunctions();
+				const auto& structs = Engine->GetCompiler()->GetStructures();
+				const auto& funcs = Engine->GetCompiler()->GetFunctions();
 
 				m_vsOutput = sd::Structure();
 
@@ -817,20 +1054,20 @@ namespace ed
 					}
 			} 
 			else {
-				m_pixel->VertexShaderOutput[id]["gl_Position"] = bv_variable_copy(*Engine.GetGlobalValue("gl_Position"));
+				m_pixel->VertexShaderOutput[id]["gl_Position"] = bv_variable_copy(*Engine->GetGlobalValue("gl_Position"));
 
 				// GLSL output variables are globals
-				const auto& globals = Engine.GetCompiler()->GetGlobals();
+				const auto& globals = Engine->GetCompiler()->GetGlobals();
 				for (const auto& glob : globals)
 					if (glob.Storage == sd::Variable::StorageType::Out)
-						m_pixel->VertexShaderOutput[id][glob.Name] = bv_variable_copy(*Engine.GetGlobalValue(glob.Name));
+						m_pixel->VertexShaderOutput[id][glob.Name] = bv_variable_copy(*Engine->GetGlobalValue(glob.Name));
 			}
 		}
 		else if (m_stage == sd::ShaderType::Pixel) {
 			// TODO: RT index
 			if (m_lang == ed::ShaderLanguage::HLSL) {
-				const auto& structs = Engine.GetCompiler()->GetStructures();
-				const auto& funcs = Engine.GetCompiler()->GetFunctions();
+				const auto& structs = Engine->GetCompiler()->GetStructures();
+				const auto& funcs = Engine->GetCompiler()->GetFunctions();
 
 				std::string returnTypeName;
 				for (const auto& func : funcs)
@@ -871,10 +1108,10 @@ namespace ed
 			}
 			else {
 				int outIndex = 0;
-				const auto& globals = Engine.GetCompiler()->GetGlobals();
+				const auto& globals = Engine->GetCompiler()->GetGlobals();
 				for (const auto& glob : globals)
 					if (glob.Storage == sd::Variable::StorageType::Out) {
-						m_pixel->DebuggerColor = glm::clamp(sd::AsVector<4, float>(*Engine.GetGlobalValue(glob.Name)), glm::vec4(0.0f), glm::vec4(1.0f));
+						m_pixel->DebuggerColor = glm::clamp(sd::AsVector<4, float>(*Engine->GetGlobalValue(glob.Name)), glm::vec4(0.0f), glm::vec4(1.0f));
 						if (m_pixel->RenderTextureIndex == glob.InputSlot || (m_pixel->RenderTextureIndex == outIndex && glob.InputSlot == -1))
 							break;
 						outIndex++;
@@ -893,12 +1130,14 @@ namespace ed
 
 		m_watchExprs.clear();
 		m_watchValues.clear();
+		m_watchCache.clear();
 	}
 	void DebugInformation::RemoveWatch(size_t index)
 	{
 		free(m_watchExprs[index]);
 		m_watchExprs.erase(m_watchExprs.begin() + index);
 		m_watchValues.erase(m_watchValues.begin() + index);
+		m_watchCache.erase(m_watchCache.begin() + index);
 	}
 	void DebugInformation::AddWatch(const std::string& expr, bool execute)
 	{
@@ -907,6 +1146,7 @@ namespace ed
 
 		m_watchExprs.push_back(data);
 		m_watchValues.push_back("");
+		m_watchCache.push_back(Expression());
 
 		if (execute)
 			UpdateWatchValue(m_watchExprs.size() - 1);
@@ -914,9 +1154,184 @@ namespace ed
 	void DebugInformation::UpdateWatchValue(size_t index)
 	{
 		char* expr = m_watchExprs[index];
-		bv_variable exprVal = Engine.Immediate(expr);
+
+		// the text is edited in place by the watch window
+		Expression& cache = m_watchCache[index];
+		if (cache.Text != expr)
+			m_parseExpression(cache, expr);
+
+		uint64_t key = 0;
+		bool comparable = m_getExpressionKey(cache, key);
+		if (comparable && cache.Valid && cache.Key == key)
+			return;
+
+		bv_variable exprVal = Engine->Immediate(expr);
 		m_watchValues[index] = VariableValueToString(exprVal);
 		bv_variable_deinitialize(&exprVal);
+
+		cache.Key = key;
+		cache.Valid = comparable;
+	}
+
+	static bool hashValue(const bv_variable& var, uint64_t& hash)
+	{
+		hash = HashData(&var.type, sizeof(var.type), hash);
+
+		if (var.type == bv_type_float) {
+			float val = bv_variable_get_float(var);
+			hash = HashData(&val, sizeof(val), hash);
+		} else if (bv_type_is_integer(var.type)) {
+			int val = bv_variable_get_int(var);
+			hash = HashData(&val, sizeof(val), hash);
+		} else if (var.type == bv_type_object) {
+			bv_object* obj = bv_variable_get_object(var);
+			hash = HashString(obj->type->name, hash);
+
+			for (u16 i = 0; i < obj->type->props.name_count; i++)
+				if (!hashValue(obj->prop[i], hash))
+					return false;
+
+			if (obj->type->props.name_count == 0 && !sd::IsBasicTexture(obj->type->name)) {
+				if (sd::GetMatrixTypeFromName(obj->type->name) == bv_type_void)
+					return false;
+
+				sd::Matrix* mat = (sd::Matrix*)obj->user_data;
+				for (int y = 0; y < mat->Rows; y++)
+					for (int x = 0; x < mat->Columns; x++)
+						hash = HashData(&mat->Data[y][x], sizeof(float), hash);
+			}
+		} else if (var.type != bv_type_void)
+			return false; // arrays, pointers...
+
+		return true;
+	}
+	void DebugInformation::m_parseExpression(Expression& expr, const std::string& text)
+	{
+		expr.Text = text;
+		expr.Names.clear();
+		expr.Valid = false;
+
+		for (size_t i = 0; i < text.size();) {
+			if (!isalpha((unsigned char)text[i]) && text[i] != '_') {
+				// skip the whole number so that 1.5f doesn't produce "f"
+				if (isdigit((unsigned char)text[i]))
+					while (i < text.size() && (isalnum((unsigned char)text[i]) || text[i] == '.'))
+						i++;
+				else
+					i++;
+				continue;
+			}
+
+			size_t end = i;
+			while (end < text.size() && (isalnum((unsigned char)text[end]) || text[end] == '_'))
+				end++;
+
+			// members & swizzles are covered by the value of the object
+			size_t prev = i;
+			while (prev > 0 && isspace((unsigned char)text[prev - 1]))
+				prev--;
+			bool isMember = prev > 0 && text[prev - 1] == '.';
+
+			std::string name = text.substr(i, end - i);
+			if (!isMember && std::find(expr.Names.begin(), expr.Names.end(), name) == expr.Names.end())
+				expr.Names.push_back(name);
+			i = end;
+		}
+	}
+	bool DebugInformation::m_getExpressionKey(const Expression& expr, uint64_t& key)
+	{
+		key = HashData(&Engine, sizeof(Engine));
+		key = HashString(Engine->GetCurrentFunction(), key);
+
+		for (const std::string& name : expr.Names) {
+			// locals hide the globals
+			bv_variable* var = Engine->GetLocalValue(name);
+			if (var == nullptr)
+				var = Engine->GetGlobalValue(name);
+
+			if (var == nullptr) {
+				key = HashString(name + ";-", key); // functions, types...
+				continue;
+			}
+
+			key = HashString(name, key);
+			if (!hashValue(*var, key))
+				return false;
+		}
+
+		return true;
+	}
+	void DebugInformation::AddActiveBreakpoint(int line, const std::string& condition)
+	{
+		Engine->AddBreakpoint(line);
+
+		if (condition.empty())
+			m_conditions.erase(line);
+		else {
+			Condition& cond = m_conditions[line];
+			m_parseExpression(cond, condition);
+		}
+	}
+	void DebugInformation::RemoveActiveBreakpoint(int line)
+	{
+		Engine->ClearBreakpoint(line);
+		m_conditions.erase(line);
+	}
+	void DebugInformation::ClearActiveBreakpoints()
+	{
+		Engine->ClearBreakpoints();
+		m_conditions.clear();
+	}
+	bool DebugInformation::m_shouldBreak()
+	{
+		auto it = m_conditions.find(Engine->GetCurrentLine());
+		if (it == m_conditions.end())
+			return true;
+
+		// loops usually hit the breakpoint with the same values in the condition many times
+		Condition& cond = it->second;
+		uint64_t key = 0;
+		bool comparable = m_getExpressionKey(cond, key);
+		if (comparable && cond.Valid && cond.Key == key)
+			return cond.Result;
+
+		bv_variable val = Engine->Immediate(cond.Text);
+		if (val.type == bv_type_float)
+			cond.Result = bv_variable_get_float(val) != 0.0f;
+		else if (bv_type_is_integer(val.type))
+			cond.Result = bv_variable_get_int(val) != 0;
+		else
+			cond.Result = true; // invalid conditions stop the execution so that the user sees it
+		bv_variable_deinitialize(&val);
+
+		cond.Key = key;
+		cond.Valid = comparable;
+
+		return cond.Result;
+	}
+	bool DebugInformation::m_skipBreakpoints(bool state, size_t depth)
+	{
+		// stopped on a breakpoint in a function that the step wanted to skip
+		while (state && Engine->GetFunctionStack().size() > depth && !m_shouldBreak())
+			state = Engine->StepOut();
+		return state;
+	}
+	bool DebugInformation::Continue()
+	{
+		bool state = Engine->Continue();
+		while (state && !m_shouldBreak())
+			state = Engine->Continue();
+		return state;
+	}
+	bool DebugInformation::StepOver()
+	{
+		size_t depth = Engine->GetFunctionStack().size();
+		return m_skipBreakpoints(Engine->StepOver(), depth);
+	}
+	bool DebugInformation::StepOut()
+	{
+		size_t depth = Engine->GetFunctionStack().size();
+		return m_skipBreakpoints(Engine->StepOut(), depth > 0 ? depth - 1 : 0);
 	}
 
 
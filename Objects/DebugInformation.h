@@ -6,12 +6,16 @@
 #include "ObjectManager.h"
 #include "RenderEngine.h"
 
+#define DEBUG_PROGRAM_CACHE_SIZE 8 // compiled debugger programs that are kept around
+#define DEBUG_VERTEX_CACHE_SIZE 16 // primitives whose vertex shader outputs are kept around
+
 namespace ed
 {
 	class DebugInformation
 	{
 	public:
 		DebugInformation(ObjectManager* objs, RenderEngine* renderer);
+		~DebugInformation();
 
 		inline void ClearPixelList() { m_pixels.clear(); }
 		inline void AddPixel(const PixelInformation& px) { m_pixels.push_back(px); }
@@ -19,8 +23,13 @@ namespace ed
 
 		bool SetSource(ed::ShaderLanguage lang, sd::ShaderType stage, const std::string& entry, const std::string& src);
 		void InitEngine(PixelInformation& pixel, int id = 0); // set up input variables
+		bool SetPixelPosition(glm::ivec2 coord, glm::vec2 rel); // move an initialized pixel shader to another pixel of the same primitive, false if the primitive doesn't cover it
 		void Fetch(int id = 0);
 
+		// runs the vertex shader set with SetSource() for every vertex of the pixel's primitive - other pixels of
+		// the same primitive (with the same uniforms) get the cached outputs without running the VM
+		bool RunVertexStage(PixelInformation& pixel);
+
 		std::string VariableValueToString(const bv_variable& var, int indent = 0);
 
 		inline const std::string& GetWatchValue(size_t index) { return m_watchValues[index]; }
@@ -40,15 +49,26 @@ namespace ed
 		inline const std::unordered_map<std::string, std::vector<bool>>& GetBreakpointStateList() { return m_breakpointStates; }
 		inline void ClearBreakpointList() { m_breakpoints.clear(); m_breakpointStates.clear(); }
 
+		// breakpoints of the current debugging session - the conditions are checked here, not by the engine
+		void AddActiveBreakpoint(int line, const std::string& condition);
+		void RemoveActiveBreakpoint(int line);
+		void ClearActiveBreakpoints();
+		bool Continue();
+		bool StepOver();
+		bool StepOut();
+
 		glm::vec2 GetVertexScreenPosition(PixelInformation& pixel, int id);
 
-		sd::ShaderDebugger Engine;
+		sd::ShaderDebugger* Engine; // the program set with the last SetSource() call, owned by the cache
 
 		inline void SetDebugging(bool debug) { m_isDebugging = debug; }
 		inline bool IsDebugging() { return m_isDebugging; }
 
 		inline sd::ShaderType GetShaderStage() { return m_stage; }
 
+		inline const sd::Structure& GetVertexOutputDescription() { return m_vsOutput; }
+		inline void SetVertexOutputDescription(const sd::Structure& desc) { m_vsOutput = desc; }
+
 	private:
 		ObjectManager* m_objs;
 		RenderEngine* m_renderer;
@@ -65,6 +85,32 @@ namespace ed
 
 		sd::Structure m_vsOutput; // hlsl VS output texture description
 
+		// debugging another pixel or vertex of the same pass doesn't compile the shader again
+		struct CachedProgram
+		{
+			uint64_t Key; // stage, language, entry & source - 0 -> failed to compile
+			sd::ShaderDebugger* Engine;
+			unsigned int LastUsed;
+		};
+		std::vector<CachedProgram> m_programs;
+		unsigned int m_programClock;
+		uint64_t m_programKey; // of the current program, 0 -> not compiled
+
+		struct VertexBatch
+		{
+			uint64_t Key; // program, object, primitive, vertex data & uniforms
+			std::unordered_map<std::string, bv_variable> Outputs[3];
+			glm::vec4 ClipPosition[3];
+			sd::Structure Description; // m_vsOutput
+			unsigned int LastUsed;
+		};
+		std::vector<VertexBatch> m_vertexBatches;
+		uint64_t m_getVertexBatchKey(PixelInformation& pixel);
+		glm::vec4 m_getClipPosition(PixelInformation& pixel, int id);
+
+		void m_resetArguments();
+		void m_setPixelInputs(int id = 0);
+
 		void m_cleanTextures(sd::ShaderType stage);
 		std::unordered_map<sd::ShaderType, std::vector<sd::Texture*>> m_textures;
 		std::unordered_map<sd::ShaderType, std::vector<sd::TextureCube*>> m_cubemaps;
@@ -72,6 +118,28 @@ namespace ed
 		std::vector<char*> m_watchExprs;
 		std::vector<std::string> m_watchValues;
 
+		// an expression is only evaluated again when a variable that it references has a different value
+		struct Expression
+		{
+			Expression() { Key = 0; Valid = false; }
+
+			std::string Text;
+			std::vector<std::string> Names; // identifiers that aren't members or swizzles
+			uint64_t Key; // of the values of Names when it was last evaluated
+			bool Valid;
+		};
+		std::vector<Expression> m_watchCache;
+		struct Condition : Expression
+		{
+			Condition() { Result = true; }
+			bool Result;
+		};
+		std::unordered_map<int, Condition> m_conditions; // line -> condition
+		void m_parseExpression(Expression& expr, const std::string& text);
+		bool m_getExpressionKey(const Expression& expr, uint64_t& key); // false if the values can't be compared
+		bool m_shouldBreak(); // at the current line
+		bool m_skipBreakpoints(bool state, size_t depth);
+
 		std::unordered_map<std::string, std::vector<sd::Breakpoint>> m_breakpoints;
 		std::unordered_map<std::string, std::vector<bool>> m_breakpointStates;
 	};
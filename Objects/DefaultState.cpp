@@ -1,34 +1,28 @@
 #include "DefaultState.h"
-#ifdef _WIN32
-#include <windows.h>
-#endif
-#include <GL/glew.h>
-#if defined(__APPLE__)
-	#include <OpenGL/gl.h>
-#else
-	#include <GL/gl.h>
-#endif
+#include "GLStateCache.h"
 
 namespace ed
 {
 	void DefaultState::Bind()
 	{
+		GLStateCache& state = GLStateCache::Instance();
+
 		// render states
-		glDisable(GL_DEPTH_CLAMP);
-		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-		glEnable(GL_CULL_FACE);
-		glCullFace(GL_BACK);
-		glFrontFace(GL_CCW);
+		state.Enable(GL_DEPTH_CLAMP, false);
+		state.PolygonMode(GL_FILL);
+		state.Enable(GL_CULL_FACE, true);
+		state.CullFace(GL_BACK);
+		state.FrontFace(GL_CCW);
 
 		// disable blending
-		glDisable(GL_BLEND);
+		state.Enable(GL_BLEND, false);
 
 		// depth state
-		glEnable(GL_DEPTH_TEST);
-		glDepthMask(GL_TRUE);
-		glDepthFunc(GL_LESS);
+		state.Enable(GL_DEPTH_TEST, true);
+		state.DepthMask(GL_TRUE);
+		state.DepthFunc(GL_LESS);
 
 		// stencil
-		glDisable(GL_STENCIL_TEST);
+		state.Enable(GL_STENCIL_TEST, false);
 	}
 }
@@ -0,0 +1,238 @@
+#include "DrawBatchCache.h"
+#include "../Engine/GLUtils.h"
+#include "../Engine/GeometryFactory.h"
+#include "../Engine/Model.h"
+
+#include <string.h>
+
+#define BATCH_VERTEX_SIZE (18 * sizeof(GLfloat))
+
+namespace ed
+{
+	struct DrawArraysIndirectCommand
+	{
+		GLuint Count, InstanceCount, First, BaseInstance;
+	};
+	struct DrawElementsIndirectCommand
+	{
+		GLuint Count, InstanceCount, FirstIndex;
+		GLint BaseVertex;
+		GLuint BaseInstance;
+	};
+
+	static inline size_t hashBytes(const void* data, size_t len, size_t hash)
+	{
+		const unsigned char* bytes = (const unsigned char*)data;
+		for (size_t i = 0; i < len; i++) {
+			hash ^= bytes[i];
+			hash *= 1099511628211ULL;
+		}
+		return hash;
+	}
+
+	DrawBatchCache::DrawBatchCache()
+	{ }
+	DrawBatchCache::~DrawBatchCache()
+	{
+		Clear();
+	}
+	bool DrawBatchCache::IsSupported()
+	{
+		return GLEW_ARB_multi_draw_indirect && GLEW_ARB_shader_storage_buffer_object && GLEW_ARB_draw_indirect;
+	}
+	bool DrawBatchCache::IsBatchable(PipelineItem* item)
+	{
+		if (item->Type == PipelineItem::ItemType::Geometry) {
+			pipe::GeometryItem* geo = (pipe::GeometryItem*)item->Data;
+			return !geo->Instanced && !geo->OcclusionCulling && geo->Type != pipe::GeometryItem::ScreenQuadNDC && geo->Type != pipe::GeometryItem::Generated && geo->Type != pipe::GeometryItem::Captured && geo->VBO != 0;
+		} else if (item->Type == PipelineItem::ItemType::Model) {
+			pipe::Model* mdl = (pipe::Model*)item->Data;
+			return !mdl->Instanced && mdl->LOD == 0 && mdl->Data != nullptr && mdl->Data->Meshes.size() > 0 && !mdl->Data->IsSkinned(); // the batch has a copy of the vertices
+		}
+
+		return false;
+	}
+	bool DrawBatchCache::IsCompatible(PipelineItem* first, PipelineItem* item)
+	{
+		if (first->Type != item->Type || !IsBatchable(item))
+			return false;
+
+		if (item->Type == PipelineItem::ItemType::Geometry)
+			return ((pipe::GeometryItem*)first->Data)->Topology == ((pipe::GeometryItem*)item->Data)->Topology;
+
+		return true;
+	}
+	void DrawBatchCache::Draw(PipelineItem* pass, const std::vector<InputLayoutItem>& layout, const std::vector<PipelineItem*>& items, int start, int count, const std::vector<ItemData>& data, GLuint binding)
+	{
+		Batch& batch = m_batches[std::make_pair(pass, start)];
+		if (!m_isValid(batch, layout, items, start, count))
+			m_build(batch, layout, items, start, count);
+
+		// one entry per draw command - models have one command per mesh
+		batch.Upload.resize(batch.DrawItem.size());
+		for (int i = 0; i < batch.DrawItem.size(); i++)
+			batch.Upload[i] = data[batch.DrawItem[i]];
+
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, batch.Data);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, batch.Upload.size() * sizeof(ItemData), batch.Upload.data(), GL_STREAM_DRAW);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, batch.Data);
+
+		glBindVertexArray(batch.VAO);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, batch.Commands);
+		if (batch.Indexed)
+			glMultiDrawElementsIndirect(batch.Topology, GL_UNSIGNED_INT, nullptr, batch.DrawItem.size(), 0);
+		else
+			glMultiDrawArraysIndirect(batch.Topology, nullptr, batch.DrawItem.size(), 0);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	}
+	void DrawBatchCache::Clear()
+	{
+		for (auto& batch : m_batches)
+			m_free(batch.second);
+		m_batches.clear();
+	}
+	size_t DrawBatchCache::m_getKey(PipelineItem* item)
+	{
+		size_t key = 14695981039346656037ULL;
+		if (item->Type == PipelineItem::ItemType::Geometry) {
+			pipe::GeometryItem* geo = (pipe::GeometryItem*)item->Data;
+			key = hashBytes(&geo->Type, sizeof(geo->Type), key);
+			key = hashBytes(&geo->VBO, sizeof(geo->VBO), key);
+			key = hashBytes(&geo->VAO, sizeof(geo->VAO), key);
+			key = hashBytes(&geo->Size, sizeof(geo->Size), key);
+		} else if (item->Type == PipelineItem::ItemType::Model) {
+			pipe::Model* mdl = (pipe::Model*)item->Data;
+			key = hashBytes(&mdl->Data, sizeof(mdl->Data), key);
+			for (const auto& mesh : mdl->Data->Meshes) {
+				key = hashBytes(&mesh.VBO, sizeof(mesh.VBO), key);
+				size_t vcount = mesh.Vertices.size(), icount = mesh.Indices.size();
+				key = hashBytes(&vcount, sizeof(vcount), key);
+				key = hashBytes(&icount, sizeof(icount), key);
+			}
+		}
+		return key;
+	}
+	bool DrawBatchCache::m_isValid(const Batch& batch, const std::vector<InputLayoutItem>& layout, const std::vector<PipelineItem*>& items, int start, int count)
+	{
+		if (batch.VAO == 0 || batch.Items.size() != count || batch.Layout.size() != layout.size())
+			return false;
+
+		for (int i = 0; i < layout.size(); i++)
+			if (batch.Layout[i] != layout[i].Value)
+				return false;
+
+		for (int i = 0; i < count; i++)
+			if (batch.Items[i] != items[start + i] || batch.Keys[i] != m_getKey(items[start + i]))
+				return false;
+
+		return true;
+	}
+	void DrawBatchCache::m_build(Batch& batch, const std::vector<InputLayoutItem>& layout, const std::vector<PipelineItem*>& items, int start, int count)
+	{
+		m_free(batch);
+
+		batch.Items.assign(items.begin() + start, items.begin() + start + count);
+		for (PipelineItem* item : batch.Items)
+			batch.Keys.push_back(m_getKey(item));
+		for (const auto& layitem : layout)
+			batch.Layout.push_back(layitem.Value);
+
+		batch.Indexed = batch.Items[0]->Type == PipelineItem::ItemType::Model;
+		batch.Topology = batch.Indexed ? GL_TRIANGLES : ((pipe::GeometryItem*)batch.Items[0]->Data)->Topology;
+
+		glGenBuffers(1, &batch.VBO);
+		glGenBuffers(1, &batch.Commands);
+		glGenBuffers(1, &batch.Data);
+
+		if (batch.Indexed) {
+			// models keep their vertices & indices on the CPU
+			size_t vertexCount = 0, indexCount = 0;
+			for (PipelineItem* item : batch.Items)
+				for (const auto& mesh : ((pipe::Model*)item->Data)->Data->Meshes) {
+					vertexCount += mesh.Vertices.size();
+					indexCount += mesh.Indices.size();
+				}
+
+			glGenBuffers(1, &batch.EBO);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, batch.VBO);
+			glBufferData(GL_COPY_WRITE_BUFFER, vertexCount * sizeof(eng::Model::Mesh::Vertex), nullptr, GL_STATIC_DRAW);
+			glBindBuffer(GL_COPY_READ_BUFFER, batch.EBO);
+			glBufferData(GL_COPY_READ_BUFFER, indexCount * sizeof(unsigned int), nullptr, GL_STATIC_DRAW);
+
+			std::vector<DrawElementsIndirectCommand> cmds;
+			size_t vertexOffset = 0, indexOffset = 0;
+			for (int i = 0; i < batch.Items.size(); i++) {
+				for (const auto& mesh : ((pipe::Model*)batch.Items[i]->Data)->Data->Meshes) {
+					glBufferSubData(GL_COPY_WRITE_BUFFER, vertexOffset * sizeof(eng::Model::Mesh::Vertex), mesh.Vertices.size() * sizeof(eng::Model::Mesh::Vertex), mesh.Vertices.data());
+					glBufferSubData(GL_COPY_READ_BUFFER, indexOffset * sizeof(unsigned int), mesh.Indices.size() * sizeof(unsigned int), mesh.Indices.data());
+
+					DrawElementsIndirectCommand cmd;
+					cmd.Count = mesh.Indices.size();
+					cmd.InstanceCount = 1;
+					cmd.FirstIndex = indexOffset;
+					cmd.BaseVertex = vertexOffset;
+					cmd.BaseInstance = 0;
+					cmds.push_back(cmd);
+					batch.DrawItem.push_back(i);
+
+					vertexOffset += mesh.Vertices.size();
+					indexOffset += mesh.Indices.size();
+				}
+			}
+
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, batch.Commands);
+			glBufferData(GL_DRAW_INDIRECT_BUFFER, cmds.size() * sizeof(DrawElementsIndirectCommand), cmds.data(), GL_STATIC_DRAW);
+		} else {
+			// geometry only lives on the GPU - copy the vertex buffers of each item
+			size_t vertexCount = 0;
+			for (PipelineItem* item : batch.Items)
+				vertexCount += eng::GeometryFactory::VertexCount[((pipe::GeometryItem*)item->Data)->Type];
+
+			glBindBuffer(GL_COPY_WRITE_BUFFER, batch.VBO);
+			glBufferData(GL_COPY_WRITE_BUFFER, vertexCount * BATCH_VERTEX_SIZE, nullptr, GL_STATIC_DRAW);
+
+			std::vector<DrawArraysIndirectCommand> cmds;
+			size_t vertexOffset = 0;
+			for (int i = 0; i < batch.Items.size(); i++) {
+				pipe::GeometryItem* geo = (pipe::GeometryItem*)batch.Items[i]->Data;
+				GLuint geoCount = eng::GeometryFactory::VertexCount[geo->Type];
+
+				glBindBuffer(GL_COPY_READ_BUFFER, geo->VBO);
+				glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, vertexOffset * BATCH_VERTEX_SIZE, geoCount * BATCH_VERTEX_SIZE);
+
+				DrawArraysIndirectCommand cmd;
+				cmd.Count = geoCount;
+				cmd.InstanceCount = 1;
+				cmd.First = vertexOffset;
+				cmd.BaseInstance = 0;
+				cmds.push_back(cmd);
+				batch.DrawItem.push_back(i);
+
+				vertexOffset += geoCount;
+			}
+
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, batch.Commands);
+			glBufferData(GL_DRAW_INDIRECT_BUFFER, cmds.size() * sizeof(DrawArraysIndirectCommand), cmds.data(), GL_STATIC_DRAW);
+		}
+
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+		gl::CreateVAO(batch.VAO, batch.VBO, layout, batch.EBO);
+		glBindVertexArray(0);
+	}
+	void DrawBatchCache::m_free(Batch& batch)
+	{
+		if (batch.VAO != 0)
+			glDeleteVertexArrays(1, &batch.VAO);
+
+		GLuint buffers[] = { batch.VBO, batch.EBO, batch.Commands, batch.Data };
+		for (GLuint buffer : buffers)
+			if (buffer != 0)
+				glDeleteBuffers(1, &buffer);
+
+		batch = Batch();
+	}
+}
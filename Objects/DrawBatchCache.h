@@ -0,0 +1,75 @@
+#pragma once
+#include "PipelineItem.h"
+#include "InputLayout.h"
+
+#include <map>
+#include <vector>
+#include <glm/glm.hpp>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/glew.h>
+#if defined(__APPLE__)
+	#include <OpenGL/gl.h>
+#else
+	#include <GL/gl.h>
+#endif
+
+#define DRAW_BATCH_BLOCK_NAME "SHADERed_Batch"
+
+namespace ed
+{
+	// merges a run of geometry or model items into one vertex buffer that is drawn with a single
+	// glMultiDraw*Indirect call - the shader reads the per item data from the SHADERed_Batch SSBO using gl_DrawID:
+	//		struct SHADERed_BatchItem { mat4 GeometryTransform; uvec4 Info; }; // Info.x = is picked, Info.y = item index in the pass
+	//		layout(std430) readonly buffer SHADERed_Batch { SHADERed_BatchItem batchItems[]; };
+	class DrawBatchCache
+	{
+	public:
+		DrawBatchCache();
+		~DrawBatchCache();
+
+		struct ItemData
+		{
+			glm::mat4 Transform;
+			glm::uvec4 Info;
+		};
+
+		static bool IsSupported();
+
+		// can this item be merged with other items
+		static bool IsBatchable(PipelineItem* item);
+		// can these two items be drawn with the same call
+		static bool IsCompatible(PipelineItem* first, PipelineItem* item);
+
+		// draws items[start, start+count) - the merged buffers are rebuilt only when the items change
+		void Draw(PipelineItem* pass, const std::vector<InputLayoutItem>& layout, const std::vector<PipelineItem*>& items, int start, int count, const std::vector<ItemData>& data, GLuint binding);
+
+		void Clear();
+
+	private:
+		struct Batch
+		{
+			Batch() { VAO = VBO = EBO = Commands = Data = 0; Topology = GL_TRIANGLES; Indexed = false; }
+
+			GLuint VAO, VBO, EBO, Commands, Data;
+			GLenum Topology;
+			bool Indexed;
+
+			std::vector<PipelineItem*> Items;
+			std::vector<size_t> Keys;	// describes the vertex data of each item
+			std::vector<int> DrawItem;	// item that owns each draw command
+			std::vector<InputLayoutValue> Layout;
+
+			std::vector<ItemData> Upload;
+		};
+
+		static size_t m_getKey(PipelineItem* item);
+		bool m_isValid(const Batch& batch, const std::vector<InputLayoutItem>& layout, const std::vector<PipelineItem*>& items, int start, int count);
+		void m_build(Batch& batch, const std::vector<InputLayoutItem>& layout, const std::vector<PipelineItem*>& items, int start, int count);
+		void m_free(Batch& batch);
+
+		std::map<std::pair<PipelineItem*, int>, Batch> m_batches; // [pass, first item] -> batch
+	};
+}
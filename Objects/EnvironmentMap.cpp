@@ -0,0 +1,908 @@
+#include "EnvironmentMap.h"
+#include "Logger.h"
+#include "Hash.h"
+#include "GLStateCache.h"
+#include "TraceRecorder.h"
+#include "../Engine/GLUtils.h"
+#include "../Engine/MappedFile.h"
+
+#include <glm/gtc/packing.hpp>
+#include <fstream>
+#include <algorithm>
+#include <thread>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <ghc/filesystem.hpp>
+#include <stb/stb_image.h>
+
+#define ENVIRONMENT_CACHE_DIR "./data/cache/"
+#define ENVIRONMENT_MAGIC 0x4E455345 // ESEN
+#define ENVIRONMENT_VERSION 1
+#define ENVIRONMENT_GROUP_SIZE 8
+
+static const char* EnvironmentCommonCode = R"(
+#version 430
+layout(local_size_x = 8, local_size_y = 8) in;
+
+#define PI 3.14159265359
+
+uniform int uSize;
+uniform int uFace;
+
+// same layout as the GL cubemap faces
+vec3 getDirection(int face, vec2 uv)
+{
+	vec2 st = uv * 2.0 - 1.0;
+	if (face == 0) return normalize(vec3(1.0, -st.y, -st.x));
+	if (face == 1) return normalize(vec3(-1.0, -st.y, st.x));
+	if (face == 2) return normalize(vec3(st.x, 1.0, st.y));
+	if (face == 3) return normalize(vec3(st.x, -1.0, -st.y));
+	if (face == 4) return normalize(vec3(st.x, -st.y, 1.0));
+	return normalize(vec3(-st.x, -st.y, -1.0));
+}
+vec2 hammersley(uint i, uint count)
+{
+	uint bits = bitfieldReverse(i);
+	return vec2(float(i) / float(count), float(bits) * 2.3283064365386963e-10);
+}
+vec3 toWorld(vec3 v, vec3 N)
+{
+	vec3 up = abs(N.z) < 0.999 ? vec3(0.0, 0.0, 1.0) : vec3(1.0, 0.0, 0.0);
+	vec3 T = normalize(cross(up, N));
+	vec3 B = cross(N, T);
+	return normalize(T * v.x + B * v.y + N * v.z);
+}
+vec3 sampleGGX(vec2 xi, vec3 N, float a)
+{
+	float phi = 2.0 * PI * xi.x;
+	float cosTheta = sqrt((1.0 - xi.y) / (1.0 + (a * a - 1.0) * xi.y));
+	float sinTheta = sqrt(1.0 - cosTheta * cosTheta);
+	return toWorld(vec3(cos(phi) * sinTheta, sin(phi) * sinTheta, cosTheta), N);
+}
+)";
+static const char* EnvironmentConvertCode = R"(
+uniform sampler2D uSource;
+uniform float uSourceLod;
+layout(rgba16f, binding = 0) writeonly uniform imageCube uTarget;
+
+void main()
+{
+	ivec2 id = ivec2(gl_GlobalInvocationID.xy);
+	if (id.x >= uSize || id.y >= uSize)
+		return;
+
+	// the rows of the image are stored from the bottom up
+	vec3 dir = getDirection(uFace, (vec2(id) + 0.5) / float(uSize));
+	vec2 uv = vec2(atan(dir.z, dir.x) / (2.0 * PI) + 0.5, 1.0 - acos(clamp(dir.y, -1.0, 1.0)) / PI);
+	imageStore(uTarget, ivec3(id, uFace), vec4(textureLod(uSource, uv, uSourceLod).rgb, 1.0));
+}
+)";
+static const char* EnvironmentSpecularCode = R"(
+uniform samplerCube uEnvironment;
+uniform float uEnvironmentSize;
+uniform float uRoughness;
+uniform uint uSamples;
+layout(rgba16f, binding = 0) writeonly uniform imageCube uTarget;
+
+void main()
+{
+	ivec2 id = ivec2(gl_GlobalInvocationID.xy);
+	if (id.x >= uSize || id.y >= uSize)
+		return;
+
+	vec3 N = getDirection(uFace, (vec2(id) + 0.5) / float(uSize));
+	vec3 color = vec3(0.0);
+	if (uRoughness == 0.0)
+		color = textureLod(uEnvironment, N, 0.0).rgb;
+	else {
+		// V = N, each sample reads the level whose texels cover its part of the lobe
+		float a = uRoughness * uRoughness;
+		float texelArea = 4.0 * PI / (6.0 * uEnvironmentSize * uEnvironmentSize);
+		float weight = 0.0;
+		for (uint i = 0u; i < uSamples; i++) {
+			vec3 H = sampleGGX(hammersley(i, uSamples), N, a);
+			vec3 L = normalize(2.0 * dot(N, H) * H - N);
+			float NdotL = dot(N, L);
+			if (NdotL <= 0.0)
+				continue;
+
+			float NdotH = max(dot(N, H), 0.0);
+			float d = NdotH * NdotH * (a * a - 1.0) + 1.0;
+			float pdf = a * a / (PI * d * d) * 0.25 + 0.0001;
+			float sampleArea = 1.0 / (float(uSamples) * pdf);
+			float lod = max(0.5 * log2(sampleArea / texelArea) + 1.0, 0.0);
+
+			color += textureLod(uEnvironment, L, lod).rgb * NdotL;
+			weight += NdotL;
+		}
+		color /= max(weight, 0.0001);
+	}
+	imageStore(uTarget, ivec3(id, uFace), vec4(color, 1.0));
+}
+)";
+static const char* EnvironmentIrradianceCode = R"(
+uniform samplerCube uEnvironment;
+uniform float uEnvironmentSize;
+uniform uint uSamples;
+layout(rgba16f, binding = 0) writeonly uniform imageCube uTarget;
+
+void main()
+{
+	ivec2 id = ivec2(gl_GlobalInvocationID.xy);
+	if (id.x >= uSize || id.y >= uSize)
+		return;
+
+	// cosine weighted, the PDF cancels the cosine & the 1 / PI of the lambertian BRDF
+	vec3 N = getDirection(uFace, (vec2(id) + 0.5) / float(uSize));
+	float texelArea = 4.0 * PI / (6.0 * uEnvironmentSize * uEnvironmentSize);
+	vec3 color = vec3(0.0);
+	for (uint i = 0u; i < uSamples; i++) {
+		vec2 xi = hammersley(i, uSamples);
+		float phi = 2.0 * PI * xi.x;
+		float cosTheta = sqrt(1.0 - xi.y), sinTheta = sqrt(xi.y);
+		vec3 L = toWorld(vec3(cos(phi) * sinTheta, sin(phi) * sinTheta, cosTheta), N);
+
+		float pdf = cosTheta / PI + 0.0001;
+		float lod = max(0.5 * log2(1.0 / (float(uSamples) * pdf * texelArea)) + 1.0, 0.0);
+		color += textureLod(uEnvironment, L, lod).rgb;
+	}
+	imageStore(uTarget, ivec3(id, uFace), vec4(color / float(uSamples), 1.0));
+}
+)";
+static const char* EnvironmentBRDFCode = R"(
+uniform uint uSamples;
+layout(rg16f, binding = 0) writeonly uniform image2D uTarget;
+
+void main()
+{
+	ivec2 id = ivec2(gl_GlobalInvocationID.xy);
+	if (id.x >= uSize || id.y >= uSize)
+		return;
+
+	float NdotV = (float(id.x) + 0.5) / float(uSize);
+	float roughness = (float(id.y) + 0.5) / float(uSize);
+	float a = roughness * roughness;
+	float k = a / 2.0;
+
+	vec3 N = vec3(0.0, 0.0, 1.0);
+	vec3 V = vec3(sqrt(1.0 - NdotV * NdotV), 0.0, NdotV);
+	vec2 sum = vec2(0.0);
+	for (uint i = 0u; i < uSamples; i++) {
+		vec3 H = sampleGGX(hammersley(i, uSamples), N, a);
+		vec3 L = normalize(2.0 * dot(V, H) * H - V);
+		float NdotL = max(L.z, 0.0);
+		if (NdotL <= 0.0)
+			continue;
+
+		float NdotH = max(H.z, 0.0);
+		float VdotH = max(dot(V, H), 0.0);
+		float G = (NdotV / (NdotV * (1.0 - k) + k)) * (NdotL / (NdotL * (1.0 - k) + k));
+		float visibility = G * VdotH / max(NdotH * NdotV, 0.0001);
+		float Fc = pow(1.0 - VdotH, 5.0);
+		sum += vec2(1.0 - Fc, Fc) * visibility;
+	}
+	imageStore(uTarget, id, vec4(sum / float(uSamples), 0.0, 0.0));
+}
+)";
+
+namespace ed
+{
+	// followed by the RGBA16F specular levels (6 faces each), the RGBA16F irradiance faces and the RG16F BRDF LUT
+	struct EnvironmentFileHeader
+	{
+		uint32_t Magic, Version;
+		int32_t FaceSize, Levels;
+		int32_t IrradianceSize, BRDFSize;
+		int32_t Width, Height; // of the source image
+	};
+
+	static size_t getDataSize(int faceSize, int levels)
+	{
+		size_t ret = 0;
+		for (int l = 0; l < levels; l++) {
+			size_t size = std::max(faceSize >> l, 1);
+			ret += size * size * 6 * 8;
+		}
+		ret += ENVIRONMENT_IRRADIANCE_SIZE * ENVIRONMENT_IRRADIANCE_SIZE * 6 * 8;
+		ret += ENVIRONMENT_BRDF_SIZE * ENVIRONMENT_BRDF_SIZE * 4;
+		return ret;
+	}
+	static GLuint createProgram(const char* code, const std::string& label, std::string& error)
+	{
+		GLchar msg[1024];
+		std::string source = std::string(EnvironmentCommonCode) + code;
+		GLuint cs = gl::CompileShader(GL_COMPUTE_SHADER, source.c_str());
+		if (!gl::CheckShaderCompilationStatus(cs, msg)) {
+			error = "failed to compile the " + label + " shader: " + std::string(msg);
+			glDeleteShader(cs);
+			return 0;
+		}
+
+		GLuint program = glCreateProgram();
+		gl::SetObjectLabel(GL_PROGRAM, program, "Environment " + label);
+		glAttachShader(program, cs);
+		glLinkProgram(program);
+		glDeleteShader(cs);
+
+		if (!gl::CheckShaderLinkStatus(program, msg)) {
+			error = "failed to link the " + label + " shader: " + std::string(msg);
+			glDeleteProgram(program);
+			return 0;
+		}
+
+		glUseProgram(program);
+		glUniform1i(glGetUniformLocation(program, "uSource"), 0);
+		glUniform1i(glGetUniformLocation(program, "uEnvironment"), 0);
+		glUseProgram(0);
+
+		return program;
+	}
+	static void setCubeParameters(GLuint tex, bool mipmaps)
+	{
+		glBindTexture(GL_TEXTURE_CUBE_MAP, tex);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, mipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+		// the blurry levels show the face edges without it
+		if (GLEW_ARB_seamless_cubemap_per_texture)
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_CUBE_MAP_SEAMLESS, GL_TRUE);
+		glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+	}
+
+	// scanline OpenEXR images (uncompressed, ZIPS or ZIP) - RGBA floats with the rows from the bottom up like stb_image loads them
+	static bool decodeEXR(const std::string& path, glm::ivec2& size, std::vector<float>& rgba, std::string& error)
+	{
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+		if (!file.is_open()) {
+			error = "failed to open " + path;
+			return false;
+		}
+		std::vector<unsigned char> data((size_t)file.tellg());
+		file.seekg(0, std::ios::beg);
+		file.read((char*)data.data(), data.size());
+		file.close();
+
+		size_t pos = 0;
+		auto readString = [&](std::string& str) {
+			const void* end = pos < data.size() ? memchr(&data[pos], 0, data.size() - pos) : nullptr;
+			if (end == nullptr)
+				return false;
+			str = std::string((const char*)&data[pos]);
+			pos += str.size() + 1;
+			return true;
+		};
+		auto readValue = [&](void* dst, size_t bytes) {
+			if (pos + bytes > data.size())
+				return false;
+			memcpy(dst, &data[pos], bytes);
+			pos += bytes;
+			return true;
+		};
+
+		uint32_t magic = 0, version = 0;
+		if (!readValue(&magic, 4) || !readValue(&version, 4) || magic != 20000630) {
+			error = "not an OpenEXR image";
+			return false;
+		}
+		if (version & (0x200 | 0x800 | 0x1000)) {
+			error = "tiled, deep & multipart OpenEXR images are not supported";
+			return false;
+		}
+
+		struct Channel
+		{
+			int32_t Type; // 0 = uint, 1 = half, 2 = float
+			int Component; // -1 -> not used, 4 -> luminance
+		};
+		std::vector<Channel> channels;
+		int compression = -1;
+		int32_t window[4] = { 0, 0, -1, -1 };
+		while (pos < data.size() && data[pos] != 0) {
+			std::string name, type;
+			int32_t attrSize = 0;
+			if (!readString(name) || !readString(type) || !readValue(&attrSize, 4) || attrSize < 0 || pos + attrSize > data.size()) {
+				error = "broken OpenEXR header";
+				return false;
+			}
+
+			size_t attrEnd = pos + attrSize;
+			if (name == "channels") {
+				while (pos < attrEnd && data[pos] != 0) {
+					std::string chName;
+					Channel ch;
+					int32_t sampling[2] = { 0, 0 };
+					unsigned char flags[4];
+					if (!readString(chName) || !readValue(&ch.Type, 4) || !readValue(flags, 4) || !readValue(sampling, 8) || ch.Type < 0 || ch.Type > 2) {
+						error = "broken OpenEXR channel list";
+						return false;
+					}
+					if (sampling[0] != 1 || sampling[1] != 1) {
+						error = "subsampled OpenEXR channels are not supported";
+						return false;
+					}
+
+					const char* components = "RGBA";
+					const char* found = chName.size() == 1 ? strchr(components, chName[0]) : nullptr;
+					ch.Component = found != nullptr ? (int)(found - components) : (chName == "Y" ? 4 : -1);
+					channels.push_back(ch);
+				}
+			} else if (name == "compression" && attrSize >= 1)
+				compression = data[pos];
+			else if (name == "dataWindow" && attrSize >= 16)
+				memcpy(window, &data[pos], 16);
+
+			pos = attrEnd;
+		}
+		pos++; // end of the header
+
+		if (compression != 0 && compression != 2 && compression != 3) {
+			error = "only uncompressed & ZIP compressed OpenEXR images are supported";
+			return false;
+		}
+
+		size = glm::ivec2(window[2] - window[0] + 1, window[3] - window[1] + 1);
+		if (size.x <= 0 || size.y <= 0 || size.x > 65536 || size.y > 65536 || channels.empty()) {
+			error = "broken OpenEXR data window";
+			return false;
+		}
+
+		size_t pixelSize = 0;
+		for (const Channel& ch : channels)
+			pixelSize += ch.Type == 1 ? 2 : 4;
+
+		rgba.assign((size_t)size.x * size.y * 4, 0.0f);
+		for (size_t i = 3; i < rgba.size(); i += 4)
+			rgba[i] = 1.0f;
+
+		int linesPerBlock = compression == 3 ? 16 : 1;
+		int blockCount = (size.y + linesPerBlock - 1) / linesPerBlock;
+		std::vector<uint64_t> offsets(blockCount);
+		if (!readValue(offsets.data(), offsets.size() * sizeof(uint64_t))) {
+			error = "broken OpenEXR offset table";
+			return false;
+		}
+
+		std::vector<unsigned char> unpacked, predicted;
+		for (int b = 0; b < blockCount; b++) {
+			pos = offsets[b];
+			int32_t y = 0, packedSize = 0;
+			if (!readValue(&y, 4) || !readValue(&packedSize, 4) || packedSize < 0 || pos + packedSize > data.size()) {
+				error = "broken OpenEXR block";
+				return false;
+			}
+
+			int line = y - window[1];
+			int lines = std::min(linesPerBlock, size.y - line);
+			if (line < 0 || lines <= 0)
+				continue;
+
+			size_t expected = (size_t)lines * size.x * pixelSize;
+			const unsigned char* src = &data[pos];
+
+			// blocks that didn't get smaller are stored as they are
+			if (compression != 0 && packedSize < expected) {
+				predicted.resize(expected);
+				if (stbi_zlib_decode_buffer((char*)predicted.data(), expected, (const char*)src, packedSize) != expected) {
+					error = "broken OpenEXR ZIP block";
+					return false;
+				}
+
+				// undo the delta encoding & interleave the two halves again
+				for (size_t i = 1; i < expected; i++)
+					predicted[i] = (unsigned char)(predicted[i - 1] + predicted[i] - 128);
+				unpacked.resize(expected);
+				size_t half = (expected + 1) / 2;
+				for (size_t i = 0; i < expected; i++)
+					unpacked[i] = predicted[(i % 2 == 0) ? i / 2 : half + i / 2];
+				src = unpacked.data();
+			} else if (packedSize < expected) {
+				error = "broken OpenEXR block";
+				return false;
+			}
+
+			// every line has all values of the first channel, then all of the second one...
+			for (int l = 0; l < lines; l++) {
+				float* row = &rgba[(size_t)(size.y - 1 - line - l) * size.x * 4];
+				for (const Channel& ch : channels) {
+					for (int x = 0; x < size.x; x++) {
+						float value = 0.0f;
+						if (ch.Type == 1) {
+							uint16_t half = 0;
+							memcpy(&half, src, 2);
+							value = glm::unpackHalf1x16(half);
+							src += 2;
+						} else if (ch.Type == 2) {
+							memcpy(&value, src, 4);
+							src += 4;
+						} else {
+							uint32_t uvalue = 0;
+							memcpy(&uvalue, src, 4);
+							value = (float)uvalue;
+							src += 4;
+						}
+
+						if (ch.Component == 4)
+							row[x * 4 + 0] = row[x * 4 + 1] = row[x * 4 + 2] = value;
+						else if (ch.Component >= 0)
+							row[x * 4 + ch.Component] = value;
+					}
+				}
+			}
+		}
+
+		return true;
+	}
+
+	EnvironmentMap::EnvironmentMap()
+	{
+		m_specular = m_irradiance = m_brdf = 0;
+		m_faceSize = m_levels = 0;
+		m_sourceSize = glm::ivec2(0, 0);
+		m_ready = m_cached = false;
+	}
+	EnvironmentMap::~EnvironmentMap()
+	{
+		m_releaseSave();
+	}
+	bool EnvironmentMap::IsSupported()
+	{
+		return GLEW_ARB_compute_shader && GLEW_ARB_shader_image_load_store && GLEW_ARB_texture_storage;
+	}
+	bool EnvironmentMap::IsSupportedFile(const std::string& path)
+	{
+		size_t dot = path.find_last_of('.');
+		if (dot == std::string::npos)
+			return false;
+
+		std::string ext = path.substr(dot + 1);
+		std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+		return ext == "hdr" || ext == "exr";
+	}
+	bool EnvironmentMap::Open(const std::string& path, int faceSize, GLuint specular, GLuint irradiance, GLuint brdf, eng::ThreadPool& pool)
+	{
+		m_path = path;
+		m_specular = specular;
+		m_irradiance = irradiance;
+		m_brdf = brdf;
+
+		std::error_code ec;
+		if (!IsSupportedFile(path)) {
+			m_error = "only .hdr & .exr images are supported";
+			return false;
+		}
+		if (!ghc::filesystem::exists(path, ec)) {
+			m_error = "the file doesn't exist";
+			return false;
+		}
+
+		GLint maxSize = 0;
+		glGetIntegerv(GL_MAX_CUBE_MAP_TEXTURE_SIZE, &maxSize);
+		m_faceSize = std::max(std::min<int>(faceSize, maxSize), ENVIRONMENT_MIN_LEVEL_SIZE);
+		m_levels = 1;
+		while ((m_faceSize >> m_levels) >= ENVIRONMENT_MIN_LEVEL_SIZE)
+			m_levels++;
+
+		// immutable storage - the levels are written as images, textureQueryLevels() returns the prefiltered levels
+		glBindTexture(GL_TEXTURE_CUBE_MAP, m_specular);
+		glTexStorage2D(GL_TEXTURE_CUBE_MAP, m_levels, GL_RGBA16F, m_faceSize, m_faceSize);
+		setCubeParameters(m_specular, m_levels > 1);
+		if (m_irradiance != 0) {
+			glBindTexture(GL_TEXTURE_CUBE_MAP, m_irradiance);
+			glTexStorage2D(GL_TEXTURE_CUBE_MAP, 1, GL_RGBA16F, ENVIRONMENT_IRRADIANCE_SIZE, ENVIRONMENT_IRRADIANCE_SIZE);
+			setCubeParameters(m_irradiance, false);
+		}
+		if (m_brdf != 0) {
+			glBindTexture(GL_TEXTURE_2D, m_brdf);
+			glTexStorage2D(GL_TEXTURE_2D, 1, GL_RG16F, ENVIRONMENT_BRDF_SIZE, ENVIRONMENT_BRDF_SIZE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			glBindTexture(GL_TEXTURE_2D, 0);
+		}
+
+		// black until the contents are there
+		if (GLEW_ARB_clear_texture) {
+			for (int l = 0; l < m_levels; l++)
+				glClearTexImage(m_specular, l, GL_RGBA, GL_FLOAT, nullptr);
+			if (m_irradiance != 0)
+				glClearTexImage(m_irradiance, 0, GL_RGBA, GL_FLOAT, nullptr);
+			if (m_brdf != 0)
+				glClearTexImage(m_brdf, 0, GL_RG, GL_FLOAT, nullptr);
+		}
+
+		// filtered again when the image or the settings change
+		uint64_t hash = HashString(ghc::filesystem::absolute(path, ec).string());
+		hash = HashString(std::to_string(ghc::filesystem::file_size(path, ec)), hash);
+		hash = HashString(std::to_string(ghc::filesystem::last_write_time(path, ec).time_since_epoch().count()), hash);
+		hash = HashString(std::to_string(m_faceSize) + "," + std::to_string(ENVIRONMENT_SAMPLES) + "," + std::to_string(ENVIRONMENT_IRRADIANCE_SAMPLES), hash);
+
+		char name[17] = { 0 };
+		snprintf(name, 17, "%016llx", (unsigned long long)hash);
+		m_cache = std::string(ENVIRONMENT_CACHE_DIR) + name + ".sen";
+
+		std::shared_ptr<LoadJob> job = m_load = std::make_shared<LoadJob>();
+		job->Source = path;
+		job->Cache = m_cache;
+		job->FaceSize = m_faceSize;
+		job->Levels = m_levels;
+		job->CacheSize = getDataSize(m_faceSize, m_levels);
+		job->Cached = false;
+		job->Size = glm::ivec2(0, 0);
+		job->Done = false;
+		pool.Add([job]() {
+			m_decode(job.get());
+			job->Done = true;
+		});
+
+		return true;
+	}
+	bool EnvironmentMap::Update(eng::ThreadPool& pool)
+	{
+		m_pollSave(pool);
+
+		if (m_load == nullptr || !m_load->Done)
+			return false;
+
+		std::shared_ptr<LoadJob> job = m_load;
+		m_load = nullptr;
+
+		if (!job->Error.empty()) {
+			m_error = job->Error;
+			Logger::Get().Log("Failed to load the environment map " + m_path + ": " + m_error, true);
+			return false;
+		}
+
+		m_sourceSize = job->Size;
+		if (job->Cached) {
+			m_upload((const unsigned char*)job->Pixels.data());
+			m_cached = true;
+		} else {
+			if (!m_filter(job->Pixels, job->Size)) {
+				Logger::Get().Log("Failed to filter the environment map " + m_path + ": " + m_error, true);
+				return false;
+			}
+			m_startSave();
+		}
+
+		m_ready = true;
+		return true;
+	}
+	void EnvironmentMap::Detach(GLuint tex)
+	{
+		if (tex == 0)
+			return;
+		if (m_specular == tex) m_specular = 0;
+		if (m_irradiance == tex) m_irradiance = 0;
+		if (m_brdf == tex) m_brdf = 0;
+	}
+	void EnvironmentMap::m_decode(LoadJob* job)
+	{
+		// the cache file has everything, the image isn't decoded at all
+		{
+			TraceRecorder::Scope zone("Read environment cache", "load");
+
+			std::ifstream file(job->Cache, std::ios::binary | std::ios::ate);
+			EnvironmentFileHeader header;
+			if (file.is_open() && (size_t)file.tellg() == sizeof(header) + job->CacheSize) {
+				file.seekg(0, std::ios::beg);
+				file.read((char*)&header, sizeof(header));
+				if (header.Magic == ENVIRONMENT_MAGIC && header.Version == ENVIRONMENT_VERSION && header.FaceSize == job->FaceSize && header.Levels == job->Levels &&
+					header.IrradianceSize == ENVIRONMENT_IRRADIANCE_SIZE && header.BRDFSize == ENVIRONMENT_BRDF_SIZE) {
+					job->Pixels.resize(job->CacheSize / 2);
+					file.read((char*)job->Pixels.data(), job->CacheSize);
+					if (file.good()) {
+						job->Size = glm::ivec2(header.Width, header.Height);
+						job->Cached = true;
+						return;
+					}
+				}
+			}
+		}
+
+		TraceRecorder::Scope zone("Decode environment map", "load");
+
+		std::vector<float> rgba;
+		size_t dot = job->Source.find_last_of('.');
+		std::string ext = job->Source.substr(dot + 1);
+		std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+		if (ext == "exr") {
+			if (!decodeEXR(job->Source, job->Size, rgba, job->Error))
+				return;
+		} else {
+			int channels = 0;
+			float* data = stbi_loadf(job->Source.c_str(), &job->Size.x, &job->Size.y, &channels, 4);
+			if (data == nullptr) {
+				job->Error = "failed to decode " + job->Source;
+				return;
+			}
+			rgba.assign(data, data + (size_t)job->Size.x * job->Size.y * 4);
+			stbi_image_free(data);
+		}
+
+		// the sun of some HDR images doesn't fit in a half float
+		job->Pixels.resize(rgba.size());
+		for (size_t i = 0; i < rgba.size(); i++) {
+			float value = rgba[i] == rgba[i] ? std::max(std::min(rgba[i], 65504.0f), -65504.0f) : 0.0f;
+			job->Pixels[i] = glm::packHalf1x16(value);
+		}
+	}
+	void EnvironmentMap::m_upload(const unsigned char* data)
+	{
+		if (m_specular != 0) {
+			glBindTexture(GL_TEXTURE_CUBE_MAP, m_specular);
+			for (int l = 0; l < m_levels; l++) {
+				int size = std::max(m_faceSize >> l, 1);
+				for (int f = 0; f < 6; f++) {
+					glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + f, l, 0, 0, size, size, GL_RGBA, GL_HALF_FLOAT, data);
+					data += (size_t)size * size * 8;
+				}
+			}
+		} else {
+			for (int l = 0; l < m_levels; l++) {
+				size_t size = std::max(m_faceSize >> l, 1);
+				data += size * size * 6 * 8;
+			}
+		}
+
+		if (m_irradiance != 0) {
+			glBindTexture(GL_TEXTURE_CUBE_MAP, m_irradiance);
+			for (int f = 0; f < 6; f++)
+				glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + f, 0, 0, 0, ENVIRONMENT_IRRADIANCE_SIZE, ENVIRONMENT_IRRADIANCE_SIZE, GL_RGBA, GL_HALF_FLOAT, data + (size_t)f * ENVIRONMENT_IRRADIANCE_SIZE * ENVIRONMENT_IRRADIANCE_SIZE * 8);
+		}
+		data += ENVIRONMENT_IRRADIANCE_SIZE * ENVIRONMENT_IRRADIANCE_SIZE * 6 * 8;
+		glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+		if (m_brdf != 0) {
+			glBindTexture(GL_TEXTURE_2D, m_brdf);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, ENVIRONMENT_BRDF_SIZE, ENVIRONMENT_BRDF_SIZE, GL_RG, GL_HALF_FLOAT, data);
+			glBindTexture(GL_TEXTURE_2D, 0);
+		}
+	}
+	bool EnvironmentMap::m_filter(const std::vector<uint16_t>& pixels, glm::ivec2 size)
+	{
+		GLint maxSize = 0;
+		glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+		if (size.x > maxSize || size.y > maxSize) {
+			m_error = "the image is larger than the largest texture (" + std::to_string(maxSize) + ")";
+			return false;
+		}
+
+		GLuint convertProgram = createProgram(EnvironmentConvertCode, "convert", m_error);
+		GLuint specularProgram = createProgram(EnvironmentSpecularCode, "specular", m_error);
+		GLuint irradianceProgram = createProgram(EnvironmentIrradianceCode, "irradiance", m_error);
+		GLuint brdfProgram = createProgram(EnvironmentBRDFCode, "BRDF", m_error);
+		if (convertProgram == 0 || specularProgram == 0 || irradianceProgram == 0 || brdfProgram == 0) {
+			glDeleteProgram(convertProgram);
+			glDeleteProgram(specularProgram);
+			glDeleteProgram(irradianceProgram);
+			glDeleteProgram(brdfProgram);
+			return false;
+		}
+
+		// the equirectangular image with a mip chain so that a small face doesn't alias
+		GLuint source = 0;
+		glGenTextures(1, &source);
+		glBindTexture(GL_TEXTURE_2D, source);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, size.x, size.y, 0, GL_RGBA, GL_HALF_FLOAT, pixels.data());
+		glGenerateMipmap(GL_TEXTURE_2D);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+		// the unfiltered cubemap with the whole mip chain, the filters read the level that matches their sample density
+		int envLevels = 1;
+		while ((m_faceSize >> envLevels) > 0)
+			envLevels++;
+		GLuint env = 0;
+		glGenTextures(1, &env);
+		glBindTexture(GL_TEXTURE_CUBE_MAP, env);
+		glTexStorage2D(GL_TEXTURE_CUBE_MAP, envLevels, GL_RGBA16F, m_faceSize, m_faceSize);
+		setCubeParameters(env, true);
+
+		GLStateCache::Instance().BindSampler(0, 0);
+		glActiveTexture(GL_TEXTURE0);
+
+		// one dispatch per face so that the large levels don't keep the GPU busy for too long
+		auto dispatchFaces = [](GLuint program, int faceSize) {
+			GLuint groups = (faceSize + ENVIRONMENT_GROUP_SIZE - 1) / ENVIRONMENT_GROUP_SIZE;
+			glUniform1i(glGetUniformLocation(program, "uSize"), faceSize);
+			for (int f = 0; f < 6; f++) {
+				glUniform1i(glGetUniformLocation(program, "uFace"), f);
+				glDispatchCompute(groups, groups, 1);
+			}
+		};
+
+		glUseProgram(convertProgram);
+		glBindTexture(GL_TEXTURE_2D, source);
+		glUniform1f(glGetUniformLocation(convertProgram, "uSourceLod"), std::max(log2f(size.x / (4.0f * m_faceSize)), 0.0f));
+		glBindImageTexture(0, env, 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+		dispatchFaces(convertProgram, m_faceSize);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+		glBindTexture(GL_TEXTURE_CUBE_MAP, env);
+		glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+
+		if (m_specular != 0) {
+			glUseProgram(specularProgram);
+			glUniform1f(glGetUniformLocation(specularProgram, "uEnvironmentSize"), (float)m_faceSize);
+			glUniform1ui(glGetUniformLocation(specularProgram, "uSamples"), ENVIRONMENT_SAMPLES);
+			for (int l = 0; l < m_levels; l++) {
+				glUniform1f(glGetUniformLocation(specularProgram, "uRoughness"), m_levels > 1 ? l / (float)(m_levels - 1) : 0.0f);
+				glBindImageTexture(0, m_specular, l, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+				dispatchFaces(specularProgram, std::max(m_faceSize >> l, 1));
+			}
+		}
+
+		if (m_irradiance != 0) {
+			glUseProgram(irradianceProgram);
+			glUniform1f(glGetUniformLocation(irradianceProgram, "uEnvironmentSize"), (float)m_faceSize);
+			glUniform1ui(glGetUniformLocation(irradianceProgram, "uSamples"), ENVIRONMENT_IRRADIANCE_SAMPLES);
+			glBindImageTexture(0, m_irradiance, 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+			dispatchFaces(irradianceProgram, ENVIRONMENT_IRRADIANCE_SIZE);
+		}
+
+		if (m_brdf != 0) {
+			GLuint groups = (ENVIRONMENT_BRDF_SIZE + ENVIRONMENT_GROUP_SIZE - 1) / ENVIRONMENT_GROUP_SIZE;
+			glUseProgram(brdfProgram);
+			glUniform1i(glGetUniformLocation(brdfProgram, "uSize"), ENVIRONMENT_BRDF_SIZE);
+			glUniform1ui(glGetUniformLocation(brdfProgram, "uSamples"), ENVIRONMENT_SAMPLES);
+			glBindImageTexture(0, m_brdf, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RG16F);
+			glDispatchCompute(groups, groups, 1);
+		}
+
+		glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+		glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+		glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+		glUseProgram(0);
+
+		glDeleteTextures(1, &source);
+		glDeleteTextures(1, &env);
+		glDeleteProgram(convertProgram);
+		glDeleteProgram(specularProgram);
+		glDeleteProgram(irradianceProgram);
+		glDeleteProgram(brdfProgram);
+
+		return true;
+	}
+	void EnvironmentMap::m_startSave()
+	{
+		// the cache file always has all three
+		if (m_specular == 0 || m_irradiance == 0 || m_brdf == 0)
+			return;
+
+		m_releaseSave();
+
+		std::shared_ptr<SaveJob> job = m_save = std::make_shared<SaveJob>();
+		job->Cache = m_cache;
+		job->FaceSize = m_faceSize;
+		job->Levels = m_levels;
+		job->Size = m_sourceSize;
+		job->DataSize = getDataSize(m_faceSize, m_levels);
+		job->Mapped = nullptr;
+		job->Done = false;
+		job->Failed = false;
+
+		// queued behind the filters, nothing waits for it
+		glGenBuffers(1, &job->PBO);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, job->PBO);
+		glBufferData(GL_PIXEL_PACK_BUFFER, job->DataSize, nullptr, GL_STREAM_READ);
+
+		size_t offset = 0;
+		glBindTexture(GL_TEXTURE_CUBE_MAP, m_specular);
+		for (int l = 0; l < m_levels; l++) {
+			size_t size = std::max(m_faceSize >> l, 1);
+			for (int f = 0; f < 6; f++) {
+				glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X + f, l, GL_RGBA, GL_HALF_FLOAT, (void*)offset);
+				offset += size * size * 8;
+			}
+		}
+		glBindTexture(GL_TEXTURE_CUBE_MAP, m_irradiance);
+		for (int f = 0; f < 6; f++) {
+			glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X + f, 0, GL_RGBA, GL_HALF_FLOAT, (void*)offset);
+			offset += ENVIRONMENT_IRRADIANCE_SIZE * ENVIRONMENT_IRRADIANCE_SIZE * 8;
+		}
+		glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+		glBindTexture(GL_TEXTURE_2D, m_brdf);
+		glGetTexImage(GL_TEXTURE_2D, 0, GL_RG, GL_HALF_FLOAT, (void*)offset);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		job->Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		glFlush(); // ObjectManager::WaitForLoading() polls the fence
+	}
+	void EnvironmentMap::m_pollSave(eng::ThreadPool& pool)
+	{
+		if (m_save == nullptr)
+			return;
+
+		std::shared_ptr<SaveJob> job = m_save;
+		if (job->Fence != nullptr) {
+			if (glClientWaitSync(job->Fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+				return;
+			glDeleteSync(job->Fence);
+			job->Fence = nullptr;
+
+			glBindBuffer(GL_COPY_READ_BUFFER, job->PBO);
+			job->Mapped = (const unsigned char*)glMapBufferRange(GL_COPY_READ_BUFFER, 0, job->DataSize, GL_MAP_READ_BIT);
+			glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+			if (job->Mapped == nullptr) {
+				job->Failed = true;
+				job->Done = true;
+			} else
+				pool.Add([job]() {
+					m_writeCache(job.get());
+					job->Done = true;
+				});
+		}
+
+		if (job->Done) {
+			if (job->Failed)
+				Logger::Get().Log("Failed to write the cache file of the environment map " + m_path, true);
+			m_releaseSave();
+		}
+	}
+	void EnvironmentMap::m_releaseSave()
+	{
+		if (m_save == nullptr)
+			return;
+
+		// the worker reads from the mapping
+		SaveJob* job = m_save.get();
+		if (job->Fence != nullptr)
+			glDeleteSync(job->Fence);
+		else
+			while (job->Mapped != nullptr && !job->Done)
+				std::this_thread::yield();
+
+		if (job->Mapped != nullptr) {
+			glBindBuffer(GL_COPY_READ_BUFFER, job->PBO);
+			glUnmapBuffer(GL_COPY_READ_BUFFER);
+			glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		}
+		glDeleteBuffers(1, &job->PBO);
+
+		m_save = nullptr;
+	}
+	void EnvironmentMap::m_writeCache(SaveJob* job)
+	{
+		TraceRecorder::Scope zone("Write environment cache", "save");
+
+		std::error_code ec;
+		ghc::filesystem::create_directories(ENVIRONMENT_CACHE_DIR, ec);
+
+		EnvironmentFileHeader header;
+		header.Magic = ENVIRONMENT_MAGIC;
+		header.Version = ENVIRONMENT_VERSION;
+		header.FaceSize = job->FaceSize;
+		header.Levels = job->Levels;
+		header.IrradianceSize = ENVIRONMENT_IRRADIANCE_SIZE;
+		header.BRDFSize = ENVIRONMENT_BRDF_SIZE;
+		header.Width = job->Size.x;
+		header.Height = job->Size.y;
+
+		// written under another name so that a half written file is never read
+		std::string tempPath = job->Cache + ".tmp";
+		std::ofstream file(tempPath, std::ios::binary);
+		file.write((const char*)&header, sizeof(header));
+		file.write((const char*)job->Mapped, job->DataSize);
+		file.close();
+
+		if (file.fail()) {
+			job->Failed = true;
+			ghc::filesystem::remove(tempPath, ec);
+			return;
+		}
+
+		job->Failed = !eng::ReplaceFileWith(job->Cache, tempPath);
+		if (job->Failed)
+			ghc::filesystem::remove(tempPath, ec);
+	}
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <stdint.h>
+#include <glm/glm.hpp>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/glew.h>
+#if defined(__APPLE__)
+	#include <OpenGL/gl.h>
+#else
+	#include <GL/gl.h>
+#endif
+
+#include "../Engine/ThreadPool.h"
+
+#define ENVIRONMENT_FACE_SIZE 512			// default face size of the prefiltered specular cubemap's first level
+#define ENVIRONMENT_MIN_LEVEL_SIZE 8		// face size of the last specular level, its roughness is 1
+#define ENVIRONMENT_IRRADIANCE_SIZE 32		// face size of the irradiance cubemap
+#define ENVIRONMENT_BRDF_SIZE 256			// the BRDF LUT is BRDF_SIZE x BRDF_SIZE texels
+#define ENVIRONMENT_SAMPLES 512				// GGX samples per texel of the specular levels & the BRDF LUT
+#define ENVIRONMENT_IRRADIANCE_SAMPLES 1024 // cosine weighted samples per irradiance texel
+
+namespace ed
+{
+	// image based lighting from an equirectangular .hdr/.exr image - the image is decoded to RGBA16F on a loader thread and
+	// everything else is generated with compute shaders once:
+	//  - specular: RGBA16F cubemap, level i is prefiltered for the GGX roughness i / (levels - 1), sample it with
+	//    textureLod(env, R, roughness * (textureQueryLevels(env) - 1))
+	//  - irradiance: RGBA16F cubemap with the cosine convolution divided by PI, diffuse = albedo * texture(irradiance, N)
+	//  - brdf: RG16F split sum LUT, texture(brdf, vec2(NdotV, roughness)).rg = scale & bias of F0
+	// the generated levels are read back and written to the cache directory, next time only the cache file is read
+	class EnvironmentMap
+	{
+	public:
+		EnvironmentMap();
+		~EnvironmentMap();
+
+		static bool IsSupported();
+		static bool IsSupportedFile(const std::string& path);
+
+		// allocates the storage of the textures & starts reading the cache file or decoding the image - irradiance/brdf can be 0
+		bool Open(const std::string& path, int faceSize, GLuint specular, GLuint irradiance, GLuint brdf, eng::ThreadPool& pool);
+		bool Update(eng::ThreadPool& pool); // main thread, once per frame - true when the textures got their contents
+		void Detach(GLuint tex); // the object that owns tex was removed, nothing is written to it anymore
+
+		inline bool IsReady() { return m_ready; }
+		inline bool IsBuilding() { return m_load != nullptr || m_save != nullptr; } // still decoding, filtering or writing the cache file
+		inline bool IsCached() { return m_cached; } // the contents came from the cache file
+		inline const std::string& GetError() { return m_error; }
+		inline glm::ivec2 GetSourceSize() { return m_sourceSize; }
+		inline int GetFaceSize() { return m_faceSize; }
+		inline int GetLevelCount() { return m_levels; }
+
+	private:
+		struct LoadJob
+		{
+			std::string Source, Cache;
+			int FaceSize, Levels;
+			size_t CacheSize; // bytes of the levels in the cache file
+
+			bool Cached; // Pixels has the cache file's levels, otherwise the decoded image
+			glm::ivec2 Size;
+			std::vector<uint16_t> Pixels; // RGBA16F, the rows of the image from the bottom up
+
+			std::atomic<bool> Done;
+			std::string Error;
+		};
+		struct SaveJob
+		{
+			std::string Cache;
+			int FaceSize, Levels;
+			glm::ivec2 Size;
+
+			GLuint PBO;
+			GLsync Fence;
+			const unsigned char* Mapped; // the worker writes straight from the mapping
+			size_t DataSize;
+
+			std::atomic<bool> Done;
+			bool Failed;
+		};
+
+		static void m_decode(LoadJob* job);
+		static void m_writeCache(SaveJob* job);
+
+		void m_upload(const unsigned char* data); // the cache file's levels
+		bool m_filter(const std::vector<uint16_t>& pixels, glm::ivec2 size);
+		void m_startSave(); // reads the levels back into a PBO
+		void m_pollSave(eng::ThreadPool& pool);
+		void m_releaseSave(); // waits for the worker if it's writing the file
+
+		GLuint m_specular, m_irradiance, m_brdf;
+		int m_faceSize, m_levels;
+		glm::ivec2 m_sourceSize;
+		std::string m_path, m_cache, m_error;
+		bool m_ready, m_cached;
+
+		std::shared_ptr<LoadJob> m_load;
+		std::shared_ptr<SaveJob> m_save;
+	};
+}
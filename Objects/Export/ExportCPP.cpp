@@ -226,11 +226,38 @@ namespace ed
 		return "";
 	}
 
-	std::string bindVariable(ed::ShaderVariable* var, std::string passName)
+	// how often the optimized export uploads a variable
+	enum class UpdateFrequency
+	{
+		Once,
+		Resize,
+		Frame,
+		Draw
+	};
+	UpdateFrequency getUpdateFrequency(ed::ShaderVariable* var)
+	{
+		switch (var->System) {
+		case ed::SystemShaderVariable::None:
+		case ed::SystemShaderVariable::View:
+			return UpdateFrequency::Once;
+		case ed::SystemShaderVariable::ViewportSize:
+		case ed::SystemShaderVariable::Projection:
+		case ed::SystemShaderVariable::Orthographic:
+		case ed::SystemShaderVariable::ViewProjection:
+		case ed::SystemShaderVariable::ViewOrthographic:
+			return UpdateFrequency::Resize;
+		case ed::SystemShaderVariable::GeometryTransform:
+			return UpdateFrequency::Draw;
+		}
+
+		return UpdateFrequency::Frame;
+	}
+
+	std::string bindVariable(ed::ShaderVariable* var, std::string passName, const std::string& location = "")
 	{
 		std::string ret = "";
 
-		std::string locSrc = "glGetUniformLocation(" + passName + "_SP, \"" + std::string(var->Name) + "\")";
+		std::string locSrc = location.empty() ? "glGetUniformLocation(" + passName + "_SP, \"" + std::string(var->Name) + "\")" : location;
 		
 		std::string systemName = getSystemVariableName(var);
 		bool isSystem = var->System != ed::SystemShaderVariable::None;
@@ -323,7 +350,7 @@ namespace ed
 		return ret;
 	}
 
-	bool ExportCPP::Export(InterfaceManager* data, const std::string& outPath, bool externalShaders, bool exportCmakeFiles, const std::string& cmakeProject, bool copyCMakeModules, bool copySTBImage, bool copyImages)
+	bool ExportCPP::Export(InterfaceManager* data, const std::string& outPath, bool externalShaders, bool exportCmakeFiles, const std::string& cmakeProject, bool copyCMakeModules, bool copySTBImage, bool copyImages, bool optimized, bool benchmark)
 	{
 		bool usesGeometry[pipe::GeometryItem::GeometryType::Count] = { false };
 		bool usesTextures = false;
@@ -334,6 +361,9 @@ namespace ed
 		if (exportCmakeFiles && !ghc::filesystem::exists("data/export/cpp/CMakeLists.txt"))
 			return false;
 
+		if (exportCmakeFiles && benchmark && !ghc::filesystem::exists("data/export/cpp/benchmark.cmake"))
+			return false;
+
 		if (copyCMakeModules && !ghc::filesystem::exists("data/export/cpp/FindGLM.cmake"))
 			return false;
 
@@ -345,6 +375,7 @@ namespace ed
 		// copy CMakeLists.txt
 		if (exportCmakeFiles) {
 			std::string cmakeLists = loadFile("data/export/cpp/CMakeLists.txt");
+			replaceSections(cmakeLists, "benchmark_target", benchmark ? loadFile("data/export/cpp/benchmark.cmake") : "");
 			replaceSections(cmakeLists, "project_name", cmakeProject);
 			replaceSections(cmakeLists, "project_file", ghc::filesystem::path(outPath).filename());
 
@@ -531,7 +562,34 @@ namespace ed
 					pipe::ShaderPass* pass = (pipe::ShaderPass*)pipeItems[i]->Data;
 
 					// load shaders
-					initSrc += indent + "GLuint " + std::string(pipeItems[i]->Name) + "_SP = CreateShader(" + getShaderFilename(pass->VSPath) + ".c_str(), " + getShaderFilename(pass->PSPath) + ".c_str());\n\n";
+					std::string passName = pipeItems[i]->Name;
+					if (!optimized)
+						initSrc += indent + "GLuint " + passName + "_SP = CreateShader(" + getShaderFilename(pass->VSPath) + ".c_str(), " + getShaderFilename(pass->PSPath) + ".c_str());\n\n";
+					else {
+						initSrc += indent + "GLuint " + passName + "_SP = CreateShaderCached(" + getShaderFilename(pass->VSPath) + ".c_str(), " + getShaderFilename(pass->PSPath) + ".c_str(), \"" + passName + "_SP.bin\");\n";
+
+						// uniform locations are only queried once
+						const auto& vars = pass->Variables.GetVariables();
+						if (!vars.empty()) {
+							initSrc += indent + "GLint " + passName + "_Uniforms[] = {\n";
+							for (const auto& var : vars)
+								initSrc += indent + "\tglGetUniformLocation(" + passName + "_SP, \"" + std::string(var->Name) + "\"),\n";
+							initSrc += indent + "};\n";
+						}
+
+						// sampler units and the variables that don't change every frame
+						initSrc += indent + "glUseProgram(" + passName + "_SP);\n";
+						const auto& srvs = data->Objects.GetBindList(pipeItems[i]);
+						const auto& samplers = pass->Variables.GetSamplerList();
+						for (int j = 0; j < srvs.size() && j < samplers.size(); j++)
+							initSrc += indent + "glUniform1i(glGetUniformLocation(" + passName + "_SP, \"" + samplers[j] + "\"), " + std::to_string(j) + ");\n";
+						for (int j = 0; j < vars.size(); j++) {
+							UpdateFrequency freq = getUpdateFrequency(vars[j]);
+							if (freq == UpdateFrequency::Once || freq == UpdateFrequency::Resize)
+								initSrc += indent + bindVariable(vars[j], passName, passName + "_Uniforms[" + std::to_string(j) + "]") + "\n";
+						}
+						initSrc += indent + "glUseProgram(0);\n\n";
+					}
 
 					// framebuffers
 					if (pass->RTCount == 1 && pass->RenderTextures[0] == data->Renderer.GetTexture()) {}
@@ -578,6 +636,83 @@ namespace ed
 			insertSection(templateSrc, locInit, initSrc);
 		}
 
+		// GPU timer queries for each shader pass, only compiled when SED_BENCHMARK is defined
+		std::vector<std::string> benchmarkPasses;
+		if (benchmark)
+			for (int i = 0; i < pipeItems.size(); i++)
+				if (pipeItems[i]->Type == ed::PipelineItem::ItemType::ShaderPass)
+					benchmarkPasses.push_back(pipeItems[i]->Name);
+		std::string passCount = std::to_string(benchmarkPasses.size());
+
+		size_t locBenchmarkSetup = findSection(templateSrc, "benchmark_setup");
+		indent = getSectionIndent(templateSrc, "benchmark_setup");
+		if (locBenchmarkSetup != std::string::npos) {
+			std::string setupSrc = "";
+
+			if (!benchmarkPasses.empty()) {
+				setupSrc += indent + "// benchmark\n";
+				setupSrc += indent + "#ifdef SED_BENCHMARK\n";
+				setupSrc += indent + "#ifndef SED_BENCHMARK_FRAMES\n";
+				setupSrc += indent + "#define SED_BENCHMARK_FRAMES 1000\n";
+				setupSrc += indent + "#endif\n";
+				setupSrc += indent + "#define SED_BENCHMARK_WARMUP 10\n";
+				setupSrc += indent + "SDL_HideWindow(wnd);\n";
+				setupSrc += indent + "SDL_GL_SetSwapInterval(0);\n";
+				setupSrc += indent + "const char* sedPassNames[] = {";
+				for (int i = 0; i < benchmarkPasses.size(); i++)
+					setupSrc += (i == 0 ? " \"" : ", \"") + benchmarkPasses[i] + "\"";
+				setupSrc += " };\n";
+				setupSrc += indent + "GLuint sedPassQueries[" + passCount + "];\n";
+				setupSrc += indent + "glGenQueries(" + passCount + ", sedPassQueries);\n";
+				setupSrc += indent + "double sedPassTotal[" + passCount + "] = { 0.0 }, sedPassMin[" + passCount + "], sedPassMax[" + passCount + "] = { 0.0 };\n";
+				setupSrc += indent + "for (int i = 0; i < " + passCount + "; i++)\n";
+				setupSrc += indent + "\tsedPassMin[i] = 1e9;\n";
+				setupSrc += indent + "int sedBenchmarkFrame = 0;\n";
+				setupSrc += indent + "#define SED_PASS_BEGIN(i) glBeginQuery(GL_TIME_ELAPSED, sedPassQueries[i])\n";
+				setupSrc += indent + "#define SED_PASS_END(i) glEndQuery(GL_TIME_ELAPSED)\n";
+				setupSrc += indent + "#else\n";
+				setupSrc += indent + "#define SED_PASS_BEGIN(i)\n";
+				setupSrc += indent + "#define SED_PASS_END(i)\n";
+				setupSrc += indent + "#endif\n";
+			}
+
+			insertSection(templateSrc, locBenchmarkSetup, setupSrc);
+		}
+
+		size_t locBenchmarkFrame = findSection(templateSrc, "benchmark_frame");
+		indent = getSectionIndent(templateSrc, "benchmark_frame");
+		if (locBenchmarkFrame != std::string::npos) {
+			std::string frameSrc = "";
+
+			// waiting for the results stalls the GPU but the timings stay per pass
+			if (!benchmarkPasses.empty()) {
+				frameSrc += indent + "#ifdef SED_BENCHMARK\n";
+				frameSrc += indent + "for (int i = 0; i < " + passCount + "; i++) {\n";
+				frameSrc += indent + "\tGLuint64 passTime = 0;\n";
+				frameSrc += indent + "\tglGetQueryObjectui64v(sedPassQueries[i], GL_QUERY_RESULT, &passTime);\n";
+				frameSrc += indent + "\tif (sedBenchmarkFrame >= SED_BENCHMARK_WARMUP) {\n";
+				frameSrc += indent + "\t\tdouble passMs = passTime / 1000000.0;\n";
+				frameSrc += indent + "\t\tsedPassTotal[i] += passMs;\n";
+				frameSrc += indent + "\t\tsedPassMin[i] = passMs < sedPassMin[i] ? passMs : sedPassMin[i];\n";
+				frameSrc += indent + "\t\tsedPassMax[i] = passMs > sedPassMax[i] ? passMs : sedPassMax[i];\n";
+				frameSrc += indent + "\t}\n";
+				frameSrc += indent + "}\n";
+				frameSrc += indent + "if (++sedBenchmarkFrame == SED_BENCHMARK_WARMUP + SED_BENCHMARK_FRAMES) {\n";
+				frameSrc += indent + "\tdouble frameTotal = 0.0;\n";
+				frameSrc += indent + "\tprintf(\"%-32s %10s %10s %10s\\n\", \"pass\", \"avg (ms)\", \"min (ms)\", \"max (ms)\");\n";
+				frameSrc += indent + "\tfor (int i = 0; i < " + passCount + "; i++) {\n";
+				frameSrc += indent + "\t\tprintf(\"%-32s %10.4f %10.4f %10.4f\\n\", sedPassNames[i], sedPassTotal[i] / SED_BENCHMARK_FRAMES, sedPassMin[i], sedPassMax[i]);\n";
+				frameSrc += indent + "\t\tframeTotal += sedPassTotal[i] / SED_BENCHMARK_FRAMES;\n";
+				frameSrc += indent + "\t}\n";
+				frameSrc += indent + "\tprintf(\"%-32s %10.4f\\n\", \"total\", frameTotal);\n";
+				frameSrc += indent + "\trun = false;\n";
+				frameSrc += indent + "}\n";
+				frameSrc += indent + "#endif\n";
+			}
+
+			insertSection(templateSrc, locBenchmarkFrame, frameSrc);
+		}
+
 		// events for system variables
 		size_t locResizeEvent = findSection(templateSrc, "resize_event");
 		indent = getSectionIndent(templateSrc, "resize_event");
@@ -612,6 +747,31 @@ namespace ed
 					resizeEventSrc += indent + "glBindTexture(GL_TEXTURE_2D, 0);\n\n";
 				}
 			}
+			// the optimized export doesn't upload the window size dependent variables every frame
+			if (optimized) {
+				bool changedProgram = false;
+				for (int i = 0; i < pipeItems.size(); i++) {
+					if (pipeItems[i]->Type != ed::PipelineItem::ItemType::ShaderPass)
+						continue;
+
+					std::string passName = pipeItems[i]->Name;
+					const auto& vars = ((pipe::ShaderPass*)pipeItems[i]->Data)->Variables.GetVariables();
+					bool usedProgram = false;
+					for (int j = 0; j < vars.size(); j++) {
+						if (getUpdateFrequency(vars[j]) != UpdateFrequency::Resize)
+							continue;
+
+						if (!usedProgram) {
+							resizeEventSrc += indent + "glUseProgram(" + passName + "_SP);\n";
+							usedProgram = changedProgram = true;
+						}
+						resizeEventSrc += indent + bindVariable(vars[j], passName, passName + "_Uniforms[" + std::to_string(j) + "]") + "\n";
+					}
+				}
+				if (changedProgram)
+					resizeEventSrc += indent + "glUseProgram(0);\n";
+			}
+
 			insertSection(templateSrc, locResizeEvent, resizeEventSrc); // TODO: system variables
 		}
 
@@ -623,6 +783,7 @@ namespace ed
 
 			GLuint previousTexture[MAX_RENDER_TEXTURES] = { 0 }; // dont clear the render target if we use it two times in a row
 			GLuint previousDepth = 0;
+			int passIndex = 0;
 
 			for (int i = 0; i < pipeItems.size(); i++) {
 				if (pipeItems[i]->Type == ed::PipelineItem::ItemType::ShaderPass) {
@@ -630,6 +791,8 @@ namespace ed
 
 					// use the program
 					renderSrc += indent + "// " + std::string(pipeItems[i]->Name) + " shader pass\n";
+					if (benchmark)
+						renderSrc += indent + "SED_PASS_BEGIN(" + std::to_string(passIndex) + ");\n";
 					renderSrc += indent + "glUseProgram(" + std::string(pipeItems[i]->Name) + "_SP);\n\n";
 
 					// FBO
@@ -695,16 +858,21 @@ namespace ed
 						else
 							renderSrc += indent + "glBindTexture(GL_TEXTURE_2D, " + texName + ");\n";
 						
-						std::string unitName = pass->Variables.GetSamplerList()[j];
-						renderSrc += indent + "glUniform1i(glGetUniformLocation(" + std::string(pipeItems[i]->Name) + "_SP, \"" + unitName + "\"), " + std::to_string(j) + ");\n\n";
+						if (!optimized) {
+							std::string unitName = pass->Variables.GetSamplerList()[j];
+							renderSrc += indent + "glUniform1i(glGetUniformLocation(" + std::string(pipeItems[i]->Name) + "_SP, \"" + unitName + "\"), " + std::to_string(j) + ");\n";
+						}
+						renderSrc += "\n";
 					}
 
 					// bind variables
 					const auto& vars = pass->Variables.GetVariables();
-					for (const auto& var : vars) {
-						if (var->System != ed::SystemShaderVariable::GeometryTransform) {
-							renderSrc += indent + bindVariable(var, std::string(pipeItems[i]->Name)) + "\n";
-						}
+					for (int j = 0; j < vars.size(); j++) {
+						if (optimized) {
+							if (getUpdateFrequency(vars[j]) == UpdateFrequency::Frame)
+								renderSrc += indent + bindVariable(vars[j], std::string(pipeItems[i]->Name), std::string(pipeItems[i]->Name) + "_Uniforms[" + std::to_string(j) + "]") + "\n";
+						} else if (vars[j]->System != ed::SystemShaderVariable::GeometryTransform)
+							renderSrc += indent + bindVariable(vars[j], std::string(pipeItems[i]->Name)) + "\n";
 					}
 					renderSrc += "\n";
 
@@ -714,7 +882,8 @@ namespace ed
 							std::string pName = pItem->Name;
 							pipe::GeometryItem* geoData = (pipe::GeometryItem*)pItem->Data;
 
-							for (const auto& var : vars) {
+							for (int j = 0; j < vars.size(); j++) {
+								ed::ShaderVariable* var = vars[j];
 								if (var->System == ed::SystemShaderVariable::GeometryTransform) {
 									if (geoData->Type == pipe::GeometryItem::GeometryType::Rectangle) {
 										renderSrc += indent + "sysGeometryTransform = glm::translate(glm::mat4(1), glm::vec3((" + std::to_string(geoData->Position.x) + "f + 0.5f) * sedWindowWidth, (" + std::to_string(geoData->Position.y) + "f + 0.5f) * sedWindowHeight, -1000.0f)) *" +
@@ -725,7 +894,10 @@ namespace ed
 											"glm::yawPitchRoll(" + std::to_string(geoData->Rotation.y) + "f, " + std::to_string(geoData->Rotation.x) + "f, " + std::to_string(geoData->Rotation.z) + "f) * " +
 											"glm::scale(glm::mat4(1.0f), glm::vec3(" + std::to_string(geoData->Scale.x) + "f, " + std::to_string(geoData->Scale.y) + "f, " + std::to_string(geoData->Scale.z) + "f));\n";
 									}
-									renderSrc += indent + "glUniformMatrix4fv(glGetUniformLocation(" + std::string(pipeItems[i]->Name) + "_SP, \"" + std::string(var->Name) + "\"), 1, GL_FALSE, glm::value_ptr(sysGeometryTransform));\n";
+									std::string locSrc = "glGetUniformLocation(" + std::string(pipeItems[i]->Name) + "_SP, \"" + std::string(var->Name) + "\")";
+									if (optimized)
+										locSrc = std::string(pipeItems[i]->Name) + "_Uniforms[" + std::to_string(j) + "]";
+									renderSrc += indent + "glUniformMatrix4fv(" + locSrc + ", 1, GL_FALSE, glm::value_ptr(sysGeometryTransform));\n";
 									break;
 								}
 							}
@@ -738,6 +910,9 @@ namespace ed
 						}
 						renderSrc += "\n";
 					}
+
+					if (benchmark)
+						renderSrc += indent + "SED_PASS_END(" + std::to_string(passIndex++) + ");\n\n";
 				}
 			}
 
@@ -6,7 +6,7 @@ namespace ed
 	class ExportCPP
 	{
 	public:
-		static bool Export(InterfaceManager* data, const std::string& outPath, bool externalShaders, bool exportCmakeFiles, const std::string& cmakeProject, bool copyCMakeModules, bool copySTBImage, bool copyImages);
+		static bool Export(InterfaceManager* data, const std::string& outPath, bool externalShaders, bool exportCmakeFiles, const std::string& cmakeProject, bool copyCMakeModules, bool copySTBImage, bool copyImages, bool optimized, bool benchmark);
 
 	};
 }
\ No newline at end of file
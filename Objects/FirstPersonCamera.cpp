@@ -14,6 +14,7 @@ namespace ed
 	void FirstPersonCamera::Reset()
 	{
 		m_pos = glm::vec3(0.0f, 0.0f, 7.0f);
+		m_changed = true;
 	}
 	void FirstPersonCamera::MoveLeftRight(float d)
 	{
@@ -21,6 +22,7 @@ namespace ed
 		glm::vec4 right = rotaMatrix * RIGHT_VECTOR;
 
 		m_pos = glm::vec4(m_pos,0) + right * d;
+		m_changed = true;
 	}
 	void FirstPersonCamera::MoveUpDown(float d)
 	{
@@ -28,6 +30,7 @@ namespace ed
 		glm::vec4 forward = rotaMatrix * FORWARD_VECTOR;
 
 		m_pos = glm::vec4(m_pos,0) + forward * d;
+		m_changed = true;
 	}
 	glm::vec4 FirstPersonCamera::GetUpVector()
 	{
@@ -37,6 +40,9 @@ namespace ed
 	}
 	glm::mat4 FirstPersonCamera::GetMatrix()
 	{
+		if (!m_changed)
+			return m_matrix;
+
 		glm::mat4 rota = glm::yawPitchRoll(glm::radians(m_yaw), glm::radians(m_pitch), 0.0f);
 
 		glm::vec4 target = rota * FORWARD_VECTOR;
@@ -48,7 +54,10 @@ namespace ed
 		glm::vec4 up =  yawMatrix * UP_VECTOR;
 		glm::vec4 forward = yawMatrix * FORWARD_VECTOR;
 
-		return glm::lookAt(m_pos, glm::vec3(target), glm::vec3(up));
+		m_matrix = glm::lookAt(m_pos, glm::vec3(target), glm::vec3(up));
+		m_changed = false;
+
+		return m_matrix;
 	}
 	glm::vec4 FirstPersonCamera::GetViewDirection() {
 		glm::mat4 rota = glm::yawPitchRoll(glm::radians(m_yaw), glm::radians(m_pitch), 0.0f);
@@ -7,18 +7,18 @@ namespace ed
 	class FirstPersonCamera : public Camera
 	{
 	public:
-		FirstPersonCamera() : m_yaw(0.0f), m_pitch(0.0f) { Reset(); }
+		FirstPersonCamera() : m_yaw(0.0f), m_pitch(0.0f), m_changed(true) { Reset(); }
 
 		virtual void Reset();
 		
-		inline void SetPosition(float x, float y, float z) { m_pos = glm::vec3(x, y, z); }
+		inline void SetPosition(float x, float y, float z) { m_pos = glm::vec3(x, y, z); m_changed = true; }
 
 		void MoveLeftRight(float d);
 		void MoveUpDown(float d);
-		inline void Yaw(float y) { m_yaw -= y; }
-		inline void Pitch(float p) { m_pitch -= p; }
-		inline void SetYaw(float y) { m_yaw = y; }
-		inline void SetPitch(float p) { m_pitch = p; }
+		inline void Yaw(float y) { m_yaw -= y; m_changed = true; }
+		inline void Pitch(float p) { m_pitch -= p; m_changed = true; }
+		inline void SetYaw(float y) { m_yaw = y; m_changed = true; }
+		inline void SetPitch(float p) { m_pitch = p; m_changed = true; }
 
 		virtual inline glm::vec3 GetRotation() { return glm::vec3(m_yaw, m_pitch, 0); }
 
@@ -32,6 +32,7 @@ namespace ed
 			this->m_pos = fp.m_pos;
 			this->m_yaw = fp.m_yaw;
 			this->m_pitch = fp.m_pitch;
+			this->m_changed = true;
 			return *this;
 		}
 
@@ -40,5 +41,9 @@ namespace ed
 
 		float m_yaw;
 		float m_pitch;
+
+		// view matrix is only rebuilt after the camera moved
+		bool m_changed;
+		glm::mat4 m_matrix;
 	};
 }
@@ -0,0 +1,174 @@
+#include "FontAtlasCache.h"
+#include "Logger.h"
+#include "Hash.h"
+
+#include <fstream>
+#include <stdio.h>
+#include <ghc/filesystem.hpp>
+
+#define FONT_CACHE_DIR "./data/cache/"
+#define FONT_CACHE_MAGIC 0x46444553 // SEDF
+#define FONT_CACHE_VERSION 1
+
+namespace ed
+{
+	static std::string getFontCachePath(uint64_t key)
+	{
+		char name[17] = { 0 };
+		snprintf(name, 17, "%016llx", (unsigned long long)key);
+
+		return std::string(FONT_CACHE_DIR) + "font_" + name + ".bin";
+	}
+	template <typename T>
+	static void writeValue(std::ofstream& file, const T& val)
+	{
+		file.write((const char*)&val, sizeof(T));
+	}
+	template <typename T>
+	static bool readValue(std::ifstream& file, T& val)
+	{
+		return (bool)file.read((char*)&val, sizeof(T));
+	}
+
+	uint64_t FontAtlasCache::Hash(const std::vector<Font>& fonts, const std::string& config)
+	{
+		// the glyphs are stored as they are in memory
+		uint64_t key = HashString(std::string(IMGUI_VERSION) + ";" + std::to_string(sizeof(ImFontGlyph)) + ";" + std::to_string(FONT_CACHE_VERSION));
+		key = HashString(config, key);
+
+		for (const Font& font : fonts) {
+			std::ifstream file(font.File, std::ios::binary);
+			std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+			key = HashString(font.File + ";" + std::to_string(font.Size) + ";" + std::to_string(data.size()), key);
+			key = HashData(data.data(), data.size(), key);
+		}
+
+		return key;
+	}
+	bool FontAtlasCache::Load(uint64_t key, ImFontAtlas* atlas, int fontCount)
+	{
+		std::ifstream file(getFontCachePath(key), std::ios::binary);
+		if (!file.is_open())
+			return false;
+
+		uint32_t magic = 0;
+		int width = 0, height = 0, count = 0;
+		ImVec2 whitePixel;
+		if (!readValue(file, magic) || magic != FONT_CACHE_MAGIC || !readValue(file, width) || !readValue(file, height) ||
+			!readValue(file, whitePixel) || !readValue(file, count) || count != fontCount || width <= 0 || height <= 0)
+			return false;
+
+		struct FontData
+		{
+			float Size, Scale, Ascent, Descent;
+			ImWchar Fallback, Ellipsis;
+			ImVec2 Offset;
+			ImVector<ImFontGlyph> Glyphs;
+		};
+		std::vector<FontData> data(count);
+		for (FontData& font : data) {
+			int glyphCount = 0;
+			if (!readValue(file, font.Size) || !readValue(file, font.Scale) || !readValue(file, font.Ascent) || !readValue(file, font.Descent) ||
+				!readValue(file, font.Fallback) || !readValue(file, font.Ellipsis) || !readValue(file, font.Offset) || !readValue(file, glyphCount) || glyphCount < 0)
+				return false;
+
+			font.Glyphs.resize(glyphCount);
+			if (glyphCount > 0 && !file.read((char*)font.Glyphs.Data, glyphCount * sizeof(ImFontGlyph)))
+				return false;
+		}
+
+		unsigned char* pixels = (unsigned char*)ImGui::MemAlloc(width * height);
+		if (!file.read((char*)pixels, width * height)) {
+			ImGui::MemFree(pixels);
+			return false;
+		}
+
+		// there are no TTF files behind these, the atlas can only be cleared & built again from scratch
+		atlas->Clear();
+		atlas->Flags |= ImFontAtlasFlags_NoMouseCursors;
+		atlas->ConfigData.resize(count);
+		for (int i = 0; i < count; i++) {
+			ImFontConfig& cfg = atlas->ConfigData[i];
+			cfg = ImFontConfig();
+			cfg.FontData = nullptr;
+			cfg.FontDataOwnedByAtlas = false;
+			cfg.SizePixels = data[i].Size;
+			snprintf(cfg.Name, sizeof(cfg.Name), "cached, %dpx", (int)data[i].Size);
+		}
+
+		for (int i = 0; i < count; i++) {
+			ImFont* font = IM_NEW(ImFont);
+			font->FontSize = data[i].Size;
+			font->Scale = data[i].Scale;
+			font->Ascent = data[i].Ascent;
+			font->Descent = data[i].Descent;
+			font->FallbackChar = data[i].Fallback;
+#if IMGUI_VERSION_NUM >= 17500
+			font->EllipsisChar = data[i].Ellipsis;
+#endif
+#if IMGUI_VERSION_NUM < 17800
+			font->DisplayOffset = data[i].Offset;
+#endif
+			font->ContainerAtlas = atlas;
+			font->ConfigData = &atlas->ConfigData[i];
+			font->ConfigDataCount = 1;
+			font->Glyphs.swap(data[i].Glyphs);
+			font->BuildLookupTable();
+
+			atlas->Fonts.push_back(font);
+		}
+
+		atlas->TexPixelsAlpha8 = pixels;
+		atlas->TexWidth = width;
+		atlas->TexHeight = height;
+		atlas->TexUvScale = ImVec2(1.0f / width, 1.0f / height);
+		atlas->TexUvWhitePixel = whitePixel;
+
+		return true;
+	}
+	void FontAtlasCache::Save(uint64_t key, ImFontAtlas* atlas)
+	{
+		unsigned char* pixels = nullptr;
+		int width = 0, height = 0;
+		atlas->GetTexDataAsAlpha8(&pixels, &width, &height);
+		if (pixels == nullptr || width <= 0 || height <= 0)
+			return;
+
+		std::error_code errCode;
+		if (!ghc::filesystem::exists(FONT_CACHE_DIR))
+			ghc::filesystem::create_directories(FONT_CACHE_DIR, errCode);
+
+		std::ofstream file(getFontCachePath(key), std::ios::binary);
+		if (!file.is_open()) {
+			Logger::Get().Log("Failed to write to the font cache", true);
+			return;
+		}
+
+		writeValue(file, (uint32_t)FONT_CACHE_MAGIC);
+		writeValue(file, width);
+		writeValue(file, height);
+		writeValue(file, atlas->TexUvWhitePixel);
+		writeValue(file, (int)atlas->Fonts.Size);
+		for (ImFont* font : atlas->Fonts) {
+			ImWchar ellipsis = (ImWchar)-1;
+			ImVec2 offset(0.0f, 0.0f);
+#if IMGUI_VERSION_NUM >= 17500
+			ellipsis = font->EllipsisChar;
+#endif
+#if IMGUI_VERSION_NUM < 17800
+			offset = font->DisplayOffset;
+#endif
+			writeValue(file, font->FontSize);
+			writeValue(file, font->Scale);
+			writeValue(file, font->Ascent);
+			writeValue(file, font->Descent);
+			writeValue(file, font->FallbackChar);
+			writeValue(file, ellipsis);
+			writeValue(file, offset);
+			writeValue(file, (int)font->Glyphs.Size);
+			if (font->Glyphs.Size > 0)
+				file.write((const char*)font->Glyphs.Data, font->Glyphs.Size * sizeof(ImFontGlyph));
+		}
+		file.write((const char*)pixels, width * height);
+	}
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <imgui/imgui.h>
+
+namespace ed
+{
+	// rasterized ImGui font atlases stored on disk - the texture & the glyph tables are read back instead of
+	// rasterizing the TTF files on every startup and DPI/font size change
+	class FontAtlasCache
+	{
+	public:
+		struct Font
+		{
+			std::string File;
+			float Size; // in pixels, DPI scale included
+		};
+
+		// contents of the files, the sizes and anything else that changes the atlas (ranges, oversampling...) are hashed
+		static uint64_t Hash(const std::vector<Font>& fonts, const std::string& config);
+
+		// fills an empty atlas - false if there's no valid entry that has fontCount fonts (ImFonts, merged fonts aren't counted)
+		static bool Load(uint64_t key, ImFontAtlas* atlas, int fontCount);
+		static void Save(uint64_t key, ImFontAtlas* atlas); // atlas has to be built
+	};
+}
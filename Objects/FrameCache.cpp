@@ -0,0 +1,197 @@
+#include "FrameCache.h"
+#include "PipelineManager.h"
+#include "RenderEngine.h"
+#include "SystemVariableManager.h"
+#include "FunctionVariableManager.h"
+#include "Hash.h"
+
+#include <algorithm>
+
+namespace ed
+{
+	static uint64_t hashVariables(ShaderVariableContainer& vars, uint64_t hash, bool& usesInput)
+	{
+		for (ShaderVariable* var : vars.GetVariables()) {
+			SystemShaderVariable sys = var->System;
+			if (sys == SystemShaderVariable::MousePosition || sys == SystemShaderVariable::Mouse || sys == SystemShaderVariable::MouseButton || sys == SystemShaderVariable::KeysWASD)
+				usesInput = true;
+
+			// system values are covered by the camera & input, functions by their arguments
+			if (sys == SystemShaderVariable::None && var->Function == FunctionShaderVariable::None)
+				hash = HashData(var->Data, ShaderVariable::GetSize(var->GetType()), hash);
+			else if (var->Function != FunctionShaderVariable::None && var->Arguments != nullptr) {
+				size_t argSize = (var->Function == FunctionShaderVariable::CameraSnapshot) ? VARIABLE_NAME_LENGTH : (FunctionVariableManager::GetArgumentCount(var->Function) * sizeof(float));
+				hash = HashData(&var->Function, sizeof(var->Function), hash);
+				hash = HashData(var->Arguments, argSize, hash);
+			}
+		}
+		return hash;
+	}
+
+	FrameCache::FrameCache()
+	{
+		m_size = glm::ivec2(0, 0);
+		m_memory = 0;
+		m_budget = 0;
+		m_signature = 0;
+		m_fbo[0] = m_fbo[1] = 0;
+	}
+	FrameCache::~FrameCache()
+	{
+		Clear();
+		if (m_fbo[0] != 0)
+			glDeleteFramebuffers(2, m_fbo);
+	}
+	uint64_t FrameCache::GetSignature(PipelineManager* pipeline, RenderEngine* renderer, const glm::ivec2& size)
+	{
+		uint64_t hash = HashData(&size, sizeof(size));
+
+		unsigned int generation[2] = { pipeline->GetGeneration(), renderer->GetContentGeneration() };
+		hash = HashData(generation, sizeof(generation), hash);
+
+		bool usesInput = false;
+		for (PipelineItem* item : pipeline->GetList()) {
+			if (item->Type == PipelineItem::ItemType::ComputePass)
+				hash = hashVariables(((pipe::ComputePass*)item->Data)->Variables, hash, usesInput);
+			else if (item->Type == PipelineItem::ItemType::ShaderPass) {
+				pipe::ShaderPass* pass = (pipe::ShaderPass*)item->Data;
+				hash = hashVariables(pass->Variables, hash, usesInput);
+
+				// the gizmo moves the items without notifying the pipeline
+				for (PipelineItem* child : pass->Items) {
+					glm::vec3 trans[3];
+					if (child->Type == PipelineItem::ItemType::Geometry) {
+						pipe::GeometryItem* geo = (pipe::GeometryItem*)child->Data;
+						trans[0] = geo->Position;
+						trans[1] = geo->Rotation;
+						trans[2] = geo->Scale;
+					}
+					else if (child->Type == PipelineItem::ItemType::Model) {
+						pipe::Model* mdl = (pipe::Model*)child->Data;
+						trans[0] = mdl->Position;
+						trans[1] = mdl->Rotation;
+						trans[2] = mdl->Scale;
+					}
+					else
+						continue;
+					hash = HashData(trans, sizeof(trans), hash);
+				}
+			}
+		}
+
+		SystemVariableManager& systemVM = SystemVariableManager::Instance();
+		glm::mat4 view = systemVM.GetViewMatrix();
+		hash = HashData(&view, sizeof(view), hash);
+
+		// moving the mouse over the preview shouldn't throw the frames away unless a shader reads it
+		if (usesInput) {
+			glm::vec4 mouse[2] = { systemVM.GetMouse(), systemVM.GetMouseButton() };
+			glm::ivec4 wasd = systemVM.GetKeysWASD();
+			hash = HashData(mouse, sizeof(mouse), hash);
+			hash = HashData(&wasd, sizeof(wasd), hash);
+		}
+
+		return hash;
+	}
+	bool FrameCache::Validate(uint64_t signature)
+	{
+		if (signature == m_signature)
+			return true;
+
+		m_signature = signature;
+		if (m_frames.empty())
+			return true;
+
+		Clear();
+		return false;
+	}
+	void FrameCache::Store(unsigned int frame, float time, GLuint tex, const glm::ivec2& size)
+	{
+		m_times[frame] = time;
+		if (m_times.size() > FRAME_CACHE_MAX_TIMES)
+			m_times.erase(m_times.begin());
+
+		glm::ivec2 cacheSize = glm::max(glm::ivec2(glm::vec2(size) * FRAME_CACHE_SCALE), glm::ivec2(1, 1));
+		size_t frameSize = (size_t)cacheSize.x * cacheSize.y * 4;
+		if (frameSize > m_budget)
+			return;
+
+		if (cacheSize != m_size) {
+			Clear();
+			m_size = cacheSize;
+		}
+
+		GLuint cached = 0;
+		auto it = m_frames.find(frame);
+		if (it != m_frames.end())
+			cached = it->second; // rendered again, e.g. after a seek
+		else {
+			// the evicted texture has the same size so it's reused
+			while (m_memory + frameSize > m_budget && !m_order.empty()) {
+				auto oldest = m_frames.find(m_order.front());
+				m_order.pop_front();
+				if (cached == 0)
+					cached = oldest->second;
+				else
+					glDeleteTextures(1, &oldest->second);
+				m_frames.erase(oldest);
+				m_memory -= frameSize;
+			}
+
+			if (cached == 0) {
+				glGenTextures(1, &cached);
+				glBindTexture(GL_TEXTURE_2D, cached);
+				glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_size.x, m_size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+				glBindTexture(GL_TEXTURE_2D, 0);
+			}
+
+			m_frames[frame] = cached;
+			m_order.push_back(frame);
+			m_memory += frameSize;
+		}
+
+		if (m_fbo[0] == 0)
+			glGenFramebuffers(2, m_fbo);
+
+		// downscaled on the GPU, nothing is read back
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fbo[0]);
+		glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex, 0);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_fbo[1]);
+		glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, cached, 0);
+		glBlitFramebuffer(0, 0, size.x, size.y, 0, 0, m_size.x, m_size.y, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	}
+	GLuint FrameCache::Get(unsigned int frame)
+	{
+		auto it = m_frames.find(frame);
+		return it == m_frames.end() ? 0 : it->second;
+	}
+	bool FrameCache::GetTime(unsigned int frame, float& time)
+	{
+		auto it = m_times.find(frame);
+		if (it == m_times.end())
+			return false;
+
+		time = it->second;
+		return true;
+	}
+	void FrameCache::Clear()
+	{
+		for (auto& frame : m_frames)
+			glDeleteTextures(1, &frame.second);
+		m_frames.clear();
+		m_order.clear();
+		m_memory = 0;
+	}
+	void FrameCache::Reset()
+	{
+		Clear();
+		m_times.clear();
+		m_signature = 0;
+	}
+}
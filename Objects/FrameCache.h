@@ -0,0 +1,62 @@
+#pragma once
+#include <map>
+#include <deque>
+#include <stdint.h>
+#include <glm/glm.hpp>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/glew.h>
+#if defined(__APPLE__)
+	#include <OpenGL/gl.h>
+#else
+	#include <GL/gl.h>
+#endif
+
+#define FRAME_CACHE_SCALE 0.5f		// cached frames have half of the preview resolution
+#define FRAME_CACHE_MAX_TIMES 100000 // frames that the timeline remembers the time of
+
+namespace ed
+{
+	class PipelineManager;
+	class RenderEngine;
+
+	// reduced resolution copies of the recently rendered preview frames in VRAM, indexed by the frame index - the timeline
+	// shows them again instead of rendering the frame, anything other than the time & frame index that changes clears them
+	class FrameCache
+	{
+	public:
+		FrameCache();
+		~FrameCache();
+
+		inline void SetBudget(int megabytes) { m_budget = (size_t)megabytes * 1024 * 1024; }
+
+		// the inputs of the frame (shaders, variables, camera, size...), the cache is cleared when they change
+		static uint64_t GetSignature(PipelineManager* pipeline, RenderEngine* renderer, const glm::ivec2& size);
+		bool Validate(uint64_t signature); // false if the cached frames were thrown away
+
+		void Store(unsigned int frame, float time, GLuint tex, const glm::ivec2& size); // copies the texture on the GPU
+		GLuint Get(unsigned int frame); // 0 if the frame isn't cached
+		bool GetTime(unsigned int frame, float& time); // frames that were evicted still have their time
+
+		void Clear(); // the frames
+		void Reset(); // the frames & times, when a different project is opened
+
+		inline bool IsEmpty() { return m_times.empty(); }
+		inline bool IsCached(unsigned int frame) { return m_frames.count(frame) > 0; }
+		inline unsigned int GetFirstFrame() { return m_times.empty() ? 0 : m_times.begin()->first; }
+		inline unsigned int GetLastFrame() { return m_times.empty() ? 0 : m_times.rbegin()->first; }
+		inline const std::map<unsigned int, GLuint>& GetFrames() { return m_frames; }
+		inline size_t GetMemory() { return m_memory; }
+
+	private:
+		std::map<unsigned int, GLuint> m_frames;
+		std::deque<unsigned int> m_order; // oldest first
+		std::map<unsigned int, float> m_times;
+		glm::ivec2 m_size; // all cached frames have the same size since it's a part of the signature
+		size_t m_memory, m_budget;
+		uint64_t m_signature;
+		GLuint m_fbo[2]; // read & draw
+	};
+}
@@ -0,0 +1,115 @@
+#include "FrameProfiler.h"
+#include "TraceRecorder.h"
+
+#include <algorithm>
+
+namespace ed
+{
+	const char* FrameProfiler::GetStageName(int stage)
+	{
+		static const char* names[StageCount] = {
+			"Events",
+			"UI",
+			"Objects",
+			"Render submission",
+			"Plugins",
+			"UI draw",
+			"GPU wait",
+			"Swap",
+			"Idle"
+		};
+		return (stage >= 0 && stage < StageCount) ? names[stage] : "";
+	}
+	bool FrameProfiler::IsNested(int stage)
+	{
+		return stage == Objects || stage == Render || stage == Plugins;
+	}
+
+	FrameProfiler::Timing::Timing()
+	{
+		Last = Average = Max = Frame = 0.0f;
+		for (int i = 0; i < FRAME_PROFILER_HISTORY; i++)
+			History[i] = 0.0f;
+		HistoryIndex = Samples = 0;
+	}
+
+	FrameProfiler::FrameProfiler()
+	{
+		ShowOverlay = false;
+		m_enabled = false;
+		m_started = false;
+		for (int i = 0; i < StageCount; i++)
+			m_running[i] = 0;
+	}
+	void FrameProfiler::Add(Stage stage, std::chrono::steady_clock::time_point start)
+	{
+		auto now = std::chrono::steady_clock::now();
+		m_stages[stage].Frame += std::chrono::duration<float, std::milli>(now - start).count();
+		if (TraceRecorder::Instance().IsRecording())
+			TraceRecorder::Instance().AddZone(GetStageName(stage), "stage", start, now);
+	}
+	void FrameProfiler::AddView(const std::string& name, std::chrono::steady_clock::time_point start)
+	{
+		auto now = std::chrono::steady_clock::now();
+		float time = std::chrono::duration<float, std::milli>(now - start).count();
+		TraceRecorder::Instance().AddZone(name, "view", start, now);
+
+		auto it = std::find_if(m_views.begin(), m_views.end(), [&](const View& view) { return view.Name == name; });
+		if (it == m_views.end()) {
+			m_views.push_back(View());
+			m_views.back().Name = name;
+			it = m_views.end() - 1;
+		}
+		it->Time.Frame += time;
+	}
+	void FrameProfiler::EndFrame()
+	{
+		auto now = std::chrono::steady_clock::now();
+		if (!m_started) {
+			m_started = true;
+			m_frameStart = now;
+			for (int i = 0; i < StageCount; i++)
+				m_stages[i].Frame = 0.0f;
+			for (View& view : m_views)
+				view.Time.Frame = 0.0f;
+			return;
+		}
+
+		float frame = std::chrono::duration<float, std::milli>(now - m_frameStart).count();
+		m_frameStart = now;
+
+		float covered = 0.0f;
+		for (int i = 0; i < StageCount; i++) {
+			if (!IsNested(i))
+				covered += m_stages[i].Frame;
+			m_push(m_stages[i], m_stages[i].Frame);
+		}
+		for (View& view : m_views)
+			m_push(view.Time, view.Time.Frame);
+		m_push(m_frame, frame);
+		m_push(m_other, std::max(frame - covered, 0.0f));
+	}
+	void FrameProfiler::ResetStats()
+	{
+		for (int i = 0; i < StageCount; i++)
+			m_stages[i] = Timing();
+		m_views.clear();
+		m_frame = m_other = Timing();
+		m_started = false;
+	}
+	void FrameProfiler::m_push(Timing& timing, float value)
+	{
+		timing.History[timing.HistoryIndex] = value;
+		timing.HistoryIndex = (timing.HistoryIndex + 1) % FRAME_PROFILER_HISTORY;
+		timing.Samples = std::min(timing.Samples + 1, FRAME_PROFILER_HISTORY);
+		timing.Last = value;
+		timing.Frame = 0.0f;
+
+		timing.Average = timing.Max = 0.0f;
+		for (int i = 0; i < timing.Samples; i++) {
+			timing.Average += timing.History[i];
+			timing.Max = std::max(timing.Max, timing.History[i]);
+		}
+		timing.Average /= timing.Samples;
+	}
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include <chrono>
+#include <string>
+#include <vector>
+
+#define FRAME_PROFILER_HISTORY 120 // frames that the average & the maximum are calculated from
+
+namespace ed
+{
+	// CPU time of the application's frames split into the stages of the main loop & the UI views - the nested stages
+	// are a part of the UI stage (the preview view renders the pipeline, the plugin callbacks happen in all of them)
+	class FrameProfiler
+	{
+	public:
+		static inline FrameProfiler& Instance()
+		{
+			static FrameProfiler ret;
+			return ret;
+		}
+
+		enum Stage
+		{
+			Events,	 // SDL events & the views' OnEvent()
+			UI,		 // building the ImGui UI
+			Objects, // ObjectManager::Update()
+			Render,	 // RenderEngine::Render(), the pipeline's draw calls
+			Plugins, // plugin callbacks
+			Draw,	 // submitting the ImGui draw lists
+			GPUWait, // waiting for the GPU to finish the frame
+			Swap,	 // SDL_GL_SwapWindow()
+			Idle,	 // frame limiter & waiting for events
+			StageCount
+		};
+		static const char* GetStageName(int stage);
+		static bool IsNested(int stage);
+
+		struct Timing
+		{
+			Timing();
+
+			float Last, Average, Max; // milliseconds
+			float Frame;
+			float History[FRAME_PROFILER_HISTORY];
+			int HistoryIndex, Samples;
+		};
+		struct View
+		{
+			std::string Name;
+			Timing Time;
+		};
+
+		// measures the time until it goes out of scope, a stage that's already being measured isn't counted twice
+		class Scope
+		{
+		public:
+			inline Scope(Stage stage) : m_stage(stage), m_start(std::chrono::steady_clock::now()) { FrameProfiler::Instance().m_running[stage]++; }
+			inline ~Scope()
+			{
+				if (--FrameProfiler::Instance().m_running[m_stage] == 0)
+					FrameProfiler::Instance().Add(m_stage, m_start);
+			}
+
+		private:
+			Stage m_stage;
+			std::chrono::steady_clock::time_point m_start;
+		};
+		class ViewScope
+		{
+		public:
+			inline ViewScope(const std::string& name) : m_name(name), m_start(std::chrono::steady_clock::now()) {}
+			inline ~ViewScope() { FrameProfiler::Instance().AddView(m_name, m_start); }
+
+		private:
+			const std::string& m_name;
+			std::chrono::steady_clock::time_point m_start;
+		};
+
+		FrameProfiler();
+
+		// GPUWait is only measured while the breakdown is shown - the CPU has to stop & wait for the GPU to be
+		// able to tell it apart from the swap
+		inline bool IsEnabled() { return m_enabled; }
+		inline void SetEnabled(bool enabled) { m_enabled = enabled; }
+		bool ShowOverlay; // draw the breakdown over the preview
+
+		void Add(Stage stage, std::chrono::steady_clock::time_point start);
+		void AddView(const std::string& name, std::chrono::steady_clock::time_point start);
+		void EndFrame();
+
+		inline const Timing& Get(int stage) { return m_stages[stage]; }
+		inline const std::vector<View>& GetViews() { return m_views; }
+		inline const Timing& GetFrame() { return m_frame; }
+		inline const Timing& GetOther() { return m_other; } // the frame time that isn't covered by the top level stages
+
+		void ResetStats();
+
+	private:
+		void m_push(Timing& timing, float value);
+
+		bool m_enabled;
+		int m_running[StageCount];
+		Timing m_stages[StageCount];
+		std::vector<View> m_views;
+		Timing m_frame, m_other;
+
+		bool m_started;
+		std::chrono::steady_clock::time_point m_frameStart;
+	};
+}
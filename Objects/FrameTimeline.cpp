@@ -0,0 +1,111 @@
+#include "FrameTimeline.h"
+#include "GPUProfiler.h"
+#include "PipelineItem.h"
+
+#include <algorithm>
+
+namespace ed
+{
+	FrameTimeline::FrameTimeline()
+	{
+		m_frames.resize(FRAME_TIMELINE_HISTORY);
+		m_start = m_count = 0;
+		m_started = false;
+	}
+	void FrameTimeline::AddFrame(unsigned int index)
+	{
+		auto now = std::chrono::steady_clock::now();
+
+		if (!m_started) {
+			m_started = true;
+			m_last = now;
+			return;
+		}
+
+		Frame* frame = nullptr;
+		if (m_count < FRAME_TIMELINE_HISTORY)
+			frame = &m_frames[(m_start + m_count++) % FRAME_TIMELINE_HISTORY];
+		else {
+			frame = &m_frames[m_start];
+			m_start = (m_start + 1) % FRAME_TIMELINE_HISTORY;
+		}
+
+		frame->Index = index;
+		frame->Time = std::chrono::duration<float, std::milli>(now - m_last).count();
+		frame->GPU = 0.0f;
+		frame->Drawn = false;
+		frame->Passes.clear();
+
+		m_last = now;
+	}
+	void FrameTimeline::DrawFrame(GPUProfiler& profiler, const std::vector<PipelineItem*>& passes)
+	{
+		if (m_count == 0)
+			return;
+
+		if (profiler.IsEnabled()) {
+			int prev = m_count - 2;
+			while (prev >= 0 && !Get(prev).Drawn)
+				prev--;
+
+			if (prev >= 0) {
+				Frame& frame = m_frames[(m_start + prev) % FRAME_TIMELINE_HISTORY];
+				frame.Passes.clear();
+				frame.GPU = 0.0f;
+				for (PipelineItem* pass : passes) {
+					if (!profiler.Has(pass))
+						continue;
+					float time = profiler.Get(pass).Last;
+					frame.Passes.push_back({ pass->Name, time });
+					frame.GPU += time;
+				}
+			}
+		}
+
+		m_frames[(m_start + m_count - 1) % FRAME_TIMELINE_HISTORY].Drawn = true;
+	}
+	void FrameTimeline::Restart()
+	{
+		m_started = false;
+	}
+	void FrameTimeline::Clear()
+	{
+		m_start = m_count = 0;
+		m_started = false;
+	}
+	FrameTimeline::Stats FrameTimeline::GetStats()
+	{
+		Stats ret;
+		if (m_count == 0)
+			return ret;
+
+		std::vector<float> times(m_count);
+		for (int i = 0; i < m_count; i++)
+			times[i] = Get(i).Time;
+		std::sort(times.begin(), times.end());
+
+		auto percentile = [&](float p) -> float {
+			return times[std::min<int>(m_count - 1, (int)(p * m_count))];
+		};
+		ret.P50 = percentile(0.50f);
+		ret.P95 = percentile(0.95f);
+		ret.P99 = percentile(0.99f);
+		ret.Max = times.back();
+
+		return ret;
+	}
+	std::vector<int> FrameTimeline::GetWorst()
+	{
+		std::vector<int> ret(m_count);
+		for (int i = 0; i < m_count; i++)
+			ret[i] = i;
+
+		int count = std::min<int>(m_count, FRAME_TIMELINE_WORST);
+		std::partial_sort(ret.begin(), ret.begin() + count, ret.end(), [&](int a, int b) {
+			return Get(a).Time > Get(b).Time;
+		});
+		ret.resize(count);
+
+		return ret;
+	}
+}
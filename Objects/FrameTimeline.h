@@ -0,0 +1,59 @@
+#pragma once
+#include <chrono>
+#include <string>
+#include <vector>
+
+#define FRAME_TIMELINE_HISTORY 600 // frames kept by the frame time graph
+#define FRAME_TIMELINE_WORST 5 // slowest frames that get a marker
+
+namespace ed
+{
+	class GPUProfiler;
+	struct PipelineItem;
+
+	// rolling history of the preview's frames for the frame time graph - each frame keeps the GPU time of its
+	// passes so that a spike can still be inspected after it scrolled past
+	class FrameTimeline
+	{
+	public:
+		struct Pass
+		{
+			std::string Name;
+			float Time; // ms
+		};
+		struct Frame
+		{
+			unsigned int Index; // SystemVariableManager's frame index
+			float Time;			// ms since the previous frame
+			float GPU;			// ms, sum of the passes - 0 if the profiler wasn't running
+			bool Drawn;			// false if the previous frame was shown again
+			std::vector<Pass> Passes;
+		};
+		struct Stats
+		{
+			Stats() { P50 = P95 = P99 = Max = 0.0f; }
+			float P50, P95, P99, Max; // ms
+		};
+
+		FrameTimeline();
+
+		void AddFrame(unsigned int index);
+		// the current frame is drawn - the profiler reads the queries back one frame late, so the pass times go to the
+		// frame that was drawn before this one
+		void DrawFrame(GPUProfiler& profiler, const std::vector<PipelineItem*>& passes);
+		void Restart(); // the time until the next frame isn't counted (pause)
+		void Clear();
+
+		inline int GetCount() { return m_count; }
+		inline const Frame& Get(int i) { return m_frames[(m_start + i) % FRAME_TIMELINE_HISTORY]; } // 0 = oldest
+		Stats GetStats();
+		std::vector<int> GetWorst(); // indices for Get(), slowest first
+
+	private:
+		std::vector<Frame> m_frames;
+		int m_start, m_count;
+
+		bool m_started;
+		std::chrono::steady_clock::time_point m_last;
+	};
+}
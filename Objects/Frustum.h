@@ -0,0 +1,46 @@
+#pragma once
+#include <glm/glm.hpp>
+
+namespace ed
+{
+	// view frustum planes extracted from a view-projection matrix, used to skip items that can't be visible
+	class Frustum
+	{
+	public:
+		inline void Set(const glm::mat4& viewProj)
+		{
+			for (int i = 0; i < 3; i++) {
+				glm::vec4 row(viewProj[0][i], viewProj[1][i], viewProj[2][i], viewProj[3][i]);
+				glm::vec4 w(viewProj[0][3], viewProj[1][3], viewProj[2][3], viewProj[3][3]);
+				m_planes[i * 2 + 0] = w + row;
+				m_planes[i * 2 + 1] = w - row;
+			}
+		}
+
+		// local space bounds transformed by world - conservative, boxes near the frustum corners can pass
+		inline bool Intersects(const glm::mat4& world, const glm::vec3& minBound, const glm::vec3& maxBound) const
+		{
+			glm::vec3 center = glm::vec3(world * glm::vec4((minBound + maxBound) * 0.5f, 1.0f));
+			glm::vec3 halfSize = (maxBound - minBound) * 0.5f;
+
+			// world space extents of the transformed box
+			glm::mat3 basis(world);
+			glm::vec3 extents = glm::abs(basis[0]) * halfSize.x + glm::abs(basis[1]) * halfSize.y + glm::abs(basis[2]) * halfSize.z;
+
+			for (int i = 0; i < 6; i++) {
+				glm::vec3 normal(m_planes[i]);
+				float dist = glm::dot(normal, center) + m_planes[i].w;
+				float radius = glm::dot(glm::abs(normal), extents);
+				if (dist + radius < 0.0f)
+					return false;
+			}
+
+			return true;
+		}
+
+		inline const glm::vec4* GetPlanes() const { return m_planes; }
+
+	private:
+		glm::vec4 m_planes[6]; // left, right, bottom, top, near, far
+	};
+}
@@ -1,5 +1,6 @@
 #include "FunctionVariableManager.h"
 #include "CameraSnapshots.h"
+#include <algorithm>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -8,6 +9,9 @@ namespace ed
 {
 	int FunctionVariableManager::CurrentIndex = 0;
 	std::vector<ed::ShaderVariable*> FunctionVariableManager::VariableList = std::vector<ed::ShaderVariable*>();
+	std::unordered_set<ed::ShaderVariable*> FunctionVariableManager::m_listed;
+	std::unordered_map<std::string, ed::ShaderVariable*> FunctionVariableManager::m_names;
+	unsigned int FunctionVariableManager::m_generation = 0;
 
 	size_t FunctionVariableManager::GetArgumentCount(ed::FunctionShaderVariable func)
 	{
@@ -106,35 +110,83 @@ namespace ed
 	}
 	void FunctionVariableManager::AddToList(ed::ShaderVariable* var)
 	{
-		int& curIndex = FunctionVariableManager::CurrentIndex;
-		std::vector<ed::ShaderVariable*>& varList = FunctionVariableManager::VariableList;
-		for (int i = 0; i < curIndex; i++)
-			if(varList[i] == var)
-				return; // already exists
-		if (curIndex % 20 == 0)
-			varList.resize(curIndex+20);
-		varList[curIndex] = var;
-		curIndex++;
+		if (!m_listed.insert(var).second)
+			return; // already exists
+
+		VariableList.push_back(var);
+		CurrentIndex = VariableList.size();
+
+		m_names.insert(std::make_pair(std::string(var->Name), var));
 	}
-	void FunctionVariableManager::Update(ed::ShaderVariable* var)
+	void FunctionVariableManager::RemoveFromList(ed::ShaderVariable* var)
 	{
+		if (m_listed.erase(var) == 0)
+			return;
 
+		VariableList.erase(std::find(VariableList.begin(), VariableList.end(), var));
+		CurrentIndex = VariableList.size();
+
+		// another variable with the same name might be next in line
+		m_names.clear();
+		for (ed::ShaderVariable* listed : VariableList)
+			m_names.insert(std::make_pair(std::string(listed->Name), listed));
+
+		m_generation++;
+	}
+	void FunctionVariableManager::Update(ed::ShaderVariable* var)
+	{
 		if (var->Function == FunctionShaderVariable::None)
 			return;
 
 		if (var->Function == FunctionShaderVariable::Pointer) {
-			std::vector<ed::ShaderVariable*>& varList = FunctionVariableManager::VariableList;
-			for (int i = 0; i < varList.size(); i++) {
-				if (varList[i] == nullptr)
-					continue;
+			ed::ShaderVariable* src = m_resolvePointer(var);
+			if (src != nullptr && src != var)
+				memcpy(var->Data, src->Data, ShaderVariable::GetSize(var->GetType()));
+			return;
+		}
 
-				if (strcmp(varList[i]->Name, var->Arguments) == 0) {
-					memcpy(var->Data, varList[i]->Data, ShaderVariable::GetSize(var->GetType()));
-					break;
-				}
-			}
+		// plugins can return a different value every time
+		if (var->Function == FunctionShaderVariable::PluginFunction) {
+			m_evaluate(var);
+			return;
 		}
-		else if (var->Function == FunctionShaderVariable::CameraSnapshot) {
+
+		// the other functions only depend on their arguments
+		ShaderVariable::FunctionCacheData& cache = var->FunctionCache;
+		size_t argSize = (var->Function == FunctionShaderVariable::CameraSnapshot) ? VARIABLE_NAME_LENGTH : (GetArgumentCount(var->Function) * sizeof(float));
+		size_t size = ShaderVariable::GetSize(var->GetType());
+		unsigned int generation = (var->Function == FunctionShaderVariable::CameraSnapshot) ? CameraSnapshots::Generation : 0;
+
+		if (cache.Function == var->Function && cache.Generation == generation && cache.Result.size() == size && cache.Arguments.size() == argSize &&
+			(argSize == 0 || memcmp(cache.Arguments.data(), var->Arguments, argSize) == 0)) {
+			memcpy(var->Data, cache.Result.data(), size); // Data can be modified after this (inverse, etc...)
+			return;
+		}
+
+		m_evaluate(var);
+
+		cache.Function = var->Function;
+		cache.Generation = generation;
+		cache.Arguments.assign(var->Arguments, var->Arguments + argSize);
+		cache.Result.assign(var->Data, var->Data + size);
+	}
+	ed::ShaderVariable* FunctionVariableManager::m_resolvePointer(ed::ShaderVariable* var)
+	{
+		ShaderVariable::FunctionCacheData& cache = var->FunctionCache;
+		if (cache.Function == FunctionShaderVariable::Pointer && cache.Generation == m_generation && cache.Source != nullptr && strcmp(cache.Source->Name, var->Arguments) == 0)
+			return cache.Source;
+
+		// variables that weren't bound yet are looked up again on the next bind
+		auto it = m_names.find(var->Arguments);
+		cache.Function = FunctionShaderVariable::Pointer;
+		cache.Generation = m_generation;
+		cache.Source = (it == m_names.end()) ? nullptr : it->second;
+
+		return cache.Source;
+	}
+	void FunctionVariableManager::m_evaluate(ed::ShaderVariable* var)
+	{
+		if (var->Function == FunctionShaderVariable::CameraSnapshot) {
 			glm::mat4 camVal = CameraSnapshots::Get(var->Arguments);
 			memcpy(var->Data, glm::value_ptr(camVal), sizeof(glm::mat4));
 		}
@@ -290,6 +342,10 @@ namespace ed
 	{
 		FunctionVariableManager::VariableList.clear();
 		FunctionVariableManager::CurrentIndex = 0;
+
+		m_listed.clear();
+		m_names.clear();
+		m_generation++;
 	}
 	float * FunctionVariableManager::LoadFloat(char* data, int index)
 	{
@@ -1,6 +1,9 @@
 #pragma once
 #include "ShaderVariable.h"
 #include <vector>
+#include <string>
+#include <unordered_set>
+#include <unordered_map>
 
 namespace ed
 {
@@ -11,6 +14,7 @@ namespace ed
 		static void AllocateArgumentSpace(ed::ShaderVariable* var, ed::FunctionShaderVariable func);
 		static bool HasValidReturnType(ShaderVariable::ValueType ret, ed::FunctionShaderVariable func);
 		static void AddToList(ed::ShaderVariable* var);
+		static void RemoveFromList(ed::ShaderVariable* var); // the variable is about to be deleted
 		static void Update(ed::ShaderVariable* var);
 		static float* LoadFloat(char* data, int index);
 
@@ -18,5 +22,13 @@ namespace ed
 
 		static int CurrentIndex;
 		static std::vector<ed::ShaderVariable*> VariableList;
+
+	private:
+		static void m_evaluate(ed::ShaderVariable* var);
+		static ed::ShaderVariable* m_resolvePointer(ed::ShaderVariable* var);
+
+		static std::unordered_set<ed::ShaderVariable*> m_listed;
+		static std::unordered_map<std::string, ed::ShaderVariable*> m_names; // first variable in the list with the name
+		static unsigned int m_generation; // changes when the list is cleared or a variable is removed
 	};
 }
\ No newline at end of file
@@ -0,0 +1,211 @@
+#include "GLStateCache.h"
+
+#include <limits>
+
+#define STATE_UNKNOWN 0xFFFFFFFF
+
+namespace ed
+{
+	static const GLenum capEnums[] = { GL_DEPTH_CLAMP, GL_CULL_FACE, GL_BLEND, GL_DEPTH_TEST, GL_STENCIL_TEST };
+
+	GLStateCache::GLStateCache()
+	{
+		m_samplerUnits = 0;
+		Invalidate();
+	}
+	void GLStateCache::Invalidate()
+	{
+		const float unknown = std::numeric_limits<float>::quiet_NaN(); // NaN never equals anything
+
+		for (int i = 0; i < CapCount; i++)
+			m_caps[i] = -1;
+
+		m_polygonMode = m_cullFace = m_frontFace = STATE_UNKNOWN;
+		m_blendEq[0] = m_blendEq[1] = STATE_UNKNOWN;
+		for (int i = 0; i < 4; i++) {
+			m_blendFunc[i] = STATE_UNKNOWN;
+			m_blendColor[i] = unknown;
+		}
+		m_sampleCoverage = unknown;
+		m_sampleCoverageInvert = -1;
+		m_depthMask = -1;
+		m_depthFunc = STATE_UNKNOWN;
+		m_polygonOffset[0] = m_polygonOffset[1] = unknown;
+		for (int i = 0; i < 2; i++) {
+			m_stencilFunc[i] = STATE_UNKNOWN;
+			m_stencilRef[i] = 0;
+			m_stencilFuncMask[i] = 0;
+			m_stencilOp[i][0] = m_stencilOp[i][1] = m_stencilOp[i][2] = STATE_UNKNOWN;
+		}
+		m_stencilMask = 0;
+		m_stencilMaskKnown = false;
+
+		// m_samplerUnits is kept so that UnbindSamplers() still resets the units
+		for (int i = 0; i < GL_STATE_SAMPLER_UNITS; i++)
+			m_samplers[i] = STATE_UNKNOWN;
+	}
+	void GLStateCache::Enable(GLenum cap, bool enable)
+	{
+		int id = -1;
+		for (int i = 0; i < CapCount; i++)
+			if (capEnums[i] == cap) {
+				id = i;
+				break;
+			}
+
+		// not tracked
+		if (id == -1) {
+			if (enable) glEnable(cap);
+			else glDisable(cap);
+			return;
+		}
+
+		if (m_caps[id] == (int)enable)
+			return;
+
+		m_caps[id] = enable;
+		if (enable) glEnable(cap);
+		else glDisable(cap);
+	}
+	void GLStateCache::PolygonMode(GLenum mode)
+	{
+		if (m_polygonMode == mode)
+			return;
+		m_polygonMode = mode;
+		glPolygonMode(GL_FRONT_AND_BACK, mode);
+	}
+	void GLStateCache::CullFace(GLenum face)
+	{
+		if (m_cullFace == face)
+			return;
+		m_cullFace = face;
+		glCullFace(face);
+	}
+	void GLStateCache::FrontFace(GLenum dir)
+	{
+		if (m_frontFace == dir)
+			return;
+		m_frontFace = dir;
+		glFrontFace(dir);
+	}
+	void GLStateCache::BlendEquationSeparate(GLenum color, GLenum alpha)
+	{
+		if (m_blendEq[0] == color && m_blendEq[1] == alpha)
+			return;
+		m_blendEq[0] = color;
+		m_blendEq[1] = alpha;
+		glBlendEquationSeparate(color, alpha);
+	}
+	void GLStateCache::BlendFuncSeparate(GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha)
+	{
+		if (m_blendFunc[0] == srcRGB && m_blendFunc[1] == dstRGB && m_blendFunc[2] == srcAlpha && m_blendFunc[3] == dstAlpha)
+			return;
+		m_blendFunc[0] = srcRGB;
+		m_blendFunc[1] = dstRGB;
+		m_blendFunc[2] = srcAlpha;
+		m_blendFunc[3] = dstAlpha;
+		glBlendFuncSeparate(srcRGB, dstRGB, srcAlpha, dstAlpha);
+	}
+	void GLStateCache::BlendColor(float r, float g, float b, float a)
+	{
+		if (m_blendColor[0] == r && m_blendColor[1] == g && m_blendColor[2] == b && m_blendColor[3] == a)
+			return;
+		m_blendColor[0] = r;
+		m_blendColor[1] = g;
+		m_blendColor[2] = b;
+		m_blendColor[3] = a;
+		glBlendColor(r, g, b, a);
+	}
+	void GLStateCache::SampleCoverage(float value, bool invert)
+	{
+		if (m_sampleCoverage == value && m_sampleCoverageInvert == (int)invert)
+			return;
+		m_sampleCoverage = value;
+		m_sampleCoverageInvert = invert;
+		glSampleCoverage(value, invert);
+	}
+	void GLStateCache::DepthMask(bool mask)
+	{
+		if (m_depthMask == (int)mask)
+			return;
+		m_depthMask = mask;
+		glDepthMask(mask);
+	}
+	void GLStateCache::DepthFunc(GLenum func)
+	{
+		if (m_depthFunc == func)
+			return;
+		m_depthFunc = func;
+		glDepthFunc(func);
+	}
+	void GLStateCache::PolygonOffset(float factor, float units)
+	{
+		if (m_polygonOffset[0] == factor && m_polygonOffset[1] == units)
+			return;
+		m_polygonOffset[0] = factor;
+		m_polygonOffset[1] = units;
+		glPolygonOffset(factor, units);
+	}
+	void GLStateCache::StencilFuncSeparate(GLenum face, GLenum func, GLint ref, GLuint mask)
+	{
+		int id = (face == GL_BACK);
+		if (face == GL_FRONT_AND_BACK) {
+			StencilFuncSeparate(GL_FRONT, func, ref, mask);
+			StencilFuncSeparate(GL_BACK, func, ref, mask);
+			return;
+		}
+
+		if (m_stencilFunc[id] == func && m_stencilRef[id] == ref && m_stencilFuncMask[id] == mask)
+			return;
+		m_stencilFunc[id] = func;
+		m_stencilRef[id] = ref;
+		m_stencilFuncMask[id] = mask;
+		glStencilFuncSeparate(face, func, ref, mask);
+	}
+	void GLStateCache::StencilMask(GLuint mask)
+	{
+		if (m_stencilMaskKnown && m_stencilMask == mask)
+			return;
+		m_stencilMaskKnown = true;
+		m_stencilMask = mask;
+		glStencilMask(mask);
+	}
+	void GLStateCache::StencilOpSeparate(GLenum face, GLenum sfail, GLenum dpfail, GLenum dppass)
+	{
+		int id = (face == GL_BACK);
+		if (face == GL_FRONT_AND_BACK) {
+			StencilOpSeparate(GL_FRONT, sfail, dpfail, dppass);
+			StencilOpSeparate(GL_BACK, sfail, dpfail, dppass);
+			return;
+		}
+
+		if (m_stencilOp[id][0] == sfail && m_stencilOp[id][1] == dpfail && m_stencilOp[id][2] == dppass)
+			return;
+		m_stencilOp[id][0] = sfail;
+		m_stencilOp[id][1] = dpfail;
+		m_stencilOp[id][2] = dppass;
+		glStencilOpSeparate(face, sfail, dpfail, dppass);
+	}
+	void GLStateCache::BindSampler(GLuint unit, GLuint sampler)
+	{
+		if (sampler != 0 && unit >= m_samplerUnits)
+			m_samplerUnits = unit + 1;
+
+		if (unit >= GL_STATE_SAMPLER_UNITS) {
+			glBindSampler(unit, sampler);
+			return;
+		}
+
+		if (m_samplers[unit] == sampler)
+			return;
+
+		glBindSampler(unit, sampler);
+		m_samplers[unit] = sampler;
+	}
+	void GLStateCache::UnbindSamplers()
+	{
+		for (GLuint i = 0; i < m_samplerUnits; i++)
+			BindSampler(i, 0);
+		m_samplerUnits = 0;
+	}
+}
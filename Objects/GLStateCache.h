@@ -0,0 +1,68 @@
+#pragma once
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/glew.h>
+#if defined(__APPLE__)
+	#include <OpenGL/gl.h>
+#else
+	#include <GL/gl.h>
+#endif
+
+#define GL_STATE_SAMPLER_UNITS 32 // texture units whose sampler objects are tracked
+
+namespace ed
+{
+	// shadows the GL render state so that only the calls that actually change something reach the driver
+	class GLStateCache
+	{
+	public:
+		GLStateCache();
+
+		// forget everything - call this after someone else (imgui, plugins, ...) might have touched the state
+		void Invalidate();
+
+		void Enable(GLenum cap, bool enable);
+		void PolygonMode(GLenum mode);
+		void CullFace(GLenum face);
+		void FrontFace(GLenum dir);
+		void BlendEquationSeparate(GLenum color, GLenum alpha);
+		void BlendFuncSeparate(GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha);
+		void BlendColor(float r, float g, float b, float a);
+		void SampleCoverage(float value, bool invert);
+		void DepthMask(bool mask);
+		void DepthFunc(GLenum func);
+		void PolygonOffset(float factor, float units);
+		void StencilFuncSeparate(GLenum face, GLenum func, GLint ref, GLuint mask);
+		void StencilMask(GLuint mask);
+		void StencilOpSeparate(GLenum face, GLenum sfail, GLenum dpfail, GLenum dppass);
+		void BindSampler(GLuint unit, GLuint sampler);
+		void UnbindSamplers(); // imgui & the plugins expect the texture parameters to be used
+
+		static inline GLStateCache& Instance()
+		{
+			static GLStateCache ret;
+			return ret;
+		}
+
+	private:
+		enum Cap { DepthClamp, CullFaceCap, Blend, DepthTest, StencilTest, CapCount };
+		int m_caps[CapCount]; // -1 = unknown
+
+		GLenum m_polygonMode, m_cullFace, m_frontFace;
+		GLenum m_blendEq[2], m_blendFunc[4];
+		float m_blendColor[4];
+		float m_sampleCoverage;
+		int m_sampleCoverageInvert, m_depthMask;
+		GLenum m_depthFunc;
+		float m_polygonOffset[2];
+		GLenum m_stencilFunc[2];
+		GLint m_stencilRef[2];
+		GLuint m_stencilFuncMask[2];
+		GLuint m_stencilMask;
+		bool m_stencilMaskKnown;
+		GLenum m_stencilOp[2][3];
+		GLuint m_samplers[GL_STATE_SAMPLER_UNITS];
+		GLuint m_samplerUnits; // units below this one might have a sampler bound
+	};
+}
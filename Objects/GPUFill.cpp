@@ -0,0 +1,361 @@
+#include "GPUFill.h"
+#include "Logger.h"
+#include "../Engine/GLUtils.h"
+
+#include <string.h>
+#include <vector>
+#include <algorithm>
+
+const char* GPU_FILL_COMMON = R"(
+#define OP_CONSTANT 1
+#define OP_RAMP 2
+#define OP_RANDOM 3
+#define OP_NOISE 4
+#define OP_SEED 5
+#define OP_COPY 6
+
+uniform int op;
+uniform vec4 a;
+uniform vec4 b;
+uniform float frequency;
+uniform uint seed;
+
+uint hash(uint x)
+{
+	x ^= x >> 16u;
+	x *= 0x7feb352du;
+	x ^= x >> 15u;
+	x *= 0x846ca68bu;
+	x ^= x >> 16u;
+	return x;
+}
+float unorm(uint x)
+{
+	return float(x >> 8u) / 16777216.0f;
+}
+float value(ivec3 cell, uint key)
+{
+	return unorm(hash(uint(cell.x) ^ hash(uint(cell.y) ^ hash(uint(cell.z) ^ key))));
+}
+float noise(vec3 p, uint key)
+{
+	ivec3 i = ivec3(floor(p));
+	vec3 f = fract(p);
+	vec3 u = f * f * (3.0f - 2.0f * f);
+
+	float x00 = mix(value(i, key), value(i + ivec3(1, 0, 0), key), u.x);
+	float x10 = mix(value(i + ivec3(0, 1, 0), key), value(i + ivec3(1, 1, 0), key), u.x);
+	float x01 = mix(value(i + ivec3(0, 0, 1), key), value(i + ivec3(1, 0, 1), key), u.x);
+	float x11 = mix(value(i + ivec3(0, 1, 1), key), value(i + ivec3(1, 1, 1), key), u.x);
+	return mix(mix(x00, x10, u.y), mix(x01, x11, u.y), u.z);
+}
+)";
+
+const char* GPU_FILL_BUFFER_CS = R"(
+#define TYPE_FLOAT 0
+#define TYPE_INT 1
+
+layout(local_size_x = GPU_FILL_GROUP_SIZE) in;
+layout(std430, binding = 0) buffer Words { uint words[]; };
+
+uniform int type;
+uniform int components;
+uniform uint count;
+
+void main()
+{
+	uint index = gl_GlobalInvocationID.y * gl_NumWorkGroups.x * uint(GPU_FILL_GROUP_SIZE) + gl_GlobalInvocationID.x;
+	if (index >= count)
+		return;
+
+	uint element = index / uint(components);
+	int c = int(index % uint(components));
+	uint key = hash(uint(c) ^ seed);
+
+	if (op == OP_SEED) {
+		uint bits = hash(element ^ key);
+		words[index] = type == TYPE_FLOAT ? floatBitsToUint(unorm(bits)) : bits;
+		return;
+	}
+
+	// integer ramps past 2^24 would lose precision in a float
+	if (type != TYPE_FLOAT && (op == OP_CONSTANT || op == OP_RAMP)) {
+		int start = int(a[c]);
+		words[index] = uint(op == OP_RAMP ? start + int(b[c]) * int(element) : start);
+		return;
+	}
+
+	float v = a[c];
+	if (op == OP_RAMP)
+		v = a[c] + b[c] * float(element);
+	else if (op == OP_RANDOM)
+		v = mix(a[c], b[c], unorm(hash(element ^ key)));
+	else if (op == OP_NOISE)
+		v = mix(a[c], b[c], noise(vec3(float(element) * frequency, 0.0f, 0.0f), key));
+
+	if (type == TYPE_FLOAT)
+		words[index] = floatBitsToUint(v);
+	else if (type == TYPE_INT)
+		words[index] = uint(int(v));
+	else
+		words[index] = uint(max(v, 0.0f));
+}
+)";
+
+const char* GPU_FILL_VS = R"(
+void main()
+{
+	// full screen triangle
+	vec2 uv = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+	gl_Position = vec4(uv * 2.0f - 1.0f, 0.0f, 1.0f);
+}
+)";
+
+const char* GPU_FILL_PS = R"(
+uniform ivec3 size;
+uniform int layer;
+uniform sampler2D source;
+
+out OUTPUT_TYPE outColor;
+
+void main()
+{
+	ivec3 p = ivec3(gl_FragCoord.xy, layer);
+	uint texel = uint(p.x) + uint(size.x) * (uint(p.y) + uint(size.y) * uint(p.z));
+
+	vec4 v = a;
+	uvec4 bits = uvec4(0u);
+	for (int c = 0; c < 4; c++) {
+		uint key = hash(uint(c) ^ seed);
+
+		if (op == OP_RAMP)
+			v[c] = mix(a[c], b[c], (float(p.x) + 0.5f) / float(size.x));
+		else if (op == OP_RANDOM)
+			v[c] = mix(a[c], b[c], unorm(hash(texel ^ key)));
+		else if (op == OP_NOISE)
+			v[c] = mix(a[c], b[c], noise(vec3(p) * frequency, key));
+		else if (op == OP_SEED) {
+			bits[c] = hash(texel ^ key);
+			v[c] = unorm(bits[c]);
+		}
+	}
+	if (op == OP_COPY)
+		v = texelFetch(source, p.xy % textureSize(source, 0), 0);
+
+#if OUTPUT_INTEGER
+	outColor = op == OP_SEED ? OUTPUT_TYPE(bits) : OUTPUT_TYPE(v);
+#else
+	outColor = v;
+#endif
+}
+)";
+
+namespace ed
+{
+	static const char* OPERATOR_NAMES[] = { "none", "constant", "ramp", "random", "noise", "seed", "copy" };
+
+	// 0 = float, 1 = signed integer, 2 = unsigned integer
+	static int getOutputKind(GLenum format)
+	{
+		switch (format) {
+		case GL_R8I: case GL_R16I: case GL_R32I:
+		case GL_RG8I: case GL_RG16I: case GL_RG32I:
+		case GL_RGB8I: case GL_RGB16I: case GL_RGB32I:
+		case GL_RGBA8I: case GL_RGBA16I: case GL_RGBA32I:
+			return 1;
+		case GL_RGB10_A2UI:
+		case GL_R8UI: case GL_R16UI: case GL_R32UI:
+		case GL_RG8UI: case GL_RG16UI: case GL_RG32UI:
+		case GL_RGB8UI: case GL_RGB16UI: case GL_RGB32UI:
+		case GL_RGBA8UI: case GL_RGBA16UI: case GL_RGBA32UI:
+			return 2;
+		}
+		return 0;
+	}
+
+	GPUFill::GPUFill()
+	{
+		m_bufferProgram = m_vao = m_fbo = 0;
+	}
+	bool GPUFill::IsSupported()
+	{
+		return GLEW_ARB_compute_shader && GLEW_ARB_shader_storage_buffer_object;
+	}
+	const char* GPUFill::GetOperatorName(Operator op)
+	{
+		return OPERATOR_NAMES[(int)op];
+	}
+	GPUFill::Operator GPUFill::GetOperator(const char* name)
+	{
+		for (int i = 0; i < sizeof(OPERATOR_NAMES) / sizeof(OPERATOR_NAMES[0]); i++)
+			if (strcmp(name, OPERATOR_NAMES[i]) == 0)
+				return (Operator)i;
+		return Operator::None;
+	}
+	GLuint GPUFill::m_createProgram(const std::string& vs, const std::string& ps, const std::string& cs)
+	{
+		GLchar msg[1024];
+		std::vector<GLuint> shaders;
+		bool compiled = true;
+
+		if (!cs.empty())
+			shaders.push_back(gl::CompileShader(GL_COMPUTE_SHADER, cs.c_str()));
+		else {
+			shaders.push_back(gl::CompileShader(GL_VERTEX_SHADER, vs.c_str()));
+			shaders.push_back(gl::CompileShader(GL_FRAGMENT_SHADER, ps.c_str()));
+		}
+		for (GLuint shader : shaders)
+			compiled = compiled && gl::CheckShaderCompilationStatus(shader, msg);
+
+		if (!compiled) {
+			Logger::Get().Log("Failed to compile the fill shader: " + std::string(msg), true);
+			for (GLuint shader : shaders)
+				glDeleteShader(shader);
+			return 0;
+		}
+
+		GLuint program = glCreateProgram();
+		gl::SetObjectLabel(GL_PROGRAM, program, "Fill");
+		for (GLuint shader : shaders)
+			glAttachShader(program, shader);
+		glLinkProgram(program);
+		for (GLuint shader : shaders)
+			glDeleteShader(shader);
+
+		if (!gl::CheckShaderLinkStatus(program, msg)) {
+			Logger::Get().Log("Failed to link the fill shader: " + std::string(msg), true);
+			glDeleteProgram(program);
+			return 0;
+		}
+
+		return program;
+	}
+	void GPUFill::m_setUniforms(GLuint program, const Operation& op)
+	{
+		glUniform1i(glGetUniformLocation(program, "op"), (int)op.Op);
+		glUniform4fv(glGetUniformLocation(program, "a"), 1, &op.A[0]);
+		glUniform4fv(glGetUniformLocation(program, "b"), 1, &op.B[0]);
+		glUniform1f(glGetUniformLocation(program, "frequency"), op.Frequency);
+		glUniform1ui(glGetUniformLocation(program, "seed"), op.Seed);
+	}
+	bool GPUFill::FillBuffer(GLuint buffer, int size, const Operation& op, GLuint srcBuffer, int srcSize)
+	{
+		if (op.Op == Operator::None || size <= 0)
+			return true;
+
+		// a plain copy on the GPU, no kernel needed
+		if (op.Op == Operator::Copy) {
+			if (srcBuffer == 0 || srcBuffer == buffer)
+				return false;
+
+			glBindBuffer(GL_COPY_READ_BUFFER, srcBuffer);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, std::min(size, srcSize));
+			glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+			glBindBuffer(GL_COPY_READ_BUFFER, 0);
+			return true;
+		}
+
+		if (!IsSupported()) {
+			Logger::Get().Log("Buffers can't be filled on the GPU without compute shaders", true);
+			return false;
+		}
+
+		if (m_bufferProgram == 0) {
+			std::string cs = "#version 430\n#define GPU_FILL_GROUP_SIZE " + std::to_string(GPU_FILL_GROUP_SIZE) + "\n" + GPU_FILL_COMMON + GPU_FILL_BUFFER_CS;
+			m_bufferProgram = m_createProgram("", "", cs);
+			if (m_bufferProgram == 0)
+				return false;
+		}
+
+		GLuint count = size / 4;
+		if (count == 0)
+			return true;
+
+		glUseProgram(m_bufferProgram);
+		m_setUniforms(m_bufferProgram, op);
+		glUniform1i(glGetUniformLocation(m_bufferProgram, "type"), (int)op.Type);
+		glUniform1i(glGetUniformLocation(m_bufferProgram, "components"), std::max(std::min(op.Components, 4), 1));
+		glUniform1ui(glGetUniformLocation(m_bufferProgram, "count"), count);
+
+		// the group count per dimension is limited to 65535
+		GLuint groups = (count + GPU_FILL_GROUP_SIZE - 1) / GPU_FILL_GROUP_SIZE;
+		GLuint groupsX = std::min<GLuint>(groups, 65535);
+		GLuint groupsY = (groups + groupsX - 1) / groupsX;
+
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, buffer);
+		glDispatchCompute(groupsX, groupsY, 1);
+		glMemoryBarrier(GL_ALL_BARRIER_BITS);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+		glUseProgram(0);
+
+		return true;
+	}
+	bool GPUFill::FillTexture(GLuint tex, GLenum target, GLenum format, const glm::ivec3& size, const Operation& op, GLuint srcTexture)
+	{
+		if (op.Op == Operator::None || size.x <= 0 || size.y <= 0)
+			return true;
+		if (op.Op == Operator::Copy && (srcTexture == 0 || srcTexture == tex))
+			return false;
+
+		int kind = getOutputKind(format);
+		GLuint& program = m_textureProgram[kind];
+		if (program == 0) {
+			static const char* OUTPUT_TYPES[] = { "vec4", "ivec4", "uvec4" };
+			std::string defines = "#version 330\n#define OUTPUT_TYPE " + std::string(OUTPUT_TYPES[kind]) + "\n#define OUTPUT_INTEGER " + std::to_string(kind != 0) + "\n";
+			program = m_createProgram(std::string("#version 330\n") + GPU_FILL_VS, defines + GPU_FILL_COMMON + GPU_FILL_PS, "");
+			if (program == 0)
+				return false;
+		}
+
+		if (m_vao == 0) {
+			glGenVertexArrays(1, &m_vao);
+			glGenFramebuffers(1, &m_fbo);
+		}
+
+		glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+		glViewport(0, 0, size.x, size.y);
+		glDisable(GL_DEPTH_TEST);
+		glDisable(GL_BLEND);
+		glDisable(GL_CULL_FACE);
+		glDisable(GL_STENCIL_TEST);
+		glDisable(GL_SCISSOR_TEST);
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+		glUseProgram(program);
+		m_setUniforms(program, op);
+		glUniform3i(glGetUniformLocation(program, "size"), size.x, size.y, std::max(size.z, 1));
+		glUniform1i(glGetUniformLocation(program, "source"), 0);
+
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, op.Op == Operator::Copy ? srcTexture : 0);
+		glBindVertexArray(m_vao);
+
+		bool ret = true;
+		int depth = target == GL_TEXTURE_3D ? std::max(size.z, 1) : 1;
+		for (int z = 0; z < depth; z++) {
+			if (target == GL_TEXTURE_3D)
+				glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, tex, 0, z);
+			else
+				glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex, 0);
+
+			if (z == 0 && glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+				Logger::Get().Log("Failed to fill the texture, its format can't be rendered to", true);
+				ret = false;
+				break;
+			}
+
+			glUniform1i(glGetUniformLocation(program, "layer"), z);
+			glDrawArrays(GL_TRIANGLES, 0, 3);
+		}
+
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+		glBindVertexArray(0);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		glUseProgram(0);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		return ret;
+	}
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <glm/glm.hpp>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/glew.h>
+#if defined(__APPLE__)
+	#include <OpenGL/gl.h>
+#else
+	#include <GL/gl.h>
+#endif
+
+#define GPU_FILL_GROUP_SIZE 256 // invocations per work group of the buffer kernel
+
+namespace ed
+{
+	// initializes buffers & images without a CPU copy - buffers are written word by word by a compute kernel,
+	// images by a full screen pass per Z slice
+	class GPUFill
+	{
+	public:
+		enum class Operator
+		{
+			None,
+			Constant, // A
+			Ramp,	  // buffers: A + B * element, images: from A to B along X
+			Random,	  // uniform between A and B
+			Noise,	  // smooth value noise between A and B
+			Seed,	  // a hash per word/texel - integer objects get the raw bits, float ones a value in [0, 1)
+			Copy	  // contents of the Source object
+		};
+		enum class ElementType
+		{
+			Float,
+			Int,
+			Uint
+		};
+
+		struct Operation
+		{
+			Operation()
+			{
+				Op = Operator::None;
+				A = glm::vec4(0.0f);
+				B = glm::vec4(1.0f);
+				Frequency = 0.1f;
+				Seed = 0;
+				Type = ElementType::Float;
+				Components = 1;
+			}
+
+			Operator Op;
+			glm::vec4 A, B; // component i of an element uses channel i
+			float Frequency; // Noise: cells per element/texel
+			unsigned int Seed;
+
+			// buffers: how the 32 bit words are written & how many of them make one element
+			ElementType Type;
+			int Components;
+
+			std::string Source; // Copy: name of a buffer (buffers) or of a texture/image/render texture (images)
+		};
+
+		static inline GPUFill& Instance()
+		{
+			static GPUFill ret;
+			return ret;
+		}
+
+		GPUFill(); // the objects live until the GL context is destroyed
+
+		static bool IsSupported(); // the buffer kernel needs compute shaders
+		static const char* GetOperatorName(Operator op);
+		static Operator GetOperator(const char* name); // None if unknown
+
+		// size in bytes, only whole words are written - for Copy srcBuffer is the source (srcSize bytes)
+		bool FillBuffer(GLuint buffer, int size, const Operation& op, GLuint srcBuffer = 0, int srcSize = 0);
+		// target is GL_TEXTURE_2D or GL_TEXTURE_3D, for Copy srcTexture is a 2D texture that is repeated over the image
+		bool FillTexture(GLuint tex, GLenum target, GLenum format, const glm::ivec3& size, const Operation& op, GLuint srcTexture = 0);
+
+	private:
+		GLuint m_createProgram(const std::string& vs, const std::string& ps, const std::string& cs);
+		void m_setUniforms(GLuint program, const Operation& op);
+
+		GLuint m_bufferProgram, m_vao, m_fbo;
+		std::unordered_map<int, GLuint> m_textureProgram; // float, int & uint outputs
+	};
+}
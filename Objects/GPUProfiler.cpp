@@ -0,0 +1,196 @@
+#include "GPUProfiler.h"
+#include "TraceRecorder.h"
+
+#include <algorithm>
+#include <string.h>
+
+namespace ed
+{
+	static const GLenum counterTargets[GPUProfiler::CounterCount] = {
+		GL_VERTICES_SUBMITTED_ARB,
+		GL_PRIMITIVES_SUBMITTED_ARB,
+		GL_VERTEX_SHADER_INVOCATIONS_ARB,
+		GL_CLIPPING_INPUT_PRIMITIVES_ARB,
+		GL_CLIPPING_OUTPUT_PRIMITIVES_ARB,
+		GL_FRAGMENT_SHADER_INVOCATIONS_ARB,
+		GL_COMPUTE_SHADER_INVOCATIONS_ARB
+	};
+	static const char* counterNames[GPUProfiler::CounterCount] = {
+		"Vertices submitted",
+		"Primitives submitted",
+		"Vertex shader invocations",
+		"Clipping input primitives",
+		"Clipping output primitives",
+		"Fragment shader invocations",
+		"Compute shader invocations"
+	};
+
+	GPUProfiler::Entry::Entry()
+	{
+		memset(Queries, 0, sizeof(Queries));
+		Pending[0] = Pending[1] = false;
+		memset(CounterQueries, 0, sizeof(CounterQueries));
+		Counters[0] = Counters[1] = CounterSet::None;
+		memset(History, 0, sizeof(History));
+		HistoryIndex = 0;
+	}
+
+	GPUProfiler::GPUProfiler()
+	{
+		m_enabled = false;
+		m_buffer = 0;
+	}
+	GPUProfiler::~GPUProfiler()
+	{
+		Clear();
+	}
+	const char* GPUProfiler::GetCounterName(int counter)
+	{
+		return counterNames[counter];
+	}
+	void GPUProfiler::BeginFrame()
+	{
+		// collect the results that are already available and switch to the other set of queries
+		for (auto& entry : m_entries)
+			m_readback(entry.second);
+
+		m_buffer = 1 - m_buffer;
+
+		// queries from two frames ago that still aren't ready will simply be overwritten
+		for (auto& entry : m_entries)
+			entry.second.Pending[m_buffer] = false;
+	}
+	void GPUProfiler::Begin(void* item, const char* name, CounterSet counters)
+	{
+		Entry& entry = m_entries[item];
+		if (entry.Name != name)
+			entry.Name = name;
+		if (entry.Queries[m_buffer][0] == 0)
+			glGenQueries(2, entry.Queries[m_buffer]);
+
+		glQueryCounter(entry.Queries[m_buffer][0], GL_TIMESTAMP);
+
+		entry.Counters[m_buffer] = GLEW_ARB_pipeline_statistics_query ? counters : CounterSet::None;
+		if (entry.Counters[m_buffer] != CounterSet::None) {
+			if (entry.CounterQueries[m_buffer][0] == 0)
+				glGenQueries(CounterCount, entry.CounterQueries[m_buffer]);
+
+			int first, last;
+			m_getCounterRange(entry.Counters[m_buffer], first, last);
+			for (int i = first; i < last; i++)
+				glBeginQuery(counterTargets[i], entry.CounterQueries[m_buffer][i]);
+		}
+	}
+	void GPUProfiler::End(void* item)
+	{
+		auto entry = m_entries.find(item);
+		if (entry == m_entries.end() || entry->second.Queries[m_buffer][1] == 0)
+			return;
+
+		if (entry->second.Counters[m_buffer] != CounterSet::None) {
+			int first, last;
+			m_getCounterRange(entry->second.Counters[m_buffer], first, last);
+			for (int i = first; i < last; i++)
+				glEndQuery(counterTargets[i]);
+		}
+
+		glQueryCounter(entry->second.Queries[m_buffer][1], GL_TIMESTAMP);
+		entry->second.Pending[m_buffer] = true;
+	}
+	bool GPUProfiler::Has(void* item)
+	{
+		auto entry = m_entries.find(item);
+		return entry != m_entries.end() && entry->second.Result.Samples > 0;
+	}
+	const GPUProfiler::Stats& GPUProfiler::Get(void* item)
+	{
+		return m_entries[item].Result;
+	}
+	void GPUProfiler::Remove(void* item)
+	{
+		auto entry = m_entries.find(item);
+		if (entry == m_entries.end())
+			return;
+
+		m_deleteQueries(entry->second);
+		m_entries.erase(entry);
+	}
+	void GPUProfiler::ResetStats()
+	{
+		for (auto& entry : m_entries) {
+			entry.second.Result = Stats();
+			entry.second.HistoryIndex = 0;
+		}
+	}
+	void GPUProfiler::Clear()
+	{
+		for (auto& entry : m_entries)
+			m_deleteQueries(entry.second);
+
+		m_entries.clear();
+	}
+	void GPUProfiler::m_readback(Entry& entry)
+	{
+		for (int i = 0; i < 2; i++) {
+			if (!entry.Pending[i])
+				continue;
+
+			GLint available = 0;
+			glGetQueryObjectiv(entry.Queries[i][1], GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available)
+				continue;
+
+			int first = 0, last = 0;
+			if (entry.Counters[i] != CounterSet::None) {
+				m_getCounterRange(entry.Counters[i], first, last);
+				glGetQueryObjectiv(entry.CounterQueries[i][last - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+				if (!available)
+					continue;
+			}
+
+			GLuint64 start = 0, end = 0;
+			glGetQueryObjectui64v(entry.Queries[i][0], GL_QUERY_RESULT, &start);
+			glGetQueryObjectui64v(entry.Queries[i][1], GL_QUERY_RESULT, &end);
+			entry.Pending[i] = false;
+
+			TraceRecorder::Instance().AddGPU(entry.Name, start, end);
+
+			float ms = (end - start) / 1000000.0f;
+
+			// rolling min/avg/max
+			Stats& res = entry.Result;
+			entry.History[entry.HistoryIndex] = ms;
+			entry.HistoryIndex = (entry.HistoryIndex + 1) % GPU_PROFILER_HISTORY;
+			res.Samples = std::min<int>(res.Samples + 1, GPU_PROFILER_HISTORY);
+			res.Last = ms;
+
+			res.Min = res.Max = ms;
+			float sum = 0.0f;
+			for (int j = 0; j < res.Samples; j++) {
+				res.Min = std::min<float>(res.Min, entry.History[j]);
+				res.Max = std::max<float>(res.Max, entry.History[j]);
+				sum += entry.History[j];
+			}
+			res.Average = sum / res.Samples;
+
+			res.HasCounters = entry.Counters[i] != CounterSet::None;
+			memset(res.Counters, 0, sizeof(res.Counters));
+			for (int j = first; j < last; j++)
+				glGetQueryObjectui64v(entry.CounterQueries[i][j], GL_QUERY_RESULT, &res.Counters[j]);
+		}
+	}
+	void GPUProfiler::m_deleteQueries(Entry& entry)
+	{
+		for (int i = 0; i < 2; i++) {
+			if (entry.Queries[i][0] != 0)
+				glDeleteQueries(2, entry.Queries[i]);
+			if (entry.CounterQueries[i][0] != 0)
+				glDeleteQueries(CounterCount, entry.CounterQueries[i]);
+		}
+	}
+	void GPUProfiler::m_getCounterRange(CounterSet set, int& first, int& last)
+	{
+		first = (set == CounterSet::Compute) ? ComputeInvocations : VerticesSubmitted;
+		last = (set == CounterSet::Compute) ? CounterCount : ComputeInvocations;
+	}
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <unordered_map>
+#include <string>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/glew.h>
+#if defined(__APPLE__)
+	#include <OpenGL/gl.h>
+#else
+	#include <GL/gl.h>
+#endif
+
+#define GPU_PROFILER_HISTORY 120
+
+namespace ed
+{
+	// measures the GPU time of pipeline items - results are read one frame late so that we never stall
+	class GPUProfiler
+	{
+	public:
+		GPUProfiler();
+		~GPUProfiler();
+
+		// GL_ARB_pipeline_statistics_query counters - only one query per target can be active, so only the passes collect them
+		enum Counter
+		{
+			VerticesSubmitted,
+			PrimitivesSubmitted,
+			VertexInvocations,
+			ClippingInput,
+			ClippingOutput,
+			FragmentInvocations,
+			ComputeInvocations,
+			CounterCount
+		};
+		enum class CounterSet
+		{
+			None,
+			Graphics,	// everything except ComputeInvocations
+			Compute		// ComputeInvocations
+		};
+
+		struct Stats
+		{
+			Stats() { Last = Min = Average = Max = 0.0f; Samples = 0; HasCounters = false; memset(Counters, 0, sizeof(Counters)); }
+			float Last, Min, Average, Max; // in milliseconds
+			int Samples;
+
+			bool HasCounters;
+			GLuint64 Counters[CounterCount]; // from the last measured frame
+		};
+
+		static const char* GetCounterName(int counter);
+
+		inline bool IsEnabled() { return m_enabled; }
+		inline void SetEnabled(bool enabled) { m_enabled = enabled; }
+
+		void BeginFrame();
+		void Begin(void* item, const char* name, CounterSet counters = CounterSet::None); // the name is used in the recorded traces
+		void End(void* item);
+
+		bool Has(void* item);
+		const Stats& Get(void* item);
+
+		void Remove(void* item);
+		void ResetStats();
+		void Clear();
+
+	private:
+		struct Entry
+		{
+			Entry();
+
+			std::string Name;
+			GLuint Queries[2][2]; // [buffer][start, end]
+			bool Pending[2];
+
+			GLuint CounterQueries[2][CounterCount];
+			CounterSet Counters[2];
+
+			float History[GPU_PROFILER_HISTORY];
+			int HistoryIndex;
+
+			Stats Result;
+		};
+
+		void m_readback(Entry& entry);
+		void m_deleteQueries(Entry& entry);
+		static void m_getCounterRange(CounterSet set, int& first, int& last);
+
+		bool m_enabled;
+		int m_buffer;
+		std::unordered_map<void*, Entry> m_entries;
+	};
+}
@@ -0,0 +1,121 @@
+#include "GeometryCache.h"
+#include "VAOCache.h"
+#include "GeometryGenerator.h"
+#include "ObjectManager.h"
+#include "../Engine/GeometryFactory.h"
+#include "../Engine/GLUtils.h"
+
+namespace ed
+{
+	// the parameters that the Create*() function of the type takes
+	static glm::vec3 getKeySize(pipe::GeometryItem::GeometryType type, const glm::vec3& size)
+	{
+		switch (type) {
+		case pipe::GeometryItem::Cube: return size;
+		case pipe::GeometryItem::Circle:
+		case pipe::GeometryItem::Plane: return glm::vec3(size.x, size.y, 0);
+		case pipe::GeometryItem::Sphere:
+		case pipe::GeometryItem::Triangle: return glm::vec3(size.x, 0, 0);
+		default: return glm::vec3(0);
+		}
+	}
+
+	void GeometryCache::Create(pipe::GeometryItem* item, const std::vector<InputLayoutItem>& inp, GLuint instanceVBO, const std::vector<ShaderVariable::ValueType>& instanceFormat)
+	{
+		// every generated item has its own buffers, the kernel writes to them
+		if (item->Type == pipe::GeometryItem::Generated) {
+			GeometryGenerator::Instance().Allocate(item, inp, instanceVBO, instanceFormat);
+			return;
+		}
+
+		// the VBO is the captured buffer, only the VAO belongs to the item
+		if (item->Type == pipe::GeometryItem::Captured) {
+			item->VBO = item->VertexBuffer == nullptr ? 0 : ((BufferObject*)item->VertexBuffer)->ID;
+			item->VAO = 0;
+			item->EBO = 0;
+			if (item->VBO != 0)
+				gl::CreateVAO(item->VAO, item->VBO, inp, 0, instanceVBO, instanceFormat);
+			return;
+		}
+
+		glm::vec3 size = getKeySize(item->Type, item->Size);
+		std::vector<InputLayoutValue> layout(inp.size());
+		for (int i = 0; i < inp.size(); i++)
+			layout[i] = inp[i].Value;
+
+		Entry* entry = nullptr;
+		for (auto& e : m_entries)
+			if (e.Type == item->Type && e.Size == size && e.Layout == layout) {
+				entry = &e;
+				break;
+			}
+
+		if (entry == nullptr) {
+			Entry e;
+			e.Type = item->Type;
+			e.Size = size;
+			e.Layout = layout;
+			e.References = 0;
+			e.VBO = 0;
+
+			switch (item->Type) {
+			case pipe::GeometryItem::Cube: e.VAO = eng::GeometryFactory::CreateCube(e.VBO, size.x, size.y, size.z, inp); break;
+			case pipe::GeometryItem::Circle: e.VAO = eng::GeometryFactory::CreateCircle(e.VBO, size.x, size.y, inp); break;
+			case pipe::GeometryItem::Plane: e.VAO = eng::GeometryFactory::CreatePlane(e.VBO, size.x, size.y, inp); break;
+			case pipe::GeometryItem::Rectangle: e.VAO = eng::GeometryFactory::CreatePlane(e.VBO, 1, 1, inp); break;
+			case pipe::GeometryItem::Sphere: e.VAO = eng::GeometryFactory::CreateSphere(e.VBO, size.x, inp); break;
+			case pipe::GeometryItem::Triangle: e.VAO = eng::GeometryFactory::CreateTriangle(e.VBO, size.x, inp); break;
+			case pipe::GeometryItem::ScreenQuadNDC: e.VAO = eng::GeometryFactory::CreateScreenQuadNDC(e.VBO, inp); break;
+			default: e.VAO = 0; break;
+			}
+
+			m_entries.push_back(e);
+			entry = &m_entries.back();
+		}
+
+		entry->References++;
+		item->VBO = entry->VBO;
+		item->VAO = entry->VAO;
+
+		// the VAO stores the instance buffer's attributes - it's only shared with the items that use the same buffer
+		if (instanceVBO != 0)
+			item->VAO = VAOCache::Instance().Get(item->VBO, inp, 0, instanceVBO, instanceFormat);
+	}
+	void GeometryCache::Release(pipe::GeometryItem* item)
+	{
+		if (item->Type == pipe::GeometryItem::Captured) {
+			if (item->VAO != 0)
+				glDeleteVertexArrays(1, &item->VAO);
+			item->VAO = item->VBO = 0;
+			return;
+		}
+
+		for (int i = 0; i < m_entries.size(); i++) {
+			Entry& entry = m_entries[i];
+			if (entry.VBO != item->VBO)
+				continue;
+
+			if (item->VAO != entry.VAO)
+				VAOCache::Instance().Release(item->VAO);
+
+			entry.References--;
+			if (entry.References <= 0) {
+				glDeleteVertexArrays(1, &entry.VAO);
+				glDeleteBuffers(1, &entry.VBO);
+				m_entries.erase(m_entries.begin() + i);
+			}
+
+			item->VAO = item->VBO = 0;
+			return;
+		}
+
+		// not created through the cache
+		if (item->VAO != 0)
+			glDeleteVertexArrays(1, &item->VAO);
+		if (item->VBO != 0)
+			glDeleteBuffers(1, &item->VBO);
+		if (item->EBO != 0)
+			glDeleteBuffers(1, &item->EBO);
+		item->VAO = item->VBO = item->EBO = 0;
+	}
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <vector>
+
+#include "PipelineItem.h"
+#include "InputLayout.h"
+#include "ShaderVariable.h"
+
+namespace ed
+{
+	// VBOs & VAOs of the built-in geometry - every GeometryItem with the same type, size & input layout shares them
+	// (except for the generated geometry, see GeometryGenerator, & the captured one that only owns its VAO)
+	// every Create() has to be paired with a Release()
+	class GeometryCache
+	{
+	public:
+		static inline GeometryCache& Instance()
+		{
+			static GeometryCache ret;
+			return ret;
+		}
+
+		// sets the item's VAO & VBO - with an instance buffer the VAO comes from the VAOCache
+		void Create(pipe::GeometryItem* item, const std::vector<InputLayoutItem>& inp, GLuint instanceVBO = 0, const std::vector<ShaderVariable::ValueType>& instanceFormat = std::vector<ShaderVariable::ValueType>());
+		void Release(pipe::GeometryItem* item);
+
+		// call after the item's size or its pass' input layout changed or its instance buffer was (un)set (or the shape or
+		// the resolution of the generated geometry)
+		inline void Rebuild(pipe::GeometryItem* item, const std::vector<InputLayoutItem>& inp, GLuint instanceVBO = 0, const std::vector<ShaderVariable::ValueType>& instanceFormat = std::vector<ShaderVariable::ValueType>())
+		{
+			// the new geometry is created first so that an unchanged one isn't freed and built again
+			pipe::GeometryItem old = *item;
+			Create(item, inp, instanceVBO, instanceFormat);
+			Release(&old);
+		}
+
+		inline int GetCount() { return m_entries.size(); }
+
+	private:
+		struct Entry
+		{
+			pipe::GeometryItem::GeometryType Type;
+			glm::vec3 Size; // only the components that the type uses, the rest are 0
+			std::vector<InputLayoutValue> Layout;
+
+			GLuint VAO, VBO;
+			int References;
+		};
+
+		std::vector<Entry> m_entries; // scenes only have a handful of distinct primitives
+	};
+}
@@ -0,0 +1,247 @@
+#include "GeometryGenerator.h"
+#include "Logger.h"
+#include "../Engine/GLUtils.h"
+
+#include <string.h>
+#include <algorithm>
+#include <glm/gtc/type_ptr.hpp>
+
+const char* GEOMETRY_GENERATOR_CS = R"(
+layout(local_size_x = GEOMETRY_GENERATOR_GROUP_SIZE) in;
+
+layout(std430, binding = 0) writeonly buffer Vertices { float verts[]; };
+layout(std430, binding = 1) writeonly buffer Indices { uint inds[]; };
+
+uniform int shape;
+uniform uvec2 res;
+uniform vec3 size;
+uniform float amplitude;
+uniform float frequency;
+uniform float time;
+uniform uint seed;
+uniform uint vertexCount;
+
+const float PI = 3.14159265;
+
+uint hash(uint x)
+{
+	x ^= x >> 16; x *= 0x7feb352du;
+	x ^= x >> 15; x *= 0x846ca68bu;
+	x ^= x >> 16;
+	return x;
+}
+float random(uint x) { return float(hash(x ^ hash(seed)) >> 8) / 16777216.0; }
+float lattice(ivec2 p) { return random(uint(p.x) * 1973u + hash(uint(p.y) * 9277u)); }
+float noise(vec2 p)
+{
+	ivec2 i = ivec2(floor(p));
+	vec2 f = fract(p);
+	f = f * f * (3.0 - 2.0 * f);
+	return mix(mix(lattice(i), lattice(i + ivec2(1, 0)), f.x), mix(lattice(i + ivec2(0, 1)), lattice(i + ivec2(1, 1)), f.x), f.y);
+}
+float height(vec2 p)
+{
+	if (amplitude == 0.0)
+		return 0.0;
+
+	p = p * frequency + vec2(time, 0.0);
+	float v = 0.0, a = 0.5;
+	for (int o = 0; o < 5; o++) {
+		v += a * noise(p);
+		p *= 2.0;
+		a *= 0.5;
+	}
+	return amplitude * (v * 2.0 - 1.0);
+}
+
+void writeVertex(uint i, vec3 pos, vec3 normal, vec2 uv, vec3 tangent)
+{
+	vec3 binormal = cross(normal, tangent);
+	float data[18] = float[18](pos.x, pos.y, pos.z, normal.x, normal.y, normal.z, uv.x, uv.y,
+		tangent.x, tangent.y, tangent.z, binormal.x, binormal.y, binormal.z, 1.0, 1.0, 1.0, 1.0);
+	for (int k = 0; k < 18; k++)
+		verts[i * 18u + uint(k)] = data[k];
+}
+void writeQuad(uint q, uint a, uint b, uint c, uint d, bool flip)
+{
+	uint o = q * 6u;
+	inds[o + 0u] = a; inds[o + 1u] = flip ? d : b; inds[o + 2u] = flip ? b : d;
+	inds[o + 3u] = a; inds[o + 4u] = flip ? c : d; inds[o + 5u] = flip ? d : c;
+}
+
+void main()
+{
+	uint i = gl_GlobalInvocationID.x + gl_GlobalInvocationID.y * gl_NumWorkGroups.x * gl_WorkGroupSize.x;
+	if (i >= vertexCount)
+		return;
+
+	// scatter - 4 vertices & 1 quad per copy
+	if (shape == 3) {
+		uint copy = i / 4u, corner = i % 4u;
+		vec2 pos = (vec2(random(copy * 4u), random(copy * 4u + 1u)) - 0.5) * size.xy;
+		float angle = random(copy * 4u + 2u) * 2.0 * PI;
+		float h = size.z * (0.5 + 0.5 * random(copy * 4u + 3u));
+
+		vec3 side = vec3(cos(angle), sin(angle), 0.0);
+		vec2 uv = vec2(corner & 1u, corner >> 1u);
+		vec3 base = vec3(pos, height(pos));
+		writeVertex(i, base + side * (uv.x - 0.5) * h * 0.25 + vec3(0.0, 0.0, uv.y * h), vec3(side.y, -side.x, 0.0), uv, side);
+
+		if (corner == 0u)
+			writeQuad(copy, i, i + 1u, i + 2u, i + 3u, false);
+		return;
+	}
+
+	// grid, terrain & sphere - (res.x + 1) * (res.y + 1) vertices, res.x * res.y quads
+	uvec2 cell = uvec2(i % (res.x + 1u), i / (res.x + 1u));
+	vec2 uv = vec2(cell) / vec2(res);
+
+	if (shape == 2) {
+		float theta = uv.x * 2.0 * PI, phi = uv.y * PI;
+		vec3 dir = vec3(sin(phi) * cos(theta), sin(phi) * sin(theta), cos(phi));
+		writeVertex(i, dir * size.x, dir, uv, vec3(-sin(theta), cos(theta), 0.0));
+	} else {
+		vec2 pos = (uv - 0.5) * size.xy;
+		vec3 normal = vec3(0.0, 0.0, 1.0), tangent = vec3(1.0, 0.0, 0.0);
+		float z = 0.0;
+		if (shape == 1) {
+			vec2 e = size.xy / vec2(res);
+			z = height(pos);
+			float dx = (height(pos + vec2(e.x, 0.0)) - height(pos - vec2(e.x, 0.0))) / (2.0 * e.x);
+			float dy = (height(pos + vec2(0.0, e.y)) - height(pos - vec2(0.0, e.y))) / (2.0 * e.y);
+			normal = normalize(vec3(-dx, -dy, 1.0));
+			tangent = normalize(vec3(1.0, 0.0, dx));
+		}
+		writeVertex(i, vec3(pos, z), normal, uv, tangent);
+	}
+
+	if (cell.x < res.x && cell.y < res.y) {
+		uint a = i, b = i + 1u, c = i + res.x + 1u, d = c + 1u;
+		writeQuad(cell.y * res.x + cell.x, a, b, c, d, shape == 2); // the sphere's parametrization faces inwards
+	}
+}
+)";
+
+namespace ed
+{
+	static const char* SHAPE_NAMES[] = { "grid", "terrain", "sphere", "scatter" };
+
+	GeometryGenerator::GeometryGenerator()
+	{
+		m_program = 0;
+		m_failed = false;
+	}
+	bool GeometryGenerator::IsSupported()
+	{
+		return GLEW_ARB_compute_shader && GLEW_ARB_shader_storage_buffer_object;
+	}
+	const char* GeometryGenerator::GetShapeName(Shape shape)
+	{
+		return SHAPE_NAMES[(int)shape];
+	}
+	GeometryGenerator::Shape GeometryGenerator::GetShape(const char* name)
+	{
+		for (int i = 0; i < sizeof(SHAPE_NAMES) / sizeof(SHAPE_NAMES[0]); i++)
+			if (strcmp(name, SHAPE_NAMES[i]) == 0)
+				return (Shape)i;
+		return Shape::Grid;
+	}
+	void GeometryGenerator::GetCounts(const pipe::GeometryItem* item, int& vertices, int& indices)
+	{
+		glm::ivec2 res = glm::max(item->GenResolution, glm::ivec2(1));
+		long long verts = 0, quads = (long long)res.x * res.y;
+		if ((Shape)item->GenShape == Shape::Scatter)
+			verts = quads * 4;
+		else
+			verts = (long long)(res.x + 1) * (res.y + 1);
+
+		if (verts > GEOMETRY_GENERATOR_MAX_VERTICES) {
+			vertices = indices = 0;
+			return;
+		}
+
+		vertices = (int)verts;
+		indices = (int)quads * 6;
+	}
+	void GeometryGenerator::Allocate(pipe::GeometryItem* item, const std::vector<InputLayoutItem>& inp, GLuint instanceVBO, const std::vector<ShaderVariable::ValueType>& instanceFormat)
+	{
+		GetCounts(item, item->VertexCount, item->IndexCount);
+		if (item->VertexCount == 0)
+			Logger::Get().Log("The generated geometry would have more than " + std::to_string(GEOMETRY_GENERATOR_MAX_VERTICES) + " vertices", true);
+
+		// the buffers are only written by the kernel
+		glGenBuffers(1, &item->VBO);
+		glBindBuffer(GL_ARRAY_BUFFER, item->VBO);
+		glBufferData(GL_ARRAY_BUFFER, std::max(item->VertexCount, 1) * 18 * sizeof(GLfloat), nullptr, GL_DYNAMIC_COPY);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		glGenBuffers(1, &item->EBO);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, item->EBO);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, std::max(item->IndexCount, 1) * sizeof(GLuint), nullptr, GL_DYNAMIC_COPY);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+		item->VAO = 0;
+		gl::CreateVAO(item->VAO, item->VBO, inp, item->EBO, instanceVBO, instanceFormat);
+
+		item->Dirty = true;
+	}
+	bool GeometryGenerator::Generate(pipe::GeometryItem* item, float time)
+	{
+		item->Dirty = false;
+		if (item->VertexCount == 0)
+			return true;
+
+		if (!IsSupported()) {
+			if (!m_failed)
+				Logger::Get().Log("Geometry can't be generated without compute shaders", true);
+			m_failed = true;
+			return false;
+		}
+
+		if (m_program == 0 && !m_failed) {
+			std::string cs = "#version 430\n#define GEOMETRY_GENERATOR_GROUP_SIZE " + std::to_string(GEOMETRY_GENERATOR_GROUP_SIZE) + "\n" + GEOMETRY_GENERATOR_CS;
+			GLuint shader = gl::CompileShader(GL_COMPUTE_SHADER, cs.c_str());
+
+			GLchar msg[1024];
+			if (!gl::CheckShaderCompilationStatus(shader, msg)) {
+				Logger::Get().Log("Failed to compile the geometry generator: " + std::string(msg), true);
+				m_failed = true;
+			} else {
+				m_program = glCreateProgram();
+				gl::SetObjectLabel(GL_PROGRAM, m_program, "Geometry generator");
+				glAttachShader(m_program, shader);
+				glLinkProgram(m_program);
+			}
+			glDeleteShader(shader);
+		}
+		if (m_program == 0)
+			return false;
+
+		glm::ivec2 res = glm::max(item->GenResolution, glm::ivec2(1));
+
+		glUseProgram(m_program);
+		glUniform1i(glGetUniformLocation(m_program, "shape"), item->GenShape);
+		glUniform2ui(glGetUniformLocation(m_program, "res"), res.x, res.y);
+		glUniform3fv(glGetUniformLocation(m_program, "size"), 1, glm::value_ptr(item->Size));
+		glUniform1f(glGetUniformLocation(m_program, "amplitude"), item->GenAmplitude);
+		glUniform1f(glGetUniformLocation(m_program, "frequency"), item->GenFrequency);
+		glUniform1f(glGetUniformLocation(m_program, "time"), item->GenAnimated ? time : 0.0f);
+		glUniform1ui(glGetUniformLocation(m_program, "seed"), item->GenSeed);
+		glUniform1ui(glGetUniformLocation(m_program, "vertexCount"), item->VertexCount);
+
+		// the group count per dimension is limited to 65535
+		GLuint groups = (item->VertexCount + GEOMETRY_GENERATOR_GROUP_SIZE - 1) / GEOMETRY_GENERATOR_GROUP_SIZE;
+		GLuint groupsX = std::min<GLuint>(groups, 65535);
+		GLuint groupsY = (groups + groupsX - 1) / groupsX;
+
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, item->VBO);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, item->EBO);
+		glDispatchCompute(groupsX, groupsY, 1);
+		glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_ELEMENT_ARRAY_BARRIER_BIT);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0);
+		glUseProgram(0);
+
+		return true;
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <vector>
+
+#include "PipelineItem.h"
+#include "InputLayout.h"
+#include "ShaderVariable.h"
+
+#define GEOMETRY_GENERATOR_GROUP_SIZE 256 // invocations per work group, one per vertex
+#define GEOMETRY_GENERATOR_MAX_VERTICES (1 << 24) // 72 bytes each
+
+namespace ed
+{
+	// vertices & indices of pipe::GeometryItem::Generated built by a compute kernel - the vertices have the same
+	// 18 float layout as the ones from GeometryFactory so the pass' input layout works unchanged
+	class GeometryGenerator
+	{
+	public:
+		enum class Shape
+		{
+			Grid,	 // Size.x by Size.y plane in XY, facing +Z
+			Terrain, // grid displaced along Z by the height noise
+			Sphere,	 // radius Size.x
+			Scatter, // upright quads Size.z high at random positions on the height noise
+			Count
+		};
+
+		static inline GeometryGenerator& Instance()
+		{
+			static GeometryGenerator ret;
+			return ret;
+		}
+
+		GeometryGenerator(); // the program lives until the GL context is destroyed
+
+		static bool IsSupported();
+		static const char* GetShapeName(Shape shape);
+		static Shape GetShape(const char* name); // Grid if unknown
+		static void GetCounts(const pipe::GeometryItem* item, int& vertices, int& indices);
+
+		// creates the item's buffers & VAO for its shape & resolution and marks it dirty
+		void Allocate(pipe::GeometryItem* item, const std::vector<InputLayoutItem>& inp, GLuint instanceVBO = 0, const std::vector<ShaderVariable::ValueType>& instanceFormat = std::vector<ShaderVariable::ValueType>());
+		bool Generate(pipe::GeometryItem* item, float time);
+
+	private:
+		GLuint m_program;
+		bool m_failed;
+	};
+}
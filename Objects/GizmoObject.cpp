@@ -1,6 +1,7 @@
 #include "GizmoObject.h"
 #include "Logger.h"
 #include "DefaultState.h"
+#include "GLStateCache.h"
 #include "SystemVariableManager.h"
 #include "../Engine/GeometryFactory.h"
 #include "../Engine/Ray.h"
@@ -533,6 +534,7 @@ namespace ed
 			glBindVertexArray(m_uiVAO);
 			glDrawArrays(GL_TRIANGLES, 0, GUI_POINT_COUNT*3);
 
+			GLStateCache::Instance().Invalidate();
 			DefaultState::Bind();
 		}
 	}
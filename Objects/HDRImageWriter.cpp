@@ -0,0 +1,295 @@
+#include "HDRImageWriter.h"
+#include "Logger.h"
+#include "../Engine/ThreadPool.h"
+
+#include <stb/stb_image_write.h>
+
+#include <array>
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <thread>
+#include <string.h>
+#include <stdlib.h>
+
+// implemented by stb_image_write, the output is allocated with malloc()
+extern "C" unsigned char* stbi_zlib_compress(unsigned char* data, int data_len, int* out_len, int quality);
+
+#define EXR_ZLIB_QUALITY 4 // fast, the compositing tools read these files more often than we write them
+
+namespace ed
+{
+	template <typename T>
+	static void writeValue(std::vector<unsigned char>& out, T val)
+	{
+		const unsigned char* bytes = (const unsigned char*)&val;
+		out.insert(out.end(), bytes, bytes + sizeof(T));
+	}
+	template <typename T>
+	static void writeValueBE(std::vector<unsigned char>& out, T val)
+	{
+		for (int i = sizeof(T) - 1; i >= 0; i--)
+			out.push_back((val >> (i * 8)) & 0xFF);
+	}
+	static void writeAttribute(std::vector<unsigned char>& out, const char* name, const char* type, const std::vector<unsigned char>& value)
+	{
+		out.insert(out.end(), name, name + strlen(name) + 1);
+		out.insert(out.end(), type, type + strlen(type) + 1);
+		writeValue<int32_t>(out, (int32_t)value.size());
+		out.insert(out.end(), value.begin(), value.end());
+	}
+
+	// OpenEXR's ZIP: the bytes are split into even & odd halves and delta encoded before deflate
+	static void exrPredict(const unsigned char* src, unsigned char* dst, size_t size)
+	{
+		size_t half = (size + 1) / 2;
+		for (size_t i = 0; i < size; i++)
+			dst[(i % 2 == 0) ? i / 2 : half + i / 2] = src[i];
+
+		unsigned char prev = dst[0];
+		for (size_t i = 1; i < size; i++) {
+			unsigned char cur = dst[i];
+			dst[i] = (unsigned char)((int)cur - prev + (128 + 256));
+			prev = cur;
+		}
+	}
+
+	bool HDRImageWriter::WriteEXR(const std::string& path, int width, int height, const std::vector<Layer>& layers, PixelType type, Compression compression, int threadCount)
+	{
+		if (width <= 0 || height <= 0 || layers.empty())
+			return false;
+
+		int pixelSize = type == PixelType::Half ? 2 : 4;
+		int linesPerBlock = compression == Compression::ZIP ? 16 : 1;
+		int blockCount = (height + linesPerBlock - 1) / linesPerBlock;
+
+		// the channels have to be sorted by their name, each channel points to its RGBA component in a layer
+		struct Channel
+		{
+			std::string Name;
+			const unsigned char* Data;
+			int Component;
+		};
+		std::vector<Channel> channels;
+		const char* components = "RGBA";
+		bool longNames = false;
+		for (const Layer& layer : layers) {
+			for (int c = 0; c < 4; c++) {
+				Channel ch;
+				ch.Name = layer.Name.empty() ? std::string(1, components[c]) : (layer.Name + "." + components[c]);
+				ch.Data = (const unsigned char*)layer.Data;
+				ch.Component = c;
+				channels.push_back(ch);
+				longNames |= ch.Name.size() > 31;
+			}
+		}
+		std::sort(channels.begin(), channels.end(), [](const Channel& a, const Channel& b) { return a.Name < b.Name; });
+
+		// header
+		std::vector<unsigned char> header;
+		writeValue<uint32_t>(header, 20000630);
+		writeValue<uint32_t>(header, 2 | (longNames ? 0x400 : 0));
+
+		std::vector<unsigned char> value;
+		for (const Channel& ch : channels) {
+			value.insert(value.end(), ch.Name.c_str(), ch.Name.c_str() + ch.Name.size() + 1);
+			writeValue<int32_t>(value, type == PixelType::Half ? 1 : 2);
+			writeValue<uint32_t>(value, 0); // pLinear & reserved
+			writeValue<int32_t>(value, 1);
+			writeValue<int32_t>(value, 1);
+		}
+		value.push_back(0);
+		writeAttribute(header, "channels", "chlist", value);
+
+		value.clear();
+		value.push_back(compression == Compression::None ? 0 : (compression == Compression::ZIPS ? 2 : 3));
+		writeAttribute(header, "compression", "compression", value);
+
+		value.clear();
+		writeValue<int32_t>(value, 0);
+		writeValue<int32_t>(value, 0);
+		writeValue<int32_t>(value, width - 1);
+		writeValue<int32_t>(value, height - 1);
+		writeAttribute(header, "dataWindow", "box2i", value);
+		writeAttribute(header, "displayWindow", "box2i", value);
+
+		value.clear();
+		value.push_back(0); // increasing Y
+		writeAttribute(header, "lineOrder", "lineOrder", value);
+
+		value.clear();
+		writeValue<float>(value, 1.0f);
+		writeAttribute(header, "pixelAspectRatio", "float", value);
+		writeAttribute(header, "screenWindowWidth", "float", value);
+
+		value.clear();
+		writeValue<float>(value, 0.0f);
+		writeValue<float>(value, 0.0f);
+		writeAttribute(header, "screenWindowCenter", "v2f", value);
+
+		header.push_back(0);
+
+		// blocks are built & compressed in parallel, EXR's first row is the top one
+		std::vector<std::vector<unsigned char>> blocks(blockCount);
+		std::atomic<int> nextBlock(0);
+		auto worker = [&]() {
+			std::vector<unsigned char> raw, predicted;
+			for (int b = nextBlock++; b < blockCount; b = nextBlock++) {
+				int y0 = b * linesPerBlock, lines = std::min(linesPerBlock, height - y0);
+
+				raw.resize((size_t)lines * width * channels.size() * pixelSize);
+				unsigned char* dst = raw.data();
+				for (int y = y0; y < y0 + lines; y++) {
+					size_t row = (size_t)(height - 1 - y) * width * 4;
+					for (const Channel& ch : channels) {
+						const unsigned char* src = ch.Data + (row + ch.Component) * pixelSize;
+						for (int x = 0; x < width; x++) {
+							memcpy(dst, src, pixelSize);
+							dst += pixelSize;
+							src += 4 * pixelSize;
+						}
+					}
+				}
+
+				std::vector<unsigned char>& block = blocks[b];
+				writeValue<int32_t>(block, y0);
+
+				unsigned char* packed = nullptr;
+				int packedSize = 0;
+				if (compression != Compression::None) {
+					predicted.resize(raw.size());
+					exrPredict(raw.data(), predicted.data(), raw.size());
+					packed = stbi_zlib_compress(predicted.data(), (int)predicted.size(), &packedSize, EXR_ZLIB_QUALITY);
+				}
+
+				// the readers treat a block that isn't smaller than the raw data as uncompressed
+				if (packed != nullptr && (size_t)packedSize < raw.size()) {
+					writeValue<int32_t>(block, packedSize);
+					block.insert(block.end(), packed, packed + packedSize);
+				} else {
+					writeValue<int32_t>(block, (int32_t)raw.size());
+					block.insert(block.end(), raw.begin(), raw.end());
+				}
+				free(packed);
+			}
+		};
+
+		if (threadCount <= 0)
+			threadCount = std::max<int>(1, std::thread::hardware_concurrency());
+		threadCount = std::min(threadCount, blockCount);
+
+		// the calling thread works too - the workers that didn't get to start before it was done are dropped
+		{
+			eng::ThreadPool workers(eng::JobPriority::Export, threadCount - 1);
+			for (int i = 1; i < threadCount; i++)
+				workers.Add(worker);
+			worker();
+		}
+
+		// offset table followed by the blocks
+		std::ofstream file(path, std::ios::binary);
+		if (!file.is_open()) {
+			Logger::Get().Log("Failed to write " + path, true);
+			return false;
+		}
+
+		file.write((const char*)header.data(), header.size());
+
+		uint64_t offset = header.size() + blockCount * sizeof(uint64_t);
+		for (const auto& block : blocks) {
+			file.write((const char*)&offset, sizeof(offset));
+			offset += block.size();
+		}
+		for (const auto& block : blocks)
+			file.write((const char*)block.data(), block.size());
+
+		return file.good();
+	}
+
+	static uint32_t pngCRC(const unsigned char* data, size_t size, uint32_t crc = 0xFFFFFFFF)
+	{
+		// the sequence encoders write from several threads at once
+		static const std::array<uint32_t, 256> table = []() {
+			std::array<uint32_t, 256> ret;
+			for (uint32_t i = 0; i < 256; i++) {
+				uint32_t c = i;
+				for (int k = 0; k < 8; k++)
+					c = (c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1);
+				ret[i] = c;
+			}
+			return ret;
+		}();
+
+		for (size_t i = 0; i < size; i++)
+			crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+		return crc;
+	}
+	static void writeChunk(std::ofstream& file, const char* type, const unsigned char* data, uint32_t size)
+	{
+		std::vector<unsigned char> chunk;
+		writeValueBE<uint32_t>(chunk, size);
+		chunk.insert(chunk.end(), type, type + 4);
+		chunk.insert(chunk.end(), data, data + size);
+		writeValueBE<uint32_t>(chunk, pngCRC(chunk.data() + 4, size + 4) ^ 0xFFFFFFFF);
+		file.write((const char*)chunk.data(), chunk.size());
+	}
+
+	bool HDRImageWriter::WritePNG16(const std::string& path, int width, int height, const uint16_t* rgba)
+	{
+		if (width <= 0 || height <= 0)
+			return false;
+
+		// rows are flipped & stored big endian, each row uses the "up" filter (the first one "none")
+		size_t rowSize = (size_t)width * 8;
+		std::vector<unsigned char> filtered((rowSize + 1) * height), prev(rowSize, 0), cur(rowSize);
+		for (int y = 0; y < height; y++) {
+			const uint16_t* src = rgba + (size_t)(height - 1 - y) * width * 4;
+			for (size_t i = 0; i < (size_t)width * 4; i++) {
+				cur[i * 2 + 0] = src[i] >> 8;
+				cur[i * 2 + 1] = src[i] & 0xFF;
+			}
+
+			unsigned char* dst = &filtered[y * (rowSize + 1)];
+			dst[0] = y == 0 ? 0 : 2;
+			for (size_t i = 0; i < rowSize; i++)
+				dst[i + 1] = cur[i] - prev[i];
+			prev.swap(cur);
+		}
+
+		if (filtered.size() > 0x7FFFFFFF) {
+			Logger::Get().Log("The image is too large for a 16 bit PNG", true);
+			return false;
+		}
+
+		int packedSize = 0;
+		unsigned char* packed = stbi_zlib_compress(filtered.data(), (int)filtered.size(), &packedSize, stbi_write_png_compression_level);
+		if (packed == nullptr)
+			return false;
+
+		std::ofstream file(path, std::ios::binary);
+		if (!file.is_open()) {
+			Logger::Get().Log("Failed to write " + path, true);
+			free(packed);
+			return false;
+		}
+
+		const unsigned char signature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+		file.write((const char*)signature, sizeof(signature));
+
+		std::vector<unsigned char> ihdr;
+		writeValueBE<uint32_t>(ihdr, width);
+		writeValueBE<uint32_t>(ihdr, height);
+		ihdr.push_back(16); // bit depth
+		ihdr.push_back(6);	// RGBA
+		ihdr.push_back(0);
+		ihdr.push_back(0);
+		ihdr.push_back(0);
+		writeChunk(file, "IHDR", ihdr.data(), ihdr.size());
+		writeChunk(file, "IDAT", packed, packedSize);
+		writeChunk(file, "IEND", nullptr, 0);
+
+		free(packed);
+
+		return file.good();
+	}
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace ed
+{
+	// linear & high bit depth output for the saved previews - OpenEXR (scanline, uncompressed or ZIP) and 16 bit PNG
+	// both take RGBA pixels with the rows stored bottom up, the way glGetTexImage returns them
+	class HDRImageWriter
+	{
+	public:
+		enum class PixelType
+		{
+			Half, // GL_HALF_FLOAT
+			Float // GL_FLOAT
+		};
+		enum class Compression
+		{
+			None,
+			ZIPS, // one scanline per block
+			ZIP	  // 16 scanlines per block
+		};
+
+		struct Layer
+		{
+			std::string Name; // empty -> the default R, G, B, A channels
+			const void* Data;
+		};
+
+		// the blocks are compressed on threadCount threads, 0 -> all cores
+		static bool WriteEXR(const std::string& path, int width, int height, const std::vector<Layer>& layers, PixelType type, Compression compression, int threadCount = 0);
+
+		static bool WritePNG16(const std::string& path, int width, int height, const uint16_t* rgba); // 16 bit values in the native byte order
+	};
+}
@@ -38,10 +38,12 @@
 
 #include <vector>
 #include <string>
-#include <fstream>
+#include <utility>
+#include <string.h>
 #include <algorithm>
 
 #include <glslang/Public/ShaderLang.h>
+#include "IncludeCache.h"
 
 namespace ed
 {
@@ -88,9 +90,13 @@ namespace ed
 
 		virtual ~HLSLFileIncluder() override { }
 
+		// every file that was included + hash of its content
+		inline const std::vector<std::pair<std::string, uint64_t>>& getIncludedFiles() const { return includedFiles; }
+
 	protected:
 		typedef char tUserDataElement;
 		std::vector<std::string> directoryStack;
+		std::vector<std::pair<std::string, uint64_t>> includedFiles;
 		int externalLocalDirectoryCount;
 
 		// Search for a valid "local" path based on combining the stack of include
@@ -107,10 +113,13 @@ namespace ed
 			for (auto it = directoryStack.rbegin(); it != directoryStack.rend(); ++it) {
 				std::string path = *it + '/' + headerName;
 				std::replace(path.begin(), path.end(), '\\', '/');
-				std::ifstream file(path, std::ios_base::binary | std::ios_base::ate);
-				if (file) {
+
+				std::string content;
+				uint64_t hash = 0;
+				if (IncludeCache::Instance().Get(path, content, &hash)) {
 					directoryStack.push_back(getDirectory(path));
-					return newIncludeResult(path, file, (int)file.tellg());
+					includedFiles.push_back(std::make_pair(path, hash));
+					return newIncludeResult(path, content);
 				}
 			}
 
@@ -124,13 +133,12 @@ namespace ed
 			return this->readLocalPath(headerName, "", 1);
 		}
 
-		// Do actual reading of the file, filling in a new include result.
-		virtual IncludeResult* newIncludeResult(const std::string& path, std::ifstream& file, int length) const
+		// Copy the cached contents of the file, filling in a new include result.
+		virtual IncludeResult* newIncludeResult(const std::string& path, const std::string& data) const
 		{
-			char* content = new tUserDataElement[length];
-			file.seekg(0, file.beg);
-			file.read(content, length);
-			return new IncludeResult(path, content, length, content);
+			char* content = new tUserDataElement[data.size()];
+			memcpy(content, data.data(), data.size());
+			return new IncludeResult(path, content, data.size(), content);
 		}
 
 		// If no path markers, return current working directory.
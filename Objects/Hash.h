@@ -0,0 +1,32 @@
+#pragma once
+#include <string>
+#include <stdint.h>
+#include <stddef.h>
+
+namespace ed
+{
+	// FNV-1a - used to build the keys for the shader caches
+	inline uint64_t HashString(const std::string& str, uint64_t hash = 14695981039346656037ULL)
+	{
+		for (unsigned char c : str) {
+			hash ^= c;
+			hash *= 1099511628211ULL;
+		}
+
+		// separator so that "ab"+"c" != "a"+"bc"
+		hash ^= 0xFF;
+		hash *= 1099511628211ULL;
+
+		return hash;
+	}
+	inline uint64_t HashData(const void* data, size_t size, uint64_t hash = 14695981039346656037ULL)
+	{
+		const unsigned char* bytes = (const unsigned char*)data;
+		for (size_t i = 0; i < size; i++) {
+			hash ^= bytes[i];
+			hash *= 1099511628211ULL;
+		}
+
+		return hash;
+	}
+}
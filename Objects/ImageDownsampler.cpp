@@ -0,0 +1,134 @@
+#include "ImageDownsampler.h"
+#include "Logger.h"
+#include "../Engine/GLUtils.h"
+
+#include <string>
+
+const char* DOWNSAMPLE_VS = R"(
+#version 330
+
+void main()
+{
+	// full screen triangle
+	vec2 uv = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+	gl_Position = vec4(uv * 2.0f - 1.0f, 0.0f, 1.0f);
+}
+)";
+
+const char* DOWNSAMPLE_PS = R"(
+#version 330
+
+uniform sampler2D tex;
+uniform int factor;
+
+out vec4 outColor;
+
+void main()
+{
+	ivec2 base = ivec2(gl_FragCoord.xy) * factor;
+
+	vec4 sum = vec4(0.0f);
+	for (int y = 0; y < factor; y++)
+		for (int x = 0; x < factor; x++)
+			sum += texelFetch(tex, base + ivec2(x, y), 0);
+
+	outColor = sum / float(factor * factor);
+}
+)";
+
+namespace ed
+{
+	ImageDownsampler::ImageDownsampler()
+	{
+		m_program = m_vao = m_fbo = m_output = 0;
+		m_uFactor = -1;
+		m_size = glm::ivec2(0, 0);
+		m_format = GL_RGBA8;
+	}
+	bool ImageDownsampler::m_init()
+	{
+		GLchar msg[1024];
+
+		GLuint vs = gl::CompileShader(GL_VERTEX_SHADER, DOWNSAMPLE_VS);
+		GLuint ps = gl::CompileShader(GL_FRAGMENT_SHADER, DOWNSAMPLE_PS);
+		bool compiled = gl::CheckShaderCompilationStatus(vs, msg) && gl::CheckShaderCompilationStatus(ps, msg);
+		if (!compiled) {
+			Logger::Get().Log("Failed to compile the downsampling shader: " + std::string(msg), true);
+			glDeleteShader(vs);
+			glDeleteShader(ps);
+			return false;
+		}
+
+		m_program = glCreateProgram();
+		gl::SetObjectLabel(GL_PROGRAM, m_program, "Downsampling");
+		glAttachShader(m_program, vs);
+		glAttachShader(m_program, ps);
+		glLinkProgram(m_program);
+		glDeleteShader(vs);
+		glDeleteShader(ps);
+
+		if (!gl::CheckShaderLinkStatus(m_program, msg)) {
+			Logger::Get().Log("Failed to link the downsampling shader: " + std::string(msg), true);
+			glDeleteProgram(m_program);
+			m_program = 0;
+			return false;
+		}
+
+		glUseProgram(m_program);
+		glUniform1i(glGetUniformLocation(m_program, "tex"), 0);
+		m_uFactor = glGetUniformLocation(m_program, "factor");
+		glUseProgram(0);
+
+		glGenVertexArrays(1, &m_vao);
+		glGenFramebuffers(1, &m_fbo);
+
+		return true;
+	}
+	GLuint ImageDownsampler::Downsample(GLuint tex, const glm::ivec2& size, int factor, GLenum format)
+	{
+		if (m_program == 0 && !m_init())
+			return 0;
+
+		glm::ivec2 outSize = glm::max(size / factor, glm::ivec2(1, 1));
+		if (outSize != m_size || format != m_format) {
+			if (m_output == 0)
+				glGenTextures(1, &m_output);
+			glBindTexture(GL_TEXTURE_2D, m_output);
+			glTexImage2D(GL_TEXTURE_2D, 0, format, outSize.x, outSize.y, 0, GL_RGBA, GL_FLOAT, nullptr);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			glBindTexture(GL_TEXTURE_2D, 0);
+
+			glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_output, 0);
+			m_size = outSize;
+			m_format = format;
+		}
+
+		glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+		glViewport(0, 0, m_size.x, m_size.y);
+		glDisable(GL_DEPTH_TEST);
+		glDisable(GL_BLEND);
+		glDisable(GL_CULL_FACE);
+		glDisable(GL_STENCIL_TEST);
+		glDisable(GL_SCISSOR_TEST);
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+		glUseProgram(m_program);
+		glUniform1i(m_uFactor, factor);
+
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, tex);
+
+		glBindVertexArray(m_vao);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+		glBindVertexArray(0);
+
+		glBindTexture(GL_TEXTURE_2D, 0);
+		glUseProgram(0);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		return m_output;
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/glew.h>
+#if defined(__APPLE__)
+	#include <OpenGL/gl.h>
+#else
+	#include <GL/gl.h>
+#endif
+
+namespace ed
+{
+	// shrinks a supersampled render on the GPU before it is read back - every output pixel is the box filtered
+	// average of its factor x factor block so the readback & the CPU work are factor^2 times smaller
+	class ImageDownsampler
+	{
+	public:
+		static inline ImageDownsampler& Instance()
+		{
+			static ImageDownsampler ret;
+			return ret;
+		}
+
+		ImageDownsampler(); // the objects live until the GL context is destroyed
+
+		// size is the size of tex, the returned texture (size / factor, format) is owned by the downsampler and is
+		// overwritten by the next call, 0 if the shader couldn't be created
+		GLuint Downsample(GLuint tex, const glm::ivec2& size, int factor, GLenum format = GL_RGBA8);
+
+		inline const glm::ivec2& GetSize() { return m_size; }
+
+	private:
+		bool m_init();
+
+		GLuint m_program, m_vao, m_fbo, m_output;
+		GLint m_uFactor;
+		glm::ivec2 m_size;
+		GLenum m_format;
+	};
+}
@@ -0,0 +1,351 @@
+#include "ImageSequence.h"
+#include "Logger.h"
+#include "TraceRecorder.h"
+
+#include <algorithm>
+#include <thread>
+#include <math.h>
+#include <string.h>
+#include <ghc/filesystem.hpp>
+#include <stb/stb_image.h>
+
+namespace ed
+{
+	ImageSequence::ImageSequence()
+	{
+		m_texture = 0;
+		m_first = m_digits = m_count = 0;
+		m_size = glm::ivec2(0, 0);
+
+		m_fps = IMAGE_SEQUENCE_FPS;
+		m_clock = Clock::Time;
+		m_loop = true;
+		m_lookAhead = IMAGE_SEQUENCE_LOOKAHEAD;
+		m_budget = IMAGE_SEQUENCE_BUDGET;
+
+		m_shown = m_target = -1;
+		m_late = 0;
+	}
+	ImageSequence::~ImageSequence()
+	{
+		m_releaseRing();
+	}
+	bool ImageSequence::IsSupportedFile(const std::string& path)
+	{
+		size_t nameStart = path.find_last_of("/\\");
+		std::string name = nameStart == std::string::npos ? path : path.substr(nameStart + 1);
+		size_t dot = name.find_last_of('.');
+		if (dot == std::string::npos || name.find_last_of("0123456789", dot) == std::string::npos)
+			return false;
+
+		std::string ext = name.substr(dot + 1);
+		std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+		return ext == "png" || ext == "jpg" || ext == "jpeg" || ext == "bmp" || ext == "tga";
+	}
+	bool ImageSequence::Open(const std::string& first, GLuint texture)
+	{
+		m_texture = texture;
+		m_error.clear();
+		m_count = 0;
+
+		// the last number in the file name, its digits are the minimum width of the other numbers
+		size_t nameStart = first.find_last_of("/\\");
+		nameStart = nameStart == std::string::npos ? 0 : nameStart + 1;
+		size_t numEnd = first.find_last_of("0123456789");
+		if (numEnd == std::string::npos || numEnd < nameStart) {
+			m_error = "the file name doesn't have a frame number";
+			return false;
+		}
+		size_t numStart = first.find_last_not_of("0123456789", numEnd);
+		numStart = (numStart == std::string::npos || numStart < nameStart) ? nameStart : numStart + 1;
+
+		m_digits = numEnd - numStart + 1;
+		if (m_digits > 9) {
+			m_error = "the frame number is too long";
+			return false;
+		}
+		m_prefix = first.substr(0, numStart);
+		m_suffix = first.substr(numEnd + 1);
+		m_first = std::stoi(first.substr(numStart, m_digits));
+
+		int channels = 0;
+		if (!stbi_info(first.c_str(), &m_size.x, &m_size.y, &channels)) {
+			m_error = "failed to read " + first;
+			return false;
+		}
+
+		while (ghc::filesystem::exists(GetFramePath(m_count)))
+			m_count++;
+
+		glBindTexture(GL_TEXTURE_2D, m_texture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_size.x, m_size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		m_createRing();
+
+		return true;
+	}
+	bool ImageSequence::Update(float time, unsigned int frameIndex, eng::ThreadPool& pool)
+	{
+		if (m_count == 0 || m_slots.empty())
+			return false;
+
+		int target = m_getFrame(time, frameIndex);
+		if (target != m_target && m_shown != m_target && m_target >= 0)
+			m_late++;
+		m_target = target;
+
+		m_poll();
+		bool changed = m_shown != target && m_show(target);
+
+		// the frames that are needed next, the nearest one first
+		std::vector<int> wanted;
+		for (int i = 0; i < m_slots.size(); i++) {
+			int frame = target + i;
+			if (frame >= m_count) {
+				if (!m_loop)
+					break;
+				frame %= m_count;
+			}
+			if (std::count(wanted.begin(), wanted.end(), frame) > 0)
+				break;
+			wanted.push_back(frame);
+		}
+
+		for (int frame : wanted) {
+			bool present = false;
+			for (const Slot& slot : m_slots)
+				if (slot.Frame == frame)
+					present = true;
+			if (present)
+				continue;
+
+			Slot* free = nullptr;
+			for (Slot& slot : m_slots)
+				if (m_isFree(slot, wanted)) {
+					free = &slot;
+					break;
+				}
+			if (free == nullptr)
+				break;
+
+			m_queue(*free, frame, pool);
+		}
+
+		return changed;
+	}
+	void ImageSequence::SetFrameRate(float fps)
+	{
+		m_fps = std::max(fps, 0.01f);
+	}
+	void ImageSequence::SetClock(Clock clock)
+	{
+		m_clock = clock;
+	}
+	void ImageSequence::SetLoop(bool loop)
+	{
+		m_loop = loop;
+	}
+	void ImageSequence::SetLookAhead(int frames)
+	{
+		frames = std::max(frames, 0);
+		if (frames == m_lookAhead)
+			return;
+
+		m_lookAhead = frames;
+		if (m_count > 0) {
+			m_releaseRing();
+			m_createRing();
+		}
+	}
+	void ImageSequence::SetBudget(int mb)
+	{
+		mb = std::max(mb, 1);
+		if (mb == m_budget)
+			return;
+
+		m_budget = mb;
+		if (m_count > 0) {
+			m_releaseRing();
+			m_createRing();
+		}
+	}
+	int ImageSequence::GetDecodedCount()
+	{
+		int ret = 0;
+		for (const Slot& slot : m_slots)
+			if (slot.Ready)
+				ret++;
+		return ret;
+	}
+	std::string ImageSequence::GetFramePath(int frame)
+	{
+		std::string number = std::to_string(m_first + frame);
+		if (number.size() < m_digits)
+			number.insert(0, m_digits - number.size(), '0');
+		return m_prefix + number + m_suffix;
+	}
+
+	void ImageSequence::m_decode(DecodeJob* job)
+	{
+		int width = 0, height = 0, channels = 0;
+		unsigned char* data = stbi_load(job->Path.c_str(), &width, &height, &channels, 4);
+		job->Failed = data == nullptr || width != job->Size.x || height != job->Size.y;
+		if (!job->Failed)
+			memcpy(job->Pixels, data, (size_t)width * height * 4);
+		if (data != nullptr)
+			stbi_image_free(data);
+	}
+	int ImageSequence::m_getFrame(float time, unsigned int frameIndex)
+	{
+		long long frame = frameIndex;
+		if (m_clock == Clock::Time)
+			frame = (long long)floor(std::max(time, 0.0f) * m_fps);
+
+		if (m_loop)
+			return frame % m_count;
+		return std::min<long long>(frame, m_count - 1);
+	}
+	void ImageSequence::m_poll()
+	{
+		for (Slot& slot : m_slots) {
+			if (slot.Job == nullptr || !slot.Job->Done)
+				continue;
+
+			if (slot.Mapped == nullptr) {
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.PBO);
+				glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			}
+
+			slot.Failed = slot.Job->Failed;
+			slot.Ready = !slot.Failed;
+			if (slot.Failed) {
+				std::string error = "failed to decode " + slot.Job->Path;
+				if (error != m_error)
+					Logger::Get().Log("Image sequence " + error + " - the last frame is kept", true);
+				m_error = error;
+			}
+
+			slot.Job = nullptr;
+		}
+	}
+	bool ImageSequence::m_show(int frame)
+	{
+		for (Slot& slot : m_slots) {
+			if (slot.Frame != frame)
+				continue;
+
+			// a frame that can't be decoded is skipped
+			if (slot.Failed)
+				m_shown = frame;
+			if (!slot.Ready)
+				return false;
+
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.PBO);
+			glBindTexture(GL_TEXTURE_2D, m_texture);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_size.x, m_size.y, GL_RGBA, GL_UNSIGNED_BYTE, (void*)0);
+			glBindTexture(GL_TEXTURE_2D, 0);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+			if (slot.Fence != nullptr)
+				glDeleteSync(slot.Fence);
+			slot.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+			m_shown = frame;
+			return true;
+		}
+		return false;
+	}
+	void ImageSequence::m_queue(Slot& slot, int frame, eng::ThreadPool& pool)
+	{
+		slot.Frame = frame;
+		slot.Ready = slot.Failed = false;
+
+		std::shared_ptr<DecodeJob> job = std::make_shared<DecodeJob>();
+		job->Path = GetFramePath(frame);
+		job->Size = m_size;
+		job->Done = false;
+		job->Failed = false;
+		job->Pixels = slot.Mapped;
+
+		if (job->Pixels == nullptr) {
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.PBO);
+			job->Pixels = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr)m_size.x * m_size.y * 4, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+			if (job->Pixels == nullptr) {
+				slot.Failed = true;
+				return;
+			}
+		}
+
+		slot.Job = job;
+		pool.Add([job]() {
+			TraceRecorder::Scope zone("Decode image sequence frame", "load");
+			m_decode(job.get());
+			job->Done = true;
+		});
+	}
+	bool ImageSequence::m_isFree(Slot& slot, const std::vector<int>& wanted)
+	{
+		if (slot.Job != nullptr || (slot.Frame >= 0 && std::count(wanted.begin(), wanted.end(), slot.Frame) > 0))
+			return false;
+
+		// the texture might still be copied from it
+		if (slot.Fence != nullptr) {
+			if (glClientWaitSync(slot.Fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+				return false;
+			glDeleteSync(slot.Fence);
+			slot.Fence = nullptr;
+		}
+
+		return true;
+	}
+	void ImageSequence::m_createRing()
+	{
+		// the shown frame lives in the texture, so the ring only holds the ones after it - at least one slot even if a single
+		// frame is over the budget
+		size_t frameSize = (size_t)m_size.x * m_size.y * 4;
+		size_t budget = (size_t)m_budget * 1024 * 1024;
+		int count = std::min(m_lookAhead + 1, m_count);
+		count = std::max<int>(1, std::min<size_t>(count, budget / std::max<size_t>(frameSize, 1)));
+
+		m_slots.resize(count);
+		for (Slot& slot : m_slots) {
+			slot.Frame = -1;
+			slot.Mapped = nullptr;
+			slot.Fence = nullptr;
+			slot.Ready = slot.Failed = false;
+
+			// persistently mapped if possible - the workers decode straight into it
+			glGenBuffers(1, &slot.PBO);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.PBO);
+			if (GLEW_ARB_buffer_storage) {
+				GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+				glBufferStorage(GL_PIXEL_UNPACK_BUFFER, frameSize, nullptr, flags);
+				slot.Mapped = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, frameSize, flags);
+			} else
+				glBufferData(GL_PIXEL_UNPACK_BUFFER, frameSize, nullptr, GL_STREAM_DRAW);
+		}
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+	void ImageSequence::m_releaseRing()
+	{
+		for (Slot& slot : m_slots) {
+			// the worker writes to the mapping
+			if (slot.Job != nullptr)
+				while (!slot.Job->Done)
+					std::this_thread::yield();
+
+			if (slot.Fence != nullptr)
+				glDeleteSync(slot.Fence);
+			glDeleteBuffers(1, &slot.PBO); // also unmaps it
+		}
+		m_slots.clear();
+	}
+}
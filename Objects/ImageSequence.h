@@ -0,0 +1,118 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <glm/glm.hpp>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/glew.h>
+#if defined(__APPLE__)
+	#include <OpenGL/gl.h>
+#else
+	#include <GL/gl.h>
+#endif
+
+#include "../Engine/ThreadPool.h"
+
+#define IMAGE_SEQUENCE_FPS 24.0f	// default frames per second of Time
+#define IMAGE_SEQUENCE_LOOKAHEAD 8	// default number of frames that are decoded ahead of the shown one
+#define IMAGE_SEQUENCE_BUDGET 256	// default MB that the decoded frames can take up
+
+namespace ed
+{
+	// numbered image files (render_0001.png, render_0002.png, ...) shown as one animated RGBA8 texture that follows the Time or
+	// the FrameIndex system variable - nothing is loaded up front:
+	//  - the frames after the shown one are decoded on the loader threads straight into a fixed ring of mapped pixel unpack
+	//    buffers, the ring has look-ahead + 1 slots but never takes up more than the memory budget
+	//  - only the shown frame is copied to the texture, a frame that isn't decoded in time keeps the last one on screen
+	class ImageSequence
+	{
+	public:
+		enum class Clock
+		{
+			Time,
+			FrameIndex
+		};
+
+		ImageSequence();
+		~ImageSequence(); // waits for the frames that are being decoded
+
+		static bool IsSupportedFile(const std::string& path); // an image with a number in its name
+
+		// first = the file of the first frame, the numbers after it are counted until a file is missing - allocates the texture
+		bool Open(const std::string& first, GLuint texture);
+		bool Update(float time, unsigned int frameIndex, eng::ThreadPool& pool); // main thread, once per frame - true when the texture got a new frame
+
+		void SetFrameRate(float fps);
+		void SetClock(Clock clock);
+		void SetLoop(bool loop);
+		void SetLookAhead(int frames); // these two rebuild the ring
+		void SetBudget(int mb);
+
+		inline float GetFrameRate() { return m_fps; }
+		inline Clock GetClock() { return m_clock; }
+		inline bool IsLooping() { return m_loop; }
+		inline int GetLookAhead() { return m_lookAhead; }
+		inline int GetBudget() { return m_budget; }
+
+		inline const std::string& GetError() { return m_error; }
+		inline glm::ivec2 GetSize() { return m_size; }
+		inline int GetFrameCount() { return m_count; }
+		inline int GetShownFrame() { return m_shown; } // -1 before the first one
+		inline int GetLateCount() { return m_late; } // frames that were skipped because they weren't decoded in time
+		inline bool IsWaiting() { return m_count > 0 && m_shown != m_target; } // the frame for the current time isn't in the texture yet
+		int GetDecodedCount(); // frames in the ring that are ready to be shown
+
+		inline int GetRingSize() { return m_slots.size(); }
+		inline GLuint GetRingBuffer(int slot) { return m_slots[slot].PBO; }
+
+		std::string GetFramePath(int frame);
+
+	private:
+		struct DecodeJob
+		{
+			std::string Path;
+			glm::ivec2 Size;
+			unsigned char* Pixels; // the PBO's mapping
+
+			std::atomic<bool> Done;
+			bool Failed;
+		};
+		struct Slot
+		{
+			int Frame; // -1 = empty
+			GLuint PBO;
+			unsigned char* Mapped; // persistent mapping, nullptr -> mapped for each decode
+			GLsync Fence; // the upload to the texture is still reading the PBO
+			std::shared_ptr<DecodeJob> Job;
+			bool Ready, Failed;
+		};
+
+		static void m_decode(DecodeJob* job);
+
+		int m_getFrame(float time, unsigned int frameIndex);
+		void m_poll();
+		bool m_show(int frame); // true if the texture was updated
+		void m_queue(Slot& slot, int frame, eng::ThreadPool& pool);
+		bool m_isFree(Slot& slot, const std::vector<int>& wanted);
+		void m_createRing();
+		void m_releaseRing();
+
+		GLuint m_texture;
+		std::string m_prefix, m_suffix; // the frame's number is between them
+		int m_first, m_digits, m_count;
+		glm::ivec2 m_size;
+		std::string m_error;
+
+		float m_fps;
+		Clock m_clock;
+		bool m_loop;
+		int m_lookAhead, m_budget;
+
+		std::vector<Slot> m_slots;
+		int m_shown, m_target, m_late;
+	};
+}
@@ -0,0 +1,125 @@
+#include "IncludeCache.h"
+#include "Hash.h"
+#include <fstream>
+#include <ghc/filesystem.hpp>
+
+namespace ed
+{
+	bool IncludeCache::Get(const std::string& path, std::string& content, uint64_t* hash)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		File& file = m_update(Normalize(path));
+		if (!file.Exists)
+			return false;
+
+		content = file.Content;
+		if (hash != nullptr)
+			*hash = file.Hash;
+
+		return true;
+	}
+	bool IncludeCache::Exists(const std::string& path)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_update(Normalize(path)).Exists;
+	}
+	void IncludeCache::SetDependencies(const std::string& shader, const std::vector<std::string>& includes)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		std::string key = Normalize(shader);
+
+		// remove the edges from the previous compile
+		for (const auto& inc : m_includes[key]) {
+			auto dep = m_dependents.find(inc);
+			if (dep != m_dependents.end()) {
+				dep->second.erase(key);
+				if (dep->second.empty())
+					m_dependents.erase(dep);
+			}
+		}
+
+		std::vector<std::string>& list = m_includes[key];
+		list.clear();
+		for (const auto& inc : includes) {
+			std::string incKey = Normalize(inc);
+			if (m_dependents[incKey].insert(key).second)
+				list.push_back(incKey);
+		}
+	}
+	std::vector<std::string> IncludeCache::GetDependents(const std::string& include)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		auto dep = m_dependents.find(Normalize(include));
+		if (dep == m_dependents.end())
+			return std::vector<std::string>();
+
+		return std::vector<std::string>(dep->second.begin(), dep->second.end());
+	}
+	std::vector<std::string> IncludeCache::GetIncludes(const std::string& shader)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		auto inc = m_includes.find(Normalize(shader));
+		if (inc == m_includes.end())
+			return std::vector<std::string>();
+
+		return inc->second;
+	}
+	std::vector<std::string> IncludeCache::GetAllIncludes()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		std::vector<std::string> ret;
+		for (const auto& dep : m_dependents)
+			ret.push_back(dep.first);
+		return ret;
+	}
+	void IncludeCache::Invalidate(const std::string& path)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_files.erase(Normalize(path));
+	}
+	void IncludeCache::Clear()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_files.clear();
+		m_includes.clear();
+		m_dependents.clear();
+	}
+	std::string IncludeCache::Normalize(const std::string& path)
+	{
+		return ghc::filesystem::path(path).lexically_normal().generic_string();
+	}
+	IncludeCache::File& IncludeCache::m_update(const std::string& path)
+	{
+		File& file = m_files[path];
+
+		// files are only read again when the file system says that they changed
+		std::error_code ec;
+		uint64_t size = ghc::filesystem::file_size(path, ec);
+		int64_t time = ec ? 0 : ghc::filesystem::last_write_time(path, ec).time_since_epoch().count();
+		if (ec) {
+			file.Exists = false;
+			file.Content.clear();
+			file.Time = 0;
+			file.Size = 0;
+			file.Hash = 0;
+			return file;
+		}
+
+		if (file.Exists && file.Time == time && file.Size == size)
+			return file;
+
+		std::ifstream in(path, std::ios::binary);
+		file.Exists = in.is_open();
+		file.Content = file.Exists ? std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>()) : "";
+		file.Time = time;
+		file.Size = size;
+		file.Hash = HashString(file.Content);
+
+		return file;
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <stdint.h>
+
+namespace ed
+{
+	// contents of the files that shaders #include and the shader files that include them
+	// shared between the GLSL include resolver and glslang's includer - every method can be called from the compile workers
+	class IncludeCache
+	{
+	public:
+		static inline IncludeCache& Instance()
+		{
+			static IncludeCache ret;
+			return ret;
+		}
+
+		// the file is read again only when its modification time or size changed, returns false if it doesn't exist
+		bool Get(const std::string& path, std::string& content, uint64_t* hash = nullptr);
+		bool Exists(const std::string& path);
+
+		// every file that the shader includes, directly or through other includes
+		void SetDependencies(const std::string& shader, const std::vector<std::string>& includes);
+
+		std::vector<std::string> GetDependents(const std::string& include);
+		std::vector<std::string> GetIncludes(const std::string& shader);
+		std::vector<std::string> GetAllIncludes();
+
+		void Invalidate(const std::string& path);
+		void Clear();
+
+		// paths are compared in this form
+		static std::string Normalize(const std::string& path);
+
+	private:
+		struct File
+		{
+			File() : Exists(false), Time(0), Size(0), Hash(0) {}
+
+			bool Exists;
+			int64_t Time;
+			uint64_t Size;
+			std::string Content;
+			uint64_t Hash;
+		};
+
+		File& m_update(const std::string& path);
+
+		std::mutex m_mutex;
+		std::unordered_map<std::string, File> m_files;
+		std::unordered_map<std::string, std::vector<std::string>> m_includes;			 // shader -> includes
+		std::unordered_map<std::string, std::unordered_set<std::string>> m_dependents; // include -> shaders
+	};
+}
@@ -0,0 +1,316 @@
+#include "InputRecorder.h"
+#include "RenderEngine.h"
+#include "PipelineManager.h"
+#include "ObjectManager.h"
+#include "SystemVariableManager.h"
+#include "Settings.h"
+#include "Logger.h"
+
+#include <algorithm>
+#include <fstream>
+#include <string.h>
+
+#define INPUT_RECORDING_MAGIC 0x49444553 // "SEDI"
+#define INPUT_RECORDING_VERSION 1
+
+namespace ed
+{
+	// a frame only stores the values that changed since the previous one
+	enum FrameField
+	{
+		FieldViewport = 1 << 0,
+		FieldMousePosition = 1 << 1,
+		FieldMouse = 1 << 2,
+		FieldMouseButton = 1 << 3,
+		FieldWASD = 1 << 4,
+		FieldCamera = 1 << 5,
+		FieldPicked = 1 << 6,
+		FieldAudio = 1 << 7
+	};
+
+	template <typename T>
+	static void writeValue(std::ofstream& file, const T& val)
+	{
+		file.write((const char*)&val, sizeof(T));
+	}
+	template <typename T>
+	static void readValue(std::ifstream& file, T& val)
+	{
+		file.read((char*)&val, sizeof(T));
+	}
+	static void writeString(std::ofstream& file, const std::string& str)
+	{
+		writeValue(file, (uint16_t)str.size());
+		file.write(str.data(), str.size());
+	}
+	static void readString(std::ifstream& file, std::string& str)
+	{
+		uint16_t len = 0;
+		readValue(file, len);
+		str.resize(len);
+		file.read(&str[0], len);
+	}
+
+	InputRecorder::InputRecorder()
+	{
+		m_recording = false;
+		m_replaying = false;
+		m_replayIndex = 0;
+		m_appliedPicks = -1;
+	}
+	void InputRecorder::StartRecording()
+	{
+		StopReplay();
+
+		m_frames.clear();
+		m_recording = true;
+	}
+	void InputRecorder::Capture(RenderEngine* renderer, ObjectManager* objects)
+	{
+		SystemVariableManager& systemVM = SystemVariableManager::Instance();
+
+		Frame frame;
+		frame.Time = systemVM.GetTime();
+		frame.Delta = systemVM.GetTimeDelta();
+		frame.FrameIndex = systemVM.GetFrameIndex();
+		frame.Viewport = systemVM.GetViewportSize();
+		frame.MousePosition = systemVM.GetMousePosition();
+		frame.Mouse = systemVM.GetMouse();
+		frame.MouseButton = systemVM.GetMouseButton();
+		frame.WASD = systemVM.GetKeysWASD();
+
+		frame.FPCamera = Settings::Instance().Project.FPCamera;
+		frame.CameraRotation = systemVM.GetCamera()->GetRotation();
+		if (frame.FPCamera)
+			frame.CameraPosition = glm::vec3(systemVM.GetCamera()->GetPosition());
+		else
+			frame.CameraPosition = glm::vec3(((ArcBallCamera*)systemVM.GetCamera())->GetDistance(), 0.0f, 0.0f);
+
+		for (PipelineItem* item : renderer->GetPicked())
+			frame.Picked.push_back(item->Name);
+
+		for (ObjectManagerItem* item : objects->GetItemDataList())
+			if (item->Sound != nullptr)
+				frame.Audio.push_back(std::make_pair(item->Name, item->Sound->GetOffset()));
+
+		m_frames.push_back(frame);
+	}
+	bool InputRecorder::StartReplay()
+	{
+		if (m_frames.empty())
+			return false;
+
+		m_recording = false;
+		m_replaying = true;
+		m_replayIndex = 0;
+		m_appliedPicks = -1;
+
+		// the wall clock would move the time between the frames
+		SystemVariableManager::Instance().GetTimeClock().Pause();
+
+		return true;
+	}
+	void InputRecorder::StopReplay()
+	{
+		if (!m_replaying)
+			return;
+
+		m_replaying = false;
+		SystemVariableManager::Instance().GetTimeClock().Resume();
+	}
+	bool InputRecorder::ApplyNext(RenderEngine* renderer, PipelineManager* pipeline, ObjectManager* objects)
+	{
+		if (m_replayIndex >= m_frames.size())
+			return false;
+
+		Apply(m_replayIndex, renderer, pipeline, objects);
+		m_replayIndex++;
+
+		return true;
+	}
+	void InputRecorder::Apply(int index, RenderEngine* renderer, PipelineManager* pipeline, ObjectManager* objects)
+	{
+		if (m_frames.empty())
+			return;
+
+		index = std::max(0, std::min(index, (int)m_frames.size() - 1));
+		const Frame& frame = m_frames[index];
+
+		SystemVariableManager& systemVM = SystemVariableManager::Instance();
+		systemVM.AdvanceTimer(frame.Time - systemVM.GetTime());
+		systemVM.SetTimeDelta(frame.Delta);
+		systemVM.SetFrameIndex(frame.FrameIndex);
+		systemVM.SetViewportSize(frame.Viewport.x, frame.Viewport.y);
+		systemVM.SetMousePosition(frame.MousePosition.x, frame.MousePosition.y);
+		systemVM.SetMouse(frame.Mouse.x, frame.Mouse.y, frame.Mouse.z, frame.Mouse.w);
+		systemVM.SetMouseButton(frame.MouseButton.x, frame.MouseButton.y, frame.MouseButton.z, frame.MouseButton.w);
+		systemVM.SetKeysWASD(frame.WASD.x, frame.WASD.y, frame.WASD.z, frame.WASD.w);
+
+		Settings::Instance().Project.FPCamera = frame.FPCamera;
+		if (frame.FPCamera) {
+			FirstPersonCamera* cam = (FirstPersonCamera*)systemVM.GetCamera();
+			cam->SetPosition(frame.CameraPosition.x, frame.CameraPosition.y, frame.CameraPosition.z);
+			cam->SetYaw(frame.CameraRotation.x);
+			cam->SetPitch(frame.CameraRotation.y);
+		} else {
+			ArcBallCamera* cam = (ArcBallCamera*)systemVM.GetCamera();
+			cam->SetDistance(frame.CameraPosition.x);
+			cam->SetPitch(frame.CameraRotation.x);
+			cam->SetYaw(frame.CameraRotation.y);
+			cam->SetRoll(frame.CameraRotation.z);
+		}
+
+		// picking rebuilds the list, only do it when the picks actually changed
+		if (m_appliedPicks < 0 || m_frames[m_appliedPicks].Picked != frame.Picked) {
+			renderer->Pick(nullptr);
+			for (const auto& name : frame.Picked) {
+				PipelineItem* item = pipeline->Get(name.c_str());
+				if (item != nullptr)
+					renderer->Pick(item, true);
+			}
+		}
+		m_appliedPicks = index;
+
+		for (const auto& audio : frame.Audio) {
+			ObjectManagerItem* item = objects->GetObjectManagerItem(audio.first);
+			if (item != nullptr && item->Sound != nullptr)
+				item->Sound->SetOffset(audio.second);
+		}
+	}
+	bool InputRecorder::Save(const std::string& path)
+	{
+		std::ofstream file(path, std::ios::binary);
+		if (!file.is_open()) {
+			Logger::Get().Log("Failed to write the input recording " + path, true);
+			return false;
+		}
+
+		writeValue(file, (uint32_t)INPUT_RECORDING_MAGIC);
+		writeValue(file, (uint32_t)INPUT_RECORDING_VERSION);
+		writeValue(file, (uint32_t)m_frames.size());
+
+		for (int i = 0; i < m_frames.size(); i++) {
+			const Frame& frame = m_frames[i];
+			const Frame* prev = i == 0 ? nullptr : &m_frames[i - 1];
+
+			uint16_t fields = 0;
+			if (prev == nullptr || frame.Viewport != prev->Viewport) fields |= FieldViewport;
+			if (prev == nullptr || frame.MousePosition != prev->MousePosition) fields |= FieldMousePosition;
+			if (prev == nullptr || frame.Mouse != prev->Mouse) fields |= FieldMouse;
+			if (prev == nullptr || frame.MouseButton != prev->MouseButton) fields |= FieldMouseButton;
+			if (prev == nullptr || frame.WASD != prev->WASD) fields |= FieldWASD;
+			if (prev == nullptr || frame.FPCamera != prev->FPCamera || frame.CameraPosition != prev->CameraPosition || frame.CameraRotation != prev->CameraRotation) fields |= FieldCamera;
+			if (prev == nullptr || frame.Picked != prev->Picked) fields |= FieldPicked;
+			if (prev == nullptr || frame.Audio != prev->Audio) fields |= FieldAudio;
+
+			writeValue(file, fields);
+			writeValue(file, frame.Time);
+			writeValue(file, frame.Delta);
+			writeValue(file, (uint32_t)frame.FrameIndex);
+
+			if (fields & FieldViewport) writeValue(file, frame.Viewport);
+			if (fields & FieldMousePosition) writeValue(file, frame.MousePosition);
+			if (fields & FieldMouse) writeValue(file, frame.Mouse);
+			if (fields & FieldMouseButton) writeValue(file, frame.MouseButton);
+			if (fields & FieldWASD) {
+				for (int k = 0; k < 4; k++)
+					writeValue(file, (uint8_t)frame.WASD[k]);
+			}
+			if (fields & FieldCamera) {
+				writeValue(file, (uint8_t)frame.FPCamera);
+				writeValue(file, frame.CameraPosition);
+				writeValue(file, frame.CameraRotation);
+			}
+			if (fields & FieldPicked) {
+				writeValue(file, (uint16_t)frame.Picked.size());
+				for (const auto& name : frame.Picked)
+					writeString(file, name);
+			}
+			if (fields & FieldAudio) {
+				writeValue(file, (uint16_t)frame.Audio.size());
+				for (const auto& audio : frame.Audio) {
+					writeString(file, audio.first);
+					writeValue(file, audio.second);
+				}
+			}
+		}
+
+		return file.good();
+	}
+	bool InputRecorder::Load(const std::string& path)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file.is_open()) {
+			Logger::Get().Log("Failed to open the input recording " + path, true);
+			return false;
+		}
+
+		uint32_t magic = 0, version = 0, count = 0;
+		readValue(file, magic);
+		readValue(file, version);
+		readValue(file, count);
+		if (magic != INPUT_RECORDING_MAGIC || version != INPUT_RECORDING_VERSION) {
+			Logger::Get().Log(path + " isn't an input recording or it was made by a different version", true);
+			return false;
+		}
+
+		StopReplay();
+		m_recording = false;
+		m_frames.clear();
+
+		Frame frame = Frame();
+		for (uint32_t i = 0; i < count && file.good(); i++) {
+			uint16_t fields = 0;
+			uint32_t frameIndex = 0;
+			readValue(file, fields);
+			readValue(file, frame.Time);
+			readValue(file, frame.Delta);
+			readValue(file, frameIndex);
+			frame.FrameIndex = frameIndex;
+
+			// the fields that aren't stored keep the values of the previous frame
+			if (fields & FieldViewport) readValue(file, frame.Viewport);
+			if (fields & FieldMousePosition) readValue(file, frame.MousePosition);
+			if (fields & FieldMouse) readValue(file, frame.Mouse);
+			if (fields & FieldMouseButton) readValue(file, frame.MouseButton);
+			if (fields & FieldWASD) {
+				for (int k = 0; k < 4; k++) {
+					uint8_t key = 0;
+					readValue(file, key);
+					frame.WASD[k] = key;
+				}
+			}
+			if (fields & FieldCamera) {
+				uint8_t fp = 0;
+				readValue(file, fp);
+				frame.FPCamera = fp;
+				readValue(file, frame.CameraPosition);
+				readValue(file, frame.CameraRotation);
+			}
+			if (fields & FieldPicked) {
+				uint16_t picked = 0;
+				readValue(file, picked);
+				frame.Picked.resize(picked);
+				for (auto& name : frame.Picked)
+					readString(file, name);
+			}
+			if (fields & FieldAudio) {
+				uint16_t audio = 0;
+				readValue(file, audio);
+				frame.Audio.resize(audio);
+				for (auto& item : frame.Audio) {
+					readString(file, item.first);
+					readValue(file, item.second);
+				}
+			}
+
+			if (file.good())
+				m_frames.push_back(frame);
+		}
+
+		if (m_frames.size() != count)
+			Logger::Get().Log("The input recording " + path + " is truncated, " + std::to_string(m_frames.size()) + " of " + std::to_string(count) + " frames were loaded", true);
+
+		return !m_frames.empty();
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <utility>
+#include <glm/glm.hpp>
+
+namespace ed
+{
+	class RenderEngine;
+	class PipelineManager;
+	class ObjectManager;
+
+	// records everything that SystemVariableManager gets from the user (time, mouse, WASD, camera, picked items) and the
+	// audio positions once per frame, a replay sets the exact same values before each frame so that the GUI and
+	// SHADERed --render project.sprj --replay session.sedi --benchmark report.json render the same session
+	class InputRecorder
+	{
+	public:
+		static inline InputRecorder& Instance()
+		{
+			static InputRecorder ret;
+			return ret;
+		}
+
+		struct Frame
+		{
+			float Time, Delta;
+			unsigned int FrameIndex;
+
+			glm::vec2 Viewport, MousePosition;
+			glm::vec4 Mouse, MouseButton;
+			glm::ivec4 WASD;
+
+			bool FPCamera;
+			glm::vec3 CameraPosition; // x is the distance for the arc ball camera
+			glm::vec3 CameraRotation;
+
+			std::vector<std::string> Picked;
+			std::vector<std::pair<std::string, float>> Audio; // playing offsets in seconds
+		};
+
+		InputRecorder();
+
+		void StartRecording();
+		inline void StopRecording() { m_recording = false; }
+		inline bool IsRecording() { return m_recording; }
+		void Capture(RenderEngine* renderer, ObjectManager* objects); // call before the frame is rendered
+
+		bool StartReplay(); // the time is only driven by the recording while replaying
+		void StopReplay();
+		inline bool IsReplaying() { return m_replaying; }
+		inline int GetReplayPosition() { return m_replayIndex; }
+		bool ApplyNext(RenderEngine* renderer, PipelineManager* pipeline, ObjectManager* objects); // false once every frame was replayed
+		void Apply(int index, RenderEngine* renderer, PipelineManager* pipeline, ObjectManager* objects); // the last frame is repeated past the end
+
+		bool Save(const std::string& file);
+		bool Load(const std::string& file);
+
+		inline int GetFrameCount() { return (int)m_frames.size(); }
+		inline float GetDuration() { return m_frames.empty() ? 0.0f : m_frames.back().Time - m_frames.front().Time; }
+
+	private:
+		std::vector<Frame> m_frames;
+		bool m_recording, m_replaying;
+		int m_replayIndex;
+		int m_appliedPicks; // frame whose picks were applied last, -1 -> none
+	};
+}
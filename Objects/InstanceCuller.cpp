@@ -0,0 +1,303 @@
+#include "InstanceCuller.h"
+#include "Frustum.h"
+#include "Logger.h"
+#include "ObjectManager.h"
+#include "VAOCache.h"
+#include "../Engine/GLUtils.h"
+#include "../Engine/GeometryFactory.h"
+#include "../Engine/Model.h"
+
+#include <string.h>
+#include <glm/gtc/type_ptr.hpp>
+
+#define INSTANCE_CULL_GROUP_SIZE 64
+
+static const char* InstanceCullShaderCode = R"(
+#version 430
+layout(local_size_x = 64) in;
+
+layout(std430, binding = 0) readonly buffer Source { uint src[]; };
+layout(std430, binding = 1) writeonly buffer Compacted { uint dst[]; };
+layout(std430, binding = 2) buffer Commands { uint commands[]; };
+
+uniform mat4 uWorld;
+uniform vec4 uPlanes[6];
+uniform vec3 uCenter;
+uniform float uRadius;
+uniform uint uStride;
+uniform uint uCount;
+
+void main()
+{
+	uint id = gl_GlobalInvocationID.x;
+	if (id >= uCount)
+		return;
+
+	uint base = id * uStride;
+	vec3 offset = vec3(uintBitsToFloat(src[base]), uintBitsToFloat(src[base + 1]), uintBitsToFloat(src[base + 2]));
+	vec3 center = (uWorld * vec4(uCenter + offset, 1.0)).xyz;
+
+	for (int i = 0; i < 6; i++)
+		if (dot(uPlanes[i].xyz, center) + uPlanes[i].w < -uRadius * length(uPlanes[i].xyz))
+			return;
+
+	// commands[1] is the instance count of the first indirect command
+	uint slot = atomicAdd(commands[1], 1u);
+	for (uint i = 0u; i < uStride; i++)
+		dst[slot * uStride + i] = src[base + i];
+}
+)";
+
+namespace ed
+{
+	struct DrawArraysIndirectCommand
+	{
+		GLuint Count, InstanceCount, First, BaseInstance;
+	};
+	struct DrawElementsIndirectCommand
+	{
+		GLuint Count, InstanceCount, FirstIndex;
+		GLint BaseVertex;
+		GLuint BaseInstance;
+	};
+
+	InstanceCuller::InstanceCuller()
+	{
+		m_objects = nullptr;
+		m_program = 0;
+		m_binding = 0;
+		m_uWorld = m_uPlanes = m_uCenter = m_uRadius = m_uStride = m_uCount = -1;
+	}
+	InstanceCuller::~InstanceCuller()
+	{
+		Clear();
+		if (m_program != 0)
+			glDeleteProgram(m_program);
+	}
+	bool InstanceCuller::IsSupported()
+	{
+		return GLEW_ARB_compute_shader && GLEW_ARB_shader_storage_buffer_object && GLEW_ARB_draw_indirect;
+	}
+	void InstanceCuller::Init(ObjectManager* objects, GLuint firstBinding)
+	{
+		m_objects = objects;
+		m_binding = firstBinding;
+
+		GLchar msg[1024];
+		GLuint cs = gl::CompileShader(GL_COMPUTE_SHADER, InstanceCullShaderCode);
+		if (!gl::CheckShaderCompilationStatus(cs, msg)) {
+			Logger::Get().Log("Failed to compile the instance culling shader: " + std::string(msg), true);
+			glDeleteShader(cs);
+			return;
+		}
+
+		m_program = glCreateProgram();
+		gl::SetObjectLabel(GL_PROGRAM, m_program, "Instance culling");
+		glAttachShader(m_program, cs);
+		glLinkProgram(m_program);
+		glDeleteShader(cs);
+
+		if (!gl::CheckShaderLinkStatus(m_program, msg)) {
+			Logger::Get().Log("Failed to link the instance culling shader: " + std::string(msg), true);
+			glDeleteProgram(m_program);
+			m_program = 0;
+			return;
+		}
+
+		// move the blocks away from the binding points that the passes usually use
+		const char* blocks[] = { "Source", "Compacted", "Commands" };
+		for (int i = 0; i < 3; i++)
+			glShaderStorageBlockBinding(m_program, glGetProgramResourceIndex(m_program, GL_SHADER_STORAGE_BLOCK, blocks[i]), m_binding + i);
+
+		m_uWorld = glGetUniformLocation(m_program, "uWorld");
+		m_uPlanes = glGetUniformLocation(m_program, "uPlanes");
+		m_uCenter = glGetUniformLocation(m_program, "uCenter");
+		m_uRadius = glGetUniformLocation(m_program, "uRadius");
+		m_uStride = glGetUniformLocation(m_program, "uStride");
+		m_uCount = glGetUniformLocation(m_program, "uCount");
+	}
+	bool InstanceCuller::Draw(PipelineItem* item, const std::vector<InputLayoutItem>& layout, const glm::mat4& world, const glm::mat4& viewProj, GLuint program, int lod)
+	{
+		if (m_program == 0)
+			return false;
+
+		BufferObject* buffer = nullptr;
+		std::vector<GLuint> vbos;
+		pipe::GeometryItem* geo = nullptr;
+		eng::Model* model = nullptr;
+		glm::vec3 center(0.0f), halfSize(0.0f);
+
+		if (item->Type == PipelineItem::ItemType::Geometry) {
+			geo = (pipe::GeometryItem*)item->Data;
+			buffer = (BufferObject*)geo->InstanceBuffer;
+			if (!eng::GeometryFactory::GetHalfSize(geo->Type, geo->Size, halfSize))
+				return false;
+			vbos.push_back(geo->VBO);
+		} else if (item->Type == PipelineItem::ItemType::Model) {
+			pipe::Model* mdl = (pipe::Model*)item->Data;
+			buffer = (BufferObject*)mdl->InstanceBuffer;
+			model = mdl->Data;
+			if (model == nullptr)
+				return false;
+			center = (model->GetMinBound() + model->GetMaxBound()) * 0.5f;
+			halfSize = (model->GetMaxBound() - model->GetMinBound()) * 0.5f;
+			for (const auto& mesh : model->Meshes) {
+				vbos.push_back(mesh.VBO);
+				vbos.push_back(mesh.EBO);
+			}
+		} else
+			return false;
+
+		if (buffer == nullptr || buffer->Size <= 0)
+			return false;
+
+		Entry& entry = m_entries[item];
+		if (!m_isValid(entry, layout, vbos, buffer->ID, buffer->ViewFormat)) {
+			m_free(entry);
+
+			std::vector<ShaderVariable::ValueType> format = m_objects->ParseBufferFormat(buffer->ViewFormat);
+			if (format.empty() || (format[0] != ShaderVariable::ValueType::Float3 && format[0] != ShaderVariable::ValueType::Float4)) {
+				Logger::Get().Log("Instance culling for " + std::string(item->Name) + " needs an instance buffer that starts with a float3 or float4 offset", true);
+				m_entries.erase(item);
+				return false;
+			}
+
+			glGenBuffers(1, &entry.Buffer);
+			glGenBuffers(1, &entry.Commands);
+			gl::SetObjectLabel(GL_BUFFER, entry.Buffer, std::string(item->Name) + " culled instances");
+
+			entry.Source = buffer->ID;
+			entry.Format = buffer->ViewFormat;
+			entry.Layout.resize(layout.size());
+			for (int i = 0; i < layout.size(); i++)
+				entry.Layout[i] = layout[i].Value;
+			entry.VBOs = vbos;
+			for (const auto& fmt : format)
+				entry.Stride += ShaderVariable::GetSize(fmt);
+
+			if (geo != nullptr)
+				entry.VAOs.push_back(VAOCache::Instance().Get(geo->VBO, layout, 0, entry.Buffer, format));
+			else
+				for (const auto& mesh : model->Meshes)
+					entry.VAOs.push_back(VAOCache::Instance().Get(mesh.VBO, layout, mesh.EBO, entry.Buffer, format));
+		}
+
+		int count = buffer->Size / entry.Stride;
+		if (item->Type == PipelineItem::ItemType::Geometry)
+			count = std::min(count, geo->InstanceCount);
+		else
+			count = std::min(count, ((pipe::Model*)item->Data)->InstanceCount);
+		if (count <= 0)
+			return true;
+
+		if (entry.Capacity < buffer->Size) {
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, entry.Buffer);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, buffer->Size, nullptr, GL_DYNAMIC_COPY);
+			entry.Capacity = buffer->Size;
+		}
+
+		// the instance counts start at 0 and are filled in by the compute shader
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, entry.Commands);
+		if (geo != nullptr) {
+			DrawArraysIndirectCommand cmd = { (GLuint)eng::GeometryFactory::VertexCount[geo->Type], 0, 0, 0 };
+			glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(cmd), &cmd, GL_STREAM_DRAW);
+		} else {
+			std::vector<DrawElementsIndirectCommand> cmds(model->Meshes.size());
+			for (int i = 0; i < cmds.size(); i++) {
+				model->Meshes[i].GetDrawRange(lod, cmds[i].FirstIndex, cmds[i].Count);
+				cmds[i].InstanceCount = 0;
+				cmds[i].BaseVertex = 0;
+				cmds[i].BaseInstance = 0;
+			}
+			glBufferData(GL_SHADER_STORAGE_BUFFER, cmds.size() * sizeof(DrawElementsIndirectCommand), cmds.data(), GL_STREAM_DRAW);
+		}
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+		// the instance data could have been written by a compute pass
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+		Frustum frustum;
+		frustum.Set(viewProj);
+		float scale = std::max(glm::length(glm::vec3(world[0])), std::max(glm::length(glm::vec3(world[1])), glm::length(glm::vec3(world[2]))));
+
+		glUseProgram(m_program);
+		glUniformMatrix4fv(m_uWorld, 1, GL_FALSE, glm::value_ptr(world));
+		glUniform4fv(m_uPlanes, 6, glm::value_ptr(frustum.GetPlanes()[0]));
+		glUniform3fv(m_uCenter, 1, glm::value_ptr(center));
+		glUniform1f(m_uRadius, glm::length(halfSize) * scale);
+		glUniform1ui(m_uStride, entry.Stride / sizeof(GLuint));
+		glUniform1ui(m_uCount, count);
+
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, m_binding + 0, buffer->ID);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, m_binding + 1, entry.Buffer);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, m_binding + 2, entry.Commands);
+		glDispatchCompute((count + INSTANCE_CULL_GROUP_SIZE - 1) / INSTANCE_CULL_GROUP_SIZE, 1, 1);
+		glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+		glUseProgram(program);
+
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, entry.Commands);
+		if (geo != nullptr) {
+			glBindVertexArray(entry.VAOs[0]);
+			glDrawArraysIndirect(geo->Topology, nullptr);
+		} else {
+			// every mesh draws the same instances
+			if (entry.VAOs.size() > 1) {
+				glBindBuffer(GL_COPY_READ_BUFFER, entry.Commands);
+				glBindBuffer(GL_COPY_WRITE_BUFFER, entry.Commands);
+				for (int i = 1; i < entry.VAOs.size(); i++)
+					glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, offsetof(DrawElementsIndirectCommand, InstanceCount),
+						i * sizeof(DrawElementsIndirectCommand) + offsetof(DrawElementsIndirectCommand, InstanceCount), sizeof(GLuint));
+				glBindBuffer(GL_COPY_READ_BUFFER, 0);
+				glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+			}
+
+			for (int i = 0; i < entry.VAOs.size(); i++) {
+				glBindVertexArray(entry.VAOs[i]);
+				glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)(i * sizeof(DrawElementsIndirectCommand)));
+			}
+		}
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+		return true;
+	}
+	void InstanceCuller::Release(PipelineItem* item)
+	{
+		auto entry = m_entries.find(item);
+		if (entry == m_entries.end())
+			return;
+
+		m_free(entry->second);
+		m_entries.erase(entry);
+	}
+	void InstanceCuller::Clear()
+	{
+		for (auto& entry : m_entries)
+			m_free(entry.second);
+		m_entries.clear();
+	}
+	bool InstanceCuller::m_isValid(const Entry& entry, const std::vector<InputLayoutItem>& layout, const std::vector<GLuint>& vbos, GLuint source, const char* format)
+	{
+		if (entry.Buffer == 0 || entry.Source != source || entry.Format != format || entry.VBOs != vbos || entry.Layout.size() != layout.size())
+			return false;
+
+		for (int i = 0; i < layout.size(); i++)
+			if (entry.Layout[i] != layout[i].Value)
+				return false;
+
+		return true;
+	}
+	void InstanceCuller::m_free(Entry& entry)
+	{
+		for (GLuint vao : entry.VAOs)
+			VAOCache::Instance().Release(vao);
+		entry.VAOs.clear();
+
+		if (entry.Buffer != 0)
+			glDeleteBuffers(1, &entry.Buffer);
+		if (entry.Commands != 0)
+			glDeleteBuffers(1, &entry.Commands);
+
+		entry = Entry();
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include "PipelineItem.h"
+#include "InputLayout.h"
+
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/glew.h>
+#if defined(__APPLE__)
+	#include <OpenGL/gl.h>
+#else
+	#include <GL/gl.h>
+#endif
+
+namespace ed
+{
+	class ObjectManager;
+
+	// compute prepass for instanced items with GPUCulling turned on - instances whose bounding sphere is outside
+	// of the frustum are dropped, the rest are packed into a second instance buffer that is drawn with an indirect call
+	// each instance in the BufferObject has to start with a float3/float4 offset in the item's local space
+	class InstanceCuller
+	{
+	public:
+		InstanceCuller();
+		~InstanceCuller();
+
+		static bool IsSupported();
+
+		// firstBinding, firstBinding + 1 and firstBinding + 2 are used as SSBO binding points while culling
+		void Init(ObjectManager* objects, GLuint firstBinding);
+		inline bool IsReady() { return m_program != 0; }
+
+		// culls & draws an instanced geometry or model item, program is bound again before drawing
+		// false -> the item can't be culled (no instance buffer, offset isn't a float3/float4...) and wasn't drawn
+		bool Draw(PipelineItem* item, const std::vector<InputLayoutItem>& layout, const glm::mat4& world, const glm::mat4& viewProj, GLuint program, int lod = 0);
+
+		void Release(PipelineItem* item);
+		void Clear();
+
+	private:
+		struct Entry
+		{
+			Entry() { Buffer = Commands = Source = 0; Capacity = Stride = 0; }
+
+			GLuint Buffer, Commands; // compacted instances, one indirect command per mesh
+			GLuint Source; // BufferObject that was compacted
+			int Capacity, Stride; // in bytes
+
+			std::string Format;
+			std::vector<InputLayoutValue> Layout;
+			std::vector<GLuint> VBOs, VAOs; // VAOs read the vertices from VBOs and the instances from Buffer
+		};
+
+		bool m_isValid(const Entry& entry, const std::vector<InputLayoutItem>& layout, const std::vector<GLuint>& vbos, GLuint source, const char* format);
+		void m_free(Entry& entry);
+
+		std::unordered_map<PipelineItem*, Entry> m_entries;
+		ObjectManager* m_objects;
+
+		GLuint m_program, m_binding;
+		GLint m_uWorld, m_uPlanes, m_uCenter, m_uRadius, m_uStride, m_uCount;
+	};
+}
@@ -1,64 +1,95 @@
 #include "Logger.h"
 #include "Settings.h"
-#include <fstream>
-#include <ctime>
-#include <sstream>
 #include <iostream>
-#include <iomanip>
+#include <stdio.h>
 
 namespace ed
 {
-	void Logger::Log(const std::string& msg, bool error, const std::string& file, int line)
+	Logger::Logger()
 	{
-		if (!Settings::Instance().General.Log)
-			return;
+		Stack = nullptr;
 
-		time_t now = time(0);
-		tm* ltm = localtime(&now);
+		m_queue.reset(new Slot[LOGGER_QUEUE_SIZE]);
+		for (size_t i = 0; i < LOGGER_QUEUE_SIZE; i++)
+			m_queue[i].Sequence.store(i, std::memory_order_relaxed);
+		m_tail = 0;
+		m_head = 0;
+		m_dropped = 0;
 
-		std::stringstream data;
-
-		// time
-		data << "[" << std::setw(2) << std::setfill('0') << ltm->tm_hour << ":" << std::setw(2) << std::setfill('0') << ltm->tm_min << ":" << std::setw(2) << std::setfill('0') << ltm->tm_sec << "] ";
-
-		// file and line
-		if (file.size() != 0)
-			data << "<" << file;
-
-		if (line != -1) {
-			if (file.size() == 0)
-				data << "<";
-			else data << " ";
-			data << "at line " << line;
+		m_stop = false;
+		m_thread = std::thread(&Logger::m_run, this);
+	}
+	Logger::~Logger()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_wakeMutex);
+			m_stop = true;
 		}
+		m_wake.notify_one();
+		if (m_thread.joinable())
+			m_thread.join();
 
-		if (file.size() != 0 || line != -1)
-			data << "> ";
-
-		// error
-		if (error)
-			data << "(ERROR) ";
-
-		// message
-		data << msg;
+		Flush();
+	}
+	void Logger::Log(Level level, const std::string& msg, const std::string& file, int line)
+	{
+		const Settings& settings = Settings::Instance();
+		if (!settings.General.Log || (int)level < settings.General.LogLevel)
+			return;
 
+		// formatting & writing happens on the flusher thread
+		Message data;
+		data.Type = level;
+		data.Time = time(0);
+		data.Text = msg;
+		data.File = file;
+		data.Line = line;
+		data.Stream = settings.General.StreamLogs;
+		data.Terminal = settings.General.PipeLogsToTerminal;
+
+		// a full queue means that the flusher can't keep up - the caller is never blocked
+		if (!m_push(std::move(data)))
+			m_dropped.fetch_add(1, std::memory_order_relaxed);
+	}
+	void Logger::Flush()
+	{
+		std::lock_guard<std::mutex> lock(m_flushMutex);
 
-		if (Settings::Instance().General.PipeLogsToTerminal)
-			std::cout << data.str() << std::endl;
+		bool wrote = false;
+		Message msg;
+		while (m_pop(msg)) {
+			m_write(msg);
+			wrote = true;
+		}
 
-		if (Settings::Instance().General.StreamLogs) {
-			std::ofstream log("log.txt", std::ios_base::app | std::ios_base::out);
-    		log << data.str() << std::endl;
-			log.close();
+		unsigned int dropped = m_dropped.exchange(0, std::memory_order_relaxed);
+		if (dropped > 0) {
+			msg.Type = Level::Warning;
+			msg.Time = time(0);
+			msg.Text = std::to_string(dropped) + " log messages were dropped";
+			msg.File.clear();
+			msg.Line = -1;
+			m_write(msg);
+			wrote = true;
 		}
-		else
-			m_msgs.push_back(data.str());
+
+		if (wrote && m_file.is_open())
+			m_file.flush();
+		if (wrote && msg.Terminal)
+			std::cout.flush();
 	}
 	void Logger::Save()
 	{
-		if (!Settings::Instance().General.Log || Settings::Instance().General.StreamLogs)
+		if (!Settings::Instance().General.Log)
 			return;
 
+		Flush();
+
+		if (Settings::Instance().General.StreamLogs)
+			return;
+
+		std::lock_guard<std::mutex> lock(m_flushMutex);
+
 		time_t now = time(0);
 		tm* ltm = localtime(&now);
 
@@ -70,4 +101,91 @@ namespace ed
 
 		file.close();
 	}
-}
\ No newline at end of file
+	bool Logger::m_push(Message&& msg)
+	{
+		// bounded multi-producer queue: a slot is free when its sequence equals the position that claims it
+		size_t pos = m_tail.load(std::memory_order_relaxed);
+		Slot* slot = nullptr;
+		while (true) {
+			slot = &m_queue[pos & (LOGGER_QUEUE_SIZE - 1)];
+			size_t seq = slot->Sequence.load(std::memory_order_acquire);
+			intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+			if (diff == 0) {
+				if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			} else if (diff < 0)
+				return false;
+			else
+				pos = m_tail.load(std::memory_order_relaxed);
+		}
+
+		slot->Data = std::move(msg);
+		slot->Sequence.store(pos + 1, std::memory_order_release);
+
+		// don't wait for the next interval when there's a burst of messages
+		if (((pos + 1) & (LOGGER_QUEUE_SIZE / 4 - 1)) == 0)
+			m_wake.notify_one();
+
+		return true;
+	}
+	bool Logger::m_pop(Message& msg)
+	{
+		Slot& slot = m_queue[m_head & (LOGGER_QUEUE_SIZE - 1)];
+		if (slot.Sequence.load(std::memory_order_acquire) != m_head + 1)
+			return false;
+
+		msg = std::move(slot.Data);
+		slot.Sequence.store(m_head + LOGGER_QUEUE_SIZE, std::memory_order_release);
+		m_head++;
+
+		return true;
+	}
+	void Logger::m_write(const Message& msg)
+	{
+		tm* ltm = localtime(&msg.Time);
+
+		char prefix[32];
+		snprintf(prefix, sizeof(prefix), "[%02d:%02d:%02d] ", ltm->tm_hour, ltm->tm_min, ltm->tm_sec);
+
+		std::string data = prefix;
+
+		// file and line
+		if (!msg.File.empty() || msg.Line != -1) {
+			data += "<" + msg.File;
+			if (msg.Line != -1)
+				data += (msg.File.empty() ? "at line " : " at line ") + std::to_string(msg.Line);
+			data += "> ";
+		}
+
+		// level
+		if (msg.Type == Level::Error)
+			data += "(ERROR) ";
+		else if (msg.Type == Level::Warning)
+			data += "(WARNING) ";
+
+		// message
+		data += msg.Text;
+
+		if (msg.Terminal)
+			std::cout << data << '\n';
+
+		if (msg.Stream) {
+			if (!m_file.is_open())
+				m_file.open("log.txt", std::ios_base::app | std::ios_base::out);
+			m_file << data << '\n';
+		}
+		else
+			m_msgs.push_back(data);
+	}
+	void Logger::m_run()
+	{
+		while (!m_stop) {
+			{
+				std::unique_lock<std::mutex> lock(m_wakeMutex);
+				m_wake.wait_for(lock, std::chrono::milliseconds(LOGGER_FLUSH_INTERVAL));
+			}
+
+			Flush();
+		}
+	}
+}
@@ -1,27 +1,81 @@
 #pragma once
 #include "MessageStack.h"
 #include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <fstream>
+#include <condition_variable>
+#include <ctime>
+#include <stdint.h>
+
+#define LOGGER_QUEUE_SIZE 8192		// must be a power of two
+#define LOGGER_FLUSH_INTERVAL 100	// ms
 
 namespace ed
 {
+	// messages are put in a lock-free queue and formatted & written by a background thread
 	class Logger
 	{
 	public:
+		enum class Level
+		{
+			Info,
+			Warning,
+			Error
+		};
+
 		MessageStack* Stack;
 
-		Logger() {
-			Stack = nullptr;
-		}
+		Logger();
+		~Logger();
 
 		static Logger& Get() {
 			static Logger ret;
 			return ret;
 		}
 
-		void Log(const std::string& msg, bool error = false, const std::string& file = "", int line = -1);
+		inline void Log(const std::string& msg, bool error = false, const std::string& file = "", int line = -1) { Log(error ? Level::Error : Level::Info, msg, file, line); }
+		void Log(Level level, const std::string& msg, const std::string& file = "", int line = -1);
+		void Flush(); // writes the queued messages on the calling thread
 		void Save();
 
 	private:
+		struct Message
+		{
+			Message() : Type(Level::Info), Time(0), Line(-1), Stream(false), Terminal(false) {}
+
+			Level Type;
+			time_t Time;
+			std::string Text, File;
+			int Line;
+			bool Stream, Terminal; // settings at the time of the Log() call
+		};
+		struct Slot
+		{
+			std::atomic<size_t> Sequence;
+			Message Data;
+		};
+
+		bool m_push(Message&& msg);
+		bool m_pop(Message& msg);
+		void m_write(const Message& msg);
+		void m_run();
+
+		std::unique_ptr<Slot[]> m_queue;
+		std::atomic<size_t> m_tail;
+		size_t m_head; // only touched while m_flushMutex is locked
+		std::atomic<unsigned int> m_dropped;
+
+		std::mutex m_flushMutex; // the flusher thread and Save()/Flush() can drain the queue
 		std::vector<std::string> m_msgs;
+		std::ofstream m_file;
+
+		std::thread m_thread;
+		std::atomic<bool> m_stop;
+		std::mutex m_wakeMutex;
+		std::condition_variable m_wake;
 	};
-}
\ No newline at end of file
+}
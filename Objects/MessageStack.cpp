@@ -1,64 +1,116 @@
 #include "MessageStack.h"
+#include <algorithm>
 
 namespace ed
 {
 	MessageStack::MessageStack()
 	{
 		BuildOccured = false;
+		m_total[0] = m_total[1] = m_total[2] = 0;
 	}
 	MessageStack::~MessageStack()
 	{}
 	void MessageStack::Add(const std::vector<Message>& msgs)
 	{
 		m_msgs.insert(m_msgs.end(), msgs.begin(), msgs.end());
+		for (const auto& msg : msgs)
+			m_updateCount(msg, 1);
 	}
 	void MessageStack::Add(Type type, const std::string & group, const std::string & message, int ln, int sh)
 	{
 		m_msgs.push_back({ type, group, message, ln, sh });
+		m_updateCount(m_msgs.back(), 1);
+	}
+	void MessageStack::Clear()
+	{
+		m_msgs.clear();
+		m_groups.clear();
+		m_total[0] = m_total[1] = m_total[2] = 0;
 	}
 	void MessageStack::ClearGroup(const std::string & group, int type)
 	{
-		for (int i = 0; i < m_msgs.size(); i++)
-			if (m_msgs[i].Group == group && (type == -1 || m_msgs[i].MType == (ed::MessageStack::Type)type)) {
-				m_msgs.erase(m_msgs.begin() + i);
-				i--;
-			}
+		// most of the groups that are cleared before a compile don't have any messages
+		auto info = m_groups.find(group);
+		if (info == m_groups.end())
+			return;
+		if (type != -1 && info->second.Count[type] == 0)
+			return;
+
+		auto end = std::remove_if(m_msgs.begin(), m_msgs.end(), [&](const Message& msg) {
+			return msg.Group == group && (type == -1 || msg.MType == (ed::MessageStack::Type)type);
+		});
+
+		for (auto it = end; it != m_msgs.end(); it++)
+			m_total[(int)it->MType]--;
+		m_msgs.erase(end, m_msgs.end());
+
+		if (type == -1)
+			m_groups.erase(info);
+		else {
+			info->second.Count[type] = 0;
+			if (info->second.Count[0] + info->second.Count[1] + info->second.Count[2] == 0)
+				m_groups.erase(info);
+		}
+	}
+	void MessageStack::ClearStage(const std::string& group, int shader)
+	{
+		if (m_groups.count(group) == 0)
+			return;
+
+		auto end = std::remove_if(m_msgs.begin(), m_msgs.end(), [&](const Message& msg) {
+			return msg.Group == group && msg.Shader == shader;
+		});
+
+		for (auto it = end; it != m_msgs.end(); it++)
+			m_updateCount(*it, -1);
+		m_msgs.erase(end, m_msgs.end());
+
+		auto info = m_groups.find(group);
+		if (info->second.Count[0] + info->second.Count[1] + info->second.Count[2] == 0)
+			m_groups.erase(info);
 	}
 	int MessageStack::GetGroupWarningMsgCount(const std::string& group)
 	{
-		int cnt = 0;
-		for (int i = 0; i < m_msgs.size(); i++)
-			if (m_msgs[i].Group == group && m_msgs[i].MType == ed::MessageStack::Type::Warning)
-				cnt++;
-		return cnt;
+		auto info = m_groups.find(group);
+		if (info == m_groups.end())
+			return 0;
+		return info->second.Count[(int)Type::Warning];
 	}
 	int MessageStack::GetErrorAndWarningMsgCount()
 	{
-		int cnt = 0;
-		for (int i = 0; i < m_msgs.size(); i++)
-			if (m_msgs[i].MType == ed::MessageStack::Type::Warning || m_msgs[i].MType == ed::MessageStack::Type::Error)
-				cnt++;
-		return cnt;
+		return m_total[(int)Type::Error] + m_total[(int)Type::Warning];
 	}
 	int MessageStack::GetGroupErrorAndWarningMsgCount(const std::string& group)
 	{
-		int cnt = 0;
-		for (int i = 0; i < m_msgs.size(); i++)
-			if ((m_msgs[i].MType == ed::MessageStack::Type::Warning || m_msgs[i].MType == ed::MessageStack::Type::Error) && m_msgs[i].Group == group)
-				cnt++;
-		return cnt;
+		auto info = m_groups.find(group);
+		if (info == m_groups.end())
+			return 0;
+		return info->second.Count[(int)Type::Error] + info->second.Count[(int)Type::Warning];
 	}
 	void MessageStack::RenameGroup(const std::string& group, const std::string& newName)
 	{
+		auto info = m_groups.find(group);
+		if (info == m_groups.end() || group == newName)
+			return;
+
 		for (int i = 0; i < m_msgs.size(); i++)
 			if (m_msgs[i].Group == group)
 				m_msgs[i].Group = newName;
+
+		GroupInfo counts = info->second;
+		m_groups.erase(info);
+
+		GroupInfo& dest = m_groups[newName];
+		for (int i = 0; i < 3; i++)
+			dest.Count[i] += counts.Count[i];
 	}
 	bool MessageStack::CanRenderPreview()
 	{
-		for (int i = 0; i < m_msgs.size(); i++)
-			if (m_msgs[i].MType == Type::Error)
-				return false;
-		return true;
+		return m_total[(int)Type::Error] == 0;
+	}
+	void MessageStack::m_updateCount(const Message& msg, int dir)
+	{
+		m_groups[msg.Group].Count[(int)msg.MType] += dir;
+		m_total[(int)msg.MType] += dir;
 	}
-}
\ No newline at end of file
+}
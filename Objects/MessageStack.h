@@ -1,6 +1,7 @@
 #pragma once
 #include <string>
 #include <vector>
+#include <unordered_map>
 
 namespace ed
 {
@@ -50,7 +51,8 @@ namespace ed
 		void Add(const std::vector<Message>& msgs);
 		void Add(Type type, const std::string& group, const std::string& message, int ln = -1, int sh = -1);
 		void ClearGroup(const std::string& group, int type = -1); // -1 == all, else use an MessageStack::Type enum
-		inline void Clear() { m_msgs.clear(); }
+		void ClearStage(const std::string& group, int shader); // only the messages of one shader stage (0=VS, 1=PS, 2=GS, 3=CS)
+		void Clear();
 		int GetGroupWarningMsgCount(const std::string &group);
 		int GetErrorAndWarningMsgCount();
 		int GetGroupErrorAndWarningMsgCount(const std::string& group);
@@ -58,9 +60,20 @@ namespace ed
 
 		bool CanRenderPreview();
 
+		// don't change the group or the type of the messages through this, the counters won't see it
 		inline std::vector<Message>& GetMessages() { return m_msgs; }
 
 	private:
 		std::vector<Message> m_msgs;
+
+		/* counters - updated with every change so that the UI can query them each frame */
+		struct GroupInfo
+		{
+			GroupInfo() : Count{ 0, 0, 0 } {}
+			int Count[3]; // indexed with MessageStack::Type
+		};
+		std::unordered_map<std::string, GroupInfo> m_groups;
+		int m_total[3];
+		void m_updateCount(const Message& msg, int dir); // dir is 1 when the message is added, -1 when it is removed
 	};
 }
\ No newline at end of file
@@ -0,0 +1,258 @@
+#include "MicroBenchmark.h"
+#include "ShaderTranscompiler.h"
+#include "ShaderVariableContainer.h"
+#include "AudioAnalyzer.h"
+#include "Settings.h"
+#include "Logger.h"
+#include "../InterfaceManager.h"
+
+#include <ghc/filesystem.hpp>
+#include <SFML/Audio/SoundBuffer.hpp>
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <math.h>
+#include <stdio.h>
+
+namespace ed
+{
+	MicroBenchmark::MicroBenchmark(InterfaceManager* data)
+	{
+		MinTime = 0.5;
+		m_data = data;
+	}
+	void MicroBenchmark::Run(const std::string& filter)
+	{
+		m_filter = filter;
+		m_results.clear();
+
+		printf("%-48s %15s %12s\n", "Benchmark", "Time", "Iterations");
+		printf("%s\n", std::string(77, '-').c_str());
+
+		m_transcompiler();
+		m_projectParser();
+		m_audioAnalyzer();
+		m_variableContainer();
+	}
+	bool MicroBenchmark::Save(const std::string& file)
+	{
+		// same layout as Google Benchmark's --benchmark_out so that the same tools can read it
+		std::ofstream out(file);
+		if (!out.is_open()) {
+			Logger::Get().Log("Failed to write the benchmark results to " + file, true);
+			return false;
+		}
+
+		out << std::fixed << std::setprecision(2);
+		out << "{" << std::endl;
+		out << "\t\"benchmarks\": [";
+		for (int i = 0; i < m_results.size(); i++) {
+			out << (i == 0 ? "" : ",") << std::endl;
+			out << "\t\t{ \"name\": \"" << m_results[i].Name << "\", \"iterations\": " << m_results[i].Iterations
+				<< ", \"real_time\": " << m_results[i].Time << ", \"time_unit\": \"ns\" }";
+		}
+		out << std::endl << "\t]" << std::endl;
+		out << "}" << std::endl;
+
+		return true;
+	}
+	void MicroBenchmark::m_run(const std::string& name, const Function& func)
+	{
+		if (!m_filter.empty() && name.find(m_filter) == std::string::npos)
+			return;
+
+		size_t iterations = 1;
+		double elapsed = 0.0;
+		while (true) {
+			auto start = std::chrono::high_resolution_clock::now();
+			func(iterations);
+			elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+			if (elapsed >= MinTime || iterations >= 1000000000)
+				break;
+
+			// aim a bit over MinTime but never grow more than 10x at once
+			double multiplier = elapsed <= 0.0 ? 10.0 : std::min(10.0, std::max(1.5, MinTime * 1.4 / elapsed));
+			iterations = (size_t)(iterations * multiplier) + 1;
+		}
+
+		Result res;
+		res.Name = name;
+		res.Iterations = iterations;
+		res.Time = elapsed * 1e9 / iterations;
+		m_results.push_back(res);
+
+		printf("%-48s %12.0f ns %12zu\n", name.c_str(), res.Time, res.Iterations);
+	}
+
+	void MicroBenchmark::m_transcompiler()
+	{
+		// the results are cached in memory & on disk - only the in memory cache is measured separately
+		bool programCache = Settings::Instance().General.ProgramCache;
+		Settings::Instance().General.ProgramCache = false;
+
+		const int sizes[] = { 8, 64, 512 }; // number of functions in the shader
+		for (int size : sizes) {
+			std::string hlsl = "cbuffer cbPerFrame : register(b0)\n{\n\tfloat4 color;\n\tfloat time;\n};\n\n";
+			std::string vulkan = "#version 450\n\nlayout(std140, binding = 0) uniform cbPerFrame\n{\n\tvec4 color;\n\tfloat time;\n} ubo;\n\nlayout(location = 0) out vec4 outColor;\n\n";
+			for (int i = 0; i < size; i++) {
+				std::string index = std::to_string(i);
+				hlsl += "float4 func" + index + "(float4 x)\n{\n\treturn sin(x * " + index + ".0f + time) * 0.5f + x * 0.5f;\n}\n";
+				vulkan += "vec4 func" + index + "(vec4 x)\n{\n\treturn sin(x * " + index + ".0 + ubo.time) * 0.5 + x * 0.5;\n}\n";
+			}
+
+			hlsl += "float4 main(float4 pos : SV_POSITION) : SV_TARGET\n{\n\tfloat4 ret = color;\n";
+			vulkan += "void main()\n{\n\tvec4 ret = ubo.color;\n";
+			for (int i = 0; i < size; i++) {
+				hlsl += "\tret = func" + std::to_string(i) + "(ret);\n";
+				vulkan += "\tret = func" + std::to_string(i) + "(ret);\n";
+			}
+			hlsl += "\treturn ret;\n}\n";
+			vulkan += "\toutColor = ret;\n}\n";
+
+			std::vector<ShaderMacro> macros;
+			MessageStack msgs;
+			std::string suffix = "/" + std::to_string(size);
+			int counter = 0;
+
+			auto transcompile = [&](ShaderLanguage lang, const std::string& source, bool unique) {
+				return [&, lang, source, unique](size_t iterations) {
+					for (size_t i = 0; i < iterations; i++) {
+						// a different comment is enough to skip the cache
+						std::string input = unique ? source + "// " + std::to_string(counter++) + "\n" : source;
+						ShaderTranscompiler::TranscompileSource(lang, "bench.shader", input, 1, "main", macros, false, &msgs, &m_data->Parser);
+					}
+				};
+			};
+
+			m_run("Transcompile/HLSL" + suffix, transcompile(ShaderLanguage::HLSL, hlsl, true));
+			m_run("Transcompile/VulkanGLSL" + suffix, transcompile(ShaderLanguage::VulkanGLSL, vulkan, true));
+			m_run("Transcompile/HLSL/Cached" + suffix, transcompile(ShaderLanguage::HLSL, hlsl, false));
+		}
+
+		Settings::Instance().General.ProgramCache = programCache;
+	}
+	void MicroBenchmark::m_projectParser()
+	{
+		ghc::filesystem::path dir = ghc::filesystem::temp_directory_path() / "shadered_bench";
+		std::error_code errCode;
+		ghc::filesystem::create_directories(dir / "shaders", errCode);
+
+		std::ofstream(dir / "shaders" / "VS.glsl") << "#version 330\n\nuniform mat4 matVP;\nuniform mat4 matGeo;\n\nlayout (location = 0) in vec3 pos;\n\nvoid main() {\n\tgl_Position = matVP * matGeo * vec4(pos, 1);\n}\n";
+		std::ofstream(dir / "shaders" / "PS.glsl") << "#version 330\n\nuniform vec4 color;\nout vec4 outColor;\n\nvoid main() {\n\toutColor = color;\n}\n";
+
+		const int sizes[] = { 16, 128 }; // number of passes
+		for (int size : sizes) {
+			std::string file = (dir / ("project" + std::to_string(size) + ".sprj")).generic_string();
+			std::ofstream project(file);
+			project << "<?xml version=\"1.0\"?>\n<project version=\"2\">\n\t<pipeline>\n";
+			for (int p = 0; p < size; p++) {
+				project << "\t\t<pass name=\"Pass" << p << "\" type=\"shader\">\n";
+				project << "\t\t\t<shader type=\"vs\" path=\"shaders/VS.glsl\" entry=\"main\" />\n";
+				project << "\t\t\t<shader type=\"ps\" path=\"shaders/PS.glsl\" entry=\"main\" />\n";
+				project << "\t\t\t<rendertexture />\n\t\t\t<variables>\n";
+				project << "\t\t\t\t<variable type=\"float4x4\" name=\"matVP\" system=\"ViewProjection\" />\n";
+				project << "\t\t\t\t<variable type=\"float4x4\" name=\"matGeo\" system=\"GeometryTransform\" />\n";
+				for (int v = 0; v < 16; v++)
+					project << "\t\t\t\t<variable type=\"float4\" name=\"var" << v << "\">\n\t\t\t\t\t<row>\n\t\t\t\t\t\t<value>1</value>\n\t\t\t\t\t\t<value>0.5</value>\n\t\t\t\t\t\t<value>0.25</value>\n\t\t\t\t\t\t<value>1</value>\n\t\t\t\t\t</row>\n\t\t\t\t</variable>\n";
+				project << "\t\t\t</variables>\n\t\t\t<macros />\n\t\t\t<items>\n";
+				for (int i = 0; i < 4; i++)
+					project << "\t\t\t\t<item name=\"Box" << p << "_" << i << "\" type=\"geometry\">\n\t\t\t\t\t<type>Cube</type>\n\t\t\t\t\t<width>1</width>\n\t\t\t\t\t<height>1</height>\n\t\t\t\t\t<depth>1</depth>\n\t\t\t\t\t<x>" << i << "</x>\n\t\t\t\t\t<topology>TriangleList</topology>\n\t\t\t\t</item>\n";
+				project << "\t\t\t</items>\n\t\t\t<itemvalues />\n\t\t</pass>\n";
+			}
+			project << "\t</pipeline>\n\t<objects />\n\t<cameras />\n\t<settings />\n</project>\n";
+			project.close();
+
+			m_run("ProjectParser::Open/" + std::to_string(size), [&](size_t iterations) {
+				for (size_t i = 0; i < iterations; i++)
+					m_data->Parser.Open(file);
+			});
+		}
+
+		ghc::filesystem::remove_all(dir, errCode);
+	}
+	void MicroBenchmark::m_audioAnalyzer()
+	{
+		// 10 seconds of a stereo chord
+		const int rate = 44100, channels = 2;
+		std::vector<sf::Int16> samples(rate * channels * 10);
+		for (size_t i = 0; i < samples.size() / channels; i++) {
+			double t = (double)i / rate;
+			sf::Int16 s = (sf::Int16)(8000.0 * (sin(t * 2 * 3.14159 * 220.0) + sin(t * 2 * 3.14159 * 277.2) + sin(t * 2 * 3.14159 * 329.6)));
+			samples[i * channels] = samples[i * channels + 1] = s;
+		}
+
+		sf::SoundBuffer buffer;
+		buffer.loadFromSamples(samples.data(), samples.size(), channels, rate);
+
+		AudioAnalyzer analyzer;
+		int perChannel = samples.size() / channels;
+		m_run("AudioAnalyzer::FFT", [&](size_t iterations) {
+			for (size_t i = 0; i < iterations; i++)
+				analyzer.FFT(buffer, (i * 735) % (perChannel - AudioAnalyzer::SampleCount)); // 735 samples = one frame at 60 FPS
+		});
+	}
+	void MicroBenchmark::m_variableContainer()
+	{
+		const int sizes[] = { 100, 500 }; // number of variables
+		for (int size : sizes) {
+			// a program that uses all of the variables
+			std::string vs = "#version 330\n\nlayout (location = 0) in vec3 pos;\n\nvoid main() {\n\tgl_Position = vec4(pos, 1);\n}\n";
+			std::string ps = "#version 330\n\nout vec4 outColor;\n\n";
+			for (int i = 0; i < size; i++)
+				ps += "uniform vec4 var" + std::to_string(i) + ";\n";
+			ps += "\nvoid main() {\n\tvec4 sum = vec4(0.0);\n";
+			for (int i = 0; i < size; i++)
+				ps += "\tsum += var" + std::to_string(i) + ";\n";
+			ps += "\toutColor = sum;\n}\n";
+
+			GLuint shaders[2] = { glCreateShader(GL_VERTEX_SHADER), glCreateShader(GL_FRAGMENT_SHADER) };
+			const char* sources[2] = { vs.c_str(), ps.c_str() };
+			GLuint program = glCreateProgram();
+			for (int i = 0; i < 2; i++) {
+				glShaderSource(shaders[i], 1, &sources[i], nullptr);
+				glCompileShader(shaders[i]);
+				glAttachShader(program, shaders[i]);
+			}
+			glLinkProgram(program);
+			for (int i = 0; i < 2; i++)
+				glDeleteShader(shaders[i]);
+
+			GLint linked = 0;
+			glGetProgramiv(program, GL_LINK_STATUS, &linked);
+			if (!linked) {
+				// drivers limit the number of uniforms
+				Logger::Get().Log("Failed to link the program for ShaderVariableContainer::Bind/" + std::to_string(size), true);
+				glDeleteProgram(program);
+				continue;
+			}
+
+			ShaderVariableContainer container;
+			for (int i = 0; i < size; i++)
+				container.Add(new ShaderVariable(ShaderVariable::ValueType::Float4, ("var" + std::to_string(i)).c_str()));
+
+			glUseProgram(program);
+			container.UpdateUniformInfo(program);
+
+			std::string suffix = "/" + std::to_string(size);
+			m_run("ShaderVariableContainer::Bind" + suffix, [&](size_t iterations) {
+				for (size_t i = 0; i < iterations; i++)
+					container.Bind();
+			});
+			m_run("ShaderVariableContainer::Bind/Changed" + suffix, [&](size_t iterations) {
+				std::vector<ShaderVariable*>& vars = container.GetVariables();
+				for (size_t i = 0; i < iterations; i++) {
+					// every value is different from the one that was uploaded last time
+					for (ShaderVariable* var : vars)
+						((float*)var->Data)[0] = (float)i;
+					container.Bind();
+				}
+			});
+			glFinish();
+
+			glUseProgram(0);
+			glDeleteProgram(program);
+		}
+	}
+}
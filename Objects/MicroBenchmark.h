@@ -0,0 +1,45 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <functional>
+
+namespace ed
+{
+	class InterfaceManager;
+
+	// times the CPU hot spots in isolation, the same way Google Benchmark does: every case
+	// is repeated until it ran for at least MinTime and the time per iteration is reported
+	class MicroBenchmark
+	{
+	public:
+		MicroBenchmark(InterfaceManager* data);
+
+		struct Result
+		{
+			std::string Name;
+			size_t Iterations;
+			double Time; // nanoseconds per iteration
+		};
+
+		double MinTime; // in seconds
+
+		void Run(const std::string& filter = "");
+		bool Save(const std::string& file);
+
+		inline const std::vector<Result>& GetResults() { return m_results; }
+
+	private:
+		// runs the measured code the given number of times
+		typedef std::function<void(size_t)> Function;
+		void m_run(const std::string& name, const Function& func);
+
+		void m_transcompiler();
+		void m_projectParser();
+		void m_audioAnalyzer();
+		void m_variableContainer();
+
+		InterfaceManager* m_data;
+		std::string m_filter;
+		std::vector<Result> m_results;
+	};
+}
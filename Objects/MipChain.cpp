@@ -0,0 +1,194 @@
+#include "MipChain.h"
+#include "Logger.h"
+#include "../Engine/GLUtils.h"
+
+#include <string>
+
+const char* MIP_CHAIN_VS = R"(
+#version 330
+
+void main()
+{
+	// full screen triangle
+	vec2 uv = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+	gl_Position = vec4(uv * 2.0f - 1.0f, 0.0f, 1.0f);
+}
+)";
+
+const char* MIP_CHAIN_PS = R"(
+#version 330
+
+uniform sampler2D tex; // only the source level is visible (base level == max level)
+uniform int filter; // 1 = min, 2 = max
+uniform ivec2 srcSize;
+
+out vec4 outColor;
+
+void main()
+{
+	ivec2 dst = ivec2(gl_FragCoord.xy);
+	ivec2 dstSize = max(srcSize / 2, ivec2(1));
+
+	// the last row & column of an odd sized level also cover the texel that doesn't have a pair
+	ivec2 start = dst * 2;
+	ivec2 end = min(start + 1 + ivec2(equal(dst, dstSize - 1)) * (srcSize & 1), srcSize - 1);
+
+	vec4 ret = texelFetch(tex, start, 0);
+	for (int y = start.y; y <= end.y; y++)
+		for (int x = start.x; x <= end.x; x++) {
+			vec4 val = texelFetch(tex, ivec2(x, y), 0);
+			ret = filter == 1 ? min(ret, val) : max(ret, val);
+		}
+
+	outColor = ret;
+}
+)";
+
+namespace ed
+{
+	MipChain::MipChain()
+	{
+		m_program = m_vao = m_fbo = 0;
+		m_filterLoc = m_sizeLoc = -1;
+	}
+	MipChain::~MipChain()
+	{
+		if (m_program != 0) {
+			glDeleteProgram(m_program);
+			glDeleteVertexArrays(1, &m_vao);
+			glDeleteFramebuffers(1, &m_fbo);
+		}
+	}
+	bool MipChain::IsSupported(GLuint format)
+	{
+		switch (format) {
+		case GL_RGB10_A2UI:
+		case GL_R8I: case GL_R8UI: case GL_R16I: case GL_R16UI: case GL_R32I: case GL_R32UI:
+		case GL_RG8I: case GL_RG8UI: case GL_RG16I: case GL_RG16UI: case GL_RG32I: case GL_RG32UI:
+		case GL_RGB8I: case GL_RGB8UI: case GL_RGB16I: case GL_RGB16UI: case GL_RGB32I: case GL_RGB32UI:
+		case GL_RGBA8I: case GL_RGBA8UI: case GL_RGBA16I: case GL_RGBA16UI: case GL_RGBA32I: case GL_RGBA32UI:
+			return false;
+		}
+		return true;
+	}
+	void MipChain::Allocate(GLuint tex, bool mipmaps)
+	{
+		glBindTexture(GL_TEXTURE_2D, tex);
+		if (mipmaps)
+			glGenerateMipmap(GL_TEXTURE_2D); // defines the levels with the format & size that match level 0
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, mipmaps ? 1000 : 0);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, mipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+	bool MipChain::m_init()
+	{
+		GLchar msg[1024];
+
+		GLuint vs = gl::CompileShader(GL_VERTEX_SHADER, MIP_CHAIN_VS);
+		GLuint ps = gl::CompileShader(GL_FRAGMENT_SHADER, MIP_CHAIN_PS);
+		bool compiled = gl::CheckShaderCompilationStatus(vs, msg) && gl::CheckShaderCompilationStatus(ps, msg);
+		if (!compiled) {
+			Logger::Get().Log("Failed to compile the mip chain shader: " + std::string(msg), true);
+			glDeleteShader(vs);
+			glDeleteShader(ps);
+			return false;
+		}
+
+		m_program = glCreateProgram();
+		gl::SetObjectLabel(GL_PROGRAM, m_program, "Mip chain");
+		glAttachShader(m_program, vs);
+		glAttachShader(m_program, ps);
+		glLinkProgram(m_program);
+		glDeleteShader(vs);
+		glDeleteShader(ps);
+
+		if (!gl::CheckShaderLinkStatus(m_program, msg)) {
+			Logger::Get().Log("Failed to link the mip chain shader: " + std::string(msg), true);
+			glDeleteProgram(m_program);
+			m_program = 0;
+			return false;
+		}
+
+		glUseProgram(m_program);
+		glUniform1i(glGetUniformLocation(m_program, "tex"), 0);
+		m_filterLoc = glGetUniformLocation(m_program, "filter");
+		m_sizeLoc = glGetUniformLocation(m_program, "srcSize");
+		glUseProgram(0);
+
+		glGenVertexArrays(1, &m_vao);
+		glGenFramebuffers(1, &m_fbo);
+
+		return true;
+	}
+	void MipChain::Generate(GLuint tex, GLuint format, const glm::ivec2& size, Filter filter)
+	{
+		if (!IsSupported(format) || (size.x <= 1 && size.y <= 1))
+			return;
+
+		if (filter == Filter::Average) {
+			glBindTexture(GL_TEXTURE_2D, tex);
+			glGenerateMipmap(GL_TEXTURE_2D);
+			glBindTexture(GL_TEXTURE_2D, 0);
+			return;
+		}
+
+		if (m_program == 0 && !m_init())
+			return;
+
+		// passes without a render state item inherit the state of the previous pass - it has to stay the way it was
+		GLboolean blend = glIsEnabled(GL_BLEND), cull = glIsEnabled(GL_CULL_FACE), depth = glIsEnabled(GL_DEPTH_TEST), stencil = glIsEnabled(GL_STENCIL_TEST), scissor = glIsEnabled(GL_SCISSOR_TEST);
+		GLint polygonMode[2];
+		GLboolean colorMask[4];
+		glGetIntegerv(GL_POLYGON_MODE, polygonMode);
+		glGetBooleanv(GL_COLOR_WRITEMASK, colorMask);
+
+		glDisable(GL_BLEND);
+		glDisable(GL_CULL_FACE);
+		glDisable(GL_DEPTH_TEST);
+		glDisable(GL_STENCIL_TEST);
+		glDisable(GL_SCISSOR_TEST);
+		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+		glUseProgram(m_program);
+		glUniform1i(m_filterLoc, filter == Filter::Minimum ? 1 : 2);
+		glBindVertexArray(m_vao);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, tex);
+		glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+		glDrawBuffer(GL_COLOR_ATTACHMENT0);
+
+		// the level that is read isn't attached - no feedback loop
+		glm::ivec2 srcSize = size;
+		for (int level = 1; srcSize.x > 1 || srcSize.y > 1; level++) {
+			glm::ivec2 dstSize = glm::max(srcSize / 2, glm::ivec2(1));
+
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level - 1);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, level - 1);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex, level);
+
+			glViewport(0, 0, dstSize.x, dstSize.y);
+			glUniform2i(m_sizeLoc, srcSize.x, srcSize.y);
+			glDrawArrays(GL_TRIANGLES, 0, 3);
+
+			srcSize = dstSize;
+		}
+
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 1000);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		glBindVertexArray(0);
+		glUseProgram(0);
+
+		if (blend) glEnable(GL_BLEND);
+		if (cull) glEnable(GL_CULL_FACE);
+		if (depth) glEnable(GL_DEPTH_TEST);
+		if (stencil) glEnable(GL_STENCIL_TEST);
+		if (scissor) glEnable(GL_SCISSOR_TEST);
+		glPolygonMode(GL_FRONT_AND_BACK, polygonMode[0]);
+		glColorMask(colorMask[0], colorMask[1], colorMask[2], colorMask[3]);
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/glew.h>
+#if defined(__APPLE__)
+	#include <OpenGL/gl.h>
+#else
+	#include <GL/gl.h>
+#endif
+
+namespace ed
+{
+	// mip levels of the render textures with RenderTextureObject::Mipmaps, built after every pass that draws to them -
+	// the average goes through glGenerateMipmap(), min & max (Hi-Z, depth pyramids) are reduced level by level with
+	// a full screen triangle that covers the extra texel of the odd sizes so that nothing is left out
+	class MipChain
+	{
+	public:
+		enum class Filter
+		{
+			Average,
+			Minimum,
+			Maximum
+		};
+
+		MipChain();
+		~MipChain();
+
+		static bool IsSupported(GLuint format); // integer formats can't be filtered
+		static void Allocate(GLuint tex, bool mipmaps); // level 0 has to be allocated already
+
+		void Generate(GLuint tex, GLuint format, const glm::ivec2& size, Filter filter);
+
+	private:
+		bool m_init();
+
+		GLuint m_program, m_vao, m_fbo;
+		GLint m_filterLoc, m_sizeLoc;
+	};
+}
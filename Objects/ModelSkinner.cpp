@@ -0,0 +1,137 @@
+#include "ModelSkinner.h"
+#include "Logger.h"
+#include "../Engine/GLUtils.h"
+
+#include <algorithm>
+
+const char* MODEL_SKINNER_CS = R"(
+layout(local_size_x = MODEL_SKINNER_GROUP_SIZE) in;
+
+struct Influence
+{
+	uvec4 bones;
+	vec4 weights;
+};
+
+layout(std430, binding = 0) readonly buffer BindPose { float src[]; };
+layout(std430, binding = 1) writeonly buffer Posed { float dst[]; };
+layout(std430, binding = 2) readonly buffer Skin { Influence skin[]; };
+layout(std430, binding = 3) readonly buffer Bones { mat4 bones[]; };
+
+uniform uint vertexCount;
+
+vec3 readVec3(uint i) { return vec3(src[i], src[i + 1u], src[i + 2u]); }
+void writeVec3(uint i, vec3 v)
+{
+	dst[i] = v.x;
+	dst[i + 1u] = v.y;
+	dst[i + 2u] = v.z;
+}
+
+void main()
+{
+	uint i = gl_GlobalInvocationID.x + gl_GlobalInvocationID.y * gl_NumWorkGroups.x * gl_WorkGroupSize.x;
+	if (i >= vertexCount)
+		return;
+
+	Influence infl = skin[i];
+	float total = dot(infl.weights, vec4(1.0));
+	mat4 m = mat4(1.0);
+	if (total > 0.0)
+		m = bones[infl.bones.x] * infl.weights.x + bones[infl.bones.y] * infl.weights.y +
+			bones[infl.bones.z] * infl.weights.z + bones[infl.bones.w] * infl.weights.w;
+	mat3 n = mat3(m);
+
+	// position, normal, uv, tangent, binormal, color
+	uint o = i * 18u;
+	writeVec3(o, (m * vec4(readVec3(o), 1.0)).xyz);
+	writeVec3(o + 3u, normalize(n * readVec3(o + 3u)));
+	dst[o + 6u] = src[o + 6u];
+	dst[o + 7u] = src[o + 7u];
+	writeVec3(o + 8u, n * readVec3(o + 8u));
+	writeVec3(o + 11u, n * readVec3(o + 11u));
+	for (uint k = 14u; k < 18u; k++)
+		dst[o + k] = src[o + k];
+}
+)";
+
+namespace ed
+{
+	ModelSkinner::ModelSkinner()
+	{
+		m_program = 0;
+		m_failed = false;
+	}
+	bool ModelSkinner::IsSupported()
+	{
+		return GLEW_ARB_compute_shader && GLEW_ARB_shader_storage_buffer_object;
+	}
+	bool ModelSkinner::Skin(eng::Model* model, int anim, float seconds)
+	{
+		if (!model->IsSkinned() || model->BoneBuffer == 0)
+			return true;
+		if (model->PosedAnimation == anim && (anim == -1 || model->PosedTime == seconds))
+			return true;
+
+		if (!IsSupported()) {
+			if (!m_failed)
+				Logger::Get().Log("Skinned models can't be animated without compute shaders", true);
+			m_failed = true;
+			return false;
+		}
+
+		if (m_program == 0 && !m_failed) {
+			std::string cs = "#version 430\n#define MODEL_SKINNER_GROUP_SIZE " + std::to_string(MODEL_SKINNER_GROUP_SIZE) + "\n" + MODEL_SKINNER_CS;
+			GLuint shader = gl::CompileShader(GL_COMPUTE_SHADER, cs.c_str());
+
+			GLchar msg[1024];
+			if (!gl::CheckShaderCompilationStatus(shader, msg)) {
+				Logger::Get().Log("Failed to compile the model skinner: " + std::string(msg), true);
+				m_failed = true;
+			} else {
+				m_program = glCreateProgram();
+				gl::SetObjectLabel(GL_PROGRAM, m_program, "Model skinner");
+				glAttachShader(m_program, shader);
+				glLinkProgram(m_program);
+			}
+			glDeleteShader(shader);
+		}
+		if (m_program == 0)
+			return false;
+
+		model->Animate(anim, seconds, m_bones);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, model->BoneBuffer);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, m_bones.size() * sizeof(glm::mat4), m_bones.data());
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+		glUseProgram(m_program);
+		GLint countLoc = glGetUniformLocation(m_program, "vertexCount");
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, model->BoneBuffer);
+
+		for (const auto& mesh : model->Meshes) {
+			if (mesh.BindVBO == 0 || mesh.Vertices.empty())
+				continue;
+
+			// the group count per dimension is limited to 65535
+			GLuint groups = (mesh.Vertices.size() + MODEL_SKINNER_GROUP_SIZE - 1) / MODEL_SKINNER_GROUP_SIZE;
+			GLuint groupsX = std::min<GLuint>(groups, 65535);
+			GLuint groupsY = (groups + groupsX - 1) / groupsX;
+
+			glUniform1ui(countLoc, mesh.Vertices.size());
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, mesh.BindVBO);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, mesh.VBO);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, mesh.SkinBuffer);
+			glDispatchCompute(groupsX, groupsY, 1);
+		}
+
+		glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+		for (int i = 0; i < 4; i++)
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, i, 0);
+		glUseProgram(0);
+
+		model->PosedAnimation = anim;
+		model->PosedTime = seconds;
+
+		return true;
+	}
+}
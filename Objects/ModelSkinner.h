@@ -0,0 +1,34 @@
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "../Engine/Model.h"
+
+#define MODEL_SKINNER_GROUP_SIZE 256 // invocations per work group, one per vertex
+
+namespace ed
+{
+	// poses the skinned meshes of an eng::Model with a compute kernel - the bone matrices are evaluated on the CPU,
+	// the posed vertices are written into the meshes' VBOs so every item & VAO that draws the model sees them
+	class ModelSkinner
+	{
+	public:
+		static inline ModelSkinner& Instance()
+		{
+			static ModelSkinner ret;
+			return ret;
+		}
+
+		ModelSkinner(); // the program lives until the GL context is destroyed
+
+		static bool IsSupported();
+
+		// anim = -1 -> bind pose, does nothing if the model already has this pose
+		bool Skin(eng::Model* model, int anim, float seconds);
+
+	private:
+		GLuint m_program;
+		bool m_failed;
+		std::vector<glm::mat4> m_bones;
+	};
+}
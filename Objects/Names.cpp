@@ -49,7 +49,16 @@ const char* SYSTEM_VARIABLE_NAMES[] = {
 	"KeysWASD",
 	"Mouse",
 	"MouseButton",
-	"PluginVariable"
+	"PluginVariable",
+	"IterationIndex",
+	"SampleIndex",
+	"AudioPosition",
+	"ViewLeft",
+	"ViewRight",
+	"ProjectionLeft",
+	"ProjectionRight",
+	"ViewProjectionLeft",
+	"ViewProjectionRight"
 };
 const char* VARIABLE_TYPE_NAMES[] = {
 	"bool",
@@ -117,7 +126,9 @@ const char* GEOMETRY_NAMES[] = {
 	"Triangle",
 	"Sphere",
 	"Plane",
-	"ScreenQuadNDC"
+	"ScreenQuadNDC",
+	"Generated",
+	"Captured"
 };
 
 const char* PIPELINE_ITEM_NAMES[] =
@@ -188,6 +199,19 @@ const char* CULL_MODE_NAMES[] = {
 	"Front",
 	"Back"
 };
+const char* BARRIER_NAMES[] = {
+	"VertexAttribArray",
+	"ElementArray",
+	"Uniform",
+	"TextureFetch",
+	"ShaderImageAccess",
+	"Command",
+	"PixelBuffer",
+	"TextureUpdate",
+	"BufferUpdate",
+	"Framebuffer",
+	"ShaderStorage"
+};
 const char* FORMAT_NAMES[] = {
 	"UNKNOWN",
 	"RGBA",
@@ -264,6 +288,28 @@ const char* ATTRIBUTE_VALUE_NAMES[] = {
 	"Bitangent",
 	"Color"
 };
+const char* FILTER_NAMES[] = {
+	"Nearest",
+	"Linear",
+	"NearestMipmapNearest",
+	"LinearMipmapNearest",
+	"NearestMipmapLinear",
+	"LinearMipmapLinear"
+};
+const char* WRAP_NAMES[] = {
+	"Repeat",
+	"MirroredRepeat",
+	"ClampToEdge"
+};
+const char* SHADING_RATE_NAMES[] = {
+	"1x1",
+	"1x2",
+	"2x1",
+	"2x2",
+	"2x4",
+	"4x2",
+	"4x4"
+};
 const char* EDITOR_SHORTCUT_NAMES[] =
 {
 	"Undo",
@@ -448,6 +494,19 @@ const unsigned int CULL_MODE_VALUES[] = {
 	GL_FRONT,
 	GL_BACK
 };
+const unsigned int BARRIER_VALUES[] = {
+	GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT,
+	GL_ELEMENT_ARRAY_BARRIER_BIT,
+	GL_UNIFORM_BARRIER_BIT,
+	GL_TEXTURE_FETCH_BARRIER_BIT,
+	GL_SHADER_IMAGE_ACCESS_BARRIER_BIT,
+	GL_COMMAND_BARRIER_BIT,
+	GL_PIXEL_BUFFER_BARRIER_BIT,
+	GL_TEXTURE_UPDATE_BARRIER_BIT,
+	GL_BUFFER_UPDATE_BARRIER_BIT,
+	GL_FRAMEBUFFER_BARRIER_BIT,
+	GL_SHADER_STORAGE_BARRIER_BIT
+};
 const unsigned int TOPOLOGY_ITEM_VALUES[] =
 {
 	-1, // "Undefined"
@@ -461,6 +520,19 @@ const unsigned int TOPOLOGY_ITEM_VALUES[] =
 	GL_TRIANGLES_ADJACENCY,
 	GL_TRIANGLE_STRIP_ADJACENCY
 };
+const unsigned int FILTER_VALUES[] = {
+	GL_NEAREST,
+	GL_LINEAR,
+	GL_NEAREST_MIPMAP_NEAREST,
+	GL_LINEAR_MIPMAP_NEAREST,
+	GL_NEAREST_MIPMAP_LINEAR,
+	GL_LINEAR_MIPMAP_LINEAR
+};
+const unsigned int WRAP_VALUES[] = {
+	GL_REPEAT,
+	GL_MIRRORED_REPEAT,
+	GL_CLAMP_TO_EDGE
+};
 
 namespace ed
 {
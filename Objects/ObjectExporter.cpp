@@ -0,0 +1,221 @@
+#include "ObjectExporter.h"
+#include "Logger.h"
+#include "HDRImageWriter.h"
+#include "TraceRecorder.h"
+
+#include <stb/stb_image_write.h>
+#include <algorithm>
+#include <fstream>
+#include <string.h>
+
+namespace ed
+{
+	// stb writes the rows top down, glGetTexImage returns them bottom up
+	static std::vector<unsigned char> flipRows(const unsigned char* data, int width, int height, int pixelSize)
+	{
+		size_t rowSize = (size_t)width * pixelSize;
+		std::vector<unsigned char> ret(rowSize * height);
+		for (int y = 0; y < height; y++)
+			memcpy(ret.data() + y * rowSize, data + (height - 1 - y) * rowSize, rowSize);
+		return ret;
+	}
+	static std::string getSlicePath(const std::string& path, int slice)
+	{
+		size_t dot = path.find_last_of('.');
+		size_t slash = path.find_last_of("/\\");
+		if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+			return path + "_" + std::to_string(slice);
+		return path.substr(0, dot) + "_" + std::to_string(slice) + path.substr(dot);
+	}
+
+	ObjectExporter::ObjectExporter()
+		: m_pool(eng::JobPriority::Export, OBJECT_EXPORTER_THREADS)
+	{
+	}
+	void ObjectExporter::SaveTexture(const std::string& name, GLuint tex, GLenum target, const glm::ivec3& size, const std::string& path)
+	{
+		Format type = m_getFormat(path);
+		if (type == Format::Raw)
+			type = Format::PNG;
+
+		bool isFloat = type == Format::HDR || type == Format::EXR;
+		std::shared_ptr<Job> job = std::make_shared<Job>();
+		job->Name = name;
+		job->Path = path;
+		job->Type = type;
+		job->Size = glm::max(size, glm::ivec3(1));
+		job->SliceSize = (size_t)job->Size.x * job->Size.y * (isFloat ? 16 : 4);
+		job->Mapped = nullptr;
+		job->SlicesDone = 0;
+		job->Done = false;
+		job->Failed = false;
+
+		// the copy is queued here, nothing waits for it
+		glGenBuffers(1, &job->PBO);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, job->PBO);
+		glBufferData(GL_PIXEL_PACK_BUFFER, job->SliceSize * job->Size.z, nullptr, GL_STREAM_READ);
+		glBindTexture(target, tex);
+		glGetTexImage(target, 0, GL_RGBA, isFloat ? GL_FLOAT : GL_UNSIGNED_BYTE, nullptr);
+		glBindTexture(target, 0);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		job->Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		m_jobs.push_back(job);
+
+		Logger::Get().Log("Saving " + name + " to " + path);
+	}
+	void ObjectExporter::SaveBuffer(const std::string& name, GLuint buffer, int size, const std::string& path)
+	{
+		std::shared_ptr<Job> job = std::make_shared<Job>();
+		job->Name = name;
+		job->Path = path;
+		job->Type = Format::Raw;
+		job->Size = glm::ivec3(1);
+		job->SliceSize = std::max(size, 0);
+		job->Mapped = nullptr;
+		job->SlicesDone = 0;
+		job->Done = false;
+		job->Failed = false;
+
+		// GPU to GPU copy so that the buffer can be written again while we wait
+		glGenBuffers(1, &job->PBO);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, job->PBO);
+		glBufferData(GL_COPY_WRITE_BUFFER, std::max<size_t>(job->SliceSize, 1), nullptr, GL_STREAM_READ);
+		if (job->SliceSize > 0) {
+			glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, job->SliceSize);
+			glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		}
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+		job->Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		m_jobs.push_back(job);
+
+		Logger::Get().Log("Saving " + name + " to " + path);
+	}
+	void ObjectExporter::Update()
+	{
+		for (int i = 0; i < m_jobs.size(); i++) {
+			std::shared_ptr<Job> job = m_jobs[i];
+
+			if (job->Fence != nullptr) {
+				if (glClientWaitSync(job->Fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+					continue;
+				glDeleteSync(job->Fence);
+				job->Fence = nullptr;
+
+				// the worker reads straight from the mapping, it's unmapped once the file is written
+				glBindBuffer(GL_COPY_READ_BUFFER, job->PBO);
+				job->Mapped = (const unsigned char*)glMapBufferRange(GL_COPY_READ_BUFFER, 0, std::max<size_t>(job->SliceSize * job->Size.z, 1), GL_MAP_READ_BIT);
+				glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+				if (job->Mapped == nullptr) {
+					job->Failed = true;
+					job->Done = true;
+				} else
+					m_pool.Add([job]() { m_encode(job.get()); });
+			}
+
+			if (job->Done) {
+				m_finish(job.get());
+				m_jobs.erase(m_jobs.begin() + i);
+				i--;
+			}
+		}
+	}
+	void ObjectExporter::Finish()
+	{
+		for (auto& job : m_jobs) {
+			if (job->Fence != nullptr)
+				glClientWaitSync(job->Fence, GL_SYNC_FLUSH_COMMANDS_BIT, 10000000000ull);
+		}
+
+		while (!m_jobs.empty()) {
+			Update();
+			if (!m_jobs.empty())
+				std::this_thread::yield();
+		}
+	}
+	std::vector<ObjectExporter::Status> ObjectExporter::GetStatus()
+	{
+		std::vector<Status> ret;
+		for (const auto& job : m_jobs) {
+			Status status;
+			status.Name = job->Name;
+			status.Reading = job->Fence != nullptr;
+			status.Progress = status.Reading ? 0.0f : (job->SlicesDone / (float)job->Size.z);
+			ret.push_back(status);
+		}
+		return ret;
+	}
+	ObjectExporter::Format ObjectExporter::m_getFormat(const std::string& path)
+	{
+		std::string ext = path.substr(path.find_last_of('.') + 1);
+		std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+
+		if (ext == "png") return Format::PNG;
+		if (ext == "jpg" || ext == "jpeg") return Format::JPG;
+		if (ext == "bmp") return Format::BMP;
+		if (ext == "tga") return Format::TGA;
+		if (ext == "hdr") return Format::HDR;
+		if (ext == "exr") return Format::EXR;
+		return Format::Raw;
+	}
+	void ObjectExporter::m_encode(Job* job)
+	{
+		TraceRecorder::Scope zone("Save object", "save");
+
+		if (job->Type == Format::Raw) {
+			std::ofstream file(job->Path, std::ios::binary);
+			file.write((const char*)job->Mapped, job->SliceSize);
+			job->Failed = !file.good();
+			job->SlicesDone = 1;
+			job->Done = true;
+			return;
+		}
+
+		int w = job->Size.x, h = job->Size.y;
+		for (int z = 0; z < job->Size.z && !job->Failed; z++) {
+			const unsigned char* data = job->Mapped + job->SliceSize * z;
+			std::string path = job->Size.z > 1 ? getSlicePath(job->Path, z) : job->Path;
+
+			bool ok = false;
+			if (job->Type == Format::EXR) {
+				std::vector<HDRImageWriter::Layer> layers = { { "", data } };
+				ok = HDRImageWriter::WriteEXR(path, w, h, layers, HDRImageWriter::PixelType::Float, HDRImageWriter::Compression::ZIP, 1);
+			} else if (job->Type == Format::HDR) {
+				std::vector<unsigned char> rows = flipRows(data, w, h, 16);
+				ok = stbi_write_hdr(path.c_str(), w, h, 4, (const float*)rows.data()) != 0;
+			} else {
+				std::vector<unsigned char> rows = flipRows(data, w, h, 4);
+				if (job->Type == Format::JPG)
+					ok = stbi_write_jpg(path.c_str(), w, h, 4, rows.data(), 100) != 0;
+				else if (job->Type == Format::BMP)
+					ok = stbi_write_bmp(path.c_str(), w, h, 4, rows.data()) != 0;
+				else if (job->Type == Format::TGA)
+					ok = stbi_write_tga(path.c_str(), w, h, 4, rows.data()) != 0;
+				else
+					ok = stbi_write_png(path.c_str(), w, h, 4, rows.data(), w * 4) != 0;
+			}
+
+			job->Failed = !ok;
+			job->SlicesDone++;
+		}
+
+		job->Done = true;
+	}
+	void ObjectExporter::m_finish(Job* job)
+	{
+		if (job->Mapped != nullptr) {
+			glBindBuffer(GL_COPY_READ_BUFFER, job->PBO);
+			glUnmapBuffer(GL_COPY_READ_BUFFER);
+			glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		}
+		glDeleteBuffers(1, &job->PBO);
+
+		if (job->Failed)
+			Logger::Get().Log("Failed to save " + job->Name + " to " + job->Path, true);
+		else
+			Logger::Get().Log("Saved " + job->Name + " to " + job->Path);
+	}
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <glm/glm.hpp>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/glew.h>
+#if defined(__APPLE__)
+	#include <OpenGL/gl.h>
+#else
+	#include <GL/gl.h>
+#endif
+
+#include "../Engine/ThreadPool.h"
+
+#define OBJECT_EXPORTER_THREADS 2 // files that are encoded at the same time
+
+namespace ed
+{
+	// saves render textures, images, 3D images & buffers to files without stalling the UI - the data is copied to a
+	// pixel pack / staging buffer, picked up once its fence is signaled and encoded straight from the mapping on a worker
+	// the image format is chosen by the extension: png, jpg, bmp, tga (8 bit), hdr & exr (float), 3D images are saved
+	// as one file per Z slice (name_0.png, name_1.png, ...), buffers are written as they are
+	class ObjectExporter
+	{
+	public:
+		static inline ObjectExporter& Instance()
+		{
+			static ObjectExporter ret;
+			return ret;
+		}
+
+		struct Status
+		{
+			std::string Name;
+			float Progress; // 0..1
+			bool Reading;	// still waiting for the GPU
+		};
+
+		ObjectExporter();
+
+		void SaveTexture(const std::string& name, GLuint tex, GLenum target, const glm::ivec3& size, const std::string& path); // GL_TEXTURE_2D or GL_TEXTURE_3D
+		void SaveBuffer(const std::string& name, GLuint buffer, int size, const std::string& path);
+
+		void Update(); // main thread, once per frame
+		void Finish(); // waits for every file, called before the GL context is destroyed
+
+		inline bool IsBusy() { return !m_jobs.empty(); }
+		std::vector<Status> GetStatus();
+
+	private:
+		enum class Format
+		{
+			PNG,
+			JPG,
+			BMP,
+			TGA,
+			HDR,
+			EXR,
+			Raw
+		};
+		struct Job
+		{
+			std::string Name, Path;
+			Format Type;
+			glm::ivec3 Size;
+			size_t SliceSize; // bytes per Z slice, the whole buffer for Raw
+
+			GLuint PBO;
+			GLsync Fence;
+			const unsigned char* Mapped;
+
+			std::atomic<int> SlicesDone;
+			std::atomic<bool> Done;
+			bool Failed; // written by the worker before Done
+		};
+
+		static Format m_getFormat(const std::string& path);
+		static void m_encode(Job* job);
+		void m_finish(Job* job);
+
+		eng::ThreadPool m_pool;
+		std::vector<std::shared_ptr<Job>> m_jobs;
+	};
+}
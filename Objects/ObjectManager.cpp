@@ -1,11 +1,18 @@
 #include "ObjectManager.h"
 #include "RenderEngine.h"
 #include "Settings.h"
+#include "SystemVariableManager.h"
 #include "Logger.h"
+#include "ProfilerZones.h"
+#include "FrameProfiler.h"
+#include "TraceRecorder.h"
+#include "ResidentAssets.h"
 #include "../Engine/GLUtils.h"
 
-#include <SFML/Audio/Sound.hpp>
-#include <SFML/Audio/SoundBuffer.hpp>
+#include <unordered_set>
+#include <algorithm>
+#include <cmath>
+#include <string.h>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb/stb_image.h>
@@ -16,64 +23,141 @@ namespace ed
 		m_parser(parser), m_renderer(rnd)
 	{
 		m_binds.clear();
+
+		m_readbackFBO = 0;
+
+		m_audioFrame = 0;
+		m_audioArray = 0;
+		m_audioArrayLayers = 0;
+		m_audioPBO = 0;
+		m_audioPBOData = nullptr;
+		m_audioPBOCapacity = 0;
+		m_audioPBOSegment = 0;
+		for (int i = 0; i < AUDIO_UPLOAD_SEGMENTS; i++)
+			m_audioFences[i] = 0;
+
+		m_bindlessTable = 0;
+
+		m_virtualBlock = 0;
+		m_virtualReadback = 0;
+		m_virtualFence = nullptr;
+		m_virtualFrame = 0;
+		m_virtualLayoutValid = false;
+
+		m_idIndexValid = false;
+		m_generation = 0;
 	}
 	ObjectManager::~ObjectManager()
 	{
 		Clear();
+
+		m_releaseAudioPBO();
+		if (m_audioArray != 0)
+			glDeleteTextures(1, &m_audioArray);
+		if (m_bindlessTable != 0)
+			glDeleteBuffers(1, &m_bindlessTable);
+		m_releaseVirtualBlock();
+		if (m_readbackFBO != 0)
+			glDeleteFramebuffers(1, &m_readbackFBO);
 	}
 
-	void loadCubemapFace(GLuint face, const std::string& path, int& w, int& h)
+	// converts the decoded image to RGBA and writes it (and the vertically flipped copy) to dest
+	static void decodeTexture(const std::string& path, const glm::ivec2& size, int channels, unsigned char* dest, bool& failed)
 	{
-		int nrChannels = 0;
-		unsigned char* data = stbi_load(path.c_str(), &w, &h, &nrChannels, 0);
-		unsigned char* paddedData = nullptr;
-
-		if (nrChannels != 4) {
-			paddedData = (unsigned char*)malloc(w * h * 4);
-			for (int x = 0; x < w; x++) {
-				for (int y = 0; y < h; y++) {
-					if (nrChannels == 3) {
-						paddedData[(y * w + x) * 4 + 0] = data[(y * w + x) * 3 + 0];
-						paddedData[(y * w + x) * 4 + 1] = data[(y * w + x) * 3 + 1];
-						paddedData[(y * w + x) * 4 + 2] = data[(y * w + x) * 3 + 2];
-					} else if (nrChannels == 1) {
-						unsigned char val = data[(y * w + x) * 1 + 0];
-						paddedData[(y * w + x) * 4 + 0] = val;
-						paddedData[(y * w + x) * 4 + 1] = val;
-						paddedData[(y * w + x) * 4 + 2] = val;
-					}
-					paddedData[(y * w + x) * 4 + 3] = 255;
-				}
-			}
+		int w = 0, h = 0, nrChannels = 0;
+		unsigned char* data = stbi_load(path.c_str(), &w, &h, &nrChannels, channels);
+		if (data == nullptr || w != size.x || h != size.y) {
+			failed = true;
+			if (data != nullptr)
+				stbi_image_free(data);
+			return;
 		}
 
-		glTexImage2D(
-			face,
-			0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, paddedData == nullptr ? data : paddedData
-		);
+		memcpy(dest, data, (size_t)w * h * channels);
 
-		if (paddedData != nullptr)
-			free(paddedData);
 		stbi_image_free(data);
+		failed = false;
+	}
+	static void createPlaceholderTexture(GLenum face)
+	{
+		const unsigned char placeholder[4] = { 128, 128, 128, 255 };
+		glTexImage2D(face, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholder);
+	}
+	// objects that get a handle in the bindless table - render textures & images are reallocated when they are resized
+	static bool isBindless(ObjectManagerItem* item)
+	{
+		return item->Texture != 0 && (item->IsTexture || item->IsCube || item->IsTextureArray);
+	}
+
+	// storage of a render texture (or of its history) for the rt's current target, format & size
+	static void allocateRenderTexture(GLuint tex, RenderTextureObject* rtObj, glm::ivec2 size)
+	{
+		GLenum target = rtObj->GetTarget();
+		glBindTexture(target, tex);
+		if (target == GL_TEXTURE_CUBE_MAP) {
+			int side = std::max(size.x, size.y); // same as CalculateSize()
+			for (int i = 0; i < 6; i++)
+				glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, rtObj->Format, side, side, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		} else if (target == GL_TEXTURE_2D_ARRAY)
+			glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, rtObj->Format, size.x, size.y, rtObj->Layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		else
+			glTexImage2D(GL_TEXTURE_2D, 0, rtObj->Format, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		glBindTexture(target, 0);
+
+		// the other levels still have the old size & format
+		if (!rtObj->IsLayered())
+			MipChain::Allocate(tex, rtObj->Mipmaps && MipChain::IsSupported(rtObj->Format));
+	}
+
+	static void applyMipmaps(GLuint tex, bool mipmaps, GLenum target = GL_TEXTURE_2D)
+	{
+		glBindTexture(target, tex);
+		if (mipmaps)
+			glGenerateMipmap(target);
+		glTexParameteri(target, GL_TEXTURE_MIN_FILTER, mipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+		glBindTexture(target, 0);
 	}
 
-	void ObjectManager::Clear()
+	void ObjectManager::Clear(bool keepResident)
 	{
 		Logger::Get().Log("Clearing ObjectManager contents...");
+
+		// the workers write to the mapped buffers - let them finish
+		std::unordered_set<ObjectManagerItem*> loading;
+		m_sliceLoads.clear();
+		for (auto& job : m_loadJobs) {
+			loading.insert(job->Item);
+			job->Item = nullptr;
+		}
+		m_pollTextureLoads(true);
+
+		m_releaseMappings(nullptr, true);
 		
 		for (int i = 0; i < m_itemData.size(); i++) {
-			if (m_itemData[i]->Plugin != nullptr) {
-				PluginObject* pobj = m_itemData[i]->Plugin;
+			ObjectManagerItem* item = m_itemData[i];
+			if (item->Plugin != nullptr) {
+				PluginObject* pobj = item->Plugin;
 				pobj->Owner->RemoveObject(m_items[i].c_str(), pobj->Type, pobj->Data, pobj->ID);
 			}
+
+			// textures with a bindless handle can't get their parameters reset
+			if (keepResident && item->IsTexture && item->Texture != 0 && item->BindlessHandle == 0 && loading.count(item) == 0) {
+				ResidentAssets::Instance().KeepTexture(m_parser->GetProjectPath(m_items[i]), item->Texture, item->ImageSize);
+				item->Texture = 0;
+			}
 			
-			delete m_itemData[i];
+			delete item;
 		}
 		
 		m_binds.clear();
 		m_uniformBinds.clear();
+		m_samplers.clear();
+		m_invalidateBindTables();
 		m_items.clear();
 		m_itemData.clear();
+		m_itemIndex.clear();
+		m_idIndexValid = false;
+		m_virtualLayoutValid = false;
 	}
 	bool ObjectManager::CreateRenderTexture(const std::string & name)
 	{
@@ -87,8 +171,7 @@ namespace ed
 		m_parser->ModifyProject();
 
 		ObjectManagerItem* item = new ObjectManagerItem();
-		m_itemData.push_back(item);
-		m_items.push_back(name);
+		m_addItem(name, item);
 
 		ed::RenderTextureObject* rtObj = item->RT = new ed::RenderTextureObject();
 		glm::ivec2 size = m_renderer->GetLastRenderSize();
@@ -103,29 +186,13 @@ namespace ed
 		// color texture
 		glGenTextures(1, &item->Texture);
 		glBindTexture(GL_TEXTURE_2D, item->Texture);
+		gl::SetObjectLabel(GL_TEXTURE, item->Texture, name);
 		glTexImage2D(GL_TEXTURE_2D, 0, rtObj->Format, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 		glBindTexture(GL_TEXTURE_2D, 0);
 
-		// depth texture
-		glGenTextures(1, &rtObj->DepthStencilBuffer);
-		glBindTexture(GL_TEXTURE_2D, rtObj->DepthStencilBuffer);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, size.x, size.y, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-		glBindTexture(GL_TEXTURE_2D, 0);
-
-		// color texture ms
-		glGenTextures(1, &rtObj->BufferMS);
-		glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, rtObj->BufferMS);
-		glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, Settings::Instance().Preview.MSAA, rtObj->Format, size.x, size.y, true);
-
-		// depth texture ms
-		glGenTextures(1, &rtObj->DepthStencilBufferMS);
-		glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, rtObj->DepthStencilBufferMS);
-		glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, Settings::Instance().Preview.MSAA, GL_DEPTH24_STENCIL8, size.x, size.y, true);
-		glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
+		// depth and multisampled attachments are assigned by the render engine once a pass uses this rt
 
 		return true;
 	}
@@ -139,94 +206,66 @@ namespace ed
 		}
 
 		std::string path = m_parser->GetProjectPath(file);
-		int width, height, nrChannels;
-		unsigned char* data = stbi_load(path.c_str(), &width, &height, &nrChannels, 0);
-		unsigned char* paddedData = nullptr;
+		bool compressed = eng::CompressedTexture::IsSupportedFile(path);
 
-		if (data == nullptr)
-			return false;
+		// unchanged since the previous project loaded it
+		glm::ivec2 residentSize;
+		GLuint resident = ResidentAssets::Instance().TakeTexture(path, residentSize);
+		if (resident != 0) {
+			m_parser->ModifyProject();
 
-		m_parser->ModifyProject();
+			ObjectManagerItem* item = new ObjectManagerItem();
+			m_addItem(file, item);
 
-		ObjectManagerItem* item = new ObjectManagerItem();
-		m_itemData.push_back(item);
-		m_items.push_back(file);
+			item->IsTexture = true;
+			item->ImageSize = residentSize;
+			item->Texture = resident;
 
-		item->IsTexture = true;
+			// the previous project might have turned the mipmaps on, the stored levels of DDS/KTX files are kept
+			GLint maxLevel = 0;
+			glBindTexture(GL_TEXTURE_2D, item->Texture);
+			glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, &maxLevel);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, compressed && maxLevel > 0 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			glBindTexture(GL_TEXTURE_2D, 0);
 
-		if (data == nullptr)
-			Logger::Get().Log("Failed to load a texture " + file + " from file", true);
+			return true;
+		}
 
-		GLenum fmt = GL_RGB;
-		if (nrChannels == 4)
-			fmt = GL_RGBA;
-		else if (nrChannels == 1)
-			fmt = GL_LUMINANCE;
-
-		if (nrChannels != 4) {
-			paddedData = (unsigned char*)malloc(width * height * 4);
-			for (int x = 0; x < width; x++) {
-				for (int y = 0; y < height; y++) {
-					if (nrChannels == 3) {
-						paddedData[(y * width + x) * 4 + 0] = data[(y * width + x) * 3 + 0];
-						paddedData[(y * width + x) * 4 + 1] = data[(y * width + x) * 3 + 1];
-						paddedData[(y * width + x) * 4 + 2] = data[(y * width + x) * 3 + 2];
-					} else if (nrChannels == 1) {
-						unsigned char val = data[(y * width + x) * 1 + 0];
-						paddedData[(y * width + x) * 4 + 0] = val;
-						paddedData[(y * width + x) * 4 + 1] = val;
-						paddedData[(y * width + x) * 4 + 2] = val;
-					}
-					paddedData[(y * width + x) * 4 + 3] = 255;
-				}
+		// only read the header here, the pixels are decoded on the loader threads
+		int width, height, nrChannels;
+		if (compressed) {
+			eng::CompressedTexture header;
+			if (!header.LoadFromFile(path, true) || !header.IsFormatSupported()) {
+				Logger::Get().Log("Failed to load a texture " + file + " from file: " + (header.GetError().empty() ? "format not supported by the GPU" : header.GetError()), true);
+				return false;
 			}
+			width = header.Size.x;
+			height = header.Size.y;
+		} else if (!stbi_info(path.c_str(), &width, &height, &nrChannels)) {
+			Logger::Get().Log("Failed to load a texture " + file + " from file", true);
+			return false;
 		}
 
-		// normal texture
-		glGenTextures(1, &item->Texture);
-		glBindTexture(GL_TEXTURE_2D, item->Texture);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-		glTexImage2D(GL_TEXTURE_2D,0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, paddedData == nullptr ? data : paddedData);
-		glBindTexture(GL_TEXTURE_2D, 0);
-
-
+		m_parser->ModifyProject();
 
-		// flipped texture
-		unsigned char* flippedData = (unsigned char*)malloc(width * height * 4);
+		ObjectManagerItem* item = new ObjectManagerItem();
+		m_addItem(file, item);
 
-		for (int x = 0; x < width; x++) {
-			for (int y = 0; y < height; y++) {
-				if (nrChannels == 4) { // use data
-					flippedData[(y * width + x) * 4 + 0] = data[((height - y - 1) * width + x) * 4 + 0];
-					flippedData[(y * width + x) * 4 + 1] = data[((height - y - 1) * width + x) * 4 + 1];
-					flippedData[(y * width + x) * 4 + 2] = data[((height - y - 1) * width + x) * 4 + 2];
-					flippedData[(y * width + x) * 4 + 3] = data[((height - y - 1) * width + x) * 4 + 3];
-				} else { // use paddedData
-					flippedData[(y * width + x) * 4 + 0] = paddedData[((height - y - 1) * width + x) * 4 + 0];
-					flippedData[(y * width + x) * 4 + 1] = paddedData[((height - y - 1) * width + x) * 4 + 1];
-					flippedData[(y * width + x) * 4 + 2] = paddedData[((height - y - 1) * width + x) * 4 + 2];
-					flippedData[(y * width + x) * 4 + 3] = paddedData[((height - y - 1) * width + x) * 4 + 3];
-				}
-			}
-		}
+		item->IsTexture = true;
+		item->ImageSize = glm::ivec2(width, height);
 
-		glGenTextures(1, &item->FlippedTexture);
-		glBindTexture(GL_TEXTURE_2D, item->FlippedTexture);
+		// normal texture
+		glGenTextures(1, &item->Texture);
+		glBindTexture(GL_TEXTURE_2D, item->Texture);
+		gl::SetObjectLabel(GL_TEXTURE, item->Texture, file);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, flippedData);
+		createPlaceholderTexture(GL_TEXTURE_2D);
 		glBindTexture(GL_TEXTURE_2D, 0);
 
-
-
-		item->ImageSize = glm::ivec2(width, height);
-
-		free(flippedData);
-		if (paddedData != nullptr)
-			free(paddedData);
-
-		stbi_image_free(data);
+		// the flipped copy is only made if a plugin asks for it
+		m_queueTextureLoad(item, file, GL_TEXTURE_2D);
 
 		return true;
 	}
@@ -242,14 +281,13 @@ namespace ed
 		m_parser->ModifyProject();
 
 		ObjectManagerItem* item = new ObjectManagerItem();
-		m_itemData.push_back(item);
-		m_items.push_back(name);
+		m_addItem(name, item);
 
 		item->IsCube = true;
 
 		glGenTextures(1, &item->Texture);
 		glBindTexture(GL_TEXTURE_CUBE_MAP, item->Texture);
-		int width, height;
+		gl::SetObjectLabel(GL_TEXTURE, item->Texture, name);
 
 		// properties
 		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -257,34 +295,84 @@ namespace ed
 		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-		
-		// left face
-		loadCubemapFace(GL_TEXTURE_CUBE_MAP_NEGATIVE_X, m_parser->GetProjectPath(left), width, height);
-		item->CubemapPaths.push_back(left);
 
-		// top
-		loadCubemapFace(GL_TEXTURE_CUBE_MAP_POSITIVE_Y, m_parser->GetProjectPath(top), width, height);
-		item->CubemapPaths.push_back(top);
+		// the faces are decoded in parallel
+		const std::string* faces[] = { &left, &top, &front, &bottom, &right, &back };
+		const GLenum targets[] = {
+			GL_TEXTURE_CUBE_MAP_NEGATIVE_X, GL_TEXTURE_CUBE_MAP_POSITIVE_Y, GL_TEXTURE_CUBE_MAP_NEGATIVE_Z,
+			GL_TEXTURE_CUBE_MAP_NEGATIVE_Y, GL_TEXTURE_CUBE_MAP_POSITIVE_X, GL_TEXTURE_CUBE_MAP_POSITIVE_Z
+		};
+		for (int i = 0; i < 6; i++) {
+			createPlaceholderTexture(targets[i]);
+			item->CubemapPaths.push_back(*faces[i]);
+		}
+		glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+		for (int i = 0; i < 6; i++)
+			if (m_queueTextureLoad(item, *faces[i], targets[i]))
+				item->ImageSize = m_loadJobs.back()->Size;
+
+		return true;
+	}
+	bool ObjectManager::CreateTextureArray(const std::string& name, const std::vector<std::string>& files)
+	{
+		Logger::Get().Log("Creating a texture array " + name + " ...");
 
-		// front
-		loadCubemapFace(GL_TEXTURE_CUBE_MAP_NEGATIVE_Z, m_parser->GetProjectPath(front), width, height);
-		item->CubemapPaths.push_back(front);
+		if (Exists(name)) {
+			Logger::Get().Log("Cannot create a texture array " + name + " because an object with such name already exists in the project", true);
+			return false;
+		}
+		if (files.size() == 0) {
+			Logger::Get().Log("Cannot create a texture array " + name + " without any layers", true);
+			return false;
+		}
 
-		// bottom
-		loadCubemapFace(GL_TEXTURE_CUBE_MAP_NEGATIVE_Y, m_parser->GetProjectPath(bottom), width, height);
-		item->CubemapPaths.push_back(bottom);
+		// every layer has the same size - only the headers are read here
+		glm::ivec2 size(0, 0);
+		for (const std::string& file : files) {
+			int width = 0, height = 0, nrChannels = 0;
+			if (eng::CompressedTexture::IsSupportedFile(file) || !stbi_info(m_parser->GetProjectPath(file).c_str(), &width, &height, &nrChannels)) {
+				Logger::Get().Log("Failed to load the layer " + file + " of a texture array " + name, true);
+				return false;
+			}
+			if (size.x == 0)
+				size = glm::ivec2(width, height);
+			else if (size.x != width || size.y != height) {
+				Logger::Get().Log("Cannot create a texture array " + name + " because " + file + " has a different size than the first layer", true);
+				return false;
+			}
+		}
 
-		// right
-		loadCubemapFace(GL_TEXTURE_CUBE_MAP_POSITIVE_X, m_parser->GetProjectPath(right), width, height);
-		item->CubemapPaths.push_back(right);
+		GLint maxLayers = 0;
+		glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+		if (files.size() > maxLayers) {
+			Logger::Get().Log("Cannot create a texture array " + name + " with more than " + std::to_string(maxLayers) + " layers", true);
+			return false;
+		}
 
-		// back
-		loadCubemapFace(GL_TEXTURE_CUBE_MAP_POSITIVE_Z, m_parser->GetProjectPath(back), width, height);
-		item->CubemapPaths.push_back(back);
-		
-		// clean up
-		glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
-		item->ImageSize = glm::ivec2(width, height);
+		m_parser->ModifyProject();
+
+		ObjectManagerItem* item = new ObjectManagerItem();
+		m_addItem(name, item);
+
+		item->IsTextureArray = true;
+		item->ImageSize = size;
+		item->ArrayPaths = files;
+
+		// the layers show up as they are decoded
+		std::vector<unsigned char> placeholder(size.x * size.y * 4, 128);
+		glGenTextures(1, &item->Texture);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, item->Texture);
+		gl::SetObjectLabel(GL_TEXTURE, item->Texture, name);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA, size.x, size.y, files.size(), 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		for (int i = 0; i < files.size(); i++)
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, i, size.x, size.y, 1, GL_RGBA, GL_UNSIGNED_BYTE, placeholder.data());
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+		for (int i = 0; i < files.size(); i++)
+			m_queueTextureLoad(item, files[i], GL_TEXTURE_2D_ARRAY, i);
 
 		return true;
 	}
@@ -297,37 +385,337 @@ namespace ed
 			return false;
 		}
 
-		ObjectManagerItem* item = new ObjectManagerItem();
+		// long tracks are streamed from the file
+		AudioTrack* track = new AudioTrack();
+		if (!track->Open(m_parser->GetProjectPath(file))) {
+			delete track;
+			ed::Logger::Get().Log("Failed to load an audio file " + file, true);
+			return false;
+		}
+		if (track->IsStreamed())
+			Logger::Get().Log("Streaming audio file " + file);
 
-		item->SoundBuffer = new sf::SoundBuffer();
-		bool loaded = item->SoundBuffer->loadFromFile(m_parser->GetProjectPath(file));
-		if (!loaded) {
-			delete item;
+		return m_createAudio(file, track);
+	}
+	bool ObjectManager::CreateAudio(const std::string& file, const sf::Int16* samples, size_t sampleCount, unsigned int channels, unsigned int sampleRate)
+	{
+		Logger::Get().Log("Creating audio object from file " + file + " ...");
+
+		if (Exists(file)) {
+			Logger::Get().Log("Audio object " + file + " already exists in the project", true);
+			return false;
+		}
+
+		AudioTrack* track = new AudioTrack();
+		if (!track->Load(samples, sampleCount, channels, sampleRate)) {
+			delete track;
 			ed::Logger::Get().Log("Failed to load an audio file " + file, true);
 			return false;
 		}
 
-		m_itemData.push_back(item);
+		return m_createAudio(file, track);
+	}
+	bool ObjectManager::m_createAudio(const std::string& file, AudioTrack* track)
+	{
+		ObjectManagerItem* item = new ObjectManagerItem();
+		item->Sound = track;
+
+		m_addItem(file, item);
 		m_parser->ModifyProject();
-		m_items.push_back(file);
 
 		glGenTextures(1, &item->Texture);
 		glBindTexture(GL_TEXTURE_2D, item->Texture);
+		gl::SetObjectLabel(GL_TEXTURE, item->Texture, file);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, 512, 2, 0, GL_RED, GL_UNSIGNED_BYTE, NULL);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, AudioAnalyzer::SampleCount, 2, 0, GL_RED, GL_UNSIGNED_BYTE, NULL);
 		glBindTexture(GL_TEXTURE_2D, 0);
 
-		item->Sound = new sf::Sound();
-		item->Sound->setBuffer(*(item->SoundBuffer));
-		item->Sound->setLoop(true);
-		item->Sound->play();
+		item->SoundAnalyzer = new AudioAnalyzer();
+		item->SoundData.resize(AudioAnalyzer::SampleCount * 2, 0.0f);
+
+		item->Sound->SetLoop(true);
+		item->Sound->Play();
 		item->SoundMuted = false;
 
 		return true;
 	}
+	bool ObjectManager::CreateVideo(const std::string& file)
+	{
+		Logger::Get().Log("Creating video object from file " + file + " ...");
+
+		if (Exists(file)) {
+			Logger::Get().Log("Video object " + file + " already exists in the project", true);
+			return false;
+		}
+
+		eng::VideoDecoder* decoder = new eng::VideoDecoder();
+		if (!decoder->Open(m_parser->GetProjectPath(file))) {
+			delete decoder;
+			ed::Logger::Get().Log("Failed to load a video file " + file, true);
+			return false;
+		}
+
+		return m_createVideo(file, decoder);
+	}
+	bool ObjectManager::CreateCaptureDevice(const std::string& device, int queueDepth)
+	{
+		Logger::Get().Log("Creating capture device object " + device + " ...");
+
+		if (Exists(device)) {
+			Logger::Get().Log("Capture device " + device + " already exists in the project", true);
+			return false;
+		}
+
+		eng::VideoDecoder* decoder = new eng::VideoDecoder();
+		if (!decoder->OpenDevice(device, queueDepth)) {
+			delete decoder;
+			return false;
+		}
+
+		return m_createVideo(device, decoder);
+	}
+	bool ObjectManager::m_createVideo(const std::string& name, eng::VideoDecoder* decoder)
+	{
+		ObjectManagerItem* item = new ObjectManagerItem();
+		VideoObject* video = item->Video = new VideoObject();
+		video->Decoder = decoder;
+		video->SyncToTime = !decoder->IsLive();
+		video->Paused = false;
+		video->Clock = 0.0;
+		video->FramePTS = -1.0;
+		video->NextPBO = 0;
+		for (int i = 0; i < VIDEO_UPLOAD_PBOS; i++) {
+			video->PBO[i] = 0;
+			video->Fence[i] = nullptr;
+			video->Mapped[i] = nullptr;
+		}
+
+		m_addItem(name, item);
+		m_parser->ModifyProject();
+
+		glGenTextures(1, &item->Texture);
+		glBindTexture(GL_TEXTURE_2D, item->Texture);
+		gl::SetObjectLabel(GL_TEXTURE, item->Texture, name);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		m_allocateVideoStorage(item);
+
+		return true;
+	}
+	void ObjectManager::m_allocateVideoStorage(ObjectManagerItem* item)
+	{
+		VideoObject* video = item->Video;
+		glm::ivec2 size = video->Decoder->GetSize();
+		GLsizeiptr frameSize = (GLsizeiptr)size.x * size.y * 4;
+
+		item->ImageSize = size;
+
+		glBindTexture(GL_TEXTURE_2D, item->Texture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		for (int i = 0; i < VIDEO_UPLOAD_PBOS; i++) {
+			if (video->Fence[i] != nullptr)
+				glDeleteSync(video->Fence[i]);
+			video->Fence[i] = nullptr;
+			video->Mapped[i] = nullptr;
+		}
+		if (video->PBO[0] != 0)
+			glDeleteBuffers(VIDEO_UPLOAD_PBOS, video->PBO);
+		video->NextPBO = 0;
+		video->FramePTS = -1.0;
+
+		// persistently mapped if possible - the frames are copied straight from the decoder's queue into the PBO
+		glGenBuffers(VIDEO_UPLOAD_PBOS, video->PBO);
+		for (int i = 0; i < VIDEO_UPLOAD_PBOS; i++) {
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, video->PBO[i]);
+			if (GLEW_ARB_buffer_storage) {
+				GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+				glBufferStorage(GL_PIXEL_UNPACK_BUFFER, frameSize, nullptr, flags);
+				video->Mapped[i] = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, frameSize, flags);
+			} else
+				glBufferData(GL_PIXEL_UNPACK_BUFFER, frameSize, NULL, GL_STREAM_DRAW);
+		}
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+	bool ObjectManager::CreateVirtualTexture(const std::string& file)
+	{
+		Logger::Get().Log("Creating a virtual texture " + file + " ...");
+
+		if (Exists(file)) {
+			Logger::Get().Log("Cannot create a virtual texture " + file + " because that texture is already added to the project", true);
+			return false;
+		}
+
+		if (!VirtualTexture::IsSupported()) {
+			Logger::Get().Log("Cannot create a virtual texture " + file + " because the GPU doesn't support sparse textures", true);
+			return false;
+		}
+
+		GLuint tex = 0;
+		glGenTextures(1, &tex);
+		gl::SetObjectLabel(GL_TEXTURE, tex, file);
+
+		VirtualTexture* vtex = new VirtualTexture();
+		if (!vtex->Open(m_parser->GetProjectPath(file), tex, m_loadPool)) {
+			Logger::Get().Log("Failed to create a virtual texture " + file + ": " + vtex->GetError(), true);
+			delete vtex;
+			glDeleteTextures(1, &tex);
+			return false;
+		}
+
+		m_parser->ModifyProject();
+
+		ObjectManagerItem* item = new ObjectManagerItem();
+		m_addItem(file, item);
+
+		item->Texture = tex;
+		item->ImageSize = vtex->GetSize();
+		item->Virtual = vtex;
+
+		m_virtualLayoutValid = false;
+
+		return true;
+	}
+	bool ObjectManager::CreateEnvironment(const std::string& file, int faceSize)
+	{
+		Logger::Get().Log("Creating an environment map " + file + " ...");
+
+		if (Exists(file)) {
+			Logger::Get().Log("Cannot create an environment map " + file + " because that file is already added to the project", true);
+			return false;
+		}
+
+		if (!EnvironmentMap::IsSupported()) {
+			Logger::Get().Log("Cannot create an environment map " + file + " because the GPU doesn't support compute shaders", true);
+			return false;
+		}
+
+		// the parts are left out if their names are taken
+		std::string irradianceName = file + ENVIRONMENT_IRRADIANCE_SUFFIX, brdfName = file + ENVIRONMENT_BRDF_SUFFIX;
+		bool hasIrradiance = !Exists(irradianceName), hasBRDF = !Exists(brdfName);
+		if (!hasIrradiance)
+			Logger::Get().Log("Environment map " + file + " won't have an irradiance map because an object called " + irradianceName + " already exists", true);
+		if (!hasBRDF)
+			Logger::Get().Log("Environment map " + file + " won't have a BRDF LUT because an object called " + brdfName + " already exists", true);
+
+		GLuint textures[3] = { 0, 0, 0 };
+		glGenTextures(1, &textures[0]);
+		if (hasIrradiance)
+			glGenTextures(1, &textures[1]);
+		if (hasBRDF)
+			glGenTextures(1, &textures[2]);
+
+		EnvironmentMap* env = new EnvironmentMap();
+		if (!env->Open(m_parser->GetProjectPath(file), faceSize, textures[0], textures[1], textures[2], m_loadPool)) {
+			Logger::Get().Log("Failed to create an environment map " + file + ": " + env->GetError(), true);
+			delete env;
+			glDeleteTextures(3, textures);
+			return false;
+		}
+
+		m_parser->ModifyProject();
+
+		ObjectManagerItem* item = new ObjectManagerItem();
+		m_addItem(file, item);
+
+		item->IsCube = true;
+		item->Texture = textures[0];
+		item->ImageSize = glm::ivec2(env->GetFaceSize());
+		item->Environment = env;
+		gl::SetObjectLabel(GL_TEXTURE, item->Texture, file);
+
+		if (hasIrradiance)
+			m_addEnvironmentPart(item, irradianceName, textures[1], true, glm::ivec2(ENVIRONMENT_IRRADIANCE_SIZE));
+		if (hasBRDF)
+			m_addEnvironmentPart(item, brdfName, textures[2], false, glm::ivec2(ENVIRONMENT_BRDF_SIZE));
+
+		return true;
+	}
+	void ObjectManager::m_addEnvironmentPart(ObjectManagerItem* env, const std::string& name, GLuint tex, bool isCube, glm::ivec2 size)
+	{
+		ObjectManagerItem* item = new ObjectManagerItem();
+		item->EnvironmentOf = env;
+		item->IsCube = isCube;
+		item->Texture = tex;
+		item->ImageSize = size;
+		m_addItem(name, item);
+
+		gl::SetObjectLabel(GL_TEXTURE, tex, name);
+	}
+	void ObjectManager::m_updateEnvironments()
+	{
+		bool changed = false;
+		for (ObjectManagerItem* item : m_itemData) {
+			if (item->Environment == nullptr || !item->Environment->Update(m_loadPool))
+				continue;
+
+			m_markChanged(item);
+			for (ObjectManagerItem* part : m_itemData)
+				if (part->EnvironmentOf == item)
+					m_markChanged(part);
+			changed = true;
+		}
+
+		if (changed && m_renderer != nullptr)
+			m_renderer->InvalidatePassCache();
+	}
+	bool ObjectManager::CreateImageSequence(const std::string& file)
+	{
+		Logger::Get().Log("Creating an image sequence " + file + " ...");
+
+		if (Exists(file)) {
+			Logger::Get().Log("Cannot create an image sequence " + file + " because that file is already added to the project", true);
+			return false;
+		}
+
+		if (!ImageSequence::IsSupportedFile(file)) {
+			Logger::Get().Log("Cannot create an image sequence " + file + " because it isn't a numbered png, jpg, bmp or tga file", true);
+			return false;
+		}
+
+		GLuint tex = 0;
+		glGenTextures(1, &tex);
+
+		ImageSequence* seq = new ImageSequence();
+		if (!seq->Open(m_parser->GetProjectPath(file), tex)) {
+			Logger::Get().Log("Failed to create an image sequence " + file + ": " + seq->GetError(), true);
+			delete seq;
+			glDeleteTextures(1, &tex);
+			return false;
+		}
+
+		m_parser->ModifyProject();
+
+		ObjectManagerItem* item = new ObjectManagerItem();
+		m_addItem(file, item);
+
+		item->Texture = tex;
+		item->ImageSize = seq->GetSize();
+		item->Sequence = seq;
+		gl::SetObjectLabel(GL_TEXTURE, item->Texture, file);
+
+		Logger::Get().Log("Image sequence " + file + " has " + std::to_string(seq->GetFrameCount()) + " frames, " + std::to_string(seq->GetRingSize()) + " of them are decoded ahead");
+
+		return true;
+	}
+	void ObjectManager::m_updateImageSequences()
+	{
+		SystemVariableManager& sysVars = SystemVariableManager::Instance();
+		float time = sysVars.GetTime();
+		unsigned int frameIndex = sysVars.GetFrameIndex();
+
+		for (ObjectManagerItem* item : m_itemData)
+			if (item->Sequence != nullptr && item->Sequence->Update(time, frameIndex, m_loadPool))
+				m_markChanged(item);
+	}
 	bool ObjectManager::CreateBuffer(const std::string& name)
 	{
 		Logger::Get().Log("Creating a buffer " + name + " ...");
@@ -340,8 +728,7 @@ namespace ed
 		m_parser->ModifyProject();
 
 		ObjectManagerItem* item = new ObjectManagerItem();
-		m_itemData.push_back(item);
-		m_items.push_back(name);
+		m_addItem(name, item);
 
 		ed::BufferObject* bObj = item->Buffer = new ed::BufferObject();
 		glm::ivec2 size = m_renderer->GetLastRenderSize();
@@ -352,6 +739,7 @@ namespace ed
 
 		glGenBuffers(1, &bObj->ID);
 		glBindBuffer(GL_UNIFORM_BUFFER, bObj->ID);
+		gl::SetObjectLabel(GL_BUFFER, bObj->ID, name);
 		glBufferData(GL_UNIFORM_BUFFER, 0, NULL, GL_STATIC_DRAW); // allocate 0 bytes of memory
 		glBindBuffer(GL_UNIFORM_BUFFER, 0);
 
@@ -369,13 +757,13 @@ namespace ed
 		m_parser->ModifyProject();
 
 		ObjectManagerItem* item = new ObjectManagerItem();
-		m_itemData.push_back(item);
-		m_items.push_back(name);
+		m_addItem(name, item);
 
 		ed::ImageObject* iObj = item->Image = new ImageObject();
 
 		glGenTextures(1, &iObj->Texture);
 		glBindTexture(GL_TEXTURE_2D, iObj->Texture);
+		gl::SetObjectLabel(GL_TEXTURE, iObj->Texture, name);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
@@ -398,8 +786,7 @@ namespace ed
 		m_parser->ModifyProject();
 
 		ObjectManagerItem* item = new ObjectManagerItem();
-		m_itemData.push_back(item);
-		m_items.push_back(name);
+		m_addItem(name, item);
 
 		ed::Image3DObject* iObj = item->Image3D = new Image3DObject();
 		iObj->Size = size;
@@ -407,6 +794,7 @@ namespace ed
 
 		glGenTextures(1, &iObj->Texture);
 		glBindTexture(GL_TEXTURE_3D, iObj->Texture);
+		gl::SetObjectLabel(GL_TEXTURE, iObj->Texture, name);
 		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 		glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 		glTexImage3D(GL_TEXTURE_3D, 0, iObj->Format, size.x, size.y, size.z, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
@@ -414,20 +802,99 @@ namespace ed
 
 		return true;
 	}
-	bool ObjectManager::CreatePluginItem(const std::string& name, const std::string& objtype, void* data, GLuint id, IPlugin* owner)
+	bool ObjectManager::LoadImage3DSlices(const std::string& name, const std::vector<std::string>& files)
 	{
-		Logger::Get().Log("Creating a plugin object " + name + " of type " + objtype + "...");
-
-		if (Exists(name)) {
-			Logger::Get().Log("Cannot create the plugin object " + name + " because an item with that name already exists", true);
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		if (item == nullptr || item->Image3D == nullptr)
+			return false;
+		if (files.size() == 0) {
+			Logger::Get().Log("Cannot load the 3D image " + name + " without any slices", true);
 			return false;
 		}
 
-		m_parser->ModifyProject();
+		// every slice has the same size - only the headers are read here
+		glm::ivec2 size(0, 0);
+		for (const std::string& file : files) {
+			int width = 0, height = 0, nrChannels = 0;
+			if (eng::CompressedTexture::IsSupportedFile(file) || !stbi_info(m_parser->GetProjectPath(file).c_str(), &width, &height, &nrChannels)) {
+				Logger::Get().Log("Failed to load the slice " + file + " of a 3D image " + name, true);
+				return false;
+			}
+			if (size.x == 0)
+				size = glm::ivec2(width, height);
+			else if (size.x != width || size.y != height) {
+				Logger::Get().Log("Cannot load the 3D image " + name + " because " + file + " has a different size than the first slice", true);
+				return false;
+			}
+		}
+
+		GLint maxSize = 0;
+		glGetIntegerv(GL_MAX_3D_TEXTURE_SIZE, &maxSize);
+		if (files.size() > maxSize || size.x > maxSize || size.y > maxSize) {
+			Logger::Get().Log("Cannot load the 3D image " + name + " because it would be larger than " + std::to_string(maxSize) + " texels in some direction", true);
+			return false;
+		}
+
+		item->Image3D->Fill = GPUFill::Operation();
+		ResizeImage3D(name, glm::ivec3(size, files.size()));
+
+		// the 8 bit RGBA pixels of the files can't be converted to an integer format
+		GLint redType = GL_NONE;
+		glBindTexture(GL_TEXTURE_3D, item->Image3D->Texture);
+		glGetTexLevelParameteriv(GL_TEXTURE_3D, 0, GL_TEXTURE_RED_TYPE, &redType);
+		glBindTexture(GL_TEXTURE_3D, 0);
+		if (redType == GL_INT || redType == GL_UNSIGNED_INT) {
+			Logger::Get().Log("Cannot load slice files into the 3D image " + name + " because it has an integer format", true);
+			return false;
+		}
+
+		item->Image3D->SlicePaths = files;
+		for (int i = 0; i < files.size(); i++)
+			m_sliceLoads.push_back({ item, files[i], i });
+		m_streamSlices();
+
+		return true;
+	}
+	void ObjectManager::m_streamSlices()
+	{
+		int loading = 0;
+		for (const auto& job : m_loadJobs)
+			if (job->Target == GL_TEXTURE_3D)
+				loading++;
+
+		while (loading < IMAGE3D_SLICE_LOADS && !m_sliceLoads.empty()) {
+			SliceLoad slice = m_sliceLoads.front();
+			m_sliceLoads.pop_front();
+
+			if (m_queueTextureLoad(slice.Item, slice.Path, GL_TEXTURE_3D, slice.Slice))
+				loading++;
+		}
+	}
+	void ObjectManager::m_cancelSlices(ObjectManagerItem* item)
+	{
+		for (auto it = m_sliceLoads.begin(); it != m_sliceLoads.end();) {
+			if (it->Item == item)
+				it = m_sliceLoads.erase(it);
+			else
+				it++;
+		}
+		for (auto& job : m_loadJobs)
+			if (job->Item == item && job->Target == GL_TEXTURE_3D)
+				job->Item = nullptr;
+	}
+	bool ObjectManager::CreatePluginItem(const std::string& name, const std::string& objtype, void* data, GLuint id, IPlugin* owner)
+	{
+		Logger::Get().Log("Creating a plugin object " + name + " of type " + objtype + "...");
+
+		if (Exists(name)) {
+			Logger::Get().Log("Cannot create the plugin object " + name + " because an item with that name already exists", true);
+			return false;
+		}
+
+		m_parser->ModifyProject();
 
 		ObjectManagerItem* item = new ObjectManagerItem();
-		m_itemData.push_back(item);
-		m_items.push_back(name);
+		m_addItem(name, item);
 
 		PluginObject* pObj = item->Plugin = new PluginObject();
 		strcpy(pObj->Type, objtype.c_str());
@@ -499,38 +966,740 @@ namespace ed
 		return ret;
 	}
 	
+	bool ObjectManager::m_queueTextureLoad(ObjectManagerItem* item, const std::string& name, GLenum target, int layer)
+	{
+		std::shared_ptr<TextureLoadJob> job = std::make_shared<TextureLoadJob>();
+		job->Item = item;
+		job->Name = name;
+		job->Path = m_parser->GetProjectPath(name);
+		job->Target = target;
+		job->Layer = layer;
+		job->Channels = 4;
+		job->Done = false;
+		job->Failed = false;
+
+		// DDS/KTX/KTX2 files are uploaded as they are stored
+		if (eng::CompressedTexture::IsSupportedFile(job->Path)) {
+			job->Compressed = std::make_shared<eng::CompressedTexture>();
+			if (!job->Compressed->LoadFromFile(job->Path, true) || !job->Compressed->IsFormatSupported()) {
+				Logger::Get().Log("Failed to load a texture " + name + " from file: " + (job->Compressed->GetError().empty() ? "format not supported by the GPU" : job->Compressed->GetError()), true);
+				return false;
+			}
+			if (job->Compressed->FaceCount > 1)
+				Logger::Get().Log("Texture " + name + " stores a cubemap - only the first face will be used", true);
+
+			job->Size = job->Compressed->Size;
+			job->PBO = 0;
+			job->Pixels = nullptr;
+
+			m_loadJobs.push_back(job);
+			m_loadPool.Add([job]() {
+				TraceRecorder::Scope zone("Load compressed texture", "load");
+				job->Failed = !job->Compressed->LoadFromFile(job->Path);
+				job->Done = true;
+			});
+
+			return true;
+		}
+
+		int nrChannels = 0;
+		if (!stbi_info(job->Path.c_str(), &job->Size.x, &job->Size.y, &nrChannels)) {
+			Logger::Get().Log("Failed to load a texture " + name + " from file", true);
+			return false;
+		}
+
+		// RGB images are uploaded as they are, the driver expands them - grey images are expanded by stb_image while decoding
+		// since glGetTexImage() & glReadPixels() (debugger, readbacks) wouldn't see a swizzle mask
+		if (nrChannels == 3 && target == GL_TEXTURE_2D)
+			job->Channels = 3;
+
+		// map a pixel unpack buffer so that the upload doesn't need another copy
+		size_t dataSize = (size_t)job->Size.x * job->Size.y * job->Channels;
+		glGenBuffers(1, &job->PBO);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, job->PBO);
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, dataSize, nullptr, GL_STREAM_DRAW);
+		job->Pixels = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, dataSize, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		if (job->Pixels == nullptr) {
+			glDeleteBuffers(1, &job->PBO);
+			job->PBO = 0;
+			job->Fallback.resize(dataSize);
+			job->Pixels = job->Fallback.data();
+		}
+
+		m_loadJobs.push_back(job);
+		m_loadPool.Add([job]() {
+			TraceRecorder::Scope zone("Decode texture", "load");
+			decodeTexture(job->Path, job->Size, job->Channels, job->Pixels, job->Failed);
+			job->Done = true;
+		});
+
+		return true;
+	}
+	void ObjectManager::m_pollTextureLoads(bool wait)
+	{
+		bool uploaded = false;
+		std::vector<ObjectManagerItem*> arrays; // the mip chain is generated once all layers are there
+		for (int i = 0; i < m_loadJobs.size(); i++) {
+			TextureLoadJob* job = m_loadJobs[i].get();
+			if (!job->Done) {
+				if (!wait)
+					continue;
+				while (!job->Done)
+					std::this_thread::yield();
+			}
+
+			const void* pixels = job->Pixels;
+			if (job->PBO != 0) {
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, job->PBO);
+				glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+				pixels = nullptr; // offset into the PBO
+			}
+
+			if (job->Failed)
+				Logger::Get().Log("Failed to load a texture " + job->Name + " from file" + (job->Compressed ? ": " + job->Compressed->GetError() : ""), true);
+			else if (job->Item != nullptr && job->Compressed) {
+				eng::CompressedTexture* tex = job->Compressed.get();
+				GLenum bindTarget = job->Target == GL_TEXTURE_2D ? GL_TEXTURE_2D : GL_TEXTURE_CUBE_MAP;
+
+				glBindTexture(bindTarget, job->Item->Texture);
+				tex->Upload(job->Target, 0);
+				glTexParameteri(bindTarget, GL_TEXTURE_MAX_LEVEL, tex->LevelCount - 1);
+				if (tex->LevelCount > 1)
+					glTexParameteri(bindTarget, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+				glBindTexture(bindTarget, 0);
+
+				if (job->Target == GL_TEXTURE_2D && job->Item->IsTexture)
+					ResidentAssets::Instance().Track(job->Path);
+
+				m_markChanged(job->Item);
+				uploaded = true;
+			} else if (job->Item != nullptr && job->Target == GL_TEXTURE_3D) {
+				Image3DObject* iobj = job->Item->Image3D;
+				if (job->Layer < iobj->Size.z && job->Size.x <= iobj->Size.x && job->Size.y <= iobj->Size.y) {
+					glBindTexture(GL_TEXTURE_3D, iobj->Texture);
+					glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, job->Layer, job->Size.x, job->Size.y, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+					glBindTexture(GL_TEXTURE_3D, 0);
+				}
+
+				m_markChanged(job->Item);
+				uploaded = true;
+			} else if (job->Item != nullptr && job->Target == GL_TEXTURE_2D_ARRAY) {
+				glBindTexture(GL_TEXTURE_2D_ARRAY, job->Item->Texture);
+				glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, job->Layer, job->Size.x, job->Size.y, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+				glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+				if (std::count(arrays.begin(), arrays.end(), job->Item) == 0)
+					arrays.push_back(job->Item);
+
+				m_markChanged(job->Item);
+				uploaded = true;
+			} else if (job->Item != nullptr) {
+				GLenum bindTarget = job->Target == GL_TEXTURE_2D ? GL_TEXTURE_2D : GL_TEXTURE_CUBE_MAP;
+
+				// rows of RGB images aren't 4 byte aligned
+				glBindTexture(bindTarget, job->Item->Texture);
+				if (job->Channels == 3) {
+					glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+					glTexImage2D(job->Target, 0, GL_RGB8, job->Size.x, job->Size.y, 0, GL_RGB, GL_UNSIGNED_BYTE, pixels);
+					glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+				} else
+					glTexImage2D(job->Target, 0, GL_RGBA, job->Size.x, job->Size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+				glBindTexture(bindTarget, 0);
+
+				if (job->Target == GL_TEXTURE_2D && job->Item->Mipmaps)
+					applyMipmaps(job->Item->Texture, true);
+				if (job->Target == GL_TEXTURE_2D && job->Item->IsTexture)
+					ResidentAssets::Instance().Track(job->Path);
+
+				m_markChanged(job->Item);
+				uploaded = true;
+			}
+
+			if (job->PBO != 0) {
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+				glDeleteBuffers(1, &job->PBO);
+			}
+
+			m_loadJobs.erase(m_loadJobs.begin() + i);
+			i--;
+		}
+
+		for (ObjectManagerItem* item : arrays) {
+			bool loading = false;
+			for (const auto& job : m_loadJobs)
+				if (job->Item == item)
+					loading = true;
+
+			if (!loading && item->Mipmaps)
+				applyMipmaps(item->Texture, true, GL_TEXTURE_2D_ARRAY);
+		}
+
+		m_streamSlices();
+
+		if (uploaded && m_renderer != nullptr)
+			m_renderer->InvalidatePassCache();
+	}
+	void ObjectManager::WaitForLoading()
+	{
+		do {
+			m_pollTextureLoads(true);
+		} while (!m_loadJobs.empty());
+
+		// environment maps are filtered on the GPU once the image is decoded
+		while (GetLoadingCount() > 0) {
+			m_updateEnvironments();
+			m_updateImageSequences();
+			if (GetLoadingCount() > 0)
+				std::this_thread::yield();
+		}
+	}
+	int ObjectManager::GetLoadingCount()
+	{
+		int ret = m_loadJobs.size();
+		for (ObjectManagerItem* item : m_itemData)
+			if ((item->Environment != nullptr && item->Environment->IsBuilding()) || (item->Sequence != nullptr && item->Sequence->IsWaiting()))
+				ret++;
+		return ret;
+	}
+
 	void ObjectManager::Update(float delta)
 	{
-		for (auto& it : m_itemData) {
-			if (it->SoundBuffer == nullptr)
+		ED_ZONE("ObjectManager::Update");
+		FrameProfiler::Scope frameScope(FrameProfiler::Objects);
+
+		m_pollTextureLoads(false);
+		m_updateBindlessTable();
+
+		// the passes can't use a mapped buffer
+		for (const auto& map : m_writeMaps) {
+			glBindBuffer(GL_COPY_WRITE_BUFFER, map.first->Buffer->ID);
+			glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		}
+		m_writeMaps.clear();
+
+		m_updateVideos(delta);
+		m_updateVirtualTextures();
+		m_updateEnvironments();
+		m_updateImageSequences();
+
+		m_audioFrame++;
+		m_updateAudioArray();
+		m_updateAudioPosition();
+
+		// the audio objects that no pass samples are skipped - packed ones are all needed if any of them is bound
+		std::unordered_set<GLuint> bound;
+		for (const auto& binds : m_binds)
+			bound.insert(binds.second.begin(), binds.second.end());
+
+		bool arrayBound = false;
+		if (m_audioArray != 0)
+			for (ObjectManagerItem* item : m_itemData)
+				if (item->SoundLayer >= 0 && bound.count(item->Texture) > 0) {
+					arrayBound = true;
+					break;
+				}
+
+		std::vector<ObjectManagerItem*> changed;
+		for (ObjectManagerItem* item : m_itemData) {
+			// whole tracks were uploaded once, the shaders only need the playing position
+			if (item->Sound == nullptr || item->SoundTrackTexture != 0)
+				continue;
+
+			if (item->SoundLayer >= 0 ? !arrayBound : bound.count(item->Texture) == 0)
+				continue;
+
+			m_updateAudioData(item);
+			if (item->SoundDirty)
+				changed.push_back(item);
+		}
+
+		if (changed.size() > 0)
+			m_uploadAudio(changed);
+	}
+	void ObjectManager::m_updateVideos(float delta)
+	{
+		double time = SystemVariableManager::Instance().GetTime();
+
+		for (ObjectManagerItem* item : m_itemData) {
+			VideoObject* video = item->Video;
+			if (video == nullptr)
+				continue;
+
+			if (video->Decoder->IsLive()) {
+				if (!video->Paused)
+					m_uploadVideoFrame(item, 0.0);
+				continue;
+			}
+
+			if (!video->Paused)
+				video->Clock += delta;
+
+			m_uploadVideoFrame(item, video->SyncToTime ? time : video->Clock);
+		}
+	}
+	void ObjectManager::m_updateVirtualTextures()
+	{
+		if (!m_virtualLayoutValid) {
+			m_releaseVirtualBlock();
+			m_virtualItems.clear();
+			m_virtualLayoutValid = true;
+
+			for (ObjectManagerItem* item : m_itemData)
+				if (item->Virtual != nullptr && m_virtualItems.size() < VIRTUAL_TEXTURE_MAX_OBJECTS)
+					m_virtualItems.push_back(item);
+			if (m_virtualItems.empty())
+				return;
+
+			// the resident flags are kept, the GPU starts requesting the pages again
+			std::vector<GLuint> data(VIRTUAL_TEXTURE_HEADER_WORDS, 0);
+			for (int i = 0; i < m_virtualItems.size(); i++) {
+				VirtualTexture* vtex = m_virtualItems[i]->Virtual;
+				glm::uvec4 info = vtex->GetInfo(data.size() - VIRTUAL_TEXTURE_HEADER_WORDS);
+				memcpy(&data[4 + i * 4], &info[0], sizeof(info));
+				data.insert(data.end(), vtex->GetWords().begin(), vtex->GetWords().end());
+				vtex->ClearDirty();
+			}
+			data[0] = m_virtualFrame;
+
+			glGenBuffers(1, &m_virtualBlock);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_virtualBlock);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, data.size() * sizeof(GLuint), data.data(), GL_DYNAMIC_DRAW);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+			glGenBuffers(1, &m_virtualReadback);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, m_virtualReadback);
+			glBufferData(GL_COPY_WRITE_BUFFER, (data.size() - VIRTUAL_TEXTURE_HEADER_WORDS) * sizeof(GLuint), nullptr, GL_STREAM_READ);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+			if (m_renderer != nullptr)
+				m_renderer->InvalidatePassCache();
+		}
+		if (m_virtualBlock == 0)
+			return;
+
+		// the words of a frame that the GPU finished, without waiting for it
+		const GLuint* feedback = nullptr;
+		if (m_virtualFence != nullptr && glClientWaitSync(m_virtualFence, 0, 0) != GL_TIMEOUT_EXPIRED) {
+			glDeleteSync(m_virtualFence);
+			m_virtualFence = nullptr;
+
+			glBindBuffer(GL_COPY_READ_BUFFER, m_virtualReadback);
+			GLint size = 0;
+			glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &size);
+			feedback = (const GLuint*)glMapBufferRange(GL_COPY_READ_BUFFER, 0, size, GL_MAP_READ_BIT);
+		}
+
+		m_virtualFrame++;
+
+		int words = 0;
+		for (ObjectManagerItem* item : m_virtualItems) {
+			item->Virtual->Update(feedback != nullptr ? feedback + words : nullptr, m_virtualFrame, m_loadPool);
+			words += item->Virtual->GetPageCount();
+		}
+
+		if (feedback != nullptr) {
+			glUnmapBuffer(GL_COPY_READ_BUFFER);
+			glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		}
+
+		// the resident flags that changed & the frame that the shaders write
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_virtualBlock);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(GLuint), &m_virtualFrame);
+		int first = 0;
+		for (ObjectManagerItem* item : m_virtualItems) {
+			VirtualTexture* vtex = item->Virtual;
+			int start = 0, end = 0;
+			if (vtex->GetDirtyRange(start, end)) {
+				GLintptr offset = (VIRTUAL_TEXTURE_HEADER_WORDS + first + start) * sizeof(GLuint);
+				glBufferSubData(GL_SHADER_STORAGE_BUFFER, offset, (end - start) * sizeof(GLuint), &vtex->GetWords()[start]);
+				vtex->ClearDirty();
+			}
+			first += vtex->GetPageCount();
+		}
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+		// the requests of the previous frames
+		if (m_virtualFence == nullptr && words > 0) {
+			glBindBuffer(GL_COPY_READ_BUFFER, m_virtualBlock);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, m_virtualReadback);
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, VIRTUAL_TEXTURE_HEADER_WORDS * sizeof(GLuint), 0, words * sizeof(GLuint));
+			glBindBuffer(GL_COPY_READ_BUFFER, 0);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+			m_virtualFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		}
+	}
+	void ObjectManager::m_releaseVirtualBlock()
+	{
+		if (m_virtualFence != nullptr)
+			glDeleteSync(m_virtualFence);
+		m_virtualFence = nullptr;
+
+		if (m_virtualBlock != 0)
+			glDeleteBuffers(1, &m_virtualBlock);
+		if (m_virtualReadback != 0)
+			glDeleteBuffers(1, &m_virtualReadback);
+		m_virtualBlock = m_virtualReadback = 0;
+	}
+	void ObjectManager::m_uploadVideoFrame(ObjectManagerItem* item, double time)
+	{
+		VideoObject* video = item->Video;
+		int index = video->NextPBO;
+
+		// the GPU is still reading this PBO -> keep showing the current frame instead of stalling
+		if (video->Fence[index] != nullptr) {
+			if (glClientWaitSync(video->Fence[index], 0, 0) == GL_TIMEOUT_EXPIRED)
+				return;
+			glDeleteSync(video->Fence[index]);
+			video->Fence[index] = nullptr;
+		}
+
+		glm::ivec2 size = item->ImageSize;
+		int frameSize = size.x * size.y * 4;
+		bool mapped = false;
+
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, video->PBO[index]);
+		video->Decoder->GetFrame(time, video->FramePTS, [&](const unsigned char* pixels) {
+			if (video->Mapped[index] != nullptr) {
+				memcpy(video->Mapped[index], pixels, frameSize);
+				mapped = true;
+				return;
+			}
+
+			void* dst = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, frameSize, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+			if (dst != nullptr) {
+				memcpy(dst, pixels, frameSize);
+				mapped = glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE;
+			}
+		});
+
+		if (mapped) {
+			glBindTexture(GL_TEXTURE_2D, item->Texture);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size.x, size.y, GL_RGBA, GL_UNSIGNED_BYTE, (void*)0);
+			glBindTexture(GL_TEXTURE_2D, 0);
+
+			video->Fence[index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			video->NextPBO = (index + 1) % VIDEO_UPLOAD_PBOS;
+			m_markChanged(item);
+		}
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+	void ObjectManager::m_updateAudioData(ObjectManagerItem* item)
+	{
+		if (item->SoundFrame == m_audioFrame)
+			return;
+		item->SoundFrame = m_audioFrame;
+
+		// get samples and fft data
+		AudioTrack* track = item->Sound;
+		int channels = track->GetChannelCount();
+		sf::Uint64 perChannel = track->GetFrameCount();
+		float duration = track->GetDuration();
+		sf::Uint64 curSample = duration > 0.0f ? (sf::Uint64)((track->GetOffset() / duration) * perChannel) : 0;
+
+		// paused or stopped - the last spectrum stays
+		if ((int)curSample == item->SoundSample)
+			return;
+		item->SoundSample = (int)curSample;
+
+		// streamed tracks only have the samples around the playhead
+		int count = ed::AudioAnalyzer::SampleCount;
+		const sf::Int16* samples = track->GetSamples(curSample, count);
+		if (samples == nullptr)
+			return;
+
+		double* fftData = item->SoundAnalyzer->FFT(samples, count, channels, track->GetSampleRate());
+
+		float* data = item->SoundData.data();
+		for (int i = 0; i < ed::AudioAnalyzer::SampleCount; i++) {
+			sf::Int16 s = samples[std::min<int>(i, count * channels - 1)];
+			float sf = (float)s / (float)INT16_MAX;
+
+			data[i] = fftData[i / 2];
+			data[i + ed::AudioAnalyzer::SampleCount] = sf * 0.5f + 0.5f;
+		}
+
+		item->SoundDirty = true;
+	}
+	void ObjectManager::m_updateAudioArray()
+	{
+		bool pack = Settings::Instance().Project.AudioTextureArray;
+
+		int count = 0;
+		for (ObjectManagerItem* item : m_itemData)
+			if (item->Sound != nullptr) {
+				if (item->SoundTrackTexture != 0) {
+					item->SoundLayer = -1;
+					continue;
+				}
+				item->SoundLayer = pack ? count : -1;
+				count++;
+			}
+
+		if (!pack || count == 0) {
+			if (m_audioArray != 0) {
+				glDeleteTextures(1, &m_audioArray);
+				m_audioArray = 0;
+				m_audioArrayLayers = 0;
+				m_invalidateBindTables();
+
+				// the 2D textures weren't updated while the objects were packed
+				for (ObjectManagerItem* item : m_itemData)
+					item->SoundDirty = item->Sound != nullptr;
+			}
+			return;
+		}
+
+		if (m_audioArray != 0 && m_audioArrayLayers == count)
+			return;
+
+		if (m_audioArray == 0) {
+			glGenTextures(1, &m_audioArray);
+			glBindTexture(GL_TEXTURE_2D_ARRAY, m_audioArray);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			m_invalidateBindTables();
+		}
+		else
+			glBindTexture(GL_TEXTURE_2D_ARRAY, m_audioArray);
+
+		// the id stays the same when the number of layers changes so the bind tables are still valid
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_R32F, AudioAnalyzer::SampleCount, 2, count, 0, GL_RED, GL_FLOAT, NULL);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+		m_audioArrayLayers = count;
+
+		for (ObjectManagerItem* item : m_itemData)
+			item->SoundDirty = item->Sound != nullptr;
+	}
+	void ObjectManager::m_updateAudioPosition()
+	{
+		// the first whole track, the seconds of the first audio object otherwise
+		glm::vec4 pos(0.0f);
+		bool found = false;
+		for (ObjectManagerItem* item : m_itemData) {
+			if (item->Sound == nullptr)
+				continue;
+
+			float offset = item->Sound->GetOffset();
+			if (item->SoundTrackTexture != 0) {
+				// an envelope value covers a whole number of samples
+				unsigned int sampleRate = item->Sound->GetSampleRate();
+				unsigned int step = item->SoundTrackRate > 0 ? std::max<unsigned int>(sampleRate / item->SoundTrackRate, 1) : 1;
+				float texelRate = (float)sampleRate / step;
+				pos = glm::vec4(offset, std::floor(offset * texelRate), texelRate, (float)item->SoundTrackLength);
+				break;
+			}
+			if (!found) {
+				pos = glm::vec4(offset, 0.0f, 0.0f, 0.0f);
+				found = true;
+			}
+		}
+
+		SystemVariableManager::Instance().SetAudioPosition(pos);
+	}
+	void ObjectManager::m_updateBindlessTable()
+	{
+		std::vector<GLuint64> handles;
+		if (Settings::Instance().Project.BindlessTextures && GLEW_ARB_bindless_texture) {
+			std::unordered_set<ObjectManagerItem*> loading;
+			for (const auto& job : m_loadJobs)
+				loading.insert(job->Item);
+
+			for (ObjectManagerItem* item : m_itemData) {
+				if (!isBindless(item))
+					continue;
+
+				// the texture becomes immutable once it has a handle so it has to be fully uploaded first
+				if (item->BindlessHandle == 0 && !item->BindlessFailed && loading.count(item) == 0) {
+					item->BindlessHandle = glGetTextureHandleARB(item->Texture);
+					item->BindlessFailed = item->BindlessHandle == 0;
+					if (item->BindlessFailed)
+						Logger::Get().Log("Failed to create a bindless handle for one of the textures", true);
+				}
+				if (item->BindlessHandle != 0 && !item->BindlessResident) {
+					glMakeTextureHandleResidentARB(item->BindlessHandle);
+					item->BindlessResident = true;
+				}
+
+				handles.push_back(item->BindlessHandle);
+			}
+		} else {
+			for (ObjectManagerItem* item : m_itemData)
+				if (item->BindlessResident) {
+					glMakeTextureHandleNonResidentARB(item->BindlessHandle);
+					item->BindlessResident = false;
+				}
+		}
+
+		if (handles == m_bindlessHandles)
+			return;
+		m_bindlessHandles = handles;
+
+		if (handles.size() == 0) {
+			glDeleteBuffers(1, &m_bindlessTable);
+			m_bindlessTable = 0;
+		} else {
+			if (m_bindlessTable == 0)
+				glGenBuffers(1, &m_bindlessTable);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_bindlessTable);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, handles.size() * sizeof(GLuint64), handles.data(), GL_STATIC_DRAW);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		}
+
+		if (m_renderer != nullptr)
+			m_renderer->InvalidatePassCache();
+	}
+	int ObjectManager::GetBindlessIndex(const std::string& name)
+	{
+		if (m_bindlessTable == 0)
+			return -1;
+
+		int index = 0;
+		for (int i = 0; i < m_items.size(); i++) {
+			if (!isBindless(m_itemData[i]))
 				continue;
+			if (m_items[i] == name)
+				return index;
+			index++;
+		}
+		return -1;
+	}
+	int ObjectManager::GetVirtualTextureIndex(const std::string& name)
+	{
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		for (int i = 0; i < m_virtualItems.size(); i++)
+			if (m_virtualItems[i] == item)
+				return i;
+		return -1;
+	}
+	void ObjectManager::m_uploadAudio(const std::vector<ObjectManagerItem*>& items)
+	{
+		const int itemSize = AudioAnalyzer::SampleCount * 2;
+
+		// persistently mapped ring - the CPU writes one segment while the GPU still reads from the older ones
+		if (GLEW_ARB_buffer_storage && m_audioPBOCapacity < items.size()) {
+			m_releaseAudioPBO();
+
+			int capacity = std::max<int>(items.size(), 4);
+			GLsizeiptr size = (GLsizeiptr)capacity * itemSize * sizeof(float) * AUDIO_UPLOAD_SEGMENTS;
+			GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+			glGenBuffers(1, &m_audioPBO);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_audioPBO);
+			glBufferStorage(GL_PIXEL_UNPACK_BUFFER, size, nullptr, flags);
+			m_audioPBOData = (float*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, flags);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+			if (m_audioPBOData == nullptr) {
+				Logger::Get().Log("Failed to map the audio upload buffer", true);
+				glDeleteBuffers(1, &m_audioPBO);
+				m_audioPBO = 0;
+			} else
+				m_audioPBOCapacity = capacity;
+		}
 
-			// get samples and fft data
-			sf::Sound* player = it->Sound;
-			int channels = it->SoundBuffer->getChannelCount();
-			int perChannel = it->SoundBuffer->getSampleCount() / channels;
-			int curSample = (int)((player->getPlayingOffset().asSeconds() / it->SoundBuffer->getDuration().asSeconds()) * perChannel);
+		bool usePBO = m_audioPBOData != nullptr && m_audioPBOCapacity >= items.size();
+		size_t offset = 0;
+		int segment = m_audioPBOSegment;
+		if (usePBO) {
+			m_audioPBOSegment = (segment + 1) % AUDIO_UPLOAD_SEGMENTS;
 
-			double* fftData = m_audioAnalyzer.FFT(*(it->SoundBuffer), curSample);
+			if (m_audioFences[segment] != 0) {
+				glClientWaitSync(m_audioFences[segment], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+				glDeleteSync(m_audioFences[segment]);
+				m_audioFences[segment] = 0;
+			}
+
+			offset = (size_t)segment * m_audioPBOCapacity * itemSize;
+			for (int i = 0; i < items.size(); i++)
+				memcpy(m_audioPBOData + offset + i * itemSize, items[i]->SoundData.data(), itemSize * sizeof(float));
+
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_audioPBO);
+		}
 
-			const sf::Int16* samples = it->SoundBuffer->getSamples();
-			for (int i = 0; i < ed::AudioAnalyzer::SampleCount; i++) {
-				sf::Int16 s = samples[std::min<int>(i + curSample, perChannel)];
-				float sf = (float)s / (float)INT16_MAX;
+		auto source = [&](int i, ObjectManagerItem* item) -> const void* {
+			if (usePBO)
+				return (const void*)(intptr_t)((offset + i * itemSize) * sizeof(float));
+			return item->SoundData.data();
+		};
 
-				m_audioTempTexData[i] = fftData[i / 2];
-				m_audioTempTexData[i + ed::AudioAnalyzer::SampleCount] = sf* 0.5f + 0.5f;
+		if (m_audioArray != 0) {
+			glBindTexture(GL_TEXTURE_2D_ARRAY, m_audioArray);
+
+			// usually every layer changed - the items are in layer order so they can go in one call
+			if (usePBO && items.size() == m_audioArrayLayers)
+				glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, AudioAnalyzer::SampleCount, 2, m_audioArrayLayers, GL_RED, GL_FLOAT, source(0, items[0]));
+			else {
+				for (int i = 0; i < items.size(); i++)
+					glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, items[i]->SoundLayer, AudioAnalyzer::SampleCount, 2, 1, GL_RED, GL_FLOAT, source(i, items[i]));
 			}
 
-			glBindTexture(GL_TEXTURE_2D, it->Texture);
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, 512, 2, 0, GL_RED, GL_FLOAT, m_audioTempTexData);
+			glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+		} else {
+			for (int i = 0; i < items.size(); i++) {
+				glBindTexture(GL_TEXTURE_2D, items[i]->Texture);
+				glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, AudioAnalyzer::SampleCount, 2, GL_RED, GL_FLOAT, source(i, items[i]));
+			}
 			glBindTexture(GL_TEXTURE_2D, 0);
 		}
+
+		if (usePBO) {
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			m_audioFences[segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		}
+
+		for (ObjectManagerItem* item : items)
+			item->SoundDirty = false;
+	}
+	void ObjectManager::m_releaseAudioPBO()
+	{
+		for (int i = 0; i < AUDIO_UPLOAD_SEGMENTS; i++)
+			if (m_audioFences[i] != 0) {
+				glClientWaitSync(m_audioFences[i], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+				glDeleteSync(m_audioFences[i]);
+				m_audioFences[i] = 0;
+			}
+
+		if (m_audioPBO != 0) {
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_audioPBO);
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			glDeleteBuffers(1, &m_audioPBO);
+		}
+
+		m_audioPBO = 0;
+		m_audioPBOData = nullptr;
+		m_audioPBOCapacity = 0;
+		m_audioPBOSegment = 0;
 	}
 	void ObjectManager::Remove(const std::string & file)
 	{
 		m_parser->ModifyProject();
 
+		// the history object can't exist without its rt
+		ObjectManagerItem* removed = GetObjectManagerItem(file);
+		if (removed != nullptr && removed->History != nullptr)
+			Remove(GetObjectManagerItemName(removed->History));
+		if (removed != nullptr && removed->HistoryOf != nullptr)
+			removed->HistoryOf->History = nullptr;
+
+		// same for the irradiance & BRDF objects of an environment map
+		if (removed != nullptr && removed->Environment != nullptr) {
+			for (int i = 0; i < m_itemData.size(); i++)
+				if (m_itemData[i]->EnvironmentOf == removed) {
+					std::string part = m_items[i];
+					Remove(part);
+					i--;
+				}
+		}
+		if (removed != nullptr && removed->EnvironmentOf != nullptr)
+			removed->EnvironmentOf->Environment->Detach(removed->Texture);
+
 		GLuint srv = GetTexture(file);
 		if (IsImage3D(file))
 			srv = GetImage3D(file)->Texture;
@@ -547,12 +1716,15 @@ namespace ed
 					i.second.erase(i.second.begin() + j);
 					j--;
 				}
+		for (auto& i : m_samplers)
+			i.second.erase(srv);
 		for (auto& i : m_uniformBinds)
 			for (int j = 0; j < i.second.size(); j++)
 				if (i.second[j] == srv) {
 					i.second.erase(i.second.begin() + j);
 					j--;
 				}
+		m_invalidateBindTables();
 		
 		int index = 0;
 		for (; index < m_items.size(); index++)
@@ -563,9 +1735,26 @@ namespace ed
 			pobj->Owner->RemoveObject(file.c_str(), pobj->Type, pobj->Data, pobj->ID);
 		}
 
+		// uploads that are still pending have nowhere to go
+		m_cancelSlices(m_itemData[index]);
+		for (auto& job : m_loadJobs)
+			if (job->Item == m_itemData[index])
+				job->Item = nullptr;
+
+		m_releaseMappings(m_itemData[index], true);
+
+		if (m_itemData[index]->Virtual != nullptr)
+			m_virtualLayoutValid = false;
+
 		delete m_itemData[index];
 		m_itemData.erase(m_itemData.begin() + index);
 		m_items.erase(m_items.begin() + index);
+		m_itemIndex.erase(file);
+		m_idIndexValid = false;
+
+		// the name can be given to a new object
+		if (m_renderer != nullptr)
+			m_renderer->InvalidatePassCache();
 	}
 
 	void ObjectManager::Bind(const std::string & file, PipelineItem * pass)
@@ -581,6 +1770,8 @@ namespace ed
 				m_binds[pass].push_back(GetPluginObject(file)->ID);
 			else
 				m_binds[pass].push_back(GetTexture(file));
+
+			m_bindTables.erase(pass);
 		}
 	}
 	void ObjectManager::Unbind(const std::string & file, PipelineItem * pass)
@@ -600,6 +1791,9 @@ namespace ed
 				m_parser->ModifyProject();
 
 				srvs.erase(srvs.begin() + i);
+				m_bindTables.erase(pass);
+				if (m_samplers.count(pass) > 0)
+					m_samplers[pass].erase(srv);
 				return;
 			}
 	}
@@ -641,6 +1835,7 @@ namespace ed
 			else
 				m_uniformBinds[pass].push_back(GetImage(file)->Texture);
 
+			m_uniformBindTables.erase(pass);
 			m_parser->ModifyProject();
 		}
 	}
@@ -661,6 +1856,7 @@ namespace ed
 		for (int i = 0; i < ubos.size(); i++)
 			if (ubos[i] == itemID) {
 				ubos.erase(ubos.begin() + i);
+				m_uniformBindTables.erase(pass);
 				m_parser->ModifyProject();
 				return;
 			}
@@ -687,272 +1883,1081 @@ namespace ed
 		return -1;
 	}
 
-	std::string ObjectManager::GetItemNameByTextureID(GLuint texID)
+	const std::vector<BindingDescriptor>& ObjectManager::GetBindTable(PipelineItem* pass)
 	{
-		for (int i = 0; i < m_itemData.size(); i++) {
-			ObjectManagerItem* item = m_itemData[i];
-			if (item->Texture == texID ||
-				(item->Image != nullptr && item->Image->Texture == texID) ||
-				(item->Image3D != nullptr && item->Image3D->Texture == texID) ||
-				(item->Buffer != nullptr && item->Buffer->ID == texID))
-			{
-				return m_items[i];
+		auto binds = m_binds.find(pass);
+		if (binds == m_binds.end())
+			return m_emptyBindTable;
+
+		// the list can also be reordered from outside (PipelineUI), so compare the IDs too
+		std::vector<BindingDescriptor>& table = m_bindTables[pass];
+		if (!m_isTableValid(table, binds->second)) {
+			table.clear();
+			for (GLuint id : binds->second)
+				table.push_back(m_buildDescriptor(id, false));
+
+			// plugins bind their own objects
+			for (BindingDescriptor& desc : table) {
+				const SamplerState* state = GetSampler(pass, desc.Source);
+				if (state != nullptr && desc.Type != BindingDescriptor::BindType::Plugin)
+					desc.Sampler = m_samplerCache.Get(*state);
 			}
 		}
 
-		return "";
-	}
-	glm::ivec2 ObjectManager::GetRenderTextureSize(const std::string & name)
-	{
-		RenderTextureObject* rt = GetRenderTexture(name);
-		if (rt->FixedSize.x < 0) return glm::ivec2(rt->RatioSize.x * m_renderer->GetLastRenderSize().x, rt->RatioSize.y * m_renderer->GetLastRenderSize().y);
-		return rt->FixedSize;
+		return table;
 	}
-	const std::vector<std::string>& ObjectManager::GetCubemapTextures(const std::string& name)
+	const SamplerState* ObjectManager::GetSampler(PipelineItem* pass, GLuint id)
 	{
-		for (int i = 0; i < m_items.size(); i++)
-			if (m_items[i] == name)
-				return m_itemData[i]->CubemapPaths;
-		return m_emptyCBTexs;
-	}
+		auto samplers = m_samplers.find(pass);
+		if (samplers == m_samplers.end())
+			return nullptr;
 
-	bool ObjectManager::IsRenderTexture(const std::string& name)
-	{
-		for (int i = 0; i < m_items.size(); i++)
-			if (m_items[i] == name)
-				return m_itemData[i]->RT != nullptr;
-		return false;
+		auto state = samplers->second.find(id);
+		if (state == samplers->second.end())
+			return nullptr;
+
+		return &state->second;
 	}
-	bool ObjectManager::IsCubeMap(const std::string& name)
+	void ObjectManager::SetSampler(PipelineItem* pass, GLuint id, const SamplerState& state)
 	{
-		for (int i = 0; i < m_items.size(); i++)
-			if (m_items[i] == name)
-				return m_itemData[i]->IsCube;
-		return false;
+		const SamplerState* cur = GetSampler(pass, id);
+		if (cur != nullptr && *cur == state)
+			return;
+
+		m_parser->ModifyProject();
+		m_samplers[pass][id] = state;
+		m_bindTables.erase(pass);
+		m_renderer->InvalidatePassCache();
 	}
-	bool ObjectManager::IsAudio(const std::string& name)
+	void ObjectManager::ResetSampler(PipelineItem* pass, GLuint id)
 	{
-		for (int i = 0; i < m_items.size(); i++)
-			if (m_items[i] == name)
-				return m_itemData[i]->Sound != nullptr;
-		return false;
+		if (GetSampler(pass, id) == nullptr)
+			return;
+
+		m_parser->ModifyProject();
+		m_samplers[pass].erase(id);
+		m_bindTables.erase(pass);
+		m_renderer->InvalidatePassCache();
 	}
-	bool ObjectManager::IsAudioMuted(const std::string& name)
+	const std::vector<BindingDescriptor>& ObjectManager::GetUniformBindTable(PipelineItem* pass)
 	{
-		for (int i = 0; i < m_items.size(); i++)
-			if (m_items[i] == name)
-				return m_itemData[i]->SoundMuted;
-		return false;
+		auto binds = m_uniformBinds.find(pass);
+		if (binds == m_uniformBinds.end())
+			return m_emptyBindTable;
+
+		std::vector<BindingDescriptor>& table = m_uniformBindTables[pass];
+		if (!m_isTableValid(table, binds->second)) {
+			table.clear();
+			for (GLuint id : binds->second)
+				table.push_back(m_buildDescriptor(id, true));
+		}
+
+		return table;
 	}
-	bool ObjectManager::IsBuffer(const std::string& name)
+	bool ObjectManager::m_isTableValid(const std::vector<BindingDescriptor>& table, const std::vector<GLuint>& ids)
 	{
-		for (int i = 0; i < m_items.size(); i++)
-			if (m_items[i] == name)
-				return m_itemData[i]->Buffer != nullptr;
-		return false;
+		if (table.size() != ids.size())
+			return false;
+		for (int i = 0; i < ids.size(); i++)
+			if (table[i].Source != ids[i])
+				return false;
+		return true;
 	}
-	bool ObjectManager::IsImage(const std::string& name)
+	BindingDescriptor ObjectManager::m_buildDescriptor(GLuint id, bool uniform)
 	{
-		for (int i = 0; i < m_items.size(); i++)
-			if (m_items[i] == name)
-				return m_itemData[i]->Image != nullptr;
+		BindingDescriptor ret;
+		ret.ID = id;
+		ret.Source = id;
+		ret.Image = nullptr;
+		ret.Image3D = nullptr;
+		ret.Buffer = nullptr;
+		ret.Plugin = nullptr;
+		ret.Sampler = 0;
+
+		bool isAudio = false, isArray = false, isCubeRT = false;
+		GLuint audioTrack = 0;
+		for (ObjectManagerItem* item : m_itemData) {
+			if (item->Sound != nullptr && item->Texture == id) {
+				isAudio = true;
+				audioTrack = item->SoundTrackTexture;
+			}
+			if (item->IsTextureArray && item->Texture == id)
+				isArray = true;
+			if (item->RT != nullptr && item->Texture == id) {
+				isArray = item->RT->GetTarget() == GL_TEXTURE_2D_ARRAY;
+				isCubeRT = item->RT->Cubemap;
+			}
+			if (item->Image != nullptr && item->Image->Texture == id)
+				ret.Image = item->Image;
+			else if (item->Image3D != nullptr && item->Image3D->Texture == id)
+				ret.Image3D = item->Image3D;
+			else if (item->Buffer != nullptr && item->Buffer->ID == id)
+				ret.Buffer = item->Buffer;
+			if (item->Plugin != nullptr && item->Plugin->ID == id)
+				ret.Plugin = item->Plugin;
+		}
+
+		// same priorities as the old per-frame Is*() checks
+		if (uniform) {
+			if (ret.Image != nullptr) {
+				ret.Type = BindingDescriptor::BindType::Image2D;
+				ret.Target = GL_TEXTURE_2D;
+			} else if (ret.Image3D != nullptr) {
+				ret.Type = BindingDescriptor::BindType::Image3D;
+				ret.Target = GL_TEXTURE_3D;
+			} else if (ret.Plugin != nullptr) {
+				ret.Type = BindingDescriptor::BindType::Plugin;
+				ret.Target = 0;
+			} else {
+				ret.Type = BindingDescriptor::BindType::Buffer;
+				ret.Target = GL_SHADER_STORAGE_BUFFER;
+			}
+		} else {
+			if (IsCubeMap(id) || isCubeRT) {
+				ret.Type = BindingDescriptor::BindType::TextureCube;
+				ret.Target = GL_TEXTURE_CUBE_MAP;
+			} else if (ret.Image3D != nullptr) {
+				ret.Type = BindingDescriptor::BindType::Texture3D;
+				ret.Target = GL_TEXTURE_3D;
+			} else if (ret.Plugin != nullptr) {
+				ret.Type = BindingDescriptor::BindType::Plugin;
+				ret.Target = 0;
+			} else if (audioTrack != 0) {
+				ret.ID = audioTrack;
+				ret.Type = BindingDescriptor::BindType::Texture2D;
+				ret.Target = GL_TEXTURE_BUFFER;
+			} else if (isAudio && m_audioArray != 0) {
+				// binding any of the packed audio objects binds all of them
+				ret.ID = m_audioArray;
+				ret.Type = BindingDescriptor::BindType::Texture2D;
+				ret.Target = GL_TEXTURE_2D_ARRAY;
+			} else if (isArray) {
+				ret.Type = BindingDescriptor::BindType::Texture2D;
+				ret.Target = GL_TEXTURE_2D_ARRAY;
+			} else {
+				ret.Type = BindingDescriptor::BindType::Texture2D;
+				ret.Target = GL_TEXTURE_2D;
+			}
+		}
+
+		return ret;
+	}
+
+	std::string ObjectManager::GetItemNameByTextureID(GLuint texID)
+	{
+		const IDIndex& index = m_getIDIndex();
+
+		ObjectManagerItem* item = m_findByID(index.Textures, texID);
+		if (item == nullptr)
+			item = m_findByID(index.Images, texID);
+		if (item == nullptr)
+			item = m_findByID(index.Images3D, texID);
+		if (item == nullptr)
+			item = m_findByID(index.Buffers, texID);
+
+		return item != nullptr ? GetObjectManagerItemName(item) : "";
+	}
+	glm::ivec2 ObjectManager::GetRenderTextureSize(const std::string & name)
+	{
+		RenderTextureObject* rt = GetRenderTexture(name);
+		return rt->CalculateSize(m_renderer->GetLastRenderSize().x, m_renderer->GetLastRenderSize().y);
+	}
+	const std::vector<std::string>& ObjectManager::GetCubemapTextures(const std::string& name)
+	{
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		if (item != nullptr)
+			return item->CubemapPaths;
+		return m_emptyCBTexs;
+	}
+
+	const std::vector<std::string>& ObjectManager::GetTextureArrayLayers(const std::string& name)
+	{
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		if (item != nullptr)
+			return item->ArrayPaths;
+		return m_emptyCBTexs;
+	}
+	bool ObjectManager::IsTextureArray(const std::string& name)
+	{
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		if (item != nullptr)
+			return item->IsTextureArray;
+		return false;
+	}
+	bool ObjectManager::IsRenderTexture(const std::string& name)
+	{
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		if (item != nullptr)
+			return item->RT != nullptr;
+		return false;
+	}
+	bool ObjectManager::IsCubeMap(const std::string& name)
+	{
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		if (item != nullptr)
+			return item->IsCube;
+		return false;
+	}
+	bool ObjectManager::IsAudio(const std::string& name)
+	{
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		if (item != nullptr)
+			return item->Sound != nullptr;
+		return false;
+	}
+	bool ObjectManager::IsAudioMuted(const std::string& name)
+	{
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		if (item != nullptr)
+			return item->SoundMuted;
+		return false;
+	}
+	bool ObjectManager::IsVideo(const std::string& name)
+	{
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		if (item != nullptr)
+			return item->Video != nullptr;
+		return false;
+	}
+	bool ObjectManager::IsCaptureDevice(const std::string& name)
+	{
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		if (item != nullptr)
+			return item->Video != nullptr && item->Video->Decoder->IsLive();
+		return false;
+	}
+	bool ObjectManager::IsVirtualTexture(const std::string& name)
+	{
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		if (item != nullptr)
+			return item->Virtual != nullptr;
+		return false;
+	}
+	bool ObjectManager::IsEnvironment(const std::string& name)
+	{
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		if (item != nullptr)
+			return item->Environment != nullptr;
+		return false;
+	}
+	bool ObjectManager::IsImageSequence(const std::string& name)
+	{
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		return item != nullptr && item->Sequence != nullptr;
+	}
+	bool ObjectManager::IsEnvironmentPart(const std::string& name)
+	{
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		return item != nullptr && item->EnvironmentOf != nullptr;
+	}
+	std::string ObjectManager::GetEnvironmentSource(const std::string& name)
+	{
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		if (item == nullptr || item->EnvironmentOf == nullptr)
+			return "";
+		return GetObjectManagerItemName(item->EnvironmentOf);
+	}
+	bool ObjectManager::HasTextureMipmaps(const std::string& name)
+	{
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		if (item != nullptr)
+			return item->Mipmaps;
+		return false;
+	}
+	bool ObjectManager::IsBuffer(const std::string& name)
+	{
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		if (item != nullptr)
+			return item->Buffer != nullptr;
+		return false;
+	}
+	bool ObjectManager::IsImage(const std::string& name)
+	{
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		if (item != nullptr)
+			return item->Image != nullptr;
 		return false;
 	}
 	bool ObjectManager::IsImage3D(const std::string& name)
 	{
-		for (int i = 0; i < m_items.size(); i++)
-			if (m_items[i] == name)
-				return m_itemData[i]->Image3D != nullptr;
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		if (item != nullptr)
+			return item->Image3D != nullptr;
 		return false;
 	}
 	bool ObjectManager::IsPluginObject(const std::string& name)
 	{
-		for (int i = 0; i < m_items.size(); i++)
-			if (m_items[i] == name)
-				return m_itemData[i]->Plugin != nullptr;
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		if (item != nullptr)
+			return item->Plugin != nullptr;
 		return false;
 	}
 	bool ObjectManager::IsPluginObject(GLuint id)
 	{
-		for (int i = 0; i < m_items.size(); i++)
-			if (m_itemData[i]->Plugin != nullptr && m_itemData[i]->Plugin->ID == id)
-				return true;
-		return false;
+		return m_findByID(m_getIDIndex().Plugins, id) != nullptr;
 	}
 	bool ObjectManager::IsCubeMap(GLuint id)
 	{
-		for (const auto& i : m_itemData)
-			if (i->Texture == id)
-				return i->IsCube;
-		return false;
+		ObjectManagerItem* item = m_findByID(m_getIDIndex().Textures, id);
+		return item != nullptr && item->IsCube;
 	}
 	bool ObjectManager::IsImage(GLuint id)
 	{
-		for (const auto& i : m_itemData)
-			if (i->Image != nullptr && i->Image->Texture == id)
-				return true;
-		return false;
+		return m_findByID(m_getIDIndex().Images, id) != nullptr;
 	}
 	bool ObjectManager::IsImage3D(GLuint id)
 	{
-		for (const auto& i : m_itemData)
-			if (i->Image3D != nullptr && i->Image3D->Texture == id)
-				return true;
-		return false;
+		return m_findByID(m_getIDIndex().Images3D, id) != nullptr;
+	}
+	bool ObjectManager::IsAudio(GLuint id)
+	{
+		ObjectManagerItem* item = m_findByID(m_getIDIndex().Textures, id);
+		return item != nullptr && item->Sound != nullptr;
 	}
 
 	GLuint ObjectManager::GetTexture(const std::string& file)
 	{
-		for (int i = 0; i < m_items.size(); i++)
-			if (m_items[i] == file)
-				return m_itemData[i]->Texture;
+		ObjectManagerItem* item = GetObjectManagerItem(file);
+		if (item != nullptr)
+			return item->Texture;
 		return 0;
 	}
 	GLuint ObjectManager::GetFlippedTexture(const std::string& file)
 	{
-		for (int i = 0; i < m_items.size(); i++)
-			if (m_items[i] == file)
-				return m_itemData[i]->FlippedTexture;
-		return 0;
+		ObjectManagerItem* item = GetObjectManagerItem(file);
+		if (item == nullptr)
+			return 0;
+		if (!item->IsTexture)
+			return item->Texture;
+
+		// only the plugins use it - copied on the GPU on the first request & whenever the texture changed since then
+		if (item->FlippedTexture != 0 && item->FlippedGeneration == item->Generation)
+			return item->FlippedTexture;
+
+		GLint width = 0, height = 0, compressed = 0;
+		glBindTexture(GL_TEXTURE_2D, item->Texture);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED, &compressed);
+
+		// compressed textures can't be attached to a framebuffer
+		if (compressed) {
+			glBindTexture(GL_TEXTURE_2D, 0);
+			return item->Texture;
+		}
+
+		if (item->FlippedTexture == 0) {
+			glGenTextures(1, &item->FlippedTexture);
+			glBindTexture(GL_TEXTURE_2D, item->FlippedTexture);
+			gl::SetObjectLabel(GL_TEXTURE, item->FlippedTexture, file + " (flipped)");
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		} else
+			glBindTexture(GL_TEXTURE_2D, item->FlippedTexture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		GLint lastRead = 0, lastDraw = 0;
+		glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &lastRead);
+		glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &lastDraw);
+
+		GLuint fbos[2];
+		glGenFramebuffers(2, fbos);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, fbos[0]);
+		glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, item->Texture, 0);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbos[1]);
+		glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, item->FlippedTexture, 0);
+		glBlitFramebuffer(0, 0, width, height, 0, height, width, 0, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, lastRead);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, lastDraw);
+		glDeleteFramebuffers(2, fbos);
+
+		applyMipmaps(item->FlippedTexture, item->Mipmaps);
+		item->FlippedGeneration = item->Generation;
+
+		return item->FlippedTexture;
 	}
 	glm::ivec2 ObjectManager::GetTextureSize(const std::string& file)
 	{
-		for (int i = 0; i < m_items.size(); i++)
-			if (m_items[i] == file)
-				return m_itemData[i]->ImageSize;
+		ObjectManagerItem* item = GetObjectManagerItem(file);
+		if (item != nullptr)
+			return item->ImageSize;
 		return glm::ivec2(0,0);
 	}
-	sf::SoundBuffer* ObjectManager::GetSoundBuffer(const std::string& file)
+	const float* ObjectManager::GetAudioData(const std::string& file)
 	{
-		for (int i = 0; i < m_items.size(); i++)
-			if (m_items[i] == file)
-				return m_itemData[i]->SoundBuffer;
-		return nullptr;
+		ObjectManagerItem* item = GetObjectManagerItem(file);
+		if (item == nullptr || item->Sound == nullptr)
+			return nullptr;
+
+		m_updateAudioData(item);
+		return item->SoundData.data();
+	}
+	int ObjectManager::GetAudioLayer(const std::string& file)
+	{
+		ObjectManagerItem* item = GetObjectManagerItem(file);
+		if (item != nullptr)
+			return item->SoundLayer;
+		return -1;
+	}
+	int ObjectManager::GetAudioTrackRate(const std::string& file)
+	{
+		ObjectManagerItem* item = GetObjectManagerItem(file);
+		if (item != nullptr && item->SoundTrackTexture != 0)
+			return item->SoundTrackRate;
+		return -1;
 	}
-	sf::Sound* ObjectManager::GetAudioPlayer(const std::string& file)
+	AudioTrack* ObjectManager::GetAudioPlayer(const std::string& file)
 	{
-		for (int i = 0; i < m_items.size(); i++)
-			if (m_items[i] == file)
-				return m_itemData[i]->Sound;
+		ObjectManagerItem* item = GetObjectManagerItem(file);
+		if (item != nullptr)
+			return item->Sound;
 		return nullptr;
 	}
 	BufferObject* ObjectManager::GetBuffer(const std::string& name)
 	{
-		for (int i = 0; i < m_items.size(); i++)
-			if (m_items[i] == name)
-				return m_itemData[i]->Buffer;
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		if (item != nullptr)
+			return item->Buffer;
 		return nullptr;
 	}
+	void ObjectManager::UploadBuffer(BufferObject* buf, eng::MappedFile& file, const std::string& path)
+	{
+		free(buf->Data);
+		buf->Data = nullptr;
+		buf->File = path;
+		buf->Fill = GPUFill::Operation();
+
+		glBindBuffer(GL_UNIFORM_BUFFER, buf->ID);
+		glBufferData(GL_UNIFORM_BUFFER, buf->Size, nullptr, GL_STATIC_DRAW);
+
+		// in chunks so that the driver doesn't need a staging copy of the whole file
+		size_t size = std::min<size_t>(buf->Size, file.GetSize());
+		for (size_t offset = 0; offset < size; offset += BUFFER_UPLOAD_CHUNK)
+			glBufferSubData(GL_UNIFORM_BUFFER, offset, std::min<size_t>(BUFFER_UPLOAD_CHUNK, size - offset), file.GetData() + offset);
+
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	}
+	void* ObjectManager::FetchBufferData(BufferObject* buf)
+	{
+		if (buf->Data != nullptr || buf->Size <= 0)
+			return buf->Data;
+
+		buf->Data = malloc(buf->Size);
+
+		glBindBuffer(GL_UNIFORM_BUFFER, buf->ID);
+		glGetBufferSubData(GL_UNIFORM_BUFFER, 0, buf->Size, buf->Data);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+		return buf->Data;
+	}
+	void ObjectManager::MarkBufferDirty(BufferObject* buf, int offset, int size)
+	{
+		int end = std::min(offset + size, buf->Size);
+		if (offset < 0 || offset >= end)
+			return;
+
+		buf->Dirty.push_back(std::make_pair(offset, end));
+		buf->Fill = GPUFill::Operation(); // the edited contents have to be saved
+	}
+	void ObjectManager::FlushBuffer(BufferObject* buf, const void* data, int dataOffset)
+	{
+		if (data == nullptr) {
+			data = buf->Data;
+			dataOffset = 0;
+		}
+
+		if (buf->Dirty.empty() || data == nullptr) {
+			buf->Dirty.clear();
+			return;
+		}
+
+		std::sort(buf->Dirty.begin(), buf->Dirty.end());
+
+		glBindBuffer(GL_UNIFORM_BUFFER, buf->ID);
+
+		std::pair<int, int> range = buf->Dirty[0];
+		for (size_t i = 1; i <= buf->Dirty.size(); i++) {
+			if (i < buf->Dirty.size() && buf->Dirty[i].first <= range.second) {
+				range.second = std::max(range.second, buf->Dirty[i].second);
+				continue;
+			}
+
+			glBufferSubData(GL_UNIFORM_BUFFER, range.first, range.second - range.first, (const char*)data + (range.first - dataOffset));
+
+			if (i < buf->Dirty.size())
+				range = buf->Dirty[i];
+		}
+
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+		buf->Dirty.clear();
+	}
+	bool ObjectManager::FillBuffer(const std::string& name, const GPUFill::Operation& op)
+	{
+		BufferObject* buf = GetBuffer(name);
+		if (buf == nullptr)
+			return false;
+
+		GLuint src = 0;
+		int srcSize = 0;
+		if (op.Op == GPUFill::Operator::Copy) {
+			BufferObject* srcBuf = GetBuffer(op.Source);
+			if (srcBuf != nullptr) {
+				src = srcBuf->ID;
+				srcSize = srcBuf->Size;
+			}
+		}
+
+		if (!GPUFill::Instance().FillBuffer(buf->ID, buf->Size, op, src, srcSize)) {
+			Logger::Get().Log("Failed to fill the buffer " + name, true);
+			return false;
+		}
+
+		// the contents only live on the GPU now
+		free(buf->Data);
+		buf->Data = nullptr;
+		buf->File.clear();
+		buf->Dirty.clear();
+		buf->Fill = op;
+
+		m_parser->ModifyProject();
+		m_markChanged(GetObjectManagerItem(name));
+		if (m_renderer != nullptr)
+			m_renderer->InvalidatePassCache();
+
+		return true;
+	}
+	bool ObjectManager::FillImage(const std::string& name, const GPUFill::Operation& op)
+	{
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		if (item == nullptr || (item->Image == nullptr && item->Image3D == nullptr))
+			return false;
+
+		// copies read a 2D texture
+		GLuint src = 0;
+		ObjectManagerItem* srcItem = op.Op == GPUFill::Operator::Copy ? GetObjectManagerItem(op.Source) : nullptr;
+		if (srcItem != nullptr && srcItem->Image != nullptr)
+			src = srcItem->Image->Texture;
+		else if (srcItem != nullptr && srcItem->RT != nullptr && !srcItem->RT->IsLayered())
+			src = srcItem->Texture;
+		else if (srcItem != nullptr && srcItem->IsTexture && !srcItem->IsCube && !srcItem->IsTextureArray)
+			src = srcItem->Texture;
+
+		bool filled = false;
+		if (item->Image != nullptr)
+			filled = GPUFill::Instance().FillTexture(item->Image->Texture, GL_TEXTURE_2D, item->Image->Format, glm::ivec3(item->Image->Size, 1), op, src);
+		else {
+			// the generated contents replace the slice files
+			m_cancelSlices(item);
+			item->Image3D->SlicePaths.clear();
+			filled = GPUFill::Instance().FillTexture(item->Image3D->Texture, GL_TEXTURE_3D, item->Image3D->Format, item->Image3D->Size, op, src);
+		}
+
+		if (!filled) {
+			Logger::Get().Log("Failed to fill the image " + name, true);
+			return false;
+		}
+
+		if (item->Image != nullptr)
+			item->Image->Fill = op;
+		else
+			item->Image3D->Fill = op;
+
+		m_parser->ModifyProject();
+		m_markChanged(item);
+		if (m_renderer != nullptr)
+			m_renderer->InvalidatePassCache();
+
+		return true;
+	}
+	bool ObjectManager::ReadBufferAsync(const std::string& name, int offset, int size)
+	{
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		if (item == nullptr || item->Buffer == nullptr || m_writeMaps.count(item))
+			return false;
+
+		BufferObject* buf = item->Buffer;
+		if (offset < 0 || size <= 0 || offset + size > buf->Size)
+			return false;
+
+		FlushBuffer(buf); // edits that weren't uploaded yet
+
+		Readback& rb = m_beginReadback(item, size);
+		glBindBuffer(GL_COPY_READ_BUFFER, buf->ID);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, rb.Buffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, offset, 0, size);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+		rb.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+		return true;
+	}
+	bool ObjectManager::ReadImageAsync(const std::string& name, int x, int y, int width, int height)
+	{
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		if (item == nullptr || item->IsCube || item->Image3D != nullptr || item->Buffer != nullptr || item->Plugin != nullptr)
+			return false;
+
+		GLuint tex = item->Image != nullptr ? item->Image->Texture : item->Texture;
+		if (tex == 0)
+			return false;
+
+		// the size of the render textures depends on the preview
+		GLint texWidth = 0, texHeight = 0;
+		glBindTexture(GL_TEXTURE_2D, tex);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &texWidth);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &texHeight);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		if (x < 0 || y < 0 || width <= 0 || height <= 0 || x + width > texWidth || y + height > texHeight)
+			return false;
+
+		if (m_readbackFBO == 0)
+			glGenFramebuffers(1, &m_readbackFBO);
+
+		Readback& rb = m_beginReadback(item, width * height * 4 * sizeof(float));
+
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, m_readbackFBO);
+		glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex, 0);
+		glReadBuffer(GL_COLOR_ATTACHMENT0);
+
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, rb.Buffer);
+		glReadPixels(x, y, width, height, GL_RGBA, GL_FLOAT, nullptr);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+		rb.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+		return true;
+	}
+	const void* ObjectManager::MapReadback(const std::string& name, int& size)
+	{
+		size = 0;
+
+		auto it = m_readbacks.find(GetObjectManagerItem(name));
+		if (it == m_readbacks.end())
+			return nullptr;
+
+		Readback& rb = it->second;
+		if (rb.Size == 0)
+			return nullptr;
+
+		if (rb.Fence != 0) {
+			GLenum status = glClientWaitSync(rb.Fence, 0, 0);
+			if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+				return nullptr;
+
+			glDeleteSync(rb.Fence);
+			rb.Fence = 0;
+		}
+
+		if (rb.Mapped == nullptr) {
+			glBindBuffer(GL_COPY_READ_BUFFER, rb.Buffer);
+			rb.Mapped = glMapBufferRange(GL_COPY_READ_BUFFER, 0, rb.Size, GL_MAP_READ_BIT);
+			glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		}
+
+		if (rb.Mapped != nullptr)
+			size = rb.Size;
+
+		return rb.Mapped;
+	}
+	void* ObjectManager::MapBufferWrite(const std::string& name, int offset, int size)
+	{
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		if (item == nullptr || item->Buffer == nullptr || m_writeMaps.count(item))
+			return nullptr;
+
+		BufferObject* buf = item->Buffer;
+		if (offset < 0 || size <= 0 || offset + size > buf->Size)
+			return nullptr;
+
+		FlushBuffer(buf);
+
+		glBindBuffer(GL_COPY_WRITE_BUFFER, buf->ID);
+		void* ret = glMapBufferRange(GL_COPY_WRITE_BUFFER, offset, size, GL_MAP_WRITE_BIT | GL_MAP_FLUSH_EXPLICIT_BIT);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+		if (ret == nullptr)
+			return nullptr;
+
+		// the GPU has the only up to date copy now - it's read back if it's needed (and saved with the project instead of the file)
+		free(buf->Data);
+		buf->Data = nullptr;
+		buf->File.clear();
+		buf->Dirty.clear();
+		m_parser->ModifyProject();
+
+		m_writeMaps[item] = offset;
+
+		return ret;
+	}
+	void ObjectManager::FlushBufferWrite(const std::string& name, int offset, int size)
+	{
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		if (item == nullptr || m_writeMaps.count(item) == 0 || offset < 0 || size <= 0)
+			return;
+
+		glBindBuffer(GL_COPY_WRITE_BUFFER, item->Buffer->ID);
+		glFlushMappedBufferRange(GL_COPY_WRITE_BUFFER, offset, size);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	}
+	void ObjectManager::Unmap(const std::string& name)
+	{
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		if (item != nullptr)
+			m_releaseMappings(item, false);
+	}
+	ObjectManager::Readback& ObjectManager::m_beginReadback(ObjectManagerItem* item, int size)
+	{
+		auto it = m_readbacks.find(item);
+		if (it == m_readbacks.end()) {
+			Readback rb;
+			rb.Buffer = 0;
+			rb.Capacity = rb.Size = 0;
+			rb.Fence = 0;
+			rb.Mapped = nullptr;
+			it = m_readbacks.insert(std::make_pair(item, rb)).first;
+		}
+
+		Readback& rb = it->second;
+		if (rb.Buffer == 0)
+			glGenBuffers(1, &rb.Buffer);
+
+		glBindBuffer(GL_COPY_WRITE_BUFFER, rb.Buffer);
+		if (rb.Mapped != nullptr) {
+			glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+			rb.Mapped = nullptr;
+		}
+		if (rb.Capacity < size) {
+			glBufferData(GL_COPY_WRITE_BUFFER, size, nullptr, GL_STREAM_READ);
+			rb.Capacity = size;
+		}
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+		if (rb.Fence != 0) {
+			glDeleteSync(rb.Fence);
+			rb.Fence = 0;
+		}
+		rb.Size = size;
+
+		return rb;
+	}
+	void ObjectManager::m_releaseMappings(ObjectManagerItem* item, bool destroy)
+	{
+		for (auto it = m_writeMaps.begin(); it != m_writeMaps.end();) {
+			if (item != nullptr && it->first != item) {
+				++it;
+				continue;
+			}
+
+			glBindBuffer(GL_COPY_WRITE_BUFFER, it->first->Buffer->ID);
+			glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+			it = m_writeMaps.erase(it);
+		}
+
+		for (auto it = m_readbacks.begin(); it != m_readbacks.end();) {
+			if (item != nullptr && it->first != item) {
+				++it;
+				continue;
+			}
+
+			Readback& rb = it->second;
+			if (!destroy) {
+				if (rb.Mapped != nullptr) {
+					glBindBuffer(GL_COPY_READ_BUFFER, rb.Buffer);
+					glUnmapBuffer(GL_COPY_READ_BUFFER);
+					glBindBuffer(GL_COPY_READ_BUFFER, 0);
+					rb.Mapped = nullptr;
+					rb.Size = 0; // nothing to map until the next read
+				}
+				++it;
+				continue;
+			}
+
+			if (rb.Fence != 0)
+				glDeleteSync(rb.Fence);
+			glDeleteBuffers(1, &rb.Buffer); // also unmaps it
+			it = m_readbacks.erase(it);
+		}
+	}
 	ImageObject* ObjectManager::GetImage(const std::string& name)
 	{
-		for (int i = 0; i < m_items.size(); i++)
-			if (m_items[i] == name)
-				return m_itemData[i]->Image;
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		if (item != nullptr)
+			return item->Image;
 		return nullptr;
 	}
 	Image3DObject* ObjectManager::GetImage3D(const std::string& name)
 	{
-		for (int i = 0; i < m_items.size(); i++)
-			if (m_items[i] == name)
-				return m_itemData[i]->Image3D;
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		if (item != nullptr)
+			return item->Image3D;
 		return nullptr;
 	}
 	glm::ivec2 ObjectManager::GetImageSize(const std::string& name)
 	{
-		for (int i = 0; i < m_items.size(); i++)
-			if (m_items[i] == name)
-				return m_itemData[i]->Image->Size;
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		if (item != nullptr)
+			return item->Image->Size;
 		return glm::ivec2(0,0);
 	}
 	glm::ivec3 ObjectManager::GetImage3DSize(const std::string& name)
 	{
-		for (int i = 0; i < m_items.size(); i++)
-			if (m_items[i] == name)
-				return m_itemData[i]->Image3D->Size;
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		if (item != nullptr)
+			return item->Image3D->Size;
 		return glm::ivec3(0, 0, 0);
 	}
 	RenderTextureObject* ObjectManager::GetRenderTexture(const std::string& name)
 	{
-		for (int i = 0; i < m_items.size(); i++)
-			if (m_items[i] == name)
-				return m_itemData[i]->RT;
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		if (item != nullptr)
+			return item->RT;
+		return nullptr;
+	}
+	VideoObject* ObjectManager::GetVideo(const std::string& name)
+	{
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		if (item != nullptr)
+			return item->Video;
+		return nullptr;
+	}
+	VirtualTexture* ObjectManager::GetVirtualTexture(const std::string& name)
+	{
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		if (item != nullptr)
+			return item->Virtual;
+		return nullptr;
+	}
+	EnvironmentMap* ObjectManager::GetEnvironment(const std::string& name)
+	{
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		if (item != nullptr)
+			return item->Environment;
+		return nullptr;
+	}
+	ImageSequence* ObjectManager::GetImageSequence(const std::string& name)
+	{
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		if (item != nullptr)
+			return item->Sequence;
 		return nullptr;
 	}
 	PluginObject* ObjectManager::GetPluginObject(const std::string& name)
 	{
-		for (int i = 0; i < m_items.size(); i++)
-			if (m_items[i] == name)
-				return m_itemData[i]->Plugin;
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		if (item != nullptr)
+			return item->Plugin;
 		return nullptr;
 	}
 	PluginObject* ObjectManager::GetPluginObject(GLuint id)
 	{
-		for (int i = 0; i < m_items.size(); i++)
-			if (m_itemData[i]->Plugin != nullptr && m_itemData[i]->Plugin->ID == id)
-				return m_itemData[i]->Plugin;
-		return nullptr;
+		ObjectManagerItem* item = m_findByID(m_getIDIndex().Plugins, id);
+		return item != nullptr ? item->Plugin : nullptr;
 	}
 
 	RenderTextureObject* ObjectManager::GetRenderTexture(GLuint tex)
 	{
-		for (const auto& i : m_itemData)
-			if (i->Texture == tex)
-				return i->RT;
-		return nullptr;
+		ObjectManagerItem* item = m_findByID(m_getIDIndex().Textures, tex);
+		return item != nullptr ? item->RT : nullptr;
 	}
 	std::string ObjectManager::GetBufferNameByID(int id)
 	{
-		for (int i = 0; i < m_itemData.size(); i++)
-			if (m_itemData[i]->Buffer != nullptr && m_itemData[i]->Buffer->ID == id)
-				return m_items[i];
-		return "";
+		ObjectManagerItem* item = m_findByID(m_getIDIndex().Buffers, id);
+		return item != nullptr ? GetObjectManagerItemName(item) : "";
 	}
 	std::string ObjectManager::GetImageNameByID(GLuint id)
 	{
-		for (int i = 0; i < m_itemData.size(); i++)
-			if (m_itemData[i]->Image != nullptr && m_itemData[i]->Image->Texture == id)
-				return m_items[i];
-		return "";
+		ObjectManagerItem* item = m_findByID(m_getIDIndex().Images, id);
+		return item != nullptr ? GetObjectManagerItemName(item) : "";
 	}
 	std::string ObjectManager::GetImage3DNameByID(GLuint id)
 	{
-		for (int i = 0; i < m_itemData.size(); i++)
-			if (m_itemData[i]->Image3D != nullptr && m_itemData[i]->Image3D->Texture == id)
-				return m_items[i];
-		return "";
+		ObjectManagerItem* item = m_findByID(m_getIDIndex().Images3D, id);
+		return item != nullptr ? GetObjectManagerItemName(item) : "";
 	}
 
 	ObjectManagerItem* ObjectManager::GetObjectManagerItem(const std::string& name)
 	{
-		for (int i = 0; i < m_items.size(); i++)
-			if (m_items[i] == name)
-				return m_itemData[i];
+		auto it = m_itemIndex.find(name);
+		if (it != m_itemIndex.end())
+			return it->second;
 		return nullptr;
 	}
 	std::string ObjectManager::GetObjectManagerItemName(ObjectManagerItem* item)
 	{
-		for (int i = 0; i < m_itemData.size(); i++)
-			if (m_itemData[i] == item)
-				return m_items[i];
+		const IDIndex& index = m_getIDIndex();
+		auto it = index.Names.find(item);
+		if (it != index.Names.end())
+			return m_items[it->second];
 		return "";
 	}
+	void ObjectManager::m_addItem(const std::string& name, ObjectManagerItem* item)
+	{
+		m_itemData.push_back(item);
+		m_items.push_back(name);
+		m_itemIndex[name] = item;
+		m_idIndexValid = false;
+		m_markChanged(item);
+	}
+	const ObjectManager::IDIndex& ObjectManager::m_getIDIndex()
+	{
+		if (m_idIndexValid)
+			return m_idIndex;
+
+		// GL ids are only assigned while an object is created so the index is rebuilt after adding or removing objects
+		m_idIndex.Textures.clear();
+		m_idIndex.Images.clear();
+		m_idIndex.Images3D.clear();
+		m_idIndex.Buffers.clear();
+		m_idIndex.Plugins.clear();
+		m_idIndex.Names.clear();
+		for (int i = 0; i < m_itemData.size(); i++) {
+			ObjectManagerItem* item = m_itemData[i];
+			if (item->Texture != 0)
+				m_idIndex.Textures.emplace(item->Texture, item);
+			if (item->Image != nullptr)
+				m_idIndex.Images.emplace(item->Image->Texture, item);
+			if (item->Image3D != nullptr)
+				m_idIndex.Images3D.emplace(item->Image3D->Texture, item);
+			if (item->Buffer != nullptr)
+				m_idIndex.Buffers.emplace(item->Buffer->ID, item);
+			if (item->Plugin != nullptr)
+				m_idIndex.Plugins.emplace(item->Plugin->ID, item);
+			m_idIndex.Names.emplace(item, i);
+		}
+		m_idIndexValid = true;
+
+		return m_idIndex;
+	}
+	ObjectManagerItem* ObjectManager::m_findByID(const std::unordered_map<GLuint, ObjectManagerItem*>& ids, GLuint id)
+	{
+		auto it = ids.find(id);
+		if (it != ids.end())
+			return it->second;
+		return nullptr;
+	}
 
 	void ObjectManager::Mute(const std::string& name)
 	{
-		for (int i = 0; i < m_items.size(); i++) {
-			if (m_items[i] == name) {
-				m_itemData[i]->SoundMuted = true;
-				m_itemData[i]->Sound->setVolume(0);
-				break;
-			}
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		if (item != nullptr) {
+			item->SoundMuted = true;
+			item->Sound->SetVolume(0);
 		}
 	}
 	void ObjectManager::Unmute(const std::string& name)
+	{
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		if (item != nullptr) {
+			item->SoundMuted = false;
+			item->Sound->SetVolume(100);
+		}
+	}
+	bool ObjectManager::SetAudioTrack(const std::string& name, int rate)
+	{
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		if (item == nullptr || item->Sound == nullptr)
+			return false;
+		if (item->SoundTrackTexture != 0 && item->SoundTrackRate == rate)
+			return true;
+
+		if (item->SoundTrackTexture != 0) {
+			glDeleteTextures(1, &item->SoundTrackTexture);
+			glDeleteBuffers(1, &item->SoundTrackBuffer);
+			item->SoundTrackTexture = item->SoundTrackBuffer = 0;
+			item->SoundTrackLength = 0;
+			item->SoundSample = -1; // the 2D texture wasn't updated in the meantime
+		}
+		item->SoundTrackRate = -1;
+
+		if (rate >= 0) {
+			std::vector<float> data;
+			if (!item->Sound->ReadTrack(rate, data)) {
+				ed::Logger::Get().Log("Failed to decode the whole track of " + name, true);
+				rate = -1;
+			} else {
+				GLint maxTexels = 0;
+				glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+				if (data.size() > (size_t)maxTexels) {
+					ed::Logger::Get().Log("The whole track of " + name + " has " + std::to_string(data.size()) + " values, the GPU's buffer textures are limited to " + std::to_string(maxTexels) + " - use an envelope", true);
+					rate = -1;
+				}
+			}
+
+			if (rate >= 0) {
+				glGenBuffers(1, &item->SoundTrackBuffer);
+				glBindBuffer(GL_TEXTURE_BUFFER, item->SoundTrackBuffer);
+				glBufferData(GL_TEXTURE_BUFFER, data.size() * sizeof(float), data.data(), GL_STATIC_DRAW);
+				glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+				glGenTextures(1, &item->SoundTrackTexture);
+				glBindTexture(GL_TEXTURE_BUFFER, item->SoundTrackTexture);
+				glTexBuffer(GL_TEXTURE_BUFFER, GL_R32F, item->SoundTrackBuffer);
+				glBindTexture(GL_TEXTURE_BUFFER, 0);
+				gl::SetObjectLabel(GL_TEXTURE, item->SoundTrackTexture, name);
+
+				item->SoundTrackRate = rate;
+				item->SoundTrackLength = (int)data.size();
+			}
+		}
+
+		m_invalidateBindTables();
+		m_parser->ModifyProject();
+
+		return rate >= 0;
+	}
+	void ObjectManager::SetCaptureQueueDepth(const std::string& name, int depth)
+	{
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		if (item == nullptr || item->Video == nullptr || !item->Video->Decoder->IsLive() || item->Video->Decoder->GetQueueDepth() == depth)
+			return;
+
+		// the device has to be reopened to resize the queue
+		if (!item->Video->Decoder->OpenDevice(name, depth))
+			return;
+
+		if (item->Video->Decoder->GetSize() != item->ImageSize)
+			m_allocateVideoStorage(item);
+		else
+			item->Video->FramePTS = -1.0;
+
+		m_parser->ModifyProject();
+	}
+	void ObjectManager::SetTextureMipmaps(const std::string& name, bool mipmaps)
 	{
 		for (int i = 0; i < m_items.size(); i++) {
 			if (m_items[i] == name) {
-				m_itemData[i]->SoundMuted = false;
-				m_itemData[i]->Sound->setVolume(100);
+				ObjectManagerItem* item = m_itemData[i];
+				if ((!item->IsTexture && !item->IsTextureArray) || item->Mipmaps == mipmaps || (item->IsTexture && eng::CompressedTexture::IsSupportedFile(name)))
+					break;
+
+				if (item->BindlessHandle != 0) {
+					Logger::Get().Log("Cannot change the mipmaps of " + name + " because it already has a bindless handle - turn off the bindless texture table and reopen the project first", true);
+					break;
+				}
+
+				item->Mipmaps = mipmaps;
+				m_parser->ModifyProject();
+
+				// textures that are still loading pick this up once they are uploaded
+				bool loading = false;
+				for (const auto& job : m_loadJobs)
+					if (job->Item == item)
+						loading = true;
+
+				if (!loading) {
+					applyMipmaps(item->Texture, mipmaps, item->IsTextureArray ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D); // the flipped copy is redone on the next request
+					if (m_renderer != nullptr)
+						m_renderer->InvalidatePassCache();
+					m_markChanged(item);
+				}
 				break;
 			}
 		}
@@ -965,19 +2970,192 @@ namespace ed
 		if (rtObj->RatioSize.x == -1 && rtObj->RatioSize.y == -1)
 			m_parser->ModifyProject();
 
-		glBindTexture(GL_TEXTURE_2D, GetTexture(name));
-		glTexImage2D(GL_TEXTURE_2D, 0, rtObj->Format, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		allocateRenderTexture(item->Texture, rtObj, size);
+		m_markChanged(item);
 
-		glBindTexture(GL_TEXTURE_2D, rtObj->DepthStencilBuffer);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, size.x, size.y, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
-		glBindTexture(GL_TEXTURE_2D, 0);
+		if (item->History != nullptr) {
+			allocateRenderTexture(item->History->Texture, rtObj, size);
+			item->History->ImageSize = size;
+			m_markChanged(item->History);
+		}
+	}
+	void ObjectManager::SetRenderTextureLayers(const std::string& name, int layers, bool cubemap)
+	{
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		if (item == nullptr || item->RT == nullptr)
+			return;
+
+		RenderTextureObject* rtObj = item->RT;
+		layers = std::max(layers, 1);
+		if (rtObj->Layers == layers && rtObj->Cubemap == cubemap)
+			return;
+
+		m_parser->ModifyProject();
 
-		glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, rtObj->BufferMS);
-		glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, Settings::Instance().Preview.MSAA, rtObj->Format, size.x, size.y, true);
+		GLenum oldTarget = rtObj->GetTarget();
+		rtObj->Layers = layers;
+		rtObj->Cubemap = cubemap;
+
+		// a texture can't be bound to another target - the passes, bind lists & samplers get the new one
+		GLenum target = rtObj->GetTarget();
+		if (target != oldTarget) {
+			GLuint oldTexture = item->Texture;
+
+			glGenTextures(1, &item->Texture);
+			glBindTexture(target, item->Texture);
+			gl::SetObjectLabel(GL_TEXTURE, item->Texture, name);
+			glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glBindTexture(target, 0);
+			glDeleteTextures(1, &oldTexture);
+			m_replaceBinds(oldTexture, item->Texture, false);
+
+			if (item->History != nullptr) {
+				GLuint oldHistory = item->History->Texture;
+
+				glGenTextures(1, &item->History->Texture);
+				glBindTexture(target, item->History->Texture);
+				gl::SetObjectLabel(GL_TEXTURE, item->History->Texture, name + RT_HISTORY_SUFFIX);
+				glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+				glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+				glBindTexture(target, 0);
+				glDeleteTextures(1, &oldHistory);
+				m_replaceBinds(oldHistory, item->History->Texture, false);
+			}
+			m_invalidateBindTables();
+			m_idIndexValid = false;
+
+			if (m_renderer != nullptr)
+				m_renderer->ReplaceRenderTexture(oldTexture, item->Texture);
+		}
+
+		ResizeRenderTexture(name, GetRenderTextureSize(name));
+
+		if (m_renderer != nullptr)
+			m_renderer->InvalidatePassCache();
+	}
+	bool ObjectManager::SetRenderTextureHistory(const std::string& name, bool history)
+	{
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		if (item == nullptr || item->RT == nullptr)
+			return false;
+		if ((item->History != nullptr) == history)
+			return true;
+
+		std::string historyName = name + RT_HISTORY_SUFFIX;
+		if (!history) {
+			Remove(historyName);
+			return true;
+		}
+
+		if (Exists(historyName)) {
+			Logger::Get().Log("Cannot keep the last frame of " + name + " because an object called " + historyName + " already exists", true);
+			return false;
+		}
+
+		m_parser->ModifyProject();
+
+		ObjectManagerItem* prev = new ObjectManagerItem();
+		prev->HistoryOf = item;
+		item->History = prev;
+		m_addItem(historyName, prev);
+
+		GLenum target = item->RT->GetTarget();
+		glGenTextures(1, &prev->Texture);
+		glBindTexture(target, prev->Texture);
+		gl::SetObjectLabel(GL_TEXTURE, prev->Texture, historyName);
+		glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glBindTexture(target, 0);
+
+		prev->ImageSize = GetRenderTextureSize(name);
+		allocateRenderTexture(prev->Texture, item->RT, prev->ImageSize);
+
+		if (m_renderer != nullptr)
+			m_renderer->InvalidatePassCache();
+
+		return true;
+	}
+	bool ObjectManager::HasRenderTextureHistory(const std::string& name)
+	{
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		return item != nullptr && item->History != nullptr;
+	}
+	bool ObjectManager::IsRenderTextureHistory(const std::string& name)
+	{
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		return item != nullptr && item->HistoryOf != nullptr;
+	}
+	bool ObjectManager::IsRenderTextureHistory(GLuint id)
+	{
+		ObjectManagerItem* item = m_findByID(m_getIDIndex().Textures, id);
+		return item != nullptr && item->HistoryOf != nullptr;
+	}
+	std::string ObjectManager::GetRenderTextureHistorySource(const std::string& name)
+	{
+		ObjectManagerItem* item = GetObjectManagerItem(name);
+		if (item == nullptr || item->HistoryOf == nullptr)
+			return "";
+		return GetObjectManagerItemName(item->HistoryOf);
+	}
+	void ObjectManager::SwapRenderTextureHistory()
+	{
+		for (ObjectManagerItem* item : m_itemData) {
+			ObjectManagerItem* history = item->History;
+			if (history == nullptr)
+				continue;
+
+			// no copy - the passes draw to the old storage of the history & everything that sampled one samples the other
+			GLuint cur = item->Texture, prev = history->Texture;
+			item->Texture = prev;
+			history->Texture = cur;
+			m_replaceBinds(cur, prev, true);
+
+			// the bind tables notice the new IDs themselves
+			if (m_idIndexValid) {
+				m_idIndex.Textures[item->Texture] = item;
+				m_idIndex.Textures[history->Texture] = history;
+			}
 
-		glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, rtObj->DepthStencilBufferMS);
-		glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, Settings::Instance().Preview.MSAA, GL_DEPTH24_STENCIL8, size.x, size.y, true);
-		glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
+			m_markChanged(item);
+			m_markChanged(history);
+
+			if (m_renderer != nullptr)
+				m_renderer->SwapRenderTexture(cur, prev);
+		}
+	}
+	void ObjectManager::m_replaceBinds(GLuint oldID, GLuint newID, bool swap)
+	{
+		auto replace = [&](std::vector<GLuint>& ids) {
+			for (GLuint& id : ids) {
+				if (id == oldID)
+					id = newID;
+				else if (swap && id == newID)
+					id = oldID;
+			}
+		};
+		for (auto& binds : m_binds)
+			replace(binds.second);
+		for (auto& binds : m_uniformBinds)
+			replace(binds.second);
+
+		for (auto& samplers : m_samplers) {
+			auto oldState = samplers.second.find(oldID);
+			auto newState = swap ? samplers.second.find(newID) : samplers.second.end();
+			bool hasOld = oldState != samplers.second.end(), hasNew = newState != samplers.second.end();
+
+			SamplerState oldCopy = hasOld ? oldState->second : SamplerState();
+			SamplerState newCopy = hasNew ? newState->second : SamplerState();
+			if (hasOld)
+				samplers.second.erase(oldID);
+			if (hasNew)
+				samplers.second.erase(newID);
+			if (hasOld)
+				samplers.second[newID] = oldCopy;
+			if (hasNew)
+				samplers.second[oldID] = newCopy;
+		}
 	}
 	void ObjectManager::ResizeImage(const std::string& name, glm::ivec2 size)
 	{
@@ -990,6 +3168,13 @@ namespace ed
 		glBindTexture(GL_TEXTURE_2D, iobj->Texture);
 		glTexImage2D(GL_TEXTURE_2D, 0, iobj->Format, iobj->Size.x, iobj->Size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
 		glBindTexture(GL_TEXTURE_2D, 0);
+		m_markChanged(GetObjectManagerItem(name));
+
+		if (iobj->Fill.Op != GPUFill::Operator::None)
+			FillImage(name, iobj->Fill);
+
+		if (m_renderer != nullptr)
+			m_renderer->InvalidatePassCache();
 	}
 	void ObjectManager::ResizeImage3D(const std::string& name, glm::ivec3 size)
 	{
@@ -997,10 +3182,21 @@ namespace ed
 
 		m_parser->ModifyProject();
 
+		// the slices that are still streaming wouldn't fit anymore
+		m_cancelSlices(GetObjectManagerItem(name));
+		iobj->SlicePaths.clear();
+
 		iobj->Size = size;
 
 		glBindTexture(GL_TEXTURE_3D, iobj->Texture);
 		glTexImage3D(GL_TEXTURE_3D, 0, iobj->Format, iobj->Size.x, iobj->Size.y, iobj->Size.z, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
 		glBindTexture(GL_TEXTURE_3D, 0);
+		m_markChanged(GetObjectManagerItem(name));
+
+		if (iobj->Fill.Op != GPUFill::Operator::None)
+			FillImage(name, iobj->Fill);
+
+		if (m_renderer != nullptr)
+			m_renderer->InvalidatePassCache();
 	}
 }
\ No newline at end of file
@@ -3,13 +3,35 @@
 #include <vector>
 #include <utility>
 #include <unordered_map>
+#include <memory>
+#include <atomic>
+#include <deque>
+#include <algorithm>
 #include <SDL2/SDL_surface.h>
-#include <SFML/Audio/Sound.hpp>
-#include <SFML/Audio/SoundBuffer.hpp>
+#include "AudioTrack.h"
 
 #include "PipelineItem.h"
 #include "ProjectParser.h"
 #include "AudioAnalyzer.h"
+#include "SamplerCache.h"
+#include "GPUFill.h"
+
+#define AUDIO_UPLOAD_SEGMENTS 3 // frames that the persistently mapped audio PBO can be ahead of the GPU
+#define BUFFER_UPLOAD_CHUNK (16 * 1024 * 1024)
+#define VIDEO_UPLOAD_PBOS 3 // video frames that can be uploading at the same time
+#define IMAGE3D_SLICE_LOADS 8 // slice files of 3D images that are decoded at the same time - each one holds a mapped PBO
+#define BINDLESS_TABLE_BLOCK_NAME "SHADERed_Textures" // storage block with the handles of Settings::Project.BindlessTextures
+#define RT_HISTORY_SUFFIX "_prev" // name of the object with the last frame of a render texture = rt name + suffix
+#define ENVIRONMENT_IRRADIANCE_SUFFIX "_irradiance" // objects with the irradiance cubemap & BRDF LUT of an environment map = its name + suffix
+#define ENVIRONMENT_BRDF_SUFFIX "_brdf"
+#include "../Engine/ThreadPool.h"
+#include "../Engine/CompressedTexture.h"
+#include "../Engine/MappedFile.h"
+#include "../Engine/VideoDecoder.h"
+#include "MipChain.h"
+#include "VirtualTexture.h"
+#include "EnvironmentMap.h"
+#include "ImageSequence.h"
 
 namespace ed
 {
@@ -17,16 +39,23 @@ namespace ed
 
 	struct RenderTextureObject
 	{
-		GLuint DepthStencilBuffer, DepthStencilBufferMS, BufferMS; // ColorBuffer is stored in ObjectManager
+		GLuint DepthStencilBuffer, DepthStencilBufferMS, BufferMS; // ColorBuffer is stored in ObjectManager, these are owned by RenderEngine's RenderTargetPool
 		glm::ivec2 FixedSize;
 		glm::vec2 RatioSize;
 		glm::vec4 ClearColor;
 		std::string Name;
 		bool Clear;
 		GLuint Format;
+		bool Mipmaps; // the mip chain is built after every pass that draws to this rt
+		MipChain::Filter MipFilter;
 
-		RenderTextureObject() : FixedSize(-1, -1), RatioSize(1,1),
-		Clear(true), ClearColor(0,0,0,1), Format(GL_RGBA) { }
+		// layered rts are attached as a whole, the passes pick the layer with gl_Layer - see ObjectManager::SetRenderTextureLayers()
+		int Layers; // > 1 -> GL_TEXTURE_2D_ARRAY
+		bool Cubemap; // six square faces, Layers is ignored
+
+		RenderTextureObject() : DepthStencilBuffer(0), DepthStencilBufferMS(0), BufferMS(0),
+		FixedSize(-1, -1), RatioSize(1,1), Clear(true), ClearColor(0,0,0,1), Format(GL_RGBA), Mipmaps(false), MipFilter(MipChain::Filter::Average),
+		Layers(1), Cubemap(false) { }
 
 		glm::ivec2 CalculateSize(int w, int h)
 		{
@@ -35,17 +64,26 @@ namespace ed
 				rtSize.x = RatioSize.x * w;
 				rtSize.y = RatioSize.y * h;
 			}
+			if (Cubemap)
+				rtSize.x = rtSize.y = std::max(rtSize.x, rtSize.y);
 
 			return rtSize;
 		}
+
+		inline bool IsLayered() { return Cubemap || Layers > 1; }
+		inline int GetLayerCount() { return Cubemap ? 6 : Layers; }
+		inline GLenum GetTarget() { return Cubemap ? GL_TEXTURE_CUBE_MAP : (Layers > 1 ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D); }
 	};
 
 	struct BufferObject
 	{
 		int Size;
-		void* Data;
+		void* Data; // nullptr -> the contents only live on the GPU, see ObjectManager::FetchBufferData()
 		char ViewFormat[256]; // vec3;vec3;vec2
 		GLuint ID;
+		std::string File; // file that a GPU only buffer was loaded from
+		std::vector<std::pair<int, int>> Dirty; // [start, end) ranges of Data that were edited but aren't uploaded yet
+		GPUFill::Operation Fill; // generated the contents on the GPU, saved instead of the contents
 	};
 
 	struct ImageObject
@@ -53,6 +91,7 @@ namespace ed
 		glm::ivec2 Size;
 		GLuint Format;
 		GLuint Texture;
+		GPUFill::Operation Fill; // generated the contents on the GPU, run again when the image is resized
 	};
 
 	struct Image3DObject
@@ -60,6 +99,23 @@ namespace ed
 		glm::ivec3 Size;
 		GLuint Format;
 		GLuint Texture;
+		std::vector<std::string> SlicePaths; // image file of each Z slice, empty for an image that the shaders fill
+		GPUFill::Operation Fill; // generated the contents on the GPU, run again when the image is resized
+	};
+
+	struct VideoObject
+	{
+		eng::VideoDecoder* Decoder;
+		bool SyncToTime; // play at the Time system variable, otherwise on its own clock - always off for capture devices
+		bool Paused; // only stops the own clock, capture devices keep showing the last frame
+		double Clock;
+		double FramePTS; // timestamp of the frame in the texture, -1 before the first one
+
+		// frames are copied to the next free PBO and the texture is updated from it without waiting for the upload
+		GLuint PBO[VIDEO_UPLOAD_PBOS];
+		GLsync Fence[VIDEO_UPLOAD_PBOS];
+		unsigned char* Mapped[VIDEO_UPLOAD_PBOS]; // persistent mappings, nullptr -> mapped for each frame
+		int NextPBO;
 	};
 
 	struct PluginObject
@@ -71,6 +127,31 @@ namespace ed
 		void* Data;
 	};
 
+	// everything needed to bind an object to a slot without looking it up again
+	struct BindingDescriptor
+	{
+		enum class BindType
+		{
+			Texture2D,
+			TextureCube,
+			Texture3D,
+			Image2D,
+			Image3D,
+			Buffer,
+			Plugin
+		};
+
+		GLuint ID;
+		GLuint Source; // id from the bind list - differs from ID for audio objects packed into the audio texture array
+		BindType Type;
+		GLenum Target;
+		ImageObject* Image;
+		Image3DObject* Image3D;
+		BufferObject* Buffer;
+		PluginObject* Plugin;
+		GLuint Sampler; // 0 -> the texture's own filtering & wrap parameters
+	};
+
 	/* Use this to remove all the maps */
 	class ObjectManagerItem
 	{
@@ -79,17 +160,39 @@ namespace ed
 			ImageSize = glm::ivec2(0, 0);
 			Texture = 0;
 			FlippedTexture = 0;
+			FlippedGeneration = 0;
 			IsCube = false;
 			IsTexture = false;
+			IsTextureArray = false;
+			BindlessHandle = 0;
+			BindlessResident = false;
+			BindlessFailed = false;
+			Mipmaps = false;
 			CubemapPaths.clear();
-			SoundBuffer = nullptr;
 			Sound = nullptr;
 			SoundMuted = false;
+			SoundAnalyzer = nullptr;
+			SoundSample = -1;
+			SoundFrame = 0;
+			SoundDirty = false;
+			SoundLayer = -1;
+			SoundTrackRate = -1;
+			SoundTrackLength = 0;
+			SoundTrackBuffer = 0;
+			SoundTrackTexture = 0;
 			RT = nullptr;
 			Buffer = nullptr;
 			Image = nullptr;
 			Image3D = nullptr;
 			Plugin = nullptr;
+			Video = nullptr;
+			Virtual = nullptr;
+			Environment = nullptr;
+			EnvironmentOf = nullptr;
+			Sequence = nullptr;
+			History = nullptr;
+			HistoryOf = nullptr;
+			Generation = 0;
 		}
 		~ObjectManagerItem() {
 			if (Buffer != nullptr) {
@@ -106,22 +209,37 @@ namespace ed
 				delete Image3D;
 			}
 
-			if (RT != nullptr) {
-				glDeleteTextures(1, &RT->DepthStencilBuffer);
+			if (RT != nullptr)
 				delete RT;
-			}
-			if (Sound != nullptr) {
-				if (Sound->getStatus() == sf::Sound::Playing)
-					Sound->stop();
-
-				delete SoundBuffer;
+			if (Sound != nullptr)
 				delete Sound;
-			}
+			if (SoundAnalyzer != nullptr)
+				delete SoundAnalyzer;
+			if (SoundTrackTexture != 0)
+				glDeleteTextures(1, &SoundTrackTexture);
+			if (SoundTrackBuffer != 0)
+				glDeleteBuffers(1, &SoundTrackBuffer);
 			if (Plugin != nullptr) {
 				delete Plugin;
 			}
+			if (Video != nullptr) {
+				delete Video->Decoder;
+				glDeleteBuffers(VIDEO_UPLOAD_PBOS, Video->PBO);
+				for (int i = 0; i < VIDEO_UPLOAD_PBOS; i++)
+					if (Video->Fence[i] != nullptr)
+						glDeleteSync(Video->Fence[i]);
+				delete Video;
+			}
+			if (Virtual != nullptr)
+				delete Virtual;
+			if (Environment != nullptr)
+				delete Environment;
+			if (Sequence != nullptr)
+				delete Sequence;
 
 
+			if (BindlessResident)
+				glMakeTextureHandleNonResidentARB(BindlessHandle);
 			if (Texture != 0)
 				glDeleteTextures(1, &Texture);
 			if (FlippedTexture != 0)
@@ -130,21 +248,47 @@ namespace ed
 		}
 
 		glm::ivec2 ImageSize;
-		GLuint Texture, FlippedTexture;
+		GLuint Texture, FlippedTexture; // FlippedTexture is created on the GPU when GetFlippedTexture() is first called
+		unsigned int FlippedGeneration; // Generation that FlippedTexture was copied from
 		bool IsCube;
 		bool IsTexture;
+		bool IsTextureArray; // same sized images packed into the layers of one GL_TEXTURE_2D_ARRAY
+		GLuint64 BindlessHandle; // the texture's parameters can't change anymore once it has a handle
+		bool BindlessResident;
+		bool BindlessFailed; // incomplete texture, glGetTextureHandleARB isn't called again
+		bool Mipmaps; // generate the mip chain for a plain image - DDS/KTX files use their stored levels
 		std::vector<std::string> CubemapPaths;
+		std::vector<std::string> ArrayPaths; // file of each layer
 		
-		sf::SoundBuffer* SoundBuffer;
-		sf::Sound* Sound;
+		AudioTrack* Sound;
 		bool SoundMuted;
+		AudioAnalyzer* SoundAnalyzer;	// every track has its own smoothing state
+		std::vector<float> SoundData;	// spectrum & samples (two rows of AudioAnalyzer::SampleCount) as they are uploaded
+		int SoundSample;				// playing position that SoundData was computed for
+		unsigned int SoundFrame;		// last frame in which SoundData was updated
+		bool SoundDirty;				// SoundData wasn't uploaded yet
+		int SoundLayer;					// layer in the audio texture array, -1 if the audio objects aren't packed
+		int SoundTrackRate;				// whole track: -1 = off, 0 = every sample, > 0 = envelope values per second
+		int SoundTrackLength;			// texels in SoundTrackTexture
+		GLuint SoundTrackBuffer, SoundTrackTexture; // GL_TEXTURE_BUFFER that replaces the per-frame audio texture
 
 		RenderTextureObject* RT;
 		BufferObject* Buffer;
 		ImageObject* Image;
 		Image3DObject* Image3D;
 
+		// the textures of a render texture & its history object are swapped before every frame, the history keeps the last one
+		ObjectManagerItem* History; // rt: the history object, nullptr if the rt doesn't keep one
+		ObjectManagerItem* HistoryOf; // history object: its rt
+
 		PluginObject* Plugin;
+		VideoObject* Video;
+		VirtualTexture* Virtual; // its storage is Texture
+		EnvironmentMap* Environment; // Texture is the prefiltered cubemap, the irradiance & BRDF objects are separate items
+		ObjectManagerItem* EnvironmentOf; // irradiance & BRDF objects: their environment map
+		ImageSequence* Sequence; // the shown frame is copied to Texture
+
+		unsigned int Generation; // changes when the contents are loaded, resized or uploaded from the CPU - unique across the objects, passes writing to it aren't counted
 	};
 
 	class ObjectManager
@@ -156,47 +300,113 @@ namespace ed
 		bool CreateRenderTexture(const std::string& name);
 		bool CreateTexture(const std::string& file);
 		bool CreateAudio(const std::string& file);
+		bool CreateAudio(const std::string& file, const sf::Int16* samples, size_t sampleCount, unsigned int channels, unsigned int sampleRate); // already decoded samples
 		bool CreateCubemap(const std::string& name, const std::string& left, const std::string& top, const std::string& front, const std::string& bottom, const std::string& right, const std::string& back);
+		bool CreateTextureArray(const std::string& name, const std::vector<std::string>& files);
+		bool CreateVideo(const std::string& file);
+		bool CreateCaptureDevice(const std::string& device, int queueDepth = 1);
+		bool CreateVirtualTexture(const std::string& file); // only the pages that the shaders ask for are loaded
+		bool CreateEnvironment(const std::string& file, int faceSize = ENVIRONMENT_FACE_SIZE); // also adds the ENVIRONMENT_*_SUFFIX objects
+		bool CreateImageSequence(const std::string& file); // file = the first frame, the frames are decoded while the sequence plays
 		bool CreateBuffer(const std::string& file);
 		bool CreateImage(const std::string& name, glm::ivec2 size = glm::ivec2(1, 1));
 		bool CreateImage3D(const std::string& name, glm::ivec3 size = glm::ivec3(1, 1, 1));
+		bool LoadImage3DSlices(const std::string& name, const std::vector<std::string>& files); // resizes the image to the slices, they are streamed in over the next frames
 		bool CreatePluginItem(const std::string& name, const std::string& objtype, void* data, GLuint id, IPlugin* owner);
 
 		void Update(float delta);
 
+		// textures are decoded on worker threads and uploaded in Update() - a placeholder is bound until then
+		inline bool IsLoading() { return GetLoadingCount() > 0; }
+		int GetLoadingCount(); // environment maps count until they are filtered, image sequences while their current frame is decoded
+		void WaitForLoading();
+
 		void Remove(const std::string& file);
 		
 		glm::ivec2 GetRenderTextureSize(const std::string& name);
 		RenderTextureObject* GetRenderTexture(GLuint tex);
 		bool IsRenderTexture(const std::string& name);
 		bool IsCubeMap(const std::string& name);
+		bool IsTextureArray(const std::string& name);
 		bool IsAudio(const std::string& name);
 		bool IsAudioMuted(const std::string& name);
+		bool IsVideo(const std::string& name);
+		bool IsCaptureDevice(const std::string& name);
+		bool IsVirtualTexture(const std::string& name);
+		bool IsEnvironment(const std::string& name);
+		bool IsImageSequence(const std::string& name);
+		bool IsEnvironmentPart(const std::string& name); // irradiance or BRDF object of an environment map
+		std::string GetEnvironmentSource(const std::string& name); // the environment map of a part
+		bool HasTextureMipmaps(const std::string& name);
 		bool IsBuffer(const std::string& name);
 		bool IsImage(const std::string& name);
 		bool IsImage3D(const std::string& name);
 		bool IsPluginObject(const std::string& name);
 		bool IsPluginObject(GLuint id);
+		bool IsAudio(GLuint id);
 		bool IsImage3D(GLuint id);
 		bool IsImage(GLuint id);
 		bool IsCubeMap(GLuint id);
 
 		void ResizeRenderTexture(const std::string& name, glm::ivec2 size);
+		void SetRenderTextureLayers(const std::string& name, int layers, bool cubemap); // the rt gets a new texture if its target changes
+		bool SetRenderTextureHistory(const std::string& name, bool history); // adds/removes the name + RT_HISTORY_SUFFIX object
+		bool HasRenderTextureHistory(const std::string& name);
+		bool IsRenderTextureHistory(const std::string& name);
+		bool IsRenderTextureHistory(GLuint id);
+		std::string GetRenderTextureHistorySource(const std::string& name); // the rt of a history object
+		void SwapRenderTextureHistory(); // called by the RenderEngine before it draws a frame
 		void ResizeImage(const std::string& name, glm::ivec2 size);
-		void ResizeImage3D(const std::string& name, glm::ivec3 size);
+		void ResizeImage3D(const std::string& name, glm::ivec3 size); // also drops the slice files
 
-		void Clear();
+		void Clear(bool keepResident = false); // keepResident -> hand the loaded textures over to ResidentAssets
 
 		const std::vector<std::string>& GetObjects() { return m_items; }
 		GLuint GetTexture(const std::string& file);
 		GLuint GetFlippedTexture(const std::string& file);
 		glm::ivec2 GetTextureSize(const std::string& file);
-		sf::SoundBuffer* GetSoundBuffer(const std::string& file);
-		sf::Sound* GetAudioPlayer(const std::string& file);
+		AudioTrack* GetAudioPlayer(const std::string& file);
+		const float* GetAudioData(const std::string& file); // contents of the audio texture, computed at most once per frame
+		int GetAudioLayer(const std::string& file);
+		int GetAudioTrackRate(const std::string& file); // -1 if the object isn't bound as a whole track
+		inline GLuint GetAudioTextureArray() { return m_audioArray; }
+
+		inline GLuint GetBindlessTable() { return m_bindlessTable; }
+		int GetBindlessIndex(const std::string& name); // -1 if the object isn't in the bindless table
+		inline GLuint GetVirtualPageBlock() { return m_virtualBlock; }
+		int GetVirtualTextureIndex(const std::string& name); // -1 if the object doesn't get feedback from the shaders
 		BufferObject* GetBuffer(const std::string& name);
+
+		// large buffer files are uploaded straight from the mapping and don't keep a CPU copy
+		void UploadBuffer(BufferObject* buf, eng::MappedFile& file, const std::string& path);
+		void* FetchBufferData(BufferObject* buf); // reads the contents back if the buffer is GPU only
+
+		// edits are collected and only the touched ranges are uploaded, adjacent ranges are merged
+		void MarkBufferDirty(BufferObject* buf, int offset, int size);
+		void FlushBuffer(BufferObject* buf, const void* data = nullptr, int dataOffset = 0); // data holds the bytes from dataOffset on, buf->Data by default
+
+		// the contents are generated on the GPU without a CPU copy - the operation stays the object's initializer
+		// until the contents are loaded or edited on the CPU
+		bool FillBuffer(const std::string& name, const GPUFill::Operation& op);
+		bool FillImage(const std::string& name, const GPUFill::Operation& op); // 2D & 3D images
+
+		// the contents are copied on the GPU and the copy is only mapped once it's done, so the caller never waits for the frame (used by the plugins)
+		bool ReadBufferAsync(const std::string& name, int offset, int size);
+		bool ReadImageAsync(const std::string& name, int x, int y, int width, int height); // RGBA float texels of a texture, render texture or image
+		const void* MapReadback(const std::string& name, int& size); // nullptr while the GPU is still copying, stays valid until Unmap() or the next read
+
+		// writes go straight to the GPU buffer - the written ranges have to be flushed, the CPU copy of the buffer is dropped
+		// the buffer can't be used while it's mapped so the mapping only lasts until Unmap() or the next Update()
+		void* MapBufferWrite(const std::string& name, int offset, int size);
+		void FlushBufferWrite(const std::string& name, int offset, int size); // offset is relative to the mapped range
+		void Unmap(const std::string& name); // ends the write mapping and unmaps the readback
 		ImageObject* GetImage(const std::string& name);
 		Image3DObject* GetImage3D(const std::string& name);
 		RenderTextureObject* GetRenderTexture(const std::string& name);
+		VideoObject* GetVideo(const std::string& name);
+		VirtualTexture* GetVirtualTexture(const std::string& name);
+		EnvironmentMap* GetEnvironment(const std::string& name);
+		ImageSequence* GetImageSequence(const std::string& name);
 		PluginObject* GetPluginObject(const std::string& name);
 		glm::ivec2 GetImageSize(const std::string& name);
 		glm::ivec3 GetImage3DSize(const std::string& name);
@@ -211,6 +421,10 @@ namespace ed
 		
 		void Mute(const std::string& name);
 		void Unmute(const std::string& name);
+		bool SetAudioTrack(const std::string& name, int rate); // uploads the whole track once, rate as in ObjectManagerItem::SoundTrackRate
+
+		void SetTextureMipmaps(const std::string& name, bool mipmaps);
+		void SetCaptureQueueDepth(const std::string& name, int depth); // reopens the device
 
 		std::string GetItemNameByTextureID(GLuint texID);
 
@@ -224,6 +438,11 @@ namespace ed
 			return m_emptyResVec;
 		}
 
+		// the pass samples the bound texture with its own sampler object instead of the texture parameters
+		const SamplerState* GetSampler(PipelineItem* pass, GLuint id); // nullptr -> texture parameters
+		void SetSampler(PipelineItem* pass, GLuint id, const SamplerState& state);
+		void ResetSampler(PipelineItem* pass, GLuint id);
+
 		void BindUniform(const std::string& file, PipelineItem* pass);
 		void UnbindUniform(const std::string& file, PipelineItem* pass);
 		int IsUniformBound(const std::string& file, PipelineItem* pass);
@@ -232,9 +451,14 @@ namespace ed
 			return m_emptyResVec;
 		}
 
-		inline bool Exists(const std::string& name) { return std::count(m_items.begin(), m_items.end(), name) > 0; }
+		// flat binding tables that are rebuilt only when the bind lists change
+		const std::vector<BindingDescriptor>& GetBindTable(PipelineItem* pass);
+		const std::vector<BindingDescriptor>& GetUniformBindTable(PipelineItem* pass);
+
+		inline bool Exists(const std::string& name) { return m_itemIndex.count(name) > 0; }
 
 		const std::vector<std::string>& GetCubemapTextures(const std::string& name);
+		const std::vector<std::string>& GetTextureArrayLayers(const std::string& name);
 		inline std::vector<ObjectManagerItem*>& GetItemDataList() { return m_itemData; }
 
 	private:
@@ -244,14 +468,126 @@ namespace ed
 		std::vector<std::string> m_items; // TODO: move item name to item data
 		std::vector<ObjectManagerItem*> m_itemData; 
 
+		/* indices for the lookups - objects can't be renamed and their GL ids are assigned when they are created */
+		std::unordered_map<std::string, ObjectManagerItem*> m_itemIndex;
+		struct IDIndex
+		{
+			std::unordered_map<GLuint, ObjectManagerItem*> Textures, Images, Images3D, Buffers, Plugins;
+			std::unordered_map<ObjectManagerItem*, int> Names; // position in m_items
+		} m_idIndex;
+		bool m_idIndexValid;
+		void m_addItem(const std::string& name, ObjectManagerItem* item);
+		unsigned int m_generation; // last ObjectManagerItem::Generation that was handed out
+		inline void m_markChanged(ObjectManagerItem* item) { item->Generation = ++m_generation; }
+		const IDIndex& m_getIDIndex(); // rebuilt on the first lookup after an object was added or removed
+		ObjectManagerItem* m_findByID(const std::unordered_map<GLuint, ObjectManagerItem*>& ids, GLuint id);
+
 		std::vector<GLuint> m_emptyResVec;
 		std::vector<char> m_emptyResVecChar;
 		std::vector<std::string> m_emptyCBTexs;
 
-		ed::AudioAnalyzer m_audioAnalyzer;
-		float m_audioTempTexData[ed::AudioAnalyzer::SampleCount * 2];
+		/* audio textures - only the objects that are bound to a pass are updated */
+		unsigned int m_audioFrame;
+		GLuint m_audioArray; // every audio object in one GL_TEXTURE_2D_ARRAY if Settings::Project.AudioTextureArray is on
+		int m_audioArrayLayers;
+		GLuint m_audioPBO;
+		float* m_audioPBOData; // persistently mapped, AUDIO_UPLOAD_SEGMENTS segments of m_audioPBOCapacity objects
+		int m_audioPBOCapacity, m_audioPBOSegment;
+		GLsync m_audioFences[AUDIO_UPLOAD_SEGMENTS];
+		bool m_createAudio(const std::string& file, AudioTrack* track); // takes the ownership of the track
+		void m_updateAudioData(ObjectManagerItem* item);
+		void m_updateAudioArray();
+		void m_updateAudioPosition();
+		void m_replaceBinds(GLuint oldID, GLuint newID, bool swap); // swap -> the binds of newID get oldID
+		void m_uploadAudio(const std::vector<ObjectManagerItem*>& items);
+		void m_releaseAudioPBO();
+
+		/* video textures - the frames are decoded on the VideoDecoder's thread */
+		bool m_createVideo(const std::string& name, eng::VideoDecoder* decoder); // takes the ownership of the decoder
+		void m_allocateVideoStorage(ObjectManagerItem* item); // texture & PBOs in the decoder's frame size
+		void m_updateVideos(float delta);
+		void m_uploadVideoFrame(ObjectManagerItem* item, double time);
+
+		/* virtual textures - the page words of every object are packed into one VIRTUAL_TEXTURE_BLOCK_NAME block */
+		GLuint m_virtualBlock; // header with the frame & an entry per object, then the page words
+		GLuint m_virtualReadback; // copy of the page words that the GPU wrote
+		GLsync m_virtualFence;
+		GLuint m_virtualFrame;
+		std::vector<ObjectManagerItem*> m_virtualItems; // in the block's order, at most VIRTUAL_TEXTURE_MAX_OBJECTS
+		bool m_virtualLayoutValid;
+		void m_updateVirtualTextures();
+		void m_releaseVirtualBlock();
+
+		/* environment maps - decoded on the loader threads, filtered on the GPU once */
+		void m_addEnvironmentPart(ObjectManagerItem* env, const std::string& name, GLuint tex, bool isCube, glm::ivec2 size);
+		void m_updateEnvironments();
+
+		/* image sequences - a ring of frames after the shown one is decoded on the loader threads */
+		void m_updateImageSequences();
+
+		/* bindless textures - only used if Settings::Project.BindlessTextures is on */
+		GLuint m_bindlessTable; // SSBO with a uint64 handle per texture, cubemap and texture array
+		std::vector<GLuint64> m_bindlessHandles; // uploaded contents of m_bindlessTable
+		void m_updateBindlessTable();
 
 		std::unordered_map<PipelineItem*, std::vector<GLuint>> m_binds;
 		std::unordered_map<PipelineItem*, std::vector<GLuint>> m_uniformBinds;
+		std::unordered_map<PipelineItem*, std::unordered_map<GLuint, SamplerState>> m_samplers; // pass -> bound texture -> state
+		SamplerCache m_samplerCache;
+
+		std::unordered_map<PipelineItem*, std::vector<BindingDescriptor>> m_bindTables;
+		std::unordered_map<PipelineItem*, std::vector<BindingDescriptor>> m_uniformBindTables;
+		std::vector<BindingDescriptor> m_emptyBindTable;
+		BindingDescriptor m_buildDescriptor(GLuint id, bool uniform);
+		bool m_isTableValid(const std::vector<BindingDescriptor>& table, const std::vector<GLuint>& ids);
+		inline void m_invalidateBindTables() { m_bindTables.clear(); m_uniformBindTables.clear(); }
+
+		struct TextureLoadJob
+		{
+			ObjectManagerItem* Item; // nullptr if the object was removed while loading
+			std::string Name, Path;
+			GLenum Target; // GL_TEXTURE_2D, a cubemap face or GL_TEXTURE_2D_ARRAY
+			int Layer; // GL_TEXTURE_2D_ARRAY only
+			int Channels; // of the decoded pixels - 3 for RGB images uploaded to GL_TEXTURE_2D, 4 otherwise
+			glm::ivec2 Size;
+
+			GLuint PBO; // the worker writes straight into the mapped buffer
+			unsigned char* Pixels;
+			std::vector<unsigned char> Fallback; // used if the PBO couldn't be mapped
+
+			std::shared_ptr<eng::CompressedTexture> Compressed; // DDS/KTX/KTX2 - uploaded with its stored mip levels, no PBO
+
+			std::atomic<bool> Done;
+			bool Failed;
+		};
+		struct Readback
+		{
+			GLuint Buffer;
+			int Capacity, Size;
+			GLsync Fence;
+			const void* Mapped;
+		};
+		std::unordered_map<ObjectManagerItem*, Readback> m_readbacks;
+		std::unordered_map<ObjectManagerItem*, int> m_writeMaps; // offset of the mapped range
+		GLuint m_readbackFBO;
+		Readback& m_beginReadback(ObjectManagerItem* item, int size);
+		void m_releaseMappings(ObjectManagerItem* item, bool destroy); // nullptr -> all items, destroy -> also delete the readback buffers
+
+		std::vector<std::shared_ptr<TextureLoadJob>> m_loadJobs;
+		bool m_queueTextureLoad(ObjectManagerItem* item, const std::string& name, GLenum target, int layer = 0);
+		void m_pollTextureLoads(bool wait);
+
+		/* slices of 3D images - only IMAGE3D_SLICE_LOADS of them are queued at once so that a large volume doesn't map a PBO per slice */
+		struct SliceLoad
+		{
+			ObjectManagerItem* Item;
+			std::string Path;
+			int Slice;
+		};
+		std::deque<SliceLoad> m_sliceLoads;
+		void m_streamSlices();
+		void m_cancelSlices(ObjectManagerItem* item);
+
+		eng::ThreadPool m_loadPool; // keep this last so that the workers stop before anything else is destroyed
 	};
 }
\ No newline at end of file
@@ -0,0 +1,246 @@
+#include "PassCondition.h"
+#include "Logger.h"
+#include "ObjectManager.h"
+#include "GLStateCache.h"
+#include "../Engine/GLUtils.h"
+
+static const char* PassConditionVSCode = R"(
+#version 330
+uniform usamplerBuffer uCondition;
+uniform int uIndex; // -1 -> the offset is outside of the buffer
+
+void main()
+{
+	uint value = uIndex >= 0 ? texelFetch(uCondition, uIndex).r : 0u;
+
+	// outside of the clip volume -> no samples pass
+	gl_Position = value != 0u ? vec4(0.0, 0.0, 0.0, 1.0) : vec4(2.0, 2.0, 2.0, 1.0);
+}
+)";
+static const char* PassConditionPSCode = R"(
+#version 330
+layout(location = 0) out vec4 outColor;
+
+void main()
+{
+	outColor = vec4(1.0);
+}
+)";
+static const char* PassConditionCSCode = R"(
+#version 430
+layout(local_size_x = 1) in;
+
+layout(std430, binding = 0) readonly buffer Condition { uint condition[]; };
+layout(std430, binding = 1) buffer Dispatch { uint dispatch[]; };
+
+uniform int uIndex;
+uniform uvec3 uGroups;
+uniform int uIndirectIndex; // -1 -> uGroups
+
+void main()
+{
+	// the indirect counts are copied to dispatch[3] before this runs
+	uvec3 groups = uIndirectIndex >= 0 ? uvec3(dispatch[3], dispatch[4], dispatch[5]) : uGroups;
+	bool run = uIndex >= 0 && condition[uIndex] != 0u;
+
+	dispatch[0] = run ? groups.x : 0u;
+	dispatch[1] = run ? groups.y : 0u;
+	dispatch[2] = run ? groups.z : 0u;
+}
+)";
+
+namespace ed
+{
+	// -1 if the uint doesn't fit in the buffer
+	static GLint getIndex(BufferObject* buffer, GLuint offset)
+	{
+		if (buffer == nullptr || offset + sizeof(GLuint) > buffer->Size)
+			return -1;
+		return offset / sizeof(GLuint);
+	}
+
+	PassCondition::PassCondition()
+	{
+		m_drawProgram = m_dispatchProgram = m_binding = 0;
+		m_uDrawIndex = m_uIndex = m_uGroups = m_uIndirectIndex = -1;
+		m_fbo = m_color = m_vao = m_texture = m_query = 0;
+		m_dispatch = 0;
+	}
+	PassCondition::~PassCondition()
+	{
+		if (m_drawProgram != 0)
+			glDeleteProgram(m_drawProgram);
+		if (m_dispatchProgram != 0)
+			glDeleteProgram(m_dispatchProgram);
+		if (m_fbo != 0) {
+			glDeleteFramebuffers(1, &m_fbo);
+			glDeleteRenderbuffers(1, &m_color);
+			glDeleteVertexArrays(1, &m_vao);
+			glDeleteTextures(1, &m_texture);
+			glDeleteQueries(1, &m_query);
+		}
+		if (m_dispatch != 0)
+			glDeleteBuffers(1, &m_dispatch);
+	}
+	bool PassCondition::IsSupported()
+	{
+		return GLEW_VERSION_3_3;
+	}
+	void PassCondition::Init(GLint firstBinding)
+	{
+		m_binding = firstBinding;
+
+		GLchar msg[1024];
+		GLuint vs = gl::CompileShader(GL_VERTEX_SHADER, PassConditionVSCode);
+		GLuint ps = gl::CompileShader(GL_FRAGMENT_SHADER, PassConditionPSCode);
+		bool compiled = gl::CheckShaderCompilationStatus(vs, msg) && gl::CheckShaderCompilationStatus(ps, msg);
+		if (compiled) {
+			m_drawProgram = glCreateProgram();
+			gl::SetObjectLabel(GL_PROGRAM, m_drawProgram, "Pass condition");
+			glAttachShader(m_drawProgram, vs);
+			glAttachShader(m_drawProgram, ps);
+			glLinkProgram(m_drawProgram);
+		}
+		glDeleteShader(vs);
+		glDeleteShader(ps);
+
+		if (!compiled || !gl::CheckShaderLinkStatus(m_drawProgram, msg)) {
+			Logger::Get().Log("Failed to create the pass condition shader: " + std::string(msg), true);
+			if (m_drawProgram != 0)
+				glDeleteProgram(m_drawProgram);
+			m_drawProgram = 0;
+			return;
+		}
+
+		glUseProgram(m_drawProgram);
+		glUniform1i(glGetUniformLocation(m_drawProgram, "uCondition"), 0);
+		m_uDrawIndex = glGetUniformLocation(m_drawProgram, "uIndex");
+		glUseProgram(0);
+
+		// a single pixel that nobody looks at, it's only there so that the query has something to count
+		glGenRenderbuffers(1, &m_color);
+		glBindRenderbuffer(GL_RENDERBUFFER, m_color);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_R8, 1, 1);
+		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+		glGenFramebuffers(1, &m_fbo);
+		glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_color);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		glGenVertexArrays(1, &m_vao);
+		glGenTextures(1, &m_texture);
+		glGenQueries(1, &m_query);
+
+		// the compute passes need the dispatch kernel, without it their condition is ignored
+		if (firstBinding < 0 || !GLEW_ARB_compute_shader || !GLEW_ARB_shader_storage_buffer_object)
+			return;
+
+		GLuint cs = gl::CompileShader(GL_COMPUTE_SHADER, PassConditionCSCode);
+		if (!gl::CheckShaderCompilationStatus(cs, msg)) {
+			Logger::Get().Log("Failed to compile the pass condition dispatch shader: " + std::string(msg), true);
+			glDeleteShader(cs);
+			return;
+		}
+
+		m_dispatchProgram = glCreateProgram();
+		gl::SetObjectLabel(GL_PROGRAM, m_dispatchProgram, "Pass condition dispatch");
+		glAttachShader(m_dispatchProgram, cs);
+		glLinkProgram(m_dispatchProgram);
+		glDeleteShader(cs);
+
+		if (!gl::CheckShaderLinkStatus(m_dispatchProgram, msg)) {
+			Logger::Get().Log("Failed to link the pass condition dispatch shader: " + std::string(msg), true);
+			glDeleteProgram(m_dispatchProgram);
+			m_dispatchProgram = 0;
+			return;
+		}
+
+		// move the blocks away from the binding points that the passes usually use
+		const char* blocks[] = { "Condition", "Dispatch" };
+		for (int i = 0; i < 2; i++)
+			glShaderStorageBlockBinding(m_dispatchProgram, glGetProgramResourceIndex(m_dispatchProgram, GL_SHADER_STORAGE_BLOCK, blocks[i]), m_binding + i);
+
+		m_uIndex = glGetUniformLocation(m_dispatchProgram, "uIndex");
+		m_uGroups = glGetUniformLocation(m_dispatchProgram, "uGroups");
+		m_uIndirectIndex = glGetUniformLocation(m_dispatchProgram, "uIndirectIndex");
+
+		// 3 uints for the dispatch, 3 for the copied indirect counts
+		glGenBuffers(1, &m_dispatch);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_dispatch);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint) * 6, nullptr, GL_DYNAMIC_COPY);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	}
+	void PassCondition::BeginDraw(BufferObject* condition, GLuint offset)
+	{
+		if (m_drawProgram == 0)
+			return;
+
+		GLStateCache& glState = GLStateCache::Instance();
+
+		// the value might have just been written by a compute pass
+		if (GLEW_ARB_shader_image_load_store)
+			glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+		GLint index = getIndex(condition, offset);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_BUFFER, m_texture);
+		glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, index >= 0 ? condition->ID : 0);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+		glViewport(0, 0, 1, 1);
+		glState.Enable(GL_DEPTH_TEST, false);
+		glState.Enable(GL_STENCIL_TEST, false);
+		glState.Enable(GL_CULL_FACE, false);
+
+		glUseProgram(m_drawProgram);
+		glUniform1i(m_uDrawIndex, index);
+		glBindVertexArray(m_vao);
+
+		glBeginQuery(GL_ANY_SAMPLES_PASSED, m_query);
+		glDrawArrays(GL_POINTS, 0, 1);
+		glEndQuery(GL_ANY_SAMPLES_PASSED);
+
+		glBindVertexArray(0);
+		glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+		// the GPU waits for the query, the CPU doesn't
+		glBeginConditionalRender(m_query, GL_QUERY_WAIT);
+	}
+	void PassCondition::EndDraw()
+	{
+		if (m_drawProgram != 0)
+			glEndConditionalRender();
+	}
+	bool PassCondition::BindDispatch(BufferObject* condition, GLuint offset, const glm::uvec3& groups, BufferObject* indirect, GLuint indirectOffset)
+	{
+		if (m_dispatchProgram == 0)
+			return false;
+
+		bool useIndirect = indirect != nullptr && indirectOffset + sizeof(GLuint) * 3 <= indirect->Size;
+		if (useIndirect) {
+			glBindBuffer(GL_COPY_READ_BUFFER, indirect->ID);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, m_dispatch);
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, indirectOffset, sizeof(GLuint) * 3, sizeof(GLuint) * 3);
+			glBindBuffer(GL_COPY_READ_BUFFER, 0);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		}
+
+		// the value & the counts might have just been written by a compute pass
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+		GLint index = getIndex(condition, offset);
+		glUseProgram(m_dispatchProgram);
+		glUniform1i(m_uIndex, index);
+		glm::uvec3 counts = indirect != nullptr ? glm::uvec3(0) : groups; // an indirect buffer that is too small dispatches nothing
+		glUniform3ui(m_uGroups, counts.x, counts.y, counts.z);
+		glUniform1i(m_uIndirectIndex, useIndirect ? 0 : -1);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, m_binding, index >= 0 ? condition->ID : m_dispatch);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, m_binding + 1, m_dispatch);
+		glDispatchCompute(1, 1, 1);
+
+		glMemoryBarrier(GL_COMMAND_BARRIER_BIT);
+		glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, m_dispatch);
+		return true;
+	}
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/glew.h>
+#if defined(__APPLE__)
+	#include <OpenGL/gl.h>
+#else
+	#include <GL/gl.h>
+#endif
+
+namespace ed
+{
+	struct BufferObject;
+
+	// runs a pass only while the uint at an offset of a buffer isn't 0 - the value is never read back, so the buffer can be
+	// written by an earlier compute pass in the same frame without stalling it
+	// shader passes: a point that is only inside of the view when the value isn't 0 is drawn inside of an occlusion query
+	// and the pass is drawn with conditional rendering, compute passes: the group counts are copied to an indirect dispatch
+	// buffer by a tiny compute shader and they are set to 0 when the value is 0
+	class PassCondition
+	{
+	public:
+		PassCondition();
+		~PassCondition();
+
+		static bool IsSupported();
+		inline bool IsReady() { return m_drawProgram != 0; }
+
+		// firstBinding & firstBinding + 1 are used as SSBO binding points while the dispatch is written, -1 -> the conditions of the compute passes are ignored
+		void Init(GLint firstBinding);
+
+		// the draw & clear calls between these are dropped by the GPU, changes the framebuffer, program & vertex array bindings
+		void BeginDraw(BufferObject* condition, GLuint offset);
+		void EndDraw();
+
+		// binds GL_DISPATCH_INDIRECT_BUFFER, dispatch with glDispatchComputeIndirect(0) - the group counts are read from
+		// indirect at indirectOffset if it's set, changes the program & the SSBO bindings
+		// false -> compute shaders aren't supported, nothing was bound and the pass runs as if it had no condition
+		bool BindDispatch(BufferObject* condition, GLuint offset, const glm::uvec3& groups, BufferObject* indirect = nullptr, GLuint indirectOffset = 0);
+
+	private:
+		GLuint m_drawProgram, m_dispatchProgram, m_binding;
+		GLint m_uDrawIndex, m_uIndex, m_uGroups, m_uIndirectIndex;
+
+		GLuint m_fbo, m_color, m_vao, m_texture, m_query;
+		GLuint m_dispatch;
+	};
+}
@@ -0,0 +1,363 @@
+#include "PassScheduler.h"
+#include "ObjectManager.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+namespace ed
+{
+	void PassScheduler::Build(const std::vector<PipelineItem*>& items, const std::vector<bool>& run, ObjectManager* objects, const WindowTargets& window,
+		const std::unordered_set<GLuint>& shown, const std::function<bool(int)>& writesAllFragments, bool reorder)
+	{
+		m_order.clear();
+		m_unused.clear();
+
+		// clears are decided in the user's order so that a reordered frame looks exactly the same
+		std::vector<Pass> passes(items.size());
+		GLuint previousTexture[MAX_RENDER_TEXTURES] = { 0 }; // dont clear the render target if we use it two times in a row
+		GLuint previousDepth = 0; // rt that owns the depth buffer - rts can share the depth storage so we can't compare the textures
+		bool clearedWindow = false;
+		for (int i = 0; i < items.size(); i++) {
+			Pass& pass = passes[i];
+			pass.Index = i;
+			pass.Clear = 0;
+			pass.Invalidate = 0;
+			pass.ClearDepth = false;
+			pass.Resolve = true;
+			pass.Unsampled = 0;
+			pass.Discard = 0;
+			pass.DiscardDepth = false;
+
+			if (!run[i])
+				continue;
+
+			pipe::ShaderPass* data = (pipe::ShaderPass*)items[i]->Data;
+
+			GLuint depthOwner = data->RenderTextures[data->RTCount - 1];
+			if (depthOwner != previousDepth) {
+				pass.ClearDepth = depthOwner != window.Color || !clearedWindow;
+				previousDepth = depthOwner;
+			}
+
+			for (int j = 0; j < MAX_RENDER_TEXTURES && data->RenderTextures[j] != 0; j++) {
+				GLuint rt = data->RenderTextures[j];
+
+				if (rt != window.Color) {
+					RenderTextureObject* rtObject = objects->GetRenderTexture(rt);
+					bool usedPreviously = std::count(previousTexture, previousTexture + MAX_RENDER_TEXTURES, rt) > 0;
+					if (!usedPreviously && rtObject != nullptr && rtObject->Clear)
+						pass.Clear |= 1u << j;
+				}
+				else if (!clearedWindow) {
+					pass.Clear |= 1u << j;
+					clearedWindow = true;
+				}
+			}
+			for (int j = 0; j < data->RTCount; j++)
+				previousTexture[j] = data->RenderTextures[j];
+
+			// the clear color would never be seen - only one attachment because the shader might not write to all of them
+			if (pass.Clear != 0 && data->RTCount == 1 && m_coversTargets(data, pass.ClearDepth) && writesAllFragments(i)) {
+				pass.Invalidate = pass.Clear;
+				pass.Clear = 0;
+			}
+		}
+
+		if (!reorder) {
+			m_order = passes;
+			m_findDiscards(items, run, objects, window, shown);
+			return;
+		}
+
+		m_findResources(items, run, objects, window);
+
+		for (int start = 0; start < items.size();) {
+			// shader passes that don't draw anything can be put anywhere
+			int end = start;
+			while (end < items.size() && (m_movable[end] || (items[end]->Type == PipelineItem::ItemType::ShaderPass && !run[end])))
+				end++;
+
+			m_schedule(items, run, passes, start, end);
+
+			if (end < items.size())
+				m_order.push_back(passes[end]);
+			start = end + 1;
+		}
+
+		// the next pass keeps drawing to the same multisampled attachments
+		for (int i = 0; i + 1 < m_order.size(); i++) {
+			int cur = m_order[i].Index, next = m_order[i + 1].Index;
+			if (run[cur] && run[next] && m_sameTargets(items[cur], items[next]) && !m_depends(cur, next, true))
+				m_order[i].Resolve = false;
+		}
+
+		m_findUnused(items, run, objects, window.Color);
+		m_findDiscards(items, run, objects, window, shown);
+	}
+	void PassScheduler::m_findResources(const std::vector<PipelineItem*>& items, const std::vector<bool>& run, ObjectManager* objects, const WindowTargets& window)
+	{
+		m_writes.assign(items.size(), std::vector<GLuint>());
+		m_reads.assign(items.size(), std::vector<GLuint>());
+		m_movable.assign(items.size(), false);
+
+		auto addTexture = [](std::vector<GLuint>& list, GLuint tex) {
+			if (tex != 0)
+				list.push_back(tex);
+		};
+
+		for (int i = 0; i < items.size(); i++) {
+			if (!run[i])
+				continue;
+
+			pipe::ShaderPass* data = (pipe::ShaderPass*)items[i]->Data;
+			m_movable[i] = true;
+
+			// the pooled attachments of different rts can be the same texture
+			for (int j = 0; j < data->RTCount; j++) {
+				GLuint rt = data->RenderTextures[j];
+				bool isLast = j == data->RTCount - 1;
+
+				addTexture(m_writes[i], rt);
+				if (rt == window.Color) {
+					addTexture(m_writes[i], window.ColorMS);
+					if (isLast) {
+						addTexture(m_writes[i], window.Depth);
+						addTexture(m_writes[i], window.DepthMS);
+					}
+				} else {
+					RenderTextureObject* rtObject = objects->GetRenderTexture(rt);
+					if (rtObject == nullptr)
+						continue;
+
+					addTexture(m_writes[i], rtObject->BufferMS);
+					if (isLast) {
+						addTexture(m_writes[i], rtObject->DepthStencilBuffer);
+						addTexture(m_writes[i], rtObject->DepthStencilBufferMS);
+					}
+				}
+			}
+
+			// plugins can read and write anything
+			for (const BindingDescriptor& srv : objects->GetBindTable(items[i])) {
+				if (srv.Type == BindingDescriptor::BindType::Plugin)
+					m_movable[i] = false;
+				else if (srv.Type != BindingDescriptor::BindType::Buffer)
+					m_reads[i].push_back(srv.ID);
+			}
+			for (PipelineItem* child : data->Items)
+				if (child->Type == PipelineItem::ItemType::PluginItem)
+					m_movable[i] = false;
+
+			// the captured vertices are only tracked through the buffer, the capture & the passes that draw it keep their order
+			if (data->CaptureBuffer != nullptr)
+				m_movable[i] = false;
+			for (PipelineItem* child : data->Items)
+				if (child->Type == PipelineItem::ItemType::Geometry && ((pipe::GeometryItem*)child->Data)->Type == pipe::GeometryItem::Captured)
+					m_movable[i] = false;
+		}
+	}
+	void PassScheduler::m_schedule(const std::vector<PipelineItem*>& items, const std::vector<bool>& run, const std::vector<Pass>& passes, int start, int end)
+	{
+		std::vector<int> segment;
+		for (int i = start; i < end; i++)
+			if (run[i])
+				segment.push_back(i);
+
+		// edges always point from the earlier pass to the later one
+		int count = segment.size();
+		std::vector<int> waiting(count, 0);
+		std::vector<std::vector<int>> next(count);
+		for (int a = 0; a < count; a++)
+			for (int b = a + 1; b < count; b++)
+				if (m_depends(segment[a], segment[b], false)) {
+					next[a].push_back(b);
+					waiting[b]++;
+				}
+
+		// the earliest ready pass, unless a ready pass draws to the same targets as the last one
+		std::vector<bool> done(count, false);
+		int last = -1;
+		for (int k = 0; k < count; k++) {
+			int pick = -1;
+			for (int c = 0; c < count; c++) {
+				if (done[c] || waiting[c] > 0)
+					continue;
+
+				if (pick == -1)
+					pick = c;
+				if (last != -1 && m_sameTargets(items[segment[c]], items[segment[last]])) {
+					pick = c;
+					break;
+				}
+			}
+
+			done[pick] = true;
+			for (int n : next[pick])
+				waiting[n]--;
+
+			m_order.push_back(passes[segment[pick]]);
+			last = pick;
+		}
+
+		for (int i = start; i < end; i++)
+			if (!run[i])
+				m_order.push_back(passes[i]);
+	}
+	void PassScheduler::m_findUnused(const std::vector<PipelineItem*>& items, const std::vector<bool>& run, ObjectManager* objects, GLuint window)
+	{
+		std::unordered_set<GLuint> sampled;
+		if (!m_findSampled(items, objects, sampled))
+			return;
+
+		// the window is always used
+		for (int i = 0; i < items.size(); i++) {
+			if (!run[i])
+				continue;
+
+			pipe::ShaderPass* data = (pipe::ShaderPass*)items[i]->Data;
+			bool used = false;
+			for (int j = 0; j < data->RTCount && !used; j++)
+				used = data->RenderTextures[j] == window || sampled.count(data->RenderTextures[j]) > 0;
+
+			if (!used)
+				m_unused.push_back(items[i]);
+		}
+	}
+	void PassScheduler::m_findDiscards(const std::vector<PipelineItem*>& items, const std::vector<bool>& run, ObjectManager* objects, const WindowTargets& window, const std::unordered_set<GLuint>& shown)
+	{
+		std::unordered_set<GLuint> sampled;
+		bool known = m_findSampled(items, objects, sampled);
+
+		// a pass without MSAA (or at a reduced resolution) continues drawing on the resolved texture
+		for (int i = 0; i < items.size(); i++) {
+			if (!run[i])
+				continue;
+
+			pipe::ShaderPass* data = (pipe::ShaderPass*)items[i]->Data;
+			if (!data->Multisample || data->ResolutionScale > 1)
+				sampled.insert(data->RenderTextures, data->RenderTextures + data->RTCount);
+		}
+
+		for (int n = 0; n < m_order.size(); n++) {
+			Pass& pass = m_order[n];
+			if (!run[pass.Index])
+				continue;
+
+			pipe::ShaderPass* data = (pipe::ShaderPass*)items[pass.Index]->Data;
+			for (int j = 0; j < data->RTCount; j++) {
+				GLuint rt = data->RenderTextures[j];
+
+				if (known && rt != window.Color && sampled.count(rt) == 0 && shown.count(rt) == 0)
+					pass.Unsampled |= 1u << j;
+				if (!m_isReadLater(items, run, objects, window.Color, n, rt, false))
+					pass.Discard |= 1u << j;
+			}
+			pass.DiscardDepth = !m_isReadLater(items, run, objects, window.Color, n, data->RenderTextures[data->RTCount - 1], true);
+		}
+	}
+	bool PassScheduler::m_isReadLater(const std::vector<PipelineItem*>& items, const std::vector<bool>& run, ObjectManager* objects, GLuint window, int position, GLuint rt, bool depth)
+	{
+		// the next pass that draws to the same attachment either continues where this one stopped or clears it
+		for (int n = position + 1; n < m_order.size(); n++) {
+			const Pass& next = m_order[n];
+			if (!run[next.Index])
+				continue;
+
+			pipe::ShaderPass* data = (pipe::ShaderPass*)items[next.Index]->Data;
+			if (depth) {
+				if (data->RenderTextures[data->RTCount - 1] == rt)
+					return !next.ClearDepth;
+				continue;
+			}
+
+			for (int j = 0; j < data->RTCount; j++)
+				if (data->RenderTextures[j] == rt)
+					return ((next.Clear | next.Invalidate) & (1u << j)) == 0;
+		}
+
+		// the next frame starts with a clear, except for the render textures that keep their contents
+		if (depth || rt == window)
+			return false;
+
+		RenderTextureObject* rtObject = objects->GetRenderTexture(rt);
+		return rtObject == nullptr || !rtObject->Clear;
+	}
+	bool PassScheduler::m_findSampled(const std::vector<PipelineItem*>& items, ObjectManager* objects, std::unordered_set<GLuint>& sampled)
+	{
+		for (PipelineItem* item : items) {
+			// no way to tell what a plugin reads
+			if (item->Type == PipelineItem::ItemType::PluginItem)
+				return false;
+			if (item->Type == PipelineItem::ItemType::ShaderPass)
+				for (PipelineItem* child : ((pipe::ShaderPass*)item->Data)->Items)
+					if (child->Type == PipelineItem::ItemType::PluginItem)
+						return false;
+
+			for (const BindingDescriptor& srv : objects->GetBindTable(item))
+				if (srv.Type != BindingDescriptor::BindType::Buffer)
+					sampled.insert(srv.ID);
+			for (const BindingDescriptor& ubo : objects->GetUniformBindTable(item))
+				if (ubo.Type == BindingDescriptor::BindType::Image2D || ubo.Type == BindingDescriptor::BindType::Image3D)
+					sampled.insert(ubo.ID);
+		}
+
+		return true;
+	}
+	bool PassScheduler::m_coversTargets(pipe::ShaderPass* data, bool depthCleared)
+	{
+		// DefaultState::Bind()
+		bool depthTest = true, cullFace = true;
+		GLenum depthFunc = GL_LESS, cullFaceType = GL_BACK, frontFace = GL_CCW;
+
+		// every pixel is written once a full screen quad passes - the items drawn before it can't blend or leave holes
+		for (PipelineItem* child : data->Items) {
+			if (child->Type == PipelineItem::ItemType::RenderState) {
+				pipe::RenderState* state = (pipe::RenderState*)child->Data;
+				if (state->Blend || state->AlphaToCoverage || state->StencilTest || state->PolygonMode != GL_FILL)
+					return false;
+
+				depthTest = state->DepthTest;
+				depthFunc = state->DepthFunction;
+				cullFace = state->CullFace;
+				cullFaceType = state->CullFaceType;
+				frontFace = state->FrontFace;
+			}
+			else if (child->Type == PipelineItem::ItemType::Geometry) {
+				pipe::GeometryItem* geoData = (pipe::GeometryItem*)child->Data;
+				if (geoData->Type != pipe::GeometryItem::ScreenQuadNDC || geoData->Topology != GL_TRIANGLES || geoData->OcclusionCulling)
+					continue;
+
+				// the quad is counter-clockwise, pixels that nothing was drawn to yet have the cleared depth
+				bool culled = cullFace && (cullFaceType == GL_FRONT_AND_BACK || (cullFaceType == GL_FRONT) == (frontFace == GL_CCW));
+				bool depthPasses = !depthTest || depthFunc == GL_ALWAYS || (depthCleared && (depthFunc == GL_LESS || depthFunc == GL_LEQUAL || depthFunc == GL_NOTEQUAL));
+				if (!culled && depthPasses)
+					return true;
+			}
+			else if (child->Type == PipelineItem::ItemType::PluginItem)
+				return false;
+		}
+
+		return false;
+	}
+	bool PassScheduler::m_depends(int a, int b, bool readsOnly)
+	{
+		auto overlaps = [](const std::vector<GLuint>& x, const std::vector<GLuint>& y) -> bool {
+			for (GLuint tex : x)
+				if (std::count(y.begin(), y.end(), tex))
+					return true;
+			return false;
+		};
+
+		if (readsOnly)
+			return overlaps(m_writes[a], m_reads[b]);
+		return overlaps(m_writes[a], m_writes[b]) || overlaps(m_writes[a], m_reads[b]) || overlaps(m_reads[a], m_writes[b]);
+	}
+	bool PassScheduler::m_sameTargets(PipelineItem* a, PipelineItem* b)
+	{
+		pipe::ShaderPass* passA = (pipe::ShaderPass*)a->Data;
+		pipe::ShaderPass* passB = (pipe::ShaderPass*)b->Data;
+		if (passA->RTCount != passB->RTCount || passA->Multisample != passB->Multisample)
+			return false;
+		return std::equal(passA->RenderTextures, passA->RenderTextures + passA->RTCount, passB->RenderTextures);
+	}
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include "PipelineItem.h"
+
+#include <vector>
+#include <functional>
+#include <unordered_set>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/glew.h>
+#if defined(__APPLE__)
+	#include <OpenGL/gl.h>
+#else
+	#include <GL/gl.h>
+#endif
+
+namespace ed
+{
+	class ObjectManager;
+
+	// decides in which order the pipeline items are rendered, which targets each shader pass clears and which attachments
+	// don't have to be loaded (cleared), resolved or stored (invalidated) because nothing reads their contents
+	// with reordering turned on, the independent shader passes between two items that can't be moved (compute, audio &
+	// plugin items, passes with plugin data) are grouped by the targets that they render to - two passes are dependent when
+	// one of them draws to a texture that the other one draws to or samples (shared depth & multisampled attachments included)
+	class PassScheduler
+	{
+	public:
+		struct Pass
+		{
+			int Index;				// in the RenderEngine's item list
+			unsigned int Clear;		// bit i -> clear the color attachment i
+			unsigned int Invalidate;	// bit i -> a full screen quad draws over the color attachment i, so it's invalidated instead of cleared
+			bool ClearDepth;
+			bool Resolve;			// false when the next pass draws to the same targets, so the MSAA resolve can wait
+			unsigned int Unsampled;	// bit i -> nothing samples the texture of the color attachment i, its MSAA resolve isn't needed
+			unsigned int Discard;	// bit i -> the multisampled color attachment i isn't read again before it's cleared
+			bool DiscardDepth;		// same for the depth & stencil attachment
+		};
+
+		struct WindowTargets
+		{
+			GLuint Color, Depth, ColorMS, DepthMS;
+		};
+
+		// run[i] -> items[i] is a shader pass that draws something in this frame
+		// shown -> textures that the UI displays, writesAllFragments(i) -> items[i]'s pixel shader doesn't discard fragments
+		void Build(const std::vector<PipelineItem*>& items, const std::vector<bool>& run, ObjectManager* objects, const WindowTargets& window,
+			const std::unordered_set<GLuint>& shown, const std::function<bool(int)>& writesAllFragments, bool reorder);
+
+		inline const std::vector<Pass>& GetOrder() { return m_order; }
+		inline const std::vector<PipelineItem*>& GetUnused() { return m_unused; } // passes whose render textures are never sampled (only with reordering)
+
+	private:
+		void m_findResources(const std::vector<PipelineItem*>& items, const std::vector<bool>& run, ObjectManager* objects, const WindowTargets& window);
+		void m_schedule(const std::vector<PipelineItem*>& items, const std::vector<bool>& run, const std::vector<Pass>& passes, int start, int end);
+		void m_findUnused(const std::vector<PipelineItem*>& items, const std::vector<bool>& run, ObjectManager* objects, GLuint window);
+		void m_findDiscards(const std::vector<PipelineItem*>& items, const std::vector<bool>& run, ObjectManager* objects, const WindowTargets& window, const std::unordered_set<GLuint>& shown);
+		bool m_isReadLater(const std::vector<PipelineItem*>& items, const std::vector<bool>& run, ObjectManager* objects, GLuint window, int position, GLuint rt, bool depth);
+		static bool m_findSampled(const std::vector<PipelineItem*>& items, ObjectManager* objects, std::unordered_set<GLuint>& sampled); // false if a plugin could read anything
+		static bool m_coversTargets(pipe::ShaderPass* data, bool depthCleared);
+		bool m_depends(int a, int b, bool readsOnly); // readsOnly -> only b sampling what a draws to counts
+		static bool m_sameTargets(PipelineItem* a, PipelineItem* b);
+
+		std::vector<Pass> m_order;
+		std::vector<PipelineItem*> m_unused;
+
+		std::vector<std::vector<GLuint>> m_writes, m_reads;
+		std::vector<bool> m_movable;
+	};
+}
@@ -0,0 +1,141 @@
+#include "PassWatchdog.h"
+
+#include <algorithm>
+
+namespace ed
+{
+	PassWatchdog::PassWatchdog()
+	{
+		m_budget = 0.0f;
+		m_frame = 0;
+		m_current.Item = nullptr;
+	}
+	PassWatchdog::~PassWatchdog()
+	{
+		Clear();
+		if (!m_queries.empty())
+			glDeleteQueries(m_queries.size(), m_queries.data());
+	}
+	void PassWatchdog::Begin(PipelineItem* item)
+	{
+		for (int i = 0; i < 2; i++) {
+			if (m_queries.empty()) {
+				GLuint query = 0;
+				glGenQueries(1, &query);
+				m_queries.push_back(query);
+			}
+			m_current.Queries[i] = m_queries.back();
+			m_queries.pop_back();
+		}
+
+		// timestamps - a GL_TIME_ELAPSED query around the pass would fail while PreviewUI or the headless benchmark already measures
+		// the whole frame with one, GL only allows one active elapsed time query
+		m_current.Item = item;
+		m_current.Frame = m_frame;
+		glQueryCounter(m_current.Queries[0], GL_TIMESTAMP);
+	}
+	void PassWatchdog::End(PipelineItem* item)
+	{
+		if (m_current.Item != item)
+			return;
+
+		glQueryCounter(m_current.Queries[1], GL_TIMESTAMP);
+		m_current.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		m_pending.push_back(m_current);
+		m_current.Item = nullptr;
+	}
+	void PassWatchdog::m_free(Submission& sub)
+	{
+		glDeleteSync(sub.Fence);
+		m_queries.push_back(sub.Queries[0]);
+		m_queries.push_back(sub.Queries[1]);
+	}
+	bool PassWatchdog::m_check(Submission& sub, bool wait, std::vector<Trip>& trips)
+	{
+		GLenum status = glClientWaitSync(sub.Fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+		if (status == GL_TIMEOUT_EXPIRED && wait) {
+			// only wait for what is left of the budget since the pass started
+			GLint started = 0;
+			glGetQueryObjectiv(sub.Queries[0], GL_QUERY_RESULT_AVAILABLE, &started);
+
+			GLuint64 timeout = (GLuint64)(m_budget * 1000000.0);
+			if (started) {
+				GLuint64 start = 0;
+				GLint64 now = 0;
+				glGetQueryObjectui64v(sub.Queries[0], GL_QUERY_RESULT, &start);
+				glGetInteger64v(GL_TIMESTAMP, &now);
+				timeout = (GLuint64)now > start ? timeout - std::min(timeout, (GLuint64)now - start) : timeout;
+			}
+			status = glClientWaitSync(sub.Fence, 0, timeout);
+		}
+
+		if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+			GLuint64 start = 0, end = 0;
+			glGetQueryObjectui64v(sub.Queries[0], GL_QUERY_RESULT, &start);
+			glGetQueryObjectui64v(sub.Queries[1], GL_QUERY_RESULT, &end);
+
+			float time = end > start ? (end - start) / 1000000.0f : 0.0f;
+			if (time > m_budget && m_tripped.insert(sub.Item).second)
+				trips.push_back({ sub.Item, time, false });
+			return true;
+		}
+		if (status == GL_WAIT_FAILED)
+			return true;
+
+		// still running - measured from the start of the pass, it might still be waiting for the passes before it
+		GLint started = 0;
+		glGetQueryObjectiv(sub.Queries[0], GL_QUERY_RESULT_AVAILABLE, &started);
+		if (!started)
+			return false;
+
+		GLuint64 start = 0;
+		GLint64 now = 0;
+		glGetQueryObjectui64v(sub.Queries[0], GL_QUERY_RESULT, &start);
+		glGetInteger64v(GL_TIMESTAMP, &now);
+
+		float time = (GLuint64)now > start ? ((GLuint64)now - start) / 1000000.0f : 0.0f;
+		if (time <= m_budget)
+			return false;
+
+		if (m_tripped.insert(sub.Item).second)
+			trips.push_back({ sub.Item, time, true });
+		return true;
+	}
+	std::vector<PassWatchdog::Trip> PassWatchdog::Poll()
+	{
+		std::vector<Trip> ret;
+		for (int i = 0; i < m_pending.size(); i++) {
+			Submission& sub = m_pending[i];
+			bool old = m_frame - sub.Frame >= PASS_WATCHDOG_LATENCY;
+
+			// a tripped pass doesn't need to be checked again
+			if (m_tripped.count(sub.Item) > 0 || m_check(sub, old, ret)) {
+				m_free(sub);
+				m_pending.erase(m_pending.begin() + i);
+				i--;
+			}
+		}
+
+		m_frame++;
+		return ret;
+	}
+	void PassWatchdog::Release(PipelineItem* item)
+	{
+		m_tripped.erase(item);
+
+		for (int i = 0; i < m_pending.size(); i++)
+			if (m_pending[i].Item == item) {
+				m_free(m_pending[i]);
+				m_pending.erase(m_pending.begin() + i);
+				i--;
+			}
+	}
+	void PassWatchdog::Clear()
+	{
+		for (auto& sub : m_pending)
+			m_free(sub);
+		m_pending.clear();
+		m_tripped.clear();
+		m_current.Item = nullptr;
+	}
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include "PipelineItem.h"
+
+#include <chrono>
+#include <unordered_set>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/glew.h>
+#if defined(__APPLE__)
+	#include <OpenGL/gl.h>
+#else
+	#include <GL/gl.h>
+#endif
+
+#define PASS_WATCHDOG_LATENCY 2 // frames that a pass can still be in flight before Poll() waits for it
+
+namespace ed
+{
+	// finds the passes whose single submission takes longer than a budget (usually an accidental infinite loop) so that
+	// they can be turned off before more frames with them are queued - each pass is wrapped in timestamps & a fence,
+	// a pass that is still running on the GPU counts from its start timestamp
+	class PassWatchdog
+	{
+	public:
+		PassWatchdog();
+		~PassWatchdog();
+
+		inline void SetBudget(float ms) { m_budget = ms; }
+		inline bool IsEnabled() { return m_budget > 0.0f; }
+
+		void Begin(PipelineItem* item);
+		void End(PipelineItem* item);
+
+		struct Trip
+		{
+			PipelineItem* Item;
+			float Time;	  // ms, lower bound if the pass is still running
+			bool Running; // the GPU wasn't done with the pass yet
+		};
+		// checks the passes of the previous frames - waits for the ones that are PASS_WATCHDOG_LATENCY frames old,
+		// but never for longer than the budget. returns the passes that went over it, they are tripped until Release()
+		std::vector<Trip> Poll();
+
+		inline bool IsTripped(PipelineItem* item) { return m_tripped.count(item) > 0; }
+
+		void Release(PipelineItem* item); // removed, recompiled or turned off - also drops its pending submissions
+		void Clear();
+
+	private:
+		struct Submission
+		{
+			PipelineItem* Item;
+			GLuint Queries[2]; // start, end
+			GLsync Fence;
+			unsigned int Frame;
+		};
+		void m_free(Submission& sub);
+		bool m_check(Submission& sub, bool wait, std::vector<Trip>& trips); // true if the submission is done with
+
+		std::vector<Submission> m_pending;
+		std::vector<GLuint> m_queries; // free ones
+		std::unordered_set<PipelineItem*> m_tripped;
+
+		Submission m_current;
+		float m_budget;
+		unsigned int m_frame;
+	};
+}
@@ -65,12 +65,43 @@ namespace ed
 				memset(Entry, 0, sizeof(char) * 32);
 
 				WorkX = WorkY = WorkZ = 1;
+				IndirectBuffer = nullptr;
+				IndirectOffset = 0;
+				ConditionBuffer = nullptr;
+				ConditionOffset = 0;
+				Iterations = 1;
+				PingPong = false;
+				TickRate = 0.0f;
+
+				AutoBarrier = true;
+				Barrier = GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_UNIFORM_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT;
 			}
 
 			char Path[MAX_PATH];
 			char Entry[32];
 
 			GLuint WorkX, WorkY, WorkZ;
+
+			// if set, the group count is read from this buffer (3 uints at IndirectOffset) instead of WorkX/Y/Z
+			void* IndirectBuffer;
+			GLuint IndirectOffset;
+
+			// if set, the pass only runs while the uint at ConditionOffset of this buffer isn't 0 - decided on the GPU, see PassCondition
+			void* ConditionBuffer;
+			GLuint ConditionOffset;
+
+			// dispatch the pass multiple times per frame - with PingPong the objects in the first two UAV slots are swapped on odd iterations
+			GLuint Iterations;
+			bool PingPong;
+
+			// steps per second, independent of the preview's frame rate - each step dispatches the pass Iterations times,
+			// the steps that became due since the last frame are caught up on (0 -> one step every frame)
+			float TickRate;
+
+			// auto: a barrier is only issued once a later pass reads what this pass wrote, with the bits that reader needs
+			bool AutoBarrier;
+			GLbitfield Barrier; // issued right after the dispatch if AutoBarrier is off
+
 			ShaderVariableContainer Variables;
 			std::vector<ShaderMacro> Macros;
 		};
@@ -97,6 +128,16 @@ namespace ed
 				RTCount = 0;
 				GSUsed = false;
 				Active = true;
+				Multisample = true;
+				Accumulate = false;
+				AccumulateSamples = 256;
+				ResolutionScale = 1;
+				EdgeAwareUpsample = true;
+				ShadingRate = 0;
+				DepthPrepass = false;
+				Multiview = false;
+				ConditionBuffer = nullptr;
+				ConditionOffset = 0;
 				Macros.clear();
 				memset(VSPath, 0, sizeof(char) * MAX_PATH);
 				memset(PSPath, 0, sizeof(char) * MAX_PATH);
@@ -104,6 +145,16 @@ namespace ed
 				memset(VSEntry, 0, sizeof(char) * 32);
 				memset(PSEntry, 0, sizeof(char) * 32);
 				memset(GSEntry, 0, sizeof(char) * 32);
+				MSUsed = TSUsed = false;
+				memset(MSPath, 0, sizeof(char) * MAX_PATH);
+				memset(TSPath, 0, sizeof(char) * MAX_PATH);
+				memset(MSEntry, 0, sizeof(char) * 32);
+				memset(TSEntry, 0, sizeof(char) * 32);
+				MeshletsPerTask = 1;
+				MeshTaskBuffer = nullptr;
+				MeshTaskOffset = 0;
+				CaptureBuffer = nullptr;
+				memset(CaptureOutputs, 0, sizeof(char) * 256);
 			}
 
 			GLbyte RTCount;
@@ -112,6 +163,30 @@ namespace ed
 			GLuint FBO; // actual framebuffer
 
 			bool Active;
+			bool Multisample; // false -> draws straight to the render textures even when Settings::Preview.MSAA is on
+
+			bool Accumulate; // render textures show the average of all frames since the inputs last changed
+			int AccumulateSamples; // stops drawing after this many frames, 0 -> never stops
+
+			int ResolutionScale; // 2 or 4 -> drawn at 1/2 or 1/4 of the render textures' size & upsampled into them, see ReducedResolution
+			bool EdgeAwareUpsample; // false -> bilinear
+
+			// coarse shading with GL_NV_shading_rate_image - index into SHADING_RATE_NAMES (0 = every pixel), the texels of the
+			// R8UI render texture or image (a tile per texel, see RenderEngine::GetShadingRateTexelSize()) pick the rate with the same indices
+			int ShadingRate;
+			std::string ShadingRateImage; // overrides ShadingRate
+
+			// the opaque items are first drawn with only the vertex shader so that the pixel shader runs once per visible pixel
+			bool DepthPrepass;
+
+			// both eyes in one draw with GL_OVR_multiview2 - the render textures have to be texture arrays with 2 layers, every
+			// draw goes to both of them & the shaders pick their view with gl_ViewID_OVR (the *Left/*Right system variables, or
+			// EyeView[]/EyeProjection[] of SHADERed_Globals), the directives are added to the shaders
+			bool Multiview;
+
+			// if set, the pass is only drawn while the uint at ConditionOffset of this buffer isn't 0 - decided on the GPU, see PassCondition
+			void* ConditionBuffer;
+			GLuint ConditionOffset;
 
 			char VSPath[MAX_PATH];
 			char VSEntry[32];
@@ -123,6 +198,28 @@ namespace ed
 			char GSEntry[32];
 			bool GSUsed;
 
+			// mesh shading (GL_NV_mesh_shader, GLSL only) - the mesh & the optional task shader replace the vertex & geometry shaders,
+			// the child models are drawn meshlet by meshlet (see eng::Model::Mesh::Meshlets) and the other children are skipped
+			char MSPath[MAX_PATH];
+			char MSEntry[32];
+			bool MSUsed;
+
+			char TSPath[MAX_PATH];
+			char TSEntry[32];
+			bool TSUsed;
+
+			GLuint MeshletsPerTask; // workgroups launched per mesh = ceil(meshlet count / MeshletsPerTask)
+
+			// if set, the launches are read from this buffer instead - a { count, first } pair of uints per mesh of every child model, in order
+			void* MeshTaskBuffer;
+			GLuint MeshTaskOffset;
+
+			// if set, the vertices are captured with transform feedback into this buffer once per frame & the later passes draw
+			// them as Captured geometry, see VertexCapture - CaptureOutputs: the vertex shader's output for each InputLayoutValue
+			// in order, separated with ';' (outPosition;outNormal;outUV) - the values with an empty name aren't written
+			void* CaptureBuffer;
+			char CaptureOutputs[256];
+
 			ShaderVariableContainer Variables;
 			std::vector<ShaderMacro> Macros;
 
@@ -145,6 +242,19 @@ namespace ed
 				Instanced = false;
 				InstanceCount = 0;
 				InstanceBuffer = nullptr;
+				VertexBuffer = nullptr;
+				OcclusionCulling = false;
+				FrustumCulling = true;
+				GPUCulling = false;
+				GenShape = 0;
+				GenResolution = glm::ivec2(64, 64);
+				GenAmplitude = 0.2f;
+				GenFrequency = 2.0f;
+				GenSeed = 0;
+				GenAnimated = false;
+				EBO = 0;
+				VertexCount = IndexCount = 0;
+				Dirty = false;
 			}
 			enum GeometryType {
 				Cube,
@@ -154,6 +264,8 @@ namespace ed
 				Sphere,
 				Plane,
 				ScreenQuadNDC,
+				Generated, // built by a compute shader, see GeometryGenerator
+				Captured, // the vertices that a shader pass captured into VertexBuffer, see VertexCapture
 				Count
 			} Type;
 
@@ -165,6 +277,22 @@ namespace ed
 			bool Instanced;
 			int InstanceCount;
 			void* InstanceBuffer;
+
+			void* VertexBuffer; // Captured - BufferObject with VERTEX_CAPTURE_STRIDE floats per vertex
+
+			bool OcclusionCulling; // skip the draw calls while an occlusion query says that nothing was visible
+			bool FrustumCulling; // skip the draw calls when the bounds are outside of the camera's view - turn off if the vertex shader moves the vertices
+			bool GPUCulling; // cull the instances on the GPU, see InstanceCuller
+
+			/* Generated - the item owns its buffers, they are filled again when Dirty is set or every frame with GenAnimated */
+			int GenShape; // GeometryGenerator::Shape
+			glm::ivec2 GenResolution; // cells of the grid & the terrain, segments & rings of the sphere, copies of the scatter
+			float GenAmplitude, GenFrequency; // height noise of the terrain & of the ground that the scatter is placed on
+			unsigned int GenSeed;
+			bool GenAnimated; // the noise moves with the time
+			GLuint EBO;
+			int VertexCount, IndexCount;
+			bool Dirty;
 		};
 
 		struct RenderState
@@ -241,6 +369,15 @@ namespace ed
 			bool Instanced;
 			int InstanceCount;
 			void* InstanceBuffer;
+
+			int LOD; // -1 -> pick by the size on screen, 0 -> full detail
+			bool FrustumCulling; // same as GeometryItem::FrustumCulling
+			bool GPUCulling;
+
+			// skinned models only, empty -> bind pose - the pose is shared by all items that draw the same file,
+			// the first one in the pipeline decides it
+			char Animation[MODEL_GROUP_NAME_LENGTH];
+			float AnimationSpeed;
 		};
 	}
 }
\ No newline at end of file
@@ -1,9 +1,18 @@
 #include "PipelineManager.h"
 #include "ProjectParser.h"
 #include "Logger.h"
+#include "GeometryCache.h"
 #include "../Options.h"
 #include "SystemVariableManager.h"
 
+static std::string lowercase(const char* str)
+{
+	std::string ret(str);
+	for (auto& c : ret)
+		c = tolower((unsigned char)c);
+	return ret;
+}
+
 int strcmpcase(const char* s1, const char* s2)
 {
 	const unsigned char* p1 = (const unsigned char*)s1;
@@ -22,6 +31,8 @@ namespace ed
 	PipelineManager::PipelineManager(ProjectParser* project)
 	{
 		m_project = project;
+		m_generation = 0;
+		m_indexValid = false;
 	}
 	PipelineManager::~PipelineManager()
 	{
@@ -38,8 +49,7 @@ namespace ed
 				for (auto& passItem : pass->Items) {
 					if (passItem->Type == PipelineItem::ItemType::Geometry) {
 						pipe::GeometryItem* geo = (pipe::GeometryItem*)passItem->Data;
-						glDeleteVertexArrays(1, &geo->VAO);
-						glDeleteVertexArrays(1, &geo->VBO);
+						GeometryCache::Instance().Release(geo);
 					}
 					else if (passItem->Type == PipelineItem::ItemType::PluginItem) {
 						pipe::PluginItemData* pdata = (pipe::PluginItemData*)passItem->Data;
@@ -65,8 +75,7 @@ namespace ed
 				for (auto& passItem : pdata->Items) {
 					if (passItem->Type == PipelineItem::ItemType::Geometry) {
 						pipe::GeometryItem* geo = (pipe::GeometryItem*)passItem->Data;
-						glDeleteVertexArrays(1, &geo->VAO);
-						glDeleteVertexArrays(1, &geo->VBO);
+						GeometryCache::Instance().Release(geo);
 					}
 					else if (passItem->Type == PipelineItem::ItemType::PluginItem) {
 						pipe::PluginItemData* pldata = (pipe::PluginItemData*)passItem->Data;
@@ -78,11 +87,14 @@ namespace ed
 				}
 			}
 
+			Notify(EventType::ItemRemoved, m_items[i]);
+
 			// delete passes and their data
 			FreeData(m_items[i]->Data, m_items[i]->Type);
 			delete m_items[i];
 		}
 		m_items.clear();
+		m_indexValid = false;
 	}
 	bool PipelineManager::AddItem(const char * owner, const char * name, PipelineItem::ItemType type, void * data)
 	{
@@ -124,6 +136,9 @@ namespace ed
 
 				pdata->Owner->AddPipelineItemChild(owner, name, (plugin::PipelineItemType)type, data);
 
+				m_addToIndex(pdata->Items.back(), item);
+				Notify(EventType::ItemAdded, pdata->Items.back());
+
 				return true;
 			}
 			else if (item->Type == PipelineItem::ItemType::ShaderPass) {
@@ -138,6 +153,9 @@ namespace ed
 				pass->Items.push_back(new PipelineItem("\0", type, data));
 				strcpy(pass->Items.at(pass->Items.size() - 1)->Name, name);
 
+				m_addToIndex(pass->Items.back(), item);
+				Notify(EventType::ItemAdded, pass->Items.back());
+
 				Logger::Get().Log("Item " + std::string(name) + " added to the project");
 
 				return true;
@@ -180,6 +198,9 @@ namespace ed
 					plPass->Owner->AddPipelineItemChild(owner, pitem->Name, plugin::PipelineItemType::PluginItem, data);
 				}
 
+				m_addToIndex(pitem, item);
+				Notify(EventType::ItemAdded, pitem);
+
 				Logger::Get().Log("Item " + std::string(name) + " added to the project");
 
 				return true;
@@ -194,6 +215,9 @@ namespace ed
 			m_items.push_back(pitem);
 			strcpy(pitem->Name, name);
 
+			m_addToIndex(pitem, nullptr);
+			Notify(EventType::ItemAdded, pitem);
+
 			return true;
 		}
 
@@ -213,6 +237,9 @@ namespace ed
 		m_items.push_back(new PipelineItem("\0", PipelineItem::ItemType::ShaderPass, data));
 		strcpy(m_items.at(m_items.size() - 1)->Name, name);
 
+		m_addToIndex(m_items.back(), nullptr);
+		Notify(EventType::ItemAdded, m_items.back());
+
 		return true;
 	}
 	bool PipelineManager::AddComputePass(const char *name, pipe::ComputePass *data)
@@ -229,6 +256,9 @@ namespace ed
 		m_items.push_back(new PipelineItem("\0", PipelineItem::ItemType::ComputePass, data));
 		strcpy(m_items.at(m_items.size() - 1)->Name, name);
 
+		m_addToIndex(m_items.back(), nullptr);
+		Notify(EventType::ItemAdded, m_items.back());
+
 		return true;
 	}
 	bool PipelineManager::AddAudioPass(const char *name, pipe::AudioPass *data)
@@ -245,6 +275,9 @@ namespace ed
 		m_items.push_back(new PipelineItem("\0", PipelineItem::ItemType::AudioPass, data));
 		strcpy(m_items.at(m_items.size() - 1)->Name, name);
 
+		m_addToIndex(m_items.back(), nullptr);
+		Notify(EventType::ItemAdded, m_items.back());
+
 		return true;
 	}
 	void PipelineManager::Remove(const char* name)
@@ -261,8 +294,7 @@ namespace ed
 					for (auto& passItem : data->Items) {
 						if (passItem->Type == PipelineItem::ItemType::Geometry) {
 							pipe::GeometryItem* geo = (pipe::GeometryItem*)passItem->Data;
-							glDeleteVertexArrays(1, &geo->VAO);
-							glDeleteVertexArrays(1, &geo->VBO);
+							GeometryCache::Instance().Release(geo);
 						}
 						else if (passItem->Type == PipelineItem::ItemType::PluginItem) {
 							pipe::PluginItemData* pdata = (pipe::PluginItemData*)passItem->Data;
@@ -285,8 +317,7 @@ namespace ed
 					for (auto& passItem : pdata->Items) {
 						if (passItem->Type == PipelineItem::ItemType::Geometry) {
 							pipe::GeometryItem* geo = (pipe::GeometryItem*)passItem->Data;
-							glDeleteVertexArrays(1, &geo->VAO);
-							glDeleteVertexArrays(1, &geo->VBO);
+							GeometryCache::Instance().Release(geo);
 						}
 						else if (passItem->Type == PipelineItem::ItemType::PluginItem) {
 							pipe::PluginItemData* pldata = (pipe::PluginItemData*)passItem->Data;
@@ -299,6 +330,8 @@ namespace ed
 					pdata->Items.clear();
 				}
 
+				Notify(EventType::ItemRemoved, m_items[i]);
+
 				FreeData(m_items[i]->Data, m_items[i]->Type);
 				m_items[i]->Data = nullptr;
 				m_items.erase(m_items.begin() + i);
@@ -312,8 +345,7 @@ namespace ed
 							ed::PipelineItem* child = data->Items[j];
 							if (child->Type == PipelineItem::ItemType::Geometry) {
 								pipe::GeometryItem* geo = (pipe::GeometryItem*)child->Data;
-								glDeleteVertexArrays(1, &geo->VAO);
-								glDeleteVertexArrays(1, &geo->VBO);
+								GeometryCache::Instance().Release(geo);
 							}
 
 							if (data->Items[j]->Type == PipelineItem::ItemType::PluginItem) {
@@ -321,6 +353,8 @@ namespace ed
 								pdata->Owner->RemovePipelineItem(data->Items[j]->Name, pdata->Type, pdata->PluginData);
 							}
 
+							Notify(EventType::ItemRemoved, data->Items[j]);
+
 							FreeData(data->Items[j]->Data, data->Items[j]->Type);
 							data->Items[j]->Data = nullptr;
 							data->Items.erase(data->Items.begin() + j);
@@ -336,8 +370,7 @@ namespace ed
 							ed::PipelineItem* child = data->Items[j];
 							if (child->Type == PipelineItem::ItemType::Geometry) {
 								pipe::GeometryItem* geo = (pipe::GeometryItem*)child->Data;
-								glDeleteVertexArrays(1, &geo->VAO);
-								glDeleteVertexArrays(1, &geo->VBO);
+								GeometryCache::Instance().Release(geo);
 							}
 
 							if (data->Items[j]->Type == PipelineItem::ItemType::PluginItem) {
@@ -345,6 +378,8 @@ namespace ed
 								pdata->Owner->RemovePipelineItem(data->Items[j]->Name, pdata->Type, pdata->PluginData);
 							}
 
+							Notify(EventType::ItemRemoved, data->Items[j]);
+
 							FreeData(data->Items[j]->Data, data->Items[j]->Type);
 							data->Items[j]->Data = nullptr;
 							data->Items.erase(data->Items.begin() + j);
@@ -354,56 +389,33 @@ namespace ed
 				}
 			}
 		}
+
+		// Notify() was called before the item was erased
+		m_indexValid = false;
 			
 		m_project->ModifyProject();
 	}
 	bool PipelineManager::Has(const char * name)
 	{
-		for (int i = 0; i < m_items.size(); i++) {
-			if (strcmpcase(m_items[i]->Name, name) == 0)
-				return true;
-			else {
-				if (m_items[i]->Type == PipelineItem::ItemType::ShaderPass) {
-					pipe::ShaderPass* data = (pipe::ShaderPass*)m_items[i]->Data;
-					for (int j = 0; j < data->Items.size(); j++)
-						if (strcmpcase(data->Items[j]->Name, name) == 0)
-							return true;
-				} else if (m_items[i]->Type == PipelineItem::ItemType::PluginItem) {
-					pipe::PluginItemData* data = (pipe::PluginItemData*)m_items[i]->Data;
-					for (int j = 0; j < data->Items.size(); j++)
-						if (strcmpcase(data->Items[j]->Name, name) == 0)
-							return true;
-				}
-			}
-		}
-		return false;
+		m_updateIndex();
+		return m_lowerNames.count(lowercase(name)) > 0;
 	}
 	char* PipelineManager::GetItemOwner(const char* name)
 	{
-		for (int i = 0; i < m_items.size(); i++) {
-			if (m_items[i]->Type == PipelineItem::ItemType::ShaderPass) {
-				pipe::ShaderPass* data = (pipe::ShaderPass*)m_items[i]->Data;
-				for (int j = 0; j < data->Items.size(); j++)
-					if (strcmp(data->Items[j]->Name, name) == 0)
-						return m_items[i]->Name;
-			}
-		}
+		m_updateIndex();
+
+		auto it = m_owners.find(name);
+		if (it != m_owners.end())
+			return it->second->Name;
 		return nullptr;
 	}
 	PipelineItem* PipelineManager::Get(const char* name)
 	{
-		for (int i = 0; i < m_items.size(); i++) {
-			if (strcmp(m_items[i]->Name, name) == 0)
-				return m_items[i];
-			else {
-				if (m_items[i]->Type == PipelineItem::ItemType::ShaderPass) {
-					pipe::ShaderPass* data = (pipe::ShaderPass*)m_items[i]->Data;
-					for (int j = 0; j < data->Items.size(); j++)
-						if (strcmp(data->Items[j]->Name, name) == 0)
-							return data->Items[j];
-				}
-			}
-		}
+		m_updateIndex();
+
+		auto it = m_index.find(name);
+		if (it != m_index.end())
+			return it->second;
 		return nullptr;
 	}
 	void PipelineManager::New(bool openTemplate)
@@ -420,6 +432,54 @@ namespace ed
 		// reset time, frame index, etc...
 		SystemVariableManager::Instance().Reset();
 	}
+	void PipelineManager::Notify(EventType type, PipelineItem* item)
+	{
+		m_generation++;
+
+		// added items are already indexed, everything else can change the names or where the items are
+		if (type != EventType::ItemAdded)
+			m_indexValid = false;
+
+		for (const auto& handler : m_handlers)
+			handler(type, item);
+	}
+	void PipelineManager::m_addToIndex(PipelineItem* item, PipelineItem* owner)
+	{
+		if (!m_indexValid)
+			return;
+
+		m_lowerNames.insert(lowercase(item->Name));
+
+		// Get() doesn't look into the plugin items
+		if (owner == nullptr || owner->Type == PipelineItem::ItemType::ShaderPass)
+			m_index.emplace(item->Name, item);
+		if (owner != nullptr && owner->Type == PipelineItem::ItemType::ShaderPass)
+			m_owners.emplace(item->Name, owner);
+	}
+	void PipelineManager::m_updateIndex()
+	{
+		if (m_indexValid)
+			return;
+
+		m_index.clear();
+		m_owners.clear();
+		m_lowerNames.clear();
+		m_indexValid = true;
+
+		for (PipelineItem* item : m_items) {
+			m_addToIndex(item, nullptr);
+
+			if (item->Type == PipelineItem::ItemType::ShaderPass) {
+				pipe::ShaderPass* data = (pipe::ShaderPass*)item->Data;
+				for (PipelineItem* child : data->Items)
+					m_addToIndex(child, item);
+			} else if (item->Type == PipelineItem::ItemType::PluginItem) {
+				pipe::PluginItemData* data = (pipe::PluginItemData*)item->Data;
+				for (PipelineItem* child : data->Items)
+					m_addToIndex(child, item);
+			}
+		}
+	}
 	void PipelineManager::FreeData(void* data, PipelineItem::ItemType type)
 	{
 		//TODO: make it type-safe.
@@ -1,5 +1,9 @@
 #pragma once
 #include <vector>
+#include <string>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
 #include "../Options.h"
 #include "PipelineItem.h"
 
@@ -10,6 +14,14 @@ namespace ed
 	class PipelineManager
 	{
 	public:
+		enum class EventType
+		{
+			ItemAdded,
+			ItemRemoved,
+			ItemMoved,
+			ItemRenamed
+		};
+		typedef std::function<void(EventType, PipelineItem*)> EventHandler;
 
 		PipelineManager(ProjectParser* project);
 		~PipelineManager();
@@ -31,7 +43,22 @@ namespace ed
 
 		void FreeData(void* data, PipelineItem::ItemType type);
 
+		// anyone who modifies the list returned by GetList() directly has to call Notify()
+		inline void Subscribe(const EventHandler& handler) { m_handlers.push_back(handler); }
+		void Notify(EventType type, PipelineItem* item);
+		inline unsigned int GetGeneration() { return m_generation; }
+
 	private:
+		std::vector<EventHandler> m_handlers;
+		unsigned int m_generation;
+
+		/* name lookups - new items are added directly, anything else rebuilds the index on the next lookup */
+		bool m_indexValid;
+		std::unordered_map<std::string, PipelineItem*> m_index;  // passes and shader pass children by their exact name
+		std::unordered_map<std::string, PipelineItem*> m_owners; // shader pass child -> shader pass
+		std::unordered_set<std::string> m_lowerNames;			  // every item, Has() ignores the case
+		void m_addToIndex(PipelineItem* item, PipelineItem* owner);
+		void m_updateIndex();
 
 		ProjectParser* m_project;
 		std::vector<PipelineItem*> m_items;
@@ -72,6 +72,18 @@ namespace ed
 		typedef bool (*GetOpenDirectoryDialogFn)(char* out);
 		typedef bool (*GetOpenFileDialogFn)(char* out, const char* files);
 		typedef bool (*GetSaveFileDialogFn)(char* out, const char* files);
+
+		// API version 2
+		typedef void (*JobFn)(void* userData);
+		typedef bool (*SubmitJobFn)(void* plugins, void* owner, JobFn job, JobFn done, void* userData); // job runs on a worker thread, done (can be nullptr) on the main/GL thread
+		typedef void (*WaitForJobsFn)(void* plugins, void* owner); // blocks until all of the owner's jobs are done and their callbacks have been called
+		typedef int (*GetWorkerCountFn)(void* plugins);
+		typedef bool (*ReadBufferAsyncFn)(void* objects, const char* name, int offset, int size);
+		typedef bool (*ReadImageAsyncFn)(void* objects, const char* name, int x, int y, int width, int height); // RGBA float texels
+		typedef const void* (*MapReadbackFn)(void* objects, const char* name, int& size); // nullptr until the GPU has finished the copy
+		typedef void* (*MapBufferWriteFn)(void* objects, const char* name, int offset, int size);
+		typedef void (*FlushBufferWriteFn)(void* objects, const char* name, int offset, int size); // offset is relative to the mapped range
+		typedef void (*UnmapObjectFn)(void* objects, const char* name);
 	}
 
 	// CreatePlugin(), DestroyPlugin(ptr), GetPluginAPIVersion(), GetPluginVersion(), GetPluginName()
@@ -253,5 +265,33 @@ namespace ed
 		pluginfn::GetOpenDirectoryDialogFn GetOpenDirectoryDialog;
 		pluginfn::GetOpenFileDialogFn GetOpenFileDialog;
 		pluginfn::GetSaveFileDialogFn GetSaveFileDialog;
+
+		// API version 2 - only set for plugins that report GetPluginAPIVersion() >= 2 since older plugins don't allocate these members
+		// jobs share SHADERed's worker threads so that the plugins don't have to create their own
+		void* Plugins;
+		pluginfn::SubmitJobFn SubmitJob;
+		pluginfn::WaitForJobsFn WaitForJobs;
+		pluginfn::GetWorkerCountFn GetWorkerCount;
+
+		// objects can be read without waiting for the GPU (copy -> fence -> map) and buffers can be written without a CPU copy
+		// write mappings have to be unmapped before the frame is rendered, they are unmapped automatically otherwise
+		// texture ids from GetTexture() are shared with the plugins, they live in the same GL context
+		pluginfn::ReadBufferAsyncFn ReadBufferAsync;
+		pluginfn::ReadImageAsyncFn ReadImageAsync;
+		pluginfn::MapReadbackFn MapReadback;
+		pluginfn::MapBufferWriteFn MapBufferWrite;
+		pluginfn::FlushBufferWriteFn FlushBufferWrite;
+		pluginfn::UnmapObjectFn UnmapObject;
+	};
+
+	// API version 3 - plugins that report GetPluginAPIVersion() >= 3 have to derive from this class
+	// batched system variables: the values of all the plugin's variables live in one block that SHADERed allocates
+	// and that the plugin fills once per frame, the binds then copy from the block instead of calling UpdateSystemVariableValue()
+	class IPlugin3 : public IPlugin
+	{
+	public:
+		virtual int GetSystemVariableBlockSize() = 0; // in bytes, queried once after Init()
+		virtual int GetSystemVariableOffset(const char* name, plugin::VariableType varType, bool isLastFrame) = 0; // -1 = not in the block, UpdateSystemVariableValue() is used for it
+		virtual void UpdateSystemVariableBlock(char* block) = 0; // called once per frame, before BeginRender()
 	};
 }
\ No newline at end of file
@@ -1,7 +1,9 @@
 #include "PluginManager.h"
+#include "PluginProfiler.h"
 #include "../Logger.h"
 #include "../Settings.h"
 #include "../DefaultState.h"
+#include "../GLStateCache.h"
 #include "../SystemVariableManager.h"
 #include "../../InterfaceManager.h"
 #include "../../GUIManager.h"
@@ -12,8 +14,10 @@
 #include "../../UI/PipelineUI.h"
 #include "../../UI/ObjectPreviewUI.h"
 #include "../../UI/UIHelper.h"
+#include "../UIRefresh.h"
 
 #include <algorithm>
+#include <thread>
 #include <imgui/imgui.h>
 #include <ghc/filesystem.hpp>
 
@@ -31,426 +35,491 @@ namespace ed
 
 	void PluginManager::OnEvent(const SDL_Event& e)
 	{
-		for (const auto& plugin : m_plugins)
-			plugin->OnEvent((void*)&e);
+		for (int i = 0; i < m_plugins.size(); i++)
+			if (m_isInitialized[i])
+				m_plugins[i]->OnEvent((void*)&e);
 	}
-	void PluginManager::Init(InterfaceManager* data, GUIManager* ui)
+	struct PluginLibrary
+	{
+		std::string Directory, File;
+		void* Proc;
+		int APIVersion, Version;
+		std::string Name;
+		CreatePluginFn Create;
+	};
+	static void* getPluginSymbol(void* proc, const char* name)
 	{
-		if (!ghc::filesystem::exists("./plugins/")) {
-			ed::Logger::Get().Log("Directory for plugins doesn't exist");
-			return;
-		}
-
-		ImGuiContext* uiCtx = ImGui::GetCurrentContext();
-
-		for (const auto& entry : ghc::filesystem::directory_iterator("./plugins/")) {
-			if (entry.is_directory()) {
-				std::string pdir = entry.path().filename().native();
-
-				// TODO: linux
 #if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
-				void* procDLL = dlopen(("./plugins/" + pdir + "/plugin.so").c_str(), RTLD_NOW);
-
-				if (!procDLL) {
-					ed::Logger::Get().Log("dlopen(\"" + pdir + "/plugin.so\") has failed.");
-					continue;
-				}
+		return dlsym(proc, name);
+#else
+		return (void*)GetProcAddress((HINSTANCE)proc, name);
+#endif
+	}
+	static void closePluginLibrary(void* proc)
+	{
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+		dlclose(proc);
+#else
+		FreeLibrary((HINSTANCE)proc);
+#endif
+	}
+	// doesn't touch ImGui, OpenGL or the PluginManager so that it can run on the loader thread
+	static bool openPluginLibrary(PluginLibrary& lib)
+	{
+#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
+		lib.File = lib.Directory + "/plugin.so";
+		lib.Proc = dlopen(("./plugins/" + lib.File).c_str(), RTLD_NOW);
 
-				// GetPluginAPIVersion() function
-				GetPluginAPIVersionFn fnGetPluginAPIVersion = (GetPluginAPIVersionFn)dlsym(procDLL, "GetPluginAPIVersion");
-				if (!fnGetPluginAPIVersion) {
-					ed::Logger::Get().Log(pdir + "/plugin.so doesn't contain GetPluginAPIVersion.", true);
-					dlclose(procDLL);
-					continue;
-				}
+		if (!lib.Proc) {
+			ed::Logger::Get().Log("dlopen(\"" + lib.File + "\") has failed.");
+			return false;
+		}
+#else
+		lib.File = lib.Directory + "/plugin.dll";
+		lib.Proc = (void*)LoadLibraryA(("./plugins/" + lib.File).c_str());
 
-				int apiVer = (*fnGetPluginAPIVersion)();
-				m_apiVersion.push_back(apiVer);
+		if (!lib.Proc) {
+			ed::Logger::Get().Log("LoadLibraryA(\"" + lib.File + "\") has failed.");
+			return false;
+		}
+#endif
 
-				// GetPluginAPIVersion() function
-				GetPluginVersionFn fnGetPluginVersion = (GetPluginVersionFn)dlsym(procDLL, "GetPluginVersion");
-				if (!fnGetPluginVersion) {
-					ed::Logger::Get().Log(pdir + "/plugin.so doesn't contain GetPluginVersion.", true);
-					dlclose(procDLL);
-					continue;
-				}
+		GetPluginAPIVersionFn fnGetPluginAPIVersion = (GetPluginAPIVersionFn)getPluginSymbol(lib.Proc, "GetPluginAPIVersion");
+		GetPluginVersionFn fnGetPluginVersion = (GetPluginVersionFn)getPluginSymbol(lib.Proc, "GetPluginVersion");
+		GetPluginNameFn fnGetPluginName = (GetPluginNameFn)getPluginSymbol(lib.Proc, "GetPluginName");
+		lib.Create = (CreatePluginFn)getPluginSymbol(lib.Proc, "CreatePlugin");
+
+		const char* missing = nullptr;
+		if (!fnGetPluginAPIVersion)
+			missing = "GetPluginAPIVersion";
+		else if (!fnGetPluginVersion)
+			missing = "GetPluginVersion";
+		else if (!lib.Create)
+			missing = "CreatePlugin";
+		else if (!fnGetPluginName)
+			missing = "GetPluginName";
+
+		if (missing) {
+			ed::Logger::Get().Log(lib.File + " doesn't contain " + missing + ".", true);
+			closePluginLibrary(lib.Proc);
+			lib.Proc = nullptr;
+			return false;
+		}
 
-				int pluginVersion = (*fnGetPluginVersion)();
-				m_pluginVersion.push_back(pluginVersion);
+		lib.APIVersion = (*fnGetPluginAPIVersion)();
+		lib.Version = (*fnGetPluginVersion)();
+		lib.Name = (*fnGetPluginName)();
 
-				// CreatePlugin() function
-				CreatePluginFn fnCreatePlugin = (CreatePluginFn)dlsym(procDLL, "CreatePlugin");
-				if (!fnCreatePlugin) {
-					ed::Logger::Get().Log(pdir + "/plugin.so doesn't contain CreatePlugin.", true);
-					dlclose(procDLL);
-					continue;
-				}
+		return true;
+	}
 
-				// GetPluginName() function
-				GetPluginNameFn fnGetPluginName = (GetPluginNameFn)dlsym(procDLL, "GetPluginName");
-				if (!fnGetPluginName) {
-					ed::Logger::Get().Log(pdir + "/plugin.so doesn't contain GetPluginName.", true);
-					dlclose(procDLL);
-					continue;
-				}
+	void PluginManager::Init(InterfaceManager* data, GUIManager* ui)
+	{
+		if (!ghc::filesystem::exists("./plugins/")) {
+			ed::Logger::Get().Log("Directory for plugins doesn't exist");
+			return;
+		}
 
-				// create the actual plugin
-				IPlugin* plugin = (*fnCreatePlugin)(uiCtx);
-				if (plugin == nullptr) {
-					ed::Logger::Get().Log(pdir + "/plugin.so CreatePlugin returned nullptr.", true);
-					dlclose(procDLL);
-					continue;
-				}
-#else
-				HINSTANCE procDLL = LoadLibraryA(std::string("./plugins/" + pdir + "/plugin.dll").c_str());
+		ImGuiContext* uiCtx = ImGui::GetCurrentContext();
 
-				if (!procDLL) {
-					ed::Logger::Get().Log("LoadLibraryA(\"" + pdir + "/plugin.dll\") has failed.");
-					continue;
-				}
+		std::vector<PluginLibrary> libs;
+		for (const auto& entry : ghc::filesystem::directory_iterator("./plugins/"))
+			if (entry.is_directory()) {
+				PluginLibrary lib;
+				lib.Directory = entry.path().filename().native();
+				lib.Proc = nullptr;
+				libs.push_back(lib);
+			}
 
-				// GetPluginAPIVersion() function
-				GetPluginAPIVersionFn fnGetPluginAPIVersion = (GetPluginAPIVersionFn)GetProcAddress(procDLL, "GetPluginAPIVersion");
-				if (!fnGetPluginAPIVersion) {
-					ed::Logger::Get().Log(pdir + "/plugin.dll doesn't contain GetPluginAPIVersion.", true);
-					FreeLibrary(procDLL);
-					continue;
+		// the libraries are opened on another thread while the main thread creates & initializes
+		// the ones that are already open - CreatePlugin() and Init() can use ImGui and OpenGL
+		std::mutex loadMutex;
+		std::condition_variable loadSignal;
+		size_t loaded = 0;
+		std::thread loader([&]() {
+			for (size_t i = 0; i < libs.size(); i++) {
+				openPluginLibrary(libs[i]);
+
+				{
+					std::lock_guard<std::mutex> lock(loadMutex);
+					loaded = i + 1;
 				}
+				loadSignal.notify_one();
+			}
+		});
 
-				int apiVer = (*fnGetPluginAPIVersion)();
-				m_apiVersion.push_back(apiVer);
+		// list of loaded plugins
+		std::vector<std::string> notLoaded = Settings::Instance().Plugins.NotLoaded;
 
-				// GetPluginVersion() function
-				GetPluginVersionFn fnGetPluginVersion = (GetPluginVersionFn)GetProcAddress(procDLL, "GetPluginVersion");
-				if (!fnGetPluginVersion) {
-					ed::Logger::Get().Log(pdir + "/plugin.dll doesn't contain GetPluginVersion.", true);
-					FreeLibrary(procDLL);
-					continue;
-				}
-
-				int pluginVer = (*fnGetPluginVersion)();
-				m_pluginVersion.push_back(pluginVer);
+		for (size_t l = 0; l < libs.size(); l++) {
+			{
+				std::unique_lock<std::mutex> lock(loadMutex);
+				loadSignal.wait(lock, [&]() { return loaded > l; });
+			}
 
-				// CreatePlugin() function
-				CreatePluginFn fnCreatePlugin = (CreatePluginFn)GetProcAddress(procDLL, "CreatePlugin");
-				if (!fnCreatePlugin) {
-					ed::Logger::Get().Log(pdir + "/plugin.dll doesn't contain CreatePlugin.", true);
-					FreeLibrary(procDLL);
-					continue;
-				}
+			PluginLibrary& lib = libs[l];
+			if (!lib.Proc)
+				continue;
 
-				// GetPluginName() function
-				GetPluginNameFn fnGetPluginName = (GetPluginNameFn)GetProcAddress(procDLL, "GetPluginName");
-				if (!fnGetPluginName) {
-					ed::Logger::Get().Log(pdir + "/plugin.dll doesn't contain GetPluginName.", true);
-					FreeLibrary(procDLL);
-					continue;
-				}
+			// create the actual plugin
+			IPlugin* plugin = (*lib.Create)(uiCtx);
+			if (plugin == nullptr) {
+				ed::Logger::Get().Log(lib.File + " CreatePlugin returned nullptr.", true);
+				closePluginLibrary(lib.Proc);
+				continue;
+			}
 
-				// create the actual plugin
-				IPlugin* plugin = (*fnCreatePlugin)(uiCtx);
-				if (plugin == nullptr) {
-					ed::Logger::Get().Log(pdir + "/plugin.dll CreatePlugin returned nullptr.", true);
-					FreeLibrary(procDLL);
-					continue;
+			int apiVer = lib.APIVersion;
+			std::string pname = lib.Name;
+
+			// set up pointers to app functions
+			plugin->ObjectManager = (void*)&data->Objects;
+			plugin->PipelineManager = (void*)&data->Pipeline;
+			plugin->Renderer = (void*)&data->Renderer;
+			plugin->Messages = (void*)&data->Messages;
+			plugin->Project = (void*)&data->Parser;
+			plugin->CodeEditor = (void*)(ui->Get(ViewID::Code));
+			plugin->UI = (void*)ui;
+
+			plugin->AddObject = [](void* objectManager, const char* name, const char* type, void* data, unsigned int id, void* owner) {
+				ObjectManager* objm = (ObjectManager*)objectManager;
+				objm->CreatePluginItem(name, type, data, id, (IPlugin*)owner);
+			};
+			plugin->AddCustomPipelineItem = [](void* pipeManager, void* parentPtr, const char* name, const char* type, void* data, void* owner) -> bool {
+				PipelineManager* pipe = (PipelineManager*)pipeManager;
+				PipelineItem* parent = (PipelineItem*)parentPtr;
+				char* parentName = nullptr;
+
+				if (parent != nullptr)
+					parentName = parent->Name;
+
+				return pipe->AddPluginItem(parentName, name, type, data, (IPlugin*)owner);
+			};
+			plugin->AddMessage = [](void* messages, plugin::MessageType mtype, const char* group, const char* txt, int ln) {
+				MessageStack* msgs = (MessageStack*)messages;
+				msgs->Add((MessageStack::Type)mtype, group, txt, ln);
+			};
+			plugin->CreateRenderTexture = [](void* objects, const char* name) -> bool {
+				ObjectManager* objs = (ObjectManager*)objects;
+				return objs->CreateRenderTexture(name);
+			};
+			plugin->CreateImage = [](void* objects, const char* name, int width, int height) -> bool {
+				ObjectManager* objs = (ObjectManager*)objects;
+				return objs->CreateImage(name, glm::ivec2(width, height));
+			};
+			plugin->ResizeRenderTexture = [](void* objects, const char* name, int width, int height) {
+				ObjectManager* objs = (ObjectManager*)objects;
+				objs->ResizeRenderTexture(name, glm::ivec2(width, height));
+			};
+			plugin->ResizeImage = [](void* objects, const char* name, int width, int height) {
+				ObjectManager* objs = (ObjectManager*)objects;
+				objs->ResizeImage(name, glm::ivec2(width, height));
+			};
+			plugin->ExistsObject = [](void* objects, const char* name) -> bool {
+				ObjectManager* objs = (ObjectManager*)objects;
+				return objs->Exists(name);
+			};
+			plugin->RemoveGlobalObject = [](void* objects, const char* name) {
+				ObjectManager* objs = (ObjectManager*)objects;
+				objs->Remove(name);
+			};
+			plugin->GetProjectPath = [](void* project, const char* filename, char* out) {
+				ProjectParser* proj = (ProjectParser*)project;
+				std::string path = proj->GetProjectPath(filename);
+				strcpy(out, path.c_str());
+			};
+			plugin->GetRelativePath = [](void* project, const char* filename, char* out) {
+				ProjectParser* proj = (ProjectParser*)project;
+				std::string path = proj->GetRelativePath(filename);
+				strcpy(out, path.c_str());
+			};
+			plugin->GetProjectFilename = [](void* project, char* out) {
+				ProjectParser* proj = (ProjectParser*)project;
+				std::string path = proj->GetOpenedFile();
+				strcpy(out, path.c_str());
+			};
+			plugin->GetProjectDirectory = [](void* project) -> const char* {
+				ProjectParser* proj = (ProjectParser*)project;
+				return proj->GetProjectDirectory().c_str();
+			};
+			plugin->IsProjectModified = [](void* project) -> bool {
+				ProjectParser* proj = (ProjectParser*)project;
+				return proj->IsProjectModified();
+			};
+			plugin->ModifyProject = [](void* project) {
+				ProjectParser* proj = (ProjectParser*)project;
+				proj->ModifyProject();
+			};
+			plugin->OpenProject = [](void* project, void* uiData, const char* filename) {
+				ProjectParser* proj = (ProjectParser*)project;
+				GUIManager* ui = (GUIManager*)uiData;
+
+				((CodeEditorUI*)ui->Get(ViewID::Code))->CloseAll();
+				((PinnedUI*)ui->Get(ViewID::Pinned))->CloseAll();
+				((PreviewUI*)ui->Get(ViewID::Preview))->Pick(nullptr);
+				((PropertyUI*)ui->Get(ViewID::Properties))->Open(nullptr);
+				((PipelineUI*)ui->Get(ViewID::Pipeline))->Reset();
+				((ObjectPreviewUI*)ui->Get(ViewID::ObjectPreview))->CloseAll();
+
+				proj->Open(filename);
+			};
+			plugin->SaveProject = [](void* project) {
+				ProjectParser* proj = (ProjectParser*)project;
+				proj->Save();
+			};
+			plugin->SaveAsProject = [](void* project, const char* filename, bool copyFiles) {
+				ProjectParser* proj = (ProjectParser*)project;
+				proj->SaveAs(filename, copyFiles);
+			};
+			plugin->IsPaused = [](void* renderer) -> bool {
+				RenderEngine* rend = (RenderEngine*)renderer;
+				return rend->IsPaused();
+			};
+			plugin->Pause = [](void* renderer, bool state) {
+				RenderEngine* rend = (RenderEngine*)renderer;
+				rend->Pause(state);
+			};
+			plugin->GetWindowColorTexture = [](void* renderer) -> unsigned int {
+				RenderEngine* rend = (RenderEngine*)renderer;
+				return rend->GetTexture();
+			};
+			plugin->GetWindowDepthTexture = [](void* renderer) -> unsigned int {
+				RenderEngine* rend = (RenderEngine*)renderer;
+				return rend->GetDepthTexture();
+			};
+			plugin->GetLastRenderSize = [](void* renderer, int& w, int& h) {
+				RenderEngine* rend = (RenderEngine*)renderer;
+				glm::ivec2 sz = rend->GetLastRenderSize();
+				w = sz.x;
+				h = sz.y;
+			};
+			plugin->Render = [](void* renderer, int w, int h) {
+				RenderEngine* rend = (RenderEngine*)renderer;
+				rend->Render(w, h);
+			};
+			plugin->ExistsPipelineItem = [](void* pipeline, const char* name) -> bool {
+				PipelineManager* pipe = (PipelineManager*)pipeline;
+				return pipe->Has(name);
+			};
+			plugin->GetPipelineItem = [](void* pipeline, const char* name) -> void* {
+				PipelineManager* pipe = (PipelineManager*)pipeline;
+				return (void*)pipe->Get(name);
+			};
+			plugin->BindShaderPassVariables = [](void* shaderpass, void* item) {
+				pipe::ShaderPass* data = (pipe::ShaderPass*)shaderpass;
+				data->Variables.Bind(item);
+			};
+			plugin->GetViewMatrix = [](float* out) {
+				glm::mat4 viewm = SystemVariableManager::Instance().GetViewMatrix();
+				memcpy(out, glm::value_ptr(viewm), sizeof(float) * 4 * 4);
+			};
+			plugin->GetProjectionMatrix = [](float* out) {
+				glm::mat4 projm = SystemVariableManager::Instance().GetProjectionMatrix();
+				memcpy(out, glm::value_ptr(projm), sizeof(float) * 4 * 4);
+			};
+			plugin->GetOrthographicMatrix = [](float* out) {
+				glm::mat4 orthom = SystemVariableManager::Instance().GetOrthographicMatrix();
+				memcpy(out, glm::value_ptr(orthom), sizeof(float) * 4 * 4);
+			};
+			plugin->GetViewportSize = [](float& w, float& h) {
+				glm::vec2 viewsize = SystemVariableManager::Instance().GetViewportSize();
+				w = viewsize.x;
+				h = viewsize.y;
+			};
+			plugin->AdvanceTimer = [](float t) {
+				SystemVariableManager::Instance().AdvanceTimer(t);
+			};
+			plugin->GetMousePosition = [](float& x, float& y) {
+				glm::vec2 mpos = SystemVariableManager::Instance().GetMousePosition();
+				x = mpos.x;
+				y = mpos.y;
+			};
+			plugin->GetFrameIndex = []() -> int {
+				return SystemVariableManager::Instance().GetFrameIndex();
+			};
+			plugin->GetTime = []() -> float {
+				return SystemVariableManager::Instance().GetTime();
+			};
+			plugin->SetGeometryTransform = [](void* item, float scale[3], float rota[3], float pos[3]) {
+				SystemVariableManager::Instance().SetGeometryTransform((PipelineItem*)item, glm::make_vec3(scale), glm::make_vec3(rota), glm::make_vec3(pos));
+			};
+			plugin->SetMousePosition = [](float x, float y) {
+				SystemVariableManager::Instance().SetMousePosition(x,y);
+			};
+			plugin->SetKeysWASD = [](bool w, bool a, bool s, bool d) {
+				SystemVariableManager::Instance().SetKeysWASD(w,a,s,d);
+			};
+			plugin->SetFrameIndex = [](int findex) {
+				SystemVariableManager::Instance().SetFrameIndex(findex);
+			};
+			plugin->GetDPI = []() -> float {
+				return Settings::Instance().DPIScale;
+			};
+			plugin->FileExists = [](void* project, const char* filename) -> bool {
+				ProjectParser* proj = (ProjectParser*)project;
+				return proj->FileExists(filename);
+			};
+			plugin->ClearMessageGroup = [](void* project, const char* group) {
+				MessageStack* msgs = (MessageStack*)project;
+				msgs->ClearGroup(group);
+			};
+			plugin->Log = [](const char* msg, bool error, const char* file, int line) {
+				printf(msg);
+				//ed::Logger::Get().Log(msg, error, file, line);
+			};
+			plugin->GetObjectCount = [](void* objects) -> int {
+				ObjectManager* obj = (ObjectManager*)objects;
+				return obj->GetObjects().size();
+			};
+			plugin->GetObjectName = [](void* objects, int index) -> const char* {
+				ObjectManager* obj = (ObjectManager*)objects;
+				return obj->GetObjects()[index].c_str();
+			};
+			plugin->IsTexture = [](void* objects, const char* name) -> bool {
+				ObjectManager* obj = (ObjectManager*)objects;
+				const auto& itemList = obj->GetItemDataList();
+				const auto& itemNames = obj->GetObjects();
+				int nameIndex = 0;
+
+				for (const auto& item : itemList) {
+					if (itemNames[nameIndex] == name)
+							return item->IsTexture;
+					nameIndex++;
 				}
-#endif
-
-				// list of loaded plugins
-				std::vector<std::string> notLoaded = Settings::Instance().Plugins.NotLoaded;
-				std::string pname = (*fnGetPluginName)();
-
-				// set up pointers to app functions
-				plugin->ObjectManager = (void*)&data->Objects;
-				plugin->PipelineManager = (void*)&data->Pipeline;
-				plugin->Renderer = (void*)&data->Renderer;
-				plugin->Messages = (void*)&data->Messages;
-				plugin->Project = (void*)&data->Parser;
-				plugin->CodeEditor = (void*)(ui->Get(ViewID::Code));
-				plugin->UI = (void*)ui;
-
-				plugin->AddObject = [](void* objectManager, const char* name, const char* type, void* data, unsigned int id, void* owner) {
-					ObjectManager* objm = (ObjectManager*)objectManager;
-					objm->CreatePluginItem(name, type, data, id, (IPlugin*)owner);
-				};
-				plugin->AddCustomPipelineItem = [](void* pipeManager, void* parentPtr, const char* name, const char* type, void* data, void* owner) -> bool {
-					PipelineManager* pipe = (PipelineManager*)pipeManager;
-					PipelineItem* parent = (PipelineItem*)parentPtr;
-					char* parentName = nullptr;
-
-					if (parent != nullptr)
-						parentName = parent->Name;
 
-					return pipe->AddPluginItem(parentName, name, type, data, (IPlugin*)owner);
-				};
-				plugin->AddMessage = [](void* messages, plugin::MessageType mtype, const char* group, const char* txt, int ln) {
-					MessageStack* msgs = (MessageStack*)messages;
-					msgs->Add((MessageStack::Type)mtype, group, txt, ln);
-				};
-				plugin->CreateRenderTexture = [](void* objects, const char* name) -> bool {
+				return false;
+			};
+			plugin->GetTexture = [](void* objects, const char* name) -> unsigned int {
+				ObjectManager* obj = (ObjectManager*)objects;
+				return obj->GetTexture(name);
+			};
+			plugin->GetFlippedTexture = [](void* objects, const char* name) -> unsigned int {
+				ObjectManager* obj = (ObjectManager*)objects;
+				return obj->GetFlippedTexture(name);
+			};
+			plugin->GetTextureSize = [](void* objects, const char* name, int& w, int& h) {
+				ObjectManager* obj = (ObjectManager*)objects;
+				glm::ivec2 tsize = obj->GetTextureSize(name);
+				w = tsize.x;
+				h = tsize.y;
+			};
+			plugin->BindDefaultState = []() {
+				GLStateCache::Instance().Invalidate();
+				DefaultState::Bind();
+			};
+			plugin->OpenInCodeEditor = [](void* codeed, void* item, const char* filename, int id) {
+				CodeEditorUI* editor = (CodeEditorUI*)codeed;
+				editor->OpenPluginCode((PipelineItem*)item, filename, id);
+			};
+			plugin->GetPipelineItemCount = [](void* pipeline) -> int {
+				PipelineManager* pipe = (PipelineManager*)pipeline;
+				return pipe->GetList().size();
+			};
+			plugin->GetPipelineItemType = [](void* pipeline, int index) -> plugin::PipelineItemType {
+				PipelineManager* pipe = (PipelineManager*)pipeline;
+				return (plugin::PipelineItemType)pipe->GetList()[index]->Type;
+			};
+			plugin->GetPipelineItemByIndex = [](void* pipeline, int index) -> void* {
+				PipelineManager* pipe = (PipelineManager*)pipeline;
+				return (void*)pipe->GetList()[index];
+			};
+			plugin->GetOpenDirectoryDialog = [](char* out) -> bool {
+				std::string outpath;
+				bool ret = UIHelper::GetOpenDirectoryDialog(outpath);
+
+				if (out != nullptr)
+					strcpy(out, outpath.c_str());
+
+				return ret;
+			};
+			plugin->GetOpenFileDialog = [](char* out, const char* files) -> bool {
+				std::string outpath;
+				bool ret = UIHelper::GetOpenFileDialog(outpath, files);
+
+				if (out != nullptr)
+					strcpy(out, outpath.c_str());
+
+				return ret;
+			};
+			plugin->GetSaveFileDialog = [](char* out, const char* files) -> bool {
+				std::string outpath;
+				bool ret = UIHelper::GetSaveFileDialog(outpath, files);
+
+				if (out != nullptr)
+					strcpy(out, outpath.c_str());
+
+				return ret;
+			};
+
+			if (apiVer >= 2) {
+				plugin->Plugins = (void*)this;
+				plugin->SubmitJob = [](void* plugins, void* owner, pluginfn::JobFn job, pluginfn::JobFn done, void* userData) -> bool {
+					PluginManager* pm = (PluginManager*)plugins;
+					return pm->SubmitJob((IPlugin*)owner, job, done, userData);
+				};
+				plugin->WaitForJobs = [](void* plugins, void* owner) {
+					PluginManager* pm = (PluginManager*)plugins;
+					pm->WaitForJobs((IPlugin*)owner);
+				};
+				plugin->GetWorkerCount = [](void* plugins) -> int {
+					PluginManager* pm = (PluginManager*)plugins;
+					return pm->GetWorkerCount();
+				};
+				plugin->ReadBufferAsync = [](void* objects, const char* name, int offset, int size) -> bool {
 					ObjectManager* objs = (ObjectManager*)objects;
-					return objs->CreateRenderTexture(name);
+					return objs->ReadBufferAsync(name, offset, size);
 				};
-				plugin->CreateImage = [](void* objects, const char* name, int width, int height) -> bool {
+				plugin->ReadImageAsync = [](void* objects, const char* name, int x, int y, int width, int height) -> bool {
 					ObjectManager* objs = (ObjectManager*)objects;
-					return objs->CreateImage(name, glm::ivec2(width, height));
+					return objs->ReadImageAsync(name, x, y, width, height);
 				};
-				plugin->ResizeRenderTexture = [](void* objects, const char* name, int width, int height) {
+				plugin->MapReadback = [](void* objects, const char* name, int& size) -> const void* {
 					ObjectManager* objs = (ObjectManager*)objects;
-					objs->ResizeRenderTexture(name, glm::ivec2(width, height));
+					return objs->MapReadback(name, size);
 				};
-				plugin->ResizeImage = [](void* objects, const char* name, int width, int height) {
+				plugin->MapBufferWrite = [](void* objects, const char* name, int offset, int size) -> void* {
 					ObjectManager* objs = (ObjectManager*)objects;
-					objs->ResizeImage(name, glm::ivec2(width, height));
+					return objs->MapBufferWrite(name, offset, size);
 				};
-				plugin->ExistsObject = [](void* objects, const char* name) -> bool {
+				plugin->FlushBufferWrite = [](void* objects, const char* name, int offset, int size) {
 					ObjectManager* objs = (ObjectManager*)objects;
-					return objs->Exists(name);
+					objs->FlushBufferWrite(name, offset, size);
 				};
-				plugin->RemoveGlobalObject = [](void* objects, const char* name) {
+				plugin->UnmapObject = [](void* objects, const char* name) {
 					ObjectManager* objs = (ObjectManager*)objects;
-					objs->Remove(name);
-				};
-				plugin->GetProjectPath = [](void* project, const char* filename, char* out) {
-					ProjectParser* proj = (ProjectParser*)project;
-					std::string path = proj->GetProjectPath(filename);
-					strcpy(out, path.c_str());
-				};
-				plugin->GetRelativePath = [](void* project, const char* filename, char* out) {
-					ProjectParser* proj = (ProjectParser*)project;
-					std::string path = proj->GetRelativePath(filename);
-					strcpy(out, path.c_str());
-				};
-				plugin->GetProjectFilename = [](void* project, char* out) {
-					ProjectParser* proj = (ProjectParser*)project;
-					std::string path = proj->GetOpenedFile();
-					strcpy(out, path.c_str());
-				};
-				plugin->GetProjectDirectory = [](void* project) -> const char* {
-					ProjectParser* proj = (ProjectParser*)project;
-					return proj->GetProjectDirectory().c_str();
-				};
-				plugin->IsProjectModified = [](void* project) -> bool {
-					ProjectParser* proj = (ProjectParser*)project;
-					return proj->IsProjectModified();
-				};
-				plugin->ModifyProject = [](void* project) {
-					ProjectParser* proj = (ProjectParser*)project;
-					proj->ModifyProject();
-				};
-				plugin->OpenProject = [](void* project, void* uiData, const char* filename) {
-					ProjectParser* proj = (ProjectParser*)project;
-					GUIManager* ui = (GUIManager*)uiData;
-
-					((CodeEditorUI*)ui->Get(ViewID::Code))->CloseAll();
-					((PinnedUI*)ui->Get(ViewID::Pinned))->CloseAll();
-					((PreviewUI*)ui->Get(ViewID::Preview))->Pick(nullptr);
-					((PropertyUI*)ui->Get(ViewID::Properties))->Open(nullptr);
-					((PipelineUI*)ui->Get(ViewID::Pipeline))->Reset();
-					((ObjectPreviewUI*)ui->Get(ViewID::ObjectPreview))->CloseAll();
-
-					proj->Open(filename);
-				};
-				plugin->SaveProject = [](void* project) {
-					ProjectParser* proj = (ProjectParser*)project;
-					proj->Save();
-				};
-				plugin->SaveAsProject = [](void* project, const char* filename, bool copyFiles) {
-					ProjectParser* proj = (ProjectParser*)project;
-					proj->SaveAs(filename, copyFiles);
-				};
-				plugin->IsPaused = [](void* renderer) -> bool {
-					RenderEngine* rend = (RenderEngine*)renderer;
-					return rend->IsPaused();
-				};
-				plugin->Pause = [](void* renderer, bool state) {
-					RenderEngine* rend = (RenderEngine*)renderer;
-					rend->Pause(state);
-				};
-				plugin->GetWindowColorTexture = [](void* renderer) -> unsigned int {
-					RenderEngine* rend = (RenderEngine*)renderer;
-					return rend->GetTexture();
-				};
-				plugin->GetWindowDepthTexture = [](void* renderer) -> unsigned int {
-					RenderEngine* rend = (RenderEngine*)renderer;
-					return rend->GetDepthTexture();
-				};
-				plugin->GetLastRenderSize = [](void* renderer, int& w, int& h) {
-					RenderEngine* rend = (RenderEngine*)renderer;
-					glm::ivec2 sz = rend->GetLastRenderSize();
-					w = sz.x;
-					h = sz.y;
-				};
-				plugin->Render = [](void* renderer, int w, int h) {
-					RenderEngine* rend = (RenderEngine*)renderer;
-					rend->Render(w, h);
-				};
-				plugin->ExistsPipelineItem = [](void* pipeline, const char* name) -> bool {
-					PipelineManager* pipe = (PipelineManager*)pipeline;
-					return pipe->Has(name);
-				};
-				plugin->GetPipelineItem = [](void* pipeline, const char* name) -> void* {
-					PipelineManager* pipe = (PipelineManager*)pipeline;
-					return (void*)pipe->Get(name);
-				};
-				plugin->BindShaderPassVariables = [](void* shaderpass, void* item) {
-					pipe::ShaderPass* data = (pipe::ShaderPass*)shaderpass;
-					data->Variables.Bind(item);
-				};
-				plugin->GetViewMatrix = [](float* out) {
-					glm::mat4 viewm = SystemVariableManager::Instance().GetViewMatrix();
-					memcpy(out, glm::value_ptr(viewm), sizeof(float) * 4 * 4);
-				};
-				plugin->GetProjectionMatrix = [](float* out) {
-					glm::mat4 projm = SystemVariableManager::Instance().GetProjectionMatrix();
-					memcpy(out, glm::value_ptr(projm), sizeof(float) * 4 * 4);
-				};
-				plugin->GetOrthographicMatrix = [](float* out) {
-					glm::mat4 orthom = SystemVariableManager::Instance().GetOrthographicMatrix();
-					memcpy(out, glm::value_ptr(orthom), sizeof(float) * 4 * 4);
-				};
-				plugin->GetViewportSize = [](float& w, float& h) {
-					glm::vec2 viewsize = SystemVariableManager::Instance().GetViewportSize();
-					w = viewsize.x;
-					h = viewsize.y;
-				};
-				plugin->AdvanceTimer = [](float t) {
-					SystemVariableManager::Instance().AdvanceTimer(t);
-				};
-				plugin->GetMousePosition = [](float& x, float& y) {
-					glm::vec2 mpos = SystemVariableManager::Instance().GetMousePosition();
-					x = mpos.x;
-					y = mpos.y;
-				};
-				plugin->GetFrameIndex = []() -> int {
-					return SystemVariableManager::Instance().GetFrameIndex();
-				};
-				plugin->GetTime = []() -> float {
-					return SystemVariableManager::Instance().GetTime();
-				};
-				plugin->SetGeometryTransform = [](void* item, float scale[3], float rota[3], float pos[3]) {
-					SystemVariableManager::Instance().SetGeometryTransform((PipelineItem*)item, glm::make_vec3(scale), glm::make_vec3(rota), glm::make_vec3(pos));
-				};
-				plugin->SetMousePosition = [](float x, float y) {
-					SystemVariableManager::Instance().SetMousePosition(x,y);
-				};
-				plugin->SetKeysWASD = [](bool w, bool a, bool s, bool d) {
-					SystemVariableManager::Instance().SetKeysWASD(w,a,s,d);
-				};
-				plugin->SetFrameIndex = [](int findex) {
-					SystemVariableManager::Instance().SetFrameIndex(findex);
-				};
-				plugin->GetDPI = []() -> float {
-					return Settings::Instance().DPIScale;
-				};
-				plugin->FileExists = [](void* project, const char* filename) -> bool {
-					ProjectParser* proj = (ProjectParser*)project;
-					return proj->FileExists(filename);
-				};
-				plugin->ClearMessageGroup = [](void* project, const char* group) {
-					MessageStack* msgs = (MessageStack*)project;
-					msgs->ClearGroup(group);
-				};
-				plugin->Log = [](const char* msg, bool error, const char* file, int line) {
-					printf(msg);
-					//ed::Logger::Get().Log(msg, error, file, line);
-				};
-				plugin->GetObjectCount = [](void* objects) -> int {
-					ObjectManager* obj = (ObjectManager*)objects;
-					return obj->GetObjects().size();
-				};
-				plugin->GetObjectName = [](void* objects, int index) -> const char* {
-					ObjectManager* obj = (ObjectManager*)objects;
-					return obj->GetObjects()[index].c_str();
-				};
-				plugin->IsTexture = [](void* objects, const char* name) -> bool {
-					ObjectManager* obj = (ObjectManager*)objects;
-					const auto& itemList = obj->GetItemDataList();
-					const auto& itemNames = obj->GetObjects();
-					int nameIndex = 0;
-
-					for (const auto& item : itemList) {
-						if (itemNames[nameIndex] == name)
-								return item->IsTexture;
-						nameIndex++;
-					}
-
-					return false;
-				};
-				plugin->GetTexture = [](void* objects, const char* name) -> unsigned int {
-					ObjectManager* obj = (ObjectManager*)objects;
-					return obj->GetTexture(name);
-				};
-				plugin->GetFlippedTexture = [](void* objects, const char* name) -> unsigned int {
-					ObjectManager* obj = (ObjectManager*)objects;
-					return obj->GetFlippedTexture(name);
-				};
-				plugin->GetTextureSize = [](void* objects, const char* name, int& w, int& h) {
-					ObjectManager* obj = (ObjectManager*)objects;
-					glm::ivec2 tsize = obj->GetTextureSize(name);
-					w = tsize.x;
-					h = tsize.y;
-				};
-				plugin->BindDefaultState = []() {
-					DefaultState::Bind();
-				};
-				plugin->OpenInCodeEditor = [](void* codeed, void* item, const char* filename, int id) {
-					CodeEditorUI* editor = (CodeEditorUI*)codeed;
-					editor->OpenPluginCode((PipelineItem*)item, filename, id);
-				};
-				plugin->GetPipelineItemCount = [](void* pipeline) -> int {
-					PipelineManager* pipe = (PipelineManager*)pipeline;
-					return pipe->GetList().size();
-				};
-				plugin->GetPipelineItemType = [](void* pipeline, int index) -> plugin::PipelineItemType {
-					PipelineManager* pipe = (PipelineManager*)pipeline;
-					return (plugin::PipelineItemType)pipe->GetList()[index]->Type;
-				};
-				plugin->GetPipelineItemByIndex = [](void* pipeline, int index) -> void* {
-					PipelineManager* pipe = (PipelineManager*)pipeline;
-					return (void*)pipe->GetList()[index];
-				};
-				plugin->GetOpenDirectoryDialog = [](char* out) -> bool {
-					std::string outpath;
-					bool ret = UIHelper::GetOpenDirectoryDialog(outpath);
-
-					if (out != nullptr)
-						strcpy(out, outpath.c_str());
-
-					return ret;
-				};
-				plugin->GetOpenFileDialog = [](char* out, const char* files) -> bool {
-					std::string outpath;
-					bool ret = UIHelper::GetOpenFileDialog(outpath, files);
-
-					if (out != nullptr)
-						strcpy(out, outpath.c_str());
-
-					return ret;
-				};
-				plugin->GetSaveFileDialog = [](char* out, const char* files) -> bool {
-					std::string outpath;
-					bool ret = UIHelper::GetSaveFileDialog(outpath, files);
-
-					if (out != nullptr)
-						strcpy(out, outpath.c_str());
-
-					return ret;
+					objs->Unmap(name);
 				};
+			}
 
-				// now we can add the plugin and the proc to the list, init the plugin, etc...
+			// now we can add the plugin and the proc to the list, init the plugin, etc...
+			// disabled plugins are only initialized once a project asks for them
+			bool isActive = std::count(notLoaded.begin(), notLoaded.end(), pname) == 0;
+			if (isActive)
 				plugin->Init();
-				m_plugins.push_back(plugin);
-				m_proc.push_back(procDLL);
-				m_isActive.push_back(std::count(notLoaded.begin(), notLoaded.end(), pname) == 0);
-				m_names.push_back(pname);
-			}
+			m_plugins.push_back(plugin);
+			m_proc.push_back(lib.Proc);
+			m_isActive.push_back(isActive);
+			m_isInitialized.push_back(isActive);
+			m_names.push_back(pname);
+			m_apiVersion.push_back(apiVer);
+			m_pluginVersion.push_back(lib.Version);
+			m_varBlocks.push_back(std::vector<char>());
+			if (isActive)
+				m_allocateVariableBlock(m_plugins.size() - 1);
+
+			PluginProfiler::Instance().Register(plugin, pname);
 		}
+
+		loader.join();
 	}
 	void PluginManager::Destroy()
 	{
+		// the job callbacks still use the plugins
+		WaitForJobs();
+
 		for (int i = 0; i < m_plugins.size(); i++) {
-			m_plugins[i]->Destroy();
+			if (m_isInitialized[i])
+				m_plugins[i]->Destroy();
 			#if defined(__linux__) || defined(__unix__) || defined(__APPLE__)
 				DestroyPluginFn fnDestroyPlugin = (DestroyPluginFn)dlsym(m_proc[i], "DestroyPlugin");
 				if (fnDestroyPlugin)
@@ -467,25 +536,124 @@ namespace ed
 		}
 
 		m_plugins.clear();
+		m_varBlocks.clear();
+		SystemVariableManager::Instance().ClearPluginBlocks();
+		PluginProfiler::Instance().Clear();
 	}
 	void PluginManager::Update(float delta)
 	{
 		for (int i = 0; i < m_plugins.size(); i++)
-			if (m_isActive[i])
+			if (m_isActive[i]) {
+				PluginProfiler::Scope profile(m_plugins[i], PluginProfiler::Update);
 				m_plugins[i]->Update(delta);
+			}
+	}
+
+	bool PluginManager::SubmitJob(IPlugin* owner, pluginfn::JobFn job, pluginfn::JobFn done, void* userData)
+	{
+		if (job == nullptr)
+			return false;
+
+		if (m_jobPool == nullptr)
+			m_jobPool.reset(new eng::ThreadPool());
+
+		{
+			std::lock_guard<std::mutex> lock(m_jobMutex);
+			m_runningJobs[owner]++;
+		}
+
+		m_jobPool->Add([this, owner, job, done, userData]() {
+			job(userData);
+
+			{
+				std::lock_guard<std::mutex> lock(m_jobMutex);
+				m_finishedJobs.push_back({ owner, done, userData });
+				m_runningJobs[owner]--;
+			}
+			m_jobSignal.notify_all();
+
+			UIRefresh::Instance().Request(); // the callback is called in the next frame
+		});
+
+		return true;
+	}
+	void PluginManager::WaitForJobs(IPlugin* owner)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_jobMutex);
+			m_jobSignal.wait(lock, [&]() {
+				if (owner != nullptr)
+					return m_runningJobs[owner] == 0;
+				for (const auto& running : m_runningJobs)
+					if (running.second != 0)
+						return false;
+				return true;
+			});
+		}
+
+		FinishJobs();
+	}
+	void PluginManager::FinishJobs()
+	{
+		std::vector<Job> finished;
+		{
+			std::lock_guard<std::mutex> lock(m_jobMutex);
+			if (m_finishedJobs.empty())
+				return;
+			finished.swap(m_finishedJobs);
+		}
+
+		for (const Job& job : finished) {
+			if (job.Done == nullptr)
+				continue;
+
+			PluginProfiler::Scope profile(job.Owner, PluginProfiler::JobCallback);
+			job.Done(job.UserData);
+		}
+	}
+	int PluginManager::GetWorkerCount()
+	{
+		if (m_jobPool == nullptr)
+			m_jobPool.reset(new eng::ThreadPool());
+
+		return m_jobPool->GetThreadCount();
+	}
+
+	void PluginManager::m_allocateVariableBlock(int index)
+	{
+		if (m_apiVersion[index] < 3)
+			return;
+
+		int size = static_cast<IPlugin3*>(m_plugins[index])->GetSystemVariableBlockSize();
+		if (size <= 0)
+			return;
+
+		m_varBlocks[index].resize(size, 0);
+		SystemVariableManager::Instance().SetPluginBlock(m_plugins[index], m_varBlocks[index].data(), size);
 	}
 
 	void PluginManager::BeginRender()
 	{
+		// one call per plugin fills the values of all its variables for this frame, disabled plugins can still own variables
 		for (int i = 0; i < m_plugins.size(); i++)
-			if (m_isActive[i])
+			if (m_isInitialized[i] && !m_varBlocks[i].empty()) {
+				PluginProfiler::Scope profile(m_plugins[i], PluginProfiler::SystemVariable);
+				static_cast<IPlugin3*>(m_plugins[i])->UpdateSystemVariableBlock(m_varBlocks[i].data());
+			}
+
+		for (int i = 0; i < m_plugins.size(); i++)
+			if (m_isActive[i]) {
+				PluginProfiler::Scope profile(m_plugins[i], PluginProfiler::BeginRender);
 				m_plugins[i]->BeginRender();
+			}
 	}
 	void PluginManager::EndRender()
 	{
 		for (int i = 0; i < m_plugins.size(); i++)
-			if (m_isActive[i])
+			if (m_isActive[i]) {
+				PluginProfiler::Scope profile(m_plugins[i], PluginProfiler::EndRender);
 				m_plugins[i]->EndRender();
+			}
 	}
 
 	std::vector<InputLayoutItem> PluginManager::BuildInputLayout(IPlugin* plugin, const char* itemName)
@@ -509,8 +677,14 @@ namespace ed
 	IPlugin* PluginManager::GetPlugin(const std::string& plugin)
 	{
 		for (int i = 0; i < m_names.size(); i++)
-			if (m_names[i] == plugin)
+			if (m_names[i] == plugin) {
+				if (!m_isInitialized[i]) {
+					m_plugins[i]->Init();
+					m_isInitialized[i] = true;
+					m_allocateVariableBlock(i);
+				}
 				return m_plugins[i];
+			}
 
 		return nullptr;
 	}
@@ -614,6 +788,7 @@ namespace ed
 					if (ImGui::Selectable(name)) {
 						data->Owner = m_plugins[i];
 						strcpy(data->Name, name);
+						data->Offset[0] = data->Offset[1] = -2;
 						ret = true;
 					}
 				}
@@ -3,10 +3,15 @@
 #include "Plugin.h"
 #include "../ShaderVariable.h"
 #include "../InputLayout.h"
+#include "../../Engine/ThreadPool.h"
 #include <vector>
 #include <string>
+#include <mutex>
+#include <memory>
+#include <unordered_map>
+#include <condition_variable>
 
-#define CURRENT_PLUGINAPI_VERSION 1
+#define CURRENT_PLUGINAPI_VERSION 3
 
 namespace ed
 {
@@ -23,7 +28,7 @@ namespace ed
 		void BeginRender();
 		void EndRender();
 
-		IPlugin* GetPlugin(const std::string& plugin);
+		IPlugin* GetPlugin(const std::string& plugin); // initializes the disabled plugins on their first use
 		std::string GetPluginName(IPlugin* plugin);
 		int GetPluginVersion(const std::string& plugin);
 		int GetPluginAPIVersion(const std::string& plugin);
@@ -48,11 +53,32 @@ namespace ed
 
 		inline const std::vector<IPlugin*>& Plugins() { return m_plugins; }
 
+		// jobs can only be submitted from the main thread
+		bool SubmitJob(IPlugin* owner, pluginfn::JobFn job, pluginfn::JobFn done, void* userData);
+		void WaitForJobs(IPlugin* owner = nullptr); // nullptr -> all plugins
+		void FinishJobs(); // calls the completion callbacks of the finished jobs, once per frame
+		int GetWorkerCount();
+
 	private:
+		void m_allocateVariableBlock(int index); // after the plugin's Init()
+
 		std::vector<void*> m_proc;
 		std::vector<IPlugin*> m_plugins;
-		std::vector<bool> m_isActive;
+		std::vector<bool> m_isActive, m_isInitialized;
 		std::vector<std::string> m_names;
 		std::vector<int> m_pluginVersion, m_apiVersion;
+		std::vector<std::vector<char>> m_varBlocks; // system variable values of the API version 3 plugins, never reallocated
+
+		struct Job
+		{
+			IPlugin* Owner;
+			pluginfn::JobFn Done;
+			void* UserData;
+		};
+		std::mutex m_jobMutex;
+		std::condition_variable m_jobSignal;
+		std::vector<Job> m_finishedJobs;
+		std::unordered_map<IPlugin*, int> m_runningJobs;
+		std::unique_ptr<eng::ThreadPool> m_jobPool; // created with the first job, keep this last so that the workers stop before anything else is destroyed
 	};
 }
\ No newline at end of file
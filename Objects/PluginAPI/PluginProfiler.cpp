@@ -0,0 +1,136 @@
+#include "PluginProfiler.h"
+#include "../Logger.h"
+#include "../Settings.h"
+#include "../TraceRecorder.h"
+
+#include <algorithm>
+#include <string.h>
+#include <stdio.h>
+
+namespace ed
+{
+	const char* PLUGIN_CALL_NAMES[] = { "Update", "BeginRender", "EndRender", "Execute", "System variables", "BindObject", "Job callbacks" };
+
+	PluginProfiler::Stats::Stats()
+	{
+		for (int i = 0; i < CallCount; i++) {
+			Last[i] = Average[i] = 0.0f;
+			Calls[i] = 0;
+		}
+		Total = Max = 0.0f;
+		OverBudget = false;
+	}
+	PluginProfiler::Entry::Entry()
+	{
+		for (int i = 0; i < CallCount; i++) {
+			Frame[i] = 0.0f;
+			Calls[i] = 0;
+		}
+		History.resize(PLUGIN_PROFILER_HISTORY * CallCount, 0.0f);
+		HistoryIndex = 0;
+		Samples = 0;
+	}
+
+	const char* PluginProfiler::GetCallName(int call)
+	{
+		return (call >= 0 && call < CallCount) ? PLUGIN_CALL_NAMES[call] : "";
+	}
+#ifdef SHADERED_TRACY
+	const tracy::SourceLocationData* PluginProfiler::GetZoneLocation(int call)
+	{
+		// the zones need a location that outlives them
+		static tracy::SourceLocationData locations[CallCount];
+		static bool initialized = false;
+		if (!initialized) {
+			for (int i = 0; i < CallCount; i++)
+				locations[i] = { PLUGIN_CALL_NAMES[i], "PluginProfiler::Scope", __FILE__, (uint32_t)__LINE__, 0 };
+			initialized = true;
+		}
+		return &locations[call];
+	}
+#endif
+	void PluginProfiler::Register(IPlugin* plugin, const std::string& name)
+	{
+		m_entries[plugin].Name = name;
+	}
+	void PluginProfiler::Add(IPlugin* plugin, int call, std::chrono::steady_clock::time_point start)
+	{
+		auto now = std::chrono::steady_clock::now();
+		Entry& entry = m_entries[plugin];
+		entry.Frame[call] += std::chrono::duration<float, std::milli>(now - start).count();
+		entry.Calls[call]++;
+
+		if (TraceRecorder::Instance().IsRecording())
+			TraceRecorder::Instance().AddZone(entry.Name + ": " + GetCallName(call), "plugin", start, now);
+	}
+	void PluginProfiler::EndFrame()
+	{
+		float budget = Settings::Instance().Plugins.Budget;
+
+		for (auto& it : m_entries) {
+			Entry& entry = it.second;
+			Stats& res = entry.Result;
+
+			float* frame = &entry.History[entry.HistoryIndex * CallCount];
+			memcpy(frame, entry.Frame, sizeof(entry.Frame));
+			entry.HistoryIndex = (entry.HistoryIndex + 1) % PLUGIN_PROFILER_HISTORY;
+			entry.Samples = std::min<int>(entry.Samples + 1, PLUGIN_PROFILER_HISTORY);
+
+			res.Total = res.Max = 0.0f;
+			for (int i = 0; i < CallCount; i++) {
+				res.Last[i] = entry.Frame[i];
+				res.Calls[i] = entry.Calls[i];
+				res.Average[i] = 0.0f;
+			}
+			for (int s = 0; s < entry.Samples; s++) {
+				float frameTotal = 0.0f;
+				for (int i = 0; i < CallCount; i++) {
+					res.Average[i] += entry.History[s * CallCount + i];
+					frameTotal += entry.History[s * CallCount + i];
+				}
+				res.Max = std::max<float>(res.Max, frameTotal);
+			}
+			for (int i = 0; i < CallCount; i++) {
+				res.Average[i] /= entry.Samples;
+				res.Total += res.Average[i];
+			}
+
+			for (int i = 0; i < CallCount; i++) {
+				entry.Frame[i] = 0.0f;
+				entry.Calls[i] = 0;
+			}
+
+			// only warn once every time the plugin goes over the budget
+			bool overBudget = budget > 0.0f && entry.Samples == PLUGIN_PROFILER_HISTORY && res.Total > budget;
+			if (overBudget && !res.OverBudget) {
+				char msg[256];
+				snprintf(msg, sizeof(msg), "%.2f ms of CPU time per frame, the budget is %.2f ms", res.Total, budget);
+				Logger::Get().Log(Logger::Level::Warning, "Plugin " + entry.Name + " is over its budget - " + msg);
+			}
+			res.OverBudget = overBudget;
+		}
+	}
+	bool PluginProfiler::Has(IPlugin* plugin)
+	{
+		auto entry = m_entries.find(plugin);
+		return entry != m_entries.end() && entry->second.Samples > 0;
+	}
+	const PluginProfiler::Stats& PluginProfiler::Get(IPlugin* plugin)
+	{
+		return m_entries[plugin].Result;
+	}
+	void PluginProfiler::ResetStats()
+	{
+		for (auto& it : m_entries) {
+			Entry& entry = it.second;
+			std::fill(entry.History.begin(), entry.History.end(), 0.0f);
+			entry.HistoryIndex = 0;
+			entry.Samples = 0;
+			entry.Result = Stats();
+		}
+	}
+	void PluginProfiler::Clear()
+	{
+		m_entries.clear();
+	}
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <chrono>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include "../ProfilerZones.h"
+#include "../FrameProfiler.h"
+
+#define PLUGIN_PROFILER_HISTORY 120 // frames that the average is calculated from
+
+namespace ed
+{
+	class IPlugin;
+
+	// CPU time that the plugins spend in their callbacks - the GPU time of plugin items is measured by the GPUProfiler
+	// plugin callbacks are only made from the main thread
+	class PluginProfiler
+	{
+	public:
+		static inline PluginProfiler& Instance()
+		{
+			static PluginProfiler ret;
+			return ret;
+		}
+
+		enum Call
+		{
+			Update,
+			BeginRender,
+			EndRender,
+			Execute,		// ExecutePipelineItem
+			SystemVariable, // UpdateSystemVariableValue
+			BindObject,
+			JobCallback,	// completion callbacks of the jobs
+			CallCount
+		};
+		static const char* GetCallName(int call);
+#ifdef SHADERED_TRACY
+		static const tracy::SourceLocationData* GetZoneLocation(int call);
+#endif
+
+		struct Stats
+		{
+			Stats();
+
+			float Last[CallCount];	  // milliseconds spent in the last frame
+			float Average[CallCount];
+			float Total;			  // average of the whole frame
+			float Max;				  // worst frame in the history
+			int Calls[CallCount];	  // in the last frame
+			bool OverBudget;
+		};
+
+		// measures the time until it goes out of scope
+		class Scope
+		{
+		public:
+			inline Scope(IPlugin* plugin, int call) :
+#ifdef SHADERED_TRACY
+				m_zone(GetZoneLocation(call)),
+#endif
+				m_plugin(plugin), m_call(call), m_start(std::chrono::steady_clock::now()), m_frame(FrameProfiler::Plugins) {}
+			inline ~Scope() { PluginProfiler::Instance().Add(m_plugin, m_call, m_start); }
+
+		private:
+#ifdef SHADERED_TRACY
+			tracy::ScopedZone m_zone;
+#endif
+			IPlugin* m_plugin;
+			int m_call;
+			std::chrono::steady_clock::time_point m_start;
+			FrameProfiler::Scope m_frame; // all plugins together
+		};
+
+		void Register(IPlugin* plugin, const std::string& name); // the name is used in the budget warnings
+		void Add(IPlugin* plugin, int call, std::chrono::steady_clock::time_point start);
+		void EndFrame(); // moves this frame's times to the history and checks the budget
+
+		bool Has(IPlugin* plugin);
+		const Stats& Get(IPlugin* plugin);
+
+		void ResetStats();
+		void Clear();
+
+	private:
+		struct Entry
+		{
+			Entry();
+
+			std::string Name;
+			float Frame[CallCount];
+			int Calls[CallCount];
+			std::vector<float> History; // [frame][call]
+			int HistoryIndex;
+			int Samples;
+
+			Stats Result;
+		};
+
+		std::unordered_map<IPlugin*, Entry> m_entries;
+	};
+}
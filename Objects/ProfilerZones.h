@@ -0,0 +1,30 @@
+#pragma once
+
+// zones for the Tracy profiler - turned on with the SHADERED_TRACY CMake option, everything expands to nothing otherwise
+// ED_ZONE & ED_GPU_ZONE names must be string literals, ED_ZONE_TEXT can be used to attach the item name
+#ifdef SHADERED_TRACY
+	#include <string>
+	#include <GL/glew.h>
+	#include <tracy/Tracy.hpp>
+	#include <tracy/TracyOpenGL.hpp>
+
+	#define ED_ZONE(name) ZoneScopedN(name)
+	#define ED_ZONE_TEXT(text) { const std::string& zoneText = (text); ZoneText(zoneText.c_str(), zoneText.size()); }
+	#define ED_GPU_ZONE(name) TracyGpuZone(name)
+	#define ED_GPU_CONTEXT() TracyGpuContext
+	#define ED_GPU_COLLECT() TracyGpuCollect
+	#define ED_FRAME() FrameMark
+
+	#define ED_LOCKABLE(type, var, desc) TracyLockableN(type, var, desc)
+	#define ED_LOCKABLE_BASE(type) LockableBase(type)
+#else
+	#define ED_ZONE(name)
+	#define ED_ZONE_TEXT(text)
+	#define ED_GPU_ZONE(name)
+	#define ED_GPU_CONTEXT()
+	#define ED_GPU_COLLECT()
+	#define ED_FRAME()
+
+	#define ED_LOCKABLE(type, var, desc) type var
+	#define ED_LOCKABLE_BASE(type) type
+#endif
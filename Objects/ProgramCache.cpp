@@ -0,0 +1,117 @@
+#include "ProgramCache.h"
+#include "Logger.h"
+#include "Hash.h"
+
+#include <fstream>
+#include <stdio.h>
+#include <ghc/filesystem.hpp>
+
+#define PROGRAM_CACHE_DIR "./data/cache/"
+#define PROGRAM_CACHE_MAGIC 0x50444553 // SEDP
+
+namespace ed
+{
+	ProgramCache::ProgramCache()
+	{
+		GLint formats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+		m_supported = (GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary) && formats > 0;
+
+		const char* vendor = (const char*)glGetString(GL_VENDOR);
+		const char* renderer = (const char*)glGetString(GL_RENDERER);
+		const char* version = (const char*)glGetString(GL_VERSION);
+		m_driver = std::string(vendor ? vendor : "") + "\n" + (renderer ? renderer : "") + "\n" + (version ? version : "");
+
+		if (!m_supported)
+			Logger::Get().Log("Program binaries are not supported - shader cache is disabled");
+	}
+	uint64_t ProgramCache::Hash(const std::vector<std::string>& sources)
+	{
+		uint64_t hash = HashString(m_driver);
+		for (const auto& src : sources)
+			hash = HashString(src, hash);
+
+		return hash;
+	}
+	GLuint ProgramCache::Load(uint64_t hash)
+	{
+		if (!m_supported)
+			return 0;
+
+		std::ifstream file(m_getPath(hash), std::ios::binary | std::ios::ate);
+		if (!file.is_open())
+			return 0;
+
+		size_t size = file.tellg();
+		file.seekg(0, std::ios::beg);
+
+		uint32_t magic = 0;
+		GLenum format = 0;
+		if (size <= sizeof(magic) + sizeof(format))
+			return 0;
+
+		file.read((char*)&magic, sizeof(magic));
+		file.read((char*)&format, sizeof(format));
+		if (magic != PROGRAM_CACHE_MAGIC)
+			return 0;
+
+		std::vector<char> binary(size - sizeof(magic) - sizeof(format));
+		file.read(binary.data(), binary.size());
+		file.close();
+
+		GLuint program = glCreateProgram();
+		glProgramBinary(program, format, binary.data(), binary.size());
+
+		// the driver can reject the binary (driver update, etc...)
+		GLint linked = 0;
+		glGetProgramiv(program, GL_LINK_STATUS, &linked);
+		if (!linked) {
+			glDeleteProgram(program);
+
+			std::error_code errCode;
+			ghc::filesystem::remove(m_getPath(hash), errCode);
+
+			return 0;
+		}
+
+		return program;
+	}
+	void ProgramCache::Save(uint64_t hash, GLuint program)
+	{
+		if (!m_supported || program == 0)
+			return;
+
+		GLint linked = 0, length = 0;
+		glGetProgramiv(program, GL_LINK_STATUS, &linked);
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+		if (!linked || length <= 0)
+			return;
+
+		std::vector<char> binary(length);
+		GLenum format = 0;
+		glGetProgramBinary(program, length, nullptr, &format, binary.data());
+
+		std::error_code errCode;
+		if (!ghc::filesystem::exists(PROGRAM_CACHE_DIR))
+			ghc::filesystem::create_directories(PROGRAM_CACHE_DIR, errCode);
+
+		std::ofstream file(m_getPath(hash), std::ios::binary);
+		if (!file.is_open()) {
+			Logger::Get().Log("Failed to write to the program cache", true);
+			return;
+		}
+
+		uint32_t magic = PROGRAM_CACHE_MAGIC;
+		file.write((char*)&magic, sizeof(magic));
+		file.write((char*)&format, sizeof(format));
+		file.write(binary.data(), binary.size());
+		file.close();
+	}
+	std::string ProgramCache::m_getPath(uint64_t hash)
+	{
+		char name[17] = { 0 };
+		snprintf(name, 17, "%016llx", (unsigned long long)hash);
+
+		return std::string(PROGRAM_CACHE_DIR) + name + ".bin";
+	}
+}
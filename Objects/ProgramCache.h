@@ -0,0 +1,38 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/glew.h>
+#if defined(__APPLE__)
+	#include <OpenGL/gl.h>
+#else
+	#include <GL/gl.h>
+#endif
+
+namespace ed
+{
+	// stores linked programs on disk (glGetProgramBinary) so that they don't have to be compiled again
+	class ProgramCache
+	{
+	public:
+		ProgramCache();
+
+		inline bool IsSupported() { return m_supported; }
+
+		// hash of the final sources - the driver is also part of the key
+		uint64_t Hash(const std::vector<std::string>& sources);
+
+		GLuint Load(uint64_t hash); // returns 0 if the program isn't cached
+		void Save(uint64_t hash, GLuint program);
+
+	private:
+		std::string m_getPath(uint64_t hash);
+
+		bool m_supported;
+		std::string m_driver;
+	};
+}
@@ -0,0 +1,233 @@
+#include "ProjectArchive.h"
+#include "Logger.h"
+#include "Hash.h"
+#include "../Engine/MappedFile.h"
+
+#include <fstream>
+#include <vector>
+#include <unordered_set>
+#include <stdio.h>
+#include <string.h>
+#include <ghc/filesystem.hpp>
+
+#define PROJECT_ARCHIVE_DIR "./data/archives/"
+#define PROJECT_ARCHIVE_MAGIC 0x41444553 // SEDA
+#define PROJECT_ARCHIVE_VERSION 1
+#define PROJECT_ARCHIVE_ALIGNMENT 4096
+
+namespace ed
+{
+	struct ArchiveHeader
+	{
+		uint32_t Magic;
+		uint32_t Version;
+		uint32_t FileCount;
+		uint32_t Reserved;
+		uint64_t TOCOffset;
+		uint64_t TOCSize;
+	};
+	struct ArchiveEntry // followed by PathLength characters of the path relative to the project directory
+	{
+		uint64_t Offset;
+		uint64_t Size;
+		uint64_t Hash;
+		uint32_t PathLength;
+		uint32_t Reserved;
+	};
+
+	bool ProjectArchive::IsArchive(const std::string& file)
+	{
+		return ghc::filesystem::path(file).extension() == "." PROJECT_ARCHIVE_EXTENSION;
+	}
+	std::string ProjectArchive::GetWorkingDirectory(const std::string& archive)
+	{
+		std::error_code ec;
+		ghc::filesystem::path path = ghc::filesystem::absolute(archive, ec);
+
+		// the same archive always ends up in the same directory so that the files can be reused
+		char hash[32];
+		snprintf(hash, sizeof(hash), "%016llx", (unsigned long long)HashString(path.generic_string()));
+
+		return (ghc::filesystem::absolute(PROJECT_ARCHIVE_DIR, ec) / (path.stem().generic_string() + "_" + hash)).lexically_normal().generic_string();
+	}
+	bool ProjectArchive::Pack(const std::string& dir, const std::string& project, const std::string& archive)
+	{
+		Logger::Get().Log("Packing the project to " + archive);
+
+		std::error_code ec;
+		ghc::filesystem::path root(dir);
+
+		std::vector<std::string> files;
+		std::string projectRel = ghc::filesystem::relative(project, root, ec).generic_string();
+		files.push_back(projectRel);
+		for (ghc::filesystem::recursive_directory_iterator it(root, ec), end; !ec && it != end; it.increment(ec)) {
+			if (!it->is_regular_file())
+				continue;
+
+			std::string rel = ghc::filesystem::relative(it->path(), root, ec).generic_string();
+			if (rel != projectRel)
+				files.push_back(rel);
+		}
+
+		// the old archive is only replaced once the new one is complete
+		std::string temp = archive + ".tmp";
+		std::ofstream out(temp, std::ios::binary);
+		if (!out.is_open()) {
+			Logger::Get().Log("Failed to create the project archive " + archive, true);
+			return false;
+		}
+
+		ArchiveHeader header;
+		memset(&header, 0, sizeof(header));
+		header.Magic = PROJECT_ARCHIVE_MAGIC;
+		header.Version = PROJECT_ARCHIVE_VERSION;
+		header.FileCount = files.size();
+		out.write((char*)&header, sizeof(header));
+
+		static const char padding[PROJECT_ARCHIVE_ALIGNMENT] = { 0 };
+
+		std::string toc;
+		uint64_t offset = sizeof(header);
+		for (const auto& rel : files) {
+			eng::MappedFile src;
+			if (!src.Open((root / rel).string())) {
+				Logger::Get().Log("Failed to read " + rel + " while packing the project", true);
+				out.close();
+				ghc::filesystem::remove(temp, ec);
+				return false;
+			}
+
+			// blobs start on a page so that they can be used straight from the mapping
+			uint64_t pad = (PROJECT_ARCHIVE_ALIGNMENT - offset % PROJECT_ARCHIVE_ALIGNMENT) % PROJECT_ARCHIVE_ALIGNMENT;
+			out.write(padding, pad);
+			offset += pad;
+
+			ArchiveEntry entry;
+			memset(&entry, 0, sizeof(entry));
+			entry.Offset = offset;
+			entry.Size = src.GetSize();
+			entry.Hash = HashData(src.GetData(), src.GetSize());
+			entry.PathLength = rel.size();
+
+			out.write(src.GetData(), src.GetSize());
+			offset += src.GetSize();
+
+			toc.append((char*)&entry, sizeof(entry));
+			toc.append(rel);
+		}
+
+		header.TOCOffset = offset;
+		header.TOCSize = toc.size();
+		out.write(toc.data(), toc.size());
+		out.seekp(0);
+		out.write((char*)&header, sizeof(header));
+		out.close();
+
+		if (!out) {
+			Logger::Get().Log("Failed to write the project archive " + archive, true);
+			ghc::filesystem::remove(temp, ec);
+			return false;
+		}
+
+		if (!eng::ReplaceFileWith(archive, temp)) {
+			Logger::Get().Log("Failed to replace the project archive " + archive, true);
+			ghc::filesystem::remove(temp, ec);
+			return false;
+		}
+
+		Logger::Get().Log("Packed " + std::to_string(files.size()) + " files");
+
+		return true;
+	}
+	std::string ProjectArchive::Unpack(const std::string& archive)
+	{
+		Logger::Get().Log("Unpacking the project archive " + archive);
+
+		eng::MappedFile map;
+		if (!map.Open(archive) || map.GetSize() < sizeof(ArchiveHeader)) {
+			Logger::Get().Log("Failed to open the project archive " + archive, true);
+			return "";
+		}
+
+		const char* data = map.GetData();
+		size_t size = map.GetSize();
+
+		ArchiveHeader header;
+		memcpy(&header, data, sizeof(header));
+		if (header.Magic != PROJECT_ARCHIVE_MAGIC || header.Version != PROJECT_ARCHIVE_VERSION || header.FileCount == 0 ||
+			header.TOCOffset > size || header.TOCSize > size - header.TOCOffset) {
+			Logger::Get().Log(archive + " is not a valid project archive", true);
+			return "";
+		}
+
+		std::error_code ec;
+		ghc::filesystem::path root(GetWorkingDirectory(archive));
+
+		std::string project;
+		std::unordered_set<std::string> unpacked;
+		const char* toc = data + header.TOCOffset;
+		size_t tocPos = 0;
+		int written = 0;
+		for (uint32_t i = 0; i < header.FileCount; i++) {
+			ArchiveEntry entry;
+			if (header.TOCSize - tocPos < sizeof(entry)) {
+				Logger::Get().Log(archive + " has a broken table of contents", true);
+				return "";
+			}
+			memcpy(&entry, toc + tocPos, sizeof(entry));
+			tocPos += sizeof(entry);
+
+			if (entry.PathLength > header.TOCSize - tocPos || entry.Offset > size || entry.Size > size - entry.Offset) {
+				Logger::Get().Log(archive + " has a broken table of contents", true);
+				return "";
+			}
+			std::string rel(toc + tocPos, entry.PathLength);
+			tocPos += entry.PathLength;
+
+			// the archive can't write outside of its working directory
+			ghc::filesystem::path relPath = ghc::filesystem::path(rel).lexically_normal();
+			if (relPath.empty() || relPath.is_absolute() || relPath.has_root_name() || relPath.begin()->string() == "..") {
+				Logger::Get().Log(archive + " contains an invalid path " + rel, true);
+				return "";
+			}
+
+			ghc::filesystem::path outPath = root / relPath;
+			if (i == 0)
+				project = outPath.generic_string();
+			unpacked.insert(outPath.generic_string());
+
+			const char* blob = data + entry.Offset;
+
+			// files from the previous unpack are kept if they didn't change
+			uint64_t oldSize = ghc::filesystem::file_size(outPath, ec);
+			if (!ec && oldSize == entry.Size) {
+				eng::MappedFile old;
+				if (old.Open(outPath.string()) && HashData(old.GetData(), old.GetSize()) == entry.Hash)
+					continue;
+			}
+
+			ghc::filesystem::create_directories(outPath.parent_path(), ec);
+			std::ofstream out(outPath.string(), std::ios::binary);
+			out.write(blob, entry.Size);
+			out.close();
+			if (!out) {
+				Logger::Get().Log("Failed to unpack " + rel, true);
+				return "";
+			}
+
+			written++;
+		}
+
+		// files that were removed from the project
+		std::vector<ghc::filesystem::path> stale;
+		for (ghc::filesystem::recursive_directory_iterator it(root, ec), end; !ec && it != end; it.increment(ec))
+			if (it->is_regular_file() && unpacked.count(it->path().generic_string()) == 0)
+				stale.push_back(it->path());
+		for (const auto& path : stale)
+			ghc::filesystem::remove(path, ec);
+
+		Logger::Get().Log("Unpacked " + std::to_string(written) + " of " + std::to_string(header.FileCount) + " files to " + root.generic_string());
+
+		return project;
+	}
+}
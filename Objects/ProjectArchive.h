@@ -0,0 +1,24 @@
+#pragma once
+#include <string>
+
+#define PROJECT_ARCHIVE_EXTENSION "sprjpack"
+
+namespace ed
+{
+	// a project and every file in its directory packed into one file: header, page aligned blobs, table of contents
+	// archives are memory mapped and unpacked to a working directory - only the files that changed are written out
+	class ProjectArchive
+	{
+	public:
+		static bool IsArchive(const std::string& file);
+
+		// directory that the archive is unpacked to, the project is saved there before it's packed
+		static std::string GetWorkingDirectory(const std::string& archive);
+
+		// packs every file in the directory, project is stored first
+		static bool Pack(const std::string& dir, const std::string& project, const std::string& archive);
+
+		// returns the path to the unpacked project file or an empty string
+		static std::string Unpack(const std::string& archive);
+	};
+}
@@ -0,0 +1,390 @@
+#include "ProjectHistory.h"
+#include "Hash.h"
+#include "../InterfaceManager.h"
+
+#include <string.h>
+#include <type_traits>
+
+#define PROJECT_HISTORY_SPAN_GAP 8 // changed ranges closer than this are stored as one
+
+namespace ed
+{
+	ProjectHistory::ProjectHistory(InterfaceManager* data)
+	{
+		m_data = data;
+		m_revision = 0;
+		m_pipelineGeneration = 0;
+		m_needsBaseline = true;
+
+		// the pass is still there when this is called - its children & variables go with it
+		m_data->Pipeline.Subscribe([this](PipelineManager::EventType type, PipelineItem* item) {
+			if (type != PipelineManager::EventType::ItemRemoved)
+				return;
+
+			m_forget(item);
+
+			std::vector<PipelineItem*>* children = nullptr;
+			ShaderVariableContainer* vars = nullptr;
+			if (item->Type == PipelineItem::ItemType::ShaderPass) {
+				children = &((pipe::ShaderPass*)item->Data)->Items;
+				vars = &((pipe::ShaderPass*)item->Data)->Variables;
+			} else if (item->Type == PipelineItem::ItemType::ComputePass)
+				vars = &((pipe::ComputePass*)item->Data)->Variables;
+			else if (item->Type == PipelineItem::ItemType::AudioPass)
+				vars = &((pipe::AudioPass*)item->Data)->Variables;
+
+			if (children != nullptr)
+				for (PipelineItem* child : *children)
+					m_forget(child);
+			if (vars != nullptr)
+				for (ShaderVariable* var : vars->GetVariables())
+					m_forget(var);
+		});
+	}
+	void ProjectHistory::Update(bool editing)
+	{
+		if (m_needsBaseline) {
+			m_scan(false);
+			m_needsBaseline = false;
+			m_revision = m_data->Parser.GetRevision();
+			m_pipelineGeneration = m_data->Pipeline.GetGeneration();
+			return;
+		}
+
+		// new items get their first copy before they are edited (opened project, added items)
+		bool modified = m_revision != m_data->Parser.GetRevision() || m_pipelineGeneration != m_data->Pipeline.GetGeneration();
+
+		// a drag or a text input that is still going on ends up in a single step
+		if (!modified || editing)
+			return;
+
+		m_revision = m_data->Parser.GetRevision();
+		m_pipelineGeneration = m_data->Pipeline.GetGeneration();
+		m_scan(true);
+	}
+	void ProjectHistory::Clear()
+	{
+		m_objects.clear();
+		m_undo.clear();
+		m_redo.clear();
+		m_needsBaseline = true;
+	}
+	void ProjectHistory::Undo()
+	{
+		m_scan(true); // the edit that wasn't committed yet is the one that gets undone
+
+		while (!m_undo.empty()) {
+			Step step = std::move(m_undo.back());
+			m_undo.pop_back();
+
+			// steps of the objects that have changed since then are skipped
+			if (m_apply(step, true)) {
+				m_push(m_redo, step);
+				break;
+			}
+		}
+	}
+	void ProjectHistory::Redo()
+	{
+		m_scan(true); // clears the redo stack if something was edited after the undo
+
+		while (!m_redo.empty()) {
+			Step step = std::move(m_redo.back());
+			m_redo.pop_back();
+
+			if (m_apply(step, false)) {
+				m_push(m_undo, step);
+				break;
+			}
+		}
+	}
+	void ProjectHistory::m_scan(bool record)
+	{
+		for (auto& obj : m_objects)
+			obj.second.Seen = false;
+
+		Step step;
+		step.Bytes = 0;
+
+		auto trackVariables = [&](ShaderVariableContainer& vars) {
+			// values of the system & function variables aren't edited by the user
+			for (ShaderVariable* var : vars.GetVariables())
+				if (var->System == SystemShaderVariable::None && var->Function == FunctionShaderVariable::None)
+					m_track(var, Kind::Variable, record, step);
+		};
+
+		for (PipelineItem* pass : m_data->Pipeline.GetList()) {
+			if (pass->Type == PipelineItem::ItemType::ShaderPass) {
+				pipe::ShaderPass* data = (pipe::ShaderPass*)pass->Data;
+				m_track(pass, Kind::ShaderPass, record, step);
+				trackVariables(data->Variables);
+
+				for (PipelineItem* child : data->Items) {
+					if (child->Type == PipelineItem::ItemType::Geometry)
+						m_track(child, Kind::Geometry, record, step);
+					else if (child->Type == PipelineItem::ItemType::Model)
+						m_track(child, Kind::Model, record, step);
+					else if (child->Type == PipelineItem::ItemType::RenderState)
+						m_track(child, Kind::RenderState, record, step);
+				}
+			} else if (pass->Type == PipelineItem::ItemType::ComputePass) {
+				m_track(pass, Kind::ComputePass, record, step);
+				trackVariables(((pipe::ComputePass*)pass->Data)->Variables);
+			} else if (pass->Type == PipelineItem::ItemType::AudioPass)
+				trackVariables(((pipe::AudioPass*)pass->Data)->Variables);
+		}
+
+		for (const std::string& name : m_data->Objects.GetObjects()) {
+			ObjectManagerItem* item = m_data->Objects.GetObjectManagerItem(name);
+			if (item != nullptr && item->RT != nullptr)
+				m_track(item->RT, Kind::RenderTexture, record, step);
+		}
+
+		// removed objects - the memory can be reused by the next object
+		std::vector<const void*> removed;
+		for (const auto& obj : m_objects)
+			if (!obj.second.Seen)
+				removed.push_back(obj.first);
+		for (const void* key : removed)
+			m_forget(key);
+
+		if (record && !step.Changes.empty()) {
+			m_push(m_undo, step);
+			m_redo.clear();
+		}
+	}
+	void ProjectHistory::m_track(const void* key, Kind type, bool record, Step& step)
+	{
+		uint64_t signature = m_signature(key, type);
+		std::vector<char> state = m_capture(key, type);
+
+		auto it = m_objects.find(key);
+		if (it == m_objects.end() || it->second.Type != type || it->second.Signature != signature || !record) {
+			// the old deltas don't fit this object anymore
+			if (it != m_objects.end() && (it->second.Type != type || it->second.Signature != signature))
+				m_forget(key);
+
+			Object& obj = m_objects[key];
+			obj.Type = type;
+			obj.Signature = signature;
+			obj.State.swap(state);
+			obj.Seen = true;
+			return;
+		}
+
+		Object& obj = it->second;
+		obj.Seen = true;
+		if (obj.State == state)
+			return;
+
+		Change change;
+		change.Key = key;
+		change.Signature = signature;
+
+		size_t size = state.size();
+		for (size_t i = 0; i < size;) {
+			if (obj.State[i] == state[i]) {
+				i++;
+				continue;
+			}
+
+			size_t start = i, end = i + 1;
+			for (size_t j = end; j < size && j - end < PROJECT_HISTORY_SPAN_GAP; j++)
+				if (obj.State[j] != state[j])
+					end = j + 1;
+
+			Span span;
+			span.Offset = (uint32_t)start;
+			span.Old.assign(obj.State.begin() + start, obj.State.begin() + end);
+			span.New.assign(state.begin() + start, state.begin() + end);
+			change.Spans.push_back(std::move(span));
+
+			step.Bytes += sizeof(Span) + (end - start) * 2;
+			i = end;
+		}
+
+		step.Bytes += sizeof(Change);
+		step.Changes.push_back(std::move(change));
+		obj.State.swap(state);
+	}
+	void ProjectHistory::m_fields(const void* key, Kind type, const FieldFunc& func)
+	{
+		switch (type) {
+		case Kind::Variable: {
+			ShaderVariable* var = (ShaderVariable*)key;
+			func(&var->Flags, sizeof(var->Flags));
+			func(var->Data, ShaderVariable::GetSize(var->GetType()));
+		} break;
+		case Kind::ShaderPass: {
+			pipe::ShaderPass* data = (pipe::ShaderPass*)((PipelineItem*)key)->Data;
+			func(&data->Active, sizeof(data->Active));
+			func(&data->Multisample, sizeof(data->Multisample));
+			func(&data->Accumulate, sizeof(data->Accumulate));
+			func(&data->AccumulateSamples, sizeof(data->AccumulateSamples));
+			func(data->VSPath, sizeof(data->VSPath));
+			func(data->VSEntry, sizeof(data->VSEntry));
+			func(data->PSPath, sizeof(data->PSPath));
+			func(data->PSEntry, sizeof(data->PSEntry));
+			func(data->GSPath, sizeof(data->GSPath));
+			func(data->GSEntry, sizeof(data->GSEntry));
+			func(&data->GSUsed, sizeof(data->GSUsed));
+			func(data->MSPath, sizeof(data->MSPath));
+			func(data->MSEntry, sizeof(data->MSEntry));
+			func(&data->MSUsed, sizeof(data->MSUsed));
+			func(data->TSPath, sizeof(data->TSPath));
+			func(data->TSEntry, sizeof(data->TSEntry));
+			func(&data->TSUsed, sizeof(data->TSUsed));
+			func(&data->MeshletsPerTask, sizeof(data->MeshletsPerTask));
+			func(&data->MeshTaskOffset, sizeof(data->MeshTaskOffset));
+			func(&data->ConditionOffset, sizeof(data->ConditionOffset));
+		} break;
+		case Kind::ComputePass: {
+			pipe::ComputePass* data = (pipe::ComputePass*)((PipelineItem*)key)->Data;
+			func(&data->WorkX, sizeof(data->WorkX));
+			func(&data->WorkY, sizeof(data->WorkY));
+			func(&data->WorkZ, sizeof(data->WorkZ));
+			func(&data->Iterations, sizeof(data->Iterations));
+			func(&data->PingPong, sizeof(data->PingPong));
+			func(&data->ConditionOffset, sizeof(data->ConditionOffset));
+			func(&data->AutoBarrier, sizeof(data->AutoBarrier));
+			func(data->Path, sizeof(data->Path));
+			func(data->Entry, sizeof(data->Entry));
+		} break;
+		case Kind::Geometry: {
+			pipe::GeometryItem* data = (pipe::GeometryItem*)((PipelineItem*)key)->Data;
+			func(&data->Position, sizeof(data->Position));
+			func(&data->Rotation, sizeof(data->Rotation));
+			func(&data->Scale, sizeof(data->Scale));
+			func(&data->InstanceCount, sizeof(data->InstanceCount));
+			func(&data->OcclusionCulling, sizeof(data->OcclusionCulling));
+			func(&data->FrustumCulling, sizeof(data->FrustumCulling));
+			func(&data->GPUCulling, sizeof(data->GPUCulling));
+		} break;
+		case Kind::Model: {
+			pipe::Model* data = (pipe::Model*)((PipelineItem*)key)->Data;
+			func(&data->Position, sizeof(data->Position));
+			func(&data->Rotation, sizeof(data->Rotation));
+			func(&data->Scale, sizeof(data->Scale));
+			func(&data->InstanceCount, sizeof(data->InstanceCount));
+			func(&data->LOD, sizeof(data->LOD));
+			func(&data->FrustumCulling, sizeof(data->FrustumCulling));
+			func(&data->GPUCulling, sizeof(data->GPUCulling));
+		} break;
+		case Kind::RenderState: {
+			static_assert(std::is_trivially_copyable<pipe::RenderState>::value, "RenderState is copied as a whole");
+			func(((PipelineItem*)key)->Data, sizeof(pipe::RenderState));
+		} break;
+		case Kind::RenderTexture: {
+			RenderTextureObject* rt = (RenderTextureObject*)key;
+			func(&rt->ClearColor, sizeof(rt->ClearColor));
+			func(&rt->Clear, sizeof(rt->Clear));
+		} break;
+		}
+	}
+	uint64_t ProjectHistory::m_signature(const void* key, Kind type)
+	{
+		uint64_t ret = HashString(std::to_string((int)type));
+
+		if (type == Kind::Variable) {
+			ShaderVariable* var = (ShaderVariable*)key;
+			ret = HashString(std::to_string((int)var->GetType()) + ";" + std::to_string((int)var->System) + ";" + std::to_string((int)var->Function), ret);
+		}
+
+		return ret;
+	}
+	std::vector<char> ProjectHistory::m_capture(const void* key, Kind type)
+	{
+		std::vector<char> ret;
+		m_fields(key, type, [&](void* field, size_t size) {
+			ret.insert(ret.end(), (char*)field, (char*)field + size);
+		});
+		return ret;
+	}
+	bool ProjectHistory::m_apply(Step& step, bool undo)
+	{
+		bool applied = false;
+		for (const Change& change : step.Changes) {
+			auto it = m_objects.find(change.Key);
+			if (it == m_objects.end() || it->second.Signature != change.Signature)
+				continue;
+
+			Object& obj = it->second;
+			std::vector<char> state = obj.State;
+
+			bool valid = true;
+			for (const Span& span : change.Spans) {
+				const std::vector<char>& from = undo ? span.New : span.Old;
+				if (span.Offset + from.size() > state.size() || memcmp(state.data() + span.Offset, from.data(), from.size()) != 0) {
+					valid = false;
+					break;
+				}
+			}
+			if (!valid)
+				continue;
+
+			for (const Span& span : change.Spans) {
+				const std::vector<char>& to = undo ? span.Old : span.New;
+				memcpy(state.data() + span.Offset, to.data(), to.size());
+			}
+
+			// a different shader has to be compiled
+			std::vector<char> shaders;
+			if (obj.Type == Kind::ShaderPass || obj.Type == Kind::ComputePass)
+				shaders = obj.State;
+
+			size_t offset = 0;
+			m_fields(change.Key, obj.Type, [&](void* field, size_t size) {
+				memcpy(field, state.data() + offset, size);
+				offset += size;
+			});
+			obj.State.swap(state);
+
+			if (!shaders.empty() && shaders != obj.State) {
+				PipelineItem* item = (PipelineItem*)change.Key;
+				m_data->Renderer.Recompile(item->Name);
+			}
+
+			applied = true;
+		}
+
+		if (applied) {
+			m_data->Parser.ModifyProject();
+			m_data->Renderer.InvalidatePassCache();
+			m_revision = m_data->Parser.GetRevision();
+		}
+
+		return applied;
+	}
+	void ProjectHistory::m_push(std::deque<Step>& stack, Step& step)
+	{
+		stack.push_back(std::move(step));
+
+		size_t bytes = 0;
+		for (const Step& s : stack)
+			bytes += s.Bytes;
+
+		while (stack.size() > 1 && (stack.size() > PROJECT_HISTORY_MAX_STEPS || bytes > PROJECT_HISTORY_MAX_BYTES)) {
+			bytes -= stack.front().Bytes;
+			stack.pop_front();
+		}
+	}
+	void ProjectHistory::m_forget(const void* key)
+	{
+		m_objects.erase(key);
+
+		for (std::deque<Step>* stack : { &m_undo, &m_redo }) {
+			for (auto step = stack->begin(); step != stack->end();) {
+				for (size_t i = 0; i < step->Changes.size(); i++)
+					if (step->Changes[i].Key == key) {
+						step->Changes.erase(step->Changes.begin() + i);
+						i--;
+					}
+
+				if (step->Changes.empty())
+					step = stack->erase(step);
+				else
+					++step;
+			}
+		}
+	}
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <deque>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+#include <stdint.h>
+
+#define PROJECT_HISTORY_MAX_STEPS 256
+#define PROJECT_HISTORY_MAX_BYTES (4 * 1024 * 1024) // of the stored deltas, the oldest steps are dropped first
+
+namespace ed
+{
+	class InterfaceManager;
+
+	// undo/redo for the properties of the pipeline items, the variables & the render textures - every tracked
+	// object has a copy of its last committed state, once an edit is done (ProjectParser::ModifyProject() was called and
+	// no widget is active anymore) the objects are compared to their copies and only the changed byte ranges are stored
+	// adding, removing & renaming objects isn't undone, the history of a removed object is dropped
+	class ProjectHistory
+	{
+	public:
+		ProjectHistory(InterfaceManager* data);
+
+		void Update(bool editing); // once per frame, commits the finished edits - editing -> a widget is still active
+		void Clear();  // new project - everything is captured again
+
+		inline bool CanUndo() { return !m_undo.empty(); }
+		inline bool CanRedo() { return !m_redo.empty(); }
+		void Undo();
+		void Redo();
+
+	private:
+		enum class Kind
+		{
+			Variable,
+			ShaderPass,
+			ComputePass,
+			Geometry,
+			Model,
+			RenderState,
+			RenderTexture
+		};
+		typedef std::function<void(void* field, size_t size)> FieldFunc;
+
+		struct Object
+		{
+			Kind Type;
+			uint64_t Signature; // state with another signature can't be applied (variable type changed, etc...)
+			std::vector<char> State;
+			bool Seen;
+		};
+		struct Span
+		{
+			uint32_t Offset;
+			std::vector<char> Old, New;
+		};
+		struct Change
+		{
+			const void* Key;
+			uint64_t Signature;
+			std::vector<Span> Spans;
+		};
+		struct Step
+		{
+			std::vector<Change> Changes;
+			size_t Bytes;
+		};
+
+		void m_scan(bool record);
+		void m_track(const void* key, Kind type, bool record, Step& step);
+		void m_fields(const void* key, Kind type, const FieldFunc& func); // the tracked members of an object
+		uint64_t m_signature(const void* key, Kind type);
+		std::vector<char> m_capture(const void* key, Kind type);
+
+		bool m_apply(Step& step, bool undo);
+		void m_push(std::deque<Step>& stack, Step& step);
+		void m_forget(const void* key);
+
+		InterfaceManager* m_data;
+		std::unordered_map<const void*, Object> m_objects;
+		std::deque<Step> m_undo, m_redo; // newest at the back
+		unsigned int m_revision, m_pipelineGeneration;
+		bool m_needsBaseline;
+	};
+}
@@ -8,10 +8,20 @@
 #include "SystemVariableManager.h"
 #include "FunctionVariableManager.h"
 #include "ShaderTranscompiler.h"
+#include "ProjectArchive.h"
 #include "InputLayout.h"
 #include "Names.h"
 #include "Logger.h"
+#include "Hash.h"
 #include "DefaultState.h"
+#include "GeometryCache.h"
+#include "GeometryGenerator.h"
+#include "VAOCache.h"
+#include "ProfilerZones.h"
+#include "TraceRecorder.h"
+#include "TextureSharing.h"
+#include "ProjectRecovery.h"
+#include "ResidentAssets.h"
 #include "PluginAPI/PluginManager.h"
 
 #include "../UI/PinnedUI.h"
@@ -19,10 +29,16 @@
 #include "../UI/PipelineUI.h"
 #include "../UI/CodeEditorUI.h"
 #include "../Engine/GLUtils.h"
-#include "../Engine/GeometryFactory.h"
+#include "../Engine/MappedFile.h"
 
 #include <fstream>
+#include <sstream>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <functional>
 #include <ghc/filesystem.hpp>
+#include <SFML/Audio/InputSoundFile.hpp>
 
 #define HARRAYSIZE(a) (sizeof(a)/sizeof(*a))
 
@@ -53,6 +69,53 @@ namespace ed
 		std::replace(ret.begin(), ret.end(), '\\', '/');
 		return ret;
 	}
+	void exportFill(pugi::xml_node& node, const GPUFill::Operation& op)
+	{
+		static const char* TYPE_NAMES[] = { "float", "int", "uint" };
+
+		pugi::xml_node fillNode = node.append_child("fill");
+		fillNode.append_attribute("op").set_value(GPUFill::GetOperatorName(op.Op));
+		for (int i = 0; i < 2; i++) {
+			const glm::vec4& value = i == 0 ? op.A : op.B;
+			pugi::xml_node valueNode = fillNode.append_child(i == 0 ? "a" : "b");
+			valueNode.append_attribute("x").set_value(value.x);
+			valueNode.append_attribute("y").set_value(value.y);
+			valueNode.append_attribute("z").set_value(value.z);
+			valueNode.append_attribute("w").set_value(value.w);
+		}
+		if (op.Op == GPUFill::Operator::Noise)
+			fillNode.append_attribute("frequency").set_value(op.Frequency);
+		if (op.Seed != 0)
+			fillNode.append_attribute("seed").set_value(op.Seed);
+		fillNode.append_attribute("type").set_value(TYPE_NAMES[(int)op.Type]);
+		fillNode.append_attribute("components").set_value(op.Components);
+		if (op.Op == GPUFill::Operator::Copy)
+			fillNode.append_attribute("source").set_value(op.Source.c_str());
+	}
+	GPUFill::Operation importFill(const pugi::xml_node& node)
+	{
+		GPUFill::Operation op;
+		pugi::xml_node fillNode = node.child("fill");
+		if (!fillNode)
+			return op;
+
+		op.Op = GPUFill::GetOperator(fillNode.attribute("op").as_string());
+		for (int i = 0; i < 2; i++) {
+			glm::vec4& value = i == 0 ? op.A : op.B;
+			pugi::xml_node valueNode = fillNode.child(i == 0 ? "a" : "b");
+			value.x = valueNode.attribute("x").as_float(value.x);
+			value.y = valueNode.attribute("y").as_float(value.y);
+			value.z = valueNode.attribute("z").as_float(value.z);
+			value.w = valueNode.attribute("w").as_float(value.w);
+		}
+		op.Frequency = fillNode.attribute("frequency").as_float(op.Frequency);
+		op.Seed = fillNode.attribute("seed").as_uint(0);
+		std::string type = fillNode.attribute("type").as_string("float");
+		op.Type = type == "int" ? GPUFill::ElementType::Int : (type == "uint" ? GPUFill::ElementType::Uint : GPUFill::ElementType::Float);
+		op.Components = std::max(std::min(fillNode.attribute("components").as_int(1), 4), 1);
+		op.Source = fillNode.attribute("source").as_string();
+		return op;
+	}
 	std::string newShaderFilename(const std::string& proj, const std::string& shaderpass, const std::string& stage, const std::string& ext)
 	{
 		return proj + "_" + shaderpass + stage + "." + ext; // eg: project_SimpleVS.glsl
@@ -63,13 +126,36 @@ namespace ed
 	{
 		ResetProjectDirectory();
 		m_ui = gui;
+		m_loadDone = 0;
+		m_loadTotal = 0;
+		m_revision = 0;
 	}
 	ProjectParser::~ProjectParser()
 	{}
 	void ProjectParser::Open(const std::string & file)
 	{
+		ED_ZONE("ProjectParser::Open");
+		ED_ZONE_TEXT(file);
+
+		if (ProjectArchive::IsArchive(file)) {
+			std::string project = ProjectArchive::Unpack(file);
+			if (project.empty())
+				return;
+
+			Open(project);
+			m_archive = file;
+			return;
+		}
+		m_archive = "";
+
 		Logger::Get().Log("Openning a project file " + file);
 
+		// left behind by a crash, it isn't opened automatically
+		std::error_code recoveryErr;
+		std::string recovery = ProjectRecovery::GetSnapshotPath(file);
+		if (ghc::filesystem::exists(recovery, recoveryErr) && ghc::filesystem::last_write_time(recovery, recoveryErr) > ghc::filesystem::last_write_time(file, recoveryErr))
+			Logger::Get().Log("Found unsaved changes of this project in " + recovery + " - open it to recover them", true);
+
 		pugi::xml_document doc;
 		pugi::xml_parse_result result = doc.load_file(file.c_str());
 		if (!result) {
@@ -99,7 +185,7 @@ namespace ed
 				};
 				const SDL_MessageBoxData messageboxdata = {
 					SDL_MESSAGEBOX_INFORMATION, /* .flags */
-					m_ui->GetSDLWindow(), /* .window */
+					m_ui != nullptr ? m_ui->GetSDLWindow() : nullptr, /* .window */
 					"SHADERed", /* .title */
 					msg.c_str(), /* .message */
 					SDL_arraysize(buttons), /* .numbuttons */
@@ -126,7 +212,7 @@ namespace ed
 				};
 				const SDL_MessageBoxData messageboxdata = {
 					SDL_MESSAGEBOX_INFORMATION, /* .flags */
-					m_ui->GetSDLWindow(), /* .window */
+					m_ui != nullptr ? m_ui->GetSDLWindow() : nullptr, /* .window */
 					"SHADERed", /* .title */
 					msg.c_str(), /* .message */
 					SDL_arraysize(buttons), /* .numbuttons */
@@ -154,7 +240,7 @@ namespace ed
 					};
 					const SDL_MessageBoxData messageboxdata = {
 						SDL_MESSAGEBOX_INFORMATION, /* .flags */
-						m_ui->GetSDLWindow(), /* .window */
+						m_ui != nullptr ? m_ui->GetSDLWindow() : nullptr, /* .window */
 						"SHADERed", /* .title */
 						msg.c_str(), /* .message */
 						SDL_arraysize(buttons), /* .numbuttons */
@@ -180,6 +266,15 @@ namespace ed
 
 		CameraSnapshots::Clear();
 
+		// the loaded files are handed over to the new project (while the paths still point to the old directory),
+		// it takes back the ones that didn't change
+		for (auto& mdl : m_models)
+			ResidentAssets::Instance().KeepModel(GetProjectPath(mdl.first), m_modelFlags(), mdl.second);
+		m_models.clear();
+
+		m_pipe->Clear();
+		m_objects->Clear(true);
+
 		m_file = file;
 		SetProjectDirectory(file.substr(0, file.find_last_of("/\\")));
 
@@ -188,18 +283,16 @@ namespace ed
 		m_debug->ClearWatchList();
 		m_debug->ClearBreakpointList();
 
-		for (auto& mdl : m_models) {
-			delete mdl.second;
-			mdl.second = nullptr;
-		}
-		m_models.clear();
-
-		m_pipe->Clear();
-		m_objects->Clear();
-
 		Settings::Instance().Project.FPCamera = false;
 		Settings::Instance().Project.ClearColor = glm::vec4(0, 0, 0, 0);
 		Settings::Instance().Project.UseAlphaChannel = false;
+		Settings::Instance().Project.SPIRVOptimization = 0;
+		Settings::Instance().Project.AudioTextureArray = false;
+		Settings::Instance().Project.BindlessTextures = false;
+		Settings::Instance().Project.EyeSeparation = 0.064f;
+		Settings::Instance().Project.StereoConvergence = 10.0f;
+		Settings::Instance().Project.StereoPreview.clear();
+		TextureSharing::Instance().Clear();
 
 		pugi::xml_node projectNode = doc.child("project");
 		int projectVersion = 1; // if no project version is specified == using first project file
@@ -210,6 +303,13 @@ namespace ed
 		for (const auto& pname : m_pluginList)
 			m_plugins->GetPlugin(pname)->BeginProjectLoading();
 
+		// files are read & decoded on the workers while the XML is parsed and the GL objects are created here
+		auto loadStart = std::chrono::steady_clock::now();
+		m_loadDone = 0;
+		m_loadTotal = 0;
+		m_prefetchModels(projectNode);
+		m_prefetchObjects(projectNode);
+
 		switch (projectVersion) {
 			case 1: m_parseV1(projectNode); break;
 			case 2: m_parseV2(projectNode); break;
@@ -218,6 +318,10 @@ namespace ed
 			break;
 		}
 
+		m_finishLoadJobs();
+		ResidentAssets::Instance().Flush();
+		Logger::Get().Log("Loaded " + std::to_string(m_loadTotal) + " project resources in " + std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - loadStart).count()) + "ms");
+
 		m_modified = false;
 
 		// reset time, frame index, etc...
@@ -236,10 +340,24 @@ namespace ed
 	}
 	void ProjectParser::Save()
 	{
-		SaveAs(m_file);
+		SaveAs(m_archive.empty() ? m_file : m_archive);
 	}
 	void ProjectParser::SaveAs(const std::string & file, bool copyFiles)
 	{
+		// the project is saved to the archive's working directory (with all of its files) and then packed
+		if (ProjectArchive::IsArchive(file)) {
+			std::string dir = ProjectArchive::GetWorkingDirectory(file);
+			std::string project = dir + "/" + ghc::filesystem::path(file).stem().generic_string() + ".sprj";
+
+			ghc::filesystem::create_directories(dir);
+			SaveAs(project, project != m_file);
+
+			if (ProjectArchive::Pack(dir, project, file))
+				m_archive = file;
+			return;
+		}
+		m_archive = "";
+
 		Logger::Get().Log("Saving project file...");
 
 		m_pluginList.clear();
@@ -249,7 +367,6 @@ namespace ed
 		SetProjectDirectory(file.substr(0, file.find_last_of("/\\")));
 
 		std::vector<PipelineItem*> passItems = m_pipe->GetList();
-		std::vector<pipe::ShaderPass*> collapsedSP = ((PipelineUI*)m_ui->Get(ViewID::Pipeline))->GetCollapsedItems();
 
 		std::string projectStem = "proj";
 		if (ghc::filesystem::path(file).has_stem())
@@ -261,7 +378,6 @@ namespace ed
 			Logger::Get().Log("Copying shader files...");
 
 			ghc::filesystem::create_directories(shadersDir);
-			std::error_code errc;
 
 			std::string proj = oldProjectPath + ((oldProjectPath[oldProjectPath.size() - 1] == '/') ? "" : "/");
 			
@@ -276,18 +392,27 @@ namespace ed
 					std::string psExt = getExtension(ps);
 
 					
-					ghc::filesystem::copy_file(vs, shadersDir + "/" + newShaderFilename(projectStem, passItem->Name, "VS", vsExt), ghc::filesystem::copy_options::overwrite_existing, errc);
-					ghc::filesystem::copy_file(ps, shadersDir + "/" + newShaderFilename(projectStem, passItem->Name, "PS", psExt), ghc::filesystem::copy_options::overwrite_existing, errc);
+					bool copied = m_copyFile(vs, shadersDir + "/" + newShaderFilename(projectStem, passItem->Name, "VS", vsExt));
+					copied &= m_copyFile(ps, shadersDir + "/" + newShaderFilename(projectStem, passItem->Name, "PS", psExt));
 
 					if (passData->GSUsed) {
 						std::string gs = ghc::filesystem::path(passData->GSPath).is_absolute() ? passData->GSPath : (proj + std::string(passData->GSPath));
 						std::string gsExt = getExtension(gs);
 
-						ghc::filesystem::copy_file(gs, shadersDir + "/" + newShaderFilename(projectStem, passItem->Name, "GS", gsExt), ghc::filesystem::copy_options::overwrite_existing, errc);
+						copied &= m_copyFile(gs, shadersDir + "/" + newShaderFilename(projectStem, passItem->Name, "GS", gsExt));
 					}
+					if (passData->MSUsed) {
+						std::string ms = ghc::filesystem::path(passData->MSPath).is_absolute() ? passData->MSPath : (proj + std::string(passData->MSPath));
+						copied &= m_copyFile(ms, shadersDir + "/" + newShaderFilename(projectStem, passItem->Name, "MS", getExtension(ms)));
 
-					if (errc)
-						ed::Logger::Get().Log("Failed to copy a file (source == destination)", true);
+						if (passData->TSUsed) {
+							std::string ts = ghc::filesystem::path(passData->TSPath).is_absolute() ? passData->TSPath : (proj + std::string(passData->TSPath));
+							copied &= m_copyFile(ts, shadersDir + "/" + newShaderFilename(projectStem, passItem->Name, "TS", getExtension(ts)));
+						}
+					}
+
+					if (!copied)
+						ed::Logger::Get().Log("Failed to copy the shaders of " + std::string(passItem->Name), true);
 				} 
 				else if (passItem->Type == PipelineItem::ItemType::ComputePass) {
 					pipe::ComputePass *passData = (pipe::ComputePass*)passItem->Data;
@@ -295,9 +420,8 @@ namespace ed
 					std::string cs = ghc::filesystem::path(passData->Path).is_absolute() ? passData->Path : (proj + std::string(passData->Path));
 					std::string csExt = getExtension(cs);
 
-					ghc::filesystem::copy_file(cs, shadersDir + "/" + newShaderFilename(projectStem, passItem->Name, "CS", csExt), ghc::filesystem::copy_options::overwrite_existing, errc);
-					if (errc)
-						ed::Logger::Get().Log("Failed to copy a file (source == destination)", true);
+					if (!m_copyFile(cs, shadersDir + "/" + newShaderFilename(projectStem, passItem->Name, "CS", csExt)))
+						ed::Logger::Get().Log("Failed to copy the shader of " + std::string(passItem->Name), true);
 				} 
 				else if (passItem->Type == PipelineItem::ItemType::AudioPass) {
 					pipe::AudioPass *passData = (pipe::AudioPass*)passItem->Data;
@@ -305,9 +429,8 @@ namespace ed
 					std::string ss = ghc::filesystem::path(passData->Path).is_absolute() ? passData->Path : (proj + std::string(passData->Path));
 					std::string ssExt = getExtension(ss);
 
-					ghc::filesystem::copy_file(ss, shadersDir + "/" + newShaderFilename(projectStem, passItem->Name, "SS", ssExt), ghc::filesystem::copy_options::overwrite_existing, errc);
-					if (errc)
-						ed::Logger::Get().Log("Failed to copy a file (source == destination)", true);
+					if (!m_copyFile(ss, shadersDir + "/" + newShaderFilename(projectStem, passItem->Name, "SS", ssExt)))
+						ed::Logger::Get().Log("Failed to copy the shader of " + std::string(passItem->Name), true);
 				}
 				else if (passItem->Type == PipelineItem::ItemType::PluginItem) {
 					pipe::PluginItemData* pdata = (pipe::PluginItemData*)passItem->Data;
@@ -320,6 +443,53 @@ namespace ed
 		}
 
 		pugi::xml_document doc;
+		m_exportProject(doc, oldProjectPath, copyFiles, projectStem, true);
+
+		std::ostringstream out;
+		doc.save(out);
+		std::string xml = out.str();
+		if (!m_writeFile(file, xml.c_str(), xml.size()))
+			Logger::Get().Log("Failed to write the project file " + file, true);
+	}
+	std::string ProjectParser::ExportRecoverySnapshot(const std::vector<std::pair<std::string, std::string>>& sources)
+	{
+		m_pluginList.clear();
+
+		pugi::xml_document doc;
+		m_exportProject(doc, m_projectPath, false, "", false);
+
+		// the unsaved shaders are loaded from their copies - paths are compared the way they were exported
+		std::vector<std::pair<std::string, std::string>> redirects;
+		for (const auto& source : sources) {
+			std::string exported = ghc::filesystem::path(source.first).is_absolute() ? source.first : GetRelativePath(m_projectPath + ((m_projectPath[m_projectPath.size() - 1] == '/') ? "" : "/") + source.first);
+			redirects.push_back(std::make_pair(exported, source.second));
+		}
+
+		std::function<void(pugi::xml_node)> redirect = [&](pugi::xml_node node) {
+			for (pugi::xml_node child : node.children()) {
+				// the text of the <path> nodes of the shaders
+				if (child.type() == pugi::node_pcdata && strcmp(node.name(), "path") == 0) {
+					for (const auto& r : redirects)
+						if (r.first == child.value()) {
+							child.set_value(r.second.c_str());
+							break;
+						}
+				}
+
+				redirect(child);
+			}
+		};
+		redirect(doc);
+
+		std::ostringstream out;
+		doc.save(out);
+		return out.str();
+	}
+	void ProjectParser::m_exportProject(pugi::xml_document& doc, const std::string& oldProjectPath, bool copyFiles, const std::string& projectStem, bool writeFiles)
+	{
+		std::vector<PipelineItem*> passItems = m_pipe->GetList();
+		std::vector<pipe::ShaderPass*> collapsedSP = ((PipelineUI*)m_ui->Get(ViewID::Pipeline))->GetCollapsedItems();
+
 		pugi::xml_node projectNode = doc.append_child("project");
 		projectNode.append_attribute("version").set_value(2);
 		pugi::xml_node pipelineNode = projectNode.append_child("pipeline");
@@ -337,6 +507,25 @@ namespace ed
 
 				passNode.append_attribute("type").set_value("shader");
 				passNode.append_attribute("active").set_value(passData->Active);
+				if (!passData->Multisample)
+					passNode.append_attribute("msaa").set_value(false);
+				if (passData->Accumulate) {
+					passNode.append_attribute("accumulate").set_value(true);
+					passNode.append_attribute("samples").set_value(passData->AccumulateSamples);
+				}
+				if (passData->DepthPrepass)
+					passNode.append_attribute("depthprepass").set_value(true);
+				if (passData->Multiview)
+					passNode.append_attribute("multiview").set_value(true);
+				if (passData->ShadingRate > 0)
+					passNode.append_attribute("shadingrate").set_value(SHADING_RATE_NAMES[passData->ShadingRate]);
+				if (!passData->ShadingRateImage.empty())
+					passNode.append_attribute("shadingrateimage").set_value(passData->ShadingRateImage.c_str());
+				if (passData->ResolutionScale > 1) {
+					passNode.append_attribute("resolution").set_value(passData->ResolutionScale);
+					if (!passData->EdgeAwareUpsample)
+						passNode.append_attribute("edgeaware").set_value(false);
+				}
 
 				/* collapsed="true" attribute */
 				for (int i = 0; i < collapsedSP.size(); i++)
@@ -385,6 +574,46 @@ namespace ed
 					gsNode.append_attribute("entry").set_value(passData->GSEntry);
 				}
 
+				// mesh & task shaders
+				if (strlen(passData->MSPath) > 0) {
+					pugi::xml_node msNode = passNode.append_child("shader");
+					relativePath = (ghc::filesystem::path(passData->MSPath).is_absolute()) ? passData->MSPath : GetRelativePath(oldProjectPath + ((oldProjectPath[oldProjectPath.size() - 1] == '/') ? "" : "/") + std::string(passData->MSPath));
+					if (copyFiles)
+						relativePath = "shaders/" + newShaderFilename(projectStem, passItem->Name, "MS", getExtension(passData->MSPath));
+
+					msNode.append_attribute("used").set_value(passData->MSUsed);
+					msNode.append_attribute("type").set_value("ms");
+					msNode.append_attribute("path").set_value(relativePath.c_str());
+					msNode.append_attribute("entry").set_value(passData->MSEntry);
+					msNode.append_attribute("meshletspertask").set_value(passData->MeshletsPerTask);
+				}
+				if (strlen(passData->TSPath) > 0) {
+					pugi::xml_node tsNode = passNode.append_child("shader");
+					relativePath = (ghc::filesystem::path(passData->TSPath).is_absolute()) ? passData->TSPath : GetRelativePath(oldProjectPath + ((oldProjectPath[oldProjectPath.size() - 1] == '/') ? "" : "/") + std::string(passData->TSPath));
+					if (copyFiles)
+						relativePath = "shaders/" + newShaderFilename(projectStem, passItem->Name, "TS", getExtension(passData->TSPath));
+
+					tsNode.append_attribute("used").set_value(passData->TSUsed);
+					tsNode.append_attribute("type").set_value("ts");
+					tsNode.append_attribute("path").set_value(relativePath.c_str());
+					tsNode.append_attribute("entry").set_value(passData->TSEntry);
+				}
+				if (passData->MeshTaskBuffer != nullptr) {
+					pugi::xml_node indirectNode = passNode.append_child("indirect");
+					indirectNode.append_attribute("buffer").set_value(m_objects->GetBufferNameByID(((BufferObject*)passData->MeshTaskBuffer)->ID).c_str());
+					indirectNode.append_attribute("offset").set_value(passData->MeshTaskOffset);
+				}
+				if (passData->ConditionBuffer != nullptr) {
+					pugi::xml_node conditionNode = passNode.append_child("condition");
+					conditionNode.append_attribute("buffer").set_value(m_objects->GetBufferNameByID(((BufferObject*)passData->ConditionBuffer)->ID).c_str());
+					conditionNode.append_attribute("offset").set_value(passData->ConditionOffset);
+				}
+				if (passData->CaptureBuffer != nullptr) {
+					pugi::xml_node captureNode = passNode.append_child("capture");
+					captureNode.append_attribute("buffer").set_value(m_objects->GetBufferNameByID(((BufferObject*)passData->CaptureBuffer)->ID).c_str());
+					captureNode.append_attribute("outputs").set_value(passData->CaptureOutputs);
+				}
+
 				/* vs input layout */
 				pugi::xml_node iLayout = passNode.append_child("inputlayout");
 				for (auto& iteminp : passData->InputLayout) {
@@ -470,6 +699,40 @@ namespace ed
 				workNode.append_attribute("y").set_value(passData->WorkY);
 				workNode.append_attribute("z").set_value(passData->WorkZ);
 
+				// iterations
+				if (passData->Iterations > 1 || passData->PingPong || passData->TickRate > 0.0f) {
+					pugi::xml_node iterNode = passNode.append_child("iterations");
+					iterNode.append_attribute("count").set_value(passData->Iterations);
+					iterNode.append_attribute("pingpong").set_value(passData->PingPong);
+					if (passData->TickRate > 0.0f)
+						iterNode.append_attribute("tickrate").set_value(passData->TickRate);
+				}
+
+				// indirect dispatch
+				if (passData->IndirectBuffer != nullptr) {
+					pugi::xml_node indirectNode = passNode.append_child("indirect");
+					indirectNode.append_attribute("buffer").set_value(m_objects->GetBufferNameByID(((BufferObject*)passData->IndirectBuffer)->ID).c_str());
+					indirectNode.append_attribute("offset").set_value(passData->IndirectOffset);
+				}
+
+				// GPU side condition
+				if (passData->ConditionBuffer != nullptr) {
+					pugi::xml_node conditionNode = passNode.append_child("condition");
+					conditionNode.append_attribute("buffer").set_value(m_objects->GetBufferNameByID(((BufferObject*)passData->ConditionBuffer)->ID).c_str());
+					conditionNode.append_attribute("offset").set_value(passData->ConditionOffset);
+				}
+
+				// memory barrier
+				pugi::xml_node barrierNode = passNode.append_child("barrier");
+				barrierNode.append_attribute("auto").set_value(passData->AutoBarrier);
+				if (!passData->AutoBarrier) {
+					std::string bits = "";
+					for (int k = 0; k < HARRAYSIZE(BARRIER_NAMES); k++)
+						if (passData->Barrier & BARRIER_VALUES[k])
+							bits += (bits.empty() ? "" : "|") + std::string(BARRIER_NAMES[k]);
+					barrierNode.append_attribute("bits").set_value(bits.c_str());
+				}
+
 				// variables -> now global in pass element [V2]
 				m_exportShaderVariables(passNode, passData->Variables.GetVariables());
 
@@ -559,18 +822,36 @@ namespace ed
 			for (int i = 0; i < texs.size(); i++) {
 				bool isRT = m_objects->IsRenderTexture(texs[i]);
 				bool isAudio = m_objects->IsAudio(texs[i]);
-				bool isCube = m_objects->IsCubeMap(texs[i]);
+				bool isEnv = m_objects->IsEnvironment(texs[i]);
+				bool isEnvPart = m_objects->IsEnvironmentPart(texs[i]);
+				bool isCube = m_objects->IsCubeMap(texs[i]) && !isEnv && !isEnvPart;
 				bool isBuffer = m_objects->IsBuffer(texs[i]);
 				bool isImage = m_objects->IsImage(texs[i]);
 				bool isImage3D = m_objects->IsImage3D(texs[i]);
+				bool isTexArray = m_objects->IsTextureArray(texs[i]);
 				bool isPluginOwner = m_objects->IsPluginObject(texs[i]);
+				bool isVideo = m_objects->IsVideo(texs[i]);
+				bool isCapture = m_objects->IsCaptureDevice(texs[i]);
+				bool isHistory = m_objects->IsRenderTextureHistory(texs[i]);
+				bool isVirtual = m_objects->IsVirtualTexture(texs[i]);
+				bool isSequence = m_objects->IsImageSequence(texs[i]);
 
 				pugi::xml_node textureNode = objectsNode.append_child("object");
-				textureNode.append_attribute("type").set_value(isBuffer ? "buffer" : (isRT ? "rendertexture" : (isAudio ? "audio" : (isImage ? "image" : (isImage3D ? "image3d" : (isPluginOwner ? "pluginobject" : "texture"))))));
-				textureNode.append_attribute((isRT || isCube || isBuffer || isImage || isImage3D || isPluginOwner) ? "name" : "path").set_value(texs[i].c_str());
+				textureNode.append_attribute("type").set_value(isBuffer ? "buffer" : (isRT ? "rendertexture" : (isAudio ? "audio" : (isImage ? "image" : (isImage3D ? "image3d" : (isTexArray ? "texturearray" : (isPluginOwner ? "pluginobject" : (isVideo ? (isCapture ? "capture" : "video") : (isHistory ? "history" : (isVirtual ? "virtualtexture" : (isEnv ? "environment" : (isEnvPart ? "environmentpart" : (isSequence ? "imagesequence" : "texture")))))))))))));
+				textureNode.append_attribute((isRT || isCube || isBuffer || isImage || isImage3D || isTexArray || isPluginOwner || isCapture || isHistory || isEnvPart) ? "name" : "path").set_value(texs[i].c_str());
+				if (isHistory)
+					textureNode.append_attribute("source").set_value(m_objects->GetRenderTextureHistorySource(texs[i]).c_str());
+				if (isEnvPart)
+					textureNode.append_attribute("source").set_value(m_objects->GetEnvironmentSource(texs[i]).c_str());
+				if (isEnv && m_objects->GetEnvironment(texs[i])->GetFaceSize() != ENVIRONMENT_FACE_SIZE)
+					textureNode.append_attribute("size").set_value(m_objects->GetEnvironment(texs[i])->GetFaceSize());
 
 				if (!isRT && !isAudio && !isBuffer && !isImage && !isImage3D && !isPluginOwner && isCube)
 					textureNode.append_attribute("cube").set_value(isCube);
+				if (m_objects->HasTextureMipmaps(texs[i]))
+					textureNode.append_attribute("mipmaps").set_value(true);
+				if (isAudio && m_objects->GetAudioTrackRate(texs[i]) >= 0)
+					textureNode.append_attribute("wholetrack").set_value(m_objects->GetAudioTrackRate(texs[i]));
 
 				if (isRT) {
 					ed::RenderTextureObject* rtObj = m_objects->GetRenderTexture(m_objects->GetTexture(texs[i]));
@@ -584,6 +865,15 @@ namespace ed
 						textureNode.append_attribute("rsize").set_value((std::to_string(rtObj->RatioSize.x) + "," + std::to_string(rtObj->RatioSize.y)).c_str());
 
 					textureNode.append_attribute("clear").set_value(rtObj->Clear);
+					if (rtObj->Cubemap)
+						textureNode.append_attribute("cubemap").set_value(true);
+					else if (rtObj->Layers > 1)
+						textureNode.append_attribute("layers").set_value(rtObj->Layers);
+					if (rtObj->Mipmaps) {
+						textureNode.append_attribute("mipmaps").set_value(true);
+						if (rtObj->MipFilter != MipChain::Filter::Average)
+							textureNode.append_attribute("mipfilter").set_value(rtObj->MipFilter == MipChain::Filter::Minimum ? "min" : "max");
+					}
 					if (rtObj->ClearColor.r != 0) textureNode.append_attribute("r").set_value(rtObj->ClearColor.r);
 					if (rtObj->ClearColor.g != 0) textureNode.append_attribute("g").set_value(rtObj->ClearColor.g);
 					if (rtObj->ClearColor.b != 0) textureNode.append_attribute("b").set_value(rtObj->ClearColor.b);
@@ -601,12 +891,46 @@ namespace ed
 					textureNode.append_attribute("back").set_value(texmaps[4].c_str());
 				}
 
+				if (isVideo) {
+					VideoObject* vobj = m_objects->GetVideo(texs[i]);
+
+					if (isCapture)
+						textureNode.append_attribute("queue").set_value(vobj->Decoder->GetQueueDepth());
+					else if (!vobj->SyncToTime)
+						textureNode.append_attribute("sync").set_value(false);
+					if (vobj->Paused)
+						textureNode.append_attribute("paused").set_value(true);
+				}
+
+				if (isSequence) {
+					ImageSequence* seq = m_objects->GetImageSequence(texs[i]);
+
+					if (seq->GetFrameRate() != IMAGE_SEQUENCE_FPS)
+						textureNode.append_attribute("fps").set_value(seq->GetFrameRate());
+					if (seq->GetClock() == ImageSequence::Clock::FrameIndex)
+						textureNode.append_attribute("clock").set_value("frameindex");
+					if (!seq->IsLooping())
+						textureNode.append_attribute("loop").set_value(false);
+					if (seq->GetLookAhead() != IMAGE_SEQUENCE_LOOKAHEAD)
+						textureNode.append_attribute("lookahead").set_value(seq->GetLookAhead());
+					if (seq->GetBudget() != IMAGE_SEQUENCE_BUDGET)
+						textureNode.append_attribute("budget").set_value(seq->GetBudget());
+				}
+
+				if (isTexArray) {
+					const std::vector<std::string>& layers = m_objects->GetTextureArrayLayers(texs[i]);
+					for (const std::string& layer : layers)
+						textureNode.append_child("layer").append_attribute("path").set_value(layer.c_str());
+				}
+
 				if (isImage) {
 					ImageObject *iobj = m_objects->GetImage(texs[i]);
 
 					textureNode.append_attribute("width").set_value(iobj->Size.x);
 					textureNode.append_attribute("height").set_value(iobj->Size.y);
 					textureNode.append_attribute("format").set_value(gl::String::Format(iobj->Format));
+					if (iobj->Fill.Op != GPUFill::Operator::None)
+						exportFill(textureNode, iobj->Fill);
 				}
 				if (isImage3D) {
 					Image3DObject* iobj = m_objects->GetImage3D(texs[i]);
@@ -615,6 +939,11 @@ namespace ed
 					textureNode.append_attribute("height").set_value(iobj->Size.y);
 					textureNode.append_attribute("depth").set_value(iobj->Size.z);
 					textureNode.append_attribute("format").set_value(gl::String::Format(iobj->Format));
+
+					for (const std::string& slice : iobj->SlicePaths)
+						textureNode.append_child("slice").append_attribute("path").set_value(slice.c_str());
+					if (iobj->Fill.Op != GPUFill::Operator::None)
+						exportFill(textureNode, iobj->Fill);
 				}
 
 				PluginObject* pluginObj = (PluginObject*)m_objects->GetPluginObject(texs[i]);
@@ -639,12 +968,34 @@ namespace ed
 					textureNode.append_attribute("format").set_value(bobj->ViewFormat);
 					
 					std::string bPath = GetProjectPath("buffers/" + texs[i] + ".buf");
-					if (!ghc::filesystem::exists(GetProjectPath("buffers")))
+					if (writeFiles && !ghc::filesystem::exists(GetProjectPath("buffers")))
 						ghc::filesystem::create_directories(GetProjectPath("buffers"));
 
-					std::ofstream bufWrite(bPath, std::ios::binary);
-					bufWrite.write((char*)bobj->Data, bobj->Size);
-					bufWrite.close();
+					// filled buffers are generated again when the project is opened
+					bool filled = bobj->Fill.Op != GPUFill::Operator::None;
+					if (filled)
+						exportFill(textureNode, bobj->Fill);
+
+					// GPU only buffers without a file were edited in the preview (or are empty)
+					if (writeFiles && !filled && bobj->Data == nullptr && bobj->File.empty())
+						m_objects->FetchBufferData(bobj);
+
+					// GPU only buffers weren't changed on the CPU side - their file just has to be where the project expects it,
+					// recovery snapshots only reference the files that are already there
+					if (filled) {
+						// nothing to write
+					} else if (writeFiles && (bobj->Data != nullptr || bobj->File.empty())) {
+						if (!m_writeFile(bPath, (const char*)bobj->Data, bobj->Data == nullptr ? 0 : bobj->Size))
+							Logger::Get().Log("Failed to write the buffer file " + bPath, true);
+					} else if (writeFiles) {
+						std::error_code ec;
+						if (!ghc::filesystem::equivalent(bobj->File, bPath, ec)) {
+							if (!m_copyFile(bobj->File, bPath))
+								Logger::Get().Log("Failed to copy the buffer file " + bobj->File + " to " + bPath, true);
+							else
+								bobj->File = bPath;
+						}
+					}
 
 					for (int j = 0; j < passItems.size(); j++) {
 						const std::vector<GLuint>& bound = m_objects->GetUniformBindList(passItems[j]);
@@ -706,6 +1057,7 @@ namespace ed
 								pugi::xml_node bindNode = textureNode.append_child("bind");
 								bindNode.append_attribute("slot").set_value(slot);
 								bindNode.append_attribute("name").set_value(passItems[j]->Name);
+								m_exportSampler(bindNode, m_objects->GetSampler(passItems[j], myTex));
 							}
 					}
 				} 
@@ -820,6 +1172,51 @@ namespace ed
 				alphaNode.append_attribute("val").set_value(settings.Project.UseAlphaChannel);
 			}
 
+			// spirv optimizer preset
+			if (settings.Project.SPIRVOptimization != 0) {
+				pugi::xml_node optNode = settingsNode.append_child("entry");
+				optNode.append_attribute("type").set_value("spvopt");
+				optNode.append_attribute("val").set_value(settings.Project.SPIRVOptimization);
+			}
+
+			// audio texture array
+			if (settings.Project.AudioTextureArray) {
+				pugi::xml_node audioNode = settingsNode.append_child("entry");
+				audioNode.append_attribute("type").set_value("audioarray");
+				audioNode.append_attribute("val").set_value(settings.Project.AudioTextureArray);
+			}
+
+			// bindless texture table
+			if (settings.Project.BindlessTextures) {
+				pugi::xml_node bindlessNode = settingsNode.append_child("entry");
+				bindlessNode.append_attribute("type").set_value("bindless");
+				bindlessNode.append_attribute("val").set_value(settings.Project.BindlessTextures);
+			}
+
+			// stereo eyes & preview
+			if (settings.Project.EyeSeparation != 0.064f || settings.Project.StereoConvergence != 10.0f || !settings.Project.StereoPreview.empty()) {
+				pugi::xml_node stereoNode = settingsNode.append_child("entry");
+				stereoNode.append_attribute("type").set_value("stereo");
+				stereoNode.append_attribute("separation").set_value(settings.Project.EyeSeparation);
+				stereoNode.append_attribute("convergence").set_value(settings.Project.StereoConvergence);
+				if (!settings.Project.StereoPreview.empty())
+					stereoNode.append_attribute("preview").set_value(settings.Project.StereoPreview.c_str());
+			}
+
+			// preview & render textures published to other applications
+			for (const TextureSharing::Output* out : TextureSharing::Instance().GetOutputs()) {
+				pugi::xml_node shareNode = settingsNode.append_child("entry");
+				shareNode.append_attribute("type").set_value("share");
+				if (!out->Source.empty())
+					shareNode.append_attribute("source").set_value(out->Source.c_str());
+				if (!out->Name.empty())
+					shareNode.append_attribute("name").set_value(out->Name.c_str());
+				if (out->GPU)
+					shareNode.append_attribute("gpu").set_value(true);
+				if (out->NDI)
+					shareNode.append_attribute("ndi").set_value(true);
+			}
+
 			// include paths
 			if (settings.Project.IncludePaths.size() > 0) {
 				pugi::xml_node pathsNode = settingsNode.append_child("entry");
@@ -863,8 +1260,6 @@ namespace ed
 				pnode.append_attribute("ver").set_value(m_plugins->GetPluginVersion(pname));
 			}
 		}
-
-		doc.save_file(file.c_str());
 	}
 	std::string ProjectParser::LoadFile(const std::string & file)
 	{
@@ -914,23 +1309,266 @@ namespace ed
 			if (mdl.first == file)
 				return mdl.second;
 
+		std::string path = GetProjectPath(file);
+		eng::Model* resident = ResidentAssets::Instance().TakeModel(path, m_modelFlags());
+		if (resident != nullptr) {
+			m_models.push_back(std::make_pair(file, resident));
+			return resident;
+		}
+
+		// the model might have already been imported in the background
+		for (int i = 0; i < m_modelJobs.size(); i++) {
+			if (m_modelJobs[i]->File != file)
+				continue;
+
+			std::shared_ptr<ModelLoadJob> job = m_modelJobs[i];
+			m_modelJobs.erase(m_modelJobs.begin() + i);
+
+			m_waitForJob(job->Done, file);
+
+			if (!job->Loaded) {
+				delete job->Model;
+				return nullptr;
+			}
+
+			job->Model->Upload();
+			ResidentAssets::Instance().Track(path, job->Flags);
+			m_models.push_back(std::make_pair(file, job->Model));
+			return job->Model;
+		}
+
 		m_models.push_back(std::make_pair(file, new eng::Model()));
 
 		// load the model
-		std::string path = GetProjectPath(file);
-		bool loaded = m_models[m_models.size() - 1].second->LoadFromFile(path);
+		bool loaded = m_models[m_models.size() - 1].second->LoadFromFile(path, Settings::Instance().General.OptimizeModels, Settings::Instance().General.ModelCache);
 		if (!loaded) {
+			delete m_models[m_models.size() - 1].second;
 			m_models.erase(m_models.begin() + (m_models.size() - 1));
 			return nullptr;
 		}
 
+		ResidentAssets::Instance().Track(path, m_modelFlags());
 		return m_models[m_models.size() - 1].second;
 	}
+	unsigned int ProjectParser::m_modelFlags()
+	{
+		return Settings::Instance().General.OptimizeModels ? 1 : 0;
+	}
+	void ProjectParser::m_prefetchModels(pugi::xml_node& projectNode)
+	{
+		bool optimize = Settings::Instance().General.OptimizeModels;
+		bool useCache = Settings::Instance().General.ModelCache;
+
+		for (pugi::xml_node passNode : projectNode.child("pipeline").children("pass")) {
+			for (pugi::xml_node itemNode : passNode.child("items").children()) {
+				if (strcmp(itemNode.attribute("type").as_string(), "model") != 0)
+					continue;
+
+				std::string file = itemNode.child("filepath").text().as_string();
+				bool queued = false;
+				for (const auto& job : m_modelJobs)
+					queued |= job->File == file;
+				if (file.empty() || queued)
+					continue;
+
+				// LoadModel() takes it back from the previous project
+				std::string path = GetProjectPath(file);
+				if (ResidentAssets::Instance().HasModel(path, m_modelFlags()))
+					continue;
+
+				std::shared_ptr<ModelLoadJob> job = std::make_shared<ModelLoadJob>();
+				job->File = file;
+				job->Model = new eng::Model();
+				job->Flags = m_modelFlags();
+				job->Done = false;
+				job->Loaded = false;
+				m_modelJobs.push_back(job);
+
+				m_loadTotal++;
+				m_loadPool.Add([this, job, path, optimize, useCache]() {
+					TraceRecorder::Scope zone("Load model", "load");
+					job->Loaded = job->Model->Import(path, optimize, useCache);
+					job->Done = true;
+					m_loadDone++;
+				});
+			}
+		}
+	}
+	void ProjectParser::m_prefetchObjects(pugi::xml_node& projectNode)
+	{
+		for (pugi::xml_node objectNode : projectNode.child("objects").children("object")) {
+			const pugi::char_t* objType = objectNode.attribute("type").as_string();
+
+			// only decode the samples here - sf::SoundBuffer is created on the main thread
+			if (strcmp(objType, "audio") == 0) {
+				std::shared_ptr<AudioLoadJob> job = std::make_shared<AudioLoadJob>();
+				job->File = toGenericPath(objectNode.attribute("path").as_string());
+				job->Channels = job->SampleRate = 0;
+				job->Done = false;
+				job->Loaded = false;
+				m_audioJobs.push_back(job);
+
+				std::string path = GetProjectPath(job->File);
+				m_loadTotal++;
+				m_loadPool.Add([this, job, path]() {
+					TraceRecorder::Scope zone("Decode audio", "load");
+					// long tracks aren't decoded, ObjectManager streams them
+					sf::InputSoundFile file;
+					if (file.openFromFile(path) && !AudioTrack::ShouldStream(file)) {
+						job->Samples.resize(file.getSampleCount());
+						job->Channels = file.getChannelCount();
+						job->SampleRate = file.getSampleRate();
+						job->Loaded = file.read(job->Samples.data(), job->Samples.size()) == job->Samples.size();
+					}
+					job->Done = true;
+					m_loadDone++;
+				});
+			}
+			else if (strcmp(objType, "buffer") == 0 && !objectNode.child("fill")) {
+				std::shared_ptr<BufferLoadJob> job = std::make_shared<BufferLoadJob>();
+				job->Name = objectNode.attribute("name").as_string();
+				job->Path = GetProjectPath("buffers/" + job->Name + ".buf");
+				job->Done = false;
+				job->Loaded = false;
+				m_bufferJobs.push_back(job);
+
+				// the pages are read here, the upload only copies them
+				size_t size = objectNode.attribute("size").as_uint();
+				m_loadTotal++;
+				m_loadPool.Add([this, job, size]() {
+					TraceRecorder::Scope zone("Read buffer", "load");
+					job->Loaded = job->Mapping.Open(job->Path);
+					if (job->Loaded)
+						job->Mapping.Prefetch(0, size);
+					job->Done = true;
+					m_loadDone++;
+				});
+			}
+		}
+	}
+	bool ProjectParser::m_takeAudio(const std::string& file, std::vector<sf::Int16>& samples, unsigned int& channels, unsigned int& sampleRate)
+	{
+		for (int i = 0; i < m_audioJobs.size(); i++) {
+			if (m_audioJobs[i]->File != file)
+				continue;
+
+			std::shared_ptr<AudioLoadJob> job = m_audioJobs[i];
+			m_audioJobs.erase(m_audioJobs.begin() + i);
+
+			m_waitForJob(job->Done, file);
+			if (!job->Loaded)
+				return false;
+
+			samples = std::move(job->Samples);
+			channels = job->Channels;
+			sampleRate = job->SampleRate;
+			return true;
+		}
+
+		return false;
+	}
+	bool ProjectParser::m_takeBuffer(const std::string& name, BufferObject* buf)
+	{
+		for (int i = 0; i < m_bufferJobs.size(); i++) {
+			if (m_bufferJobs[i]->Name != name)
+				continue;
+
+			std::shared_ptr<BufferLoadJob> job = m_bufferJobs[i];
+			m_bufferJobs.erase(m_bufferJobs.begin() + i);
+
+			m_waitForJob(job->Done, name);
+			if (!job->Loaded)
+				return false;
+
+			m_objects->UploadBuffer(buf, job->Mapping, job->Path);
+			return true;
+		}
+
+		return false;
+	}
+	void ProjectParser::m_waitForJob(const std::atomic<bool>& done, const std::string& name)
+	{
+		if (done)
+			return;
+
+		Logger::Get().Log("Waiting for " + name + " (" + std::to_string(m_loadDone) + "/" + std::to_string(m_loadTotal) + " resources loaded)");
+		while (!done)
+			std::this_thread::yield();
+	}
+	void ProjectParser::m_finishLoadJobs()
+	{
+		// resources that no item ended up using
+		for (auto& job : m_modelJobs) {
+			m_waitForJob(job->Done, job->File);
+			delete job->Model;
+		}
+		for (auto& job : m_audioJobs)
+			m_waitForJob(job->Done, job->File);
+		for (auto& job : m_bufferJobs)
+			m_waitForJob(job->Done, job->Name);
+
+		m_modelJobs.clear();
+		m_audioJobs.clear();
+		m_bufferJobs.clear();
+	}
 	void ProjectParser::SaveProjectFile(const std::string & file, const std::string & data)
 	{
-		std::ofstream out(GetProjectPath(file));
-		out << data;
+		std::string path = GetProjectPath(file);
+		if (!m_writeFile(path, data.c_str(), data.size()))
+			Logger::Get().Log("Failed to save " + path, true);
+	}
+	bool ProjectParser::m_writeFile(const std::string& path, const char* data, size_t size)
+	{
+		uint64_t hash = HashData(data, size);
+		std::error_code ec;
+
+		// the file could have been changed by someone else since it was written
+		auto saved = m_savedFiles.find(path);
+		if (saved != m_savedFiles.end() && saved->second.Hash == hash && ghc::filesystem::exists(path, ec)) {
+			uintmax_t curSize = ghc::filesystem::file_size(path, ec);
+			ghc::filesystem::file_time_type curTime = ghc::filesystem::last_write_time(path, ec);
+			if (!ec && curSize == saved->second.Size && curTime == saved->second.Time)
+				return true;
+		}
+
+		std::string temp = path + ".tmp";
+		std::ofstream out(temp, std::ios::binary);
+		if (!out.is_open())
+			return false;
+		if (size > 0)
+			out.write(data, size);
 		out.close();
+		if (out.fail()) {
+			ghc::filesystem::remove(temp, ec);
+			return false;
+		}
+
+		if (!eng::ReplaceFileWith(path, temp)) {
+			ghc::filesystem::remove(temp, ec);
+			return false;
+		}
+
+		SavedFile& entry = m_savedFiles[path];
+		entry.Hash = hash;
+		entry.Size = ghc::filesystem::file_size(path, ec);
+		entry.Time = ghc::filesystem::last_write_time(path, ec);
+		if (ec)
+			m_savedFiles.erase(path);
+
+		return true;
+	}
+	bool ProjectParser::m_copyFile(const std::string& from, const std::string& to)
+	{
+		// m_writeFile only skips the copy if the destination is still what the last save wrote for the same content
+		std::ifstream in(from, std::ios::binary);
+		if (!in.is_open())
+			return false;
+
+		std::string data((std::istreambuf_iterator<char>(in)), (std::istreambuf_iterator<char>()));
+		if (in.bad())
+			return false;
+
+		return m_writeFile(to, data.data(), data.size());
 	}
 	std::string ProjectParser::GetRelativePath(const std::string& to)
 	{
@@ -964,6 +1602,7 @@ namespace ed
 	void ProjectParser::ResetProjectDirectory()
 	{
 		m_file = "";
+		m_archive = "";
 		m_projectPath = ghc::filesystem::current_path().native();
 	}
 
@@ -1052,6 +1691,8 @@ namespace ed
 				bool isLastFrame = var->Flags & (char)ShaderVariable::Flag::LastFrame;
 				if (isInvert) varNode.append_attribute("invert").set_value(isInvert);
 				if (isLastFrame) varNode.append_attribute("lastframe").set_value(isLastFrame);
+				bool isConstant = var->Flags & (char)ShaderVariable::Flag::Constant;
+				if (isConstant) varNode.append_attribute("constant").set_value(isConstant);
 
 				if (var->System != SystemShaderVariable::None) {
 					varNode.append_attribute("system").set_value(SYSTEM_VARIABLE_NAMES[(int)var->System]);
@@ -1112,6 +1753,56 @@ namespace ed
 		return GL_BACK;
 	}
 
+	void ProjectParser::m_exportSampler(pugi::xml_node& node, const SamplerState* state)
+	{
+		if (state == nullptr)
+			return;
+
+		auto filterName = [](GLenum val) -> const char* {
+			for (int k = 0; k < HARRAYSIZE(FILTER_VALUES); k++)
+				if (FILTER_VALUES[k] == val)
+					return FILTER_NAMES[k];
+			return FILTER_NAMES[1];
+		};
+		auto wrapName = [](GLenum val) -> const char* {
+			for (int k = 0; k < HARRAYSIZE(WRAP_VALUES); k++)
+				if (WRAP_VALUES[k] == val)
+					return WRAP_NAMES[k];
+			return WRAP_NAMES[0];
+		};
+
+		node.append_attribute("min_filter").set_value(filterName(state->MinFilter));
+		node.append_attribute("mag_filter").set_value(filterName(state->MagFilter));
+		node.append_attribute("wrap_s").set_value(wrapName(state->WrapS));
+		node.append_attribute("wrap_t").set_value(wrapName(state->WrapT));
+		node.append_attribute("wrap_r").set_value(wrapName(state->WrapR));
+	}
+	bool ProjectParser::m_parseSampler(const pugi::xml_node& node, SamplerState& state)
+	{
+		if (node.attribute("min_filter").empty())
+			return false;
+
+		auto toFilter = [](const char* str, GLenum def) -> GLenum {
+			for (int k = 0; k < HARRAYSIZE(FILTER_NAMES); k++)
+				if (strcmp(str, FILTER_NAMES[k]) == 0)
+					return FILTER_VALUES[k];
+			return def;
+		};
+		auto toWrap = [](const char* str, GLenum def) -> GLenum {
+			for (int k = 0; k < HARRAYSIZE(WRAP_NAMES); k++)
+				if (strcmp(str, WRAP_NAMES[k]) == 0)
+					return WRAP_VALUES[k];
+			return def;
+		};
+
+		state.MinFilter = toFilter(node.attribute("min_filter").as_string(), state.MinFilter);
+		state.MagFilter = toFilter(node.attribute("mag_filter").as_string(), state.MagFilter);
+		state.WrapS = toWrap(node.attribute("wrap_s").as_string(), state.WrapS);
+		state.WrapT = toWrap(node.attribute("wrap_t").as_string(), state.WrapT);
+		state.WrapR = toWrap(node.attribute("wrap_r").as_string(), state.WrapR);
+
+		return true;
+	}
 	void ProjectParser::m_exportItems(pugi::xml_node& node, std::vector<PipelineItem*>& items, const std::string& oldProjectPath)
 	{
 		for (PipelineItem* item : items)
@@ -1129,6 +1820,17 @@ namespace ed
 				itemNode.append_child("width").text().set(tData->Size.x);
 				itemNode.append_child("height").text().set(tData->Size.y);
 				itemNode.append_child("depth").text().set(tData->Size.z);
+				if (tData->Type == pipe::GeometryItem::Generated) {
+					itemNode.append_child("shape").text().set(GeometryGenerator::GetShapeName((GeometryGenerator::Shape)tData->GenShape));
+					itemNode.append_child("resolutionX").text().set(tData->GenResolution.x);
+					itemNode.append_child("resolutionY").text().set(tData->GenResolution.y);
+					itemNode.append_child("amplitude").text().set(tData->GenAmplitude);
+					itemNode.append_child("frequency").text().set(tData->GenFrequency);
+					if (tData->GenSeed != 0)
+						itemNode.append_child("seed").text().set(tData->GenSeed);
+					if (tData->GenAnimated)
+						itemNode.append_child("animated").text().set(tData->GenAnimated);
+				}
 				if (tData->Scale.x != 1.0f)
 					itemNode.append_child("scaleX").text().set(tData->Scale.x);
 				if (tData->Scale.y != 1.0f)
@@ -1153,6 +1855,14 @@ namespace ed
 					itemNode.append_child("instancecount").text().set(tData->InstanceCount);
 				if (tData->InstanceBuffer != nullptr)
 					itemNode.append_child("instancebuffer").text().set(m_objects->GetBufferNameByID(((BufferObject*)tData->InstanceBuffer)->ID).c_str());
+				if (tData->Type == pipe::GeometryItem::Captured && tData->VertexBuffer != nullptr)
+					itemNode.append_child("vertexbuffer").text().set(m_objects->GetBufferNameByID(((BufferObject*)tData->VertexBuffer)->ID).c_str());
+				if (tData->OcclusionCulling)
+					itemNode.append_child("occlusion").text().set(tData->OcclusionCulling);
+				if (!tData->FrustumCulling)
+					itemNode.append_child("frustumculling").text().set(tData->FrustumCulling);
+				if (tData->GPUCulling)
+					itemNode.append_child("gpuculling").text().set(tData->GPUCulling);
 				for (int tind = 0; tind < HARRAYSIZE(TOPOLOGY_ITEM_VALUES); tind++)
 				{
 					if (TOPOLOGY_ITEM_VALUES[tind] == tData->Topology)
@@ -1256,6 +1966,16 @@ namespace ed
 					itemNode.append_child("instancecount").text().set(data->InstanceCount);
 				if (data->InstanceBuffer != nullptr)
 					itemNode.append_child("instancebuffer").text().set(m_objects->GetBufferNameByID(((BufferObject*)data->InstanceBuffer)->ID).c_str());
+				if (data->LOD != 0)
+					itemNode.append_child("lod").text().set(data->LOD);
+				if (!data->FrustumCulling)
+					itemNode.append_child("frustumculling").text().set(data->FrustumCulling);
+				if (data->GPUCulling)
+					itemNode.append_child("gpuculling").text().set(data->GPUCulling);
+				if (data->Animation[0] != 0)
+					itemNode.append_child("animation").text().set(data->Animation);
+				if (data->AnimationSpeed != 1.0f)
+					itemNode.append_child("animationspeed").text().set(data->AnimationSpeed);
 			}
 			else if (item->Type == PipelineItem::ItemType::PluginItem) {
 				pipe::PluginItemData* plData = (pipe::PluginItemData*)item->Data;
@@ -1276,7 +1996,8 @@ namespace ed
 	}
 	void ProjectParser::m_importItems(const char* name, pipe::ShaderPass* data, const pugi::xml_node& node, const std::vector<InputLayoutItem>& inpLayout,
 		std::map<pipe::GeometryItem*, std::pair<std::string, pipe::ShaderPass*>>& geoUBOs,
-		std::map<pipe::Model*, std::pair<std::string, pipe::ShaderPass*>>& modelUBOs)
+		std::map<pipe::Model*, std::pair<std::string, pipe::ShaderPass*>>& modelUBOs,
+		std::map<pipe::GeometryItem*, std::pair<std::string, pipe::ShaderPass*>>& geoVBOs)
 	{
 		for (pugi::xml_node itemNode : node.children()) {
 			char itemName[PIPELINE_ITEM_NAME_LENGTH];
@@ -1297,6 +2018,7 @@ namespace ed
 				tData->Instanced = false;
 				tData->InstanceCount = 0;
 				tData->InstanceBuffer = nullptr;
+				tData->OcclusionCulling = false;
 
 				for (pugi::xml_node attrNode : itemNode.children()) {
 					if (strcmp(attrNode.name(), "width") == 0)
@@ -1329,6 +2051,28 @@ namespace ed
 						tData->InstanceCount = attrNode.text().as_int();
 					else if (strcmp(attrNode.name(), "instancebuffer") == 0)
 						geoUBOs[tData] = std::make_pair(attrNode.text().as_string(), data);
+					else if (strcmp(attrNode.name(), "vertexbuffer") == 0)
+						geoVBOs[tData] = std::make_pair(attrNode.text().as_string(), data);
+					else if (strcmp(attrNode.name(), "occlusion") == 0)
+						tData->OcclusionCulling = attrNode.text().as_bool();
+					else if (strcmp(attrNode.name(), "frustumculling") == 0)
+						tData->FrustumCulling = attrNode.text().as_bool();
+					else if (strcmp(attrNode.name(), "gpuculling") == 0)
+						tData->GPUCulling = attrNode.text().as_bool();
+					else if (strcmp(attrNode.name(), "shape") == 0)
+						tData->GenShape = (int)GeometryGenerator::GetShape(attrNode.text().as_string());
+					else if (strcmp(attrNode.name(), "resolutionX") == 0)
+						tData->GenResolution.x = std::max(attrNode.text().as_int(), 1);
+					else if (strcmp(attrNode.name(), "resolutionY") == 0)
+						tData->GenResolution.y = std::max(attrNode.text().as_int(), 1);
+					else if (strcmp(attrNode.name(), "amplitude") == 0)
+						tData->GenAmplitude = attrNode.text().as_float();
+					else if (strcmp(attrNode.name(), "frequency") == 0)
+						tData->GenFrequency = attrNode.text().as_float();
+					else if (strcmp(attrNode.name(), "seed") == 0)
+						tData->GenSeed = attrNode.text().as_uint();
+					else if (strcmp(attrNode.name(), "animated") == 0)
+						tData->GenAnimated = attrNode.text().as_bool();
 					else if (strcmp(attrNode.name(), "topology") == 0) {
 						for (int k = 0; k < HARRAYSIZE(TOPOLOGY_ITEM_NAMES); k++)
 							if (strcmp(attrNode.text().as_string(), TOPOLOGY_ITEM_NAMES[k]) == 0)
@@ -1434,6 +2178,11 @@ namespace ed
 				mdata->InstanceBuffer = nullptr;
 				mdata->Instanced = false;
 				mdata->InstanceCount = 0;
+				mdata->LOD = 0;
+				mdata->FrustumCulling = true;
+				mdata->GPUCulling = false;
+				mdata->Animation[0] = 0;
+				mdata->AnimationSpeed = 1.0f;
 
 				modelUBOs[mdata] = std::make_pair("", data);
 
@@ -1468,6 +2217,18 @@ namespace ed
 						mdata->InstanceCount = attrNode.text().as_int();
 					else if (strcmp(attrNode.name(), "instancebuffer") == 0)
 						modelUBOs[mdata] = std::make_pair(attrNode.text().as_string(), data);
+					else if (strcmp(attrNode.name(), "lod") == 0)
+						mdata->LOD = attrNode.text().as_int();
+					else if (strcmp(attrNode.name(), "frustumculling") == 0)
+						mdata->FrustumCulling = attrNode.text().as_bool();
+					else if (strcmp(attrNode.name(), "gpuculling") == 0)
+						mdata->GPUCulling = attrNode.text().as_bool();
+					else if (strcmp(attrNode.name(), "animation") == 0) {
+						strncpy(mdata->Animation, attrNode.text().as_string(), MODEL_GROUP_NAME_LENGTH - 1);
+						mdata->Animation[MODEL_GROUP_NAME_LENGTH - 1] = 0;
+					}
+					else if (strcmp(attrNode.name(), "animationspeed") == 0)
+						mdata->AnimationSpeed = attrNode.text().as_float();
 				}
 
 				if (strlen(mdata->Filename) > 0)
@@ -1490,20 +2251,7 @@ namespace ed
 			// create and modify if needed
 			if (itemType == ed::PipelineItem::ItemType::Geometry) {
 				ed::pipe::GeometryItem* tData = reinterpret_cast<ed::pipe::GeometryItem*>(itemData);
-				if (tData->Type == pipe::GeometryItem::Cube)
-					tData->VAO = eng::GeometryFactory::CreateCube(tData->VBO, tData->Size.x, tData->Size.y, tData->Size.z, inpLayout);
-				else if (tData->Type == pipe::GeometryItem::Circle)
-					tData->VAO = eng::GeometryFactory::CreateCircle(tData->VBO, tData->Size.x, tData->Size.y, inpLayout);
-				else if (tData->Type == pipe::GeometryItem::Plane)
-					tData->VAO = eng::GeometryFactory::CreatePlane(tData->VBO, tData->Size.x, tData->Size.y, inpLayout);
-				else if (tData->Type == pipe::GeometryItem::Rectangle)
-					tData->VAO = eng::GeometryFactory::CreatePlane(tData->VBO, 1, 1, inpLayout);
-				else if (tData->Type == pipe::GeometryItem::Sphere)
-					tData->VAO = eng::GeometryFactory::CreateSphere(tData->VBO, tData->Size.x, inpLayout);
-				else if (tData->Type == pipe::GeometryItem::Triangle)
-					tData->VAO = eng::GeometryFactory::CreateTriangle(tData->VBO, tData->Size.x, inpLayout);
-				else if (tData->Type == pipe::GeometryItem::ScreenQuadNDC)
-					tData->VAO = eng::GeometryFactory::CreateScreenQuadNDC(tData->VBO, inpLayout);
+				GeometryCache::Instance().Create(tData, inpLayout);
 			}
 			else if (itemType == ed::PipelineItem::ItemType::Model) {
 				pipe::Model* tData = reinterpret_cast<pipe::Model*>(itemData);
@@ -1555,7 +2303,7 @@ namespace ed
 			// check if it should be collapsed
 			if (!passNode.attribute("collapsed").empty()) {
 				bool cs = passNode.attribute("collapsed").as_bool();
-				if (cs)
+				if (cs && m_ui != nullptr)
 					((PipelineUI*)m_ui->Get(ViewID::Pipeline))->Collapse(data);
 			}
 
@@ -1802,6 +2550,11 @@ namespace ed
 					mdata->InstanceBuffer = nullptr;
 					mdata->InstanceCount = 0;
 					mdata->Instanced = false;
+					mdata->LOD = 0;
+					mdata->FrustumCulling = true;
+					mdata->GPUCulling = false;
+					mdata->Animation[0] = 0;
+					mdata->AnimationSpeed = 1.0f;
 
 					for (pugi::xml_node attrNode : itemNode.children()) {
 						if (strcmp(attrNode.name(), "filepath") == 0)
@@ -1838,20 +2591,7 @@ namespace ed
 				if (itemType == ed::PipelineItem::ItemType::Geometry) {
 					ed::pipe::GeometryItem* tData = reinterpret_cast<ed::pipe::GeometryItem*>(itemData);
 					
-					if (tData->Type == pipe::GeometryItem::Cube)
-						tData->VAO = eng::GeometryFactory::CreateCube(tData->VBO, tData->Size.x, tData->Size.y, tData->Size.z, data->InputLayout);
-					else if (tData->Type == pipe::GeometryItem::Circle)
-						tData->VAO = eng::GeometryFactory::CreateCircle(tData->VBO, tData->Size.x, tData->Size.y, data->InputLayout);
-					else if (tData->Type == pipe::GeometryItem::Plane)
-						tData->VAO = eng::GeometryFactory::CreatePlane(tData->VBO, tData->Size.x, tData->Size.y, data->InputLayout);
-					else if (tData->Type == pipe::GeometryItem::Rectangle)
-						tData->VAO = eng::GeometryFactory::CreatePlane(tData->VBO, 1, 1, data->InputLayout);
-					else if (tData->Type == pipe::GeometryItem::Sphere)
-						tData->VAO = eng::GeometryFactory::CreateSphere(tData->VBO, tData->Size.x, data->InputLayout);
-					else if (tData->Type == pipe::GeometryItem::Triangle)
-						tData->VAO = eng::GeometryFactory::CreateTriangle(tData->VBO, tData->Size.x, data->InputLayout);
-					else if (tData->Type == pipe::GeometryItem::ScreenQuadNDC)
-						tData->VAO = eng::GeometryFactory::CreateScreenQuadNDC(tData->VBO, data->InputLayout);
+					GeometryCache::Instance().Create(tData, data->InputLayout);
 				}
 				else if (itemType == ed::PipelineItem::ItemType::Model) {
 					pipe::Model* tData = reinterpret_cast<pipe::Model*>(itemData);
@@ -1928,8 +2668,11 @@ namespace ed
 
 				if (isCube)
 					m_objects->CreateCubemap(name, cubeLeft, cubeTop, cubeFront, cubeBottom, cubeRight, cubeBack);
-				else
+				else {
 					m_objects->CreateTexture(name);
+					if (objectNode.attribute("mipmaps").as_bool())
+						m_objects->SetTextureMipmaps(name, true);
+				}
 
 				for (pugi::xml_node bindNode : objectNode.children("bind")) {
 					const pugi::char_t* passBindName = bindNode.attribute("name").as_string();
@@ -2004,7 +2747,16 @@ namespace ed
 				pugi::char_t objPath[MAX_PATH];
 				strcpy(objPath, toGenericPath(objectNode.attribute("path").as_string()).c_str());
 
-				m_objects->CreateAudio(std::string(objPath));
+				std::vector<sf::Int16> samples;
+				unsigned int channels = 0, sampleRate = 0;
+				if (m_takeAudio(objPath, samples, channels, sampleRate))
+					m_objects->CreateAudio(std::string(objPath), samples.data(), samples.size(), channels, sampleRate);
+				else
+					m_objects->CreateAudio(std::string(objPath));
+
+				// 0 = samples, envelope values per second otherwise
+				if (!objectNode.attribute("wholetrack").empty())
+					m_objects->SetAudioTrack(std::string(objPath), objectNode.attribute("wholetrack").as_int());
 
 				for (pugi::xml_node bindNode : objectNode.children("bind")) {
 					const pugi::char_t* passBindName = bindNode.attribute("name").as_string();
@@ -2033,14 +2785,14 @@ namespace ed
 		for (pugi::xml_node settingItem : projectNode.child("settings").children("entry")) {
 			if (!settingItem.attribute("type").empty()) {
 				std::string type = settingItem.attribute("type").as_string();
-				if (type == "property") {
+				if (type == "property" && m_ui != nullptr) {
 					PropertyUI* props = ((PropertyUI*)m_ui->Get(ViewID::Properties));
 					if (!settingItem.attribute("name").empty()) {
 						PipelineItem* item = m_pipe->Get(settingItem.attribute("name").as_string());
 						props->Open(item);
 					}
 				}
-				else if (type == "file" && Settings::Instance().General.ReopenShaders) {
+				else if (type == "file" && Settings::Instance().General.ReopenShaders && m_ui != nullptr) {
 					CodeEditorUI* editor = ((CodeEditorUI*)m_ui->Get(ViewID::Code));
 					if (!settingItem.attribute("name").empty()) {
 						PipelineItem* item = m_pipe->Get(settingItem.attribute("name").as_string());
@@ -2062,7 +2814,7 @@ namespace ed
 							editor->OpenGS(item);
 					}
 				}
-				else if (type == "pinned") {
+				else if (type == "pinned" && m_ui != nullptr) {
 					PinnedUI* pinned = ((PinnedUI*)m_ui->Get(ViewID::Pinned));
 					if (!settingItem.attribute("name").empty()) {
 						const pugi::char_t* item = settingItem.attribute("name").as_string();
@@ -2138,6 +2890,13 @@ namespace ed
 		std::map<pipe::ShaderPass*, std::vector<std::string>> fbos;
 		std::map<pipe::GeometryItem*, std::pair<std::string, pipe::ShaderPass*>> geoUBOs; // buffers that are bound to pipeline items
 		std::map<pipe::Model*, std::pair<std::string, pipe::ShaderPass*>> modelUBOs;
+		std::map<pipe::GeometryItem*, std::pair<std::string, pipe::ShaderPass*>> geoVBOs; // buffers that the captured geometry draws
+		std::map<pipe::ShaderPass*, std::string> captureBuffers; // buffers that the passes capture their vertices to
+		std::map<pipe::ComputePass*, std::string> indirectBuffers; // buffers that hold the compute dispatch size
+		std::map<pipe::ShaderPass*, std::string> meshTaskBuffers; // buffers that hold the mesh shader launches
+		std::map<pipe::ShaderPass*, std::string> passConditions; // buffers that decide if the passes run
+		std::map<pipe::ComputePass*, std::string> computeConditions;
+		std::vector<std::pair<std::string, GPUFill::Operation>> fills; // objects that are generated on the GPU
 
 		// shader passes
 		for (pugi::xml_node passNode : projectNode.child("pipeline").children("pass")) {
@@ -2167,11 +2926,32 @@ namespace ed
 				data->Active = true;
 				if (!passNode.attribute("active").empty())
 					data->Active = passNode.attribute("active").as_bool();
+				if (!passNode.attribute("msaa").empty())
+					data->Multisample = passNode.attribute("msaa").as_bool();
+				if (!passNode.attribute("accumulate").empty())
+					data->Accumulate = passNode.attribute("accumulate").as_bool();
+				if (!passNode.attribute("samples").empty())
+					data->AccumulateSamples = std::max(0, passNode.attribute("samples").as_int());
+				if (!passNode.attribute("resolution").empty()) {
+					int scale = passNode.attribute("resolution").as_int();
+					data->ResolutionScale = scale >= 4 ? 4 : (scale >= 2 ? 2 : 1);
+				}
+				if (!passNode.attribute("edgeaware").empty())
+					data->EdgeAwareUpsample = passNode.attribute("edgeaware").as_bool();
+				if (!passNode.attribute("depthprepass").empty())
+					data->DepthPrepass = passNode.attribute("depthprepass").as_bool();
+				data->Multiview = passNode.attribute("multiview").as_bool(false);
+				if (!passNode.attribute("shadingrate").empty()) {
+					for (int i = 0; i < HARRAYSIZE(SHADING_RATE_NAMES); i++)
+						if (strcmp(passNode.attribute("shadingrate").as_string(), SHADING_RATE_NAMES[i]) == 0)
+							data->ShadingRate = i;
+				}
+				data->ShadingRateImage = passNode.attribute("shadingrateimage").as_string();
 
 				// check if it should be collapsed
 				if (!passNode.attribute("collapsed").empty()) {
 					bool cs = passNode.attribute("collapsed").as_bool();
-					if (cs)
+					if (cs && m_ui != nullptr)
 						((PipelineUI*)m_ui->Get(ViewID::Pipeline))->Collapse(data);
 				}
 
@@ -2212,12 +2992,44 @@ namespace ed
 						strcpy(data->GSPath, shaderPath);
 						strcpy(data->GSEntry, shaderEntry);
 					}
+					else if (shaderNodeType == "ms") {
+						data->MSUsed = shaderNode.attribute("used").as_bool(false);
+						data->MeshletsPerTask = std::max(shaderNode.attribute("meshletspertask").as_uint(1), 1u);
+						strcpy(data->MSPath, shaderPath);
+						strcpy(data->MSEntry, shaderEntry);
+					}
+					else if (shaderNodeType == "ts") {
+						data->TSUsed = shaderNode.attribute("used").as_bool(false);
+						strcpy(data->TSPath, shaderPath);
+						strcpy(data->TSEntry, shaderEntry);
+					}
 
-					std::string type = ((shaderNodeType == "vs") ? "vertex" : ((shaderNodeType == "ps") ? "pixel" : "geometry"));
+					std::string type = ((shaderNodeType == "vs") ? "vertex" : ((shaderNodeType == "ps") ? "pixel" : ((shaderNodeType == "ms") ? "mesh" : ((shaderNodeType == "ts") ? "task" : "geometry"))));
 					if (!FileExists(shaderPath))
 						m_msgs->Add(ed::MessageStack::Type::Error, name, type + " shader does not exist.");
 				}
 
+				// get the mesh shader launch buffer - resolved once the objects are loaded
+				pugi::xml_node meshTaskNode = passNode.child("indirect");
+				if (!meshTaskNode.attribute("buffer").empty()) {
+					meshTaskBuffers[data] = meshTaskNode.attribute("buffer").as_string();
+					data->MeshTaskOffset = meshTaskNode.attribute("offset").as_uint();
+				}
+
+				// get the condition buffer - resolved once the objects are loaded
+				pugi::xml_node conditionNode = passNode.child("condition");
+				if (!conditionNode.attribute("buffer").empty()) {
+					passConditions[data] = conditionNode.attribute("buffer").as_string();
+					data->ConditionOffset = conditionNode.attribute("offset").as_uint() & ~3u;
+				}
+
+				// get the capture buffer - resolved once the objects are loaded
+				pugi::xml_node captureNode = passNode.child("capture");
+				if (!captureNode.attribute("buffer").empty()) {
+					captureBuffers[data] = captureNode.attribute("buffer").as_string();
+					strncpy(data->CaptureOutputs, captureNode.attribute("outputs").as_string(), sizeof(data->CaptureOutputs) - 1);
+				}
+
 				// parse variables
 				for (pugi::xml_node variableNode : passNode.child("variables").children("variable")) {
 					ShaderVariable::ValueType type = ShaderVariable::ValueType::Float1;
@@ -2229,15 +3041,18 @@ namespace ed
 					char flags = 0;
 
 					/* FLAGS */
-					bool isInvert = false, isLastFrame = false;
+					bool isInvert = false, isLastFrame = false, isConstant = false;
 
 					if (!variableNode.attribute("invert").empty())
 						isInvert = variableNode.attribute("invert").as_bool();
 					if (!variableNode.attribute("lastframe").empty())
 						isLastFrame = variableNode.attribute("lastframe").as_bool();
+					if (!variableNode.attribute("constant").empty())
+						isConstant = variableNode.attribute("constant").as_bool();
 
 					flags = (isInvert * (char)ShaderVariable::Flag::Inverse) |
-							(isLastFrame * (char)ShaderVariable::Flag::LastFrame);
+							(isLastFrame * (char)ShaderVariable::Flag::LastFrame) |
+							(isConstant * (char)ShaderVariable::Flag::Constant);
 							
 					/* TYPE */
 					if (!variableNode.attribute("type").empty()) {
@@ -2330,7 +3145,7 @@ namespace ed
 				}
 
 				// parse items
-				m_importItems(name, data, passNode.child("items"), data->InputLayout, geoUBOs, modelUBOs);
+				m_importItems(name, data, passNode.child("items"), data->InputLayout, geoUBOs, modelUBOs, geoVBOs);
 
 				// parse item values
 				for (pugi::xml_node itemValueNode : passNode.child("itemvalues").children("value")) {
@@ -2390,15 +3205,18 @@ namespace ed
 					char flags = 0;
 
 					/* FLAGS */
-					bool isInvert = false, isLastFrame = false;
+					bool isInvert = false, isLastFrame = false, isConstant = false;
 
 					if (!variableNode.attribute("invert").empty())
 						isInvert = variableNode.attribute("invert").as_bool();
 					if (!variableNode.attribute("lastframe").empty())
 						isLastFrame = variableNode.attribute("lastframe").as_bool();
+					if (!variableNode.attribute("constant").empty())
+						isConstant = variableNode.attribute("constant").as_bool();
 
 					flags = (isInvert * (char)ShaderVariable::Flag::Inverse) |
-							(isLastFrame * (char)ShaderVariable::Flag::LastFrame);
+							(isLastFrame * (char)ShaderVariable::Flag::LastFrame) |
+							(isConstant * (char)ShaderVariable::Flag::Constant);
 
 					/* TYPE */
 					if (!variableNode.attribute("type").empty())
@@ -2470,6 +3288,48 @@ namespace ed
 				if (!workNode.attribute("z").empty()) data->WorkZ = workNode.attribute("z").as_uint();
 				else data->WorkZ = 1;
 
+				// get iteration count
+				pugi::xml_node iterNode = passNode.child("iterations");
+				data->Iterations = iterNode.attribute("count").as_uint(1);
+				if (data->Iterations == 0) data->Iterations = 1;
+				data->PingPong = iterNode.attribute("pingpong").as_bool(false);
+				data->TickRate = std::max<float>(iterNode.attribute("tickrate").as_float(0.0f), 0.0f);
+
+				// get indirect dispatch buffer - resolved once the objects are loaded
+				pugi::xml_node indirectNode = passNode.child("indirect");
+				if (!indirectNode.attribute("buffer").empty()) {
+					indirectBuffers[data] = indirectNode.attribute("buffer").as_string();
+					data->IndirectOffset = indirectNode.attribute("offset").as_uint();
+				}
+
+				// get the condition buffer - resolved once the objects are loaded
+				pugi::xml_node conditionNode = passNode.child("condition");
+				if (!conditionNode.attribute("buffer").empty()) {
+					computeConditions[data] = conditionNode.attribute("buffer").as_string();
+					data->ConditionOffset = conditionNode.attribute("offset").as_uint() & ~3u;
+				}
+
+				// get memory barrier - older projects don't have it and use auto barriers
+				pugi::xml_node barrierNode = passNode.child("barrier");
+				data->AutoBarrier = barrierNode.attribute("auto").as_bool(true);
+				if (!data->AutoBarrier) {
+					data->Barrier = 0;
+					std::string bits = barrierNode.attribute("bits").as_string();
+					size_t start = 0;
+					while (start <= bits.size()) {
+						size_t end = bits.find('|', start);
+						if (end == std::string::npos)
+							end = bits.size();
+
+						std::string bit = bits.substr(start, end - start);
+						for (int k = 0; k < HARRAYSIZE(BARRIER_NAMES); k++)
+							if (bit == BARRIER_NAMES[k])
+								data->Barrier |= BARRIER_VALUES[k];
+
+						start = end + 1;
+					}
+				}
+
 				// add the item
 				m_pipe->AddComputePass(name, data);
 			} 
@@ -2498,15 +3358,18 @@ namespace ed
 					char flags = 0;
 
 					/* FLAGS */
-					bool isInvert = false, isLastFrame = false;
+					bool isInvert = false, isLastFrame = false, isConstant = false;
 
 					if (!variableNode.attribute("invert").empty())
 						isInvert = variableNode.attribute("invert").as_bool();
 					if (!variableNode.attribute("lastframe").empty())
 						isLastFrame = variableNode.attribute("lastframe").as_bool();
+					if (!variableNode.attribute("constant").empty())
+						isConstant = variableNode.attribute("constant").as_bool();
 
 					flags = (isInvert * (char)ShaderVariable::Flag::Inverse) |
-							(isLastFrame * (char)ShaderVariable::Flag::LastFrame);
+							(isLastFrame * (char)ShaderVariable::Flag::LastFrame) |
+							(isConstant * (char)ShaderVariable::Flag::Constant);
 
 					/* TYPE */
 					if (!variableNode.attribute("type").empty())
@@ -2581,7 +3444,7 @@ namespace ed
 				// add the item
 				m_pipe->AddPluginItem(nullptr, name, otype.c_str(), pluginData, plugin);
 
-				m_importItems(name, nullptr, passNode.child("items"), m_plugins->BuildInputLayout(plugin, name), geoUBOs, modelUBOs);
+				m_importItems(name, nullptr, passNode.child("items"), m_plugins->BuildInputLayout(plugin, name), geoUBOs, modelUBOs, geoVBOs);
 			}
 		}
 
@@ -2609,6 +3472,7 @@ namespace ed
 		// objects
 		std::vector<PipelineItem*> passes = m_pipe->GetList();
 		std::map<PipelineItem*, std::vector<std::string>> boundTextures, boundUBOs;
+		std::map<PipelineItem*, std::vector<std::pair<std::string, SamplerState>>> boundSamplers;
 		for (pugi::xml_node objectNode : projectNode.child("objects").children("object")) {
 			const pugi::char_t* objType = objectNode.attribute("type").as_string();
 
@@ -2635,8 +3499,11 @@ namespace ed
 
 				if (isCube)
 					m_objects->CreateCubemap(name, cubeLeft, cubeTop, cubeFront, cubeBottom, cubeRight, cubeBack);
-				else
+				else {
 					m_objects->CreateTexture(name);
+					if (objectNode.attribute("mipmaps").as_bool())
+						m_objects->SetTextureMipmaps(name, true);
+				}
 
 				for (pugi::xml_node bindNode : objectNode.children("bind")) {
 					const pugi::char_t* passBindName = bindNode.attribute("name").as_string();
@@ -2649,6 +3516,42 @@ namespace ed
 
 							boundTextures[pass][slot] = name;
 
+							SamplerState sampler;
+							if (m_parseSampler(bindNode, sampler))
+								boundSamplers[pass].push_back(std::make_pair(std::string(name), sampler));
+
+							break;
+						}
+					}
+				}
+			}
+			else if (strcmp(objType, "texturearray") == 0) {
+				const pugi::char_t* objName = objectNode.attribute("name").as_string();
+
+				std::vector<std::string> layers;
+				for (pugi::xml_node layerNode : objectNode.children("layer"))
+					layers.push_back(toGenericPath(layerNode.attribute("path").as_string()));
+
+				if (!m_objects->CreateTextureArray(objName, layers))
+					continue;
+				if (objectNode.attribute("mipmaps").as_bool())
+					m_objects->SetTextureMipmaps(objName, true);
+
+				for (pugi::xml_node bindNode : objectNode.children("bind")) {
+					const pugi::char_t* passBindName = bindNode.attribute("name").as_string();
+					int slot = bindNode.attribute("slot").as_int();
+
+					for (const auto& pass : passes) {
+						if (strcmp(pass->Name, passBindName) == 0) {
+							if (boundTextures[pass].size() <= slot)
+								boundTextures[pass].resize(slot + 1);
+
+							boundTextures[pass][slot] = objName;
+
+							SamplerState sampler;
+							if (m_parseSampler(bindNode, sampler))
+								boundSamplers[pass].push_back(std::make_pair(std::string(objName), sampler));
+
 							break;
 						}
 					}
@@ -2671,6 +3574,17 @@ namespace ed
 					}
 				}
 
+				// layered rts get their own texture, nothing references the old one yet
+				if (objectNode.attribute("cubemap").as_bool() || objectNode.attribute("layers").as_int() > 1)
+					m_objects->SetRenderTextureLayers(objName, objectNode.attribute("layers").as_int(), objectNode.attribute("cubemap").as_bool());
+
+				// load mip chain - before the size so that the levels get allocated
+				rt->Mipmaps = objectNode.attribute("mipmaps").as_bool();
+				if (strcmp(objectNode.attribute("mipfilter").as_string(), "min") == 0)
+					rt->MipFilter = MipChain::Filter::Minimum;
+				else if (strcmp(objectNode.attribute("mipfilter").as_string(), "max") == 0)
+					rt->MipFilter = MipChain::Filter::Maximum;
+
 				// load size
 				if (objectNode.attribute("fsize").empty()) { // load RatioSize if attribute fsize (FixedSize) doesnt exist
 					std::string rtSize = objectNode.attribute("rsize").as_string();
@@ -2718,6 +3632,36 @@ namespace ed
 								boundTextures[pass].resize(slot + 1);
 
 							boundTextures[pass][slot] = objName;
+
+							SamplerState sampler;
+							if (m_parseSampler(bindNode, sampler))
+								boundSamplers[pass].push_back(std::make_pair(std::string(objName), sampler));
+							break;
+						}
+					}
+				}
+			}
+			else if (strcmp(objType, "history") == 0) {
+				const pugi::char_t* objName = objectNode.attribute("name").as_string();
+
+				// created by its rt, which is always saved before it
+				if (!m_objects->SetRenderTextureHistory(objectNode.attribute("source").as_string(), true))
+					continue;
+
+				for (pugi::xml_node bindNode : objectNode.children("bind")) {
+					const pugi::char_t* passBindName = bindNode.attribute("name").as_string();
+					int slot = bindNode.attribute("slot").as_int();
+
+					for (const auto& pass : passes) {
+						if (strcmp(pass->Name, passBindName) == 0) {
+							if (boundTextures[pass].size() <= slot)
+								boundTextures[pass].resize(slot + 1);
+
+							boundTextures[pass][slot] = objName;
+
+							SamplerState sampler;
+							if (m_parseSampler(bindNode, sampler))
+								boundSamplers[pass].push_back(std::make_pair(std::string(objName), sampler));
 							break;
 						}
 					}
@@ -2749,6 +3693,10 @@ namespace ed
 					iobj->Size.y = objectNode.attribute("height").as_int();
 				m_objects->ResizeImage(objName, iobj->Size);
 
+				GPUFill::Operation fill = importFill(objectNode);
+				if (fill.Op != GPUFill::Operator::None)
+					fills.push_back(std::make_pair(std::string(objName), fill));
+
 				// load binds
 				for (pugi::xml_node bindNode : objectNode.children("bind"))
 				{
@@ -2807,7 +3755,17 @@ namespace ed
 					iobj->Size.y = objectNode.attribute("height").as_int();
 				if (!objectNode.attribute("depth").empty())
 					iobj->Size.z = objectNode.attribute("depth").as_int();
-				m_objects->ResizeImage3D(objName, iobj->Size);
+
+				// the slice files are streamed in after the project is opened
+				std::vector<std::string> slices;
+				for (pugi::xml_node sliceNode : objectNode.children("slice"))
+					slices.push_back(toGenericPath(sliceNode.attribute("path").as_string()));
+				if (slices.empty() || !m_objects->LoadImage3DSlices(objName, slices))
+					m_objects->ResizeImage3D(objName, iobj->Size);
+
+				GPUFill::Operation fill = importFill(objectNode);
+				if (fill.Op != GPUFill::Operator::None)
+					fills.push_back(std::make_pair(std::string(objName), fill));
 
 				// load binds
 				for (pugi::xml_node bindNode : objectNode.children("bind"))
@@ -2845,7 +3803,147 @@ namespace ed
 				pugi::char_t objPath[MAX_PATH];
 				strcpy(objPath, toGenericPath(objectNode.attribute("path").as_string()).c_str());
 
-				m_objects->CreateAudio(std::string(objPath));
+				std::vector<sf::Int16> samples;
+				unsigned int channels = 0, sampleRate = 0;
+				if (m_takeAudio(objPath, samples, channels, sampleRate))
+					m_objects->CreateAudio(std::string(objPath), samples.data(), samples.size(), channels, sampleRate);
+				else
+					m_objects->CreateAudio(std::string(objPath));
+
+				// 0 = samples, envelope values per second otherwise
+				if (!objectNode.attribute("wholetrack").empty())
+					m_objects->SetAudioTrack(std::string(objPath), objectNode.attribute("wholetrack").as_int());
+
+				for (pugi::xml_node bindNode : objectNode.children("bind")) {
+					const pugi::char_t* passBindName = bindNode.attribute("name").as_string();
+					int slot = bindNode.attribute("slot").as_int();
+
+					for (const auto& pass : passes) {
+						if (strcmp(pass->Name, passBindName) == 0) {
+							if (boundTextures[pass].size() <= slot)
+								boundTextures[pass].resize(slot + 1);
+
+							boundTextures[pass][slot] = objPath;
+							break;
+						}
+					}
+				}
+			}
+			else if (strcmp(objType, "environment") == 0 || strcmp(objType, "environmentpart") == 0) {
+				bool isPart = strcmp(objType, "environmentpart") == 0;
+				pugi::char_t objName[MAX_PATH];
+				if (isPart)
+					strcpy(objName, objectNode.attribute("name").as_string());
+				else
+					strcpy(objName, toGenericPath(objectNode.attribute("path").as_string()).c_str());
+
+				// the parts are created by their environment map, which is always saved before them
+				if (!isPart)
+					m_objects->CreateEnvironment(std::string(objName), objectNode.attribute("size").as_int(ENVIRONMENT_FACE_SIZE));
+				if (!m_objects->Exists(objName))
+					continue;
+
+				for (pugi::xml_node bindNode : objectNode.children("bind")) {
+					const pugi::char_t* passBindName = bindNode.attribute("name").as_string();
+					int slot = bindNode.attribute("slot").as_int();
+
+					for (const auto& pass : passes) {
+						if (strcmp(pass->Name, passBindName) == 0) {
+							if (boundTextures[pass].size() <= slot)
+								boundTextures[pass].resize(slot + 1);
+
+							boundTextures[pass][slot] = objName;
+
+							SamplerState sampler;
+							if (m_parseSampler(bindNode, sampler))
+								boundSamplers[pass].push_back(std::make_pair(std::string(objName), sampler));
+
+							break;
+						}
+					}
+				}
+			}
+			else if (strcmp(objType, "imagesequence") == 0) {
+				pugi::char_t objPath[MAX_PATH];
+				strcpy(objPath, toGenericPath(objectNode.attribute("path").as_string()).c_str());
+
+				if (m_objects->CreateImageSequence(std::string(objPath))) {
+					// the ring is only rebuilt if these differ from the defaults
+					ImageSequence* seq = m_objects->GetImageSequence(objPath);
+					seq->SetFrameRate(objectNode.attribute("fps").as_float(IMAGE_SEQUENCE_FPS));
+					seq->SetClock(strcmp(objectNode.attribute("clock").as_string(), "frameindex") == 0 ? ImageSequence::Clock::FrameIndex : ImageSequence::Clock::Time);
+					seq->SetLoop(objectNode.attribute("loop").as_bool(true));
+					seq->SetLookAhead(objectNode.attribute("lookahead").as_int(IMAGE_SEQUENCE_LOOKAHEAD));
+					seq->SetBudget(objectNode.attribute("budget").as_int(IMAGE_SEQUENCE_BUDGET));
+				}
+
+				for (pugi::xml_node bindNode : objectNode.children("bind")) {
+					const pugi::char_t* passBindName = bindNode.attribute("name").as_string();
+					int slot = bindNode.attribute("slot").as_int();
+
+					for (const auto& pass : passes) {
+						if (strcmp(pass->Name, passBindName) == 0) {
+							if (boundTextures[pass].size() <= slot)
+								boundTextures[pass].resize(slot + 1);
+
+							boundTextures[pass][slot] = objPath;
+
+							SamplerState sampler;
+							if (m_parseSampler(bindNode, sampler))
+								boundSamplers[pass].push_back(std::make_pair(std::string(objPath), sampler));
+
+							break;
+						}
+					}
+				}
+			}
+			else if (strcmp(objType, "virtualtexture") == 0) {
+				pugi::char_t objPath[MAX_PATH];
+				strcpy(objPath, toGenericPath(objectNode.attribute("path").as_string()).c_str());
+
+				m_objects->CreateVirtualTexture(std::string(objPath));
+
+				for (pugi::xml_node bindNode : objectNode.children("bind")) {
+					const pugi::char_t* passBindName = bindNode.attribute("name").as_string();
+					int slot = bindNode.attribute("slot").as_int();
+
+					for (const auto& pass : passes) {
+						if (strcmp(pass->Name, passBindName) == 0) {
+							if (boundTextures[pass].size() <= slot)
+								boundTextures[pass].resize(slot + 1);
+
+							boundTextures[pass][slot] = objPath;
+
+							SamplerState sampler;
+							if (m_parseSampler(bindNode, sampler))
+								boundSamplers[pass].push_back(std::make_pair(std::string(objPath), sampler));
+
+							break;
+						}
+					}
+				}
+			}
+			else if (strcmp(objType, "video") == 0 || strcmp(objType, "capture") == 0) {
+				bool isCapture = strcmp(objType, "capture") == 0;
+				pugi::char_t objPath[MAX_PATH];
+				if (isCapture)
+					strcpy(objPath, objectNode.attribute("name").as_string());
+				else
+					strcpy(objPath, toGenericPath(objectNode.attribute("path").as_string()).c_str());
+
+				bool created = false;
+				if (isCapture)
+					created = m_objects->CreateCaptureDevice(std::string(objPath), objectNode.attribute("queue").as_int(1));
+				else
+					created = m_objects->CreateVideo(std::string(objPath));
+
+				if (created) {
+					VideoObject* vobj = m_objects->GetVideo(objPath);
+					if (!objectNode.attribute("sync").empty())
+						vobj->SyncToTime = objectNode.attribute("sync").as_bool();
+					if (!objectNode.attribute("paused").empty())
+						vobj->Paused = objectNode.attribute("paused").as_bool();
+				}
 
 				for (pugi::xml_node bindNode : objectNode.children("bind")) {
 					const pugi::char_t* passBindName = bindNode.attribute("name").as_string();
@@ -2868,22 +3966,27 @@ namespace ed
 				m_objects->CreateBuffer(objName);
 				ed::BufferObject* buf = m_objects->GetBuffer(objName);
 
-				if (!objectNode.attribute("size").empty()) {
+				if (!objectNode.attribute("size").empty())
 					buf->Size = objectNode.attribute("size").as_int();
-					buf->Data = realloc(buf->Data, buf->Size);
-				}
 				if (!objectNode.attribute("format").empty())
 					strcpy(buf->ViewFormat, objectNode.attribute("format").as_string());
 				
-				std::string bPath = GetProjectPath("buffers/" + std::string(objName) + ".buf");
-				std::ifstream bufRead(bPath, std::ios::binary);
-				if (bufRead.is_open())
-					bufRead.read((char*)buf->Data, buf->Size);
-				bufRead.close();
-
-				glBindBuffer(GL_UNIFORM_BUFFER, buf->ID);
-				glBufferData(GL_UNIFORM_BUFFER, buf->Size, buf->Data, GL_STATIC_DRAW); // allocate 0 bytes of memory
-				glBindBuffer(GL_UNIFORM_BUFFER, 0);
+				// generated on the GPU once all the objects (the copy sources) exist
+				GPUFill::Operation fill = importFill(objectNode);
+				if (fill.Op != GPUFill::Operator::None) {
+					glBindBuffer(GL_UNIFORM_BUFFER, buf->ID);
+					glBufferData(GL_UNIFORM_BUFFER, buf->Size, nullptr, GL_STATIC_DRAW);
+					glBindBuffer(GL_UNIFORM_BUFFER, 0);
+					fills.push_back(std::make_pair(std::string(objName), fill));
+				}
+				// the file was mapped on a worker thread and is uploaded from the mapping
+				else if (!m_takeBuffer(objName, buf)) {
+					buf->Data = realloc(buf->Data, buf->Size);
+
+					glBindBuffer(GL_UNIFORM_BUFFER, buf->ID);
+					glBufferData(GL_UNIFORM_BUFFER, buf->Size, buf->Data, GL_STATIC_DRAW); // allocate 0 bytes of memory
+					glBindBuffer(GL_UNIFORM_BUFFER, 0);
+				}
 				
 				for (pugi::xml_node bindNode : objectNode.children("bind")) {
 					const pugi::char_t* passBindName = bindNode.attribute("name").as_string();
@@ -2949,7 +4052,7 @@ namespace ed
 		for (auto& geo : geoUBOs) {
 			BufferObject* bojb = m_objects->GetBuffer(geo.second.first);
 			geo.first->InstanceBuffer = bojb;
-			gl::CreateVAO(geo.first->VAO, geo.first->VBO, geo.second.second->InputLayout, 0, bojb->ID, m_objects->ParseBufferFormat(bojb->ViewFormat));
+			GeometryCache::Instance().Rebuild(geo.first, geo.second.second->InputLayout, bojb->ID, m_objects->ParseBufferFormat(bojb->ViewFormat));
 		}
 		for (auto& mdl : modelUBOs) {
 			if (mdl.second.first.size() > 0) {
@@ -2957,18 +4060,53 @@ namespace ed
 				mdl.first->InstanceBuffer = bojb;
 
 				for (auto& mesh : mdl.first->Data->Meshes)
-					gl::CreateVAO(mesh.VAO, mesh.VBO, mdl.second.second->InputLayout, mesh.EBO, bojb->ID, m_objects->ParseBufferFormat(bojb->ViewFormat));
+					VAOCache::Instance().Rebuild(mesh.VAO, mesh.VBO, mdl.second.second->InputLayout, mesh.EBO, bojb->ID, m_objects->ParseBufferFormat(bojb->ViewFormat));
 			} else { // recreate vao anyway
 				for (auto& mesh : mdl.first->Data->Meshes)
-					gl::CreateVAO(mesh.VAO, mesh.VBO, mdl.second.second->InputLayout, mesh.EBO);
+					VAOCache::Instance().Rebuild(mesh.VAO, mesh.VBO, mdl.second.second->InputLayout, mesh.EBO);
 			}
 		}
 
+		// indirect dispatch buffers
+		for (auto& cs : indirectBuffers)
+			cs.first->IndirectBuffer = m_objects->GetBuffer(cs.second);
+		for (auto& sp : meshTaskBuffers)
+			sp.first->MeshTaskBuffer = m_objects->GetBuffer(sp.second);
+		for (auto& sp : passConditions)
+			sp.first->ConditionBuffer = m_objects->GetBuffer(sp.second);
+		for (auto& sp : captureBuffers)
+			sp.first->CaptureBuffer = m_objects->GetBuffer(sp.second);
+
+		// captured geometry - after the instance buffers since the VAO has both
+		for (auto& geo : geoVBOs) {
+			geo.first->VertexBuffer = m_objects->GetBuffer(geo.second.first);
+
+			std::vector<InputLayoutItem> layout = geo.second.second != nullptr ? geo.second.second->InputLayout : gl::CreateDefaultInputLayout();
+			BufferObject* instances = (BufferObject*)geo.first->InstanceBuffer;
+			if (instances != nullptr)
+				GeometryCache::Instance().Rebuild(geo.first, layout, instances->ID, m_objects->ParseBufferFormat(instances->ViewFormat));
+			else
+				GeometryCache::Instance().Rebuild(geo.first, layout);
+		}
+		for (auto& cs : computeConditions)
+			cs.first->ConditionBuffer = m_objects->GetBuffer(cs.second);
+
+		// generated objects
+		for (const auto& fill : fills) {
+			if (m_objects->IsBuffer(fill.first))
+				m_objects->FillBuffer(fill.first, fill.second);
+			else
+				m_objects->FillImage(fill.first, fill.second);
+		}
+
 		// bind objects
 		for (const auto& b : boundTextures)
 			for (const auto& id : b.second)
 				if (!id.empty())
 					m_objects->Bind(id, b.first);
+		for (const auto& b : boundSamplers)
+			for (const auto& sampler : b.second)
+				m_objects->SetSampler(b.first, m_objects->GetTexture(sampler.first), sampler.second);
 		// bind buffers
 		for (const auto& b : boundUBOs)
 			for (const auto& id : b.second)
@@ -2980,7 +4118,7 @@ namespace ed
 		for (pugi::xml_node settingItem : projectNode.child("settings").children("entry")) {
 			if (!settingItem.attribute("type").empty()) {
 				std::string type = settingItem.attribute("type").as_string();
-				if (type == "property") {
+				if (type == "property" && m_ui != nullptr) {
 					PropertyUI* props = ((PropertyUI*)m_ui->Get(ViewID::Properties));
 					if (!settingItem.attribute("name").empty()) {
 						int type = 0; // pipeline item
@@ -3000,7 +4138,7 @@ namespace ed
 							props->Open(itemName, m_objects->GetObjectManagerItem(itemName));
 					}
 				}
-				else if (type == "file" && Settings::Instance().General.ReopenShaders) {
+				else if (type == "file" && Settings::Instance().General.ReopenShaders && m_ui != nullptr) {
 					CodeEditorUI* editor = ((CodeEditorUI*)m_ui->Get(ViewID::Code));
 					if (!settingItem.attribute("name").empty()) {
 						PipelineItem* item = m_pipe->Get(settingItem.attribute("name").as_string());
@@ -3031,7 +4169,7 @@ namespace ed
 						}
 					}
 				}
-				else if (type == "pinned") {
+				else if (type == "pinned" && m_ui != nullptr) {
 					PinnedUI* pinned = ((PinnedUI*)m_ui->Get(ViewID::Pinned));
 					if (!settingItem.attribute("name").empty()) {
 						const pugi::char_t* item = settingItem.attribute("name").as_string();
@@ -3104,6 +4242,24 @@ namespace ed
 					for (pugi::xml_node pathNode : settingItem.children("path"))
 						Settings::Instance().Project.IncludePaths.push_back(pathNode.text().as_string());
 				}
+				else if (type == "spvopt") {
+					int preset = settingItem.attribute("val").as_int();
+					Settings::Instance().Project.SPIRVOptimization = (preset < 0 || preset > 2) ? 0 : preset;
+				}
+				else if (type == "audioarray")
+					Settings::Instance().Project.AudioTextureArray = settingItem.attribute("val").as_bool();
+				else if (type == "bindless")
+					Settings::Instance().Project.BindlessTextures = settingItem.attribute("val").as_bool();
+				else if (type == "stereo") {
+					Settings::Instance().Project.EyeSeparation = settingItem.attribute("separation").as_float(0.064f);
+					Settings::Instance().Project.StereoConvergence = std::max(settingItem.attribute("convergence").as_float(10.0f), 0.001f);
+					Settings::Instance().Project.StereoPreview = settingItem.attribute("preview").as_string();
+				}
+				else if (type == "share") {
+					TextureSharing::Output* out = TextureSharing::Instance().Add(settingItem.attribute("source").as_string(), settingItem.attribute("name").as_string());
+					out->GPU = settingItem.attribute("gpu").as_bool() && TextureSharing::IsGPUSharingSupported();
+					out->NDI = settingItem.attribute("ndi").as_bool();
+				}
 				else if (type == "watch_expr") {
 					if (!settingItem.attribute("expr").empty())
 						m_debug->AddWatch(settingItem.attribute("expr").as_string(), false);
@@ -2,9 +2,17 @@
 #include "../GUIManager.h"
 #include "ShaderVariable.h"
 #include "MessageStack.h"
+#include "SamplerCache.h"
 #include "../Engine/Model.h"
+#include "../Engine/ThreadPool.h"
+#include "../Engine/MappedFile.h"
 
 #include <string>
+#include <memory>
+#include <atomic>
+#include <unordered_map>
+#include <ghc/filesystem.hpp>
+#include <SFML/Config.hpp>
 #include <pugixml/src/pugixml.hpp>
 #ifdef _WIN32
 #include <windows.h>
@@ -25,6 +33,7 @@ namespace ed
 	class InputLayoutItem;
 	class DebugInformation;
 	struct PipelineItem;
+	struct BufferObject;
 	namespace pipe { struct ShaderPass; struct GeometryItem; struct Model; }
 
 	class ProjectParser
@@ -39,6 +48,7 @@ namespace ed
 
 		void Save();
 		void SaveAs(const std::string& file, bool copyFiles = false);
+		std::string ExportRecoverySnapshot(const std::vector<std::pair<std::string, std::string>>& sources); // project XML, sources -> the shaders that were not saved & their copies
 
 		std::string LoadProjectFile(const std::string& file);
 		std::string LoadFile(const std::string& file);
@@ -56,9 +66,11 @@ namespace ed
 		inline const std::string& GetProjectDirectory() { return m_projectPath; }
 
 		inline const std::string& GetOpenedFile() { return m_file; }
+		inline const std::string& GetOpenedArchive() { return m_archive; }
 		inline const std::string& GetTemplate() { return m_template; }
 
-		inline void ModifyProject() { m_modified = true; }
+		inline void ModifyProject() { m_modified = true; m_revision++; }
+		inline unsigned int GetRevision() { return m_revision; } // incremented by every ModifyProject() call
 		inline bool IsProjectModified() { return m_modified; }
 
 	private:
@@ -73,13 +85,30 @@ namespace ed
 		GLenum m_toComparisonFunc(const char* str);
 		GLenum m_toStencilOp(const char* str);
 		GLenum m_toCullMode(const char* str);
+		void m_exportSampler(pugi::xml_node& node, const SamplerState* state); // nothing if the texture parameters are used
+		bool m_parseSampler(const pugi::xml_node& node, SamplerState& state);
 
+		void m_exportProject(pugi::xml_document& doc, const std::string& oldProjectPath, bool copyFiles, const std::string& projectStem, bool writeFiles); // writeFiles -> also the buffer files
 		void m_exportItems(pugi::xml_node& node, std::vector<PipelineItem*>& items, const std::string& oldProjectPath);
 		void m_importItems(const char* owner, pipe::ShaderPass* data, const pugi::xml_node& node, const std::vector<InputLayoutItem>& inpLayout,
 			std::map<pipe::GeometryItem*, std::pair<std::string, pipe::ShaderPass*>>& geoUBOs,
-			std::map<pipe::Model*, std::pair<std::string, pipe::ShaderPass*>>& modelUBOs);
+			std::map<pipe::Model*, std::pair<std::string, pipe::ShaderPass*>>& modelUBOs,
+			std::map<pipe::GeometryItem*, std::pair<std::string, pipe::ShaderPass*>>& geoVBOs);
+
+		// files written by the last saves - a file whose contents, size & modification time didn't change isn't written again,
+		// everything else goes to a temporary file that replaces the old one so that a failed save can't leave a half written file
+		struct SavedFile
+		{
+			uint64_t Hash;
+			uintmax_t Size;
+			ghc::filesystem::file_time_type Time;
+		};
+		std::unordered_map<std::string, SavedFile> m_savedFiles;
+		bool m_writeFile(const std::string& path, const char* data, size_t size);
+		bool m_copyFile(const std::string& from, const std::string& to); // skips the files that the last save wrote with the same content
 
 		bool m_modified;
+		unsigned int m_revision;
 
 		GUIManager* m_ui;
 		PipelineManager* m_pipe;
@@ -89,6 +118,7 @@ namespace ed
 		MessageStack* m_msgs;
 		DebugInformation* m_debug;
 		std::string m_file;
+		std::string m_archive; // .sprjpack file that m_file was unpacked from
 		std::string m_projectPath;
 		std::string m_template;
 
@@ -96,5 +126,47 @@ namespace ed
 		void m_addPlugin(const std::string& name);
 		
 		std::vector<std::pair<std::string, eng::Model*>> m_models;
+
+		// models used by a project are imported on worker threads while the rest of the project is parsed
+		struct ModelLoadJob
+		{
+			std::string File;
+			eng::Model* Model;
+			unsigned int Flags; // m_modelFlags() when the job was queued
+			std::atomic<bool> Done;
+			bool Loaded;
+		};
+		std::vector<std::shared_ptr<ModelLoadJob>> m_modelJobs;
+		void m_prefetchModels(pugi::xml_node& projectNode);
+		unsigned int m_modelFlags(); // import settings that change the result, for ResidentAssets
+
+		// audio files are decoded and buffer files are read on the same workers
+		struct AudioLoadJob
+		{
+			std::string File;
+			std::vector<sf::Int16> Samples;
+			unsigned int Channels, SampleRate;
+			std::atomic<bool> Done;
+			bool Loaded;
+		};
+		struct BufferLoadJob
+		{
+			std::string Name, Path;
+			eng::MappedFile Mapping;
+			std::atomic<bool> Done;
+			bool Loaded;
+		};
+		std::vector<std::shared_ptr<AudioLoadJob>> m_audioJobs;
+		std::vector<std::shared_ptr<BufferLoadJob>> m_bufferJobs;
+		void m_prefetchObjects(pugi::xml_node& projectNode);
+		bool m_takeAudio(const std::string& file, std::vector<sf::Int16>& samples, unsigned int& channels, unsigned int& sampleRate); // false -> not prefetched or couldn't be decoded
+		bool m_takeBuffer(const std::string& name, BufferObject* buf); // false -> not prefetched or the file doesn't exist
+
+		void m_finishLoadJobs();
+		std::atomic<int> m_loadDone; // background jobs of the project that is being opened
+		int m_loadTotal;
+		void m_waitForJob(const std::atomic<bool>& done, const std::string& name);
+
+		eng::ThreadPool m_loadPool; // keep this last so that the workers stop before anything else is destroyed
 	};
 }
\ No newline at end of file
@@ -0,0 +1,157 @@
+#include "ProjectRecovery.h"
+#include "Logger.h"
+#include "../Engine/MappedFile.h"
+
+#include <stdio.h>
+#include <ghc/filesystem.hpp>
+#if defined(_WIN32)
+	#include <io.h>
+#else
+	#include <unistd.h>
+#endif
+
+namespace ed
+{
+	ProjectRecovery::ProjectRecovery()
+	{
+		m_exit = false;
+		m_pending = false;
+		m_discard = false;
+		m_hasSnapshot = false;
+		m_thread = new std::thread(&ProjectRecovery::m_run, this);
+	}
+	ProjectRecovery::~ProjectRecovery()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_exit = true;
+		}
+		m_signal.notify_one();
+
+		m_thread->join();
+		delete m_thread;
+	}
+	std::string ProjectRecovery::GetSnapshotPath(const std::string& project)
+	{
+		ghc::filesystem::path path(project);
+		return (path.parent_path() / (path.stem().generic_string() + ".recovery.sprj")).generic_string();
+	}
+	std::string ProjectRecovery::GetSourcePath(const std::string& project, const std::string& source)
+	{
+		// flat names so that absolute & relative paths both end up in the directory
+		std::string name = source;
+		for (char& c : name)
+			if (c == '/' || c == '\\' || c == ':')
+				c = '_';
+
+		return std::string(RECOVERY_DIRECTORY) + "/" + ghc::filesystem::path(project).stem().generic_string() + "_" + name;
+	}
+	void ProjectRecovery::Write(const std::vector<File>& files)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_queued = files;
+			m_pending = true;
+		}
+		m_signal.notify_one();
+
+		m_hasSnapshot = true;
+	}
+	void ProjectRecovery::Discard()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_queued.clear();
+			m_pending = false;
+			m_discard = true;
+		}
+		m_signal.notify_one();
+
+		m_hasSnapshot = false;
+	}
+	void ProjectRecovery::m_run()
+	{
+		while (true) {
+			std::vector<File> files;
+			bool write = false, discard = false;
+
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_signal.wait(lock, [&]() { return m_exit || m_pending || m_discard; });
+
+				if (!m_pending && !m_discard)
+					return;
+
+				files.swap(m_queued);
+				write = m_pending;
+				discard = m_discard;
+				m_pending = m_discard = false;
+			}
+
+			if (discard) {
+				for (const File& file : m_written)
+					m_removeFile(file.Path);
+				m_written.clear();
+			}
+			if (!write)
+				continue;
+
+			// files of the previous snapshot that aren't part of this one were saved in the meantime
+			for (const File& old : m_written) {
+				bool kept = false;
+				for (const File& file : files)
+					kept |= file.Path == old.Path;
+				if (!kept)
+					m_removeFile(old.Path);
+			}
+
+			for (File& file : files) {
+				bool unchanged = false;
+				for (const File& old : m_written)
+					unchanged |= old.Path == file.Path && old.Data == file.Data;
+
+				if (!unchanged && !m_writeFile(file.Path, *file.Data)) {
+					Logger::Get().Log("Failed to write the recovery file " + file.Path, true);
+					file.Data = nullptr; // try again with the next snapshot
+				}
+			}
+			m_written = files;
+		}
+	}
+	bool ProjectRecovery::m_writeFile(const std::string& path, const std::string& data)
+	{
+		std::error_code ec;
+		ghc::filesystem::create_directories(ghc::filesystem::path(path).parent_path(), ec);
+
+		// a crash while writing can't destroy the previous snapshot
+		std::string temp = path + ".tmp";
+		FILE* f = fopen(temp.c_str(), "wb");
+		if (f == nullptr)
+			return false;
+
+		bool ok = fwrite(data.data(), 1, data.size(), f) == data.size() && fflush(f) == 0;
+#if defined(_WIN32)
+		ok = ok && _commit(_fileno(f)) == 0;
+#else
+		ok = ok && fsync(fileno(f)) == 0;
+#endif
+		ok = (fclose(f) == 0) && ok;
+
+		ok = ok && eng::ReplaceFileWith(path, temp);
+		if (!ok) {
+			ghc::filesystem::remove(temp, ec);
+			return false;
+		}
+		return true;
+	}
+	void ProjectRecovery::m_removeFile(const std::string& path)
+	{
+		std::error_code ec;
+		ghc::filesystem::remove(path, ec);
+
+		// the recovery directory goes away with its last file
+		ghc::filesystem::path dir = ghc::filesystem::path(path).parent_path();
+		if (dir.filename() == RECOVERY_DIRECTORY && ghc::filesystem::is_empty(dir, ec))
+			ghc::filesystem::remove(dir, ec);
+	}
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+#define RECOVERY_INTERVAL 600.0f // seconds between two snapshots - they are only taken if something isn't saved
+#define RECOVERY_DIRECTORY ".recovery" // next to the project file, has the copies of the unsaved shaders
+
+namespace ed
+{
+	// recovery snapshots of the opened project - the files are put together on the UI thread and
+	// written (and flushed to the disk) by a worker so that a slow drive never blocks a frame
+	class ProjectRecovery
+	{
+	public:
+		struct File
+		{
+			std::string Path;
+			std::shared_ptr<const std::string> Data; // same pointer as in the previous snapshot -> it isn't written again
+		};
+
+		ProjectRecovery();
+		~ProjectRecovery(); // finishes the work that is still queued
+
+		static std::string GetSnapshotPath(const std::string& project); // <project>.recovery.sprj, can be opened as a project
+		static std::string GetSourcePath(const std::string& project, const std::string& source); // relative to the project's directory
+
+		void Write(const std::vector<File>& files); // replaces the snapshot that wasn't written yet
+		void Discard(); // deletes the files of the written snapshots, once the project is saved
+		inline bool HasSnapshot() { return m_hasSnapshot; }
+
+	private:
+		void m_run();
+		static bool m_writeFile(const std::string& path, const std::string& data);
+		static void m_removeFile(const std::string& path);
+
+		std::thread* m_thread;
+		std::mutex m_mutex;
+		std::condition_variable m_signal;
+		bool m_exit, m_pending, m_discard;
+		std::vector<File> m_queued;
+
+		std::vector<File> m_written; // only used by the worker
+		bool m_hasSnapshot; // only used by the UI thread
+	};
+}
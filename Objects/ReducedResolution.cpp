@@ -0,0 +1,327 @@
+#include "ReducedResolution.h"
+#include "GLStateCache.h"
+#include "Logger.h"
+#include "../Engine/GLUtils.h"
+
+#include <algorithm>
+#include <string>
+
+#define REDUCED_RESOLUTION_DEPTH_EPSILON 0.0001f // keeps the weights of the texels with the same depth finite
+
+const char* UPSAMPLE_VS = R"(
+#version 330
+
+void main()
+{
+	// full screen triangle
+	vec2 uv = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+	gl_Position = vec4(uv * 2.0f - 1.0f, 0.0f, 1.0f);
+}
+)";
+
+const char* UPSAMPLE_PS = R"(
+#version 330
+
+uniform sampler2D lowColor;
+uniform sampler2D lowDepth;
+uniform sampler2D fullDepth;
+uniform ivec2 lowSize;
+
+out vec4 outColor;
+
+void main()
+{
+	ivec2 pixel = ivec2(gl_FragCoord.xy);
+	vec2 lowPos = gl_FragCoord.xy / vec2(textureSize(fullDepth, 0)) * vec2(lowSize) - 0.5f;
+	ivec2 base = ivec2(floor(lowPos));
+	vec2 frac = lowPos - vec2(base);
+	float depth = texelFetch(fullDepth, pixel, 0).r;
+
+	// bilinear weights scaled down by the depth difference - the texels from the other side of an edge barely count
+	vec4 sum = vec4(0.0f);
+	float total = 0.0f;
+	for (int i = 0; i < 4; i++) {
+		ivec2 offset = ivec2(i & 1, i >> 1);
+		ivec2 texel = clamp(base + offset, ivec2(0), lowSize - 1);
+		vec2 bilinear = mix(1.0f - frac, frac, vec2(offset));
+		float weight = bilinear.x * bilinear.y / (EPSILON + abs(texelFetch(lowDepth, texel, 0).r - depth));
+
+		sum += texelFetch(lowColor, texel, 0) * weight;
+		total += weight;
+	}
+
+	outColor = sum / max(total, 1e-8f);
+}
+)";
+
+namespace ed
+{
+	static bool isIntegerFormat(GLint format)
+	{
+		switch (format) {
+		case GL_RGB10_A2UI:
+		case GL_R8I: case GL_R8UI: case GL_R16I: case GL_R16UI: case GL_R32I: case GL_R32UI:
+		case GL_RG8I: case GL_RG8UI: case GL_RG16I: case GL_RG16UI: case GL_RG32I: case GL_RG32UI:
+		case GL_RGB8I: case GL_RGB8UI: case GL_RGB16I: case GL_RGB16UI: case GL_RGB32I: case GL_RGB32UI:
+		case GL_RGBA8I: case GL_RGBA8UI: case GL_RGBA16I: case GL_RGBA16UI: case GL_RGBA32I: case GL_RGBA32UI:
+			return true;
+		}
+		return false;
+	}
+
+	ReducedResolution::ReducedResolution()
+	{
+		m_program = m_vao = m_fbo = 0;
+		m_lowSizeLoc = -1;
+	}
+	ReducedResolution::~ReducedResolution()
+	{
+		Clear();
+		if (m_program != 0) {
+			glDeleteProgram(m_program);
+			glDeleteVertexArrays(1, &m_vao);
+			glDeleteFramebuffers(1, &m_fbo);
+		}
+	}
+	bool ReducedResolution::m_init()
+	{
+		GLchar msg[1024];
+
+		std::string psSource = UPSAMPLE_PS;
+		psSource.insert(psSource.find('\n', 1) + 1, "#define EPSILON " + std::to_string(REDUCED_RESOLUTION_DEPTH_EPSILON) + "\n");
+
+		GLuint vs = gl::CompileShader(GL_VERTEX_SHADER, UPSAMPLE_VS);
+		GLuint ps = gl::CompileShader(GL_FRAGMENT_SHADER, psSource.c_str());
+		bool compiled = gl::CheckShaderCompilationStatus(vs, msg) && gl::CheckShaderCompilationStatus(ps, msg);
+		if (!compiled) {
+			Logger::Get().Log("Failed to compile the upsampling shader: " + std::string(msg), true);
+			glDeleteShader(vs);
+			glDeleteShader(ps);
+			return false;
+		}
+
+		m_program = glCreateProgram();
+		gl::SetObjectLabel(GL_PROGRAM, m_program, "Upsampling");
+		glAttachShader(m_program, vs);
+		glAttachShader(m_program, ps);
+		glLinkProgram(m_program);
+		glDeleteShader(vs);
+		glDeleteShader(ps);
+
+		if (!gl::CheckShaderLinkStatus(m_program, msg)) {
+			Logger::Get().Log("Failed to link the upsampling shader: " + std::string(msg), true);
+			glDeleteProgram(m_program);
+			m_program = 0;
+			return false;
+		}
+
+		glUseProgram(m_program);
+		glUniform1i(glGetUniformLocation(m_program, "lowColor"), 0);
+		glUniform1i(glGetUniformLocation(m_program, "lowDepth"), 1);
+		glUniform1i(glGetUniformLocation(m_program, "fullDepth"), 2);
+		m_lowSizeLoc = glGetUniformLocation(m_program, "lowSize");
+		glUseProgram(0);
+
+		glGenVertexArrays(1, &m_vao);
+		glGenFramebuffers(1, &m_fbo);
+
+		return true;
+	}
+	glm::ivec2 ReducedResolution::Begin(pipe::ShaderPass* pass, const glm::ivec2& size)
+	{
+		State& state = m_states[pass];
+		int scale = std::max(pass->ResolutionScale, 1);
+		glm::ivec2 lowSize = glm::max(size / scale, glm::ivec2(1));
+
+		// new copies when the render textures change
+		if (state.Size != lowSize || state.FullSize != size || !std::equal(pass->RenderTextures, pass->RenderTextures + MAX_RENDER_TEXTURES, state.Targets)) {
+			m_free(state);
+
+			glGenFramebuffers(1, &state.FBO);
+			glBindFramebuffer(GL_FRAMEBUFFER, state.FBO);
+			gl::SetObjectLabel(GL_FRAMEBUFFER, state.FBO, "Reduced resolution");
+
+			for (int i = 0; i < pass->RTCount; i++) {
+				GLint format = GL_RGBA;
+				glBindTexture(GL_TEXTURE_2D, pass->RenderTextures[i]);
+				glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &format);
+
+				glGenTextures(1, &state.Textures[i]);
+				glBindTexture(GL_TEXTURE_2D, state.Textures[i]);
+				glTexImage2D(GL_TEXTURE_2D, 0, format, lowSize.x, lowSize.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+				gl::SetObjectLabel(GL_TEXTURE, state.Textures[i], "Reduced resolution");
+				glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, state.Textures[i], 0);
+
+				state.Integer[i] = isIntegerFormat(format);
+			}
+
+			glGenTextures(1, &state.Depth);
+			glBindTexture(GL_TEXTURE_2D, state.Depth);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, lowSize.x, lowSize.y, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, nullptr);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			gl::SetObjectLabel(GL_TEXTURE, state.Depth, "Reduced resolution (depth)");
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, state.Depth, 0);
+			glBindTexture(GL_TEXTURE_2D, 0);
+
+			memcpy(state.Targets, pass->RenderTextures, sizeof(state.Targets));
+			state.Size = lowSize;
+			state.FullSize = size;
+		}
+
+		// blits are scissored too
+		GLboolean scissor = glIsEnabled(GL_SCISSOR_TEST);
+		glDisable(GL_SCISSOR_TEST);
+
+		// the copies start with what the full resolution targets have
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, pass->FBO);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, state.FBO);
+		for (int i = 0; i < pass->RTCount; i++) {
+			glReadBuffer(GL_COLOR_ATTACHMENT0 + i);
+			glDrawBuffer(GL_COLOR_ATTACHMENT0 + i);
+			glBlitFramebuffer(0, 0, size.x, size.y, 0, 0, lowSize.x, lowSize.y, GL_COLOR_BUFFER_BIT, state.Integer[i] ? GL_NEAREST : GL_LINEAR);
+		}
+		glBlitFramebuffer(0, 0, size.x, size.y, 0, 0, lowSize.x, lowSize.y, GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT, GL_NEAREST);
+
+		if (scissor)
+			glEnable(GL_SCISSOR_TEST);
+
+		GLenum buffers[MAX_RENDER_TEXTURES];
+		for (int i = 0; i < pass->RTCount; i++)
+			buffers[i] = GL_COLOR_ATTACHMENT0 + i;
+		glBindFramebuffer(GL_FRAMEBUFFER, state.FBO);
+		glDrawBuffers(pass->RTCount, buffers);
+
+		return lowSize;
+	}
+	void ReducedResolution::End(pipe::ShaderPass* pass)
+	{
+		auto found = m_states.find(pass);
+		if (found == m_states.end())
+			return;
+		State& state = found->second;
+
+		GLboolean scissor = glIsEnabled(GL_SCISSOR_TEST);
+		glDisable(GL_SCISSOR_TEST);
+
+		bool edgeAware = pass->EdgeAwareUpsample && pass->DepthTexture != 0 && (m_program != 0 || m_init());
+		if (!edgeAware) {
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, state.FBO);
+			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, pass->FBO);
+			for (int i = 0; i < pass->RTCount; i++) {
+				glReadBuffer(GL_COLOR_ATTACHMENT0 + i);
+				glDrawBuffer(GL_COLOR_ATTACHMENT0 + i);
+				glBlitFramebuffer(0, 0, state.Size.x, state.Size.y, 0, 0, state.FullSize.x, state.FullSize.y, GL_COLOR_BUFFER_BIT, state.Integer[i] ? GL_NEAREST : GL_LINEAR);
+			}
+		} else {
+			// passes without a render state item inherit the state of the previous pass - it has to stay the way it was
+			GLboolean blend = glIsEnabled(GL_BLEND), cull = glIsEnabled(GL_CULL_FACE), depth = glIsEnabled(GL_DEPTH_TEST), stencil = glIsEnabled(GL_STENCIL_TEST);
+			GLint polygonMode[2];
+			GLboolean colorMask[4];
+			glGetIntegerv(GL_POLYGON_MODE, polygonMode);
+			glGetBooleanv(GL_COLOR_WRITEMASK, colorMask);
+
+			glDisable(GL_BLEND);
+			glDisable(GL_CULL_FACE);
+			glDisable(GL_DEPTH_TEST);
+			glDisable(GL_STENCIL_TEST);
+			glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+			glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+			// the sampler objects would make the textures incomplete or filtered
+			GLStateCache& glState = GLStateCache::Instance();
+			for (int i = 0; i < 3; i++)
+				glState.BindSampler(i, 0);
+
+			glViewport(0, 0, state.FullSize.x, state.FullSize.y);
+			glUseProgram(m_program);
+			glUniform2i(m_lowSizeLoc, state.Size.x, state.Size.y);
+			glBindVertexArray(m_vao);
+			glActiveTexture(GL_TEXTURE1);
+			glBindTexture(GL_TEXTURE_2D, state.Depth);
+			glActiveTexture(GL_TEXTURE2);
+			glBindTexture(GL_TEXTURE_2D, pass->DepthTexture);
+			glActiveTexture(GL_TEXTURE0);
+
+			// one render texture at a time & without the depth buffer that is read - the shader has a single output
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, state.FBO);
+			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_fbo);
+			glDrawBuffer(GL_COLOR_ATTACHMENT0);
+			for (int i = 0; i < pass->RTCount; i++) {
+				glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, pass->RenderTextures[i], 0);
+
+				if (state.Integer[i]) {
+					glReadBuffer(GL_COLOR_ATTACHMENT0 + i);
+					glBlitFramebuffer(0, 0, state.Size.x, state.Size.y, 0, 0, state.FullSize.x, state.FullSize.y, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+					continue;
+				}
+
+				glBindTexture(GL_TEXTURE_2D, state.Textures[i]);
+				glDrawArrays(GL_TRIANGLES, 0, 3);
+			}
+			glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+
+			for (int i = 2; i >= 0; i--) {
+				glActiveTexture(GL_TEXTURE0 + i);
+				glBindTexture(GL_TEXTURE_2D, 0);
+			}
+			glBindVertexArray(0);
+			glUseProgram(0);
+
+			if (blend) glEnable(GL_BLEND);
+			if (cull) glEnable(GL_CULL_FACE);
+			if (depth) glEnable(GL_DEPTH_TEST);
+			if (stencil) glEnable(GL_STENCIL_TEST);
+			glPolygonMode(GL_FRONT_AND_BACK, polygonMode[0]);
+			glColorMask(colorMask[0], colorMask[1], colorMask[2], colorMask[3]);
+		}
+
+		if (scissor)
+			glEnable(GL_SCISSOR_TEST);
+
+		GLenum buffers[MAX_RENDER_TEXTURES];
+		for (int i = 0; i < pass->RTCount; i++)
+			buffers[i] = GL_COLOR_ATTACHMENT0 + i;
+		glBindFramebuffer(GL_FRAMEBUFFER, pass->FBO);
+		glDrawBuffers(pass->RTCount, buffers);
+		glViewport(0, 0, state.FullSize.x, state.FullSize.y);
+	}
+	void ReducedResolution::m_free(State& state)
+	{
+		for (int i = 0; i < MAX_RENDER_TEXTURES; i++)
+			if (state.Textures[i] != 0)
+				glDeleteTextures(1, &state.Textures[i]);
+		if (state.Depth != 0)
+			glDeleteTextures(1, &state.Depth);
+		if (state.FBO != 0)
+			glDeleteFramebuffers(1, &state.FBO);
+
+		state = State();
+	}
+	void ReducedResolution::Release(pipe::ShaderPass* pass)
+	{
+		auto state = m_states.find(pass);
+		if (state == m_states.end())
+			return;
+
+		m_free(state->second);
+		m_states.erase(state);
+	}
+	void ReducedResolution::Clear()
+	{
+		for (auto& state : m_states)
+			m_free(state.second);
+		m_states.clear();
+	}
+	void ReducedResolution::GetTextures(std::vector<GLuint>& out)
+	{
+		for (const auto& state : m_states) {
+			for (int i = 0; i < MAX_RENDER_TEXTURES && state.second.Textures[i] != 0; i++)
+				out.push_back(state.second.Textures[i]);
+			if (state.second.Depth != 0)
+				out.push_back(state.second.Depth);
+		}
+	}
+}
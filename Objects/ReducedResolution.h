@@ -0,0 +1,59 @@
+#pragma once
+#include "PipelineItem.h"
+
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/glew.h>
+#if defined(__APPLE__)
+	#include <OpenGL/gl.h>
+#else
+	#include <GL/gl.h>
+#endif
+
+namespace ed
+{
+	// shader passes with pipe::ShaderPass::ResolutionScale > 1 draw to smaller copies of their render textures & depth buffer,
+	// the copies start with a downsampled version of what the full resolution targets have (after their clears) and are
+	// upsampled back into them once the pass is done - bilinear or weighted by how close the 4 nearest low resolution depths
+	// are to the full resolution depth, which keeps the edges of the objects sharp
+	class ReducedResolution
+	{
+	public:
+		ReducedResolution();
+		~ReducedResolution();
+
+		// binds the low resolution framebuffer, the pass' fbo has to be up to date - returns the size of the copies
+		glm::ivec2 Begin(pipe::ShaderPass* pass, const glm::ivec2& size);
+		void End(pipe::ShaderPass* pass); // upsamples into the render textures, pass->FBO is bound afterwards
+
+		void Release(pipe::ShaderPass* pass);
+		void Clear();
+
+		void GetTextures(std::vector<GLuint>& out); // the low resolution copies, for the memory panel
+
+	private:
+		struct State
+		{
+			State() { memset(Textures, 0, sizeof(Textures)); memset(Targets, 0, sizeof(Targets)); memset(Integer, 0, sizeof(Integer)); Depth = FBO = 0; Size = FullSize = glm::ivec2(0, 0); }
+
+			GLuint Textures[MAX_RENDER_TEXTURES]; // low resolution copies
+			GLuint Targets[MAX_RENDER_TEXTURES]; // render textures they were made for
+			bool Integer[MAX_RENDER_TEXTURES]; // can't be filtered - copied with GL_NEAREST
+			GLuint Depth, FBO;
+			glm::ivec2 Size, FullSize;
+		};
+
+		bool m_init();
+		void m_free(State& state);
+
+		std::unordered_map<pipe::ShaderPass*, State> m_states;
+
+		GLuint m_program, m_vao, m_fbo; // the render textures are attached one by one - their depth buffer is read
+		GLint m_lowSizeLoc;
+	};
+}
@@ -0,0 +1,114 @@
+#include "ReloadProfiler.h"
+#include "Logger.h"
+
+#include <stdio.h>
+
+namespace ed
+{
+	const char* RELOAD_STEP_NAMES[] = { "read", "includes", "parse", "SPIR-V", "SPIRV-Cross", "compile", "link", "reflection" };
+
+	ReloadProfiler::Entry::Entry()
+	{
+		for (int i = 0; i < StepCount; i++)
+			Time[i] = 0.0f;
+		Total = 0.0f;
+		Cached = false;
+	}
+	const char* ReloadProfiler::GetStepName(int step)
+	{
+		return (step >= 0 && step < StepCount) ? RELOAD_STEP_NAMES[step] : "";
+	}
+	void ReloadProfiler::Begin(const std::string& item, const std::string& trigger, std::chrono::steady_clock::time_point origin)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		auto it = m_pending.find(item);
+		if (it != m_pending.end() && !it->second.Finished)
+			return;
+
+		Pending& pending = m_pending[item];
+		pending = Pending();
+		pending.Data.Item = item;
+		pending.Data.Trigger = trigger;
+		pending.Data.Origin = origin;
+	}
+	void ReloadProfiler::Add(const std::string& item, int step, float ms)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		auto it = m_pending.find(item);
+		if (it != m_pending.end() && !it->second.Finished)
+			it->second.Data.Time[step] += ms;
+	}
+	void ReloadProfiler::SetCached(const std::string& item)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		auto it = m_pending.find(item);
+		if (it != m_pending.end())
+			it->second.Data.Cached = true;
+	}
+	void ReloadProfiler::Finish(const std::string& item)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		auto it = m_pending.find(item);
+		if (it != m_pending.end())
+			it->second.Finished = true;
+	}
+	void ReloadProfiler::Cancel(const std::string& item)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_pending.erase(item);
+	}
+	void ReloadProfiler::EndFrame()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		for (auto it = m_pending.begin(); it != m_pending.end();) {
+			if (!it->second.Finished) {
+				++it;
+				continue;
+			}
+
+			Entry& entry = it->second.Data;
+			entry.Total = Elapsed(entry.Origin);
+
+			char buffer[64];
+			std::string msg = "Reloaded " + entry.Item + " (" + entry.Trigger + (entry.Cached ? ", cached" : "") + ") in ";
+			snprintf(buffer, 64, "%.2f ms -", entry.Total);
+			msg += buffer;
+			for (int i = 0; i < StepCount; i++) {
+				snprintf(buffer, 64, " %s %.2f", RELOAD_STEP_NAMES[i], entry.Time[i]);
+				msg += buffer;
+			}
+			Logger::Get().Log(msg);
+
+			m_history.push_front(entry);
+			if (m_history.size() > RELOAD_PROFILER_HISTORY)
+				m_history.pop_back();
+
+			it = m_pending.erase(it);
+		}
+	}
+	std::deque<ReloadProfiler::Entry> ReloadProfiler::GetHistory()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_history;
+	}
+	void ReloadProfiler::ClearHistory()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_history.clear();
+	}
+	void ReloadProfiler::Clear()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_pending.clear();
+		m_history.clear();
+	}
+	float ReloadProfiler::Elapsed(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <string>
+#include <deque>
+#include <mutex>
+#include <chrono>
+#include <unordered_map>
+
+#define RELOAD_PROFILER_HISTORY 64
+
+namespace ed
+{
+	// time between a shader edit and the first frame that was rendered with the new program, split into the steps of the rebuild
+	// the steps can be reported from the compile workers, everything else is called from the main thread
+	class ReloadProfiler
+	{
+	public:
+		static inline ReloadProfiler& Instance()
+		{
+			static ReloadProfiler ret;
+			return ret;
+		}
+
+		enum Step
+		{
+			FileRead,
+			Includes,
+			Parse,		// glslang parse & link
+			SPIRV,		// SPIR-V generation and optimization
+			Cross,		// SPIRV-Cross
+			GLCompile,
+			GLLink,
+			Reflection, // uniform & texture info, system block bindings
+			StepCount
+		};
+		static const char* GetStepName(int step);
+
+		struct Entry
+		{
+			Entry();
+
+			std::string Item;
+			std::string Trigger;
+			float Time[StepCount]; // milliseconds - stages are preprocessed in parallel so these are summed over the stages
+			float Total;		   // wall time until the end of the first frame
+			bool Cached;		   // the program came from the program cache or from a precompiled variant
+			std::chrono::steady_clock::time_point Origin;
+		};
+
+		// edits that arrive while the item is still being rebuilt are measured from the first one
+		void Begin(const std::string& item, const std::string& trigger, std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now());
+		void Add(const std::string& item, int step, float ms); // ignored if the item isn't being measured
+		void SetCached(const std::string& item);
+		void Finish(const std::string& item); // the item uses the new program from now on
+		void Cancel(const std::string& item); // the build failed, nothing new will be rendered
+		void EndFrame();					  // logs the finished items and moves them to the history
+
+		std::deque<Entry> GetHistory();
+		void ClearHistory();
+		void Clear(); // also drops the items that are being measured
+
+		static float Elapsed(std::chrono::steady_clock::time_point start); // in milliseconds
+
+	private:
+		struct Pending
+		{
+			Pending() : Finished(false) {}
+
+			Entry Data;
+			bool Finished;
+		};
+
+		std::mutex m_mutex;
+		std::unordered_map<std::string, Pending> m_pending;
+		std::deque<Entry> m_history; // newest first
+	};
+}
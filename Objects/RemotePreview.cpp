@@ -0,0 +1,488 @@
+#include "RemotePreview.h"
+#include "Logger.h"
+#include "Settings.h"
+#include "SystemVariableManager.h"
+#include "UIRefresh.h"
+
+#include <stb/stb_image.h>
+#include <stb/stb_image_write.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string.h>
+
+namespace ed
+{
+	static void writeToVector(void* context, void* data, int size)
+	{
+		std::vector<unsigned char>* out = (std::vector<unsigned char>*)context;
+		out->insert(out->end(), (unsigned char*)data, (unsigned char*)data + size);
+	}
+
+	static void writeInput(sf::Packet& packet, const remote::InputState& state)
+	{
+		packet << (sf::Int32)state.Viewport.x << (sf::Int32)state.Viewport.y;
+		packet << state.MousePosition.x << state.MousePosition.y;
+		for (int i = 0; i < 4; i++)
+			packet << state.Mouse[i] << state.MouseButton[i] << (sf::Int8)state.WASD[i];
+		packet << state.Paused << state.FPCamera;
+		for (int i = 0; i < 3; i++)
+			packet << state.CameraRotation[i] << state.CameraPosition[i];
+	}
+	static bool readInput(sf::Packet& packet, remote::InputState& state)
+	{
+		sf::Int32 vw = 0, vh = 0;
+		packet >> vw >> vh;
+		state.Viewport = glm::ivec2(vw, vh);
+		packet >> state.MousePosition.x >> state.MousePosition.y;
+		for (int i = 0; i < 4; i++) {
+			sf::Int8 key = 0;
+			packet >> state.Mouse[i] >> state.MouseButton[i] >> key;
+			state.WASD[i] = key;
+		}
+		packet >> state.Paused >> state.FPCamera;
+		for (int i = 0; i < 3; i++)
+			packet >> state.CameraRotation[i] >> state.CameraPosition[i];
+
+		return (bool)packet;
+	}
+
+	/* SERVER */
+	RemoteServer::RemoteServer()
+	{
+		m_running = false;
+		m_connected = false;
+		m_inFlight = 0;
+		m_receiveThread = nullptr;
+		m_encodeThread = nullptr;
+		m_input = remote::InputState();
+		m_inputChanged = false;
+		m_width = m_height = 0;
+		m_hasFrame = false;
+		m_frameID = 0;
+	}
+	RemoteServer::~RemoteServer()
+	{
+		Stop();
+	}
+	bool RemoteServer::Start(unsigned short port, const std::string& address, const std::string& token)
+	{
+		std::string bind = address.empty() ? "127.0.0.1" : address;
+		sf::IpAddress ip(bind);
+		if (ip == sf::IpAddress::None || m_listener.listen(port, ip) != sf::Socket::Done) {
+			Logger::Get().Log("Failed to listen on " + bind + ":" + std::to_string(port), true);
+			return false;
+		}
+
+		m_token = token;
+		if (m_token.empty()) {
+			static const char hex[] = "0123456789abcdef";
+			std::random_device rd;
+			for (int i = 0; i < 32; i++)
+				m_token += hex[rd() % 16];
+		}
+
+		m_running = true;
+		m_receiveThread = new std::thread(&RemoteServer::m_receive, this);
+		m_encodeThread = new std::thread(&RemoteServer::m_encode, this);
+
+		Logger::Get().Log("Waiting for a remote client on " + bind + ":" + std::to_string(port));
+		if (token.empty())
+			Logger::Get().Log("The clients have to connect with the token " + m_token);
+
+		return true;
+	}
+	void RemoteServer::Stop()
+	{
+		if (!m_running)
+			return;
+
+		m_running = false;
+		m_frameReady.notify_all();
+
+		m_receiveThread->join();
+		m_encodeThread->join();
+		delete m_receiveThread;
+		delete m_encodeThread;
+		m_receiveThread = m_encodeThread = nullptr;
+
+		m_disconnect();
+		m_listener.close();
+	}
+	bool RemoteServer::CanSendFrame()
+	{
+		if (!m_connected || m_inFlight >= REMOTE_FRAMES_IN_FLIGHT)
+			return false;
+
+		std::lock_guard<std::mutex> lock(m_frameMutex);
+		return !m_hasFrame;
+	}
+	void RemoteServer::SendFrame(const unsigned char* pixels, int width, int height)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_frameMutex);
+			m_pixels.assign(pixels, pixels + width * height * 4);
+			m_width = width;
+			m_height = height;
+			m_hasFrame = true;
+		}
+		m_frameReady.notify_one();
+	}
+	bool RemoteServer::GetInput(remote::InputState& state)
+	{
+		std::lock_guard<std::mutex> lock(m_inputMutex);
+		if (!m_inputChanged)
+			return false;
+
+		state = m_input;
+		m_inputChanged = false;
+		return true;
+	}
+	std::vector<remote::FileEdit> RemoteServer::GetEdits()
+	{
+		std::lock_guard<std::mutex> lock(m_inputMutex);
+		std::vector<remote::FileEdit> ret;
+		ret.swap(m_edits);
+		return ret;
+	}
+	void RemoteServer::m_disconnect()
+	{
+		std::lock_guard<std::mutex> lock(m_socketMutex);
+		if (m_connected)
+			Logger::Get().Log("Remote client disconnected");
+		m_socket.disconnect();
+		m_connected = false;
+		m_inFlight = 0;
+	}
+	bool RemoteServer::m_checkHello(sf::Packet& packet)
+	{
+		sf::Uint8 type = 0;
+		std::string token;
+		if (!(packet >> type >> token) || type != (sf::Uint8)remote::Message::Hello || token.size() != m_token.size())
+			return false;
+
+		// the time doesn't depend on how much of the token is right
+		unsigned char diff = 0;
+		for (size_t i = 0; i < token.size(); i++)
+			diff |= token[i] ^ m_token[i];
+		return diff == 0;
+	}
+	void RemoteServer::m_receive()
+	{
+		sf::SocketSelector selector;
+		selector.add(m_listener);
+
+		// a client is accepted first and only connected once it sends the right token
+		bool pending = false;
+		auto acceptTime = std::chrono::steady_clock::now();
+
+		// the timeout lets Stop() end the thread
+		while (m_running) {
+			if (pending && std::chrono::steady_clock::now() - acceptTime > std::chrono::seconds(REMOTE_HELLO_TIMEOUT)) {
+				Logger::Get().Log("Rejected remote client " + m_socket.getRemoteAddress().toString() + ", it didn't send the token", true);
+				selector.remove(m_socket);
+				m_disconnect();
+				pending = false;
+			}
+
+			if (!selector.wait(sf::milliseconds(100)))
+				continue;
+
+			if (selector.isReady(m_listener)) {
+				if (m_connected || pending) {
+					// one client at a time
+					sf::TcpSocket other;
+					if (m_listener.accept(other) == sf::Socket::Done) {
+						Logger::Get().Log("Rejected remote client " + other.getRemoteAddress().toString() + ", another client is connected");
+						other.disconnect();
+					}
+				} else {
+					std::lock_guard<std::mutex> lock(m_socketMutex);
+					if (m_listener.accept(m_socket) == sf::Socket::Done) {
+						m_socket.setBlocking(true);
+						pending = true;
+						acceptTime = std::chrono::steady_clock::now();
+						selector.add(m_socket);
+					}
+				}
+			}
+			else if ((m_connected || pending) && selector.isReady(m_socket)) {
+				sf::Packet packet;
+				if (m_socket.receive(packet) != sf::Socket::Done) {
+					selector.remove(m_socket);
+					m_disconnect();
+					pending = false;
+					continue;
+				}
+
+				if (pending) {
+					pending = false;
+					if (m_checkHello(packet)) {
+						m_connected = true;
+						Logger::Get().Log("Remote client " + m_socket.getRemoteAddress().toString() + " connected");
+					} else {
+						Logger::Get().Log("Rejected remote client " + m_socket.getRemoteAddress().toString() + ", wrong token", true);
+						selector.remove(m_socket);
+						m_disconnect();
+					}
+					continue;
+				}
+
+				sf::Uint8 type = 0;
+				packet >> type;
+
+				if (type == (sf::Uint8)remote::Message::Ack)
+					m_inFlight = std::max(0, m_inFlight.load() - 1);
+				else if (type == (sf::Uint8)remote::Message::Input) {
+					remote::InputState state;
+					if (readInput(packet, state)) {
+						std::lock_guard<std::mutex> lock(m_inputMutex);
+						m_input = state;
+						m_inputChanged = true;
+					}
+				}
+				else if (type == (sf::Uint8)remote::Message::File) {
+					remote::FileEdit edit;
+					if (packet >> edit.Path >> edit.Source) {
+						std::lock_guard<std::mutex> lock(m_inputMutex);
+						m_edits.push_back(edit);
+					}
+				}
+			}
+		}
+	}
+	void RemoteServer::m_encode()
+	{
+		std::vector<unsigned char> jpeg;
+
+		while (true) {
+			{
+				std::unique_lock<std::mutex> lock(m_frameMutex);
+				m_frameReady.wait(lock, [&] { return m_hasFrame || !m_running; });
+				if (!m_running)
+					break;
+			}
+
+			// CanSendFrame() stays false until the frame is sent so m_pixels can be used without the lock -
+			// the rows are bottom up, the client uploads them the same way so the texture matches the one on the server
+			jpeg.clear();
+			stbi_write_jpg_to_func(writeToVector, &jpeg, m_width, m_height, 4, m_pixels.data(), REMOTE_JPEG_QUALITY);
+
+			sf::Packet packet;
+			packet << (sf::Uint8)remote::Message::Frame << m_frameID++ << (sf::Uint16)m_width << (sf::Uint16)m_height;
+			packet.append(jpeg.data(), jpeg.size());
+
+			// a failed send means that the connection is gone, the receiving thread notices that too and disconnects
+			{
+				std::lock_guard<std::mutex> lock(m_socketMutex);
+				if (m_connected) {
+					m_inFlight++;
+					m_socket.send(packet);
+				}
+			}
+
+			std::lock_guard<std::mutex> lock(m_frameMutex);
+			m_hasFrame = false;
+		}
+	}
+
+	/* CLIENT */
+	RemoteClient::RemoteClient()
+	{
+		m_connected = false;
+		m_thread = nullptr;
+		m_size = glm::ivec2(0, 0);
+		m_hasFrame = false;
+		m_frameTime = 0.0f;
+		m_tex = 0;
+		m_texSize = glm::ivec2(0, 0);
+	}
+	RemoteClient::~RemoteClient()
+	{
+		Disconnect();
+	}
+	bool RemoteClient::Connect(const std::string& host, unsigned short port, const std::string& token)
+	{
+		Disconnect();
+
+		sf::IpAddress ip(host);
+		if (ip == sf::IpAddress::None || m_socket.connect(ip, port, sf::seconds(5)) != sf::Socket::Done) {
+			Logger::Get().Log("Failed to connect to the remote renderer " + host + ":" + std::to_string(port), true);
+			return false;
+		}
+
+		// the server drops the connection if the token is wrong
+		sf::Packet hello;
+		hello << (sf::Uint8)remote::Message::Hello << token;
+		if (m_socket.send(hello) != sf::Socket::Done) {
+			Logger::Get().Log("Failed to connect to the remote renderer " + host + ":" + std::to_string(port), true);
+			m_socket.disconnect();
+			return false;
+		}
+
+		m_address = host + ":" + std::to_string(port);
+		m_lastInput.clear();
+		m_connected = true;
+		m_thread = new std::thread(&RemoteClient::m_receive, this);
+
+		Logger::Get().Log("Connected to the remote renderer " + m_address);
+
+		return true;
+	}
+	void RemoteClient::Disconnect()
+	{
+		m_connected = false;
+		if (m_thread != nullptr) {
+			m_thread->join();
+			delete m_thread;
+			m_thread = nullptr;
+		}
+
+		m_socket.disconnect();
+
+		m_hasFrame = false;
+		if (m_tex != 0) {
+			glDeleteTextures(1, &m_tex);
+			m_tex = 0;
+		}
+		m_texSize = glm::ivec2(0, 0);
+	}
+	void RemoteClient::SendInput(const glm::ivec2& viewport, bool paused)
+	{
+		if (!m_connected)
+			return;
+
+		SystemVariableManager& systemVM = SystemVariableManager::Instance();
+
+		remote::InputState state;
+		state.Viewport = viewport;
+		state.MousePosition = systemVM.GetMousePosition();
+		state.Mouse = systemVM.GetMouse();
+		state.MouseButton = systemVM.GetMouseButton();
+		state.WASD = systemVM.GetKeysWASD();
+		state.Paused = paused;
+
+		state.FPCamera = Settings::Instance().Project.FPCamera;
+		state.CameraRotation = systemVM.GetCamera()->GetRotation();
+		if (state.FPCamera)
+			state.CameraPosition = glm::vec3(systemVM.GetCamera()->GetPosition());
+		else
+			state.CameraPosition = glm::vec3(((ArcBallCamera*)systemVM.GetCamera())->GetDistance(), 0.0f, 0.0f);
+
+		sf::Packet packet;
+		packet << (sf::Uint8)remote::Message::Input;
+		writeInput(packet, state);
+
+		const char* data = (const char*)packet.getData();
+		if (m_lastInput.size() == packet.getDataSize() && memcmp(m_lastInput.data(), data, m_lastInput.size()) == 0)
+			return;
+		m_lastInput.assign(data, data + packet.getDataSize());
+
+		m_send(packet);
+	}
+	void RemoteClient::SendFile(const std::string& path, const std::string& source)
+	{
+		if (!m_connected)
+			return;
+
+		sf::Packet packet;
+		packet << (sf::Uint8)remote::Message::File << path << source;
+		m_send(packet);
+	}
+	void RemoteClient::Update()
+	{
+		if (!m_connected && m_tex != 0)
+			Disconnect(); // the server went away
+
+		std::lock_guard<std::mutex> lock(m_frameMutex);
+		if (!m_hasFrame)
+			return;
+		m_hasFrame = false;
+
+		if (m_tex == 0) {
+			glGenTextures(1, &m_tex);
+			glBindTexture(GL_TEXTURE_2D, m_tex);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		} else
+			glBindTexture(GL_TEXTURE_2D, m_tex);
+
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		if (m_texSize != m_size) {
+			m_texSize = m_size;
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_size.x, m_size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, m_pixels.data());
+		} else
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_size.x, m_size.y, GL_RGBA, GL_UNSIGNED_BYTE, m_pixels.data());
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+	bool RemoteClient::m_send(sf::Packet& packet)
+	{
+		std::lock_guard<std::mutex> lock(m_sendMutex);
+		if (m_socket.send(packet) != sf::Socket::Done) {
+			m_connected = false;
+			return false;
+		}
+		return true;
+	}
+	void RemoteClient::m_receive()
+	{
+		sf::SocketSelector selector;
+		selector.add(m_socket);
+
+		auto lastFrame = std::chrono::steady_clock::now();
+
+		while (m_connected) {
+			if (!selector.wait(sf::milliseconds(100)))
+				continue;
+
+			sf::Packet packet;
+			if (m_socket.receive(packet) != sf::Socket::Done) {
+				Logger::Get().Log("Lost the connection to the remote renderer " + m_address, true);
+				m_connected = false;
+				break;
+			}
+
+			sf::Uint8 type = 0;
+			sf::Uint32 id = 0;
+			sf::Uint16 width = 0, height = 0;
+			packet >> type;
+			if (type != (sf::Uint8)remote::Message::Frame || !(packet >> id >> width >> height))
+				continue;
+
+			// acknowledge before decoding so the server can render the next frame in the meantime
+			sf::Packet ack;
+			ack << (sf::Uint8)remote::Message::Ack << id;
+			m_send(ack);
+
+			size_t headerSize = sizeof(type) + sizeof(id) + sizeof(width) + sizeof(height);
+			const unsigned char* jpeg = (const unsigned char*)packet.getData() + headerSize;
+			int jpegSize = packet.getDataSize() - headerSize;
+
+			int w = 0, h = 0, comp = 0;
+			unsigned char* pixels = stbi_load_from_memory(jpeg, jpegSize, &w, &h, &comp, 4);
+			if (pixels == nullptr || w != width || h != height) {
+				stbi_image_free(pixels);
+				continue;
+			}
+
+			{
+				// an older frame that wasn't uploaded yet is simply replaced
+				std::lock_guard<std::mutex> lock(m_frameMutex);
+				m_pixels.assign(pixels, pixels + w * h * 4);
+				m_size = glm::ivec2(w, h);
+				m_hasFrame = true;
+			}
+			stbi_image_free(pixels);
+
+			UIRefresh::Instance().Request(); // the event driven UI would sleep through the new frame
+
+			auto now = std::chrono::steady_clock::now();
+			m_frameTime = std::chrono::duration<float, std::milli>(now - lastFrame).count();
+			lastFrame = now;
+		}
+	}
+}
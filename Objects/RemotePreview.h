@@ -0,0 +1,155 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+#include <glm/glm.hpp>
+#include <SFML/Network.hpp>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/glew.h>
+#if defined(__APPLE__)
+	#include <OpenGL/gl.h>
+#else
+	#include <GL/gl.h>
+#endif
+
+#define REMOTE_DEFAULT_PORT 7310
+#define REMOTE_FRAMES_IN_FLIGHT 2 // frames that were sent but not acknowledged yet - keeps the latency from piling up on slow links
+#define REMOTE_JPEG_QUALITY 85
+#define REMOTE_HELLO_TIMEOUT 5 // seconds that a new client has to send the token in
+
+namespace ed
+{
+	// remote rendering: a GPU workstation runs "SHADERed --serve project.sprj --port 7310" and streams JPEG encoded
+	// preview frames to a SHADERed client that has the same project opened, the client sends back its input
+	// (viewport size, mouse, WASD, camera) and the shaders that it compiles - the client's first message has to carry the
+	// server's token, the server only listens on 127.0.0.1 unless --bind is used
+	namespace remote
+	{
+		enum class Message : sf::Uint8
+		{
+			Hello,	// client -> server: token
+			Frame,  // server -> client: id, width, height, jpeg
+			Ack,	// client -> server: id
+			Input,	// client -> server: InputState
+			File	// client -> server: project relative path, source
+		};
+
+		struct InputState
+		{
+			glm::ivec2 Viewport;
+			glm::vec2 MousePosition;
+			glm::vec4 Mouse, MouseButton;
+			glm::ivec4 WASD;
+			bool Paused;
+
+			bool FPCamera;
+			glm::vec3 CameraRotation;
+			glm::vec3 CameraPosition; // x is the distance for the arc ball camera
+		};
+
+		struct FileEdit
+		{
+			std::string Path, Source;
+		};
+	}
+
+	// used by the HeadlessRenderer - the connection is handled on a separate thread and the frames are encoded on another one
+	class RemoteServer
+	{
+	public:
+		RemoteServer();
+		~RemoteServer();
+
+		bool Start(unsigned short port, const std::string& address = "", const std::string& token = ""); // empty address -> 127.0.0.1, empty token -> a random one is logged
+		void Stop();
+
+		inline bool IsConnected() { return m_connected; }
+		bool CanSendFrame(); // the encoder is idle and the client keeps up
+		void SendFrame(const unsigned char* pixels, int width, int height); // RGBA, the rows are copied
+
+		bool GetInput(remote::InputState& state); // false if nothing changed since the last call
+		std::vector<remote::FileEdit> GetEdits();
+
+	private:
+		void m_receive();
+		void m_encode();
+		void m_disconnect();
+
+		bool m_checkHello(sf::Packet& packet);
+
+		sf::TcpListener m_listener;
+		sf::TcpSocket m_socket;
+		std::string m_token;
+		std::mutex m_socketMutex;
+		std::atomic<bool> m_running, m_connected;
+		std::atomic<int> m_inFlight;
+
+		std::thread* m_receiveThread;
+		std::mutex m_inputMutex;
+		remote::InputState m_input;
+		bool m_inputChanged;
+		std::vector<remote::FileEdit> m_edits;
+
+		std::thread* m_encodeThread;
+		std::mutex m_frameMutex;
+		std::condition_variable m_frameReady;
+		std::vector<unsigned char> m_pixels;
+		int m_width, m_height;
+		bool m_hasFrame;
+		sf::Uint32 m_frameID;
+	};
+
+	// the client side that the PreviewUI uses instead of rendering locally
+	class RemoteClient
+	{
+	public:
+		static inline RemoteClient& Instance()
+		{
+			static RemoteClient ret;
+			return ret;
+		}
+
+		RemoteClient();
+		~RemoteClient();
+
+		bool Connect(const std::string& host, unsigned short port, const std::string& token);
+		void Disconnect();
+		inline bool IsConnected() { return m_connected; }
+		inline const std::string& GetAddress() { return m_address; }
+
+		void SendInput(const glm::ivec2& viewport, bool paused);
+		void SendFile(const std::string& path, const std::string& source);
+
+		void Update(); // uploads the newest frame, has to be called on the main thread
+		inline GLuint GetTexture() { return m_tex; }
+		inline const glm::ivec2& GetSize() { return m_texSize; }
+		inline float GetFrameTime() { return m_frameTime; } // ms between the last two frames that arrived
+
+	private:
+		void m_receive();
+		bool m_send(sf::Packet& packet);
+
+		sf::TcpSocket m_socket;
+		std::mutex m_sendMutex;
+		std::atomic<bool> m_connected;
+		std::string m_address;
+		std::thread* m_thread;
+
+		std::mutex m_frameMutex;
+		std::vector<unsigned char> m_pixels;
+		glm::ivec2 m_size;
+		bool m_hasFrame;
+		std::atomic<float> m_frameTime;
+
+		std::vector<char> m_lastInput; // the same input isn't sent every frame
+
+		GLuint m_tex;
+		glm::ivec2 m_texSize;
+	};
+}
@@ -0,0 +1,146 @@
+#include "RenderDocCapture.h"
+#include "Logger.h"
+#include "UIRefresh.h"
+#include "../Engine/GLUtils.h"
+#include <stdint.h>
+
+#if defined(_WIN32)
+	#include <windows.h>
+	#define RENDERDOC_CC __cdecl
+#elif defined(__linux__) || defined(__unix__)
+	#include <dlfcn.h>
+	#define RENDERDOC_CC
+#else
+	#define RENDERDOC_CC
+#endif
+
+#define RENDERDOC_API_VERSION 10102 // eRENDERDOC_API_Version_1_1_2
+
+namespace ed
+{
+	// same layout as RENDERDOC_API_1_1_2 from renderdoc_app.h - only the functions that we call are typed
+	struct RenderDocCapture::API
+	{
+		void* GetAPIVersion;
+		void* SetCaptureOptionU32;
+		void* SetCaptureOptionF32;
+		void* GetCaptureOptionU32;
+		void* GetCaptureOptionF32;
+		void* SetFocusToggleKeys;
+		void* SetCaptureKeys;
+		void* GetOverlayBits;
+		void* MaskOverlayBits;
+		void* RemoveHooks;
+		void* UnloadCrashHandler;
+		void* SetCaptureFilePathTemplate;
+		void* GetCaptureFilePathTemplate;
+		uint32_t(RENDERDOC_CC* GetNumCaptures)();
+		uint32_t(RENDERDOC_CC* GetCapture)(uint32_t idx, char* filename, uint32_t* pathlength, uint64_t* timestamp);
+		void* TriggerCapture;
+		uint32_t(RENDERDOC_CC* IsTargetControlConnected)();
+		uint32_t(RENDERDOC_CC* LaunchReplayUI)(uint32_t connectTargetControl, const char* cmdline);
+		void* SetActiveWindow;
+		void(RENDERDOC_CC* StartFrameCapture)(void* device, void* wndHandle);
+		uint32_t(RENDERDOC_CC* IsFrameCapturing)();
+		uint32_t(RENDERDOC_CC* EndFrameCapture)(void* device, void* wndHandle);
+	};
+	typedef int(RENDERDOC_CC* RenderDocGetAPIFn)(int version, void** outAPIPointers);
+
+	RenderDocCapture::RenderDocCapture()
+	{
+		m_api = nullptr;
+		m_requested = false;
+	}
+	void RenderDocCapture::Init(bool load)
+	{
+		if (m_api != nullptr)
+			return;
+
+		void* getAPI = nullptr;
+#if defined(_WIN32)
+		HMODULE mod = GetModuleHandleA("renderdoc.dll");
+		if (mod == nullptr && load)
+			mod = LoadLibraryA("renderdoc.dll");
+		if (mod != nullptr)
+			getAPI = (void*)GetProcAddress(mod, "RENDERDOC_GetAPI");
+#elif defined(__linux__) || defined(__unix__)
+		void* mod = dlopen("librenderdoc.so", RTLD_NOW | RTLD_NOLOAD);
+		if (mod == nullptr && load)
+			mod = dlopen("librenderdoc.so", RTLD_NOW);
+		if (mod != nullptr)
+			getAPI = dlsym(mod, "RENDERDOC_GetAPI");
+#endif
+
+		if (getAPI == nullptr) {
+			if (load)
+				Logger::Get().Log("Failed to load the RenderDoc library", true);
+			return;
+		}
+
+		void* api = nullptr;
+		if (((RenderDocGetAPIFn)getAPI)(RENDERDOC_API_VERSION, &api) != 1 || api == nullptr) {
+			Logger::Get().Log("RenderDoc doesn't support API version 1.1.2", true);
+			return;
+		}
+
+		m_api = (API*)api;
+		Logger::Get().Log("Attached to RenderDoc");
+	}
+	void RenderDocCapture::Request()
+	{
+		if (m_api == nullptr) {
+			Logger::Get().Log("RenderDoc isn't loaded - turn it on in Options -> Debug and restart SHADERed", true);
+			return;
+		}
+		m_requested = true;
+		UIRefresh::Instance().Request();
+	}
+	bool RenderDocCapture::BeginFrame()
+	{
+		if (!m_requested || m_api == nullptr)
+			return false;
+		m_requested = false;
+
+		// the driver can't tell where a frame starts when the preview is rendered to a texture, so the capture is explicit
+		m_api->StartFrameCapture(nullptr, nullptr);
+
+		// the capture is useless without the pipeline item groups
+		gl::ForceDebugGroups(true);
+
+		return true;
+	}
+	void RenderDocCapture::EndFrame()
+	{
+		gl::ForceDebugGroups(false);
+
+		if (m_api->EndFrameCapture(nullptr, nullptr) != 1) {
+			Logger::Get().Log("RenderDoc failed to capture the frame", true);
+			return;
+		}
+
+		Logger::Get().Log("Captured a frame with RenderDoc");
+		m_openCapture();
+	}
+	void RenderDocCapture::m_openCapture()
+	{
+		// an already connected replay UI shows the new capture on its own
+		if (m_api->IsTargetControlConnected())
+			return;
+
+		uint32_t count = m_api->GetNumCaptures();
+		if (count == 0)
+			return;
+
+		uint32_t pathLength = 0;
+		if (m_api->GetCapture(count - 1, nullptr, &pathLength, nullptr) != 1 || pathLength == 0)
+			return;
+
+		std::string path(pathLength, '\0');
+		m_api->GetCapture(count - 1, &path[0], &pathLength, nullptr);
+		path.resize(path.find('\0') == std::string::npos ? path.size() : path.find('\0'));
+
+		std::string cmdline = "\"" + path + "\"";
+		if (m_api->LaunchReplayUI(1, cmdline.c_str()) == 0)
+			Logger::Get().Log("Failed to launch the RenderDoc UI - the capture was saved to " + path, true);
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+
+namespace ed
+{
+	// RenderDoc in-app API - captures exactly one RenderEngine::Render() call of the preview
+	// the library has to be loaded before the GL context is created, so Init() is called from main()
+	class RenderDocCapture
+	{
+	public:
+		static inline RenderDocCapture& Instance()
+		{
+			static RenderDocCapture ret;
+			return ret;
+		}
+
+		RenderDocCapture();
+
+		// attaches to an injected renderdoc library, loads it if load == true
+		void Init(bool load);
+
+		inline bool IsAvailable() { return m_api != nullptr; }
+		inline bool IsRequested() { return m_requested; }
+
+		// the capture starts with the next preview frame
+		void Request();
+
+		// called by the RenderEngine - BeginFrame() returns true if this frame is captured
+		bool BeginFrame();
+		void EndFrame();
+
+	private:
+		void m_openCapture();
+
+		struct API;
+		API* m_api;
+		bool m_requested;
+	};
+}
@@ -1,19 +1,49 @@
 #include "RenderEngine.h"
+#include "Frustum.h"
+#include "Hash.h"
+#include "IncludeCache.h"
 #include "Logger.h"
 #include "Settings.h"
 #include "ShaderTranscompiler.h"
 #include "DefaultState.h"
+#include "GLStateCache.h"
 #include "ObjectManager.h"
 #include "PipelineManager.h"
 #include "SystemVariableManager.h"
+#include "FunctionVariableManager.h"
+#include "FrameCache.h"
+#include "Debug/Heatmap.h"
+#include "UIRefresh.h"
+#include "RenderDocCapture.h"
+#include "TextureSharing.h"
+#include "UniformRing.h"
+#include "GeometryGenerator.h"
+#include "ModelSkinner.h"
+#include "ProfilerZones.h"
+#include "FrameProfiler.h"
+#include "TraceRecorder.h"
+#include "PluginAPI/PluginProfiler.h"
 #include "../Engine/GeometryFactory.h"
 #include "../Engine/GLUtils.h"
 #include "../Engine/Ray.h"
 
 #include <algorithm>
+#include <string.h>
+#include <thread>
+#include <chrono>
+#include <regex>
 #include <ghc/filesystem.hpp>
 #include <glm/gtx/intersect.hpp>
 
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+static const GLenum shaderStageTypes[] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER, GL_GEOMETRY_SHADER, GL_COMPUTE_SHADER,
+#ifdef GL_NV_mesh_shader
+	GL_TASK_SHADER_NV, GL_MESH_SHADER_NV
+#endif
+};
 static const GLenum fboBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2, GL_COLOR_ATTACHMENT3, GL_COLOR_ATTACHMENT4, GL_COLOR_ATTACHMENT5, GL_COLOR_ATTACHMENT6, GL_COLOR_ATTACHMENT7, GL_COLOR_ATTACHMENT8, GL_COLOR_ATTACHMENT9, GL_COLOR_ATTACHMENT10, GL_COLOR_ATTACHMENT11, GL_COLOR_ATTACHMENT12, GL_COLOR_ATTACHMENT13, GL_COLOR_ATTACHMENT14, GL_COLOR_ATTACHMENT15 };
 static const char* PixelDebugShaderCode = R"(
 #version 330
@@ -57,9 +87,46 @@ void main()
 }
 )";
 #define DEBUG_ID_START 1
+#define VARIANT_CACHE_SIZE 16 // programs kept per pass for the macro sets that aren't used right now
+#define COMPUTE_TICK_MAX_STEPS 16 // steps of a fixed rate compute pass per frame, a simulation that falls further behind is slowed down
 
 namespace ed
 {
+	static inline GLuint64 getBarrierKey(bool isBuffer, GLuint id)
+	{
+		// textures & buffers have separate names
+		return ((GLuint64)isBuffer << 32) | id;
+	}
+	static uint64_t getConstantsKey(const std::vector<ShaderMacro>& constants)
+	{
+		uint64_t key = ed::HashString("constants");
+		for (const auto& constant : constants)
+			key = ed::HashString(std::string(constant.Name) + "=" + constant.Value, key);
+		return key;
+	}
+	// value of a constant written as a GLSL literal of the declared type, empty for the types that aren't supported
+	static std::string getConstantLiteral(const std::string& value, const std::string& type)
+	{
+		double num = atof(value.c_str());
+
+		if (type == "bool")
+			return num != 0.0 ? "true" : "false";
+		if (type == "int")
+			return std::to_string((int)num);
+		if (type == "uint")
+			return std::to_string((unsigned int)(int)num) + "u";
+		if (type == "float" || type == "double") {
+			char str[64];
+			snprintf(str, sizeof(str), "%.9g", num);
+			std::string ret = str;
+			if (ret.find_first_of(".eni") == std::string::npos)
+				ret += ".0";
+			return ret;
+		}
+
+		return "";
+	}
+
 	RenderEngine::RenderEngine(PipelineManager * pipeline, ObjectManager* objects, ProjectParser* project, MessageStack* msgs, PluginManager* plugins, DebugInformation* debugger) :
 		m_pipeline(pipeline),
 		m_objects(objects),
@@ -72,16 +139,55 @@ namespace ed
 		m_rtColor(0),
 		m_rtDepth(0),
 		m_fbosNeedUpdate(false),
+		m_msSize(0, 0),
+		m_msSamples(0),
+		m_msFormat(0),
+		m_outputShown(-1),
+		m_outputPending(-1),
 		m_computeSupported(true),
-		m_wasMultiPick(false)
+		m_meshShaderSupported(false),
+		m_multiviewSupported(false),
+		m_wasMultiPick(false),
+		m_gpuPickAwaiting(false),
+		m_readFBO(0),
+		m_gpuPickPBO(0),
+		m_gpuPickFence(0),
+		m_costRender(false),
+		m_costTexture(0),
+		m_costMax(0),
+		m_overdrawRender(false),
+		m_overdrawQuads(false),
+		m_overdrawTexture(0),
+		m_overdrawMax(0),
+		m_quadEfficiency(-1.0f),
+		m_variantClock(0),
+		m_compareVersion(-1),
+		m_comparePartial(false),
+		m_compareCapture(false),
+		m_backgroundOnly(false),
+		m_cachedGeneration(0),
+		m_frameDirty(true),
+		m_frameGeneration(0),
+		m_contentGeneration(0),
+		m_frameIndex(0),
+		m_compilePool(eng::JobPriority::Interactive)
 	{
 		m_paused = false;
+		m_itemValueRevision = 0;
 
 		glGenTextures(1, &m_rtColor);
 		glGenTextures(1, &m_rtDepth);
 		glGenTextures(1, &m_rtColorMS);
 		glGenTextures(1, &m_rtDepthMS);
 
+		glGenTextures(RENDER_OUTPUT_BUFFERS, m_outputTex);
+		for (int i = 0; i < RENDER_OUTPUT_BUFFERS; i++) {
+			m_outputFence[i] = 0;
+			m_outputSize[i] = glm::ivec2(0, 0);
+			m_outputFormat[i] = 0;
+		}
+		m_stereoFBO[0] = m_stereoFBO[1] = 0;
+
 		GLchar msg[1024];
 		m_debugPixelShader = gl::CompileShader(GL_FRAGMENT_SHADER, PixelDebugShaderCode);
 		bool psCompiled = gl::CheckShaderCompilationStatus(m_debugPixelShader, msg);
@@ -97,6 +203,88 @@ namespace ed
 		psCompiled = gl::CheckShaderCompilationStatus(m_debugVertexPickShader, msg);
 		if (!psCompiled)
 			Logger::Get().Log("Failed to compile the pixel shader used for getting instance ID.", true);
+
+		// SHADERed_Globals uses the last binding point so that it doesn't collide with the user's UBOs
+		GLint maxBindings = 0;
+		glGetIntegerv(GL_MAX_UNIFORM_BUFFER_BINDINGS, &maxBindings);
+		m_sysBlockBinding = std::max<GLint>(maxBindings, 1) - 1;
+		m_sysBlockValid = false;
+		memset(&m_sysBlockData, 0, sizeof(SystemBlock));
+
+		// same for SHADERed_Batch and the SSBO binding points
+		m_batchSupported = DrawBatchCache::IsSupported();
+		m_batchBinding = 0;
+		if (m_batchSupported) {
+			GLint maxSSBOBindings = 0;
+			glGetIntegerv(GL_MAX_SHADER_STORAGE_BUFFER_BINDINGS, &maxSSBOBindings);
+			m_batchBinding = std::max<GLint>(maxSSBOBindings, 1) - 1;
+		}
+		m_bindlessBinding = -1;
+		if (GLEW_ARB_bindless_texture && GLEW_ARB_shader_storage_buffer_object) {
+			GLint maxSSBOBindings = 0;
+			glGetIntegerv(GL_MAX_SHADER_STORAGE_BUFFER_BINDINGS, &maxSSBOBindings);
+			if (maxSSBOBindings >= 2)
+				m_bindlessBinding = maxSSBOBindings - 2;
+		}
+		if (InstanceCuller::IsSupported()) {
+			GLint maxSSBOBindings = 0;
+			glGetIntegerv(GL_MAX_SHADER_STORAGE_BUFFER_BINDINGS, &maxSSBOBindings);
+			if (maxSSBOBindings >= 5)
+				m_instanceCuller.Init(m_objects, maxSSBOBindings - 5);
+		}
+		m_traceBinding = -1;
+		if (ShaderTrace::IsSupported()) {
+			GLint maxSSBOBindings = 0;
+			glGetIntegerv(GL_MAX_SHADER_STORAGE_BUFFER_BINDINGS, &maxSSBOBindings);
+			if (maxSSBOBindings >= 6)
+				m_traceBinding = maxSSBOBindings - 6;
+		}
+		m_virtualBinding = -1;
+		if (VirtualTexture::IsSupported()) {
+			GLint maxSSBOBindings = 0;
+			glGetIntegerv(GL_MAX_SHADER_STORAGE_BUFFER_BINDINGS, &maxSSBOBindings);
+			if (maxSSBOBindings >= 7)
+				m_virtualBinding = maxSSBOBindings - 7;
+		}
+		if (PassCondition::IsSupported()) {
+			GLint maxSSBOBindings = 0;
+			if (GLEW_ARB_shader_storage_buffer_object)
+				glGetIntegerv(GL_MAX_SHADER_STORAGE_BUFFER_BINDINGS, &maxSSBOBindings);
+			m_condition.Init(maxSSBOBindings >= 9 ? maxSSBOBindings - 9 : -1);
+		}
+
+		m_rtPoolSamples = 0;
+
+		glGenBuffers(1, &m_sysUBO);
+		glBindBuffer(GL_UNIFORM_BUFFER, m_sysUBO);
+		gl::SetObjectLabel(GL_BUFFER, m_sysUBO, "System variables");
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(SystemBlock), NULL, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+		// let the driver compile the shaders on its own threads
+		m_parallelCompile = glewIsSupported("GL_KHR_parallel_shader_compile") || glewIsSupported("GL_ARB_parallel_shader_compile");
+#ifdef GL_NV_mesh_shader
+		m_meshShaderSupported = glewIsSupported("GL_NV_mesh_shader");
+#endif
+#ifdef GL_OVR_multiview2
+		m_multiviewSupported = glewIsSupported("GL_OVR_multiview2");
+#endif
+#ifdef GL_KHR_parallel_shader_compile
+		if (m_parallelCompile && glMaxShaderCompilerThreadsKHR != nullptr)
+			glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+#endif
+
+		m_invalidateSupported = GLEW_VERSION_4_3 || GLEW_ARB_invalidate_subdata;
+
+		m_shadingRateSupported = false;
+		m_shadingRateTexel = glm::ivec2(16, 16);
+#ifdef GL_NV_shading_rate_image
+		m_shadingRateSupported = glewIsSupported("GL_NV_shading_rate_image");
+		if (m_shadingRateSupported) {
+			glGetIntegerv(GL_SHADING_RATE_IMAGE_TEXEL_WIDTH_NV, &m_shadingRateTexel.x);
+			glGetIntegerv(GL_SHADING_RATE_IMAGE_TEXEL_HEIGHT_NV, &m_shadingRateTexel.y);
+		}
+#endif
 	}
 	RenderEngine::~RenderEngine()
 	{
@@ -104,13 +292,61 @@ namespace ed
 		glDeleteTextures(1, &m_rtDepth);
 		glDeleteTextures(1, &m_rtColorMS);
 		glDeleteTextures(1, &m_rtDepthMS);
+		m_clearOutput();
+		glDeleteTextures(RENDER_OUTPUT_BUFFERS, m_outputTex);
+		TextureSharing::Instance().Clear();
+		UniformRing::Instance().Release();
 		glDeleteShader(m_debugPixelShader);
 		glDeleteShader(m_debugVertexPickShader);
 		glDeleteShader(m_debugInstancePickShader);
+		glDeleteBuffers(1, &m_sysUBO);
 		FlushCache();
+		if (m_readFBO != 0)
+			glDeleteFramebuffers(1, &m_readFBO);
+		if (m_stereoFBO[0] != 0)
+			glDeleteFramebuffers(2, m_stereoFBO);
+		if (m_gpuPickPBO != 0)
+			glDeleteBuffers(1, &m_gpuPickPBO);
+		if (m_costTexture != 0)
+			glDeleteTextures(1, &m_costTexture);
+		if (m_overdrawTexture != 0)
+			glDeleteTextures(1, &m_overdrawTexture);
 	}
 	void RenderEngine::Render(int width, int height, bool isDebug)
 	{
+		ED_ZONE("RenderEngine::Render");
+		FrameProfiler::Scope frameScope(FrameProfiler::Render);
+
+		gl::UpdateDebugOutput(m_msgs);
+
+		// a requested RenderDoc capture covers exactly one full frame
+		bool isCapture = !isDebug && !m_comparePartial && RenderDocCapture::Instance().BeginFrame();
+		bool isPreview = !isDebug && !m_comparePartial && !isCapture && !m_backgroundOnly;
+		if (isPreview)
+			m_timeline.AddFrame(SystemVariableManager::Instance().GetFrameIndex());
+
+		// the ID render is overwritten by the actual frame right after it's queued for reading
+		if (!isDebug && !m_comparePartial) {
+			m_gpuPickPoll();
+			if (m_gpuPickAwaiting)
+				m_gpuPickRender(width, height);
+		}
+
+		// m_rtColor already contains this frame
+		if (!isDebug && !isCapture && CanReuseFrame(width, height))
+			return;
+
+		if (!isDebug && !m_comparePartial)
+			m_frameIndex++;
+
+		// the last frame becomes the history of the render textures that keep one, this frame is drawn to the old history
+		if (!isDebug && !m_comparePartial && !m_backgroundOnly)
+			m_objects->SwapRenderTextureHistory();
+
+		// the compared pass is rendered with both versions before the actual frame
+		if (!isDebug && !m_comparePartial && m_compare.IsActive())
+			m_renderComparison(width, height);
+
 		bool isMSAA = (Settings::Instance().Preview.MSAA != 1) && !isDebug;
 
 		if (isMSAA)
@@ -121,23 +357,39 @@ namespace ed
 			m_lastSize = glm::vec2(width, height);
 
 			glBindTexture(GL_TEXTURE_2D, m_rtColor);
+			gl::SetObjectLabel(GL_TEXTURE, m_rtColor, "Window");
 			glTexImage2D(GL_TEXTURE_2D, 0, Settings::Instance().Project.UseAlphaChannel ? GL_RGBA : GL_RGB, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 			glBindTexture(GL_TEXTURE_2D, 0);
 
 			glBindTexture(GL_TEXTURE_2D, m_rtDepth);
+			gl::SetObjectLabel(GL_TEXTURE, m_rtDepth, "Window (depth)");
 			glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, width, height, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 			glBindTexture(GL_TEXTURE_2D, 0);
 
-			glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, m_rtColorMS);
-			glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, Settings::Instance().Preview.MSAA, Settings::Instance().Project.UseAlphaChannel ? GL_RGBA : GL_RGB, width, height, true);
-			
-			glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, m_rtDepthMS);
-			glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, Settings::Instance().Preview.MSAA, GL_DEPTH24_STENCIL8, width, height, true);
-			glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
+			// resizing the preview panel would otherwise reallocate the (large) multisampled storage on every pixel
+			int msSamples = Settings::Instance().Preview.MSAA;
+			GLint msFormat = Settings::Instance().Project.UseAlphaChannel ? GL_RGBA : GL_RGB;
+			if (width > m_msSize.x || height > m_msSize.y || msSamples != m_msSamples || msFormat != m_msFormat) {
+				glm::ivec2 msNeeded(((width + RENDER_MSAA_HEADROOM - 1) / RENDER_MSAA_HEADROOM) * RENDER_MSAA_HEADROOM,
+					((height + RENDER_MSAA_HEADROOM - 1) / RENDER_MSAA_HEADROOM) * RENDER_MSAA_HEADROOM);
+				if (msSamples != m_msSamples || msFormat != m_msFormat)
+					m_msSize = msNeeded;
+				else
+					m_msSize = glm::max(m_msSize, msNeeded);
+				m_msSamples = msSamples;
+				m_msFormat = msFormat;
+
+				glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, m_rtColorMS);
+				glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, msSamples, msFormat, m_msSize.x, m_msSize.y, true);
+
+				glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, m_rtDepthMS);
+				glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, msSamples, GL_DEPTH24_STENCIL8, m_msSize.x, m_msSize.y, true);
+				glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
+			}
 
 			// update
 			std::vector<std::string> objs = m_objects->GetObjects();
@@ -152,52 +404,207 @@ namespace ed
 
 		// cache elements
 		m_cache();
+		m_queueActivatedPasses();
+		m_pollCompileJobs();
+		m_updateRenderTargets(width, height);
 
 		auto& systemVM = SystemVariableManager::Instance();
 
+		// the UI and the plugins could have changed the state since the last frame
+		GLStateCache& glState = GLStateCache::Instance();
+		glState.Invalidate();
+
+		m_slicer.SetBudget(Settings::Instance().Preview.TimeSliceBudget);
+		m_watchdog.SetBudget(Settings::Instance().Preview.PassBudget);
+		bool watched = m_watchdog.IsEnabled() && !isDebug && !m_comparePartial;
+		if (watched)
+			m_pollWatchdog();
+
 		auto& itemVarValues = GetItemVariableValues();
-		GLuint previousTexture[MAX_RENDER_TEXTURES] = { 0 }; // dont clear the render target if we use it two times in a row
-		GLuint previousDepth = 0;
-		bool clearedWindow = false;
+
+		// the shader passes that draw something in this frame
+		std::vector<bool> runs(m_items.size(), false);
+		for (int i = 0; i < m_items.size(); i++)
+			if (m_items[i]->Type == PipelineItem::ItemType::ShaderPass) {
+				pipe::ShaderPass* data = (pipe::ShaderPass*)m_items[i]->Data;
+				runs[i] = data->Active && data->Items.size() > 0 && data->RTCount != 0 && !(isDebug && (data->GSUsed || data->MSUsed)) && m_shaders[i] != 0;
+			}
+
+		// progressive passes start over when anything other than the time changes (the time too if they read it)
+		bool accumulate = !isDebug && !m_comparePartial && !systemVM.IsTiled();
+		if (accumulate) {
+			bool accumulating = false, usesTime = false, usesAudio = false;
+			for (int i = 0; i < m_items.size(); i++) {
+				if (m_items[i]->Type != PipelineItem::ItemType::ShaderPass)
+					continue;
+
+				pipe::ShaderPass* data = (pipe::ShaderPass*)m_items[i]->Data;
+				if (!runs[i] || !data->Accumulate) {
+					m_accumulator.Release(data);
+					continue;
+				}
+
+				accumulating = true;
+				for (ShaderVariable* var : data->Variables.GetVariables()) {
+					usesTime |= var->System == SystemShaderVariable::Time || var->System == SystemShaderVariable::TimeDelta;
+					usesAudio |= var->System == SystemShaderVariable::AudioPosition;
+				}
+			}
+
+			if (accumulating) {
+				uint64_t signature = FrameCache::GetSignature(m_pipeline, this, glm::ivec2(width, height));
+				if (usesTime) {
+					float time = systemVM.GetTime();
+					signature = HashData(&time, sizeof(time), signature);
+				}
+				if (usesAudio) {
+					glm::vec4 audio = systemVM.GetAudioPosition();
+					signature = HashData(&audio, sizeof(audio), signature);
+				}
+				m_accumulator.Validate(signature);
+			}
+		}
+
+		// debug renders keep the user's order - the debug IDs are assigned in it
+		bool reorder = Settings::Instance().Preview.ReorderPasses && !isDebug && !m_comparePartial;
+		if (m_compare.IsActive() && m_compare.GetPass() != nullptr) {
+			pipe::ShaderPass* compareData = (pipe::ShaderPass*)m_compare.GetPass()->Data;
+			m_keepResolved.insert(compareData->RenderTextures, compareData->RenderTextures + compareData->RTCount);
+		}
+		auto writesAllFragments = [&](int index) -> bool {
+			const std::string& ps = m_shaderSources[index].PSCode;
+			return !ps.empty() && ps.find("discard") == std::string::npos && ps.find("gl_FragDepth") == std::string::npos && ps.find("gl_SampleMask") == std::string::npos;
+		};
+		m_scheduler.Build(m_items, runs, m_objects, { m_rtColor, m_rtDepth, m_rtColorMS, m_rtDepthMS }, m_keepResolved, writesAllFragments, reorder);
+		if (reorder)
+			m_reportUnusedPasses();
+		const std::vector<PassScheduler::Pass>& order = m_scheduler.GetOrder();
 		int debugID = DEBUG_ID_START;
+		bool profile = m_profiler.IsEnabled() && !isDebug && !m_comparePartial;
+
+		// the debug renders read the attachments back, a plugin can read any texture
+		bool storeDontCare = !isDebug && m_plugins->Plugins().size() == 0;
+
+		// the debug & comparison renders draw over the render textures, plugins can change anything
+		bool cacheStatic = Settings::Instance().Preview.CacheStaticPasses && !isDebug && !isCapture && !m_comparePartial && !m_backgroundOnly &&
+			!m_compare.IsActive() && !m_tuner.IsRunning() && !m_pickAwaiting && m_plugins->Plugins().size() == 0;
+		if (!cacheStatic)
+			m_staticPasses.clear();
+
+		if (profile)
+			m_profiler.BeginFrame();
+		if (isPreview)
+			m_timeline.DrawFrame(m_profiler, m_items);
+
+		// the records of the previous frames are picked up once the GPU is done with them
+		bool trace = false;
+		if (m_traceBinding != -1 && !m_tracePrograms.empty()) {
+			m_trace.Poll();
+			trace = m_trace.Begin(m_traceBinding) && !isDebug && !m_comparePartial;
+		}
 
-		m_plugins->BeginRender();
+		if (!m_comparePartial)
+			m_plugins->BeginRender();
 
-		for (int i = 0; i < m_items.size(); i++) {
+		// before any pass binds its own buffers
+		m_generateGeometry(isDebug);
+		m_skinModels(isDebug);
+
+		for (int n = 0; n < order.size(); n++) {
+			const PassScheduler::Pass& scheduled = order[n];
+			int i = scheduled.Index;
 			PipelineItem* it = m_items[i];
 
+			ED_ZONE("Pipeline item");
+			ED_ZONE_TEXT(std::string(it->Name));
+			ED_GPU_ZONE("Pipeline item");
+			gl::DebugGroup debugGroup(it->Name);
+
+			// partial frames only draw the passes that the compared pass could depend on
+			if (m_comparePartial && it->Type != PipelineItem::ItemType::ShaderPass)
+				continue;
+			if (m_backgroundOnly && !m_isBackgroundPass(it))
+				continue;
+
 			if (it->Type == PipelineItem::ItemType::ShaderPass) {
 				pipe::ShaderPass* data = (pipe::ShaderPass*)it->Data;
 
-				if (!data->Active || data->Items.size() <= 0 || data->RTCount == 0 || (isDebug && data->GSUsed))
+				if (!data->Active || data->Items.size() <= 0 || data->RTCount == 0 || (isDebug && (data->GSUsed || data->MSUsed || data->Multiview)))
 					continue;
 
-				const std::vector<GLuint>& srvs = m_objects->GetBindList(m_items[i]);
-				const std::vector<GLuint>& ubos = m_objects->GetUniformBindList(m_items[i]);
+				if (!isDebug)
+					m_checkConstants(it);
+
+				const std::vector<BindingDescriptor>& srvs = m_objects->GetBindTable(m_items[i]);
+				const std::vector<BindingDescriptor>& ubos = m_objects->GetUniformBindTable(m_items[i]);
 
 				// create/update fbo if necessary
-				m_updatePassFBO(data);
+				m_updatePassFBO(data, it->Name);
 
 				if (m_shaders[i] == 0)
 					continue;
 
-				// bind fbo and buffers
-				glBindFramebuffer(GL_FRAMEBUFFER, isMSAA ? m_fboMS[data] : data->FBO);
+				// cubemaps & texture arrays are drawn as they are, the helpers only work with 2D textures
+				bool layered = m_isLayeredPass(data);
+
+				// converged - the average is shown instead of drawing more samples
+				bool accumulated = accumulate && data->Accumulate && !layered;
+				if (accumulated && m_accumulator.IsDone(data)) {
+					m_accumulator.Restore(data);
+					continue;
+				}
+
+				// the render textures still have what the pass would draw now - the traced passes print every frame
+				if (cacheStatic && m_tracePrograms.count(m_shaders[i]) == 0 && m_isPassCached(i, width, height))
+					continue;
+
+				m_barrierRead(it, srvs, ubos);
+
+				if (profile)
+					m_profiler.Begin(it, it->Name, GPUProfiler::CounterSet::Graphics);
+				if (watched)
+					m_watchdog.Begin(it);
+
+				bool compared = m_compareVersion >= 0 && it == m_compare.GetPass();
+				if (compared)
+					m_compare.Begin(m_compareVersion);
+
+				// the reduced resolution copies aren't multisampled, the debugger & the comparison work with the full size
+				bool reduced = data->ResolutionScale > 1 && !isDebug && !accumulated && !compared && !layered;
+				if (data->ResolutionScale <= 1)
+					m_reduced.Release(data);
+
+				// the clears, draws & the resolve are dropped by the GPU while the pass' condition is 0 - the targets keep their contents
+				bool conditioned = data->ConditionBuffer != nullptr && m_condition.IsReady();
+				if (conditioned)
+					m_condition.BeginDraw((BufferObject*)data->ConditionBuffer, data->ConditionOffset);
+
+				// bind fbo and buffers - full screen passes can opt out of MSAA
+				bool passMSAA = isMSAA && data->Multisample && !reduced && !layered;
+				glBindFramebuffer(GL_FRAMEBUFFER, passMSAA ? m_fboMS[data] : data->FBO);
 				glDrawBuffers(data->RTCount, fboBuffers);
 
-				// clear depth texture
-				if (data->DepthTexture != previousDepth) {
-					if ((data->DepthTexture == m_rtDepth && !clearedWindow) || data->DepthTexture != m_rtDepth) {
-						glStencilMask(0xFFFFFFFF);
-						glClearBufferfi(GL_DEPTH_STENCIL, 0, 1.0f, 0);
-					}
+				// the pass draws over every pixel - the old contents don't have to be loaded, the overdraw heatmap needs the clear though
+				unsigned int clearMask = scheduled.Clear | (isDebug ? scheduled.Invalidate : 0);
+				if (!isDebug && scheduled.Invalidate != 0 && m_invalidateSupported && !conditioned) {
+					GLenum attachments[MAX_RENDER_TEXTURES];
+					GLsizei attachmentCount = 0;
+					for (int j = 0; j < data->RTCount; j++)
+						if (scheduled.Invalidate & (1u << j))
+							attachments[attachmentCount++] = GL_COLOR_ATTACHMENT0 + j;
+					glInvalidateFramebuffer(GL_FRAMEBUFFER, attachmentCount, attachments);
+				}
 
-					previousDepth = data->DepthTexture;
+				// clear depth texture (the scheduler decides the clears in the user's order)
+				if (scheduled.ClearDepth) {
+					glState.StencilMask(0xFFFFFFFF);
+					glClearBufferfi(GL_DEPTH_STENCIL, 0, 1.0f, 0);
 				}
 
 				// bind RTs
 				int rtCount = MAX_RENDER_TEXTURES;
 				glm::vec2 rtSize(width, height);
+				bool windowSized = true;
 				for (int i = 0; i < MAX_RENDER_TEXTURES; i++) {
 					if (data->RenderTextures[i] == 0) {
 						rtCount = i;
@@ -210,59 +617,76 @@ namespace ed
 						ed::RenderTextureObject* rtObject = m_objects->GetRenderTexture(rt);
 
 						rtSize = rtObject->CalculateSize(width, height);
+						windowSized = rtObject->FixedSize.x == -1;
 
 						// clear and bind rt (only if not used in last shader pass)
-						bool usedPreviously = false;
-						for (int j = 0; j < MAX_RENDER_TEXTURES; j++)
-							if (previousTexture[j] == rt) {
-								usedPreviously = true;
-								break;
-							}
-						if (!usedPreviously && rtObject->Clear)
-							glClearBufferfv(GL_COLOR, i, isDebug ? glm::value_ptr(glm::vec4(0.0f)) : glm::value_ptr(rtObject->ClearColor));
+						if (clearMask & (1u << i))
+							glClearBufferfv(GL_COLOR, i, (isDebug && !m_costRender && !m_overdrawRender) ? glm::value_ptr(glm::vec4(0.0f)) : glm::value_ptr(rtObject->ClearColor));
 
 					}
-					else if (!clearedWindow) {
+					else if (clearMask & (1u << i))
 						glClearBufferfv(GL_COLOR, i, isDebug ? glm::value_ptr(glm::vec4(0.0f)) : glm::value_ptr(Settings::Instance().Project.ClearColor));
-
-						clearedWindow = true;
-					}
 				}
-				for (int i = 0; i < data->RTCount; i++)
-					previousTexture[i] = data->RenderTextures[i];
 
-				// update viewport value
+				// draw to the smaller copies, they start with what the render textures have after the clears
+				glm::vec2 fullSize = rtSize;
+				if (reduced)
+					rtSize = m_reduced.Begin(data, glm::ivec2(rtSize));
+
+				// update viewport value, fixed size render textures always get the whole image when rendering in tiles
+				systemVM.EnableTile(windowSized);
 				systemVM.SetViewportSize(rtSize.x, rtSize.y);
+				systemVM.SetSampleIndex(accumulated ? m_accumulator.GetSampleCount(data) : 0);
 				glViewport(0, 0, rtSize.x, rtSize.y);
 
 				// bind shaders
-
+				GLuint program = m_shaders[i];
+				bool overdraw = false;
 				if (isDebug) {
-					data->Variables.UpdateUniformInfo(m_debugShaders[i]);
-					glUseProgram(m_debugShaders[i]);
-				} else
-					glUseProgram(m_shaders[i]);
+					program = m_debugShaders[i];
+
+					// passes that don't draw to the window keep their output so that the later passes read the same data
+					if (m_costRender) {
+						program = m_getCostShader(i);
+						if (program == 0)
+							program = m_shaders[i];
+					}
+					else if (m_overdrawRender) {
+						program = m_getOverdrawShader(i);
+						overdraw = program != 0;
+						if (program == 0)
+							program = m_shaders[i];
+					}
+
+					data->Variables.UpdateUniformInfo(program);
+				}
+				else if (compared && m_compareVersion == 1) {
+					program = m_compare.GetProgram();
+					data->Variables.UpdateUniformInfo(program);
+				}
+				glUseProgram(program);
 
 				// bind shader resource views
 				for (int j = 0; j < srvs.size(); j++) {
 					glActiveTexture(GL_TEXTURE0 + j);
-					if (m_objects->IsCubeMap(srvs[j]))
-						glBindTexture(GL_TEXTURE_CUBE_MAP, srvs[j]);
-					else if (m_objects->IsImage3D(srvs[j]))
-						glBindTexture(GL_TEXTURE_3D, srvs[j]);
-					else if (m_objects->IsPluginObject(srvs[j])) {
-						PluginObject* pobj = m_objects->GetPluginObject(srvs[j]);
+					if (srvs[j].Type == BindingDescriptor::BindType::Plugin) {
+						PluginObject* pobj = srvs[j].Plugin;
+						PluginProfiler::Scope profile(pobj->Owner, PluginProfiler::BindObject);
 						pobj->Owner->BindObject(pobj->Type, pobj->Data, pobj->ID);
 					}
 					else
-						glBindTexture(GL_TEXTURE_2D, srvs[j]);
+						glBindTexture(srvs[j].Target, srvs[j].ID);
+					glState.BindSampler(j, srvs[j].Sampler);
 
 					if (ShaderTranscompiler::GetShaderTypeFromExtension(data->PSPath) == ShaderLanguage::GLSL) // TODO: or should this be for vulkan glsl too?
-						data->Variables.UpdateTexture(m_shaders[i], j);
+						data->Variables.UpdateTexture(program, j);
 				}
 
 				for (int j = 0; j < ubos.size(); j++)
-					glBindBufferBase(GL_UNIFORM_BUFFER, j, ubos[j]);
+					glBindBufferBase(GL_UNIFORM_BUFFER, j, ubos[j].ID);
+
+				// built-in SHADERed_Globals block
+				m_updateSystemBlock();
 				
 				// clear messages
 				//if (m_msgs->GetGroupWarningMsgCount(it->Name) > 0)
@@ -270,158 +694,358 @@ namespace ed
 
 				// bind default states for each shader pass
 				DefaultState::Bind();
+				if (overdraw)
+					m_bindOverdrawState(data);
+
+				// the debugger & the heatmaps need every pixel
+				bool coarseShading = !isDebug && m_bindShadingRate(data);
+
+				// every item is written to the capture buffer - the debug & comparison programs aren't linked with the outputs
+				GLint captureVaryings = 0;
+				if (data->CaptureBuffer != nullptr && !data->MSUsed && !isDebug && program == m_shaders[i] && VertexCapture::IsSupported())
+					glGetProgramiv(program, GL_TRANSFORM_FEEDBACK_VARYINGS, &captureVaryings);
+				bool capturing = captureVaryings > 0;
+
+				// the batches can mix the topologies, a capture only takes triangles
+				bool batched = !isDebug && m_batchSupported && m_batchPrograms.count(program) > 0 && !data->MSUsed && !capturing;
+
+				// mesh shader passes launch the workgroups for each mesh of their models
+				GLint meshletCountLoc = data->MSUsed ? glGetUniformLocation(program, "SHADERed_MeshletCount") : -1;
+				BufferObject* meshTasks = data->MSUsed ? (BufferObject*)data->MeshTaskBuffer : nullptr;
+				if (meshTasks != nullptr)
+					glBindBuffer(GL_DRAW_INDIRECT_BUFFER, meshTasks->ID);
+
+				// skip the items outside of the camera's view - the captured vertices are drawn by the other passes from other views
+				bool frustumCull = !isDebug && !m_comparePartial && m_usesCamera(data) && !capturing;
+				glm::mat4 viewProj = systemVM.GetProjectionMatrix() * systemVM.GetViewMatrix();
+				Frustum frustum;
+				if (frustumCull)
+					frustum.Set(viewProj);
+				bool instanceCull = frustumCull && m_instanceCuller.IsReady();
+
+				// the depth buffer already has the nearest opaque surfaces, the pass' pixel shader only runs for them - LEQUAL instead
+				// of EQUAL because the two programs aren't guaranteed to compute bit-identical positions
+				bool prepassed = !isDebug && !compared && data->DepthPrepass && !data->MSUsed && m_drawDepthPrepass(i, width, height);
+				if (prepassed) {
+					data->Variables.UpdateUniformInfo(program);
+					glUseProgram(program);
+					DefaultState::Bind();
+				}
 
-				// render pipeline items
-				for (int j = 0; j < data->Items.size(); j++) {
-					PipelineItem* item = data->Items[j];
+				if (capturing)
+					m_capture.Begin((BufferObject*)data->CaptureBuffer);
+
+				// heavy passes are drawn in bands that are each waited for, every band starts from the pass' default state
+				bool timeSliced = m_slicer.IsEnabled() && !isDebug && !m_pickAwaiting && !m_comparePartial && !compared && !capturing;
+				int slices = timeSliced ? m_slicer.GetSliceCount(it, (int)rtSize.y) : 1;
+				for (int slice = 0; slice < slices; slice++) {
+					if (slices > 1) {
+						int bandStart = (int)rtSize.y * slice / slices, bandEnd = (int)rtSize.y * (slice + 1) / slices;
+						glEnable(GL_SCISSOR_TEST);
+						glScissor(0, bandStart, (int)rtSize.x, bandEnd - bandStart);
+						if (slice > 0)
+							DefaultState::Bind();
+					}
+					if (prepassed)
+						glState.DepthFunc(GL_LEQUAL);
+					if (timeSliced)
+						m_slicer.BeginSlice();
+
+					// render pipeline items
+					GLuint meshTaskOffset = data->MeshTaskOffset;
+					const DrawList& drawList = m_getDrawList(data);
+					for (int j = 0; j < drawList.Commands.size(); j++) {
+						const DrawCommand& cmd = drawList.Commands[j];
+						PipelineItem* item = cmd.Item;
+						gl::DebugGroup itemGroup(item->Name);
+
+						// merge the following geometry items into one draw call
+						if (batched) {
+							int batchLength = m_getBatchLength(data->Items, j);
+							if (batchLength > 1) {
+								m_drawBatch(it, j, batchLength, width, height);
+								j += batchLength - 1;
+								continue;
+							}
+						}
 
-					systemVM.SetPicked(false);
+						systemVM.SetPicked(false);
 
-					// update the value for this element and check if we picked it
-					if (item->Type == PipelineItem::ItemType::Geometry || item->Type == PipelineItem::ItemType::Model) {
-						if (m_pickAwaiting) m_pickItem(item, m_wasMultiPick);
-						for (int k = 0; k < itemVarValues.size(); k++)
-							if (itemVarValues[k].Item == item)
-								itemVarValues[k].Variable->Data = itemVarValues[k].NewValue->Data;
-
-						if (isDebug) {
-							float r = (debugID & 0x000000FF) / 255.0f;
-							float g = ((debugID & 0x0000FF00) >> 8) / 255.0f;
-							float b = ((debugID & 0x00FF0000) >> 16) / 255.0f;
-							glUniform3f(glGetUniformLocation(m_debugShaders[i], "_sed_dbg_pixel_color"), r, g, b);
-							debugID++;
+						bool profileItem = profile && slices == 1 && cmd.Type != PipelineItem::ItemType::RenderState;
+						if (profileItem)
+							m_profiler.Begin(item, item->Name);
+
+						// update the value for this element and check if we picked it
+						if (cmd.Type == PipelineItem::ItemType::Geometry || cmd.Type == PipelineItem::ItemType::Model) {
+							if (m_pickAwaiting) m_pickItem(item, m_wasMultiPick);
+							for (int k = cmd.ValueStart; k < cmd.ValueStart + cmd.ValueCount; k++)
+								itemVarValues[drawList.Values[k]].Variable->Data = itemVarValues[drawList.Values[k]].NewValue->Data;
+
+							if (isDebug) {
+								float r = (debugID & 0x000000FF) / 255.0f;
+								float g = ((debugID & 0x0000FF00) >> 8) / 255.0f;
+								float b = ((debugID & 0x00FF0000) >> 16) / 255.0f;
+								glUniform3f(data->Variables.GetDebugColorLocation(), r, g, b);
+								debugID++;
+							}
 						}
-					}
 
-					if (item->Type == PipelineItem::ItemType::Geometry) {
-						pipe::GeometryItem* geoData = reinterpret_cast<pipe::GeometryItem*>(item->Data);
+						if (cmd.Type == PipelineItem::ItemType::Geometry && data->MSUsed) {
+							// only the models have meshlets
+						}
+						else if (cmd.Type == PipelineItem::ItemType::Model && data->MSUsed) {
+							pipe::Model* objData = reinterpret_cast<pipe::Model*>(cmd.Data);
+
+							systemVM.SetPicked(cmd.Picked);
+							systemVM.SetGeometryTransform(item, objData->Scale, objData->Rotation, objData->Position);
+							data->Variables.Bind(item);
+
+							if (meshTasks == nullptr)
+								objData->Data->DrawMeshlets(data->MeshletsPerTask, meshletCountLoc);
+							else {
+								for (auto& mesh : objData->Data->Meshes) {
+									if (meshTaskOffset + sizeof(GLuint) * 2 > meshTasks->Size)
+										break;
+									mesh.DrawMeshletsIndirect(meshTaskOffset, meshletCountLoc);
+									meshTaskOffset += sizeof(GLuint) * 2;
+								}
+							}
+						}
+						else if (cmd.Type == PipelineItem::ItemType::Geometry) {
+							pipe::GeometryItem* geoData = reinterpret_cast<pipe::GeometryItem*>(cmd.Data);
+
+							m_setGeometryTransform(item, geoData, width, height);
 
-						if (geoData->Type == pipe::GeometryItem::Rectangle) {
-							// TODO: don't multiply with m_renderer->GetLastRenderSize() but rather with actual RT size
-							glm::vec3 scaleRect(geoData->Scale.x * width, geoData->Scale.y * height, 1.0f);
-							glm::vec3 posRect((geoData->Position.x + 0.5f) * width, (geoData->Position.y + 0.5f) * height, -1000.0f);
-							systemVM.SetGeometryTransform(item, scaleRect, geoData->Rotation, posRect);
-						} else
-							systemVM.SetGeometryTransform(item, geoData->Scale, geoData->Rotation, geoData->Position);
+							systemVM.SetPicked(cmd.Picked);
 
-						systemVM.SetPicked(std::count(m_pick.begin(), m_pick.end(), item));
+							// bind variables
+							data->Variables.Bind(item);
 
-						// bind variables
-						data->Variables.Bind(item);
+							glm::vec3 halfSize;
+							bool visible = !frustumCull || !geoData->FrustumCulling || geoData->Instanced ||
+								!eng::GeometryFactory::GetHalfSize(geoData->Type, geoData->Size, halfSize) ||
+								frustum.Intersects(systemVM.GetGeometryTransform(item), -halfSize, halfSize);
 
-						glBindVertexArray(geoData->VAO);
-						if (geoData->Instanced)
-							glDrawArraysInstanced(geoData->Topology, 0, eng::GeometryFactory::VertexCount[geoData->Type], geoData->InstanceCount);
-						else
-							glDrawArrays(geoData->Topology, 0, eng::GeometryFactory::VertexCount[geoData->Type]);
-					}
-					else if (item->Type == PipelineItem::ItemType::Model) {
-						pipe::Model* objData = reinterpret_cast<pipe::Model*>(item->Data);
+							bool occlusion = geoData->OcclusionCulling && !isDebug && !m_comparePartial && slices == 1 && !capturing, occlusionTest = false;
+							if (visible && (!occlusion || m_beginOcclusionQuery(item, occlusionTest))) {
+								if (!geoData->Instanced || !instanceCull || !geoData->GPUCulling || geoData->Type == pipe::GeometryItem::Captured || !m_instanceCuller.Draw(item, data->InputLayout, systemVM.GetGeometryTransform(item), viewProj, program))
+									m_drawGeometry(geoData);
 
-						systemVM.SetPicked(std::count(m_pick.begin(), m_pick.end(), item));
-						systemVM.SetGeometryTransform(item, objData->Scale, objData->Rotation, objData->Position);
+								if (occlusionTest)
+									glEndQuery(GL_ANY_SAMPLES_PASSED);
+							}
+						}
+						else if (cmd.Type == PipelineItem::ItemType::Model) {
+							pipe::Model* objData = reinterpret_cast<pipe::Model*>(cmd.Data);
 
-						// bind variables
-						data->Variables.Bind(item);
+							systemVM.SetPicked(cmd.Picked);
+							systemVM.SetGeometryTransform(item, objData->Scale, objData->Rotation, objData->Position);
 
-						objData->Data->Draw(objData->Instanced, objData->InstanceCount);
-					}
-					else if (item->Type == PipelineItem::ItemType::RenderState) {
-						pipe::RenderState* state = reinterpret_cast<pipe::RenderState*>(item->Data);
-						
-						// depth clamp
-						if (state->DepthClamp)
-							glEnable(GL_DEPTH_CLAMP);
-						else
-							glDisable(GL_DEPTH_CLAMP);
-
-						// fill mode
-						glPolygonMode(GL_FRONT_AND_BACK, state->PolygonMode);
-
-						// culling and front face
-						if (state->CullFace)
-							glEnable(GL_CULL_FACE);
-						else
-							glDisable(GL_CULL_FACE);
-						glCullFace(state->CullFaceType);
-						glFrontFace(state->FrontFace);
-
-						// disable blending
-						if (state->Blend) {
-							glEnable(GL_BLEND);
-							glBlendEquationSeparate(state->BlendFunctionColor, state->BlendFunctionAlpha);
-							glBlendFuncSeparate(state->BlendSourceFactorRGB, state->BlendDestinationFactorRGB, state->BlendSourceFactorAlpha, state->BlendDestinationFactorAlpha);
-							glBlendColor(state->BlendFactor.r, state->BlendFactor.g, state->BlendFactor.a, state->BlendFactor.a);
-							glSampleCoverage(state->AlphaToCoverage, GL_FALSE);
+							// bind variables
+							data->Variables.Bind(item);
+
+							bool visible = !frustumCull || !objData->FrustumCulling || objData->Instanced || objData->Data->IsSkinned() || // the bounds are the bind pose's
+								frustum.Intersects(systemVM.GetGeometryTransform(item), objData->Data->GetMinBound(), objData->Data->GetMaxBound());
+
+							if (objData->Instanced && instanceCull && objData->GPUCulling) {
+								int lod = m_pickModelLOD(item, objData);
+								if (!m_instanceCuller.Draw(item, data->InputLayout, systemVM.GetGeometryTransform(item), viewProj, program, lod))
+									objData->Data->Draw(true, objData->InstanceCount, lod);
+							} else if (visible)
+								objData->Data->Draw(objData->Instanced, objData->InstanceCount, m_pickModelLOD(item, objData));
 						}
-						else
-							glDisable(GL_BLEND);
-
-						// depth state
-						if (state->DepthTest)
-							glEnable(GL_DEPTH_TEST);
-						else
-							glDisable(GL_DEPTH_TEST);
-						glDepthMask(state->DepthMask);
-						glDepthFunc(state->DepthFunction);
-						glPolygonOffset(0.0f, state->DepthBias);
-
-						// stencil
-						if (state->StencilTest) {
-							glEnable(GL_STENCIL_TEST);
-							glStencilFuncSeparate(GL_FRONT, state->StencilFrontFaceFunction, 1, state->StencilReference);
-							glStencilFuncSeparate(GL_BACK, state->StencilBackFaceFunction, 1, state->StencilReference);
-							glStencilMask(state->StencilMask);
-							glStencilOpSeparate(GL_FRONT, state->StencilFrontFaceOpStencilFail, state->StencilFrontFaceOpDepthFail, state->StencilFrontFaceOpPass);
-							glStencilOpSeparate(GL_BACK, state->StencilBackFaceOpStencilFail, state->StencilBackFaceOpDepthFail, state->StencilBackFaceOpPass);
+						else if (cmd.Type == PipelineItem::ItemType::RenderState) {
+							pipe::RenderState* state = reinterpret_cast<pipe::RenderState*>(cmd.Data);
+						
+							// depth clamp
+							glState.Enable(GL_DEPTH_CLAMP, state->DepthClamp);
+
+							// fill mode
+							glState.PolygonMode(state->PolygonMode);
+
+							// culling and front face
+							glState.Enable(GL_CULL_FACE, state->CullFace);
+							glState.CullFace(state->CullFaceType);
+							glState.FrontFace(state->FrontFace);
+
+							// disable blending
+							glState.Enable(GL_BLEND, state->Blend);
+							if (state->Blend) {
+								glState.BlendEquationSeparate(state->BlendFunctionColor, state->BlendFunctionAlpha);
+								glState.BlendFuncSeparate(state->BlendSourceFactorRGB, state->BlendDestinationFactorRGB, state->BlendSourceFactorAlpha, state->BlendDestinationFactorAlpha);
+								glState.BlendColor(state->BlendFactor.r, state->BlendFactor.g, state->BlendFactor.a, state->BlendFactor.a);
+								glState.SampleCoverage(state->AlphaToCoverage, GL_FALSE);
+							}
+
+							// depth state
+							glState.Enable(GL_DEPTH_TEST, state->DepthTest);
+							glState.DepthMask(state->DepthMask);
+							glState.DepthFunc(state->DepthFunction);
+							glState.PolygonOffset(0.0f, state->DepthBias);
+							if (prepassed && state->DepthFunction == GL_LESS)
+								glState.DepthFunc(GL_LEQUAL);
+
+							// stencil
+							glState.Enable(GL_STENCIL_TEST, state->StencilTest);
+							if (state->StencilTest) {
+								glState.StencilFuncSeparate(GL_FRONT, state->StencilFrontFaceFunction, 1, state->StencilReference);
+								glState.StencilFuncSeparate(GL_BACK, state->StencilBackFaceFunction, 1, state->StencilReference);
+								glState.StencilMask(state->StencilMask);
+								glState.StencilOpSeparate(GL_FRONT, state->StencilFrontFaceOpStencilFail, state->StencilFrontFaceOpDepthFail, state->StencilFrontFaceOpPass);
+								glState.StencilOpSeparate(GL_BACK, state->StencilBackFaceOpStencilFail, state->StencilBackFaceOpDepthFail, state->StencilBackFaceOpPass);
+							}
+
+							// the depth & stencil tests still decide which fragments are counted
+							if (overdraw)
+								m_bindOverdrawState(data);
 						}
-						else
-							glDisable(GL_STENCIL_TEST);
-					}
-					else if (item->Type == PipelineItem::ItemType::PluginItem) {
-						pipe::PluginItemData* pldata = reinterpret_cast<pipe::PluginItemData*>(item->Data);
+						else if (cmd.Type == PipelineItem::ItemType::PluginItem) {
+							pipe::PluginItemData* pldata = reinterpret_cast<pipe::PluginItemData*>(cmd.Data);
 
-						if (m_pickAwaiting && pldata->Owner->IsPipelineItemPickable(pldata->Type))
-							m_pickItem(item, m_wasMultiPick);
+							if (m_pickAwaiting && pldata->Owner->IsPipelineItemPickable(pldata->Type))
+								m_pickItem(item, m_wasMultiPick);
 
-						if (pldata->Owner->IsPipelineItemPickable(pldata->Type))
-							systemVM.SetPicked(std::count(m_pick.begin(), m_pick.end(), item));
-						else
-							systemVM.SetPicked(false);
+							systemVM.SetPicked(cmd.Picked && pldata->Owner->IsPipelineItemPickable(pldata->Type));
 
-						pldata->Owner->ExecutePipelineItem(data, plugin::PipelineItemType::ShaderPass, pldata->Type, pldata->PluginData);
+							// the plugin can bind anything
+							m_capture.Pause();
+							{
+								PluginProfiler::Scope profile(pldata->Owner, PluginProfiler::Execute);
+								pldata->Owner->ExecutePipelineItem(data, plugin::PipelineItemType::ShaderPass, pldata->Type, pldata->PluginData);
+							}
+							m_capture.Resume();
+							glState.Invalidate();
+						}
+
+						if (profileItem)
+							m_profiler.End(item);
+
+						// set the old value back
+						for (int k = cmd.ValueStart; k < cmd.ValueStart + cmd.ValueCount; k++)
+							itemVarValues[drawList.Values[k]].Variable->Data = itemVarValues[drawList.Values[k]].OldValue;
 					}
 
-					// set the old value back
-					if (item->Type == PipelineItem::ItemType::Geometry || item->Type == PipelineItem::ItemType::Model)
-						for (int k = 0; k < itemVarValues.size(); k++)
-							if (itemVarValues[k].Item == item)
-								itemVarValues[k].Variable->Data = itemVarValues[k].OldValue;
+					if (timeSliced)
+						m_slicer.EndSlice(it);
 				}
-
-				if (isDebug)
+				m_capture.End();
+				if (slices > 1)
+					glDisable(GL_SCISSOR_TEST);
+				if (timeSliced)
+					m_slicer.EndItem(it);
+				if (meshTasks != nullptr)
+					glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+				if (isDebug || program != m_shaders[i])
 					data->Variables.UpdateUniformInfo(m_shaders[i]); // return old variable data
 
-				if (isMSAA) {
+				if (overdraw)
+					glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+				if (coarseShading)
+					m_unbindShadingRate();
+
+				if (reduced) {
+					m_reduced.End(data);
+					rtSize = fullSize;
+				}
+
+				// the next pass draws to the same multisampled attachments (the accumulation needs this pass' samples though)
+				if (passMSAA && (scheduled.Resolve || accumulated)) {
 					glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fboMS[data]);
 					glBindFramebuffer(GL_DRAW_FRAMEBUFFER, data->FBO);
 					glDrawBuffer(GL_BACK);
 					for (unsigned int i = 0; i < data->RTCount; i++)
 					{
+						// nothing samples or shows the texture
+						if (storeDontCare && (scheduled.Unsampled & (1u << i)))
+							continue;
+
 						glReadBuffer(GL_COLOR_ATTACHMENT0 + i);
 						glDrawBuffer(GL_COLOR_ATTACHMENT0 + i);
 						glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
 					}
 				}
+
+				if (conditioned)
+					m_condition.EndDraw();
+
+				if (accumulated) {
+					m_accumulator.Add(data, glm::ivec2(rtSize));
+					systemVM.SetSampleIndex(0);
+				}
+
+				// the attachments are cleared before anything reads them again (the resolved textures keep their contents)
+				if (storeDontCare && m_invalidateSupported) {
+					GLenum attachments[MAX_RENDER_TEXTURES + 1];
+					GLsizei attachmentCount = 0;
+					if (passMSAA && (scheduled.Resolve || accumulated))
+						for (int j = 0; j < data->RTCount; j++)
+							if (scheduled.Discard & (1u << j))
+								attachments[attachmentCount++] = GL_COLOR_ATTACHMENT0 + j;
+					if (scheduled.DiscardDepth)
+						attachments[attachmentCount++] = GL_DEPTH_STENCIL_ATTACHMENT;
+
+					if (attachmentCount > 0) {
+						glBindFramebuffer(GL_FRAMEBUFFER, passMSAA ? m_fboMS[data] : data->FBO);
+						glInvalidateFramebuffer(GL_FRAMEBUFFER, attachmentCount, attachments);
+					}
+				}
+
+				// the mip chains are built from what this pass (or the accumulation) left in level 0
+				for (int j = 0; j < data->RTCount; j++) {
+					if (data->RenderTextures[j] == m_rtColor)
+						continue;
+
+					ed::RenderTextureObject* rtObject = m_objects->GetRenderTexture(data->RenderTextures[j]);
+					if (rtObject != nullptr && rtObject->Mipmaps && !rtObject->IsLayered()) {
+						m_mipChain.Generate(data->RenderTextures[j], rtObject->Format, rtObject->CalculateSize(width, height), rtObject->MipFilter);
+						glViewport(0, 0, rtSize.x, rtSize.y);
+					}
+				}
+
+				// the static passes that sample these are drawn again
+				for (int j = 0; j < data->RTCount; j++)
+					m_writeCount[getBarrierKey(false, data->RenderTextures[j])]++;
+
+				if (compared) {
+					m_compare.End(m_compareVersion);
+					if (m_compareCapture)
+						m_compare.Capture(m_compareVersion, data->FBO, glm::ivec2(rtSize));
+				}
+
+				if (profile)
+					m_profiler.End(it);
+				if (watched)
+					m_watchdog.End(it);
+
+				if (trace && m_tracePrograms.count(m_shaders[i]))
+					m_trace.Mark(it->Name);
+
+				if (m_comparePartial && it == m_compare.GetPass())
+					break;
 			}
 			else if (it->Type == PipelineItem::ItemType::ComputePass && !isDebug && !m_paused && m_computeSupported) {
 				pipe::ComputePass *data = (pipe::ComputePass *)it->Data;
 
-				const std::vector<GLuint>& srvs = m_objects->GetBindList(m_items[i]);
-				const std::vector<GLuint>& ubos = m_objects->GetUniformBindList(m_items[i]);
+				const std::vector<BindingDescriptor>& srvs = m_objects->GetBindTable(m_items[i]);
+				const std::vector<BindingDescriptor>& ubos = m_objects->GetUniformBindTable(m_items[i]);
 
-				if (m_shaders[i] == 0)
+				m_checkConstants(it);
+
+				if (m_shaders[i] == 0 || m_watchdog.IsTripped(it))
+					continue;
+
+				// fixed rate passes only run the steps that became due since the last frame
+				GLuint ticks = data->TickRate > 0.0f ? m_getComputeTicks(it, data->TickRate) : 1;
+				if (ticks == 0)
 					continue;
+
+				m_barrierRead(it, srvs, ubos);
+
+				if (profile)
+					m_profiler.Begin(it, it->Name, GPUProfiler::CounterSet::Compute);
+				if (watched)
+					m_watchdog.Begin(it);
 				
 				// bind shaders
 				glUseProgram(m_shaders[i]);
@@ -430,91 +1054,165 @@ namespace ed
 				for (int j = 0; j < srvs.size(); j++)
 				{
 					glActiveTexture(GL_TEXTURE0 + j);
-					if (m_objects->IsCubeMap(srvs[j]))
-						glBindTexture(GL_TEXTURE_CUBE_MAP, srvs[j]);
-					else if (m_objects->IsImage3D(srvs[j]))
-						glBindTexture(GL_TEXTURE_3D, srvs[j]);
+					if (srvs[j].Type == BindingDescriptor::BindType::Plugin)
+						glBindTexture(GL_TEXTURE_2D, srvs[j].ID);
 					else
-						glBindTexture(GL_TEXTURE_2D, srvs[j]);
+						glBindTexture(srvs[j].Target, srvs[j].ID);
+					glState.BindSampler(j, srvs[j].Sampler);
 
 					if (ShaderTranscompiler::GetShaderTypeFromExtension(data->Path) == ShaderLanguage::GLSL) // TODO: or should this be for vulkan glsl too?
 						data->Variables.UpdateTexture(m_shaders[i], j);
 				}
 
-				// bind buffers
-				for (int j = 0; j < ubos.size(); j++) {
-					if (m_objects->IsImage(ubos[j])) {
-						ImageObject* iobj = m_objects->GetImage(m_objects->GetImageNameByID(ubos[j])); // TODO: GetImageByID
-						glBindImageTexture(j, ubos[j], 0, GL_FALSE, 0, GL_WRITE_ONLY | GL_READ_ONLY, iobj->Format);
-					}
-					else if (m_objects->IsImage3D(ubos[j])) {
-						Image3DObject* iobj = m_objects->GetImage3D(m_objects->GetImage3DNameByID(ubos[j]));
-						glBindImageTexture(j, ubos[j], 0, GL_TRUE, 0, GL_WRITE_ONLY | GL_READ_ONLY, iobj->Format);
+				m_updateSystemBlock();
+
+				// time slicing splits the dispatch along its largest dimension - only if the shader adds SHADERed_WorkGroupOffset to gl_WorkGroupID
+				bool conditioned = data->ConditionBuffer != nullptr;
+				bool timeSliced = m_slicer.IsEnabled() && data->IndirectBuffer == nullptr && !conditioned;
+				GLint groupOffset = glGetUniformLocation(m_shaders[i], "SHADERed_WorkGroupOffset");
+				glm::uvec3 groups(data->WorkX, data->WorkY, data->WorkZ);
+				int axis = 0;
+				for (int k = 1; k < 3; k++)
+					if (groups[k] > groups[axis])
+						axis = k;
+				int slices = timeSliced ? m_slicer.GetSliceCount(it, groupOffset != -1 ? groups[axis] : 1) : 1; // without the offset each iteration is still waited for
+				if (groupOffset != -1)
+					glUniform3ui(groupOffset, 0, 0, 0);
+
+				GLuint iterations = std::max<GLuint>(data->Iterations, 1) * ticks;
+				bool pingPong = data->PingPong && ubos.size() >= 2;
+				for (GLuint iter = 0; iter < iterations; iter++) {
+					// each iteration reads what the previous one wrote
+					if (iter > 0)
+						m_barrierRead(it, srvs, ubos);
+
+					// bind buffers
+					if (iter == 0 || pingPong) {
+						for (int j = 0; j < ubos.size(); j++) {
+							const BindingDescriptor& ubo = ubos[(pingPong && j < 2 && iter % 2 == 1) ? (1 - j) : j];
+							if (ubo.Type == BindingDescriptor::BindType::Image2D)
+								glBindImageTexture(j, ubo.ID, 0, GL_FALSE, 0, GL_WRITE_ONLY | GL_READ_ONLY, ubo.Image->Format);
+							else if (ubo.Type == BindingDescriptor::BindType::Image3D)
+								glBindImageTexture(j, ubo.ID, 0, GL_TRUE, 0, GL_WRITE_ONLY | GL_READ_ONLY, ubo.Image3D->Format);
+							else if (ubo.Type == BindingDescriptor::BindType::Plugin) {
+								PluginProfiler::Scope profile(ubo.Plugin->Owner, PluginProfiler::BindObject);
+								ubo.Plugin->Owner->BindObject(ubo.Plugin->Type, ubo.Plugin->Data, ubo.Plugin->ID);
+							}
+							else
+								glBindBufferBase(GL_SHADER_STORAGE_BUFFER, j, ubo.ID);
+						}
 					}
-					else if (m_objects->IsPluginObject(ubos[j])) {
-						PluginObject* pobj = m_objects->GetPluginObject(ubos[j]);
-						pobj->Owner->BindObject(pobj->Type, pobj->Data, pobj->ID);
+
+					// bind variables - only the iteration index changes between the iterations
+					SystemVariableManager::Instance().SetIterationIndex(iter);
+					data->Variables.Bind();
+
+					// call compute shader - the condition is checked before every iteration so that the pass can also stop itself,
+					// the group counts are written on the GPU (0 when the pass shouldn't run) with SSBO binding points that the pass doesn't use
+					BufferObject* indirect = (BufferObject*)data->IndirectBuffer;
+					if (conditioned && m_condition.BindDispatch((BufferObject*)data->ConditionBuffer, data->ConditionOffset, groups, indirect, data->IndirectOffset)) {
+						glUseProgram(m_shaders[i]);
+						glDispatchComputeIndirect(0);
+						glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+					} else if (indirect != nullptr) {
+						if (data->IndirectOffset + sizeof(GLuint) * 3 <= indirect->Size) {
+							glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, indirect->ID);
+							glDispatchComputeIndirect(data->IndirectOffset);
+							glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+						}
+					} else if (timeSliced) {
+						for (int slice = 0; slice < slices; slice++) {
+							glm::uvec3 offset(0, 0, 0), count = groups;
+							offset[axis] = groups[axis] * slice / slices;
+							count[axis] = groups[axis] * (slice + 1) / slices - offset[axis];
+							if (slices > 1)
+								glUniform3ui(groupOffset, offset.x, offset.y, offset.z);
+
+							m_slicer.BeginSlice();
+							glDispatchCompute(count.x, count.y, count.z);
+							m_slicer.EndSlice(it);
+						}
+						if (slices > 1)
+							glUniform3ui(groupOffset, 0, 0, 0);
 					} else
-						glBindBufferBase(GL_SHADER_STORAGE_BUFFER, j, ubos[j]);
+						glDispatchCompute(data->WorkX, data->WorkY, data->WorkZ);
+
+					// auto: the barrier waits for the first pass that reads the results
+					if (!data->AutoBarrier && data->Barrier != 0)
+						glMemoryBarrier(data->Barrier);
+					m_barrierWrite(ubos, data->AutoBarrier ? 0 : data->Barrier);
 				}
-				
-				// bind variables
-				data->Variables.Bind();
+				SystemVariableManager::Instance().SetIterationIndex(0);
+				if (timeSliced)
+					m_slicer.EndItem(it);
+
+				if (profile)
+					m_profiler.End(it);
+				if (watched)
+					m_watchdog.End(it);
 
-				// call compute shader
-				glDispatchCompute(data->WorkX, data->WorkY, data->WorkZ);
+				if (trace && m_tracePrograms.count(m_shaders[i]))
+					m_trace.Mark(it->Name);
 
-				// wait until it finishes
-				glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_UNIFORM_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
-				// or maybe until i implement these as options glMemoryBarrier(GL_ALL_BARRIER_BITS);
+				// the candidates run after the pass, with the same bindings
+				if (it == m_tuner.GetPass() && !m_comparePartial)
+					m_runTuner(it, m_shaders[i], srvs);
 			}
 			else if (it->Type == PipelineItem::ItemType::AudioPass && !isDebug) {
 				pipe::AudioPass *data = (pipe::AudioPass *)it->Data;
 
-				const std::vector<GLuint>& srvs = m_objects->GetBindList(m_items[i]);
-				const std::vector<GLuint>& ubos = m_objects->GetUniformBindList(m_items[i]);
+				const std::vector<BindingDescriptor>& srvs = m_objects->GetBindTable(m_items[i]);
+				const std::vector<BindingDescriptor>& ubos = m_objects->GetUniformBindTable(m_items[i]);
 
-				// bind shader resource views
-				for (int j = 0; j < srvs.size(); j++)
-				{
-					glActiveTexture(GL_TEXTURE0 + j);
-					if (m_objects->IsCubeMap(srvs[j]))
-						glBindTexture(GL_TEXTURE_CUBE_MAP, srvs[j]);
-					else if (m_objects->IsImage3D(srvs[j]))
-						glBindTexture(GL_TEXTURE_3D, srvs[j]);
-					else if (m_objects->IsPluginObject(srvs[j])) {
-						PluginObject* pobj = m_objects->GetPluginObject(srvs[j]);
-						pobj->Owner->BindObject(pobj->Type, pobj->Data, pobj->ID);
-					}
-					else
-						glBindTexture(GL_TEXTURE_2D, srvs[j]);
+				m_barrierRead(it, srvs, ubos);
 
-					if (ShaderTranscompiler::GetShaderTypeFromExtension(data->Path) == ShaderLanguage::GLSL) // TODO: or should this be for vulkan glsl too?
-						data->Variables.UpdateTexture(m_shaders[i], j);
-				}
+				if (profile)
+					m_profiler.Begin(it, it->Name);
 
-				// bind buffers
-				for (int j = 0; j < ubos.size(); j++) {
-					if (m_objects->IsBuffer(m_objects->GetBufferNameByID(ubos[j])))
-						glBindBufferBase(GL_SHADER_STORAGE_BUFFER, j, ubos[j]);
-				}
-				
-				// bind variables
-				data->Variables.Bind();
+				m_bindAudioPass(i, srvs, ubos);
 
 				data->Stream.renderAudio();
+
+				if (profile)
+					m_profiler.End(it);
 			}
 			else if (it->Type == PipelineItem::ItemType::PluginItem && !isDebug) {
 				pipe::PluginItemData* pldata = reinterpret_cast<pipe::PluginItemData*>(it->Data);
 
-				pldata->Owner->ExecutePipelineItem(pldata->Type, pldata->PluginData, pldata->Items.data(), pldata->Items.size());
+				m_barrierRead(it, m_objects->GetBindTable(it), m_objects->GetUniformBindTable(it));
+
+				if (profile)
+					m_profiler.Begin(it, it->Name);
+
+				glState.UnbindSamplers();
+				{
+					PluginProfiler::Scope profile(pldata->Owner, PluginProfiler::Execute);
+					pldata->Owner->ExecutePipelineItem(pldata->Type, pldata->PluginData, pldata->Items.data(), pldata->Items.size());
+				}
+				glState.Invalidate();
+
+				if (profile)
+					m_profiler.End(it);
 			}
 		}
 
-		m_plugins->EndRender();
+		// the UI and the plugins sample with the texture parameters
+		glState.UnbindSamplers();
+
+		if (trace)
+			m_trace.End();
+
+		if (!m_comparePartial)
+			m_plugins->EndRender();
+
+		m_barrierEndFrame();
+
+		// the UI tells again which textures it still shows
+		if (!isDebug && !m_comparePartial)
+			m_keepResolved.clear();
 
 		// update frame index
-		if (!m_paused) {
+		if (!m_paused && !m_comparePartial) {
 			systemVM.CopyState();
 			systemVM.SetFrameIndex(systemVM.GetFrameIndex() + 1);
 		}
@@ -532,63 +1230,508 @@ namespace ed
 
 		if (isMSAA)
 			glDisable(GL_MULTISAMPLE);
+
+		if (m_comparePartial)
+			return;
+
+		if (!isDebug && m_compare.IsActive()) {
+			m_compareVersion = -1;
+			m_compare.EndFrame();
+		}
+		if (!isDebug)
+			m_tuner.EndFrame();
+
+		// the items that switched to a new program were just rendered with it
+		if (!isDebug)
+			ReloadProfiler::Instance().EndFrame();
+
+		// debug renders overwrite the preview, the background ones skip most of it
+		m_frameDirty = isDebug || m_backgroundOnly;
+		m_frameGeneration = m_pipeline->GetGeneration();
+
+		// the UI keeps showing the last finished frame instead of the debug one
+		if (!isDebug) {
+			m_presentStereo();
+			m_queueOutput();
+			TextureSharing::Instance().Publish(m_objects, m_rtColor, m_lastSize);
+		}
+
+		if (isCapture)
+			RenderDocCapture::Instance().EndFrame();
 	}
-	void RenderEngine::DebugPixelPick(glm::vec2 r)
+	GLuint RenderEngine::GetOutputTexture()
 	{
-		m_debug->ClearPixelList();
+		if (m_outputPending != -1) {
+			GLenum status = glClientWaitSync(m_outputFence[m_outputPending], 0, 0);
+			if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+				glDeleteSync(m_outputFence[m_outputPending]);
+				m_outputFence[m_outputPending] = 0;
+
+				m_outputShown = m_outputPending;
+				m_outputPending = -1;
+			}
+			else
+				UIRefresh::Instance().Request(); // the idle UI has to redraw once the frame is done
+		}
 
-		int x = r.x * m_lastSize.x;
-		int y = r.y * m_lastSize.y;
+		// nothing has finished yet
+		if (m_outputShown == -1)
+			return m_rtColor;
 
-		const std::vector<ObjectManagerItem*>& objs = m_objects->GetItemDataList();
-		glm::ivec2 maxRTSize = m_lastSize;
-		for (int i = 0; i < objs.size(); i++) {
-			if (objs[i]->RT != nullptr) {
-				glm::ivec2 rtSize = m_objects->GetRenderTextureSize(objs[i]->RT->Name);
-				if (rtSize.x > maxRTSize.x)
-					maxRTSize.x = rtSize.x;
-				if (rtSize.y > maxRTSize.y)
-					maxRTSize.y = rtSize.y;
-			}
+		return m_outputTex[m_outputShown];
+	}
+	void RenderEngine::m_queueOutput()
+	{
+		// never write to the shown texture - a newer frame replaces the pending one
+		int slot = 0;
+		while (slot == m_outputShown || slot == m_outputPending)
+			slot++;
+
+		GLint format = Settings::Instance().Project.UseAlphaChannel ? GL_RGBA : GL_RGB;
+		if (m_outputSize[slot] != m_lastSize || m_outputFormat[slot] != format) {
+			glBindTexture(GL_TEXTURE_2D, m_outputTex[slot]);
+			glTexImage2D(GL_TEXTURE_2D, 0, format, m_lastSize.x, m_lastSize.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			glBindTexture(GL_TEXTURE_2D, 0);
+
+			m_outputSize[slot] = m_lastSize;
+			m_outputFormat[slot] = format;
 		}
 
-		uint8_t* mainPixelData = new uint8_t[maxRTSize.x * maxRTSize.y * 4];
+		glCopyImageSubData(m_rtColor, GL_TEXTURE_2D, 0, 0, 0, 0, m_outputTex[slot], GL_TEXTURE_2D, 0, 0, 0, 0, m_lastSize.x, m_lastSize.y, 1);
 
-		std::unordered_map<GLuint, glm::vec4> pixelColors;
+		if (m_outputPending != -1) {
+			glDeleteSync(m_outputFence[m_outputPending]);
+			m_outputFence[m_outputPending] = 0;
+		}
+		m_outputFence[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		m_outputPending = slot;
+	}
+	void RenderEngine::m_clearOutput()
+	{
+		for (int i = 0; i < RENDER_OUTPUT_BUFFERS; i++) {
+			if (m_outputFence[i] != 0)
+				glDeleteSync(m_outputFence[i]);
+			m_outputFence[i] = 0;
+		}
+		m_outputShown = m_outputPending = -1;
+	}
+	void RenderEngine::m_presentStereo()
+	{
+		const std::string& name = Settings::Instance().Project.StereoPreview;
+		if (name.empty())
+			return;
 
-		// window pixel color
+		ObjectManagerItem* item = m_objects->GetObjectManagerItem(name);
+		if (item == nullptr || item->RT == nullptr || item->RT->Cubemap || item->RT->Layers < STEREO_VIEW_COUNT)
+			return;
+
+		if (m_stereoFBO[0] == 0)
+			glGenFramebuffers(2, m_stereoFBO);
+
+		glm::ivec2 size = item->RT->CalculateSize(m_lastSize.x, m_lastSize.y);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_stereoFBO[1]);
+		glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_rtColor, 0);
+		glDrawBuffer(GL_COLOR_ATTACHMENT0);
+		glClearBufferfv(GL_COLOR, 0, glm::value_ptr(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)));
+
+		// an eye per half of the window, the aspect ratio of the layers is kept
+		float halfWidth = m_lastSize.x / (float)STEREO_VIEW_COUNT;
+		float scale = std::min(halfWidth / size.x, m_lastSize.y / (float)size.y);
+		glm::ivec2 shown = glm::ivec2(glm::vec2(size) * scale);
+		int y = (m_lastSize.y - shown.y) / 2;
+
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, m_stereoFBO[0]);
+		for (int i = 0; i < STEREO_VIEW_COUNT; i++) {
+			int x = (int)(halfWidth * i + (halfWidth - shown.x) / 2);
+			glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, item->Texture, 0, i);
+			glReadBuffer(GL_COLOR_ATTACHMENT0);
+			glBlitFramebuffer(0, 0, size.x, size.y, x, y, x + shown.x, y + shown.y, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+		}
+
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	}
+	void RenderEngine::m_renderComparison(int width, int height)
+	{
+		// the order alternates so that neither version profits from the caches that the other one filled,
+		// the actual frame always ends with the pass' own program
+		bool pick = m_pickAwaiting;
+		m_pickAwaiting = false;
+		m_comparePartial = true;
+
+		bool bFirst = m_compare.GetFrame() % 2 == 0;
+		if (bFirst) {
+			m_compareVersion = 1;
+			Render(width, height, false);
+		} else {
+			// both versions see exactly the same inputs here so these frames are used for the difference image
+			m_compareCapture = true;
+			m_compareVersion = 0;
+			Render(width, height, false);
+			m_compareVersion = 1;
+			Render(width, height, false);
+			m_compareCapture = false;
+		}
+
+		m_comparePartial = false;
+		m_pickAwaiting = pick;
+
+		// the actual frame measures the pass' own program when it wasn't measured yet
+		m_compareVersion = bFirst ? 0 : -1;
+	}
+	void RenderEngine::RenderCostHeatmap(int width, int height)
+	{
+		m_costRender = true;
+		Render(width, height, true);
+		m_costRender = false;
+
+		// the instrumented shaders pack the loop iteration count into rgb
+		std::vector<unsigned char> pixels(width * height * 4);
 		glBindTexture(GL_TEXTURE_2D, m_rtColor);
-		glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, mainPixelData);
+		glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
 		glBindTexture(GL_TEXTURE_2D, 0);
-		uint8_t* pxData = &mainPixelData[(x + y * m_lastSize.x) * 4];
-		pixelColors[m_rtColor] = glm::vec4(pxData[0] / 255.0f, pxData[1] / 255.0f, pxData[2] / 255.0f, pxData[3] / 255.0f);
 
-		// rt pixel colors
-		for (int i = 0; i < objs.size(); i++) {
-			if (objs[i]->RT != nullptr) {
-				GLuint tex = objs[i]->Texture;
-				glm::ivec2 rtSize = m_objects->GetRenderTextureSize(objs[i]->RT->Name);
+		std::vector<int> costs(width * height);
+		m_costMax = 0;
+		for (int i = 0; i < costs.size(); i++) {
+			costs[i] = pixels[i * 4 + 0] | (pixels[i * 4 + 1] << 8) | (pixels[i * 4 + 2] << 16);
+			m_costMax = std::max<int>(m_costMax, costs[i]);
+		}
 
-				glBindTexture(GL_TEXTURE_2D, tex);
-				glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, mainPixelData);
-				glBindTexture(GL_TEXTURE_2D, 0);
+		// nothing was drawn where the cost is 0
+		std::vector<float> values(costs.size());
+		for (int i = 0; i < costs.size(); i++)
+			values[i] = costs[i] == 0 ? -1.0f : costs[i] / (float)std::max<int>(m_costMax, 1);
+
+		m_buildHeatmap(m_costTexture, values, width, height);
+	}
+	void RenderEngine::RenderOverdrawHeatmap(int width, int height, bool quads)
+	{
+		m_overdrawRender = true;
+		m_overdrawQuads = quads && GLEW_VERSION_4_5;
+		Render(width, height, true);
+		m_overdrawRender = false;
 
-				pxData = &mainPixelData[((int)(r.x * rtSize.x) + (int)(r.y * rtSize.y) * rtSize.x) * 4];
+		// r = shaded fragments, g = helper lanes * 3 (quad mode)
+		std::vector<unsigned char> pixels(width * height * 4);
+		glBindTexture(GL_TEXTURE_2D, m_rtColor);
+		glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+		glBindTexture(GL_TEXTURE_2D, 0);
 
-				pixelColors[tex] = glm::vec4(pxData[0] / 255.0f, pxData[1] / 255.0f, pxData[2] / 255.0f, pxData[3] / 255.0f);
+		int count = width * height;
+		m_overdrawMax = 0;
+		for (int i = 0; i < count; i++)
+			m_overdrawMax = std::max<int>(m_overdrawMax, pixels[i * 4 + 0]);
+
+		std::vector<float> values(count);
+		double fragments = 0.0, lanes = 0.0;
+		for (int i = 0; i < count; i++) {
+			float shaded = pixels[i * 4 + 0];
+			if (shaded == 0.0f) {
+				values[i] = -1.0f;
+				continue;
 			}
+
+			if (m_overdrawQuads) {
+				float helpers = pixels[i * 4 + 1] / 3.0f;
+				values[i] = helpers / (shaded + helpers);
+				fragments += shaded;
+				lanes += shaded + helpers;
+			} else
+				values[i] = shaded / std::max<int>(m_overdrawMax, 1);
 		}
+		m_quadEfficiency = (m_overdrawQuads && lanes > 0.0) ? (float)(fragments / lanes) : -1.0f;
 
-		// render in debug mode
-		Render(true);
+		m_buildHeatmap(m_overdrawTexture, values, width, height);
+	}
+	void RenderEngine::m_buildHeatmap(GLuint& texture, const std::vector<float>& values, int width, int height)
+	{
+		std::vector<unsigned char> pixels(values.size() * 4);
+		for (int i = 0; i < values.size(); i++) {
+			glm::vec3 color = GetHeatmapColor(values[i]);
+			pixels[i * 4 + 0] = color.r * 255;
+			pixels[i * 4 + 1] = color.g * 255;
+			pixels[i * 4 + 2] = color.b * 255;
+			pixels[i * 4 + 3] = values[i] < 0.0f ? 0 : 255;
+		}
 
-		// window item id
-		
-		glBindTexture(GL_TEXTURE_2D, m_rtColor);
-		glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, mainPixelData);
+		if (texture == 0) {
+			glGenTextures(1, &texture);
+			glBindTexture(GL_TEXTURE_2D, texture);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		} else
+			glBindTexture(GL_TEXTURE_2D, texture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
 		glBindTexture(GL_TEXTURE_2D, 0);
-		pxData = &mainPixelData[(x + m_lastSize.x * y) * 4];
-		int id = (pxData[0] << 0) | (pxData[1] << 8) | (pxData[2] << 16);
+	}
+	int RenderEngine::m_getWindowOutput(pipe::ShaderPass* pass)
+	{
+		for (int i = 0; i < pass->RTCount; i++)
+			if (pass->RenderTextures[i] == m_rtColor)
+				return i;
+		return -1;
+	}
+	GLuint RenderEngine::m_createInstrumentedProgram(const std::string& vsCode, const std::string& psCode)
+	{
+		GLuint program = 0;
+		GLchar msg[1024];
+		GLuint vs = gl::CompileShader(GL_VERTEX_SHADER, vsCode.c_str());
+		GLuint ps = gl::CompileShader(GL_FRAGMENT_SHADER, psCode.c_str());
+
+		if (gl::CheckShaderCompilationStatus(vs, msg) && gl::CheckShaderCompilationStatus(ps, msg)) {
+			program = glCreateProgram();
+			glAttachShader(program, vs);
+			glAttachShader(program, ps);
+			glLinkProgram(program);
+
+			GLint linked = 0;
+			glGetProgramiv(program, GL_LINK_STATUS, &linked);
+			if (linked)
+				m_bindSystemBlock(program);
+			else {
+				glDeleteProgram(program);
+				program = 0;
+			}
+		}
+
+		glDeleteShader(vs);
+		glDeleteShader(ps);
+
+		return program;
+	}
+	GLuint RenderEngine::m_getCostShader(int index)
+	{
+		PipelineItem* item = m_items[index];
+
+		auto cached = m_costShaders.find(item);
+		if (cached != m_costShaders.end())
+			return cached->second;
+
+		int output = m_getWindowOutput((pipe::ShaderPass*)item->Data);
+
+		GLuint program = 0;
+		const ShaderPack& sources = m_shaderSources[index];
+		if (output != -1 && !sources.VSCode.empty()) {
+			std::string psCode = ShaderTranscompiler::InstrumentCost(sources.PSCode, output);
+
+			if (!psCode.empty())
+				program = m_createInstrumentedProgram(sources.VSCode, psCode);
+
+			if (program == 0)
+				Logger::Get().Log("Failed to create the cost heatmap shader for " + std::string(item->Name), true);
+		}
+
+		m_costShaders[item] = program;
+		return program;
+	}
+	GLuint RenderEngine::m_getOverdrawShader(int index)
+	{
+		PipelineItem* item = m_items[index];
+		std::unordered_map<PipelineItem*, GLuint>& shaders = m_overdrawShaders[m_overdrawQuads];
+
+		auto cached = shaders.find(item);
+		if (cached != shaders.end())
+			return cached->second;
+
+		int output = m_getWindowOutput((pipe::ShaderPass*)item->Data);
+
+		GLuint program = 0;
+		const ShaderPack& sources = m_shaderSources[index];
+		if (output != -1 && !sources.VSCode.empty()) {
+			// the pass' own pixel shader doesn't matter, only how many fragments were rasterized
+			std::string psCode;
+			if (m_overdrawQuads) {
+				// with fine derivatives of a 0/1 value every lane can tell which of its three quad neighbours are alive
+				psCode = "#version 450\n"
+						 "layout(location = " + std::to_string(output) + ") out vec4 sedOverdraw;\n"
+						 "void main() {\n"
+						 "	float alive = gl_HelperInvocation ? 0.0 : 1.0;\n"
+						 "	float rowDiff = abs(dFdxFine(alive));\n"
+						 "	float horizontal = abs(alive - rowDiff);\n"
+						 "	float vertical = abs(alive - abs(dFdyFine(alive)));\n"
+						 "	float otherRowDiff = abs(rowDiff - abs(dFdyFine(rowDiff)));\n"
+						 "	float diagonal = abs(vertical - otherRowDiff);\n"
+						 "	float lanes = alive + horizontal + vertical + diagonal;\n"
+						 "	sedOverdraw = vec4(1.0, 3.0 * (4.0 - lanes) / max(lanes, 1.0), 0.0, 0.0) / 255.0;\n" // 0, 1, 3 or 9
+						 "}\n";
+			} else {
+				psCode = "#version 330\n"
+						 "layout(location = " + std::to_string(output) + ") out vec4 sedOverdraw;\n"
+						 "void main() { sedOverdraw = vec4(1.0 / 255.0, 0.0, 0.0, 0.0); }\n";
+			}
+
+			program = m_createInstrumentedProgram(sources.VSCode, psCode);
+			if (program == 0)
+				Logger::Get().Log("Failed to create the overdraw shader for " + std::string(item->Name), true);
+		}
+
+		shaders[item] = program;
+		return program;
+	}
+	GLuint RenderEngine::m_getDepthPrepassShader(int index)
+	{
+		PipelineItem* item = m_items[index];
+		pipe::ShaderPass* pass = (pipe::ShaderPass*)item->Data;
+
+		auto cached = m_prepassShaders.find(item);
+		if (cached != m_prepassShaders.end())
+			return cached->second;
+
+		GLuint program = 0;
+		const ShaderPack& sources = m_shaderSources[index];
+		if (!sources.VSCode.empty()) {
+			// the positions would come from the geometry shader & the empty pixel shader can't discard or write the depth
+			bool customDepth = sources.PSCode.find("discard") != std::string::npos || sources.PSCode.find("gl_FragDepth") != std::string::npos;
+			if (pass->GSUsed || customDepth)
+				Logger::Get().Log("Depth prepass of " + std::string(item->Name) + " skipped - it uses a geometry shader, discard or gl_FragDepth");
+			else {
+				program = m_createInstrumentedProgram(sources.VSCode, "#version 330\nvoid main() {}\n");
+				if (program == 0)
+					Logger::Get().Log("Failed to create the depth prepass shader for " + std::string(item->Name), true);
+			}
+		}
+
+		m_prepassShaders[item] = program;
+		return program;
+	}
+	bool RenderEngine::m_drawDepthPrepass(int index, int width, int height)
+	{
+		GLuint program = m_getDepthPrepassShader(index);
+		if (program == 0)
+			return false;
+
+		PipelineItem* it = m_items[index];
+		pipe::ShaderPass* data = (pipe::ShaderPass*)it->Data;
+		SystemVariableManager& systemVM = SystemVariableManager::Instance();
+		GLStateCache& glState = GLStateCache::Instance();
+		auto& itemVarValues = GetItemVariableValues();
+		gl::DebugGroup prepassGroup("Depth prepass");
+
+		data->Variables.UpdateUniformInfo(program);
+		glUseProgram(program);
+
+		DefaultState::Bind();
+		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+
+		// only the items drawn with depth writes & without blending are opaque
+		bool opaque = true;
+		for (PipelineItem* item : data->Items) {
+			if (item->Type == PipelineItem::ItemType::RenderState) {
+				pipe::RenderState* state = reinterpret_cast<pipe::RenderState*>(item->Data);
+				opaque = state->DepthTest && state->DepthMask && !state->Blend;
+
+				glState.Enable(GL_DEPTH_CLAMP, state->DepthClamp);
+				glState.PolygonMode(state->PolygonMode);
+				glState.Enable(GL_CULL_FACE, state->CullFace);
+				glState.CullFace(state->CullFaceType);
+				glState.FrontFace(state->FrontFace);
+				glState.Enable(GL_DEPTH_TEST, state->DepthTest);
+				glState.DepthMask(state->DepthMask);
+				glState.DepthFunc(state->DepthFunction);
+				glState.PolygonOffset(0.0f, state->DepthBias);
+				continue;
+			}
+			if (!opaque || (item->Type != PipelineItem::ItemType::Geometry && item->Type != PipelineItem::ItemType::Model))
+				continue;
+
+			for (int k = 0; k < itemVarValues.size(); k++)
+				if (itemVarValues[k].Item == item)
+					itemVarValues[k].Variable->Data = itemVarValues[k].NewValue->Data;
+
+			if (item->Type == PipelineItem::ItemType::Geometry) {
+				pipe::GeometryItem* geoData = reinterpret_cast<pipe::GeometryItem*>(item->Data);
+
+				m_setGeometryTransform(item, geoData, width, height);
+				data->Variables.Bind(item);
+
+				m_drawGeometry(geoData);
+			} else {
+				pipe::Model* objData = reinterpret_cast<pipe::Model*>(item->Data);
+
+				systemVM.SetGeometryTransform(item, objData->Scale, objData->Rotation, objData->Position);
+				data->Variables.Bind(item);
+
+				objData->Data->Draw(objData->Instanced, objData->InstanceCount, m_pickModelLOD(item, objData));
+			}
+
+			for (int k = 0; k < itemVarValues.size(); k++)
+				if (itemVarValues[k].Item == item)
+					itemVarValues[k].Variable->Data = itemVarValues[k].OldValue;
+		}
+
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+		return true;
+	}
+	void RenderEngine::m_bindOverdrawState(pipe::ShaderPass* pass)
+	{
+		GLStateCache& glState = GLStateCache::Instance();
+		glState.Enable(GL_BLEND, true);
+		glState.BlendEquationSeparate(GL_FUNC_ADD, GL_FUNC_ADD);
+		glState.BlendFuncSeparate(GL_ONE, GL_ONE, GL_ONE, GL_ONE);
+
+		// the other render textures keep what the later passes will read
+		for (int i = 0; i < pass->RTCount; i++) {
+			GLboolean window = pass->RenderTextures[i] == m_rtColor;
+			glColorMaski(i, window, window, window, window);
+		}
+	}
+	void RenderEngine::m_deleteInstrumentedShaders(PipelineItem* item)
+	{
+		auto cached = m_costShaders.find(item);
+		if (cached != m_costShaders.end()) {
+			glDeleteProgram(cached->second);
+			m_costShaders.erase(cached);
+		}
+
+		for (int i = 0; i < 2; i++) {
+			cached = m_overdrawShaders[i].find(item);
+			if (cached != m_overdrawShaders[i].end()) {
+				glDeleteProgram(cached->second);
+				m_overdrawShaders[i].erase(cached);
+			}
+		}
+		cached = m_prepassShaders.find(item);
+		if (cached != m_prepassShaders.end()) {
+			glDeleteProgram(cached->second);
+			m_prepassShaders.erase(cached);
+		}
+	}
+	void RenderEngine::DebugPixelPick(glm::vec2 r)
+	{
+		m_debug->ClearPixelList();
+
+		int x = r.x * m_lastSize.x;
+		int y = r.y * m_lastSize.y;
+
+		const std::vector<ObjectManagerItem*>& objs = m_objects->GetItemDataList();
+
+		std::unordered_map<GLuint, glm::vec4> pixelColors;
+
+		// window pixel color
+		glm::u8vec4 pxData = m_readPixel(m_rtColor, x, y);
+		pixelColors[m_rtColor] = glm::vec4(pxData) / 255.0f;
+
+		// rt pixel colors
+		for (int i = 0; i < objs.size(); i++) {
+			if (objs[i]->RT != nullptr) {
+				GLuint tex = objs[i]->Texture;
+				glm::ivec2 rtSize = m_objects->GetRenderTextureSize(objs[i]->RT->Name);
+
+				pxData = m_readPixel(tex, r.x * rtSize.x, r.y * rtSize.y);
+				pixelColors[tex] = glm::vec4(pxData) / 255.0f;
+			}
+		}
+
+		// render in debug mode
+		Render(true);
+
+		// window item id
+		
+		pxData = m_readPixel(m_rtColor, x, y);
+		int id = (pxData[0] << 0) | (pxData[1] << 8) | (pxData[2] << 16);
 		if (id != 0 && !m_isGSUsedSet(m_rtColor)) {
 			std::pair<PipelineItem*, PipelineItem*> itemData = GetPipelineItemByID(id);
 
@@ -618,11 +1761,7 @@ namespace ed
 				GLuint tex = objs[i]->Texture;
 				glm::ivec2 rtSize = m_objects->GetRenderTextureSize(objs[i]->RT->Name);
 
-				glBindTexture(GL_TEXTURE_2D, tex);
-				glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, mainPixelData);
-				glBindTexture(GL_TEXTURE_2D, 0);
-
-				pxData = &mainPixelData[((int)(r.x * rtSize.x) + (int)(r.y * rtSize.y) * rtSize.x) * 4];
+				pxData = m_readPixel(tex, r.x * rtSize.x, r.y * rtSize.y);
 				id = (pxData[0] << 0) | (pxData[1] << 8) | (pxData[2] << 16);
 				if (id != 0 && !m_isGSUsedSet(tex)) {
 					std::pair<PipelineItem*, PipelineItem*> itemData = GetPipelineItemByID(id);
@@ -651,8 +1790,6 @@ namespace ed
 
 		// return the actual RT that was shown before
 		Render();
-
-		delete[] mainPixelData;
 	}
 	int RenderEngine::DebugVertexPick(PipelineItem* vertexData, PipelineItem* vertexItem, glm::vec2 r)
 	{
@@ -666,7 +1803,7 @@ namespace ed
 		int lineBias = 0;
 		if (ShaderTranscompiler::GetShaderTypeFromExtension(vertexPass->VSPath) == ShaderLanguage::GLSL) {// GLSL
 			vsCode = m_project->LoadProjectFile(vertexPass->VSPath);
-			m_includeCheck(vsCode, std::vector<std::string>(), lineBias);
+			m_includeCheck(vsCode, lineBias, m_msgs);
 			m_applyMacros(vsCode, vertexPass);
 		}
 		else // HLSL / VK
@@ -697,13 +1834,14 @@ namespace ed
 		glAttachShader(customProgram, vs);
 		glAttachShader(customProgram, m_debugVertexPickShader);
 		glLinkProgram(customProgram);
+		m_bindSystemBlock(customProgram);
 
 		// update info
 		vertexPass->Variables.UpdateUniformInfo(customProgram);
 
 		// get resources
-		const std::vector<GLuint>& srvs = m_objects->GetBindList(vertexData);
-		const std::vector<GLuint>& ubos = m_objects->GetUniformBindList(vertexData);
+		const std::vector<BindingDescriptor>& srvs = m_objects->GetBindTable(vertexData);
+		const std::vector<BindingDescriptor>& ubos = m_objects->GetUniformBindTable(vertexData);
 
 		// item variable values
 		auto& itemVarValues = GetItemVariableValues();
@@ -747,24 +1885,24 @@ namespace ed
 		// bind shader resource views
 		for (int j = 0; j < srvs.size(); j++) {
 			glActiveTexture(GL_TEXTURE0 + j);
-			if (m_objects->IsCubeMap(srvs[j]))
-				glBindTexture(GL_TEXTURE_CUBE_MAP, srvs[j]);
-			else if (m_objects->IsImage3D(srvs[j]))
-				glBindTexture(GL_TEXTURE_3D, srvs[j]);
-			else if (m_objects->IsPluginObject(srvs[j])) {
-				PluginObject* pobj = m_objects->GetPluginObject(srvs[j]);
+			if (srvs[j].Type == BindingDescriptor::BindType::Plugin) {
+				PluginObject* pobj = srvs[j].Plugin;
+				PluginProfiler::Scope profile(pobj->Owner, PluginProfiler::BindObject);
 				pobj->Owner->BindObject(pobj->Type, pobj->Data, pobj->ID);
 			}
 			else
-				glBindTexture(GL_TEXTURE_2D, srvs[j]);
+				glBindTexture(srvs[j].Target, srvs[j].ID);
+			GLStateCache::Instance().BindSampler(j, srvs[j].Sampler);
 
 			if (ShaderTranscompiler::GetShaderTypeFromExtension(vertexPass->PSPath) == ShaderLanguage::GLSL) // TODO: or should this be for vulkan glsl too?
 				vertexPass->Variables.UpdateTexture(customProgram, j);
 		}
 		for (int j = 0; j < ubos.size(); j++)
-			glBindBufferBase(GL_UNIFORM_BUFFER, j, ubos[j]);
+			glBindBufferBase(GL_UNIFORM_BUFFER, j, ubos[j].ID);
+		m_updateSystemBlock();
 
 		// bind default states for each shader pass
+		GLStateCache::Instance().Invalidate();
 		DefaultState::Bind();
 		SystemVariableManager& systemVM = SystemVariableManager::Instance();
 
@@ -797,11 +1935,7 @@ namespace ed
 				// bind variables
 				vertexPass->Variables.Bind(item);
 
-				glBindVertexArray(geoData->VAO);
-				if (geoData->Instanced)
-					glDrawArraysInstanced(geoData->Topology, 0, eng::GeometryFactory::VertexCount[geoData->Type], geoData->InstanceCount);
-				else
-					glDrawArrays(geoData->Topology, 0, eng::GeometryFactory::VertexCount[geoData->Type]);
+				m_drawGeometry(geoData);
 			}
 			else if (item->Type == PipelineItem::ItemType::Model) {
 				pipe::Model* objData = reinterpret_cast<pipe::Model*>(item->Data);
@@ -818,12 +1952,9 @@ namespace ed
 				pipe::RenderState* state = reinterpret_cast<pipe::RenderState*>(item->Data);
 
 				// culling and front face (only thing we care about when picking a vertex, i think)
-				if (state->CullFace)
-					glEnable(GL_CULL_FACE);
-				else
-					glDisable(GL_CULL_FACE);
-				glCullFace(state->CullFaceType);
-				glFrontFace(state->FrontFace);
+				GLStateCache::Instance().Enable(GL_CULL_FACE, state->CullFace);
+				GLStateCache::Instance().CullFace(state->CullFaceType);
+				GLStateCache::Instance().FrontFace(state->FrontFace);
 			}
 
 			// set the old value back
@@ -834,13 +1965,11 @@ namespace ed
 		}
 
 		// window pixel color
-		uint8_t* mainPixelData = new uint8_t[(int)(rtSize.x * rtSize.y) * 4];
-		glBindTexture(GL_TEXTURE_2D, vertexPass->RenderTextures[0]);
-		glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, mainPixelData);
-		glBindTexture(GL_TEXTURE_2D, 0);
-		uint8_t* pxData = &mainPixelData[(x + y * (int)rtSize.x) * 4];
+		// only the picked pixel is needed - the pass FBO is still bound
+		uint8_t pxData[4] = { 0 };
+		glReadBuffer(GL_COLOR_ATTACHMENT0);
+		glReadPixels(x, y, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pxData);
 		int vertexID = (pxData[0] << 0) | (pxData[1] << 8) | (pxData[2] << 16);
-		delete[] mainPixelData;
 
 		// return old info
 		for (int i = 0; i < m_items.size(); i++) {
@@ -871,7 +2000,7 @@ namespace ed
 		int lineBias = 0;
 		if (ShaderTranscompiler::GetShaderTypeFromExtension(vertexPass->VSPath) == ShaderLanguage::GLSL) {// GLSL
 			vsCode = m_project->LoadProjectFile(vertexPass->VSPath);
-			m_includeCheck(vsCode, std::vector<std::string>(), lineBias);
+			m_includeCheck(vsCode, lineBias, m_msgs);
 			m_applyMacros(vsCode, vertexPass);
 		}
 		else // HLSL / VK
@@ -902,13 +2031,14 @@ namespace ed
 		glAttachShader(customProgram, vs);
 		glAttachShader(customProgram, m_debugInstancePickShader);
 		glLinkProgram(customProgram);
+		m_bindSystemBlock(customProgram);
 
 		// update info
 		vertexPass->Variables.UpdateUniformInfo(customProgram);
 
 		// get resources
-		const std::vector<GLuint>& srvs = m_objects->GetBindList(vertexData);
-		const std::vector<GLuint>& ubos = m_objects->GetUniformBindList(vertexData);
+		const std::vector<BindingDescriptor>& srvs = m_objects->GetBindTable(vertexData);
+		const std::vector<BindingDescriptor>& ubos = m_objects->GetUniformBindTable(vertexData);
 
 		// item variable values
 		auto& itemVarValues = GetItemVariableValues();
@@ -952,24 +2082,24 @@ namespace ed
 		// bind shader resource views
 		for (int j = 0; j < srvs.size(); j++) {
 			glActiveTexture(GL_TEXTURE0 + j);
-			if (m_objects->IsCubeMap(srvs[j]))
-				glBindTexture(GL_TEXTURE_CUBE_MAP, srvs[j]);
-			else if (m_objects->IsImage3D(srvs[j]))
-				glBindTexture(GL_TEXTURE_3D, srvs[j]);
-			else if (m_objects->IsPluginObject(srvs[j])) {
-				PluginObject* pobj = m_objects->GetPluginObject(srvs[j]);
+			if (srvs[j].Type == BindingDescriptor::BindType::Plugin) {
+				PluginObject* pobj = srvs[j].Plugin;
+				PluginProfiler::Scope profile(pobj->Owner, PluginProfiler::BindObject);
 				pobj->Owner->BindObject(pobj->Type, pobj->Data, pobj->ID);
 			}
 			else
-				glBindTexture(GL_TEXTURE_2D, srvs[j]);
+				glBindTexture(srvs[j].Target, srvs[j].ID);
+			GLStateCache::Instance().BindSampler(j, srvs[j].Sampler);
 
 			if (ShaderTranscompiler::GetShaderTypeFromExtension(vertexPass->PSPath) == ShaderLanguage::GLSL) // TODO: or should this be for vulkan glsl too?
 				vertexPass->Variables.UpdateTexture(customProgram, j);
 		}
 		for (int j = 0; j < ubos.size(); j++)
-			glBindBufferBase(GL_UNIFORM_BUFFER, j, ubos[j]);
+			glBindBufferBase(GL_UNIFORM_BUFFER, j, ubos[j].ID);
+		m_updateSystemBlock();
 
 		// bind default states for each shader pass
+		GLStateCache::Instance().Invalidate();
 		DefaultState::Bind();
 		SystemVariableManager& systemVM = SystemVariableManager::Instance();
 
@@ -1002,11 +2132,7 @@ namespace ed
 				// bind variables
 				vertexPass->Variables.Bind(item);
 
-				glBindVertexArray(geoData->VAO);
-				if (geoData->Instanced)
-					glDrawArraysInstanced(geoData->Topology, 0, eng::GeometryFactory::VertexCount[geoData->Type], geoData->InstanceCount);
-				else
-					glDrawArrays(geoData->Topology, 0, eng::GeometryFactory::VertexCount[geoData->Type]);
+				m_drawGeometry(geoData);
 			}
 			else if (item->Type == PipelineItem::ItemType::Model) {
 				pipe::Model* objData = reinterpret_cast<pipe::Model*>(item->Data);
@@ -1023,12 +2149,9 @@ namespace ed
 				pipe::RenderState* state = reinterpret_cast<pipe::RenderState*>(item->Data);
 
 				// culling and front face (only thing we care about when picking a vertex, i think)
-				if (state->CullFace)
-					glEnable(GL_CULL_FACE);
-				else
-					glDisable(GL_CULL_FACE);
-				glCullFace(state->CullFaceType);
-				glFrontFace(state->FrontFace);
+				GLStateCache::Instance().Enable(GL_CULL_FACE, state->CullFace);
+				GLStateCache::Instance().CullFace(state->CullFaceType);
+				GLStateCache::Instance().FrontFace(state->FrontFace);
 			}
 
 			// set the old value back
@@ -1039,13 +2162,11 @@ namespace ed
 		}
 
 		// window pixel color
-		uint8_t* mainPixelData = new uint8_t[(int)(rtSize.x * rtSize.y) * 4];
-		glBindTexture(GL_TEXTURE_2D, vertexPass->RenderTextures[0]);
-		glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, mainPixelData);
-		glBindTexture(GL_TEXTURE_2D, 0);
-		uint8_t* pxData = &mainPixelData[(x + y * (int)rtSize.x) * 4];
+		// only the picked pixel is needed - the pass FBO is still bound
+		uint8_t pxData[4] = { 0 };
+		glReadBuffer(GL_COLOR_ATTACHMENT0);
+		glReadPixels(x, y, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pxData);
 		int instanceID = (pxData[0] << 0) | (pxData[1] << 8) | (pxData[2] << 16);
-		delete[] mainPixelData;
 
 		// return old info
 		for (int i = 0; i < m_items.size(); i++) {
@@ -1067,6 +2188,8 @@ namespace ed
 	void RenderEngine::Pause(bool pause)
 	{
 		m_paused = pause;
+		m_computeTicks.clear(); // the fixed rate passes don't catch up on the paused time
+		m_timeline.Restart();
 
 		if (m_paused)
 			SystemVariableManager::Instance().GetTimeClock().Pause();
@@ -1075,167 +2198,39 @@ namespace ed
 
 		m_debug->ClearPixelList();
 	}
+	void RenderEngine::RenderBackground(int width, int height)
+	{
+		m_backgroundOnly = true;
+		Render(width, height);
+		m_backgroundOnly = false;
+	}
+	bool RenderEngine::HasBackgroundPasses()
+	{
+		for (PipelineItem* item : m_items)
+			if (m_isBackgroundPass(item))
+				return true;
+		return false;
+	}
+	bool RenderEngine::m_isBackgroundPass(PipelineItem* item)
+	{
+		// audio would stop & the fixed rate simulations would fall behind
+		return item->Type == PipelineItem::ItemType::AudioPass ||
+			(item->Type == PipelineItem::ItemType::ComputePass && ((pipe::ComputePass*)item->Data)->TickRate > 0.0f);
+	}
 	void RenderEngine::Recompile(const char * name)
 	{
 		Logger::Get().Log("Recompiling " + std::string(name)); 
 
 		m_msgs->BuildOccured = true;
 		m_msgs->CurrentItem = name;
-		
-		GLchar cMsg[1024] = { 0 };
 
 		int d3dCounter = 0;
 		for (int i = 0; i < m_items.size(); i++) {
 			PipelineItem* item = m_items[i];
 			if (strcmp(item->Name, name) == 0) {
-				if (item->Type == PipelineItem::ItemType::ShaderPass) {
-					pipe::ShaderPass* shader = (pipe::ShaderPass*)item->Data;
-
-					m_msgs->ClearGroup(name);
-
-					glDeleteShader(m_shaderSources[i].VS);
-					glDeleteShader(m_shaderSources[i].PS);
-					glDeleteShader(m_shaderSources[i].GS);
-
-					std::string psContent = "", vsContent = "",
-						vsEntry = shader->VSEntry,
-						psEntry = shader->PSEntry;
-					int lineBias = 0;
-
-					// pixel shader
-					m_msgs->CurrentItemType = 1;
-					if (ShaderTranscompiler::GetShaderTypeFromExtension(shader->PSPath) == ShaderLanguage::GLSL) {// GLSL
-						psContent = m_project->LoadProjectFile(shader->PSPath);
-						m_includeCheck(psContent, std::vector<std::string>(), lineBias);
-						m_applyMacros(psContent, shader);
-					} else { // HLSL / VK
-						psContent = ShaderTranscompiler::Transcompile(ShaderTranscompiler::GetShaderTypeFromExtension(shader->PSPath), m_project->GetProjectPath(std::string(shader->PSPath)), 1, shader->PSEntry, shader->Macros, shader->GSUsed, m_msgs, m_project);
-						psEntry = "main";
-					}
-
-					shader->Variables.UpdateTextureList(psContent);
-					GLuint ps = gl::CompileShader(GL_FRAGMENT_SHADER, psContent.c_str());
-					bool psCompiled = gl::CheckShaderCompilationStatus(ps, cMsg);
-
-					if (!psCompiled && ShaderTranscompiler::GetShaderTypeFromExtension(shader->PSPath) == ShaderLanguage::GLSL)
-						m_msgs->Add(gl::ParseMessages(name, 1, cMsg, lineBias));
-
-					// vertex shader
-					m_msgs->CurrentItemType = 0;
-					lineBias = 0;
-					if (ShaderTranscompiler::GetShaderTypeFromExtension(shader->VSPath) == ShaderLanguage::GLSL) {// GLSL
-						vsContent = m_project->LoadProjectFile(shader->VSPath);
-						m_includeCheck(vsContent, std::vector<std::string>(), lineBias);
-						m_applyMacros(vsContent, shader);
-					} else { // HLSL / VK
-						vsContent = ShaderTranscompiler::Transcompile(ShaderTranscompiler::GetShaderTypeFromExtension(shader->VSPath), m_project->GetProjectPath(std::string(shader->VSPath)), 0, shader->VSEntry, shader->Macros, shader->GSUsed, m_msgs, m_project);
-						vsEntry = "main";
-					}
-
-					GLuint vs = gl::CompileShader(GL_VERTEX_SHADER, vsContent.c_str());
-					bool vsCompiled = gl::CheckShaderCompilationStatus(vs, cMsg);
-
-					if (!vsCompiled && ShaderTranscompiler::GetShaderTypeFromExtension(shader->PSPath) == ShaderLanguage::GLSL)
-						m_msgs->Add(gl::ParseMessages(name, 0, cMsg, lineBias));
-
-					// geometry shader
-					bool gsCompiled = true;
-					GLuint gs = 0;
-					if (shader->GSUsed && strlen(shader->GSPath) > 0 && strlen(shader->GSEntry) > 0) {
-						std::string gsContent = "",
-							gsEntry = shader->GSEntry;
-
-						m_msgs->CurrentItemType = 2;
-						lineBias = 0;
-						if (ShaderTranscompiler::GetShaderTypeFromExtension(shader->GSPath) == ShaderLanguage::GLSL) {// GLSL
-							gsContent = m_project->LoadProjectFile(shader->GSPath);
-							m_includeCheck(gsContent, std::vector<std::string>(), lineBias);
-							m_applyMacros(gsContent, shader);
-						} else { // HLSL / VK
-							gsContent = ShaderTranscompiler::Transcompile(ShaderTranscompiler::GetShaderTypeFromExtension(shader->GSPath), m_project->GetProjectPath(std::string(shader->GSPath)), 2, shader->GSEntry, shader->Macros, shader->GSUsed, m_msgs, m_project);
-							gsEntry = "main";
-
-							// TODO: delete this when glslang fixes this https://github.com/KhronosGroup/glslang/issues/1660
-							m_msgs->Add(MessageStack::Type::Warning, name, "HLSL geometry shaders are currently not supported by glslang");
-						}
-
-						gs = gl::CompileShader(GL_GEOMETRY_SHADER, gsContent.c_str());
-						gsCompiled = gl::CheckShaderCompilationStatus(gs, cMsg);
-
-						if (!gsCompiled && ShaderTranscompiler::GetShaderTypeFromExtension(shader->GSPath) == ShaderLanguage::GLSL)
-							m_msgs->Add(gl::ParseMessages(name, 2, cMsg, lineBias));
-					}
-
-					if (m_shaders[i] != 0)
-						glDeleteProgram(m_shaders[i]);
-
-					if (!vsCompiled || !psCompiled || !gsCompiled) {
-						Logger::Get().Log("Shaders not compiled", true); 
-						m_msgs->Add(MessageStack::Type::Error, name, "Failed to compile the shader(s)");
-						m_shaders[i] = 0;
-					}
-					else {
-						m_msgs->Add(MessageStack::Type::Message, name, "Compiled the shaders.");
-
-						m_shaders[i] = glCreateProgram();
-						glAttachShader(m_shaders[i], vs);
-						glAttachShader(m_shaders[i], ps);
-						if (shader->GSUsed) glAttachShader(m_shaders[i], gs);
-						glLinkProgram(m_shaders[i]);
-					}
-
-					if (m_shaders[i] != 0)
-						shader->Variables.UpdateUniformInfo(m_shaders[i]);
-
-					m_shaderSources[i].VS = vs;
-					m_shaderSources[i].PS = ps;
-					m_shaderSources[i].GS = gs;
-				}
-				else if (item->Type == PipelineItem::ItemType::ComputePass && m_computeSupported) {
-					pipe::ComputePass *shader = (pipe::ComputePass *)item->Data;
-
-					m_msgs->ClearGroup(name);
-
-					std::string content = "", entry = shader->Entry;
-					int lineBias = 0;
-
-					// compute shader
-					m_msgs->CurrentItemType = 3;
-					if (ShaderTranscompiler::GetShaderTypeFromExtension(shader->Path) == ShaderLanguage::GLSL) {// GLSL
-						content = m_project->LoadProjectFile(shader->Path);
-						m_includeCheck(content, std::vector<std::string>(), lineBias);
-						m_applyMacros(content, shader);
-					} else { // HLSL / VK
-						content = ShaderTranscompiler::Transcompile(ShaderTranscompiler::GetShaderTypeFromExtension(shader->Path), m_project->GetProjectPath(std::string(shader->Path)), 3, entry, shader->Macros, false, m_msgs, m_project);
-						entry = "main";
-					}
-
-					// compute shader supported == version 4.3 == not needed: shader->Variables.UpdateTextureList(content);
-					GLuint cs = gl::CompileShader(GL_COMPUTE_SHADER, content.c_str());
-					bool compiled = gl::CheckShaderCompilationStatus(cs, cMsg);
-
-					if (!compiled && ShaderTranscompiler::GetShaderTypeFromExtension(shader->Path) == ShaderLanguage::GLSL)
-						m_msgs->Add(gl::ParseMessages(name, 3, cMsg, lineBias));
-
-					if (m_shaders[i] != 0)
-						glDeleteProgram(m_shaders[i]);
-
-					if (!compiled) {
-						Logger::Get().Log("Compute shader was not compiled", true);
-						m_msgs->Add(MessageStack::Type::Error, name, "Failed to compile the compute shader");
-						m_shaders[i] = 0;
-					} else {
-						m_msgs->Add(MessageStack::Type::Message, name, "Compiled the compute shader.");
-
-						m_shaders[i] = glCreateProgram();
-						glAttachShader(m_shaders[i], cs);
-						glLinkProgram(m_shaders[i]);
-					}
-
-					glDeleteShader(cs);
-
-					if (m_shaders[i] != 0)
-						shader->Variables.UpdateUniformInfo(m_shaders[i]);
+				if (item->Type == PipelineItem::ItemType::ShaderPass || (item->Type == PipelineItem::ItemType::ComputePass && m_computeSupported)) {
+					ReloadProfiler::Instance().Begin(name, "recompile");
+					m_queueCompile(item);
 				}
 				else if (item->Type == PipelineItem::ItemType::AudioPass) {
 					pipe::AudioPass *shader = (pipe::AudioPass *)item->Data;
@@ -1264,25 +2259,68 @@ namespace ed
 	}
 	void RenderEngine::RecompileFile(const char* fname)
 	{
+		if (strlen(fname) == 0)
+			return;
+
+		RecompileFiles(std::vector<std::string>(1, m_project->GetProjectPath(fname)), "save");
+	}
+	void RenderEngine::RecompileFiles(const std::vector<std::string>& files, const std::string& trigger, std::chrono::steady_clock::time_point changed)
+	{
+		std::unordered_set<std::string> changedPaths;
+		for (const auto& file : files) {
+			std::string path = IncludeCache::Normalize(file);
+			IncludeCache::Instance().Invalidate(path);
+			changedPaths.insert(path);
+		}
+
+		// the files could also be headers - every stage that includes one of them is affected too
+		auto isAffected = [&](const char* stagePath) -> bool {
+			if (strlen(stagePath) == 0)
+				return false;
+
+			std::string path = IncludeCache::Normalize(m_project->GetProjectPath(stagePath));
+			if (changedPaths.count(path) > 0)
+				return true;
+
+			std::vector<std::string> includes = IncludeCache::Instance().GetIncludes(path);
+			for (const auto& inc : includes)
+				if (changedPaths.count(inc) > 0)
+					return true;
+
+			return false;
+		};
+
 		for (int i = 0; i < m_items.size(); i++) {
 			PipelineItem* item = m_items[i];
 			if (item->Type == PipelineItem::ItemType::ShaderPass) {
 				pipe::ShaderPass* shader = (pipe::ShaderPass*)item->Data;
-				if (strcmp(shader->VSPath, fname) == 0 ||
-					strcmp(shader->PSPath, fname) == 0 ||
-					strcmp(shader->GSPath, fname) == 0)
-				{
-					Recompile(item->Name);
+
+				int stages = 0;
+				if (isAffected(shader->VSPath)) stages |= 1 << 0;
+				if (isAffected(shader->PSPath)) stages |= 1 << 1;
+				if (shader->GSUsed && isAffected(shader->GSPath)) stages |= 1 << 2;
+				if (shader->MSUsed && isAffected(shader->MSPath)) stages |= 1 << 5;
+				if (shader->MSUsed && shader->TSUsed && isAffected(shader->TSPath)) stages |= 1 << 4;
+
+				if (stages != 0) {
+					Logger::Get().Log("Recompiling " + std::string(item->Name));
+					m_msgs->BuildOccured = true;
+					ReloadProfiler::Instance().Begin(item->Name, trigger, changed);
+					m_queueCompile(item, false, std::vector<ShaderMacro>(), stages);
 				}
 			}
 			else if (item->Type == PipelineItem::ItemType::ComputePass && m_computeSupported) {
 				pipe::ComputePass* shader = (pipe::ComputePass*)item->Data;
-				if (strcmp(shader->Path, fname) == 0)
-					Recompile(item->Name);
+				if (isAffected(shader->Path)) {
+					Logger::Get().Log("Recompiling " + std::string(item->Name));
+					m_msgs->BuildOccured = true;
+					ReloadProfiler::Instance().Begin(item->Name, trigger, changed);
+					m_queueCompile(item);
+				}
 			}
 			else if (item->Type == PipelineItem::ItemType::AudioPass) {
 				pipe::AudioPass* shader = (pipe::AudioPass*)item->Data;
-				if (strcmp(shader->Path, fname) == 0)
+				if (isAffected(shader->Path))
 					Recompile(item->Name);
 			}
 		}
@@ -1298,16 +2336,29 @@ namespace ed
 		for (int i = 0; i < m_items.size(); i++) {
 			PipelineItem* item = m_items[i];
 			if (strcmp(item->Name, name) == 0) {
-				if (item->Type == PipelineItem::ItemType::ShaderPass) {
+				if (item->Type == PipelineItem::ItemType::ShaderPass && ((pipe::ShaderPass*)item->Data)->MSUsed) {
+					// the code editor only has the vertex, pixel & geometry shaders - mesh shader passes are built from their files
+					ReloadProfiler::Instance().Begin(name, "recompile");
+					m_queueCompile(item);
+				}
+				else if (item->Type == PipelineItem::ItemType::ShaderPass) {
 					pipe::ShaderPass* shader = (pipe::ShaderPass*)item->Data;
 					m_msgs->ClearGroup(name);
 
+					// these sources are newer than anything that is still being compiled
+					m_cancelCompile(item);
+					m_variantKeys[item] = 0;
+
+					ReloadProfiler& reload = ReloadProfiler::Instance();
+					reload.Begin(name, "recompile");
+					auto stepStart = std::chrono::steady_clock::now();
+
 					bool vsCompiled = true, psCompiled = true, gsCompiled = true;
 
 					// pixel shader
 					if (pssrc.size() > 0) {
 						m_msgs->CurrentItemType = 1;
-						shader->Variables.UpdateTextureList(pssrc);
+						shader->Variables.UpdateTextureList(pssrc, vssrc.size() > 0 ? vssrc : m_shaderSources[i].VSCode, gssrc.size() > 0 ? gssrc : m_shaderSources[i].GSCode);
 						GLuint ps = gl::CompileShader(GL_FRAGMENT_SHADER, pssrc.c_str());
 						psCompiled = gl::CheckShaderCompilationStatus(ps, cMsg);
 
@@ -1316,6 +2367,7 @@ namespace ed
 
 						glDeleteShader(m_shaderSources[i].PS);
 						m_shaderSources[i].PS = ps;
+						m_shaderSources[i].PSCode = pssrc;
 					}
 
 					// vertex shader
@@ -1329,6 +2381,7 @@ namespace ed
 
 						glDeleteShader(m_shaderSources[i].VS);
 						m_shaderSources[i].VS = vs;
+						m_shaderSources[i].VSCode = vssrc;
 					}
 
 					// geometry shader
@@ -1347,11 +2400,24 @@ namespace ed
 								m_msgs->Add(MessageStack::Type::Warning, name, "HLSL geometry shaders are currently not supported by glslang");
 
 							m_shaderSources[i].GS = gs;
+							m_shaderSources[i].GSCode = gssrc;
 						}
 					}
 
+					// stages of a program that was loaded from the program cache still have to be compiled
+					ShaderPack& pack = m_shaderSources[i];
+					if (pack.VS == 0 && pack.VSCode.size() > 0)
+						pack.VS = gl::CompileShader(GL_VERTEX_SHADER, pack.VSCode.c_str());
+					if (pack.PS == 0 && pack.PSCode.size() > 0)
+						pack.PS = gl::CompileShader(GL_FRAGMENT_SHADER, pack.PSCode.c_str());
+					if (pack.GS == 0 && pack.GSCode.size() > 0)
+						pack.GS = gl::CompileShader(GL_GEOMETRY_SHADER, pack.GSCode.c_str());
+
+					reload.Add(name, ReloadProfiler::GLCompile, ReloadProfiler::Elapsed(stepStart));
+
 					if (m_shaders[i] != 0)
 						glDeleteProgram(m_shaders[i]);
+					m_staticPasses.erase(m_items[i]);
 
 					if (!vsCompiled || !psCompiled || !gsCompiled) {
 						m_msgs->Add(MessageStack::Type::Error, name, "Failed to compile the shader(s)");
@@ -1360,20 +2426,40 @@ namespace ed
 					else {
 						m_msgs->Add(MessageStack::Type::Message, name, "Compiled the shaders.");
 
+						stepStart = std::chrono::steady_clock::now();
 						m_shaders[i] = glCreateProgram();
+						gl::SetObjectLabel(GL_PROGRAM, m_shaders[i], name);
 						glAttachShader(m_shaders[i], m_shaderSources[i].VS);
 						glAttachShader(m_shaders[i], m_shaderSources[i].PS);
 						if (shader->GSUsed) glAttachShader(m_shaders[i], m_shaderSources[i].GS);
 						glLinkProgram(m_shaders[i]);
+
+						GLint linked = 0;
+						glGetProgramiv(m_shaders[i], GL_LINK_STATUS, &linked); // waits for the driver so that the link isn't counted as reflection
+						reload.Add(name, ReloadProfiler::GLLink, ReloadProfiler::Elapsed(stepStart));
+
+						stepStart = std::chrono::steady_clock::now();
+						m_bindSystemBlock(m_shaders[i]);
 					}
 
-					if (m_shaders[i] != 0)
+					if (m_shaders[i] != 0) {
 						shader->Variables.UpdateUniformInfo(m_shaders[i]);
+						reload.Add(name, ReloadProfiler::Reflection, ReloadProfiler::Elapsed(stepStart));
+						reload.Finish(name);
+					} else
+						reload.Cancel(name);
 				}
 				else if (item->Type == PipelineItem::ItemType::ComputePass && m_computeSupported) {
 					pipe::ComputePass *shader = (pipe::ComputePass *)item->Data;
 					m_msgs->ClearGroup(name);
 
+					m_cancelCompile(item);
+					m_variantKeys[item] = 0;
+
+					ReloadProfiler& reload = ReloadProfiler::Instance();
+					reload.Begin(name, "recompile");
+					auto stepStart = std::chrono::steady_clock::now();
+
 					bool compiled = false;
 					GLuint cs = 0;
 
@@ -1387,6 +2473,7 @@ namespace ed
 						if (!compiled && ShaderTranscompiler::GetShaderTypeFromExtension(shader->Path) == ShaderLanguage::GLSL)
 							m_msgs->Add(gl::ParseMessages(name, 3, cMsg));
 					}
+					reload.Add(name, ReloadProfiler::GLCompile, ReloadProfiler::Elapsed(stepStart));
 
 					if (m_shaders[i] != 0)
 						glDeleteProgram(m_shaders[i]);
@@ -1400,13 +2487,26 @@ namespace ed
 					{
 						m_msgs->Add(MessageStack::Type::Message, name, "Compiled the compute shader.");
 
+						stepStart = std::chrono::steady_clock::now();
 						m_shaders[i] = glCreateProgram();
+						gl::SetObjectLabel(GL_PROGRAM, m_shaders[i], name);
 						glAttachShader(m_shaders[i], cs);
 						glLinkProgram(m_shaders[i]);
+
+						GLint linked = 0;
+						glGetProgramiv(m_shaders[i], GL_LINK_STATUS, &linked);
+						reload.Add(name, ReloadProfiler::GLLink, ReloadProfiler::Elapsed(stepStart));
+
+						stepStart = std::chrono::steady_clock::now();
+						m_bindSystemBlock(m_shaders[i]);
 					}
 
-					if (m_shaders[i] != 0)
+					if (m_shaders[i] != 0) {
 						shader->Variables.UpdateUniformInfo(m_shaders[i]);
+						reload.Add(name, ReloadProfiler::Reflection, ReloadProfiler::Elapsed(stepStart));
+						reload.Finish(name);
+					} else
+						reload.Cancel(name);
 
 					glDeleteShader(cs);
 				}
@@ -1429,10 +2529,18 @@ namespace ed
 	}
 	void RenderEngine::Pick(float sx, float sy, bool multiPick, std::function<void(PipelineItem*)> func)
 	{
-		m_pickAwaiting = true;
-		m_pickDist = std::numeric_limits<float>::infinity();
 		m_pickHandle = func;
 		m_wasMultiPick = multiPick;
+
+		if (Settings::Instance().Preview.GPUPicking) {
+			m_gpuPickCancel(); // only the latest click matters
+			m_gpuPickAwaiting = true;
+			m_gpuPickPixel = glm::ivec2(sx, sy);
+			return;
+		}
+
+		m_pickAwaiting = true;
+		m_pickDist = std::numeric_limits<float>::infinity();
 		
 		float mouseX = sx / (m_lastSize.x * 0.5f) - 1.0f;
 		float mouseY = sy / (m_lastSize.y * 0.5f) - 1.0f;
@@ -1555,33 +2663,11 @@ namespace ed
 			glm::vec3 minb = obj->Data->GetMinBound();
 			glm::vec3 maxb = obj->Data->GetMaxBound();
 
+			// the per mesh BVH only visits the triangles near the ray and skips everything behind the closest pick
 			float triDist = std::numeric_limits<float>::infinity();
-			if (ray::IntersectBox(minb, maxb, vec3Origin, vec3Dir, triDist)) { // TODO: test this optimization
-				if (triDist < m_pickDist) { // optimization: check if bounding box is closer than selected object
-					bool donetris = false;
-					for (auto& mesh : obj->Data->Meshes) {
-						for (int i = 0; i+2 < mesh.Vertices.size(); i+=3) {
-							glm::vec3 v0 = mesh.Vertices[i + 0].Position;
-							glm::vec3 v1 = mesh.Vertices[i + 1].Position;
-							glm::vec3 v2 = mesh.Vertices[i + 2].Position;
-
-							if (ray::IntersectTriangle(vec3Origin, vec3Dir, v0, v1, v2, triDist))
-								if (triDist < myDist) {
-									myDist = triDist;
-
-									if (triDist < m_pickDist) {
-										donetris = true;
-										break;
-									}
-								}
-						}
-
-						if (donetris)
-							break;
-					}
-				}
-				else myDist = triDist;
-			}
+			if (ray::IntersectBox(minb, maxb, vec3Origin, vec3Dir, triDist))
+				if (obj->Data->Intersect(vec3Origin, vec3Dir, triDist, m_pickDist))
+					myDist = triDist;
 		}
 		else if (item->Type == PipelineItem::ItemType::PluginItem) {
 			pipe::PluginItemData* obj = (pipe::PluginItemData*)item->Data;
@@ -1597,30 +2683,124 @@ namespace ed
 			AddPickedItem(item, multiPick);
 		}
 	}
-	void RenderEngine::AddPickedItem(PipelineItem* pipe, bool multiPick)
+	void RenderEngine::m_gpuPickRender(int width, int height)
 	{
-		// check if it already exists
-		bool skipAdd = false;
-		for (int i = 0; i < m_pick.size(); i++)
-			if (m_pick[i] == pipe) {
-				if (!multiPick) {
-					m_pick.clear();
-					m_pick.push_back(pipe);
-				}
-				skipAdd = true;
-				break;
-			}
+		m_gpuPickAwaiting = false;
 
-		// add item
-		if (!skipAdd) {
-			if (pipe == nullptr)
-				m_pick.clear();
-			else if (multiPick)
-				m_pick.push_back(pipe);
-			else {
-				m_pick.clear();
-				m_pick.push_back(pipe);
-			}
+		int x = m_gpuPickPixel.x, y = m_gpuPickPixel.y;
+		if (x < 0 || y < 0 || x >= width || y >= height)
+			return;
+
+		// same IDs as the ones used for the pixel debugger
+		Render(width, height, true);
+
+		if (m_gpuPickPBO == 0) {
+			glGenBuffers(1, &m_gpuPickPBO);
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, m_gpuPickPBO);
+			glBufferData(GL_PIXEL_PACK_BUFFER, 4, nullptr, GL_STREAM_READ);
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		}
+
+		m_bindReadFBO(m_rtColor);
+
+		// the copy happens on the GPU, the CPU only maps the buffer once the fence is signaled
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, m_gpuPickPBO);
+		glReadPixels(x, y, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+		m_gpuPickFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+	void RenderEngine::m_gpuPickPoll()
+	{
+		if (m_gpuPickFence == 0)
+			return;
+
+		GLenum status = glClientWaitSync(m_gpuPickFence, 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+			return;
+
+		glDeleteSync(m_gpuPickFence);
+		m_gpuPickFence = 0;
+
+		int id = 0;
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, m_gpuPickPBO);
+		uint8_t* pxData = (uint8_t*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, 4, GL_MAP_READ_BIT);
+		if (pxData != nullptr) {
+			id = (pxData[0] << 0) | (pxData[1] << 8) | (pxData[2] << 16);
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		PipelineItem* item = nullptr;
+		if (id != 0 && !m_isGSUsedSet(m_rtColor))
+			item = GetPipelineItemByID(id).second;
+
+		// full screen quads aren't pickable on the CPU either
+		if (item != nullptr && item->Type == PipelineItem::ItemType::Geometry) {
+			pipe::GeometryItem* geo = (pipe::GeometryItem*)item->Data;
+			if (geo->Type == pipe::GeometryItem::GeometryType::Rectangle ||
+				geo->Type == pipe::GeometryItem::GeometryType::ScreenQuadNDC)
+				item = nullptr;
+		}
+
+		if (item == nullptr)
+			m_pick.clear();
+		else
+			AddPickedItem(item, m_wasMultiPick);
+
+		if (m_pickHandle != nullptr)
+			m_pickHandle(m_pick.size() == 0 ? nullptr : m_pick[m_pick.size() - 1]);
+	}
+	void RenderEngine::m_bindReadFBO(GLuint tex)
+	{
+		if (m_readFBO == 0)
+			glGenFramebuffers(1, &m_readFBO);
+
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, m_readFBO);
+		glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex, 0);
+		glReadBuffer(GL_COLOR_ATTACHMENT0);
+	}
+	glm::u8vec4 RenderEngine::m_readPixel(GLuint tex, int x, int y)
+	{
+		glm::u8vec4 ret(0);
+		m_bindReadFBO(tex);
+		glReadPixels(x, y, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, glm::value_ptr(ret));
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+		return ret;
+	}
+	void RenderEngine::m_gpuPickCancel()
+	{
+		m_gpuPickAwaiting = false;
+		if (m_gpuPickFence != 0) {
+			glDeleteSync(m_gpuPickFence);
+			m_gpuPickFence = 0;
+		}
+	}
+	void RenderEngine::AddPickedItem(PipelineItem* pipe, bool multiPick)
+	{
+		// check if it already exists
+		bool skipAdd = false;
+		for (int i = 0; i < m_pick.size(); i++)
+			if (m_pick[i] == pipe) {
+				if (!multiPick) {
+					m_pick.clear();
+					m_pick.push_back(pipe);
+				}
+				skipAdd = true;
+				break;
+			}
+
+		// add item
+		if (!skipAdd) {
+			if (pipe == nullptr)
+				m_pick.clear();
+			else if (multiPick)
+				m_pick.push_back(pipe);
+			else {
+				m_pick.clear();
+				m_pick.push_back(pipe);
+			}
 		}
 	}
 	std::pair<PipelineItem*, PipelineItem*> RenderEngine::GetPipelineItemByID(int id)
@@ -1654,20 +2834,70 @@ namespace ed
 	}
 	void RenderEngine::FlushCache()
 	{
+		m_frameDirty = true;
+		m_contentGeneration++;
+		m_gpuPickCancel();
+		m_barrierState.clear();
+		m_lastUsed.clear();
+		m_batches.Clear();
+		m_batchPrograms.clear();
+		m_drawLists.clear();
+		m_tracePrograms.clear();
+		m_constantKeys.clear();
+
+		while (m_compileJobs.size() > 0)
+			m_cancelCompile(m_compileJobs[0]->Item, true);
+		m_deferredCompile.clear();
+		m_deleteVariants(nullptr);
+		m_compare.Stop();
+		m_tuner.Stop();
+		IncludeCache::Instance().Clear();
+		ReloadProfiler::Instance().Clear();
+
 		for (int i = 0; i < m_shaders.size(); i++) {
 			glDeleteShader(m_shaderSources[i].VS);
 			glDeleteShader(m_shaderSources[i].PS);
 			glDeleteShader(m_shaderSources[i].GS);
 			glDeleteProgram(m_shaders[i]);
+			glDeleteProgram(m_debugShaders[i]);
 		}
+		for (auto& cost : m_costShaders)
+			glDeleteProgram(cost.second);
+		m_costShaders.clear();
+		for (int i = 0; i < 2; i++) {
+			for (auto& overdraw : m_overdrawShaders[i])
+				glDeleteProgram(overdraw.second);
+			m_overdrawShaders[i].clear();
+		}
+		for (auto& prepass : m_prepassShaders)
+			glDeleteProgram(prepass.second);
+		m_prepassShaders.clear();
 		
 		m_fbos.clear();
 		m_fboCount.clear();
 		m_items.clear();
 		m_shaders.clear();
+		m_debugShaders.clear();
 		m_shaderSources.clear();
 		m_fbosNeedUpdate = true;
 
+		m_profiler.Clear();
+		m_timeline.Clear();
+		m_clearOcclusionQueries();
+		m_instanceCuller.Clear();
+		m_capture.Clear();
+		m_accumulator.Clear();
+		m_reduced.Clear();
+		m_slicer.Clear();
+		m_watchdog.Clear();
+		m_unusedReported.clear();
+		m_staticPasses.clear();
+		m_writeCount.clear();
+		m_computeTicks.clear();
+
+		m_rtUsage.clear();
+		m_rtPool.Clear();
+
 		// clear textures
 		glBindTexture(GL_TEXTURE_2D, m_rtColor);
 		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_lastSize.x, m_lastSize.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
@@ -1679,17 +2909,15 @@ namespace ed
 	}
 	void RenderEngine::m_cache()
 	{
+		ED_ZONE("RenderEngine::m_cache");
+
 		// check for any changes
 		std::vector<ed::PipelineItem*>& items = m_pipeline->GetList();
 
-		// check if no major changes were made, if so dont cache for another 0.25s
-		if (m_items.size() == items.size()) {
-			if (m_cacheTimer.GetElapsedTime() > 0.5f)
-				m_cacheTimer.Restart();
-			else return;
-		}
-
-		GLchar cMsg[1024];
+		// PipelineManager bumps the generation on every add/remove/move/rename, FlushCache() empties m_items
+		if (m_cachedGeneration == m_pipeline->GetGeneration() && m_items.size() == items.size())
+			return;
+		m_cachedGeneration = m_pipeline->GetGeneration();
 
 		// check if some item was added
 		for (int i = 0; i < items.size(); i++) {
@@ -1716,122 +2944,24 @@ namespace ed
 						continue;
 					}
 
-					glDeleteShader(m_shaderSources[i].VS);
-					glDeleteShader(m_shaderSources[i].PS);
-					glDeleteShader(m_shaderSources[i].GS);
-
 					/*
 						ITEM CACHING
 					*/
 
 					m_fbos[data].resize(MAX_RENDER_TEXTURES);
 
-					GLuint ps = 0, vs = 0, gs = 0;
-
-					m_msgs->CurrentItem = items[i]->Name;
-
-					std::string psContent = "", vsContent = "",
-						vsEntry = data->VSEntry,
-						psEntry = data->PSEntry;
-					int lineBias = 0;
-
-					// vertex shader
-					m_msgs->CurrentItemType = 0;
-					if (ShaderTranscompiler::GetShaderTypeFromExtension(data->VSPath) == ShaderLanguage::GLSL) { // GLSL
-						vsContent = m_project->LoadProjectFile(data->VSPath);
-						m_includeCheck(vsContent, std::vector<std::string>(), lineBias);
-						m_applyMacros(vsContent, data);
-					} else { // HLSL / VK
-						vsContent = ShaderTranscompiler::Transcompile(ShaderTranscompiler::GetShaderTypeFromExtension(data->VSPath), m_project->GetProjectPath(std::string(data->VSPath)), 0, data->VSEntry, data->Macros, data->GSUsed, m_msgs, m_project);
-						vsEntry = "main";
-					}
-					
-					vs = gl::CompileShader(GL_VERTEX_SHADER, vsContent.c_str());
-					bool vsCompiled = gl::CheckShaderCompilationStatus(vs, cMsg);
-
-					if (!vsCompiled && ShaderTranscompiler::GetShaderTypeFromExtension(data->VSPath) == ShaderLanguage::GLSL)
-						m_msgs->Add(gl::ParseMessages(m_msgs->CurrentItem, 0, cMsg, lineBias));
-
-					// pixel shader
-					m_msgs->CurrentItemType = 1;
-					lineBias = 0;
-					if (ShaderTranscompiler::GetShaderTypeFromExtension(data->PSPath) == ShaderLanguage::GLSL) { // GLSL
-						psContent = m_project->LoadProjectFile(data->PSPath);
-						m_includeCheck(psContent, std::vector<std::string>(), lineBias);
-						m_applyMacros(psContent, data);
-					} else { // HLSL / VK
-						psContent = ShaderTranscompiler::Transcompile(ShaderTranscompiler::GetShaderTypeFromExtension(data->PSPath), m_project->GetProjectPath(std::string(data->PSPath)), 1, data->PSEntry, data->Macros, data->GSUsed, m_msgs, m_project);
-						psEntry = "main";
-					}
-
-					data->Variables.UpdateTextureList(psContent);
-					ps = gl::CompileShader(GL_FRAGMENT_SHADER, psContent.c_str());
-					bool psCompiled = gl::CheckShaderCompilationStatus(ps, cMsg);
-
-					if (!psCompiled && ShaderTranscompiler::GetShaderTypeFromExtension(data->PSPath) == ShaderLanguage::GLSL)
-						m_msgs->Add(gl::ParseMessages(m_msgs->CurrentItem, 1, cMsg, lineBias));
-
-					// geometry shader
-					lineBias = 0;
-					bool gsCompiled = true;
-					if (data->GSUsed && strlen(data->GSEntry) > 0 && strlen(data->GSPath) > 0) {
-						std::string gsContent = "", gsEntry = data->GSEntry;
-						m_msgs->CurrentItemType = 2;
-						if (ShaderTranscompiler::GetShaderTypeFromExtension(data->GSPath) == ShaderLanguage::GLSL) { // GLSL
-							gsContent = m_project->LoadProjectFile(data->GSPath);
-							m_includeCheck(gsContent, std::vector<std::string>(), lineBias);
-							m_applyMacros(gsContent, data);
-						} else { // HLSL
-							gsContent = ShaderTranscompiler::Transcompile(ShaderTranscompiler::GetShaderTypeFromExtension(data->GSPath), m_project->GetProjectPath(std::string(data->GSPath)), 2, data->GSEntry, data->Macros, data->GSUsed, m_msgs, m_project);
-							gsEntry = "main";
-							
-							m_msgs->Add(MessageStack::Type::Warning, m_msgs->CurrentItem, "Geometry shaders are currently not supported by glslang");
-						}
-
-						gs = gl::CompileShader(GL_GEOMETRY_SHADER, gsContent.c_str());
-						gsCompiled = gl::CheckShaderCompilationStatus(gs, cMsg);
-
-						if (!gsCompiled && ShaderTranscompiler::GetShaderTypeFromExtension(data->GSPath) == ShaderLanguage::GLSL)
-							m_msgs->Add(gl::ParseMessages(m_msgs->CurrentItem, 2, cMsg, lineBias));
-
-					}
-
-					if (m_shaders[i] != 0)
-						glDeleteProgram(m_shaders[i]);
-
-					if (m_debugShaders[i] != 0)
-						glDeleteProgram(m_debugShaders[i]);
-
-					if (!vsCompiled || !psCompiled || !gsCompiled) {
-						m_msgs->Add(MessageStack::Type::Error, items[i]->Name, "Failed to compile the shader");
-						m_shaders[i] = 0;
-					} else {
-						m_msgs->ClearGroup(items[i]->Name);
-
-						m_shaders[i] = glCreateProgram();
-						glAttachShader(m_shaders[i], vs);
-						glAttachShader(m_shaders[i], ps);
-						if (data->GSUsed) glAttachShader(m_shaders[i], gs);
-						glLinkProgram(m_shaders[i]);
-
-						m_debugShaders[i] = glCreateProgram();
-						glAttachShader(m_debugShaders[i], m_debugPixelShader);
-						glAttachShader(m_debugShaders[i], vs);
-						glLinkProgram(m_debugShaders[i]);
-					}
-
-					if (m_shaders[i] != 0)
-						data->Variables.UpdateUniformInfo(m_shaders[i]);
-
-					m_shaderSources[i].VS = vs;
-					m_shaderSources[i].PS = ps;
-					m_shaderSources[i].GS = gs;
+					// disabled variants don't hold back the first frame
+					if (data->Active)
+						m_queueCompile(items[i]);
+					else
+						m_deferredCompile.insert(items[i]);
 				} 
 				else if (items[i]->Type == PipelineItem::ItemType::ComputePass && m_computeSupported) {
 					pipe::ComputePass *data = reinterpret_cast<ed::pipe::ComputePass *>(items[i]->Data);
 
 					m_items.insert(m_items.begin() + i, items[i]);
 					m_shaders.insert(m_shaders.begin() + i, 0);
+					m_debugShaders.insert(m_debugShaders.begin() + i, 0);
 					m_shaderSources.insert(m_shaderSources.begin() + i, ShaderPack());
 
 					if (strlen(data->Path) == 0) {
@@ -1843,59 +2973,14 @@ namespace ed
 						ITEM CACHING
 					*/
 
-					GLuint cs = 0;
-
-					m_msgs->CurrentItem = items[i]->Name;
-
-					std::string content = "", entry = data->Entry;
-					int lineBias = 0;
-
-					// vertex shader
-					m_msgs->CurrentItemType = 3;
-					if (ShaderTranscompiler::GetShaderTypeFromExtension(data->Path) == ShaderLanguage::GLSL) { // GLSL
-						content = m_project->LoadProjectFile(data->Path);
-						m_includeCheck(content, std::vector<std::string>(), lineBias);
-						m_applyMacros(content, data);
-					} else { // HLSL / VK
-						content = ShaderTranscompiler::Transcompile(ShaderTranscompiler::GetShaderTypeFromExtension(data->Path), m_project->GetProjectPath(std::string(data->Path)), 3, entry, data->Macros, false, m_msgs, m_project);
-						entry = "main";
-					}
-
-					cs = gl::CompileShader(GL_COMPUTE_SHADER, content.c_str());
-					bool compiled = gl::CheckShaderCompilationStatus(cs, cMsg);
-
-					if (!compiled && ShaderTranscompiler::GetShaderTypeFromExtension(data->Path) == ShaderLanguage::GLSL)
-						m_msgs->Add(gl::ParseMessages(m_msgs->CurrentItem, 3, cMsg, lineBias));
-
-					if (m_shaders[i] != 0)
-						glDeleteProgram(m_shaders[i]);
-
-					if (!compiled)
-					{
-						m_msgs->Add(MessageStack::Type::Error, items[i]->Name, "Failed to compile the compute shader");
-						m_shaders[i] = 0;
-					}
-					else
-					{
-						m_msgs->ClearGroup(items[i]->Name);
-
-						m_shaders[i] = glCreateProgram();
-						glAttachShader(m_shaders[i], cs);
-						glLinkProgram(m_shaders[i]);
-					}
-
-					if (m_shaders[i] != 0)
-						data->Variables.UpdateUniformInfo(m_shaders[i]);
-
-					m_shaderSources[i].VS = 0;
-					m_shaderSources[i].PS = 0;
-					m_shaderSources[i].GS = 0;
+					m_queueCompile(items[i]);
 				} 
 				else if (items[i]->Type == PipelineItem::ItemType::AudioPass) {
 					pipe::AudioPass *data = reinterpret_cast<ed::pipe::AudioPass *>(items[i]->Data);
 
 					m_items.insert(m_items.begin() + i, items[i]);
 					m_shaders.insert(m_shaders.begin() + i, 0);
+					m_debugShaders.insert(m_debugShaders.begin() + i, 0);
 					m_shaderSources.insert(m_shaderSources.begin() + i, ShaderPack());
 
 					/*
@@ -1918,6 +3003,7 @@ namespace ed
 
 					m_items.insert(m_items.begin() + i, items[i]);
 					m_shaders.insert(m_shaders.begin() + i, 0);
+					m_debugShaders.insert(m_debugShaders.begin() + i, 0);
 					m_shaderSources.insert(m_shaderSources.begin() + i, ShaderPack());
 				}
 			}
@@ -1933,13 +3019,37 @@ namespace ed
 				}
 
 			if (!found) {
+				m_cancelCompile(m_items[i], true);
+				m_deferredCompile.erase(m_items[i]);
+
 				glDeleteProgram(m_shaders[i]);
 				glDeleteProgram(m_debugShaders[i]);
+				m_deleteInstrumentedShaders(m_items[i]);
+				m_deleteVariants(m_items[i]);
+				if (m_compare.GetPass() == m_items[i])
+					m_compare.Stop();
+				if (m_tuner.GetPass() == m_items[i])
+					m_tuner.Stop();
 
 				Logger::Get().Log("Removing an item from cache");
 
-				if (m_items[i]->Type == PipelineItem::ItemType::ShaderPass)
+				m_profiler.Remove(m_items[i]);
+				m_slicer.Release(m_items[i]);
+				m_watchdog.Release(m_items[i]);
+				m_unusedReported.erase(m_items[i]);
+				m_staticPasses.erase(m_items[i]);
+				m_computeTicks.erase(m_items[i]);
+
+				if (m_items[i]->Type == PipelineItem::ItemType::ShaderPass) {
+					for (PipelineItem* child : ((pipe::ShaderPass*)m_items[i]->Data)->Items) {
+						m_clearOcclusionQueries(child);
+						m_instanceCuller.Release(child);
+					}
+					m_accumulator.Release((pipe::ShaderPass*)m_items[i]->Data);
+					m_reduced.Release((pipe::ShaderPass*)m_items[i]->Data);
 					m_fbos.erase((pipe::ShaderPass*)m_items[i]->Data);
+					m_drawLists.erase((pipe::ShaderPass*)m_items[i]->Data);
+				}
 				
 				m_items.erase(m_items.begin() + i);
 				m_shaders.erase(m_shaders.begin() + i);
@@ -1979,129 +3089,2256 @@ namespace ed
 			}
 		}
 	}
-	bool RenderEngine::m_isGSUsedSet(GLuint rt)
+	void RenderEngine::m_queueActivatedPasses()
 	{
-		bool ret = false;
-		for (int i = 0; i < m_items.size(); i++) {
-			if (m_items[i]->Type == PipelineItem::ItemType::ShaderPass) {
-				pipe::ShaderPass* pass = (pipe::ShaderPass*)m_items[i]->Data;
-				for (int j = 0; j < pass->RTCount; j++)
-					if (pass->RenderTextures[j] == rt)
-						ret = pass->GSUsed;
-			}
-		}
+		if (m_deferredCompile.empty())
+			return;
 
-		return ret;
+		std::vector<PipelineItem*> activated;
+		for (PipelineItem* item : m_deferredCompile)
+			if (((pipe::ShaderPass*)item->Data)->Active)
+				activated.push_back(item);
+
+		// pipeline order, the passes that are drawn first are also compiled first
+		for (PipelineItem* item : m_items)
+			if (std::count(activated.begin(), activated.end(), item) > 0) {
+				Logger::Get().Log("Compiling " + std::string(item->Name) + " now that it's turned on");
+				m_queueCompile(item);
+			}
 	}
-	void RenderEngine::m_applyMacros(std::string  &src, pipe::ShaderPass *pass)
+	void RenderEngine::UpdateCompilation()
 	{
-		size_t verLoc = src.find_first_of("#version");
-		size_t lineLoc = src.find_first_of('\n', verLoc + 1) + 1;
-		std::string strMacro = "";
-
-		for (auto &macro : pass->Macros)
-		{
-			if (!macro.Active)
+		// Render() polls the jobs too - this keeps the compilation going while the preview is paused
+		if (m_pollCompileJobs() && m_paused)
+			Render();
+	}
+	void RenderEngine::m_barrierWrite(const std::vector<BindingDescriptor>& ubos, GLbitfield issued)
+	{
+		for (const auto& ubo : ubos) {
+			GLuint64 key = 0;
+			if (ubo.Type == BindingDescriptor::BindType::Image2D || ubo.Type == BindingDescriptor::BindType::Image3D)
+				key = getBarrierKey(false, ubo.ID);
+			else if (ubo.Type == BindingDescriptor::BindType::Buffer)
+				key = getBarrierKey(true, ubo.ID);
+			else
 				continue;
 
-			strMacro += "#define " + std::string(macro.Name) + " " + std::string(macro.Value) + "\n";
+			m_barrierState[key] = issued;
+			m_writeCount[key]++;
 		}
-
-		if (strMacro.size() > 0)
-			src.insert(lineLoc, strMacro);
 	}
-	void RenderEngine::m_applyMacros(std::string  &src, pipe::ComputePass *pass)
+	void RenderEngine::m_barrierRead(PipelineItem* pass, const std::vector<BindingDescriptor>& srvs, const std::vector<BindingDescriptor>& ubos)
 	{
-		size_t verLoc = src.find_first_of("#version");
-		size_t lineLoc = src.find_first_of('\n', verLoc + 1) + 1;
-		std::string strMacro = "";
+		m_markUsed(pass, srvs, ubos);
 
-		for (auto &macro : pass->Macros)
-		{
-			if (!macro.Active)
-				continue;
+		if (m_barrierState.empty())
+			return;
 
-			strMacro += "#define " + std::string(macro.Name) + " " + std::string(macro.Value) + "\n";
+		GLbitfield bits = 0;
+		auto read = [&](bool isBuffer, GLuint id, GLbitfield bit) {
+			auto state = m_barrierState.find(getBarrierKey(isBuffer, id));
+			if (state != m_barrierState.end() && (state->second & bit) != bit)
+				bits |= bit;
+		};
+
+		if (pass->Type == PipelineItem::ItemType::PluginItem) {
+			// no idea what the plugin does with the resources
+			bits = GL_ALL_BARRIER_BITS;
+		} else {
+			bool isCompute = pass->Type == PipelineItem::ItemType::ComputePass || pass->Type == PipelineItem::ItemType::AudioPass;
+
+			for (const auto& srv : srvs)
+				if (srv.Type != BindingDescriptor::BindType::Plugin)
+					read(false, srv.ID, GL_TEXTURE_FETCH_BARRIER_BIT);
+
+			for (const auto& ubo : ubos) {
+				if (ubo.Type == BindingDescriptor::BindType::Image2D || ubo.Type == BindingDescriptor::BindType::Image3D)
+					read(false, ubo.ID, GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+				else if (ubo.Type == BindingDescriptor::BindType::Buffer)
+					read(true, ubo.ID, isCompute ? GL_SHADER_STORAGE_BARRIER_BIT : GL_UNIFORM_BARRIER_BIT);
+			}
+
+			// indirect dispatch & mesh task arguments
+			if (pass->Type == PipelineItem::ItemType::ComputePass) {
+				BufferObject* indirect = (BufferObject*)((pipe::ComputePass*)pass->Data)->IndirectBuffer;
+				if (indirect != nullptr)
+					read(true, indirect->ID, GL_COMMAND_BARRIER_BIT);
+			} else if (pass->Type == PipelineItem::ItemType::ShaderPass && ((pipe::ShaderPass*)pass->Data)->MSUsed) {
+				BufferObject* tasks = (BufferObject*)((pipe::ShaderPass*)pass->Data)->MeshTaskBuffer;
+				if (tasks != nullptr)
+					read(true, tasks->ID, GL_COMMAND_BARRIER_BIT);
+			}
+
+			// instance buffers
+			if (pass->Type == PipelineItem::ItemType::ShaderPass) {
+				for (PipelineItem* item : ((pipe::ShaderPass*)pass->Data)->Items) {
+					BufferObject* buffer = nullptr;
+					if (item->Type == PipelineItem::ItemType::Geometry)
+						buffer = (BufferObject*)((pipe::GeometryItem*)item->Data)->InstanceBuffer;
+					else if (item->Type == PipelineItem::ItemType::Model)
+						buffer = (BufferObject*)((pipe::Model*)item->Data)->InstanceBuffer;
+
+					if (buffer != nullptr)
+						read(true, buffer->ID, GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+				}
+			}
 		}
 
-		if (strMacro.size() > 0)
-			src.insert(lineLoc, strMacro);
+		if (bits == 0)
+			return;
+
+		// barriers are global - every earlier write is now visible to these accesses
+		glMemoryBarrier(bits);
+		for (auto& state : m_barrierState)
+			state.second |= bits;
 	}
-	void RenderEngine::m_applyMacros(std::string  &src, pipe::AudioPass *pass)
+	void RenderEngine::m_markUsed(PipelineItem* pass, const std::vector<BindingDescriptor>& srvs, const std::vector<BindingDescriptor>& ubos)
 	{
-		size_t verLoc = src.find_first_of("#version");
-		size_t lineLoc = src.find_first_of('\n', verLoc + 1) + 1;
-		std::string strMacro = "";
-
-		for (auto &macro : pass->Macros)
-		{
-			if (!macro.Active)
-				continue;
+		for (const auto& srv : srvs)
+			if (srv.Type != BindingDescriptor::BindType::Plugin)
+				m_lastUsed[getBarrierKey(false, srv.ID)] = m_frameIndex;
+		for (const auto& ubo : ubos)
+			if (ubo.Type != BindingDescriptor::BindType::Plugin)
+				m_lastUsed[getBarrierKey(ubo.Type == BindingDescriptor::BindType::Buffer, ubo.ID)] = m_frameIndex;
+
+		if (pass->Type == PipelineItem::ItemType::ComputePass) {
+			BufferObject* indirect = (BufferObject*)((pipe::ComputePass*)pass->Data)->IndirectBuffer;
+			if (indirect != nullptr)
+				m_lastUsed[getBarrierKey(true, indirect->ID)] = m_frameIndex;
+			BufferObject* condition = (BufferObject*)((pipe::ComputePass*)pass->Data)->ConditionBuffer;
+			if (condition != nullptr)
+				m_lastUsed[getBarrierKey(true, condition->ID)] = m_frameIndex;
+		} else if (pass->Type == PipelineItem::ItemType::ShaderPass) {
+			pipe::ShaderPass* data = (pipe::ShaderPass*)pass->Data;
+			for (int i = 0; i < data->RTCount; i++)
+				m_lastUsed[getBarrierKey(false, data->RenderTextures[i])] = m_frameIndex;
+			if (data->MSUsed && data->MeshTaskBuffer != nullptr)
+				m_lastUsed[getBarrierKey(true, ((BufferObject*)data->MeshTaskBuffer)->ID)] = m_frameIndex;
+			if (data->ConditionBuffer != nullptr)
+				m_lastUsed[getBarrierKey(true, ((BufferObject*)data->ConditionBuffer)->ID)] = m_frameIndex;
+			if (data->CaptureBuffer != nullptr)
+				m_lastUsed[getBarrierKey(true, ((BufferObject*)data->CaptureBuffer)->ID)] = m_frameIndex;
+
+			// vertex & instance buffers
+			for (PipelineItem* item : data->Items) {
+				BufferObject* instances = nullptr;
+				if (item->Type == PipelineItem::ItemType::Geometry) {
+					pipe::GeometryItem* geo = (pipe::GeometryItem*)item->Data;
+					m_lastUsed[getBarrierKey(true, geo->VBO)] = m_frameIndex;
+					instances = (BufferObject*)geo->InstanceBuffer;
+				} else if (item->Type == PipelineItem::ItemType::Model) {
+					pipe::Model* model = (pipe::Model*)item->Data;
+					if (model->Data != nullptr)
+						for (const auto& mesh : model->Data->Meshes) {
+							m_lastUsed[getBarrierKey(true, mesh.VBO)] = m_frameIndex;
+							m_lastUsed[getBarrierKey(true, mesh.EBO)] = m_frameIndex;
+						}
+					instances = (BufferObject*)model->InstanceBuffer;
+				}
 
-			strMacro += "#define " + std::string(macro.Name) + " " + std::string(macro.Value) + "\n";
+				if (instances != nullptr)
+					m_lastUsed[getBarrierKey(true, instances->ID)] = m_frameIndex;
+			}
 		}
-
-		if (strMacro.size() > 0)
-			src.insert(lineLoc, strMacro);
 	}
-	void RenderEngine::m_includeCheck(std::string &src, std::vector<std::string> includeStack, int& lineBias)
+	unsigned int RenderEngine::GetLastUsed(bool isBuffer, GLuint id)
 	{
-		size_t incLoc = src.find("#include");
-		Settings& settings = Settings::Instance();
+		auto used = m_lastUsed.find(getBarrierKey(isBuffer, id));
+		return used == m_lastUsed.end() ? 0 : used->second;
+	}
+	void RenderEngine::GetInternalTextures(std::vector<InternalTexture>& out)
+	{
+		out.push_back({ "Window color", GL_TEXTURE_2D, m_rtColor });
+		out.push_back({ "Window depth", GL_TEXTURE_2D, m_rtDepth });
+		out.push_back({ "Window color (MSAA)", GL_TEXTURE_2D_MULTISAMPLE, m_rtColorMS });
+		out.push_back({ "Window depth (MSAA)", GL_TEXTURE_2D_MULTISAMPLE, m_rtDepthMS });
+		for (int i = 0; i < RENDER_OUTPUT_BUFFERS; i++)
+			out.push_back({ "Preview output " + std::to_string(i), GL_TEXTURE_2D, m_outputTex[i] });
+
+		// depth & multisampled attachments of the render textures
+		const auto& slots = m_rtPool.GetSlots();
+		for (size_t i = 0; i < slots.size(); i++)
+			out.push_back({ "Shared attachment " + std::to_string(i), slots[i].Samples > 0 ? GL_TEXTURE_2D_MULTISAMPLE : slots[i].Target, slots[i].Texture });
+
+		std::vector<GLuint> accumulation;
+		m_accumulator.GetTextures(accumulation);
+		for (size_t i = 0; i < accumulation.size(); i++)
+			out.push_back({ "Accumulation " + std::to_string(i), GL_TEXTURE_2D, accumulation[i] });
+
+		std::vector<GLuint> reduced;
+		m_reduced.GetTextures(reduced);
+		for (size_t i = 0; i < reduced.size(); i++)
+			out.push_back({ "Reduced resolution " + std::to_string(i), GL_TEXTURE_2D, reduced[i] });
+
+		out.push_back({ "Cost heatmap", GL_TEXTURE_2D, m_costTexture });
+		out.push_back({ "Overdraw heatmap", GL_TEXTURE_2D, m_overdrawTexture });
+	}
+	void RenderEngine::m_barrierEndFrame()
+	{
+		// the UI shows the images and reads the buffers back - the passes from the next frame are handled by m_barrierRead()
+		GLbitfield bits = 0;
+		for (const auto& state : m_barrierState) {
+			bool isBuffer = state.first >> 32;
+			GLbitfield needed = isBuffer ? GL_BUFFER_UPDATE_BARRIER_BIT : (GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+			bits |= needed & ~state.second;
+		}
 
-		std::vector<std::string> paths = settings.Project.IncludePaths;
-		paths.push_back(".");
+		if (bits == 0)
+			return;
 
-		while (incLoc != std::string::npos) {
-			bool isAfterNewline = true;
-			if (incLoc != 0)
-				if (src[incLoc - 1] != '\n')
-					isAfterNewline = false;
+		glMemoryBarrier(bits);
+		for (auto& state : m_barrierState)
+			state.second |= bits;
+	}
+	bool RenderEngine::CanReuseFrame(int width, int height)
+	{
+		if (!Settings::Instance().Preview.SkipIdleFrames || m_frameDirty || m_pickAwaiting || m_gpuPickAwaiting || m_compileJobs.size() > 0 || m_compare.IsActive() || m_tuner.IsRunning())
+			return false;
 
-			if (!isAfterNewline) {
-				incLoc = src.find("#include", incLoc + 1);
-				continue;
-			}
+		if (m_lastSize.x != width || m_lastSize.y != height || m_frameGeneration != m_pipeline->GetGeneration())
+			return false;
 
-			size_t quotePos = src.find_first_of("\"<", incLoc);
-			size_t quoteEnd = src.find_first_of("\">", quotePos + 1);
-			std::string fileName = src.substr(quotePos+1, quoteEnd - quotePos-1);
+		return m_isFrameStatic();
+	}
+	bool RenderEngine::m_isFrameStatic()
+	{
+		// plugins can change anything at any time
+		if (m_plugins->Plugins().size() > 0)
+			return false;
+
+		// audio changes every frame, render textures that aren't cleared & the history objects accumulate
+		for (const auto& name : m_objects->GetObjects()) {
+			if (m_objects->IsAudio(name) || m_objects->IsPluginObject(name))
+				return false;
+			if (m_objects->IsRenderTexture(name) && !m_objects->GetRenderTexture(name)->Clear)
+				return false;
+			if (m_objects->IsRenderTextureHistory(name))
+				return false;
+		}
 
-			for (int i = 0; i < paths.size(); i++) {
-				std::string ipath = paths[i];
-				char last = ipath[ipath.size() - 1];
-				if (last != '\\' && last != '/')
-					ipath += "/";
+		for (int i = 0; i < m_items.size(); i++) {
+			PipelineItem* item = m_items[i];
 
-				ipath += fileName;
+			// compute passes usually work on the results of the previous frame
+			if (item->Type != PipelineItem::ItemType::ShaderPass)
+				return false;
+
+			// SHADERed_Globals has the time & frame index
+			if (m_shaders[i] != 0 && (glGetUniformBlockIndex(m_shaders[i], "SHADERed_Globals") != GL_INVALID_INDEX ||
+				glGetUniformBlockIndex(m_shaders[i], "type_SHADERed_Globals") != GL_INVALID_INDEX))
+				return false;
+
+			pipe::ShaderPass* data = (pipe::ShaderPass*)item->Data;
+			if (data->Active && data->Accumulate && !m_accumulator.IsDone(data))
+				return false;
+
+			for (PipelineItem* child : data->Items) {
+				if (child->Type == PipelineItem::ItemType::Geometry && ((pipe::GeometryItem*)child->Data)->Type == pipe::GeometryItem::Generated &&
+					((pipe::GeometryItem*)child->Data)->GenAnimated)
+					return false;
+				if (child->Type == PipelineItem::ItemType::Model && ((pipe::Model*)child->Data)->Data != nullptr &&
+					((pipe::Model*)child->Data)->Data->IsSkinned() && ((pipe::Model*)child->Data)->Animation[0] != 0)
+					return false;
+			}
 
-				src.erase(incLoc, src.find_first_of('\n', incLoc) - incLoc);
+			for (ShaderVariable* var : data->Variables.GetVariables()) {
+				SystemShaderVariable sys = var->System;
+				if (sys == SystemShaderVariable::Time || sys == SystemShaderVariable::TimeDelta || sys == SystemShaderVariable::FrameIndex ||
+					sys == SystemShaderVariable::MousePosition || sys == SystemShaderVariable::Mouse || sys == SystemShaderVariable::MouseButton ||
+					sys == SystemShaderVariable::KeysWASD || sys == SystemShaderVariable::PluginVariable || sys == SystemShaderVariable::AudioPosition)
+					return false;
 
-				if (std::count(includeStack.begin(), includeStack.end(), ipath) > 0)
-					m_msgs->Add(ed::MessageStack::Type::Error, m_msgs->CurrentItem, "Recursive #include detected");
+				// the pointed variable could be anything
+				if (var->Function == FunctionShaderVariable::Pointer)
+					return false;
+			}
+		}
 
-				if (m_project->FileExists(ipath) && std::count(includeStack.begin(), includeStack.end(), ipath) == 0) {
-					includeStack.push_back(ipath);
+		return true;
+	}
+	void RenderEngine::m_pollWatchdog()
+	{
+		for (const auto& trip : m_watchdog.Poll()) {
+			PipelineItem* item = trip.Item;
+			std::string time = std::to_string((int)trip.Time) + "ms" + (trip.Running ? " and is still running" : "");
 
-					std::string incFileSrc = m_project->LoadProjectFile(ipath);
-					lineBias = std::count(incFileSrc.begin(), incFileSrc.end(), '\n');
+			if (item->Type == PipelineItem::ItemType::ShaderPass) {
+				// turning it back on is up to the user
+				((pipe::ShaderPass*)item->Data)->Active = false;
+				m_watchdog.Release(item);
+				m_project->ModifyProject();
+
+				m_msgs->Add(MessageStack::Type::Error, item->Name, "The pass took " + time + " on the GPU, over the budget of " +
+					std::to_string(Settings::Instance().Preview.PassBudget) + "ms - it was deactivated");
+			} else
+				m_msgs->Add(MessageStack::Type::Error, item->Name, "The pass took " + time + " on the GPU, over the budget of " +
+					std::to_string(Settings::Instance().Preview.PassBudget) + "ms - it is skipped until it's recompiled");
+
+			Logger::Get().Log("Pass " + std::string(item->Name) + " went over the GPU time budget (" + time + ")", true);
+			InvalidatePassCache();
+		}
+	}
+	GLuint RenderEngine::m_getComputeTicks(PipelineItem* item, float rate)
+	{
+		auto now = std::chrono::steady_clock::now();
+		auto found = m_computeTicks.find(item);
+		if (found == m_computeTicks.end()) {
+			m_computeTicks[item] = { now, 0.0 };
+			return 1;
+		}
 
-					m_includeCheck(incFileSrc, includeStack, lineBias);
+		ComputeTick& tick = found->second;
+		tick.Pending += std::chrono::duration<double>(now - tick.Last).count() * rate;
+		tick.Last = now;
 
-					src.insert(incLoc, incFileSrc);
+		GLuint steps = (GLuint)std::min<double>(tick.Pending, COMPUTE_TICK_MAX_STEPS);
+		if (steps == COMPUTE_TICK_MAX_STEPS)
+			tick.Pending = 0.0; // too far behind, the debt would only keep growing
+		else
+			tick.Pending -= steps;
 
-					break;
-				}
-			}
+		return steps;
+	}
+	bool RenderEngine::m_isPassCached(int index, int width, int height)
+	{
+		PipelineItem* item = m_items[index];
 
-			incLoc = src.find("#include", incLoc + 1);
+		uint64_t signature = 0;
+		if (!m_getPassSignature(index, width, height, signature)) {
+			m_staticPasses.erase(item);
+			return false;
 		}
+
+		auto cached = m_staticPasses.find(item);
+		if (cached != m_staticPasses.end() && cached->second == signature)
+			return true;
+
+		// the pass is drawn with these inputs right after this
+		m_staticPasses[item] = signature;
+		return false;
 	}
-	void RenderEngine::m_updatePassFBO(ed::pipe::ShaderPass* pass)
+	bool RenderEngine::m_getPassSignature(int index, int width, int height, uint64_t& signature)
 	{
-		bool changed = false;
+		PipelineItem* item = m_items[index];
+		pipe::ShaderPass* data = (pipe::ShaderPass*)item->Data;
+		GLuint program = m_shaders[index];
+
+		// SHADERed_Globals has the time & frame index
+		if (glGetUniformBlockIndex(program, "SHADERed_Globals") != GL_INVALID_INDEX || glGetUniformBlockIndex(program, "type_SHADERed_Globals") != GL_INVALID_INDEX)
+			return false;
+
+		// buffers can be edited in the UI at any time
+		if (m_objects->GetUniformBindTable(item).size() > 0 || data->ConditionBuffer != nullptr)
+			return false;
+
+		// a new sample every frame
+		if (data->Accumulate)
+			return false;
+
+		int msaa = data->Multisample ? Settings::Instance().Preview.MSAA : 1;
+		signature = HashData(&program, sizeof(program));
+		signature = HashData(&width, sizeof(width), signature);
+		signature = HashData(&height, sizeof(height), signature);
+		signature = HashData(&msaa, sizeof(msaa), signature);
+
+		// the old contents of the render textures have to be exactly what the pass would draw - no other pass can touch them
+		glm::vec2 rtSize(width, height);
+		for (int i = 0; i < MAX_RENDER_TEXTURES && data->RenderTextures[i] != 0; i++) {
+			GLuint rt = data->RenderTextures[i];
+			RenderTextureObject* rtObject = rt == m_rtColor ? nullptr : m_objects->GetRenderTexture(rt);
+			if (rtObject == nullptr || !rtObject->Clear)
+				return false;
+
+			for (PipelineItem* other : m_items) {
+				if (other == item || other->Type != PipelineItem::ItemType::ShaderPass)
+					continue;
 
-		for (int i = 0; i < pass->RTCount; i++)
+				pipe::ShaderPass* otherData = (pipe::ShaderPass*)other->Data;
+				if (std::count(otherData->RenderTextures, otherData->RenderTextures + MAX_RENDER_TEXTURES, rt) > 0)
+					return false;
+			}
+
+			rtSize = rtObject->CalculateSize(width, height);
+			signature = HashData(&rt, sizeof(rt), signature);
+			signature = HashData(&rtObject->Format, sizeof(rtObject->Format), signature);
+			signature = HashData(glm::value_ptr(rtSize), sizeof(glm::vec2), signature);
+			signature = HashData(glm::value_ptr(rtObject->ClearColor), sizeof(glm::vec4), signature);
+		}
+
+		// a sampled texture changed if something drew to it since then
+		for (const BindingDescriptor& srv : m_objects->GetBindTable(item)) {
+			// audio is updated every frame
+			if (srv.Type == BindingDescriptor::BindType::Plugin || srv.ID != srv.Source || m_objects->IsAudio(srv.ID))
+				return false;
+
+			unsigned int written = 0;
+			auto count = m_writeCount.find(getBarrierKey(false, srv.ID));
+			if (count != m_writeCount.end())
+				written = count->second;
+
+			signature = HashData(&srv.ID, sizeof(srv.ID), signature);
+			signature = HashData(&written, sizeof(written), signature);
+		}
+
+		// current values of the variables, the per item ones are covered by the items below
+		SystemVariableManager& systemVM = SystemVariableManager::Instance();
+		systemVM.SetViewportSize(rtSize.x, rtSize.y);
+		bool usesPicked = false;
+		for (ShaderVariable* var : data->Variables.GetVariables()) {
+			SystemShaderVariable sys = var->System;
+			if (sys == SystemShaderVariable::Time || sys == SystemShaderVariable::TimeDelta || sys == SystemShaderVariable::FrameIndex ||
+				sys == SystemShaderVariable::MousePosition || sys == SystemShaderVariable::Mouse || sys == SystemShaderVariable::MouseButton ||
+				sys == SystemShaderVariable::KeysWASD || sys == SystemShaderVariable::PluginVariable || sys == SystemShaderVariable::AudioPosition)
+				return false;
+
+			// the pointed variable could be anything, last frame's values are always one frame behind
+			if (var->Function == FunctionShaderVariable::Pointer || (var->Flags & (char)ShaderVariable::Flag::LastFrame))
+				return false;
+
+			if (sys == SystemShaderVariable::GeometryTransform || sys == SystemShaderVariable::IsPicked) {
+				usesPicked |= sys == SystemShaderVariable::IsPicked;
+				continue;
+			}
+
+			systemVM.Update(var);
+			FunctionVariableManager::Update(var);
+			signature = HashData(var->Data, ShaderVariable::GetSize(var->GetType()), signature);
+		}
+
+		for (PipelineItem* child : data->Items) {
+			if (child->Type == PipelineItem::ItemType::Geometry) {
+				pipe::GeometryItem* geoData = (pipe::GeometryItem*)child->Data;
+
+				// the query results and the instance & captured buffers change without the pass knowing, animated geometry with the time
+				if (geoData->OcclusionCulling || (geoData->Instanced && geoData->InstanceBuffer != nullptr) || (geoData->Type == pipe::GeometryItem::Generated && geoData->GenAnimated) ||
+					geoData->Type == pipe::GeometryItem::Captured)
+					return false;
+
+				signature = HashData(geoData, sizeof(pipe::GeometryItem), signature);
+			}
+			else if (child->Type == PipelineItem::ItemType::Model) {
+				pipe::Model* objData = (pipe::Model*)child->Data;
+				if ((objData->Instanced && objData->InstanceBuffer != nullptr) || (objData->Data != nullptr && objData->Data->IsSkinned() && objData->Animation[0] != 0))
+					return false;
+
+				signature = HashData(&objData->Data, sizeof(objData->Data), signature);
+				signature = HashData(&objData->OnlyGroup, sizeof(objData->OnlyGroup), signature);
+				signature = HashString(objData->GroupName, signature);
+				signature = HashData(glm::value_ptr(objData->Position), sizeof(glm::vec3), signature);
+				signature = HashData(glm::value_ptr(objData->Rotation), sizeof(glm::vec3), signature);
+				signature = HashData(glm::value_ptr(objData->Scale), sizeof(glm::vec3), signature);
+				signature = HashData(&objData->Instanced, sizeof(objData->Instanced), signature);
+				signature = HashData(&objData->InstanceCount, sizeof(objData->InstanceCount), signature);
+			}
+			else if (child->Type == PipelineItem::ItemType::RenderState)
+				signature = HashData(child->Data, sizeof(pipe::RenderState), signature);
+			else
+				return false;
+
+			bool picked = usesPicked && std::count(m_pick.begin(), m_pick.end(), child) > 0;
+			signature = HashData(&picked, sizeof(picked), signature);
+		}
+
+		// values that were set for a single item
+		for (const ItemVariableValue& value : m_itemValues)
+			if (std::count(data->Items.begin(), data->Items.end(), value.Item) > 0)
+				signature = HashData(value.NewValue->Data, ShaderVariable::GetSize(value.NewValue->GetType()), signature);
+
+		return true;
+	}
+	bool RenderEngine::ExportAudio(PipelineItem* item, const std::string& path, float start, float duration)
+	{
+		for (int i = 0; i < m_items.size(); i++) {
+			if (m_items[i] != item || item->Type != PipelineItem::ItemType::AudioPass)
+				continue;
+
+			pipe::AudioPass* data = (pipe::AudioPass*)item->Data;
+
+			const std::vector<BindingDescriptor>& srvs = m_objects->GetBindTable(item);
+			const std::vector<BindingDescriptor>& ubos = m_objects->GetUniformBindTable(item);
+
+			m_barrierRead(item, srvs, ubos);
+
+			glUseProgram(data->Stream.getShader());
+			m_bindAudioPass(i, srvs, ubos);
+
+			auto timerStart = std::chrono::steady_clock::now();
+			bool ret = data->Stream.renderToFile(path, start, duration);
+			GLStateCache::Instance().UnbindSamplers();
+			if (ret)
+				Logger::Get().Log("Exported " + std::to_string(duration) + "s of audio to " + path + " in " + std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - timerStart).count()) + "ms");
+			else
+				Logger::Get().Log("Failed to export the audio to " + path, true);
+
+			return ret;
+		}
+
+		return false;
+	}
+	void RenderEngine::m_bindAudioPass(int index, const std::vector<BindingDescriptor>& srvs, const std::vector<BindingDescriptor>& ubos)
+	{
+		pipe::AudioPass* data = (pipe::AudioPass*)m_items[index]->Data;
+
+		// bind shader resource views
+		for (int j = 0; j < srvs.size(); j++)
+		{
+			glActiveTexture(GL_TEXTURE0 + j);
+			if (srvs[j].Type == BindingDescriptor::BindType::Plugin) {
+				PluginObject* pobj = srvs[j].Plugin;
+				PluginProfiler::Scope profile(pobj->Owner, PluginProfiler::BindObject);
+				pobj->Owner->BindObject(pobj->Type, pobj->Data, pobj->ID);
+			}
+			else
+				glBindTexture(srvs[j].Target, srvs[j].ID);
+			GLStateCache::Instance().BindSampler(j, srvs[j].Sampler);
+
+			if (ShaderTranscompiler::GetShaderTypeFromExtension(data->Path) == ShaderLanguage::GLSL) // TODO: or should this be for vulkan glsl too?
+				data->Variables.UpdateTexture(m_shaders[index], j);
+		}
+
+		// bind buffers
+		for (int j = 0; j < ubos.size(); j++) {
+			if (ubos[j].Buffer != nullptr)
+				glBindBufferBase(GL_SHADER_STORAGE_BUFFER, j, ubos[j].ID);
+		}
+
+		// bind variables
+		data->Variables.Bind();
+	}
+	void RenderEngine::WaitForCompilation()
+	{
+		// precompiled variants aren't needed for the next frame
+		for (int i = 0; i < m_compileJobs.size(); i++) {
+			if (m_compileJobs[i]->Background)
+				continue;
+
+			std::shared_ptr<CompileJob> job = m_compileJobs[i];
+			m_compileJobs.erase(m_compileJobs.begin() + i);
+			m_updateCompileJob(job.get(), true);
+			m_contentGeneration++;
+			i--;
+		}
+	}
+	bool RenderEngine::m_pollCompileJobs()
+	{
+		bool finished = false;
+		for (int i = 0; i < m_compileJobs.size(); i++) {
+			if (m_updateCompileJob(m_compileJobs[i].get(), false)) {
+				m_compileJobs.erase(m_compileJobs.begin() + i);
+				m_frameDirty = true;
+				m_contentGeneration++;
+				finished = true;
+				i--;
+			}
+		}
+		return finished;
+	}
+	void RenderEngine::m_queueCompile(PipelineItem* item, bool background, const std::vector<ShaderMacro>& macros, int dirtyStages)
+	{
+		// a newer request replaces the one that is still in progress - the stages that job would've rebuilt are unknown now
+		if (!background) {
+			for (const auto& other : m_compileJobs)
+				if (other->Item == item && !other->Background)
+					dirtyStages = -1;
+			m_cancelCompile(item);
+			m_watchdog.Release(item);
+
+			// nothing was built yet, every stage is needed
+			if (m_deferredCompile.erase(item) > 0)
+				dirtyStages = -1;
+		}
+
+		std::shared_ptr<CompileJob> job = std::make_shared<CompileJob>();
+		job->Item = item;
+		job->Name = item->Name;
+		job->GSUsed = false;
+		job->Views = 0;
+		job->State = CompileState::Preprocessing;
+		job->Program = job->DebugProgram = 0;
+		job->UseCache = Settings::Instance().General.ProgramCache && m_programCache.IsSupported();
+		job->Cached = false;
+		job->Hash = job->DebugHash = 0;
+		job->Background = background;
+		job->CompileTime = job->LinkTime = 0.0f;
+
+		if (item->Type == PipelineItem::ItemType::ShaderPass && ((pipe::ShaderPass*)item->Data)->MSUsed) {
+			pipe::ShaderPass* pass = (pipe::ShaderPass*)item->Data;
+			bool hasTS = pass->TSUsed && strlen(pass->TSPath) > 0;
+
+			if (!m_meshShaderSupported) {
+				m_msgs->Add(MessageStack::Type::Error, item->Name, "Mesh shaders aren't supported by this GPU");
+				return;
+			}
+
+			job->Macros = pass->Macros;
+
+			// the mesh shader takes the vertex shader's place, the debug program is built from it
+			job->Stages.resize(hasTS ? 3 : 2);
+			job->Stages[0].Type = 5;
+			job->Stages[0].Path = pass->MSPath;
+			job->Stages[0].Entry = pass->MSEntry;
+			job->Stages[1].Type = 1;
+			job->Stages[1].Path = pass->PSPath;
+			job->Stages[1].Entry = pass->PSEntry;
+			if (hasTS) {
+				job->Stages[2].Type = 4;
+				job->Stages[2].Path = pass->TSPath;
+				job->Stages[2].Entry = pass->TSEntry;
+			}
+		}
+		else if (item->Type == PipelineItem::ItemType::ShaderPass) {
+			pipe::ShaderPass* pass = (pipe::ShaderPass*)item->Data;
+			bool hasGS = pass->GSUsed && strlen(pass->GSPath) > 0 && strlen(pass->GSEntry) > 0;
+
+			job->GSUsed = pass->GSUsed;
+			job->Macros = pass->Macros;
+			if (pass->Multiview) {
+				job->Views = m_multiviewSupported ? STEREO_VIEW_COUNT : 0;
+				if (!m_multiviewSupported)
+					m_msgs->Add(MessageStack::Type::Warning, item->Name, "Multiview isn't supported by this GPU (GL_OVR_multiview2)");
+			}
+			if (pass->CaptureBuffer != nullptr && VertexCapture::IsSupported())
+				job->CaptureVaryings = VertexCapture::GetVaryings(pass->CaptureOutputs);
+
+			// vertex shader has to be the first stage - it is also used by the debug program
+			job->Stages.resize(hasGS ? 3 : 2);
+			job->Stages[0].Type = 0;
+			job->Stages[0].Path = pass->VSPath;
+			job->Stages[0].Entry = pass->VSEntry;
+			job->Stages[1].Type = 1;
+			job->Stages[1].Path = pass->PSPath;
+			job->Stages[1].Entry = pass->PSEntry;
+			if (hasGS) {
+				job->Stages[2].Type = 2;
+				job->Stages[2].Path = pass->GSPath;
+				job->Stages[2].Entry = pass->GSEntry;
+			}
+		}
+		else if (item->Type == PipelineItem::ItemType::ComputePass) {
+			pipe::ComputePass* pass = (pipe::ComputePass*)item->Data;
+
+			job->Macros = pass->Macros;
+
+			job->Stages.resize(1);
+			job->Stages[0].Type = 3;
+			job->Stages[0].Path = pass->Path;
+			job->Stages[0].Entry = pass->Entry;
+		}
+		else return;
+
+		if (background)
+			job->Macros = macros;
+
+		job->Constants = m_getConstants(item);
+		if (!background)
+			m_constantKeys[item] = getConstantsKey(job->Constants);
+
+		job->VariantKey = m_getVariantKey(item, job->Macros);
+		job->BuildKey = m_getBuildKey(item, job->Macros);
+		if (background) {
+			// already built or being built
+			if (m_variantKeys[item] == job->VariantKey || m_variants[item].count(job->VariantKey) > 0)
+				return;
+			for (const auto& other : m_compileJobs)
+				if (other->Item == item && other->VariantKey == job->VariantKey)
+					return;
+		}
+		else {
+			int index = std::distance(m_items.begin(), std::find(m_items.begin(), m_items.end(), item));
+			if (index < m_items.size() && m_useVariant(item, index, job->VariantKey)) {
+				ReloadProfiler::Instance().SetCached(item->Name);
+				ReloadProfiler::Instance().Finish(item->Name);
+				return;
+			}
+
+			// the variant is already being precompiled - just wait for it
+			for (const auto& other : m_compileJobs)
+				if (other->Item == item && other->Background && other->VariantKey == job->VariantKey) {
+					other->Background = false;
+					return;
+				}
+		}
+
+		for (auto& stage : job->Stages) {
+			stage.LineBias = 0;
+			stage.Shader = 0;
+			stage.Messages.CurrentItem = job->Name;
+			stage.Messages.CurrentItemType = stage.Type;
+			for (int i = 0; i < ReloadProfiler::StepCount; i++)
+				stage.Timings[i] = 0.0f;
+		}
+
+		// stages whose files didn't change keep the code that the last successful build preprocessed
+		int index = std::distance(m_items.begin(), std::find(m_items.begin(), m_items.end(), item));
+		const ShaderPack* last = nullptr;
+		if (dirtyStages != -1 && index < m_items.size() && m_variantKeys[item] != 0 && m_shaderSources[index].BuildKey == job->BuildKey)
+			last = &m_shaderSources[index];
+
+		std::vector<int> dirty;
+		for (int i = 0; i < job->Stages.size(); i++) {
+			CompileStage& stage = job->Stages[i];
+
+			const std::string* code = nullptr;
+			if (last != nullptr && (dirtyStages & (1 << stage.Type)) == 0) {
+				if (stage.Type == 0 || stage.Type == 5) code = &last->VSCode;
+				else if (stage.Type == 1) code = &last->PSCode;
+				else if (stage.Type == 2 || stage.Type == 4) code = &last->GSCode;
+			}
+
+			if (code != nullptr && !code->empty())
+				stage.Code = *code;
+			else
+				dirty.push_back(i);
+		}
+
+		job->Remaining = dirty.size();
+		m_compileJobs.push_back(job);
+
+		// every stage is preprocessed on its own worker
+		for (int i : dirty) {
+			m_compilePool.Add([this, job, i]() {
+				TraceRecorder::Scope zone("Compile shader", "compile");
+				m_preprocessStage(job.get(), job->Stages[i]);
+				job->Remaining--;
+			});
+		}
+	}
+	void RenderEngine::m_cancelCompile(PipelineItem* item, bool all)
+	{
+		for (int i = 0; i < m_compileJobs.size(); i++) {
+			CompileJob* job = m_compileJobs[i].get();
+			if (job->Item != item || (job->Background && !all))
+				continue;
+
+			// the workers keep their own reference to the job so it's fine if they are still running
+			for (auto& stage : job->Stages)
+				glDeleteShader(stage.Shader);
+			glDeleteProgram(job->Program);
+			glDeleteProgram(job->DebugProgram);
+
+			m_compileJobs.erase(m_compileJobs.begin() + i);
+			i--;
+		}
+	}
+	void RenderEngine::m_preprocessStage(CompileJob* job, CompileStage& stage)
+	{
+		// this runs on a worker thread - don't touch anything other than the job
+		ShaderLanguage lang = ShaderTranscompiler::GetShaderTypeFromExtension(stage.Path);
+
+		if (lang == ShaderLanguage::GLSL) {
+			std::string path = m_project->GetProjectPath(stage.Path);
+			std::vector<std::string> included;
+
+			auto stepStart = std::chrono::steady_clock::now();
+			IncludeCache::Instance().Get(path, stage.Code);
+			stage.Timings[ReloadProfiler::FileRead] = ReloadProfiler::Elapsed(stepStart);
+
+			stepStart = std::chrono::steady_clock::now();
+			m_includeCheck(stage.Code, stage.LineBias, &stage.Messages, &included);
+			m_applyMacros(stage.Code, job->Macros);
+			m_applyConstants(stage.Code, job->Constants);
+			stage.LineBias += VirtualTexture::Instrument(stage.Code);
+			stage.LineBias += ShaderTrace::Instrument(stage.Code, stage.Type);
+			stage.Timings[ReloadProfiler::Includes] = ReloadProfiler::Elapsed(stepStart);
+
+			IncludeCache::Instance().SetDependencies(path, included);
+		} else if (stage.Type == 4 || stage.Type == 5) {
+			// glslang can't translate them
+			stage.Messages.Add(MessageStack::Type::Error, job->Name, "Task & mesh shaders have to be written in GLSL");
+			stage.Code = "";
+		} else { // HLSL / VK
+			stage.Code = ShaderTranscompiler::Transcompile(lang, m_project->GetProjectPath(stage.Path), stage.Type, stage.Entry, job->Macros, job->GSUsed, &stage.Messages, m_project, true);
+			ShaderTrace::RegisterFormats(stage.Code); // the output can come from the disk cache
+			m_applyConstants(stage.Code, job->Constants); // after the cache so that other values don't go through glslang again
+
+			ShaderTranscompiler::Timings timings = ShaderTranscompiler::GetLastTimings();
+			stage.Timings[ReloadProfiler::FileRead] = timings.Read;
+			stage.Timings[ReloadProfiler::Includes] = timings.Preprocess;
+			stage.Timings[ReloadProfiler::Parse] = timings.Parse;
+			stage.Timings[ReloadProfiler::SPIRV] = timings.SPIRV;
+			stage.Timings[ReloadProfiler::Cross] = timings.Cross;
+
+			// TODO: delete this when glslang fixes this https://github.com/KhronosGroup/glslang/issues/1660
+			if (stage.Type == 2)
+				stage.Messages.Add(MessageStack::Type::Warning, job->Name, "HLSL geometry shaders are currently not supported by glslang");
+		}
+
+		if (job->Views > 1 && !stage.Code.empty())
+			stage.LineBias += m_applyMultiview(stage.Code, stage.Type);
+	}
+	bool RenderEngine::m_updateCompileJob(CompileJob* job, bool wait)
+	{
+		GLchar cMsg[1024];
+
+		if (job->State == CompileState::Preprocessing) {
+			if (job->Remaining > 0 && !wait)
+				return false;
+
+			while (job->Remaining > 0)
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+			// skip the compiler completely if we've already seen these sources
+			if (job->UseCache && m_loadCachedProgram(job)) {
+				m_finishCompileJob(job, true);
+				return true;
+			}
+
+			// give the driver all the stages at once
+			job->StepStart = std::chrono::steady_clock::now();
+			for (auto& stage : job->Stages)
+				stage.Shader = gl::CompileShader(shaderStageTypes[stage.Type], stage.Code.c_str());
+
+			job->State = CompileState::Compiling;
+		}
+
+		if (job->State == CompileState::Compiling) {
+			if (m_parallelCompile && !wait) {
+				for (auto& stage : job->Stages) {
+					GLint done = 0;
+					glGetShaderiv(stage.Shader, GL_COMPLETION_STATUS_KHR, &done);
+					if (!done)
+						return false;
+				}
+			}
+
+			bool compiled = true;
+			for (auto& stage : job->Stages) {
+				if (!gl::CheckShaderCompilationStatus(stage.Shader, cMsg)) {
+					compiled = false;
+
+					if (ShaderTranscompiler::GetShaderTypeFromExtension(stage.Path) == ShaderLanguage::GLSL)
+						stage.Messages.Add(gl::ParseMessages(job->Name, stage.Type, cMsg, stage.LineBias));
+				}
+			}
+
+			job->CompileTime = ReloadProfiler::Elapsed(job->StepStart);
+
+			if (!compiled) {
+				m_finishCompileJob(job, false);
+				return true;
+			}
+
+			job->StepStart = std::chrono::steady_clock::now();
+			job->Program = glCreateProgram();
+			gl::SetObjectLabel(GL_PROGRAM, job->Program, job->Name);
+			for (auto& stage : job->Stages)
+				glAttachShader(job->Program, stage.Shader);
+			if (job->UseCache)
+				glProgramParameteri(job->Program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+			if (!job->CaptureVaryings.empty()) {
+				std::vector<const GLchar*> varyings;
+				for (const auto& varying : job->CaptureVaryings)
+					varyings.push_back(varying.c_str());
+				glTransformFeedbackVaryings(job->Program, varyings.size(), varyings.data(), GL_INTERLEAVED_ATTRIBS);
+			}
+			glLinkProgram(job->Program);
+
+			if (job->Item->Type == PipelineItem::ItemType::ShaderPass) {
+				job->DebugProgram = glCreateProgram();
+				gl::SetObjectLabel(GL_PROGRAM, job->DebugProgram, job->Name + " (debug)");
+				glAttachShader(job->DebugProgram, m_debugPixelShader);
+				glAttachShader(job->DebugProgram, job->Stages[0].Shader);
+				if (job->UseCache)
+					glProgramParameteri(job->DebugProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+				glLinkProgram(job->DebugProgram);
+			}
+
+			job->State = CompileState::Linking;
+		}
+
+		if (m_parallelCompile && !wait) {
+			GLint done = 0;
+			glGetProgramiv(job->Program, GL_COMPLETION_STATUS_KHR, &done);
+			if (done && job->DebugProgram != 0)
+				glGetProgramiv(job->DebugProgram, GL_COMPLETION_STATUS_KHR, &done);
+			if (!done)
+				return false;
+		}
+
+		job->LinkTime = ReloadProfiler::Elapsed(job->StepStart);
+		m_finishCompileJob(job, true);
+		return true;
+	}
+	bool RenderEngine::m_loadCachedProgram(CompileJob* job)
+	{
+		std::vector<std::string> key;
+		for (auto& macro : job->Macros)
+			if (macro.Active)
+				key.push_back(std::string(macro.Name) + "=" + macro.Value);
+		for (auto& stage : job->Stages) {
+			key.push_back(std::to_string(stage.Type));
+			key.push_back(stage.Code);
+		}
+		for (const auto& varying : job->CaptureVaryings)
+			key.push_back("capture " + varying);
+		job->Hash = m_programCache.Hash(key);
+
+		bool isShaderPass = job->Item->Type == PipelineItem::ItemType::ShaderPass;
+		if (isShaderPass) {
+			key.push_back("debug");
+			job->DebugHash = m_programCache.Hash(key);
+		}
+
+		job->Program = m_programCache.Load(job->Hash);
+		if (job->Program != 0 && isShaderPass) {
+			job->DebugProgram = m_programCache.Load(job->DebugHash);
+			if (job->DebugProgram == 0) {
+				glDeleteProgram(job->Program);
+				job->Program = 0;
+			}
+		}
+
+		job->Cached = job->Program != 0;
+		return job->Cached;
+	}
+	void RenderEngine::m_finishCompileJob(CompileJob* job, bool compiled)
+	{
+		PipelineItem* item = job->Item;
+
+		int index = -1;
+		for (int i = 0; i < m_items.size(); i++)
+			if (m_items[i] == item) {
+				index = i;
+				break;
+			}
+
+		if (index == -1 || (job->Background && !compiled)) {
+			for (auto& stage : job->Stages)
+				glDeleteShader(stage.Shader);
+			glDeleteProgram(job->Program);
+			glDeleteProgram(job->DebugProgram);
+			if (!job->Background)
+				ReloadProfiler::Instance().Cancel(job->Name);
+			return;
+		}
+
+		ShaderPack sources;
+		sources.BuildKey = job->BuildKey;
+		for (auto& stage : job->Stages) {
+			if (item->Type == PipelineItem::ItemType::ComputePass) {
+				glDeleteShader(stage.Shader);
+				stage.Shader = 0;
+			}
+			else if (stage.Type == 0 || stage.Type == 5) {
+				sources.VS = stage.Shader;
+				sources.VSCode = stage.Code;
+			}
+			else if (stage.Type == 1) {
+				sources.PS = stage.Shader;
+				sources.PSCode = stage.Code;
+			}
+			else if (stage.Type == 2 || stage.Type == 4) {
+				sources.GS = stage.Shader;
+				sources.GSCode = stage.Code;
+			}
+		}
+
+		if (compiled && job->UseCache && !job->Cached) {
+			m_programCache.Save(job->Hash, job->Program);
+			if (job->DebugProgram != 0)
+				m_programCache.Save(job->DebugHash, job->DebugProgram);
+		}
+
+		// precompiled variant, the current program stays
+		if (job->Background) {
+			m_bindSystemBlock(job->Program);
+			if (job->DebugProgram != 0)
+				m_bindSystemBlock(job->DebugProgram);
+			m_storeVariant(item, job->VariantKey, job->Program, job->DebugProgram, sources);
+			return;
+		}
+
+		auto reflectionStart = std::chrono::steady_clock::now();
+
+		m_msgs->ClearGroup(item->Name);
+		m_msgs->BuildOccured = true;
+		for (auto& stage : job->Stages) {
+			std::vector<MessageStack::Message>& msgs = stage.Messages.GetMessages();
+			for (auto& msg : msgs)
+				msg.Group = item->Name; // item could've been renamed in the meantime
+			m_msgs->Add(msgs);
+		}
+
+		// only now replace the program that was used while this one was compiling - it is kept if it was built for other macros
+		uint64_t oldKey = m_variantKeys[item];
+		m_deleteInstrumentedShaders(item);
+		if (oldKey != 0 && oldKey != job->VariantKey && m_shaders[index] != 0)
+			m_storeVariant(item, oldKey, m_shaders[index], m_debugShaders[index], m_shaderSources[index]);
+		else {
+			glDeleteProgram(m_shaders[index]);
+			glDeleteProgram(m_debugShaders[index]);
+			glDeleteShader(m_shaderSources[index].VS);
+			glDeleteShader(m_shaderSources[index].PS);
+			glDeleteShader(m_shaderSources[index].GS);
+
+			// rebuilding the same macro set means that something else (included files, ...) changed
+			if (oldKey == job->VariantKey)
+				m_deleteVariants(item);
+		}
+
+		m_shaders[index] = compiled ? job->Program : 0;
+		m_staticPasses.erase(item); // the new program can get the old one's name
+		m_debugShaders[index] = compiled ? job->DebugProgram : 0;
+		m_shaderSources[index] = sources;
+		m_variantKeys[item] = compiled ? job->VariantKey : 0;
+
+		if (compiled) {
+			m_bindSystemBlock(m_shaders[index]);
+			if (m_debugShaders[index] != 0)
+				m_bindSystemBlock(m_debugShaders[index]);
+		}
+
+		if (item->Type == PipelineItem::ItemType::ShaderPass) {
+			pipe::ShaderPass* pass = (pipe::ShaderPass*)item->Data;
+
+			pass->Variables.UpdateTextureList(sources.PSCode, sources.VSCode, sources.GSCode);
+
+			if (compiled) {
+				m_msgs->Add(MessageStack::Type::Message, item->Name, "Compiled the shaders.");
+				pass->Variables.UpdateUniformInfo(m_shaders[index]);
+
+				std::string captureError;
+				if (!job->CaptureVaryings.empty() && !VertexCapture::Check(m_shaders[index], job->CaptureVaryings, captureError))
+					m_msgs->Add(MessageStack::Type::Error, item->Name, captureError);
+			} else {
+				Logger::Get().Log("Shaders not compiled", true);
+				m_msgs->Add(MessageStack::Type::Error, item->Name, "Failed to compile the shader(s)");
+			}
+		}
+		else if (item->Type == PipelineItem::ItemType::ComputePass) {
+			pipe::ComputePass* pass = (pipe::ComputePass*)item->Data;
+
+			if (compiled) {
+				m_msgs->Add(MessageStack::Type::Message, item->Name, "Compiled the compute shader.");
+				pass->Variables.UpdateUniformInfo(m_shaders[index]);
+			} else {
+				Logger::Get().Log("Compute shader was not compiled", true);
+				m_msgs->Add(MessageStack::Type::Error, item->Name, "Failed to compile the compute shader");
+			}
+		}
+
+		ReloadProfiler& reload = ReloadProfiler::Instance();
+		if (compiled) {
+			for (auto& stage : job->Stages)
+				for (int i = 0; i < ReloadProfiler::StepCount; i++)
+					reload.Add(item->Name, i, stage.Timings[i]);
+			reload.Add(item->Name, ReloadProfiler::GLCompile, job->CompileTime);
+			reload.Add(item->Name, ReloadProfiler::GLLink, job->LinkTime);
+			reload.Add(item->Name, ReloadProfiler::Reflection, ReloadProfiler::Elapsed(reflectionStart));
+			if (job->Cached)
+				reload.SetCached(item->Name);
+			reload.Finish(item->Name);
+		} else
+			reload.Cancel(item->Name);
+	}
+	void RenderEngine::PrecompileVariants(PipelineItem* item)
+	{
+		std::vector<ShaderMacro> macros;
+		if (item->Type == PipelineItem::ItemType::ShaderPass)
+			macros = ((pipe::ShaderPass*)item->Data)->Macros;
+		else if (item->Type == PipelineItem::ItemType::ComputePass && m_computeSupported)
+			macros = ((pipe::ComputePass*)item->Data)->Macros;
+		else
+			return;
+
+		std::vector<std::vector<ShaderMacro>> sets;
+		if (macros.size() <= 4) {
+			// every on/off combination - 2^4 = VARIANT_CACHE_SIZE
+			for (int mask = 0; mask < (1 << macros.size()); mask++) {
+				std::vector<ShaderMacro> set = macros;
+				for (int i = 0; i < set.size(); i++)
+					set[i].Active = (mask >> i) & 1;
+				sets.push_back(set);
+			}
+		} else {
+			// too many macros - only the sets that differ from the current one in a single macro
+			for (int i = 0; i < macros.size() && sets.size() < VARIANT_CACHE_SIZE - 1; i++) {
+				std::vector<ShaderMacro> set = macros;
+				set[i].Active = !set[i].Active;
+				sets.push_back(set);
+			}
+		}
+
+		for (const auto& set : sets)
+			m_queueCompile(item, true, set);
+	}
+	int RenderEngine::GetVariantCount(PipelineItem* item)
+	{
+		auto it = m_variants.find(item);
+		return it == m_variants.end() ? 0 : it->second.size();
+	}
+	int RenderEngine::GetPrecompileJobCount(PipelineItem* item)
+	{
+		int count = 0;
+		for (const auto& job : m_compileJobs)
+			if (job->Item == item && job->Background)
+				count++;
+		return count;
+	}
+	bool RenderEngine::StartComparison(PipelineItem* pass, const std::vector<ShaderMacro>& macros, const std::string& psPath, const std::string& psSource, std::string& error)
+	{
+		StopComparison();
+
+		if (pass == nullptr || pass->Type != PipelineItem::ItemType::ShaderPass) {
+			error = "Only shader passes can be compared.";
+			return false;
+		}
+
+		int index = std::distance(m_items.begin(), std::find(m_items.begin(), m_items.end(), pass));
+		if (index >= m_items.size() || m_shaders[index] == 0) {
+			error = "The shader pass has to compile before it can be compared.";
+			return false;
+		}
+
+		// version B shares everything with the pass except for the pixel shader and the macros
+		pipe::ShaderPass* data = (pipe::ShaderPass*)pass->Data;
+		bool hasGS = data->GSUsed && strlen(data->GSPath) > 0 && strlen(data->GSEntry) > 0;
+
+		CompileJob job;
+		job.Item = pass;
+		job.Name = pass->Name;
+		job.GSUsed = data->GSUsed;
+		job.Views = data->Multiview && m_multiviewSupported ? STEREO_VIEW_COUNT : 0;
+		job.Macros = macros;
+		job.Stages.resize(hasGS ? 3 : 2);
+		job.Stages[0].Type = 0;
+		job.Stages[0].Path = data->VSPath;
+		job.Stages[0].Entry = data->VSEntry;
+		job.Stages[1].Type = 1;
+		job.Stages[1].Path = psPath.empty() ? std::string(data->PSPath) : psPath;
+		job.Stages[1].Entry = data->PSEntry;
+		if (hasGS) {
+			job.Stages[2].Type = 2;
+			job.Stages[2].Path = data->GSPath;
+			job.Stages[2].Entry = data->GSEntry;
+		}
+
+		GLchar cMsg[1024];
+		bool compiled = true;
+		for (auto& stage : job.Stages) {
+			stage.LineBias = 0;
+			stage.Messages.CurrentItem = job.Name;
+			stage.Messages.CurrentItemType = stage.Type;
+
+			if (stage.Type == 1 && !psSource.empty()) {
+				ShaderLanguage lang = ShaderTranscompiler::GetShaderTypeFromExtension(stage.Path);
+				if (lang == ShaderLanguage::GLSL) {
+					stage.Code = psSource;
+					m_includeCheck(stage.Code, stage.LineBias, &stage.Messages);
+					m_applyMacros(stage.Code, job.Macros);
+				} else
+					stage.Code = ShaderTranscompiler::TranscompileSource(lang, m_project->GetProjectPath(stage.Path), psSource, stage.Type, stage.Entry, job.Macros, job.GSUsed, &stage.Messages, m_project);
+			} else
+				m_preprocessStage(&job, stage);
+
+			stage.Shader = gl::CompileShader(shaderStageTypes[stage.Type], stage.Code.c_str());
+			if (!gl::CheckShaderCompilationStatus(stage.Shader, cMsg)) {
+				if (compiled)
+					error = std::string(stage.Type == 1 ? "Pixel" : (stage.Type == 0 ? "Vertex" : "Geometry")) + " shader of version B failed to compile:\n" + cMsg;
+				compiled = false;
+			}
+		}
+
+		GLuint program = 0;
+		if (compiled) {
+			program = glCreateProgram();
+			for (auto& stage : job.Stages)
+				glAttachShader(program, stage.Shader);
+			glLinkProgram(program);
+
+			if (!gl::CheckShaderLinkStatus(program, cMsg)) {
+				error = std::string("Version B failed to link:\n") + cMsg;
+				glDeleteProgram(program);
+				program = 0;
+			}
+		}
+
+		for (auto& stage : job.Stages)
+			glDeleteShader(stage.Shader);
+
+		if (program == 0)
+			return false;
+
+		m_bindSystemBlock(program);
+		m_compare.Start(pass, program);
+
+		return true;
+	}
+	void RenderEngine::StopComparison()
+	{
+		m_compare.Stop();
+		m_compareVersion = -1;
+	}
+	bool RenderEngine::StartTuning(PipelineItem* pass, std::string& error)
+	{
+		m_tuner.Stop();
+
+		if (pass == nullptr || pass->Type != PipelineItem::ItemType::ComputePass || !m_computeSupported) {
+			error = "Only compute passes can be tuned.";
+			return false;
+		}
+
+		int index = std::distance(m_items.begin(), std::find(m_items.begin(), m_items.end(), pass));
+		if (index >= m_items.size() || m_shaders[index] == 0) {
+			error = "The compute pass has to compile before it can be tuned.";
+			return false;
+		}
+
+		pipe::ComputePass* data = (pipe::ComputePass*)pass->Data;
+		if (data->IndirectBuffer != nullptr) {
+			error = "The group counts of an indirect dispatch come from a buffer and can't be changed.";
+			return false;
+		}
+
+		GLint local[3] = { 1, 1, 1 };
+		glGetProgramiv(m_shaders[index], GL_COMPUTE_WORK_GROUP_SIZE, local);
+
+		GLint maxSize[3] = { 1024, 1024, 64 }, maxInvocations = 1024;
+		for (int d = 0; d < 3; d++)
+			glGetIntegeri_v(GL_MAX_COMPUTE_WORK_GROUP_SIZE, d, &maxSize[d]);
+		glGetIntegerv(GL_MAX_COMPUTE_WORK_GROUP_INVOCATIONS, &maxInvocations);
+
+		m_tuner.Start(pass, glm::uvec3(local[0], local[1], local[2]), glm::uvec3(data->WorkX, data->WorkY, data->WorkZ), glm::uvec3(maxSize[0], maxSize[1], maxSize[2]), maxInvocations);
+
+		return true;
+	}
+	bool RenderEngine::ApplyTuning(int candidate)
+	{
+		PipelineItem* pass = (PipelineItem*)m_tuner.GetPass();
+		std::vector<WorkGroupTuner::Candidate>& cands = m_tuner.GetCandidates();
+		if (pass == nullptr || candidate < 0 || candidate >= cands.size())
+			return false;
+
+		pipe::ComputePass* data = (pipe::ComputePass*)pass->Data;
+		const WorkGroupTuner::Candidate& cand = cands[candidate];
+
+		for (int d = 0; d < 3; d++) {
+			ShaderMacro* macro = nullptr;
+			for (auto& m : data->Macros)
+				if (strcmp(m.Name, WorkGroupTuner::MacroNames[d]) == 0)
+					macro = &m;
+			if (macro == nullptr) {
+				data->Macros.push_back(ShaderMacro());
+				macro = &data->Macros.back();
+				strcpy(macro->Name, WorkGroupTuner::MacroNames[d]);
+			}
+			macro->Active = true;
+			strcpy(macro->Value, std::to_string(cand.Size[d]).c_str());
+		}
+		data->WorkX = cand.Groups.x;
+		data->WorkY = cand.Groups.y;
+		data->WorkZ = cand.Groups.z;
+
+		m_tuner.Stop();
+		Recompile(pass->Name);
+
+		return true;
+	}
+	GLuint RenderEngine::m_compileTuningCandidate(PipelineItem* pass, const glm::uvec3& size, std::string& error)
+	{
+		pipe::ComputePass* data = (pipe::ComputePass*)pass->Data;
+
+		CompileJob job;
+		job.Item = pass;
+		job.Name = pass->Name;
+		job.GSUsed = false;
+		job.Views = 0;
+		job.Constants = m_getConstants(pass);
+
+		// the pass' own macros with the local size replaced
+		for (const auto& macro : data->Macros) {
+			bool isSize = false;
+			for (int d = 0; d < 3; d++)
+				isSize |= strcmp(macro.Name, WorkGroupTuner::MacroNames[d]) == 0;
+			if (!isSize)
+				job.Macros.push_back(macro);
+		}
+		for (int d = 0; d < 3; d++) {
+			ShaderMacro macro;
+			macro.Active = true;
+			strcpy(macro.Name, WorkGroupTuner::MacroNames[d]);
+			strcpy(macro.Value, std::to_string(size[d]).c_str());
+			job.Macros.push_back(macro);
+		}
+
+		job.Stages.resize(1);
+		CompileStage& stage = job.Stages[0];
+		stage.Type = 3;
+		stage.Path = data->Path;
+		stage.Entry = data->Entry;
+		stage.LineBias = 0;
+		stage.Messages.CurrentItem = job.Name;
+		stage.Messages.CurrentItemType = stage.Type;
+		m_preprocessStage(&job, stage);
+
+		GLchar cMsg[1024];
+		stage.Shader = gl::CompileShader(shaderStageTypes[stage.Type], stage.Code.c_str());
+		if (!gl::CheckShaderCompilationStatus(stage.Shader, cMsg)) {
+			error = cMsg;
+			glDeleteShader(stage.Shader);
+			return 0;
+		}
+
+		GLuint program = glCreateProgram();
+		glAttachShader(program, stage.Shader);
+		glLinkProgram(program);
+		glDeleteShader(stage.Shader);
+
+		if (!gl::CheckShaderLinkStatus(program, cMsg)) {
+			error = cMsg;
+			glDeleteProgram(program);
+			return 0;
+		}
+
+		m_bindSystemBlock(program);
+
+		return program;
+	}
+	void RenderEngine::m_runTuner(PipelineItem* pass, GLuint program, const std::vector<BindingDescriptor>& srvs)
+	{
+		WorkGroupTuner::Candidate* cand = m_tuner.GetNext();
+		if (cand == nullptr)
+			return;
+
+		pipe::ComputePass* data = (pipe::ComputePass*)pass->Data;
+
+		if (!cand->Compiled) {
+			cand->Compiled = true;
+			cand->Program = m_compileTuningCandidate(pass, cand->Size, cand->Error);
+			if (cand->Program == 0) {
+				// shared memory & other per group limits can make the larger sizes fail
+				if (cand->Current)
+					m_tuner.Fail("The pass doesn't compile with its own local size:\n" + cand->Error);
+				return;
+			}
+
+			GLint local[3] = { 0, 0, 0 };
+			glGetProgramiv(cand->Program, GL_COMPUTE_WORK_GROUP_SIZE, local);
+			if (glm::uvec3(local[0], local[1], local[2]) != cand->Size) {
+				m_tuner.Fail("The shader has to declare its local size with the LOCAL_SIZE_X, LOCAL_SIZE_Y and LOCAL_SIZE_Z macros.");
+				return;
+			}
+		}
+
+		data->Variables.UpdateUniformInfo(cand->Program);
+		glUseProgram(cand->Program);
+
+		if (ShaderTranscompiler::GetShaderTypeFromExtension(data->Path) == ShaderLanguage::GLSL)
+			for (int j = 0; j < srvs.size(); j++)
+				data->Variables.UpdateTexture(cand->Program, j);
+
+		GLint groupOffset = glGetUniformLocation(cand->Program, "SHADERed_WorkGroupOffset");
+		if (groupOffset != -1)
+			glUniform3ui(groupOffset, 0, 0, 0);
+
+		data->Variables.Bind();
+
+		// the barriers keep the dispatches from overlapping, each one is measured on its own
+		m_tuner.Begin();
+		for (int k = 0; k < WORKGROUP_TUNER_DISPATCHES; k++) {
+			glDispatchCompute(cand->Groups.x, cand->Groups.y, cand->Groups.z);
+			glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+		}
+		m_tuner.End();
+
+		data->Variables.UpdateUniformInfo(program); // return old variable data
+		glUseProgram(program);
+	}
+	uint64_t RenderEngine::m_getBuildKey(PipelineItem* item, const std::vector<ShaderMacro>& macros)
+	{
+		uint64_t key = ed::HashString(std::to_string(Settings::Instance().Project.SPIRVOptimization));
+		for (auto& macro : macros)
+			if (macro.Active)
+				key = ed::HashString(std::string(macro.Name) + "=" + macro.Value, key);
+		for (auto& path : Settings::Instance().Project.IncludePaths)
+			key = ed::HashString(path, key);
+		key = ed::HashData(&key, sizeof(key), getConstantsKey(m_getConstants(item))); // the stored code has them applied
+
+		if (item->Type == PipelineItem::ItemType::ShaderPass) {
+			pipe::ShaderPass* pass = (pipe::ShaderPass*)item->Data;
+			key = ed::HashString(std::string(pass->VSPath) + ";" + pass->PSPath + ";" + pass->GSPath, key);
+			key = ed::HashString(std::string(pass->VSEntry) + ";" + pass->PSEntry + ";" + pass->GSEntry + ";" + std::to_string(pass->GSUsed), key);
+			if (pass->MSUsed)
+				key = ed::HashString(std::string(pass->MSPath) + ";" + pass->TSPath + ";" + std::to_string(pass->TSUsed), key);
+			if (pass->Multiview)
+				key = ed::HashString("multiview", key); // the stored code has the directives
+		}
+		else if (item->Type == PipelineItem::ItemType::ComputePass) {
+			pipe::ComputePass* pass = (pipe::ComputePass*)item->Data;
+			key = ed::HashString(std::string(pass->Path) + ";" + pass->Entry, key);
+		}
+
+		return key;
+	}
+	uint64_t RenderEngine::m_getVariantKey(PipelineItem* item, const std::vector<ShaderMacro>& macros)
+	{
+		// the macros only matter together with the sources they were applied to
+		uint64_t key = ed::HashString(std::to_string(Settings::Instance().Project.SPIRVOptimization));
+		for (auto& macro : macros)
+			if (macro.Active)
+				key = ed::HashString(std::string(macro.Name) + "=" + macro.Value, key);
+		key = ed::HashData(&key, sizeof(key), getConstantsKey(m_getConstants(item)));
+
+		if (item->Type == PipelineItem::ItemType::ShaderPass) {
+			pipe::ShaderPass* pass = (pipe::ShaderPass*)item->Data;
+			key = ed::HashString(std::string(pass->VSEntry) + ";" + pass->PSEntry + ";" + pass->GSEntry + ";" + std::to_string(pass->GSUsed), key);
+			if (pass->CaptureBuffer != nullptr)
+				key = ed::HashString(std::string("capture ") + pass->CaptureOutputs, key); // linked into the program
+			if (pass->Multiview)
+				key = ed::HashString("multiview", key);
+			key = ed::HashString(m_project->LoadProjectFile(pass->VSPath), key);
+			key = ed::HashString(m_project->LoadProjectFile(pass->PSPath), key);
+			if (pass->GSUsed)
+				key = ed::HashString(m_project->LoadProjectFile(pass->GSPath), key);
+			if (pass->MSUsed) {
+				key = ed::HashString(m_project->LoadProjectFile(pass->MSPath) + ";" + std::to_string(pass->TSUsed), key);
+				if (pass->TSUsed)
+					key = ed::HashString(m_project->LoadProjectFile(pass->TSPath), key);
+			}
+		}
+		else if (item->Type == PipelineItem::ItemType::ComputePass) {
+			pipe::ComputePass* pass = (pipe::ComputePass*)item->Data;
+			key = ed::HashString(pass->Entry, key);
+			key = ed::HashString(m_project->LoadProjectFile(pass->Path), key);
+		}
+
+		return key == 0 ? 1 : key; // 0 is used for unknown sources
+	}
+	void RenderEngine::m_storeVariant(PipelineItem* item, uint64_t key, GLuint program, GLuint debugProgram, const ShaderPack& sources)
+	{
+		auto& variants = m_variants[item];
+
+		auto existing = variants.find(key);
+		if (existing != variants.end()) {
+			glDeleteProgram(existing->second.Program);
+			glDeleteProgram(existing->second.DebugProgram);
+			glDeleteShader(existing->second.Sources.VS);
+			glDeleteShader(existing->second.Sources.PS);
+			glDeleteShader(existing->second.Sources.GS);
+		}
+
+		ShaderVariant& variant = variants[key];
+		variant.Program = program;
+		variant.DebugProgram = debugProgram;
+		variant.Sources = sources;
+		variant.LastUse = ++m_variantClock;
+
+		// throw away the variant that wasn't used for the longest time
+		if (variants.size() > VARIANT_CACHE_SIZE) {
+			auto oldest = variants.begin();
+			for (auto it = variants.begin(); it != variants.end(); it++)
+				if (it->second.LastUse < oldest->second.LastUse)
+					oldest = it;
+
+			glDeleteProgram(oldest->second.Program);
+			glDeleteProgram(oldest->second.DebugProgram);
+			glDeleteShader(oldest->second.Sources.VS);
+			glDeleteShader(oldest->second.Sources.PS);
+			glDeleteShader(oldest->second.Sources.GS);
+			variants.erase(oldest);
+		}
+	}
+	bool RenderEngine::m_useVariant(PipelineItem* item, int index, uint64_t key)
+	{
+		auto variants = m_variants.find(item);
+		if (variants == m_variants.end())
+			return false;
+
+		auto it = variants->second.find(key);
+		if (it == variants->second.end())
+			return false;
+
+		ShaderVariant variant = it->second;
+		variants->second.erase(it);
+
+		// current program becomes one of the stored variants
+		uint64_t oldKey = m_variantKeys[item];
+		m_deleteInstrumentedShaders(item);
+		if (oldKey != 0 && m_shaders[index] != 0)
+			m_storeVariant(item, oldKey, m_shaders[index], m_debugShaders[index], m_shaderSources[index]);
+		else {
+			glDeleteProgram(m_shaders[index]);
+			glDeleteProgram(m_debugShaders[index]);
+			glDeleteShader(m_shaderSources[index].VS);
+			glDeleteShader(m_shaderSources[index].PS);
+			glDeleteShader(m_shaderSources[index].GS);
+		}
+
+		m_shaders[index] = variant.Program;
+		m_staticPasses.erase(item);
+		m_debugShaders[index] = variant.DebugProgram;
+		m_shaderSources[index] = variant.Sources;
+		m_variantKeys[item] = key;
+
+		m_msgs->ClearGroup(item->Name);
+		m_msgs->BuildOccured = true;
+		if (item->Type == PipelineItem::ItemType::ShaderPass) {
+			pipe::ShaderPass* pass = (pipe::ShaderPass*)item->Data;
+			pass->Variables.UpdateTextureList(variant.Sources.PSCode, variant.Sources.VSCode, variant.Sources.GSCode);
+			pass->Variables.UpdateUniformInfo(variant.Program);
+		}
+		else if (item->Type == PipelineItem::ItemType::ComputePass)
+			((pipe::ComputePass*)item->Data)->Variables.UpdateUniformInfo(variant.Program);
+		m_msgs->Add(MessageStack::Type::Message, item->Name, "Switched to an already compiled variant.");
+
+		m_frameDirty = true;
+		m_contentGeneration++;
+
+		return true;
+	}
+	void RenderEngine::m_deleteVariants(PipelineItem* item)
+	{
+		for (auto it = m_variants.begin(); it != m_variants.end();) {
+			if (item != nullptr && it->first != item) {
+				it++;
+				continue;
+			}
+
+			for (auto& variant : it->second) {
+				glDeleteProgram(variant.second.Program);
+				glDeleteProgram(variant.second.DebugProgram);
+				glDeleteShader(variant.second.Sources.VS);
+				glDeleteShader(variant.second.Sources.PS);
+				glDeleteShader(variant.second.Sources.GS);
+			}
+			it = m_variants.erase(it);
+		}
+
+		if (item == nullptr)
+			m_variantKeys.clear();
+		else
+			m_variantKeys.erase(item);
+	}
+	bool RenderEngine::m_isGSUsedSet(GLuint rt)
+	{
+		bool ret = false;
+		for (int i = 0; i < m_items.size(); i++) {
+			if (m_items[i]->Type == PipelineItem::ItemType::ShaderPass) {
+				pipe::ShaderPass* pass = (pipe::ShaderPass*)m_items[i]->Data;
+				for (int j = 0; j < pass->RTCount; j++)
+					if (pass->RenderTextures[j] == rt)
+						ret = pass->GSUsed;
+			}
+		}
+
+		return ret;
+	}
+	void RenderEngine::m_applyMacros(std::string& src, const std::vector<ShaderMacro>& macros)
+	{
+		size_t verLoc = src.find_first_of("#version");
+		size_t lineLoc = src.find_first_of('\n', verLoc + 1) + 1;
+		std::string strMacro = "";
+
+		for (auto &macro : macros)
+		{
+			if (!macro.Active)
+				continue;
+
+			strMacro += "#define " + std::string(macro.Name) + " " + std::string(macro.Value) + "\n";
+		}
+
+		if (strMacro.size() > 0)
+			src.insert(lineLoc, strMacro);
+	}
+	int RenderEngine::m_applyMultiview(std::string& src, int stage)
+	{
+		// this runs on the compile workers too
+		size_t verLoc = src.find("#version");
+		size_t lineLoc = verLoc == std::string::npos ? 0 : src.find('\n', verLoc) + 1;
+		src.insert(lineLoc, "#extension GL_OVR_multiview2 : require\n");
+
+		// the view count goes after the other #extension directives
+		if (stage == 0) {
+			size_t declPos = 0, dirPos = 0;
+			while ((dirPos = src.find('#', dirPos)) != std::string::npos) {
+				size_t lineEnd = src.find('\n', dirPos);
+				lineEnd = lineEnd == std::string::npos ? src.size() : lineEnd + 1;
+				if (src.compare(dirPos, 8, "#version") == 0 || src.compare(dirPos, 10, "#extension") == 0)
+					declPos = lineEnd;
+				dirPos = lineEnd;
+			}
+			src.insert(declPos, "layout(num_views = " + std::to_string(STEREO_VIEW_COUNT) + ") in;\n");
+			return 2;
+		}
+
+		return 1;
+	}
+	std::vector<ShaderMacro> RenderEngine::m_getConstants(PipelineItem* item)
+	{
+		std::vector<ShaderMacro> ret;
+
+		ShaderVariableContainer* vars = nullptr;
+		if (item->Type == PipelineItem::ItemType::ShaderPass)
+			vars = &((pipe::ShaderPass*)item->Data)->Variables;
+		else if (item->Type == PipelineItem::ItemType::ComputePass)
+			vars = &((pipe::ComputePass*)item->Data)->Variables;
+		else
+			return ret;
+
+		for (ShaderVariable* var : vars->GetVariables()) {
+			if (!(var->Flags & (char)ShaderVariable::Flag::Constant) || var->System != SystemShaderVariable::None || var->Function != FunctionShaderVariable::None)
+				continue;
+
+			ShaderMacro constant;
+			constant.Active = true;
+			strncpy(constant.Name, var->Name, sizeof(constant.Name) - 1);
+			constant.Name[sizeof(constant.Name) - 1] = 0;
+
+			ShaderVariable::ValueType type = var->GetType();
+			if (type == ShaderVariable::ValueType::Boolean1)
+				snprintf(constant.Value, sizeof(constant.Value), "%d", (int)var->AsBoolean());
+			else if (type == ShaderVariable::ValueType::Integer1)
+				snprintf(constant.Value, sizeof(constant.Value), "%d", var->AsInteger());
+			else if (type == ShaderVariable::ValueType::Float1)
+				snprintf(constant.Value, sizeof(constant.Value), "%.9g", var->AsFloat());
+			else
+				continue;
+
+			ret.push_back(constant);
+		}
+
+		return ret;
+	}
+	void RenderEngine::m_applyConstants(std::string& src, const std::vector<ShaderMacro>& constants)
+	{
+		// this runs on the compile workers too
+		if (constants.empty())
+			return;
+
+		std::string defines;
+		for (const auto& constant : constants) {
+			std::string name = constant.Name;
+			std::smatch match;
+
+			// [layout(...)] uniform [precision] float quality; -> const float quality = 4.0;
+			std::regex uniformRe("(layout\\s*\\([^)]*\\)\\s*)?uniform\\s+(?:(?:lowp|mediump|highp)\\s+)?(\\w+)\\s+" + name + "\\s*;");
+			if (std::regex_search(src, match, uniformRe)) {
+				std::string literal = getConstantLiteral(constant.Value, match[2].str());
+				if (!literal.empty())
+					src.replace(match.position(0), match.length(0), "const " + match[2].str() + " " + name + " = " + literal + ";");
+				continue;
+			}
+
+			// const int quality = SPIRV_CROSS_CONSTANT_ID_0; -> the #ifndef SPIRV-Cross wrote in front of it keeps our value
+			std::regex specRe("const\\s+(\\w+)\\s+" + name + "\\s*=\\s*(SPIRV_CROSS_CONSTANT_ID_\\d+)\\s*;");
+			if (std::regex_search(src, match, specRe)) {
+				std::string literal = getConstantLiteral(constant.Value, match[1].str());
+				if (!literal.empty())
+					defines += "#define " + match[2].str() + " " + literal + "\n";
+			}
+		}
+
+		if (!defines.empty()) {
+			size_t verLoc = src.find("#version");
+			size_t lineLoc = verLoc == std::string::npos ? 0 : src.find('\n', verLoc) + 1;
+			src.insert(lineLoc, defines);
+		}
+	}
+	void RenderEngine::m_checkConstants(PipelineItem* item)
+	{
+		auto queued = m_constantKeys.find(item);
+		if (queued == m_constantKeys.end() || queued->second == getConstantsKey(m_getConstants(item)))
+			return;
+
+		// one build at a time while a slider is dragged, the next frame picks up the latest value
+		for (const auto& job : m_compileJobs)
+			if (job->Item == item && !job->Background)
+				return;
+
+		m_queueCompile(item);
+	}
+	void RenderEngine::m_bindSystemBlock(GLuint program)
+	{
+		// HLSL cbuffers go through SPIRV-Cross which prefixes the block name with type_
+		GLuint index = glGetUniformBlockIndex(program, "SHADERed_Globals");
+		if (index == GL_INVALID_INDEX)
+			index = glGetUniformBlockIndex(program, "type_SHADERed_Globals");
+
+		if (index != GL_INVALID_INDEX)
+			glUniformBlockBinding(program, index, m_sysBlockBinding);
+
+		// programs that can draw batched geometry
+		if (m_batchSupported) {
+			GLuint batchIndex = glGetProgramResourceIndex(program, GL_SHADER_STORAGE_BLOCK, DRAW_BATCH_BLOCK_NAME);
+			if (batchIndex != GL_INVALID_INDEX) {
+				glShaderStorageBlockBinding(program, batchIndex, m_batchBinding);
+				m_batchPrograms.insert(program);
+			} else
+				m_batchPrograms.erase(program);
+		}
+
+		if (m_bindlessBinding != -1) {
+			GLuint bindlessIndex = glGetProgramResourceIndex(program, GL_SHADER_STORAGE_BLOCK, BINDLESS_TABLE_BLOCK_NAME);
+			if (bindlessIndex != GL_INVALID_INDEX)
+				glShaderStorageBlockBinding(program, bindlessIndex, m_bindlessBinding);
+		}
+
+		// programs that call SHADERed_VirtualLod()
+		if (m_virtualBinding != -1) {
+			GLuint virtualIndex = glGetProgramResourceIndex(program, GL_SHADER_STORAGE_BLOCK, VIRTUAL_TEXTURE_BLOCK_NAME);
+			if (virtualIndex != GL_INVALID_INDEX)
+				glShaderStorageBlockBinding(program, virtualIndex, m_virtualBinding);
+		}
+
+		// programs with printf() calls
+		if (m_traceBinding != -1) {
+			GLuint traceIndex = glGetProgramResourceIndex(program, GL_SHADER_STORAGE_BLOCK, SHADER_TRACE_BLOCK_NAME);
+			if (traceIndex != GL_INVALID_INDEX) {
+				glShaderStorageBlockBinding(program, traceIndex, m_traceBinding);
+				m_tracePrograms.insert(program);
+			} else
+				m_tracePrograms.erase(program);
+		}
+	}
+	void RenderEngine::m_reportUnusedPasses()
+	{
+		const std::vector<PipelineItem*>& unused = m_scheduler.GetUnused();
+
+		// passes that are used again are reported the next time they become unused
+		for (auto it = m_unusedReported.begin(); it != m_unusedReported.end();) {
+			if (std::count(unused.begin(), unused.end(), *it) == 0)
+				it = m_unusedReported.erase(it);
+			else
+				it++;
+		}
+
+		for (PipelineItem* pass : unused)
+			if (m_unusedReported.insert(pass).second)
+				m_msgs->Add(MessageStack::Type::Warning, pass->Name, "None of the render textures that this pass draws to are sampled - the pass can be turned off");
+	}
+	bool RenderEngine::IsOccluded(PipelineItem* item)
+	{
+		auto query = m_occlusion.find(item);
+		return query != m_occlusion.end() && query->second.Occluded;
+	}
+	bool RenderEngine::m_beginOcclusionQuery(PipelineItem* item, bool& test)
+	{
+		OcclusionQuery& query = m_occlusion[item];
+		test = false;
+
+		if (query.Pending) {
+			GLint available = 0;
+			glGetQueryObjectiv(query.ID, GL_QUERY_RESULT_AVAILABLE, &available);
+			if (available) {
+				GLint passed = 0;
+				glGetQueryObjectiv(query.ID, GL_QUERY_RESULT, &passed);
+				query.Occluded = passed == 0;
+				query.Pending = false;
+			}
+		}
+
+		// a skipped item can't be tested, so it's drawn every few frames to check if it became visible again
+		if (query.Occluded && query.Skipped < RENDER_OCCLUSION_RETEST) {
+			query.Skipped++;
+			return false;
+		}
+		query.Skipped = 0;
+
+		// still waiting for the previous result
+		if (query.Pending)
+			return true;
+
+		if (query.ID == 0)
+			glGenQueries(1, &query.ID);
+		glBeginQuery(GL_ANY_SAMPLES_PASSED, query.ID);
+		query.Pending = test = true;
+
+		return true;
+	}
+	void RenderEngine::m_clearOcclusionQueries(PipelineItem* item)
+	{
+		if (item != nullptr) {
+			auto query = m_occlusion.find(item);
+			if (query == m_occlusion.end())
+				return;
+			if (query->second.ID != 0)
+				glDeleteQueries(1, &query->second.ID);
+			m_occlusion.erase(query);
+			return;
+		}
+
+		for (auto& query : m_occlusion)
+			if (query.second.ID != 0)
+				glDeleteQueries(1, &query.second.ID);
+		m_occlusion.clear();
+	}
+	const RenderEngine::DrawList& RenderEngine::m_getDrawList(pipe::ShaderPass* pass)
+	{
+		DrawList& list = m_drawLists[pass];
+		if (list.Items == pass->Items && list.Pick == m_pick && list.ValueRevision == m_itemValueRevision && list.ValueTotal == m_itemValues.size())
+			return list;
+
+		list.Items = pass->Items;
+		list.Pick = m_pick;
+		list.ValueRevision = m_itemValueRevision;
+		list.ValueTotal = m_itemValues.size();
+		list.Values.clear();
+		list.Commands.resize(pass->Items.size());
+
+		for (int j = 0; j < pass->Items.size(); j++) {
+			PipelineItem* item = pass->Items[j];
+			DrawCommand& cmd = list.Commands[j];
+			cmd.Item = item;
+			cmd.Type = item->Type;
+			cmd.Data = item->Data;
+			cmd.Picked = std::count(m_pick.begin(), m_pick.end(), item) > 0;
+
+			// only the geometry & the models have their own values
+			cmd.ValueStart = list.Values.size();
+			if (item->Type == PipelineItem::ItemType::Geometry || item->Type == PipelineItem::ItemType::Model)
+				for (int k = 0; k < m_itemValues.size(); k++)
+					if (m_itemValues[k].Item == item)
+						list.Values.push_back(k);
+			cmd.ValueCount = list.Values.size() - cmd.ValueStart;
+		}
+
+		return list;
+	}
+	void RenderEngine::m_drawGeometry(pipe::GeometryItem* geo)
+	{
+		if (geo->Type == pipe::GeometryItem::Captured) {
+			if (geo->VertexBuffer != nullptr && geo->VAO != 0) {
+				glBindVertexArray(geo->VAO);
+				m_capture.Draw((BufferObject*)geo->VertexBuffer, geo->Topology, geo->Instanced, geo->InstanceCount);
+			}
+			return;
+		}
+
+		// a capture only takes triangles
+		bool paused = m_capture.IsActive() && !VertexCapture::IsCaptured(geo->Topology);
+		if (paused)
+			m_capture.Pause();
+
+		glBindVertexArray(geo->VAO);
+
+		if (geo->Type == pipe::GeometryItem::Generated) {
+			if (geo->Instanced)
+				glDrawElementsInstanced(geo->Topology, geo->IndexCount, GL_UNSIGNED_INT, nullptr, geo->InstanceCount);
+			else
+				glDrawElements(geo->Topology, geo->IndexCount, GL_UNSIGNED_INT, nullptr);
+		} else if (geo->Instanced)
+			glDrawArraysInstanced(geo->Topology, 0, eng::GeometryFactory::VertexCount[geo->Type], geo->InstanceCount);
+		else
+			glDrawArrays(geo->Topology, 0, eng::GeometryFactory::VertexCount[geo->Type]);
+
+		if (paused)
+			m_capture.Resume();
+	}
+	void RenderEngine::m_generateGeometry(bool isDebug)
+	{
+		float time = SystemVariableManager::Instance().GetTime();
+
+		for (PipelineItem* item : m_items) {
+			if (item->Type != PipelineItem::ItemType::ShaderPass)
+				continue;
+
+			for (PipelineItem* child : ((pipe::ShaderPass*)item->Data)->Items) {
+				if (child->Type != PipelineItem::ItemType::Geometry)
+					continue;
+
+				// the debug renders draw what the last frame did
+				pipe::GeometryItem* geo = (pipe::GeometryItem*)child->Data;
+				if (geo->Type == pipe::GeometryItem::Generated && (geo->Dirty || (geo->GenAnimated && !isDebug && !m_paused)))
+					GeometryGenerator::Instance().Generate(geo, time);
+			}
+		}
+	}
+	void RenderEngine::m_skinModels(bool isDebug)
+	{
+		// the debug renders draw what the last frame did
+		if (isDebug)
+			return;
+
+		float time = SystemVariableManager::Instance().GetTime();
+
+		std::vector<eng::Model*> posed;
+		for (PipelineItem* item : m_items) {
+			if (item->Type != PipelineItem::ItemType::ShaderPass || !((pipe::ShaderPass*)item->Data)->Active)
+				continue;
+
+			for (PipelineItem* child : ((pipe::ShaderPass*)item->Data)->Items) {
+				if (child->Type != PipelineItem::ItemType::Model)
+					continue;
+
+				// the VBOs are shared by every item that uses the file, the first one decides the pose
+				pipe::Model* mdl = (pipe::Model*)child->Data;
+				if (mdl->Data == nullptr || !mdl->Data->IsSkinned() || std::count(posed.begin(), posed.end(), mdl->Data) > 0)
+					continue;
+				posed.push_back(mdl->Data);
+
+				int anim = mdl->Data->FindAnimation(mdl->Animation);
+				ModelSkinner::Instance().Skin(mdl->Data, anim, anim == -1 ? 0.0f : time * mdl->AnimationSpeed);
+			}
+		}
+	}
+	int RenderEngine::m_getBatchLength(const std::vector<PipelineItem*>& items, int start)
+	{
+		auto& itemVarValues = GetItemVariableValues();
+		auto hasItemValues = [&](PipelineItem* item) -> bool {
+			for (const auto& val : itemVarValues)
+				if (val.Item == item)
+					return true;
+			return false;
+		};
+
+		PipelineItem* first = items[start];
+		if (!DrawBatchCache::IsBatchable(first) || hasItemValues(first))
+			return 0;
+
+		// items with their own variable values still need their own draw call
+		int end = start + 1;
+		while (end < items.size() && DrawBatchCache::IsCompatible(first, items[end]) && !hasItemValues(items[end]))
+			end++;
+
+		return end - start;
+	}
+	void RenderEngine::m_setGeometryTransform(PipelineItem* item, pipe::GeometryItem* geo, int width, int height)
+	{
+		SystemVariableManager& systemVM = SystemVariableManager::Instance();
+
+		if (geo->Type == pipe::GeometryItem::Rectangle) {
+			// TODO: don't multiply with m_renderer->GetLastRenderSize() but rather with actual RT size
+			glm::vec4 tile = systemVM.GetTile();
+			float rectWidth = width / tile.z, rectHeight = height / tile.w;
+			glm::vec3 scaleRect(geo->Scale.x * rectWidth, geo->Scale.y * rectHeight, 1.0f);
+			glm::vec3 posRect((geo->Position.x + 0.5f) * rectWidth, (geo->Position.y + 0.5f) * rectHeight, -1000.0f);
+			systemVM.SetGeometryTransform(item, scaleRect, geo->Rotation, posRect);
+		} else
+			systemVM.SetGeometryTransform(item, geo->Scale, geo->Rotation, geo->Position);
+	}
+	void RenderEngine::m_drawBatch(PipelineItem* pass, int start, int count, int width, int height)
+	{
+		SystemVariableManager& systemVM = SystemVariableManager::Instance();
+		pipe::ShaderPass* data = (pipe::ShaderPass*)pass->Data;
+
+		std::vector<DrawBatchCache::ItemData> itemData(count);
+		for (int j = 0; j < count; j++) {
+			PipelineItem* item = data->Items[start + j];
+
+			if (m_pickAwaiting) m_pickItem(item, m_wasMultiPick);
+
+			if (item->Type == PipelineItem::ItemType::Geometry) {
+				pipe::GeometryItem* geoData = reinterpret_cast<pipe::GeometryItem*>(item->Data);
+
+				m_setGeometryTransform(item, geoData, width, height);
+			} else {
+				pipe::Model* objData = reinterpret_cast<pipe::Model*>(item->Data);
+				systemVM.SetGeometryTransform(item, objData->Scale, objData->Rotation, objData->Position);
+			}
+
+			itemData[j].Transform = systemVM.GetGeometryTransform(item);
+			itemData[j].Info = glm::uvec4(std::count(m_pick.begin(), m_pick.end(), item) > 0, start + j, 0, 0);
+		}
+
+		// per item system values (GeometryTransform, IsPicked) come from the first item - the shader should use SHADERed_Batch instead
+		PipelineItem* first = data->Items[start];
+		systemVM.SetPicked(itemData[0].Info.x);
+		data->Variables.Bind(first);
+
+		m_batches.Draw(pass, data->InputLayout, data->Items, start, count, itemData, m_batchBinding);
+	}
+	bool RenderEngine::m_usesCamera(pipe::ShaderPass* pass)
+	{
+		// geometry & mesh shaders can emit vertices anywhere, the eyes of a multiview pass see more than the camera
+		if (pass->GSUsed || pass->MSUsed || pass->Multiview)
+			return false;
+
+		bool view = false, proj = false;
+		for (ShaderVariable* var : pass->Variables.GetVariables()) {
+			if (var->System == SystemShaderVariable::ViewProjection)
+				return true;
+			view |= var->System == SystemShaderVariable::View;
+			proj |= var->System == SystemShaderVariable::Projection;
+		}
+
+		return view && proj;
+	}
+	int RenderEngine::m_pickModelLOD(PipelineItem* item, pipe::Model* data)
+	{
+		if (data->LOD >= 0 || data->Data->GetLODCount() <= 1)
+			return std::max(data->LOD, 0);
+
+		SystemVariableManager& systemVM = SystemVariableManager::Instance();
+
+		// bounding sphere in view space
+		glm::mat4 world = systemVM.GetGeometryTransform(item);
+		glm::vec3 minBound = data->Data->GetMinBound(), maxBound = data->Data->GetMaxBound();
+		glm::vec3 center = glm::vec3(world * glm::vec4((minBound + maxBound) * 0.5f, 1.0f));
+		float scale = std::max(glm::length(glm::vec3(world[0])), std::max(glm::length(glm::vec3(world[1])), glm::length(glm::vec3(world[2]))));
+		float radius = glm::length(maxBound - minBound) * 0.5f * scale;
+
+		float dist = -(systemVM.GetViewMatrix() * glm::vec4(center, 1.0f)).z;
+		if (dist <= radius)
+			return 0; // camera is inside of the model
+
+		// projected diameter in pixels
+		float pixels = radius / dist * systemVM.GetProjectionMatrix()[1][1] * systemVM.GetViewportSize().y * systemVM.GetTile().w; // the tile's projection is scaled
+
+		return data->Data->PickLOD(pixels);
+	}
+	void RenderEngine::m_updateSystemBlock()
+	{
+		SystemVariableManager& systemVM = SystemVariableManager::Instance();
+		Camera* cam = systemVM.GetCamera();
+
+		SystemBlock data;
+		memset(&data, 0, sizeof(SystemBlock));
+		data.View = systemVM.GetViewMatrix();
+		data.Projection = systemVM.GetProjectionMatrix();
+		data.ViewProjection = data.Projection * data.View;
+		data.Orthographic = systemVM.GetOrthographicMatrix();
+		data.ViewOrthographic = data.Orthographic * data.View;
+		data.Mouse = systemVM.GetMouse();
+		data.MouseButton = systemVM.GetMouseButton();
+		data.CameraPosition = cam->GetPosition();
+		data.CameraDirection = cam->GetViewDirection();
+		data.KeysWASD = systemVM.GetKeysWASD();
+		data.ViewportSize = systemVM.GetViewportSize();
+		data.MousePosition = systemVM.GetMousePosition();
+		data.Time = systemVM.GetTime();
+		data.TimeDelta = systemVM.GetTimeDelta();
+		data.FrameIndex = systemVM.GetFrameIndex();
+		data.SampleIndex = systemVM.GetSampleIndex();
+		for (int i = 0; i < STEREO_VIEW_COUNT; i++) {
+			data.EyeView[i] = systemVM.GetEyeViewMatrix(i);
+			data.EyeProjection[i] = systemVM.GetEyeProjectionMatrix(i);
+		}
+
+		// only the viewport size & sample index can change between passes - skip the upload if nothing changed
+		if (!m_sysBlockValid || memcmp(&data, &m_sysBlockData, sizeof(SystemBlock)) != 0) {
+			glBindBuffer(GL_UNIFORM_BUFFER, m_sysUBO);
+			glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(SystemBlock), &data);
+			glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+			m_sysBlockData = data;
+			m_sysBlockValid = true;
+		}
+
+		glBindBufferBase(GL_UNIFORM_BUFFER, m_sysBlockBinding, m_sysUBO);
+
+		GLuint bindless = m_objects->GetBindlessTable();
+		if (bindless != 0 && m_bindlessBinding != -1)
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, m_bindlessBinding, bindless);
+
+		GLuint virtualPages = m_objects->GetVirtualPageBlock();
+		if (virtualPages != 0 && m_virtualBinding != -1)
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, m_virtualBinding, virtualPages);
+	}
+	void RenderEngine::m_includeCheck(std::string& src, int& lineBias, MessageStack* msgs, std::vector<std::string>* included)
+	{
+		std::vector<std::string> includeStack;
+		m_resolveIncludes(src, includeStack, lineBias, msgs, included);
+	}
+	void RenderEngine::m_resolveIncludes(std::string &src, std::vector<std::string>& includeStack, int& lineBias, MessageStack* msgs, std::vector<std::string>* included)
+	{
+		// files pushed here are visible to the rest of this file and its includes but not to the file that included it
+		size_t stackSize = includeStack.size();
+
+		size_t incLoc = src.find("#include");
+		Settings& settings = Settings::Instance();
+
+		std::vector<std::string> paths = settings.Project.IncludePaths;
+		paths.push_back(".");
+
+		while (incLoc != std::string::npos) {
+			bool isAfterNewline = true;
+			if (incLoc != 0)
+				if (src[incLoc - 1] != '\n')
+					isAfterNewline = false;
+
+			if (!isAfterNewline) {
+				incLoc = src.find("#include", incLoc + 1);
+				continue;
+			}
+
+			size_t quotePos = src.find_first_of("\"<", incLoc);
+			size_t quoteEnd = src.find_first_of("\">", quotePos + 1);
+			std::string fileName = src.substr(quotePos+1, quoteEnd - quotePos-1);
+
+			for (int i = 0; i < paths.size(); i++) {
+				std::string ipath = paths[i];
+				char last = ipath[ipath.size() - 1];
+				if (last != '\\' && last != '/')
+					ipath += "/";
+
+				ipath += fileName;
+
+				src.erase(incLoc, src.find_first_of('\n', incLoc) - incLoc);
+
+				bool recursive = std::count(includeStack.begin(), includeStack.end(), ipath) > 0;
+				if (recursive)
+					msgs->Add(ed::MessageStack::Type::Error, msgs->CurrentItem, "Recursive #include detected");
+
+				std::string absPath = m_project->GetProjectPath(ipath);
+				std::string incFileSrc;
+				if (!recursive && IncludeCache::Instance().Get(absPath, incFileSrc)) {
+					includeStack.push_back(ipath);
+					if (included != nullptr)
+						included->push_back(absPath);
+
+					lineBias = std::count(incFileSrc.begin(), incFileSrc.end(), '\n');
+
+					m_resolveIncludes(incFileSrc, includeStack, lineBias, msgs, included);
+
+					src.insert(incLoc, incFileSrc);
+
+					break;
+				}
+			}
+
+			incLoc = src.find("#include", incLoc + 1);
+		}
+
+		includeStack.resize(stackSize);
+	}
+	bool RenderEngine::m_bindShadingRate(pipe::ShaderPass* pass)
+	{
+#ifdef GL_NV_shading_rate_image
+		static const GLenum shadingRates[] = {
+			GL_SHADING_RATE_1_INVOCATION_PER_PIXEL_NV,
+			GL_SHADING_RATE_1_INVOCATION_PER_1X2_PIXELS_NV,
+			GL_SHADING_RATE_1_INVOCATION_PER_2X1_PIXELS_NV,
+			GL_SHADING_RATE_1_INVOCATION_PER_2X2_PIXELS_NV,
+			GL_SHADING_RATE_1_INVOCATION_PER_2X4_PIXELS_NV,
+			GL_SHADING_RATE_1_INVOCATION_PER_4X2_PIXELS_NV,
+			GL_SHADING_RATE_1_INVOCATION_PER_4X4_PIXELS_NV
+		};
+		const int rateCount = sizeof(shadingRates) / sizeof(*shadingRates);
+
+		if (!m_shadingRateSupported || (pass->ShadingRate <= 0 && pass->ShadingRateImage.empty()))
+			return false;
+
+		// the image has to be R8UI, anything else falls back to the fixed rate
+		GLuint image = 0;
+		if (!pass->ShadingRateImage.empty()) {
+			ObjectManagerItem* item = m_objects->GetObjectManagerItem(pass->ShadingRateImage);
+			if (item != nullptr && item->RT != nullptr && item->RT->Format == GL_R8UI)
+				image = item->Texture;
+			else if (item != nullptr && item->Image != nullptr && item->Image->Format == GL_R8UI)
+				image = item->Image->Texture;
+		}
+		if (image == 0 && pass->ShadingRate <= 0)
+			return false;
+
+		// without an image every tile reads index 0
+		if (image != 0)
+			glShadingRateImagePaletteNV(0, 0, rateCount, shadingRates);
+		else
+			glShadingRateImagePaletteNV(0, 0, 1, &shadingRates[std::min(pass->ShadingRate, rateCount - 1)]);
+		glBindShadingRateImageNV(image);
+		glEnable(GL_SHADING_RATE_IMAGE_NV);
+
+		return true;
+#else
+		return false;
+#endif
+	}
+	void RenderEngine::m_unbindShadingRate()
+	{
+#ifdef GL_NV_shading_rate_image
+		glDisable(GL_SHADING_RATE_IMAGE_NV);
+		glBindShadingRateImageNV(0);
+#endif
+	}
+	void RenderEngine::m_updateRenderTargets(int width, int height)
+	{
+		std::vector<RenderTargetUsage> usage;
+		std::vector<GLuint> usageTex;
+
+		std::vector<ObjectManagerItem*>& objs = m_objects->GetItemDataList();
+		for (ObjectManagerItem* obj : objs) {
+			if (obj->RT == nullptr)
+				continue;
+
+			RenderTargetUsage rt;
+			rt.Object = obj->RT;
+			rt.Size = obj->RT->CalculateSize(width, height);
+			rt.Format = obj->RT->Format;
+			rt.Target = obj->RT->GetTarget();
+			rt.Layers = obj->RT->GetLayerCount();
+			rt.Clear = obj->RT->Clear;
+			rt.Multisampled = false;
+			rt.ColorFirst = rt.ColorLast = rt.DepthFirst = rt.DepthLast = -1;
+
+			usage.push_back(rt);
+			usageTex.push_back(obj->Texture);
+		}
+
+		// find the range of passes in which each rt's attachments are alive
+		for (int i = 0; i < m_items.size(); i++) {
+			if (m_items[i]->Type != PipelineItem::ItemType::ShaderPass)
+				continue;
+
+			pipe::ShaderPass* data = (pipe::ShaderPass*)m_items[i]->Data;
+			if (!data->Active || data->Items.size() <= 0 || data->RTCount == 0)
+				continue;
+
+			for (int j = 0; j < data->RTCount; j++) {
+				auto tex = std::find(usageTex.begin(), usageTex.end(), data->RenderTextures[j]);
+				if (tex == usageTex.end())
+					continue;
+
+				RenderTargetUsage& rt = usage[tex - usageTex.begin()];
+				if (rt.ColorFirst == -1)
+					rt.ColorFirst = i;
+				rt.ColorLast = i;
+				rt.Multisampled = rt.Multisampled || data->Multisample;
+
+				if (j == data->RTCount - 1) {
+					if (rt.DepthFirst == -1)
+						rt.DepthFirst = i;
+					rt.DepthLast = i;
+				}
+			}
+		}
+
+		int samples = Settings::Instance().Preview.MSAA;
+		if (usage == m_rtUsage && samples == m_rtPoolSamples)
+			return;
+
+		m_rtUsage = usage;
+		m_rtPoolSamples = samples;
+
+		m_rtPool.Begin();
+		for (const auto& rt : usage) {
+			RenderTextureObject* obj = rt.Object;
+
+			m_rtPool.AddDedicated(rt.Size, rt.Format, rt.Layers);
+
+			// the depth buffer is cleared every time a pass with a different depth buffer starts (same for color when rt->Clear is set)
+			// layered passes need a depth buffer with the same layers
+			obj->DepthStencilBuffer = 0;
+			if (rt.DepthFirst != -1)
+				obj->DepthStencilBuffer = m_rtPool.Acquire(rt.Size, GL_DEPTH24_STENCIL8, 0, rt.DepthFirst, rt.DepthLast, rt.Target, rt.Layers);
+
+			// multisampled buffers are only attached when MSAA is on
+			obj->BufferMS = obj->DepthStencilBufferMS = 0;
+			if (samples != 1 && rt.Multisampled && rt.Target == GL_TEXTURE_2D) {
+				// a rt that isn't cleared keeps its samples from the last frame so it can't share the storage
+				if (rt.ColorFirst != -1) {
+					if (rt.Clear)
+						obj->BufferMS = m_rtPool.Acquire(rt.Size, rt.Format, samples, rt.ColorFirst, rt.ColorLast);
+					else
+						obj->BufferMS = m_rtPool.Acquire(rt.Size, rt.Format, samples, 0, std::numeric_limits<int>::max());
+				}
+				if (rt.DepthFirst != -1)
+					obj->DepthStencilBufferMS = m_rtPool.Acquire(rt.Size, GL_DEPTH24_STENCIL8, samples, rt.DepthFirst, rt.DepthLast);
+			}
+		}
+		m_rtPool.End();
+
+		// attachments changed - rebuild every fbo
+		for (auto& fbo : m_fbos)
+			std::fill(fbo.second.begin(), fbo.second.end(), 0);
+
+		const RenderTargetPool::Stats& stats = m_rtPool.GetStats();
+		Logger::Get().Log("Render target pool: " + std::to_string(stats.Textures) + " textures, " + std::to_string(stats.Allocated / (1024 * 1024)) + " MB instead of " + std::to_string(stats.Requested / (1024 * 1024)) + " MB");
+	}
+	void RenderEngine::m_updatePassFBO(ed::pipe::ShaderPass* pass, const std::string& name)
+	{
+		bool changed = false;
+
+		for (int i = 0; i < pass->RTCount; i++)
 			if (pass->RenderTextures[i] != m_fbos[pass][i]) {
 				changed = true;
 				break;
@@ -2126,25 +5363,47 @@ namespace ed
 			glDeleteFramebuffers(1, &m_fboMS[pass]);
 		}
 
-		// normal FBO
+		// normal FBO - cubemaps & texture arrays are attached with all of their layers, the primitives pick one with gl_Layer
+		// multiview passes get the first STEREO_VIEW_COUNT layers as their views instead
+		bool layered = m_isLayeredPass(pass);
+		bool multiview = layered && pass->Multiview && m_multiviewSupported;
 		glGenFramebuffers(1, &pass->FBO);
 		glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)pass->FBO);
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depthID, 0);
+		gl::SetObjectLabel(GL_FRAMEBUFFER, pass->FBO, name);
+		if (multiview)
+			m_attachMultiview(GL_DEPTH_STENCIL_ATTACHMENT, depthID);
+		else if (layered)
+			glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, depthID, 0);
+		else
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depthID, 0);
 		for (int i = 0; i < pass->RTCount; i++) {
 			GLuint texID = pass->RenderTextures[i];
 
 			if (texID == 0) continue;
 
 			// attach
-			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, texID, 0);
+			if (multiview)
+				m_attachMultiview(GL_COLOR_ATTACHMENT0 + i, texID);
+			else if (layered)
+				glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, texID, 0);
+			else
+				glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, texID, 0);
 		}
 		GLenum retval = glCheckFramebufferStatus(GL_FRAMEBUFFER);
 		glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
+		if (multiview && retval != GL_FRAMEBUFFER_COMPLETE)
+			Logger::Get().Log("The render textures of the multiview pass " + name + " have to be texture arrays with at least " + std::to_string(STEREO_VIEW_COUNT) + " layers", true);
+		else if (layered && retval != GL_FRAMEBUFFER_COMPLETE)
+			Logger::Get().Log("The render textures of " + name + " have to be all cubemaps or all texture arrays with the same number of layers", true);
+		else if (pass->Multiview && !layered)
+			Logger::Get().Log("The multiview pass " + name + " has to draw to texture arrays", true);
+
 
 		// MSAA fbo
 		glGenFramebuffers(1, &m_fboMS[pass]);
 		glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)m_fboMS[pass]);
+		gl::SetObjectLabel(GL_FRAMEBUFFER, m_fboMS[pass], name + " (MSAA)");
 		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D_MULTISAMPLE, depthMSID, 0);
 		for (int i = 0; i < pass->RTCount; i++) {
 			GLuint texID = pass->RenderTextures[i];
@@ -2162,4 +5421,53 @@ namespace ed
 
 		m_fbosNeedUpdate = false;
 	}
-}
\ No newline at end of file
+	void RenderEngine::m_attachMultiview(GLenum attachment, GLuint texture)
+	{
+#ifdef GL_OVR_multiview
+		glFramebufferTextureMultiviewOVR(GL_FRAMEBUFFER, attachment, texture, 0, 0, STEREO_VIEW_COUNT);
+#endif
+	}
+	bool RenderEngine::m_isLayeredPass(ed::pipe::ShaderPass* pass)
+	{
+		for (int i = 0; i < pass->RTCount; i++) {
+			if (pass->RenderTextures[i] == 0 || pass->RenderTextures[i] == m_rtColor)
+				continue;
+
+			RenderTextureObject* rtObject = m_objects->GetRenderTexture(pass->RenderTextures[i]);
+			if (rtObject != nullptr && rtObject->IsLayered())
+				return true;
+		}
+		return false;
+	}
+	void RenderEngine::ReplaceRenderTexture(GLuint oldTexture, GLuint newTexture)
+	{
+		for (PipelineItem* item : m_items) {
+			if (item->Type != PipelineItem::ItemType::ShaderPass)
+				continue;
+
+			pipe::ShaderPass* pass = (pipe::ShaderPass*)item->Data;
+			for (int i = 0; i < pass->RTCount; i++)
+				if (pass->RenderTextures[i] == oldTexture)
+					pass->RenderTextures[i] = newTexture;
+		}
+
+		m_rtUsage.clear();
+		m_fbosNeedUpdate = true;
+	}
+	void RenderEngine::SwapRenderTexture(GLuint a, GLuint b)
+	{
+		// only the changed passes get new FBOs, the attachments' sizes & formats stay the same
+		for (PipelineItem* item : m_items) {
+			if (item->Type != PipelineItem::ItemType::ShaderPass)
+				continue;
+
+			pipe::ShaderPass* pass = (pipe::ShaderPass*)item->Data;
+			for (int i = 0; i < pass->RTCount; i++) {
+				if (pass->RenderTextures[i] == a)
+					pass->RenderTextures[i] = b;
+				else if (pass->RenderTextures[i] == b)
+					pass->RenderTextures[i] = a;
+			}
+		}
+	}
+}
@@ -4,10 +4,32 @@
 #include "ProjectParser.h"
 #include "MessageStack.h"
 #include "PluginAPI/PluginManager.h"
+#include "FrameTimeline.h"
+#include "GPUProfiler.h"
+#include "ProgramCache.h"
+#include "RenderTargetPool.h"
+#include "DrawBatchCache.h"
+#include "InstanceCuller.h"
+#include "PassCondition.h"
+#include "VertexCapture.h"
+#include "PassScheduler.h"
+#include "ShaderComparison.h"
+#include "WorkGroupTuner.h"
+#include "ReloadProfiler.h"
+#include "Accumulator.h"
+#include "MipChain.h"
+#include "ReducedResolution.h"
+#include "TimeSlicer.h"
+#include "PassWatchdog.h"
+#include "ShaderTrace.h"
 #include "../Engine/Timer.h"
+#include "../Engine/ThreadPool.h"
 
 #include <unordered_map>
+#include <unordered_set>
 #include <functional>
+#include <memory>
+#include <atomic>
 
 #include <glm/glm.hpp>
 #ifdef _WIN32
@@ -20,9 +42,15 @@
 	#include <GL/gl.h>
 #endif
 
+#define RENDER_OUTPUT_BUFFERS 3 // shown, pending and the one that the next frame is copied to
+#define RENDER_MSAA_HEADROOM 128 // px, the multisampled window targets only grow and are allocated in steps of this size
+#define RENDER_OCCLUSION_RETEST 8 // frames that a fully occluded item is skipped for before it's drawn & tested again
+#define STEREO_VIEW_COUNT 2 // views of a multiview pass = the layers of its render textures that it draws to
+
 namespace ed
 {
 	class ObjectManager;
+	struct RenderTextureObject;
 
 	class RenderEngine
 	{
@@ -36,12 +64,17 @@ namespace ed
 
 		void Render(int width, int height, bool isDebug = false);
 		inline void Render(bool isDebug = false) { Render(m_lastSize.x, m_lastSize.y, isDebug); }
+		// the preview can't be seen - only the audio passes & the compute passes with a fixed tick rate are executed
+		void RenderBackground(int width, int height);
+		bool HasBackgroundPasses();
 		void Recompile(const char* name);
 		void RecompileFile(const char* fname);
+		void RecompileFiles(const std::vector<std::string>& files, const std::string& trigger = "file change", std::chrono::steady_clock::time_point changed = std::chrono::steady_clock::now()); // absolute paths of shaders and/or headers, only the stages that use them are preprocessed again
 		void RecompileFromSource(const char* name, const std::string& vs = "", const std::string& ps = "", const std::string& gs = "");
 		void Pick(float sx, float sy, bool multiPick, std::function<void(PipelineItem*)> func = nullptr);
 		void Pick(PipelineItem* item, bool add = false);
 		inline bool IsPicked(PipelineItem* item) { return std::count(m_pick.begin(), m_pick.end(), item); }
+		inline const std::vector<PipelineItem*>& GetPicked() { return m_pick; }
 
 		void FlushCache();
 		void AddPickedItem(PipelineItem* pipe, bool multiPick = false);
@@ -52,12 +85,89 @@ namespace ed
 
 		inline void RequestTextureResize() { m_lastSize = glm::ivec2(1,1); }
 		inline GLuint GetTexture() { return m_rtColor; }
+		GLuint GetOutputTexture(); // last frame that the GPU has finished - use this one for displaying the preview
 		inline GLuint GetDepthTexture() { return m_rtDepth; }
 		inline glm::ivec2 GetLastRenderSize() { return m_lastSize; }
 
+		// renders the passes that draw to the window with the loop counting fragment shaders and turns the counts into a heatmap
+		void RenderCostHeatmap(int width, int height);
+		inline void RenderCostHeatmap() { RenderCostHeatmap(m_lastSize.x, m_lastSize.y); }
+		inline GLuint GetCostTexture() { return m_costTexture; }
+		inline int GetCostMax() { return m_costMax; }
+
+		// same for the number of fragments shaded per pixel - quads = true shows the share of the shaded lanes that were only
+		// helper invocations of partially covered 2x2 quads instead (needs GL 4.5, falls back to the overdraw otherwise)
+		void RenderOverdrawHeatmap(int width, int height, bool quads);
+		inline void RenderOverdrawHeatmap(bool quads) { RenderOverdrawHeatmap(m_lastSize.x, m_lastSize.y, quads); }
+		inline GLuint GetOverdrawTexture() { return m_overdrawTexture; }
+		inline int GetOverdrawMax() { return m_overdrawMax; }
+		inline float GetQuadEfficiency() { return m_quadEfficiency; } // shaded fragments / all lanes, -1 if not measured
+
 		inline bool IsPaused() { return m_paused; }
 		void Pause(bool pause);
 
+		// shaders are preprocessed/transcompiled on worker threads - the old program is used until the new one is ready
+		void UpdateCompilation();
+		void WaitForCompilation();
+		inline bool IsCompiling() { return m_compileJobs.size() > 0; }
+
+		// compiles the on/off combinations of the pass' macros in the background so that switching between them is instant
+		void PrecompileVariants(PipelineItem* item);
+		int GetVariantCount(PipelineItem* item); // number of programs stored for the other macro sets
+		int GetPrecompileJobCount(PipelineItem* item);
+
+		// preview frames are only rendered again when something they depend on could have changed
+		inline void InvalidateFrame() { m_frameDirty = true; }
+		// the texture is displayed so its MSAA resolve can't be skipped even if no pass samples it
+		inline void KeepResolved(GLuint rt) { m_keepResolved.insert(rt); }
+		inline void ReleaseVertexCapture(GLuint buffer) { m_capture.Release(buffer); } // the buffer was deleted
+		inline void InvalidatePassCache() { m_frameDirty = true; m_contentGeneration++; m_staticPasses.clear(); } // contents of an object changed outside of the pipeline
+		void ReplaceRenderTexture(GLuint oldTexture, GLuint newTexture); // the rt got a new GL texture, see ObjectManager::SetRenderTextureLayers()
+		void SwapRenderTexture(GLuint a, GLuint b); // an rt & its history swapped their textures, see ObjectManager::SwapRenderTextureHistory()
+		bool CanReuseFrame(int width, int height);
+		inline bool CanReuseFrame() { return CanReuseFrame(m_lastSize.x, m_lastSize.y); }
+		inline unsigned int GetContentGeneration() { return m_contentGeneration; } // changes when a program or an object changes, not on UI events
+
+		inline GPUProfiler& GetProfiler() { return m_profiler; }
+		inline FrameTimeline& GetTimeline() { return m_timeline; }
+		bool IsOccluded(PipelineItem* item); // geometry with occlusion culling that currently isn't drawn
+
+		// renders the pass with its own program and with the one built from the given sources in the same frames
+		// (psPath empty -> pass' pixel shader, psSource not empty -> used instead of the file's content)
+		bool StartComparison(PipelineItem* pass, const std::vector<ShaderMacro>& macros, const std::string& psPath, const std::string& psSource, std::string& error);
+		void StopComparison();
+		inline ShaderComparison& GetComparison() { return m_compare; }
+
+		// measures the compute pass with the local sizes that fit its dispatch, while the preview is running
+		bool StartTuning(PipelineItem* pass, std::string& error);
+		inline void StopTuning() { m_tuner.Stop(); }
+		bool ApplyTuning(int candidate); // sets the pass' LOCAL_SIZE_* macros & group counts and recompiles it
+		inline WorkGroupTuner& GetTuner() { return m_tuner; }
+
+		inline Accumulator& GetAccumulator() { return m_accumulator; } // progress of the passes with pipe::ShaderPass::Accumulate
+
+		inline bool IsShadingRateSupported() { return m_shadingRateSupported; } // GL_NV_shading_rate_image
+		inline bool IsMultiviewSupported() { return m_multiviewSupported; } // GL_OVR_multiview2
+		inline void RebuildFBO(pipe::ShaderPass* pass) { m_fboCount[pass] = 0; } // the attachments change, e.g. pipe::ShaderPass::Multiview
+		inline glm::ivec2 GetShadingRateTexelSize() { return m_shadingRateTexel; } // pixels covered by a texel of a shading rate image
+
+		// renders the audio pass' shader offline, as fast as the GPU can (wav, ogg or flac - picked by the extension)
+		bool ExportAudio(PipelineItem* item, const std::string& path, float start, float duration);
+
+		inline const RenderTargetPool::Stats& GetRenderTargetStats() { return m_rtPool.GetStats(); }
+
+		// textures that the renderer allocates for itself (window targets, shared attachments, accumulation...)
+		struct InternalTexture
+		{
+			std::string Name;
+			GLenum Target;
+			GLuint Texture;
+		};
+		void GetInternalTextures(std::vector<InternalTexture>& out);
+		inline unsigned int GetFrameIndex() { return m_frameIndex; } // rendered preview frames
+		inline ShaderTrace& GetShaderTrace() { return m_trace; }
+		unsigned int GetLastUsed(bool isBuffer, GLuint id); // frame in which a pass last read or wrote the resource, 0 = never
+
 	public:
 		struct ItemVariableValue
 		{
@@ -75,11 +185,12 @@ namespace ed
 		};
 
 		inline std::vector<ItemVariableValue>& GetItemVariableValues() { return m_itemValues; }
-		inline void AddItemVariableValue(const ItemVariableValue& item) { m_itemValues.push_back(item); }
+		inline void AddItemVariableValue(const ItemVariableValue& item) { m_itemValues.push_back(item); m_itemValueRevision++; }
 		inline void RemoveItemVariableValue(PipelineItem* item, ShaderVariable* var) {
 			for (int i = 0; i < m_itemValues.size(); i++)
 				if (m_itemValues[i].Item == item && m_itemValues[i].Variable == var) {
 					m_itemValues.erase(m_itemValues.begin() + i);
+					m_itemValueRevision++;
 					return;
 				}
 		}
@@ -87,6 +198,7 @@ namespace ed
 			for (int i = 0; i < m_itemValues.size(); i++)
 				if (m_itemValues[i].Item == item) {
 					m_itemValues.erase(m_itemValues.begin() + i);
+					m_itemValueRevision++;
 					i--;
 				}
 		}
@@ -101,6 +213,8 @@ namespace ed
 
 		// are compute shaders supported?
 		bool m_computeSupported;
+		bool m_meshShaderSupported; // GL_NV_mesh_shader
+		bool m_multiviewSupported; // GL_OVR_multiview2
 
 		// paused time?
 		bool m_paused;
@@ -109,14 +223,42 @@ namespace ed
 		glm::ivec2 m_lastSize;
 		GLuint m_rtColor, m_rtDepth, m_rtColorMS, m_rtDepthMS;
 		bool m_fbosNeedUpdate;
+		glm::ivec2 m_msSize; // allocated size of m_rtColorMS and m_rtDepthMS - rendered through a viewport and resolved with a blit
+		int m_msSamples;
+		GLint m_msFormat;
+
+		/* output chain - finished frames are copied out of m_rtColor so that the UI never samples the texture that's being rendered to */
+		GLuint m_outputTex[RENDER_OUTPUT_BUFFERS];
+		GLsync m_outputFence[RENDER_OUTPUT_BUFFERS];
+		glm::ivec2 m_outputSize[RENDER_OUTPUT_BUFFERS];
+		GLint m_outputFormat[RENDER_OUTPUT_BUFFERS];
+		int m_outputShown, m_outputPending; // -1 if there's no such frame
+		void m_queueOutput();
+		void m_clearOutput();
+
+		// Settings::Project.StereoPreview - the first two layers of the render texture side by side in m_rtColor
+		GLuint m_stereoFBO[2]; // read, draw
+		void m_presentStereo();
 
 		// check for the #include's & change the source code accordingly (includeStack == prevent recursion)
-		void m_includeCheck(std::string& src, std::vector<std::string> includeStack, int& lineBias);
+		void m_includeCheck(std::string& src, int& lineBias, MessageStack* msgs, std::vector<std::string>* included = nullptr); // included = absolute paths of all the included files
+		void m_resolveIncludes(std::string& src, std::vector<std::string>& includeStack, int& lineBias, MessageStack* msgs, std::vector<std::string>* included);
 
 		// apply macros to GLSL source code
-		void m_applyMacros(std::string& source, pipe::ShaderPass* pass);
-		void m_applyMacros(std::string& source, pipe::ComputePass* pass);
-		void m_applyMacros(std::string& source, pipe::AudioPass* pass); // TODO: merge this function with the ones above
+		void m_applyMacros(std::string& source, const std::vector<ShaderMacro>& macros);
+		inline void m_applyMacros(std::string& source, pipe::ShaderPass* pass) { m_applyMacros(source, pass->Macros); }
+		inline void m_applyMacros(std::string& source, pipe::ComputePass* pass) { m_applyMacros(source, pass->Macros); }
+		inline void m_applyMacros(std::string& source, pipe::AudioPass* pass) { m_applyMacros(source, pass->Macros); }
+
+		// variables with ShaderVariable::Flag::Constant (Name = variable, Value = its value) - they replace the GLSL uniform
+		// declarations & set the specialization constants in the code that SPIRV-Cross generated
+		std::vector<ShaderMacro> m_getConstants(PipelineItem* item);
+		void m_applyConstants(std::string& source, const std::vector<ShaderMacro>& constants);
+
+		// the GL_OVR_multiview2 directives of pipe::ShaderPass::Multiview, returns the number of lines that were added
+		int m_applyMultiview(std::string& source, int stage);
+		std::unordered_map<PipelineItem*, uint64_t> m_constantKeys; // of the last build that was queued
+		void m_checkConstants(PipelineItem* item); // rebuilds the pass if one of its constants changed
 		
 		// does a shader pass with GSUsed set also use this texture
 		bool m_isGSUsedSet(GLuint rt);
@@ -131,6 +273,20 @@ namespace ed
 		bool m_wasMultiPick;
 		void m_pickItem(PipelineItem* item, bool multiPick);
 
+		/* GPU picking - the debug ID render is read back through a PBO a frame or two later */
+		bool m_gpuPickAwaiting;
+		glm::ivec2 m_gpuPickPixel;
+		GLuint m_gpuPickPBO;
+		GLsync m_gpuPickFence;
+		void m_gpuPickRender(int width, int height);
+		void m_gpuPickPoll();
+		void m_gpuPickCancel();
+
+		// reads a single texel of a color texture - used instead of downloading whole render textures
+		GLuint m_readFBO;
+		glm::u8vec4 m_readPixel(GLuint tex, int x, int y);
+		void m_bindReadFBO(GLuint tex);
+
 		// cache
 		std::vector<PipelineItem*> m_items;
 		std::vector<GLuint> m_shaders;
@@ -138,16 +294,304 @@ namespace ed
 		std::map<pipe::ShaderPass*, std::vector<GLuint>> m_fbos;
 		std::map<pipe::ShaderPass*, GLuint> m_fboMS; // multisampled fbo's
 		std::map<pipe::ShaderPass*, GLuint> m_fboCount;
-		struct ShaderPack {ShaderPack() {VS=GS=PS=0;} GLuint VS, PS, GS;};
+		struct ShaderPack {
+			ShaderPack() {VS=GS=PS=0; BuildKey=0;}
+			GLuint VS, PS, GS;
+			std::string VSCode, PSCode, GSCode; // programs loaded from the program cache have no shader objects, mesh shader passes keep the mesh & task shaders in VS & GS
+			uint64_t BuildKey; // everything but the file contents that the code depends on
+		};
 		std::vector<ShaderPack> m_shaderSources;
 
 		GLuint m_debugPixelShader, m_debugVertexPickShader, m_debugInstancePickShader;
 
-		void m_updatePassFBO(ed::pipe::ShaderPass* pass);
+		/* cost heatmap - programs are created from the cached sources the first time they are needed */
+		bool m_costRender;
+		std::unordered_map<PipelineItem*, GLuint> m_costShaders;
+		GLuint m_costTexture;
+		int m_costMax;
+		GLuint m_getCostShader(int index);
+		void m_deleteInstrumentedShaders(PipelineItem* item);
+		GLuint m_createInstrumentedProgram(const std::string& vs, const std::string& ps);
+		int m_getWindowOutput(pipe::ShaderPass* pass);
+		void m_buildHeatmap(GLuint& texture, const std::vector<float>& values, int width, int height); // values normalized, < 0 -> nothing drawn
+
+		/* overdraw heatmap - the window's color target accumulates one per fragment with additive blending */
+		bool m_overdrawRender, m_overdrawQuads;
+		std::unordered_map<PipelineItem*, GLuint> m_overdrawShaders[2]; // [overdraw, quads]
+		GLuint m_overdrawTexture;
+		int m_overdrawMax;
+		float m_quadEfficiency;
+		GLuint m_getOverdrawShader(int index);
+		void m_bindOverdrawState(pipe::ShaderPass* pass);
+
+		/* depth prepass - the pass' vertex shader with an empty pixel shader, 0 if the pass can't use one */
+		std::unordered_map<PipelineItem*, GLuint> m_prepassShaders;
+		GLuint m_getDepthPrepassShader(int index);
+		bool m_drawDepthPrepass(int index, int width, int height);
+
+		void m_updatePassFBO(ed::pipe::ShaderPass* pass, const std::string& name);
+		bool m_isLayeredPass(ed::pipe::ShaderPass* pass); // draws to cubemaps or texture arrays, they aren't multisampled
+		void m_attachMultiview(GLenum attachment, GLuint texture); // the first STEREO_VIEW_COUNT layers to the bound FBO
+
+		/* render texture attachments */
+		struct RenderTargetUsage
+		{
+			RenderTextureObject* Object;
+			glm::ivec2 Size;
+			GLuint Format;
+			GLenum Target;
+			int Layers;
+			bool Clear;
+			bool Multisampled; // a pass with MSAA on draws to it
+			int ColorFirst, ColorLast; // pass indices, -1 if the rt isn't rendered to
+			int DepthFirst, DepthLast; // passes that use the rt's depth buffer (rt is the last one attached)
+
+			inline bool operator==(const RenderTargetUsage& u) const
+			{
+				return Object == u.Object && Size == u.Size && Format == u.Format && Target == u.Target && Layers == u.Layers && Clear == u.Clear && Multisampled == u.Multisampled &&
+					ColorFirst == u.ColorFirst && ColorLast == u.ColorLast && DepthFirst == u.DepthFirst && DepthLast == u.DepthLast;
+			}
+		};
+		std::vector<RenderTargetUsage> m_rtUsage;
+		int m_rtPoolSamples;
+		RenderTargetPool m_rtPool;
+		void m_updateRenderTargets(int width, int height);
 
 		std::vector<ItemVariableValue> m_itemValues; // list of all values to apply once we start rendering 
+		unsigned int m_itemValueRevision;
+
+		/* flattened items of the shader passes - rebuilt when the pass' items, the picked items or the per item values change */
+		struct DrawCommand
+		{
+			PipelineItem* Item;
+			PipelineItem::ItemType Type;
+			void* Data;
+			bool Picked;
+			int ValueStart, ValueCount; // range of DrawList::Values
+		};
+		struct DrawList
+		{
+			DrawList() { ValueRevision = 0; ValueTotal = 0; }
+			std::vector<PipelineItem*> Items, Pick; // what the list was built from
+			unsigned int ValueRevision;
+			size_t ValueTotal;
+
+			std::vector<DrawCommand> Commands; // one per item, in the same order as pipe::ShaderPass::Items
+			std::vector<int> Values;		   // indices in m_itemValues
+		};
+		std::unordered_map<pipe::ShaderPass*, DrawList> m_drawLists;
+		const DrawList& m_getDrawList(pipe::ShaderPass* pass);
+
+		GPUProfiler m_profiler;
+		FrameTimeline m_timeline; // preview frames only, no debug or partial renders
+
+		/* render order & clears - passes are only reordered when Settings::Preview.ReorderPasses is on */
+		PassScheduler m_scheduler;
+		std::unordered_set<PipelineItem*> m_unusedReported;
+		void m_reportUnusedPasses();
 
-		eng::Timer m_cacheTimer;
+		/* occlusion culling - the result of an item's query is read without waiting in one of the following frames */
+		struct OcclusionQuery
+		{
+			OcclusionQuery() : ID(0), Pending(false), Occluded(false), Skipped(0) {}
+			GLuint ID;
+			bool Pending, Occluded;
+			int Skipped;
+		};
+		std::unordered_map<PipelineItem*, OcclusionQuery> m_occlusion;
+		bool m_beginOcclusionQuery(PipelineItem* item, bool& test);
+		void m_clearOcclusionQueries(PipelineItem* item = nullptr);
+
+		/* static passes - with Settings::Preview.CacheStaticPasses a pass isn't drawn again while its inputs stay the same */
+		std::unordered_map<PipelineItem*, uint64_t> m_staticPasses; // pass -> signature of the inputs it was last drawn with
+		std::unordered_map<GLuint64, unsigned int> m_writeCount; // texture/buffer -> how many times it was drawn to/written
+
+		/* fixed rate compute passes */
+		struct ComputeTick
+		{
+			std::chrono::steady_clock::time_point Last;
+			double Pending; // steps that are due but weren't dispatched yet
+		};
+		std::unordered_map<PipelineItem*, ComputeTick> m_computeTicks;
+		GLuint m_getComputeTicks(PipelineItem* item, float rate);
+		bool m_isPassCached(int index, int width, int height);
+		bool m_getPassSignature(int index, int width, int height, uint64_t& signature); // false if the pass changes on its own
+
+		/* built-in SHADERed_Globals uniform block (std140) */
+		struct SystemBlock
+		{
+			glm::mat4 View, Projection, ViewProjection, Orthographic, ViewOrthographic;
+			glm::vec4 Mouse, MouseButton, CameraPosition, CameraDirection;
+			glm::ivec4 KeysWASD;
+			glm::vec2 ViewportSize, MousePosition;
+			float Time, TimeDelta;
+			int FrameIndex;
+			unsigned int SampleIndex;
+			glm::mat4 EyeView[STEREO_VIEW_COUNT], EyeProjection[STEREO_VIEW_COUNT]; // index with gl_ViewID_OVR
+		};
+		GLuint m_sysUBO, m_sysBlockBinding;
+		SystemBlock m_sysBlockData;
+		bool m_sysBlockValid;
+		void m_bindSystemBlock(GLuint program);
+		void m_updateSystemBlock();
+
+		/* geometry items drawn with one multi draw call when the shader declares the SHADERed_Batch SSBO */
+		DrawBatchCache m_batches;
+		bool m_batchSupported;
+		GLuint m_batchBinding;
+		std::unordered_set<GLuint> m_batchPrograms;
+
+		/* compute prepass for the instanced items with GPUCulling, uses the 3 SSBO binding points below the bindless table */
+		InstanceCuller m_instanceCuller;
+
+		/* occlusion query & indirect dispatch predicates of the passes with a ConditionBuffer, uses the 2 SSBO binding points below the virtual texture's one */
+		PassCondition m_condition;
+
+		/* transform feedback of the passes with a CaptureBuffer & the draws of the Captured geometry */
+		VertexCapture m_capture;
+
+		/* running averages of the passes with pipe::ShaderPass::Accumulate */
+		Accumulator m_accumulator;
+
+		/* low resolution copies of the targets of the passes with pipe::ShaderPass::ResolutionScale */
+		ReducedResolution m_reduced;
+
+		/* levels of the render textures with RenderTextureObject::Mipmaps, rebuilt after the passes that draw to them */
+		MipChain m_mipChain;
+
+		/* heavy passes split into slices that are waited for one by one (Settings::Preview.TimeSliceBudget) */
+		TimeSlicer m_slicer;
+
+		/* passes that take longer than Settings::Preview.PassBudget - shader passes are deactivated, compute passes are
+		   skipped until they are recompiled */
+		PassWatchdog m_watchdog;
+		void m_pollWatchdog();
+
+		/* ObjectManager's table of bindless texture handles, bound to the binding point below SHADERed_Batch */
+		GLint m_bindlessBinding; // -1 -> not supported
+		GLint m_virtualBinding; // binding of VIRTUAL_TEXTURE_BLOCK_NAME, -1 -> not supported
+
+		/* printf() records of the shaders, SHADERed_Trace is bound below the InstanceCuller's binding points */
+		ShaderTrace m_trace;
+		GLint m_traceBinding; // -1 -> not supported
+		std::unordered_set<GLuint> m_tracePrograms;
+		int m_getBatchLength(const std::vector<PipelineItem*>& items, int start);
+		void m_drawBatch(PipelineItem* pass, int start, int count, int width, int height);
+		void m_setGeometryTransform(PipelineItem* item, pipe::GeometryItem* geo, int width, int height); // rectangles are sized to the current tile of the render size
+		void m_drawGeometry(pipe::GeometryItem* geo); // binds the VAO & draws all of the vertices (or the indices of the generated geometry)
+		void m_generateGeometry(bool isDebug); // runs the kernels of the generated geometry whose buffers are out of date
+		void m_skinModels(bool isDebug);	   // poses the skinned models, once per eng::Model
+		int m_pickModelLOD(PipelineItem* item, pipe::Model* data); // pipe::Model::LOD == -1 -> by the projected size of the bounds
+		bool m_usesCamera(pipe::ShaderPass* pass); // can the items in this pass be frustum culled
+
+		unsigned int m_cachedGeneration;
 		void m_cache();
+
+		bool m_frameDirty;
+		unsigned int m_frameGeneration;
+		unsigned int m_contentGeneration;
+
+		/* A/B comparison - partial frames render the passes up to the compared one */
+		ShaderComparison m_compare;
+		int m_compareVersion; // version of the compared pass that is rendered right now, -1 = not measured
+		bool m_comparePartial, m_compareCapture;
+		bool m_backgroundOnly; // RenderBackground()
+		bool m_isBackgroundPass(PipelineItem* item);
+		void m_renderComparison(int width, int height);
+
+		/* compute work group size tuning */
+		WorkGroupTuner m_tuner;
+		GLuint m_compileTuningCandidate(PipelineItem* pass, const glm::uvec3& size, std::string& error);
+		void m_runTuner(PipelineItem* pass, GLuint program, const std::vector<BindingDescriptor>& srvs);
+		bool m_isFrameStatic();
+
+		/* memory barriers for the results of the compute passes */
+		std::unordered_map<GLuint64, GLbitfield> m_barrierState; // resource written by a compute pass -> barrier bits issued since then
+		void m_barrierWrite(const std::vector<BindingDescriptor>& ubos, GLbitfield issued);
+		void m_barrierRead(PipelineItem* pass, const std::vector<BindingDescriptor>& srvs, const std::vector<BindingDescriptor>& ubos);
+		void m_barrierEndFrame();
+
+		/* frame in which the passes last accessed a resource - keys are the same as m_barrierState's */
+		unsigned int m_frameIndex;
+		std::unordered_map<GLuint64, unsigned int> m_lastUsed;
+		void m_markUsed(PipelineItem* pass, const std::vector<BindingDescriptor>& srvs, const std::vector<BindingDescriptor>& ubos);
+
+		void m_bindAudioPass(int index, const std::vector<BindingDescriptor>& srvs, const std::vector<BindingDescriptor>& ubos);
+
+		/* asynchronous shader compilation */
+		enum class CompileState
+		{
+			Preprocessing,	// worker threads are loading/transcompiling the sources
+			Compiling,		// waiting for glCompileShader
+			Linking			// waiting for glLinkProgram
+		};
+		struct CompileStage
+		{
+			int Type; // 0 = VS, 1 = PS, 2 = GS, 3 = CS, 4 = TS, 5 = MS
+			std::string Path, Entry;
+			std::string Code; // final GLSL code
+			int LineBias;
+			GLuint Shader;
+			MessageStack Messages; // messages from the worker thread
+			float Timings[ReloadProfiler::StepCount]; // preprocessing steps measured by the worker
+		};
+		struct CompileJob
+		{
+			PipelineItem* Item;
+			std::string Name;
+			bool GSUsed;
+			std::vector<ShaderMacro> Macros;
+			std::vector<ShaderMacro> Constants; // m_getConstants()
+			std::vector<CompileStage> Stages;
+			std::vector<std::string> CaptureVaryings; // VertexCapture::GetVaryings(), linked into the program
+			int Views; // > 1 -> m_applyMultiview()
+			std::atomic<int> Remaining; // number of stages that are still being preprocessed
+			CompileState State;
+			GLuint Program, DebugProgram;
+			bool UseCache, Cached;
+			uint64_t Hash, DebugHash; // program cache keys
+			uint64_t VariantKey, BuildKey;
+			bool Background; // precompiled variant - the result goes to m_variants and not to m_shaders
+			std::chrono::steady_clock::time_point StepStart; // when the current GL step was started
+			float CompileTime, LinkTime;
+		};
+		std::vector<std::shared_ptr<CompileJob>> m_compileJobs;
+		bool m_parallelCompile; // GL_KHR_parallel_shader_compile
+		bool m_invalidateSupported; // glInvalidateFramebuffer
+		bool m_shadingRateSupported;
+		glm::ivec2 m_shadingRateTexel;
+		bool m_bindShadingRate(pipe::ShaderPass* pass); // true -> the pass uses coarse shading, m_unbindShadingRate() after its draw calls
+		void m_unbindShadingRate();
+		std::unordered_set<GLuint> m_keepResolved; // render textures that the UI shows
+		ProgramCache m_programCache;
+		bool m_loadCachedProgram(CompileJob* job);
+		void m_queueCompile(PipelineItem* item, bool background = false, const std::vector<ShaderMacro>& macros = std::vector<ShaderMacro>(), int dirtyStages = -1); // dirtyStages = bit per stage type, others reuse the last build's code
+		void m_cancelCompile(PipelineItem* item, bool all = false); // all = also cancel the background jobs
+
+		// shader passes that were turned off when they were cached - compiled once they're turned on
+		std::unordered_set<PipelineItem*> m_deferredCompile;
+		void m_queueActivatedPasses();
+		void m_preprocessStage(CompileJob* job, CompileStage& stage);
+		bool m_updateCompileJob(CompileJob* job, bool wait); // returns true once the job is done
+		void m_finishCompileJob(CompileJob* job, bool compiled);
+		bool m_pollCompileJobs();
+
+		/* programs built for the other macro sets of a pass - switching back to one of them skips the compiler */
+		struct ShaderVariant
+		{
+			GLuint Program, DebugProgram;
+			ShaderPack Sources;
+			unsigned int LastUse;
+		};
+		std::unordered_map<PipelineItem*, std::unordered_map<uint64_t, ShaderVariant>> m_variants;
+		std::unordered_map<PipelineItem*, uint64_t> m_variantKeys; // variant that is currently in m_shaders, 0 if it isn't known (compiled from the editor's source)
+		unsigned int m_variantClock;
+		uint64_t m_getVariantKey(PipelineItem* item, const std::vector<ShaderMacro>& macros);
+		uint64_t m_getBuildKey(PipelineItem* item, const std::vector<ShaderMacro>& macros);
+		void m_storeVariant(PipelineItem* item, uint64_t key, GLuint program, GLuint debugProgram, const ShaderPack& sources);
+		bool m_useVariant(PipelineItem* item, int index, uint64_t key);
+		void m_deleteVariants(PipelineItem* item); // nullptr -> every item
+
+		eng::ThreadPool m_compilePool; // keep this last so that the workers stop before anything else is destroyed
 	};
 }
\ No newline at end of file
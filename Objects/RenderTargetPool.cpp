@@ -0,0 +1,154 @@
+#include "RenderTargetPool.h"
+
+#include <algorithm>
+
+namespace ed
+{
+	RenderTargetPool::RenderTargetPool()
+	{ }
+	RenderTargetPool::~RenderTargetPool()
+	{
+		Clear();
+	}
+	void RenderTargetPool::Begin()
+	{
+		for (auto& slot : m_slots)
+			slot.Lifetimes.clear();
+
+		m_stats = Stats();
+	}
+	GLuint RenderTargetPool::Acquire(glm::ivec2 size, GLuint format, int samples, int firstPass, int lastPass, GLenum target, int layers)
+	{
+		AddRequested(size, format, samples, layers);
+
+		// reuse a texture that isn't alive during [firstPass, lastPass]
+		for (auto& slot : m_slots) {
+			if (slot.Size != size || slot.Format != format || slot.Samples != samples || slot.Target != target || slot.Layers != layers)
+				continue;
+
+			bool overlaps = false;
+			for (const auto& life : slot.Lifetimes)
+				if (firstPass <= life.y && life.x <= lastPass) {
+					overlaps = true;
+					break;
+				}
+
+			if (!overlaps) {
+				slot.Lifetimes.push_back(glm::ivec2(firstPass, lastPass));
+				return slot.Texture;
+			}
+		}
+
+		Slot slot;
+		slot.Size = size;
+		slot.Format = format;
+		slot.Samples = samples;
+		slot.Target = target;
+		slot.Layers = layers;
+		slot.Lifetimes.push_back(glm::ivec2(firstPass, lastPass));
+
+		glGenTextures(1, &slot.Texture);
+		if (target != GL_TEXTURE_2D) {
+			GLenum dataFormat = format == GL_DEPTH24_STENCIL8 ? GL_DEPTH_STENCIL : GL_RGBA;
+			GLenum dataType = format == GL_DEPTH24_STENCIL8 ? GL_UNSIGNED_INT_24_8 : GL_UNSIGNED_BYTE;
+
+			glBindTexture(target, slot.Texture);
+			if (target == GL_TEXTURE_CUBE_MAP) {
+				for (int i = 0; i < 6; i++)
+					glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, format, size.x, size.y, 0, dataFormat, dataType, NULL);
+			} else
+				glTexImage3D(target, 0, format, size.x, size.y, layers, 0, dataFormat, dataType, NULL);
+			glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			glBindTexture(target, 0);
+		} else if (samples == 0) {
+			glBindTexture(GL_TEXTURE_2D, slot.Texture);
+			if (format == GL_DEPTH24_STENCIL8)
+				glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, size.x, size.y, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
+			else
+				glTexImage2D(GL_TEXTURE_2D, 0, format, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			glBindTexture(GL_TEXTURE_2D, 0);
+		} else {
+			glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, slot.Texture);
+			glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, samples, format, size.x, size.y, true);
+			glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
+		}
+
+		m_slots.push_back(slot);
+
+		return slot.Texture;
+	}
+	void RenderTargetPool::End()
+	{
+		for (int i = 0; i < m_slots.size(); i++) {
+			if (m_slots[i].Lifetimes.size() == 0) {
+				glDeleteTextures(1, &m_slots[i].Texture);
+				m_slots.erase(m_slots.begin() + i);
+				i--;
+				continue;
+			}
+
+			const Slot& slot = m_slots[i];
+			m_stats.Allocated += GetTexelSize(slot.Format) * slot.Size.x * slot.Size.y * std::max(slot.Samples, 1) * slot.Layers;
+		}
+
+		m_stats.Textures = m_slots.size();
+	}
+	void RenderTargetPool::AddDedicated(glm::ivec2 size, GLuint format, int layers)
+	{
+		m_stats.Dedicated += GetTexelSize(format) * size.x * size.y * layers;
+	}
+	void RenderTargetPool::AddRequested(glm::ivec2 size, GLuint format, int samples, int layers)
+	{
+		m_stats.Requested += GetTexelSize(format) * size.x * size.y * std::max(samples, 1) * layers;
+	}
+	void RenderTargetPool::Clear()
+	{
+		for (auto& slot : m_slots)
+			glDeleteTextures(1, &slot.Texture);
+		m_slots.clear();
+
+		m_stats = Stats();
+	}
+	size_t RenderTargetPool::GetTexelSize(GLuint format)
+	{
+		switch (format) {
+		case GL_RED: case GL_R8: case GL_R8_SNORM: case GL_R8I: case GL_R8UI:
+		case GL_R3_G3_B2: case GL_RGBA2:
+			return 1;
+
+		case GL_RG: case GL_RG8: case GL_RG8_SNORM: case GL_RG8I: case GL_RG8UI:
+		case GL_R16: case GL_R16_SNORM: case GL_R16F: case GL_R16I: case GL_R16UI:
+		case GL_RGB4: case GL_RGB5: case GL_RGBA4: case GL_RGB5_A1:
+			return 2;
+
+		case GL_RGB: case GL_RGB8: case GL_RGB8_SNORM: case GL_RGB8I: case GL_RGB8UI:
+			return 3;
+
+		case GL_RG16: case GL_RG16_SNORM: case GL_RG16F: case GL_RG16I: case GL_RG16UI:
+		case GL_R32F: case GL_R32I: case GL_R32UI:
+		case GL_RGB10: case GL_RGB10_A2: case GL_RGB10_A2UI:
+		case GL_R11F_G11F_B10F: case GL_RGB9_E5:
+		case GL_DEPTH24_STENCIL8:
+			return 4;
+
+		case GL_RGB12: case GL_RGBA12:
+		case GL_RGB16_SNORM: case GL_RGB16F: case GL_RGB16I: case GL_RGB16UI:
+			return 6;
+
+		case GL_RGBA16: case GL_RGBA16F: case GL_RGBA16I: case GL_RGBA16UI:
+		case GL_RG32F: case GL_RG32I: case GL_RG32UI:
+			return 8;
+
+		case GL_RGB32F: case GL_RGB32I: case GL_RGB32UI:
+			return 12;
+
+		case GL_RGBA32F: case GL_RGBA32I: case GL_RGBA32UI:
+			return 16;
+		}
+
+		return 4; // GL_RGBA, GL_RGBA8, ...
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/glew.h>
+#if defined(__APPLE__)
+	#include <OpenGL/gl.h>
+#else
+	#include <GL/gl.h>
+#endif
+
+namespace ed
+{
+	// owns the depth & multisampled attachments of the render textures - attachments that are never
+	// used at the same time (in the pipeline order) and have the same size & format share one texture
+	class RenderTargetPool
+	{
+	public:
+		RenderTargetPool();
+		~RenderTargetPool();
+
+		struct Stats
+		{
+			Stats() { Dedicated = Requested = Allocated = 0; Textures = 0; }
+			size_t Dedicated;	// color textures owned by the render textures themselves
+			size_t Requested;	// attachments needed if every render texture had its own storage
+			size_t Allocated;	// attachments actually allocated by the pool
+			int Textures;		// number of textures in the pool
+		};
+
+		// Acquire() calls between Begin() and End() describe the whole frame - slots that weren't acquired again are deleted in End()
+		void Begin();
+		GLuint Acquire(glm::ivec2 size, GLuint format, int samples, int firstPass, int lastPass, GLenum target = GL_TEXTURE_2D, int layers = 1); // target: 2D, 2D array or cubemap (6 layers)
+		void End();
+
+		void AddDedicated(glm::ivec2 size, GLuint format, int layers = 1);
+		void AddRequested(glm::ivec2 size, GLuint format, int samples, int layers = 1);
+
+		void Clear();
+
+		inline const Stats& GetStats() { return m_stats; }
+
+		static size_t GetTexelSize(GLuint format);
+
+		struct Slot
+		{
+			GLuint Texture;
+			glm::ivec2 Size;
+			GLuint Format;
+			int Samples;
+			GLenum Target;
+			int Layers;
+			std::vector<glm::ivec2> Lifetimes; // [first pass, last pass]
+		};
+		inline const std::vector<Slot>& GetSlots() { return m_slots; }
+
+	private:
+		std::vector<Slot> m_slots;
+		Stats m_stats;
+	};
+}
@@ -0,0 +1,131 @@
+#include "ResidentAssets.h"
+#include "Logger.h"
+
+#include <ghc/filesystem.hpp>
+
+namespace ed
+{
+	bool ResidentAssets::m_getStamp(const std::string& path, Stamp& stamp)
+	{
+		std::error_code ec;
+		stamp.Size = ghc::filesystem::file_size(path, ec);
+		if (ec)
+			return false;
+		stamp.Time = ghc::filesystem::last_write_time(path, ec).time_since_epoch().count();
+		return !ec;
+	}
+	std::string ResidentAssets::m_getKey(const std::string& path, unsigned int flags)
+	{
+		std::error_code ec;
+		ghc::filesystem::path abs = ghc::filesystem::absolute(path, ec);
+		return (ec ? path : abs.lexically_normal().generic_string()) + "|" + std::to_string(flags);
+	}
+	void ResidentAssets::Track(const std::string& path, unsigned int flags)
+	{
+		Stamp stamp;
+		if (m_getStamp(path, stamp))
+			m_tracked[m_getKey(path, flags)] = stamp;
+	}
+	bool ResidentAssets::m_isCurrent(const std::string& key, const std::string& path, bool take)
+	{
+		auto kept = m_kept.find(key);
+		if (kept == m_kept.end())
+			return false;
+
+		Stamp stamp;
+		if (!m_getStamp(path, stamp) || stamp.Size != kept->second.Size || stamp.Time != kept->second.Time)
+			return false;
+
+		if (take) {
+			m_tracked[key] = kept->second;
+			m_kept.erase(kept);
+		}
+		return true;
+	}
+
+	void ResidentAssets::KeepModel(const std::string& path, unsigned int flags, eng::Model* model)
+	{
+		std::string key = m_getKey(path, flags);
+		auto tracked = m_tracked.find(key);
+		if (tracked == m_tracked.end() || m_models.count(key) > 0) {
+			delete model;
+			return;
+		}
+
+		m_kept[key] = tracked->second;
+		m_tracked.erase(tracked);
+		m_models[key] = model;
+	}
+	bool ResidentAssets::HasModel(const std::string& path, unsigned int flags)
+	{
+		std::string key = m_getKey(path, flags);
+		return m_models.count(key) > 0 && m_isCurrent(key, path, false);
+	}
+	eng::Model* ResidentAssets::TakeModel(const std::string& path, unsigned int flags)
+	{
+		std::string key = m_getKey(path, flags);
+		auto entry = m_models.find(key);
+		if (entry == m_models.end())
+			return nullptr;
+
+		// a changed file is imported again
+		eng::Model* ret = entry->second;
+		m_models.erase(entry);
+		if (!m_isCurrent(key, path, true)) {
+			m_kept.erase(key);
+			delete ret;
+			return nullptr;
+		}
+
+		Logger::Get().Log("Reusing the already loaded 3D model " + path);
+		return ret;
+	}
+
+	void ResidentAssets::KeepTexture(const std::string& path, GLuint tex, const glm::ivec2& size)
+	{
+		std::string key = m_getKey(path, 0);
+		auto tracked = m_tracked.find(key);
+		if (tracked == m_tracked.end() || m_textures.count(key) > 0) {
+			glDeleteTextures(1, &tex);
+			return;
+		}
+
+		m_kept[key] = tracked->second;
+		m_tracked.erase(tracked);
+		m_textures[key] = { tex, size };
+	}
+	GLuint ResidentAssets::TakeTexture(const std::string& path, glm::ivec2& size)
+	{
+		std::string key = m_getKey(path, 0);
+		auto entry = m_textures.find(key);
+		if (entry == m_textures.end())
+			return 0;
+
+		GLuint ret = entry->second.Texture;
+		size = entry->second.Size;
+		m_textures.erase(entry);
+		if (!m_isCurrent(key, path, true)) {
+			m_kept.erase(key);
+			glDeleteTextures(1, &ret);
+			return 0;
+		}
+
+		Logger::Get().Log("Reusing the already loaded texture " + path);
+		return ret;
+	}
+
+	void ResidentAssets::Flush()
+	{
+		if (!m_models.empty() || !m_textures.empty())
+			Logger::Get().Log("Freeing " + std::to_string(m_models.size() + m_textures.size()) + " resources that the new project doesn't use");
+
+		for (auto& mdl : m_models)
+			delete mdl.second;
+		for (auto& tex : m_textures)
+			glDeleteTextures(1, &tex.second.Texture);
+
+		m_models.clear();
+		m_textures.clear();
+		m_kept.clear();
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <glm/glm.hpp>
+
+#include "../Engine/Model.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/glew.h>
+#if defined(__APPLE__)
+	#include <OpenGL/gl.h>
+#else
+	#include <GL/gl.h>
+#endif
+
+namespace ed
+{
+	// textures & models that survive a project reload - the project that is closed hands its loaded files over,
+	// the next one takes back the ones that it uses and whose file didn't change since they were loaded
+	// keyed by the absolute path & the load flags, the file's size & modification time tell if it changed
+	class ResidentAssets
+	{
+	public:
+		static inline ResidentAssets& Instance()
+		{
+			static ResidentAssets ret;
+			return ret;
+		}
+
+		// remember the file's state when it was loaded, Keep*() ignores files that weren't tracked
+		void Track(const std::string& path, unsigned int flags = 0);
+
+		void KeepModel(const std::string& path, unsigned int flags, eng::Model* model); // takes the ownership
+		bool HasModel(const std::string& path, unsigned int flags);						  // without taking it
+		eng::Model* TakeModel(const std::string& path, unsigned int flags);				  // nullptr if it isn't kept or the file changed
+
+		void KeepTexture(const std::string& path, GLuint tex, const glm::ivec2& size);
+		GLuint TakeTexture(const std::string& path, glm::ivec2& size); // 0 if it isn't kept or the file changed
+
+		// frees everything that the new project didn't take - whatever is left when the app closes goes with the GL context
+		void Flush();
+
+	private:
+		struct Stamp
+		{
+			uint64_t Size;
+			int64_t Time;
+		};
+		static bool m_getStamp(const std::string& path, Stamp& stamp);
+		static std::string m_getKey(const std::string& path, unsigned int flags);
+
+		// true if the file was tracked & is still the same, the stamp is moved from m_kept to m_tracked
+		bool m_isCurrent(const std::string& key, const std::string& path, bool take);
+
+		struct TextureEntry
+		{
+			GLuint Texture;
+			glm::ivec2 Size;
+		};
+
+		std::unordered_map<std::string, Stamp> m_tracked; // loaded by the current project
+		std::unordered_map<std::string, Stamp> m_kept;	  // handed over by the previous one
+		std::unordered_map<std::string, eng::Model*> m_models;
+		std::unordered_map<std::string, TextureEntry> m_textures;
+	};
+}
@@ -0,0 +1,33 @@
+#include "SamplerCache.h"
+
+namespace ed
+{
+	SamplerCache::~SamplerCache()
+	{
+		Clear();
+	}
+	GLuint SamplerCache::Get(const SamplerState& state)
+	{
+		for (const auto& sampler : m_samplers)
+			if (sampler.first == state)
+				return sampler.second;
+
+		GLuint id = 0;
+		glGenSamplers(1, &id);
+		glSamplerParameteri(id, GL_TEXTURE_MIN_FILTER, state.MinFilter);
+		glSamplerParameteri(id, GL_TEXTURE_MAG_FILTER, state.MagFilter);
+		glSamplerParameteri(id, GL_TEXTURE_WRAP_S, state.WrapS);
+		glSamplerParameteri(id, GL_TEXTURE_WRAP_T, state.WrapT);
+		glSamplerParameteri(id, GL_TEXTURE_WRAP_R, state.WrapR);
+
+		m_samplers.push_back(std::make_pair(state, id));
+
+		return id;
+	}
+	void SamplerCache::Clear()
+	{
+		for (const auto& sampler : m_samplers)
+			glDeleteSamplers(1, &sampler.second);
+		m_samplers.clear();
+	}
+}
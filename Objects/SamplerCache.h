@@ -0,0 +1,45 @@
+#pragma once
+#include <vector>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/glew.h>
+#if defined(__APPLE__)
+	#include <OpenGL/gl.h>
+#else
+	#include <GL/gl.h>
+#endif
+
+namespace ed
+{
+	// filtering & wrapping of one texture in one pass' bind list
+	struct SamplerState
+	{
+		SamplerState() : MinFilter(GL_LINEAR), MagFilter(GL_LINEAR), WrapS(GL_REPEAT), WrapT(GL_REPEAT), WrapR(GL_REPEAT) { }
+
+		GLenum MinFilter, MagFilter;
+		GLenum WrapS, WrapT, WrapR;
+
+		inline bool operator==(const SamplerState& s) const
+		{
+			return MinFilter == s.MinFilter && MagFilter == s.MagFilter && WrapS == s.WrapS && WrapT == s.WrapT && WrapR == s.WrapR;
+		}
+	};
+
+	// one GL sampler object per distinct SamplerState - bindings with the same state share it
+	class SamplerCache
+	{
+	public:
+		~SamplerCache();
+
+		GLuint Get(const SamplerState& state);
+		void Clear();
+
+		inline int GetCount() { return m_samplers.size(); }
+
+	private:
+		std::vector<std::pair<SamplerState, GLuint>> m_samplers; // projects only use a handful of states
+	};
+}
@@ -14,6 +14,8 @@ namespace ed
 		Theme = "Dark";
 
 		General.VSync = false;
+		General.AdaptiveVSync = false;
+		General.EventDrivenUI = false;
 		General.AutoOpenErrorWindow = true;
 		General.Toolbar = false;
 		General.Recovery = false;
@@ -24,10 +26,14 @@ namespace ed
 		General.ItemPropsOnDblCLk = true;
 		General.SelectItemOnDblClk = true;
 		General.RecompileOnFileChange = true;
+		General.ProgramCache = true;
+		General.ModelCache = true;
+		General.OptimizeModels = false;
 		General.StartUpTemplate = "HLSL";
 		General.AutoScale = true;
 		General.Log = true;
 		General.PipeLogsToTerminal = false;
+		General.LogLevel = 0;
 		DPIScale = 1.0f;
 		strcpy(General.Font, "null");
 		General.FontSize = 15;
@@ -49,6 +55,8 @@ namespace ed
 		Editor.FunctionTooltips = true;
 
 		Debug.ShowValuesOnHover = true;
+		Debug.GPUMarkers = false;
+		Debug.RenderDoc = false;
 
 		Preview.PausedOnStartup = false;
 		Preview.SwitchLeftRightClick = false;
@@ -61,11 +69,29 @@ namespace ed
 		Preview.GizmoSnapRotation = 0;
 		Preview.GizmoSnapTranslation = 0;
 		Preview.PropertyPick = true;
+		Preview.GPUPicking = false;
 		Preview.StatusBar = true;
 		Preview.FPSLimit = -1;
 		Preview.ApplyFPSLimitToApp = false;
 		Preview.LostFocusLimitFPS = false;
+		Preview.SkipIdleFrames = true;
+		Preview.RenderWhenHidden = false;
+		Preview.DynamicResolution = false;
+		Preview.EditorPriority = true;
+		Preview.ReorderPasses = false;
+		Preview.CacheStaticPasses = false;
+		Preview.FrameCacheSize = 128;
 		Preview.MSAA = 1;
+		Preview.AudioBlockSize = 1024;
+		Preview.AudioBlocksAhead = 4;
+		Preview.BufferRefreshRate = 330;
+		Preview.TimeSliceBudget = 0;
+		Preview.PassBudget = 500;
+
+		Plugins.Budget = 0.0f;
+
+		Project.EyeSeparation = 0.064f;
+		Project.StereoConvergence = 10.0f;
 	}
 	void Settings::Load()
 	{
@@ -79,6 +105,8 @@ namespace ed
 		Theme = ini.Get("general", "theme", "Gray");
 
 		General.VSync = ini.GetBoolean("general", "vsync", false);
+		General.AdaptiveVSync = ini.GetBoolean("general", "adaptivevsync", false);
+		General.EventDrivenUI = ini.GetBoolean("general", "eventdrivenui", false);
 		General.AutoOpenErrorWindow = ini.GetBoolean("general", "autoerror", true);
 		General.Toolbar = ini.GetBoolean("general", "toolbar", false);
 		General.Recovery = ini.GetBoolean("general", "recovery", false);
@@ -86,6 +114,7 @@ namespace ed
 		General.Log = ini.GetBoolean("general", "log", false);
 		General.StreamLogs = ini.GetBoolean("general", "streamlogs", false);
 		General.PipeLogsToTerminal = ini.GetBoolean("general", "pipelogsterminal", false);
+		General.LogLevel = std::max<int>(std::min<int>(ini.GetInteger("general", "loglevel", 0), 2), 0);
 		General.ReopenShaders = ini.GetBoolean("general", "reopenshaders", false);
 		General.UseExternalEditor = ini.GetBoolean("general", "useexternaleditor", false);
 		General.OpenShadersOnDblClk = ini.GetBoolean("general", "openshadersdblclk", true);
@@ -93,6 +122,9 @@ namespace ed
 		General.SelectItemOnDblClk = ini.GetBoolean("general", "selectitemdblclk", true);
 		General.RecompileOnFileChange = ini.GetBoolean("general", "trackfilechange", false);
 		General.AutoRecompile = ini.GetBoolean("general", "autorecompile", false);
+		General.ProgramCache = ini.GetBoolean("general", "programcache", true);
+		General.ModelCache = ini.GetBoolean("general", "modelcache", true);
+		General.OptimizeModels = ini.GetBoolean("general", "optimizemodels", false);
 		General.StartUpTemplate = ini.Get("general", "template", "GLSL");
 		General.AutoScale = ini.GetBoolean("general", "autoscale", true);
 		DPIScale = ini.GetReal("general", "uiscale", 1.0f);
@@ -116,6 +148,8 @@ namespace ed
 		Editor.FunctionTooltips = ini.GetBoolean("editor", "functooltips", true);
 		
 		Debug.ShowValuesOnHover = ini.GetBoolean("debug", "valuesonhover", true);
+		Debug.GPUMarkers = ini.GetBoolean("debug", "gpumarkers", false);
+		Debug.RenderDoc = ini.GetBoolean("debug", "renderdoc", false);
 
 		Preview.PausedOnStartup = ini.GetBoolean("preview", "pausedonstartup", false);
 		Preview.SwitchLeftRightClick = ini.GetBoolean("preview", "switchleftrightclick", false);
@@ -128,18 +162,37 @@ namespace ed
 		Preview.GizmoSnapRotation = ini.GetInteger("preview", "gizmosnaprota", 0);
 		Preview.GizmoSnapTranslation = ini.GetInteger("preview", "gizmosnaptrans", 0);
 		Preview.PropertyPick = ini.GetBoolean("preview", "propertypick", true);
+		Preview.GPUPicking = ini.GetBoolean("preview", "gpupicking", false);
 		Preview.StatusBar = ini.GetBoolean("preview", "statusbar", false);
 		Preview.FPSLimit = ini.GetInteger("preview", "fpslimit", -1);
 		Preview.ApplyFPSLimitToApp = ini.GetBoolean("preview", "fpslimitwholeapp", false);
 		Preview.LostFocusLimitFPS = ini.GetBoolean("preview", "fpslimitlostfocus", false);
+		Preview.SkipIdleFrames = ini.GetBoolean("preview", "skipidleframes", true);
+		Preview.RenderWhenHidden = ini.GetBoolean("preview", "renderwhenhidden", false);
+		Preview.DynamicResolution = ini.GetBoolean("preview", "dynamicres", false);
+		Preview.EditorPriority = ini.GetBoolean("preview", "editorpriority", true);
+		Preview.ReorderPasses = ini.GetBoolean("preview", "reorderpasses", false);
+		Preview.CacheStaticPasses = ini.GetBoolean("preview", "cachestaticpasses", false);
+		Preview.FrameCacheSize = std::max<int>(ini.GetInteger("preview", "framecache", 128), 0);
 		Preview.MSAA = ini.GetInteger("preview", "msaa", 1);
+		Preview.AudioBlockSize = ini.GetInteger("preview", "audioblocksize", 1024);
+		Preview.AudioBlocksAhead = ini.GetInteger("preview", "audioblocksahead", 4);
+		Preview.BufferRefreshRate = ini.GetInteger("preview", "bufferrefresh", 330);
+		Preview.TimeSliceBudget = std::max<int>(ini.GetInteger("preview", "timeslice", 0), 0);
+		Preview.PassBudget = std::max<int>(ini.GetInteger("preview", "passbudget", 500), 0);
 
 		m_parseExt(ini.Get("plugins", "notloaded", ""), Plugins.NotLoaded);
+		Plugins.Budget = std::max<float>(ini.GetReal("plugins", "budget", 0.0f), 0.0f);
 		
 		if (Preview.MSAA != 1 && Preview.MSAA != 2 && Preview.MSAA != 4 &&
 			Preview.MSAA != 8 && Preview.MSAA != 16 && Preview.MSAA != 32)
 			Preview.MSAA = 1;
 
+		if (Preview.AudioBlockSize < 256 || Preview.AudioBlockSize > 4096 || (Preview.AudioBlockSize & (Preview.AudioBlockSize - 1)) != 0)
+			Preview.AudioBlockSize = 1024;
+		Preview.AudioBlocksAhead = std::max<int>(std::min<int>(Preview.AudioBlocksAhead, 16), 2);
+		Preview.BufferRefreshRate = std::max<int>(Preview.BufferRefreshRate, 0);
+
 		if (Preview.ApplyFPSLimitToApp)
 			Preview.LostFocusLimitFPS = false;
 	}
@@ -152,6 +205,8 @@ namespace ed
 		ini << "[general]" << std::endl;
 		ini << "theme=" << Theme << std::endl;
 		ini << "vsync=" << General.VSync << std::endl;
+		ini << "adaptivevsync=" << General.AdaptiveVSync << std::endl;
+		ini << "eventdrivenui=" << General.EventDrivenUI << std::endl;
 		ini << "autoerror=" << General.AutoOpenErrorWindow << std::endl;
 		ini << "toolbar=" << General.Toolbar << std::endl;
 		ini << "recovery=" << General.Recovery << std::endl;
@@ -159,6 +214,7 @@ namespace ed
 		ini << "log=" << General.Log << std::endl;
 		ini << "streamlogs=" << General.StreamLogs << std::endl;
 		ini << "pipelogsterminal=" << General.PipeLogsToTerminal << std::endl;
+		ini << "loglevel=" << General.LogLevel << std::endl;
 		ini << "reopenshaders=" << General.ReopenShaders << std::endl;
 		ini << "useexternaleditor=" << General.UseExternalEditor << std::endl;
 		ini << "openshadersdblclk=" << General.OpenShadersOnDblClk << std::endl;
@@ -166,6 +222,9 @@ namespace ed
 		ini << "selectitemdblclk=" << General.SelectItemOnDblClk << std::endl;
 		ini << "trackfilechange=" << General.RecompileOnFileChange << std::endl;
 		ini << "autorecompile=" << General.AutoRecompile << std::endl;
+		ini << "programcache=" << General.ProgramCache << std::endl;
+		ini << "modelcache=" << General.ModelCache << std::endl;
+		ini << "optimizemodels=" << General.OptimizeModels << std::endl;
 		ini << "template=" << General.StartUpTemplate << std::endl;
 		ini << "font=" << General.Font << std::endl;
 		ini << "fontsize=" << General.FontSize << std::endl;
@@ -199,11 +258,24 @@ namespace ed
 		ini << "gizmosnapscale=" << Preview.GizmoSnapScale << std::endl;
 		ini << "gizmosnaprota=" << Preview.GizmoSnapRotation << std::endl;
 		ini << "propertypick=" << Preview.PropertyPick << std::endl;
+		ini << "gpupicking=" << Preview.GPUPicking << std::endl;
 		ini << "statusbar=" << Preview.StatusBar << std::endl;
 		ini << "fpslimit=" << Preview.FPSLimit << std::endl;
 		ini << "fpslimitwholeapp=" << Preview.ApplyFPSLimitToApp << std::endl;
 		ini << "fpslimitlostfocus=" << Preview.LostFocusLimitFPS << std::endl;
+		ini << "skipidleframes=" << Preview.SkipIdleFrames << std::endl;
+		ini << "renderwhenhidden=" << Preview.RenderWhenHidden << std::endl;
+		ini << "dynamicres=" << Preview.DynamicResolution << std::endl;
+		ini << "editorpriority=" << Preview.EditorPriority << std::endl;
+		ini << "reorderpasses=" << Preview.ReorderPasses << std::endl;
+		ini << "cachestaticpasses=" << Preview.CacheStaticPasses << std::endl;
+		ini << "framecache=" << Preview.FrameCacheSize << std::endl;
 		ini << "msaa=" << Preview.MSAA << std::endl;
+		ini << "audioblocksize=" << Preview.AudioBlockSize << std::endl;
+		ini << "audioblocksahead=" << Preview.AudioBlocksAhead << std::endl;
+		ini << "bufferrefresh=" << Preview.BufferRefreshRate << std::endl;
+		ini << "timeslice=" << Preview.TimeSliceBudget << std::endl;
+		ini << "passbudget=" << Preview.PassBudget << std::endl;
 
 		ini << "[editor]" << std::endl;
 		ini << "smartpred=" << Editor.SmartPredictions << std::endl;
@@ -222,6 +294,8 @@ namespace ed
 
 		ini << "[debug]" << std::endl;
 		ini << "valuesonhover=" << Debug.ShowValuesOnHover << std::endl;
+		ini << "gpumarkers=" << Debug.GPUMarkers << std::endl;
+		ini << "renderdoc=" << Debug.RenderDoc << std::endl;
 
 		ini << "[plugins]" << std::endl;
 		ini << "notloaded=";
@@ -231,6 +305,7 @@ namespace ed
 				ini << " ";
 		}
 		ini << std::endl;
+		ini << "budget=" << Plugins.Budget << std::endl;
 
 
 	}
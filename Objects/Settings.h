@@ -19,13 +19,18 @@ namespace ed
 
 		struct strGeneral {
 			bool VSync;
+			bool AdaptiveVSync;			// late frames are swapped without waiting for the next vblank
+			bool EventDrivenUI;			// sleep until there's input instead of redrawing an idle UI
 			// std::string Language;	// [TODO] Not implemented
 			bool AutoOpenErrorWindow;
 			bool Toolbar;
-			bool Recovery;				// [TODO] Not implemented
+			bool Recovery;				// snapshot of the unsaved changes next to the project every RECOVERY_INTERVAL
 			bool CheckUpdates;
 			bool RecompileOnFileChange;
 			bool AutoRecompile;
+			bool ProgramCache;
+			bool ModelCache;
+			bool OptimizeModels;
 			bool ReopenShaders;
 			bool UseExternalEditor;
 			bool OpenShadersOnDblClk;
@@ -34,6 +39,7 @@ namespace ed
 			bool Log;
 			bool StreamLogs;
 			bool PipeLogsToTerminal;
+			int LogLevel;				// Logger::Level, less important messages aren't logged
 			std::string StartUpTemplate;
 			char Font[MAX_PATH];
 			int FontSize;
@@ -60,6 +66,8 @@ namespace ed
 
 		struct strDebug {
 			bool ShowValuesOnHover;
+			bool GPUMarkers;	// KHR_debug groups around the pipeline items & driver performance warnings in the messages
+			bool RenderDoc;		// load the RenderDoc library on startup
 		} Debug;
 
 		struct strPreview {
@@ -73,11 +81,24 @@ namespace ed
 			int GizmoSnapScale;
 			int GizmoSnapRotation;	// in degrees (0 == no snap)
 			bool PropertyPick;
+			bool GPUPicking; // pick the item under the cursor from the debug ID render instead of casting rays
 			bool StatusBar;
 			int FPSLimit;
 			bool ApplyFPSLimitToApp; // apply FPSLimit to whole app, not only preview
 			bool LostFocusLimitFPS; // limit to 30FPS when app loses focus
+			bool SkipIdleFrames; // don't render the preview again (and sleep) when nothing in the frame can change
+			bool RenderWhenHidden; // keep executing the whole pipeline while the preview is hidden or the window is minimized
+			bool DynamicResolution; // lower the preview resolution to stay within FPSLimit (60 if there's no limit)
+			bool EditorPriority; // heavy previews are rendered less often while the user types or drags a widget in the other windows
+			bool ReorderPasses; // group the independent shader passes by their render textures & report the unused ones
+			bool CacheStaticPasses; // don't draw the passes whose inputs didn't change again
+			int FrameCacheSize; // MB of VRAM for the frames that the timeline shows without rendering them again, 0 -> off
 			int MSAA; // 1 (off), 2, 4, 8
+			int AudioBlockSize; // samples that the audio shader renders at once, power of two between 256 and 4096
+			int AudioBlocksAhead; // blocks that are rendered before the audio thread needs them
+			int BufferRefreshRate; // milliseconds between two readbacks of the rows shown in the buffer preview
+			int TimeSliceBudget; // ms of GPU time that one submission of a pass can take before it's split, 0 -> off
+			int PassBudget; // ms of GPU time that a pass can take before it's turned off (see PassWatchdog), 0 -> off
 		} Preview;
 
 		struct strProject {
@@ -85,10 +106,20 @@ namespace ed
 			bool UseAlphaChannel;
 			glm::vec4 ClearColor;
 			std::vector<std::string> IncludePaths;
+			int SPIRVOptimization; // 0 = off, 1 = performance, 2 = size (HLSL & Vulkan GLSL)
+			bool AudioTextureArray; // bind all the audio objects as one sampler2DArray, layer = order in the object list
+			bool BindlessTextures; // resident handles of the texture objects in the SHADERed_Textures SSBO (ARB_bindless_texture)
+
+			// stereo: the *Left & *Right system variables, the eyes are EyeSeparation apart & look at the same point StereoConvergence
+			// away - StereoPreview is a render texture with 2 layers that is shown side by side in the preview, empty = off
+			float EyeSeparation;
+			float StereoConvergence;
+			std::string StereoPreview;
 		} Project;
 
 		struct strPlugins {
 			std::vector<std::string> NotLoaded;
+			float Budget; // ms of CPU time that a plugin can use per frame before a warning is logged (0 = off)
 		} Plugins;
 
 		static inline Settings& Instance()
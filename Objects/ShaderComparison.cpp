@@ -0,0 +1,304 @@
+#include "ShaderComparison.h"
+#include "../Engine/GLUtils.h"
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+const char* COMPARISON_DIFF_VS = R"(
+#version 330
+
+out vec2 uv;
+
+void main()
+{
+	// full screen triangle
+	uv = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+	gl_Position = vec4(uv * 2.0f - 1.0f, 0.0f, 1.0f);
+}
+)";
+
+const char* COMPARISON_DIFF_PS = R"(
+#version 330
+
+uniform sampler2D texA;
+uniform sampler2D texB;
+uniform float gain;
+
+in vec2 uv;
+out vec4 outColor;
+
+void main()
+{
+	vec4 a = texture(texA, uv);
+	vec4 b = texture(texB, uv);
+
+	outColor = vec4(min(abs(a - b).rgb * gain, vec3(1.0f)), 1.0f);
+}
+)";
+
+namespace ed
+{
+	ShaderComparison::ShaderComparison()
+	{
+		m_pass = nullptr;
+		m_program = 0;
+		m_frame = 0;
+
+		memset(m_queries, 0, sizeof(m_queries));
+		memset(m_pending, 0, sizeof(m_pending));
+		m_next[0] = m_next[1] = 0;
+		m_sampleIndex[0] = m_sampleIndex[1] = 0;
+
+		m_captureTex[0] = m_captureTex[1] = 0;
+		m_captureFBO[0] = m_captureFBO[1] = 0;
+		m_captured[0] = m_captured[1] = false;
+		m_captureSize = glm::ivec2(0);
+		m_diffTex = m_diffFBO = m_diffVAO = m_diffShader = 0;
+		m_diffGain = 1.0f;
+	}
+	ShaderComparison::~ShaderComparison()
+	{
+		Stop();
+
+		if (m_diffShader != 0)
+			glDeleteProgram(m_diffShader);
+		if (m_diffVAO != 0)
+			glDeleteVertexArrays(1, &m_diffVAO);
+	}
+	void ShaderComparison::Start(void* pass, GLuint program)
+	{
+		Stop();
+
+		m_pass = pass;
+		m_program = program;
+		m_frame = 0;
+
+		for (int v = 0; v < 2; v++)
+			glGenQueries(SHADER_COMPARISON_QUERIES * 2, &m_queries[v][0][0]);
+
+		ResetStats();
+	}
+	void ShaderComparison::Stop()
+	{
+		if (m_pass == nullptr)
+			return;
+
+		glDeleteProgram(m_program);
+		for (int v = 0; v < 2; v++)
+			glDeleteQueries(SHADER_COMPARISON_QUERIES * 2, &m_queries[v][0][0]);
+		memset(m_queries, 0, sizeof(m_queries));
+
+		glDeleteTextures(2, m_captureTex);
+		glDeleteFramebuffers(2, m_captureFBO);
+		glDeleteTextures(1, &m_diffTex);
+		glDeleteFramebuffers(1, &m_diffFBO);
+		m_captureTex[0] = m_captureTex[1] = 0;
+		m_captureFBO[0] = m_captureFBO[1] = 0;
+		m_diffTex = m_diffFBO = 0;
+		m_captureSize = glm::ivec2(0);
+
+		m_pass = nullptr;
+		m_program = 0;
+	}
+	void ShaderComparison::Begin(int version)
+	{
+		// queries that still aren't done are simply overwritten
+		int slot = m_next[version];
+		glQueryCounter(m_queries[version][slot][0], GL_TIMESTAMP);
+		m_pending[version][slot] = false;
+	}
+	void ShaderComparison::End(int version)
+	{
+		int slot = m_next[version];
+		glQueryCounter(m_queries[version][slot][1], GL_TIMESTAMP);
+		m_pending[version][slot] = true;
+		m_next[version] = (slot + 1) % SHADER_COMPARISON_QUERIES;
+	}
+	void ShaderComparison::Capture(int version, GLuint fbo, glm::ivec2 size)
+	{
+		// float storage so that HDR render textures can be compared too
+		if (m_captureSize != size) {
+			glDeleteTextures(2, m_captureTex);
+			glDeleteFramebuffers(2, m_captureFBO);
+			glDeleteTextures(1, &m_diffTex);
+			glDeleteFramebuffers(1, &m_diffFBO);
+
+			glGenTextures(2, m_captureTex);
+			glGenFramebuffers(2, m_captureFBO);
+			for (int v = 0; v < 2; v++) {
+				glBindTexture(GL_TEXTURE_2D, m_captureTex[v]);
+				glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, size.x, size.y, 0, GL_RGBA, GL_FLOAT, NULL);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+				glBindFramebuffer(GL_FRAMEBUFFER, m_captureFBO[v]);
+				glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_captureTex[v], 0);
+			}
+
+			glGenTextures(1, &m_diffTex);
+			glBindTexture(GL_TEXTURE_2D, m_diffTex);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+			glGenFramebuffers(1, &m_diffFBO);
+			glBindFramebuffer(GL_FRAMEBUFFER, m_diffFBO);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_diffTex, 0);
+			glBindTexture(GL_TEXTURE_2D, 0);
+
+			m_captureSize = size;
+			m_captured[0] = m_captured[1] = false;
+		}
+
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+		glReadBuffer(GL_COLOR_ATTACHMENT0);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_captureFBO[version]);
+		glDrawBuffer(GL_COLOR_ATTACHMENT0);
+		glBlitFramebuffer(0, 0, size.x, size.y, 0, 0, size.x, size.y, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+		// restore the pass' framebuffer
+		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+
+		m_captured[version] = true;
+	}
+	void ShaderComparison::EndFrame()
+	{
+		if (m_pass == nullptr)
+			return;
+
+		for (int v = 0; v < 2; v++)
+			m_readback(v);
+
+		if (m_captured[0] && m_captured[1]) {
+			m_renderDiff();
+			m_captured[0] = m_captured[1] = false;
+		}
+
+		m_frame++;
+	}
+	float ShaderComparison::GetDifference(float& ci95)
+	{
+		// Welch's t-test with the normal approximation - there are always plenty of samples
+		const Stats& a = m_stats[0];
+		const Stats& b = m_stats[1];
+
+		ci95 = 0.0f;
+		if (a.Samples < 2 || b.Samples < 2)
+			return b.Mean - a.Mean;
+
+		float se = sqrtf(a.StdDev * a.StdDev / a.Samples + b.StdDev * b.StdDev / b.Samples);
+		ci95 = 1.96f * se;
+
+		return b.Mean - a.Mean;
+	}
+	void ShaderComparison::ResetStats()
+	{
+		for (int v = 0; v < 2; v++) {
+			m_samples[v].clear();
+			m_sampleIndex[v] = 0;
+			m_stats[v] = Stats();
+
+			// results of the queries that were already issued would mix the old and the new state
+			for (int i = 0; i < SHADER_COMPARISON_QUERIES; i++)
+				m_pending[v][i] = false;
+		}
+	}
+	void ShaderComparison::m_readback(int version)
+	{
+		bool added = false;
+		for (int i = 0; i < SHADER_COMPARISON_QUERIES; i++) {
+			if (!m_pending[version][i])
+				continue;
+
+			GLint available = 0;
+			glGetQueryObjectiv(m_queries[version][i][1], GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available)
+				continue;
+
+			GLuint64 start = 0, end = 0;
+			glGetQueryObjectui64v(m_queries[version][i][0], GL_QUERY_RESULT, &start);
+			glGetQueryObjectui64v(m_queries[version][i][1], GL_QUERY_RESULT, &end);
+			m_pending[version][i] = false;
+
+			float ms = (end - start) / 1000000.0f;
+
+			std::vector<float>& samples = m_samples[version];
+			if (samples.size() < SHADER_COMPARISON_SAMPLES)
+				samples.push_back(ms);
+			else {
+				samples[m_sampleIndex[version]] = ms;
+				m_sampleIndex[version] = (m_sampleIndex[version] + 1) % SHADER_COMPARISON_SAMPLES;
+			}
+			added = true;
+		}
+
+		if (added)
+			m_updateStats(version);
+	}
+	void ShaderComparison::m_updateStats(int version)
+	{
+		const std::vector<float>& samples = m_samples[version];
+		Stats& res = m_stats[version];
+
+		res.Samples = samples.size();
+
+		double sum = 0.0;
+		for (float s : samples)
+			sum += s;
+		res.Mean = sum / res.Samples;
+
+		double var = 0.0;
+		for (float s : samples)
+			var += (s - res.Mean) * (s - res.Mean);
+		res.StdDev = res.Samples > 1 ? sqrt(var / (res.Samples - 1)) : 0.0f;
+	}
+	void ShaderComparison::m_renderDiff()
+	{
+		if (m_diffShader == 0) {
+			GLchar msg[1024];
+
+			GLuint vs = gl::CompileShader(GL_VERTEX_SHADER, COMPARISON_DIFF_VS);
+			GLuint ps = gl::CompileShader(GL_FRAGMENT_SHADER, COMPARISON_DIFF_PS);
+			gl::CheckShaderCompilationStatus(vs, msg);
+			gl::CheckShaderCompilationStatus(ps, msg);
+
+			m_diffShader = glCreateProgram();
+			glAttachShader(m_diffShader, vs);
+			glAttachShader(m_diffShader, ps);
+			glLinkProgram(m_diffShader);
+			glDeleteShader(vs);
+			glDeleteShader(ps);
+
+			glUseProgram(m_diffShader);
+			glUniform1i(glGetUniformLocation(m_diffShader, "texA"), 0);
+			glUniform1i(glGetUniformLocation(m_diffShader, "texB"), 1);
+
+			glGenVertexArrays(1, &m_diffVAO);
+		}
+
+		glBindFramebuffer(GL_FRAMEBUFFER, m_diffFBO);
+		glViewport(0, 0, m_captureSize.x, m_captureSize.y);
+		glDisable(GL_DEPTH_TEST);
+		glDisable(GL_BLEND);
+		glDisable(GL_CULL_FACE);
+		glDisable(GL_STENCIL_TEST);
+
+		glUseProgram(m_diffShader);
+		glUniform1f(glGetUniformLocation(m_diffShader, "gain"), m_diffGain);
+
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, m_captureTex[0]);
+		glActiveTexture(GL_TEXTURE1);
+		glBindTexture(GL_TEXTURE_2D, m_captureTex[1]);
+
+		glBindVertexArray(m_diffVAO);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+		glBindVertexArray(0);
+
+		glBindTexture(GL_TEXTURE_2D, 0);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/glew.h>
+#if defined(__APPLE__)
+	#include <OpenGL/gl.h>
+#else
+	#include <GL/gl.h>
+#endif
+
+#define SHADER_COMPARISON_QUERIES 8	// timer queries in flight per version
+#define SHADER_COMPARISON_SAMPLES 600
+
+namespace ed
+{
+	// GPU timings & output of one shader pass rendered with two programs in the same frames
+	// version 0 is the pass' own program, version 1 is the program that it's compared with
+	class ShaderComparison
+	{
+	public:
+		ShaderComparison();
+		~ShaderComparison();
+
+		struct Stats
+		{
+			Stats() { Mean = StdDev = 0.0f; Samples = 0; }
+			float Mean, StdDev; // in milliseconds
+			int Samples;
+		};
+
+		// takes the ownership of the program
+		void Start(void* pass, GLuint program);
+		void Stop();
+
+		inline bool IsActive() { return m_pass != nullptr; }
+		inline void* GetPass() { return m_pass; }
+		inline GLuint GetProgram() { return m_program; }
+		inline int GetFrame() { return m_frame; }
+
+		void Begin(int version);
+		void End(int version);
+
+		// copies the first color attachment of the currently bound pass
+		void Capture(int version, GLuint fbo, glm::ivec2 size);
+
+		// reads the finished queries and updates the difference image
+		void EndFrame();
+
+		const Stats& Get(int version) { return m_stats[version]; }
+		float GetDifference(float& ci95); // mean(B) - mean(A) and the half width of its 95% confidence interval
+		void ResetStats();
+
+		inline GLuint GetDiffTexture() { return m_diffTex; }
+		inline glm::ivec2 GetDiffSize() { return m_captureSize; }
+		inline float GetDiffGain() { return m_diffGain; }
+		inline void SetDiffGain(float gain) { m_diffGain = gain; } // applied with the next capture
+
+	private:
+		void m_readback(int version);
+		void m_updateStats(int version);
+		void m_renderDiff();
+
+		void* m_pass;
+		GLuint m_program;
+		int m_frame;
+
+		GLuint m_queries[2][SHADER_COMPARISON_QUERIES][2]; // [version][slot][start, end]
+		bool m_pending[2][SHADER_COMPARISON_QUERIES];
+		int m_next[2];
+
+		std::vector<float> m_samples[2];
+		int m_sampleIndex[2];
+		Stats m_stats[2];
+
+		/* pixel difference */
+		GLuint m_captureTex[2], m_captureFBO[2];
+		bool m_captured[2];
+		glm::ivec2 m_captureSize;
+		GLuint m_diffTex, m_diffFBO, m_diffVAO, m_diffShader;
+		float m_diffGain;
+	};
+}
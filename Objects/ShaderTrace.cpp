@@ -0,0 +1,553 @@
+#include "ShaderTrace.h"
+#include "Hash.h"
+#include "../Engine/GLUtils.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <mutex>
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SHADER_TRACE_FORMAT_COMMENT "// SHADERed_printf "
+
+namespace ed
+{
+	struct TraceFormat
+	{
+		std::string Text;
+		int Stage;
+	};
+	static std::mutex formatMutex; // Instrument() runs on the compile workers
+	static std::unordered_map<GLuint, TraceFormat> formats;
+
+	// printf("format", arg0, arg1, ...)
+	struct PrintfCall
+	{
+		size_t Start, End; // End is past the ')'
+		std::string Format;
+		std::vector<std::string> Args;
+	};
+
+	static bool isIdentChar(char c)
+	{
+		return isalnum((unsigned char)c) || c == '_';
+	}
+	static size_t skipSpace(const std::string& code, size_t i)
+	{
+		while (i < code.size() && isspace((unsigned char)code[i]))
+			i++;
+		return i;
+	}
+	static GLuint getFormatID(const std::string& fmt, int stage)
+	{
+		uint64_t hash = HashString(fmt, HashString(std::to_string(stage)));
+		return ((GLuint)(hash ^ (hash >> 32))) | 1; // 0 -> never written
+	}
+	static void findCalls(const std::string& code, std::vector<PrintfCall>& out)
+	{
+		bool lineStart = true;
+		for (size_t i = 0; i < code.size(); i++) {
+			char c = code[i];
+
+			// comments
+			if (c == '/' && i + 1 < code.size() && code[i + 1] == '/') {
+				while (i + 1 < code.size() && code[i + 1] != '\n')
+					i++;
+				continue;
+			} else if (c == '/' && i + 1 < code.size() && code[i + 1] == '*') {
+				i += 2;
+				while (i + 1 < code.size() && !(code[i] == '*' && code[i + 1] == '/'))
+					i++;
+				i++;
+				continue;
+			}
+
+			// preprocessor lines are left alone
+			if (c == '#' && lineStart) {
+				while (i + 1 < code.size() && (code[i + 1] != '\n' || code[i] == '\\'))
+					i++;
+				continue;
+			}
+
+			if (c == '\n')
+				lineStart = true;
+			else if (!isspace((unsigned char)c))
+				lineStart = false;
+
+			if (!isIdentChar(c))
+				continue;
+
+			size_t wordEnd = i;
+			while (wordEnd < code.size() && isIdentChar(code[wordEnd]))
+				wordEnd++;
+
+			bool isPrintf = wordEnd - i == 6 && code.compare(i, 6, "printf") == 0;
+			size_t p = skipSpace(code, wordEnd);
+			if (!isPrintf || p >= code.size() || code[p] != '(') {
+				i = wordEnd - 1;
+				continue;
+			}
+			p = skipSpace(code, p + 1);
+			if (p >= code.size() || code[p] != '"') {
+				i = wordEnd - 1;
+				continue;
+			}
+
+			PrintfCall call;
+			call.Start = i;
+
+			// format string
+			for (p++; p < code.size() && code[p] != '"' && code[p] != '\n'; p++) {
+				if (code[p] == '\\' && p + 1 < code.size()) {
+					p++;
+					switch (code[p]) {
+					case 'n': call.Format += '\n'; break;
+					case 't': call.Format += '\t'; break;
+					default: call.Format += code[p]; break;
+					}
+				} else
+					call.Format += code[p];
+			}
+			p = skipSpace(code, p + 1);
+
+			// arguments
+			bool closed = false;
+			if (p < code.size() && code[p] == ')')
+				closed = true;
+			else if (p < code.size() && code[p] == ',') {
+				int depth = 0;
+				std::string arg;
+				for (p++; p < code.size(); p++) {
+					char a = code[p];
+					if ((a == ',' || a == ')') && depth == 0) {
+						call.Args.push_back(arg);
+						arg.clear();
+						if (a == ')') {
+							closed = true;
+							break;
+						}
+						continue;
+					}
+
+					if (a == '(' || a == '[' || a == '{') depth++;
+					else if (a == ')' || a == ']' || a == '}') depth--;
+					arg += a;
+				}
+			}
+
+			if (!closed) {
+				i = wordEnd - 1;
+				continue;
+			}
+
+			call.End = p + 1;
+			out.push_back(call);
+			i = p;
+		}
+	}
+	// replaces the calls, the lines of the code stay where they were
+	static std::string replaceCalls(const std::string& code, const std::vector<PrintfCall>& calls, const std::vector<std::string>& with)
+	{
+		std::string ret;
+		ret.reserve(code.size());
+
+		size_t last = 0;
+		for (size_t i = 0; i < calls.size(); i++) {
+			ret += code.substr(last, calls[i].Start - last);
+			ret += with[i];
+
+			int lines = std::count(code.begin() + calls[i].Start, code.begin() + calls[i].End, '\n') - std::count(with[i].begin(), with[i].end(), '\n');
+			for (int l = 0; l < lines; l++)
+				ret += '\n';
+
+			last = calls[i].End;
+		}
+		ret += code.substr(last);
+
+		return ret;
+	}
+	// position after the #version and #extension directives
+	static size_t getDeclarationStart(const std::string& code)
+	{
+		size_t declPos = 0;
+		size_t dirPos = 0;
+		while ((dirPos = code.find('#', dirPos)) != std::string::npos) {
+			size_t lineEnd = code.find('\n', dirPos);
+			lineEnd = lineEnd == std::string::npos ? code.size() : lineEnd + 1;
+			if (code.compare(dirPos, 8, "#version") == 0 || code.compare(dirPos, 10, "#extension") == 0)
+				declPos = lineEnd;
+			dirPos = lineEnd;
+		}
+		return declPos;
+	}
+	static std::string getHelper(int stage, bool vulkan)
+	{
+		std::string id = "uvec3(0u)";
+		if (stage == 0)
+			id = vulkan ? "uvec3(uint(gl_VertexIndex), uint(gl_InstanceIndex), 0u)" : "uvec3(uint(gl_VertexID), uint(gl_InstanceID), 0u)";
+		else if (stage == 1)
+			id = "uvec3(uvec2(gl_FragCoord.xy), 0u)";
+		else if (stage == 2)
+			id = "uvec3(uint(gl_PrimitiveIDIn), 0u, 0u)";
+		else if (stage == 3)
+			id = "gl_GlobalInvocationID";
+
+		// one line so that the line numbers only move by one
+		std::string ret = "layout(std430) buffer " SHADER_TRACE_BLOCK_NAME " { uint _sed_trace_cursor; uint _sed_trace_data[]; }; uint _sed_trace_at;";
+		ret += " uvec4 _sed_bits(float v) { return uvec4(floatBitsToUint(v), 0u, 0u, 0u); }";
+		ret += " uvec4 _sed_bits(vec2 v) { return uvec4(floatBitsToUint(v), 0u, 0u); }";
+		ret += " uvec4 _sed_bits(vec3 v) { return uvec4(floatBitsToUint(v), 0u); }";
+		ret += " uvec4 _sed_bits(vec4 v) { return floatBitsToUint(v); }";
+		ret += " uvec4 _sed_bits(int v) { return uvec4(uint(v), 0u, 0u, 0u); }";
+		ret += " uvec4 _sed_bits(ivec2 v) { return uvec4(uvec2(v), 0u, 0u); }";
+		ret += " uvec4 _sed_bits(ivec3 v) { return uvec4(uvec3(v), 0u); }";
+		ret += " uvec4 _sed_bits(ivec4 v) { return uvec4(v); }";
+		ret += " uvec4 _sed_bits(uint v) { return uvec4(v, 0u, 0u, 0u); }";
+		ret += " uvec4 _sed_bits(uvec2 v) { return uvec4(v, 0u, 0u); }";
+		ret += " uvec4 _sed_bits(uvec3 v) { return uvec4(v, 0u); }";
+		ret += " uvec4 _sed_bits(uvec4 v) { return v; }";
+		ret += " uvec4 _sed_bits(bool v) { return uvec4(v ? 1u : 0u, 0u, 0u, 0u); }";
+		ret += " uint _sed_trace_begin(uint fmt) { _sed_trace_at = (atomicAdd(_sed_trace_cursor, 1u) % " + std::to_string(SHADER_TRACE_CAPACITY) + "u) * " + std::to_string(SHADER_TRACE_RECORD_SIZE) + "u;";
+		ret += " uvec3 id = " + id + "; _sed_trace_data[_sed_trace_at] = fmt; _sed_trace_data[_sed_trace_at + 1u] = id.x; _sed_trace_data[_sed_trace_at + 2u] = id.y; _sed_trace_data[_sed_trace_at + 3u] = id.z; return 0u; }";
+		ret += " uint _sed_trace_put(uint arg, uvec4 v) { uint at = _sed_trace_at + 4u + arg * 4u;";
+		ret += " _sed_trace_data[at] = v.x; _sed_trace_data[at + 1u] = v.y; _sed_trace_data[at + 2u] = v.z; _sed_trace_data[at + 3u] = v.w; return 0u; }\n";
+
+		return ret;
+	}
+
+	ShaderTrace::ShaderTrace()
+	{
+		m_buffer = m_marks = m_readback = 0;
+		m_fence = 0;
+		m_capturing = false;
+		m_written = 0;
+		m_revision = 0;
+	}
+	ShaderTrace::~ShaderTrace()
+	{
+		if (m_fence != 0)
+			glDeleteSync(m_fence);
+		if (m_buffer != 0) {
+			glDeleteBuffers(1, &m_buffer);
+			glDeleteBuffers(1, &m_marks);
+			glDeleteBuffers(1, &m_readback);
+		}
+	}
+	bool ShaderTrace::IsSupported()
+	{
+		return GLEW_VERSION_4_3 || GLEW_ARB_shader_storage_buffer_object;
+	}
+	int ShaderTrace::Instrument(std::string& glsl, int stage, bool vulkan)
+	{
+		std::vector<PrintfCall> calls;
+		findCalls(glsl, calls);
+		if (calls.empty())
+			return 0;
+
+		int version = 110;
+		size_t verPos = glsl.find("#version");
+		if (verPos != std::string::npos)
+			version = atoi(glsl.c_str() + verPos + 8);
+
+		// uints & floatBitsToUint
+		if (!vulkan && (version < 330 || !IsSupported())) {
+			Strip(glsl);
+			return 0;
+		}
+
+		std::vector<std::string> replacements;
+		std::string comments;
+		for (const auto& call : calls) {
+			GLuint id = getFormatID(call.Format, stage);
+
+			std::string repl = "(_sed_trace_begin(" + std::to_string(id) + "u)";
+			for (int i = 0; i < std::min<int>(call.Args.size(), SHADER_TRACE_MAX_ARGS); i++)
+				repl += ", _sed_trace_put(" + std::to_string(i) + "u, _sed_bits(" + call.Args[i] + "))";
+			repl += ")";
+			replacements.push_back(repl);
+
+			// one line per format, the records only know the id
+			std::string escaped;
+			for (char c : call.Format) {
+				if (c == '\n') escaped += "\\n";
+				else if (c == '\\') escaped += "\\\\";
+				else escaped += c;
+			}
+			comments += SHADER_TRACE_FORMAT_COMMENT + std::to_string(id) + " " + std::to_string(stage) + " " + escaped + "\n";
+		}
+
+		glsl = replaceCalls(glsl, calls, replacements);
+
+		size_t declPos = getDeclarationStart(glsl);
+		std::string helper;
+		if (!vulkan && version < 430)
+			helper += "#extension GL_ARB_shader_storage_buffer_object : require\n";
+		helper += getHelper(stage, vulkan);
+		if (vulkan)
+			helper += "#line " + std::to_string(1 + std::count(glsl.begin(), glsl.begin() + declPos, '\n')) + "\n";
+
+		glsl.insert(declPos, helper);
+		glsl += "\n" + comments;
+
+		RegisterFormats(comments);
+
+		return vulkan ? 0 : std::count(helper.begin(), helper.end(), '\n');
+	}
+	void ShaderTrace::Strip(std::string& code)
+	{
+		std::vector<PrintfCall> calls;
+		findCalls(code, calls);
+		if (calls.empty())
+			return;
+
+		code = replaceCalls(code, calls, std::vector<std::string>(calls.size(), "0"));
+	}
+	void ShaderTrace::RegisterFormats(const std::string& code)
+	{
+		size_t pos = code.find(SHADER_TRACE_FORMAT_COMMENT);
+		if (pos == std::string::npos)
+			return;
+
+		std::lock_guard<std::mutex> lock(formatMutex);
+		for (; pos != std::string::npos; pos = code.find(SHADER_TRACE_FORMAT_COMMENT, pos)) {
+			pos += strlen(SHADER_TRACE_FORMAT_COMMENT);
+			size_t lineEnd = code.find('\n', pos);
+			if (lineEnd == std::string::npos)
+				lineEnd = code.size();
+
+			char* end = nullptr;
+			GLuint id = strtoul(code.c_str() + pos, &end, 10);
+			int stage = strtol(end, &end, 10);
+			if (*end == ' ')
+				end++;
+
+			TraceFormat fmt;
+			fmt.Stage = stage;
+			for (const char* c = end; c < code.c_str() + lineEnd; c++) {
+				if (*c == '\\' && c + 1 < code.c_str() + lineEnd) {
+					c++;
+					fmt.Text += *c == 'n' ? '\n' : *c;
+				} else
+					fmt.Text += *c;
+			}
+			formats[id] = fmt;
+
+			pos = lineEnd;
+		}
+	}
+	std::string ShaderTrace::GetFormatComments(const std::string& code)
+	{
+		size_t pos = code.find("\n" SHADER_TRACE_FORMAT_COMMENT);
+		if (pos == std::string::npos)
+			return "";
+		return code.substr(pos);
+	}
+	bool ShaderTrace::Begin(GLuint binding)
+	{
+		{
+			std::lock_guard<std::mutex> lock(formatMutex);
+			if (formats.empty())
+				return false;
+		}
+
+		if (m_buffer == 0) {
+			size_t bufferSize = (1 + SHADER_TRACE_CAPACITY * SHADER_TRACE_RECORD_SIZE) * sizeof(GLuint);
+
+			glGenBuffers(1, &m_buffer);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_buffer);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, bufferSize, NULL, GL_DYNAMIC_COPY);
+			gl::SetObjectLabel(GL_BUFFER, m_buffer, "Shader trace");
+
+			glGenBuffers(1, &m_marks);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_marks);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, SHADER_TRACE_MAX_PASSES * sizeof(GLuint), NULL, GL_DYNAMIC_COPY);
+			gl::SetObjectLabel(GL_BUFFER, m_marks, "Shader trace marks");
+
+			glGenBuffers(1, &m_readback);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, m_readback);
+			glBufferData(GL_COPY_WRITE_BUFFER, bufferSize + SHADER_TRACE_MAX_PASSES * sizeof(GLuint), NULL, GL_STREAM_READ);
+			gl::SetObjectLabel(GL_BUFFER, m_readback, "Shader trace readback");
+			glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+			GLuint zero = 0;
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_buffer);
+			glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(GLuint), &zero);
+		}
+
+		// the instrumented shaders write to the buffer in every frame, only one frame is read back at a time
+		m_capturing = m_fence == 0;
+		if (m_capturing) {
+			m_passes.clear();
+
+			GLuint zero = 0;
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_buffer);
+			glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(GLuint), &zero);
+		}
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, m_buffer);
+
+		return m_capturing;
+	}
+	void ShaderTrace::Mark(const std::string& pass)
+	{
+		if (!m_capturing || m_passes.size() >= SHADER_TRACE_MAX_PASSES)
+			return;
+
+		// the cursor after the pass - the records in between belong to it
+		glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+		glBindBuffer(GL_COPY_READ_BUFFER, m_buffer);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, m_marks);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, m_passes.size() * sizeof(GLuint), sizeof(GLuint));
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+		m_passes.push_back(pass);
+	}
+	void ShaderTrace::End()
+	{
+		if (!m_capturing)
+			return;
+		m_capturing = false;
+
+		if (m_passes.empty())
+			return;
+
+		size_t bufferSize = (1 + SHADER_TRACE_CAPACITY * SHADER_TRACE_RECORD_SIZE) * sizeof(GLuint);
+
+		glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+		glBindBuffer(GL_COPY_READ_BUFFER, m_buffer);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, m_readback);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, bufferSize);
+		glBindBuffer(GL_COPY_READ_BUFFER, m_marks);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, bufferSize, m_passes.size() * sizeof(GLuint));
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+		m_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+	bool ShaderTrace::Poll()
+	{
+		if (m_fence == 0)
+			return false;
+
+		GLenum status = glClientWaitSync(m_fence, 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+			return false;
+
+		glDeleteSync(m_fence);
+		m_fence = 0;
+
+		size_t recordCount = 1 + SHADER_TRACE_CAPACITY * SHADER_TRACE_RECORD_SIZE;
+		std::vector<GLuint> data(recordCount + m_passes.size());
+		glBindBuffer(GL_COPY_READ_BUFFER, m_readback);
+		glGetBufferSubData(GL_COPY_READ_BUFFER, 0, data.size() * sizeof(GLuint), data.data());
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+		const GLuint* marks = data.data() + recordCount;
+		m_written = marks[m_passes.size() - 1];
+		unsigned int first = m_written > SHADER_TRACE_CAPACITY ? m_written - SHADER_TRACE_CAPACITY : 0;
+
+		m_records.clear();
+
+		std::lock_guard<std::mutex> lock(formatMutex);
+		unsigned int start = 0;
+		for (size_t p = 0; p < m_passes.size(); p++) {
+			for (unsigned int i = std::max(start, first); i < marks[p]; i++) {
+				const GLuint* rec = data.data() + 1 + (i % SHADER_TRACE_CAPACITY) * SHADER_TRACE_RECORD_SIZE;
+
+				Record record;
+				record.Pass = m_passes[p];
+				record.ID = glm::uvec3(rec[1], rec[2], rec[3]);
+
+				auto fmt = formats.find(rec[0]);
+				if (fmt == formats.end()) {
+					record.Stage = -1;
+					record.Text = "<unknown format " + std::to_string(rec[0]) + ">";
+				} else {
+					record.Stage = fmt->second.Stage;
+					record.Text = m_format(fmt->second.Text, rec + 4);
+				}
+
+				m_records.push_back(record);
+			}
+			start = std::max(start, marks[p]);
+		}
+
+		m_revision++;
+
+		return true;
+	}
+	std::string ShaderTrace::m_format(const std::string& fmt, const GLuint* args)
+	{
+		std::string ret;
+		int argIndex = 0;
+		char buffer[128];
+
+		for (size_t i = 0; i < fmt.size(); i++) {
+			if (fmt[i] != '%') {
+				ret += fmt[i];
+				continue;
+			}
+			if (i + 1 < fmt.size() && fmt[i + 1] == '%') {
+				ret += '%';
+				i++;
+				continue;
+			}
+
+			// %[flags][width][.precision][v2-4](d|i|u|x|X|o|c|f|F|e|E|g|G|a|A)
+			size_t p = i + 1;
+			std::string spec = "%";
+			while (p < fmt.size() && strchr("-+ #0123456789.", fmt[p]) != nullptr)
+				spec += fmt[p++];
+			while (p < fmt.size() && (fmt[p] == 'l' || fmt[p] == 'h'))
+				p++;
+
+			int components = 1;
+			if (p + 1 < fmt.size() && fmt[p] == 'v' && fmt[p + 1] >= '2' && fmt[p + 1] <= '4') {
+				components = fmt[p + 1] - '0';
+				p += 2;
+			}
+
+			if (p >= fmt.size() || strchr("diuxXocfFeEgGaA", fmt[p]) == nullptr) {
+				ret += fmt.substr(i, p - i);
+				i = p - 1;
+				continue;
+			}
+
+			char type = fmt[p];
+			spec += type;
+			i = p;
+
+			if (argIndex >= SHADER_TRACE_MAX_ARGS) {
+				ret += "?";
+				continue;
+			}
+
+			const GLuint* arg = args + argIndex * 4;
+			argIndex++;
+
+			if (components > 1)
+				ret += "(";
+			for (int c = 0; c < components; c++) {
+				if (c > 0)
+					ret += ", ";
+
+				if (type == 'd' || type == 'i')
+					snprintf(buffer, sizeof(buffer), spec.c_str(), (int)arg[c]);
+				else if (strchr("uxXoc", type) != nullptr)
+					snprintf(buffer, sizeof(buffer), spec.c_str(), arg[c]);
+				else {
+					float f;
+					memcpy(&f, &arg[c], sizeof(float));
+					snprintf(buffer, sizeof(buffer), spec.c_str(), (double)f);
+				}
+				ret += buffer;
+			}
+			if (components > 1)
+				ret += ")";
+		}
+
+		return ret;
+	}
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include <GL/glew.h>
+#if defined(__APPLE__)
+	#include <OpenGL/gl.h>
+#else
+	#include <GL/gl.h>
+#endif
+
+#define SHADER_TRACE_BLOCK_NAME "SHADERed_Trace"
+#define SHADER_TRACE_CAPACITY 16384 // records in the ring (power of two), older records of the same frame are overwritten
+#define SHADER_TRACE_MAX_ARGS 4 // printf() arguments that are stored, scalars & vectors up to 4 components
+#define SHADER_TRACE_RECORD_SIZE (4 + SHADER_TRACE_MAX_ARGS * 4) // uints: format, invocation id xyz, arguments
+#define SHADER_TRACE_MAX_PASSES 256 // passes per frame whose records can be told apart
+
+namespace ed
+{
+	// printf("format", args...) in GLSL shaders - the calls are rewritten into writes to an SSBO ring with an atomic
+	// cursor, the buffer is read back asynchronously & the records are attributed to the passes through the value
+	// that the cursor had after each pass
+	class ShaderTrace
+	{
+	public:
+		struct Record
+		{
+			std::string Pass;
+			int Stage; // 0 = VS, 1 = PS, 2 = GS, 3 = CS
+			glm::uvec3 ID; // VS: vertex & instance, PS: pixel, GS: primitive, CS: global invocation
+			std::string Text;
+		};
+
+		ShaderTrace();
+		~ShaderTrace();
+
+		static bool IsSupported();
+
+		// rewrites the printf() calls of the GLSL code, returns the number of lines that were added in front of the
+		// user's code (vulkan -> Vulkan GLSL that still goes through glslang, a #line directive keeps the line numbers)
+		static int Instrument(std::string& glsl, int stage, bool vulkan = false);
+		// removes the printf() calls - for the compilers that don't know about the trace buffer
+		static void Strip(std::string& code);
+		// formats used by the code generated by Instrument(), for the outputs that come from a cache
+		static void RegisterFormats(const std::string& code);
+		static std::string GetFormatComments(const std::string& code); // the part of the instrumented code that RegisterFormats() reads
+
+		// binds the buffer, true if this frame's records will be read back (Mark() & End() have to be called)
+		bool Begin(GLuint binding);
+		void Mark(const std::string& pass); // after the pass' draw calls
+		void End();
+		bool Poll(); // true if GetRecords() was just updated
+
+		inline const std::vector<Record>& GetRecords() { return m_records; }
+		inline unsigned int GetWritten() { return m_written; } // records written in the traced frame, including the overwritten ones
+		inline unsigned int GetRevision() { return m_revision; } // incremented by every Poll() that returns true
+		inline bool IsActive() { return m_buffer != 0; }
+
+	private:
+		static std::string m_format(const std::string& fmt, const GLuint* args);
+
+		GLuint m_buffer, m_marks, m_readback;
+		GLsync m_fence;
+		bool m_capturing;
+
+		std::vector<std::string> m_passes; // of the frame that is being read back
+		std::vector<Record> m_records;
+		unsigned int m_written, m_revision;
+	};
+}
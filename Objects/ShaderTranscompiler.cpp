@@ -3,11 +3,21 @@
 #include <vector>
 #include <sstream>
 #include <algorithm>
-
+#include <mutex>
+#include <chrono>
+#include <regex>
+#include <stdio.h>
+#include <unordered_map>
+#include <ghc/filesystem.hpp>
+
+#include "Hash.h"
 #include "Logger.h"
 #include "Settings.h"
+#include "IncludeCache.h"
 #include "HLSLFileIncluder.h"
+#include "ProfilerZones.h"
 #include "ShaderTranscompiler.h"
+#include "ShaderTrace.h"
 #include <glslang/glslang/Public/ShaderLang.h>
 #include <glslang/SPIRV/GlslangToSpv.h>
 #include <glslang/StandAlone/DirStackFileIncluder.h>
@@ -126,32 +136,299 @@ const TBuiltInResource DefaultTBuiltInResource = {
 
 namespace ed
 {
-	std::string ShaderTranscompiler::Transcompile(ShaderLanguage inLang, const std::string &filename, int sType, const std::string &entry, std::vector<ShaderMacro> &macros, bool gsUsed, MessageStack *msgs, ProjectParser* project)
+	/* transcompiled code cache - shared by everything that calls TranscompileSource (renderer workers, auto recompile, ...) */
+#define TRANSCOMPILE_CACHE_DIR "./data/cache/"
+#define TRANSCOMPILE_CACHE_VERSION "3" // change this when transcompiler output changes
+#define TRANSCOMPILE_CACHE_MAGIC 0x54444553 // SEDT
+#define TRANSCOMPILE_CACHE_MAX_ENTRIES 512
+
+	struct TranscompileCacheEntry
 	{
-		ed::Logger::Get().Log("Starting to transcompile a HLSL shader " + filename);
+		std::vector<std::pair<std::string, uint64_t>> Includes; // path + content hash
+		std::string Output;
+		ShaderCostReport Report;
+	};
+	static std::mutex transcompileCacheMutex;
+	static std::unordered_map<uint64_t, TranscompileCacheEntry> transcompileCache;
+	static std::unordered_map<std::string, TranscompileCacheEntry> lastResults; // filename;stage -> last successful result, guarded by transcompileCacheMutex
+
+	static std::string getLastResultKey(const std::string& filename, int sType)
+	{
+		return filename + ";" + std::to_string(sType);
+	}
 
-		//Load HLSL into a string
-		std::ifstream file(filename);
+	static thread_local ed::ShaderTranscompiler::Timings lastTimings; // every worker transcompiles on its own
 
+	static std::once_flag glslangInitFlag;
+	static bool glslangInitialized = false;
+
+	static float elapsedTime(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+	static std::string getTranscompileCachePath(uint64_t key)
+	{
+		char name[17] = { 0 };
+		snprintf(name, 17, "%016llx", (unsigned long long)key);
+		return std::string(TRANSCOMPILE_CACHE_DIR) + name + ".glsl";
+	}
+	static bool areIncludesUnchanged(const TranscompileCacheEntry& entry)
+	{
+		// the include cache only reads the files that were modified since they were last seen
+		for (const auto& inc : entry.Includes) {
+			std::string content;
+			uint64_t hash = 0;
+			if (!ed::IncludeCache::Instance().Get(inc.first, content, &hash) || hash != inc.second)
+				return false;
+		}
+		return true;
+	}
+	static void registerIncludes(const std::string& filename, const std::vector<std::pair<std::string, uint64_t>>& includes)
+	{
+		std::vector<std::string> paths;
+		for (const auto& inc : includes)
+			paths.push_back(inc.first);
+		ed::IncludeCache::Instance().SetDependencies(filename, paths);
+	}
+	static bool loadTranscompileCacheEntry(uint64_t key, TranscompileCacheEntry& entry)
+	{
+		std::ifstream file(getTranscompileCachePath(key), std::ios::binary);
 		if (!file.is_open())
+			return false;
+
+		uint32_t magic = 0, incCount = 0, len = 0;
+		file.read((char*)&magic, sizeof(magic));
+		file.read((char*)&incCount, sizeof(incCount));
+		if (!file || magic != TRANSCOMPILE_CACHE_MAGIC)
+			return false;
+
+		entry.Includes.resize(incCount);
+		for (auto& inc : entry.Includes) {
+			file.read((char*)&len, sizeof(len));
+			inc.first.resize(len);
+			file.read(&inc.first[0], len);
+			file.read((char*)&inc.second, sizeof(inc.second));
+		}
+
+		file.read((char*)&len, sizeof(len));
+		entry.Output.resize(len);
+		file.read(&entry.Output[0], len);
+
+		file.read((char*)&entry.Report, sizeof(entry.Report));
+
+		return (bool)file;
+	}
+	static void saveTranscompileCacheEntry(uint64_t key, const TranscompileCacheEntry& entry)
+	{
+		std::error_code errCode;
+		if (!ghc::filesystem::exists(TRANSCOMPILE_CACHE_DIR))
+			ghc::filesystem::create_directories(TRANSCOMPILE_CACHE_DIR, errCode);
+
+		std::ofstream file(getTranscompileCachePath(key), std::ios::binary);
+		if (!file.is_open())
+			return;
+
+		uint32_t magic = TRANSCOMPILE_CACHE_MAGIC, incCount = entry.Includes.size(), len = 0;
+		file.write((char*)&magic, sizeof(magic));
+		file.write((char*)&incCount, sizeof(incCount));
+		for (const auto& inc : entry.Includes) {
+			len = inc.first.size();
+			file.write((char*)&len, sizeof(len));
+			file.write(inc.first.c_str(), len);
+			file.write((char*)&inc.second, sizeof(inc.second));
+		}
+
+		len = entry.Output.size();
+		file.write((char*)&len, sizeof(len));
+		file.write(entry.Output.c_str(), len);
+
+		file.write((char*)&entry.Report, sizeof(entry.Report));
+	}
+
+	/* SPIR-V cost report */
+	static bool hasSPIRVResult(uint32_t op)
+	{
+		// only the value producing instructions that are interesting for register pressure (pointers are left out)
+		return op == spv::OpExtInst || op == spv::OpFunctionCall || op == spv::OpLoad || op == spv::OpPhi ||
+			(op >= spv::OpVectorShuffle && op <= spv::OpTranspose) ||
+			(op >= spv::OpSampledImage && op <= spv::OpImageRead) ||
+			(op >= spv::OpImage && op <= spv::OpImageQuerySamples) ||
+			(op >= spv::OpConvertFToU && op <= spv::OpFwidthCoarse) ||
+			(op >= spv::OpAtomicLoad && op <= spv::OpAtomicXor && op != spv::OpAtomicStore);
+	}
+	static void analyzeSPIRV(const std::vector<unsigned int>& spv, ShaderCostReport& report)
+	{
+		// instruction stream starts after the 5 word header
+		size_t i = 5;
+
+		bool inFunction = false;
+		int instIndex = 0;
+		std::unordered_map<uint32_t, std::pair<int, int>> ranges; // result id -> first & last instruction that touches it
+
+		auto endFunction = [&]() {
+			std::vector<std::pair<int, int>> events; // instruction, +1/-1
+			events.reserve(ranges.size() * 2);
+			for (const auto& range : ranges) {
+				events.push_back(std::make_pair(range.second.first, 1));
+				events.push_back(std::make_pair(range.second.second + 1, -1));
+			}
+			std::sort(events.begin(), events.end()); // -1 before +1 at the same instruction
+
+			int live = 0;
+			for (const auto& e : events) {
+				live += e.second;
+				report.LiveValues = std::max<int>(report.LiveValues, live);
+			}
+
+			ranges.clear();
+		};
+
+		while (i < spv.size()) {
+			uint32_t wordCount = spv[i] >> 16;
+			uint32_t op = spv[i] & 0xFFFF;
+			if (wordCount == 0 || i + wordCount > spv.size())
+				break;
+
+			if (op == spv::OpFunction) {
+				inFunction = true;
+				report.Functions++;
+			}
+			else if (op == spv::OpFunctionEnd) {
+				inFunction = false;
+				endFunction();
+			}
+			else if (inFunction && op != spv::OpFunctionParameter && op != spv::OpLabel && op != spv::OpLine && op != spv::OpNoLine) {
+				instIndex++;
+
+				// uses - literal operands that happen to match an id only make the estimate a bit more pessimistic
+				for (uint32_t w = 1; w < wordCount; w++) {
+					auto it = ranges.find(spv[i + w]);
+					if (it != ranges.end())
+						it->second.second = instIndex;
+				}
+
+				if (hasSPIRVResult(op) && wordCount >= 3)
+					ranges[spv[i + 2]] = std::make_pair(instIndex, instIndex);
+
+				if (op == spv::OpVariable)
+					report.LocalVariables++;
+				else if (op == spv::OpSelectionMerge || op == spv::OpBranch || op == spv::OpReturn || op == spv::OpReturnValue) {
+					// structure only, not counted
+				}
+				else {
+					report.Total++;
+
+					if ((op >= spv::OpConvertFToU && op <= spv::OpFwidthCoarse) || op == spv::OpExtInst)
+						report.ALU++;
+					else if (op >= spv::OpImageSampleImplicitLod && op <= spv::OpImageWrite) {
+						report.Texture++;
+						if (op <= spv::OpImageDrefGather)
+							report.TextureSamples++;
+					}
+					else if (op == spv::OpBranchConditional || op == spv::OpSwitch || op == spv::OpKill)
+						report.Branch++;
+					else if (op == spv::OpLoopMerge)
+						report.Loops++;
+					else if (op == spv::OpFunctionCall)
+						report.Calls++;
+					else if ((op >= spv::OpLoad && op <= spv::OpInBoundsAccessChain) || (op >= spv::OpControlBarrier && op <= spv::OpAtomicXor))
+						report.Memory++;
+					else
+						report.Other++;
+				}
+			}
+
+			i += wordCount;
+		}
+
+		report.Available = true;
+	}
+
+	bool ShaderTranscompiler::Initialize()
+	{
+		std::call_once(glslangInitFlag, []() {
+			auto start = std::chrono::steady_clock::now();
+			glslangInitialized = glslang::InitializeProcess();
+
+			char buffer[32];
+			snprintf(buffer, 32, "%.1f ms", elapsedTime(start));
+			if (glslangInitialized)
+				ed::Logger::Get().Log("Finished glslang initialization (" + std::string(buffer) + ")");
+			else
+				ed::Logger::Get().Log("Failed to initialize glslang", true);
+		});
+		return glslangInitialized;
+	}
+	std::string ShaderTranscompiler::Transcompile(ShaderLanguage inLang, const std::string &filename, int sType, const std::string &entry, std::vector<ShaderMacro> &macros, bool gsUsed, MessageStack *msgs, ProjectParser* project, bool trace)
+	{
+		ed::Logger::Get().Log("Starting to transcompile a HLSL shader " + filename);
+
+		//Load HLSL into a string
+		auto readStart = std::chrono::steady_clock::now();
+		std::string inputHLSL;
+		if (!IncludeCache::Instance().Get(filename, inputHLSL))
 		{
+			lastTimings = Timings();
 			if (msgs != nullptr)
 				msgs->Add(MessageStack::Type::Error, msgs->CurrentItem, "Failed to open file " + filename, -1, sType);
-			file.close();
 			return "errorFile";
 		}
+		float readTime = elapsedTime(readStart);
 
-		std::string inputHLSL((std::istreambuf_iterator<char>(file)),
-							std::istreambuf_iterator<char>());
-
-		file.close();
+		std::string ret = ShaderTranscompiler::TranscompileSource(inLang, filename, inputHLSL, sType, entry, macros, gsUsed, msgs, project, trace);
+		lastTimings.Read = readTime;
 
-		return ShaderTranscompiler::TranscompileSource(inLang, filename, inputHLSL, sType, entry, macros, gsUsed, msgs, project);
+		return ret;
 	}
-	std::string ShaderTranscompiler::TranscompileSource(ShaderLanguage inLang, const std::string &filename, const std::string &inputHLSL, int sType, const std::string &entry, std::vector<ShaderMacro> &macros, bool gsUsed, MessageStack *msgs, ProjectParser* project)
+	std::string ShaderTranscompiler::TranscompileSource(ShaderLanguage inLang, const std::string &filename, const std::string &inputHLSL, int sType, const std::string &entry, std::vector<ShaderMacro> &macros, bool gsUsed, MessageStack *msgs, ProjectParser* project, bool trace)
 	{
+		ED_ZONE("ShaderTranscompiler::TranscompileSource");
+		ED_ZONE_TEXT(filename);
+
+		lastTimings = Timings();
+
+		// everything that can change the output is part of the key - included files are checked separately
+		uint64_t cacheKey = ed::HashString(TRANSCOMPILE_CACHE_VERSION);
+		cacheKey = ed::HashString(inputHLSL, cacheKey);
+		cacheKey = ed::HashString(std::to_string((int)inLang) + ";" + std::to_string(sType) + ";" + std::to_string(gsUsed) + ";" + entry + ";" + std::to_string(Settings::Instance().Project.SPIRVOptimization) + ";" + std::to_string(trace), cacheKey);
+		cacheKey = ed::HashString(filename.substr(0, filename.find_last_of("/\\")), cacheKey);
+		for (auto& macro : macros)
+			if (macro.Active)
+				cacheKey = ed::HashString(std::string(macro.Name) + "=" + macro.Value, cacheKey);
+		if (project != nullptr)
+			for (auto& str : Settings::Instance().Project.IncludePaths)
+				cacheKey = ed::HashString(project->GetProjectPath(str), cacheKey);
+
+		bool useDiskCache = Settings::Instance().General.ProgramCache;
+		{
+			std::lock_guard<std::mutex> lock(transcompileCacheMutex);
+			auto cached = transcompileCache.find(cacheKey);
+			if (cached != transcompileCache.end() && areIncludesUnchanged(cached->second)) {
+				lastResults[getLastResultKey(filename, sType)] = cached->second;
+				registerIncludes(filename, cached->second.Includes);
+				return cached->second.Output;
+			}
+		}
+		if (useDiskCache) {
+			TranscompileCacheEntry cached;
+			if (loadTranscompileCacheEntry(cacheKey, cached) && areIncludesUnchanged(cached)) {
+				std::lock_guard<std::mutex> lock(transcompileCacheMutex);
+				transcompileCache[cacheKey] = cached;
+				lastResults[getLastResultKey(filename, sType)] = cached;
+				registerIncludes(filename, cached.Includes);
+				return cached.Output;
+			}
+		}
+
 		const char* inputStr = inputHLSL.c_str();
 
+		// waits for the startup thread if it hasn't finished yet
+		if (!Initialize()) {
+			if (msgs != nullptr)
+				msgs->Add(MessageStack::Type::Error, msgs->CurrentItem, "glslang couldn't be initialized", -1, sType);
+			return "error";
+		}
+
 		// create shader
 		EShLanguage shaderType = EShLangVertex;
 		if (sType == 1)
@@ -201,7 +478,13 @@ namespace ed
 
 		std::string processedShader;
 
-		if (!shader.preprocess(&res, defVersion, ENoProfile, false, false, messages, &processedShader, includer))
+		auto stepStart = std::chrono::steady_clock::now();
+		bool preprocessed = shader.preprocess(&res, defVersion, ENoProfile, false, false, messages, &processedShader, includer);
+
+		// the includes are known even if the shader has errors - fixing the header should recompile it
+		registerIncludes(filename, includer.getIncludedFiles());
+
+		if (!preprocessed)
 		{
 			if (msgs != nullptr) {
 				msgs->Add(gl::ParseHLSLMessages(msgs->CurrentItem, sType, shader.getInfoLog()));
@@ -210,6 +493,17 @@ namespace ed
 			return "error";
 		}
 
+		// glslang doesn't know printf() - the includes are already resolved here
+		if (inLang == ShaderLanguage::VulkanGLSL) {
+			if (trace)
+				ShaderTrace::Instrument(processedShader, sType, true);
+			else
+				ShaderTrace::Strip(processedShader);
+		}
+
+		lastTimings.Preprocess = elapsedTime(stepStart);
+		stepStart = std::chrono::steady_clock::now();
+
 		// update strings
 		const char *processedStr = processedShader.c_str();
 		shader.setStrings(&processedStr, 1);
@@ -233,18 +527,26 @@ namespace ed
 			return "error";
 		}
 
+		lastTimings.Parse = elapsedTime(stepStart);
+		stepStart = std::chrono::steady_clock::now();
+
 		// convert to spirv
 		std::vector<unsigned int> spv;
 		spv::SpvBuildLogger logger;
 		glslang::SpvOptions spvOptions;
 
-		spvOptions.optimizeSize = false;
-		spvOptions.disableOptimizer = true;
+		// glslang runs the SPIRV-Tools optimizer when it was built with it (ENABLE_OPT)
+		int optPreset = Settings::Instance().Project.SPIRVOptimization;
+		spvOptions.disableOptimizer = optPreset == 0;
+		spvOptions.optimizeSize = optPreset == 2;
 
 		glslang::GlslangToSpv(*prog.getIntermediate(shaderType), spv, &logger, &spvOptions);
 
+		ShaderCostReport costReport;
+		analyzeSPIRV(spv, costReport);
 
-
+		lastTimings.SPIRV = elapsedTime(stepStart);
+		stepStart = std::chrono::steady_clock::now();
 
 		// Read SPIR-V from disk or similar.
 		spirv_cross::CompilerGLSL glsl(std::move(spv));
@@ -259,6 +561,14 @@ namespace ed
 
 		// rename outputs
 		spirv_cross::ShaderResources resources = glsl.get_shader_resources();
+		costReport.Inputs = resources.stage_inputs.size();
+		costReport.Outputs = resources.stage_outputs.size();
+		costReport.UniformBuffers = resources.uniform_buffers.size();
+		costReport.StorageBuffers = resources.storage_buffers.size();
+		costReport.Samplers = resources.sampled_images.size() + resources.separate_samplers.size();
+		costReport.Images = resources.separate_images.size() + resources.storage_images.size();
+		costReport.PushConstants = resources.push_constant_buffers.size();
+
 		std::string outputName = "outputVS";
 		if (shaderType == EShLangFragment)
 			outputName = "outputPS";
@@ -439,10 +749,120 @@ namespace ed
 			}
 		}
 
+		lastTimings.Cross = elapsedTime(stepStart);
+
 		ed::Logger::Get().Log("Finished transcompiling the shader");
+
+		// the formats of the printf() calls travel with the (cached) output
+		source += ShaderTrace::GetFormatComments(processedShader);
+
+		// only successful results are cached so that the errors are reported every time
+		TranscompileCacheEntry cacheEntry;
+		cacheEntry.Includes = includer.getIncludedFiles();
+		cacheEntry.Output = source;
+		cacheEntry.Report = costReport;
+		{
+			std::lock_guard<std::mutex> lock(transcompileCacheMutex);
+			lastResults[getLastResultKey(filename, sType)] = cacheEntry;
+			if (transcompileCache.size() >= TRANSCOMPILE_CACHE_MAX_ENTRIES)
+				transcompileCache.clear();
+			transcompileCache[cacheKey] = cacheEntry;
+		}
+		if (useDiskCache)
+			saveTranscompileCacheEntry(cacheKey, cacheEntry);
 		
 		return source;
 	}
+	bool ShaderTranscompiler::Check(ShaderLanguage inLang, const std::string& filename, const std::string& source, int sType, const std::string& entry, std::vector<ShaderMacro>& macros, MessageStack* msgs, ProjectParser* project)
+	{
+		ED_ZONE("ShaderTranscompiler::Check");
+		ED_ZONE_TEXT(filename);
+
+		if (!Initialize())
+			return true; // nothing to report, the full compile shows the error
+
+		EShLanguage shaderType = EShLangVertex;
+		if (sType == 1)
+			shaderType = EShLangFragment;
+		else if (sType == 2)
+			shaderType = EShLangGeometry;
+		else if (sType == 3)
+			shaderType = EShLangCompute;
+
+		// same set up as TranscompileSource()
+		const char* inputStr = source.c_str();
+		glslang::TShader shader(shaderType);
+		if (entry.size() > 0 && entry != "main") {
+			shader.setEntryPoint(entry.c_str());
+			shader.setSourceEntryPoint(entry.c_str());
+		}
+		shader.setStrings(&inputStr, 1);
+
+		std::string preambleStr = (inLang == ShaderLanguage::VulkanGLSL) ? "" : "#extension GL_GOOGLE_include_directive : enable\n";
+		for (auto& macro : macros) {
+			if (!macro.Active)
+				continue;
+			preambleStr += "#define " + std::string(macro.Name) + " " + std::string(macro.Value) + "\n";
+		}
+		if (preambleStr.size() > 0)
+			shader.setPreamble(preambleStr.c_str());
+
+		int sVersion = (sType == 3) ? 430 : 330;
+		shader.setEnvInput(inLang == ShaderLanguage::HLSL ? glslang::EShSourceHlsl : glslang::EShSourceGlsl, shaderType, glslang::EShClientVulkan, sVersion);
+		shader.setEnvClient(glslang::EShClientVulkan, glslang::EShTargetVulkan_1_0);
+		shader.setEnvTarget(glslang::EShTargetSpv, glslang::EShTargetSpv_1_0);
+
+		TBuiltInResource res = DefaultTBuiltInResource;
+		EShMessages messages = (EShMessages)(EShMsgSpvRules | EShMsgVulkanRules);
+
+		ed::HLSLFileIncluder includer;
+		includer.pushExternalLocalDirectory(filename.substr(0, filename.find_last_of("/\\")));
+		if (project != nullptr)
+			for (auto& str : Settings::Instance().Project.IncludePaths)
+				includer.pushExternalLocalDirectory(project->GetProjectPath(str));
+
+		std::string processedShader;
+		if (!shader.preprocess(&res, sVersion, ENoProfile, false, false, messages, &processedShader, includer)) {
+			if (msgs != nullptr) {
+				msgs->Add(gl::ParseHLSLMessages(msgs->CurrentItem, sType, shader.getInfoLog()));
+				msgs->Add(MessageStack::Type::Error, msgs->CurrentItem, "Shader preprocessing failed", -1, sType);
+			}
+			return false;
+		}
+
+		if (inLang == ShaderLanguage::VulkanGLSL)
+			ShaderTrace::Strip(processedShader);
+
+		const char* processedStr = processedShader.c_str();
+		shader.setStrings(&processedStr, 1);
+		if (!shader.parse(&res, 100, false, messages)) {
+			if (msgs != nullptr)
+				msgs->Add(gl::ParseHLSLMessages(msgs->CurrentItem, sType, shader.getInfoLog()));
+			return false;
+		}
+
+		return true;
+	}
+	ShaderCostReport ShaderTranscompiler::GetCostReport(const std::string& filename, int shaderType)
+	{
+		std::lock_guard<std::mutex> lock(transcompileCacheMutex);
+		auto it = lastResults.find(getLastResultKey(filename, shaderType));
+		if (it == lastResults.end())
+			return ShaderCostReport();
+		return it->second.Report;
+	}
+	std::string ShaderTranscompiler::GetLastOutput(const std::string& filename, int shaderType)
+	{
+		std::lock_guard<std::mutex> lock(transcompileCacheMutex);
+		auto it = lastResults.find(getLastResultKey(filename, shaderType));
+		if (it == lastResults.end())
+			return "";
+		return it->second.Output;
+	}
+	ShaderTranscompiler::Timings ShaderTranscompiler::GetLastTimings()
+	{
+		return lastTimings;
+	}
 	ShaderLanguage ShaderTranscompiler::GetShaderTypeFromExtension(const std::string &file)
 	{
 		std::vector<std::string> &hlslExts = Settings::Instance().General.HLSLExtensions;
@@ -454,4 +874,114 @@ namespace ed
 
 		return ShaderLanguage::GLSL;
 	}
+	static size_t skipSpaceAndComments(const std::string& code, size_t i)
+	{
+		while (i < code.size()) {
+			if (isspace(code[i]))
+				i++;
+			else if (code.compare(i, 2, "//") == 0)
+				i = code.find('\n', i) == std::string::npos ? code.size() : code.find('\n', i);
+			else if (code.compare(i, 2, "/*") == 0)
+				i = code.find("*/", i) == std::string::npos ? code.size() : code.find("*/", i) + 2;
+			else break;
+		}
+		return i;
+	}
+	std::string ShaderTranscompiler::InstrumentCost(const std::string& glsl, int output)
+	{
+		// find the output variable that goes to the render texture we're measuring
+		std::string outName, outType;
+		try {
+			std::regex outRe("(layout\\s*\\(\\s*location\\s*=\\s*(\\d+)\\s*\\)\\s*)?\\bout\\s+(vec[34])\\s+(\\w+)\\s*;");
+			std::sregex_iterator next(glsl.begin(), glsl.end(), outRe), end;
+			for (int outIndex = 0; next != end; next++, outIndex++) {
+				const std::smatch& match = *next;
+				int location = match[2].matched ? std::stoi(match[2].str()) : outIndex;
+				if (location == output) {
+					outType = match[3].str();
+					outName = match[4].str();
+					break;
+				}
+			}
+		} catch (std::regex_error&) { }
+
+		std::regex mainRe("\\bvoid\\s+main\\s*\\(");
+		if (outName.empty() || !std::regex_search(glsl, mainRe))
+			return "";
+
+		// count every iteration of for/while/do loops that have a body in braces
+		std::vector<size_t> counters;
+		for (size_t i = 0; i < glsl.size();) {
+			if (glsl.compare(i, 2, "//") == 0 || glsl.compare(i, 2, "/*") == 0) {
+				i = skipSpaceAndComments(glsl, i);
+				continue;
+			}
+			if (glsl[i] == '#') { // preprocessor
+				size_t lineEnd = glsl.find('\n', i);
+				i = lineEnd == std::string::npos ? glsl.size() : lineEnd;
+				continue;
+			}
+			if (!isalpha(glsl[i]) && glsl[i] != '_') {
+				i++;
+				continue;
+			}
+
+			size_t wordEnd = i;
+			while (wordEnd < glsl.size() && (isalnum(glsl[wordEnd]) || glsl[wordEnd] == '_'))
+				wordEnd++;
+			std::string word = glsl.substr(i, wordEnd - i);
+			i = wordEnd;
+
+			if (word == "for" || word == "while") {
+				size_t p = skipSpaceAndComments(glsl, i);
+				if (p >= glsl.size() || glsl[p] != '(')
+					continue;
+
+				int depth = 0;
+				for (; p < glsl.size(); p++) {
+					if (glsl[p] == '(') depth++;
+					else if (glsl[p] == ')' && --depth == 0)
+						break;
+				}
+
+				p = skipSpaceAndComments(glsl, p + 1);
+				if (p < glsl.size() && glsl[p] == '{')
+					counters.push_back(p + 1);
+			}
+			else if (word == "do") {
+				size_t p = skipSpaceAndComments(glsl, i);
+				if (p < glsl.size() && glsl[p] == '{')
+					counters.push_back(p + 1);
+			}
+		}
+
+		std::string ret;
+		ret.reserve(glsl.size() + counters.size() * 16 + 256);
+		size_t last = 0;
+		for (size_t pos : counters) {
+			ret += glsl.substr(last, pos - last);
+			ret += " _sed_cost++;";
+			last = pos;
+		}
+		ret += glsl.substr(last);
+
+		// the counter has to come after #version and #extension
+		size_t declPos = 0;
+		size_t dirPos = 0;
+		while ((dirPos = ret.find('#', dirPos)) != std::string::npos) {
+			size_t lineEnd = ret.find('\n', dirPos);
+			lineEnd = lineEnd == std::string::npos ? ret.size() : lineEnd + 1;
+			if (ret.compare(dirPos, 8, "#version") == 0 || ret.compare(dirPos, 10, "#extension") == 0)
+				declPos = lineEnd;
+			dirPos = lineEnd;
+		}
+		ret.insert(declPos, "int _sed_cost = 1;\n");
+
+		ret = std::regex_replace(ret, mainRe, "void _sed_main(", std::regex_constants::format_first_only);
+
+		std::string packed = "float(_sed_cost & 255) / 255.0, float((_sed_cost >> 8) & 255) / 255.0, float((_sed_cost >> 16) & 255) / 255.0";
+		ret += "\nvoid main()\n{\n\t_sed_main();\n\t" + outName + " = " + (outType == "vec4" ? "vec4(" + packed + ", 1.0)" : "vec3(" + packed + ")") + ";\n}\n";
+
+		return ret;
+	}
 }
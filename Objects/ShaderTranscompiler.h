@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <string.h>
 #include "MessageStack.h"
 #include "ShaderMacro.h"
 #include "ShaderLanguage.h"
@@ -7,12 +8,75 @@
 
 namespace ed
 {
+	// rough cost figures gathered from the SPIR-V that glslang generates for a shader stage
+	struct ShaderCostReport
+	{
+		ShaderCostReport() { memset(this, 0, sizeof(ShaderCostReport)); }
+
+		bool Available; // false for shaders that don't go through SPIR-V
+
+		// instruction counts
+		int Total;
+		int ALU;
+		int Texture;	// sampling, fetches, gathers, image loads & stores
+		int Branch;		// conditional branches, switches and kills
+		int Loops;
+		int Calls;
+		int Memory;		// loads, stores, access chains, atomics & barriers
+		int Other;
+
+		int TextureSamples;
+		int LiveValues;		// highest number of SSA values alive at the same time in a function
+		int LocalVariables;
+		int Functions;
+
+		// resources
+		int Inputs;
+		int Outputs;
+		int UniformBuffers;
+		int StorageBuffers;
+		int Samplers; // combined image samplers + separate samplers
+		int Images;   // separate & storage images
+		int PushConstants;
+	};
+
 	class ShaderTranscompiler
 	{
 	public:
+		// glslang::InitializeProcess(), once - main() runs it on another thread so that it doesn't hold back the first frame,
+		// transcompiling waits for it
+		static bool Initialize();
+
+		// how long the steps of a Transcompile() call took, in milliseconds
+		struct Timings
+		{
+			Timings() { Read = Preprocess = Parse = SPIRV = Cross = 0.0f; }
+
+			float Read;			// 0 for TranscompileSource()
+			float Preprocess;	// includes & macros
+			float Parse;		// glslang parse & link
+			float SPIRV;
+			float Cross;		// SPIRV-Cross & the post processing of its output
+		};
+
 		/* TODO: enum for shaderType = { 0 -> vertex, 1 -> pixel, 2 -> geometry } */
-		static std::string Transcompile(ShaderLanguage inLang, const std::string &filename, int shaderType, const std::string &entry, std::vector<ShaderMacro> &macros, bool gsUsed, MessageStack *msgs, ProjectParser* project);
-		static std::string TranscompileSource(ShaderLanguage inLang, const std::string &filename, const std::string &source, int shaderType, const std::string &entry, std::vector<ShaderMacro> &macros, bool gsUsed, MessageStack *msgs, ProjectParser* project);
+		// trace -> printf() calls of Vulkan GLSL shaders write to the ShaderTrace buffer, they are removed otherwise
+		static std::string Transcompile(ShaderLanguage inLang, const std::string &filename, int shaderType, const std::string &entry, std::vector<ShaderMacro> &macros, bool gsUsed, MessageStack *msgs, ProjectParser* project, bool trace = false);
+		static std::string TranscompileSource(ShaderLanguage inLang, const std::string &filename, const std::string &source, int shaderType, const std::string &entry, std::vector<ShaderMacro> &macros, bool gsUsed, MessageStack *msgs, ProjectParser* project, bool trace = false);
 		static ShaderLanguage GetShaderTypeFromExtension(const std::string& file);
+
+		// only preprocesses & parses the source with glslang (no link, SPIR-V or cross compile) so that the errors can be shown
+		// while typing - the messages are the ones that TranscompileSource() would report, the cache isn't touched
+		static bool Check(ShaderLanguage inLang, const std::string& filename, const std::string& source, int shaderType, const std::string& entry, std::vector<ShaderMacro>& macros, MessageStack* msgs, ProjectParser* project);
+
+		// GLSL fragment shader that writes the number of loop iterations (packed into rgb) to the given output instead of its color, empty if the shader can't be instrumented
+		static std::string InstrumentCost(const std::string& glsl, int output);
+
+		// report generated by the last TranscompileSource() call for this file & stage (filename must match the one passed to TranscompileSource())
+		static ShaderCostReport GetCostReport(const std::string& filename, int shaderType);
+		// GLSL code generated by the last successful TranscompileSource() call for this file & stage
+		static std::string GetLastOutput(const std::string& filename, int shaderType);
+		// timings of the last Transcompile()/TranscompileSource() call made on the calling thread, all 0 if the output came from the cache
+		static Timings GetLastTimings();
 	};
 }
\ No newline at end of file
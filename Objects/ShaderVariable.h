@@ -2,14 +2,18 @@
 #include "../Options.h"
 #include "PluginAPI/Plugin.h"
 #include <string>
+#include <vector>
 #include <string.h>
 
 namespace ed
 {
 	struct PluginSystemVariableData
 	{
+		PluginSystemVariableData() : Owner(nullptr) { Name[0] = 0; Offset[0] = Offset[1] = -2; }
+
 		char Name[64];
 		IPlugin* Owner;
+		int Offset[2]; // into the owner's value block (API version 3) for the current & the last frame, -1 = not in the block, -2 = not looked up yet
 	};
 
 	struct PluginFunctionData
@@ -41,6 +45,15 @@ namespace ed
 		Mouse,				// vec4 - (x,y,left,right) updated every frame
 		MouseButton,		// vec4 - (x,y,left,right) updated only when mouse button pressed
 		PluginVariable,		// a value that is updated by some plugin
+		IterationIndex,		// uint - current iteration of a compute pass that is dispatched multiple times
+		SampleIndex,		// uint - number of frames that an accumulating shader pass has averaged so far
+		AudioPosition,		// vec4 - (seconds, texel at the playhead, texels per second, texel count) of a whole-track audio object
+		ViewLeft,			// mat4 - View moved by half of the eye separation, for the stereo preview (gl_ViewID_OVR == 0)
+		ViewRight,			// mat4 - View moved by half of the eye separation, for the stereo preview (gl_ViewID_OVR == 1)
+		ProjectionLeft,		// mat4 - off-axis projection of the left eye, converges at Settings::Project.StereoConvergence
+		ProjectionRight,	// mat4 - off-axis projection of the right eye
+		ViewProjectionLeft,	// mat4 - ProjectionLeft*ViewLeft
+		ViewProjectionRight,// mat4 - ProjectionRight*ViewRight
 		Count
 	};
 
@@ -98,7 +111,8 @@ namespace ed
 		{
 			None		= 0b00000000, // no flags
 			LastFrame	= 0b00000001, // use previous value instead of the current value
-			Inverse		= 0b00000010  // inverse(matrix)
+			Inverse		= 0b00000010, // inverse(matrix)
+			Constant	= 0b00000100  // compiled into the shader, the pass is rebuilt when the value changes
 		};
 
 		ShaderVariable(ValueType type, const char* name = "var\0", SystemShaderVariable systemVar = SystemShaderVariable::None) :
@@ -146,6 +160,17 @@ namespace ed
 		PluginSystemVariableData PluginSystemVarData;
 		PluginFunctionData PluginFuncData;
 
+		// FunctionVariableManager keeps the last result so that the function only runs again when its inputs change
+		struct FunctionCacheData
+		{
+			FunctionCacheData() : Function(FunctionShaderVariable::None), Generation(0), Source(nullptr) {}
+
+			FunctionShaderVariable Function;
+			unsigned int Generation; // list generation for Pointer, CameraSnapshots::Generation for CameraSnapshot
+			ShaderVariable* Source;	 // resolved Pointer
+			std::vector<char> Arguments, Result;
+		} FunctionCache;
+
 		inline int AsInteger(int index = 0) { return *AsIntegerPtr(index); }
 		inline bool AsBoolean(int index = 0) { return *AsBooleanPtr(index); }
 		inline float AsFloat(int col = 0, int row = 0) { return *AsFloatPtr(col, row); }
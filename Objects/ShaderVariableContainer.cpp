@@ -1,15 +1,130 @@
 #include "ShaderVariableContainer.h"
 #include "FunctionVariableManager.h"
 #include "SystemVariableManager.h"
+#include "UniformRing.h"
 #include <iostream>
-#include <regex>
+#include <algorithm>
 
 namespace ed
 {
-	ShaderVariableContainer::ShaderVariableContainer() { }
+	static bool isSamplerType(GLenum type)
+	{
+		switch (type) {
+		case GL_SAMPLER_1D: case GL_SAMPLER_2D: case GL_SAMPLER_3D: case GL_SAMPLER_CUBE:
+		case GL_SAMPLER_1D_SHADOW: case GL_SAMPLER_2D_SHADOW: case GL_SAMPLER_1D_ARRAY: case GL_SAMPLER_2D_ARRAY:
+		case GL_SAMPLER_1D_ARRAY_SHADOW: case GL_SAMPLER_2D_ARRAY_SHADOW: case GL_SAMPLER_2D_MULTISAMPLE: case GL_SAMPLER_2D_MULTISAMPLE_ARRAY:
+		case GL_SAMPLER_CUBE_SHADOW: case GL_SAMPLER_CUBE_MAP_ARRAY: case GL_SAMPLER_CUBE_MAP_ARRAY_SHADOW: case GL_SAMPLER_BUFFER: case GL_SAMPLER_2D_RECT: case GL_SAMPLER_2D_RECT_SHADOW:
+		case GL_INT_SAMPLER_1D: case GL_INT_SAMPLER_2D: case GL_INT_SAMPLER_3D: case GL_INT_SAMPLER_CUBE:
+		case GL_INT_SAMPLER_1D_ARRAY: case GL_INT_SAMPLER_2D_ARRAY: case GL_INT_SAMPLER_2D_MULTISAMPLE: case GL_INT_SAMPLER_2D_MULTISAMPLE_ARRAY:
+		case GL_INT_SAMPLER_CUBE_MAP_ARRAY: case GL_INT_SAMPLER_BUFFER: case GL_INT_SAMPLER_2D_RECT:
+		case GL_UNSIGNED_INT_SAMPLER_1D: case GL_UNSIGNED_INT_SAMPLER_2D: case GL_UNSIGNED_INT_SAMPLER_3D: case GL_UNSIGNED_INT_SAMPLER_CUBE:
+		case GL_UNSIGNED_INT_SAMPLER_1D_ARRAY: case GL_UNSIGNED_INT_SAMPLER_2D_ARRAY: case GL_UNSIGNED_INT_SAMPLER_2D_MULTISAMPLE: case GL_UNSIGNED_INT_SAMPLER_2D_MULTISAMPLE_ARRAY:
+		case GL_UNSIGNED_INT_SAMPLER_CUBE_MAP_ARRAY: case GL_UNSIGNED_INT_SAMPLER_BUFFER: case GL_UNSIGNED_INT_SAMPLER_2D_RECT:
+			return true;
+		}
+		return false;
+	}
+	static bool isSamplerKeyword(const std::string& word)
+	{
+		size_t start = (word[0] == 'i' || word[0] == 'u') ? 1 : 0;
+		return word.size() > start + 7 && word.compare(start, 7, "sampler") == 0;
+	}
+	static bool isIdentifierChar(char c)
+	{
+		return isalnum((unsigned char)c) || c == '_';
+	}
+
+	// names of the global sampler declarations in the order they are written - comments, preprocessor
+	// lines & function parameters are skipped and "uniform sampler2D a, b[2];" declares both a & b
+	static void scanSamplers(const std::string& src, std::vector<std::string>& out)
+	{
+		int braces = 0, parens = 0;
+		bool inDecl = false, expectName = false;
+		int brackets = 0; // skips the array sizes in the declaration
+		bool lineStart = true;
+
+		for (size_t i = 0; i < src.size();) {
+			char c = src[i];
+
+			// comments & preprocessor directives
+			if (c == '/' && i + 1 < src.size() && src[i + 1] == '/') {
+				i = src.find('\n', i);
+				if (i == std::string::npos) break;
+				continue;
+			} else if (c == '/' && i + 1 < src.size() && src[i + 1] == '*') {
+				i = src.find("*/", i + 2);
+				if (i == std::string::npos) break;
+				i += 2;
+				continue;
+			} else if (c == '#' && lineStart) {
+				// continue past the escaped line breaks
+				while (i < src.size() && (src[i] != '\n' || src[i - 1] == '\\'))
+					i++;
+				continue;
+			}
+
+			if (c == '\n')
+				lineStart = true;
+			else if (!isspace((unsigned char)c))
+				lineStart = false;
+
+			if (isIdentifierChar(c)) {
+				size_t end = i;
+				while (end < src.size() && isIdentifierChar(src[end]))
+					end++;
+				std::string word = src.substr(i, end - i);
+				i = end;
+
+				if (braces != 0 || parens != 0 || isdigit((unsigned char)word[0]))
+					continue;
+
+				if (inDecl && expectName && brackets == 0) {
+					if (std::find(out.begin(), out.end(), word) == out.end())
+						out.push_back(word);
+					expectName = false;
+				} else if (!inDecl && isSamplerKeyword(word)) {
+					inDecl = true;
+					expectName = true;
+				}
+				continue;
+			}
+
+			switch (c) {
+			case '{': braces++; break;
+			case '}': braces = std::max(braces - 1, 0); break;
+			case '(':
+				parens++;
+				inDecl = false; // a function that takes or returns a sampler
+				break;
+			case ')': parens = std::max(parens - 1, 0); break;
+			case '[':
+				if (inDecl) brackets++;
+				break;
+			case ']':
+				if (inDecl) brackets = std::max(brackets - 1, 0);
+				break;
+			case ',':
+				if (inDecl && brackets == 0) expectName = true;
+				break;
+			case ';': inDecl = false; brackets = 0; break;
+			}
+			i++;
+		}
+	}
+
+	ShaderVariableContainer::ShaderVariableContainer()
+	{
+		m_locsDirty = true;
+		m_program = 0;
+		m_samplerProgram = 0;
+		m_debugColorLoc = -1;
+	}
 	ShaderVariableContainer::~ShaderVariableContainer()
 	{
+		m_releaseBlocks();
+
 		for (int i = 0; i < m_vars.size(); i++) {
+			FunctionVariableManager::RemoveFromList(m_vars[i]);
 			free(m_vars[i]->Data);
 			if (m_vars[i]->Arguments != nullptr)
 				free(m_vars[i]->Arguments);
@@ -21,103 +136,339 @@ namespace ed
 	{
 		ShaderVariable* n = new ShaderVariable(var);
 		m_vars.push_back(n);
+		m_locsDirty = true;
 	}
 	void ShaderVariableContainer::Remove(const char* name)
 	{
 		for (int i = 0; i < m_vars.size(); i++)
 			if (strcmp(m_vars[i]->Name, name) == 0) {
+				FunctionVariableManager::RemoveFromList(m_vars[i]);
 				free(m_vars[i]->Data);
 				if (m_vars[i]->Arguments != nullptr)
 					free(m_vars[i]->Arguments);
 				m_vars[i]->Arguments = nullptr;
 				delete m_vars[i];
 				m_vars.erase(m_vars.begin() + i);
+				m_locsDirty = true;
 				break;
 			}
 	}
 	void ShaderVariableContainer::UpdateUniformInfo(GLuint pass)
 	{
-		GLint count;
-
-		const GLsizei bufSize = 64; // maximum name length
+		const GLsizei bufSize = 256; // maximum name length
 		GLchar name[bufSize]; // variable name in GLSL
 		GLsizei length; // name length
-		GLuint samplerLoc = 0;
 
-		glGetProgramiv(pass, GL_ACTIVE_UNIFORMS, &count);
+		m_uniforms.clear();
+		m_samplerRecord.clear();
+		m_releaseBlocks();
+		m_program = pass;
+
+		// one query per resource instead of one per property
+		bool interfaceQuery = GLEW_VERSION_4_3 || GLEW_ARB_program_interface_query;
+
+		// blocks get the binding points below the one that RenderEngine uses for the system block
+		static GLint maxBindings = 0;
+		if (maxBindings == 0)
+			glGetIntegerv(GL_MAX_UNIFORM_BUFFER_BINDINGS, &maxBindings);
+
+		GLint blockCount = 0;
+		if (interfaceQuery)
+			glGetProgramInterfaceiv(pass, GL_UNIFORM_BLOCK, GL_ACTIVE_RESOURCES, &blockCount);
+		else
+			glGetProgramiv(pass, GL_ACTIVE_UNIFORM_BLOCKS, &blockCount);
+		for (GLint i = 0; i < blockCount; i++) {
+			UniformBlock block;
+			block.Size = block.Members = 0;
+			length = 0;
+			if (interfaceQuery) {
+				// the indices of the GL_UNIFORM_BLOCK resources are the uniform block indices
+				const GLenum props[] = { GL_BUFFER_DATA_SIZE, GL_NUM_ACTIVE_VARIABLES };
+				GLint values[2] = { 0, 0 };
+				glGetProgramResourceiv(pass, GL_UNIFORM_BLOCK, i, 2, props, 2, nullptr, values);
+				glGetProgramResourceName(pass, GL_UNIFORM_BLOCK, i, bufSize, &length, name);
+				block.Size = values[0];
+				block.Members = values[1];
+			} else {
+				glGetActiveUniformBlockName(pass, i, bufSize, &length, name);
+				glGetActiveUniformBlockiv(pass, i, GL_UNIFORM_BLOCK_DATA_SIZE, &block.Size);
+				glGetActiveUniformBlockiv(pass, i, GL_UNIFORM_BLOCK_ACTIVE_UNIFORMS, &block.Members);
+			}
+
+			block.Name = std::string(name, length);
+			block.Index = i;
+			block.Binding = std::max<GLint>(maxBindings - 2 - i, 0);
+			block.Used = false;
+			block.Buffer = 0;
+			block.Valid = block.Changed = false;
+			block.InRing = false;
+			block.RingOffset = 0;
+			block.RingChunk = 0;
+			m_blocks.push_back(block);
+		}
+
+		GLint count = 0;
+		std::vector<std::pair<std::string, GLint>> samplers; // in the order the program reports them
+		if (interfaceQuery)
+			glGetProgramInterfaceiv(pass, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+		else
+			glGetProgramiv(pass, GL_ACTIVE_UNIFORMS, &count);
 		for (GLuint i = 0; i < count; i++)
 		{
-			GLint size;
-			GLenum type;
+			GLint type = 0, location = -1, block = -1, offset = 0, matrixStride = 0, rowMajor = 0;
+			length = 0;
+
+			if (interfaceQuery) {
+				const GLenum props[] = { GL_TYPE, GL_LOCATION, GL_BLOCK_INDEX, GL_OFFSET, GL_MATRIX_STRIDE, GL_IS_ROW_MAJOR };
+				GLint values[6] = { 0, -1, -1, 0, 0, 0 };
+				glGetProgramResourceiv(pass, GL_UNIFORM, i, 6, props, 6, nullptr, values);
+				glGetProgramResourceName(pass, GL_UNIFORM, i, bufSize, &length, name);
+
+				type = values[0];
+				location = values[1];
+				block = values[2];
+				offset = values[3];
+				matrixStride = values[4];
+				rowMajor = values[5];
+			} else {
+				GLint size;
+				GLenum glType;
+				glGetActiveUniform(pass, i, bufSize, &length, &size, &glType, name);
+				glGetActiveUniformsiv(pass, 1, &i, GL_UNIFORM_BLOCK_INDEX, &block);
+				if (block >= 0 && block < blockCount) {
+					glGetActiveUniformsiv(pass, 1, &i, GL_UNIFORM_OFFSET, &offset);
+					glGetActiveUniformsiv(pass, 1, &i, GL_UNIFORM_MATRIX_STRIDE, &matrixStride);
+					glGetActiveUniformsiv(pass, 1, &i, GL_UNIFORM_IS_ROW_MAJOR, &rowMajor);
+				} else
+					location = glGetUniformLocation(pass, name);
+				type = glType;
+			}
+
+			UniformInfo info;
+			std::string uName(name, length);
+
+			if (isSamplerType(type)) {
+				// sampler arrays are reported as name[0]
+				if (uName.size() > 3 && uName.compare(uName.size() - 3, 3, "[0]") == 0)
+					uName.resize(uName.size() - 3);
+				m_samplerRecord[uName] = location;
+				samplers.push_back(std::make_pair(uName, location));
+				continue;
+			}
+
+			if (block >= 0 && block < blockCount) {
+				// members of named blocks are reported as Block.member
+				const std::string& prefix = m_blocks[block].Name;
+				if (uName.size() > prefix.size() && uName.compare(0, prefix.size(), prefix) == 0 && uName[prefix.size()] == '.')
+					uName = uName.substr(prefix.size() + 1);
+
+				info.Location = -1;
+				info.Block = block;
+			} else {
+				info.Location = location;
+				info.Block = -1;
+			}
+			info.Offset = offset;
+			info.MatrixStride = matrixStride;
+			info.RowMajor = rowMajor != 0;
+
+			m_uniforms[uName] = info;
+		}
 
-			glGetActiveUniform(pass, (GLuint)i, bufSize, &length, &size, &type, name);
+		m_debugColorLoc = glGetUniformLocation(pass, "_sed_dbg_pixel_color");
+		m_locsDirty = true;
+		m_updateSamplerLocations(pass);
 
-			if (type == GL_SAMPLER_2D)
-				glUniform1i(glGetUniformLocation(pass, name), samplerLoc++);
+		// declared samplers get their own unit, the ones that the source scan didn't see get the units after them
+		GLint nextUnit = m_samplers.size();
+		for (const auto& sampler : samplers) {
+			auto declared = std::find(m_samplers.begin(), m_samplers.end(), sampler.first);
+			if (declared != m_samplers.end())
+				glUniform1i(sampler.second, (GLint)(declared - m_samplers.begin()));
 			else
-				m_uLocs[name] = glGetUniformLocation(pass, name);
+				glUniform1i(sampler.second, nextUnit++);
 		}
 	}
-	void ShaderVariableContainer::UpdateTextureList(const std::string& fragShader)
+	void ShaderVariableContainer::UpdateTextureList(const std::string& fragShader, const std::string& vertShader, const std::string& geomShader)
 	{
 		m_samplers.clear();
 
-		try {
-			std::regex re("[a-z]?sampler.+ .+;");
-			std::sregex_iterator next(fragShader.begin(), fragShader.end(), re);
-			std::sregex_iterator end;
-			while (next != end) {
-				std::smatch match = *next;
-				std::string name = match.str();
-				name = name.substr(name.find_first_of(' ') + 1);
-				name = name.substr(0, name.size() - 1);
-				m_samplers.push_back(name);
-				next++;
-			}
-		}
-		catch (std::regex_error& e) {
-			// Syntax error in the regular expression
-		}
+		scanSamplers(fragShader, m_samplers);
+		scanSamplers(vertShader, m_samplers);
+		scanSamplers(geomShader, m_samplers);
+
+		m_samplerProgram = 0;
 	}
 	void ShaderVariableContainer::UpdateTexture(GLuint pass, GLuint unit)
 	{
 		if (unit >= m_samplers.size())
 			return;
 
-		glUniform1i(glGetUniformLocation(pass, m_samplers[unit].c_str()), unit);
+		if (pass != m_samplerProgram || m_samplerLocs.size() != m_samplers.size())
+			m_updateSamplerLocations(pass);
+
+		glUniform1i(m_samplerLocs[unit], unit);
+	}
+	void ShaderVariableContainer::m_updateSamplerLocations(GLuint pass)
+	{
+		m_samplerProgram = pass;
+		m_samplerLocs.resize(m_samplers.size());
+		for (int i = 0; i < m_samplers.size(); i++) {
+			// inactive samplers aren't in the record
+			if (pass == m_program) {
+				auto rec = m_samplerRecord.find(m_samplers[i]);
+				m_samplerLocs[i] = rec == m_samplerRecord.end() ? -1 : rec->second;
+			} else
+				m_samplerLocs[i] = glGetUniformLocation(pass, m_samplers[i].c_str());
+		}
+	}
+	void ShaderVariableContainer::m_updateVariableLocations()
+	{
+		m_locOwners = m_vars;
+		m_slots.assign(m_vars.size(), Slot());
+
+		std::vector<int> matched(m_blocks.size(), 0);
+		for (int i = 0; i < m_vars.size(); i++) {
+			auto info = m_uniforms.find(m_vars[i]->Name);
+			if (info == m_uniforms.end())
+				continue;
+
+			Slot& slot = m_slots[i];
+			slot.Location = info->second.Location;
+			slot.Block = info->second.Block;
+			slot.Offset = info->second.Offset;
+			slot.MatrixStride = info->second.MatrixStride;
+			slot.RowMajor = info->second.RowMajor;
+
+			if (slot.Block != -1)
+				matched[slot.Block]++;
+		}
+
+		// blocks with members that aren't variables are left to the buffers that the user binds
+		for (int b = 0; b < m_blocks.size(); b++) {
+			UniformBlock& block = m_blocks[b];
+			bool isSystem = block.Name == "SHADERed_Globals" || block.Name == "type_SHADERed_Globals";
+			block.Used = !isSystem && block.Members > 0 && block.Size > 0 && matched[b] >= block.Members;
+			block.Valid = false;
+			block.InRing = false;
+
+			if (block.Used) {
+				block.Arena.assign(block.Size, 0);
+				if (block.Buffer == 0) {
+					glGenBuffers(1, &block.Buffer);
+					glBindBuffer(GL_UNIFORM_BUFFER, block.Buffer);
+					glBufferData(GL_UNIFORM_BUFFER, block.Size, nullptr, GL_DYNAMIC_DRAW);
+					glBindBuffer(GL_UNIFORM_BUFFER, 0);
+				}
+				glUniformBlockBinding(m_program, block.Index, block.Binding);
+			}
+		}
+
+		for (Slot& slot : m_slots)
+			if (slot.Block != -1 && !m_blocks[slot.Block].Used)
+				slot.Block = -1;
+
+		m_locsDirty = false;
+	}
+	void ShaderVariableContainer::m_writeToBlock(Slot& slot, ShaderVariable* var)
+	{
+		UniformBlock& block = m_blocks[slot.Block];
+		char* dst = block.Arena.data() + slot.Offset;
+		ShaderVariable::ValueType type = var->GetType();
+
+		bool isMatrix = type == ShaderVariable::ValueType::Float4x4 || type == ShaderVariable::ValueType::Float3x3 || type == ShaderVariable::ValueType::Float2x2;
+		if (!isMatrix) {
+			int size = ShaderVariable::GetSize(type);
+			if (slot.Offset + size <= block.Size && memcmp(dst, var->Data, size) != 0) {
+				memcpy(dst, var->Data, size);
+				block.Changed = true;
+			}
+			return;
+		}
+
+		// std140 pads the columns (or the rows) of the matrices
+		int cols = var->GetColumnCount();
+		for (int c = 0; c < cols; c++) {
+			for (int r = 0; r < cols; r++) {
+				int offset = slot.RowMajor ? (r * slot.MatrixStride + c * sizeof(float)) : (c * slot.MatrixStride + r * sizeof(float));
+				if (slot.Offset + offset + sizeof(float) > block.Size)
+					continue;
+
+				const char* src = var->Data + (c * cols + r) * sizeof(float);
+				if (memcmp(dst + offset, src, sizeof(float)) != 0) {
+					memcpy(dst + offset, src, sizeof(float));
+					block.Changed = true;
+				}
+			}
+		}
+	}
+	void ShaderVariableContainer::m_releaseBlocks()
+	{
+		for (UniformBlock& block : m_blocks)
+			if (block.Buffer != 0)
+				glDeleteBuffers(1, &block.Buffer);
+		m_blocks.clear();
+		m_locsDirty = true;
 	}
 	void ShaderVariableContainer::Bind(void* item)
 	{
+		if (m_locsDirty || m_locOwners != m_vars)
+			m_updateVariableLocations();
+
 		for (int i = 0; i < m_vars.size(); i++) {
 			FunctionVariableManager::AddToList(m_vars[i]);
 			
-			if (m_uLocs.count(m_vars[i]->Name) == 0)
+			Slot& slot = m_slots[i];
+			GLint loc = slot.Location;
+			if (loc == -1 && slot.Block == -1)
 				continue;
-			
-			GLint loc = m_uLocs[m_vars[i]->Name];
 
 			// update values if needed
 			SystemVariableManager::Instance().Update(m_vars[i], item);
 			FunctionVariableManager::Update(m_vars[i]);
 
-			// update uniform every time we bind this container
-			// TODO: maybe we shouldn't update variables that havent changed
 			ShaderVariable::ValueType type = m_vars[i]->GetType();
+			int size = ShaderVariable::GetSize(type);
 
 			// check the flags
-			if (m_vars[i]->Flags & (char)ShaderVariable::Flag::Inverse) {
-				if (type == ShaderVariable::ValueType::Float4x4) {
-					glm::mat4x4 matVal = glm::make_mat4x4(m_vars[i]->AsFloatPtr());
-					memcpy(m_vars[i]->Data, glm::value_ptr(glm::inverse(matVal)), sizeof(glm::mat4x4));
-				} else if (type == ShaderVariable::ValueType::Float3x3) {
-					glm::mat3x3 matVal = glm::make_mat3x3(m_vars[i]->AsFloatPtr());
-					memcpy(m_vars[i]->Data, glm::value_ptr(glm::inverse(matVal)), sizeof(glm::mat3x3));
-				} else if (type == ShaderVariable::ValueType::Float2x2) {
-					glm::mat2x2 matVal = glm::make_mat2x2(m_vars[i]->AsFloatPtr());
-					memcpy(m_vars[i]->Data, glm::value_ptr(glm::inverse(matVal)), sizeof(glm::mat2x2));
+			bool isMatrix = type == ShaderVariable::ValueType::Float4x4 || type == ShaderVariable::ValueType::Float3x3 || type == ShaderVariable::ValueType::Float2x2;
+			if ((m_vars[i]->Flags & (char)ShaderVariable::Flag::Inverse) && isMatrix) {
+				// reuse the last inverse if the input matrix is the same
+				if (slot.InverseValid && slot.Type == type && memcmp(slot.InverseSource, m_vars[i]->Data, size) == 0)
+					memcpy(m_vars[i]->Data, slot.InverseResult, size);
+				else {
+					memcpy(slot.InverseSource, m_vars[i]->Data, size);
+
+					if (type == ShaderVariable::ValueType::Float4x4) {
+						glm::mat4x4 matVal = glm::make_mat4x4(m_vars[i]->AsFloatPtr());
+						memcpy(m_vars[i]->Data, glm::value_ptr(glm::inverse(matVal)), sizeof(glm::mat4x4));
+					} else if (type == ShaderVariable::ValueType::Float3x3) {
+						glm::mat3x3 matVal = glm::make_mat3x3(m_vars[i]->AsFloatPtr());
+						memcpy(m_vars[i]->Data, glm::value_ptr(glm::inverse(matVal)), sizeof(glm::mat3x3));
+					} else if (type == ShaderVariable::ValueType::Float2x2) {
+						glm::mat2x2 matVal = glm::make_mat2x2(m_vars[i]->AsFloatPtr());
+						memcpy(m_vars[i]->Data, glm::value_ptr(glm::inverse(matVal)), sizeof(glm::mat2x2));
+					}
+
+					memcpy(slot.InverseResult, m_vars[i]->Data, size);
+					slot.InverseValid = true;
 				}
 			}
 
+			if (slot.Block != -1) {
+				slot.Type = type;
+				m_writeToBlock(slot, m_vars[i]);
+				continue;
+			}
+
+			// skip the upload if the program already has this value
+			if (slot.Valid && slot.Type == type && memcmp(slot.Uploaded, m_vars[i]->Data, size) == 0)
+				continue;
+
+			slot.Valid = true;
+			slot.Type = type;
+			memcpy(slot.Uploaded, m_vars[i]->Data, size);
+
 			switch (type) {
 			case ShaderVariable::ValueType::Boolean1:
 			case ShaderVariable::ValueType::Integer1:
@@ -158,6 +509,31 @@ namespace ed
 				break;
 			}
 		}
+
+		// the whole block in one upload - streamed into the ring so that the driver doesn't have to synchronize or
+		// rename the buffer between the draws, unchanged blocks bind the same slice again
+		UniformRing& ring = UniformRing::Instance();
+		for (UniformBlock& block : m_blocks) {
+			if (!block.Used)
+				continue;
+
+			if (block.Changed || !block.Valid || (block.InRing && !ring.IsAlive(block.RingChunk))) {
+				block.InRing = ring.Write(block.Arena.data(), block.Size, block.RingOffset, block.RingChunk);
+				if (!block.InRing) {
+					glBindBuffer(GL_UNIFORM_BUFFER, block.Buffer);
+					glBufferSubData(GL_UNIFORM_BUFFER, 0, block.Size, block.Arena.data());
+					glBindBuffer(GL_UNIFORM_BUFFER, 0);
+				}
+
+				block.Valid = true;
+				block.Changed = false;
+			}
+
+			if (block.InRing)
+				glBindBufferRange(GL_UNIFORM_BUFFER, block.Binding, ring.GetBuffer(), block.RingOffset, block.Size);
+			else
+				glBindBufferBase(GL_UNIFORM_BUFFER, block.Binding, block.Buffer);
+		}
 	}
 	bool ShaderVariableContainer::ContainsVariable(const char* name)
 	{
@@ -1,7 +1,8 @@
 #pragma once
 #include "ShaderVariable.h"
 #include <vector>
-#include <map>
+#include <unordered_map>
+#include <stdint.h>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -21,21 +22,83 @@ namespace ed
 		ShaderVariableContainer();
 		~ShaderVariableContainer();
 
-		inline void Add(ShaderVariable* var) { m_vars.push_back(var); }
+		inline void Add(ShaderVariable* var) { m_vars.push_back(var); m_locsDirty = true; }
 		void AddCopy(ShaderVariable var);
 		void Remove(const char* name);
 
 		bool ContainsVariable(const char* name);
 		void UpdateUniformInfo(GLuint pass);
 		void UpdateTexture(GLuint pass, GLuint unit);
-		void UpdateTextureList(const std::string& fragShader);
+		void UpdateTextureList(const std::string& fragShader, const std::string& vertShader = "", const std::string& geomShader = ""); // units follow the declarations: pixel shader first, then the other stages
 		void Bind(void* item = nullptr);
 		inline std::vector<ShaderVariable*>& GetVariables() { return m_vars; }
 		inline const std::vector<std::string>& GetSamplerList() { return m_samplers; }
 
+		// call this when a variable was renamed
+		inline void InvalidateLocations() { m_locsDirty = true; }
+		inline GLint GetDebugColorLocation() { return m_debugColorLoc; }
+
 	private:
 		std::vector<ShaderVariable*> m_vars;
-		std::map<std::string, GLint> m_uLocs;
 		std::vector<std::string> m_samplers;
+		std::unordered_map<std::string, GLint> m_samplerRecord; // locations of the active samplers of m_program, array samplers without the [0]
+
+		// uniforms of the program, members of uniform blocks are stored without the block name
+		struct UniformInfo
+		{
+			GLint Location;
+			GLint Block; // index into m_blocks, -1 -> default block
+			GLint Offset, MatrixStride;
+			bool RowMajor;
+		};
+		std::unordered_map<std::string, UniformInfo> m_uniforms;
+
+		// uniform blocks whose every member is one of the variables are uploaded as a whole from their std140 image
+		struct UniformBlock
+		{
+			std::string Name;
+			GLuint Index, Binding;
+			GLint Size, Members;
+			bool Used;
+			std::vector<char> Arena;
+			GLuint Buffer;
+			bool Valid, Changed; // Valid -> Buffer (or the ring slice) has the contents of Arena
+
+			// slice of the UniformRing that the last upload went to
+			bool InRing;
+			GLintptr RingOffset;
+			uint64_t RingChunk;
+		};
+		std::vector<UniformBlock> m_blocks;
+		GLuint m_program;
+
+		// everything that Bind needs for one variable - indexed the same way as m_vars, resolved once per program
+		struct Slot
+		{
+			Slot() { Location = Block = -1; Offset = MatrixStride = 0; RowMajor = false; Valid = InverseValid = false; }
+
+			GLint Location;
+			GLint Block, Offset, MatrixStride;
+			bool RowMajor;
+
+			// last value sent to the current program - uniforms are only uploaded when it changes
+			bool Valid, InverseValid;
+			ShaderVariable::ValueType Type;
+			char Uploaded[sizeof(float) * 16];
+			char InverseSource[sizeof(float) * 16];
+			char InverseResult[sizeof(float) * 16];
+		};
+		bool m_locsDirty;
+		std::vector<ShaderVariable*> m_locOwners;
+		std::vector<Slot> m_slots;
+		void m_updateVariableLocations();
+		void m_writeToBlock(Slot& slot, ShaderVariable* var);
+		void m_releaseBlocks();
+
+		GLuint m_samplerProgram;
+		std::vector<GLint> m_samplerLocs;
+		void m_updateSamplerLocations(GLuint pass);
+
+		GLint m_debugColorLoc;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,62 @@
+#include "StartupTimeline.h"
+#include "Logger.h"
+
+#include <stdio.h>
+
+namespace ed
+{
+	StartupTimeline::StartupTimeline()
+	{
+		m_start = std::chrono::steady_clock::now();
+		m_last = m_total = 0.0f;
+		m_finished = false;
+	}
+	void StartupTimeline::Mark(const std::string& name)
+	{
+		float now = m_now();
+
+		Phase phase;
+		phase.Name = name;
+		phase.Start = m_last;
+		phase.Duration = now - m_last;
+		phase.Background = m_finished;
+		m_phases.push_back(phase);
+
+		m_last = now;
+	}
+	void StartupTimeline::MarkBackground(const std::string& name)
+	{
+		Phase phase;
+		phase.Name = name;
+		phase.Start = 0.0f;
+		phase.Duration = m_now();
+		phase.Background = true;
+		m_phases.push_back(phase);
+
+		if (m_finished) {
+			char buffer[64];
+			snprintf(buffer, 64, "%.1f ms", phase.Duration);
+			Logger::Get().Log("Startup: " + name + " finished after " + buffer);
+		}
+	}
+	void StartupTimeline::Finish()
+	{
+		if (m_finished)
+			return;
+
+		m_total = m_now();
+		m_finished = true;
+
+		char buffer[64];
+		snprintf(buffer, 64, "%.1f ms", m_total);
+		Logger::Get().Log("Startup: first frame after " + std::string(buffer));
+		for (const Phase& phase : m_phases) {
+			snprintf(buffer, 64, "%.1f ms", phase.Duration);
+			Logger::Get().Log("Startup: " + phase.Name + (phase.Background ? " finished after " : " - ") + buffer);
+		}
+	}
+	float StartupTimeline::m_now()
+	{
+		return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - m_start).count();
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <chrono>
+
+namespace ed
+{
+	// steps between the start of main() and the first frame on the screen - work that goes on in the background
+	// after that (shader compilation, glslang...) is added to the same timeline once it's done
+	// everything is called from the main thread
+	class StartupTimeline
+	{
+	public:
+		static inline StartupTimeline& Instance()
+		{
+			static StartupTimeline ret;
+			return ret;
+		}
+
+		struct Phase
+		{
+			std::string Name;
+			float Start;	 // milliseconds since the start
+			float Duration;	 // milliseconds
+			bool Background; // finished after the first frame
+		};
+
+		StartupTimeline();
+
+		void Mark(const std::string& name);			  // ends the step that started with the previous Mark()
+		void MarkBackground(const std::string& name); // finished now, measured from the start - logged right away after Finish()
+		void Finish();								  // the first frame was presented, logs the timeline
+
+		inline bool IsFinished() { return m_finished; }
+		inline float GetTotal() { return m_finished ? m_total : m_now(); } // time until the first frame
+		inline const std::vector<Phase>& GetPhases() { return m_phases; }
+
+	private:
+		float m_now();
+
+		std::chrono::steady_clock::time_point m_start;
+		float m_last, m_total;
+		bool m_finished;
+		std::vector<Phase> m_phases;
+	};
+}
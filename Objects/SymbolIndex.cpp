@@ -0,0 +1,359 @@
+#include "SymbolIndex.h"
+#include "IncludeCache.h"
+#include "Hash.h"
+
+#include <algorithm>
+#include <ctype.h>
+
+#define SYMBOL_DECLARATION_LENGTH 256 // longer declarations are cut in the tooltips
+
+namespace ed
+{
+	static bool isIdentChar(char c)
+	{
+		return isalnum((unsigned char)c) || c == '_';
+	}
+	static std::vector<std::string> getWords(const std::string& str)
+	{
+		std::vector<std::string> ret;
+		for (size_t i = 0; i < str.size();) {
+			if (!isIdentChar(str[i])) {
+				i++;
+				continue;
+			}
+			size_t end = i;
+			while (end < str.size() && isIdentChar(str[end]))
+				end++;
+			if (!isdigit((unsigned char)str[i]))
+				ret.push_back(str.substr(i, end - i));
+			i = end;
+		}
+		return ret;
+	}
+	static std::string collapse(const std::string& str)
+	{
+		std::string ret;
+		for (char c : str) {
+			if (isspace((unsigned char)c)) {
+				if (!ret.empty() && ret.back() != ' ')
+					ret += ' ';
+			} else
+				ret += c;
+		}
+		while (!ret.empty() && ret.back() == ' ')
+			ret.pop_back();
+		if (ret.size() > SYMBOL_DECLARATION_LENGTH)
+			ret = ret.substr(0, SYMBOL_DECLARATION_LENGTH) + "...";
+		return ret;
+	}
+	// removes the leading layout(...) and [attribute(...)] parts of a statement
+	static std::string stripQualifiers(const std::string& stmt)
+	{
+		size_t start = 0;
+		while (true) {
+			while (start < stmt.size() && isspace((unsigned char)stmt[start]))
+				start++;
+
+			char close = 0;
+			size_t open = std::string::npos;
+			if (stmt.compare(start, 6, "layout") == 0) {
+				open = stmt.find('(', start);
+				close = ')';
+			} else if (start < stmt.size() && stmt[start] == '[') {
+				open = start;
+				close = ']';
+			}
+			if (open == std::string::npos)
+				break;
+
+			// matching bracket
+			int depth = 0;
+			size_t i = open;
+			for (; i < stmt.size(); i++) {
+				if (stmt[i] == stmt[open]) depth++;
+				else if (stmt[i] == close && --depth == 0) break;
+			}
+			if (i >= stmt.size())
+				break;
+			start = i + 1;
+		}
+		return stmt.substr(start);
+	}
+	static bool hasWord(const std::vector<std::string>& words, const char* word)
+	{
+		return std::find(words.begin(), words.end(), word) != words.end();
+	}
+	// int foo(float a, float b) [: SEMANTIC] -> name & the declaration without the semantic
+	static bool parseFunction(const std::string& stmt, std::string& name, std::string& decl)
+	{
+		size_t paren = stmt.find('(');
+		size_t close = stmt.rfind(')');
+		if (paren == std::string::npos || close == std::string::npos || close < paren)
+			return false;
+
+		size_t end = paren;
+		while (end > 0 && isspace((unsigned char)stmt[end - 1]))
+			end--;
+		size_t start = end;
+		while (start > 0 && isIdentChar(stmt[start - 1]))
+			start--;
+		if (start == end || start == 0) // no return type
+			return false;
+
+		name = stmt.substr(start, end - start);
+		if (name == "if" || name == "for" || name == "while" || name == "switch" || name == "return")
+			return false;
+
+		decl = collapse(stmt.substr(0, close + 1));
+		return true;
+	}
+	// names declared by "type a, b[2] = ..., c : register(t0)"
+	static void parseVariables(const std::string& stmt, std::vector<std::string>& names)
+	{
+		std::vector<std::string> parts(1);
+		int depth = 0;
+		for (char c : stmt) {
+			if (c == '(' || c == '[' || c == '{') depth++;
+			else if (c == ')' || c == ']' || c == '}') depth--;
+			else if (c == ',' && depth == 0) {
+				parts.push_back("");
+				continue;
+			}
+			parts.back() += c;
+		}
+
+		for (const std::string& part : parts) {
+			std::string decl = part.substr(0, part.find_first_of("=:["));
+			std::vector<std::string> words = getWords(decl);
+			if (!words.empty())
+				names.push_back(words.back());
+		}
+	}
+
+	SymbolIndex::SymbolIndex()
+	{
+		m_exit = false;
+		m_thread = new std::thread(&SymbolIndex::m_run, this);
+	}
+	SymbolIndex::~SymbolIndex()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_exit = true;
+		}
+		m_signal.notify_one();
+
+		m_thread->join();
+		delete m_thread;
+	}
+	void SymbolIndex::SetContent(const std::string& file, const std::string& content)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_contents[file] = content;
+			m_queued.insert(file);
+		}
+		m_signal.notify_one();
+	}
+	void SymbolIndex::ClearContent(const std::string& file)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_contents.erase(file) == 0)
+				return;
+			m_queued.insert(file);
+		}
+		m_signal.notify_one();
+	}
+	uint64_t SymbolIndex::Get(const std::vector<std::string>& files, std::vector<Symbol>* out)
+	{
+		uint64_t key = HashString(std::to_string(files.size()));
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			for (const std::string& file : files) {
+				m_queued.insert(file);
+
+				auto it = m_files.find(file);
+				unsigned int revision = it == m_files.end() ? 0 : it->second.Revision;
+				key = HashString(file + ";" + std::to_string(revision), key);
+
+				if (out != nullptr && it != m_files.end())
+					out->insert(out->end(), it->second.Symbols.begin(), it->second.Symbols.end());
+			}
+		}
+		m_signal.notify_one();
+
+		return key;
+	}
+	void SymbolIndex::m_run()
+	{
+		while (true) {
+			std::unordered_set<std::string> files;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_signal.wait(lock, [&]() { return m_exit || !m_queued.empty(); });
+				if (m_exit)
+					break;
+				files.swap(m_queued);
+			}
+
+			for (const std::string& file : files) {
+				std::string content;
+				uint64_t hash = 0;
+				bool found = false;
+
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					auto edited = m_contents.find(file);
+					if (edited != m_contents.end()) {
+						content = edited->second;
+						found = true;
+					}
+				}
+
+				// the cache only reads the file again if it changed
+				if (found)
+					hash = HashString(content);
+				else if (!IncludeCache::Instance().Get(file, content, &hash))
+					content.clear();
+
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					auto it = m_files.find(file);
+					if (it != m_files.end() && it->second.Hash == hash)
+						continue;
+				}
+
+				std::vector<Symbol> symbols;
+				Parse(content, symbols);
+
+				std::lock_guard<std::mutex> lock(m_mutex);
+				File& entry = m_files[file];
+				entry.Hash = hash;
+				entry.Revision++;
+				entry.Symbols.swap(symbols);
+			}
+		}
+	}
+	void SymbolIndex::Parse(const std::string& code, std::vector<Symbol>& out)
+	{
+		int depth = 0, line = 1, stmtLine = 1;
+		bool lineStart = true;
+		bool memberBlock = false; // inside a cbuffer or a uniform block
+		std::string stmt;
+
+		auto add = [&](const std::string& name, const std::string& decl, Kind type, int atLine) {
+			Symbol sym;
+			sym.Name = name;
+			sym.Declaration = decl;
+			sym.Type = type;
+			sym.Line = atLine;
+			out.push_back(sym);
+		};
+		auto addVariables = [&](const std::string& text, int atLine) {
+			std::vector<std::string> names;
+			parseVariables(text, names);
+			std::string decl = collapse(text);
+			for (const std::string& name : names)
+				add(name, decl, Kind::Uniform, atLine);
+		};
+
+		for (size_t i = 0; i < code.size(); i++) {
+			char c = code[i];
+
+			// comments
+			if (c == '/' && i + 1 < code.size() && code[i + 1] == '/') {
+				while (i + 1 < code.size() && code[i + 1] != '\n')
+					i++;
+				continue;
+			} else if (c == '/' && i + 1 < code.size() && code[i + 1] == '*') {
+				i += 2;
+				while (i + 1 < code.size() && !(code[i] == '*' && code[i + 1] == '/')) {
+					if (code[i] == '\n') line++;
+					i++;
+				}
+				i++;
+				continue;
+			}
+
+			// preprocessor
+			if (c == '#' && lineStart) {
+				std::string directive;
+				int atLine = line;
+				for (; i < code.size() && code[i] != '\n'; i++) {
+					if (code[i] == '\\' && i + 1 < code.size() && code[i + 1] == '\n') {
+						i++;
+						line++;
+						directive += ' ';
+						continue;
+					}
+					directive += code[i];
+				}
+				line++;
+
+				std::vector<std::string> words = getWords(directive);
+				if (words.size() >= 2 && words[0] == "define")
+					add(words[1], collapse(directive), Kind::Macro, atLine);
+				continue;
+			}
+
+			if (c == '\n') {
+				line++;
+				lineStart = true;
+			} else if (!isspace((unsigned char)c))
+				lineStart = false;
+
+			bool collecting = depth == 0 || (depth == 1 && memberBlock);
+
+			if (c == '{') {
+				if (depth == 0) {
+					std::string decl = stripQualifiers(stmt);
+					std::vector<std::string> words = getWords(decl);
+					std::string name, funcDecl;
+
+					if (words.size() >= 2 && words[0] == "struct")
+						add(words[1], "struct " + words[1], Kind::Struct, stmtLine);
+					else if (hasWord(words, "cbuffer") || hasWord(words, "tbuffer") || (!words.empty() && words[0] == "uniform"))
+						memberBlock = true;
+					else if (parseFunction(decl, name, funcDecl))
+						add(name, funcDecl, Kind::Function, stmtLine);
+				}
+				depth++;
+				stmt.clear();
+			} else if (c == '}') {
+				depth = std::max(depth - 1, 0);
+				if (depth == 0)
+					memberBlock = false;
+				stmt.clear();
+			} else if (c == ';') {
+				if (depth == 0) {
+					std::string decl = stripQualifiers(stmt);
+					std::vector<std::string> words = getWords(decl);
+					std::string name, funcDecl;
+
+					// globals without a storage qualifier are uniforms in HLSL
+					bool isStorage = hasWord(words, "in") || hasWord(words, "out") || hasWord(words, "static") || hasWord(words, "const") ||
+						hasWord(words, "shared") || hasWord(words, "groupshared") || hasWord(words, "varying") || hasWord(words, "attribute") ||
+						hasWord(words, "buffer") || hasWord(words, "precision") || hasWord(words, "typedef") || hasWord(words, "struct");
+
+					// "Texture2D tex : register(t0)" isn't a prototype
+					size_t paren = decl.find('('), colon = decl.find(':');
+					if (paren != std::string::npos && (colon == std::string::npos || colon > paren)) {
+						if (parseFunction(decl, name, funcDecl))
+							add(name, funcDecl, Kind::Function, stmtLine);
+					} else if (hasWord(words, "uniform") || (!isStorage && words.size() >= 2))
+						addVariables(decl, stmtLine);
+				} else if (depth == 1 && memberBlock)
+					addVariables(stripQualifiers(stmt), stmtLine);
+				stmt.clear();
+			} else if (collecting) {
+				if (stmt.empty() && isspace((unsigned char)c))
+					continue;
+				if (stmt.empty())
+					stmtLine = line;
+				stmt += c;
+			}
+		}
+	}
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <stdint.h>
+#include <condition_variable>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace ed
+{
+	// functions, structs, uniforms & macros declared in the shader files of the project - the files are
+	// parsed by a worker, the editors ask for the symbols of the files that their shader includes
+	class SymbolIndex
+	{
+	public:
+		enum class Kind
+		{
+			Function,
+			Struct,
+			Uniform,
+			Macro
+		};
+		struct Symbol
+		{
+			std::string Name;
+			std::string Declaration; // shown in the tooltips
+			Kind Type;
+			int Line;
+		};
+
+		SymbolIndex();
+		~SymbolIndex();
+
+		// contents of an editor that wasn't saved yet, used instead of the file on the disk
+		void SetContent(const std::string& file, const std::string& content);
+		void ClearContent(const std::string& file);
+
+		// a key that changes whenever the symbols of one of the files change - files that aren't indexed yet
+		// (or that could have changed on the disk) are queued, out gets whatever is already known
+		uint64_t Get(const std::vector<std::string>& files, std::vector<Symbol>* out = nullptr);
+
+		static void Parse(const std::string& code, std::vector<Symbol>& out);
+
+	private:
+		void m_run();
+
+		struct File
+		{
+			File() : Hash(0), Revision(0) {}
+
+			uint64_t Hash; // of the parsed text
+			unsigned int Revision;
+			std::vector<Symbol> Symbols;
+		};
+
+		std::thread* m_thread;
+		std::mutex m_mutex;
+		std::condition_variable m_signal;
+		bool m_exit;
+		std::unordered_set<std::string> m_queued;
+		std::unordered_map<std::string, std::string> m_contents;
+		std::unordered_map<std::string, File> m_files;
+	};
+}
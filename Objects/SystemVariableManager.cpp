@@ -1,20 +1,113 @@
 #include "SystemVariableManager.h"
+#include "PluginAPI/PluginProfiler.h"
 #include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
 
 namespace ed
 {
+	// the eyes move by half of the separation along the camera's x axis & their frustums are sheared so that the points
+	// StereoConvergence in front of the camera land on the same pixel in both views
+	static glm::mat4 getEyeView(const glm::mat4& view, int eye)
+	{
+		float offset = Settings::Instance().Project.EyeSeparation * 0.5f;
+		return glm::translate(glm::mat4(1.0f), glm::vec3(eye == 0 ? offset : -offset, 0.0f, 0.0f)) * view;
+	}
+	static glm::mat4 getEyeProjection(const glm::mat4& proj, int eye)
+	{
+		float convergence = std::max(Settings::Instance().Project.StereoConvergence, 0.001f);
+		float shift = proj[0][0] * Settings::Instance().Project.EyeSeparation * 0.5f / convergence;
+		return glm::translate(glm::mat4(1.0f), glm::vec3(eye == 0 ? -shift : shift, 0.0f, 0.0f)) * proj;
+	}
+
 	void SystemVariableManager::Reset()
 	{
 		m_timer.Restart();
 		m_curState.FrameIndex = 0;
-		m_curGeoTransform.clear();
-		m_prevGeoTransform.clear();
+		m_geoTransform.clear();
 		m_advTimer = 0;
 	}
+	void SystemVariableManager::SetPluginBlock(IPlugin* plugin, const char* data, int size)
+	{
+		PluginBlock& block = m_pluginBlocks[plugin];
+		block.Data = data;
+		block.Size = size;
+	}
+	void SystemVariableManager::m_updatePluginVariable(ShaderVariable* var, bool isLastFrame)
+	{
+		PluginSystemVariableData* pvData = &var->PluginSystemVarData;
+		plugin::VariableType type = (plugin::VariableType)var->GetType();
+
+		// values from the block that the plugin filled at the start of the frame
+		auto block = m_pluginBlocks.find(pvData->Owner);
+		if (block != m_pluginBlocks.end()) {
+			int& offset = pvData->Offset[isLastFrame];
+			if (offset == -2) {
+				offset = static_cast<IPlugin3*>(pvData->Owner)->GetSystemVariableOffset(pvData->Name, type, isLastFrame);
+				if (offset < 0 || offset + ShaderVariable::GetSize(var->GetType()) > block->second.Size)
+					offset = -1;
+			}
+			if (offset >= 0) {
+				memcpy(var->Data, block->second.Data + offset, ShaderVariable::GetSize(var->GetType()));
+				return;
+			}
+		}
+
+		PluginProfiler::Scope profile(pvData->Owner, PluginProfiler::SystemVariable);
+		pvData->Owner->UpdateSystemVariableValue(var->Data, pvData->Name, type, isLastFrame);
+	}
 	void SystemVariableManager::CopyState()
 	{
 		memcpy(&m_prevState, &m_curState, sizeof(m_curState));
-		m_prevGeoTransform = m_curGeoTransform;
+
+		// transforms keep their current matrix as the previous one lazily, on their next update
+		m_generation++;
+	}
+	glm::mat4 SystemVariableManager::GetViewProjectionMatrix()
+	{
+		glm::mat4 view = GetViewMatrix();
+		if (view != m_viewProjKey || m_curState.Viewport != m_viewProjViewport) {
+			m_viewProj = GetProjectionMatrix() * view;
+			m_viewProjKey = view;
+			m_viewProjViewport = m_curState.Viewport;
+		}
+		return m_viewProj;
+	}
+	glm::mat4 SystemVariableManager::GetViewOrthographicMatrix()
+	{
+		glm::mat4 view = GetViewMatrix();
+		if (view != m_viewOrthoKey || m_curState.Viewport != m_viewOrthoViewport) {
+			m_viewOrtho = GetOrthographicMatrix() * view;
+			m_viewOrthoKey = view;
+			m_viewOrthoViewport = m_curState.Viewport;
+		}
+		return m_viewOrtho;
+	}
+	glm::mat4 SystemVariableManager::GetEyeViewMatrix(int eye)
+	{
+		return getEyeView(GetViewMatrix(), eye);
+	}
+	glm::mat4 SystemVariableManager::GetEyeProjectionMatrix(int eye)
+	{
+		return getEyeProjection(GetProjectionMatrix(), eye);
+	}
+	void SystemVariableManager::m_updateProjection()
+	{
+		if (m_curState.Viewport == m_projViewport)
+			return;
+
+		glm::vec2 size = GetViewportSize();
+		m_proj = glm::perspective(glm::radians(45.0f), size.x / size.y, 0.1f, 1000.0f);
+		m_ortho = glm::ortho(0.0f, size.x, size.y, 0.0f, 0.1f, 1000.0f);
+		m_projViewport = m_curState.Viewport;
+
+		// the tile's part of the clip space is stretched over the whole render target
+		glm::vec4 tile = GetTile();
+		if (tile != glm::vec4(0, 0, 1, 1)) {
+			glm::mat4 crop = glm::translate(glm::mat4(1.0f), glm::vec3((1.0f - 2.0f * tile.x - tile.z) / tile.z, (1.0f - 2.0f * tile.y - tile.w) / tile.w, 0.0f)) *
+				glm::scale(glm::mat4(1.0f), glm::vec3(1.0f / tile.z, 1.0f / tile.w, 1.0f));
+			m_proj = crop * m_proj;
+			m_ortho = crop * m_ortho;
+		}
 	}
 	void SystemVariableManager::Update(ed::ShaderVariable* var, void* item)
 	{
@@ -49,6 +142,22 @@ namespace ed
 						rawMatrix = SystemVariableManager::Instance().GetGeometryTransform((PipelineItem*)item);
 						memcpy(var->Data, glm::value_ptr(rawMatrix), sizeof(glm::mat4));
 						break;
+					case ed::SystemShaderVariable::ViewLeft:
+					case ed::SystemShaderVariable::ViewRight:
+						rawMatrix = GetEyeViewMatrix(var->System == ed::SystemShaderVariable::ViewRight);
+						memcpy(var->Data, glm::value_ptr(rawMatrix), sizeof(glm::mat4));
+						break;
+					case ed::SystemShaderVariable::ProjectionLeft:
+					case ed::SystemShaderVariable::ProjectionRight:
+						rawMatrix = GetEyeProjectionMatrix(var->System == ed::SystemShaderVariable::ProjectionRight);
+						memcpy(var->Data, glm::value_ptr(rawMatrix), sizeof(glm::mat4));
+						break;
+					case ed::SystemShaderVariable::ViewProjectionLeft:
+					case ed::SystemShaderVariable::ViewProjectionRight: {
+						int eye = var->System == ed::SystemShaderVariable::ViewProjectionRight;
+						rawMatrix = GetEyeProjectionMatrix(eye) * GetEyeViewMatrix(eye);
+						memcpy(var->Data, glm::value_ptr(rawMatrix), sizeof(glm::mat4));
+					} break;
 					case ed::SystemShaderVariable::ViewportSize:
 					{
 						glm::vec2 raw = SystemVariableManager::Instance().GetViewportSize();
@@ -84,6 +193,21 @@ namespace ed
 						unsigned int frame = SystemVariableManager::Instance().GetFrameIndex();
 						memcpy(var->Data, &frame, sizeof(unsigned int));
 					} break;
+					case ed::SystemShaderVariable::IterationIndex:
+					{
+						unsigned int iteration = SystemVariableManager::Instance().GetIterationIndex();
+						memcpy(var->Data, &iteration, sizeof(unsigned int));
+					} break;
+					case ed::SystemShaderVariable::SampleIndex:
+					{
+						unsigned int sample = SystemVariableManager::Instance().GetSampleIndex();
+						memcpy(var->Data, &sample, sizeof(unsigned int));
+					} break;
+					case ed::SystemShaderVariable::AudioPosition:
+					{
+						glm::vec4 raw = SystemVariableManager::Instance().GetAudioPosition();
+						memcpy(var->Data, glm::value_ptr(raw), sizeof(glm::vec4));
+					} break;
 					case ed::SystemShaderVariable::IsPicked:
 					{
 						bool raw = SystemVariableManager::Instance().IsPicked();
@@ -110,10 +234,8 @@ namespace ed
 						memcpy(var->Data, glm::value_ptr(raw), sizeof(glm::ivec4));
 					} break;
 					case ed::SystemShaderVariable::PluginVariable:
-					{
-						PluginSystemVariableData* pvData = &var->PluginSystemVarData;
-						pvData->Owner->UpdateSystemVariableValue(var->Data, pvData->Name, (plugin::VariableType)var->GetType(), isLastFrame);
-					} break;
+						m_updatePluginVariable(var, isLastFrame);
+						break;
 				}
 			} else {
 				glm::mat4 rawMatrix;
@@ -143,10 +265,29 @@ namespace ed
 						rawMatrix = ortho * view;
 						memcpy(var->Data, glm::value_ptr(rawMatrix), sizeof(glm::mat4));
 					} break;
-					case ed::SystemShaderVariable::GeometryTransform:
-						rawMatrix = m_prevGeoTransform[(PipelineItem*)item];
+					case ed::SystemShaderVariable::GeometryTransform: {
+						const TransformCache& trans = m_geoTransform[(PipelineItem*)item];
+						rawMatrix = trans.Generation == m_generation ? trans.Previous : trans.Current;
 						memcpy(var->Data, glm::value_ptr(rawMatrix), sizeof(glm::mat4));
-						break;
+					} break;
+					case ed::SystemShaderVariable::ViewLeft:
+					case ed::SystemShaderVariable::ViewRight:
+					case ed::SystemShaderVariable::ProjectionLeft:
+					case ed::SystemShaderVariable::ProjectionRight:
+					case ed::SystemShaderVariable::ViewProjectionLeft:
+					case ed::SystemShaderVariable::ViewProjectionRight: {
+						int eye = var->System == ed::SystemShaderVariable::ViewRight || var->System == ed::SystemShaderVariable::ProjectionRight || var->System == ed::SystemShaderVariable::ViewProjectionRight;
+						glm::mat4 view = getEyeView(Settings::Instance().Project.FPCamera ? m_prevState.FPCam.GetMatrix() : m_prevState.ArcCam.GetMatrix(), eye);
+						glm::mat4 persp = getEyeProjection(glm::perspective(glm::radians(45.0f), m_prevState.Viewport.x / m_prevState.Viewport.y, 0.1f, 1000.0f), eye);
+
+						if (var->System == ed::SystemShaderVariable::ViewLeft || var->System == ed::SystemShaderVariable::ViewRight)
+							rawMatrix = view;
+						else if (var->System == ed::SystemShaderVariable::ProjectionLeft || var->System == ed::SystemShaderVariable::ProjectionRight)
+							rawMatrix = persp;
+						else
+							rawMatrix = persp * view;
+						memcpy(var->Data, glm::value_ptr(rawMatrix), sizeof(glm::mat4));
+					} break;
 					case ed::SystemShaderVariable::ViewportSize:
 					{
 						glm::vec2 raw = m_prevState.Viewport;
@@ -182,6 +323,23 @@ namespace ed
 						unsigned int frame = m_prevState.FrameIndex;
 						memcpy(var->Data, &frame, sizeof(unsigned int));
 					} break;
+					case ed::SystemShaderVariable::IterationIndex:
+					{
+						// iterations don't have a "last frame" value
+						unsigned int iteration = m_curState.IterationIndex;
+						memcpy(var->Data, &iteration, sizeof(unsigned int));
+					} break;
+					case ed::SystemShaderVariable::SampleIndex:
+					{
+						// the previous sample of the same pass is always one lower
+						unsigned int sample = m_curState.SampleIndex > 0 ? m_curState.SampleIndex - 1 : 0;
+						memcpy(var->Data, &sample, sizeof(unsigned int));
+					} break;
+					case ed::SystemShaderVariable::AudioPosition:
+					{
+						glm::vec4 raw = m_prevState.AudioPosition;
+						memcpy(var->Data, glm::value_ptr(raw), sizeof(glm::vec4));
+					} break;
 					case ed::SystemShaderVariable::IsPicked:
 					{
 						bool raw = m_prevState.IsPicked;
@@ -208,10 +366,8 @@ namespace ed
 						memcpy(var->Data, glm::value_ptr(raw), sizeof(glm::ivec4));
 					} break;
 					case ed::SystemShaderVariable::PluginVariable:
-					{
-						PluginSystemVariableData* pvData = &var->PluginSystemVarData;
-						pvData->Owner->UpdateSystemVariableValue(var->Data, pvData->Name, (plugin::VariableType)var->GetType(), isLastFrame);
-					} break;
+						m_updatePluginVariable(var, isLastFrame);
+						break;
 				}
 			}
 		}
@@ -26,13 +26,21 @@ namespace ed
 		SystemVariableManager()
 		{
 			m_curState.FrameIndex = 0;
+			m_curState.IterationIndex = 0;
+			m_curState.SampleIndex = 0;
 			m_curState.IsPicked = false;
 			m_curState.WASD = glm::vec4(0,0,0,0);
 			m_curState.Viewport = glm::vec2(0,1);
 			m_curState.MousePosition = glm::vec2(0,0);
 			m_curState.DeltaTime = 0.0f;
-			m_curGeoTransform.clear();
-			m_prevGeoTransform.clear();
+			m_curState.AudioPosition = glm::vec4(0.0f);
+			m_geoTransform.clear();
+			m_generation = 1;
+			m_projViewport = glm::vec2(-1, -1);
+			m_viewProjKey = m_viewOrthoKey = glm::mat4(0.0f);
+			m_viewProjViewport = m_viewOrthoViewport = glm::vec2(-1, -1);
+			m_tile = glm::vec4(0, 0, 1, 1);
+			m_tileEnabled = false;
 		}
 
 		static inline ed::ShaderVariable::ValueType GetType(ed::SystemShaderVariable sysVar)
@@ -45,6 +53,8 @@ namespace ed
 				case ed::SystemShaderVariable::Time: return ed::ShaderVariable::ValueType::Float1;
 				case ed::SystemShaderVariable::TimeDelta: return ed::ShaderVariable::ValueType::Float1;
 				case ed::SystemShaderVariable::FrameIndex: return ed::ShaderVariable::ValueType::Integer1;
+				case ed::SystemShaderVariable::IterationIndex: return ed::ShaderVariable::ValueType::Integer1;
+				case ed::SystemShaderVariable::SampleIndex: return ed::ShaderVariable::ValueType::Integer1;
 				case ed::SystemShaderVariable::View: return ed::ShaderVariable::ValueType::Float4x4;
 				case ed::SystemShaderVariable::ViewportSize: return ed::ShaderVariable::ValueType::Float2;
 				case ed::SystemShaderVariable::ViewProjection: return ed::ShaderVariable::ValueType::Float4x4;
@@ -56,6 +66,13 @@ namespace ed
 				case ed::SystemShaderVariable::CameraPosition3: return ed::ShaderVariable::ValueType::Float3;
 				case ed::SystemShaderVariable::CameraDirection3: return ed::ShaderVariable::ValueType::Float3;
 				case ed::SystemShaderVariable::KeysWASD: return ed::ShaderVariable::ValueType::Integer4;
+				case ed::SystemShaderVariable::AudioPosition: return ed::ShaderVariable::ValueType::Float4;
+				case ed::SystemShaderVariable::ViewLeft: return ed::ShaderVariable::ValueType::Float4x4;
+				case ed::SystemShaderVariable::ViewRight: return ed::ShaderVariable::ValueType::Float4x4;
+				case ed::SystemShaderVariable::ProjectionLeft: return ed::ShaderVariable::ValueType::Float4x4;
+				case ed::SystemShaderVariable::ProjectionRight: return ed::ShaderVariable::ValueType::Float4x4;
+				case ed::SystemShaderVariable::ViewProjectionLeft: return ed::ShaderVariable::ValueType::Float4x4;
+				case ed::SystemShaderVariable::ViewProjectionRight: return ed::ShaderVariable::ValueType::Float4x4;
 			}
 
 			return ed::ShaderVariable::ValueType::Float1;
@@ -68,25 +85,46 @@ namespace ed
 
 		inline Camera* GetCamera() { return Settings::Instance().Project.FPCamera ? (Camera*)&m_curState.FPCam : (Camera*)&m_curState.ArcCam; }
 		inline glm::mat4 GetViewMatrix() { return Settings::Instance().Project.FPCamera ? m_curState.FPCam.GetMatrix() : m_curState.ArcCam.GetMatrix(); }
-		inline glm::mat4 GetProjectionMatrix() { return glm::perspective(glm::radians(45.0f), m_curState.Viewport.x / m_curState.Viewport.y, 0.1f, 1000.0f); }
-		inline glm::mat4 GetOrthographicMatrix() { return glm::ortho(0.0f, m_curState.Viewport.x, m_curState.Viewport.y, 0.0f, 0.1f, 1000.0f); }
-		inline glm::mat4 GetViewProjectionMatrix() { return GetProjectionMatrix() * GetViewMatrix(); }
-		inline glm::mat4 GetViewOrthographicMatrix() { return GetOrthographicMatrix() * GetViewMatrix(); }
-		inline glm::mat4 GetGeometryTransform(PipelineItem* item) { return m_curGeoTransform[item]; }
-		inline glm::vec2 GetViewportSize() { return m_curState.Viewport; }
+		inline glm::mat4 GetProjectionMatrix() { m_updateProjection(); return m_proj; }
+		inline glm::mat4 GetOrthographicMatrix() { m_updateProjection(); return m_ortho; }
+		glm::mat4 GetViewProjectionMatrix();
+		glm::mat4 GetViewOrthographicMatrix();
+		glm::mat4 GetEyeViewMatrix(int eye); // 0 = left, 1 = right - see Settings::Project.EyeSeparation
+		glm::mat4 GetEyeProjectionMatrix(int eye);
+		inline glm::mat4 GetGeometryTransform(PipelineItem* item) { return m_geoTransform[item].Current; }
+		inline glm::vec2 GetViewportSize() { return m_curState.Viewport / glm::vec2(GetTile().z, GetTile().w); }
 		inline glm::ivec4  GetKeysWASD() { return m_curState.WASD; }
 		inline glm::vec2 GetMousePosition() { return m_curState.MousePosition; }
 		inline glm::vec4 GetMouse() { return m_curState.Mouse; }
 		inline glm::vec4 GetMouseButton() { return m_curState.MouseButton; }
 		inline unsigned int GetFrameIndex() { return m_curState.FrameIndex; }
+		inline unsigned int GetIterationIndex() { return m_curState.IterationIndex; }
+		inline unsigned int GetSampleIndex() { return m_curState.SampleIndex; }
 		inline float GetTime() { return m_timer.GetElapsedTime() + m_advTimer; }
 		inline eng::Timer& GetTimeClock() { return m_timer; }
 		inline float GetTimeDelta() { return m_curState.DeltaTime; }
 		inline bool IsPicked() { return m_curState.IsPicked; }
+		inline glm::vec4 GetAudioPosition() { return m_curState.AudioPosition; }
 
 		inline void SetGeometryTransform(PipelineItem* item, const glm::vec3& scale, const glm::vec3& rota, const glm::vec3& pos)
 		{
-			m_curGeoTransform[item] = glm::translate(glm::mat4(1), pos) *
+			TransformCache& trans = m_geoTransform[item];
+
+			// first update since CopyState() - the current matrix is now the last frame's matrix
+			if (trans.Generation != m_generation) {
+				trans.Previous = trans.Current;
+				trans.Generation = m_generation;
+			}
+
+			// most items don't move so the matrix is only rebuilt when the gizmo, UI or a plugin changed the values
+			if (trans.Valid && trans.Scale == scale && trans.Rotation == rota && trans.Position == pos)
+				return;
+
+			trans.Scale = scale;
+			trans.Rotation = rota;
+			trans.Position = pos;
+			trans.Valid = true;
+			trans.Current = glm::translate(glm::mat4(1), pos) *
 				glm::yawPitchRoll(rota.y, rota.x, rota.z) * 
 				glm::scale(glm::mat4(1.0f), scale);
 		}
@@ -98,9 +136,24 @@ namespace ed
 		inline void SetPicked(bool picked) { m_curState.IsPicked = picked; }
 		inline void SetKeysWASD(int w, int a, int s, int d) { m_curState.WASD = glm::ivec4(w, a, s, d); }
 		inline void SetFrameIndex(unsigned int ind) { m_curState.FrameIndex = ind; }
+		inline void SetIterationIndex(unsigned int ind) { m_curState.IterationIndex = ind; }
+		inline void SetSampleIndex(unsigned int ind) { m_curState.SampleIndex = ind; }
+		inline void SetAudioPosition(const glm::vec4& pos) { m_curState.AudioPosition = pos; }
 
 		inline void AdvanceTimer(float t) { m_advTimer += t; }
 
+		// value blocks of the API version 3 plugins, the pointers stay valid until ClearPluginBlocks()
+		void SetPluginBlock(IPlugin* plugin, const char* data, int size);
+		inline void ClearPluginBlocks() { m_pluginBlocks.clear(); }
+
+		// tiled rendering: the projection & ViewportSize describe the whole image while only the tile is rasterized,
+		// rect is x, y, width, height relative to the whole image starting at the bottom left corner
+		inline void SetTile(const glm::vec4& rect) { m_tile = rect; m_invalidateProjection(); }
+		inline void EnableTile(bool enabled) { if (m_tileEnabled != enabled) { m_tileEnabled = enabled; if (m_tile != glm::vec4(0, 0, 1, 1)) m_invalidateProjection(); } } // off for fixed size render textures
+		inline void ClearTile() { m_tile = glm::vec4(0, 0, 1, 1); m_tileEnabled = false; m_invalidateProjection(); }
+		inline glm::vec4 GetTile() { return m_tileEnabled ? m_tile : glm::vec4(0, 0, 1, 1); }
+		inline bool IsTiled() { return m_tile != glm::vec4(0, 0, 1, 1); } // a tile is set, even if the current pass doesn't use it
+
 	private:
 		eng::Timer m_timer;
 		float m_advTimer;
@@ -113,11 +166,42 @@ namespace ed
 			glm::vec2 Viewport, MousePosition;
 			bool IsPicked;
 			unsigned int FrameIndex;
+			unsigned int IterationIndex;
+			unsigned int SampleIndex;
 			glm::ivec4 WASD;
 			glm::vec4 Mouse, MouseButton;
+			glm::vec4 AudioPosition;
 		} m_prevState, m_curState;
 
+		struct TransformCache
+		{
+			TransformCache() : Current(1.0f), Previous(1.0f), Generation(0), Valid(false) {}
+
+			glm::vec3 Scale, Rotation, Position;
+			glm::mat4 Current, Previous;
+			unsigned int Generation; // m_generation when Previous was last taken
+			bool Valid;
+		};
+		std::unordered_map<PipelineItem*, TransformCache> m_geoTransform;
+		unsigned int m_generation; // increased by every CopyState()
+
+		/* view dependent matrices - rebuilt only when their inputs change */
+		void m_updateProjection();
+		void m_updatePluginVariable(ShaderVariable* var, bool isLastFrame);
+		inline void m_invalidateProjection() { m_projViewport = m_viewProjViewport = m_viewOrthoViewport = glm::vec2(-1, -1); }
+		glm::vec2 m_projViewport;
+		glm::mat4 m_proj, m_ortho;
+		glm::mat4 m_viewProjKey, m_viewProj, m_viewOrthoKey, m_viewOrtho;
+		glm::vec2 m_viewProjViewport, m_viewOrthoViewport;
 
-		std::unordered_map<PipelineItem*, glm::mat4> m_curGeoTransform, m_prevGeoTransform;
+		glm::vec4 m_tile;
+		bool m_tileEnabled;
+
+		struct PluginBlock
+		{
+			const char* Data;
+			int Size;
+		};
+		std::unordered_map<IPlugin*, PluginBlock> m_pluginBlocks;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,453 @@
+#include "TextureSharing.h"
+#include "ObjectManager.h"
+#include "Logger.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+
+#if defined(_WIN32)
+	#include <windows.h>
+#else
+	#include <dlfcn.h>
+#endif
+
+#ifdef SHADERED_SPOUT
+	#include <SpoutLibrary.h>
+#endif
+
+#define NDI_FOURCC_RGBA ((uint32_t)'R' | ((uint32_t)'G' << 8) | ((uint32_t)'B' << 16) | ((uint32_t)'A' << 24))
+#define NDI_FRAME_PROGRESSIVE 1
+#define NDI_TIMECODE_SYNTHESIZE INT64_MAX
+
+namespace ed
+{
+#ifdef SHADERED_SYPHON
+	// TextureSharingSyphon.mm
+	void* syphonCreateServer(const char* name);
+	void syphonPublish(void* server, GLuint tex, int width, int height);
+	void syphonDestroyServer(void* server);
+#endif
+
+	// same layouts as NDIlib_send_create_t & NDIlib_video_frame_v2_t from Processing.NDI.Lib.h
+	struct NDISendCreate
+	{
+		const char* Name;
+		const char* Groups;
+		bool ClockVideo, ClockAudio;
+	};
+	struct NDIVideoFrame
+	{
+		int XRes, YRes;
+		uint32_t FourCC;
+		int FrameRateN, FrameRateD;
+		float AspectRatio; // 0 -> XRes / YRes
+		int FrameFormat;
+		int64_t Timecode;
+		const uint8_t* Data;
+		int LineStride;
+		const char* Metadata;
+		int64_t Timestamp;
+	};
+
+	struct TextureSharing::NDI
+	{
+		bool (*Initialize)();
+		void (*Destroy)();
+		void* (*SendCreate)(const NDISendCreate* desc);
+		void (*SendDestroy)(void* sender);
+		void (*SendVideoAsync)(void* sender, const NDIVideoFrame* frame); // the frame's memory has to stay valid until the next call
+	};
+
+	struct TextureSharing::Output::Sender
+	{
+		std::string Name; // the senders are created again once the output is renamed
+
+		void* Spout; // SPOUTLIBRARY*
+		void* Syphon; // SyphonOpenGLServer*
+
+		void* NDI; // NDIlib_send_instance_t
+		glm::ivec2 Size; // of the readback buffers
+		GLuint Texture; // flipped RGBA8 copy of the frame
+
+		struct Readback
+		{
+			GLuint PBO;
+			GLsync Fence;
+			unsigned char* Mapped; // persistently mapped, nullptr -> mapped & copied once it's done
+		} Ring[SHARE_READBACK_BUFFERS];
+		int Read, Write, Count;
+		int Sending; // ring slot that NDI still reads from, -1 if it's one of the copies
+		std::vector<unsigned char> Copy[2];
+		int CopyIndex;
+	};
+
+	static void releaseGPUSender(TextureSharing::Output::Sender* s)
+	{
+#if defined(SHADERED_SPOUT)
+		if (s->Spout != nullptr) {
+			((SPOUTLIBRARY*)s->Spout)->ReleaseSender();
+			((SPOUTLIBRARY*)s->Spout)->Release();
+		}
+#elif defined(SHADERED_SYPHON)
+		if (s->Syphon != nullptr)
+			syphonDestroyServer(s->Syphon);
+#endif
+		s->Spout = s->Syphon = nullptr;
+	}
+
+	TextureSharing::TextureSharing()
+	{
+		m_ndi = nullptr;
+		m_ndiLoaded = false;
+		m_flipFBO[0] = m_flipFBO[1] = 0;
+	}
+	TextureSharing::~TextureSharing()
+	{
+		// the senders are released in Clear() while the GL context still exists
+		for (Output* out : m_outputs)
+			delete out;
+	}
+
+	bool TextureSharing::IsGPUSharingSupported()
+	{
+#if defined(SHADERED_SPOUT) || defined(SHADERED_SYPHON)
+		return true;
+#else
+		return false;
+#endif
+	}
+	bool TextureSharing::IsNDIAvailable()
+	{
+		if (m_ndiLoaded)
+			return m_ndi != nullptr;
+		m_ndiLoaded = true;
+
+		const char* names[] = { "NDIlib_initialize", "NDIlib_destroy", "NDIlib_send_create", "NDIlib_send_destroy", "NDIlib_send_send_video_async_v2" };
+		void* funcs[5] = { nullptr };
+
+#if defined(_WIN32)
+		HMODULE mod = nullptr;
+		for (const char* env : { "NDI_RUNTIME_DIR_V6", "NDI_RUNTIME_DIR_V5", "NDI_RUNTIME_DIR_V4" }) {
+			const char* dir = getenv(env);
+			if (dir != nullptr && (mod = LoadLibraryA((std::string(dir) + "\\Processing.NDI.Lib.x64.dll").c_str())) != nullptr)
+				break;
+		}
+		if (mod == nullptr)
+			mod = LoadLibraryA("Processing.NDI.Lib.x64.dll");
+		if (mod != nullptr)
+			for (int i = 0; i < 5; i++)
+				funcs[i] = (void*)GetProcAddress(mod, names[i]);
+#else
+		void* mod = nullptr;
+		for (const char* lib : { "libndi.so.6", "libndi.so.5", "libndi.so.4", "libndi.so", "/usr/local/lib/libndi.dylib", "libndi.dylib" })
+			if ((mod = dlopen(lib, RTLD_NOW)) != nullptr)
+				break;
+		if (mod != nullptr)
+			for (int i = 0; i < 5; i++)
+				funcs[i] = dlsym(mod, names[i]);
+#endif
+
+		for (int i = 0; i < 5; i++)
+			if (funcs[i] == nullptr) {
+				Logger::Get().Log("NDI runtime wasn't found - NDI outputs are disabled");
+				return false;
+			}
+
+		NDI* ndi = new NDI();
+		ndi->Initialize = (bool (*)())funcs[0];
+		ndi->Destroy = (void (*)())funcs[1];
+		ndi->SendCreate = (void* (*)(const NDISendCreate*))funcs[2];
+		ndi->SendDestroy = (void (*)(void*))funcs[3];
+		ndi->SendVideoAsync = (void (*)(void*, const NDIVideoFrame*))funcs[4];
+
+		if (!ndi->Initialize()) {
+			Logger::Get().Log("Failed to initialize NDI - the CPU isn't supported", true);
+			delete ndi;
+			return false;
+		}
+
+		m_ndi = ndi;
+		return true;
+	}
+
+	TextureSharing::Output* TextureSharing::Add(const std::string& source, const std::string& name)
+	{
+		Output* out = Get(source);
+		if (out != nullptr)
+			return out;
+
+		out = new Output();
+		out->Source = source;
+		out->Name = name;
+		out->GPU = false;
+		out->NDI = false;
+		out->Data = nullptr;
+		m_outputs.push_back(out);
+
+		return out;
+	}
+	void TextureSharing::Remove(const std::string& source)
+	{
+		for (int i = 0; i < m_outputs.size(); i++)
+			if (m_outputs[i]->Source == source) {
+				m_release(m_outputs[i]);
+				delete m_outputs[i];
+				m_outputs.erase(m_outputs.begin() + i);
+				break;
+			}
+	}
+	TextureSharing::Output* TextureSharing::Get(const std::string& source)
+	{
+		for (Output* out : m_outputs)
+			if (out->Source == source)
+				return out;
+		return nullptr;
+	}
+	void TextureSharing::Clear()
+	{
+		for (Output* out : m_outputs) {
+			m_release(out);
+			delete out;
+		}
+		m_outputs.clear();
+
+		if (m_flipFBO[0] != 0)
+			glDeleteFramebuffers(2, m_flipFBO);
+		m_flipFBO[0] = m_flipFBO[1] = 0;
+	}
+
+	void TextureSharing::Publish(ObjectManager* objects, GLuint preview, const glm::ivec2& previewSize)
+	{
+		for (Output* out : m_outputs) {
+			if (!out->GPU && !out->NDI) {
+				if (out->Data != nullptr)
+					m_release(out);
+				continue;
+			}
+
+			if (out->Source.empty())
+				m_publish(out, preview, previewSize);
+			else if (objects->IsRenderTexture(out->Source))
+				m_publish(out, objects->GetTexture(out->Source), objects->GetRenderTextureSize(out->Source));
+		}
+	}
+	void TextureSharing::m_publish(Output* out, GLuint tex, const glm::ivec2& size)
+	{
+		if (tex == 0 || size.x <= 0 || size.y <= 0)
+			return;
+
+		if (out->Data != nullptr && out->Data->Name != out->Name)
+			m_release(out);
+
+		if (out->Data == nullptr) {
+			Output::Sender* s = out->Data = new Output::Sender();
+			s->Name = out->Name;
+			s->Spout = nullptr;
+			s->Syphon = nullptr;
+			s->NDI = nullptr;
+			s->Size = glm::ivec2(0, 0);
+			s->Texture = 0;
+			for (int i = 0; i < SHARE_READBACK_BUFFERS; i++) {
+				s->Ring[i].PBO = 0;
+				s->Ring[i].Fence = 0;
+				s->Ring[i].Mapped = nullptr;
+			}
+			s->Read = s->Write = s->Count = 0;
+			s->Sending = -1;
+			s->CopyIndex = 0;
+		}
+
+		Output::Sender* s = out->Data;
+		std::string name = out->Name.empty() ? (out->Source.empty() ? "SHADERed" : out->Source) : out->Name;
+
+		// the texture is shared as it is, no copies
+		if (out->GPU) {
+#if defined(SHADERED_SPOUT)
+			if (s->Spout == nullptr) {
+				SPOUTLIBRARY* spout = GetSpout();
+				spout->SetSenderName(name.c_str());
+				s->Spout = spout;
+			}
+			((SPOUTLIBRARY*)s->Spout)->SendTexture(tex, GL_TEXTURE_2D, size.x, size.y, true, 0);
+#elif defined(SHADERED_SYPHON)
+			if (s->Syphon == nullptr)
+				s->Syphon = syphonCreateServer(name.c_str());
+			if (s->Syphon != nullptr)
+				syphonPublish(s->Syphon, tex, size.x, size.y);
+#endif
+		} else
+			releaseGPUSender(s);
+
+		if (out->NDI && IsNDIAvailable())
+			m_sendNDI(out, tex, size);
+	}
+	void TextureSharing::m_sendNDI(Output* out, GLuint tex, const glm::ivec2& size)
+	{
+		Output::Sender* s = out->Data;
+
+		if (s->NDI == nullptr) {
+			std::string name = out->Name.empty() ? (out->Source.empty() ? "SHADERed" : out->Source) : out->Name;
+			NDISendCreate desc = { name.c_str(), nullptr, false, false };
+
+			s->NDI = m_ndi->SendCreate(&desc);
+			if (s->NDI == nullptr) {
+				Logger::Get().Log("Failed to create the NDI sender " + name, true);
+				out->NDI = false;
+				return;
+			}
+		}
+
+		int frameSize = size.x * size.y * 4;
+
+		// (re)allocate the readback ring
+		if (s->Size != size) {
+			m_ndi->SendVideoAsync(s->NDI, nullptr); // waits until NDI doesn't need the last frame anymore
+
+			for (int i = 0; i < SHARE_READBACK_BUFFERS; i++) {
+				if (s->Ring[i].Fence != 0)
+					glDeleteSync(s->Ring[i].Fence);
+				s->Ring[i].Fence = 0;
+				s->Ring[i].Mapped = nullptr;
+			}
+			if (s->Ring[0].PBO != 0) {
+				GLuint pbos[SHARE_READBACK_BUFFERS];
+				for (int i = 0; i < SHARE_READBACK_BUFFERS; i++)
+					pbos[i] = s->Ring[i].PBO;
+				glDeleteBuffers(SHARE_READBACK_BUFFERS, pbos);
+			}
+			if (s->Texture == 0)
+				glGenTextures(1, &s->Texture);
+
+			glBindTexture(GL_TEXTURE_2D, s->Texture);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			glBindTexture(GL_TEXTURE_2D, 0);
+
+			// persistently mapped if possible - NDI then sends straight from the PBO
+			for (int i = 0; i < SHARE_READBACK_BUFFERS; i++) {
+				glGenBuffers(1, &s->Ring[i].PBO);
+				glBindBuffer(GL_PIXEL_PACK_BUFFER, s->Ring[i].PBO);
+				if (GLEW_ARB_buffer_storage) {
+					GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+					glBufferStorage(GL_PIXEL_PACK_BUFFER, frameSize, nullptr, flags);
+					s->Ring[i].Mapped = (unsigned char*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, frameSize, flags);
+				} else
+					glBufferData(GL_PIXEL_PACK_BUFFER, frameSize, NULL, GL_STREAM_READ);
+			}
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+			s->Read = s->Write = s->Count = 0;
+			s->Sending = -1;
+			s->Size = size;
+		}
+
+		// send the oldest frame once the GPU copied it
+		if (s->Count > 0) {
+			Output::Sender::Readback& rb = s->Ring[s->Read];
+			GLenum status = glClientWaitSync(rb.Fence, 0, 0);
+			if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+				glDeleteSync(rb.Fence);
+				rb.Fence = 0;
+
+				const unsigned char* data = rb.Mapped;
+				if (data == nullptr) {
+					// NDI keeps reading the previous frame until the next call -> alternate between two copies
+					glBindBuffer(GL_PIXEL_PACK_BUFFER, rb.PBO);
+					void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, frameSize, GL_MAP_READ_BIT);
+					if (mapped != nullptr) {
+						std::vector<unsigned char>& copy = s->Copy[s->CopyIndex];
+						copy.resize(frameSize);
+						memcpy(copy.data(), mapped, frameSize);
+						glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+
+						data = copy.data();
+						s->CopyIndex = 1 - s->CopyIndex;
+					}
+					glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+				}
+
+				if (data != nullptr) {
+					NDIVideoFrame frame;
+					frame.XRes = size.x;
+					frame.YRes = size.y;
+					frame.FourCC = NDI_FOURCC_RGBA;
+					frame.FrameRateN = 60;
+					frame.FrameRateD = 1;
+					frame.AspectRatio = 0.0f;
+					frame.FrameFormat = NDI_FRAME_PROGRESSIVE;
+					frame.Timecode = NDI_TIMECODE_SYNTHESIZE;
+					frame.Data = data;
+					frame.LineStride = size.x * 4;
+					frame.Metadata = nullptr;
+					frame.Timestamp = 0;
+
+					m_ndi->SendVideoAsync(s->NDI, &frame);
+					s->Sending = rb.Mapped != nullptr ? s->Read : -1;
+				}
+
+				s->Read = (s->Read + 1) % SHARE_READBACK_BUFFERS;
+				s->Count--;
+			}
+		}
+
+		// every buffer is still busy -> skip this frame instead of waiting
+		if (s->Count == SHARE_READBACK_BUFFERS || s->Write == s->Sending)
+			return;
+
+		if (m_flipFBO[0] == 0)
+			glGenFramebuffers(2, m_flipFBO);
+
+		GLboolean scissor = glIsEnabled(GL_SCISSOR_TEST);
+		glDisable(GL_SCISSOR_TEST);
+
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, m_flipFBO[0]);
+		glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex, 0);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_flipFBO[1]);
+		glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, s->Texture, 0);
+		glBlitFramebuffer(0, 0, size.x, size.y, 0, size.y, size.x, 0, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+		Output::Sender::Readback& rb = s->Ring[s->Write];
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, m_flipFBO[1]);
+		glReadBuffer(GL_COLOR_ATTACHMENT0);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, rb.PBO);
+		glReadPixels(0, 0, size.x, size.y, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, m_flipFBO[0]);
+		glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		if (scissor)
+			glEnable(GL_SCISSOR_TEST);
+
+		rb.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		s->Write = (s->Write + 1) % SHARE_READBACK_BUFFERS;
+		s->Count++;
+	}
+	void TextureSharing::m_release(Output* out)
+	{
+		Output::Sender* s = out->Data;
+		if (s == nullptr)
+			return;
+
+		releaseGPUSender(s);
+
+		if (s->NDI != nullptr)
+			m_ndi->SendDestroy(s->NDI); // also waits for the frame that's being sent
+
+		for (int i = 0; i < SHARE_READBACK_BUFFERS; i++) {
+			if (s->Ring[i].Fence != 0)
+				glDeleteSync(s->Ring[i].Fence);
+			if (s->Ring[i].PBO != 0)
+				glDeleteBuffers(1, &s->Ring[i].PBO);
+		}
+		if (s->Texture != 0)
+			glDeleteTextures(1, &s->Texture);
+
+		delete s;
+		out->Data = nullptr;
+	}
+}
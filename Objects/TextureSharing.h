@@ -0,0 +1,72 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/glew.h>
+#if defined(__APPLE__)
+	#include <OpenGL/gl.h>
+#else
+	#include <GL/gl.h>
+#endif
+
+#define SHARE_READBACK_BUFFERS 4 // frames that the NDI readback can be behind the GPU
+
+namespace ed
+{
+	class ObjectManager;
+
+	// publishes the preview and render textures to other applications - the GL texture itself is shared through
+	// Spout (Windows) or Syphon (macOS) if SHADERed was built with them, NDI is loaded at runtime like RenderDoc
+	// and sends frames that were read back asynchronously
+	class TextureSharing
+	{
+	public:
+		static inline TextureSharing& Instance()
+		{
+			static TextureSharing ret;
+			return ret;
+		}
+
+		struct Output
+		{
+			std::string Source; // render texture, empty -> the preview
+			std::string Name; // sender name that the other applications see
+			bool GPU; // Spout/Syphon
+			bool NDI;
+
+			struct Sender;
+			Sender* Data;
+		};
+
+		TextureSharing();
+		~TextureSharing();
+
+		static bool IsGPUSharingSupported();
+		bool IsNDIAvailable(); // loads the NDI runtime on the first call
+
+		Output* Add(const std::string& source, const std::string& name = "");
+		void Remove(const std::string& source);
+		Output* Get(const std::string& source);
+		inline const std::vector<Output*>& GetOutputs() { return m_outputs; }
+		void Clear();
+
+		// called by the RenderEngine once the frame is finished
+		void Publish(ObjectManager* objects, GLuint preview, const glm::ivec2& previewSize);
+
+	private:
+		void m_publish(Output* out, GLuint tex, const glm::ivec2& size);
+		void m_sendNDI(Output* out, GLuint tex, const glm::ivec2& size);
+		void m_release(Output* out);
+
+		struct NDI;
+		NDI* m_ndi;
+		bool m_ndiLoaded;
+
+		std::vector<Output*> m_outputs;
+		GLuint m_flipFBO[2]; // read & draw FBO for the NDI copies - GL reads the rows bottom up, NDI wants them top down
+	};
+}
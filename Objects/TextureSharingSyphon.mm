@@ -0,0 +1,22 @@
+// Syphon server for TextureSharing - only compiled on macOS with SHADERED_SYPHON
+#import <Syphon/Syphon.h>
+#import <OpenGL/OpenGL.h>
+#include <GL/glew.h>
+
+namespace ed
+{
+	void* syphonCreateServer(const char* name)
+	{
+		SyphonOpenGLServer* server = [[SyphonOpenGLServer alloc] initWithName:[NSString stringWithUTF8String:name] context:CGLGetCurrentContext() options:nil];
+		return (void*)server;
+	}
+	void syphonPublish(void* server, GLuint tex, int width, int height)
+	{
+		[(SyphonOpenGLServer*)server publishFrameTexture:tex textureTarget:GL_TEXTURE_2D imageRegion:NSMakeRect(0, 0, width, height) textureDimensions:NSMakeSize(width, height) flipped:NO];
+	}
+	void syphonDestroyServer(void* server)
+	{
+		[(SyphonOpenGLServer*)server stop];
+		[(SyphonOpenGLServer*)server release];
+	}
+}
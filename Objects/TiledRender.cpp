@@ -0,0 +1,186 @@
+#include "TiledRender.h"
+#include "RenderEngine.h"
+#include "SystemVariableManager.h"
+#include "ImageDownsampler.h"
+#include "Logger.h"
+
+#include <stb/stb_image_write.h>
+
+#include <algorithm>
+#include <fstream>
+#include <vector>
+#include <stdint.h>
+#include <string.h>
+
+namespace ed
+{
+	template <typename T>
+	static void writeValue(std::ofstream& file, T val)
+	{
+		file.write((const char*)&val, sizeof(T));
+	}
+
+	// both formats store the rows bottom up, same as OpenGL, so the tiles can be written in the order they are rendered
+	static bool writeHeader(std::ofstream& file, const std::string& ext, int width, int height)
+	{
+		if (ext == "bmp") {
+			uint32_t rowSize = (width * 3 + 3) & ~3u;
+			uint32_t dataSize = rowSize * height;
+
+			// BITMAPFILEHEADER
+			file.write("BM", 2);
+			writeValue<uint32_t>(file, 14 + 40 + dataSize);
+			writeValue<uint32_t>(file, 0);
+			writeValue<uint32_t>(file, 14 + 40);
+
+			// BITMAPINFOHEADER
+			writeValue<uint32_t>(file, 40);
+			writeValue<int32_t>(file, width);
+			writeValue<int32_t>(file, height);
+			writeValue<uint16_t>(file, 1);
+			writeValue<uint16_t>(file, 24);
+			writeValue<uint32_t>(file, 0);
+			writeValue<uint32_t>(file, dataSize);
+			writeValue<int32_t>(file, 2835);
+			writeValue<int32_t>(file, 2835);
+			writeValue<uint32_t>(file, 0);
+			writeValue<uint32_t>(file, 0);
+		} else {
+			if (width > 0xFFFF || height > 0xFFFF) {
+				Logger::Get().Log("TGA images can't be larger than 65535x65535", true);
+				return false;
+			}
+
+			uint8_t header[18] = { 0 };
+			header[2] = 2; // uncompressed true color
+			header[12] = width & 0xFF;
+			header[13] = (width >> 8) & 0xFF;
+			header[14] = height & 0xFF;
+			header[15] = (height >> 8) & 0xFF;
+			header[16] = 32;
+			header[17] = 8; // alpha bits, bottom left origin
+			file.write((const char*)header, sizeof(header));
+		}
+		return file.good();
+	}
+	static void writeRows(std::ofstream& file, const std::string& ext, const unsigned char* rgba, int width, int rows)
+	{
+		int pixelSize = ext == "bmp" ? 3 : 4;
+		std::vector<unsigned char> row((width * pixelSize + 3) & ~3, 0);
+
+		for (int y = 0; y < rows; y++) {
+			const unsigned char* src = rgba + (size_t)y * width * 4;
+			for (int x = 0; x < width; x++) {
+				unsigned char* dst = &row[x * pixelSize];
+				dst[0] = src[x * 4 + 2];
+				dst[1] = src[x * 4 + 1];
+				dst[2] = src[x * 4 + 0];
+				if (pixelSize == 4)
+					dst[3] = src[x * 4 + 3];
+			}
+			file.write((const char*)row.data(), pixelSize == 3 ? row.size() : (size_t)width * 4);
+		}
+	}
+
+	bool TiledRender::IsTooLarge(int width, int height)
+	{
+		GLint maxTex = 0, maxViewport[2] = { 0, 0 };
+		glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTex);
+		glGetIntegerv(GL_MAX_VIEWPORT_DIMS, maxViewport);
+
+		return width > std::min<int>(maxTex, maxViewport[0]) || height > std::min<int>(maxTex, maxViewport[1]);
+	}
+	bool TiledRender::Save(RenderEngine* renderer, const std::string& path, int width, int height, int supersample, int tileSize)
+	{
+		if (width <= 0 || height <= 0)
+			return false;
+
+		supersample = std::max(1, supersample);
+
+		GLint maxTex = 0, maxViewport[2] = { 0, 0 };
+		glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTex);
+		glGetIntegerv(GL_MAX_VIEWPORT_DIMS, maxViewport);
+		tileSize = std::min(tileSize, std::min<int>(maxTex, std::min(maxViewport[0], maxViewport[1])));
+		tileSize -= tileSize % supersample; // an output pixel never needs two tiles
+		if (tileSize < supersample) {
+			Logger::Get().Log("The tile size is smaller than the supersampling factor", true);
+			return false;
+		}
+
+		int fullWidth = width * supersample, fullHeight = height * supersample;
+		int tileWidth = std::min(tileSize, fullWidth), tileHeight = std::min(tileSize, fullHeight); // all tiles have the same size so the render targets are only created once
+		int bandRows = tileHeight / supersample;
+
+		std::string ext = path.substr(path.find_last_of('.') + 1);
+		bool streamed = ext == "bmp" || ext == "tga";
+
+		std::ofstream file;
+		std::vector<unsigned char> image;
+		if (streamed) {
+			file.open(path, std::ios::binary);
+			if (!file.is_open() || !writeHeader(file, ext, width, height)) {
+				Logger::Get().Log("Failed to write " + path, true);
+				return false;
+			}
+		} else
+			image.resize((size_t)width * height * 4);
+
+		std::vector<unsigned char> tile((size_t)(tileWidth / supersample) * bandRows * 4);
+		std::vector<unsigned char> band((size_t)width * bandRows * 4);
+
+		// every tile has to see the same time
+		SystemVariableManager& systemVM = SystemVariableManager::Instance();
+		bool wasPaused = systemVM.GetTimeClock().IsPaused();
+		if (!wasPaused)
+			systemVM.GetTimeClock().Pause();
+
+		for (int y0 = 0; y0 < fullHeight; y0 += tileHeight) {
+			int rows = std::min(tileHeight, fullHeight - y0) / supersample;
+
+			for (int x0 = 0; x0 < fullWidth; x0 += tileWidth) {
+				int cols = std::min(tileWidth, fullWidth - x0) / supersample;
+
+				systemVM.SetTile(glm::vec4((float)x0 / fullWidth, (float)y0 / fullHeight, (float)tileWidth / fullWidth, (float)tileHeight / fullHeight));
+				renderer->InvalidatePassCache(); // the previous tile's passes can't be reused
+				renderer->Render(tileWidth, tileHeight);
+
+				// downsampled before the readback
+				GLuint tex = renderer->GetTexture();
+				if (supersample != 1)
+					tex = ImageDownsampler::Instance().Downsample(tex, glm::ivec2(tileWidth, tileHeight), supersample);
+
+				if (tex != 0) {
+					glBindTexture(GL_TEXTURE_2D, tex);
+					glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, tile.data());
+					glBindTexture(GL_TEXTURE_2D, 0);
+				}
+
+				for (int y = 0; y < rows; y++)
+					memcpy(&band[((size_t)y * width + x0 / supersample) * 4], &tile[(size_t)y * (tileWidth / supersample) * 4], (size_t)cols * 4);
+			}
+
+			if (streamed)
+				writeRows(file, ext, band.data(), width, rows);
+			else
+				memcpy(&image[(size_t)(y0 / supersample) * width * 4], band.data(), (size_t)rows * width * 4);
+		}
+
+		systemVM.ClearTile();
+		renderer->InvalidatePassCache();
+		if (!wasPaused)
+			systemVM.GetTimeClock().Resume();
+
+		bool ret = true;
+		if (streamed)
+			ret = file.good();
+		else if (ext == "jpg" || ext == "jpeg")
+			ret = stbi_write_jpg(path.c_str(), width, height, 4, image.data(), 100);
+		else
+			ret = stbi_write_png(path.c_str(), width, height, 4, image.data(), width * 4);
+
+		if (!ret)
+			Logger::Get().Log("Failed to write " + path, true);
+
+		return ret;
+	}
+}
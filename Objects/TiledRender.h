@@ -0,0 +1,21 @@
+#pragma once
+#include <string>
+
+#define TILED_RENDER_DEFAULT_TILE 2048
+
+namespace ed
+{
+	class RenderEngine;
+
+	// renders an image that is bigger than GL_MAX_TEXTURE_SIZE (or VRAM) one tile at a time - the projection & ViewportSize
+	// still describe the whole image, each tile is a short GPU submission so heavy frames don't hit the driver timeout
+	// bmp & tga are streamed to the file one row of tiles at a time, png & jpg keep the final image in memory since stb
+	// writes them at once (each tile is downsampled on the GPU so the supersampled image is never read back)
+	class TiledRender
+	{
+	public:
+		static bool Save(RenderEngine* renderer, const std::string& path, int width, int height, int supersample, int tileSize = TILED_RENDER_DEFAULT_TILE);
+
+		static bool IsTooLarge(int width, int height); // can't be rendered into a single texture
+	};
+}
@@ -0,0 +1,65 @@
+#include "TimeSlicer.h"
+
+#include <algorithm>
+#include <math.h>
+
+namespace ed
+{
+	TimeSlicer::TimeSlicer()
+	{
+		m_budget = 0.0f;
+		m_queries[0] = m_queries[1] = 0;
+	}
+	TimeSlicer::~TimeSlicer()
+	{
+		if (m_queries[0] != 0)
+			glDeleteQueries(2, m_queries);
+	}
+	int TimeSlicer::GetSliceCount(PipelineItem* item, int max)
+	{
+		Entry& entry = m_entries[item];
+		entry.Max = std::max(max, 1);
+		entry.Slices = std::max(1, std::min(entry.Slices, entry.Max));
+		entry.Longest = 0.0f;
+
+		return entry.Slices;
+	}
+	void TimeSlicer::BeginSlice()
+	{
+		if (m_queries[0] == 0)
+			glGenQueries(2, m_queries);
+
+		// timestamps - the slices are drawn inside the GL_TIME_ELAPSED queries that PreviewUI (dynamic resolution) and the headless
+		// benchmark wrap around the whole frame, and only one elapsed time query can be active at a time
+		glQueryCounter(m_queries[0], GL_TIMESTAMP);
+	}
+	void TimeSlicer::EndSlice(PipelineItem* item)
+	{
+		glQueryCounter(m_queries[1], GL_TIMESTAMP);
+
+		// also flushes the slice & blocks until the GPU is done with it
+		GLuint64 start = 0, end = 0;
+		glGetQueryObjectui64v(m_queries[1], GL_QUERY_RESULT, &end);
+		glGetQueryObjectui64v(m_queries[0], GL_QUERY_RESULT, &start);
+
+		Entry& entry = m_entries[item];
+		entry.Longest = std::max(entry.Longest, (end - start) / 1000000.0f);
+	}
+	void TimeSlicer::EndItem(PipelineItem* item)
+	{
+		auto entry = m_entries.find(item);
+		if (entry == m_entries.end() || entry->second.Longest <= 0.0f)
+			return;
+
+		// the slices aim for half of the budget, the cost isn't spread evenly over the image - fewer slices are only used gradually
+		Entry& e = entry->second;
+		int wanted = (int)ceilf(e.Slices * e.Longest / (m_budget * 0.5f));
+		if (wanted < e.Slices)
+			wanted = std::max(wanted, e.Slices * 3 / 4);
+		e.Slices = std::max(1, std::min(wanted, e.Max));
+	}
+	void TimeSlicer::Release(PipelineItem* item)
+	{
+		m_entries.erase(item);
+	}
+}
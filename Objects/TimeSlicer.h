@@ -0,0 +1,54 @@
+#pragma once
+#include "PipelineItem.h"
+
+#include <unordered_map>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/glew.h>
+#if defined(__APPLE__)
+	#include <OpenGL/gl.h>
+#else
+	#include <GL/gl.h>
+#endif
+
+#define TIME_SLICE_INITIAL 16 // slices of a pass that wasn't measured yet
+
+namespace ed
+{
+	// keeps the GPU submissions of heavy passes under a time budget so that the OS watchdog (TDR) doesn't reset the driver -
+	// shader passes are drawn in scissored bands & compute passes in sub-dispatches, the CPU waits for each slice before
+	// the next one is submitted. the number of slices follows the GPU time that the slices took in the previous frame
+	class TimeSlicer
+	{
+	public:
+		TimeSlicer();
+		~TimeSlicer();
+
+		inline void SetBudget(float ms) { m_budget = ms; }
+		inline bool IsEnabled() { return m_budget > 0.0f; }
+
+		int GetSliceCount(PipelineItem* item, int max); // max = rows of a shader pass, work groups of a compute pass
+
+		void BeginSlice();
+		void EndSlice(PipelineItem* item); // waits for the GPU to finish the slice
+		void EndItem(PipelineItem* item); // all slices of this frame were drawn, picks the next slice count
+
+		void Release(PipelineItem* item);
+		inline void Clear() { m_entries.clear(); }
+
+	private:
+		struct Entry
+		{
+			Entry() { Slices = TIME_SLICE_INITIAL; Max = 1; Longest = 0.0f; }
+
+			int Slices, Max;
+			float Longest; // ms, the slowest slice of this frame
+		};
+		std::unordered_map<PipelineItem*, Entry> m_entries;
+
+		float m_budget;
+		GLuint m_queries[2];
+	};
+}
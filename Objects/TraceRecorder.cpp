@@ -0,0 +1,223 @@
+#include "TraceRecorder.h"
+#include "Logger.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/glew.h>
+#if defined(__APPLE__)
+	#include <OpenGL/gl.h>
+#else
+	#include <GL/gl.h>
+#endif
+
+#include <fstream>
+#include <algorithm>
+#include <string.h>
+#include <stdio.h>
+
+namespace ed
+{
+	enum
+	{
+		ProcessEditor = 1,
+		ProcessGPU = 2
+	};
+	enum
+	{
+		ThreadFrames,
+		ThreadMain,
+		ThreadWorkers // the first worker, the others follow in the order they were seen
+	};
+
+	static void writeString(std::ofstream& out, const std::string& str)
+	{
+		out.put('"');
+		for (char c : str) {
+			if (c == '"' || c == '\\')
+				out << '\\' << c;
+			else if ((unsigned char)c < 0x20) {
+				char buf[8];
+				snprintf(buf, sizeof(buf), "\\u%04x", c);
+				out << buf;
+			} else
+				out.put(c);
+		}
+		out.put('"');
+	}
+	static void writeMetadata(std::ofstream& out, const char* type, int process, int thread, const std::string& name)
+	{
+		out << ",\n{\"name\":\"" << type << "\",\"ph\":\"M\",\"pid\":" << process << ",\"tid\":" << thread << ",\"args\":{\"name\":";
+		writeString(out, name);
+		out << "}}";
+	}
+
+	TraceRecorder::TraceRecorder()
+	{
+		m_recording = false;
+		m_duration = 0.0f;
+		m_gpuOffset = 0;
+		m_frame = 0;
+		m_dropped = 0;
+	}
+	void TraceRecorder::Start(const std::string& file, float seconds)
+	{
+		if (m_recording)
+			Stop();
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_events.clear();
+			m_threads.clear();
+			m_dropped = 0;
+			m_mainThread = std::this_thread::get_id();
+		}
+
+		m_file = file;
+		m_duration = std::max(seconds, 0.1f);
+		m_start = m_frameStart = std::chrono::steady_clock::now();
+		m_frame = 0;
+		m_calibrate();
+		m_recording = true;
+
+		Logger::Get().Log("Recording a trace for " + std::to_string(m_duration) + "s");
+	}
+	void TraceRecorder::Stop()
+	{
+		if (!m_recording)
+			return;
+		m_recording = false;
+
+		// jobs that are still running might add their zones until the lock is taken
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_write())
+			Logger::Get().Log("Saved a trace with " + std::to_string(m_events.size()) + " events to " + m_file);
+		else
+			Logger::Get().Log("Failed to save the trace to " + m_file, true);
+
+		if (m_dropped > 0)
+			Logger::Get().Log(std::to_string(m_dropped) + " trace events were dropped, only " + std::to_string(TRACE_RECORDER_MAX_EVENTS) + " are stored", true);
+
+		m_events.clear();
+		m_events.shrink_to_fit();
+	}
+	float TraceRecorder::GetRemaining()
+	{
+		if (!m_recording)
+			return 0.0f;
+		return std::max(m_duration - std::chrono::duration<float>(std::chrono::steady_clock::now() - m_start).count(), 0.0f);
+	}
+	void TraceRecorder::AddZone(const std::string& name, const char* category, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+	{
+		if (!m_recording)
+			return;
+
+		double ts = std::chrono::duration<double, std::micro>(start - m_start).count();
+		double dur = std::chrono::duration<double, std::micro>(end - start).count();
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_push(name, category, ProcessEditor, m_getThread(), ts, dur);
+	}
+	void TraceRecorder::AddGPU(const std::string& name, unsigned long long start, unsigned long long end)
+	{
+		if (!m_recording || end < start)
+			return;
+
+		// queries that were issued before the recording started
+		double ts = ((long long)start + m_gpuOffset) / 1000.0;
+		if (ts < 0.0)
+			return;
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_push(name, "gpu", ProcessGPU, 0, ts, (end - start) / 1000.0);
+	}
+	void TraceRecorder::EndFrame()
+	{
+		if (!m_recording)
+			return;
+
+		auto now = std::chrono::steady_clock::now();
+		AddZone("Frame " + std::to_string(m_frame), "frame", m_frameStart, now);
+		m_frameStart = now;
+		m_frame++;
+
+		// the clocks drift apart a bit over the recording
+		m_calibrate();
+
+		if (std::chrono::duration<float>(now - m_start).count() >= m_duration)
+			Stop();
+	}
+	int TraceRecorder::m_getThread()
+	{
+		std::thread::id id = std::this_thread::get_id();
+		if (id == m_mainThread)
+			return ThreadMain;
+
+		auto it = m_threads.find(id);
+		if (it != m_threads.end())
+			return it->second;
+
+		int ret = ThreadWorkers + m_threads.size();
+		m_threads[id] = ret;
+		return ret;
+	}
+	void TraceRecorder::m_push(const std::string& name, const char* category, int process, int thread, double start, double duration)
+	{
+		if (m_events.size() >= TRACE_RECORDER_MAX_EVENTS) {
+			m_dropped++;
+			return;
+		}
+
+		// the frame zones are added on the main thread but have their own track
+		if (strcmp(category, "frame") == 0)
+			thread = ThreadFrames;
+
+		Event e;
+		e.Name = name;
+		e.Category = category;
+		e.Process = process;
+		e.Thread = thread;
+		e.Start = start;
+		e.Duration = duration;
+		m_events.push_back(e);
+	}
+	void TraceRecorder::m_calibrate()
+	{
+		if (!GLEW_ARB_timer_query)
+			return;
+
+		GLint64 gpu = 0;
+		glGetInteger64v(GL_TIMESTAMP, &gpu);
+		long long cpu = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count();
+		m_gpuOffset = cpu - (long long)gpu;
+	}
+	bool TraceRecorder::m_write()
+	{
+		std::ofstream out(m_file);
+		if (!out.is_open())
+			return false;
+
+		// every event after the first one starts with a comma
+		out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+		out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << ProcessEditor << ",\"tid\":0,\"args\":{\"name\":\"SHADERed\"}}";
+		writeMetadata(out, "process_name", ProcessGPU, 0, "GPU");
+		writeMetadata(out, "thread_name", ProcessEditor, ThreadFrames, "Frames");
+		writeMetadata(out, "thread_name", ProcessEditor, ThreadMain, "Main thread");
+		for (const auto& thread : m_threads)
+			writeMetadata(out, "thread_name", ProcessEditor, thread.second, "Worker " + std::to_string(thread.second - ThreadWorkers + 1));
+		writeMetadata(out, "thread_name", ProcessGPU, 0, "Passes");
+
+		out.precision(3);
+		out << std::fixed;
+		for (size_t i = 0; i < m_events.size(); i++) {
+			const Event& e = m_events[i];
+			out << ",\n{\"name\":";
+			writeString(out, e.Name);
+			out << ",\"cat\":\"" << e.Category << "\",\"ph\":\"X\",\"pid\":" << e.Process << ",\"tid\":" << e.Thread
+				<< ",\"ts\":" << e.Start << ",\"dur\":" << e.Duration << "}";
+		}
+
+		out << "\n]}\n";
+		return out.good();
+	}
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <chrono>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <unordered_map>
+
+#define TRACE_RECORDER_MAX_EVENTS 2000000 // the rest of the session is dropped, ~100 bytes of JSON each
+
+namespace ed
+{
+	// records the CPU zones of the main loop & the workers, the GPU time of the passes and the frame boundaries
+	// for a few seconds and writes them as Chrome trace events (chrome://tracing, Perfetto)
+	// zones can be added from any thread, Start(), Stop() & EndFrame() are only called from the main thread
+	class TraceRecorder
+	{
+	public:
+		static inline TraceRecorder& Instance()
+		{
+			static TraceRecorder ret;
+			return ret;
+		}
+
+		// measures the time until it goes out of scope - does nothing if the recording wasn't running when it started
+		class Scope
+		{
+		public:
+			inline Scope(const char* name, const char* category) : m_name(name), m_category(category), m_active(TraceRecorder::Instance().IsRecording())
+			{
+				if (m_active)
+					m_start = std::chrono::steady_clock::now();
+			}
+			inline ~Scope()
+			{
+				if (m_active)
+					TraceRecorder::Instance().AddZone(m_name, m_category, m_start, std::chrono::steady_clock::now());
+			}
+
+		private:
+			const char* m_name;
+			const char* m_category;
+			bool m_active;
+			std::chrono::steady_clock::time_point m_start;
+		};
+
+		TraceRecorder();
+
+		void Start(const std::string& file, float seconds);
+		void Stop(); // writes the file
+		inline bool IsRecording() { return m_recording; }
+		float GetRemaining();
+		inline const std::string& GetFile() { return m_file; }
+
+		void AddZone(const std::string& name, const char* category, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+		void AddGPU(const std::string& name, unsigned long long start, unsigned long long end); // GL_TIMESTAMP values
+		void EndFrame();
+
+	private:
+		struct Event
+		{
+			std::string Name;
+			const char* Category;
+			int Process, Thread;
+			double Start, Duration; // microseconds since the start of the recording
+		};
+
+		int m_getThread(); // locked
+		void m_push(const std::string& name, const char* category, int process, int thread, double start, double duration); // locked
+		void m_calibrate();
+		bool m_write();
+
+		std::atomic<bool> m_recording;
+		std::string m_file;
+		float m_duration;
+		std::chrono::steady_clock::time_point m_start, m_frameStart;
+		long long m_gpuOffset; // nanoseconds, GL_TIMESTAMP -> time since m_start
+		int m_frame;
+
+		std::mutex m_mutex;
+		std::vector<Event> m_events;
+		int m_dropped;
+		std::thread::id m_mainThread;
+		std::unordered_map<std::thread::id, int> m_threads;
+	};
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <stdint.h>
+
+#include <SDL2/SDL_events.h>
+
+#define UI_IDLE_TIMEOUT 1000 // ms that the main loop sleeps at most before it checks if it's still idle
+
+namespace ed
+{
+	// wakes up the main loop when it sleeps in SDL_WaitEventTimeout (Settings::General.EventDrivenUI)
+	// Request() can be called from any thread
+	class UIRefresh
+	{
+	public:
+		static inline UIRefresh& Instance()
+		{
+			static UIRefresh ret;
+			return ret;
+		}
+
+		UIRefresh() : m_event((Uint32)-1), m_deadline(INT64_MAX) {}
+
+		// call after SDL_Init()
+		inline void Init() { m_event = SDL_RegisterEvents(1); }
+
+		// delay is in milliseconds, the earliest of the delayed requests wins
+		inline void Request(int delay = 0)
+		{
+			if (delay <= 0) {
+				if (m_event == (Uint32)-1)
+					return;
+
+				SDL_Event event;
+				SDL_memset(&event, 0, sizeof(event));
+				event.type = m_event;
+				SDL_PushEvent(&event);
+				return;
+			}
+
+			int64_t deadline = m_now() + delay;
+			int64_t cur = m_deadline.load();
+			while (deadline < cur && !m_deadline.compare_exchange_weak(cur, deadline));
+		}
+
+		// how long the main loop can sleep
+		inline int GetTimeout(int maxTimeout)
+		{
+			int64_t left = m_deadline.load() - m_now();
+			if (left < 0) return 0;
+			return left < maxTimeout ? (int)left : maxTimeout;
+		}
+
+		// true (once) if a delayed request has expired
+		inline bool IsDue()
+		{
+			int64_t cur = m_deadline.load();
+			if (cur > m_now())
+				return false;
+			return m_deadline.compare_exchange_strong(cur, INT64_MAX);
+		}
+
+	private:
+		static inline int64_t m_now() { return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count(); }
+
+		Uint32 m_event;
+		std::atomic<int64_t> m_deadline;
+	};
+}
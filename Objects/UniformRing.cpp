@@ -0,0 +1,112 @@
+#include "UniformRing.h"
+#include "Logger.h"
+
+#include <string.h>
+
+#define UNIFORM_RING_CHUNK_SIZE (UNIFORM_RING_SIZE / UNIFORM_RING_CHUNKS)
+#define UNIFORM_RING_WAIT_TIMEOUT 1000000000 // ns per glClientWaitSync() call
+
+namespace ed
+{
+	UniformRing::UniformRing()
+	{
+		m_failed = false;
+		m_buffer = 0;
+		m_data = nullptr;
+		m_alignment = 256;
+		m_head = 0;
+		m_chunk = 0;
+		memset(m_fences, 0, sizeof(m_fences));
+	}
+	UniformRing::~UniformRing()
+	{
+		Release();
+	}
+	bool UniformRing::IsSupported()
+	{
+		return GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+	}
+	bool UniformRing::m_init()
+	{
+		if (m_buffer != 0)
+			return true;
+		if (m_failed || !IsSupported())
+			return false;
+
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &m_alignment);
+		if (m_alignment <= 0)
+			m_alignment = 256;
+
+		// coherent -> the memcpy()s are visible to the draws that are issued after them without a flush
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glGenBuffers(1, &m_buffer);
+		glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+		glBufferStorage(GL_UNIFORM_BUFFER, UNIFORM_RING_SIZE, nullptr, flags);
+		m_data = (char*)glMapBufferRange(GL_UNIFORM_BUFFER, 0, UNIFORM_RING_SIZE, flags);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+		if (m_data == nullptr) {
+			Logger::Get().Log("Failed to map the uniform ring buffer, uniform blocks are uploaded with glBufferSubData", true);
+			glDeleteBuffers(1, &m_buffer);
+			m_buffer = 0;
+			m_failed = true;
+			return false;
+		}
+
+		m_head = 0;
+		m_chunk = 0;
+		return true;
+	}
+	bool UniformRing::Write(const void* data, GLsizeiptr size, GLintptr& offset, uint64_t& chunk)
+	{
+		if (size <= 0 || size > UNIFORM_RING_CHUNK_SIZE || !m_init())
+			return false;
+
+		int index = m_chunk % UNIFORM_RING_CHUNKS;
+		GLsizeiptr chunkEnd = (GLsizeiptr)(index + 1) * UNIFORM_RING_CHUNK_SIZE;
+		GLsizeiptr start = (m_head + m_alignment - 1) / m_alignment * m_alignment;
+
+		// the writes never straddle two chunks
+		if (start + size > chunkEnd) {
+			m_fences[index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+			m_chunk++;
+			index = m_chunk % UNIFORM_RING_CHUNKS;
+			start = (GLsizeiptr)index * UNIFORM_RING_CHUNK_SIZE;
+
+			// the slices of this chunk were last bound before the writes left the chunk that came UNIFORM_RING_REUSE after it
+			int last = (m_chunk + UNIFORM_RING_REUSE) % UNIFORM_RING_CHUNKS;
+			if (m_fences[last] != 0) {
+				GLenum status = GL_TIMEOUT_EXPIRED;
+				while (status == GL_TIMEOUT_EXPIRED)
+					status = glClientWaitSync(m_fences[last], GL_SYNC_FLUSH_COMMANDS_BIT, UNIFORM_RING_WAIT_TIMEOUT);
+				glDeleteSync(m_fences[last]);
+				m_fences[last] = 0;
+			}
+		}
+
+		memcpy(m_data + start, data, size);
+		m_head = start + size;
+
+		offset = start;
+		chunk = m_chunk;
+		return true;
+	}
+	void UniformRing::Release()
+	{
+		for (int i = 0; i < UNIFORM_RING_CHUNKS; i++) {
+			if (m_fences[i] != 0)
+				glDeleteSync(m_fences[i]);
+			m_fences[i] = 0;
+		}
+
+		if (m_buffer != 0) {
+			glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+			glUnmapBuffer(GL_UNIFORM_BUFFER);
+			glBindBuffer(GL_UNIFORM_BUFFER, 0);
+			glDeleteBuffers(1, &m_buffer);
+		}
+		m_buffer = 0;
+		m_data = nullptr;
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/glew.h>
+#if defined(__APPLE__)
+	#include <OpenGL/gl.h>
+#else
+	#include <GL/gl.h>
+#endif
+
+#define UNIFORM_RING_SIZE (4 * 1024 * 1024) // bytes
+#define UNIFORM_RING_CHUNKS 8 // each chunk is fenced once the writes move on to the next one
+#define UNIFORM_RING_REUSE 4 // chunks after the one it was written to in which a slice can still be bound again
+
+namespace ed
+{
+	// persistently mapped buffer that the uniform blocks of the draws are streamed into - the writes go linearly through
+	// the chunks & a chunk is only written again once the GPU finished the commands that could still read from it
+	class UniformRing
+	{
+	public:
+		static inline UniformRing& Instance()
+		{
+			static UniformRing ret;
+			return ret;
+		}
+
+		UniformRing();
+		~UniformRing();
+
+		static bool IsSupported();
+
+		// copies the data into the ring, false if it has to be uploaded the old way - [offset, offset + size) of
+		// GetBuffer() can be bound for as long as IsAlive(chunk) returns true
+		bool Write(const void* data, GLsizeiptr size, GLintptr& offset, uint64_t& chunk);
+		inline bool IsAlive(uint64_t chunk) { return m_buffer != 0 && m_chunk - chunk <= UNIFORM_RING_REUSE; }
+		inline GLuint GetBuffer() { return m_buffer; }
+
+		void Release(); // before the GL context is destroyed
+
+	private:
+		bool m_init();
+		bool m_failed;
+
+		GLuint m_buffer;
+		char* m_data;
+		GLint m_alignment;
+
+		GLsizeiptr m_head; // where the next write can start
+		uint64_t m_chunk; // chunks entered so far, m_chunk % UNIFORM_RING_CHUNKS is being written
+		GLsync m_fences[UNIFORM_RING_CHUNKS]; // [i] is placed when the writes leave the chunk i
+	};
+}
@@ -1,10 +1,10 @@
 #include "UpdateChecker.h"
+#include "UIRefresh.h"
 #include <SFML/Network.hpp>
-#include <thread>
 
 namespace ed
 {
-	void checkUpdates(std::function<void()> onUpdate)
+	static bool checkUpdates()
 	{
 		sf::Http http("http://api.shadered.org");
 		sf::Http::Request request;
@@ -24,26 +24,36 @@ namespace ed
 
 			if (isAllDigits && src.size() > 0 && src.size() < 6) {
 				int ver = std::stoi(src);
-				if (ver > UpdateChecker::MyVersion && onUpdate != nullptr) 
-					onUpdate();
+				return ver > UpdateChecker::MyVersion;
 			}
 		}
+
+		return false;
 	}
 	UpdateChecker::UpdateChecker()
 	{
-		m_thread = nullptr;
 	}
 	UpdateChecker::~UpdateChecker()
 	{
-		if (m_thread != nullptr && m_thread->joinable())
-			m_thread->join();
-		delete m_thread;
+		// the request can't be interrupted but its result is thrown away
+		m_token.Cancel();
 	}
 	void UpdateChecker::CheckForUpdates(std::function<void()> onUpdate)
 	{
-		if (m_thread != nullptr && m_thread->joinable())
-			m_thread->join();
-		delete m_thread;
-		m_thread = new std::thread(checkUpdates, onUpdate);
+		m_token.Cancel();
+		m_token = eng::CancelToken::Create();
+
+		eng::CancelToken token = m_token;
+		eng::JobScheduler::Instance().Add([onUpdate, token]() {
+			if (!checkUpdates() || token.IsCancelled())
+				return;
+
+			eng::JobScheduler::Instance().Complete([onUpdate, token]() {
+				if (token.IsCancelled() || onUpdate == nullptr)
+					return;
+				onUpdate();
+			});
+			UIRefresh::Instance().Request(); // show the notification
+		}, eng::JobPriority::Background, token);
 	}
 }
\ No newline at end of file
@@ -1,6 +1,6 @@
 #pragma once
 #include <functional>
-#include <thread>
+#include "../Engine/JobScheduler.h"
 
 namespace ed
 {
@@ -12,9 +12,9 @@ namespace ed
 		UpdateChecker();
 		~UpdateChecker();
 
-		void CheckForUpdates(std::function<void()> onUpdate);
+		void CheckForUpdates(std::function<void()> onUpdate); // onUpdate is called on the GL thread, see JobScheduler::RunCompletions()
 
 	private:
-		std::thread* m_thread;
+		eng::CancelToken m_token;
 	};
-}
\ No newline at end of file
+}
@@ -0,0 +1,56 @@
+#include "VAOCache.h"
+#include "../Engine/GLUtils.h"
+
+namespace ed
+{
+	GLuint VAOCache::Get(GLuint vbo, const std::vector<InputLayoutItem>& inp, GLuint ebo, GLuint instanceVBO, const std::vector<ShaderVariable::ValueType>& instanceFormat)
+	{
+		std::vector<InputLayoutValue> layout(inp.size());
+		for (int i = 0; i < inp.size(); i++)
+			layout[i] = inp[i].Value;
+
+		// the format only matters if there's an instance buffer
+		std::vector<ShaderVariable::ValueType> format;
+		if (instanceVBO != 0)
+			format = instanceFormat;
+
+		for (auto& entry : m_entries)
+			if (entry.VBO == vbo && entry.EBO == ebo && entry.InstanceVBO == instanceVBO && entry.Layout == layout && entry.InstanceFormat == format) {
+				entry.References++;
+				return entry.VAO;
+			}
+
+		Entry entry;
+		entry.VBO = vbo;
+		entry.EBO = ebo;
+		entry.InstanceVBO = instanceVBO;
+		entry.Layout = layout;
+		entry.InstanceFormat = format;
+		entry.VAO = 0;
+		entry.References = 1;
+		gl::CreateVAO(entry.VAO, vbo, inp, ebo, instanceVBO, format);
+
+		m_entries.push_back(entry);
+
+		return entry.VAO;
+	}
+	void VAOCache::Release(GLuint vao)
+	{
+		if (vao == 0)
+			return;
+
+		for (int i = 0; i < m_entries.size(); i++) {
+			if (m_entries[i].VAO != vao)
+				continue;
+
+			m_entries[i].References--;
+			if (m_entries[i].References <= 0) {
+				glDeleteVertexArrays(1, &vao);
+				m_entries.erase(m_entries.begin() + i);
+			}
+			return;
+		}
+
+		glDeleteVertexArrays(1, &vao);
+	}
+}
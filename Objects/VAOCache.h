@@ -0,0 +1,57 @@
+#pragma once
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/glew.h>
+#if defined(__APPLE__)
+	#include <OpenGL/gl.h>
+#else
+	#include <GL/gl.h>
+#endif
+
+#include "InputLayout.h"
+#include "ShaderVariable.h"
+
+namespace ed
+{
+	// VAOs shared by every item that reads the same buffers with the same input layout - e.g. instanced
+	// geometry fed from one BufferObject or a model that's used by many items
+	class VAOCache
+	{
+	public:
+		static inline VAOCache& Instance()
+		{
+			static VAOCache ret;
+			return ret;
+		}
+
+		// every Get() has to be paired with a Release()
+		GLuint Get(GLuint vbo, const std::vector<InputLayoutItem>& inp, GLuint ebo = 0, GLuint instanceVBO = 0, const std::vector<ShaderVariable::ValueType>& instanceFormat = std::vector<ShaderVariable::ValueType>());
+		void Release(GLuint vao); // VAOs that weren't created by the cache are deleted
+
+		// replaces vao with the one for the new buffers & layout
+		inline void Rebuild(GLuint& vao, GLuint vbo, const std::vector<InputLayoutItem>& inp, GLuint ebo = 0, GLuint instanceVBO = 0, const std::vector<ShaderVariable::ValueType>& instanceFormat = std::vector<ShaderVariable::ValueType>())
+		{
+			GLuint old = vao;
+			vao = Get(vbo, inp, ebo, instanceVBO, instanceFormat);
+			Release(old);
+		}
+
+		inline int GetCount() { return m_entries.size(); }
+
+	private:
+		struct Entry
+		{
+			GLuint VBO, EBO, InstanceVBO;
+			std::vector<InputLayoutValue> Layout;
+			std::vector<ShaderVariable::ValueType> InstanceFormat;
+
+			GLuint VAO;
+			int References;
+		};
+
+		std::vector<Entry> m_entries;
+	};
+}
@@ -0,0 +1,191 @@
+#include "VertexCapture.h"
+#include "ObjectManager.h"
+#include "InputLayout.h"
+
+#include <sstream>
+
+namespace ed
+{
+	static std::string trim(const std::string& str)
+	{
+		size_t first = str.find_first_not_of(" \t");
+		if (first == std::string::npos)
+			return "";
+		size_t last = str.find_last_not_of(" \t");
+		return str.substr(first, last - first + 1);
+	}
+	static int getComponentCount(GLenum type)
+	{
+		switch (type) {
+		case GL_FLOAT: return 1;
+		case GL_FLOAT_VEC2: return 2;
+		case GL_FLOAT_VEC3: return 3;
+		case GL_FLOAT_VEC4: return 4;
+		}
+		return 0; // the consumers read floats
+	}
+
+	VertexCapture::VertexCapture()
+	{
+		m_active = 0;
+		m_paused = false;
+	}
+	VertexCapture::~VertexCapture()
+	{
+		Clear();
+	}
+	bool VertexCapture::IsSupported()
+	{
+		// transform feedback objects, glDrawTransformFeedback & gl_SkipComponents
+		return GLEW_ARB_transform_feedback2 && GLEW_ARB_transform_feedback3;
+	}
+	bool VertexCapture::IsCaptured(GLenum topology)
+	{
+		// the ones that glBeginTransformFeedback(GL_TRIANGLES) accepts
+		return topology == GL_TRIANGLES || topology == GL_TRIANGLE_STRIP || topology == GL_TRIANGLE_FAN;
+	}
+	std::vector<std::string> VertexCapture::GetVaryings(const std::string& outputs)
+	{
+		std::vector<std::string> names;
+		std::stringstream ss(outputs);
+		std::string name;
+		while (std::getline(ss, name, ';'))
+			names.push_back(trim(name));
+
+		std::vector<std::string> ret;
+		bool captured = false;
+		for (int i = 0; i < (int)InputLayoutValue::MaxCount; i++) {
+			std::string varying = i < names.size() ? names[i] : "";
+			captured |= !varying.empty();
+
+			// keeps the stride of every vertex at VERTEX_CAPTURE_STRIDE
+			if (varying.empty())
+				varying = "gl_SkipComponents" + std::to_string(InputLayoutItem::GetValueSize((InputLayoutValue)i));
+			ret.push_back(varying);
+		}
+
+		if (!captured)
+			ret.clear();
+		return ret;
+	}
+	bool VertexCapture::Check(GLuint program, const std::vector<std::string>& varyings, std::string& error)
+	{
+		GLint linked = GL_FALSE;
+		glGetProgramiv(program, GL_LINK_STATUS, &linked);
+		if (!linked) {
+			GLchar msg[1024] = { 0 };
+			glGetProgramInfoLog(program, sizeof(msg), nullptr, msg);
+			error = "Failed to link the captured outputs: " + std::string(msg);
+			return false;
+		}
+
+		GLint count = 0;
+		glGetProgramiv(program, GL_TRANSFORM_FEEDBACK_VARYINGS, &count);
+		for (int i = 0; i < count && i < varyings.size(); i++) {
+			if (varyings[i].find("gl_SkipComponents") == 0)
+				continue;
+
+			GLchar name[256];
+			GLsizei size = 0;
+			GLenum type = GL_NONE;
+			glGetTransformFeedbackVarying(program, i, sizeof(name), nullptr, &size, &type, name);
+
+			int expected = InputLayoutItem::GetValueSize((InputLayoutValue)i);
+			if (size != 1 || getComponentCount(type) != expected) {
+				error = "The captured output " + varyings[i] + " has to be a " + (expected == 2 ? "vec2" : (expected == 3 ? "vec3" : "vec4"));
+				return false;
+			}
+		}
+
+		return true;
+	}
+	int VertexCapture::GetVertexCount(BufferObject* buffer)
+	{
+		return buffer == nullptr ? 0 : buffer->Size / (VERTEX_CAPTURE_STRIDE * sizeof(GLfloat));
+	}
+	void VertexCapture::Begin(BufferObject* buffer)
+	{
+		if (m_active != 0 || GetVertexCount(buffer) == 0)
+			return;
+
+		GLuint& feedback = m_feedbacks[buffer->ID];
+		if (feedback == 0)
+			glGenTransformFeedbacks(1, &feedback);
+
+		// the write offset starts at 0 again, the vertices that don't fit are dropped
+		glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, feedback);
+		glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, buffer->ID);
+		glBeginTransformFeedback(GL_TRIANGLES);
+
+		m_active = feedback;
+		m_paused = false;
+	}
+	void VertexCapture::End()
+	{
+		if (m_active == 0)
+			return;
+
+		glEndTransformFeedback();
+		glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, 0);
+		m_active = 0;
+		m_paused = false;
+	}
+	void VertexCapture::Pause()
+	{
+		if (m_active != 0 && !m_paused) {
+			glPauseTransformFeedback();
+			m_paused = true;
+		}
+	}
+	void VertexCapture::Resume()
+	{
+		if (m_active != 0 && m_paused) {
+			glResumeTransformFeedback();
+			m_paused = false;
+		}
+	}
+	void VertexCapture::Draw(BufferObject* buffer, GLenum topology, bool instanced, int instanceCount)
+	{
+		auto feedback = m_feedbacks.find(buffer->ID);
+
+		// can't draw from its own capture
+		if (feedback != m_feedbacks.end() && feedback->second == m_active)
+			return;
+
+		bool pause = m_active != 0 && !m_paused && !IsCaptured(topology);
+		if (pause)
+			Pause();
+
+		if (feedback == m_feedbacks.end() || (instanced && !GLEW_ARB_transform_feedback_instanced)) {
+			int count = GetVertexCount(buffer);
+			if (instanced)
+				glDrawArraysInstanced(topology, 0, count, instanceCount);
+			else
+				glDrawArrays(topology, 0, count);
+		} else if (instanced)
+			glDrawTransformFeedbackInstanced(topology, feedback->second, instanceCount);
+		else
+			glDrawTransformFeedback(topology, feedback->second);
+
+		if (pause)
+			Resume();
+	}
+	void VertexCapture::Release(GLuint buffer)
+	{
+		auto feedback = m_feedbacks.find(buffer);
+		if (feedback == m_feedbacks.end())
+			return;
+
+		if (feedback->second == m_active)
+			End();
+		glDeleteTransformFeedbacks(1, &feedback->second);
+		m_feedbacks.erase(feedback);
+	}
+	void VertexCapture::Clear()
+	{
+		End();
+		for (const auto& feedback : m_feedbacks)
+			glDeleteTransformFeedbacks(1, &feedback.second);
+		m_feedbacks.clear();
+	}
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/glew.h>
+#if defined(__APPLE__)
+	#include <OpenGL/gl.h>
+#else
+	#include <GL/gl.h>
+#endif
+
+#define VERTEX_CAPTURE_STRIDE 18 // floats per captured vertex, the layout of the built-in geometry (see InputLayoutItem::GetValueOffset())
+
+namespace ed
+{
+	struct BufferObject;
+
+	// transform feedback of a shader pass - the outputs that pipe::ShaderPass::CaptureOutputs lists are written to the pass'
+	// CaptureBuffer in the layout of the built-in geometry, so the later passes draw them as Captured geometry items through
+	// their own input layout and the displacement/skinning/... of the vertex shader only runs once per frame
+	// the captured vertices are drawn with glDrawTransformFeedback, the vertex count is never read back
+	// only triangles are captured (a geometry shader has to output triangle strips), the other topologies are drawn but skipped
+	class VertexCapture
+	{
+	public:
+		VertexCapture();
+		~VertexCapture();
+
+		static bool IsSupported();
+		static bool IsCaptured(GLenum topology); // the topologies that a capture takes, the others are drawn while it's paused
+
+		// the names for glTransformFeedbackVaryings() - CaptureOutputs has an output per InputLayoutValue (position, normal,
+		// texcoord, tangent, binormal, color), the values with an empty name aren't written - empty if nothing is captured
+		static std::vector<std::string> GetVaryings(const std::string& outputs);
+
+		// the program was linked with GetVaryings() - false if the outputs don't exist or don't have the size of their values
+		static bool Check(GLuint program, const std::vector<std::string>& varyings, std::string& error);
+
+		static int GetVertexCount(BufferObject* buffer); // vertices that fit in the buffer
+
+		// the bound program has to be linked with GetVaryings(), changes the GL_TRANSFORM_FEEDBACK binding
+		void Begin(BufferObject* buffer);
+		void End();
+		inline bool IsActive() { return m_active != 0; }
+
+		// around the draws that aren't triangles or that switch the program
+		void Pause();
+		void Resume();
+
+		// binds nothing, the geometry item's VAO has to be bound - without a capture (a compute shader wrote the buffer) the
+		// whole buffer is drawn
+		void Draw(BufferObject* buffer, GLenum topology, bool instanced, int instanceCount);
+
+		void Release(GLuint buffer); // the buffer was deleted
+		void Clear();
+
+	private:
+		std::unordered_map<GLuint, GLuint> m_feedbacks; // buffer -> transform feedback object that holds its last capture
+		GLuint m_active;
+		bool m_paused;
+	};
+}
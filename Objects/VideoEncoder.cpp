@@ -0,0 +1,293 @@
+#include "VideoEncoder.h"
+#include "Logger.h"
+
+#include <algorithm>
+
+#if defined(_WIN32)
+	#include <windows.h>
+	#include <ghc/filesystem.hpp>
+#else
+	#include <spawn.h>
+	#include <signal.h>
+	#include <unistd.h>
+	#include <fcntl.h>
+	#include <errno.h>
+	#include <sys/wait.h>
+	extern char** environ;
+#endif
+
+namespace ed
+{
+	static std::string getCommandLine(const std::vector<std::string>& args)
+	{
+		// only shown in the log
+		std::string ret = "ffmpeg";
+		for (const auto& arg : args)
+			ret += " " + arg;
+		return ret;
+	}
+
+#if defined(_WIN32)
+	// CommandLineToArgvW's rules - backslashes only have to be escaped in front of a quote
+	static std::wstring quoteArgument(const std::wstring& arg)
+	{
+		if (!arg.empty() && arg.find_first_of(L" \t\n\v\"") == std::wstring::npos)
+			return arg;
+
+		std::wstring ret = L"\"";
+		for (size_t i = 0;; i++) {
+			size_t slashes = 0;
+			while (i < arg.size() && arg[i] == L'\\') {
+				slashes++;
+				i++;
+			}
+
+			if (i == arg.size()) {
+				ret.append(slashes * 2, L'\\');
+				break;
+			} else if (arg[i] == L'"') {
+				ret.append(slashes * 2 + 1, L'\\');
+				ret += L'"';
+			} else {
+				ret.append(slashes, L'\\');
+				ret += arg[i];
+			}
+		}
+		ret += L'"';
+
+		return ret;
+	}
+	static bool startFFmpeg(const std::vector<std::string>& args, HANDLE* input, HANDLE& process)
+	{
+		// the arguments are UTF-8
+		std::wstring cmd = L"ffmpeg";
+		for (const auto& arg : args)
+			cmd += L" " + quoteArgument(ghc::filesystem::path(arg).wstring());
+
+		STARTUPINFOW si = {};
+		si.cb = sizeof(si);
+
+		HANDLE pipeRead = nullptr, pipeWrite = nullptr;
+		if (input != nullptr) {
+			SECURITY_ATTRIBUTES sa = { sizeof(SECURITY_ATTRIBUTES), nullptr, TRUE };
+			if (!CreatePipe(&pipeRead, &pipeWrite, &sa, 0))
+				return false;
+			SetHandleInformation(pipeWrite, HANDLE_FLAG_INHERIT, 0); // only the read end belongs to ffmpeg
+
+			si.dwFlags = STARTF_USESTDHANDLES;
+			si.hStdInput = pipeRead;
+			si.hStdOutput = GetStdHandle(STD_OUTPUT_HANDLE);
+			si.hStdError = GetStdHandle(STD_ERROR_HANDLE);
+		}
+
+		PROCESS_INFORMATION pi = {};
+		BOOL started = CreateProcessW(nullptr, &cmd[0], nullptr, nullptr, TRUE, 0, nullptr, nullptr, &si, &pi);
+
+		if (pipeRead != nullptr)
+			CloseHandle(pipeRead);
+		if (!started) {
+			if (pipeWrite != nullptr)
+				CloseHandle(pipeWrite);
+			return false;
+		}
+
+		CloseHandle(pi.hThread);
+		process = pi.hProcess;
+		if (input != nullptr)
+			*input = pipeWrite;
+
+		return true;
+	}
+	static int waitFFmpeg(HANDLE process)
+	{
+		DWORD code = 1;
+		WaitForSingleObject(process, INFINITE);
+		GetExitCodeProcess(process, &code);
+		CloseHandle(process);
+		return code;
+	}
+#else
+	static bool startFFmpeg(const std::vector<std::string>& args, int* input, int& process)
+	{
+		int fds[2] = { -1, -1 };
+		if (input != nullptr) {
+			if (pipe(fds) != 0)
+				return false;
+
+			// other processes that are started later must not keep ffmpeg's input open
+			fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+			fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+		}
+
+		posix_spawn_file_actions_t actions;
+		posix_spawn_file_actions_init(&actions);
+		if (input != nullptr)
+			posix_spawn_file_actions_adddup2(&actions, fds[0], STDIN_FILENO);
+
+		// SIGPIPE is ignored by the editor, ffmpeg gets the default behaviour back
+		posix_spawnattr_t attr;
+		posix_spawnattr_init(&attr);
+		sigset_t defaults;
+		sigemptyset(&defaults);
+		sigaddset(&defaults, SIGPIPE);
+		posix_spawnattr_setsigdefault(&attr, &defaults);
+		posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGDEF);
+
+		std::vector<char*> argv;
+		argv.push_back((char*)"ffmpeg");
+		for (const auto& arg : args)
+			argv.push_back((char*)arg.c_str());
+		argv.push_back(nullptr);
+
+		pid_t pid = 0;
+		int err = posix_spawnp(&pid, "ffmpeg", &actions, &attr, argv.data(), environ);
+
+		posix_spawnattr_destroy(&attr);
+		posix_spawn_file_actions_destroy(&actions);
+
+		if (input != nullptr) {
+			close(fds[0]);
+			if (err == 0)
+				*input = fds[1];
+			else
+				close(fds[1]);
+		}
+		process = pid;
+
+		return err == 0;
+	}
+	static int waitFFmpeg(int process)
+	{
+		int status = 0;
+		while (waitpid(process, &status, 0) < 0)
+			if (errno != EINTR)
+				return -1;
+		return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+	}
+#endif
+
+	VideoEncoder::VideoEncoder()
+	{
+		m_started = false;
+		m_process = 0;
+		m_input = 0;
+		m_frameSize = 0;
+		m_failed = false;
+	}
+	VideoEncoder::~VideoEncoder()
+	{
+		Close();
+	}
+	int VideoEncoder::RunFFmpeg(const std::vector<std::string>& args)
+	{
+		Logger::Get().Log("Running " + getCommandLine(args));
+
+#if defined(_WIN32)
+		HANDLE process = nullptr;
+#else
+		int process = 0;
+#endif
+		if (!startFFmpeg(args, nullptr, process)) {
+			Logger::Get().Log("Failed to start ffmpeg - make sure that it is installed and in your PATH", true);
+			return -1;
+		}
+
+		return waitFFmpeg(process);
+	}
+	bool VideoEncoder::Open(const std::string& file, int width, int height, int fps, const std::string& codec, int bitrate, const std::string& pixelFormat)
+	{
+		Close();
+
+		m_frameSize = (size_t)width * height * 4;
+		m_failed = false;
+
+		std::vector<std::string> args = {
+			"-y", "-loglevel", "error", "-f", "rawvideo", "-pix_fmt", "rgba",
+			"-s", std::to_string(width) + "x" + std::to_string(height),
+			"-r", std::to_string(fps),
+			"-i", "-",
+			"-vf", "vflip", // rows come straight from glGetTexImage (bottom to top)
+			"-c:v", codec
+		};
+		if (bitrate > 0) {
+			args.push_back("-b:v");
+			args.push_back(std::to_string(bitrate) + "k");
+		}
+		args.push_back("-pix_fmt");
+		args.push_back(pixelFormat);
+		args.push_back(file);
+
+		Logger::Get().Log("Starting the video encoder: " + getCommandLine(args));
+
+#if !defined(_WIN32)
+		// ffmpeg can exit before it read every frame (missing codec, bad path, ...) - the write then fails with EPIPE
+		// instead of killing the editor
+		signal(SIGPIPE, SIG_IGN);
+#endif
+
+		if (!startFFmpeg(args, &m_input, m_process)) {
+			Logger::Get().Log("Failed to start ffmpeg - make sure that it is installed and in your PATH", true);
+			return false;
+		}
+		m_started = true;
+
+		return true;
+	}
+	bool VideoEncoder::Write(const unsigned char* pixels)
+	{
+		if (!m_started || m_failed)
+			return false;
+
+		size_t written = 0;
+		while (written < m_frameSize) {
+#if defined(_WIN32)
+			DWORD count = 0;
+			if (!WriteFile(m_input, pixels + written, (DWORD)std::min<size_t>(m_frameSize - written, 1 << 30), &count, nullptr)) {
+				DWORD err = GetLastError();
+				m_failed = true;
+				Logger::Get().Log(err == ERROR_BROKEN_PIPE || err == ERROR_NO_DATA ? "The video encoder exited before the video was finished" : "Failed to send a frame to the video encoder", true);
+				return false;
+			}
+#else
+			ssize_t count = write(m_input, pixels + written, m_frameSize - written);
+			if (count < 0) {
+				if (errno == EINTR)
+					continue;
+				m_failed = true;
+				Logger::Get().Log(errno == EPIPE ? "The video encoder exited before the video was finished" : "Failed to send a frame to the video encoder", true);
+				return false;
+			}
+#endif
+			written += count;
+		}
+
+		return true;
+	}
+	bool VideoEncoder::Close()
+	{
+		if (!m_started)
+			return false;
+		m_started = false;
+
+		// ffmpeg finishes the file once its input is closed
+#if defined(_WIN32)
+		CloseHandle(m_input);
+#else
+		close(m_input);
+#endif
+		int ret = waitFFmpeg(m_process);
+		m_process = 0;
+		m_input = 0;
+
+		if (ret != 0) {
+			Logger::Get().Log("Video encoder exited with an error (" + std::to_string(ret) + ")", true);
+			return false;
+		}
+		if (m_failed)
+			return false;
+
+		Logger::Get().Log("Video encoder finished");
+
+		return true;
+	}
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <string>
+#include <vector>
+
+namespace ed
+{
+	// streams raw RGBA frames to an ffmpeg process - it is started with an argument list, never through a shell, so
+	// the paths can contain any character
+	class VideoEncoder
+	{
+	public:
+		VideoEncoder();
+		~VideoEncoder();
+
+		bool Open(const std::string& file, int width, int height, int fps, const std::string& codec, int bitrate, const std::string& pixelFormat); // bitrate in kbit/s
+		bool Write(const unsigned char* pixels); // width * height * 4 bytes, false once ffmpeg is gone
+		bool Close();
+
+		inline bool IsOpen() { return m_started; }
+
+		static int RunFFmpeg(const std::vector<std::string>& args); // waits for it to finish - the exit code, -1 if it didn't start
+
+	private:
+		bool m_started;
+#if defined(_WIN32)
+		void* m_process; // HANDLEs
+		void* m_input;
+#else
+		int m_process; // pid
+		int m_input;
+#endif
+		size_t m_frameSize;
+		bool m_failed;
+	};
+}
@@ -0,0 +1,432 @@
+#include "VirtualTexture.h"
+#include "Logger.h"
+#include "Hash.h"
+
+#include <fstream>
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <ghc/filesystem.hpp>
+#include <stb/stb_image.h>
+
+#define VIRTUAL_TEXTURE_CACHE_DIR "./data/cache/"
+#define VIRTUAL_TEXTURE_MAGIC 0x54565345 // ESVT
+#define VIRTUAL_TEXTURE_VERSION 1
+
+namespace ed
+{
+	// followed by the RGBA8 tiles of every level, row by row - the tiles on the right & bottom edge repeat the last texel
+	struct TileFileHeader
+	{
+		uint32_t Magic, Version;
+		int32_t Width, Height;
+		int32_t PageX, PageY;
+		int32_t Levels;
+	};
+
+	// position after the #version and #extension directives
+	static size_t getDeclarationStart(const std::string& code)
+	{
+		size_t declPos = 0;
+		size_t dirPos = 0;
+		while ((dirPos = code.find('#', dirPos)) != std::string::npos) {
+			size_t lineEnd = code.find('\n', dirPos);
+			lineEnd = lineEnd == std::string::npos ? code.size() : lineEnd + 1;
+			if (code.compare(dirPos, 8, "#version") == 0 || code.compare(dirPos, 10, "#extension") == 0)
+				declPos = lineEnd;
+			dirPos = lineEnd;
+		}
+		return declPos;
+	}
+
+	VirtualTexture::VirtualTexture()
+	{
+		m_texture = 0;
+		m_size = m_pageSize = glm::ivec2(0, 0);
+		m_sparseLevels = 0;
+		m_dirtyStart = m_dirtyEnd = 0;
+	}
+	bool VirtualTexture::IsSupported()
+	{
+		return GLEW_ARB_sparse_texture && GLEW_ARB_texture_storage && GLEW_ARB_shader_storage_buffer_object;
+	}
+	int VirtualTexture::Instrument(std::string& glsl)
+	{
+		if (glsl.find("SHADERed_VirtualLod") == std::string::npos)
+			return 0;
+
+		// one line so that the line numbers only move by one - the first level that is resident at or above lod
+		std::string helper = "layout(std430) buffer " VIRTUAL_TEXTURE_BLOCK_NAME " { uvec4 _sed_vt_header; uvec4 _sed_vt_info[" + std::to_string(VIRTUAL_TEXTURE_MAX_OBJECTS) + "]; uint _sed_vt_pages[]; };";
+		helper += " float SHADERed_VirtualLod(uint tex, vec2 uv, float lod) { uvec4 info = _sed_vt_info[tex]; uvec2 page = uvec2(info.w & 4095u, (info.w >> 12u) & 4095u);";
+		helper += " int levels = int(info.w >> 24u); int want = clamp(int(lod), 0, levels); uint first = info.x; uint frame = _sed_vt_header.x;";
+		helper += " for (int i = 0; i < levels; i++) { uvec2 size = max(info.yz >> uint(i), uvec2(1u)); uvec2 count = (size + page - 1u) / page;";
+		helper += " if (i >= want) { uvec2 p = min(uvec2(fract(uv) * vec2(size)) / page, count - 1u); uint at = first + p.y * count.x + p.x; uint w = _sed_vt_pages[at];";
+		helper += " if (i == want && (w & 0x7fffffffu) < frame) atomicMax(_sed_vt_pages[at], (w & 0x80000000u) | frame);";
+		helper += " if ((w & 0x80000000u) != 0u) return max(float(i), lod); }";
+		helper += " first += count.x * count.y; } return max(float(levels), lod); }\n";
+
+		glsl.insert(getDeclarationStart(glsl), helper);
+
+		return 1;
+	}
+	bool VirtualTexture::Open(const std::string& path, GLuint tex, eng::ThreadPool& pool)
+	{
+		m_texture = tex;
+
+		int channels = 0;
+		if (!stbi_info(path.c_str(), &m_size.x, &m_size.y, &channels)) {
+			m_error = "Failed to read the image";
+			return false;
+		}
+
+		GLint maxSize = 0, pageX = 0, pageY = 0;
+		glGetIntegerv(GL_MAX_SPARSE_TEXTURE_SIZE_ARB, &maxSize);
+		glGetInternalformativ(GL_TEXTURE_2D, GL_RGBA8, GL_VIRTUAL_PAGE_SIZE_X_ARB, 1, &pageX);
+		glGetInternalformativ(GL_TEXTURE_2D, GL_RGBA8, GL_VIRTUAL_PAGE_SIZE_Y_ARB, 1, &pageY);
+		if (pageX <= 0 || pageY <= 0) {
+			m_error = "The GPU doesn't support sparse RGBA8 textures";
+			return false;
+		}
+		if (m_size.x > maxSize || m_size.y > maxSize) {
+			m_error = "The image is larger than the largest sparse texture (" + std::to_string(maxSize) + ")";
+			return false;
+		}
+		m_pageSize = glm::ivec2(pageX, pageY);
+
+		int levelCount = 1;
+		while ((std::max(m_size.x, m_size.y) >> levelCount) > 0)
+			levelCount++;
+
+		GLint sparseLevels = 0;
+		glBindTexture(GL_TEXTURE_2D, tex);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SPARSE_ARB, GL_TRUE);
+		glTexParameteri(GL_TEXTURE_2D, GL_VIRTUAL_PAGE_SIZE_INDEX_ARB, 0);
+		glTexStorage2D(GL_TEXTURE_2D, levelCount, GL_RGBA8, m_size.x, m_size.y);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glGetTexParameteriv(GL_TEXTURE_2D, GL_NUM_SPARSE_LEVELS_ARB, &sparseLevels);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		m_sparseLevels = std::min<int>(sparseLevels, levelCount);
+
+		int tiles = 0;
+		m_levels.resize(levelCount);
+		for (int i = 0; i < levelCount; i++) {
+			Level& level = m_levels[i];
+			level.First = tiles;
+			level.Size = glm::max(m_size >> i, glm::ivec2(1));
+			level.Pages = (level.Size + m_pageSize - 1) / m_pageSize;
+			tiles += level.Pages.x * level.Pages.y;
+
+			if (i + 1 == m_sparseLevels)
+				m_words.resize(tiles, 0);
+		}
+		m_loading.resize(m_words.size(), false);
+		ClearDirty();
+
+		// the tile file is rebuilt when the image changes
+		std::error_code ec;
+		uint64_t hash = HashString(ghc::filesystem::absolute(path, ec).string());
+		hash = HashString(std::to_string(ghc::filesystem::file_size(path, ec)), hash);
+		hash = HashString(std::to_string(ghc::filesystem::last_write_time(path, ec).time_since_epoch().count()), hash);
+		hash = HashString(std::to_string(m_pageSize.x) + "x" + std::to_string(m_pageSize.y), hash);
+
+		char name[17] = { 0 };
+		snprintf(name, 17, "%016llx", (unsigned long long)hash);
+		m_cache = std::string(VIRTUAL_TEXTURE_CACHE_DIR) + name + ".svt";
+
+		if (m_openTiles())
+			return true;
+
+		// the first time this image is used - the whole image is decoded once on a loader thread
+		Logger::Get().Log("Building the tiles of " + path + " ...");
+
+		std::shared_ptr<BuildJob> job = m_build = std::make_shared<BuildJob>();
+		job->Source = path;
+		job->Cache = m_cache;
+		job->PageSize = m_pageSize;
+		job->Done = false;
+		pool.Add([job]() {
+			m_buildTiles(job.get());
+			job->Done = true;
+		});
+
+		return true;
+	}
+	void VirtualTexture::m_buildTiles(BuildJob* job)
+	{
+		int width = 0, height = 0, channels = 0;
+		unsigned char* data = stbi_load(job->Source.c_str(), &width, &height, &channels, 4);
+		if (data == nullptr) {
+			job->Error = "failed to decode " + job->Source;
+			return;
+		}
+
+		std::vector<unsigned char> pixels(data, data + (size_t)width * height * 4);
+		stbi_image_free(data);
+
+		std::error_code ec;
+		ghc::filesystem::create_directories(VIRTUAL_TEXTURE_CACHE_DIR, ec);
+
+		// written under another name so that a half written file is never opened
+		std::string tempPath = job->Cache + ".tmp";
+		std::ofstream file(tempPath, std::ios::binary);
+		if (!file.is_open()) {
+			job->Error = "failed to write " + tempPath;
+			return;
+		}
+
+		glm::ivec2 page = job->PageSize;
+		glm::ivec2 size(width, height);
+
+		TileFileHeader header;
+		header.Magic = VIRTUAL_TEXTURE_MAGIC;
+		header.Version = VIRTUAL_TEXTURE_VERSION;
+		header.Width = width;
+		header.Height = height;
+		header.PageX = page.x;
+		header.PageY = page.y;
+		header.Levels = 1;
+		while ((std::max(width, height) >> header.Levels) > 0)
+			header.Levels++;
+		file.write((const char*)&header, sizeof(header));
+
+		std::vector<unsigned char> tile((size_t)page.x * page.y * 4);
+		for (int l = 0; l < header.Levels; l++) {
+			glm::ivec2 pages = (size + page - 1) / page;
+			for (int ty = 0; ty < pages.y; ty++)
+				for (int tx = 0; tx < pages.x; tx++) {
+					int cols = std::min(page.x, size.x - tx * page.x);
+					for (int r = 0; r < page.y; r++) {
+						int y = std::min(ty * page.y + r, size.y - 1);
+						unsigned char* dst = &tile[(size_t)r * page.x * 4];
+						const unsigned char* src = &pixels[((size_t)y * size.x + tx * page.x) * 4];
+						memcpy(dst, src, cols * 4);
+						for (int c = cols; c < page.x; c++)
+							memcpy(dst + c * 4, src + (cols - 1) * 4, 4);
+					}
+					file.write((const char*)tile.data(), tile.size());
+				}
+
+			// 2x2 box filter
+			glm::ivec2 next = glm::max(size / 2, glm::ivec2(1));
+			std::vector<unsigned char> smaller((size_t)next.x * next.y * 4);
+			for (int y = 0; y < next.y; y++)
+				for (int x = 0; x < next.x; x++) {
+					int x0 = std::min(x * 2, size.x - 1), x1 = std::min(x * 2 + 1, size.x - 1);
+					int y0 = std::min(y * 2, size.y - 1), y1 = std::min(y * 2 + 1, size.y - 1);
+					for (int c = 0; c < 4; c++) {
+						int sum = pixels[((size_t)y0 * size.x + x0) * 4 + c] + pixels[((size_t)y0 * size.x + x1) * 4 + c] +
+							pixels[((size_t)y1 * size.x + x0) * 4 + c] + pixels[((size_t)y1 * size.x + x1) * 4 + c];
+						smaller[((size_t)y * next.x + x) * 4 + c] = (sum + 2) / 4;
+					}
+				}
+			pixels.swap(smaller);
+			size = next;
+		}
+
+		file.close();
+		if (file.fail()) {
+			job->Error = "failed to write " + tempPath;
+			ghc::filesystem::remove(tempPath, ec);
+			return;
+		}
+
+		if (!eng::ReplaceFileWith(job->Cache, tempPath)) {
+			job->Error = "failed to write " + job->Cache;
+			ghc::filesystem::remove(tempPath, ec);
+		}
+	}
+	bool VirtualTexture::m_openTiles()
+	{
+		std::shared_ptr<eng::MappedFile> file = std::make_shared<eng::MappedFile>();
+		if (!file->Open(m_cache) || file->GetSize() < sizeof(TileFileHeader))
+			return false;
+
+		TileFileHeader header;
+		memcpy(&header, file->GetData(), sizeof(header));
+
+		const Level& last = m_levels.back();
+		size_t tileSize = (size_t)m_pageSize.x * m_pageSize.y * 4;
+		size_t tiles = last.First + last.Pages.x * last.Pages.y;
+		if (header.Magic != VIRTUAL_TEXTURE_MAGIC || header.Version != VIRTUAL_TEXTURE_VERSION || header.Width != m_size.x || header.Height != m_size.y ||
+			header.PageX != m_pageSize.x || header.PageY != m_pageSize.y || header.Levels != m_levels.size() || file->GetSize() < sizeof(header) + tiles * tileSize)
+			return false;
+
+		m_file = file;
+
+		// committing any part of the mip tail commits all of it
+		if (m_sparseLevels < m_levels.size()) {
+			const Level& tail = m_levels[m_sparseLevels];
+			glBindTexture(GL_TEXTURE_2D, m_texture);
+			glTexPageCommitmentARB(GL_TEXTURE_2D, m_sparseLevels, 0, 0, 0, tail.Size.x, tail.Size.y, 1, GL_TRUE);
+			glBindTexture(GL_TEXTURE_2D, 0);
+
+			for (int l = m_sparseLevels; l < m_levels.size(); l++) {
+				const Level& level = m_levels[l];
+				for (int i = 0; i < level.Pages.x * level.Pages.y; i++)
+					m_upload(l, glm::ivec2(i % level.Pages.x, i / level.Pages.x), (const unsigned char*)m_file->GetData() + sizeof(header) + (level.First + i) * tileSize);
+			}
+		}
+
+		return true;
+	}
+	void VirtualTexture::m_upload(int level, glm::ivec2 tile, const unsigned char* pixels)
+	{
+		glm::ivec2 origin = tile * m_pageSize;
+		glm::ivec2 extent = glm::min(m_pageSize, m_levels[level].Size - origin);
+
+		glBindTexture(GL_TEXTURE_2D, m_texture);
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, m_pageSize.x);
+		glTexSubImage2D(GL_TEXTURE_2D, level, origin.x, origin.y, extent.x, extent.y, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+	void VirtualTexture::m_commit(int page, const unsigned char* pixels)
+	{
+		int l = 0;
+		while (l + 1 < m_sparseLevels && m_levels[l + 1].First <= page)
+			l++;
+
+		const Level& level = m_levels[l];
+		glm::ivec2 tile((page - level.First) % level.Pages.x, (page - level.First) / level.Pages.x);
+		glm::ivec2 origin = tile * m_pageSize;
+		glm::ivec2 extent = glm::min(m_pageSize, level.Size - origin); // the pages on the edges can end with the level
+
+		glBindTexture(GL_TEXTURE_2D, m_texture);
+		glTexPageCommitmentARB(GL_TEXTURE_2D, l, origin.x, origin.y, 0, extent.x, extent.y, 1, pixels != nullptr ? GL_TRUE : GL_FALSE);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		if (pixels != nullptr)
+			m_upload(l, tile, pixels);
+	}
+	void VirtualTexture::m_releasePage(int resident)
+	{
+		int page = m_resident[resident];
+		m_commit(page, nullptr);
+
+		m_words[page] &= 0x7fffffff;
+		m_markDirty(page);
+
+		m_resident[resident] = m_resident.back();
+		m_resident.pop_back();
+	}
+	bool VirtualTexture::m_makeRoom(GLuint frame)
+	{
+		if (m_resident.size() < VIRTUAL_TEXTURE_RESIDENT_PAGES)
+			return true;
+
+		// the least recently requested page, the finer one if they were requested in the same frame - the coarser
+		// levels always have the newer frame so the parents of the resident pages stay resident
+		int oldest = 0;
+		for (int i = 1; i < m_resident.size(); i++) {
+			GLuint stamp = m_words[m_resident[i]] & 0x7fffffff;
+			GLuint oldestStamp = m_words[m_resident[oldest]] & 0x7fffffff;
+			if (stamp < oldestStamp || (stamp == oldestStamp && m_resident[i] < m_resident[oldest]))
+				oldest = i;
+		}
+
+		if (m_isWanted(m_words[m_resident[oldest]], frame))
+			return false;
+
+		m_releasePage(oldest);
+		return true;
+	}
+	void VirtualTexture::m_markDirty(int page)
+	{
+		m_dirtyStart = std::min(m_dirtyStart, page);
+		m_dirtyEnd = std::max(m_dirtyEnd, page + 1);
+	}
+	glm::uvec4 VirtualTexture::GetInfo(GLuint firstWord)
+	{
+		return glm::uvec4(firstWord, m_size.x, m_size.y, (GLuint)m_pageSize.x | ((GLuint)m_pageSize.y << 12) | ((GLuint)m_sparseLevels << 24));
+	}
+	void VirtualTexture::Update(const GLuint* feedback, GLuint frame, eng::ThreadPool& pool)
+	{
+		if (m_build != nullptr) {
+			if (!m_build->Done)
+				return;
+
+			m_error = m_build->Error;
+			if (m_error.empty() && !m_openTiles())
+				m_error = "failed to open " + m_cache;
+			if (!m_error.empty())
+				Logger::Get().Log("Failed to build the virtual texture tiles: " + m_error, true);
+
+			m_build = nullptr;
+		}
+		if (m_file == nullptr)
+			return;
+
+		// the GPU only writes newer frames - the coarser pages are needed by the same texels
+		if (feedback != nullptr) {
+			for (int i = 0; i < m_words.size(); i++) {
+				GLuint stamp = feedback[i] & 0x7fffffff;
+				if (stamp > (m_words[i] & 0x7fffffff))
+					m_words[i] = (m_words[i] & 0x80000000) | stamp;
+			}
+
+			for (int l = 0; l + 1 < m_sparseLevels; l++) {
+				const Level& level = m_levels[l];
+				const Level& parent = m_levels[l + 1];
+				for (int y = 0; y < level.Pages.y; y++)
+					for (int x = 0; x < level.Pages.x; x++) {
+						GLuint stamp = m_words[level.First + y * level.Pages.x + x] & 0x7fffffff;
+						int p = parent.First + std::min(y / 2, parent.Pages.y - 1) * parent.Pages.x + std::min(x / 2, parent.Pages.x - 1);
+						if (stamp > (m_words[p] & 0x7fffffff))
+							m_words[p] = (m_words[p] & 0x80000000) | stamp;
+					}
+			}
+		}
+
+		// finished tiles - the ones that don't fit stay queued until a page isn't needed anymore
+		int uploads = 0;
+		for (int i = 0; i < m_loads.size() && uploads < VIRTUAL_TEXTURE_UPLOADS; i++) {
+			TileJob* job = m_loads[i].get();
+			if (!job->Done)
+				continue;
+
+			if (m_isWanted(m_words[job->Page], frame)) {
+				if (!m_makeRoom(frame))
+					break;
+
+				m_commit(job->Page, job->Pixels.data());
+				m_words[job->Page] |= 0x80000000;
+				m_resident.push_back(job->Page);
+				m_markDirty(job->Page);
+				uploads++;
+			}
+
+			m_loading[job->Page] = false;
+			m_loads.erase(m_loads.begin() + i);
+			i--;
+		}
+
+		// missing pages, the coarsest level first
+		size_t tileSize = (size_t)m_pageSize.x * m_pageSize.y * 4;
+		for (int l = m_sparseLevels - 1; l >= 0 && m_loads.size() < VIRTUAL_TEXTURE_LOADS; l--) {
+			const Level& level = m_levels[l];
+			int end = level.First + level.Pages.x * level.Pages.y;
+			for (int page = level.First; page < end && m_loads.size() < VIRTUAL_TEXTURE_LOADS; page++) {
+				if (m_loading[page] || (m_words[page] & 0x80000000) || !m_isWanted(m_words[page], frame))
+					continue;
+
+				std::shared_ptr<TileJob> job = std::make_shared<TileJob>();
+				job->Page = page;
+				job->Done = false;
+				m_loading[page] = true;
+				m_loads.push_back(job);
+
+				// the tiles of the sparse levels come first in the file, in the same order as the pages
+				std::shared_ptr<eng::MappedFile> file = m_file;
+				size_t offset = sizeof(TileFileHeader) + (size_t)page * tileSize;
+				pool.Add([job, file, offset, tileSize]() {
+					// the pages of the mapping are read from the disk here instead of on the main thread
+					job->Pixels.assign(file->GetData() + offset, file->GetData() + offset + tileSize);
+					job->Done = true;
+				});
+			}
+		}
+	}
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <glm/glm.hpp>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/glew.h>
+#if defined(__APPLE__)
+	#include <OpenGL/gl.h>
+#else
+	#include <GL/gl.h>
+#endif
+
+#include "../Engine/ThreadPool.h"
+#include "../Engine/MappedFile.h"
+
+#define VIRTUAL_TEXTURE_BLOCK_NAME "SHADERed_VirtualPages"
+#define VIRTUAL_TEXTURE_MAX_OBJECTS 16 // entries in the block's header, the other virtual textures don't get feedback
+#define VIRTUAL_TEXTURE_HEADER_WORDS (4 + VIRTUAL_TEXTURE_MAX_OBJECTS * 4) // uints in front of the page words
+#define VIRTUAL_TEXTURE_RESIDENT_PAGES 4096 // committed pages per texture (64kB each for RGBA8 on most GPUs)
+#define VIRTUAL_TEXTURE_LOADS 16 // tiles that are read from the disk at the same time
+#define VIRTUAL_TEXTURE_UPLOADS 8 // tiles that are committed & uploaded per frame
+#define VIRTUAL_TEXTURE_KEEP_FRAMES 8 // pages requested this many frames ago are still needed - the feedback is a few frames late
+
+namespace ed
+{
+	// GL_TEXTURE_2D with GL_ARB_sparse_texture storage where only the pages that the shaders ask for are committed
+	// the image is converted once into a tile file in the cache directory (a GL page per tile, every mip level) and
+	// the tiles are copied out of the mapped file on the loader threads
+	// shaders call float SHADERed_VirtualLod(uint index, vec2 uv, float lod) - see Instrument() - which marks the page
+	// in the SHADERed_VirtualPages block and returns the finest level that can be sampled with textureLod()
+	class VirtualTexture
+	{
+	public:
+		VirtualTexture();
+
+		static bool IsSupported();
+		static int Instrument(std::string& glsl); // adds the helper if the code calls it, returns the number of added lines
+
+		// reads the image's header, allocates the storage of tex and starts building the tile file if it isn't cached yet
+		bool Open(const std::string& path, GLuint tex, eng::ThreadPool& pool);
+
+		// words of this texture in the block: bit 31 = resident, the rest = last frame that requested the page
+		// feedback = the words that the GPU wrote (nullptr if no readback finished), frame = the block's current frame
+		void Update(const GLuint* feedback, GLuint frame, eng::ThreadPool& pool);
+
+		inline const std::vector<GLuint>& GetWords() { return m_words; }
+		inline bool GetDirtyRange(int& start, int& end) { start = m_dirtyStart; end = m_dirtyEnd; return m_dirtyStart < m_dirtyEnd; } // [start, end)
+		inline void ClearDirty() { m_dirtyStart = m_words.size(); m_dirtyEnd = 0; }
+		glm::uvec4 GetInfo(GLuint firstWord); // the header entry: first word, size, page size | level count << 24
+
+		inline bool IsReady() { return m_file != nullptr; }
+		inline bool IsBuilding() { return m_build != nullptr; }
+		inline const std::string& GetError() { return m_error; }
+		inline glm::ivec2 GetSize() { return m_size; }
+		inline glm::ivec2 GetPageSize() { return m_pageSize; }
+		inline int GetPageCount() { return m_words.size(); } // pages of the sparse levels, the mip tail is always resident
+		inline int GetResidentCount() { return m_resident.size(); }
+
+	private:
+		struct Level
+		{
+			int First; // tile index
+			glm::ivec2 Size, Pages;
+		};
+		struct BuildJob
+		{
+			std::string Source, Cache;
+			glm::ivec2 PageSize;
+			std::atomic<bool> Done;
+			std::string Error;
+		};
+		struct TileJob
+		{
+			int Page;
+			std::vector<unsigned char> Pixels;
+			std::atomic<bool> Done;
+		};
+
+		static void m_buildTiles(BuildJob* job);
+
+		bool m_openTiles(); // also uploads the mip tail
+		void m_upload(int level, glm::ivec2 tile, const unsigned char* pixels);
+		void m_commit(int page, const unsigned char* pixels); // nullptr -> release the page
+		void m_releasePage(int resident); // index in m_resident
+		bool m_makeRoom(GLuint frame); // false if every resident page is still needed
+		void m_markDirty(int page);
+		inline bool m_isWanted(GLuint word, GLuint frame) { word &= 0x7fffffff; return word != 0 && word + VIRTUAL_TEXTURE_KEEP_FRAMES >= frame; }
+
+		GLuint m_texture;
+		glm::ivec2 m_size, m_pageSize;
+		int m_sparseLevels; // this level & the smaller ones are the mip tail
+		std::vector<Level> m_levels;
+		std::string m_cache;
+		std::string m_error;
+
+		std::shared_ptr<BuildJob> m_build;
+		std::shared_ptr<eng::MappedFile> m_file; // shared with the tile jobs
+
+		std::vector<GLuint> m_words;
+		std::vector<int> m_resident; // pages
+		std::vector<bool> m_loading;
+		std::vector<std::shared_ptr<TileJob>> m_loads;
+		int m_dirtyStart, m_dirtyEnd;
+	};
+}
@@ -0,0 +1,224 @@
+#include "WorkGroupTuner.h"
+
+#include <algorithm>
+#include <string.h>
+
+namespace ed
+{
+	const char* WorkGroupTuner::MacroNames[3] = { "LOCAL_SIZE_X", "LOCAL_SIZE_Y", "LOCAL_SIZE_Z" };
+
+	static int log2Ceil(GLuint val)
+	{
+		int ret = 0;
+		while ((1u << ret) < val && ret < 31)
+			ret++;
+		return ret;
+	}
+
+	WorkGroupTuner::WorkGroupTuner()
+	{
+		m_pass = nullptr;
+		m_done = false;
+		m_turn = 0;
+		m_slot = 0;
+
+		memset(m_queries, 0, sizeof(m_queries));
+		for (int i = 0; i < WORKGROUP_TUNER_QUERIES; i++)
+			m_pending[i] = -1;
+	}
+	WorkGroupTuner::~WorkGroupTuner()
+	{
+		Stop();
+	}
+	void WorkGroupTuner::Start(void* pass, const glm::uvec3& local, const glm::uvec3& groups, const glm::uvec3& maxSize, int maxInvocations)
+	{
+		Stop();
+		m_error = "";
+
+		glm::uvec3 threads = local * groups;
+		int maxExp = log2Ceil(std::min(maxInvocations, 1024) + 1) - 1;
+		int minExp = std::min(log2Ceil(WORKGROUP_TUNER_MIN_INVOCATIONS), log2Ceil(threads.x * threads.y * threads.z));
+
+		// powers of two along the axes that have more than one invocation, larger than the axis isn't useful
+		int cap[3];
+		for (int d = 0; d < 3; d++)
+			cap[d] = threads[d] > 1 ? std::min(log2Ceil(threads[d]), log2Ceil(maxSize[d] + 1) - 1) : 0;
+
+		for (int x = 0; x <= cap[0]; x++)
+			for (int y = 0; y <= cap[1]; y++)
+				for (int z = 0; z <= cap[2]; z++) {
+					int e[3] = { x, y, z };
+					int sum = x + y + z;
+					if (sum < minExp || sum > maxExp)
+						continue;
+
+					// skip the very thin groups unless an axis is too short for anything else
+					int lo = 31, hi = 0;
+					bool clamped = false;
+					for (int d = 0; d < 3; d++) {
+						if (cap[d] == 0)
+							continue;
+						lo = std::min(lo, e[d]);
+						hi = std::max(hi, e[d]);
+						clamped |= e[d] == cap[d];
+					}
+					if (hi - lo > 3 && !clamped)
+						continue;
+
+					Candidate cand;
+					cand.Size = glm::uvec3(1u << x, 1u << y, 1u << z);
+					cand.Current = cand.Size == local;
+					m_candidates.push_back(cand);
+				}
+
+		bool hasCurrent = false;
+		for (const auto& cand : m_candidates)
+			hasCurrent |= cand.Current;
+		if (!hasCurrent) {
+			Candidate cand;
+			cand.Size = local;
+			cand.Current = true;
+			m_candidates.push_back(cand);
+		}
+
+		for (auto& cand : m_candidates) {
+			cand.Groups = (threads + cand.Size - 1u) / cand.Size;
+			cand.Program = 0;
+			cand.Compiled = false;
+			cand.Time = 0.0f;
+		}
+		std::sort(m_candidates.begin(), m_candidates.end(), [](const Candidate& a, const Candidate& b) {
+			GLuint ai = a.Size.x * a.Size.y * a.Size.z, bi = b.Size.x * b.Size.y * b.Size.z;
+			if (ai != bi)
+				return ai < bi;
+			return a.Size.x < b.Size.x;
+		});
+
+		m_pass = pass;
+		m_done = false;
+		m_turn = 0;
+		m_slot = 0;
+		glGenQueries(WORKGROUP_TUNER_QUERIES * 2, &m_queries[0][0]);
+		for (int i = 0; i < WORKGROUP_TUNER_QUERIES; i++)
+			m_pending[i] = -1;
+	}
+	void WorkGroupTuner::Stop()
+	{
+		if (m_pass == nullptr)
+			return;
+
+		m_finish();
+		m_candidates.clear();
+		m_pass = nullptr;
+	}
+	void WorkGroupTuner::Fail(const std::string& error)
+	{
+		m_error = error;
+		m_finish();
+	}
+	void WorkGroupTuner::m_finish()
+	{
+		if (m_done)
+			return;
+
+		for (auto& cand : m_candidates)
+			if (cand.Program != 0) {
+				glDeleteProgram(cand.Program);
+				cand.Program = 0;
+			}
+
+		glDeleteQueries(WORKGROUP_TUNER_QUERIES * 2, &m_queries[0][0]);
+		memset(m_queries, 0, sizeof(m_queries));
+		for (int i = 0; i < WORKGROUP_TUNER_QUERIES; i++)
+			m_pending[i] = -1;
+
+		m_done = true;
+	}
+	int WorkGroupTuner::GetBest()
+	{
+		int ret = -1;
+		for (int i = 0; i < m_candidates.size(); i++)
+			if (m_candidates[i].Time > 0.0f && (ret == -1 || m_candidates[i].Time < m_candidates[ret].Time))
+				ret = i;
+		return ret;
+	}
+	float WorkGroupTuner::GetProgress()
+	{
+		if (m_candidates.empty())
+			return 1.0f;
+
+		int samples = 0;
+		for (const auto& cand : m_candidates)
+			samples += cand.Error.empty() ? cand.Samples.size() : WORKGROUP_TUNER_ROUNDS;
+		return samples / (float)(m_candidates.size() * WORKGROUP_TUNER_ROUNDS);
+	}
+	WorkGroupTuner::Candidate* WorkGroupTuner::GetNext()
+	{
+		if (!IsRunning() || m_pending[m_slot] != -1)
+			return nullptr;
+
+		// samples that are still in flight count as taken
+		std::vector<int> taken(m_candidates.size(), 0);
+		for (int i = 0; i < WORKGROUP_TUNER_QUERIES; i++)
+			if (m_pending[i] >= 0)
+				taken[m_pending[i]]++;
+
+		for (int i = 0; i < m_candidates.size(); i++) {
+			int index = (m_turn + i) % m_candidates.size();
+			Candidate& cand = m_candidates[index];
+			if (cand.Error.empty() && cand.Samples.size() + taken[index] < WORKGROUP_TUNER_ROUNDS) {
+				m_turn = index;
+				return &cand;
+			}
+		}
+
+		return nullptr;
+	}
+	void WorkGroupTuner::Begin()
+	{
+		glQueryCounter(m_queries[m_slot][0], GL_TIMESTAMP);
+	}
+	void WorkGroupTuner::End()
+	{
+		glQueryCounter(m_queries[m_slot][1], GL_TIMESTAMP);
+		m_pending[m_slot] = m_turn;
+		m_slot = (m_slot + 1) % WORKGROUP_TUNER_QUERIES;
+		m_turn = (m_turn + 1) % m_candidates.size();
+	}
+	void WorkGroupTuner::EndFrame()
+	{
+		if (!IsRunning())
+			return;
+
+		for (int i = 0; i < WORKGROUP_TUNER_QUERIES; i++) {
+			if (m_pending[i] < 0)
+				continue;
+
+			GLint available = 0;
+			glGetQueryObjectiv(m_queries[i][1], GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available)
+				continue;
+
+			GLuint64 start = 0, end = 0;
+			glGetQueryObjectui64v(m_queries[i][0], GL_QUERY_RESULT, &start);
+			glGetQueryObjectui64v(m_queries[i][1], GL_QUERY_RESULT, &end);
+
+			Candidate& cand = m_candidates[m_pending[i]];
+			m_pending[i] = -1;
+			if (end <= start)
+				continue;
+
+			cand.Samples.push_back((end - start) / 1e6f / WORKGROUP_TUNER_DISPATCHES);
+
+			std::vector<float> sorted = cand.Samples;
+			std::sort(sorted.begin(), sorted.end());
+			cand.Time = sorted[sorted.size() / 2];
+		}
+
+		bool done = true;
+		for (const auto& cand : m_candidates)
+			done &= !cand.Error.empty() || cand.Samples.size() >= WORKGROUP_TUNER_ROUNDS;
+		if (done)
+			m_finish();
+	}
+}
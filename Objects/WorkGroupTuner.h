@@ -0,0 +1,83 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/glew.h>
+#if defined(__APPLE__)
+	#include <OpenGL/gl.h>
+#else
+	#include <GL/gl.h>
+#endif
+
+#define WORKGROUP_TUNER_QUERIES 4	   // timer queries in flight
+#define WORKGROUP_TUNER_ROUNDS 8	   // samples per candidate, the median is used
+#define WORKGROUP_TUNER_DISPATCHES 4   // dispatches per sample
+#define WORKGROUP_TUNER_MIN_INVOCATIONS 32 // smaller groups than a warp/wave are never faster
+
+namespace ed
+{
+	// times a compute pass with different local sizes - the shader has to declare its local size with the
+	// LOCAL_SIZE_X/Y/Z macros, the group counts are changed so that the same number of invocations is dispatched
+	// one candidate is measured per frame, round robin so that clock changes affect all of them the same way
+	class WorkGroupTuner
+	{
+	public:
+		WorkGroupTuner();
+		~WorkGroupTuner();
+
+		static const char* MacroNames[3];
+
+		struct Candidate
+		{
+			glm::uvec3 Size;   // local size
+			glm::uvec3 Groups; // group counts that cover the pass' invocations
+			bool Current;	   // the pass' local size
+
+			GLuint Program; // built when the candidate is measured for the first time
+			bool Compiled;
+			std::string Error;
+
+			std::vector<float> Samples; // milliseconds per dispatch
+			float Time;					// median, 0 = not measured yet
+		};
+
+		// local = the pass' current local size, groups = its group counts
+		void Start(void* pass, const glm::uvec3& local, const glm::uvec3& groups, const glm::uvec3& maxSize, int maxInvocations);
+		void Stop();
+		void Fail(const std::string& error); // stops measuring, the error is kept until the next Start()
+
+		inline bool IsActive() { return m_pass != nullptr; }
+		inline bool IsRunning() { return m_pass != nullptr && !m_done; }
+		inline void* GetPass() { return m_pass; }
+		inline const std::string& GetError() { return m_error; }
+		inline std::vector<Candidate>& GetCandidates() { return m_candidates; }
+		int GetBest(); // index of the fastest candidate, -1 if none was measured
+		float GetProgress();
+
+		// candidate whose dispatches should be timed in this frame, nullptr if none
+		Candidate* GetNext();
+		void Begin();
+		void End();
+
+		// reads the finished queries
+		void EndFrame();
+
+	private:
+		void m_finish();
+
+		void* m_pass;
+		bool m_done;
+		std::string m_error;
+
+		std::vector<Candidate> m_candidates;
+		int m_turn;
+
+		GLuint m_queries[WORKGROUP_TUNER_QUERIES][2]; // [slot][start, end]
+		int m_pending[WORKGROUP_TUNER_QUERIES];		  // candidate that the slot measured, -1 = free
+		int m_slot;
+	};
+}
@@ -7,24 +7,45 @@
 #include "../Objects/ShaderTranscompiler.h"
 #include "../Objects/ThemeContainer.h"
 #include "../Objects/KeyboardShortcuts.h"
+#include "../Objects/IncludeCache.h"
+#include "../Objects/ReloadProfiler.h"
+#include "../Objects/Hash.h"
+#include "../Objects/UIRefresh.h"
+#include "../Objects/RemotePreview.h"
+#include "../Objects/Debug/Heatmap.h"
+#include "../Engine/GLUtils.h"
 
 #include <iostream>
 #include <fstream>
+#include <algorithm>
+#include <string.h>
 
 #if defined(_WIN32)
 	#include <windows.h>
+#elif defined(__APPLE__)
+	#include <unistd.h>
+	#include <sys/types.h>
+	#include <CoreServices/CoreServices.h>
+	#include <dispatch/dispatch.h>
 #elif defined(__linux__) || defined(__unix__)
 	#include <fcntl.h>
 	#include <unistd.h>
 	#include <sys/types.h>
+	#include <sys/select.h>
 	#include <sys/inotify.h>
 	#define EVENT_SIZE  ( sizeof (struct inotify_event) )
 	#define EVENT_BUF_LEN     ( 1024 * ( EVENT_SIZE + 16 ) )
-#elif defined(__APPLE__)
-	#include <unistd.h>
-	#include <sys/types.h>
 #endif
 
+#define AUTO_RECOMPILE_INTERVAL 100 // ms between the checks for edited stages
+#define AUTO_RECOMPILE_IDLE 500 // ms without edits before a stage is rebuilt, its errors are checked right away
+#define TRACK_DEBOUNCE_TIME 150 // ms without new changes before the batch is compiled
+#define TRACK_IGNORE_TIME 1000  // ms after "Compile" during which its own save is ignored
+#define TRACK_LIST_INTERVAL 500 // ms between the updates of the list of tracked files
+#define EDITOR_LARGE_FILE_LINES 3000 // documents with more lines are only recolored once the typing stops
+#define EDITOR_COLORIZE_DELAY 300 // ms without edits before a large document is recolored
+#define SYMBOL_REFRESH_INTERVAL 500 // ms between the checks for new symbols in the included files
+
 
 
 #define STATUSBAR_HEIGHT 20 * Settings::Instance().DPIScale
@@ -32,7 +53,6 @@
 namespace ed
 {
 	CodeEditorUI::~CodeEditorUI() {
-		m_autoRecompileThread = nullptr;
 		m_trackThread = nullptr;
 
 		SetAutoRecompile(false);
@@ -52,7 +72,13 @@ namespace ed
 			m_save(m_selectedItem);
 		});
 		KeyboardShortcuts::Instance().SetCallback("CodeUI.SwitchView", [=]() {
-			// REMOVED
+			if (m_selectedItem == -1)
+				return;
+
+			if (m_stats[m_selectedItem].IsActive)
+				m_stats[m_selectedItem].IsActive = false;
+			else
+				m_stats[m_selectedItem].Fetch(m_items[m_selectedItem], m_editor[m_selectedItem].GetText(), m_shaderTypeId[m_selectedItem]);
 		});
 		KeyboardShortcuts::Instance().SetCallback("CodeUI.ToggleStatusbar", [=]() {
 			Settings::Instance().Editor.StatusBar = !Settings::Instance().Editor.StatusBar;
@@ -68,6 +94,12 @@ namespace ed
 		
 		m_selectedItem = -1;
 
+		auto now = std::chrono::steady_clock::now();
+		if (now - m_symbolsTime >= std::chrono::milliseconds(SYMBOL_REFRESH_INTERVAL)) {
+			m_symbolsTime = now;
+			m_updateSymbols();
+		}
+
 		// counters for each shader type for window ids
 		int wid[5] = { 0 }; // vs, ps, gs, cs, pl
 
@@ -94,7 +126,7 @@ namespace ed
 						if (ImGui::BeginMenu("Code")) {
 							if (ImGui::MenuItem("Compile", KeyboardShortcuts::Instance().GetString("CodeUI.Compile").c_str())) m_compile(i);
 
-							if (!m_stats[i].IsActive && ImGui::MenuItem("Stats", KeyboardShortcuts::Instance().GetString("CodeUI.SwitchView").c_str(), nullptr, false)) m_stats[i].Fetch(m_items[i], m_editor[i].GetText(), m_shaderTypeId[i]);
+							if (!m_stats[i].IsActive && ImGui::MenuItem("Stats", KeyboardShortcuts::Instance().GetString("CodeUI.SwitchView").c_str())) m_stats[i].Fetch(m_items[i], m_editor[i].GetText(), m_shaderTypeId[i]);
 							
 							if (m_stats[i].IsActive && ImGui::MenuItem("Code", KeyboardShortcuts::Instance().GetString("CodeUI.SwitchView").c_str())) m_stats[i].IsActive = false;
 							ImGui::Separator();
@@ -117,7 +149,7 @@ namespace ed
 						m_stats[i].Render();
 					else {
 						// add error markers if needed
-						auto msgs = m_data->Messages.GetMessages();
+						const auto& msgs = m_data->Messages.GetMessages();
 						int groupMsg = 0;
 						TextEditor::ErrorMarkers groupErrs;
 						for (int j = 0; j < msgs.size(); j++)
@@ -127,9 +159,13 @@ namespace ed
 
 						bool statusbar = Settings::Instance().Editor.StatusBar;
 
+						m_updateColorizer(i);
+
 						// render code
 						ImGui::PushFont(m_font);
 						m_editor[i].Render(windowName.c_str(), ImVec2(0, -statusbar*STATUSBAR_HEIGHT));
+						if (m_shaderTypeId[i] == 1 && m_data->DebugRegion.GetLineOwner() == m_items[i])
+							m_renderLineCost(i);
 						ImGui::PopFont();
 
 						
@@ -139,6 +175,7 @@ namespace ed
 
 							ImGui::Separator();
 							ImGui::Text("Line %d\tCol %d\tType: %s\tPath: %s", cursor.mLine, cursor.mColumn, m_editor[i].GetLanguageDefinition().mName.c_str(), m_paths[i].c_str());
+							m_stats[i].RenderSummary(m_items[i], m_shaderTypeId[i]);
 						}
 					}
 
@@ -206,6 +243,8 @@ namespace ed
 					m_editor.erase(m_editor.begin() + i);
 					m_editorOpen.erase(m_editorOpen.begin() + i);
 					m_stats.erase(m_stats.begin() + i);
+					m_state.erase(m_state.begin() + i);
+					m_symbols.ClearContent(IncludeCache::Normalize(m_paths[i]));
 					m_paths.erase(m_paths.begin() + i);
 					m_shaderTypeId.erase(m_shaderTypeId.begin() + i);
 					i--;
@@ -252,6 +291,7 @@ namespace ed
 			m_editor.push_back(TextEditor());
 			m_editorOpen.push_back(true);
 			m_stats.push_back(StatsPage(m_data));
+			m_state.push_back(EditorState());
 
 			TextEditor* editor = &m_editor[m_editor.size() - 1];
 
@@ -317,6 +357,7 @@ namespace ed
 			m_editor.push_back(TextEditor());
 			m_editorOpen.push_back(true);
 			m_stats.push_back(StatsPage(m_data));
+			m_state.push_back(EditorState());
 			m_paths.push_back(shader->Path);
 
 			TextEditor *editor = &m_editor[m_editor.size() - 1];
@@ -382,6 +423,7 @@ namespace ed
 			m_editor.push_back(TextEditor());
 			m_editorOpen.push_back(true);
 			m_stats.push_back(StatsPage(m_data));
+			m_state.push_back(EditorState());
 			m_paths.push_back(shader->Path);
 
 			TextEditor *editor = &m_editor[m_editor.size() - 1];
@@ -452,6 +494,7 @@ namespace ed
 			m_editor.push_back(TextEditor());
 			m_editorOpen.push_back(true);
 			m_stats.push_back(StatsPage(m_data));
+			m_state.push_back(EditorState());
 			m_paths.push_back(filepath);
 
 			TextEditor* editor = &m_editor[m_editor.size() - 1];
@@ -523,6 +566,8 @@ namespace ed
 			m_editor.erase(m_editor.begin() + i);
 			m_editorOpen.erase(m_editorOpen.begin() + i);
 			m_stats.erase(m_stats.begin() + i);
+			m_state.erase(m_state.begin() + i);
+			m_symbols.ClearContent(IncludeCache::Normalize(m_paths[i]));
 			m_paths.erase(m_paths.begin() + i);
 			m_shaderTypeId.erase(m_shaderTypeId.begin() + i);
 			i--;
@@ -541,6 +586,8 @@ namespace ed
 				m_editor.erase(m_editor.begin() + i);
 				m_editorOpen.erase(m_editorOpen.begin() + i);
 				m_stats.erase(m_stats.begin() + i);
+				m_state.erase(m_state.begin() + i);
+				m_symbols.ClearContent(IncludeCache::Normalize(m_paths[i]));
 				m_paths.erase(m_paths.begin() + i);
 				m_shaderTypeId.erase(m_shaderTypeId.begin() + i);
 				i--;
@@ -566,6 +613,26 @@ namespace ed
 			ret.push_back(m_editor[i].GetText());
 		return ret;
 	}
+	void CodeEditorUI::GetUnsavedFiles(std::vector<std::pair<std::string, std::string>>& out)
+	{
+		for (int i = 0; i < m_items.size(); i++) {
+			if (!m_editor[i].IsTextChanged())
+				continue;
+
+			// plugins save their own code
+			const char* path = nullptr;
+			if (m_items[i]->Type == PipelineItem::ItemType::ShaderPass) {
+				ed::pipe::ShaderPass* shader = reinterpret_cast<ed::pipe::ShaderPass*>(m_items[i]->Data);
+				path = m_shaderTypeId[i] == 0 ? shader->VSPath : (m_shaderTypeId[i] == 1 ? shader->PSPath : shader->GSPath);
+			} else if (m_items[i]->Type == PipelineItem::ItemType::ComputePass)
+				path = reinterpret_cast<ed::pipe::ComputePass*>(m_items[i]->Data)->Path;
+			else if (m_items[i]->Type == PipelineItem::ItemType::AudioPass)
+				path = reinterpret_cast<ed::pipe::AudioPass*>(m_items[i]->Data)->Path;
+
+			if (path != nullptr)
+				out.push_back(std::make_pair(std::string(path), m_editor[i].GetText()));
+		}
+	}
 	void CodeEditorUI::SetOpenedFilesData(const std::vector<std::string>& data)
 	{
 		for (int i = 0; i < m_items.size() && i < data.size(); i++)
@@ -614,37 +681,46 @@ namespace ed
 	}
 	void CodeEditorUI::m_compile(int id)
 	{
-		if (m_trackerRunning) {
-			std::lock_guard<std::mutex> lock(m_trackFilesMutex);
-			m_trackIgnore.push_back(m_items[id]->Name);
+		std::string shaderFile = m_getShaderFile(id);
+
+		// the notification caused by this save shouldn't compile the shader again
+		if (m_trackerRunning && !shaderFile.empty()) {
+			std::lock_guard<ED_LOCKABLE_BASE(std::mutex)> lock(m_trackFilesMutex);
+			m_trackIgnore[IncludeCache::Normalize(m_data->Parser.GetProjectPath(shaderFile))] = std::chrono::steady_clock::now() + std::chrono::milliseconds(TRACK_IGNORE_TIME);
 		}
 
 		m_save(id);
 
-		std::string shaderFile = "";
+		if (m_items[id]->Type == PipelineItem::ItemType::PluginItem) {
+			ed::pipe::PluginItemData* shader = reinterpret_cast<ed::pipe::PluginItemData*>(m_items[id]->Data);
+			shader->Owner->HandleRecompile(m_items[id]->Name);
+		}
+
+		if (!shaderFile.empty()) {
+			m_data->Renderer.RecompileFile(shaderFile.c_str());
+
+			// the remote renderer has its own copy of the project
+			if (RemoteClient::Instance().IsConnected())
+				RemoteClient::Instance().SendFile(shaderFile, m_editor[id].GetText());
+		}
+	}
+	std::string CodeEditorUI::m_getShaderFile(int id)
+	{
 		if (m_items[id]->Type == PipelineItem::ItemType::ShaderPass) {
 			ed::pipe::ShaderPass* shader = reinterpret_cast<ed::pipe::ShaderPass*>(m_items[id]->Data);
 			if (m_shaderTypeId[id] == 0)
-				shaderFile = shader->VSPath;
+				return shader->VSPath;
 			else if (m_shaderTypeId[id] == 1)
-				shaderFile = shader->PSPath;
+				return shader->PSPath;
 			else if (m_shaderTypeId[id] == 2)
-				shaderFile = shader->GSPath;
-		}
-		else if (m_items[id]->Type == PipelineItem::ItemType::ComputePass) {
-			ed::pipe::ComputePass* shader = reinterpret_cast<ed::pipe::ComputePass*>(m_items[id]->Data);
-			shaderFile = shader->Path;
-		}
-		else if (m_items[id]->Type == PipelineItem::ItemType::AudioPass) {
-			ed::pipe::AudioPass* shader = reinterpret_cast<ed::pipe::AudioPass*>(m_items[id]->Data);
-			shaderFile = shader->Path;
-		}
-		else if (m_items[id]->Type == PipelineItem::ItemType::PluginItem) {
-			ed::pipe::PluginItemData* shader = reinterpret_cast<ed::pipe::PluginItemData*>(m_items[id]->Data);
-			shader->Owner->HandleRecompile(m_items[id]->Name);
+				return shader->GSPath;
 		}
+		else if (m_items[id]->Type == PipelineItem::ItemType::ComputePass)
+			return reinterpret_cast<ed::pipe::ComputePass*>(m_items[id]->Data)->Path;
+		else if (m_items[id]->Type == PipelineItem::ItemType::AudioPass)
+			return reinterpret_cast<ed::pipe::AudioPass*>(m_items[id]->Data)->Path;
 
-		m_data->Renderer.RecompileFile(shaderFile.c_str());
+		return "";
 	}
 	void CodeEditorUI::m_loadEditorShortcuts(TextEditor* ed)
 	{
@@ -679,17 +755,19 @@ namespace ed
 			editor->AddBreakpoint(bkpts[i].Line, bkpts[i].IsConditional ? bkpts[i].Condition : "", states[i]);
 
 		editor->OnBreakpointRemove = [&](TextEditor* ed, int line) {
-			m_data->Debugger.Engine.ClearBreakpoint(line);
+			m_data->Debugger.RemoveActiveBreakpoint(line);
 			m_data->Debugger.RemoveBreakpoint(ed->GetPath(), line);
 		};
 		editor->OnBreakpointUpdate = [&](TextEditor* ed, int line, const std::string& cond, bool enabled) {
 			// save it for later use
 			m_data->Debugger.AddBreakpoint(ed->GetPath(), line, cond, enabled);
 
-			if (!enabled) return;
+			if (!enabled) {
+				m_data->Debugger.RemoveActiveBreakpoint(line);
+				return;
+			}
 
-			if (cond.empty()) m_data->Debugger.Engine.AddBreakpoint(line);
-			else m_data->Debugger.Engine.AddConditionalBreakpoint(line, cond);
+			m_data->Debugger.AddActiveBreakpoint(line, cond);
 		};
 	}
 	
@@ -699,25 +777,282 @@ namespace ed
 			ed.SetCurrentLineIndicator(-1);
 	}
 
+	void CodeEditorUI::m_renderLineCost(int id)
+	{
+		const std::vector<unsigned int>& steps = m_data->DebugRegion.GetLineSteps();
+		if (steps.empty())
+			return;
+
+		// the editor is the last child window, it draws its lines with the font's height & no item spacing
+		ImGuiWindow* window = ImGui::GetCurrentWindow();
+		if (window->DC.ChildWindows.empty())
+			return;
+		ImGuiWindow* child = window->DC.ChildWindows.back();
+		float lineHeight = ImGui::GetTextLineHeight();
+
+		unsigned int maxSteps = 0, totalSteps = 0;
+		for (unsigned int s : steps) {
+			maxSteps = std::max(maxSteps, s);
+			totalSteps += s;
+		}
+		if (maxSteps == 0)
+			return;
+
+		// the debugger's lines start at 1
+		int lineCount = m_editor[id].GetTotalLines();
+		int first = std::max<int>(child->Scroll.y / lineHeight, 0);
+		int last = std::min<int>(first + child->Size.y / lineHeight + 1, std::min<int>(lineCount, steps.size() - 1));
+		float barWidth = 4.0f * Settings::Instance().DPIScale;
+		int pixels = std::max(m_data->DebugRegion.GetLinePixels(), 1);
+
+		ImDrawList* drawList = child->DrawList;
+		drawList->PushClipRect(child->ClipRect.Min, child->ClipRect.Max);
+		for (int line = first; line < last; line++) {
+			unsigned int count = steps[line + 1];
+			if (count == 0)
+				continue;
+
+			ImVec2 start(child->Pos.x, child->DC.CursorStartPos.y + line * lineHeight);
+			ImVec2 end(start.x + barWidth, start.y + lineHeight);
+			glm::vec3 color = GetHeatmapColor(count / (float)maxSteps);
+			drawList->AddRectFilled(start, end, ImGui::GetColorU32(ImVec4(color.r, color.g, color.b, 1.0f)));
+
+			if (ImGui::IsMouseHoveringRect(start, end) && child->ClipRect.Contains(ImGui::GetMousePos()))
+				ImGui::SetTooltip("%u steps (%.1f%%), %.1f per pixel over %d pixels", count, count * 100.0f / totalSteps, count / (float)pixels, pixels);
+		}
+		drawList->PopClipRect();
+	}
+	void CodeEditorUI::m_updateColorizer(int id)
+	{
+		// the colorizer goes over the whole buffer (multiline comments, preprocessor) after every edit - on
+		// big files that's done once per burst of typing, the edited ranges are kept by the editor until then
+		TextEditor& editor = m_editor[id];
+		EditorState& state = m_state[id];
+
+		int lines = editor.GetTotalLines();
+		TextEditor::Coordinates cursor = editor.GetCursorPosition();
+		bool edited = lines != state.Lines || cursor != state.Cursor;
+		state.Lines = lines;
+		state.Cursor = cursor;
+
+		if (lines < EDITOR_LARGE_FILE_LINES) {
+			if (state.Deferred) {
+				editor.SetColorizerEnable(true);
+				state.Deferred = false;
+			}
+			return;
+		}
+
+		auto now = std::chrono::steady_clock::now();
+		if (edited) {
+			state.LastEdit = now;
+			if (!state.Deferred) {
+				editor.SetColorizerEnable(false);
+				state.Deferred = true;
+			}
+		} else if (state.Deferred && now - state.LastEdit >= std::chrono::milliseconds(EDITOR_COLORIZE_DELAY)) {
+			editor.SetColorizerEnable(true);
+			state.Deferred = false;
+		}
+	}
+	void CodeEditorUI::m_updateSymbols()
+	{
+		for (int i = 0; i < m_editor.size(); i++) {
+			if (m_items[i]->Type == PipelineItem::ItemType::PluginItem)
+				continue;
+
+			TextEditor& editor = m_editor[i];
+			EditorState& state = m_state[i];
+			std::string file = IncludeCache::Normalize(m_paths[i]);
+
+			// unsaved edits of a file that other shaders include
+			if (editor.IsTextChanged()) {
+				if (!IncludeCache::Instance().GetDependents(file).empty()) {
+					std::string code = editor.GetText();
+					uint64_t hash = HashString(code);
+					if (hash != state.ContentHash) {
+						m_symbols.SetContent(file, code);
+						state.ContentHash = hash;
+					}
+				}
+			} else if (state.ContentHash != 0) {
+				m_symbols.ClearContent(file);
+				state.ContentHash = 0;
+			}
+
+			// the editor scans its own text, the symbols of the includes are added to the language definition
+			std::vector<std::string> includes = IncludeCache::Instance().GetIncludes(file);
+			uint64_t key = m_symbols.Get(includes);
+			if (key == state.SymbolsKey)
+				continue;
+			state.SymbolsKey = key;
+
+			std::vector<SymbolIndex::Symbol> symbols;
+			m_symbols.Get(includes, &symbols);
+			if (symbols.empty() && state.SymbolCount == 0)
+				continue;
+			state.SymbolCount = symbols.size();
+
+			bool isHLSL = ShaderTranscompiler::GetShaderTypeFromExtension(m_paths[i]) == ShaderLanguage::HLSL;
+			TextEditor::LanguageDefinition langDef = isHLSL ? TextEditor::LanguageDefinition::HLSL() : TextEditor::LanguageDefinition::GLSL();
+			for (const SymbolIndex::Symbol& sym : symbols) {
+				TextEditor::Identifier id;
+				id.mDeclaration = sym.Declaration;
+				langDef.mIdentifiers.insert(std::make_pair(sym.Name, id)); // built-ins aren't replaced
+			}
+			editor.SetLanguageDefinition(langDef);
+		}
+	}
 	void CodeEditorUI::UpdateAutoRecompileItems() 
 	{
+		if (!m_autoRecompilerRunning)
+			return;
+
+		auto now = std::chrono::steady_clock::now();
+		if (now - m_autoRecompileTime >= std::chrono::milliseconds(AUTO_RECOMPILE_INTERVAL)) {
+			m_autoRecompileTime = now;
+			m_queueAutoRecompile();
+		}
+
 		if (m_autoRecompileRequest) {
-        	std::shared_lock<std::shared_mutex> lk(m_autoRecompilerMutex);
-			for (const auto& it : m_ariiList) {
-				if (it.second.SPass != nullptr)
-					m_data->Renderer.RecompileFromSource(it.first.c_str(), it.second.VS, it.second.PS, it.second.GS);
-				else if (it.second.CPass != nullptr)
-					m_data->Renderer.RecompileFromSource(it.first.c_str(), it.second.CS);
-				else if (it.second.APass != nullptr)
-					m_data->Renderer.RecompileFromSource(it.first.c_str(), it.second.AS);
-				else if (it.second.PluginData != nullptr)
-					it.second.PluginData->Owner->HandleRecompileFromSource(it.first.c_str(), it.second.PluginID, it.second.PluginCode.c_str(), it.second.PluginCode.size());
+			std::unordered_map<std::string, AutoRecompilerItemInfo> results;
+			std::vector<ed::MessageStack::Message> msgs;
+			std::vector<std::pair<std::string, int>> checked;
+			{
+				std::lock_guard<ED_LOCKABLE_BASE(std::mutex)> lock(m_autoRecompilerMutex);
+				results.swap(m_ariiList);
+				msgs.swap(m_autoRecompileCachedMsgs);
+				checked.swap(m_autoRecompileChecked);
+				m_autoRecompileRequest = false;
+			}
+
+			// the checked stages only replace their own messages, the program stays
+			for (const auto& stage : checked)
+				m_data->Messages.ClearStage(stage.first, stage.second);
+
+			for (const auto& it : results) {
+				const AutoRecompilerItemInfo& info = it.second;
+				if (info.IsCompute && !info.CS.empty())
+					m_data->Renderer.RecompileFromSource(it.first.c_str(), info.CS);
+				else if (!info.IsCompute && (!info.VS.empty() || !info.PS.empty() || !info.GS.empty()))
+					m_data->Renderer.RecompileFromSource(it.first.c_str(), info.VS, info.PS, info.GS);
+				else {
+					m_data->Messages.ClearGroup(it.first); // nothing compiled - the current program stays, show why
+					ReloadProfiler::Instance().Cancel(it.first);
+				}
+			}
+			if (msgs.size() > 0)
+				m_data->Messages.Add(msgs);
+		}
+	}
+	void CodeEditorUI::m_queueAutoRecompile()
+	{
+		for (int i = 0; i < m_editor.size(); i++) {
+			if (!m_editor[i].IsTextChanged())
+				continue;
+
+			PipelineItem* item = m_items[i];
+			std::string key = std::string(item->Name) + ";" + std::to_string(m_shaderTypeId[i]);
+			std::string code = m_editor[i].GetText();
+			auto now = std::chrono::steady_clock::now();
+
+			// new edits are checked for errors, the stages that weren't edited for AUTO_RECOMPILE_IDLE are rebuilt
+			bool check = false;
+			std::chrono::steady_clock::time_point lastEdit = now;
+			uint64_t hash = HashString(code);
+			auto last = m_autoRecompileHashes.find(key);
+			if (last == m_autoRecompileHashes.end() || last->second != hash) {
+				m_autoRecompileHashes[key] = hash;
+				m_autoRecompileEdits[key] = now;
+				check = true;
+			} else {
+				auto edit = m_autoRecompileEdits.find(key);
+				if (edit == m_autoRecompileEdits.end() || now - edit->second < std::chrono::milliseconds(AUTO_RECOMPILE_IDLE))
+					continue;
+				lastEdit = edit->second;
+				m_autoRecompileEdits.erase(edit);
+			}
+
+			// these don't need the worker and can't be checked without rebuilding them
+			if (check && (item->Type == PipelineItem::ItemType::AudioPass || item->Type == PipelineItem::ItemType::PluginItem))
+				continue;
+			if (item->Type == PipelineItem::ItemType::AudioPass) {
+				m_data->Renderer.RecompileFromSource(item->Name, code);
+				continue;
+			}
+			else if (item->Type == PipelineItem::ItemType::PluginItem) {
+				pipe::PluginItemData* data = (pipe::PluginItemData*)item->Data;
+				data->Owner->HandleRecompileFromSource(item->Name, m_shaderTypeId[i], code.c_str(), code.size());
+				continue;
+			}
+
+			AutoRecompileJob job;
+			job.Item = item->Name;
+			job.Code = code;
+			job.GSUsed = false;
+
+			if (item->Type == PipelineItem::ItemType::ShaderPass) {
+				pipe::ShaderPass* pass = (pipe::ShaderPass*)item->Data;
+				job.Stage = m_shaderTypeId[i];
+				job.Macros = pass->Macros;
+				job.GSUsed = pass->GSUsed;
+				if (job.Stage == 0) {
+					job.Path = pass->VSPath;
+					job.Entry = pass->VSEntry;
+				} else if (job.Stage == 1) {
+					job.Path = pass->PSPath;
+					job.Entry = pass->PSEntry;
+				} else {
+					job.Path = pass->GSPath;
+					job.Entry = pass->GSEntry;
+				}
+			}
+			else if (item->Type == PipelineItem::ItemType::ComputePass) {
+				pipe::ComputePass* pass = (pipe::ComputePass*)item->Data;
+				job.Stage = 3;
+				job.Macros = pass->Macros;
+				job.Path = pass->Path;
+				job.Entry = pass->Entry;
+			}
+			else continue;
+
+			job.Language = ShaderTranscompiler::GetShaderTypeFromExtension(job.Path);
+			job.Path = m_data->Parser.GetProjectPath(job.Path);
+			job.CheckOnly = check;
+
+			// the driver reports the errors of GLSL faster than glslang would parse it
+			if (check && job.Language == ShaderLanguage::GLSL) {
+				m_checkGLSL(job.Item, job.Stage, job.Code);
+				continue;
 			}
-			if (m_autoRecompileCachedMsgs.size() > 0)
-				m_data->Messages.Add(m_autoRecompileCachedMsgs);
-			m_autoRecompileRequest = false;
+
+			// measured from the last edit, the idle time is a part of the latency - edits are only noticed every
+			// AUTO_RECOMPILE_INTERVAL so it can be that much shorter
+			if (!check)
+				ReloadProfiler::Instance().Begin(item->Name, "edit", lastEdit);
+
+			// replaces the job for the previous edit if the worker didn't pick it up yet
+			std::lock_guard<ED_LOCKABLE_BASE(std::mutex)> lock(m_autoRecompilerMutex);
+			job.Revision = ++m_autoRecompileRevisions[key];
+			m_autoRecompileJobs[key] = job;
+			m_autoRecompilePool.Add([this]() { m_autoRecompiler(); });
 		}
 	}
+	void CodeEditorUI::m_checkGLSL(const std::string& item, int stage, const std::string& code)
+	{
+		GLenum types[] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER, GL_GEOMETRY_SHADER, GL_COMPUTE_SHADER };
+		if (stage == 3 && !GLEW_ARB_compute_shader)
+			return;
+
+		GLchar msg[1024];
+		GLuint shader = gl::CompileShader(types[stage], code.c_str());
+		bool compiled = gl::CheckShaderCompilationStatus(shader, msg);
+		glDeleteShader(shader);
+
+		m_data->Messages.ClearStage(item, stage);
+		if (!compiled)
+			m_data->Messages.Add(gl::ParseMessages(item, stage, msg));
+	}
 	void CodeEditorUI::SetAutoRecompile(bool autorec)
 	{
 		if (m_autoRecompile == autorec)
@@ -730,127 +1065,106 @@ namespace ed
 
 			// stop if it was running before
 			m_autoRecompilerRunning = false;
-			if (m_autoRecompileThread != nullptr && m_autoRecompileThread->joinable())
-				m_autoRecompileThread->join();
-			delete m_autoRecompileThread;
-			m_autoRecompileThread = nullptr;
+			m_autoRecompilePool.Cancel();
+
+			m_autoRecompileHashes.clear();
+			m_autoRecompileEdits.clear();
+			{
+				std::lock_guard<ED_LOCKABLE_BASE(std::mutex)> lock(m_autoRecompilerMutex);
+				m_autoRecompileJobs.clear();
+				m_ariiList.clear();
+				m_autoRecompileChecked.clear();
+				m_autoRecompileCachedMsgs.clear();
+				m_autoRecompileRequest = false;
+			}
 
 			// rerun
 			m_autoRecompilerRunning = true;
-			m_autoRecompileThread = new std::thread(&CodeEditorUI::m_autoRecompiler, this);
 		}
 		else {
 			Logger::Get().Log("Stopping auto-recompiler...");
 
 			m_autoRecompilerRunning = false;
-
-			if (m_autoRecompileThread && m_autoRecompileThread->joinable())
-				m_autoRecompileThread->join();
-			delete m_autoRecompileThread;
-			m_autoRecompileThread = nullptr;
+			m_autoRecompilePool.Cancel();
 		}
 	}
 	void CodeEditorUI::m_autoRecompiler()
 	{		
 		while (m_autoRecompilerRunning) {
-			std::this_thread::sleep_for(std::chrono::milliseconds(200));
-
-			// get all the sources
-			if (!m_autoRecompilerMutex.try_lock())
-				continue;
+			std::string key;
+			AutoRecompileJob job;
+			bool hasJob = false;
+			{
+				std::lock_guard<ED_LOCKABLE_BASE(std::mutex)> lock(m_autoRecompilerMutex);
+				if (!m_autoRecompileJobs.empty()) {
+					auto first = m_autoRecompileJobs.begin();
+					key = first->first;
+					job = first->second;
+					m_autoRecompileJobs.erase(first);
+					hasJob = true;
+				}
+			}
 
-			m_ariiList.clear();
-			for (int i = 0; i < m_editor.size(); i++) {
-				if (!m_editor[i].IsTextChanged())
-					continue;
+			if (!hasJob)
+				return;
 
-				if (m_items[i]->Type == PipelineItem::ItemType::ShaderPass) {
-					AutoRecompilerItemInfo* inf = &m_ariiList[m_items[i]->Name];
-					pipe::ShaderPass* pass = (pipe::ShaderPass*)m_items[i]->Data;
-					inf->SPass = pass;
-					inf->CPass = nullptr;
-					inf->APass = nullptr;
-					inf->PluginData = nullptr;
-					
-					if (m_shaderTypeId[i] == 0) {
-						inf->VS = m_editor[i].GetText();
-						inf->VS_SLang = ShaderTranscompiler::GetShaderTypeFromExtension(pass->VSPath);
-					} else if (m_shaderTypeId[i] == 1) {
-						inf->PS = m_editor[i].GetText();
-						inf->PS_SLang = ShaderTranscompiler::GetShaderTypeFromExtension(pass->PSPath);
-					} else if (m_shaderTypeId[i] == 2) {
-						inf->GS = m_editor[i].GetText();
-						inf->GS_SLang = ShaderTranscompiler::GetShaderTypeFromExtension(pass->GSPath);
-					}
-				}
-				else if (m_items[i]->Type == PipelineItem::ItemType::ComputePass) {
-					AutoRecompilerItemInfo* inf = &m_ariiList[m_items[i]->Name];
-					pipe::ComputePass* pass = (pipe::ComputePass*)m_items[i]->Data;
-					inf->CPass = pass;
-					inf->SPass = nullptr;
-					inf->APass = nullptr;
-					inf->PluginData = nullptr;
-
-					inf->CS = m_editor[i].GetText();
-					inf->CS_SLang = ShaderTranscompiler::GetShaderTypeFromExtension(pass->Path);
-				}
-				else if (m_items[i]->Type == PipelineItem::ItemType::AudioPass) {
-					AutoRecompilerItemInfo *inf = &m_ariiList[m_items[i]->Name];
-					pipe::AudioPass *pass = (pipe::AudioPass *)m_items[i]->Data;
-					inf->APass = pass;
-					inf->SPass = nullptr;
-					inf->CPass = nullptr;
-					inf->PluginData = nullptr;
-					
-					inf->AS = m_editor[i].GetText();
-				}
-				else if (m_items[i]->Type == PipelineItem::ItemType::PluginItem) {
-					AutoRecompilerItemInfo* inf = &m_ariiList[m_items[i]->Name];
-					pipe::PluginItemData* pass = (pipe::PluginItemData*)m_items[i]->Data;
-					inf->APass = nullptr;
-					inf->SPass = nullptr;
-					inf->CPass = nullptr;
-					inf->PluginData = pass;
-
-					inf->PluginCode = m_editor[i].GetText();
-					inf->PluginID = m_shaderTypeId[i];
-				}
+			MessageStack msgs;
+			msgs.CurrentItem = job.Item;
+			msgs.CurrentItemType = job.Stage;
+
+			std::string code = job.Code;
+			bool failed = false;
+			ShaderTranscompiler::Timings timings;
+			if (job.CheckOnly)
+				failed = !ShaderTranscompiler::Check(job.Language, job.Path, job.Code, job.Stage, job.Entry, job.Macros, &msgs, &m_data->Parser);
+			else if (job.Language != ShaderLanguage::GLSL) {
+				code = ShaderTranscompiler::TranscompileSource(job.Language, job.Path, job.Code, job.Stage, job.Entry, job.Macros, job.GSUsed, &msgs, &m_data->Parser);
+				failed = code.empty() || code == "error" || code == "errorFile";
+				timings = ShaderTranscompiler::GetLastTimings();
 			}
 
-			// cache
-			std::vector<ed::MessageStack::Message> msgPrev = m_data->Messages.GetMessages();
-			m_autoRecompileCachedMsgs.clear();
-
-			for (auto& it : m_ariiList) {
-				if (it.second.SPass != nullptr) {
-					if (it.second.VS_SLang != ShaderLanguage::GLSL)
-						it.second.VS = ShaderTranscompiler::TranscompileSource(it.second.VS_SLang, m_data->Parser.GetProjectPath(it.second.SPass->VSPath), it.second.VS, 0, it.second.SPass->VSEntry, it.second.SPass->Macros, it.second.SPass->GSUsed, &m_data->Messages, &m_data->Parser);
-					if (it.second.PS_SLang != ShaderLanguage::GLSL)
-						it.second.PS = ShaderTranscompiler::TranscompileSource(it.second.PS_SLang, m_data->Parser.GetProjectPath(it.second.SPass->PSPath), it.second.PS, 1, it.second.SPass->PSEntry, it.second.SPass->Macros, it.second.SPass->GSUsed, &m_data->Messages, &m_data->Parser);
-					if (it.second.GS_SLang != ShaderLanguage::GLSL)
-						it.second.GS = ShaderTranscompiler::TranscompileSource(it.second.GS_SLang, m_data->Parser.GetProjectPath(it.second.SPass->GSPath), it.second.GS, 2, it.second.SPass->GSEntry, it.second.SPass->Macros, it.second.SPass->GSUsed, &m_data->Messages, &m_data->Parser);
-				} else if (it.second.CPass != nullptr) {
-					if (it.second.CS_SLang != ShaderLanguage::GLSL)
-						it.second.CS = ShaderTranscompiler::TranscompileSource(it.second.CS_SLang, m_data->Parser.GetProjectPath(it.second.CPass->Path), it.second.CS, 3, it.second.CPass->Entry, it.second.CPass->Macros, false, &m_data->Messages, &m_data->Parser);
-				}
+			std::lock_guard<ED_LOCKABLE_BASE(std::mutex)> lock(m_autoRecompilerMutex);
+
+			// the stage was edited again while this was compiling - that result is the one that matters
+			if (m_autoRecompileRevisions[key] != job.Revision)
+				continue;
+
+			if (!job.CheckOnly) {
+				ReloadProfiler& reload = ReloadProfiler::Instance();
+				reload.Add(job.Item, ReloadProfiler::Includes, timings.Preprocess);
+				reload.Add(job.Item, ReloadProfiler::Parse, timings.Parse);
+				reload.Add(job.Item, ReloadProfiler::SPIRV, timings.SPIRV);
+				reload.Add(job.Item, ReloadProfiler::Cross, timings.Cross);
 			}
 
-			std::vector<ed::MessageStack::Message> msgCurr = m_data->Messages.GetMessages();
-			for (int i = 0; i < msgCurr.size(); i++) {
-				for (int j = 0; j < msgPrev.size(); j++) {
-					if (msgCurr[i].Text == msgPrev[j].Text) {
-						msgCurr.erase(msgCurr.begin() + i);
-						msgPrev.erase(msgPrev.begin() + j);
-						i--;
-						break;
-					}
+			// messages of this stage that weren't published yet are outdated now
+			for (int i = 0; i < m_autoRecompileCachedMsgs.size(); i++)
+				if (m_autoRecompileCachedMsgs[i].Group == job.Item && m_autoRecompileCachedMsgs[i].Shader == job.Stage) {
+					m_autoRecompileCachedMsgs.erase(m_autoRecompileCachedMsgs.begin() + i);
+					i--;
 				}
+			std::vector<ed::MessageStack::Message>& stageMsgs = msgs.GetMessages();
+			m_autoRecompileCachedMsgs.insert(m_autoRecompileCachedMsgs.end(), stageMsgs.begin(), stageMsgs.end());
+
+			if (job.CheckOnly) {
+				m_autoRecompileChecked.push_back(std::make_pair(job.Item, job.Stage));
+				m_autoRecompileRequest = true;
+				UIRefresh::Instance().Request();
+				continue;
 			}
-			m_autoRecompileCachedMsgs = msgCurr;
 
-			m_autoRecompileRequest = m_ariiList.size()>0;
+			// failed stages keep the last program that worked
+			AutoRecompilerItemInfo& info = m_ariiList[job.Item];
+			info.IsCompute = job.Stage == 3;
+			if (!failed) {
+				if (job.Stage == 0) info.VS = code;
+				else if (job.Stage == 1) info.PS = code;
+				else if (job.Stage == 2) info.GS = code;
+				else info.CS = code;
+			}
 
-			m_autoRecompilerMutex.unlock();
+			m_autoRecompileRequest = true;
+			UIRefresh::Instance().Request();
 		}
 	}
 
@@ -871,6 +1185,13 @@ namespace ed
 			delete m_trackThread;
 			m_trackThread = nullptr;
 
+			{
+				std::lock_guard<ED_LOCKABLE_BASE(std::mutex)> lock(m_trackFilesMutex);
+				m_trackChanged.clear();
+				m_trackIgnore.clear();
+			}
+			m_trackListTime = std::chrono::steady_clock::time_point(); // build the list in the next UpdateTrackedFiles()
+
 			// start
 			m_trackerRunning = true;
 			m_trackThread = new std::thread(&CodeEditorUI::m_trackWorker, this);
@@ -887,426 +1208,368 @@ namespace ed
 			m_trackThread = nullptr;
 		}
 	}
-	void CodeEditorUI::m_trackWorker()
+	void CodeEditorUI::UpdateTrackedFiles()
 	{
-		std::string curProject = m_data->Parser.GetOpenedFile();
-
-		std::vector<PipelineItem*> passes = m_data->Pipeline.GetList();
-		std::vector<bool> gsUsed(passes.size());
-
-		std::vector<std::string> allFiles;		// list of all files we care for
-		std::vector<std::string> allPasses;		// list of shader pass names that correspond to the file name
-		std::vector<std::string> paths;			// list of all paths that we should have "notifications turned on"
-
-		m_trackUpdatesNeeded = 0;
-
-	#if defined(__APPLE__)
-		// TODO: implementation for macos (cant test)
-	#elif defined(__linux__) || defined(__unix__)
-	
-		int bufLength, bufIndex = 0;
-		int notifyEngine = inotify_init1(IN_NONBLOCK);
-		char buffer[EVENT_BUF_LEN];
+		if (!m_trackerRunning)
+			return;
 
-		std::vector<int> notifyIDs;
+		auto now = std::chrono::steady_clock::now();
 
-		if (notifyEngine < 0) {
-			// TODO: log!
-			return;
+		// includes are only known once the shaders were compiled so the list is refreshed every now and then
+		if (now - m_trackListTime > std::chrono::milliseconds(TRACK_LIST_INTERVAL)) {
+			m_trackListTime = now;
+			m_updateTrackedFileList();
 		}
 
-		// make sure that read() doesn't block on exit
-		int flags = fcntl(notifyEngine, F_GETFL, 0);
-		flags = (flags | O_NONBLOCK);
-		fcntl(notifyEngine, F_SETFL, flags);
+		// editors usually write a file in multiple steps - wait until they are done
+		std::vector<std::string> batch;
+		std::chrono::steady_clock::time_point changed;
+		{
+			std::lock_guard<ED_LOCKABLE_BASE(std::mutex)> lock(m_trackFilesMutex);
+			if (m_trackChanged.empty())
+				return;
 
-	#elif defined(_WIN32)
-		// variables for storing all the handles
-		std::vector<HANDLE> events(paths.size());
-		std::vector<HANDLE> hDirs(paths.size());
-		std::vector<OVERLAPPED> pOverlap(paths.size());
-
-		// buffer data
-		const int bufferLen = 2048;
-		char buffer[bufferLen];
-		DWORD bytesReturned;
-		char filename[MAX_PATH];
-	#endif
+			auto quiet = std::chrono::duration_cast<std::chrono::milliseconds>(now - m_trackLastChange).count();
+			if (quiet < TRACK_DEBOUNCE_TIME) {
+				UIRefresh::Instance().Request(TRACK_DEBOUNCE_TIME - quiet);
+				return;
+			}
 
-		// run this loop until we close the thread
-		while (m_trackerRunning) {
-			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			batch.assign(m_trackChanged.begin(), m_trackChanged.end());
+			m_trackChanged.clear();
+			changed = m_trackFirstChange;
+		}
 
-			for (int j = 0; j < m_trackedNeedsUpdate.size(); j++)
-				m_trackedNeedsUpdate[j] = false;
+		Logger::Get().Log(std::to_string(batch.size()) + " tracked file(s) changed");
 
-			// check if user added/changed shader paths
-			std::vector<PipelineItem*> nPasses = m_data->Pipeline.GetList();
-			bool needsUpdate = false;
-			for (auto& pass : nPasses) {
-				if (pass->Type == PipelineItem::ItemType::ShaderPass) {
-					pipe::ShaderPass* data = (pipe::ShaderPass*) pass->Data;
+		// plugins compile their own items
+		std::unordered_set<std::string> plugins;
+		for (const auto& file : m_trackPluginFiles)
+			if (std::count(batch.begin(), batch.end(), file.first) > 0)
+				plugins.insert(file.second);
+		for (const auto& name : plugins)
+			m_data->Renderer.Recompile(name.c_str());
 
-					bool foundVS = false, foundPS = false, foundGS = false;
+		m_data->Renderer.RecompileFiles(batch, "file change", changed);
+	}
+	void CodeEditorUI::m_updateTrackedFileList()
+	{
+		std::unordered_set<std::string> files;
+		m_trackPluginFiles.clear();
 
-					std::string vsPath(m_data->Parser.GetProjectPath(data->VSPath));
-					std::string psPath(m_data->Parser.GetProjectPath(data->PSPath));
+		auto addShader = [&](const char* path) {
+			if (strlen(path) == 0)
+				return;
 
-					for (auto& f : allFiles) {
-						if (f == vsPath) {
-							foundVS = true;
-							if (foundPS) break;
-						}
-						else if (f == psPath) {
-							foundPS = true;
-							if (foundVS) break;
-						}
-					}
+			std::string file = IncludeCache::Normalize(m_data->Parser.GetProjectPath(path));
+			files.insert(file);
 
-					if (data->GSUsed) {
-						std::string gsPath(m_data->Parser.GetProjectPath(data->GSPath));
-						for (auto& f : allFiles)
-							if (f == gsPath) {
-								foundGS = true;
-								break;
-							}
-					}
-					else foundGS = true;
+			std::vector<std::string> includes = IncludeCache::Instance().GetIncludes(file);
+			files.insert(includes.begin(), includes.end());
+		};
 
-					if (!foundGS || !foundVS || !foundPS) {
-						needsUpdate = true;
-						break;
-					}
+		std::vector<PipelineItem*>& passes = m_data->Pipeline.GetList();
+		for (PipelineItem* pass : passes) {
+			if (pass->Type == PipelineItem::ItemType::ShaderPass) {
+				pipe::ShaderPass* data = (pipe::ShaderPass*)pass->Data;
+				addShader(data->VSPath);
+				addShader(data->PSPath);
+				if (data->GSUsed)
+					addShader(data->GSPath);
+			}
+			else if (pass->Type == PipelineItem::ItemType::ComputePass)
+				addShader(((pipe::ComputePass*)pass->Data)->Path);
+			else if (pass->Type == PipelineItem::ItemType::AudioPass)
+				addShader(((pipe::AudioPass*)pass->Data)->Path);
+			else if (pass->Type == PipelineItem::ItemType::PluginItem) {
+				pipe::PluginItemData* data = (pipe::PluginItemData*)pass->Data;
+
+				if (data->Owner->HasShaderFilePathChanged())
+					data->Owner->UpdateShaderFilePath();
+
+				int count = data->Owner->GetShaderFilePathCount();
+				for (int i = 0; i < count; i++) {
+					std::string file = IncludeCache::Normalize(m_data->Parser.GetProjectPath(data->Owner->GetShaderFilePath(i)));
+					files.insert(file);
+					m_trackPluginFiles.push_back(std::make_pair(file, std::string(pass->Name)));
 				}
-				else if (pass->Type == PipelineItem::ItemType::ComputePass) {
-					pipe::ComputePass* data = (pipe::ComputePass*) pass->Data;
+			}
+		}
 
-					bool found = false;
+		std::lock_guard<ED_LOCKABLE_BASE(std::mutex)> lock(m_trackFilesMutex);
+		if (files != m_trackFiles) {
+			m_trackFiles = files;
+			m_trackFilesVersion++;
+		}
+	}
+	void CodeEditorUI::m_trackChange(const std::string& file)
+	{
+		// called by the worker (or by the FSEvents queue)
+		std::string path = IncludeCache::Normalize(file);
+		auto now = std::chrono::steady_clock::now();
 
-					std::string path(m_data->Parser.GetProjectPath(data->Path));
+		std::lock_guard<ED_LOCKABLE_BASE(std::mutex)> lock(m_trackFilesMutex);
+		if (m_trackFiles.count(path) == 0)
+			return;
 
-					for (auto& f : allFiles)
-						if (f == path)
-							found = true;
+		// did we modify this file through the "Compile" option?
+		auto ignore = m_trackIgnore.find(path);
+		if (ignore != m_trackIgnore.end()) {
+			if (now < ignore->second)
+				return;
+			m_trackIgnore.erase(ignore);
+		}
 
-					if (!found) {
-						needsUpdate = true;
-						break;
-					}
-				}
-				else if (pass->Type == PipelineItem::ItemType::AudioPass) {
-					pipe::AudioPass* data = (pipe::AudioPass*) pass->Data;
+		if (m_trackChanged.empty())
+			m_trackFirstChange = now;
+		m_trackChanged.insert(path);
+		m_trackLastChange = now;
 
-					bool found = false;
+		UIRefresh::Instance().Request(TRACK_DEBOUNCE_TIME);
+	}
+	void CodeEditorUI::m_trackWorker()
+	{
+		std::vector<std::string> paths; // list of all directories that we should have "notifications turned on" for
+		int version = -1;
 
-					std::string path(m_data->Parser.GetProjectPath(data->Path));
+	#if defined(__APPLE__)
+		FSEventStreamRef stream = nullptr;
+		dispatch_queue_t queue = dispatch_queue_create("SHADERed.FileTracker", DISPATCH_QUEUE_SERIAL);
+
+		FSEventStreamContext context;
+		memset(&context, 0, sizeof(context));
+		context.info = this;
+
+		// events are delivered on the queue, this thread only updates the stream
+		FSEventStreamCallback callback = [](ConstFSEventStreamRef streamRef, void* info, size_t count, void* eventPaths, const FSEventStreamEventFlags flags[], const FSEventStreamEventId ids[]) {
+			CodeEditorUI* editor = (CodeEditorUI*)info;
+			char** files = (char**)eventPaths;
+			for (size_t i = 0; i < count; i++)
+				if ((flags[i] & kFSEventStreamEventFlagItemIsFile) && (flags[i] & (kFSEventStreamEventFlagItemModified | kFSEventStreamEventFlagItemCreated | kFSEventStreamEventFlagItemRenamed)))
+					editor->m_trackChange(files[i]);
+		};
+	#elif defined(__linux__) || defined(__unix__)
+		int notifyEngine = inotify_init1(IN_NONBLOCK);
+		char buffer[EVENT_BUF_LEN];
 
-					for (auto& f : allFiles)
-						if (f == path)
-							found = true;
+		std::vector<int> notifyIDs;
 
-					if (!found) {
-						needsUpdate = true;
-						break;
-					}
-				}
-				else if (pass->Type == PipelineItem::ItemType::PluginItem) {
-					pipe::PluginItemData* data = (pipe::PluginItemData*) pass->Data;
+		if (notifyEngine < 0) {
+			Logger::Get().Log("Failed to initialize inotify - file changes won't be tracked", true);
+			return;
+		}
+	#elif defined(_WIN32)
+		struct WatchedDirectory
+		{
+			std::string Path;
+			HANDLE Dir;
+			OVERLAPPED Overlap;
+			DWORD Buffer[1024]; // FILE_NOTIFY_INFORMATION has to be DWORD aligned
+		};
+		std::vector<std::unique_ptr<WatchedDirectory>> dirs; // OVERLAPPED can't move while the read is pending
+		std::vector<HANDLE> events;
 
-					if (data->Owner->HasShaderFilePathChanged()) {
-						needsUpdate = true;
-						data->Owner->UpdateShaderFilePath();
-					}
-				}
-			}
+		auto readChanges = [](WatchedDirectory* dir) {
+			ReadDirectoryChangesW(dir->Dir, dir->Buffer, sizeof(dir->Buffer), TRUE,
+				FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME,
+				NULL, &dir->Overlap, NULL);
+		};
+	#endif
 
-			for (int i = 0; i < gsUsed.size() && i < nPasses.size(); i++) {
-				if (nPasses[i]->Type == PipelineItem::ItemType::ShaderPass) {
-					bool used = ((pipe::ShaderPass*) nPasses[i]->Data)->GSUsed;
-					if (gsUsed[i] != used) {
-						gsUsed[i] = used;
-						needsUpdate = true;
-					}
+		// run this loop until we close the thread
+		while (m_trackerRunning) {
+			// the list of tracked files is built on the main thread
+			std::vector<std::string> files;
+			bool needsUpdate = false;
+			{
+				std::lock_guard<ED_LOCKABLE_BASE(std::mutex)> lock(m_trackFilesMutex);
+				if (version != m_trackFilesVersion) {
+					version = m_trackFilesVersion;
+					files.assign(m_trackFiles.begin(), m_trackFiles.end());
+					needsUpdate = true;
 				}
 			}
 
-			// update our file collection if needed
-			if (needsUpdate || nPasses.size() != passes.size() || curProject != m_data->Parser.GetOpenedFile() ||
-				paths.size() == 0) {
+			if (needsUpdate) {
 #if defined(__APPLE__)
-				// TODO: implementation for macos
+				if (stream != nullptr) {
+					FSEventStreamStop(stream);
+					FSEventStreamInvalidate(stream);
+					FSEventStreamRelease(stream);
+					stream = nullptr;
+				}
 #elif defined(__linux__) || defined(__unix__)
 				for (int i = 0; i < notifyIDs.size(); i++)
 					inotify_rm_watch(notifyEngine, notifyIDs[i]);
 				notifyIDs.clear();
 #elif defined(_WIN32)
-				for (int i = 0; i < paths.size(); i++) {
-					CloseHandle(hDirs[i]);
-					CloseHandle(events[i]);
+				for (auto& dir : dirs) {
+					DWORD bytes = 0;
+					CancelIo(dir->Dir);
+					GetOverlappedResult(dir->Dir, &dir->Overlap, &bytes, TRUE);
+					CloseHandle(dir->Dir);
+					CloseHandle(dir->Overlap.hEvent);
 				}
+				dirs.clear();
 				events.clear();
-				hDirs.clear();
 #endif
 
-				allFiles.clear();
-				allPasses.clear();
 				paths.clear();
-				curProject = m_data->Parser.GetOpenedFile();
-
-				// get all paths to all shaders
-				passes = nPasses;
-				gsUsed.resize(passes.size());
-				m_trackedNeedsUpdate.resize(passes.size());
-				for (const auto& pass : passes) {
-					if (pass->Type == PipelineItem::ItemType::ShaderPass) {
-						pipe::ShaderPass* data = (pipe::ShaderPass*) pass->Data;
-
-						std::string vsPath(m_data->Parser.GetProjectPath(data->VSPath));
-						std::string psPath(m_data->Parser.GetProjectPath(data->PSPath));
-
-						allFiles.push_back(vsPath);
-						paths.push_back(vsPath.substr(0, vsPath.find_last_of("/\\") + 1));
-						allPasses.push_back(pass->Name);
-
-						allFiles.push_back(psPath);
-						paths.push_back(psPath.substr(0, psPath.find_last_of("/\\") + 1));
-						allPasses.push_back(pass->Name);
-
-						if (data->GSUsed) {
-							std::string gsPath(m_data->Parser.GetProjectPath(data->GSPath));
+				for (const auto& file : files) {
+					std::string dir = file.substr(0, file.find_last_of("/\\") + 1);
+					if (std::count(paths.begin(), paths.end(), dir) == 0)
+						paths.push_back(dir);
+				}
 
-							allFiles.push_back(gsPath);
-							paths.push_back(gsPath.substr(0, gsPath.find_last_of("/\\") + 1));
-							allPasses.push_back(pass->Name);
+#if defined(_WIN32) || defined(__APPLE__)
+				// these APIs watch the whole subtree - delete the directories that are subdirectories of other ones
+				for (int i = 0; i < paths.size(); i++)
+					for (int j = 0; j < paths.size(); j++)
+						if (i != j && paths[j].size() > paths[i].size() && paths[j].compare(0, paths[i].size(), paths[i]) == 0) {
+							paths.erase(paths.begin() + j);
+							if (j < i) i--;
+							j--;
 						}
-					}
-					else if (pass->Type == PipelineItem::ItemType::ComputePass) {
-						pipe::ComputePass* data = (pipe::ComputePass*) pass->Data;
-
-						std::string path(m_data->Parser.GetProjectPath(data->Path));
-
-						allFiles.push_back(path);
-						paths.push_back(path.substr(0, path.find_last_of("/\\") + 1));
-						allPasses.push_back(pass->Name);
-					}
-					else if (pass->Type == PipelineItem::ItemType::AudioPass) {
-						pipe::AudioPass* data = (pipe::AudioPass*) pass->Data;
-
-						std::string path(m_data->Parser.GetProjectPath(data->Path));
-
-						allFiles.push_back(path);
-						paths.push_back(path.substr(0, path.find_last_of("/\\") + 1));
-						allPasses.push_back(pass->Name);
-					}
-					else if (pass->Type == PipelineItem::ItemType::PluginItem) {
-						pipe::PluginItemData* data = (pipe::PluginItemData*) pass->Data;
-
-
-						int count = data->Owner->GetShaderFilePathCount();
-
-						for (int i = 0; i < count; i++) {
-							std::string path(m_data->Parser.GetProjectPath(data->Owner->GetShaderFilePath(i)));
+#endif
 
-							allFiles.push_back(path);
-							paths.push_back(path.substr(0, path.find_last_of("/\\") + 1));
-							allPasses.push_back(pass->Name);
-						}
+#if defined(__APPLE__)
+				if (paths.size() > 0) {
+					CFMutableArrayRef dirs = CFArrayCreateMutable(NULL, 0, &kCFTypeArrayCallBacks);
+					for (const auto& path : paths) {
+						CFStringRef str = CFStringCreateWithCString(NULL, path.c_str(), kCFStringEncodingUTF8);
+						CFArrayAppendValue(dirs, str);
+						CFRelease(str);
 					}
-				}
-
-				// delete directories that appear twice or that are subdirectories
-				{
-					std::vector<bool> toDelete(paths.size(), false);
 
-					for (int i = 0; i < paths.size(); i++) {
-						if (toDelete[i]) continue;
+					stream = FSEventStreamCreate(NULL, callback, &context, dirs, kFSEventStreamEventIdSinceNow, 0.05,
+						kFSEventStreamCreateFlagFileEvents | kFSEventStreamCreateFlagNoDefer);
+					CFRelease(dirs);
 
-						for (int j = 0; j < paths.size(); j++) {
-							if (j == i || toDelete[j]) continue;
-
-							if (paths[j].find(paths[i]) != std::string::npos)
-								toDelete[j] = true;
-						}
+					if (stream != nullptr) {
+						FSEventStreamSetDispatchQueue(stream, queue);
+						FSEventStreamStart(stream);
 					}
-
-					for (int i = 0; i < paths.size(); i++)
-						if (toDelete[i]) {
-							paths.erase(paths.begin() + i);
-							toDelete.erase(toDelete.begin() + i);
-							i--;
-						}
 				}
-
-#if defined(__APPLE__)
-				// TODO: implementation for macos
 #elif defined(__linux__) || defined(__unix__)
-				// create HANDLE to all tracked directories
+				// editors that save through a temporary file only cause IN_MOVED_TO
 				notifyIDs.resize(paths.size());
 				for (int i = 0; i < paths.size(); i++)
-					notifyIDs[i] = inotify_add_watch(notifyEngine, paths[i].c_str(), IN_MODIFY);
+					notifyIDs[i] = inotify_add_watch(notifyEngine, paths[i].c_str(), IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
 #elif defined(_WIN32)
-				events.resize(paths.size());
-				hDirs.resize(paths.size());
-				pOverlap.resize(paths.size());
-
 				// create HANDLE to all tracked directories
-				for (int i = 0; i < paths.size(); i++) {
-					hDirs[i] = CreateFileA(paths[i].c_str(), GENERIC_READ | FILE_LIST_DIRECTORY,
+				for (int i = 0; i < paths.size() && events.size() < MAXIMUM_WAIT_OBJECTS; i++) {
+					std::unique_ptr<WatchedDirectory> dir(new WatchedDirectory());
+					dir->Path = paths[i];
+					dir->Dir = CreateFileA(paths[i].c_str(), FILE_LIST_DIRECTORY,
 						FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
 						NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
 						NULL);
 
-					if (hDirs[i] == INVALID_HANDLE_VALUE)
-						return;
+					if (dir->Dir == INVALID_HANDLE_VALUE)
+						continue;
 
-					pOverlap[i].OffsetHigh = 0;
-					pOverlap[i].hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+					memset(&dir->Overlap, 0, sizeof(OVERLAPPED));
+					dir->Overlap.hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+					readChanges(dir.get());
 
-					events[i] = pOverlap[i].hEvent;
+					events.push_back(dir->Overlap.hEvent);
+					dirs.push_back(std::move(dir));
 				}
 #endif
 			}
 
+#if defined(__APPLE__)
+			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		}
+
+		if (stream != nullptr) {
+			FSEventStreamStop(stream);
+			FSEventStreamInvalidate(stream);
+			FSEventStreamRelease(stream);
+		}
+		dispatch_release(queue);
+#elif defined(__linux__) || defined(__unix__)
 			if (paths.size() == 0) {
-				std::this_thread::sleep_for(std::chrono::milliseconds(500));
+				std::this_thread::sleep_for(std::chrono::milliseconds(100));
 				continue;
 			}
 
-#if defined(__APPLE__)
-			// TODO: implementation for macos
-		}
-#elif defined(__linux__) || defined(__unix__)
+			// don't block for too long so that the list updates are picked up
 			fd_set rfds;
-			int eCount = select(notifyEngine + 1, &rfds, NULL, NULL, NULL);
+			FD_ZERO(&rfds);
+			FD_SET(notifyEngine, &rfds);
+			timeval timeout;
+			timeout.tv_sec = 0;
+			timeout.tv_usec = 100000;
 
+			int eCount = select(notifyEngine + 1, &rfds, NULL, NULL, &timeout);
 			if (eCount <= 0) continue;
 
-			// check for changes
-			bufLength = read(notifyEngine, buffer, EVENT_BUF_LEN);
-			if (bufLength < 0) { /* TODO: error! */ }
-
 			// read all events
-			while (bufIndex < bufLength) {
-				struct inotify_event* event = (struct inotify_event*) & buffer[bufIndex];
-				if (event->len) {
-					if (event->mask & IN_MODIFY) {
-						if (event->mask & IN_ISDIR) { /* it is a directory - do nothing */ }
-						else {
-							// check if its our shader and push it on the update queue if it is
-							char filename[MAX_PATH];
-							strcpy(filename, event->name);
-
-							int pathIndex = 0;
-							for (int i = 0; i < notifyIDs.size(); i++) {
-								if (event->wd == notifyIDs[i]) {
-									pathIndex = i;
-									break;
-								}
-							}
-
-							std::lock_guard<std::mutex> lock(m_trackFilesMutex);
-							std::string updatedFile(paths[pathIndex] + filename);
-
-							for (int i = 0; i < allFiles.size(); i++)
-								if (allFiles[i] == updatedFile) {
-									// did we modify this file through "Compile" option?
-									bool shouldBeIgnored = false;
-									for (int j = 0; j < m_trackIgnore.size(); j++)
-										if (m_trackIgnore[j] == allPasses[i]) {
-											shouldBeIgnored = true;
-											m_trackIgnore.erase(m_trackIgnore.begin() + j);
-											break;
-										}
-
-									if (!shouldBeIgnored) {
-										m_trackUpdatesNeeded++;
-
-										for (int j = 0; j < passes.size(); j++)
-											if (allPasses[i] == passes[j]->Name)
-												m_trackedNeedsUpdate[j] = true;
-									}
-								}
+			int bufLength = read(notifyEngine, buffer, EVENT_BUF_LEN);
+			for (int bufIndex = 0; bufIndex < bufLength; ) {
+				struct inotify_event* event = (struct inotify_event*)&buffer[bufIndex];
+				if (event->len && !(event->mask & IN_ISDIR)) {
+					for (int i = 0; i < notifyIDs.size(); i++)
+						if (event->wd == notifyIDs[i]) {
+							m_trackChange(paths[i] + event->name);
+							break;
 						}
-					}
 				}
 				bufIndex += EVENT_SIZE + event->len;
 			}
-			bufIndex = 0;
 		}
 
 		for (int i = 0; i < notifyIDs.size(); i++)
 			inotify_rm_watch(notifyEngine, notifyIDs[i]);
 		close(notifyEngine);
 #elif defined(_WIN32)
-			// notification data
-			FILE_NOTIFY_INFORMATION* notif;
-			int bufferOffset;
-
-			// check for changes
-			for (int i = 0; i < paths.size(); i++) {
-				ReadDirectoryChangesW(
-					hDirs[i],
-					&buffer,
-					bufferLen * sizeof(char),
-					TRUE,
-					FILE_NOTIFY_CHANGE_SIZE |
-					FILE_NOTIFY_CHANGE_LAST_WRITE,
-					&bytesReturned,
-					&pOverlap[i],
-					NULL);
+			if (events.size() == 0) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(100));
+				continue;
 			}
 
-			DWORD dwWaitStatus = WaitForMultipleObjects(paths.size(), events.data(), false, 1000);
+			DWORD dwWaitStatus = WaitForMultipleObjects(events.size(), events.data(), FALSE, 100);
+			if (dwWaitStatus < WAIT_OBJECT_0 || dwWaitStatus >= WAIT_OBJECT_0 + events.size())
+				continue;
 
-			// check if we got any info
-			if (dwWaitStatus != WAIT_TIMEOUT) {
-				bufferOffset = 0;
-				do
-				{
-					// get notification data
-					notif = (FILE_NOTIFY_INFORMATION*)((char*)buffer + bufferOffset);
-					strcpy_s(filename, "");
-					int filenamelen = WideCharToMultiByte(CP_ACP, 0, notif->FileName, notif->FileNameLength / 2, filename, sizeof(filename), NULL, NULL);
-					if (filenamelen == 0)
-						continue;
-					filename[notif->FileNameLength / 2] = 0;
-
-					if (notif->Action == FILE_ACTION_MODIFIED) {
-						std::lock_guard<std::mutex> lock(m_trackFilesMutex);
-
-						std::string updatedFile(paths[dwWaitStatus - WAIT_OBJECT_0] + std::string(filename));
-
-						for (int i = 0; i < allFiles.size(); i++)
-							if (allFiles[i] == updatedFile) {
-								// did we modify this file through "Compile" option?
-								bool shouldBeIgnored = false;
-								for (int j = 0; j < m_trackIgnore.size(); j++)
-									if (m_trackIgnore[j] == allPasses[i]) {
-										shouldBeIgnored = true;
-										m_trackIgnore.erase(m_trackIgnore.begin() + j);
-										break;
-									}
-
-								if (!shouldBeIgnored) {
-									m_trackUpdatesNeeded++;
-
-									for (int j = 0; j < passes.size(); j++)
-										if (allPasses[i] == passes[j]->Name)
-											m_trackedNeedsUpdate[j] = true;
-								}
-							}
+			WatchedDirectory* dir = dirs[dwWaitStatus - WAIT_OBJECT_0].get();
+
+			DWORD bytes = 0;
+			if (GetOverlappedResult(dir->Dir, &dir->Overlap, &bytes, FALSE) && bytes > 0) {
+				char* notifData = (char*)dir->Buffer;
+				while (true) {
+					FILE_NOTIFY_INFORMATION* notif = (FILE_NOTIFY_INFORMATION*)notifData;
+
+					char filename[MAX_PATH];
+					int filenamelen = WideCharToMultiByte(CP_ACP, 0, notif->FileName, notif->FileNameLength / 2, filename, MAX_PATH - 1, NULL, NULL);
+					if (filenamelen > 0 && (notif->Action == FILE_ACTION_MODIFIED || notif->Action == FILE_ACTION_ADDED || notif->Action == FILE_ACTION_RENAMED_NEW_NAME)) {
+						filename[filenamelen] = 0;
+
+						std::string updatedFile = dir->Path + filename;
+						std::replace(updatedFile.begin(), updatedFile.end(), '\\', '/');
+						m_trackChange(updatedFile);
 					}
 
-					bufferOffset += notif->NextEntryOffset;
-				} while (notif->NextEntryOffset);
+					if (notif->NextEntryOffset == 0)
+						break;
+					notifData += notif->NextEntryOffset;
+				}
 			}
+
+			ResetEvent(dir->Overlap.hEvent);
+			readChanges(dir);
 		}
-		for (int i = 0; i < hDirs.size(); i++)
-			CloseHandle(hDirs[i]);
-		for (int i = 0; i < events.size(); i++)
-			CloseHandle(events[i]);
+
+		for (auto& dir : dirs) {
+			DWORD bytes = 0;
+			CancelIo(dir->Dir);
+			GetOverlappedResult(dir->Dir, &dir->Overlap, &bytes, TRUE);
+			CloseHandle(dir->Dir);
+			CloseHandle(dir->Overlap.hEvent);
+		}
+		dirs.clear();
 		events.clear();
-		hDirs.clear();
 #endif
 	}
 
@@ -1355,11 +1618,109 @@ namespace ed
 	
 	void CodeEditorUI::StatsPage::Fetch(ed::PipelineItem* item, const std::string& code, int typeId)
 	{
+		m_item = item;
+		m_type = typeId;
+		IsActive = true;
 	}
 	void CodeEditorUI::StatsPage::Render()
 	{
-		// TODO: reimplement this
-		ImGui::Text("This function currently isn't implemented.");
-		ImGui::Text("TODO");
+		ShaderCostReport report = m_getReport(m_item, m_type);
+		if (!report.Available) {
+			ImGui::TextWrapped("No report available. The report is generated from the SPIR-V code, so it only exists for HLSL and Vulkan GLSL shaders that compiled successfully.");
+			return;
+		}
+
+		auto row = [](const char* name, int value) {
+			ImGui::Text("%s", name);
+			ImGui::NextColumn();
+			ImGui::Text("%d", value);
+			ImGui::NextColumn();
+		};
+
+		ImGui::Text("Instructions");
+		ImGui::Separator();
+		ImGui::Columns(2, "##stats_inst", false);
+		row("Total", report.Total);
+		row("ALU", report.ALU);
+		row("Texture", report.Texture);
+		row("Texture samples", report.TextureSamples);
+		row("Branches", report.Branch);
+		row("Loops", report.Loops);
+		row("Function calls", report.Calls);
+		row("Memory", report.Memory);
+		row("Other", report.Other);
+		ImGui::Columns(1);
+
+		ImGui::NewLine();
+		ImGui::Text("Registers (estimate)");
+		ImGui::Separator();
+		ImGui::Columns(2, "##stats_regs", false);
+		row("Peak live values", report.LiveValues);
+		row("Local variables", report.LocalVariables);
+		row("Functions", report.Functions);
+		ImGui::Columns(1);
+
+		ImGui::NewLine();
+		ImGui::Text("Resources");
+		ImGui::Separator();
+		ImGui::Columns(2, "##stats_res", false);
+		row("Inputs", report.Inputs);
+		row("Outputs", report.Outputs);
+		row("Uniform buffers", report.UniformBuffers);
+		row("Storage buffers", report.StorageBuffers);
+		row("Samplers", report.Samplers);
+		row("Images", report.Images);
+		row("Push constants", report.PushConstants);
+		ImGui::Columns(1);
+
+		ImGui::NewLine();
+		ImGui::TextWrapped("Counted from the SPIR-V before it gets converted to GLSL - the driver's output will differ, use this to compare shader variants.");
+
+		// lets the user see what the SPIR-V optimizer changed
+		ImGui::NewLine();
+		if (ImGui::CollapsingHeader("Transcompiled GLSL")) {
+			std::string glsl = ShaderTranscompiler::GetLastOutput(m_getShaderPath(m_item, m_type), m_type);
+			ImGui::InputTextMultiline("##stats_glsl", &glsl[0], glsl.size() + 1, ImVec2(-1, ImGui::GetTextLineHeightWithSpacing() * 30), ImGuiInputTextFlags_ReadOnly);
+		}
+	}
+	void CodeEditorUI::StatsPage::RenderSummary(ed::PipelineItem* item, int type)
+	{
+		ShaderCostReport report = m_getReport(item, type);
+		if (!report.Available)
+			return;
+
+		ImGui::SameLine();
+		ImGui::Text("\tALU: %d  Tex: %d  Branch: %d  Loops: %d  Live: %d", report.ALU, report.TextureSamples, report.Branch, report.Loops, report.LiveValues);
+	}
+	ShaderCostReport CodeEditorUI::StatsPage::m_getReport(ed::PipelineItem* item, int type)
+	{
+		std::string path = m_getShaderPath(item, type);
+		if (path.empty())
+			return ShaderCostReport();
+
+		return ShaderTranscompiler::GetCostReport(path, type);
+	}
+	std::string CodeEditorUI::StatsPage::m_getShaderPath(ed::PipelineItem* item, int type)
+	{
+		std::string path = "";
+		if (item == nullptr)
+			return "";
+		else if (item->Type == PipelineItem::ItemType::ShaderPass) {
+			ed::pipe::ShaderPass* shader = reinterpret_cast<ed::pipe::ShaderPass*>(item->Data);
+			if (type == 0)
+				path = shader->VSPath;
+			else if (type == 1)
+				path = shader->PSPath;
+			else if (type == 2)
+				path = shader->GSPath;
+		}
+		else if (item->Type == PipelineItem::ItemType::ComputePass)
+			path = reinterpret_cast<ed::pipe::ComputePass*>(item->Data)->Path;
+
+		if (path.empty())
+			return "";
+
+		// same path that the renderer passes to the transcompiler
+		return m_data->Parser.GetProjectPath(path);
 	}
 }
\ No newline at end of file
@@ -2,14 +2,21 @@
 #include "UIView.h"
 #include <ImGuiColorTextEdit/TextEditor.h>
 #include "../Objects/ShaderLanguage.h"
+#include "../Objects/ShaderTranscompiler.h"
 #include "../Objects/PipelineItem.h"
 #include "../Objects/Settings.h"
 #include "../Objects/Logger.h"
+#include "../Objects/ProfilerZones.h"
+#include "../Objects/SymbolIndex.h"
+#include "../Engine/ThreadPool.h"
 #include <imgui/examples/imgui_impl_sdl.h>
 #include <imgui/examples/imgui_impl_opengl3.h>
 #include <deque>
+#include <chrono>
 #include <future>
 #include <shared_mutex>
+#include <unordered_map>
+#include <unordered_set>
 #include <ghc/filesystem.hpp>
 
 namespace ed
@@ -17,7 +24,7 @@ namespace ed
 	class CodeEditorUI : public UIView
 	{
 	public:
-		CodeEditorUI(GUIManager* ui, ed::InterfaceManager* objects, const std::string& name = "", bool visible = false) : UIView(ui, objects, name, visible), m_selectedItem(-1) {
+		CodeEditorUI(GUIManager* ui, ed::InterfaceManager* objects, const std::string& name = "", bool visible = false) : UIView(ui, objects, name, visible), m_selectedItem(-1), m_autoRecompilePool(eng::JobPriority::Interactive, 1) {
 			Settings& sets = Settings::Instance(); // TODO: do this more often
 
 			if (ghc::filesystem::exists(sets.Editor.Font))
@@ -35,7 +42,7 @@ namespace ed
 			m_focusWindow = false;
 			m_trackFileChanges = false;
 			m_trackThread = nullptr;
-			m_autoRecompileThread = nullptr;
+			m_trackFilesVersion = 0;
 			m_autoRecompilerRunning = false;
 			m_autoRecompile = false;
 
@@ -126,15 +133,14 @@ namespace ed
 		void StopDebugging();
 
 		void SetTrackFileChanges(bool track);
-		inline bool TrackedFilesNeedUpdate() { return m_trackUpdatesNeeded > 0; }
-		inline void EmptyTrackedFiles() { m_trackUpdatesNeeded = 0; }
-		inline std::vector<bool> TrackedNeedsUpdate() { return m_trackedNeedsUpdate; }
+		void UpdateTrackedFiles(); // recompiles the stages affected by the files that changed on the disk
 
 		void CloseAll();
 		void CloseAllFrom(PipelineItem* item);
 
 		std::vector<std::pair<std::string, int>> GetOpenedFiles();
 		std::vector<std::string> GetOpenedFilesData();
+		void GetUnsavedFiles(std::vector<std::pair<std::string, std::string>>& out); // path as stored in the pass -> contents of the editor
 		void SetOpenedFilesData(const std::vector<std::string>& data);
 
 
@@ -142,17 +148,24 @@ namespace ed
 		class StatsPage
 		{
 		public:
-			StatsPage(InterfaceManager* im) : IsActive(false), Info(nullptr), m_data(im) {}
+			StatsPage(InterfaceManager* im) : IsActive(false), Info(nullptr), m_data(im), m_item(nullptr), m_type(0) {}
 			~StatsPage() { }
 
 			void Fetch(ed::PipelineItem* item, const std::string& code, int type);
 			void Render();
+			void RenderSummary(ed::PipelineItem* item, int type); // short version for the status bar
 
 			bool IsActive;
 			void* Info;
 
 		private:
+			// the report is read every frame so that it follows the recompiles
+			ShaderCostReport m_getReport(ed::PipelineItem* item, int type);
+			std::string m_getShaderPath(ed::PipelineItem* item, int type);
+
 			InterfaceManager* m_data;
+			ed::PipelineItem* m_item;
+			int m_type;
 		};
 
 
@@ -177,6 +190,29 @@ namespace ed
 		std::vector<PipelineItem*> m_items;
 		std::vector<TextEditor> m_editor; // TODO: use pointers here
 		std::vector<StatsPage> m_stats;
+
+		struct EditorState
+		{
+			EditorState() { Lines = 0; Deferred = false; ContentHash = SymbolsKey = 0; SymbolCount = 0; }
+
+			// large documents are recolored when the typing stops
+			int Lines;
+			TextEditor::Coordinates Cursor;
+			std::chrono::steady_clock::time_point LastEdit;
+			bool Deferred; // colorizer is off until the edits stop
+
+			uint64_t ContentHash; // of the unsaved text given to the symbol index, 0 -> none
+			uint64_t SymbolsKey; // SymbolIndex::Get() result for the includes when the language definition was built
+			size_t SymbolCount;
+		};
+		std::vector<EditorState> m_state;
+		void m_updateColorizer(int id);
+		void m_renderLineCost(int id); // heat bar of RegionDebugger::GetLineSteps() over the editor's gutter
+
+		// symbols of the included files for the autocomplete & the function tooltips
+		SymbolIndex m_symbols;
+		std::chrono::steady_clock::time_point m_symbolsTime;
+		void m_updateSymbols();
 		std::vector<std::string> m_paths;
 		std::vector<int> m_shaderTypeId;
 		std::deque<bool> m_editorOpen;
@@ -192,48 +228,64 @@ namespace ed
 
 		int m_selectedItem;
 
-		// auto recompile
-		std::thread* m_autoRecompileThread;
-		void m_autoRecompiler();
+		// auto recompile - the main thread queues the edited stages, a job on the scheduler transcompiles them one at a time
+		// every edit is only checked for errors (glslang parse, GL compile of GLSL), the program is rebuilt once the typing stops
+		eng::ThreadPool m_autoRecompilePool;
+		void m_autoRecompiler(); // runs until there are no queued stages left
+		void m_queueAutoRecompile();
+		void m_checkGLSL(const std::string& item, int stage, const std::string& code); // GL compile without a link, main thread
 		std::atomic<bool> m_autoRecompilerRunning, m_autoRecompileRequest;
 		std::vector<ed::MessageStack::Message> m_autoRecompileCachedMsgs;
 		bool m_autoRecompile;
-		std::shared_mutex m_autoRecompilerMutex;
+		ED_LOCKABLE(std::mutex, m_autoRecompilerMutex, "Auto recompiler");
+		std::chrono::steady_clock::time_point m_autoRecompileTime;
+		std::unordered_map<std::string, uint64_t> m_autoRecompileHashes; // text of every stage when it was last queued, main thread only
+		std::unordered_map<std::string, std::chrono::steady_clock::time_point> m_autoRecompileEdits; // item;stage -> last edit that wasn't fully recompiled yet, main thread only
+		std::vector<std::pair<std::string, int>> m_autoRecompileChecked; // item & stage whose messages are replaced by the cached ones
+		struct AutoRecompileJob
+		{
+			std::string Item;
+			int Stage; // 0 = VS, 1 = PS, 2 = GS, 3 = CS
+			std::string Code, Path, Entry;
+			std::vector<ShaderMacro> Macros;
+			bool GSUsed;
+			ShaderLanguage Language;
+			unsigned int Revision;
+			bool CheckOnly; // only the messages, the program isn't rebuilt
+		};
+		std::unordered_map<std::string, AutoRecompileJob> m_autoRecompileJobs; // item;stage -> only the newest edit, older ones are dropped
+		std::unordered_map<std::string, unsigned int> m_autoRecompileRevisions; // item;stage -> newest revision
 		struct AutoRecompilerItemInfo
 		{
 			AutoRecompilerItemInfo() {
 				VS = PS = GS = CS = "";
-				VS_SLang = PS_SLang = GS_SLang = CS_SLang = ShaderLanguage::GLSL;
-
-				SPass = nullptr;
-				CPass = nullptr;
+				IsCompute = false;
 			}
-			std::string VS, PS, GS;
-			ShaderLanguage VS_SLang, PS_SLang, GS_SLang;
-			pipe::ShaderPass* SPass;
-
+			std::string VS, PS, GS; // empty = keep the current shader
 			std::string CS;
-			ShaderLanguage CS_SLang;
-			pipe::ComputePass* CPass;
-
-			std::string AS;
-			pipe::AudioPass* APass;
-
-			std::string PluginCode;
-			int PluginID;
-			pipe::PluginItemData* PluginData;
+			bool IsCompute;
 		};
-		std::unordered_map<std::string, AutoRecompilerItemInfo> m_ariiList;
+		std::unordered_map<std::string, AutoRecompilerItemInfo> m_ariiList; // results that weren't published yet
 
 		// all the variables needed for the file change notifications
-		std::vector<bool> m_trackedNeedsUpdate;
-
 		bool m_trackFileChanges;
 		std::atomic<bool> m_trackerRunning;
-		std::atomic<int> m_trackUpdatesNeeded;
-		std::vector<std::string> m_trackIgnore;
 		std::thread* m_trackThread;
-		std::mutex m_trackFilesMutex;
+		std::chrono::steady_clock::time_point m_trackListTime;
+		std::vector<std::pair<std::string, std::string>> m_trackPluginFiles; // file + plugin item name
+
+		// shared with the worker, guarded by m_trackFilesMutex - all the paths are absolute & normalized
+		ED_LOCKABLE(std::mutex, m_trackFilesMutex, "Tracked files");
+		std::unordered_set<std::string> m_trackFiles; // shaders and every file they include
+		int m_trackFilesVersion;
+		std::unordered_set<std::string> m_trackChanged;
+		std::chrono::steady_clock::time_point m_trackLastChange;
+		std::chrono::steady_clock::time_point m_trackFirstChange; // of the batch in m_trackChanged
+		std::unordered_map<std::string, std::chrono::steady_clock::time_point> m_trackIgnore; // files saved by the editor itself
+
 		void m_trackWorker();
+		void m_trackChange(const std::string& file);
+		void m_updateTrackedFileList();
+		std::string m_getShaderFile(int id);
 	};
 }
\ No newline at end of file
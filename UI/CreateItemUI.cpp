@@ -6,7 +6,7 @@
 #include "../Objects/ThemeContainer.h"
 #include "../Objects/ShaderTranscompiler.h"
 #include "../Objects/SystemVariableManager.h"
-#include "../Engine/GeometryFactory.h"
+#include "../Objects/GeometryCache.h"
 #include "../Engine/Model.h"
 #include "../Engine/GLUtils.h"
 
@@ -96,6 +96,26 @@ namespace ed
 				ImGui::DragFloat("##cui_geosize", &data->Size.x);
 				ImGui::NextColumn();
 			}
+			else if (data->Type == pipe::GeometryItem::GeometryType::Generated) {
+				ImGui::Text("Shape:");
+				ImGui::NextColumn();
+				ImGui::PushItemWidth(-1);
+				ImGui::Combo("##cui_geoshape", &data->GenShape, " Grid\0 Terrain\0 Sphere\0 Scatter\0");
+				ImGui::NextColumn();
+
+				ImGui::Text("Size:");
+				ImGui::NextColumn();
+				ImGui::PushItemWidth(-1);
+				ImGui::DragFloat3("##cui_geosize", glm::value_ptr(data->Size));
+				ImGui::NextColumn();
+
+				ImGui::Text("Resolution:");
+				ImGui::NextColumn();
+				ImGui::PushItemWidth(-1);
+				if (ImGui::InputInt2("##cui_georesolution", glm::value_ptr(data->GenResolution)))
+					data->GenResolution = glm::clamp(data->GenResolution, glm::ivec2(1), glm::ivec2(4096));
+				ImGui::NextColumn();
+			}
 		}
 		else if (m_item.Type == PipelineItem::ItemType::ShaderPass) {
 			pipe::ShaderPass* data = (pipe::ShaderPass*)m_item.Data;
@@ -703,6 +723,8 @@ namespace ed
 			pipe::Model* allocatedData = new pipe::Model();
 			allocatedData->OnlyGroup = false;
 			allocatedData->Scale = glm::vec3(1, 1, 1);
+			allocatedData->FrustumCulling = true;
+			allocatedData->AnimationSpeed = 1.0f;
 			m_item.Data = allocatedData;
 		}
 	}
@@ -818,10 +840,16 @@ namespace ed
 		std::transform(vname.begin(), vname.end(), vname.begin(), tolower);
 
 		// list of rules for detection:
-		if (vname.find("time") != std::string::npos && vname.find("d") == std::string::npos && vname.find("del") == std::string::npos && vname.find("delta") == std::string::npos)
+		if (vname.find("audio") != std::string::npos && (vname.find("pos") != std::string::npos || vname.find("time") != std::string::npos))
+			return SystemShaderVariable::AudioPosition;
+		else if (vname.find("time") != std::string::npos && vname.find("d") == std::string::npos && vname.find("del") == std::string::npos && vname.find("delta") == std::string::npos)
 			return SystemShaderVariable::Time;
 		else if (vname.find("time") != std::string::npos && (vname.find("d") != std::string::npos || vname.find("del") != std::string::npos || vname.find("delta") != std::string::npos))
 			return SystemShaderVariable::TimeDelta;
+		else if (vname.find("iter") != std::string::npos)
+			return SystemShaderVariable::IterationIndex;
+		else if (vname.find("sample") != std::string::npos && (vname.find("index") != std::string::npos || vname.find("count") != std::string::npos))
+			return SystemShaderVariable::SampleIndex;
 		else if (vname.find("frame") != std::string::npos || vname.find("index") != std::string::npos)
 			return SystemShaderVariable::FrameIndex;
 		else if (vname.find("size") != std::string::npos || vname.find("window") != std::string::npos || vname.find("viewport") != std::string::npos || vname.find("resolution") != std::string::npos || vname.find("res") != std::string::npos)
@@ -884,6 +912,14 @@ namespace ed
 			data->WorkX = origData->WorkX;
 			data->WorkY = origData->WorkY;
 			data->WorkZ = origData->WorkZ;
+			data->IndirectBuffer = origData->IndirectBuffer;
+			data->IndirectOffset = origData->IndirectOffset;
+			data->ConditionBuffer = origData->ConditionBuffer;
+			data->ConditionOffset = origData->ConditionOffset;
+			data->Iterations = origData->Iterations;
+			data->PingPong = origData->PingPong;
+			data->AutoBarrier = origData->AutoBarrier;
+			data->Barrier = origData->Barrier;
 
 			m_errorOccured = !m_data->Pipeline.AddComputePass(m_item.Name, data);
 			return !m_errorOccured;
@@ -916,23 +952,12 @@ namespace ed
 				data->Size = origData->Size;
 				data->Topology = GL_TRIANGLES;
 				data->Type = origData->Type;
+				data->GenShape = origData->GenShape;
+				data->GenResolution = origData->GenResolution;
 
-				if (data->Type == pipe::GeometryItem::GeometryType::Cube)
-					data->VAO = eng::GeometryFactory::CreateCube(data->VBO, data->Size.x, data->Size.y, data->Size.z, inpLayout);
-				else if (data->Type == pipe::GeometryItem::Circle) {
-					data->VAO = eng::GeometryFactory::CreateCircle(data->VBO, data->Size.x, data->Size.y, inpLayout);
+				GeometryCache::Instance().Create(data, inpLayout);
+				if (data->Type == pipe::GeometryItem::Circle)
 					data->Topology = GL_TRIANGLE_STRIP;
-				}
-				else if (data->Type == pipe::GeometryItem::Plane)
-					data->VAO = eng::GeometryFactory::CreatePlane(data->VBO,data->Size.x, data->Size.y, inpLayout);
-				else if (data->Type == pipe::GeometryItem::Rectangle)
-					data->VAO = eng::GeometryFactory::CreatePlane(data->VBO, 1, 1, inpLayout);
-				else if (data->Type == pipe::GeometryItem::Sphere)
-					data->VAO = eng::GeometryFactory::CreateSphere(data->VBO, data->Size.x, inpLayout);
-				else if (data->Type == pipe::GeometryItem::Triangle)
-					data->VAO = eng::GeometryFactory::CreateTriangle(data->VBO, data->Size.x, inpLayout);
-				else if (data->Type == pipe::GeometryItem::ScreenQuadNDC)
-					data->VAO = eng::GeometryFactory::CreateScreenQuadNDC(data->VBO, inpLayout);
 
 				m_errorOccured = !m_data->Pipeline.AddItem(m_owner, m_item.Name, m_item.Type, data);
 				return !m_errorOccured;
@@ -956,6 +981,11 @@ namespace ed
 				data->Scale = origData->Scale;
 				data->Position = origData->Position;
 				data->Rotation = origData->Rotation;
+				data->LOD = origData->LOD;
+				data->FrustumCulling = origData->FrustumCulling;
+				data->GPUCulling = origData->GPUCulling;
+				strcpy(data->Animation, origData->Animation);
+				data->AnimationSpeed = origData->AnimationSpeed;
 			
 
 				if (strlen(data->Filename) > 0) {
@@ -5,7 +5,7 @@ namespace ed
 {
 	void DebugFunctionStackUI::Refresh()
 	{
-		m_stack = m_data->Debugger.Engine.GetFunctionStack();
+		m_stack = m_data->Debugger.Engine->GetFunctionStack();
 	}
 	void DebugFunctionStackUI::OnEvent(const SDL_Event& e)
 	{}
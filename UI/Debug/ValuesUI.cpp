@@ -8,7 +8,7 @@ namespace ed
 	{}
 	void DebugValuesUI::Update(float delta)
 	{
-		sd::ShaderDebugger* dbgr = &m_data->Debugger.Engine;
+		sd::ShaderDebugger* dbgr = m_data->Debugger.Engine;
 		const auto& globals = dbgr->GetCompiler()->GetGlobals();
 		const auto& locals = dbgr->GetCurrentFunctionLocals();
 		const auto& funcs = dbgr->GetCompiler()->GetFunctions();
@@ -14,7 +14,7 @@ namespace ed
 	{}
 	void DebugWatchUI::Update(float delta)
 	{
-		sd::ShaderDebugger* dbgr = &m_data->Debugger.Engine;
+		sd::ShaderDebugger* dbgr = m_data->Debugger.Engine;
 		std::vector<char*>& exprs = m_data->Debugger.GetWatchList();
 
 		// Main window
@@ -0,0 +1,422 @@
+#include "MemoryUI.h"
+#include "../Objects/Names.h"
+#include "../Objects/Settings.h"
+#include "../Objects/RenderTargetPool.h"
+#include <imgui/imgui.h>
+#include <algorithm>
+#include <stdio.h>
+
+#define MEMORY_REFRESH_INTERVAL 0.5f // seconds between two GL queries of the whole list
+
+namespace ed
+{
+	static inline GLuint64 getResourceKey(bool isBuffer, GLuint id)
+	{
+		return ((GLuint64)isBuffer << 32) | id;
+	}
+	static GLenum getTextureBinding(GLenum target)
+	{
+		switch (target) {
+		case GL_TEXTURE_3D: return GL_TEXTURE_BINDING_3D;
+		case GL_TEXTURE_CUBE_MAP: return GL_TEXTURE_BINDING_CUBE_MAP;
+		case GL_TEXTURE_2D_ARRAY: return GL_TEXTURE_BINDING_2D_ARRAY;
+		case GL_TEXTURE_2D_MULTISAMPLE: return GL_TEXTURE_BINDING_2D_MULTISAMPLE;
+		}
+		return GL_TEXTURE_BINDING_2D;
+	}
+	static std::string getFormatName(GLuint format)
+	{
+		switch (format) {
+		case 0: return "-";
+		case GL_DEPTH24_STENCIL8: return "DEPTH24_STENCIL8";
+		case GL_DEPTH32F_STENCIL8: return "DEPTH32F_STENCIL8";
+		case GL_DEPTH_COMPONENT16: return "DEPTH16";
+		case GL_DEPTH_COMPONENT24: return "DEPTH24";
+		case GL_DEPTH_COMPONENT32F: return "DEPTH32F";
+		}
+
+		const char* name = gl::String::Format(format);
+		if (name != FORMAT_NAMES[0])
+			return name;
+
+		// compressed & other formats that the UI doesn't offer
+		char hex[16];
+		sprintf(hex, "0x%04X", format);
+		return hex;
+	}
+	static std::string getByteString(size_t bytes)
+	{
+		char str[32];
+		if (bytes >= 1024 * 1024)
+			sprintf(str, "%.2f MB", bytes / (1024.0f * 1024.0f));
+		else if (bytes >= 1024)
+			sprintf(str, "%.2f KB", bytes / 1024.0f);
+		else
+			sprintf(str, "%d B", (int)bytes);
+		return str;
+	}
+
+	void MemoryUI::OnEvent(const SDL_Event& e)
+	{}
+	void MemoryUI::Update(float delta)
+	{
+		m_advisor.Update(&m_data->Objects, &m_data->Pipeline);
+
+		m_timer -= delta;
+		if (ImGui::Button("Refresh##memory_refresh") || m_timer <= 0.0f) {
+			m_collect();
+			m_timer = MEMORY_REFRESH_INTERVAL;
+		}
+		ImGui::SameLine();
+
+		size_t total = 0;
+		for (const auto& entry : m_entries)
+			total += entry.Bytes;
+
+		// budget of the whole GPU, the other applications use it too (in KB)
+		GLint dedicated = -1, available = -1;
+		if (GLEW_NVX_gpu_memory_info) {
+			glGetIntegerv(GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX, &dedicated);
+			glGetIntegerv(GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, &available);
+		} else if (GLEW_ATI_meminfo) {
+			GLint mem[4] = { -1, -1, -1, -1 };
+			glGetIntegerv(GL_TEXTURE_FREE_MEMORY_ATI, mem);
+			available = mem[0];
+		}
+
+		ImGui::Text("Estimated: %s in %d allocations", getByteString(total).c_str(), (int)m_entries.size());
+		if (dedicated > 0) {
+			float used = (float)(dedicated - available) / dedicated;
+			char overlay[128];
+			sprintf(overlay, "%.0f / %.0f MB used on the GPU, %.0f MB by the project", (dedicated - available) / 1024.0f, dedicated / 1024.0f, total / (1024.0f * 1024.0f));
+			ImGui::ProgressBar(used, ImVec2(-1, 0), overlay);
+		} else if (available >= 0)
+			ImGui::Text("Free texture memory: %.0f MB", available / 1024.0f);
+		else
+			ImGui::TextDisabled("GL_NVX_gpu_memory_info and GL_ATI_meminfo aren't supported - the GPU's budget is not available.");
+
+		ImGui::Separator();
+
+		if (ImGui::CollapsingHeader("Format advisor##memory_advisor"))
+			m_renderAdvisor();
+
+		ImGui::BeginChild("##memory_container", ImVec2(-1, -1));
+
+		ImGui::Columns(6);
+		ImGui::SetColumnWidth(0, 200.0f * Settings::Instance().DPIScale);
+
+		ImGui::Text("Name"); ImGui::NextColumn();
+		ImGui::Text("Type"); ImGui::NextColumn();
+		ImGui::Text("Format"); ImGui::NextColumn();
+		ImGui::Text("Dimensions"); ImGui::NextColumn();
+		ImGui::Text("Size"); ImGui::NextColumn();
+		ImGui::Text("Last used"); ImGui::NextColumn();
+		ImGui::Separator();
+
+		unsigned int frame = m_data->Renderer.GetFrameIndex();
+		for (const auto& entry : m_entries) {
+			ImGui::Text("%s", entry.Name.c_str()); ImGui::NextColumn();
+			ImGui::Text("%s", entry.Kind.c_str()); ImGui::NextColumn();
+			ImGui::Text("%s", getFormatName(entry.Format).c_str()); ImGui::NextColumn();
+
+			if (entry.Format == 0)
+				ImGui::Text("-");
+			else if (entry.Size.z > 1)
+				ImGui::Text("%dx%dx%d", entry.Size.x, entry.Size.y, entry.Size.z);
+			else
+				ImGui::Text("%dx%d", entry.Size.x, entry.Size.y);
+			if (entry.Samples > 0) {
+				ImGui::SameLine();
+				ImGui::Text("%dx MSAA", entry.Samples);
+			} else if (entry.Levels > 1) {
+				ImGui::SameLine();
+				ImGui::Text("%d mips", entry.Levels);
+			}
+			ImGui::NextColumn();
+
+			if (entry.Bytes == 0)
+				ImGui::TextDisabled("unknown");
+			else
+				ImGui::Text("%s", getByteString(entry.Bytes).c_str());
+			ImGui::NextColumn();
+
+			if (entry.LastUsed == 0)
+				ImGui::TextDisabled("never");
+			else if (entry.LastUsed == frame)
+				ImGui::Text("this frame");
+			else
+				ImGui::Text("%u frames ago", frame - entry.LastUsed);
+			ImGui::NextColumn();
+		}
+
+		ImGui::Columns(1);
+		ImGui::EndChild();
+	}
+	void MemoryUI::m_renderAdvisor()
+	{
+		if (!TextureStatistics::IsSupported()) {
+			ImGui::TextDisabled("The format advisor needs compute shaders (OpenGL 4.3).");
+			return;
+		}
+
+		if (m_advisor.IsRunning()) {
+			if (ImGui::Button("Cancel##memory_advisor_cancel"))
+				m_advisor.Cancel();
+			ImGui::SameLine();
+			ImGui::ProgressBar(m_advisor.GetProgress(), ImVec2(-1, 0), "Sampling the render textures...");
+			return;
+		}
+
+		if (ImGui::Button("Analyze##memory_advisor_start"))
+			m_advisor.Start(&m_data->Objects);
+		ImGui::SameLine();
+		ImGui::TextDisabled("(?)");
+		if (ImGui::IsItemHovered())
+			ImGui::SetTooltip("Reads the values of every 2D render texture for %d frames and suggests\nthe smallest format that still holds them. Run it while the preview shows\nthe usual range of values - the suggestions are only as good as the frames.", FORMAT_ADVISOR_FRAMES);
+
+		std::vector<FormatAdvisor::Suggestion>& suggestions = m_advisor.GetSuggestions();
+		if (suggestions.empty()) {
+			ImGui::TextDisabled("No suggestions.");
+			return;
+		}
+
+		size_t vram = 0, bandwidth = 0;
+		for (const auto& suggestion : suggestions) {
+			vram += suggestion.CurrentBytes - suggestion.SuggestedBytes;
+			bandwidth += suggestion.Bandwidth;
+		}
+		ImGui::Text("Savings: %s of memory, up to %s of bandwidth per frame", getByteString(vram).c_str(), getByteString(bandwidth).c_str());
+
+		ImGui::Columns(5, "##memory_advisor_columns");
+		ImGui::SetColumnWidth(0, 200.0f * Settings::Instance().DPIScale);
+
+		ImGui::Text("Name"); ImGui::NextColumn();
+		ImGui::Text("Format"); ImGui::NextColumn();
+		ImGui::Text("Memory"); ImGui::NextColumn();
+		ImGui::Text("Bandwidth"); ImGui::NextColumn();
+		ImGui::NextColumn();
+		ImGui::Separator();
+
+		std::string applied = "";
+		for (const auto& suggestion : suggestions) {
+			ImGui::Text("%s", suggestion.Name.c_str()); ImGui::NextColumn();
+
+			ImGui::Text("%s -> %s", getFormatName(suggestion.Current).c_str(), getFormatName(suggestion.Suggested).c_str());
+			if (suggestion.Lossy)
+				ImGui::TextColored(ImVec4(1.0f, 0.8f, 0.2f, 1.0f), "%s", suggestion.Reason.c_str());
+			else
+				ImGui::TextDisabled("%s", suggestion.Reason.c_str());
+			ImGui::NextColumn();
+
+			ImGui::Text("-%s", getByteString(suggestion.CurrentBytes - suggestion.SuggestedBytes).c_str()); ImGui::NextColumn();
+
+			if (suggestion.Bandwidth == 0)
+				ImGui::TextDisabled("not used");
+			else
+				ImGui::Text("-%s", getByteString(suggestion.Bandwidth).c_str());
+			ImGui::NextColumn();
+
+			if (ImGui::Button(("Apply##memory_advisor_apply_" + suggestion.Name).c_str()))
+				applied = suggestion.Name;
+			ImGui::NextColumn();
+		}
+		ImGui::Columns(1);
+
+		if (!applied.empty()) {
+			RenderTextureObject* rt = m_data->Objects.GetRenderTexture(applied);
+			if (rt != nullptr) {
+				for (const auto& suggestion : suggestions)
+					if (suggestion.Name == applied)
+						rt->Format = suggestion.Suggested;
+
+				glm::ivec2 wsize = m_data->Renderer.GetLastRenderSize();
+				m_data->Objects.ResizeRenderTexture(applied, rt->CalculateSize(wsize.x, wsize.y));
+				m_data->Parser.ModifyProject();
+			}
+
+			m_advisor.Remove(applied);
+			m_collect();
+		}
+	}
+	void MemoryUI::m_collect()
+	{
+		m_entries.clear();
+		m_seen.clear();
+
+		ObjectManager& objects = m_data->Objects;
+		for (const std::string& name : objects.GetObjects()) {
+			ObjectManagerItem* item = objects.GetObjectManagerItem(name);
+			if (item == nullptr)
+				continue;
+
+			if (item->RT != nullptr)
+				m_addTexture(name, "Render texture", item->RT->GetTarget(), item->Texture);
+			else if (item->Buffer != nullptr)
+				m_addBuffer(name, "Buffer", item->Buffer->ID);
+			else if (item->Image != nullptr)
+				m_addTexture(name, "Image", GL_TEXTURE_2D, item->Image->Texture);
+			else if (item->Image3D != nullptr)
+				m_addTexture(name, "Image 3D", GL_TEXTURE_3D, item->Image3D->Texture);
+			else if (item->Plugin != nullptr) {
+				// plugins bind their objects themselves - only buffers can be measured without knowing the texture target
+				std::string kind = "Plugin (" + std::string(item->Plugin->Type) + ")";
+				if (glIsBuffer(item->Plugin->ID))
+					m_addBuffer(name, kind, item->Plugin->ID);
+				else if (m_seen.insert(getResourceKey(false, item->Plugin->ID)).second) {
+					Entry entry;
+					entry.Name = name;
+					entry.Kind = kind;
+					entry.LastUsed = m_data->Renderer.GetLastUsed(false, item->Plugin->ID);
+					m_entries.push_back(entry);
+				}
+			} else if (item->Video != nullptr) {
+				m_addTexture(name, "Video", GL_TEXTURE_2D, item->Texture);
+				for (int i = 0; i < VIDEO_UPLOAD_PBOS; i++)
+					m_addBuffer(name + " (upload " + std::to_string(i) + ")", "Video", item->Video->PBO[i]);
+			} else if (item->Sound != nullptr)
+				m_addTexture(name, "Audio", GL_TEXTURE_2D, item->Texture);
+			else if (item->Environment != nullptr || (item->EnvironmentOf != nullptr && item->IsCube))
+				m_addTexture(name, "Environment map", GL_TEXTURE_CUBE_MAP, item->Texture);
+			else if (item->EnvironmentOf != nullptr)
+				m_addTexture(name, "Environment map", GL_TEXTURE_2D, item->Texture);
+			else if (item->Sequence != nullptr) {
+				m_addTexture(name, "Image sequence", GL_TEXTURE_2D, item->Texture);
+				for (int i = 0; i < item->Sequence->GetRingSize(); i++)
+					m_addBuffer(name + " (frame " + std::to_string(i) + ")", "Image sequence", item->Sequence->GetRingBuffer(i));
+			}
+			else if (item->IsCube)
+				m_addTexture(name, "Cubemap", GL_TEXTURE_CUBE_MAP, item->Texture);
+			else if (item->IsTextureArray)
+				m_addTexture(name, "Texture array", GL_TEXTURE_2D_ARRAY, item->Texture);
+			else if (item->Texture != 0)
+				m_addTexture(name, "Texture", GL_TEXTURE_2D, item->Texture);
+
+			if (item->FlippedTexture != 0)
+				m_addTexture(name + " (flipped)", "Texture", GL_TEXTURE_2D, item->FlippedTexture);
+		}
+		m_addTexture("Audio texture array", "Audio", GL_TEXTURE_2D_ARRAY, objects.GetAudioTextureArray());
+		m_addBuffer("Bindless table", "Buffer", objects.GetBindlessTable());
+
+		// geometry & models, the same imported model can be used by several items
+		for (PipelineItem* pass : m_data->Pipeline.GetList()) {
+			if (pass->Type != PipelineItem::ItemType::ShaderPass)
+				continue;
+
+			for (PipelineItem* item : ((pipe::ShaderPass*)pass->Data)->Items) {
+				if (item->Type == PipelineItem::ItemType::Geometry)
+					m_addBuffer(item->Name, "Geometry", ((pipe::GeometryItem*)item->Data)->VBO);
+				else if (item->Type == PipelineItem::ItemType::Model) {
+					eng::Model* model = ((pipe::Model*)item->Data)->Data;
+					if (model == nullptr)
+						continue;
+
+					Entry entry;
+					entry.Name = item->Name;
+					entry.Kind = "Model";
+					for (const auto& mesh : model->Meshes) {
+						GLuint buffers[2] = { mesh.VBO, mesh.EBO };
+						for (GLuint buffer : buffers) {
+							if (buffer == 0 || !m_seen.insert(getResourceKey(true, buffer)).second)
+								continue;
+							entry.Bytes += m_getBufferSize(buffer);
+							entry.LastUsed = std::max(entry.LastUsed, m_data->Renderer.GetLastUsed(true, buffer));
+						}
+					}
+					if (entry.Bytes > 0)
+						m_entries.push_back(entry);
+				}
+			}
+		}
+
+		std::vector<RenderEngine::InternalTexture> internal;
+		m_data->Renderer.GetInternalTextures(internal);
+		for (const auto& tex : internal)
+			m_addTexture(tex.Name, "Renderer", tex.Target, tex.Texture);
+
+		std::stable_sort(m_entries.begin(), m_entries.end(), [](const Entry& a, const Entry& b) {
+			return a.Bytes > b.Bytes;
+		});
+	}
+	void MemoryUI::m_addTexture(const std::string& name, const std::string& kind, GLenum target, GLuint tex)
+	{
+		if (tex == 0 || !m_seen.insert(getResourceKey(false, tex)).second)
+			return;
+
+		GLint bound = 0;
+		glGetIntegerv(getTextureBinding(target), &bound);
+		glBindTexture(target, tex);
+
+		Entry entry;
+		entry.Name = name;
+		entry.Kind = kind;
+		entry.LastUsed = m_data->Renderer.GetLastUsed(false, tex);
+
+		// a cubemap's faces all have the same size
+		GLenum levelTarget = target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X : target;
+		int faces = target == GL_TEXTURE_CUBE_MAP ? 6 : 1;
+		for (int level = 0; level < 16; level++) {
+			GLint width = 0, height = 0, depth = 0, format = 0, compressed = GL_FALSE;
+			glGetTexLevelParameteriv(levelTarget, level, GL_TEXTURE_WIDTH, &width);
+			if (width == 0)
+				break;
+			glGetTexLevelParameteriv(levelTarget, level, GL_TEXTURE_HEIGHT, &height);
+			glGetTexLevelParameteriv(levelTarget, level, GL_TEXTURE_DEPTH, &depth);
+			glGetTexLevelParameteriv(levelTarget, level, GL_TEXTURE_INTERNAL_FORMAT, &format);
+			glGetTexLevelParameteriv(levelTarget, level, GL_TEXTURE_COMPRESSED, &compressed);
+
+			size_t bytes = 0;
+			if (compressed) {
+				GLint size = 0;
+				glGetTexLevelParameteriv(levelTarget, level, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &size);
+				bytes = size;
+			} else
+				bytes = RenderTargetPool::GetTexelSize(format) * width * height * std::max(depth, 1);
+
+			if (level == 0) {
+				entry.Format = format;
+				entry.Size = glm::ivec3(width, height, std::max(depth, 1));
+				if (target == GL_TEXTURE_2D_MULTISAMPLE) {
+					glGetTexLevelParameteriv(levelTarget, 0, GL_TEXTURE_SAMPLES, &entry.Samples);
+					bytes *= std::max(entry.Samples, 1);
+				}
+			}
+
+			entry.Bytes += bytes * faces;
+			entry.Levels++;
+
+			if (target == GL_TEXTURE_2D_MULTISAMPLE)
+				break;
+		}
+
+		glBindTexture(target, bound);
+
+		// generated but never allocated
+		if (entry.Levels > 0)
+			m_entries.push_back(entry);
+	}
+	void MemoryUI::m_addBuffer(const std::string& name, const std::string& kind, GLuint buffer)
+	{
+		if (buffer == 0 || !m_seen.insert(getResourceKey(true, buffer)).second)
+			return;
+
+		Entry entry;
+		entry.Name = name;
+		entry.Kind = kind;
+		entry.Bytes = m_getBufferSize(buffer);
+		entry.LastUsed = m_data->Renderer.GetLastUsed(true, buffer);
+
+		m_entries.push_back(entry);
+	}
+	size_t MemoryUI::m_getBufferSize(GLuint buffer)
+	{
+		GLint bound = 0;
+		glGetIntegerv(GL_COPY_READ_BUFFER_BINDING, &bound);
+		glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+
+		GLint64 size = 0;
+		glGetBufferParameteri64v(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &size);
+
+		glBindBuffer(GL_COPY_READ_BUFFER, bound);
+		return (size_t)size;
+	}
+}
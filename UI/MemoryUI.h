@@ -0,0 +1,49 @@
+#pragma once
+#include "UIView.h"
+#include "Tools/FormatAdvisor.h"
+
+#include <unordered_set>
+
+namespace ed
+{
+	// every GPU allocation of the project & the renderer with its estimated size - the list is
+	// rebuilt from GL queries a few times per second while the panel is open
+	class MemoryUI : public UIView
+	{
+	public:
+		MemoryUI(GUIManager* ui, ed::InterfaceManager* objects, const std::string& name = "", bool visible = true) :
+			UIView(ui, objects, name, visible),
+			m_timer(0.0f)
+		{
+		}
+
+		virtual void OnEvent(const SDL_Event& e);
+		virtual void Update(float delta);
+
+	private:
+		struct Entry
+		{
+			Entry() { Format = 0; Size = glm::ivec3(0); Samples = Levels = 0; Bytes = 0; LastUsed = 0; }
+
+			std::string Name;
+			std::string Kind;
+			GLuint Format;  // 0 -> unknown or not a texture
+			glm::ivec3 Size; // texels of the first mip level, not used by the buffers
+			int Samples, Levels;
+			size_t Bytes;
+			unsigned int LastUsed; // RenderEngine::GetFrameIndex() of the last access, 0 = never
+		};
+
+		void m_collect();
+		void m_renderAdvisor();
+		void m_addTexture(const std::string& name, const std::string& kind, GLenum target, GLuint tex);
+		void m_addBuffer(const std::string& name, const std::string& kind, GLuint buffer);
+		size_t m_getBufferSize(GLuint buffer);
+
+		std::vector<Entry> m_entries;
+		std::unordered_set<GLuint64> m_seen; // textures & buffers that are shared (models, audio...) are only listed once
+		float m_timer;
+
+		FormatAdvisor m_advisor;
+	};
+}
@@ -39,7 +39,7 @@ namespace ed
 			ImGui::NextColumn();
 
 			if (m->Shader != -1)
-				ImGui::Text(m->Shader == 0 ? "VS" : (m->Shader == 1 ? "PS" : (m->Shader == 2 ? "GS" : "CS")));
+				ImGui::Text(m->Shader == 0 ? "VS" : (m->Shader == 1 ? "PS" : (m->Shader == 2 ? "GS" : (m->Shader == 3 ? "CS" : (m->Shader == 4 ? "TS" : "MS")))));
 			ImGui::NextColumn();
 
 			if (m->Line != -1)
@@ -3,7 +3,11 @@
 #include "PropertyUI.h"
 #include "../Objects/Settings.h"
 #include "../Objects/Logger.h"
-#include "../Engine/GeometryFactory.h"
+#include "../Objects/GeometryCache.h"
+#include "../Objects/VAOCache.h"
+#include "../Objects/TextureSharing.h"
+#include "../Objects/ObjectExporter.h"
+#include "UIHelper.h"
 #include "../Engine/GLUtils.h"
 #include <imgui/imgui.h>
 #include <imgui/imgui_internal.h>
@@ -31,42 +35,9 @@ namespace ed
 			ImGui::TextWrapped("Right click on this window or go to Create menu in the menu bar to create an item.");
 
 		for (int i = 0; i < items.size(); i++) {
-			bool isPluginOwner = m_data->Objects.IsPluginObject(items[i]);
-
-			GLuint tex = m_data->Objects.GetTexture(items[i]);
-			if (m_data->Objects.IsImage(items[i]))
-				tex = m_data->Objects.GetImage(items[i])->Texture;
-			else if (m_data->Objects.IsImage3D(items[i]))
-				tex = m_data->Objects.GetImage3D(items[i])->Texture;
-
-			float imgWH = 0.0f;
-			glm::vec2 imgSize(0,0);
-			if (m_data->Objects.IsRenderTexture(items[i])) {
-				glm::ivec2 rtSize = m_data->Objects.GetRenderTextureSize(items[i]);
-				imgWH = (float)rtSize.y / rtSize.x;
-				imgSize = glm::vec2(rtSize.x, rtSize.y);
-			}
-			else if (m_data->Objects.IsAudio(items[i])) {
-				imgWH = 2.0f / 512.0f;
-				imgSize = glm::vec2(512, 2);
-			}
-			else if (m_data->Objects.IsCubeMap(items[i])) {
-				imgWH = 375.0f / 512.0f;
-				imgSize = glm::vec2(512, 375);
-			}
-			else if (m_data->Objects.IsImage(items[i])) {
-				imgSize = m_data->Objects.GetImageSize(items[i]);
-				imgWH = imgSize.y / imgSize.x;
-			}
-			else if (m_data->Objects.IsImage3D(items[i])) {
-				imgSize = m_data->Objects.GetImage3DSize(items[i]);
-				imgWH = imgSize.y / imgSize.x;
-			}
-			else if (!isPluginOwner) {
-				auto img = m_data->Objects.GetTextureSize(items[i]);
-				imgWH = (float)img.y / img.x;
-				imgSize = glm::vec2(img);
-			}
+			// the list is drawn every frame - only the item whose menu is open needs more than this lookup
+			ObjectManagerItem* itemData = m_data->Objects.GetObjectManagerItem(items[i]);
+			bool isPluginOwner = itemData != nullptr && itemData->Plugin != nullptr;
 
 			size_t lastSlash = items[i].find_last_of("/\\");
 			std::string itemText = items[i];
@@ -79,27 +50,67 @@ namespace ed
 			if (ImGui::BeginPopupContextItem(std::string("##context" + items[i]).c_str())) {
 				itemMenuOpened = true;
 
+				GLuint tex = m_data->Objects.GetTexture(items[i]);
+				if (m_data->Objects.IsImage(items[i]))
+					tex = m_data->Objects.GetImage(items[i])->Texture;
+				else if (m_data->Objects.IsImage3D(items[i]))
+					tex = m_data->Objects.GetImage3D(items[i])->Texture;
+
+				float imgWH = 0.0f;
+				glm::vec2 imgSize(0,0);
+				if (m_data->Objects.IsRenderTexture(items[i])) {
+					glm::ivec2 rtSize = m_data->Objects.GetRenderTextureSize(items[i]);
+					imgWH = (float)rtSize.y / rtSize.x;
+					imgSize = glm::vec2(rtSize.x, rtSize.y);
+				}
+				else if (m_data->Objects.IsAudio(items[i])) {
+					imgWH = 2.0f / 512.0f;
+					imgSize = glm::vec2(512, 2);
+				}
+				else if (m_data->Objects.IsCubeMap(items[i])) {
+					imgWH = 375.0f / 512.0f;
+					imgSize = glm::vec2(512, 375);
+				}
+				else if (m_data->Objects.IsImage(items[i])) {
+					imgSize = m_data->Objects.GetImageSize(items[i]);
+					imgWH = imgSize.y / imgSize.x;
+				}
+				else if (m_data->Objects.IsImage3D(items[i])) {
+					imgSize = m_data->Objects.GetImage3DSize(items[i]);
+					imgWH = imgSize.y / imgSize.x;
+				}
+				else if (!isPluginOwner) {
+					auto img = m_data->Objects.GetTextureSize(items[i]);
+					imgWH = (float)img.y / img.x;
+					imgSize = glm::vec2(img);
+				}
+
 				PluginObject* pobj = m_data->Objects.GetPluginObject(items[i]);
 
 				bool isBuf = m_data->Objects.IsBuffer(items[i]);
 				bool isImg3D = m_data->Objects.IsImage3D(items[i]);
+				bool isTexArray = m_data->Objects.IsTextureArray(items[i]);
 				bool hasPluginExtendedPreview = isPluginOwner && pobj->Owner->HasObjectExtendedPreview(pobj->Type);
-				if ((hasPluginExtendedPreview || !isPluginOwner) && !isImg3D && (isBuf ? ImGui::Selectable("Edit") : ImGui::Selectable("Preview"))) {
+				if ((hasPluginExtendedPreview || !isPluginOwner) && !isTexArray && (isBuf ? ImGui::Selectable("Edit") : ImGui::Selectable("Preview"))) {
 					((ObjectPreviewUI*)m_ui->Get(ViewID::ObjectPreview))->Open(items[i], imgSize.x, imgSize.y, tex,
-							m_data->Objects.IsCubeMap(items[i]),
+							m_data->Objects.IsCubeMap(items[i]) || (m_data->Objects.IsRenderTexture(items[i]) && m_data->Objects.GetRenderTexture(tex)->Cubemap),
 							m_data->Objects.IsRenderTexture(items[i]) ? m_data->Objects.GetRenderTexture(tex) : nullptr,
-							m_data->Objects.IsAudio(items[i]) ? m_data->Objects.GetSoundBuffer(items[i]) : nullptr,
+							m_data->Objects.IsAudio(items[i]) ? m_data->Objects.GetAudioPlayer(items[i]) : nullptr,
 							isBuf ? m_data->Objects.GetBuffer(items[i]) : nullptr,
-							isPluginOwner ? pobj : nullptr);
+							isPluginOwner ? pobj : nullptr,
+							isImg3D ? m_data->Objects.GetImage3D(items[i]) : nullptr);
 				}
 
 				bool hasPluginPreview = isPluginOwner && pobj->Owner->HasObjectPreview(pobj->Type);
 				if (m_data->Objects.IsCubeMap(items[i])) {
-					m_cubePrev.Draw(tex);
-					ImGui::Image((void*)(intptr_t)m_cubePrev.GetTexture(), ImVec2(IMAGE_CONTEXT_WIDTH, ((float)imgWH)* IMAGE_CONTEXT_WIDTH), ImVec2(0,1), ImVec2(1,0));
-				} else if (!isBuf && !isImg3D && !isPluginOwner)
+					ImGui::Image((void*)(intptr_t)m_cubePrev.GetThumbnail(tex, itemData != nullptr ? itemData->Generation : 0), ImVec2(IMAGE_CONTEXT_WIDTH, ((float)imgWH)* IMAGE_CONTEXT_WIDTH), ImVec2(0,1), ImVec2(1,0));
+				} else if (isTexArray) {
+					ImGui::TextDisabled("%dx%d, %d layers", (int)imgSize.x, (int)imgSize.y, (int)m_data->Objects.GetTextureArrayLayers(items[i]).size());
+				} else if (!isBuf && !isImg3D && !isPluginOwner) {
+					if (m_data->Objects.IsRenderTexture(items[i]))
+						m_data->Renderer.KeepResolved(tex);
 					ImGui::Image((void*)(intptr_t)tex, ImVec2(IMAGE_CONTEXT_WIDTH, ((float)imgWH)* IMAGE_CONTEXT_WIDTH), ImVec2(0,1), ImVec2(1,0));
-				else if (hasPluginPreview)
+				} else if (hasPluginPreview)
 					pobj->Owner->ShowObjectPreview(pobj->Type, pobj->Data, pobj->ID);
 
 				ImGui::Separator();
@@ -171,6 +182,9 @@ namespace ed
 						((ed::PropertyUI *)m_ui->Get(ViewID::Properties))->Open(items[i], m_data->Objects.GetObjectManagerItem(items[i]));
 				}
 
+				if (m_data->Objects.IsRenderTextureHistory(items[i]))
+					ImGui::TextDisabled("Last frame of %s", m_data->Objects.GetRenderTextureHistorySource(items[i]).c_str());
+
 				if (m_data->Objects.IsAudio(items[i])) {
 					bool isMuted = m_data->Objects.IsAudioMuted(items[i]);
 					if (ImGui::MenuItem("Mute", (const char*)0, &isMuted)) {
@@ -179,10 +193,153 @@ namespace ed
 						else
 							m_data->Objects.Unmute(items[i]);
 					}
+
+					// the whole track is uploaded once to a samplerBuffer, AudioPosition tells the shaders where the playhead is
+					int trackRate = m_data->Objects.GetAudioTrackRate(items[i]);
+					if (ImGui::BeginMenu("Whole track")) {
+						if (ImGui::MenuItem("Off", (const char*)0, trackRate == -1))
+							m_data->Objects.SetAudioTrack(items[i], -1);
+						if (ImGui::MenuItem("Samples", (const char*)0, trackRate == 0))
+							m_data->Objects.SetAudioTrack(items[i], 0);
+						for (int rate = 30; rate <= 240; rate *= 2)
+							if (ImGui::MenuItem(("Envelope " + std::to_string(rate) + "/s").c_str(), (const char*)0, trackRate == rate))
+								m_data->Objects.SetAudioTrack(items[i], rate);
+						ImGui::EndMenu();
+					}
+
+					int layer = m_data->Objects.GetAudioLayer(items[i]);
+					if (layer >= 0)
+						ImGui::TextDisabled("Texture array layer: %d", layer);
+				}
+
+				if (m_data->Objects.IsVideo(items[i])) {
+					VideoObject* vobj = m_data->Objects.GetVideo(items[i]);
+					bool isLive = vobj->Decoder->IsLive();
+					if (!isLive && ImGui::MenuItem("Sync to time", (const char*)0, &vobj->SyncToTime))
+						m_data->Parser.ModifyProject();
+					if (ImGui::MenuItem("Pause", (const char*)0, &vobj->Paused, !vobj->SyncToTime))
+						m_data->Parser.ModifyProject();
+					if (isLive && ImGui::BeginMenu("Queue depth")) {
+						for (int depth = 1; depth <= VIDEO_FRAME_QUEUE_MAX; depth *= 2)
+							if (ImGui::MenuItem(std::to_string(depth).c_str(), (const char*)0, vobj->Decoder->GetQueueDepth() == depth))
+								m_data->Objects.SetCaptureQueueDepth(items[i], depth);
+						ImGui::EndMenu();
+					}
+
+					glm::ivec2 videoSize = vobj->Decoder->GetSize();
+					ImGui::TextDisabled("%dx%d, %.2f fps, %s decoding", videoSize.x, videoSize.y, vobj->Decoder->GetFrameRate(), vobj->Decoder->IsHardwareDecoded() ? "hardware" : "software");
+				}
+
+				VirtualTexture* vtex = m_data->Objects.GetVirtualTexture(items[i]);
+				if (vtex != nullptr) {
+					glm::ivec2 vtexSize = vtex->GetSize();
+					if (vtex->IsBuilding())
+						ImGui::TextDisabled("%dx%d, building the tiles...", vtexSize.x, vtexSize.y);
+					else if (!vtex->GetError().empty())
+						ImGui::TextDisabled("%dx%d, %s", vtexSize.x, vtexSize.y, vtex->GetError().c_str());
+					else
+						ImGui::TextDisabled("%dx%d, %d of %d pages resident", vtexSize.x, vtexSize.y, vtex->GetResidentCount(), vtex->GetPageCount());
+
+					int virtualIndex = m_data->Objects.GetVirtualTextureIndex(items[i]);
+					if (virtualIndex >= 0)
+						ImGui::TextDisabled("SHADERed_VirtualLod index: %d", virtualIndex);
+				}
+
+				EnvironmentMap* env = m_data->Objects.GetEnvironment(items[i]);
+				if (env != nullptr) {
+					glm::ivec2 envSize = env->GetSourceSize();
+					if (env->IsBuilding() && !env->IsReady())
+						ImGui::TextDisabled("%d levels, filtering...", env->GetLevelCount());
+					else if (!env->GetError().empty())
+						ImGui::TextDisabled("%d levels, %s", env->GetLevelCount(), env->GetError().c_str());
+					else
+						ImGui::TextDisabled("%dx%d source, %d levels%s", envSize.x, envSize.y, env->GetLevelCount(), env->IsCached() ? " (cached)" : "");
+					ImGui::TextDisabled("textureLod(env, R, roughness * %d)", env->GetLevelCount() - 1);
+				}
+				if (m_data->Objects.IsEnvironmentPart(items[i]))
+					ImGui::TextDisabled("Part of %s", m_data->Objects.GetEnvironmentSource(items[i]).c_str());
+
+				ImageSequence* seq = m_data->Objects.GetImageSequence(items[i]);
+				if (seq != nullptr) {
+					bool followsFrame = seq->GetClock() == ImageSequence::Clock::FrameIndex;
+					if (ImGui::MenuItem("Follow FrameIndex", (const char*)0, &followsFrame)) {
+						seq->SetClock(followsFrame ? ImageSequence::Clock::FrameIndex : ImageSequence::Clock::Time);
+						m_data->Parser.ModifyProject();
+					}
+					if (!followsFrame && ImGui::BeginMenu("Frame rate")) {
+						const float rates[] = { 12.0f, 24.0f, 25.0f, 30.0f, 50.0f, 60.0f };
+						for (float rate : rates)
+							if (ImGui::MenuItem(std::to_string((int)rate).c_str(), (const char*)0, seq->GetFrameRate() == rate)) {
+								seq->SetFrameRate(rate);
+								m_data->Parser.ModifyProject();
+							}
+						ImGui::EndMenu();
+					}
+					bool loop = seq->IsLooping();
+					if (ImGui::MenuItem("Loop", (const char*)0, &loop)) {
+						seq->SetLoop(loop);
+						m_data->Parser.ModifyProject();
+					}
+					if (ImGui::BeginMenu("Look-ahead")) {
+						for (int frames = 2; frames <= 64; frames *= 2)
+							if (ImGui::MenuItem((std::to_string(frames) + " frames").c_str(), (const char*)0, seq->GetLookAhead() == frames)) {
+								seq->SetLookAhead(frames);
+								m_data->Parser.ModifyProject();
+							}
+						ImGui::EndMenu();
+					}
+					if (ImGui::BeginMenu("Memory budget")) {
+						for (int mb = 64; mb <= 2048; mb *= 2)
+							if (ImGui::MenuItem((std::to_string(mb) + " MB").c_str(), (const char*)0, seq->GetBudget() == mb)) {
+								seq->SetBudget(mb);
+								m_data->Parser.ModifyProject();
+							}
+						ImGui::EndMenu();
+					}
+
+					glm::ivec2 seqSize = seq->GetSize();
+					float ringSize = seq->GetRingSize() * seqSize.x * seqSize.y * 4 / (1024.0f * 1024.0f);
+					ImGui::TextDisabled("%dx%d, frame %d of %d", seqSize.x, seqSize.y, seq->GetShownFrame() + 1, seq->GetFrameCount());
+					ImGui::TextDisabled("%d of %d ahead decoded (%.0f MB), %d late", seq->GetDecodedCount(), seq->GetRingSize(), ringSize, seq->GetLateCount());
+					if (!seq->GetError().empty())
+						ImGui::TextDisabled("Last error: %s", seq->GetError().c_str());
+				}
+
+				int bindlessIndex = m_data->Objects.GetBindlessIndex(items[i]);
+				if (bindlessIndex >= 0)
+					ImGui::TextDisabled("SHADERed_Textures index: %d", bindlessIndex);
+
+				if (itemData != nullptr && (itemData->IsTextureArray || (itemData->IsTexture && !eng::CompressedTexture::IsSupportedFile(items[i])))) {
+					bool hasMipmaps = itemData->Mipmaps;
+					if (ImGui::MenuItem("Mipmaps", (const char*)0, &hasMipmaps))
+						m_data->Objects.SetTextureMipmaps(items[i], hasMipmaps);
+				}
+
+				// layered render textures & cubemaps can't be saved as a single image
+				RenderTextureObject* rtObj = m_data->Objects.IsRenderTexture(items[i]) ? m_data->Objects.GetRenderTexture(tex) : nullptr;
+				bool isSavable = isBuf || isImg3D || m_data->Objects.IsImage(items[i]) || (rtObj != nullptr && rtObj->Layers <= 1 && !rtObj->Cubemap);
+				if (isSavable && ImGui::Selectable("Save to file...")) {
+					std::string file;
+					if (UIHelper::GetSaveFileDialog(file, isBuf ? "buf;bin" : "png;jpg,jpeg;bmp;tga;hdr;exr")) {
+						if (isBuf) {
+							BufferObject* bobj = m_data->Objects.GetBuffer(items[i]);
+							ObjectExporter::Instance().SaveBuffer(itemText, bobj->ID, bobj->Size, file);
+						} else if (isImg3D)
+							ObjectExporter::Instance().SaveTexture(itemText, tex, GL_TEXTURE_3D, m_data->Objects.GetImage3DSize(items[i]), file);
+						else
+							ObjectExporter::Instance().SaveTexture(itemText, tex, GL_TEXTURE_2D, glm::ivec3(glm::ivec2(imgSize), 1), file);
+					}
+				}
+
+				if (m_data->Objects.IsRenderTexture(items[i]) && ImGui::BeginMenu("Share")) {
+					if (UIHelper::CreateShareMenuItems(items[i]))
+						m_data->Parser.ModifyProject();
+					ImGui::EndMenu();
 				}
 
 				if (ImGui::Selectable("Delete")) {
 					if (m_data->Objects.IsRenderTexture(items[i])) {
+						TextureSharing::Instance().Remove(items[i]);
 						auto& passes = m_data->Pipeline.GetList();
 						for (int j = 0; j < passes.size(); j++) {
 							if (passes[i]->Type != PipelineItem::ItemType::ShaderPass)
@@ -218,19 +375,40 @@ namespace ed
 					}
 
 					if (isBuf) {
+						m_data->Renderer.ReleaseVertexCapture(m_data->Objects.GetBuffer(items[i])->ID);
+
 						auto& passes = m_data->Pipeline.GetList();
 						for (int j = 0; j < passes.size(); j++) {
-							if (passes[i]->Type != PipelineItem::ItemType::ShaderPass)
+							if (passes[j]->Type == PipelineItem::ItemType::ComputePass) {
+								pipe::ComputePass* cdata = (pipe::ComputePass*)passes[j]->Data;
+								if (cdata->IndirectBuffer == m_data->Objects.GetBuffer(items[i]))
+									cdata->IndirectBuffer = nullptr;
+								if (cdata->ConditionBuffer == m_data->Objects.GetBuffer(items[i]))
+									cdata->ConditionBuffer = nullptr;
+								continue;
+							}
+							if (passes[j]->Type != PipelineItem::ItemType::ShaderPass)
 								continue;
 
 							pipe::ShaderPass* pdata = (pipe::ShaderPass*)passes[j]->Data;
+							if (pdata->MeshTaskBuffer == m_data->Objects.GetBuffer(items[i]))
+								pdata->MeshTaskBuffer = nullptr;
+							if (pdata->ConditionBuffer == m_data->Objects.GetBuffer(items[i]))
+								pdata->ConditionBuffer = nullptr;
+							if (pdata->CaptureBuffer == m_data->Objects.GetBuffer(items[i]))
+								pdata->CaptureBuffer = nullptr;
 							for (int k = 0; k < pdata->Items.size(); k++) {
 								PipelineItem* pitem = pdata->Items[k];
 								if (pitem->Type == ed::PipelineItem::ItemType::Geometry) {
 									pipe::GeometryItem* gitem = (pipe::GeometryItem*)pitem->Data;
 
+									if (gitem->VertexBuffer == m_data->Objects.GetBuffer(items[i])) {
+										gitem->VertexBuffer = nullptr;
+										GeometryCache::Instance().Rebuild(gitem, pdata->InputLayout);
+									}
+
 									if (gitem->InstanceBuffer == m_data->Objects.GetBuffer(items[i]))
-										gl::CreateVAO(gitem->VAO, gitem->VBO, pdata->InputLayout);
+										GeometryCache::Instance().Rebuild(gitem, pdata->InputLayout);
 									gitem->InstanceBuffer = nullptr;
 								}
 								else if (pitem->Type == ed::PipelineItem::ItemType::Model) {
@@ -238,7 +416,7 @@ namespace ed
 
 									if (mitem->InstanceBuffer == m_data->Objects.GetBuffer(items[i])) {
 										for (auto& mesh : mitem->Data->Meshes)
-											gl::CreateVAO(mesh.VAO, mesh.VBO, pdata->InputLayout, mesh.EBO);
+											VAOCache::Instance().Rebuild(mesh.VAO, mesh.VBO, pdata->InputLayout, mesh.EBO);
 										mitem->InstanceBuffer = nullptr;
 									}
 								}
@@ -264,7 +442,12 @@ namespace ed
 			if (ImGui::Selectable("Create Texture")) { m_ui->CreateNewTexture(); }
 			if (ImGui::Selectable("Create Cubemap")) { m_ui->CreateNewCubemap(); }
 			if (ImGui::Selectable("Create Render Texture")) { m_ui->CreateNewRenderTexture(); }
+			if (VirtualTexture::IsSupported() && ImGui::Selectable("Create Virtual Texture")) { m_ui->CreateNewVirtualTexture(); }
+			if (EnvironmentMap::IsSupported() && ImGui::Selectable("Create Environment Map")) { m_ui->CreateNewEnvironment(); }
+			if (ImGui::Selectable("Create Image Sequence")) { m_ui->CreateNewImageSequence(); }
 			if (ImGui::Selectable("Create Audio")) { m_ui->CreateNewAudio(); }
+			if (eng::VideoDecoder::IsSupported() && ImGui::Selectable("Create Video")) { m_ui->CreateNewVideo(); }
+			if (eng::VideoDecoder::IsSupported() && ImGui::Selectable("Create Capture Device")) { m_ui->CreateNewCaptureDevice(); }
 			if (ImGui::Selectable("Create Buffer")) { m_ui->CreateNewBuffer(); }
 			if (ImGui::Selectable("Create Empty Image")) m_ui->CreateNewImage();
 			if (ImGui::Selectable("Create Empty 3D Image")) m_ui->CreateNewImage3D();
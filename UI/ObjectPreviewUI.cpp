@@ -1,11 +1,18 @@
 #include "ObjectPreviewUI.h"
+#include "UIHelper.h"
 #include "../Objects/Names.h"
 #include "../Objects/SystemVariableManager.h"
+#include "../Objects/Settings.h"
 #include <imgui/imgui.h>
+#include <algorithm>
+#include <stdio.h>
+
+#define STATISTICS_REFRESH_INTERVAL 250 // ms between two texture statistics requests
+#define AUDIO_REFRESH_INTERVAL 33 // ms between two copies of the spectrum & samples that are plotted
 
 namespace ed
 {
-    void ObjectPreviewUI::Open(const std::string& name, float w, float h, unsigned int item, bool isCube, void* rt, void* audio, void* buffer, void* plugin)
+    void ObjectPreviewUI::Open(const std::string& name, float w, float h, unsigned int item, bool isCube, void* rt, void* audio, void* buffer, void* plugin, void* image3D)
     {
         mItem i;
         i.Name = name;
@@ -19,12 +26,24 @@ namespace ed
         i.Buffer = buffer;
         i.CachedFormat.clear();
         i.CachedSize = 0;
+        i.BufferViewStart = 0;
+        i.BufferReadStart = i.BufferReadSize = 0;
+        i.BufferReadPBO = 0;
+        i.BufferReadFence = 0;
 		i.Plugin = plugin;
+		i.ShowStatistics = false;
+		i.StatisticsChannel = 0;
+		i.Image3D = image3D;
+		i.SliceIndex = 0;
+		i.SliceReduction = 0;
+		if (image3D != nullptr)
+			i.Slice = std::make_shared<VolumeSlice>();
 
         if (buffer != nullptr) {
             BufferObject* buf = (BufferObject*)buffer;
             i.CachedFormat = m_data->Objects.ParseBufferFormat(buf->ViewFormat);
             i.CachedSize = buf->Size;
+            i.Fill = buf->Fill;
         }
 
         m_items.push_back(i);
@@ -69,9 +88,17 @@ namespace ed
 					PluginObject* pobj = ((PluginObject*)item->Plugin);
 					pobj->Owner->ShowObjectExtendedPreview(pobj->Type, pobj->Data, pobj->ID);
 				} else {
+					// an rt that keeps its last frame swaps textures with its history object every frame
+					ObjectManagerItem* current = m_data->Objects.GetObjectManagerItem(name);
+					if (current != nullptr && (current->History != nullptr || current->HistoryOf != nullptr))
+						item->Texture = current->Texture;
+
 					glm::ivec2 iSize(item->Width, item->Height);
-					if (item->RT != nullptr)
+					if (item->RT != nullptr) {
 						iSize = m_data->Objects.GetRenderTextureSize(name);
+						m_data->Renderer.KeepResolved(item->Texture);
+					} else if (item->Image3D != nullptr)
+						iSize = glm::ivec2(((Image3DObject*)item->Image3D)->Size);
 
 					float scale = std::min<float>(aSize.x / iSize.x, aSize.y / iSize.y);
 					aSize.x = iSize.x * scale;
@@ -84,10 +111,11 @@ namespace ed
 						ImGui::SetCursorPosX(posX);
 						ImGui::SetCursorPosY(posY);
 
-						m_cubePrev.Draw(item->Texture);
+						ObjectManagerItem* itemData = m_data->Objects.GetObjectManagerItem(name);
+						GLuint unwrap = m_cubePrev.GetThumbnail(item->Texture, itemData != nullptr ? itemData->Generation : 0);
 						const glm::vec2& zPos = m_zoom[i].GetZoomPosition();
 						const glm::vec2& zSize = m_zoom[i].GetZoomSize();
-						ImGui::Image((void*)(intptr_t)m_cubePrev.GetTexture(), aSize, ImVec2(zPos.x, zPos.y + zSize.y), ImVec2(zPos.x + zSize.x, zPos.y));
+						ImGui::Image((void*)(intptr_t)unwrap, aSize, ImVec2(zPos.x, zPos.y + zSize.y), ImVec2(zPos.x + zSize.x, zPos.y));
 
 						if (ImGui::IsItemHovered()) m_curHoveredItem = i;
 						if (m_zoom[i].IsSelecting() && m_lastZoomSize != glm::vec2(aSize.x, aSize.y)) {
@@ -98,28 +126,23 @@ namespace ed
 							m_zoom[i].Reset();
 					}
 					else if (item->Audio != nullptr) {
-						sf::Sound* player = m_data->Objects.GetAudioPlayer(item->Name);
-						sf::SoundBuffer* buffer = (sf::SoundBuffer*)item->Audio;
-						int channels = buffer->getChannelCount();
-						int perChannel = buffer->getSampleCount() / channels;
-						int curSample = (int)((player->getPlayingOffset().asSeconds() / buffer->getDuration().asSeconds()) * perChannel);
-
-						double* fftData = m_audioAnalyzer.FFT(*buffer, curSample);
-
-						const sf::Int16* samples = buffer->getSamples();
-						for (int i = 0; i < ed::AudioAnalyzer::SampleCount; i++) {
-							sf::Int16 s = samples[std::min<int>(i + curSample, perChannel)];
-							float sf = (float)s / (float)INT16_MAX;
-
-							m_fft[i] = fftData[i / 2];
-							m_samples[i] = sf * 0.5f + 0.5f;
+						// same data as the texture - it isn't computed again if a pass already needed it in this frame,
+						// otherwise the analysis only runs at the capped rate while the preview is open
+						if (item->AudioView.empty() || item->AudioClock.getElapsedTime().asMilliseconds() >= AUDIO_REFRESH_INTERVAL) {
+							const float* data = m_data->Objects.GetAudioData(item->Name);
+							if (data != nullptr)
+								item->AudioView.assign(data, data + ed::AudioAnalyzer::SampleCount * 2);
+							else
+								item->AudioView.assign(ed::AudioAnalyzer::SampleCount * 2, 0.0f);
+							item->AudioClock.restart();
 						}
 
-						ImGui::PlotHistogram("Frequencies", m_fft, IM_ARRAYSIZE(m_fft), 0, NULL, 0.0f, 1.0f, ImVec2(0, 80));
-						ImGui::PlotHistogram("Samples", m_samples, IM_ARRAYSIZE(m_samples), 0, NULL, 0.0f, 1.0f, ImVec2(0, 80));
+						ImGui::PlotHistogram("Frequencies", item->AudioView.data(), ed::AudioAnalyzer::SampleCount, 0, NULL, 0.0f, 1.0f, ImVec2(0, 80));
+						ImGui::PlotHistogram("Samples", item->AudioView.data() + ed::AudioAnalyzer::SampleCount, ed::AudioAnalyzer::SampleCount, 0, NULL, 0.0f, 1.0f, ImVec2(0, 80));
 					}
 					else if (item->Buffer != nullptr) {
 						BufferObject* buf = (BufferObject*)item->Buffer;
+						m_pollBufferRead(item);
 
 						ImGui::Text("Format:");
 						ImGui::SameLine();
@@ -141,36 +164,58 @@ namespace ed
 						ImGui::PopItemWidth();
 						ImGui::SameLine();
 						if (ImGui::Button("APPLY##objprev_applysize")) {
+							// generated buffers are filled again, the others keep the old contents
+							bool filled = buf->Fill.Op != GPUFill::Operator::None;
+							if (!filled)
+								m_data->Objects.FetchBufferData(buf);
+
 							buf->Size = item->CachedSize;
 							if (buf->Size < 0) buf->Size = 0;
 
-							buf->Data = realloc(buf->Data, buf->Size);
+							if (!filled)
+								buf->Data = realloc(buf->Data, buf->Size);
+							buf->Dirty.clear();
+							item->BufferView.clear();
+							m_cancelBufferRead(item);
 
 							glBindBuffer(GL_UNIFORM_BUFFER, buf->ID);
 							glBufferData(GL_UNIFORM_BUFFER, buf->Size, buf->Data, GL_STATIC_DRAW); // resize
 							glBindBuffer(GL_UNIFORM_BUFFER, 0);
 
+							if (filled)
+								m_data->Objects.FillBuffer(item->Name, buf->Fill);
+
 							m_data->Parser.ModifyProject();
 						}
 						if (ImGui::Button("CLEAR##objprev_clearbuf")) {
-							memset(buf->Data, 0, buf->Size);
+							if (buf->Data != nullptr)
+								memset(buf->Data, 0, buf->Size);
+							std::fill(item->BufferView.begin(), item->BufferView.end(), 0);
+							buf->Dirty.clear();
+							buf->Fill = GPUFill::Operation();
+							m_cancelBufferRead(item);
 
 							glBindBuffer(GL_UNIFORM_BUFFER, buf->ID);
-							glBufferData(GL_UNIFORM_BUFFER, buf->Size, buf->Data, GL_STATIC_DRAW); // resize
+							glClearBufferData(GL_UNIFORM_BUFFER, GL_R8, GL_RED, GL_UNSIGNED_BYTE, nullptr); // same size, no need to reallocate
 							glBindBuffer(GL_UNIFORM_BUFFER, 0);
 
 							m_data->Parser.ModifyProject();
 						}
 
-						// update buffer data every 330ms
-						ImGui::Text("Buffer view is updated every 330ms");
-						if (m_bufUpdateClock.getElapsedTime().asMilliseconds() > 330) {
-							glBindBuffer(GL_SHADER_STORAGE_BUFFER, buf->ID);
-							glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, buf->Size, buf->Data);
-							glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
-							m_bufUpdateClock.restart();
+						// generated on the GPU, the other buffers can be copied
+						std::vector<std::string> fillSources;
+						for (const std::string& name : m_data->Objects.GetObjects())
+							if (name != item->Name && m_data->Objects.IsBuffer(name))
+								fillSources.push_back(name);
+						if (UIHelper::CreateFillEditor("objprev_fill", item->Fill, true, fillSources)) {
+							item->BufferView.clear();
+							m_cancelBufferRead(item);
+							m_data->Objects.FillBuffer(item->Name, item->Fill);
 						}
 
+						int refreshRate = Settings::Instance().Preview.BufferRefreshRate;
+						ImGui::Text("Buffer view is updated every %dms", refreshRate);
+
 						if (perRow != 0) {
 							ImGui::Separator();
 
@@ -182,36 +227,136 @@ namespace ed
 								ImGui::NextColumn();
 							}
 
-							for (int i = 0; i < rows; i++) {
-								int curColOffset = 0;
-								for (int j = 0; j < item->CachedFormat.size(); j++) {
-									int dOffset = i * perRow + curColOffset;
-									if (m_drawBufferElement(i, j, (void*)(((char*)buf->Data) + dOffset), item->CachedFormat[j])) {
-										glBindBuffer(GL_UNIFORM_BUFFER, buf->ID);
-										glBufferData(GL_UNIFORM_BUFFER, buf->Size, buf->Data, GL_STATIC_DRAW); // allocate 0 bytes of memory
-										glBindBuffer(GL_UNIFORM_BUFFER, 0);
+							int viewStart = item->BufferViewStart;
+							int viewEnd = viewStart + item->BufferView.size();
+							int visStart = 0, visEnd = 0;
+							bool edited = false;
+
+							// matrices take a line for each of their columns
+							int lines = 1;
+							for (int j = 0; j < item->CachedFormat.size(); j++) {
+								if (item->CachedFormat[j] == ShaderVariable::ValueType::Float4x4)
+									lines = std::max(lines, 4);
+								else if (item->CachedFormat[j] == ShaderVariable::ValueType::Float3x3)
+									lines = std::max(lines, 3);
+								else if (item->CachedFormat[j] == ShaderVariable::ValueType::Float2x2)
+									lines = std::max(lines, 2);
+							}
 
-										m_data->Parser.ModifyProject();
+							// only the rows that are on the screen are formatted
+							ImGuiListClipper clipper;
+							clipper.Begin(rows, lines * ImGui::GetFrameHeightWithSpacing());
+							while (clipper.Step()) {
+								visStart = clipper.DisplayStart;
+								visEnd = clipper.DisplayEnd;
+
+								for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+									bool loaded = i * perRow >= viewStart && (i + 1) * perRow <= viewEnd;
+
+									int curColOffset = 0;
+									for (int j = 0; j < item->CachedFormat.size(); j++) {
+										int dOffset = i * perRow + curColOffset;
+										int vSize = ShaderVariable::GetSize(item->CachedFormat[j]);
+										char* vData = item->BufferView.data() + (dOffset - viewStart);
+
+										if (!loaded) {
+											ImGui::AlignTextToFramePadding();
+											ImGui::TextDisabled("...");
+										} else if (m_drawBufferElement(i, j, vData, item->CachedFormat[j])) {
+											if (buf->Data != nullptr)
+												memcpy((char*)buf->Data + dOffset, vData, vSize);
+											else
+												buf->File.clear(); // the file doesn't match the GPU contents anymore
+
+											m_data->Objects.MarkBufferDirty(buf, dOffset, vSize);
+											edited = true;
+										}
+										curColOffset += vSize;
+										ImGui::NextColumn();
 									}
-									curColOffset += ShaderVariable::GetSize(item->CachedFormat[j]);
-									ImGui::NextColumn();
 								}
 							}
+							clipper.End();
 
 							ImGui::Columns(1);
-						}
 
+							// only the values that were edited this frame are uploaded
+							if (edited) {
+								m_data->Objects.FlushBuffer(buf, item->BufferView.data(), viewStart);
+								m_data->Parser.ModifyProject();
+								m_cancelBufferRead(item); // it would bring back the old values
+							}
+
+							// read a screen of rows above & below too so that scrolling doesn't show empty rows
+							int pad = std::max(visEnd - visStart, 1);
+							int readStart = std::max(visStart - pad, 0) * perRow;
+							int readEnd = std::min(visEnd + pad, rows) * perRow;
+							bool missing = visStart * perRow < viewStart || visEnd * perRow > viewEnd;
+							if (missing || item->BufferClock.getElapsedTime().asMilliseconds() >= refreshRate)
+								m_readBufferRows(item, readStart, readEnd);
+						}
 					}
 					else {
+						ObjectManagerItem* objItem = m_data->Objects.GetObjectManagerItem(name);
+						GLuint shownTex = item->Texture;
+
+						// 3D images are shown one Z slice at a time
+						if (item->Image3D != nullptr) {
+							Image3DObject* iobj = (Image3DObject*)item->Image3D;
+							static const char* REDUCTION_NAMES[] = { "Full", "1/2", "1/4", "1/8" };
+
+							ImGui::PushItemWidth(ImGui::GetContentRegionAvail().x * 0.6f);
+							ImGui::SliderInt(("Slice##objprev_slice" + std::to_string(i)).c_str(), &item->SliceIndex, 0, iobj->Size.z - 1);
+							ImGui::PopItemWidth();
+							ImGui::SameLine();
+							ImGui::PushItemWidth(-1);
+							ImGui::Combo(("##objprev_slicered" + std::to_string(i)).c_str(), &item->SliceReduction, REDUCTION_NAMES, IM_ARRAYSIZE(REDUCTION_NAMES));
+							ImGui::PopItemWidth();
+							if (ImGui::IsItemHovered())
+								ImGui::SetTooltip("Resolution of the slice that is copied from the 3D image");
+
+							shownTex = item->Slice->Update(iobj->Texture, iobj->Size, iobj->Format, item->SliceIndex, item->SliceReduction, objItem != nullptr ? objItem->Generation : 0);
+						}
+
+						// texture arrays aren't 2D textures
+						bool isLayered = (item->Image3D == nullptr && m_data->Objects.IsImage3D(item->Texture)) || (objItem != nullptr && (objItem->IsTextureArray || (objItem->RT != nullptr && objItem->RT->IsLayered())));
+						if (!isLayered) {
+							bool readout = m_zoom[i].IsReadoutEnabled();
+							if (ImGui::Checkbox(("Values##objprev_values" + std::to_string(i)).c_str(), &readout))
+								m_zoom[i].SetReadout(readout);
+							if (ImGui::IsItemHovered())
+								ImGui::SetTooltip("Show the values of the zoomed texels (Alt + drag to zoom)");
+
+							if (TextureStatistics::IsSupported()) {
+								ImGui::SameLine();
+								ImGui::Checkbox(("Statistics##objprev_stats" + std::to_string(i)).c_str(), &item->ShowStatistics);
+								if (item->ShowStatistics)
+									m_renderStatistics(item, shownTex, i);
+							}
+
+							// the image gets the rest of the window
+							ImVec2 rest = ImGui::GetContentRegionAvail();
+							float restScale = std::max(0.0f, std::min<float>(rest.x / iSize.x, rest.y / iSize.y));
+							aSize.x = iSize.x * restScale;
+							aSize.y = iSize.y * restScale;
+						}
+
+						ImVec2 cursor = ImGui::GetCursorPos();
 						ImVec2 posSize = ImGui::GetContentRegionAvail();
 						float posX = (posSize.x - aSize.x) / 2;
-						float posY = (posSize.y - aSize.y) / 2;
+						float posY = cursor.y + (posSize.y - aSize.y) / 2;
 						ImGui::SetCursorPosX(posX);
 						ImGui::SetCursorPosY(posY);
 
 						const glm::vec2& zPos = m_zoom[i].GetZoomPosition();
 						const glm::vec2& zSize = m_zoom[i].GetZoomSize();
-						ImGui::Image((void*)(intptr_t)item->Texture, aSize, ImVec2(zPos.x, zPos.y + zSize.y), ImVec2(zPos.x + zSize.x, zPos.y));
+						ImGui::Image((void*)(intptr_t)shownTex, aSize, ImVec2(zPos.x, zPos.y + zSize.y), ImVec2(zPos.x + zSize.x, zPos.y));
+
+						if (!isLayered) {
+							ImVec2 imagePos = ImGui::GetItemRectMin();
+							m_zoom[i].UpdateReadout(shownTex);
+							m_zoom[i].RenderReadout(glm::vec2(imagePos.x, imagePos.y), glm::vec2(aSize.x, aSize.y));
+						}
 
 						if (ImGui::IsItemHovered()) m_curHoveredItem = i;
 						if (m_zoom[i].IsSelecting() && m_lastZoomSize != glm::vec2(aSize.x, aSize.y)) {
@@ -226,6 +371,7 @@ namespace ed
             ImGui::End();
 
             if (!item->IsOpen) {
+                m_release(*item);
                 m_items.erase(m_items.begin() + i);
                 i--;
             }
@@ -310,9 +456,139 @@ namespace ed
     {
         for (int i = 0; i < m_items.size(); i++) {
             if (m_items[i].Name == name) {
+                m_release(m_items[i]);
                 m_items.erase(m_items.begin() + i);
                 i--;
             }
         }
     }
+    void ObjectPreviewUI::m_release(mItem& item)
+    {
+        m_cancelBufferRead(&item);
+        m_stats.Release(item.Statistics);
+        if (item.BufferReadPBO != 0) {
+            glDeleteBuffers(1, &item.BufferReadPBO);
+            item.BufferReadPBO = 0;
+        }
+    }
+    void ObjectPreviewUI::m_readBufferRows(mItem* item, int start, int end)
+    {
+        BufferObject* buf = (BufferObject*)item->Buffer;
+        end = std::min(end, buf->Size);
+        if (item->BufferReadFence != 0 || start >= end)
+            return;
+
+        if (item->BufferReadPBO == 0)
+            glGenBuffers(1, &item->BufferReadPBO);
+
+        // the copy happens on the GPU, the result is picked up once the fence is signaled
+        glBindBuffer(GL_COPY_READ_BUFFER, buf->ID);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, item->BufferReadPBO);
+        glBufferData(GL_COPY_WRITE_BUFFER, end - start, nullptr, GL_STREAM_READ);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, start, 0, end - start);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+        item->BufferReadStart = start;
+        item->BufferReadSize = end - start;
+        item->BufferReadFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        item->BufferClock.restart();
+    }
+    void ObjectPreviewUI::m_pollBufferRead(mItem* item)
+    {
+        if (item->BufferReadFence == 0)
+            return;
+
+        GLenum status = glClientWaitSync(item->BufferReadFence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            return;
+
+        glDeleteSync(item->BufferReadFence);
+        item->BufferReadFence = 0;
+
+        item->BufferView.resize(item->BufferReadSize);
+        item->BufferViewStart = item->BufferReadStart;
+
+        glBindBuffer(GL_COPY_READ_BUFFER, item->BufferReadPBO);
+        glGetBufferSubData(GL_COPY_READ_BUFFER, 0, item->BufferReadSize, item->BufferView.data());
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+        // the CPU copy is what gets saved
+        BufferObject* buf = (BufferObject*)item->Buffer;
+        if (buf->Data != nullptr && item->BufferReadStart + item->BufferReadSize <= buf->Size)
+            memcpy((char*)buf->Data + item->BufferReadStart, item->BufferView.data(), item->BufferReadSize);
+    }
+    void ObjectPreviewUI::m_cancelBufferRead(mItem* item)
+    {
+        if (item->BufferReadFence != 0) {
+            glDeleteSync(item->BufferReadFence);
+            item->BufferReadFence = 0;
+        }
+    }
+    void ObjectPreviewUI::m_renderStatistics(mItem* item, GLuint tex, int index)
+    {
+        TextureStatistics::Query& query = item->Statistics;
+        m_stats.Poll(query);
+
+        // a new request is only made once the previous one was read back
+        if (!m_stats.IsPending(query) && (!query.Last.Valid || item->StatisticsClock.getElapsedTime().asMilliseconds() >= STATISTICS_REFRESH_INTERVAL)) {
+            if (!m_stats.Start(query, tex) && !query.Last.Valid) {
+                ImGui::TextDisabled("The texture's format can't be inspected.");
+                return;
+            }
+            item->StatisticsClock.restart();
+        }
+
+        const TextureStatistics::Result& res = query.Last;
+        if (!res.Valid) {
+            ImGui::TextDisabled("Computing...");
+            return;
+        }
+
+        const char* channels[] = { "R", "G", "B", "A" };
+
+        ImGui::Columns(6, ("##objprev_statcols" + std::to_string(index)).c_str());
+        ImGui::Text("Channel"); ImGui::NextColumn();
+        ImGui::Text("Min"); ImGui::NextColumn();
+        ImGui::Text("Max"); ImGui::NextColumn();
+        ImGui::Text("Mean"); ImGui::NextColumn();
+        ImGui::Text("NaN"); ImGui::NextColumn();
+        ImGui::Text("Inf"); ImGui::NextColumn();
+        ImGui::Separator();
+        for (int c = 0; c < 4; c++) {
+            ImGui::Text("%s", channels[c]); ImGui::NextColumn();
+            ImGui::Text("%.5g", res.Min[c]); ImGui::NextColumn();
+            ImGui::Text("%.5g", res.Max[c]); ImGui::NextColumn();
+            ImGui::Text("%.5g", res.Mean[c]); ImGui::NextColumn();
+            if (res.NaN[c] > 0)
+                ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "%u", res.NaN[c]);
+            else
+                ImGui::Text("0");
+            ImGui::NextColumn();
+            if (res.Inf[c] > 0)
+                ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "%u", res.Inf[c]);
+            else
+                ImGui::Text("0");
+            ImGui::NextColumn();
+        }
+        ImGui::Columns(1);
+
+        // the bins are spread between the channel's min & max
+        int ch = item->StatisticsChannel;
+        float histogram[TEXTURE_STATISTICS_BINS];
+        float peak = 0.0f;
+        for (int b = 0; b < TEXTURE_STATISTICS_BINS; b++) {
+            histogram[b] = (float)res.Histogram[ch][b];
+            peak = std::max(peak, histogram[b]);
+        }
+
+        char range[64];
+        snprintf(range, sizeof(range), "%.4g .. %.4g", res.Min[ch], res.Max[ch]);
+
+        ImGui::PushItemWidth(60 * Settings::Instance().DPIScale);
+        ImGui::Combo(("##objprev_statch" + std::to_string(index)).c_str(), &item->StatisticsChannel, channels, 4);
+        ImGui::PopItemWidth();
+        ImGui::SameLine();
+        ImGui::PlotHistogram(("##objprev_stathist" + std::to_string(index)).c_str(), histogram, TEXTURE_STATISTICS_BINS, 0, range, 0.0f, peak, ImVec2(-1, 80 * Settings::Instance().DPIScale));
+    }
 }
\ No newline at end of file
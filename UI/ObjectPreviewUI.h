@@ -3,7 +3,10 @@
 #include "../Objects/PipelineItem.h"
 #include "Tools/CubemapPreview.h"
 #include "Tools/Magnifier.h"
+#include "Tools/TextureStatistics.h"
+#include "Tools/VolumeSlice.h"
 #include "../Engine/GLUtils.h"
+#include "../Objects/GPUFill.h"
 
 namespace ed
 {
@@ -22,10 +25,10 @@ namespace ed
 		virtual void OnEvent(const SDL_Event& e);
 		virtual void Update(float delta);
 
-        void Open(const std::string& name, float w, float h, unsigned int item, bool isCube = false, void* rt = nullptr, void* audio = nullptr, void* buffer = nullptr, void* plugin = nullptr);
+        void Open(const std::string& name, float w, float h, unsigned int item, bool isCube = false, void* rt = nullptr, void* audio = nullptr, void* buffer = nullptr, void* plugin = nullptr, void* image3D = nullptr);
 
         inline bool ShouldRun() { return m_items.size() > 0; }
-        inline void CloseAll() { m_items.clear(); }
+        inline void CloseAll() { for (auto& item : m_items) m_release(item); m_items.clear(); }
         void Close(const std::string& name);
 
 	protected:
@@ -40,23 +43,47 @@ namespace ed
             void* RT;
             
             void* Audio;
+            std::vector<float> AudioView; // spectrum & samples that are plotted
+            sf::Clock AudioClock;
 
             void* Buffer;
             std::vector<ShaderVariable::ValueType> CachedFormat;
             int CachedSize;
+            std::vector<char> BufferView; // bytes around the visible rows, starting at BufferViewStart
+            int BufferViewStart;
+            int BufferReadStart, BufferReadSize; // range that is being copied to BufferReadPBO
+            GLuint BufferReadPBO;
+            GLsync BufferReadFence;
+            sf::Clock BufferClock;
+            GPUFill::Operation Fill; // settings of the fill editor
 
 			void* Plugin;
+
+			void* Image3D;
+			std::shared_ptr<VolumeSlice> Slice; // shared by the copies of the item
+			int SliceIndex, SliceReduction;
+
+			bool ShowStatistics;
+			int StatisticsChannel; // shown in the histogram
+			TextureStatistics::Query Statistics;
+			sf::Clock StatisticsClock;
         };
 
     private:
-        sf::Clock m_bufUpdateClock;
         bool m_drawBufferElement(int row, int col, void *data, ShaderVariable::ValueType type);
+        void m_release(mItem& item);
+
+        // only the rows that are visible are copied from the GPU, without waiting for it
+        void m_readBufferRows(mItem* item, int start, int end);
+        void m_pollBufferRead(mItem* item);
+        void m_cancelBufferRead(mItem* item);
+
+        void m_renderStatistics(mItem* item, GLuint tex, int index);
         std::vector<mItem> m_items;
-        ed::AudioAnalyzer m_audioAnalyzer;
-        float m_samples[512], m_fft[512];
         
 		// tools
 		CubemapPreview m_cubePrev;
+		TextureStatistics m_stats;
         
         // for each item opened
         int m_curHoveredItem;
@@ -7,6 +7,7 @@
 #include "../Objects/Settings.h"
 #include "../Objects/ThemeContainer.h"
 #include "../Objects/KeyboardShortcuts.h"
+#include "../Engine/FramePacer.h"
 #include "UIHelper.h"
 
 #include <algorithm>
@@ -166,7 +167,26 @@ namespace ed
 		ImGui::Text("VSync: ");
 		ImGui::SameLine();
 		if (ImGui::Checkbox("##optg_vsync", &settings->General.VSync))
-			SDL_GL_SetSwapInterval(settings->General.VSync);
+			eng::FramePacer::ApplyVSync(settings->General.VSync, settings->General.AdaptiveVSync);
+
+		/* ADAPTIVE VSYNC: */
+		if (!settings->General.VSync) {
+			ImGui::PushItemFlag(ImGuiItemFlags_Disabled, true);
+			ImGui::PushStyleVar(ImGuiStyleVar_Alpha, ImGui::GetStyle().Alpha * 0.5f);
+		}
+		ImGui::Text("Adaptive VSync: ");
+		ImGui::SameLine();
+		if (ImGui::Checkbox("##optg_adaptivevsync", &settings->General.AdaptiveVSync))
+			eng::FramePacer::ApplyVSync(settings->General.VSync, settings->General.AdaptiveVSync);
+		if (!settings->General.VSync) {
+			ImGui::PopStyleVar();
+			ImGui::PopItemFlag();
+		}
+
+		/* EVENT DRIVEN UI: */
+		ImGui::Text("Redraw the UI only when something changes: ");
+		ImGui::SameLine();
+		ImGui::Checkbox("##optg_eventdrivenui", &settings->General.EventDrivenUI);
 
 		/* THEME */
 		ImGui::Text("Theme: "); ImGui::SameLine();
@@ -205,15 +225,11 @@ namespace ed
 		ImGui::Checkbox("##optg_autoerror", &settings->General.AutoOpenErrorWindow);
 
 		/* RECOVERY: */
-		ImGui::PushItemFlag(ImGuiItemFlags_Disabled, true);
-		ImGui::PushStyleVar(ImGuiStyleVar_Alpha, ImGui::GetStyle().Alpha * 0.5f);
-
 		ImGui::Text("Save recovery file every 10mins: ");
 		ImGui::SameLine();
 		ImGui::Checkbox("##optg_recovery", &settings->General.Recovery);
-
-		ImGui::PopStyleVar();
-		ImGui::PopItemFlag();
+		if (ImGui::IsItemHovered())
+			ImGui::SetTooltip("Unsaved changes are written to <project>.recovery.sprj in the background, it can be opened after a crash");
 
 		/* CHECK FOR UPDATES: */
 		ImGui::Text("Check for updates on startup: ");
@@ -230,6 +246,21 @@ namespace ed
 		ImGui::SameLine();
 		ImGui::Checkbox("##optg_autorecompile", &settings->General.AutoRecompile);
 
+		/* PROGRAM CACHE */
+		ImGui::Text("Cache compiled shaders on disk: ");
+		ImGui::SameLine();
+		ImGui::Checkbox("##optg_programcache", &settings->General.ProgramCache);
+
+		/* MODEL CACHE */
+		ImGui::Text("Cache imported 3D models on disk: ");
+		ImGui::SameLine();
+		ImGui::Checkbox("##optg_modelcache", &settings->General.ModelCache);
+
+		/* OPTIMIZE MODELS */
+		ImGui::Text("Optimize imported 3D models (can merge mesh groups): ");
+		ImGui::SameLine();
+		ImGui::Checkbox("##optg_optimizemodels", &settings->General.OptimizeModels);
+
 		/* REOPEN: */
 		ImGui::Text("Reopen shaders after openning a project: ");
 		ImGui::SameLine();
@@ -431,6 +462,13 @@ namespace ed
 		ImGui::SameLine();
 		ImGui::Checkbox("##optg_terminallogs", &settings->General.PipeLogsToTerminal);
 
+		/* LOG LEVEL: */
+		ImGui::Text("Log level: ");
+		ImGui::SameLine();
+		ImGui::PushItemWidth(-1);
+		ImGui::Combo("##optg_loglevel", &settings->General.LogLevel, " Everything\0 Warnings and errors\0 Only errors\0");
+		ImGui::PopItemWidth();
+
 		if (!settings->General.Log) {
 			ImGui::PopStyleVar();
 			ImGui::PopItemFlag();
@@ -678,6 +716,11 @@ namespace ed
 		ImGui::SameLine();
 		ImGui::Checkbox("##optp_prop_pick", &settings->Preview.PropertyPick);
 
+		/* GPU PICKING: */
+		ImGui::Text("Pick items on the GPU (only items drawn to the window): ");
+		ImGui::SameLine();
+		ImGui::Checkbox("##optp_gpu_pick", &settings->Preview.GPUPicking);
+
 		/* FPS LIMIT: */
 		ImGui::Text("FPS limit: ");
 		ImGui::SameLine();
@@ -707,6 +750,87 @@ namespace ed
 			ImGui::PopItemFlag();
 		}
 
+		/* SKIP IDLE FRAMES: */
+		ImGui::Text("Don't render the same frame again when nothing is animated: ");
+		ImGui::SameLine();
+		ImGui::Checkbox("##optp_skip_idle", &settings->Preview.SkipIdleFrames);
+
+		/* RENDER WHEN HIDDEN: */
+		ImGui::Text("Keep rendering while the preview is hidden or the window is minimized: ");
+		ImGui::SameLine();
+		ImGui::Checkbox("##optp_render_hidden", &settings->Preview.RenderWhenHidden);
+		if (ImGui::IsItemHovered())
+			ImGui::SetTooltip("Audio passes and compute passes with a tick rate always keep running");
+
+		/* DYNAMIC RESOLUTION: */
+		ImGui::Text("Lower the resolution to reach the FPS limit: ");
+		ImGui::SameLine();
+		ImGui::Checkbox("##optp_dynamic_res", &settings->Preview.DynamicResolution);
+
+		/* EDITOR PRIORITY: */
+		ImGui::Text("Keep the editor responsive while typing: ");
+		ImGui::SameLine();
+		ImGui::Checkbox("##optp_editor_priority", &settings->Preview.EditorPriority);
+		if (ImGui::IsItemHovered())
+			ImGui::SetTooltip("Previews that take longer than a few milliseconds are rendered less often while you type or drag a widget outside of the preview");
+
+		/* REORDER PASSES: */
+		ImGui::Text("Reorder independent passes: ");
+		ImGui::SameLine();
+		ImGui::Checkbox("##optp_reorder_passes", &settings->Preview.ReorderPasses);
+		if (ImGui::IsItemHovered())
+			ImGui::SetTooltip("Render the passes that don't depend on each other grouped by their render textures and warn about passes whose output is never used");
+
+		/* CACHE STATIC PASSES: */
+		ImGui::Text("Cache static passes: ");
+		ImGui::SameLine();
+		ImGui::Checkbox("##optp_cache_static", &settings->Preview.CacheStaticPasses);
+		if (ImGui::IsItemHovered())
+			ImGui::SetTooltip("Keep the render textures of the passes that don't use time, mouse or other changing inputs instead of drawing them every frame");
+
+		/* FRAME CACHE: */
+		ImGui::Text("Timeline frame cache (MB): ");
+		ImGui::SameLine();
+		ImGui::DragInt("##optp_frame_cache", &settings->Preview.FrameCacheSize, 1.0f, 0, 4096);
+		if (ImGui::IsItemHovered())
+			ImGui::SetTooltip("Video memory for half resolution copies of the recently rendered frames that the timeline under the preview can scrub through, 0 turns the timeline off");
+
+		/* AUDIO BLOCK SIZE: */
+		ImGui::Text("Audio shader block size: ");
+		ImGui::SameLine();
+		int audioBlockChoice = 0;
+		while ((256 << audioBlockChoice) < settings->Preview.AudioBlockSize)
+			audioBlockChoice++;
+		if (ImGui::Combo("##optp_audio_block", &audioBlockChoice, " 256\0 512\0 1024\0 2048\0 4096\0"))
+			settings->Preview.AudioBlockSize = 256 << audioBlockChoice;
+
+		/* AUDIO BLOCKS AHEAD: */
+		ImGui::Text("Audio shader blocks rendered ahead: ");
+		ImGui::SameLine();
+		if (ImGui::InputInt("##optp_audio_ahead", &settings->Preview.AudioBlocksAhead))
+			settings->Preview.AudioBlocksAhead = std::max<int>(std::min<int>(settings->Preview.AudioBlocksAhead, 16), 2);
+
+		/* BUFFER PREVIEW REFRESH RATE: */
+		ImGui::Text("Buffer preview refresh rate (ms): ");
+		ImGui::SameLine();
+		if (ImGui::InputInt("##optp_buffer_refresh", &settings->Preview.BufferRefreshRate, 10, 100))
+			settings->Preview.BufferRefreshRate = std::max<int>(settings->Preview.BufferRefreshRate, 0);
+
+		/* TIME SLICING: */
+		ImGui::Text("Time slice budget (ms): ");
+		ImGui::SameLine();
+		if (ImGui::InputInt("##optp_time_slice", &settings->Preview.TimeSliceBudget, 10, 100))
+			settings->Preview.TimeSliceBudget = std::max<int>(settings->Preview.TimeSliceBudget, 0);
+		if (ImGui::IsItemHovered())
+			ImGui::SetTooltip("Split the shader passes into bands and the compute dispatches into smaller ones so that no GPU submission takes longer than this - keeps very heavy shaders from triggering the driver's timeout (TDR). Compute shaders have to add the uvec3 SHADERed_WorkGroupOffset uniform to gl_WorkGroupID. Slower, 0 turns it off");
+
+		/* PASS WATCHDOG: */
+		ImGui::Text("Pass time budget (ms): ");
+		ImGui::SameLine();
+		if (ImGui::InputInt("##optp_pass_budget", &settings->Preview.PassBudget, 50, 500))
+			settings->Preview.PassBudget = std::max<int>(settings->Preview.PassBudget, 0);
+		if (ImGui::IsItemHovered())
+			ImGui::SetTooltip("Shader passes that take longer than this on the GPU (an infinite loop for example) are deactivated, compute passes are skipped until they are recompiled. 0 turns it off");
 	}
 	void OptionsUI::m_renderPlugins()
 	{
@@ -752,6 +876,14 @@ namespace ed
 
 		ImGui::Columns(1);
 
+		/* BUDGET: */
+		ImGui::Text("Warn when a plugin uses more CPU time per frame than (ms, 0 = off): ");
+		ImGui::SameLine();
+		ImGui::PushItemWidth(100 * Settings::Instance().DPIScale);
+		if (ImGui::InputFloat("##optpl_budget", &settings->Plugins.Budget, 0.1f, 1.0f, "%.2f"))
+			settings->Plugins.Budget = std::max<float>(settings->Plugins.Budget, 0.0f);
+		ImGui::PopItemWidth();
+
 		ImGui::Text("Search: ");
 		ImGui::SameLine();
 		ImGui::PushItemWidth(-1);
@@ -769,6 +901,20 @@ namespace ed
 		ImGui::Text("Show variable values when hovering over them: ");
 		ImGui::SameLine();
 		ImGui::Checkbox("##optdbg_values", &settings->Debug.ShowValuesOnHover);
+
+		/* GPU MARKERS: */
+		ImGui::Text("GPU debug markers: ");
+		ImGui::SameLine();
+		ImGui::Checkbox("##optdbg_gpumarkers", &settings->Debug.GPUMarkers);
+		if (ImGui::IsItemHovered())
+			ImGui::SetTooltip("Group the draw calls by pipeline item for RenderDoc, Nsight, etc... and show the driver's performance warnings");
+
+		/* RENDERDOC: */
+		ImGui::Text("Load RenderDoc on startup: ");
+		ImGui::SameLine();
+		ImGui::Checkbox("##optdbg_renderdoc", &settings->Debug.RenderDoc);
+		if (ImGui::IsItemHovered())
+			ImGui::SetTooltip("Enables Project -> Capture frame in RenderDoc (requires a restart, RenderDoc has to be installed)");
 	}
 	void OptionsUI::m_renderProject()
 	{
@@ -796,6 +942,89 @@ namespace ed
 			m_data->Parser.ModifyProject();
 		ImGui::PopItemWidth();
 
+		/* SPIR-V OPTIMIZER: */
+		ImGui::Text("SPIR-V optimization: ");
+		ImGui::SameLine();
+		ImGui::PushItemWidth(-1);
+		if (ImGui::Combo("##optpr_spvopt", &settings->Project.SPIRVOptimization, "Off\0Performance\0Size\0")) {
+			m_data->Parser.ModifyProject();
+
+			// only HLSL & Vulkan GLSL go through SPIR-V but recompiling everything is simpler
+			std::vector<PipelineItem*>& passes = m_data->Pipeline.GetList();
+			for (PipelineItem* pass : passes)
+				if (pass->Type == PipelineItem::ItemType::ShaderPass || pass->Type == PipelineItem::ItemType::ComputePass)
+					m_data->Renderer.Recompile(pass->Name);
+		}
+		ImGui::PopItemWidth();
+		if (ImGui::IsItemHovered())
+			ImGui::SetTooltip("Runs the SPIRV-Tools optimizer on HLSL and Vulkan GLSL shaders before they are converted to GLSL");
+
+		/* AUDIO TEXTURE ARRAY: */
+		ImGui::Text("Pack audio objects into a texture array: ");
+		ImGui::SameLine();
+		if (ImGui::Checkbox("##optpr_audioarray", &settings->Project.AudioTextureArray))
+			m_data->Parser.ModifyProject();
+		if (ImGui::IsItemHovered())
+			ImGui::SetTooltip("Binding any audio object binds all of them as one sampler2DArray - the layer is the audio object's position in the object list");
+
+		/* BINDLESS TEXTURES: */
+		ImGui::Text("Bindless texture table: ");
+		ImGui::SameLine();
+		if (!GLEW_ARB_bindless_texture)
+			ImGui::TextDisabled("not supported by the driver");
+		else if (ImGui::Checkbox("##optpr_bindless", &settings->Project.BindlessTextures))
+			m_data->Parser.ModifyProject();
+		if (ImGui::IsItemHovered())
+			ImGui::SetTooltip("Textures, cubemaps and texture arrays get a resident handle in the SHADERed_Textures storage block (layout(std430) readonly buffer SHADERed_Textures { uvec2 Handles[]; }) - the index is shown in the object's context menu. Textures that have a handle can't change their mipmap setting.");
+
+		/* STEREO: */
+		ImGui::Text("Eye separation: ");
+		ImGui::SameLine();
+		ImGui::PushItemWidth(150 * settings->DPIScale);
+		if (ImGui::DragFloat("##optpr_eyesep", &settings->Project.EyeSeparation, 0.001f, 0.0f, 10.0f, "%.3f"))
+			m_data->Parser.ModifyProject();
+		ImGui::PopItemWidth();
+		if (ImGui::IsItemHovered())
+			ImGui::SetTooltip("Distance between the cameras of the ViewLeft/ViewRight system variables");
+
+		ImGui::Text("Stereo convergence: ");
+		ImGui::SameLine();
+		ImGui::PushItemWidth(150 * settings->DPIScale);
+		if (ImGui::DragFloat("##optpr_stereoconv", &settings->Project.StereoConvergence, 0.05f, 0.001f, 1000.0f, "%.2f")) {
+			settings->Project.StereoConvergence = std::max(settings->Project.StereoConvergence, 0.001f);
+			m_data->Parser.ModifyProject();
+		}
+		ImGui::PopItemWidth();
+		if (ImGui::IsItemHovered())
+			ImGui::SetTooltip("Distance in front of the camera at which both eyes see a point at the same pixel (ProjectionLeft/ProjectionRight)");
+
+		ImGui::Text("Stereo preview: ");
+		ImGui::SameLine();
+		ImGui::PushItemWidth(-1);
+		if (ImGui::BeginCombo("##optpr_stereoprev", settings->Project.StereoPreview.empty() ? "Off" : settings->Project.StereoPreview.c_str())) {
+			if (ImGui::Selectable("Off", settings->Project.StereoPreview.empty())) {
+				settings->Project.StereoPreview.clear();
+				m_data->Parser.ModifyProject();
+			}
+
+			// the layers of a texture array are the eyes
+			for (const std::string& name : m_data->Objects.GetObjects()) {
+				ObjectManagerItem* obj = m_data->Objects.GetObjectManagerItem(name);
+				if (obj == nullptr || obj->RT == nullptr || obj->RT->Cubemap || obj->RT->Layers < 2)
+					continue;
+
+				if (ImGui::Selectable(name.c_str(), settings->Project.StereoPreview == name)) {
+					settings->Project.StereoPreview = name;
+					m_data->Parser.ModifyProject();
+				}
+			}
+
+			ImGui::EndCombo();
+		}
+		ImGui::PopItemWidth();
+		if (ImGui::IsItemHovered())
+			ImGui::SetTooltip("Show the first two layers of this render texture side by side in the preview - draw both of them in one pass with the pass' Multiview option");
+
 		/* INCLUDE PATHS: */
 		ImGui::Text("Include directories: ");
 		ImGui::SameLine();
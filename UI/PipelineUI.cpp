@@ -3,6 +3,7 @@
 #include "PropertyUI.h"
 #include "PinnedUI.h"
 #include "PreviewUI.h"
+#include "UIHelper.h"
 #include "Icons.h"
 #include "../Options.h"
 #include "../GUIManager.h"
@@ -10,8 +11,9 @@
 #include "../Objects/ShaderTranscompiler.h"
 #include "../Objects/SystemVariableManager.h"
 #include "../Objects/ThemeContainer.h"
+#include "../Objects/GeometryCache.h"
+#include "../Objects/VAOCache.h"
 #include "../Engine/GLUtils.h"
-#include "../Engine/GeometryFactory.h"
 
 #include <imgui/imgui.h>
 #include <imgui/imgui_internal.h>
@@ -145,6 +147,10 @@ namespace ed
 			ImGui::OpenPopup("Resource manager##pui_res_manager");
 			m_isResourceManagerOpened = false;
 		}
+		if (m_isExportAudioOpened) {
+			ImGui::OpenPopup("Export audio##pui_export_audio");
+			m_isExportAudioOpened = false;
+		}
 
 		// Shader Variable manager
 		ImGui::SetNextWindowSize(ImVec2(730 * Settings::Instance().DPIScale, 225 * Settings::Instance().DPIScale), ImGuiCond_Once);
@@ -160,6 +166,20 @@ namespace ed
 		if (ImGui::BeginPopupModal("Shader Macros##pui_shader_macros")) {
 			m_renderMacroManagerUI();
 
+			if (m_modalItem->Type != PipelineItem::ItemType::AudioPass) {
+				if (ImGui::Button("Precompile variants"))
+					m_data->Renderer.PrecompileVariants(m_modalItem);
+				if (ImGui::IsItemHovered())
+					ImGui::SetTooltip("Compiles the on/off combinations of these macros in the background so that switching between them is instant");
+
+				ImGui::SameLine();
+				int building = m_data->Renderer.GetPrecompileJobCount(m_modalItem);
+				if (building > 0)
+					ImGui::Text("%d compiled, %d in progress", m_data->Renderer.GetVariantCount(m_modalItem), building);
+				else
+					ImGui::Text("%d compiled", m_data->Renderer.GetVariantCount(m_modalItem));
+				ImGui::SameLine();
+			}
 			if (ImGui::Button("Ok")) m_closePopup();
 			ImGui::EndPopup();
 		}
@@ -183,19 +203,19 @@ namespace ed
 
 						BufferObject* bobj = (BufferObject*)gitem->InstanceBuffer;
 						if (bobj == nullptr)
-							gl::CreateVAO(gitem->VAO, gitem->VBO, pass->InputLayout);
+							GeometryCache::Instance().Rebuild(gitem, pass->InputLayout);
 						else
-							gl::CreateVAO(gitem->VAO, gitem->VBO, pass->InputLayout, 0, bobj->ID, m_data->Objects.ParseBufferFormat(bobj->ViewFormat));
+							GeometryCache::Instance().Rebuild(gitem, pass->InputLayout, bobj->ID, m_data->Objects.ParseBufferFormat(bobj->ViewFormat));
 					} else if (pitem->Type == PipelineItem::ItemType::Model) {
 						pipe::Model* mitem = (pipe::Model*)pitem->Data;
 						BufferObject* bobj = (BufferObject*)mitem->InstanceBuffer;
 						if (bobj == nullptr) {
 							for (auto& mesh : mitem->Data->Meshes)
-								gl::CreateVAO(mesh.VAO, mesh.VBO, pass->InputLayout, mesh.EBO);
+								VAOCache::Instance().Rebuild(mesh.VAO, mesh.VBO, pass->InputLayout, mesh.EBO);
 						}
 						else {
 							for (auto& mesh : mitem->Data->Meshes)
-								gl::CreateVAO(mesh.VAO, mesh.VBO, pass->InputLayout, mesh.EBO, bobj->ID, m_data->Objects.ParseBufferFormat(bobj->ViewFormat));
+								VAOCache::Instance().Rebuild(mesh.VAO, mesh.VBO, pass->InputLayout, mesh.EBO, bobj->ID, m_data->Objects.ParseBufferFormat(bobj->ViewFormat));
 						}
 					}
 				}
@@ -206,6 +226,35 @@ namespace ed
 			ImGui::EndPopup();
 		}
 
+		// Export audio
+		ImGui::SetNextWindowSize(ImVec2(450 * Settings::Instance().DPIScale, 150 * Settings::Instance().DPIScale), ImGuiCond_Once);
+		if (ImGui::BeginPopupModal("Export audio##pui_export_audio")) {
+			ImGui::TextWrapped("Path: %s", m_exportAudioPath.c_str());
+			ImGui::SameLine();
+			if (ImGui::Button("...##pui_export_audio_path"))
+				UIHelper::GetSaveFileDialog(m_exportAudioPath, "wav;flac;ogg");
+
+			ImGui::Text("Start (s): ");
+			ImGui::SameLine();
+			ImGui::PushItemWidth(-1);
+			ImGui::DragFloat("##pui_export_audio_start", &m_exportAudioStart, 0.1f, 0.0f, 3600.0f);
+			ImGui::PopItemWidth();
+
+			ImGui::Text("Duration (s): ");
+			ImGui::SameLine();
+			ImGui::PushItemWidth(-1);
+			ImGui::DragFloat("##pui_export_audio_dur", &m_exportAudioDuration, 0.1f, 0.0f, 3600.0f);
+			ImGui::PopItemWidth();
+
+			if (ImGui::Button("Export") && !m_exportAudioPath.empty()) {
+				m_data->Renderer.ExportAudio(m_modalItem, m_exportAudioPath, m_exportAudioStart, m_exportAudioDuration);
+				m_closePopup();
+			}
+			ImGui::SameLine();
+			if (ImGui::Button("Cancel")) m_closePopup();
+			ImGui::EndPopup();
+		}
+
 		// Create Item
 		ImGui::SetNextWindowSize(ImVec2(430 * Settings::Instance().DPIScale, 175 * Settings::Instance().DPIScale), ImGuiCond_Once);
 		if (ImGui::BeginPopupModal("Create Item##pui_create_item")) {
@@ -258,6 +307,7 @@ namespace ed
 				ed::PipelineItem* temp = items[index - 1];
 				items[index - 1] = items[index];
 				items[index] = temp;
+				m_data->Pipeline.Notify(PipelineManager::EventType::ItemMoved, items[index - 1]);
 
 				if (props->HasItemSelected()) {
 					if (oldPropertyItemName == items[index - 1]->Name)
@@ -284,6 +334,7 @@ namespace ed
 				ed::PipelineItem* temp = items[index + 1];
 				items[index + 1] = items[index];
 				items[index] = temp;
+				m_data->Pipeline.Notify(PipelineManager::EventType::ItemMoved, items[index + 1]);
 
 				if (props->HasItemSelected()) {
 					if (oldPropertyItemName == items[index + 1]->Name)
@@ -418,6 +469,11 @@ namespace ed
 					m_modalItem = items[index];
 				}
 
+				if (items[index]->Type == PipelineItem::ItemType::AudioPass && ImGui::MenuItem("Export audio")) {
+					m_isExportAudioOpened = true;
+					m_modalItem = items[index];
+				}
+
 			}
 			else if (items[index]->Type == ed::PipelineItem::ItemType::Geometry || items[index]->Type == ed::PipelineItem::ItemType::Model) {
 				if (ImGui::MenuItem("Change Variables")) {
@@ -492,6 +548,9 @@ namespace ed
 
 		bool isInvert = var->Flags & (char)ShaderVariable::Flag::Inverse;
 		bool isLastFrame = var->Flags & (char)ShaderVariable::Flag::LastFrame;
+		bool isConstant = var->Flags & (char)ShaderVariable::Flag::Constant;
+		bool canConstant = var->System == ed::SystemShaderVariable::None && var->Function == ed::FunctionShaderVariable::None &&
+			(type == ShaderVariable::ValueType::Boolean1 || type == ShaderVariable::ValueType::Integer1 || type == ShaderVariable::ValueType::Float1);
 
 		if (var->System == ed::SystemShaderVariable::None || !canInvert) {
 			ImGui::PushItemFlag(ImGuiItemFlags_Disabled, true);
@@ -516,14 +575,30 @@ namespace ed
 		if (ImGui::Checkbox(("##flaglf" + std::string(var->Name)).c_str(), &isLastFrame))
 			m_data->Parser.ModifyProject();
 		m_tooltip("Use last frame values");
+		ImGui::SameLine();
 
 		if (var->System == ed::SystemShaderVariable::None || !canLastFrame) {
 			ImGui::PopStyleVar();
 			ImGui::PopItemFlag();
 		}
 
+		if (!canConstant) {
+			ImGui::PushItemFlag(ImGuiItemFlags_Disabled, true);
+			ImGui::PushStyleVar(ImGuiStyleVar_Alpha, ImGui::GetStyle().Alpha * 0.5f);
+		}
+
+		if (ImGui::Checkbox(("##flagconst" + std::string(var->Name)).c_str(), &isConstant))
+			m_data->Parser.ModifyProject();
+		m_tooltip("Compile-time constant (the pass is rebuilt when the value changes)");
+
+		if (!canConstant) {
+			ImGui::PopStyleVar();
+			ImGui::PopItemFlag();
+		}
+
 		var->Flags = (isInvert * (char)ShaderVariable::Flag::Inverse) |
-					 (isLastFrame * (char)ShaderVariable::Flag::LastFrame);
+					 (isLastFrame * (char)ShaderVariable::Flag::LastFrame) |
+					 ((isConstant && canConstant) * (char)ShaderVariable::Flag::Constant);
 	}
 	void PipelineUI::m_renderInputLayoutManagerUI()
 	{
@@ -807,6 +882,12 @@ namespace ed
 			/* NAME */
 			ImGui::PushItemWidth(-ImGui::GetStyle().FramePadding.x);
 			if (ImGui::InputText(("##name" + std::to_string(id)).c_str(), const_cast<char*>(el->Name), VARIABLE_NAME_LENGTH)) {
+				if (isCompute)
+					((pipe::ComputePass*)itemData)->Variables.InvalidateLocations();
+				else if (isAudio)
+					((pipe::AudioPass*)itemData)->Variables.InvalidateLocations();
+				else
+					((pipe::ShaderPass*)itemData)->Variables.InvalidateLocations();
 				m_data->Parser.ModifyProject();
 			}
 			ImGui::NextColumn();
@@ -1072,6 +1153,65 @@ namespace ed
 		ImGui::EndChild();
 		ImGui::Columns(1);
 	}
+	void PipelineUI::m_renderSamplerUI(GLuint tex, int slot)
+	{
+		ObjectManager* objs = &m_data->Objects;
+		const SamplerState* sampler = objs->GetSampler(m_modalItem, tex);
+
+		std::string popupName = "##pui_sampler" + std::to_string(slot);
+		if (ImGui::Button(((sampler == nullptr ? "Texture" : "Custom") + std::string("##pui_samplerbtn") + std::to_string(slot)).c_str(), ImVec2(-1, 0)))
+			ImGui::OpenPopup(popupName.c_str());
+		if (ImGui::IsItemHovered())
+			ImGui::SetTooltip("Texture -> sample with the texture's own parameters, Custom -> this pass has its own filtering & wrapping");
+
+		if (!ImGui::BeginPopup(popupName.c_str()))
+			return;
+
+		bool custom = sampler != nullptr;
+		if (ImGui::Checkbox("Custom sampler", &custom)) {
+			if (custom)
+				objs->SetSampler(m_modalItem, tex, SamplerState());
+			else
+				objs->ResetSampler(m_modalItem, tex);
+			sampler = objs->GetSampler(m_modalItem, tex);
+		}
+
+		if (sampler != nullptr) {
+			SamplerState state = *sampler;
+
+			auto combo = [](const char* label, GLenum& value, const char** names, const unsigned int* values, int count) -> bool {
+				int cur = 0;
+				for (int i = 0; i < count; i++)
+					if (values[i] == value)
+						cur = i;
+
+				bool ret = false;
+				ImGui::PushItemWidth(200 * Settings::Instance().DPIScale);
+				if (ImGui::BeginCombo(label, names[cur])) {
+					for (int i = 0; i < count; i++)
+						if (ImGui::Selectable(names[i], i == cur)) {
+							value = values[i];
+							ret = true;
+						}
+					ImGui::EndCombo();
+				}
+				ImGui::PopItemWidth();
+				return ret;
+			};
+
+			bool changed = false;
+			changed |= combo("Min filter", state.MinFilter, FILTER_NAMES, FILTER_VALUES, HARRAYSIZE(FILTER_NAMES));
+			changed |= combo("Mag filter", state.MagFilter, FILTER_NAMES, FILTER_VALUES, 2); // no mipmaps for magnification
+			changed |= combo("Wrap S", state.WrapS, WRAP_NAMES, WRAP_VALUES, HARRAYSIZE(WRAP_NAMES));
+			changed |= combo("Wrap T", state.WrapT, WRAP_NAMES, WRAP_VALUES, HARRAYSIZE(WRAP_NAMES));
+			changed |= combo("Wrap R", state.WrapR, WRAP_NAMES, WRAP_VALUES, HARRAYSIZE(WRAP_NAMES));
+
+			if (changed)
+				objs->SetSampler(m_modalItem, tex, state);
+		}
+
+		ImGui::EndPopup();
+	}
 	void PipelineUI::m_renderResourceManagerUI()
 	{
 		ImGui::TextWrapped("List of all bound textures, images, etc...\n");
@@ -1084,7 +1224,7 @@ namespace ed
 		{
 			ImGui::Text("SRV");
 			ImGui::Separator();
-			ImGui::Columns(4);
+			ImGui::Columns(5);
 
 			// TODO: remove this after imgui fixes the table/column system
 			static bool isColumnWidthSet = false;
@@ -1100,6 +1240,7 @@ namespace ed
 			ImGui::Text("Unit"); ImGui::NextColumn();
 			ImGui::Text("Type"); ImGui::NextColumn();
 			ImGui::Text("Name"); ImGui::NextColumn();
+			ImGui::Text("Sampler"); ImGui::NextColumn();
 
 			ImGui::Separator();
 
@@ -1142,6 +1283,7 @@ namespace ed
 				else if (objs->IsAudio(itemName)) ImGui::Text("audio");
 				else if (objs->IsBuffer(itemName)) ImGui::Text("buffer");
 				else if (objs->IsCubeMap(itemName)) ImGui::Text("cubemap");
+				else if (objs->IsTextureArray(itemName)) ImGui::Text("texture array");
 				else ImGui::Text("texture");
 				ImGui::NextColumn();
 
@@ -1149,6 +1291,13 @@ namespace ed
 				ImGui::Text("%s", itemName.c_str());
 				ImGui::NextColumn();
 
+				/* SAMPLER */
+				if (objs->IsImage(itemName) || objs->IsImage3D(itemName) || objs->IsBuffer(itemName) || objs->IsPluginObject(itemName))
+					ImGui::Text("-");
+				else
+					m_renderSamplerUI(el, id);
+				ImGui::NextColumn();
+
 				id++;
 			}
 
@@ -1219,6 +1368,7 @@ namespace ed
 				else if (objs->IsAudio(itemName)) ImGui::Text("audio");
 				else if (objs->IsBuffer(itemName)) ImGui::Text("buffer");
 				else if (objs->IsCubeMap(itemName)) ImGui::Text("cubemap");
+				else if (objs->IsTextureArray(itemName)) ImGui::Text("texture array");
 				else ImGui::Text("texture");
 				ImGui::NextColumn();
 
@@ -1289,8 +1439,13 @@ namespace ed
 
 			/* ACTIVE */
 			ImGui::PushItemWidth(-ImGui::GetStyle().FramePadding.x);
-			if (ImGui::Checkbox(("##pui_mcr_act" + std::to_string(id)).c_str(), &el.Active))
+			if (ImGui::Checkbox(("##pui_mcr_act" + std::to_string(id)).c_str(), &el.Active)) {
 				m_data->Parser.ModifyProject();
+
+				// instant if this macro set was already compiled
+				if (!isAudio)
+					m_data->Renderer.Recompile(m_modalItem->Name);
+			}
 			ImGui::NextColumn();
 
 			/* NAME */
@@ -1478,23 +1633,17 @@ namespace ed
 					newData->Size = origData->Size;
 					newData->Topology = origData->Topology;
 					newData->Type = origData->Type;
-
-					if (newData->Type == pipe::GeometryItem::GeometryType::Cube)
-						newData->VAO = eng::GeometryFactory::CreateCube(newData->VBO, newData->Size.x, newData->Size.y, newData->Size.z, data->InputLayout);
-					else if (newData->Type == pipe::GeometryItem::Circle) {
-						newData->VAO = eng::GeometryFactory::CreateCircle(newData->VBO, newData->Size.x, newData->Size.y, data->InputLayout);
+					newData->GenShape = origData->GenShape;
+					newData->GenResolution = origData->GenResolution;
+					newData->GenAmplitude = origData->GenAmplitude;
+					newData->GenFrequency = origData->GenFrequency;
+					newData->GenSeed = origData->GenSeed;
+					newData->GenAnimated = origData->GenAnimated;
+					newData->VertexBuffer = origData->VertexBuffer;
+
+					GeometryCache::Instance().Create(newData, data->InputLayout);
+					if (newData->Type == pipe::GeometryItem::Circle)
 						newData->Topology = GL_TRIANGLE_STRIP;
-					}
-					else if (newData->Type == pipe::GeometryItem::Plane)
-						newData->VAO = eng::GeometryFactory::CreatePlane(newData->VBO, newData->Size.x, newData->Size.y, data->InputLayout);
-					else if (newData->Type == pipe::GeometryItem::Rectangle)
-						newData->VAO = eng::GeometryFactory::CreatePlane(newData->VBO, 1, 1, data->InputLayout);
-					else if (newData->Type == pipe::GeometryItem::Sphere)
-						newData->VAO = eng::GeometryFactory::CreateSphere(newData->VBO, newData->Size.x, data->InputLayout);
-					else if (newData->Type == pipe::GeometryItem::Triangle)
-						newData->VAO = eng::GeometryFactory::CreateTriangle(newData->VBO, newData->Size.x, data->InputLayout);
-					else if (newData->Type == pipe::GeometryItem::ScreenQuadNDC)
-						newData->VAO = eng::GeometryFactory::CreateScreenQuadNDC(newData->VBO, data->InputLayout);
 					
 					itemData = newData;
 				}
@@ -1510,6 +1659,11 @@ namespace ed
 					newData->Scale = origData->Scale;
 					newData->Position = origData->Position;
 					newData->Rotation = origData->Rotation;
+					newData->LOD = origData->LOD;
+					newData->FrustumCulling = origData->FrustumCulling;
+					newData->GPUCulling = origData->GPUCulling;
+					strcpy(newData->Animation, origData->Animation);
+					newData->AnimationSpeed = origData->AnimationSpeed;
 
 
 					if (strlen(newData->Filename) > 0) {
@@ -1722,23 +1876,17 @@ namespace ed
 						newData->Size = origData->Size;
 						newData->Topology = origData->Topology;
 						newData->Type = origData->Type;
-
-						if (newData->Type == pipe::GeometryItem::GeometryType::Cube)
-							newData->VAO = eng::GeometryFactory::CreateCube(newData->VBO, newData->Size.x, newData->Size.y, newData->Size.z, inpLayout);
-						else if (newData->Type == pipe::GeometryItem::Circle) {
-							newData->VAO = eng::GeometryFactory::CreateCircle(newData->VBO, newData->Size.x, newData->Size.y, inpLayout);
+						newData->GenShape = origData->GenShape;
+						newData->GenResolution = origData->GenResolution;
+						newData->GenAmplitude = origData->GenAmplitude;
+						newData->GenFrequency = origData->GenFrequency;
+						newData->GenSeed = origData->GenSeed;
+						newData->GenAnimated = origData->GenAnimated;
+						newData->VertexBuffer = origData->VertexBuffer;
+
+						GeometryCache::Instance().Create(newData, inpLayout);
+						if (newData->Type == pipe::GeometryItem::Circle)
 							newData->Topology = GL_TRIANGLE_STRIP;
-						}
-						else if (newData->Type == pipe::GeometryItem::Plane)
-							newData->VAO = eng::GeometryFactory::CreatePlane(newData->VBO, newData->Size.x, newData->Size.y, inpLayout);
-						else if (newData->Type == pipe::GeometryItem::Rectangle)
-							newData->VAO = eng::GeometryFactory::CreatePlane(newData->VBO, 1, 1, inpLayout);
-						else if (newData->Type == pipe::GeometryItem::Sphere)
-							newData->VAO = eng::GeometryFactory::CreateSphere(newData->VBO, newData->Size.x, inpLayout);
-						else if (newData->Type == pipe::GeometryItem::Triangle)
-							newData->VAO = eng::GeometryFactory::CreateTriangle(newData->VBO, newData->Size.x, inpLayout);
-						else if (newData->Type == pipe::GeometryItem::ScreenQuadNDC)
-							newData->VAO = eng::GeometryFactory::CreateScreenQuadNDC(newData->VBO, inpLayout);
 
 						itemData = newData;
 					}
@@ -1754,6 +1902,11 @@ namespace ed
 						newData->Scale = origData->Scale;
 						newData->Position = origData->Position;
 						newData->Rotation = origData->Rotation;
+						newData->LOD = origData->LOD;
+						newData->FrustumCulling = origData->FrustumCulling;
+						newData->GPUCulling = origData->GPUCulling;
+						strcpy(newData->Animation, origData->Animation);
+						newData->AnimationSpeed = origData->AnimationSpeed;
 
 
 						if (strlen(newData->Filename) > 0) {
@@ -17,6 +17,9 @@ namespace ed
 			m_isMacroManagerOpened = false;
 			m_isInpLayoutManagerOpened = false;
 			m_isResourceManagerOpened = false;
+			m_isExportAudioOpened = false;
+			m_exportAudioStart = 0.0f;
+			m_exportAudioDuration = 60.0f;
 		}
 
 		virtual void OnEvent(const SDL_Event& e);
@@ -36,6 +39,11 @@ namespace ed
 		bool m_isChangeVarsOpened;
 		bool m_isCreateViewOpened;
 		bool m_itemMenuOpened;
+		bool m_isExportAudioOpened;
+
+		// offline audio export
+		std::string m_exportAudioPath;
+		float m_exportAudioStart, m_exportAudioDuration;
 
 		std::vector<pipe::ShaderPass*> m_expandList; // list of shader pass items that are collapsed
 
@@ -53,6 +61,7 @@ namespace ed
 		void m_renderVariableManagerUI();
 		void m_renderInputLayoutManagerUI();
 		void m_renderResourceManagerUI();
+		void m_renderSamplerUI(GLuint tex, int slot);
 		void m_renderChangeVariablesUI();
 		void m_renderMacroManagerUI();
 
@@ -25,8 +25,42 @@ namespace ed
 	{
 		std::vector<PixelInformation>& pixels = m_data->Debugger.GetPixelList();
 
-		if (ImGui::Button("Clear##pixel_clear", ImVec2(-1, 0)))
+		RegionDebugger* region = &m_data->DebugRegion;
+
+		if (ImGui::Button("Clear##pixel_clear", ImVec2(-1, 0))) {
 			pixels.clear();
+			region->Clear();
+		}
+
+		// settings for running the debugger over the pixels around the selected one
+		ImGui::Text("Area: ");
+		ImGui::SameLine();
+		ImGui::PushItemWidth(100 * Settings::Instance().DPIScale);
+		ImGui::Combo("##pixel_region_mode", &m_regionMode, "Output\0Watch\0Steps\0");
+		ImGui::SameLine();
+		if (ImGui::InputInt("##pixel_region_size", &m_regionSize))
+			m_regionSize = std::max<int>(1, std::min<int>(m_regionSize, 512));
+		ImGui::PopItemWidth();
+		if (m_regionMode == (int)RegionDebugger::Mode::Watch) {
+			ImGui::PushItemWidth(-1);
+			ImGui::InputText("##pixel_region_watch", m_regionWatch, 256);
+			ImGui::PopItemWidth();
+		}
+		if (region->GetTexture() != 0) {
+			bool visible = region->IsVisible();
+			if (ImGui::Checkbox("Show area##pixel_region_visible", &visible))
+				region->SetVisible(visible);
+			if (region->GetMode() == RegionDebugger::Mode::Steps || region->GetRange() != glm::vec2(0.0f)) {
+				ImGui::SameLine();
+				ImGui::Text("min: %.3f, max: %.3f", region->GetRange().x, region->GetRange().y);
+			}
+			if (region->GetMode() == RegionDebugger::Mode::Steps && region->GetLineOwner() != nullptr) {
+				ImGui::SameLine();
+				ImGui::TextDisabled("(?)");
+				if (ImGui::IsItemHovered())
+					ImGui::SetTooltip("The steps of the area are also shown per line next to the line numbers of the pixel shader's editor");
+			}
+		}
 
 		ImGui::NewLine();
 
@@ -50,7 +84,7 @@ namespace ed
 
 					if (!success) {
 						m_errorPopup = true;
-						m_errorMessage = m_data->Debugger.Engine.GetLastError();
+						m_errorMessage = m_data->Debugger.Engine->GetLastError();
 					}
 				}
 			}
@@ -150,7 +184,7 @@ namespace ed
 					m_data->Debugger.SetDebugging(true);
 					m_data->Debugger.InitEngine(pixel, initIndex);
 					
-					sd::ShaderDebugger* dbgr = &m_data->Debugger.Engine;
+					sd::ShaderDebugger* dbgr = m_data->Debugger.Engine;
 					const auto& bkpts = editor->GetBreakpoints();
 
 					// skip initialization
@@ -166,12 +200,11 @@ namespace ed
 						m_data->Debugger.UpdateWatchValue(i);
 
 					// copy breakpoints
-					dbgr->ClearBreakpoints();
+					m_data->Debugger.ClearActiveBreakpoints();
 					for (const auto& bkpt : bkpts) {
 						if (!bkpt.mEnabled) continue;
 
-						if (bkpt.mCondition.empty()) dbgr->AddBreakpoint(bkpt.mLine);
-						else dbgr->AddConditionalBreakpoint(bkpt.mLine, bkpt.mCondition);
+						m_data->Debugger.AddActiveBreakpoint(bkpt.mLine, bkpt.mCondition);
 					}
 
 					// editor functions
@@ -179,20 +212,20 @@ namespace ed
 						if (!m_data->Debugger.IsDebugging())
 							return;
 
-						sd::ShaderDebugger* mDbgr = &m_data->Debugger.Engine;
+						sd::ShaderDebugger* mDbgr = m_data->Debugger.Engine;
 						bool state = false;
 						switch (act) {
 						case TextEditor::DebugAction::Continue:
-							state = mDbgr->Continue();
+							state = m_data->Debugger.Continue();
 							break;
 						case TextEditor::DebugAction::Step:
-							state = mDbgr->StepOver();
+							state = m_data->Debugger.StepOver();
 							break;
 						case TextEditor::DebugAction::StepInto:
 							state = mDbgr->Step();
 							break;
 						case TextEditor::DebugAction::StepOut:
-							state = mDbgr->StepOut();
+							state = m_data->Debugger.StepOut();
 							break;
 						}
 
@@ -210,15 +243,15 @@ namespace ed
 						if (!m_data->Debugger.IsDebugging())
 							return;
 
-						m_data->Debugger.Engine.Jump(line);
-						ed->SetCurrentLineIndicator(m_data->Debugger.Engine.GetCurrentLine());
+						m_data->Debugger.Engine->Jump(line);
+						ed->SetCurrentLineIndicator(m_data->Debugger.Engine->GetCurrentLine());
 						((DebugWatchUI*)m_ui->Get(ViewID::DebugWatch))->Refresh();
 					};
 					editor->HasIdentifierHover = [&](TextEditor* ed, const std::string& id) -> bool {
 						if (!m_data->Debugger.IsDebugging())
 							return false;
 
-						sd::ShaderDebugger* mDbgr = &m_data->Debugger.Engine;
+						sd::ShaderDebugger* mDbgr = m_data->Debugger.Engine;
 						bv_variable* var = mDbgr->GetLocalValue(id);
 						if (var == nullptr)
 							var = mDbgr->GetGlobalValue(id);
@@ -226,7 +259,7 @@ namespace ed
 						return var != nullptr && var->type != bv_type_void && Settings::Instance().Debug.ShowValuesOnHover;
 					};
 					editor->OnIdentifierHover = [&](TextEditor* ed, const std::string& id) {
-						sd::ShaderDebugger* mDbgr = &m_data->Debugger.Engine;
+						sd::ShaderDebugger* mDbgr = m_data->Debugger.Engine;
 						bv_variable* var = mDbgr->GetLocalValue(id);
 						if (var == nullptr)
 							var = mDbgr->GetGlobalValue(id);
@@ -266,8 +299,7 @@ namespace ed
 							}
 							else if (isCube) {
 								sd::TextureCube* tex = (sd::TextureCube*)bv_variable_get_object(*var)->user_data;
-								m_cubePrev.Draw(tex->UserData);
-								ImGui::Image((ImTextureID)m_cubePrev.GetTexture(), ImVec2(128.0f, 128.0f * (375.0f / 512.0f)), ImVec2(0, 1), ImVec2(1, 0));
+								ImGui::Image((ImTextureID)m_cubePrev.GetThumbnail(tex->UserData), ImVec2(128.0f, 128.0f * (375.0f / 512.0f)), ImVec2(0, 1), ImVec2(1, 0));
 							}
 							else
 								ImGui::Text(m_data->Debugger.VariableValueToString(*var).c_str());
@@ -276,6 +308,31 @@ namespace ed
 				}
 
 				ImGui::PopStyleColor();
+
+				// run the pixel shader for the area around this pixel
+				if (pixel.RenderTexture == "Window" && !pixel.Discarded) {
+					if (region->IsRunning()) {
+						ImGui::ProgressBar(region->GetProgress(), ImVec2(-ICON_BUTTON_WIDTH * 3, 0));
+						ImGui::SameLine();
+						if (ImGui::Button(("Cancel##pixel_region_cancel_" + std::to_string(pxId)).c_str(), ImVec2(-1, 0)))
+							region->Cancel();
+					}
+					else if (ImGui::Button(("Debug area##pixel_region_" + std::to_string(pxId)).c_str(), ImVec2(-1, 0))
+						&& m_data->Messages.CanRenderPreview())
+					{
+						pipe::ShaderPass* pass = ((pipe::ShaderPass*)pixel.Owner->Data);
+
+						ed::ShaderLanguage lang = ShaderTranscompiler::GetShaderTypeFromExtension(pass->PSPath);
+						std::string psSrc = m_data->Parser.LoadProjectFile(pass->PSPath);
+
+						if (!region->Start(pixel, lang, lang == ed::ShaderLanguage::GLSL ? "main" : pass->PSEntry, psSrc,
+							m_data->Renderer.GetLastRenderSize(), m_regionSize, (RegionDebugger::Mode)m_regionMode, m_regionWatch))
+						{
+							m_errorPopup = true;
+							m_errorMessage = region->GetLastError();
+						}
+					}
+				}
 			}
 
 			ImGui::Separator();
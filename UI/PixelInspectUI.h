@@ -11,6 +11,9 @@ namespace ed
 			UIView(ui, objects, name, visible) {
 			m_errorPopup = false;
 			m_cubePrev.Init(152, 114);
+			m_regionMode = 0;
+			m_regionSize = 32;
+			m_regionWatch[0] = 0;
 		}
 
 		virtual void OnEvent(const SDL_Event& e);
@@ -20,6 +23,11 @@ namespace ed
 		bool m_errorPopup;
 		std::string m_errorMessage;
 		CubemapPreview m_cubePrev;
+
+		// area debugging
+		int m_regionMode;
+		int m_regionSize;
+		char m_regionWatch[256];
 		
 	};
 }
\ No newline at end of file
@@ -8,20 +8,33 @@
 #include "../Objects/SystemVariableManager.h"
 #include "../Objects/KeyboardShortcuts.h"
 #include "../Objects/ThemeContainer.h"
-#include "../Engine/GeometryFactory.h"
+#include "../Objects/UIRefresh.h"
+#include "../Objects/RenderDocCapture.h"
+#include "../Objects/RemotePreview.h"
+#include "../Objects/InputRecorder.h"
+#include "../Objects/GeometryCache.h"
+#include "../Objects/FrameProfiler.h"
 #include "../Engine/GLUtils.h"
 
+#include <algorithm>
 #include <chrono>
 #include <thread>
 #include <imgui/imgui_internal.h>
 
 #define STATUSBAR_HEIGHT 30 * Settings::Instance().DPIScale
+#define TIMELINE_HEIGHT 24 * Settings::Instance().DPIScale
 #define BUTTON_SIZE 20 * Settings::Instance().DPIScale
 #define ICON_BUTTON_WIDTH 25 * Settings::Instance().DPIScale
 #define BUTTON_INDENT 5 * Settings::Instance().DPIScale
 #define FPS_UPDATE_RATE 0.3f
 #define BOUNDING_BOX_PADDING 0.01f
 #define MAX_PICKED_ITEM_LIST_SIZE 4
+#define MIN_RENDER_SCALE 0.25f
+#define RENDER_SCALE_STEP 0.0625f
+#define RENDER_SCALE_INTERVAL 0.25f
+#define RESIZE_DEBOUNCE_TIME 0.15f // s that the panel size has to stay the same while dragging before the render targets are resized
+#define EDITOR_PRIORITY_COST 0.008f // s per preview frame above which the edits come first
+#define EDITOR_PRIORITY_SPACING 4.0f // the preview gets at most 1/x of the time while the user edits something
 
 
 const char* BOX_VS_CODE = R"(
@@ -257,54 +270,171 @@ namespace ed
 		bool paused = m_data->Renderer.IsPaused();
 		bool capWholeApp = settings.Preview.ApplyFPSLimitToApp;
 		bool statusbar = settings.Preview.StatusBar;
-		float fpsLimit = settings.Preview.FPSLimit;
-		if (fpsLimit != m_fpsLimit) {
-			m_elapsedTime = 0;
-			m_fpsLimit = fpsLimit;
-		}
+		m_pacer.SetTarget(capWholeApp ? 0.0f : settings.Preview.FPSLimit); // the main loop paces the whole app
+
+		// connected to a remote renderer -> the local renderer stays idle and only the input goes out
+		RemoteClient& remote = RemoteClient::Instance();
+		remote.Update();
+		bool isRemote = remote.IsConnected();
 
-		ImVec2 imageSize = m_imgSize = ImVec2(ImGui::GetWindowContentRegionWidth(), abs(ImGui::GetWindowContentRegionMax().y - ImGui::GetWindowContentRegionMin().y - STATUSBAR_HEIGHT * statusbar));
+		bool cacheFrames = settings.Preview.FrameCacheSize > 0 && !isRemote;
+		bool timeline = statusbar && cacheFrames && !m_frameCache.IsEmpty();
+
+		ImVec2 imageSize = m_imgSize = ImVec2(ImGui::GetWindowContentRegionWidth(), abs(ImGui::GetWindowContentRegionMax().y - ImGui::GetWindowContentRegionMin().y - STATUSBAR_HEIGHT * statusbar - TIMELINE_HEIGHT * timeline));
 		ed::RenderEngine* renderer = &m_data->Renderer;
+
+		// frames that the timeline can show without rendering them again
+		if (cacheFrames) {
+			m_frameCache.SetBudget(settings.Preview.FrameCacheSize);
+			if (!m_frameCache.Validate(FrameCache::GetSignature(&m_data->Pipeline, renderer, m_renderSize))) {
+				// the shown frame is gone, it's rendered again with the new inputs
+				m_scrubTexture = 0;
+				m_scrubDirty = m_scrubFrame >= 0;
+			}
+		} else if (!m_frameCache.IsEmpty()) {
+			m_frameCache.Reset();
+			m_scrubTexture = 0;
+		}
+		if (!paused) {
+			m_scrubFrame = -1;
+			m_scrubDirty = false;
+			m_scrubTexture = 0;
+		}
 		
 		if (m_zoomLastSize.x != (int)imageSize.x || m_zoomLastSize.y != (int)imageSize.y) {
 			m_zoomLastSize.x = imageSize.x;
 			m_zoomLastSize.y = imageSize.y;
-			SystemVariableManager::Instance().SetViewportSize(imageSize.x, imageSize.y);
 
 			m_zoom.RebuildVBO(imageSize.x, imageSize.y);
 
 		}
 
+		m_readGPUTime();
+
+		// lower the resolution while the preview can't keep up, go back to the exact output once nothing is changing
+		if (settings.Preview.DynamicResolution && !paused && !isRemote && !renderer->CanReuseFrame())
+			m_updateRenderScale(delta);
+		else
+			m_renderScale = 1.0f;
+
+		glm::ivec2 renderSize = glm::max(glm::ivec2(imageSize.x * m_renderScale, imageSize.y * m_renderScale), glm::ivec2(1, 1));
+		if (renderSize != m_renderSize) {
+			// keep stretching the old frame while the panel is being dragged around - every new size reallocates the render targets
+			if (renderSize != m_resizeTarget) {
+				m_resizeTarget = renderSize;
+				m_resizeTime = 0.0f;
+			}
+			m_resizeTime += delta;
+
+			if (m_renderSize.x <= 0 || !ImGui::IsMouseDown(0) || m_resizeTime >= RESIZE_DEBOUNCE_TIME) {
+				m_renderSize = renderSize;
+				SystemVariableManager::Instance().SetViewportSize(renderSize.x, renderSize.y);
+			} else
+				UIRefresh::Instance().Request(RESIZE_DEBOUNCE_TIME * 1000);
+		}
+
+		// typing & dragging the widgets of the other windows come first - a heavy preview keeps showing its last frame for a while
+		m_sinceRender += delta;
+		bool editing = settings.Preview.EditorPriority && !m_hasFocus && (ImGui::GetIO().WantTextInput || ImGui::IsAnyItemActive());
+		float renderCost = std::max(m_gpuTime, m_cpuTime);
+		bool deferred = editing && !paused && !isRemote && renderCost > EDITOR_PRIORITY_COST && m_sinceRender < renderCost * EDITOR_PRIORITY_SPACING;
+		if (deferred)
+			UIRefresh::Instance().Request((int)((renderCost * EDITOR_PRIORITY_SPACING - m_sinceRender) * 1000) + 1);
+
 		m_fpsUpdateTime += delta;
-		m_elapsedTime += delta;
-		if (capWholeApp || m_fpsLimit <= 0 || m_elapsedTime >= 1.0f / m_fpsLimit) {
-			if (!paused)
-				renderer->Render(imageSize.x, imageSize.y);
-
-			float fps = m_fpsTimer.Restart();
-			if (m_fpsUpdateTime > FPS_UPDATE_RATE) {
-				m_fpsDelta = fps;
-				m_fpsUpdateTime -= FPS_UPDATE_RATE;
+		if (!deferred && m_pacer.Ready()) {
+			// a paused preview still renders the frame that RenderDoc should capture
+			if (isRemote)
+				remote.SendInput(m_renderSize, paused);
+			else if (!paused || RenderDocCapture::Instance().IsRequested()) {
+				if (m_costHeatmap)
+					renderer->RenderCostHeatmap(m_renderSize.x, m_renderSize.y);
+				else if (m_overdrawHeatmap)
+					renderer->RenderOverdrawHeatmap(m_renderSize.x, m_renderSize.y, m_overdrawHeatmap == 2);
+
+				bool measure = (settings.Preview.DynamicResolution || settings.Preview.EditorPriority) && !m_gpuQueryPending[m_gpuQueryIndex];
+				if (measure) {
+					if (m_gpuQueries[0] == 0)
+						glGenQueries(2, m_gpuQueries);
+					glBeginQuery(GL_TIME_ELAPSED, m_gpuQueries[m_gpuQueryIndex]);
+				}
+
+				// a replay overrides what the user does with the preview
+				InputRecorder& recorder = InputRecorder::Instance();
+				if (recorder.IsReplaying()) {
+					if (!recorder.ApplyNext(renderer, &m_data->Pipeline, &m_data->Objects))
+						recorder.StopReplay();
+				}
+				else if (recorder.IsRecording())
+					recorder.Capture(renderer, &m_data->Objects);
+
+				unsigned int frame = SystemVariableManager::Instance().GetFrameIndex();
+				float time = SystemVariableManager::Instance().GetTime();
+
+				auto renderStart = std::chrono::steady_clock::now();
+				renderer->Render(m_renderSize.x, m_renderSize.y);
+				float renderTime = std::chrono::duration<float>(std::chrono::steady_clock::now() - renderStart).count();
+				m_cpuTime = m_cpuTime * 0.8f + renderTime * 0.2f;
+				m_sinceRender = 0.0f;
+
+				if (cacheFrames && !paused) {
+					if (frame < m_lastCachedFrame)
+						m_frameCache.Reset(); // the time was reset
+					m_lastCachedFrame = frame;
+					m_frameCache.Store(frame, time, renderer->GetTexture(), m_renderSize);
+				}
+
+				if (measure) {
+					glEndQuery(GL_TIME_ELAPSED);
+					m_gpuQueryPending[m_gpuQueryIndex] = true;
+					m_gpuQueryIndex = 1 - m_gpuQueryIndex;
+				}
 			}
 
-			m_elapsedTime -= 1 / m_fpsLimit;
 		}
-		
-		if (capWholeApp && 1000 / delta > m_fpsLimit)
-			std::this_thread::sleep_for(std::chrono::milliseconds(1000 / (int)m_fpsLimit - (int)(1000 * delta)));
+
+		if (m_fpsUpdateTime > FPS_UPDATE_RATE) {
+			m_frameStats = m_pacer.GetStats();
+			m_fpsUpdateTime -= FPS_UPDATE_RATE;
+		}
 			
-		GLuint rtView = renderer->GetTexture();
+		if (m_scrubDirty && cacheFrames) {
+			m_scrubDirty = false;
+			m_showFrame(m_scrubFrame);
+		}
+
+		GLuint rtView = (isRemote && remote.GetTexture() != 0) ? remote.GetTexture() : renderer->GetOutputTexture();
+		if (m_scrubTexture != 0)
+			rtView = m_scrubTexture;
+
+		// smoother upscaling - Render() sets the filter back to GL_NEAREST when the size changes
+		if (m_renderScale < 1.0f) {
+			glBindTexture(GL_TEXTURE_2D, rtView);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glBindTexture(GL_TEXTURE_2D, 0);
+		}
 
 		// display the image on the imgui window
 		const glm::vec2& zPos = m_zoom.GetZoomPosition();
 		const glm::vec2& zSize = m_zoom.GetZoomSize();
 		ImGui::Image((void*)rtView, imageSize, ImVec2(zPos.x,zPos.y+zSize.y), ImVec2(zPos.x+zSize.x,zPos.y));
+		ImVec2 imagePos = ImGui::GetItemRectMin();
+		m_zoom.UpdateReadout(rtView);
+
+		if (m_costHeatmap && renderer->GetCostTexture() != 0) {
+			ImGui::SetCursorPosY(ImGui::GetWindowContentRegionMin().y);
+			ImGui::Image((void*)renderer->GetCostTexture(), imageSize, ImVec2(zPos.x, zPos.y + zSize.y), ImVec2(zPos.x + zSize.x, zPos.y), ImVec4(1, 1, 1, 0.75f));
+		}
+		else if (m_overdrawHeatmap && renderer->GetOverdrawTexture() != 0) {
+			ImGui::SetCursorPosY(ImGui::GetWindowContentRegionMin().y);
+			ImGui::Image((void*)renderer->GetOverdrawTexture(), imageSize, ImVec2(zPos.x, zPos.y + zSize.y), ImVec2(zPos.x + zSize.x, zPos.y), ImVec4(1, 1, 1, 0.75f));
+		}
 
 		m_hasFocus = ImGui::IsWindowFocused();
 
 
-		if (paused && m_zoomLastSize != renderer->GetLastRenderSize() && ((pixelList.size() > 0 && ((ImGui::IsMouseClicked(0) && ImGui::IsItemHovered()) || !pixelList[0].Fetched)) || (pixelList.size() == 0)))
-			renderer->Render(imageSize.x, imageSize.y);
+		if (paused && !isRemote && m_renderSize != renderer->GetLastRenderSize() && ((pixelList.size() > 0 && ((ImGui::IsMouseClicked(0) && ImGui::IsItemHovered()) || !pixelList[0].Fetched)) || (pixelList.size() == 0)))
+			renderer->Render(m_renderSize.x, m_renderSize.y);
 
 		// render the gizmo/bounding box/zoom area if necessary
 		if ((m_picks.size() != 0 && (settings.Preview.Gizmo || settings.Preview.BoundingBox)) ||
@@ -339,6 +469,10 @@ namespace ed
 			ImGui::Image((void*)m_overlayColor, imageSize, ImVec2(zPos.x, zPos.y + zSize.y), ImVec2(zPos.x + zSize.x, zPos.y));
 		}
 
+		m_zoom.RenderReadout(glm::vec2(imagePos.x, imagePos.y), glm::vec2(imageSize.x, imageSize.y));
+		if (FrameProfiler::Instance().ShowOverlay)
+			m_renderCPUOverlay(imagePos);
+
 		m_mousePos = glm::vec2((ImGui::GetMousePos().x - ImGui::GetCursorScreenPos().x - ImGui::GetScrollX()) / imageSize.x,
 				1.0f - (imageSize.y + (ImGui::GetMousePos().y - ImGui::GetCursorScreenPos().y - ImGui::GetScrollY())) / imageSize.y);
 		m_zoom.SetCurrentMousePosition(m_mousePos);
@@ -356,10 +490,10 @@ namespace ed
 			// update system variable mouse position value
 			if (ImGui::IsMouseDown(0)) {
 				glm::vec4 mbtnlast = SystemVariableManager::Instance().GetMouseButton();
-				SystemVariableManager::Instance().SetMouseButton(std::max<float>(0.0f, m_mousePos.x * imageSize.x), 
-																std::max<float>(0.0f, m_mousePos.y * imageSize.y),
-																std::max<float>(0.0f, m_lastButton.x * imageSize.x),
-																std::max<float>(0.0f, m_lastButton.y * imageSize.y));
+				SystemVariableManager::Instance().SetMouseButton(std::max<float>(0.0f, m_mousePos.x * m_renderSize.x), 
+																std::max<float>(0.0f, m_mousePos.y * m_renderSize.y),
+																std::max<float>(0.0f, m_lastButton.x * m_renderSize.x),
+																std::max<float>(0.0f, m_lastButton.y * m_renderSize.y));
 			}
 
 			SystemVariableManager::Instance().SetMousePosition(m_mousePos.x, m_mousePos.y);
@@ -604,9 +738,28 @@ namespace ed
 		}
 
 		// status bar
+		if (timeline)
+			m_renderTimeline(imageSize.x);
 		if (statusbar)
 			m_renderStatusbar(imageSize.x, imageSize.y);
 
+		// results of the area debugger
+		RegionDebugger* region = &m_data->DebugRegion;
+		region->Update();
+		if (paused && zPos == glm::vec2(0, 0) && zSize == glm::vec2(1, 1) && region->IsVisible() && pixelList.size() > 0) {
+			ImGui::SetCursorPosY(ImGui::GetWindowContentRegionMin().y);
+			ImVec2 uiPos = ImGui::GetCursorScreenPos();
+
+			const glm::ivec4& rect = region->GetRect();
+			glm::vec2 targetSize = region->GetTargetSize();
+			ImVec2 rectMin(uiPos.x + rect.x / targetSize.x * imageSize.x, uiPos.y + (1.0f - (rect.y + rect.w) / targetSize.y) * imageSize.y);
+			ImVec2 rectMax(uiPos.x + (rect.x + rect.z) / targetSize.x * imageSize.x, uiPos.y + (1.0f - rect.y / targetSize.y) * imageSize.y);
+
+			auto drawList = ImGui::GetWindowDrawList();
+			drawList->AddImage((ImTextureID)region->GetTexture(), rectMin, rectMax, ImVec2(0, 1), ImVec2(1, 0));
+			drawList->AddRect(rectMin, rectMax, 0xffffffff);
+		}
+
 		// debugger vertex outline
 		if (paused && zPos == glm::vec2(0,0) && zSize == glm::vec2(1, 1) && (!m_data->Debugger.IsDebugging() || m_data->Debugger.GetShaderStage() == sd::ShaderType::Vertex)) {
 			if (pixelList.size() > 0) {
@@ -694,22 +847,9 @@ namespace ed
 				data->Topology = origData->Topology;
 				data->Type = origData->Type;
 
-				if (data->Type == pipe::GeometryItem::GeometryType::Cube)
-					data->VAO = eng::GeometryFactory::CreateCube(data->VBO, data->Size.x, data->Size.y, data->Size.z, ownerData->InputLayout);
-				else if (data->Type == pipe::GeometryItem::Circle) {
-					data->VAO = eng::GeometryFactory::CreateCircle(data->VBO, data->Size.x, data->Size.y, ownerData->InputLayout);
+				GeometryCache::Instance().Create(data, ownerData->InputLayout);
+				if (data->Type == pipe::GeometryItem::Circle)
 					data->Topology = GL_TRIANGLE_STRIP;
-				}
-				else if (data->Type == pipe::GeometryItem::Plane)
-					data->VAO = eng::GeometryFactory::CreatePlane(data->VBO, data->Size.x, data->Size.y, ownerData->InputLayout);
-				else if (data->Type == pipe::GeometryItem::Rectangle)
-					data->VAO = eng::GeometryFactory::CreatePlane(data->VBO, 1, 1, ownerData->InputLayout);
-				else if (data->Type == pipe::GeometryItem::Sphere)
-					data->VAO = eng::GeometryFactory::CreateSphere(data->VBO, data->Size.x, ownerData->InputLayout);
-				else if (data->Type == pipe::GeometryItem::Triangle)
-					data->VAO = eng::GeometryFactory::CreateTriangle(data->VBO,  data->Size.x, ownerData->InputLayout);
-				else if (data->Type == pipe::GeometryItem::ScreenQuadNDC)
-					data->VAO = eng::GeometryFactory::CreateScreenQuadNDC(data->VBO, ownerData->InputLayout);
 				m_data->Pipeline.AddItem(owner, name.c_str(), item->Type, data);
 			}
 
@@ -724,6 +864,11 @@ namespace ed
 				data->Scale = origData->Scale;
 				data->Position = origData->Position;
 				data->Rotation = origData->Rotation;
+				data->LOD = origData->LOD;
+				data->FrustumCulling = origData->FrustumCulling;
+				data->GPUCulling = origData->GPUCulling;
+				strcpy(data->Animation, origData->Animation);
+				data->AnimationSpeed = origData->AnimationSpeed;
 
 
 				if (strlen(data->Filename) > 0) {
@@ -751,19 +896,226 @@ namespace ed
 				((PropertyUI*)m_ui->Get(ViewID::Properties))->Open(m_picks[m_picks.size()-1]);
 	}
 
+	void PreviewUI::m_readGPUTime()
+	{
+		// read the GPU time of the preview without waiting for it
+		for (int i = 0; i < 2; i++) {
+			if (!m_gpuQueryPending[i])
+				continue;
+
+			GLint available = 0;
+			glGetQueryObjectiv(m_gpuQueries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+			if (available) {
+				GLuint64 elapsed = 0;
+				glGetQueryObjectui64v(m_gpuQueries[i], GL_QUERY_RESULT, &elapsed);
+				m_gpuTime = m_gpuTime * 0.8f + (elapsed / 1e9f) * 0.2f;
+				m_gpuQueryPending[i] = false;
+			}
+		}
+	}
+	void PreviewUI::m_updateRenderScale(float delta)
+	{
+		// give the new resolution some time to show up in the measurements
+		m_renderScaleTime += delta;
+		if (m_renderScaleTime < RENDER_SCALE_INTERVAL || m_gpuTime <= 0.0f)
+			return;
+
+		// leave some of the frame to the UI
+		int fpsLimit = Settings::Instance().Preview.FPSLimit;
+		float budget = 0.8f / (fpsLimit > 0 ? fpsLimit : 60);
+
+		float scale = m_renderScale;
+		if (m_gpuTime > budget * 1.1f) {
+			// the cost goes with the number of pixels
+			scale = m_renderScale * sqrt(budget / m_gpuTime);
+			scale = std::max(MIN_RENDER_SCALE, floor(scale / RENDER_SCALE_STEP) * RENDER_SCALE_STEP);
+		}
+		else if (m_gpuTime < budget * 0.6f)
+			scale = std::min(1.0f, m_renderScale + RENDER_SCALE_STEP);
+
+		if (scale != m_renderScale) {
+			m_renderScale = scale;
+			m_renderScaleTime = 0.0f;
+		}
+	}
+	void PreviewUI::m_pause(bool pause)
+	{
+		m_data->Renderer.Pause(pause);
+		m_ui->StopDebugging();
+
+		auto& audioItems = m_data->Objects.GetItemDataList();
+		for (auto& audioItem : audioItems) {
+			if (audioItem->Sound != nullptr) {
+				if (pause)
+					audioItem->Sound->Pause();
+				else
+					audioItem->Sound->Play();
+			}
+		}
+	}
+	void PreviewUI::m_showFrame(unsigned int frame)
+	{
+		float time = 0.0f;
+		if (!m_frameCache.GetTime(frame, time))
+			return;
+
+		SystemVariableManager& systemVM = SystemVariableManager::Instance();
+		systemVM.AdvanceTimer(time - systemVM.GetTime());
+		systemVM.SetFrameIndex(frame);
+		m_lastCachedFrame = frame;
+
+		// a miss is rendered at the full resolution and cached for the next time
+		m_scrubTexture = m_frameCache.Get(frame);
+		if (m_scrubTexture == 0) {
+			m_data->Renderer.Render(m_renderSize.x, m_renderSize.y);
+			m_frameCache.Store(frame, time, m_data->Renderer.GetTexture(), m_renderSize);
+		}
+	}
+	void PreviewUI::m_renderTimeline(float width)
+	{
+		int first = m_frameCache.GetFirstFrame();
+		int last = m_frameCache.GetLastFrame();
+		int frame = m_scrubFrame >= 0 ? m_scrubFrame : (int)SystemVariableManager::Instance().GetFrameIndex();
+		frame = std::max(first, std::min(frame, last));
+
+		float time = 0.0f;
+		m_frameCache.GetTime(frame, time);
+		char format[64];
+		snprintf(format, 64, "frame %%d - %.2fs", time);
+
+		ImGui::PushItemWidth(width);
+		if (ImGui::SliderInt("##preview_timeline", &frame, first, last, format)) {
+			if (!m_data->Renderer.IsPaused())
+				m_pause(true);
+
+			m_scrubFrame = frame;
+			m_scrubDirty = true;
+		}
+		ImGui::PopItemWidth();
+
+		if (ImGui::IsItemHovered())
+			ImGui::SetTooltip("%d frames cached (%.1f MB), drag to scrub through the recently rendered frames", (int)m_frameCache.GetFrames().size(), m_frameCache.GetMemory() / (1024.0f * 1024.0f));
+
+		// mark the cached ranges under the slider - one rect per run of consecutive frames
+		ImVec2 rectMin = ImGui::GetItemRectMin();
+		ImVec2 rectMax = ImGui::GetItemRectMax();
+		float range = std::max(1, last - first);
+		float barWidth = rectMax.x - rectMin.x;
+		ImDrawList* drawList = ImGui::GetWindowDrawList();
+		ImU32 color = ImGui::GetColorU32(ImGuiCol_PlotHistogram);
+
+		const auto& frames = m_frameCache.GetFrames();
+		for (auto it = frames.begin(); it != frames.end();) {
+			unsigned int runStart = it->first, runEnd = it->first;
+			for (it++; it != frames.end() && it->first == runEnd + 1; it++)
+				runEnd = it->first;
+
+			float x0 = rectMin.x + std::max(0, (int)runStart - first) / range * barWidth;
+			float x1 = rectMin.x + ((int)runEnd + 1 - first) / range * barWidth;
+			drawList->AddRectFilled(ImVec2(x0, rectMax.y - 3 * Settings::Instance().DPIScale), ImVec2(std::max(x0 + 1.0f, std::min(x1, rectMax.x)), rectMax.y), color);
+		}
+	}
+	void PreviewUI::UpdateHidden(float delta)
+	{
+		RemoteClient& remote = RemoteClient::Instance();
+		remote.Update();
+
+		RenderEngine* renderer = &m_data->Renderer;
+		if (remote.IsConnected() || renderer->IsPaused() || !m_data->Messages.CanRenderPreview() || m_renderSize.x <= 0 || !m_pacer.Ready())
+			return;
+
+		if (Settings::Instance().Preview.RenderWhenHidden)
+			renderer->Render(m_renderSize.x, m_renderSize.y);
+		else if (renderer->HasBackgroundPasses())
+			renderer->RenderBackground(m_renderSize.x, m_renderSize.y);
+	}
+	void PreviewUI::m_renderCPUOverlay(const ImVec2& pos)
+	{
+		FrameProfiler& profiler = FrameProfiler::Instance();
+
+		std::vector<std::pair<std::string, float>> lines;
+		lines.push_back(std::make_pair("Frame", profiler.GetFrame().Average));
+		for (int i = 0; i < FrameProfiler::StageCount; i++)
+			if (profiler.Get(i).Max > 0.0f)
+				lines.push_back(std::make_pair(std::string(FrameProfiler::IsNested(i) ? "  " : "") + FrameProfiler::GetStageName(i), profiler.Get(i).Average));
+
+		// the slowest views
+		std::vector<FrameProfiler::View> views = profiler.GetViews();
+		std::sort(views.begin(), views.end(), [](const FrameProfiler::View& a, const FrameProfiler::View& b) {
+			return a.Time.Average > b.Time.Average;
+		});
+		for (int i = 0; i < views.size() && i < 3; i++)
+			lines.push_back(std::make_pair("  " + views[i].Name, views[i].Time.Average));
+
+		float dpi = Settings::Instance().DPIScale;
+		float lineHeight = ImGui::GetTextLineHeight();
+		ImVec2 start(pos.x + 5 * dpi, pos.y + 5 * dpi);
+		ImVec2 size(190 * dpi, lines.size() * lineHeight + 6 * dpi);
+
+		ImDrawList* drawList = ImGui::GetWindowDrawList();
+		drawList->AddRectFilled(start, ImVec2(start.x + size.x, start.y + size.y), IM_COL32(0, 0, 0, 160));
+		for (int i = 0; i < lines.size(); i++) {
+			char time[32];
+			snprintf(time, sizeof(time), "%.2f ms", lines[i].second);
+
+			ImVec2 linePos(start.x + 3 * dpi, start.y + 3 * dpi + i * lineHeight);
+			drawList->AddText(linePos, IM_COL32_WHITE, lines[i].first.c_str());
+			drawList->AddText(ImVec2(start.x + size.x - ImGui::CalcTextSize(time).x - 3 * dpi, linePos.y), IM_COL32_WHITE, time);
+		}
+	}
 	void PreviewUI::m_renderStatusbar(float width, float height)
 	{
-		float FPS = 1.0f / m_fpsDelta;
+		float FPS = m_frameStats.Mean > 0.0f ? 1.0f / m_frameStats.Mean : 0.0f;
 		ImGui::Separator();
 		ImGui::Text("FPS: %.2f", FPS);
+		if (ImGui::IsItemHovered() && m_frameStats.Samples > 0) {
+			ImGui::BeginTooltip();
+			ImGui::Text("Frame time (last %d frames)", m_frameStats.Samples);
+			ImGui::Text("mean: %.2f ms", m_frameStats.Mean * 1000.0f);
+			ImGui::Text("p50: %.2f ms", m_frameStats.P50 * 1000.0f);
+			ImGui::Text("p95: %.2f ms", m_frameStats.P95 * 1000.0f);
+			ImGui::Text("p99: %.2f ms", m_frameStats.P99 * 1000.0f);
+			ImGui::Text("max: %.2f ms", m_frameStats.Max * 1000.0f);
+			ImGui::TextDisabled("Click to open the frame time graph");
+			ImGui::EndTooltip();
+		}
+		if (ImGui::IsItemClicked())
+			m_ui->Get(ViewID::Profiler)->Visible = true;
 		ImGui::SameLine();
+		if (m_renderScale < 1.0f) {
+			ImGui::TextDisabled("%d%%", (int)(m_renderScale * 100));
+			ImGui::SameLine();
+		}
+		if (RemoteClient::Instance().IsConnected()) {
+			ImGui::TextDisabled("remote");
+			if (ImGui::IsItemHovered())
+				ImGui::SetTooltip("%s, %.1f ms between frames", RemoteClient::Instance().GetAddress().c_str(), RemoteClient::Instance().GetFrameTime());
+			ImGui::SameLine();
+		}
+		unsigned int samples = 0, sampleTarget = 0;
+		Accumulator& accumulator = m_data->Renderer.GetAccumulator();
+		if (accumulator.GetProgress(samples, sampleTarget)) {
+			if (sampleTarget == 0)
+				ImGui::TextDisabled("%u spp", samples);
+			else
+				ImGui::TextDisabled("%u/%u spp", samples, sampleTarget);
+			if (ImGui::IsItemHovered())
+				ImGui::SetTooltip("Samples averaged by the accumulating passes (the least converged one), click to start over");
+			if (ImGui::IsItemClicked())
+				accumulator.Reset();
+			ImGui::SameLine();
+		}
 
 		ImGui::SameLine(120 * Settings::Instance().DPIScale);
 		ImGui::Text("Time: %.2f", SystemVariableManager::Instance().GetTime());
 		ImGui::SameLine();
 
 		ImGui::SameLine(240 * Settings::Instance().DPIScale);
-		ImGui::Text("Zoom: %d%%", (int)((1.0f/m_zoom.GetZoomSize().x)*100.0f));
+		ImGui::Text("Zoom: %d%%%s", (int)((1.0f/m_zoom.GetZoomSize().x)*100.0f), m_zoom.IsReadoutEnabled() ? " (values)" : "");
+		if (ImGui::IsItemHovered())
+			ImGui::SetTooltip("Click to show the values of the zoomed pixels");
+		if (ImGui::IsItemClicked())
+			m_zoom.SetReadout(!m_zoom.IsReadoutEnabled());
 		ImGui::SameLine();
 
 		ImGui::SameLine(340 * Settings::Instance().DPIScale);
@@ -791,6 +1143,54 @@ namespace ed
 		else if (m_pickMode == 2) ImGui::PopStyleColor();
 		ImGui::SameLine();
 
+		// loop cost heatmap
+		bool costHeatmap = m_costHeatmap;
+		if (costHeatmap) ImGui::PushStyleColor(ImGuiCol_Button, ImVec4(0, 0, 0, 0));
+		bool toggleHeatmap = ImGui::Button("C##costHeatmap", ImVec2(BUTTON_SIZE, BUTTON_SIZE));
+		if (costHeatmap) ImGui::PopStyleColor();
+		if (ImGui::IsItemHovered())
+			ImGui::SetTooltip("Loop iterations per pixel (max: %d)", m_data->Renderer.GetCostMax());
+		if (toggleHeatmap) {
+			m_costHeatmap = !m_costHeatmap;
+			m_overdrawHeatmap = 0;
+
+			// the preview isn't rendered again while paused
+			if (m_costHeatmap && m_data->Renderer.IsPaused()) {
+				m_data->Renderer.RenderCostHeatmap();
+				m_data->Renderer.Render();
+			}
+		}
+		ImGui::SameLine();
+
+		// overdraw heatmap -> quad efficiency heatmap -> off
+		int overdrawHeatmap = m_overdrawHeatmap;
+		if (overdrawHeatmap) ImGui::PushStyleColor(ImGuiCol_Button, ImVec4(0, 0, 0, 0));
+		bool toggleOverdraw = ImGui::Button(overdrawHeatmap == 2 ? "Q##overdrawHeatmap" : "O##overdrawHeatmap", ImVec2(BUTTON_SIZE, BUTTON_SIZE));
+		if (overdrawHeatmap) ImGui::PopStyleColor();
+		if (ImGui::IsItemHovered()) {
+			if (overdrawHeatmap == 2 && m_data->Renderer.GetQuadEfficiency() >= 0.0f)
+				ImGui::SetTooltip("Helper lanes of partially covered 2x2 quads (quad efficiency: %.1f%%)", m_data->Renderer.GetQuadEfficiency() * 100.0f);
+			else
+				ImGui::SetTooltip("Fragments shaded per pixel of the passes that draw to the window (max: %d)", m_data->Renderer.GetOverdrawMax());
+		}
+		if (toggleOverdraw) {
+			m_overdrawHeatmap = (m_overdrawHeatmap + 1) % (GLEW_VERSION_4_5 ? 3 : 2);
+			m_costHeatmap = false;
+
+			if (m_overdrawHeatmap && m_data->Renderer.IsPaused()) {
+				m_data->Renderer.RenderOverdrawHeatmap(m_overdrawHeatmap == 2);
+				m_data->Renderer.Render();
+			}
+		}
+		ImGui::SameLine();
+
+		// textures of a project that was just opened are still decoded in the background
+		if (m_data->Objects.IsLoading()) {
+			ImGui::SameLine(0, 20*Settings::Instance().DPIScale);
+			ImGui::TextDisabled("Loading %d textures", m_data->Objects.GetLoadingCount());
+			ImGui::SameLine();
+		}
+
 		if (m_picks.size() != 0) {
 			ImGui::SameLine(0, 20*Settings::Instance().DPIScale);
 			ImGui::Text("Picked: ");
@@ -821,20 +1221,8 @@ namespace ed
 		else
 			ImGui::SetCursorPosX(pauseStartX);
 
-		if (ImGui::Button(m_data->Renderer.IsPaused() ? UI_ICON_PLAY : UI_ICON_PAUSE, ImVec2(ICON_BUTTON_WIDTH, BUTTON_SIZE))) {
-			m_data->Renderer.Pause(!m_data->Renderer.IsPaused());
-			m_ui->StopDebugging();
-
-			auto& audioItems = m_data->Objects.GetItemDataList();
-			for (auto& audioItem : audioItems) {
-				if (audioItem->Sound != nullptr) {
-					if (m_data->Renderer.IsPaused())
-						audioItem->Sound->pause();
-					else
-						audioItem->Sound->play();
-				}
-			}
-		}
+		if (ImGui::Button(m_data->Renderer.IsPaused() ? UI_ICON_PLAY : UI_ICON_PAUSE, ImVec2(ICON_BUTTON_WIDTH, BUTTON_SIZE)))
+			m_pause(!m_data->Renderer.IsPaused());
 
 		ImGui::SameLine(0,BUTTON_INDENT);
 		if (ImGui::Button(UI_ICON_NEXT, ImVec2(ICON_BUTTON_WIDTH, BUTTON_SIZE)) &&
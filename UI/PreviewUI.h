@@ -2,6 +2,8 @@
 #include "UIView.h"
 #include "../Objects/GizmoObject.h"
 #include "Tools/Magnifier.h"
+#include "../Engine/FramePacer.h"
+#include "../Objects/FrameCache.h"
 
 #include <imgui/imgui.h>
 #include <imgui/imgui_internal.h>
@@ -14,20 +16,37 @@ namespace ed
 		PreviewUI(GUIManager* ui, ed::InterfaceManager* objects, const std::string& name = "", bool visible = true) :
 			UIView(ui, objects, name, visible),
 			m_pickMode(0),
-			m_fpsDelta(0.0f),
 			m_fpsUpdateTime(0.0f),
 			m_pos1(0,0,0), m_pos2(0,0,0),
 			m_overlayFBO(0), m_overlayColor(0), m_overlayDepth(0),
 			m_lastSize(-1, -1) {
 			m_setupShortcuts();
 			m_setupBoundingBox();
-			m_fpsLimit = m_elapsedTime = 0;
 			m_hasFocus = false;
 			m_startWrap = false;
 			m_mouseHovers = false;
 			m_lastButtonUpdate = false;
+			m_renderScale = 1.0f;
+			m_renderScaleTime = 0.0f;
+			m_renderSize = glm::ivec2(-1, -1);
+			m_resizeTarget = glm::ivec2(-1, -1);
+			m_resizeTime = 0.0f;
+			m_gpuQueries[0] = m_gpuQueries[1] = 0;
+			m_gpuQueryPending[0] = m_gpuQueryPending[1] = false;
+			m_gpuQueryIndex = 0;
+			m_gpuTime = 0.0f;
+			m_cpuTime = 0.0f;
+			m_sinceRender = 0.0f;
+			m_costHeatmap = false;
+			m_overdrawHeatmap = 0;
+			m_scrubFrame = -1;
+			m_scrubDirty = false;
+			m_scrubTexture = 0;
+			m_lastCachedFrame = 0;
 		}
 		~PreviewUI() {
+			if (m_gpuQueries[0] != 0)
+				glDeleteQueries(2, m_gpuQueries);
 			glDeleteBuffers(1, &m_boxVBO);
 			glDeleteVertexArrays(1, &m_boxVAO);
 			glDeleteShader(m_boxShader);
@@ -35,6 +54,7 @@ namespace ed
 
 		virtual void OnEvent(const SDL_Event& e);
 		virtual void Update(float delta);
+		void UpdateHidden(float delta); // instead of Update() while the preview can't be seen
 
 		void Duplicate();
 		void Pick(PipelineItem* item, bool add = false);
@@ -44,6 +64,9 @@ namespace ed
 		void m_setupShortcuts();
 
 		void m_renderStatusbar(float width, float height);
+		void m_renderCPUOverlay(const ImVec2& pos); // FrameProfiler's breakdown
+		void m_renderTimeline(float width);
+		void m_pause(bool pause); // also pauses the audio
 		
 		void m_setupBoundingBox();
 		void m_buildBoundingBox();
@@ -66,8 +89,8 @@ namespace ed
 
 		glm::vec3 m_pos1, m_pos2;
 
-		eng::Timer m_fpsTimer;
-		float m_fpsDelta;
+		eng::FramePacer m_pacer; // FPSLimit when it isn't applied to the whole app, frame time statistics
+		eng::FramePacer::Stats m_frameStats;
 		float m_fpsUpdateTime; // check if 0.5s passed then update the fps widget
 
 		GLuint m_overlayFBO, m_overlayColor, m_overlayDepth;
@@ -75,11 +98,35 @@ namespace ed
 		bool m_hasFocus;
 		bool m_mouseHovers;
 
-		float m_elapsedTime;
-		float m_fpsLimit;
+		// dynamic resolution - the preview is rendered at m_renderScale * panel size and stretched
+		float m_renderScale;
+		float m_renderScaleTime; // time since the scale last changed
+		glm::ivec2 m_renderSize;
+		glm::ivec2 m_resizeTarget; // panel size that m_renderSize will switch to once it stops changing
+		float m_resizeTime;
+		GLuint m_gpuQueries[2];
+		bool m_gpuQueryPending[2];
+		int m_gpuQueryIndex;
+		float m_gpuTime; // smoothed GPU time of the preview, in seconds
+		void m_readGPUTime();
+		void m_updateRenderScale(float delta);
+
+		// editor priority - the preview waits for a multiple of its cost between two frames while the user edits something
+		float m_cpuTime; // smoothed time that Render() blocks for, in seconds
+		float m_sinceRender;
+
+		// timeline - the recently rendered frames are shown from the frame cache while scrubbing
+		FrameCache m_frameCache;
+		int m_scrubFrame; // -1 -> not scrubbing
+		bool m_scrubDirty; // m_scrubFrame has to be shown
+		GLuint m_scrubTexture; // cached frame that is shown instead of the preview, 0 -> the preview
+		unsigned int m_lastCachedFrame;
+		void m_showFrame(unsigned int frame);
 
 		std::vector<PipelineItem*> m_picks;
 		int m_pickMode; // 0 = position, 1 = scale, 2 = rotation
+		bool m_costHeatmap; // loop iteration heatmap over the preview
+		int m_overdrawHeatmap; // 0 = off, 1 = fragments per pixel, 2 = helper lanes of partially covered quads
 
 		// bounding box
 		GLuint m_boxShader, m_boxVAO, m_boxVBO;
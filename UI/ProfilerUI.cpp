@@ -0,0 +1,725 @@
+#include "ProfilerUI.h"
+#include "CodeEditorUI.h"
+#include "UIHelper.h"
+#include "../GUIManager.h"
+#include "../Objects/Settings.h"
+#include "../Objects/ReloadProfiler.h"
+#include "../Objects/FrameProfiler.h"
+#include "../Objects/PluginAPI/PluginProfiler.h"
+#include <imgui/imgui.h>
+#include <imgui/imgui_internal.h>
+#include <algorithm>
+#include <unordered_map>
+#include <math.h>
+#include <stdio.h>
+
+namespace ed
+{
+	void ProfilerUI::OnEvent(const SDL_Event& e)
+	{}
+	void ProfilerUI::Update(float delta)
+	{
+		GPUProfiler& profiler = m_data->Renderer.GetProfiler();
+		std::vector<PipelineItem*>& passes = m_data->Pipeline.GetList();
+
+		if (ImGui::Button("Reset##profiler_reset"))
+			profiler.ResetStats();
+		ImGui::SameLine();
+
+		// total GPU time of all the passes
+		float total = 0.0f;
+		for (PipelineItem* pass : passes)
+			if (profiler.Has(pass))
+				total += profiler.Get(pass).Average;
+		ImGui::Text("GPU frame time: %.3f ms", total);
+
+		// memory used by the render textures - depth & multisampled attachments are shared between rts
+		const RenderTargetPool::Stats& rtStats = m_data->Renderer.GetRenderTargetStats();
+		ImGui::Text("Render texture memory: %.2f MB (attachments: %.2f MB, %.2f MB without sharing)",
+			(rtStats.Dedicated + rtStats.Allocated) / (1024.0f * 1024.0f),
+			rtStats.Allocated / (1024.0f * 1024.0f),
+			rtStats.Requested / (1024.0f * 1024.0f));
+
+		if (m_data->Renderer.IsPaused())
+			ImGui::TextDisabled("Preview is paused - timings are not updated.");
+		if (!GLEW_ARB_pipeline_statistics_query)
+			ImGui::TextDisabled("GL_ARB_pipeline_statistics_query isn't supported - the passes' counters are not available.");
+
+		ImGui::Separator();
+
+		if (ImGui::CollapsingHeader("Frame times##profiler_frametimes", ImGuiTreeNodeFlags_DefaultOpen)) {
+			m_renderFrameTimes();
+			ImGui::Separator();
+		}
+		if (ImGui::CollapsingHeader("CPU frame##profiler_cpu")) {
+			m_renderCPUFrame();
+			ImGui::Separator();
+		}
+		if (ImGui::CollapsingHeader("A/B comparison##profiler_compare")) {
+			m_renderComparison();
+			ImGui::Separator();
+		}
+		if (ImGui::CollapsingHeader("Work group size##profiler_tune")) {
+			m_renderTuner();
+			ImGui::Separator();
+		}
+		if (ImGui::CollapsingHeader("Hot reload##profiler_reload")) {
+			m_renderReloads();
+			ImGui::Separator();
+		}
+		if (!m_data->Plugins.Plugins().empty() && ImGui::CollapsingHeader("Plugins##profiler_plugins")) {
+			m_renderPlugins();
+			ImGui::Separator();
+		}
+
+		ImGui::BeginChild("##profiler_container", ImVec2(-1, -1));
+
+		ImGui::Columns(9);
+		ImGui::SetColumnWidth(0, 200.0f * Settings::Instance().DPIScale);
+
+		ImGui::Text("Item"); ImGui::NextColumn();
+		ImGui::Text("Last (ms)"); ImGui::NextColumn();
+		ImGui::Text("Min"); ImGui::NextColumn();
+		ImGui::Text("Avg"); ImGui::NextColumn();
+		ImGui::Text("Max"); ImGui::NextColumn();
+		ImGui::Text("Vertices"); ImGui::NextColumn();
+		ImGui::Text("Primitives"); ImGui::NextColumn();
+		ImGui::Text("Fragments"); ImGui::NextColumn();
+		ImGui::Text("Compute"); ImGui::NextColumn();
+		ImGui::Separator();
+
+		for (PipelineItem* pass : passes) {
+			m_renderRow(pass, 0);
+
+			std::vector<PipelineItem*>* children = nullptr;
+			if (pass->Type == PipelineItem::ItemType::ShaderPass)
+				children = &((pipe::ShaderPass*)pass->Data)->Items;
+			else if (pass->Type == PipelineItem::ItemType::PluginItem)
+				children = &((pipe::PluginItemData*)pass->Data)->Items;
+			
+			if (children != nullptr)
+				for (PipelineItem* child : *children)
+					if (child->Type != PipelineItem::ItemType::RenderState)
+						m_renderRow(child, 1);
+		}
+
+		ImGui::Columns(1);
+		ImGui::EndChild();
+	}
+	void ProfilerUI::m_renderComparison()
+	{
+		RenderEngine& renderer = m_data->Renderer;
+		ShaderComparison& compare = renderer.GetComparison();
+		std::vector<PipelineItem*>& passes = m_data->Pipeline.GetList();
+
+		// the pass could've been deleted in the meantime
+		if (m_comparePass != nullptr && std::count(passes.begin(), passes.end(), m_comparePass) == 0)
+			m_selectComparePass(nullptr);
+
+		bool active = compare.IsActive();
+
+		if (active)
+			ImGui::PushItemFlag(ImGuiItemFlags_Disabled, true);
+
+		if (ImGui::BeginCombo("Pass##profiler_cmp_pass", m_comparePass ? m_comparePass->Name : "")) {
+			for (PipelineItem* pass : passes)
+				if (pass->Type == PipelineItem::ItemType::ShaderPass && ImGui::Selectable(pass->Name, pass == m_comparePass))
+					m_selectComparePass(pass);
+			ImGui::EndCombo();
+		}
+
+		ImGui::Text("Version B:");
+		ImGui::SameLine();
+		ImGui::RadioButton("Macros##profiler_cmp_mode", &m_compareMode, 0);
+		ImGui::SameLine();
+		ImGui::RadioButton("Other pixel shader##profiler_cmp_mode", &m_compareMode, 1);
+		ImGui::SameLine();
+		ImGui::RadioButton("Unsaved changes##profiler_cmp_mode", &m_compareMode, 2);
+
+		if (m_compareMode == 0) {
+			for (int i = 0; i < m_compareMacros.size(); i++) {
+				ShaderMacro& macro = m_compareMacros[i];
+				ImGui::PushID(i);
+				ImGui::Checkbox("##profiler_cmp_mactive", &macro.Active);
+				ImGui::SameLine();
+				ImGui::Text("%s", macro.Name);
+				ImGui::SameLine();
+				ImGui::PushItemWidth(150.0f * Settings::Instance().DPIScale);
+				ImGui::InputText("##profiler_cmp_mvalue", macro.Value, 512);
+				ImGui::PopItemWidth();
+				ImGui::PopID();
+			}
+			if (m_compareMacros.empty())
+				ImGui::TextDisabled("The pass doesn't have any macros.");
+		}
+		else if (m_compareMode == 1) {
+			ImGui::Text("%s", m_comparePath.empty() ? "(no file selected)" : m_comparePath.c_str());
+			ImGui::SameLine();
+			if (ImGui::Button("...##profiler_cmp_path")) {
+				std::string file;
+				if (UIHelper::GetOpenFileDialog(file))
+					m_comparePath = m_data->Parser.GetRelativePath(file);
+			}
+		}
+		else
+			ImGui::TextDisabled("The text in the pass' pixel shader editor is compared with the file on the disk.");
+
+		if (active)
+			ImGui::PopItemFlag();
+
+		if (!active) {
+			if (ImGui::Button("Start##profiler_cmp_start") && m_comparePass != nullptr) {
+				pipe::ShaderPass* data = (pipe::ShaderPass*)m_comparePass->Data;
+				std::string path, source;
+				std::vector<ShaderMacro> macros = data->Macros;
+
+				m_compareError = "";
+				if (m_compareMode == 0)
+					macros = m_compareMacros;
+				else if (m_compareMode == 1) {
+					path = m_comparePath;
+					if (path.empty())
+						m_compareError = "Select the pixel shader that the pass should be compared with.";
+				}
+				else {
+					TextEditor* editor = ((CodeEditorUI*)m_ui->Get(ViewID::Code))->GetPS(m_comparePass);
+					if (editor == nullptr)
+						m_compareError = "Open the pass' pixel shader in the code editor first.";
+					else
+						source = editor->GetText();
+				}
+
+				if (m_compareError.empty())
+					renderer.StartComparison(m_comparePass, macros, path, source, m_compareError);
+			}
+		}
+		else {
+			if (ImGui::Button("Stop##profiler_cmp_stop"))
+				renderer.StopComparison();
+			ImGui::SameLine();
+			if (ImGui::Button("Reset##profiler_cmp_reset"))
+				compare.ResetStats();
+		}
+
+		if (!m_compareError.empty())
+			ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "%s", m_compareError.c_str());
+
+		if (!compare.IsActive())
+			return;
+
+		const ShaderComparison::Stats& a = compare.Get(0);
+		const ShaderComparison::Stats& b = compare.Get(1);
+		ImGui::Text("A: %.4f ms (sd %.4f, n = %d)", a.Mean, a.StdDev, a.Samples);
+		ImGui::Text("B: %.4f ms (sd %.4f, n = %d)", b.Mean, b.StdDev, b.Samples);
+
+		// the difference only counts once the confidence interval doesn't contain zero
+		float ci95 = 0.0f;
+		float diff = compare.GetDifference(ci95);
+		float percent = a.Mean > 0.0f ? diff / a.Mean * 100.0f : 0.0f;
+		bool significant = a.Samples > 1 && b.Samples > 1 && fabsf(diff) > ci95;
+		ImVec4 color = !significant ? ImGui::GetStyleColorVec4(ImGuiCol_TextDisabled) : (diff < 0.0f ? ImVec4(0.3f, 1.0f, 0.3f, 1.0f) : ImVec4(1.0f, 0.3f, 0.3f, 1.0f));
+		ImGui::TextColored(color, "B - A: %+.4f ms +- %.4f (%+.1f%%)%s", diff, ci95, percent, significant ? "" : " - not significant");
+
+		float gain = compare.GetDiffGain();
+		ImGui::PushItemWidth(150.0f * Settings::Instance().DPIScale);
+		if (ImGui::SliderFloat("Difference gain##profiler_cmp_gain", &gain, 1.0f, 100.0f, "%.1f", 2.0f))
+			compare.SetDiffGain(gain);
+		ImGui::PopItemWidth();
+
+		glm::ivec2 size = compare.GetDiffSize();
+		if (compare.GetDiffTexture() != 0 && size.x > 0 && size.y > 0) {
+			float width = std::min<float>(ImGui::GetContentRegionAvail().x, 320.0f * Settings::Instance().DPIScale);
+			ImGui::Image((ImTextureID)compare.GetDiffTexture(), ImVec2(width, width * size.y / size.x), ImVec2(0, 1), ImVec2(1, 0));
+		}
+	}
+	void ProfilerUI::m_renderTuner()
+	{
+		RenderEngine& renderer = m_data->Renderer;
+		WorkGroupTuner& tuner = renderer.GetTuner();
+		std::vector<PipelineItem*>& passes = m_data->Pipeline.GetList();
+
+		if (m_tunePass != nullptr && std::count(passes.begin(), passes.end(), m_tunePass) == 0)
+			m_tunePass = nullptr;
+
+		bool running = tuner.IsRunning();
+
+		if (running)
+			ImGui::PushItemFlag(ImGuiItemFlags_Disabled, true);
+		if (ImGui::BeginCombo("Pass##profiler_tune_pass", m_tunePass ? m_tunePass->Name : "")) {
+			for (PipelineItem* pass : passes)
+				if (pass->Type == PipelineItem::ItemType::ComputePass && ImGui::Selectable(pass->Name, pass == m_tunePass))
+					m_tunePass = pass;
+			ImGui::EndCombo();
+		}
+		if (running)
+			ImGui::PopItemFlag();
+
+		ImGui::TextDisabled("The shader has to use LOCAL_SIZE_X, LOCAL_SIZE_Y and LOCAL_SIZE_Z in its layout (or numthreads).\nThe candidates run after the pass each frame & write to the same objects.");
+
+		if (!running) {
+			if (ImGui::Button("Start##profiler_tune_start") && m_tunePass != nullptr) {
+				m_tuneError = "";
+				renderer.StartTuning(m_tunePass, m_tuneError);
+			}
+		} else {
+			if (ImGui::Button("Stop##profiler_tune_stop"))
+				renderer.StopTuning();
+			ImGui::SameLine();
+			ImGui::ProgressBar(tuner.GetProgress(), ImVec2(150.0f * Settings::Instance().DPIScale, 0));
+			if (renderer.IsPaused())
+				ImGui::TextDisabled("Preview is paused - the candidates are not measured.");
+		}
+
+		if (!m_tuneError.empty())
+			ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "%s", m_tuneError.c_str());
+		if (!tuner.GetError().empty())
+			ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "%s", tuner.GetError().c_str());
+
+		if (!tuner.IsActive() || tuner.GetPass() != m_tunePass)
+			return;
+
+		std::vector<WorkGroupTuner::Candidate>& cands = tuner.GetCandidates();
+		int best = tuner.GetBest();
+		float current = 0.0f;
+		for (const auto& cand : cands)
+			if (cand.Current)
+				current = cand.Time;
+
+		if (!running && tuner.GetError().empty() && best >= 0 && !cands[best].Current) {
+			if (ImGui::Button("Apply fastest##profiler_tune_apply")) {
+				renderer.ApplyTuning(best);
+				m_data->Parser.ModifyProject();
+				return;
+			}
+		}
+
+		ImGui::Columns(4);
+		ImGui::Text("Local size"); ImGui::NextColumn();
+		ImGui::Text("Groups"); ImGui::NextColumn();
+		ImGui::Text("Time (ms)"); ImGui::NextColumn();
+		ImGui::Text("vs current"); ImGui::NextColumn();
+		ImGui::Separator();
+
+		for (int i = 0; i < cands.size(); i++) {
+			const WorkGroupTuner::Candidate& cand = cands[i];
+			ImVec4 color = i == best ? ImVec4(0.3f, 1.0f, 0.3f, 1.0f) : ImGui::GetStyleColorVec4(ImGuiCol_Text);
+
+			ImGui::TextColored(color, "%u x %u x %u%s", cand.Size.x, cand.Size.y, cand.Size.z, cand.Current ? " (current)" : "");
+			ImGui::NextColumn();
+			ImGui::Text("%u x %u x %u", cand.Groups.x, cand.Groups.y, cand.Groups.z);
+			ImGui::NextColumn();
+			if (!cand.Error.empty()) {
+				ImGui::TextDisabled("doesn't compile");
+				if (ImGui::IsItemHovered())
+					ImGui::SetTooltip("%s", cand.Error.c_str());
+			} else if (cand.Time > 0.0f)
+				ImGui::Text("%.4f", cand.Time);
+			else
+				ImGui::TextDisabled("-");
+			ImGui::NextColumn();
+			if (cand.Time > 0.0f && current > 0.0f)
+				ImGui::Text("%+.1f%%", (cand.Time - current) / current * 100.0f);
+			ImGui::NextColumn();
+		}
+		ImGui::Columns(1);
+	}
+	void ProfilerUI::m_renderReloads()
+	{
+		ReloadProfiler& reload = ReloadProfiler::Instance();
+		std::deque<ReloadProfiler::Entry> history = reload.GetHistory();
+
+		if (ImGui::Button("Clear##profiler_reload_clear"))
+			reload.ClearHistory();
+		ImGui::SameLine();
+
+		if (history.empty()) {
+			ImGui::TextDisabled("Edit or save a shader to measure the time until its first frame.");
+			return;
+		}
+
+		float avg = 0.0f;
+		for (const auto& entry : history)
+			avg += entry.Total;
+		ImGui::Text("Last: %.2f ms, average of %d: %.2f ms", history[0].Total, (int)history.size(), avg / history.size());
+
+		ImGui::BeginChild("##profiler_reload_list", ImVec2(-1, 150.0f * Settings::Instance().DPIScale));
+		ImGui::Columns(3 + ReloadProfiler::StepCount);
+		ImGui::SetColumnWidth(0, 150.0f * Settings::Instance().DPIScale);
+
+		ImGui::Text("Item"); ImGui::NextColumn();
+		ImGui::Text("Trigger"); ImGui::NextColumn();
+		ImGui::Text("Total (ms)"); ImGui::NextColumn();
+		for (int i = 0; i < ReloadProfiler::StepCount; i++) {
+			ImGui::Text("%s", ReloadProfiler::GetStepName(i));
+			ImGui::NextColumn();
+		}
+		ImGui::Separator();
+
+		for (const auto& entry : history) {
+			ImGui::Text("%s", entry.Item.c_str()); ImGui::NextColumn();
+			if (entry.Cached)
+				ImGui::Text("%s (cached)", entry.Trigger.c_str());
+			else
+				ImGui::Text("%s", entry.Trigger.c_str());
+			ImGui::NextColumn();
+			ImGui::Text("%.2f", entry.Total); ImGui::NextColumn();
+			for (int i = 0; i < ReloadProfiler::StepCount; i++) {
+				ImGui::Text("%.2f", entry.Time[i]);
+				ImGui::NextColumn();
+			}
+		}
+
+		ImGui::Columns(1);
+		ImGui::EndChild();
+	}
+	void ProfilerUI::m_renderPlugins()
+	{
+		PluginProfiler& plProfiler = PluginProfiler::Instance();
+		GPUProfiler& profiler = m_data->Renderer.GetProfiler();
+		std::vector<PipelineItem*>& passes = m_data->Pipeline.GetList();
+		const std::vector<IPlugin*>& plugins = m_data->Plugins.Plugins();
+
+		// GPU time of the items that the plugin executes
+		std::unordered_map<IPlugin*, float> gpuTime;
+		for (PipelineItem* pass : passes) {
+			if (pass->Type == PipelineItem::ItemType::PluginItem && profiler.Has(pass))
+				gpuTime[((pipe::PluginItemData*)pass->Data)->Owner] += profiler.Get(pass).Average;
+			else if (pass->Type == PipelineItem::ItemType::ShaderPass) {
+				for (PipelineItem* child : ((pipe::ShaderPass*)pass->Data)->Items)
+					if (child->Type == PipelineItem::ItemType::PluginItem && profiler.Has(child))
+						gpuTime[((pipe::PluginItemData*)child->Data)->Owner] += profiler.Get(child).Average;
+			}
+		}
+
+		if (ImGui::Button("Reset##profiler_plugins_reset"))
+			plProfiler.ResetStats();
+		if (Settings::Instance().Plugins.Budget > 0.0f) {
+			ImGui::SameLine();
+			ImGui::Text("Budget: %.2f ms", Settings::Instance().Plugins.Budget);
+		}
+
+		ImGui::BeginChild("##profiler_plugins_list", ImVec2(-1, 150.0f * Settings::Instance().DPIScale));
+		ImGui::Columns(4);
+		ImGui::SetColumnWidth(0, 150.0f * Settings::Instance().DPIScale);
+
+		ImGui::Text("Plugin"); ImGui::NextColumn();
+		ImGui::Text("CPU avg (ms)"); ImGui::NextColumn();
+		ImGui::Text("CPU max"); ImGui::NextColumn();
+		ImGui::Text("GPU avg"); ImGui::NextColumn();
+		ImGui::Separator();
+
+		for (IPlugin* plugin : plugins) {
+			if (!plProfiler.Has(plugin))
+				continue;
+
+			const PluginProfiler::Stats& stats = plProfiler.Get(plugin);
+			if (stats.OverBudget)
+				ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "%s", m_data->Plugins.GetPluginName(plugin).c_str());
+			else
+				ImGui::Text("%s", m_data->Plugins.GetPluginName(plugin).c_str());
+			ImGui::NextColumn();
+
+			ImGui::Text("%.3f", stats.Total);
+			if (ImGui::IsItemHovered()) {
+				ImGui::BeginTooltip();
+				for (int i = 0; i < PluginProfiler::CallCount; i++)
+					ImGui::Text("%s: %.3f ms (%d calls)", PluginProfiler::GetCallName(i), stats.Average[i], stats.Calls[i]);
+				ImGui::EndTooltip();
+			}
+			ImGui::NextColumn();
+
+			ImGui::Text("%.3f", stats.Max); ImGui::NextColumn();
+
+			auto gpu = gpuTime.find(plugin);
+			if (gpu != gpuTime.end())
+				ImGui::Text("%.3f", gpu->second);
+			else
+				ImGui::TextDisabled("-");
+			ImGui::NextColumn();
+		}
+
+		ImGui::Columns(1);
+		ImGui::EndChild();
+	}
+	void ProfilerUI::m_selectComparePass(PipelineItem* pass)
+	{
+		m_comparePass = pass;
+		m_compareMacros.clear();
+
+		if (pass != nullptr)
+			m_compareMacros = ((pipe::ShaderPass*)pass->Data)->Macros;
+	}
+	void ProfilerUI::m_renderFrameTimes()
+	{
+		FrameTimeline& timeline = m_data->Renderer.GetTimeline();
+		FrameTimeline::Stats stats = timeline.GetStats();
+		std::vector<int> worst = timeline.GetWorst();
+		int count = timeline.GetCount();
+
+		if (ImGui::Button("Clear##profiler_frametimes_clear")) {
+			timeline.Clear();
+			m_hasFrame = false;
+			count = 0;
+			worst.clear();
+		}
+		ImGui::SameLine();
+		ImGui::Text("p50: %.2f ms  p95: %.2f ms  p99: %.2f ms  worst: %.2f ms", stats.P50, stats.P95, stats.P99, stats.Max);
+		if (!m_data->Renderer.GetProfiler().IsEnabled())
+			ImGui::TextDisabled("The pass timings are only recorded while the profiler is open.");
+
+		// one bar per frame, the newest one on the right
+		float dpi = Settings::Instance().DPIScale;
+		ImVec2 size(ImGui::GetContentRegionAvail().x, 90.0f * dpi);
+		ImVec2 pos = ImGui::GetCursorScreenPos();
+		ImGui::InvisibleButton("##profiler_frametimes_graph", size);
+		bool hovered = ImGui::IsItemHovered();
+		bool clicked = ImGui::IsItemClicked();
+
+		ImDrawList* drawList = ImGui::GetWindowDrawList();
+		drawList->AddRectFilled(pos, ImVec2(pos.x + size.x, pos.y + size.y), ImGui::GetColorU32(ImGuiCol_FrameBg));
+
+		float scale = std::max(stats.Max, 1000.0f / 60.0f) * 1.1f; // ms at the top of the graph
+		float barWidth = size.x / FRAME_TIMELINE_HISTORY;
+		float left = pos.x + size.x - count * barWidth;
+		auto getY = [&](float ms) -> float {
+			return pos.y + size.y - size.y * std::min(ms / scale, 1.0f);
+		};
+
+		int hoveredBar = -1;
+		if (hovered && count > 0) {
+			hoveredBar = (int)floor((ImGui::GetIO().MousePos.x - left) / barWidth);
+			if (hoveredBar < 0 || hoveredBar >= count)
+				hoveredBar = -1;
+		}
+
+		ImU32 barColor = ImGui::GetColorU32(ImGuiCol_PlotHistogram);
+		ImU32 spikeColor = IM_COL32(230, 70, 60, 255);
+		ImU32 selectColor = ImGui::GetColorU32(ImGuiCol_PlotHistogramHovered);
+		for (int i = 0; i < count; i++) {
+			const FrameTimeline::Frame& frame = timeline.Get(i);
+			ImU32 color = frame.Time > stats.P99 ? spikeColor : barColor;
+			if (i == hoveredBar || (m_hasFrame && frame.Index == m_frame.Index))
+				color = selectColor;
+
+			float x = left + i * barWidth;
+			drawList->AddRectFilled(ImVec2(x, getY(frame.Time)), ImVec2(x + std::max(barWidth - 1.0f, 1.0f), pos.y + size.y), color);
+		}
+
+		// percentile lines
+		const float lines[3] = { stats.P50, stats.P95, stats.P99 };
+		const ImU32 lineColors[3] = { IM_COL32(90, 200, 90, 200), IM_COL32(230, 200, 60, 200), IM_COL32(230, 70, 60, 200) };
+		const char* lineNames[3] = { "p50", "p95", "p99" };
+		for (int i = 0; i < 3 && count > 0; i++) {
+			float y = getY(lines[i]);
+			drawList->AddLine(ImVec2(pos.x, y), ImVec2(pos.x + size.x, y), lineColors[i]);
+			drawList->AddText(ImVec2(pos.x + 2.0f * dpi, y - ImGui::GetFontSize()), lineColors[i], lineNames[i]);
+		}
+
+		// markers above the slowest frames
+		for (int index : worst) {
+			float x = left + (index + 0.5f) * barWidth;
+			float y = getY(timeline.Get(index).Time);
+			float r = 4.0f * dpi;
+			drawList->AddTriangleFilled(ImVec2(x - r, y - 2 * r), ImVec2(x + r, y - 2 * r), ImVec2(x, y - 1), spikeColor);
+		}
+
+		if (hoveredBar != -1) {
+			const FrameTimeline::Frame& frame = timeline.Get(hoveredBar);
+			ImGui::BeginTooltip();
+			ImGui::Text("Frame %u: %.2f ms", frame.Index, frame.Time);
+			if (!frame.Passes.empty())
+				ImGui::Text("GPU: %.3f ms", frame.GPU);
+			ImGui::TextDisabled("Click to see the passes of this frame");
+			ImGui::EndTooltip();
+
+			if (clicked) {
+				m_frame = frame;
+				m_hasFrame = true;
+			}
+		}
+
+		// worst frames
+		if (!worst.empty()) {
+			ImGui::Text("Worst:");
+			for (int index : worst) {
+				const FrameTimeline::Frame& frame = timeline.Get(index);
+				ImGui::SameLine();
+				if (ImGui::SmallButton((std::to_string(frame.Index) + " (" + std::to_string((int)(frame.Time + 0.5f)) + " ms)##profiler_worst" + std::to_string(index)).c_str())) {
+					m_frame = frame;
+					m_hasFrame = true;
+				}
+			}
+		}
+
+		if (!m_hasFrame)
+			return;
+
+		// passes of the selected frame, slowest first
+		ImGui::Text("Frame %u: %.2f ms, GPU: %.3f ms", m_frame.Index, m_frame.Time, m_frame.GPU);
+		ImGui::SameLine();
+		if (ImGui::SmallButton("Close##profiler_frametimes_close")) {
+			m_hasFrame = false;
+			return;
+		}
+
+		if (m_frame.Passes.empty()) {
+			ImGui::TextDisabled("No pass timings were recorded for this frame.");
+			return;
+		}
+
+		std::vector<FrameTimeline::Pass> sorted = m_frame.Passes;
+		std::sort(sorted.begin(), sorted.end(), [](const FrameTimeline::Pass& a, const FrameTimeline::Pass& b) {
+			return a.Time > b.Time;
+		});
+
+		ImGui::Columns(3, "##profiler_frametimes_passes", false);
+		ImGui::SetColumnWidth(0, 200.0f * dpi);
+		for (const FrameTimeline::Pass& pass : sorted) {
+			ImGui::Text("%s", pass.Name.c_str());
+			ImGui::NextColumn();
+			ImGui::Text("%.3f ms", pass.Time);
+			ImGui::NextColumn();
+			ImGui::ProgressBar(m_frame.GPU > 0.0f ? pass.Time / m_frame.GPU : 0.0f, ImVec2(-1, 0));
+			ImGui::NextColumn();
+		}
+		ImGui::Columns(1);
+	}
+	void ProfilerUI::m_renderCPUFrame()
+	{
+		FrameProfiler& profiler = FrameProfiler::Instance();
+		const FrameProfiler::Timing& frame = profiler.GetFrame();
+
+		if (ImGui::Button("Reset##profiler_cpu_reset"))
+			profiler.ResetStats();
+		ImGui::SameLine();
+		ImGui::Checkbox("Show over the preview##profiler_cpu_overlay", &profiler.ShowOverlay);
+		ImGui::SameLine();
+		ImGui::Text("Frame: %.2f ms (max %.2f ms)", frame.Average, frame.Max);
+
+		ImGui::Columns(5, "##profiler_cpu_columns", false);
+		ImGui::SetColumnWidth(0, 200.0f * Settings::Instance().DPIScale);
+		ImGui::Text("Stage"); ImGui::NextColumn();
+		ImGui::Text("Last (ms)"); ImGui::NextColumn();
+		ImGui::Text("Avg"); ImGui::NextColumn();
+		ImGui::Text("Max"); ImGui::NextColumn();
+		ImGui::Text("Share"); ImGui::NextColumn();
+		ImGui::Separator();
+
+		auto row = [&](const char* name, const FrameProfiler::Timing& timing, int depth) {
+			for (int i = 0; i < depth; i++)
+				ImGui::Indent();
+			ImGui::Text("%s", name);
+			for (int i = 0; i < depth; i++)
+				ImGui::Unindent();
+			ImGui::NextColumn();
+
+			ImGui::Text("%.3f", timing.Last); ImGui::NextColumn();
+			ImGui::Text("%.3f", timing.Average); ImGui::NextColumn();
+			ImGui::Text("%.3f", timing.Max); ImGui::NextColumn();
+			ImGui::ProgressBar(frame.Average > 0.0f ? timing.Average / frame.Average : 0.0f, ImVec2(-1, 0));
+			ImGui::NextColumn();
+		};
+
+		for (int i = 0; i < FrameProfiler::StageCount; i++) {
+			if (FrameProfiler::IsNested(i))
+				continue;
+			row(FrameProfiler::GetStageName(i), profiler.Get(i), 0);
+
+			// the parts of the UI stage
+			if (i == FrameProfiler::UI) {
+				for (const FrameProfiler::View& view : profiler.GetViews())
+					if (view.Time.Max > 0.0f)
+						row(view.Name.c_str(), view.Time, 1);
+				for (int j = 0; j < FrameProfiler::StageCount; j++)
+					if (FrameProfiler::IsNested(j))
+						row(FrameProfiler::GetStageName(j), profiler.Get(j), 1);
+			}
+		}
+		row("Other", profiler.GetOther(), 0);
+
+		ImGui::Columns(1);
+
+		if (!profiler.IsEnabled())
+			ImGui::TextDisabled("GPU wait is only measured while the profiler or the overlay is shown.");
+		else
+			ImGui::TextDisabled("Render submission is a part of the preview's time, plugin callbacks can happen in any stage.");
+	}
+	void ProfilerUI::m_renderRow(PipelineItem* item, int depth)
+	{
+		GPUProfiler& profiler = m_data->Renderer.GetProfiler();
+
+		if (depth > 0)
+			ImGui::Indent();
+		if (m_data->Renderer.IsOccluded(item))
+			ImGui::TextDisabled("%s (occluded)", item->Name);
+		else
+			ImGui::Text("%s", item->Name);
+		if (depth > 0)
+			ImGui::Unindent();
+		ImGui::NextColumn();
+
+		if (profiler.Has(item)) {
+			const GPUProfiler::Stats& stats = profiler.Get(item);
+			ImGui::Text("%.3f", stats.Last); ImGui::NextColumn();
+			ImGui::Text("%.3f", stats.Min); ImGui::NextColumn();
+			ImGui::Text("%.3f", stats.Average); ImGui::NextColumn();
+			ImGui::Text("%.3f", stats.Max); ImGui::NextColumn();
+		} else {
+			for (int i = 0; i < 4; i++) {
+				ImGui::TextDisabled("-");
+				ImGui::NextColumn();
+			}
+		}
+
+		m_renderCounters(item);
+	}
+	void ProfilerUI::m_renderCounters(PipelineItem* item)
+	{
+		GPUProfiler& profiler = m_data->Renderer.GetProfiler();
+		const GPUProfiler::Stats* stats = profiler.Has(item) ? &profiler.Get(item) : nullptr;
+
+		if (stats == nullptr || !stats->HasCounters) {
+			for (int i = 0; i < 4; i++) {
+				ImGui::TextDisabled("-");
+				ImGui::NextColumn();
+			}
+			return;
+		}
+
+		// 1234567 -> 1.23M
+		auto formatCount = [](GLuint64 count) -> std::string {
+			char buf[32];
+			if (count >= 1000000000ull)
+				snprintf(buf, sizeof(buf), "%.2fG", count / 1000000000.0);
+			else if (count >= 1000000ull)
+				snprintf(buf, sizeof(buf), "%.2fM", count / 1000000.0);
+			else if (count >= 10000ull)
+				snprintf(buf, sizeof(buf), "%.1fk", count / 1000.0);
+			else
+				snprintf(buf, sizeof(buf), "%llu", (unsigned long long)count);
+			return buf;
+		};
+
+		const int columns[4] = { GPUProfiler::VertexInvocations, GPUProfiler::PrimitivesSubmitted, GPUProfiler::FragmentInvocations, GPUProfiler::ComputeInvocations };
+		bool compute = item->Type == PipelineItem::ItemType::ComputePass;
+		for (int i = 0; i < 4; i++) {
+			if ((columns[i] == GPUProfiler::ComputeInvocations) != compute)
+				ImGui::TextDisabled("-");
+			else
+				ImGui::Text("%s", formatCount(stats->Counters[columns[i]]).c_str());
+
+			if (ImGui::IsItemHovered() && !compute) {
+				ImGui::BeginTooltip();
+				for (int j = 0; j < GPUProfiler::ComputeInvocations; j++)
+					ImGui::Text("%s: %llu", GPUProfiler::GetCounterName(j), (unsigned long long)stats->Counters[j]);
+
+				// a lot more fragments than vertices usually means that the pass is bound by the pixel shader
+				GLuint64 vertices = stats->Counters[GPUProfiler::VertexInvocations];
+				if (vertices > 0)
+					ImGui::Text("Fragments per vertex: %.2f", (double)stats->Counters[GPUProfiler::FragmentInvocations] / vertices);
+				ImGui::EndTooltip();
+			}
+			ImGui::NextColumn();
+		}
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include "UIView.h"
+#include "../Objects/FrameTimeline.h"
+
+namespace ed
+{
+	class ProfilerUI : public UIView
+	{
+	public:
+		ProfilerUI(GUIManager* ui, ed::InterfaceManager* objects, const std::string& name = "", bool visible = true) :
+			UIView(ui, objects, name, visible),
+			m_comparePass(nullptr),
+			m_compareMode(0),
+			m_tunePass(nullptr),
+			m_hasFrame(false)
+		{
+		}
+
+		virtual void OnEvent(const SDL_Event& e);
+		virtual void Update(float delta);
+
+	private:
+		void m_renderRow(PipelineItem* item, int depth);
+		void m_renderCounters(PipelineItem* item);
+		void m_renderComparison();
+		void m_renderTuner();
+		void m_selectComparePass(PipelineItem* pass);
+		void m_renderReloads();
+		void m_renderPlugins();
+		void m_renderFrameTimes();
+		void m_renderCPUFrame();
+
+		/* A/B comparison */
+		PipelineItem* m_comparePass;
+		int m_compareMode; // 0 = macros, 1 = other file, 2 = code editor
+		std::vector<ShaderMacro> m_compareMacros;
+		std::string m_comparePath;
+		std::string m_compareError;
+
+		/* work group size tuning */
+		PipelineItem* m_tunePass;
+		std::string m_tuneError;
+
+		/* frame time graph */
+		bool m_hasFrame;
+		FrameTimeline::Frame m_frame; // copy of the clicked frame, the history moves on
+	};
+}
@@ -5,6 +5,8 @@
 #include "../Objects/Logger.h"
 #include "../Objects/Names.h"
 #include "../Objects/ShaderTranscompiler.h"
+#include "../Objects/GeometryCache.h"
+#include "../Objects/VAOCache.h"
 
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -89,6 +91,7 @@ namespace ed
 
 						m_data->Messages.RenameGroup(m_current->Name, m_itemName);
 						memcpy(m_current->Name, m_itemName, PIPELINE_ITEM_NAME_LENGTH);
+						m_data->Pipeline.Notify(PipelineManager::EventType::ItemRenamed, m_current);
 						m_data->Parser.ModifyProject();
 					}
 				}
@@ -343,6 +346,389 @@ namespace ed
 					ImGui::NextColumn();
 
 					if (!item->GSUsed) ImGui::PopItemFlag();
+
+					ImGui::Separator();
+
+					// mesh shader used
+					ImGui::Text("MS:");
+					ImGui::NextColumn();
+					ImGui::PushItemWidth(-1);
+					if (ImGui::Checkbox("##pui_msuse", &item->MSUsed)) {
+						m_data->Parser.ModifyProject();
+						m_data->Renderer.Recompile(m_current->Name);
+					}
+					if (ImGui::IsItemHovered())
+						ImGui::SetTooltip("Draw the models' meshlets with GLSL task & mesh shaders (GL_NV_mesh_shader) instead of the vertex & geometry shaders");
+					ImGui::NextColumn();
+					ImGui::Separator();
+
+					if (!item->MSUsed) ImGui::PushItemFlag(ImGuiItemFlags_Disabled, true);
+
+					ImGui::Text("MS path:");
+					ImGui::NextColumn();
+					ImGui::PushItemWidth(BUTTON_SPACE_LEFT);
+					ImGui::PushItemFlag(ImGuiItemFlags_Disabled, true);
+					ImGui::InputText("##pui_mspath", item->MSPath, MAX_PATH);
+					ImGui::PopItemFlag();
+					ImGui::PopItemWidth();
+					ImGui::SameLine();
+					if (ImGui::Button("...##pui_msbtn", ImVec2(-1, 0))) {
+						std::string file;
+						bool success = UIHelper::GetOpenFileDialog(file);
+						if (success) {
+							file = m_data->Parser.GetRelativePath(file);
+							strcpy(item->MSPath, file.c_str());
+
+							m_data->Parser.ModifyProject();
+
+							if (m_data->Parser.FileExists(file)) {
+								m_data->Messages.ClearGroup(m_current->Name);
+								m_data->Renderer.Recompile(m_current->Name);
+							}
+							else
+								m_data->Messages.Add(ed::MessageStack::Type::Error, m_current->Name, "Mesh shader file doesnt exist");
+						}
+					}
+					ImGui::NextColumn();
+					ImGui::Separator();
+
+					// task shader used
+					ImGui::Text("TS:");
+					ImGui::NextColumn();
+					if (ImGui::Checkbox("##pui_tsuse", &item->TSUsed)) {
+						m_data->Parser.ModifyProject();
+						m_data->Renderer.Recompile(m_current->Name);
+					}
+					ImGui::NextColumn();
+					ImGui::Separator();
+
+					if (!item->TSUsed) ImGui::PushItemFlag(ImGuiItemFlags_Disabled, true);
+					ImGui::Text("TS path:");
+					ImGui::NextColumn();
+					ImGui::PushItemWidth(BUTTON_SPACE_LEFT);
+					ImGui::PushItemFlag(ImGuiItemFlags_Disabled, true);
+					ImGui::InputText("##pui_tspath", item->TSPath, MAX_PATH);
+					ImGui::PopItemFlag();
+					ImGui::PopItemWidth();
+					ImGui::SameLine();
+					if (ImGui::Button("...##pui_tsbtn", ImVec2(-1, 0))) {
+						std::string file;
+						bool success = UIHelper::GetOpenFileDialog(file);
+						if (success) {
+							file = m_data->Parser.GetRelativePath(file);
+							strcpy(item->TSPath, file.c_str());
+
+							m_data->Parser.ModifyProject();
+
+							if (m_data->Parser.FileExists(file)) {
+								m_data->Messages.ClearGroup(m_current->Name);
+								m_data->Renderer.Recompile(m_current->Name);
+							}
+							else
+								m_data->Messages.Add(ed::MessageStack::Type::Error, m_current->Name, "Task shader file doesnt exist");
+						}
+					}
+					ImGui::NextColumn();
+					ImGui::Separator();
+					if (!item->TSUsed) ImGui::PopItemFlag();
+
+					// meshlets per task
+					ImGui::Text("Meshlets per group:");
+					ImGui::NextColumn();
+					int perTask = item->MeshletsPerTask;
+					if (ImGui::InputInt("##pui_mspertask", &perTask, 1, 8)) {
+						item->MeshletsPerTask = std::max(perTask, 1);
+						m_data->Parser.ModifyProject();
+					}
+					if (ImGui::IsItemHovered())
+						ImGui::SetTooltip("Workgroups launched per mesh = ceil(SHADERed_MeshletCount / this)");
+					ImGui::NextColumn();
+					ImGui::Separator();
+
+					// launches from a buffer
+					ImGui::Text("Task buffer:");
+					ImGui::NextColumn();
+					{
+						const auto& bufList = m_data->Objects.GetItemDataList();
+						auto& bufNames = m_data->Objects.GetObjects();
+						if (ImGui::BeginCombo("##pui_mstaskbuf", ((item->MeshTaskBuffer == nullptr) ? "NULL" : (m_data->Objects.GetBufferNameByID(((BufferObject*)item->MeshTaskBuffer)->ID).c_str())))) {
+							if (ImGui::Selectable("NULL", item->MeshTaskBuffer == nullptr)) {
+								item->MeshTaskBuffer = nullptr;
+								m_data->Parser.ModifyProject();
+							}
+
+							for (int i = 0; i < bufList.size(); i++) {
+								if (bufList[i]->Buffer == nullptr)
+									continue;
+
+								ed::BufferObject* buf = bufList[i]->Buffer;
+								if (ImGui::Selectable(bufNames[i].c_str(), buf == item->MeshTaskBuffer)) {
+									item->MeshTaskBuffer = buf;
+									m_data->Parser.ModifyProject();
+								}
+							}
+
+							ImGui::EndCombo();
+						}
+						if (ImGui::IsItemHovered())
+							ImGui::SetTooltip("A { count, first } pair of uints per mesh of every model in the pass, written by a culling compute pass for example");
+					}
+					ImGui::NextColumn();
+					ImGui::Separator();
+
+					if (item->MeshTaskBuffer != nullptr) {
+						ImGui::Text("Task offset:");
+						ImGui::NextColumn();
+
+						int offset = item->MeshTaskOffset;
+						if (ImGui::InputInt("##pui_mstaskoffset", &offset, 4, 16)) {
+							// must be a multiple of 4
+							item->MeshTaskOffset = std::max<int>(offset, 0) & ~3;
+							m_data->Parser.ModifyProject();
+						}
+						ImGui::NextColumn();
+						ImGui::Separator();
+					}
+
+					if (!item->MSUsed) ImGui::PopItemFlag();
+
+					ImGui::PopItemWidth();
+					ImGui::Separator();
+
+					/* multisampling */
+					ImGui::Text("MSAA:");
+					ImGui::NextColumn();
+					if (ImGui::Checkbox("##pui_msaa", &item->Multisample)) {
+						m_data->Parser.ModifyProject();
+						m_data->Renderer.InvalidatePassCache();
+					}
+					if (ImGui::IsItemHovered())
+						ImGui::SetTooltip("Render to multisampled targets when MSAA is on - full screen passes usually don't need it. Passes that continue drawing to the same render texture should use the same setting");
+					ImGui::NextColumn();
+
+					/* progressive accumulation */
+					ImGui::Text("Accumulate:");
+					ImGui::NextColumn();
+					if (ImGui::Checkbox("##pui_accumulate", &item->Accumulate)) {
+						m_data->Parser.ModifyProject();
+						m_data->Renderer.InvalidatePassCache();
+					}
+					if (ImGui::IsItemHovered())
+						ImGui::SetTooltip("Show the average of every frame rendered since the camera, a variable or a shader last changed - for path tracers and other noisy shaders. Use the SampleIndex system variable to seed the random numbers");
+					ImGui::NextColumn();
+
+					if (!item->Accumulate) ImGui::PushItemFlag(ImGuiItemFlags_Disabled, true);
+					ImGui::Text("Samples:");
+					ImGui::NextColumn();
+					ImGui::PushItemWidth(-1);
+					if (ImGui::InputInt("##pui_accumulatesamples", &item->AccumulateSamples)) {
+						item->AccumulateSamples = std::max(0, item->AccumulateSamples);
+						m_data->Parser.ModifyProject();
+						m_data->Renderer.InvalidatePassCache();
+					}
+					ImGui::PopItemWidth();
+					if (ImGui::IsItemHovered())
+						ImGui::SetTooltip("The pass stops drawing once this many samples were averaged, 0 = never stop");
+					ImGui::NextColumn();
+					if (!item->Accumulate) ImGui::PopItemFlag();
+
+					/* reduced resolution */
+					ImGui::Text("Resolution:");
+					ImGui::NextColumn();
+					static const char* RESOLUTION_SCALE_NAMES[] = { "Full", "1/2", "1/4" };
+					int scaleIndex = item->ResolutionScale >= 4 ? 2 : (item->ResolutionScale >= 2 ? 1 : 0);
+					ImGui::PushItemWidth(-1);
+					if (ImGui::Combo("##pui_resscale", &scaleIndex, RESOLUTION_SCALE_NAMES, HARRAYSIZE(RESOLUTION_SCALE_NAMES))) {
+						item->ResolutionScale = 1 << scaleIndex;
+						m_data->Parser.ModifyProject();
+						m_data->Renderer.InvalidatePassCache();
+					}
+					ImGui::PopItemWidth();
+					if (ImGui::IsItemHovered())
+						ImGui::SetTooltip("Draw to smaller copies of the render textures that are upsampled into them - for expensive volumetric, SSAO and blur passes. MSAA isn't used for these passes");
+					ImGui::NextColumn();
+
+					if (item->ResolutionScale <= 1) ImGui::PushItemFlag(ImGuiItemFlags_Disabled, true);
+					ImGui::Text("Edge aware:");
+					ImGui::NextColumn();
+					if (ImGui::Checkbox("##pui_edgeaware", &item->EdgeAwareUpsample)) {
+						m_data->Parser.ModifyProject();
+						m_data->Renderer.InvalidatePassCache();
+					}
+					if (ImGui::IsItemHovered())
+						ImGui::SetTooltip("Weigh the upsampled texels by how close their depth is to the depth of the full resolution pixel instead of plain bilinear filtering");
+					ImGui::NextColumn();
+					if (item->ResolutionScale <= 1) ImGui::PopItemFlag();
+
+					/* depth prepass */
+					ImGui::Text("Depth prepass:");
+					ImGui::NextColumn();
+					if (ImGui::Checkbox("##pui_depthprepass", &item->DepthPrepass)) {
+						m_data->Parser.ModifyProject();
+						m_data->Renderer.InvalidatePassCache();
+					}
+					if (ImGui::IsItemHovered())
+						ImGui::SetTooltip("Draw the opaque items with only the vertex shader first so that the pixel shader runs once per visible pixel. Not used if the pixel shader discards or writes the depth");
+					ImGui::NextColumn();
+
+					/* multiview */
+					bool multiview = m_data->Renderer.IsMultiviewSupported() && !item->MSUsed;
+					if (!multiview) ImGui::PushItemFlag(ImGuiItemFlags_Disabled, true);
+					ImGui::Text("Multiview:");
+					ImGui::NextColumn();
+					if (ImGui::Checkbox("##pui_multiview", &item->Multiview)) {
+						m_data->Parser.ModifyProject();
+						m_data->Renderer.RebuildFBO(item);
+						m_data->Renderer.Recompile(m_current->Name);
+					}
+					if (ImGui::IsItemHovered())
+						ImGui::SetTooltip(multiview ? "Draw both eyes at once into the first 2 layers of the render textures (texture arrays) - pick the eye's matrices with gl_ViewID_OVR, e.g. ViewProjectionLeft/ViewProjectionRight" : "Needs GL_OVR_multiview2 and a vertex shader");
+					ImGui::NextColumn();
+					if (!multiview) ImGui::PopItemFlag();
+
+					/* GPU side condition */
+					ImGui::Text("Condition:");
+					if (ImGui::IsItemHovered())
+						ImGui::SetTooltip("Only draw the pass while the uint at the offset of this buffer isn't 0 - decided on the GPU, the value isn't read back");
+					ImGui::NextColumn();
+
+					const auto& condList = m_data->Objects.GetItemDataList();
+					auto& condNames = m_data->Objects.GetObjects();
+					ImGui::PushItemWidth(-1);
+					if (ImGui::BeginCombo("##pui_spcondbuf", ((item->ConditionBuffer == nullptr) ? "NULL" : (m_data->Objects.GetBufferNameByID(((BufferObject*)item->ConditionBuffer)->ID).c_str())))) {
+						// null element -> always drawn
+						if (ImGui::Selectable("NULL", item->ConditionBuffer == nullptr)) {
+							item->ConditionBuffer = nullptr;
+							m_data->Parser.ModifyProject();
+						}
+
+						for (int i = 0; i < condList.size(); i++) {
+							if (condList[i]->Buffer == nullptr)
+								continue;
+
+							ed::BufferObject* buf = condList[i]->Buffer;
+							if (ImGui::Selectable(condNames[i].c_str(), buf == item->ConditionBuffer)) {
+								item->ConditionBuffer = buf;
+								m_data->Parser.ModifyProject();
+							}
+						}
+
+						ImGui::EndCombo();
+					}
+					ImGui::PopItemWidth();
+					ImGui::NextColumn();
+
+					if (item->ConditionBuffer != nullptr) {
+						ImGui::Text("Condition offset:");
+						ImGui::NextColumn();
+
+						int offset = item->ConditionOffset;
+						ImGui::PushItemWidth(-1);
+						if (ImGui::InputInt("##pui_spcondoffset", &offset, 4, 16)) {
+							// must be a multiple of 4
+							item->ConditionOffset = std::max<int>(offset, 0) & ~3;
+							m_data->Parser.ModifyProject();
+						}
+						ImGui::PopItemWidth();
+						ImGui::NextColumn();
+					}
+
+					/* transform feedback */
+					bool capture = VertexCapture::IsSupported() && !item->MSUsed;
+					if (!capture) ImGui::PushItemFlag(ImGuiItemFlags_Disabled, true);
+					ImGui::Text("Capture vertices:");
+					if (ImGui::IsItemHovered())
+						ImGui::SetTooltip(capture ? "Write the vertex shader's outputs to this buffer so that the later passes can draw them with a Captured geometry item instead of running the vertex shader again" : "Needs GL_ARB_transform_feedback3 and a vertex shader");
+					ImGui::NextColumn();
+
+					ImGui::PushItemWidth(-1);
+					if (ImGui::BeginCombo("##pui_spcapturebuf", ((item->CaptureBuffer == nullptr) ? "NULL" : (m_data->Objects.GetBufferNameByID(((BufferObject*)item->CaptureBuffer)->ID).c_str())))) {
+						// null element -> nothing is captured
+						if (ImGui::Selectable("NULL", item->CaptureBuffer == nullptr)) {
+							item->CaptureBuffer = nullptr;
+							m_data->Parser.ModifyProject();
+							m_data->Renderer.Recompile(m_current->Name);
+						}
+
+						for (int i = 0; i < condList.size(); i++) {
+							if (condList[i]->Buffer == nullptr)
+								continue;
+
+							ed::BufferObject* buf = condList[i]->Buffer;
+							if (ImGui::Selectable(condNames[i].c_str(), buf == item->CaptureBuffer)) {
+								item->CaptureBuffer = buf;
+								m_data->Parser.ModifyProject();
+								m_data->Renderer.Recompile(m_current->Name);
+							}
+						}
+
+						ImGui::EndCombo();
+					}
+					ImGui::PopItemWidth();
+					ImGui::NextColumn();
+
+					if (item->CaptureBuffer != nullptr) {
+						ImGui::Text("Captured outputs:");
+						if (ImGui::IsItemHovered())
+							ImGui::SetTooltip("The vertex shader's outputs for the position, normal, texcoord, tangent, binormal & color, separated with ';' - the values with an empty name aren't written. Press enter to relink the shaders");
+						ImGui::NextColumn();
+
+						ImGui::PushItemWidth(-1);
+						if (ImGui::InputText("##pui_spcaptureout", item->CaptureOutputs, sizeof(item->CaptureOutputs), ImGuiInputTextFlags_EnterReturnsTrue)) {
+							m_data->Parser.ModifyProject();
+							m_data->Renderer.Recompile(m_current->Name);
+						}
+						ImGui::PopItemWidth();
+						if (ImGui::IsItemHovered())
+							ImGui::SetTooltip("%d vertices fit in the buffer", VertexCapture::GetVertexCount((BufferObject*)item->CaptureBuffer));
+						ImGui::NextColumn();
+					}
+					if (!capture) ImGui::PopItemFlag();
+
+					/* variable rate shading */
+					bool vrs = m_data->Renderer.IsShadingRateSupported();
+					if (!vrs) ImGui::PushItemFlag(ImGuiItemFlags_Disabled, true);
+					ImGui::Text("Shading rate:");
+					ImGui::NextColumn();
+					ImGui::PushItemWidth(-1);
+					if (ImGui::Combo("##pui_shadingrate", &item->ShadingRate, SHADING_RATE_NAMES, HARRAYSIZE(SHADING_RATE_NAMES))) {
+						m_data->Parser.ModifyProject();
+						m_data->Renderer.InvalidatePassCache();
+					}
+					ImGui::PopItemWidth();
+					if (ImGui::IsItemHovered())
+						ImGui::SetTooltip(vrs ? "One fragment shader invocation per block of pixels - cheaper full screen passes in the low detail regions" : "Needs GL_NV_shading_rate_image");
+					ImGui::NextColumn();
+
+					ImGui::Text("Rate image:");
+					ImGui::NextColumn();
+					ImGui::PushItemWidth(-1);
+					if (ImGui::BeginCombo("##pui_shadingrateimg", item->ShadingRateImage.empty() ? "None" : item->ShadingRateImage.c_str())) {
+						if (ImGui::Selectable("None", item->ShadingRateImage.empty())) {
+							item->ShadingRateImage.clear();
+							m_data->Parser.ModifyProject();
+							m_data->Renderer.InvalidatePassCache();
+						}
+
+						// the texels are indices of the rates above
+						for (const std::string& name : m_data->Objects.GetObjects()) {
+							ObjectManagerItem* obj = m_data->Objects.GetObjectManagerItem(name);
+							bool isRateImage = (obj->RT != nullptr && obj->RT->Format == GL_R8UI) || (obj->Image != nullptr && obj->Image->Format == GL_R8UI);
+							if (isRateImage && ImGui::Selectable(name.c_str(), name == item->ShadingRateImage)) {
+								item->ShadingRateImage = name;
+								m_data->Parser.ModifyProject();
+								m_data->Renderer.InvalidatePassCache();
+							}
+						}
+						ImGui::EndCombo();
+					}
+					ImGui::PopItemWidth();
+					if (ImGui::IsItemHovered()) {
+						glm::ivec2 texel = m_data->Renderer.GetShadingRateTexelSize();
+						ImGui::SetTooltip("R8UI render texture or image written by an earlier pass, one texel per %dx%d pixels - 0 = 1x1 ... 6 = 4x4", texel.x, texel.y);
+					}
+					ImGui::NextColumn();
+					if (!vrs) ImGui::PopItemFlag();
 				}
 				else if (m_current->Type == ed::PipelineItem::ItemType::ComputePass)
 				{
@@ -411,6 +797,152 @@ namespace ed
 
 						m_data->Parser.ModifyProject();
 					}
+					ImGui::NextColumn();
+					ImGui::Separator();
+
+					/* iterations */
+					ImGui::Text("Iterations:");
+					ImGui::NextColumn();
+					int iterations = item->Iterations;
+					ImGui::PushItemWidth(-1);
+					if (ImGui::InputInt("##pui_csiterations", &iterations)) {
+						item->Iterations = std::max<int>(iterations, 1);
+						m_data->Parser.ModifyProject();
+					}
+					ImGui::PopItemWidth();
+					ImGui::NextColumn();
+					ImGui::Separator();
+
+					ImGui::Text("Ping-pong:");
+					if (ImGui::IsItemHovered())
+						ImGui::SetTooltip("Swap the objects bound to the UAV slots 0 and 1 on every odd iteration");
+					ImGui::NextColumn();
+					if (ImGui::Checkbox("##pui_cspingpong", &item->PingPong))
+						m_data->Parser.ModifyProject();
+					ImGui::NextColumn();
+					ImGui::Separator();
+
+					/* fixed tick rate */
+					ImGui::Text("Tick rate:");
+					if (ImGui::IsItemHovered())
+						ImGui::SetTooltip("Steps per second that don't depend on the preview's frame rate - missed steps are dispatched on the next frame, 0 runs one step per frame");
+					ImGui::NextColumn();
+					ImGui::PushItemWidth(-1);
+					if (ImGui::DragFloat("##pui_cstickrate", &item->TickRate, 1.0f, 0.0f, 1000.0f, item->TickRate > 0.0f ? "%.1f Hz" : "every frame")) {
+						item->TickRate = std::max<float>(item->TickRate, 0.0f);
+						m_data->Parser.ModifyProject();
+					}
+					ImGui::PopItemWidth();
+					ImGui::NextColumn();
+					ImGui::Separator();
+
+					/* indirect dispatch */
+					ImGui::Text("Indirect buffer:");
+					ImGui::NextColumn();
+
+					const auto& bufList = m_data->Objects.GetItemDataList();
+					auto& bufNames = m_data->Objects.GetObjects();
+					ImGui::PushItemWidth(-1);
+					if (ImGui::BeginCombo("##pui_csindirectbuf", ((item->IndirectBuffer == nullptr) ? "NULL" : (m_data->Objects.GetBufferNameByID(((BufferObject*)item->IndirectBuffer)->ID).c_str())))) {
+						// null element -> use the group size
+						if (ImGui::Selectable("NULL", item->IndirectBuffer == nullptr)) {
+							item->IndirectBuffer = nullptr;
+							m_data->Parser.ModifyProject();
+						}
+
+						for (int i = 0; i < bufList.size(); i++) {
+							if (bufList[i]->Buffer == nullptr)
+								continue;
+
+							ed::BufferObject* buf = bufList[i]->Buffer;
+							if (ImGui::Selectable(bufNames[i].c_str(), buf == item->IndirectBuffer)) {
+								item->IndirectBuffer = buf;
+								m_data->Parser.ModifyProject();
+							}
+						}
+
+						ImGui::EndCombo();
+					}
+					ImGui::PopItemWidth();
+					ImGui::NextColumn();
+					ImGui::Separator();
+
+					if (item->IndirectBuffer != nullptr) {
+						ImGui::Text("Indirect offset:");
+						ImGui::NextColumn();
+
+						int offset = item->IndirectOffset;
+						ImGui::PushItemWidth(-1);
+						if (ImGui::InputInt("##pui_csindirectoffset", &offset, 4, 16)) {
+							// must be a multiple of 4
+							item->IndirectOffset = std::max<int>(offset, 0) & ~3;
+							m_data->Parser.ModifyProject();
+						}
+						ImGui::PopItemWidth();
+						ImGui::NextColumn();
+						ImGui::Separator();
+					}
+
+					/* GPU side condition */
+					ImGui::Text("Condition:");
+					if (ImGui::IsItemHovered())
+						ImGui::SetTooltip("Only dispatch the pass while the uint at the offset of this buffer isn't 0 - decided on the GPU, the value isn't read back");
+					ImGui::NextColumn();
+
+					ImGui::PushItemWidth(-1);
+					if (ImGui::BeginCombo("##pui_cscondbuf", ((item->ConditionBuffer == nullptr) ? "NULL" : (m_data->Objects.GetBufferNameByID(((BufferObject*)item->ConditionBuffer)->ID).c_str())))) {
+						// null element -> always dispatched
+						if (ImGui::Selectable("NULL", item->ConditionBuffer == nullptr)) {
+							item->ConditionBuffer = nullptr;
+							m_data->Parser.ModifyProject();
+						}
+
+						for (int i = 0; i < bufList.size(); i++) {
+							if (bufList[i]->Buffer == nullptr)
+								continue;
+
+							ed::BufferObject* buf = bufList[i]->Buffer;
+							if (ImGui::Selectable(bufNames[i].c_str(), buf == item->ConditionBuffer)) {
+								item->ConditionBuffer = buf;
+								m_data->Parser.ModifyProject();
+							}
+						}
+
+						ImGui::EndCombo();
+					}
+					ImGui::PopItemWidth();
+					ImGui::NextColumn();
+					ImGui::Separator();
+
+					if (item->ConditionBuffer != nullptr) {
+						ImGui::Text("Condition offset:");
+						ImGui::NextColumn();
+
+						int offset = item->ConditionOffset;
+						ImGui::PushItemWidth(-1);
+						if (ImGui::InputInt("##pui_cscondoffset", &offset, 4, 16)) {
+							// must be a multiple of 4
+							item->ConditionOffset = std::max<int>(offset, 0) & ~3;
+							m_data->Parser.ModifyProject();
+						}
+						ImGui::PopItemWidth();
+						ImGui::NextColumn();
+						ImGui::Separator();
+					}
+
+					/* memory barrier */
+					ImGui::Text("Barrier:");
+					ImGui::NextColumn();
+					if (ImGui::Checkbox("Auto##pui_csautobarrier", &item->AutoBarrier))
+						m_data->Parser.ModifyProject();
+					if (!item->AutoBarrier) {
+						for (int i = 0; i < HARRAYSIZE(BARRIER_NAMES); i++) {
+							ImGui::PushID(i);
+							if (ImGui::CheckboxFlags(BARRIER_NAMES[i], &item->Barrier, BARRIER_VALUES[i]))
+								m_data->Parser.ModifyProject();
+							ImGui::PopID();
+						}
+					}
 				}
 				else if (m_current->Type == ed::PipelineItem::ItemType::AudioPass)
 				{
@@ -495,6 +1027,148 @@ namespace ed
 					ImGui::PopItemWidth();
 					ImGui::NextColumn();
 					ImGui::Separator();
+
+					// the items with the old size still share the old buffers
+					auto rebuild = [&]() {
+						char* owner = m_data->Pipeline.GetItemOwner(m_current->Name);
+						pipe::ShaderPass* ownerData = (pipe::ShaderPass*)(m_data->Pipeline.Get(owner)->Data);
+
+						BufferObject* buf = (BufferObject*)item->InstanceBuffer;
+						if (buf == nullptr)
+							GeometryCache::Instance().Rebuild(item, ownerData->InputLayout);
+						else
+							GeometryCache::Instance().Rebuild(item, ownerData->InputLayout, buf->ID, m_data->Objects.ParseBufferFormat(buf->ViewFormat));
+
+						m_data->Parser.ModifyProject();
+					};
+
+					/* captured vertices */
+					if (item->Type == pipe::GeometryItem::Captured) {
+						ImGui::Text("Vertex buffer:");
+						if (ImGui::IsItemHovered())
+							ImGui::SetTooltip("The buffer that an earlier shader pass captures its vertices to - drawn through this pass' input layout");
+						ImGui::NextColumn();
+
+						const auto& vertList = m_data->Objects.GetItemDataList();
+						auto& vertNames = m_data->Objects.GetObjects();
+						ImGui::PushItemWidth(-1);
+						if (ImGui::BeginCombo("##pui_geo_vertexbuf", ((item->VertexBuffer == nullptr) ? "NULL" : (m_data->Objects.GetBufferNameByID(((BufferObject*)item->VertexBuffer)->ID).c_str())))) {
+							// null element -> nothing is drawn
+							if (ImGui::Selectable("NULL", item->VertexBuffer == nullptr)) {
+								item->VertexBuffer = nullptr;
+								rebuild();
+							}
+
+							for (int i = 0; i < vertList.size(); i++) {
+								if (vertList[i]->Buffer == nullptr)
+									continue;
+
+								ed::BufferObject* buf = vertList[i]->Buffer;
+								if (ImGui::Selectable(vertNames[i].c_str(), buf == item->VertexBuffer)) {
+									item->VertexBuffer = buf;
+									rebuild();
+								}
+							}
+
+							ImGui::EndCombo();
+						}
+						ImGui::PopItemWidth();
+						ImGui::NextColumn();
+						ImGui::Separator();
+					}
+
+					/* size */
+					if (item->Type != pipe::GeometryItem::Rectangle && item->Type != pipe::GeometryItem::ScreenQuadNDC && item->Type != pipe::GeometryItem::Captured) {
+						ImGui::Text("Size:");
+						ImGui::NextColumn();
+
+						ImGui::PushItemWidth(-1);
+						bool sizeChanged = false;
+						if (item->Type == pipe::GeometryItem::Cube || item->Type == pipe::GeometryItem::Generated)
+							sizeChanged = ImGui::DragFloat3("##pui_geosize", glm::value_ptr(item->Size), 0.01f);
+						else if (item->Type == pipe::GeometryItem::Circle || item->Type == pipe::GeometryItem::Plane)
+							sizeChanged = ImGui::DragFloat2("##pui_geosize", glm::value_ptr(item->Size), 0.01f);
+						else
+							sizeChanged = ImGui::DragFloat("##pui_geosize", &item->Size.x, 0.01f);
+
+						// the generated geometry keeps its buffers, only the kernel runs again
+						if (sizeChanged && item->Type == pipe::GeometryItem::Generated) {
+							item->Dirty = true;
+							m_data->Parser.ModifyProject();
+						} else if (sizeChanged)
+							rebuild();
+						ImGui::PopItemWidth();
+						ImGui::NextColumn();
+						ImGui::Separator();
+					}
+
+					/* generated geometry */
+					if (item->Type == pipe::GeometryItem::Generated) {
+						bool resized = false, changed = false;
+
+						ImGui::Text("Shape:");
+						ImGui::NextColumn();
+						ImGui::PushItemWidth(-1);
+						resized |= ImGui::Combo("##pui_geoshape", &item->GenShape, " Grid\0 Terrain\0 Sphere\0 Scatter\0");
+						ImGui::PopItemWidth();
+						ImGui::NextColumn();
+						ImGui::Separator();
+
+						ImGui::Text("Resolution:");
+						ImGui::NextColumn();
+						ImGui::PushItemWidth(-1);
+						glm::ivec2 res = item->GenResolution;
+						if (ImGui::InputInt2("##pui_georesolution", glm::value_ptr(res)) && res != item->GenResolution) {
+							item->GenResolution = glm::clamp(res, glm::ivec2(1), glm::ivec2(4096));
+							resized = true;
+						}
+						if (ImGui::IsItemHovered())
+							ImGui::SetTooltip("Grid & terrain: cells, sphere: segments & rings, scatter: copies (X * Y)");
+						ImGui::PopItemWidth();
+						ImGui::NextColumn();
+						ImGui::Separator();
+
+						ImGui::Text("Noise amplitude:");
+						ImGui::NextColumn();
+						ImGui::PushItemWidth(-1);
+						changed |= ImGui::DragFloat("##pui_geoamplitude", &item->GenAmplitude, 0.01f);
+						if (ImGui::IsItemHovered())
+							ImGui::SetTooltip("Height of the terrain & of the ground that the scatter is placed on");
+						ImGui::PopItemWidth();
+						ImGui::NextColumn();
+						ImGui::Separator();
+
+						ImGui::Text("Noise frequency:");
+						ImGui::NextColumn();
+						ImGui::PushItemWidth(-1);
+						changed |= ImGui::DragFloat("##pui_geofrequency", &item->GenFrequency, 0.01f);
+						ImGui::PopItemWidth();
+						ImGui::NextColumn();
+						ImGui::Separator();
+
+						ImGui::Text("Seed:");
+						ImGui::NextColumn();
+						ImGui::PushItemWidth(-1);
+						changed |= ImGui::InputInt("##pui_geoseed", (int*)&item->GenSeed);
+						ImGui::PopItemWidth();
+						ImGui::NextColumn();
+						ImGui::Separator();
+
+						ImGui::Text("Animated:");
+						ImGui::NextColumn();
+						changed |= ImGui::Checkbox("##pui_geoanimated", &item->GenAnimated);
+						if (ImGui::IsItemHovered())
+							ImGui::SetTooltip("Generate the geometry every frame, the noise moves with the time");
+						ImGui::NextColumn();
+						ImGui::Separator();
+
+						if (resized)
+							rebuild();
+						else if (changed) {
+							item->Dirty = true;
+							m_data->Parser.ModifyProject();
+						}
+					}
 					
 					/* topology type */
 					ImGui::Text("Topology:");
@@ -527,6 +1201,39 @@ namespace ed
 					ImGui::NextColumn();
 					ImGui::Separator();
 
+					/* gpu instance culling */
+					ImGui::Text("GPU instance culling:");
+					ImGui::NextColumn();
+
+					if (ImGui::Checkbox("##pui_geogpucull", &item->GPUCulling))
+						m_data->Parser.ModifyProject();
+					if (ImGui::IsItemHovered())
+						ImGui::SetTooltip("Cull the instances against the camera's view with a compute shader before drawing - each instance has to start with a float3/float4 offset");
+					ImGui::NextColumn();
+					ImGui::Separator();
+
+					/* occlusion culling */
+					ImGui::Text("Occlusion culling:");
+					ImGui::NextColumn();
+
+					if (ImGui::Checkbox("##pui_geoocclusion", &item->OcclusionCulling))
+						m_data->Parser.ModifyProject();
+					if (ImGui::IsItemHovered())
+						ImGui::SetTooltip("Skip the draw call while the item is fully occluded - it's drawn every few frames to check if it became visible again");
+					ImGui::NextColumn();
+					ImGui::Separator();
+
+					/* frustum culling */
+					ImGui::Text("Frustum culling:");
+					ImGui::NextColumn();
+
+					if (ImGui::Checkbox("##pui_geofrustum", &item->FrustumCulling))
+						m_data->Parser.ModifyProject();
+					if (ImGui::IsItemHovered())
+						ImGui::SetTooltip("Skip the draw call when the item is outside of the camera's view - turn this off if the vertex shader moves the vertices");
+					ImGui::NextColumn();
+					ImGui::Separator();
+
 					/* instance array buffers */
 					ImGui::Text("Instance input buffer:");
 					ImGui::NextColumn();
@@ -542,7 +1249,7 @@ namespace ed
 							char* owner = m_data->Pipeline.GetItemOwner(m_current->Name);
 							pipe::ShaderPass* ownerData = (pipe::ShaderPass*)(m_data->Pipeline.Get(owner)->Data);
 
-							gl::CreateVAO(item->VAO, item->VBO, ownerData->InputLayout);
+							GeometryCache::Instance().Rebuild(item, ownerData->InputLayout);
 							
 							m_data->Parser.ModifyProject();
 						}
@@ -560,7 +1267,7 @@ namespace ed
 								char* owner = m_data->Pipeline.GetItemOwner(m_current->Name);
 								pipe::ShaderPass* ownerData = (pipe::ShaderPass*)(m_data->Pipeline.Get(owner)->Data);
 
-								gl::CreateVAO(item->VAO, item->VBO, ownerData->InputLayout, 0, buf->ID, fmtList);
+								GeometryCache::Instance().Rebuild(item, ownerData->InputLayout, buf->ID, fmtList);
 
 								m_data->Parser.ModifyProject();
 							}
@@ -957,7 +1664,84 @@ namespace ed
 					item->Rotation = glm::vec3(glm::radians(rotaDeg.x), glm::radians(rotaDeg.y), glm::radians(rotaDeg.z));
 					ImGui::PopItemWidth();
 					ImGui::NextColumn();
+					ImGui::Separator();
+
+					/* level of detail */
+					ImGui::Text("LOD:");
+					ImGui::NextColumn();
+
+					int lodCount = item->Data == nullptr ? 1 : item->Data->GetLODCount();
+					std::string lodName = item->LOD < 0 ? "Auto" : std::to_string(item->LOD);
+					ImGui::PushItemWidth(-1);
+					if (ImGui::BeginCombo("##pui_mdllod", lodName.c_str())) {
+						if (ImGui::Selectable("Auto", item->LOD < 0)) {
+							item->LOD = -1;
+							m_data->Parser.ModifyProject();
+						}
+						for (int i = 0; i < lodCount; i++) {
+							std::string lodLabel = std::to_string(i);
+							if (item->Data != nullptr)
+								lodLabel += " (" + std::to_string(item->Data->GetTriangleCount(i)) + " triangles)";
+							if (ImGui::Selectable(lodLabel.c_str(), item->LOD == i)) {
+								item->LOD = i;
+								m_data->Parser.ModifyProject();
+							}
+						}
+						ImGui::EndCombo();
+					}
+					if (lodCount <= 1 && ImGui::IsItemHovered())
+						ImGui::SetTooltip("LODs are generated for dense meshes when \"Optimize imported 3D models\" is turned on");
+					ImGui::PopItemWidth();
+					ImGui::NextColumn();
+					ImGui::Separator();
+
+					/* skeletal animation */
+					if (item->Data != nullptr && item->Data->IsSkinned()) {
+						ImGui::Text("Animation:");
+						ImGui::NextColumn();
+
+						ImGui::PushItemWidth(-1);
+						if (ImGui::BeginCombo("##pui_mdlanim", item->Animation[0] == 0 ? "Bind pose" : item->Animation)) {
+							if (ImGui::Selectable("Bind pose", item->Animation[0] == 0)) {
+								item->Animation[0] = 0;
+								m_data->Parser.ModifyProject();
+							}
+							for (const auto& anim : item->Data->GetAnimationNames()) {
+								if (ImGui::Selectable(anim.c_str(), anim == item->Animation)) {
+									strncpy(item->Animation, anim.c_str(), MODEL_GROUP_NAME_LENGTH - 1);
+									item->Animation[MODEL_GROUP_NAME_LENGTH - 1] = 0;
+									m_data->Parser.ModifyProject();
+								}
+							}
+							ImGui::EndCombo();
+						}
+						if (ImGui::IsItemHovered())
+							ImGui::SetTooltip("The pose is shared by all items that use this file - the first one in the pipeline decides it");
+						ImGui::PopItemWidth();
+						ImGui::NextColumn();
+						ImGui::Separator();
+
+						ImGui::Text("Animation speed:");
+						ImGui::NextColumn();
+
+						ImGui::PushItemWidth(-1);
+						if (ImGui::DragFloat("##pui_mdlanimspeed", &item->AnimationSpeed, 0.01f))
+							m_data->Parser.ModifyProject();
+						ImGui::PopItemWidth();
+						ImGui::NextColumn();
+						ImGui::Separator();
+					}
+
+					/* frustum culling */
+					ImGui::Text("Frustum culling:");
+					ImGui::NextColumn();
 
+					if (ImGui::Checkbox("##pui_mdlfrustum", &item->FrustumCulling))
+						m_data->Parser.ModifyProject();
+					if (ImGui::IsItemHovered())
+						ImGui::SetTooltip("Skip the draw call when the item is outside of the camera's view - turn this off if the vertex shader moves the vertices");
+					ImGui::NextColumn();
+					ImGui::Separator();
 
 					/* instanced */
 					ImGui::Text("Instanced:");
@@ -979,6 +1763,17 @@ namespace ed
 					ImGui::NextColumn();
 					ImGui::Separator();
 
+					/* gpu instance culling */
+					ImGui::Text("GPU instance culling:");
+					ImGui::NextColumn();
+
+					if (ImGui::Checkbox("##pui_mdlgpucull", &item->GPUCulling))
+						m_data->Parser.ModifyProject();
+					if (ImGui::IsItemHovered())
+						ImGui::SetTooltip("Cull the instances against the camera's view with a compute shader before drawing - each instance has to start with a float3/float4 offset");
+					ImGui::NextColumn();
+					ImGui::Separator();
+
 					/* instance array buffers */
 					ImGui::Text("Instance input buffer:");
 					ImGui::NextColumn();
@@ -995,7 +1790,7 @@ namespace ed
 							pipe::ShaderPass* ownerData = (pipe::ShaderPass*)(m_data->Pipeline.Get(owner)->Data);
 
 							for (auto& mesh : item->Data->Meshes)
-								gl::CreateVAO(mesh.VAO, mesh.VBO, ownerData->InputLayout, mesh.EBO);
+								VAOCache::Instance().Rebuild(mesh.VAO, mesh.VBO, ownerData->InputLayout, mesh.EBO);
 
 							m_data->Parser.ModifyProject();
 						}
@@ -1014,7 +1809,7 @@ namespace ed
 								pipe::ShaderPass* ownerData = (pipe::ShaderPass*)(m_data->Pipeline.Get(owner)->Data);
 
 								for (auto& mesh : item->Data->Meshes)
-									gl::CreateVAO(mesh.VAO, mesh.VBO, ownerData->InputLayout, mesh.EBO, buf->ID, fmtList);
+									VAOCache::Instance().Rebuild(mesh.VAO, mesh.VBO, ownerData->InputLayout, mesh.EBO, buf->ID, fmtList);
 								
 								m_data->Parser.ModifyProject();
 							}
@@ -1097,7 +1892,82 @@ namespace ed
 				ImGui::NextColumn();
 				ImGui::Separator();
 
+				/* LAYERS */
+				ImGui::Text("Type:");
+				ImGui::NextColumn();
+				static const char* RT_TYPE_NAMES[] = { "2D", "2D array", "Cubemap" };
+				int rtType = m_currentRT->Cubemap ? 2 : (m_currentRT->Layers > 1 ? 1 : 0);
+				ImGui::PushItemWidth(-1);
+				if (ImGui::Combo("##pui_rt_type", &rtType, RT_TYPE_NAMES, HARRAYSIZE(RT_TYPE_NAMES)))
+					m_data->Objects.SetRenderTextureLayers(std::string(m_itemName), rtType == 1 ? std::max(m_currentRT->Layers, 2) : 1, rtType == 2);
+				ImGui::PopItemWidth();
+				if (ImGui::IsItemHovered())
+					ImGui::SetTooltip("Layered render textures are drawn in one pass - the geometry shader (or the vertex shader with GL_ARB_shader_viewport_layer_array) writes gl_Layer, for example from gl_InstanceID. MSAA isn't used for them");
+				ImGui::NextColumn();
+
+				if (rtType == 1) {
+					ImGui::Text("Layers:");
+					ImGui::NextColumn();
+					int layers = m_currentRT->Layers;
+					ImGui::PushItemWidth(-1);
+					if (ImGui::InputInt("##pui_rt_layers", &layers, 1, 4, ImGuiInputTextFlags_EnterReturnsTrue))
+						m_data->Objects.SetRenderTextureLayers(std::string(m_itemName), std::max(layers, 2), false);
+					ImGui::PopItemWidth();
+					ImGui::NextColumn();
+				}
+				ImGui::Separator();
+
+				/* MIPMAPS */
+				ImGui::Text("Mipmaps:");
+				ImGui::NextColumn();
+
+				bool canMip = MipChain::IsSupported(m_currentRT->Format) && !m_currentRT->IsLayered(); // integer formats can't be filtered
+				if (!canMip) {
+					ImGui::PushItemFlag(ImGuiItemFlags_Disabled, true);
+					ImGui::PushStyleVar(ImGuiStyleVar_Alpha, ImGui::GetStyle().Alpha * 0.5f);
+				}
+
+				if (ImGui::Checkbox("##pui_rt_mipmaps", &m_currentRT->Mipmaps)) {
+					glm::ivec2 wsize(m_data->Renderer.GetLastRenderSize().x, m_data->Renderer.GetLastRenderSize().y);
+					m_data->Objects.ResizeRenderTexture(std::string(m_itemName), m_currentRT->CalculateSize(wsize.x, wsize.y));
+					m_data->Parser.ModifyProject();
+				}
+				if (ImGui::IsItemHovered())
+					ImGui::SetTooltip("Build the mip chain after every pass that renders to this texture");
+
+				if (m_currentRT->Mipmaps) {
+					static const char* MIP_FILTER_NAMES[] = { "Average", "Minimum", "Maximum" };
+
+					ImGui::SameLine();
+					ImGui::PushItemWidth(-1);
+					int filter = (int)m_currentRT->MipFilter;
+					if (ImGui::Combo("##pui_rt_mipfilter", &filter, MIP_FILTER_NAMES, HARRAYSIZE(MIP_FILTER_NAMES))) {
+						m_currentRT->MipFilter = (MipChain::Filter)filter;
+						m_data->Parser.ModifyProject();
+						m_data->Renderer.InvalidatePassCache();
+					}
+					ImGui::PopItemWidth();
+				}
+
+				if (!canMip) {
+					ImGui::PopStyleVar();
+					ImGui::PopItemFlag();
+				}
+				ImGui::NextColumn();
+				ImGui::Separator();
+
 				
+				/* HISTORY */
+				ImGui::Text("Keep last frame:");
+				ImGui::NextColumn();
+				bool hasHistory = m_currentObj->History != nullptr;
+				if (ImGui::Checkbox("##pui_rt_history", &hasHistory))
+					m_data->Objects.SetRenderTextureHistory(std::string(m_itemName), hasHistory);
+				if (ImGui::IsItemHovered())
+					ImGui::SetTooltip("Adds the %s%s object with the previous frame's contents - the two textures are swapped before every frame, no copy pass is needed for feedback effects", m_itemName, RT_HISTORY_SUFFIX);
+				ImGui::NextColumn();
+				ImGui::Separator();
+
 				/* CLEAR? */
 				ImGui::Text("Clear:");
 				ImGui::NextColumn();
@@ -1169,6 +2039,16 @@ namespace ed
 					ImGui::EndCombo();
 				}
 				ImGui::PopItemWidth();
+				ImGui::NextColumn();
+				ImGui::Separator();
+
+				/* FILL */
+				ImGui::Text("Contents:");
+				if (ImGui::IsItemHovered())
+					ImGui::SetTooltip("Generate the contents on the GPU - the operation is saved with the project and runs again when the image is resized");
+				ImGui::NextColumn();
+				if (UIHelper::CreateFillEditor("pui_imgfill", m_fill, false, m_getFillSources()))
+					m_data->Objects.FillImage(std::string(m_itemName), m_fill);
 			}
 			else if (IsImage3D()) {
 				ed::Image3DObject* m_currentImg3D = m_currentObj->Image3D;
@@ -1214,6 +2094,16 @@ namespace ed
 					ImGui::EndCombo();
 				}
 				ImGui::PopItemWidth();
+				ImGui::NextColumn();
+				ImGui::Separator();
+
+				/* FILL */
+				ImGui::Text("Contents:");
+				if (ImGui::IsItemHovered())
+					ImGui::SetTooltip("Generate the contents on the GPU - the operation is saved with the project and runs again when the image is resized");
+				ImGui::NextColumn();
+				if (UIHelper::CreateFillEditor("pui_imgfill", m_fill, false, m_getFillSources()))
+					m_data->Objects.FillImage(std::string(m_itemName), m_fill);
 			}
 			else if (IsPlugin()) {
 				ImGui::Columns(1);
@@ -1229,6 +2119,19 @@ namespace ed
 			ImGui::TextWrapped("Right click on an item -> Properties");
 		}
 	}
+	std::vector<std::string> PropertyUI::m_getFillSources()
+	{
+		// 2D textures that an image can be copied from
+		std::vector<std::string> ret;
+		for (const std::string& name : m_data->Objects.GetObjects()) {
+			ObjectManagerItem* obj = m_data->Objects.GetObjectManagerItem(name);
+			if (obj == m_currentObj)
+				continue;
+			if (obj->Image != nullptr || (obj->RT != nullptr && !obj->RT->IsLayered()) || (obj->IsTexture && !obj->IsCube && !obj->IsTextureArray))
+				ret.push_back(name);
+		}
+		return ret;
+	}
 	void PropertyUI::Open(ed::PipelineItem * item)
 	{
 		if (item != nullptr) {
@@ -1260,5 +2163,11 @@ namespace ed
 
 		m_current = nullptr;
 		m_currentObj = obj;
+
+		m_fill = GPUFill::Operation();
+		if (obj != nullptr && obj->Image != nullptr)
+			m_fill = obj->Image->Fill;
+		else if (obj != nullptr && obj->Image3D != nullptr)
+			m_fill = obj->Image3D->Fill;
 	}
 }
\ No newline at end of file
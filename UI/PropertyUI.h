@@ -29,10 +29,12 @@ namespace ed
 		char m_itemName[64];
 
 		void m_init();
+		std::vector<std::string> m_getFillSources();
 
 		PipelineItem* m_current;
 		ObjectManagerItem* m_currentObj;
 
 		glm::ivec3 m_cachedGroupSize;
+		GPUFill::Operation m_fill; // settings of the fill editor of images
 	};
 }
\ No newline at end of file
@@ -0,0 +1,133 @@
+#include "ShaderTraceUI.h"
+#include "../Objects/Settings.h"
+#include <imgui/imgui.h>
+#include <algorithm>
+
+namespace ed
+{
+	static const char* getStageName(int stage)
+	{
+		switch (stage) {
+		case 0: return "VS";
+		case 1: return "PS";
+		case 2: return "GS";
+		case 3: return "CS";
+		case 4: return "TS";
+		case 5: return "MS";
+		}
+		return "?";
+	}
+
+	void ShaderTraceUI::OnEvent(const SDL_Event& e)
+	{}
+	void ShaderTraceUI::Update(float delta)
+	{
+		if (!ShaderTrace::IsSupported()) {
+			ImGui::TextDisabled("printf() needs OpenGL 4.3 or GL_ARB_shader_storage_buffer_object.");
+			return;
+		}
+
+		ShaderTrace& trace = m_data->Renderer.GetShaderTrace();
+		if (!m_paused && trace.GetRevision() != m_revision) {
+			m_revision = trace.GetRevision();
+			m_records = trace.GetRecords();
+			m_written = trace.GetWritten();
+
+			m_passes.clear();
+			for (const auto& rec : m_records)
+				if (std::find(m_passes.begin(), m_passes.end(), rec.Pass) == m_passes.end())
+					m_passes.push_back(rec.Pass);
+
+			m_dirty = true;
+		}
+
+		if (!trace.IsActive()) {
+			ImGui::TextWrapped("Call printf(\"format\", args...) in a GLSL shader to trace it on the GPU. The arguments are formatted with %%d, %%i, %%u, %%x, %%f, %%e & %%g, vectors with %%v2f, %%v3d, %%v4u...");
+			return;
+		}
+
+		ImGui::Checkbox("Pause##trace_pause", &m_paused);
+		ImGui::SameLine();
+
+		ImGui::PushItemWidth(200 * Settings::Instance().DPIScale);
+		if (ImGui::BeginCombo("##trace_pass", m_pass.empty() ? "All passes" : m_pass.c_str())) {
+			if (ImGui::Selectable("All passes", m_pass.empty())) {
+				m_pass.clear();
+				m_dirty = true;
+			}
+			for (const auto& pass : m_passes)
+				if (ImGui::Selectable(pass.c_str(), pass == m_pass)) {
+					m_pass = pass;
+					m_dirty = true;
+				}
+			ImGui::EndCombo();
+		}
+		ImGui::PopItemWidth();
+		ImGui::SameLine();
+
+		// pixel for the pixel shaders, vertex & instance for the vertex shaders, global invocation for the compute shaders
+		m_dirty |= ImGui::Checkbox("ID##trace_filter_id", &m_filterID);
+		ImGui::SameLine();
+		ImGui::PushItemWidth(200 * Settings::Instance().DPIScale);
+		if (ImGui::InputInt3("##trace_id", m_id)) {
+			m_filterID = true;
+			m_dirty = true;
+		}
+		ImGui::PopItemWidth();
+
+		if (m_dirty)
+			m_filter();
+
+		ImGui::SameLine();
+		if (m_written > SHADER_TRACE_CAPACITY)
+			ImGui::Text("%d shown, %u written (%u overwritten)", (int)m_filtered.size(), m_written, m_written - SHADER_TRACE_CAPACITY);
+		else
+			ImGui::Text("%d shown, %u written", (int)m_filtered.size(), m_written);
+
+		ImGui::Separator();
+
+		ImGui::BeginChild("##trace_container", ImVec2(-1, -1));
+
+		ImGui::Columns(4);
+		ImGui::SetColumnWidth(0, 150.0f * Settings::Instance().DPIScale);
+		ImGui::SetColumnWidth(1, 50.0f * Settings::Instance().DPIScale);
+		ImGui::SetColumnWidth(2, 150.0f * Settings::Instance().DPIScale);
+
+		ImGui::Text("Pass"); ImGui::NextColumn();
+		ImGui::Text("Stage"); ImGui::NextColumn();
+		ImGui::Text("ID"); ImGui::NextColumn();
+		ImGui::Text("Output"); ImGui::NextColumn();
+		ImGui::Separator();
+
+		ImGuiListClipper clipper;
+		clipper.Begin(m_filtered.size());
+		while (clipper.Step()) {
+			for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+				const ShaderTrace::Record& rec = m_records[m_filtered[i]];
+				ImGui::Text("%s", rec.Pass.c_str()); ImGui::NextColumn();
+				ImGui::Text("%s", getStageName(rec.Stage)); ImGui::NextColumn();
+				ImGui::Text("%u, %u, %u", rec.ID.x, rec.ID.y, rec.ID.z); ImGui::NextColumn();
+				ImGui::TextUnformatted(rec.Text.c_str()); ImGui::NextColumn();
+			}
+		}
+		clipper.End();
+
+		ImGui::Columns(1);
+		ImGui::EndChild();
+	}
+	void ShaderTraceUI::m_filter()
+	{
+		m_dirty = false;
+		m_filtered.clear();
+
+		for (int i = 0; i < m_records.size(); i++) {
+			const ShaderTrace::Record& rec = m_records[i];
+			if (!m_pass.empty() && rec.Pass != m_pass)
+				continue;
+			if (m_filterID && (rec.ID.x != (unsigned int)m_id[0] || rec.ID.y != (unsigned int)m_id[1] || rec.ID.z != (unsigned int)m_id[2]))
+				continue;
+
+			m_filtered.push_back(i);
+		}
+	}
+}
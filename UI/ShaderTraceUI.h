@@ -0,0 +1,36 @@
+#pragma once
+#include "UIView.h"
+
+namespace ed
+{
+	// printf() records of the last traced frame, grouped by pass & filtered by the pixel or thread that wrote them
+	class ShaderTraceUI : public UIView
+	{
+	public:
+		ShaderTraceUI(GUIManager* ui, ed::InterfaceManager* objects, const std::string& name = "", bool visible = true) :
+			UIView(ui, objects, name, visible),
+			m_revision(0),
+			m_written(0),
+			m_paused(false),
+			m_filterID(false),
+			m_dirty(true)
+		{
+			m_id[0] = m_id[1] = m_id[2] = 0;
+		}
+
+		virtual void OnEvent(const SDL_Event& e);
+		virtual void Update(float delta);
+
+	private:
+		void m_filter();
+
+		std::vector<ShaderTrace::Record> m_records; // copy so that the list can be paused
+		std::vector<int> m_filtered;
+		std::vector<std::string> m_passes;
+		unsigned int m_revision, m_written;
+
+		std::string m_pass; // empty -> all
+		bool m_paused, m_filterID, m_dirty;
+		int m_id[3];
+	};
+}
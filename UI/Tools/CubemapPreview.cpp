@@ -70,9 +70,7 @@ namespace ed
     CubemapPreview::~CubemapPreview() {
         glDeleteBuffers(1, &m_fsVBO);
         glDeleteVertexArrays(1, &m_fsVAO);
-        glDeleteTextures(1, &m_cubeTex);
-        glDeleteTextures(1, &m_cubeDepth);
-        glDeleteFramebuffers(1, &m_cubeFBO);
+        m_prune(-1.0f);
     }
     void CubemapPreview::Init(int w, int h)
     {
@@ -125,13 +123,50 @@ namespace ed
 		glUniform1i(glGetUniformLocation(m_cubeShader, "cubemap"), 0);
 
 		m_fsVAO = ed::eng::GeometryFactory::CreatePlane(m_fsVBO, w, h, gl::CreateDefaultInputLayout());
-		m_cubeFBO = gl::CreateSimpleFramebuffer(w, h, m_cubeTex, m_cubeDepth);
-		
 	}
-    void CubemapPreview::Draw(GLuint tex)
+    GLuint CubemapPreview::GetThumbnail(GLuint tex, unsigned int generation)
+    {
+		float now = m_clock.getElapsedTime().asSeconds();
+
+		auto it = m_thumbs.find(tex);
+		if (it == m_thumbs.end()) {
+			Thumbnail thumb;
+			thumb.FBO = gl::CreateSimpleFramebuffer(m_w, m_h, thumb.Color, thumb.Depth);
+			thumb.Generation = generation;
+			thumb.Drawn = now;
+			m_draw(thumb, tex);
+
+			it = m_thumbs.insert(std::make_pair(tex, thumb)).first;
+		} else if (it->second.Generation != generation || now - it->second.Drawn >= CUBEMAP_PREVIEW_REFRESH) {
+			it->second.Generation = generation;
+			it->second.Drawn = now;
+			m_draw(it->second, tex);
+		}
+		it->second.Used = now;
+
+		m_prune(now);
+
+		return it->second.Color;
+    }
+    void CubemapPreview::m_prune(float now)
+    {
+		// now < 0 -> delete all of them
+		for (auto it = m_thumbs.begin(); it != m_thumbs.end();) {
+			if (now >= 0.0f && now - it->second.Used < CUBEMAP_PREVIEW_KEEP) {
+				it++;
+				continue;
+			}
+
+			glDeleteTextures(1, &it->second.Color);
+			glDeleteTextures(1, &it->second.Depth);
+			glDeleteFramebuffers(1, &it->second.FBO);
+			it = m_thumbs.erase(it);
+		}
+    }
+    void CubemapPreview::m_draw(const Thumbnail& thumb, GLuint tex)
     {
 		// bind fbo and buffers
-		glBindFramebuffer(GL_FRAMEBUFFER, m_cubeFBO);
+		glBindFramebuffer(GL_FRAMEBUFFER, thumb.FBO);
 		static const GLuint fboBuffers[] = { GL_COLOR_ATTACHMENT0 };
 		glDrawBuffers(1, fboBuffers);
 		glClearBufferfi(GL_DEPTH_STENCIL, 0, 1.0f, 0);
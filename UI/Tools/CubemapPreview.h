@@ -1,4 +1,7 @@
 #pragma once
+#include <unordered_map>
+#include <SFML/System/Clock.hpp>
+
 #include <GL/glew.h>
 #if defined(__APPLE__)
 	#include <OpenGL/gl.h>
@@ -6,6 +9,9 @@
 	#include <GL/gl.h>
 #endif
 
+#define CUBEMAP_PREVIEW_REFRESH 1.0f // seconds - cubemaps whose generation isn't known are still redrawn at this rate
+#define CUBEMAP_PREVIEW_KEEP 5.0f // seconds - unwraps that weren't requested for this long are deleted
+
 namespace ed
 {
     class CubemapPreview
@@ -15,15 +21,27 @@ namespace ed
         ~CubemapPreview();
         
         void Init(int w, int h);
-        void Draw(GLuint tex);
-        inline GLuint GetTexture() { return m_cubeTex; }
+
+        // unwrap of the cubemap, only drawn again if the generation differs from the one of the cached unwrap
+        GLuint GetThumbnail(GLuint tex, unsigned int generation = 0);
 
     private:
+        struct Thumbnail
+        {
+            GLuint FBO, Color, Depth;
+            unsigned int Generation;
+            float Drawn, Used; // m_clock time
+        };
+        void m_draw(const Thumbnail& thumb, GLuint tex);
+        void m_prune(float now);
+
         float m_w, m_h;
 
 		GLuint m_cubeShader;
-		GLuint m_cubeFBO, m_cubeTex, m_cubeDepth;
 		GLuint m_fsVAO, m_fsVBO;
 		GLuint m_uMatWVPLoc;
+
+		std::unordered_map<GLuint, Thumbnail> m_thumbs; // cubemap -> unwrap
+		sf::Clock m_clock;
     };
-}
\ No newline at end of file
+}
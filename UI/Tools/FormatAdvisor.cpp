@@ -0,0 +1,253 @@
+#include "FormatAdvisor.h"
+#include "../../Objects/ObjectManager.h"
+#include "../../Objects/PipelineManager.h"
+#include "../../Objects/RenderTargetPool.h"
+
+#include <algorithm>
+#include <math.h>
+
+namespace ed
+{
+	enum class FormatFamily
+	{
+		Unknown,
+		Float32,
+		Float16,
+		Small, // R11F_G11F_B10F
+		Unorm8
+	};
+	static FormatFamily getFamily(GLuint format, int& channels)
+	{
+		switch (format) {
+		case GL_R32F: channels = 1; return FormatFamily::Float32;
+		case GL_RG32F: channels = 2; return FormatFamily::Float32;
+		case GL_RGB32F: channels = 3; return FormatFamily::Float32;
+		case GL_RGBA32F: channels = 4; return FormatFamily::Float32;
+		case GL_R16F: channels = 1; return FormatFamily::Float16;
+		case GL_RG16F: channels = 2; return FormatFamily::Float16;
+		case GL_RGB16F: channels = 3; return FormatFamily::Float16;
+		case GL_RGBA16F: channels = 4; return FormatFamily::Float16;
+		case GL_R11F_G11F_B10F: channels = 3; return FormatFamily::Small;
+		case GL_R8: channels = 1; return FormatFamily::Unorm8;
+		case GL_RG8: channels = 2; return FormatFamily::Unorm8;
+		case GL_RGBA: case GL_RGBA8: channels = 4; return FormatFamily::Unorm8;
+		}
+		channels = 0;
+		return FormatFamily::Unknown;
+	}
+	// RGB formats aren't required to be color renderable, the three channel data stays in RGBA
+	static GLuint getFormat(FormatFamily family, int channels)
+	{
+		static const GLuint float32[] = { GL_R32F, GL_RG32F, GL_RGBA32F, GL_RGBA32F };
+		static const GLuint float16[] = { GL_R16F, GL_RG16F, GL_RGBA16F, GL_RGBA16F };
+		static const GLuint unorm8[] = { GL_R8, GL_RG8, GL_RGBA8, GL_RGBA8 };
+
+		int index = std::max(std::min(channels, 4), 1) - 1;
+		if (family == FormatFamily::Float32) return float32[index];
+		if (family == FormatFamily::Float16) return float16[index];
+		if (family == FormatFamily::Small) return GL_R11F_G11F_B10F;
+		return unorm8[index];
+	}
+	// the format keeps FORMAT_ADVISOR_*_STEPS distinct values between the channel's min & max, even at the largest magnitude
+	static bool isPrecise(float minValue, float maxValue, int mantissa, float limit, int steps)
+	{
+		float maxAbs = std::max(fabsf(minValue), fabsf(maxValue));
+		if (maxAbs > limit)
+			return false;
+
+		float range = maxValue - minValue;
+		float step = ldexpf(maxAbs, -mantissa);
+		return step <= (range > 0.0f ? range : maxAbs) / steps;
+	}
+	static size_t getBytes(GLuint format, glm::ivec2 size, bool mipmaps)
+	{
+		size_t ret = 0;
+		while (true) {
+			ret += RenderTargetPool::GetTexelSize(format) * size.x * size.y;
+			if (!mipmaps || (size.x <= 1 && size.y <= 1))
+				break;
+			size = glm::max(size / 2, glm::ivec2(1));
+		}
+		return ret;
+	}
+
+	FormatAdvisor::~FormatAdvisor()
+	{
+		Cancel();
+	}
+	void FormatAdvisor::Start(ObjectManager* objects)
+	{
+		Cancel();
+		m_suggestions.clear();
+
+		for (const std::string& name : objects->GetObjects()) {
+			ObjectManagerItem* item = objects->GetObjectManagerItem(name);
+			if (item == nullptr || item->RT == nullptr || item->RT->IsLayered() || item->Texture == 0)
+				continue;
+
+			int channels = 0;
+			if (getFamily(item->RT->Format, channels) == FormatFamily::Unknown)
+				continue;
+
+			Target target;
+			target.Name = name;
+			target.Texture = item->Texture;
+			target.Samples = 0;
+			target.Min = glm::vec4(INFINITY);
+			target.Max = glm::vec4(-INFINITY);
+			target.NaN = target.Inf = glm::uvec4(0);
+			m_targets.push_back(target);
+		}
+	}
+	void FormatAdvisor::Cancel()
+	{
+		for (auto& target : m_targets)
+			m_stats.Release(target.Query);
+		m_targets.clear();
+	}
+	void FormatAdvisor::Update(ObjectManager* objects, PipelineManager* pipeline)
+	{
+		if (m_targets.empty())
+			return;
+
+		bool done = true;
+		for (int i = 0; i < m_targets.size(); i++) {
+			Target& target = m_targets[i];
+
+			// deleted, resized or its format was changed while we were sampling it
+			ObjectManagerItem* item = objects->GetObjectManagerItem(target.Name);
+			if (item == nullptr || item->RT == nullptr || item->Texture != target.Texture) {
+				m_stats.Release(target.Query);
+				m_targets.erase(m_targets.begin() + i);
+				i--;
+				continue;
+			}
+
+			if (m_stats.Poll(target.Query)) {
+				const TextureStatistics::Result& res = target.Query.Last;
+				target.Min = glm::min(target.Min, res.Min);
+				target.Max = glm::max(target.Max, res.Max);
+				target.NaN += res.NaN;
+				target.Inf += res.Inf;
+				target.Samples++;
+			}
+
+			if (target.Samples < FORMAT_ADVISOR_FRAMES) {
+				done = false;
+
+				// the next sample is taken once the last one is back, so the samples come from different frames
+				if (!m_stats.IsPending(target.Query) && !m_stats.Start(target.Query, target.Texture))
+					target.Samples = FORMAT_ADVISOR_FRAMES + 1; // can't be read, skipped
+			}
+		}
+
+		if (!done)
+			return;
+
+		for (const auto& target : m_targets)
+			if (target.Samples == FORMAT_ADVISOR_FRAMES)
+				m_suggest(objects, pipeline, target);
+		Cancel();
+
+		std::stable_sort(m_suggestions.begin(), m_suggestions.end(), [](const Suggestion& a, const Suggestion& b) {
+			return a.CurrentBytes - a.SuggestedBytes > b.CurrentBytes - b.SuggestedBytes;
+		});
+	}
+	float FormatAdvisor::GetProgress()
+	{
+		if (m_targets.empty())
+			return 1.0f;
+
+		int samples = 0;
+		for (const auto& target : m_targets)
+			samples += std::min(target.Samples, FORMAT_ADVISOR_FRAMES);
+		return samples / (float)(m_targets.size() * FORMAT_ADVISOR_FRAMES);
+	}
+	void FormatAdvisor::Remove(const std::string& name)
+	{
+		for (int i = 0; i < m_suggestions.size(); i++)
+			if (m_suggestions[i].Name == name) {
+				m_suggestions.erase(m_suggestions.begin() + i);
+				break;
+			}
+	}
+	void FormatAdvisor::m_suggest(ObjectManager* objects, PipelineManager* pipeline, const Target& target)
+	{
+		RenderTextureObject* rt = objects->GetRenderTexture(target.Name);
+		if (rt == nullptr)
+			return;
+
+		int channels = 0;
+		FormatFamily family = getFamily(rt->Format, channels);
+
+		// the trailing channels that always hold the sampler's default can be dropped without touching the shaders
+		const float defaults[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+		int needed = 1;
+		for (int c = 1; c < channels; c++)
+			if (target.NaN[c] != 0 || target.Inf[c] != 0 || target.Min[c] != defaults[c] || target.Max[c] != defaults[c])
+				needed = c + 1;
+
+		bool fitsHalf = true, fitsSmall = needed <= 3, isPositive = true;
+		for (int c = 0; c < needed; c++) {
+			fitsHalf = fitsHalf && isPrecise(target.Min[c], target.Max[c], 10, 65504.0f, FORMAT_ADVISOR_HALF_STEPS);
+			fitsSmall = fitsSmall && isPrecise(target.Min[c], target.Max[c], c == 2 ? 5 : 6, 64512.0f, FORMAT_ADVISOR_SMALL_STEPS);
+			isPositive = isPositive && target.Min[c] >= 0.0f && target.NaN[c] == 0;
+		}
+
+		GLuint suggested = rt->Format;
+		std::string reason;
+		bool lossy = false;
+		if (family == FormatFamily::Float32 || family == FormatFamily::Float16) {
+			bool half = family == FormatFamily::Float16 || fitsHalf;
+			suggested = getFormat(half ? FormatFamily::Float16 : FormatFamily::Float32, needed);
+			if (family == FormatFamily::Float32 && half)
+				reason = "values fit in 16 bit floats";
+
+			// unsigned & only 6/5 bits of mantissa, half the size of RGBA16F
+			if (needed == 3 && isPositive && fitsSmall) {
+				suggested = GL_R11F_G11F_B10F;
+				reason = "positive RGB values, lower precision";
+				lossy = true;
+			}
+		} else if (family == FormatFamily::Small && needed < 3)
+			suggested = getFormat(FormatFamily::Float16, needed);
+		else if (family == FormatFamily::Unorm8)
+			suggested = getFormat(FormatFamily::Unorm8, needed);
+
+		if (RenderTargetPool::GetTexelSize(suggested) >= RenderTargetPool::GetTexelSize(rt->Format))
+			return;
+
+		if (needed < channels) {
+			std::string unused = std::string("RGBA").substr(needed, channels - needed) + " unused";
+			reason = reason.empty() ? unused : (reason + ", " + unused);
+		}
+
+		Suggestion ret;
+		ret.Name = target.Name;
+		ret.Current = rt->Format;
+		ret.Suggested = suggested;
+		ret.Reason = reason;
+		ret.Lossy = lossy;
+
+		glm::ivec2 size = objects->GetRenderTextureSize(target.Name);
+		ret.CurrentBytes = getBytes(rt->Format, size, rt->Mipmaps);
+		ret.SuggestedBytes = getBytes(suggested, size, rt->Mipmaps);
+
+		// every pass that draws to it or samples it
+		int accesses = 0;
+		for (PipelineItem* pass : pipeline->GetList()) {
+			if (pass->Type == PipelineItem::ItemType::ShaderPass) {
+				pipe::ShaderPass* data = (pipe::ShaderPass*)pass->Data;
+				for (int i = 0; i < data->RTCount; i++)
+					if (data->RenderTextures[i] == target.Texture)
+						accesses++;
+			}
+
+			const std::vector<GLuint>& binds = objects->GetBindList(pass);
+			accesses += std::count(binds.begin(), binds.end(), target.Texture);
+		}
+		ret.Bandwidth = (getBytes(rt->Format, size, false) - getBytes(suggested, size, false)) * accesses;
+
+		m_suggestions.push_back(ret);
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include "TextureStatistics.h"
+
+#include <string>
+#include <vector>
+
+#define FORMAT_ADVISOR_FRAMES 8		  // statistics samples of every render texture, one per frame
+#define FORMAT_ADVISOR_HALF_STEPS 256 // distinct values that a 16 bit float must keep over the channel's range
+#define FORMAT_ADVISOR_SMALL_STEPS 64 // same for the 11 & 10 bit floats of R11F_G11F_B10F
+
+namespace ed
+{
+	class ObjectManager;
+	class PipelineManager;
+
+	// samples the values of every 2D render texture over a few frames and suggests cheaper formats for them:
+	// 32 -> 16 bit floats when the range & precision fit, R11F_G11F_B10F for positive RGB data and dropping the
+	// trailing channels that always hold the value that the sampler returns for a missing channel (G, B = 0, A = 1)
+	class FormatAdvisor
+	{
+	public:
+		struct Suggestion
+		{
+			std::string Name;
+			GLuint Current, Suggested;
+			size_t CurrentBytes, SuggestedBytes; // with the mip chain
+			size_t Bandwidth;					 // bytes per frame that aren't read/written anymore, every access touches every texel once
+			std::string Reason;
+			bool Lossy; // some precision is lost, the values don't survive the conversion as they are
+		};
+
+		~FormatAdvisor();
+
+		void Start(ObjectManager* objects);
+		void Cancel();
+		void Update(ObjectManager* objects, PipelineManager* pipeline); // main thread, once per frame
+
+		inline bool IsRunning() { return !m_targets.empty(); }
+		float GetProgress();
+
+		inline std::vector<Suggestion>& GetSuggestions() { return m_suggestions; }
+		void Remove(const std::string& name);
+
+	private:
+		struct Target
+		{
+			std::string Name;
+			GLuint Texture;
+			TextureStatistics::Query Query;
+			int Samples;
+
+			glm::vec4 Min, Max;
+			glm::uvec4 NaN, Inf;
+		};
+
+		void m_suggest(ObjectManager* objects, PipelineManager* pipeline, const Target& target);
+
+		TextureStatistics m_stats;
+		std::vector<Target> m_targets;
+		std::vector<Suggestion> m_suggestions;
+	};
+}
@@ -1,8 +1,12 @@
 #include "Magnifier.h"
 #include "../../Objects/Logger.h"
 
+#include <imgui/imgui.h>
 #include <vector>
 #include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
 
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -43,6 +47,9 @@ namespace ed
 		m_h = 10;
 		m_selecting = false;
 		m_dragging = false;
+		m_readoutEnabled = false;
+		m_readoutTooLarge = false;
+		m_texSize = glm::ivec2(0, 0);
 
 		
 		GLint success = 0;
@@ -155,11 +162,11 @@ namespace ed
 			if (m_size.y >= m_size.x)
 				m_size.x = m_size.y;
 
-			if (m_size.x < 25.0f / m_w && m_size.y < 25.0f / m_h)
+			if (m_size.x < m_getMinSize() && m_size.y < 25.0f / m_h)
 				m_size = oldSize;
 			
-			m_size.x = std::max<float>(std::min<float>(m_size.x, 1.0f), 25.0f / m_w);
-			m_size.y = std::max<float>(std::min<float>(m_size.y, 1.0f), 25.0f / m_w);
+			m_size.x = std::max<float>(std::min<float>(m_size.x, 1.0f), m_getMinSize());
+			m_size.y = std::max<float>(std::min<float>(m_size.y, 1.0f), m_getMinSize());
 
 			if (m_pos.x + m_size.x > 1.0f)
 				m_pos.x = 1 - m_size.x;
@@ -177,8 +184,8 @@ namespace ed
 	{
 		float oldZoomWidth = m_size.x, oldZoomHeight = m_size.y;
 
-		m_size.x = std::max<float>(std::min<float>(m_size.x * w, 1.0f), 25.0f / m_w);
-		m_size.y = std::max<float>(std::min<float>(m_size.y * w, 1.0f), 25.0f / m_w);
+		m_size.x = std::max<float>(std::min<float>(m_size.x * w, 1.0f), m_getMinSize());
+		m_size.y = std::max<float>(std::min<float>(m_size.y * w, 1.0f), m_getMinSize());
 
 		if (mouseAsPosition) {
 			float zx = (m_pos.x + oldZoomWidth * m_mousePos.x) - m_size.x/2;
@@ -270,5 +277,164 @@ namespace ed
 		glDrawArrays(GL_TRIANGLES, 0, 6);
 	
 		glEnable(GL_CULL_FACE);
+	}	float Magnifier::m_getMinSize()
+	{
+		float ret = 25.0f / m_w;
+		if (m_readoutEnabled && m_texSize.x > 0)
+			ret = std::min<float>(ret, (float)MAGNIFIER_READOUT_MIN_TEXELS / m_texSize.x);
+		return ret;
+	}
+
+	Magnifier::Readout::Readout()
+	{
+		glGenFramebuffers(1, &FBO);
+		glGenBuffers(MAGNIFIER_READOUT_PBOS, PBO);
+		for (int i = 0; i < MAGNIFIER_READOUT_PBOS; i++) {
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, PBO[i]);
+			glBufferData(GL_PIXEL_PACK_BUFFER, MAGNIFIER_READOUT_MAX * MAGNIFIER_READOUT_MAX * 4 * sizeof(GLuint), nullptr, GL_STREAM_READ);
+			Fence[i] = 0;
+			Rect[i] = glm::ivec4(0);
+			Type[i] = GL_FLOAT;
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		Next = 0;
+		DataRect = glm::ivec4(0);
+		DataType = GL_FLOAT;
+	}
+	Magnifier::Readout::~Readout()
+	{
+		for (int i = 0; i < MAGNIFIER_READOUT_PBOS; i++)
+			if (Fence[i] != 0)
+				glDeleteSync(Fence[i]);
+		glDeleteBuffers(MAGNIFIER_READOUT_PBOS, PBO);
+		glDeleteFramebuffers(1, &FBO);
+	}
+	void Magnifier::UpdateReadout(GLuint tex)
+	{
+		if (!m_readoutEnabled || tex == 0)
+			return;
+
+		if (m_readout == nullptr)
+			m_readout = std::make_shared<Readout>();
+		Readout& r = *m_readout;
+
+		// pick up the finished reads, oldest first
+		for (int i = 0; i < MAGNIFIER_READOUT_PBOS; i++) {
+			int slot = (r.Next + i) % MAGNIFIER_READOUT_PBOS;
+			if (r.Fence[slot] == 0)
+				continue;
+
+			GLenum status = glClientWaitSync(r.Fence[slot], 0, 0);
+			if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+				break;
+
+			glDeleteSync(r.Fence[slot]);
+			r.Fence[slot] = 0;
+
+			r.DataRect = r.Rect[slot];
+			r.DataType = r.Type[slot];
+			r.Data.resize(r.DataRect.z * r.DataRect.w * 4);
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, r.PBO[slot]);
+			glGetBufferSubData(GL_PIXEL_PACK_BUFFER, 0, r.Data.size() * sizeof(GLuint), r.Data.data());
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		}
+
+		// integer formats can't be read as floats, depth textures can't be attached as a color target
+		GLint type = GL_NONE;
+		glBindTexture(GL_TEXTURE_2D, tex);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &m_texSize.x);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &m_texSize.y);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_RED_TYPE, &type);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		if (type == GL_NONE || m_texSize.x <= 0 || m_texSize.y <= 0)
+			return;
+
+		glm::ivec2 start(floorf(m_pos.x * m_texSize.x), floorf(m_pos.y * m_texSize.y));
+		glm::ivec2 end(ceilf((m_pos.x + m_size.x) * m_texSize.x), ceilf((m_pos.y + m_size.y) * m_texSize.y));
+		start = glm::clamp(start, glm::ivec2(0), m_texSize);
+		end = glm::clamp(end, glm::ivec2(0), m_texSize);
+		glm::ivec2 size = end - start;
+
+		m_readoutTooLarge = size.x > MAGNIFIER_READOUT_MAX || size.y > MAGNIFIER_READOUT_MAX;
+		if (m_readoutTooLarge || size.x <= 0 || size.y <= 0 || r.Fence[r.Next] != 0)
+			return;
+
+		GLenum format = GL_RGBA, readType = GL_FLOAT;
+		if (type == GL_INT || type == GL_UNSIGNED_INT) {
+			format = GL_RGBA_INTEGER;
+			readType = type;
+		}
+
+		int slot = r.Next;
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, r.FBO);
+		glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex, 0);
+		glReadBuffer(GL_COLOR_ATTACHMENT0);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, r.PBO[slot]);
+		glPixelStorei(GL_PACK_ALIGNMENT, 4);
+		glReadPixels(start.x, start.y, size.x, size.y, format, readType, nullptr);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+		r.Fence[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		r.Rect[slot] = glm::ivec4(start, size);
+		r.Type[slot] = readType;
+		r.Next = (slot + 1) % MAGNIFIER_READOUT_PBOS;
+	}
+	void Magnifier::RenderReadout(const glm::vec2& pos, const glm::vec2& size)
+	{
+		if (!m_readoutEnabled || m_readout == nullptr || m_texSize.x <= 0 || m_texSize.y <= 0)
+			return;
+
+		ImDrawList* drawList = ImGui::GetWindowDrawList();
+		ImVec2 clipMin(pos.x, pos.y), clipMax(pos.x + size.x, pos.y + size.y);
+		drawList->PushClipRect(clipMin, clipMax, true);
+
+		// every texel needs room for four lines of values
+		float texelW = size.x / (m_size.x * m_texSize.x);
+		float texelH = size.y / (m_size.y * m_texSize.y);
+		float lineH = ImGui::GetTextLineHeight();
+		bool fits = texelW >= ImGui::CalcTextSize("-0.00000").x + 4 && texelH >= lineH * 4 + 4;
+
+		const Readout& r = *m_readout;
+		if (m_readoutTooLarge || !fits || r.DataRect.z == 0) {
+			const char* hint = m_readoutTooLarge || !fits ? "Zoom in to see the values" : "Reading...";
+			drawList->AddText(ImVec2(pos.x + 5, pos.y + 5), IM_COL32(0, 0, 0, 255), hint);
+			drawList->AddText(ImVec2(pos.x + 4, pos.y + 4), IM_COL32(255, 255, 255, 255), hint);
+			drawList->PopClipRect();
+			return;
+		}
+
+		const ImU32 colors[4] = { IM_COL32(255, 110, 110, 255), IM_COL32(110, 255, 110, 255), IM_COL32(130, 170, 255, 255), IM_COL32(255, 255, 255, 255) };
+		char text[32];
+		for (int y = 0; y < r.DataRect.w; y++) {
+			// texture rows go up, the screen rows go down
+			float sy = pos.y + size.y - (r.DataRect.y + y + 1 - m_pos.y * m_texSize.y) * texelH;
+			for (int x = 0; x < r.DataRect.z; x++) {
+				float sx = pos.x + (r.DataRect.x + x - m_pos.x * m_texSize.x) * texelW;
+				if (sx + texelW < clipMin.x || sx > clipMax.x || sy + texelH < clipMin.y || sy > clipMax.y)
+					continue;
+
+				const GLuint* texel = &r.Data[(y * r.DataRect.z + x) * 4];
+				for (int c = 0; c < 4; c++) {
+					if (r.DataType == GL_INT)
+						snprintf(text, sizeof(text), "%d", (int)texel[c]);
+					else if (r.DataType == GL_UNSIGNED_INT)
+						snprintf(text, sizeof(text), "%u", texel[c]);
+					else {
+						float val;
+						memcpy(&val, &texel[c], sizeof(val));
+						snprintf(text, sizeof(text), "%.4g", val);
+					}
+
+					ImVec2 textPos(sx + 2, sy + 2 + c * lineH);
+					drawList->AddText(ImVec2(textPos.x + 1, textPos.y + 1), IM_COL32(0, 0, 0, 255), text);
+					drawList->AddText(textPos, colors[c], text);
+				}
+			}
+		}
+
+		drawList->PopClipRect();
 	}
 }
\ No newline at end of file
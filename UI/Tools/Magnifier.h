@@ -7,6 +7,12 @@
 #endif
 
 #include <glm/glm.hpp>
+#include <memory>
+#include <vector>
+
+#define MAGNIFIER_READOUT_MAX 32 // texels per side that the readout reads back
+#define MAGNIFIER_READOUT_MIN_TEXELS 4 // the zoom can go down to this many texels while the readout is on
+#define MAGNIFIER_READOUT_PBOS 3 // reads that can be in flight
 
 namespace ed
 {
@@ -33,7 +39,36 @@ namespace ed
 		void RebuildVBO(int w, int h);
 		void Render();
 
+		// live values of the zoomed texels - only that rectangle is read back, without waiting for the GPU
+		inline void SetReadout(bool enabled) { m_readoutEnabled = enabled; }
+		inline bool IsReadoutEnabled() { return m_readoutEnabled; }
+		void UpdateReadout(GLuint tex); // call once per frame with the texture that's shown
+		void RenderReadout(const glm::vec2& pos, const glm::vec2& size); // on top of the image, in screen coordinates
+
 	private:
+		float m_getMinSize();
+
+		struct Readout
+		{
+			Readout();
+			~Readout();
+
+			GLuint FBO;
+			GLuint PBO[MAGNIFIER_READOUT_PBOS];
+			GLsync Fence[MAGNIFIER_READOUT_PBOS];
+			glm::ivec4 Rect[MAGNIFIER_READOUT_PBOS]; // x, y, w, h in texels
+			GLenum Type[MAGNIFIER_READOUT_PBOS];
+			int Next;
+
+			// the last read that finished
+			glm::ivec4 DataRect;
+			GLenum DataType; // GL_FLOAT, GL_INT or GL_UNSIGNED_INT
+			std::vector<GLuint> Data; // RGBA
+		};
+		std::shared_ptr<Readout> m_readout; // shared by the copies, the GL objects are deleted with the last one
+		bool m_readoutEnabled, m_readoutTooLarge;
+		glm::ivec2 m_texSize;
+
 		glm::vec2 m_mousePos;
 		glm::vec2 m_pos, m_size;
 		glm::vec2 m_posStart, m_zoomDrag; // m_zoomDrag -> m_lastDrag
@@ -0,0 +1,372 @@
+#include "TextureStatistics.h"
+#include "../../Objects/Logger.h"
+#include "../../Engine/GLUtils.h"
+
+#include <algorithm>
+#include <string.h>
+
+// every pass sees the same buffers - the values are ordered uints so that atomicMin/Max work on floats too
+const char* TEXSTATS_COMMON = R"(
+#version 430
+
+uniform SAMPLER tex;
+
+layout(std430, binding = 0) buffer Results
+{
+	uint minBits[4];
+	uint maxBits[4];
+	uint nanCount[4];
+	uint infCount[4];
+	vec4 sum;
+	uint histogram[4 * BINS];
+};
+layout(std430, binding = 1) buffer Partials
+{
+	vec4 partials[];
+};
+
+uint toOrdered(float f)
+{
+	uint u = floatBitsToUint(f);
+	return (u & 0x80000000u) != 0u ? ~u : (u | 0x80000000u);
+}
+float fromOrdered(uint u)
+{
+	return uintBitsToFloat((u & 0x80000000u) != 0u ? (u & 0x7FFFFFFFu) : ~u);
+}
+// bit tests - isnan() & isinf() can be optimized away
+bool isNaN(float f) { return (floatBitsToUint(f) & 0x7FFFFFFFu) > 0x7F800000u; }
+bool isInf(float f) { return (floatBitsToUint(f) & 0x7FFFFFFFu) == 0x7F800000u; }
+)";
+
+const char* TEXSTATS_REDUCE = R"(
+layout(local_size_x = 16, local_size_y = 16) in;
+
+shared vec4 sSum[256];
+shared uint sMin[4], sMax[4], sNaN[4], sInf[4];
+
+void main()
+{
+	uint li = gl_LocalInvocationIndex;
+	if (li < 4u) {
+		sMin[li] = 0xFFFFFFFFu;
+		sMax[li] = 0u;
+		sNaN[li] = sInf[li] = 0u;
+	}
+	barrier();
+
+	ivec2 pos = ivec2(gl_GlobalInvocationID.xy);
+	vec4 finite = vec4(0.0f);
+	if (all(lessThan(pos, textureSize(tex, 0)))) {
+		vec4 val = vec4(texelFetch(tex, pos, 0));
+		for (int c = 0; c < 4; c++) {
+			if (isNaN(val[c]))
+				atomicAdd(sNaN[c], 1u);
+			else if (isInf(val[c]))
+				atomicAdd(sInf[c], 1u);
+			else {
+				atomicMin(sMin[c], toOrdered(val[c]));
+				atomicMax(sMax[c], toOrdered(val[c]));
+				finite[c] = val[c];
+			}
+		}
+	}
+
+	// the sums are added up in a tree, atomics on floats aren't available
+	sSum[li] = finite;
+	barrier();
+	for (uint s = 128u; s > 0u; s >>= 1) {
+		if (li < s)
+			sSum[li] += sSum[li + s];
+		barrier();
+	}
+
+	if (li < 4u) {
+		atomicMin(minBits[li], sMin[li]);
+		atomicMax(maxBits[li], sMax[li]);
+		atomicAdd(nanCount[li], sNaN[li]);
+		atomicAdd(infCount[li], sInf[li]);
+	}
+	if (li == 0u)
+		partials[gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x] = sSum[0];
+}
+)";
+
+const char* TEXSTATS_SUM = R"(
+layout(local_size_x = 256) in;
+
+uniform uint count;
+
+shared vec4 sSum[256];
+
+void main()
+{
+	uint li = gl_LocalInvocationIndex;
+
+	vec4 acc = vec4(0.0f);
+	for (uint i = li; i < count; i += 256u)
+		acc += partials[i];
+	sSum[li] = acc;
+	barrier();
+
+	for (uint s = 128u; s > 0u; s >>= 1) {
+		if (li < s)
+			sSum[li] += sSum[li + s];
+		barrier();
+	}
+
+	if (li == 0u)
+		sum = sSum[0];
+}
+)";
+
+const char* TEXSTATS_HISTOGRAM = R"(
+layout(local_size_x = 16, local_size_y = 16) in;
+
+shared uint sHistogram[4 * BINS];
+
+void main()
+{
+	uint li = gl_LocalInvocationIndex;
+	for (uint i = li; i < 4u * BINS; i += 256u)
+		sHistogram[i] = 0u;
+	barrier();
+
+	ivec2 pos = ivec2(gl_GlobalInvocationID.xy);
+	if (all(lessThan(pos, textureSize(tex, 0)))) {
+		vec4 val = vec4(texelFetch(tex, pos, 0));
+		for (int c = 0; c < 4; c++) {
+			if (isNaN(val[c]) || isInf(val[c]))
+				continue;
+
+			float lo = fromOrdered(minBits[c]), hi = fromOrdered(maxBits[c]);
+			uint bin = hi > lo ? min(uint((val[c] - lo) / (hi - lo) * float(BINS)), BINS - 1u) : 0u;
+			atomicAdd(sHistogram[c * BINS + bin], 1u);
+		}
+	}
+	barrier();
+
+	for (uint i = li; i < 4u * BINS; i += 256u)
+		if (sHistogram[i] != 0u)
+			atomicAdd(histogram[i], sHistogram[i]);
+}
+)";
+
+namespace ed
+{
+	// layout of the Results block
+	struct GPUStatistics
+	{
+		GLuint MinBits[4];
+		GLuint MaxBits[4];
+		GLuint NaN[4];
+		GLuint Inf[4];
+		GLfloat Sum[4];
+		GLuint Histogram[4 * TEXTURE_STATISTICS_BINS];
+	};
+
+	static float fromOrdered(GLuint u)
+	{
+		u = (u & 0x80000000u) ? (u & 0x7FFFFFFFu) : ~u;
+
+		float ret;
+		memcpy(&ret, &u, sizeof(ret));
+		return ret;
+	}
+
+	TextureStatistics::TextureStatistics()
+	{
+		m_initialized = m_failed = false;
+		memset(m_programs, 0, sizeof(m_programs));
+		m_results = m_partials = 0;
+		m_partialsSize = 0;
+	}
+	TextureStatistics::~TextureStatistics()
+	{
+		for (int i = 0; i < 3; i++)
+			for (int j = 0; j < 3; j++)
+				glDeleteProgram(m_programs[i][j]);
+		if (m_initialized) {
+			glDeleteBuffers(1, &m_results);
+			glDeleteBuffers(1, &m_partials);
+		}
+	}
+	bool TextureStatistics::IsSupported()
+	{
+		return GLEW_ARB_compute_shader && GLEW_ARB_shader_storage_buffer_object;
+	}
+	GLuint TextureStatistics::m_compile(const std::string& code, const char* sampler)
+	{
+		GLchar msg[1024];
+
+		std::string source = code;
+		size_t line = source.find('\n', source.find("#version"));
+		source.insert(line + 1, "#define SAMPLER " + std::string(sampler) + "\n#define BINS " + std::to_string(TEXTURE_STATISTICS_BINS) + "u\n");
+
+		GLuint cs = gl::CompileShader(GL_COMPUTE_SHADER, source.c_str());
+		if (!gl::CheckShaderCompilationStatus(cs, msg)) {
+			Logger::Get().Log("Failed to compile the texture statistics shader: " + std::string(msg), true);
+			glDeleteShader(cs);
+			return 0;
+		}
+
+		GLuint program = glCreateProgram();
+		gl::SetObjectLabel(GL_PROGRAM, program, "Texture statistics");
+		glAttachShader(program, cs);
+		glLinkProgram(program);
+		glDeleteShader(cs);
+
+		if (!gl::CheckShaderLinkStatus(program, msg)) {
+			Logger::Get().Log("Failed to link the texture statistics shader: " + std::string(msg), true);
+			glDeleteProgram(program);
+			return 0;
+		}
+
+		glUseProgram(program);
+		glUniform1i(glGetUniformLocation(program, "tex"), 0);
+		glUseProgram(0);
+
+		return program;
+	}
+	bool TextureStatistics::m_init()
+	{
+		if (m_initialized || m_failed)
+			return m_initialized;
+
+		const char* samplers[3] = { "sampler2D", "isampler2D", "usampler2D" };
+		const char* kernels[3] = { TEXSTATS_REDUCE, TEXSTATS_SUM, TEXSTATS_HISTOGRAM };
+		for (int i = 0; i < 3; i++)
+			for (int j = 0; j < 3; j++) {
+				m_programs[i][j] = m_compile(std::string(TEXSTATS_COMMON) + kernels[j], samplers[i]);
+				m_failed |= m_programs[i][j] == 0;
+			}
+
+		if (m_failed)
+			return false;
+
+		glGenBuffers(1, &m_results);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_results);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GPUStatistics), nullptr, GL_DYNAMIC_COPY);
+		glGenBuffers(1, &m_partials);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		gl::SetObjectLabel(GL_BUFFER, m_results, "Texture statistics");
+
+		m_initialized = true;
+		return true;
+	}
+	bool TextureStatistics::Start(Query& query, GLuint tex)
+	{
+		if (query.Fence != 0 || !IsSupported() || !m_init())
+			return false;
+
+		// the sampler has to match the format - unorm, snorm & float formats are all read as floats
+		GLint width = 0, height = 0, type = GL_NONE;
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, tex);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_RED_TYPE, &type);
+		if (type == GL_NONE)
+			glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_DEPTH_TYPE, &type);
+
+		if (width <= 0 || height <= 0 || type == GL_NONE) {
+			glBindTexture(GL_TEXTURE_2D, 0);
+			return false;
+		}
+
+		int variant = type == GL_INT ? 1 : (type == GL_UNSIGNED_INT ? 2 : 0);
+		glm::ivec2 groups((width + 15) / 16, (height + 15) / 16);
+		size_t partials = (size_t)groups.x * groups.y * sizeof(glm::vec4);
+
+		GPUStatistics init;
+		memset(&init, 0, sizeof(init));
+		std::fill(init.MinBits, init.MinBits + 4, 0xFFFFFFFFu);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_results);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(init), &init);
+		if (partials > m_partialsSize) {
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_partials);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, partials, nullptr, GL_DYNAMIC_COPY);
+			m_partialsSize = partials;
+		}
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+		glBindTexture(GL_TEXTURE_2D, tex);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_results);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_partials);
+
+		// min, max, counts & partial sums -> sums of the partial sums & the histogram (which needs the range)
+		glUseProgram(m_programs[variant][0]);
+		glDispatchCompute(groups.x, groups.y, 1);
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+		glUseProgram(m_programs[variant][1]);
+		glUniform1ui(glGetUniformLocation(m_programs[variant][1], "count"), groups.x * groups.y);
+		glDispatchCompute(1, 1, 1);
+
+		glUseProgram(m_programs[variant][2]);
+		glDispatchCompute(groups.x, groups.y, 1);
+		glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+		glUseProgram(0);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		// the result is copied out so that the next request can start before this one is read
+		if (query.Readback == 0) {
+			glGenBuffers(1, &query.Readback);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, query.Readback);
+			glBufferData(GL_COPY_WRITE_BUFFER, sizeof(GPUStatistics), nullptr, GL_STREAM_READ);
+		}
+		glBindBuffer(GL_COPY_READ_BUFFER, m_results);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, query.Readback);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, sizeof(GPUStatistics));
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+		query.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		query.Last.Size = glm::ivec2(width, height);
+
+		return true;
+	}
+	bool TextureStatistics::Poll(Query& query)
+	{
+		if (query.Fence == 0)
+			return false;
+
+		GLenum status = glClientWaitSync(query.Fence, 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+			return false;
+
+		glDeleteSync(query.Fence);
+		query.Fence = 0;
+
+		GPUStatistics stats;
+		glBindBuffer(GL_COPY_READ_BUFFER, query.Readback);
+		glGetBufferSubData(GL_COPY_READ_BUFFER, 0, sizeof(stats), &stats);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+		Result& res = query.Last;
+		double pixels = (double)res.Size.x * res.Size.y;
+		for (int c = 0; c < 4; c++) {
+			double finite = pixels - stats.NaN[c] - stats.Inf[c];
+			res.Min[c] = finite > 0 ? fromOrdered(stats.MinBits[c]) : 0.0f;
+			res.Max[c] = finite > 0 ? fromOrdered(stats.MaxBits[c]) : 0.0f;
+			res.Mean[c] = finite > 0 ? (float)(stats.Sum[c] / finite) : 0.0f;
+			res.NaN[c] = stats.NaN[c];
+			res.Inf[c] = stats.Inf[c];
+			memcpy(res.Histogram[c], &stats.Histogram[c * TEXTURE_STATISTICS_BINS], sizeof(res.Histogram[c]));
+		}
+		res.Valid = true;
+
+		return true;
+	}
+	void TextureStatistics::Release(Query& query)
+	{
+		if (query.Fence != 0)
+			glDeleteSync(query.Fence);
+		if (query.Readback != 0)
+			glDeleteBuffers(1, &query.Readback);
+		query = Query();
+	}
+}
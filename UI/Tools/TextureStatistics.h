@@ -0,0 +1,61 @@
+#pragma once
+#include <string>
+#include <glm/glm.hpp>
+
+#include <GL/glew.h>
+#if defined(__APPLE__)
+	#include <OpenGL/gl.h>
+#else
+	#include <GL/gl.h>
+#endif
+
+#define TEXTURE_STATISTICS_BINS 64 // histogram bins per channel, between the channel's min & max
+
+namespace ed
+{
+	// per channel min, max, mean, NaN/Inf counts & a histogram of a 2D texture - computed with compute shader
+	// reductions, only the result (~1KB) is copied back and it's picked up once the GPU is done with it
+	class TextureStatistics
+	{
+	public:
+		TextureStatistics();
+		~TextureStatistics();
+
+		struct Result
+		{
+			Result() { Valid = false; Size = glm::ivec2(0, 0); }
+
+			bool Valid;
+			glm::ivec2 Size;
+			glm::vec4 Min, Max, Mean; // of the finite values
+			glm::uvec4 NaN, Inf;
+			unsigned int Histogram[4][TEXTURE_STATISTICS_BINS];
+		};
+
+		// one for each texture that is inspected - the requests don't wait for each other
+		struct Query
+		{
+			Query() { Readback = 0; Fence = 0; }
+
+			GLuint Readback;
+			GLsync Fence;
+			Result Last;
+		};
+
+		static bool IsSupported();
+
+		bool Start(Query& query, GLuint tex); // false if the texture isn't a 2D texture with a float, int or uint format
+		bool Poll(Query& query); // true if query.Last was just updated
+		inline bool IsPending(const Query& query) { return query.Fence != 0; }
+		void Release(Query& query);
+
+	private:
+		bool m_init();
+		GLuint m_compile(const std::string& code, const char* sampler);
+
+		bool m_initialized, m_failed;
+		GLuint m_programs[3][3]; // [float/int/uint][reduce/sum/histogram]
+		GLuint m_results, m_partials;
+		size_t m_partialsSize;
+	};
+}
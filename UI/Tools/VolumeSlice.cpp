@@ -0,0 +1,92 @@
+#include "VolumeSlice.h"
+
+#include <algorithm>
+
+namespace ed
+{
+	VolumeSlice::VolumeSlice()
+	{
+		m_fbos[0] = m_fbos[1] = 0;
+		m_tex = 0;
+		m_size = glm::ivec2(0, 0);
+		m_format = GL_NONE;
+		m_integer = false;
+
+		m_lastTex = 0;
+		m_lastSlice = m_lastReduction = -1;
+		m_lastGeneration = 0;
+	}
+	VolumeSlice::~VolumeSlice()
+	{
+		if (m_fbos[0] != 0)
+			glDeleteFramebuffers(2, m_fbos);
+		if (m_tex != 0)
+			glDeleteTextures(1, &m_tex);
+	}
+	void VolumeSlice::m_allocate(GLuint tex, GLenum format, const glm::ivec2& size)
+	{
+		if (m_tex != 0)
+			glDeleteTextures(1, &m_tex);
+
+		m_format = format;
+		m_size = size;
+
+		GLint redType = GL_NONE;
+		glBindTexture(GL_TEXTURE_3D, tex);
+		glGetTexLevelParameteriv(GL_TEXTURE_3D, 0, GL_TEXTURE_RED_TYPE, &redType);
+		glBindTexture(GL_TEXTURE_3D, 0);
+		m_integer = redType == GL_INT || redType == GL_UNSIGNED_INT;
+
+		glGenTextures(1, &m_tex);
+		glBindTexture(GL_TEXTURE_2D, m_tex);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		if (GLEW_ARB_texture_storage)
+			glTexStorage2D(GL_TEXTURE_2D, 1, format, size.x, size.y);
+		else
+			glTexImage2D(GL_TEXTURE_2D, 0, format, size.x, size.y, 0, m_integer ? GL_RGBA_INTEGER : GL_RGBA, m_integer ? redType : GL_FLOAT, nullptr);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+	GLuint VolumeSlice::Update(GLuint tex, const glm::ivec3& size, GLenum format, int slice, int reduction, unsigned int generation)
+	{
+		if (tex == 0 || size.x <= 0 || size.y <= 0 || size.z <= 0)
+			return m_tex;
+
+		slice = std::max(0, std::min(slice, size.z - 1));
+		glm::ivec2 sliceSize(std::max(1, size.x >> reduction), std::max(1, size.y >> reduction));
+
+		bool changed = tex != m_lastTex || slice != m_lastSlice || reduction != m_lastReduction || generation != m_lastGeneration;
+		if (!changed && m_tex != 0 && m_size == sliceSize && m_format == format && m_clock.getElapsedTime().asMilliseconds() < VOLUME_SLICE_REFRESH)
+			return m_tex;
+
+		if (m_tex == 0 || m_size != sliceSize || m_format != format)
+			m_allocate(tex, format, sliceSize);
+		if (m_fbos[0] == 0)
+			glGenFramebuffers(2, m_fbos);
+
+		m_lastTex = tex;
+		m_lastSlice = slice;
+		m_lastReduction = reduction;
+		m_lastGeneration = generation;
+		m_clock.restart();
+
+		// only this layer is touched, the rest of the volume never leaves the GPU
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fbos[0]);
+		glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, tex, 0, slice);
+		glReadBuffer(GL_COLOR_ATTACHMENT0);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_fbos[1]);
+		glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_tex, 0);
+		glDrawBuffer(GL_COLOR_ATTACHMENT0);
+
+		// the UI leaves the scissor test on
+		GLboolean scissor = glIsEnabled(GL_SCISSOR_TEST);
+		glDisable(GL_SCISSOR_TEST);
+		glBlitFramebuffer(0, 0, size.x, size.y, 0, 0, m_size.x, m_size.y, GL_COLOR_BUFFER_BIT, (m_integer || reduction == 0) ? GL_NEAREST : GL_LINEAR);
+		if (scissor)
+			glEnable(GL_SCISSOR_TEST);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+		return m_tex;
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <SFML/System/Clock.hpp>
+
+#include <GL/glew.h>
+#if defined(__APPLE__)
+	#include <OpenGL/gl.h>
+#else
+	#include <GL/gl.h>
+#endif
+
+#define VOLUME_SLICE_REFRESH 100 // ms - passes can write to the 3D image, so an unchanged slice is still copied at this rate
+
+namespace ed
+{
+	// one Z slice of a 3D texture copied to a 2D texture of the same format - the preview then works with that
+	// instead of the whole volume, which can be hundreds of megabytes
+	class VolumeSlice
+	{
+	public:
+		VolumeSlice();
+		~VolumeSlice();
+
+		// reduction -> the slice is scaled down to 1 / 2^reduction of its size, returns the 2D texture
+		GLuint Update(GLuint tex, const glm::ivec3& size, GLenum format, int slice, int reduction, unsigned int generation);
+
+		inline GLuint GetTexture() { return m_tex; }
+		inline const glm::ivec2& GetSize() { return m_size; }
+
+	private:
+		void m_allocate(GLuint tex, GLenum format, const glm::ivec2& size);
+
+		GLuint m_fbos[2]; // read (a layer of the 3D texture) & draw
+		GLuint m_tex;
+		glm::ivec2 m_size;
+		GLenum m_format;
+		bool m_integer; // can't be filtered when it's scaled down
+
+		GLuint m_lastTex;
+		int m_lastSlice, m_lastReduction;
+		unsigned int m_lastGeneration;
+		sf::Clock m_clock;
+	};
+}
@@ -1,11 +1,14 @@
 #include "UIHelper.h"
 #include "../Objects/Names.h"
 #include "../Objects/Logger.h"
+#include "../Objects/TextureSharing.h"
 
 #include <iomanip>
+#include <string.h>
 #include <sstream>
 #include <clocale>
 #include <imgui/imgui.h>
+#include <glm/gtc/type_ptr.hpp>
 #include <nativefiledialog/nfd.h>
 
 #include <ShaderDebugger/Utils.h>
@@ -198,4 +201,124 @@ namespace ed
 
 		return ret;
 	}
-}
\ No newline at end of file
+	bool UIHelper::CreateShareMenuItems(const std::string& source)
+	{
+#if defined(_WIN32)
+		const char* gpuName = "Spout";
+#elif defined(__APPLE__)
+		const char* gpuName = "Syphon";
+#else
+		const char* gpuName = "Share texture";
+#endif
+
+		TextureSharing& sharing = TextureSharing::Instance();
+		TextureSharing::Output* out = sharing.Get(source);
+		bool gpu = out != nullptr && out->GPU;
+		bool ndi = out != nullptr && out->NDI;
+		bool changed = false;
+
+		if (ImGui::MenuItem(gpuName, (const char*)0, &gpu, TextureSharing::IsGPUSharingSupported()))
+			changed = true;
+		if (ImGui::MenuItem("NDI", (const char*)0, &ndi, sharing.IsNDIAvailable()))
+			changed = true;
+
+		if (changed) {
+			if (!gpu && !ndi)
+				sharing.Remove(source);
+			else {
+				out = sharing.Add(source);
+				out->GPU = gpu;
+				out->NDI = ndi;
+			}
+			out = sharing.Get(source);
+		}
+
+		if (out != nullptr) {
+			char name[128] = { 0 };
+			strncpy(name, out->Name.c_str(), 127);
+			if (ImGui::InputText("Name##share_name", name, 127)) {
+				out->Name = name;
+				changed = true;
+			}
+		}
+
+		return changed;
+	}
+	bool UIHelper::CreateFillEditor(const char* id, GPUFill::Operation& op, bool buffer, const std::vector<std::string>& sources)
+	{
+		static const char* OPERATORS[] = { "Constant", "Ramp", "Random", "Noise", "Seed", "Copy" };
+		static const char* TYPES[] = { "float", "int", "uint" };
+		std::string suffix = std::string("##") + id;
+
+		if (op.Op == GPUFill::Operator::None)
+			op.Op = GPUFill::Operator::Constant;
+
+		ImGui::Text("Fill:");
+		ImGui::SameLine();
+		ImGui::PushItemWidth(120);
+		int opIndex = (int)op.Op - 1;
+		if (ImGui::Combo(("##op" + suffix).c_str(), &opIndex, OPERATORS, HARRAYSIZE(OPERATORS)))
+			op.Op = (GPUFill::Operator)(opIndex + 1);
+		ImGui::PopItemWidth();
+
+		if (buffer) {
+			ImGui::SameLine();
+			ImGui::PushItemWidth(80);
+			int type = (int)op.Type;
+			if (ImGui::Combo(("##type" + suffix).c_str(), &type, TYPES, HARRAYSIZE(TYPES)))
+				op.Type = (GPUFill::ElementType)type;
+			ImGui::SameLine();
+			ImGui::SliderInt(("##components" + suffix).c_str(), &op.Components, 1, 4, "%d per element");
+			ImGui::PopItemWidth();
+			if (ImGui::IsItemHovered())
+				ImGui::SetTooltip("Words per element, component i uses the channel i of the values");
+		}
+
+		const char* labelA = "Value:";
+		const char* labelB = nullptr;
+		if (op.Op == GPUFill::Operator::Ramp) {
+			labelA = buffer ? "Start:" : "From:";
+			labelB = buffer ? "Step:" : "To:";
+		} else if (op.Op == GPUFill::Operator::Random || op.Op == GPUFill::Operator::Noise) {
+			labelA = "Min:";
+			labelB = "Max:";
+		}
+
+		ImGui::PushItemWidth(300);
+		if (op.Op != GPUFill::Operator::Seed && op.Op != GPUFill::Operator::Copy) {
+			ImGui::Text(labelA);
+			ImGui::SameLine();
+			ImGui::DragFloat4(("##a" + suffix).c_str(), glm::value_ptr(op.A), 0.01f);
+		}
+		if (labelB != nullptr) {
+			ImGui::Text(labelB);
+			ImGui::SameLine();
+			ImGui::DragFloat4(("##b" + suffix).c_str(), glm::value_ptr(op.B), 0.01f);
+		}
+		if (op.Op == GPUFill::Operator::Noise) {
+			ImGui::Text("Frequency:");
+			ImGui::SameLine();
+			ImGui::DragFloat(("##freq" + suffix).c_str(), &op.Frequency, 0.001f, 0.0f, 100.0f);
+		}
+		if (op.Op == GPUFill::Operator::Random || op.Op == GPUFill::Operator::Noise || op.Op == GPUFill::Operator::Seed) {
+			ImGui::Text("Seed:");
+			ImGui::SameLine();
+			int seed = (int)op.Seed;
+			if (ImGui::InputInt(("##seed" + suffix).c_str(), &seed))
+				op.Seed = (unsigned int)seed;
+		}
+		if (op.Op == GPUFill::Operator::Copy) {
+			ImGui::Text("Source:");
+			ImGui::SameLine();
+			if (ImGui::BeginCombo(("##src" + suffix).c_str(), op.Source.empty() ? "NULL" : op.Source.c_str())) {
+				for (const std::string& source : sources)
+					if (ImGui::Selectable(source.c_str(), source == op.Source))
+						op.Source = source;
+				ImGui::EndCombo();
+			}
+		}
+		ImGui::PopItemWidth();
+
+		return ImGui::Button(("FILL" + suffix).c_str());
+	}
+}
@@ -1,6 +1,8 @@
 #pragma once
 #include <string>
+#include <vector>
 #include <glm/glm.hpp>
+#include "../Objects/GPUFill.h"
 #ifdef _WIN32
 #include <windows.h>
 #endif
@@ -30,5 +32,11 @@ namespace ed
 		static bool CreateCullModeCombo(const char* name, GLenum& cull);
 		static bool CreateComparisonFunctionCombo(const char* name, GLenum& comp);
 		static bool CreateStencilOperationCombo(const char* name, GLenum& op);
+
+		// Spout/Syphon & NDI toggles of a TextureSharing output, source is a render texture or empty for the preview
+		static bool CreateShareMenuItems(const std::string& source);
+
+		// operator & parameters of a GPU fill, true when the FILL button was pressed - sources are the objects that can be copied
+		static bool CreateFillEditor(const char* id, GPUFill::Operation& op, bool buffer, const std::vector<std::string>& sources);
 	};
 }
\ No newline at end of file
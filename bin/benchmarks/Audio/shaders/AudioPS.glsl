@@ -0,0 +1,17 @@
+#version 330
+
+in vec2 outUV;
+out vec4 fragColor;
+
+uniform sampler2D tex;
+
+void main() {
+	// first row is frequency data, second row is the sound wave
+	float fft = texture(tex, vec2(outUV.x, 0.0)).x;
+	float wave = texture(tex, vec2(outUV.x, 1.0)).x;
+
+	vec3 col = vec3(fft, 4.0 * fft * (1.0 - fft), 1.0 - fft) * fft;
+	col += 1.0 - smoothstep(0.0, 0.15, abs(wave - outUV.y));
+
+	fragColor = vec4(col, 1.0);
+}
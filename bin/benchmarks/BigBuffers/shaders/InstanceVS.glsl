@@ -0,0 +1,16 @@
+#version 330
+
+uniform mat4 matVP;
+uniform mat4 matGeo;
+
+layout (location = 0) in vec3 pos;
+layout (location = 1) in vec3 normal;
+layout (location = 2) in vec4 iPosition;
+layout (location = 3) in vec4 iVelocity;
+
+out vec4 color;
+
+void main() {
+	color = vec4(abs(normal) * 0.5 + abs(iVelocity.xyz) * 0.05, 1.0);
+	gl_Position = matVP * (matGeo * vec4(pos, 1) + vec4(iPosition.xyz, 0.0));
+}
@@ -0,0 +1,30 @@
+#version 430
+layout(local_size_x = 256) in;
+
+struct Particle
+{
+	vec4 Position;
+	vec4 Velocity;
+};
+
+layout(std430, binding = 0) buffer Particles
+{
+	Particle particles[];
+};
+
+uniform float delta;
+
+void main() {
+	uint id = gl_GlobalInvocationID.x;
+	Particle p = particles[id];
+
+	// reset the particles that have garbage or left the area
+	if (!(abs(p.Position.x) < 64.0 && abs(p.Position.y) < 64.0 && abs(p.Position.z) < 64.0)) {
+		p.Position = vec4(float(id % 128u) - 64.0, 0.0, float((id / 128u) % 128u) - 64.0, 1.0);
+		p.Velocity = vec4(0.0, 1.0 + float(id % 7u), 0.0, 0.0);
+	}
+
+	p.Velocity.y -= 9.81 * delta;
+	p.Position.xyz += p.Velocity.xyz * delta;
+	particles[id] = p;
+}
@@ -0,0 +1,18 @@
+#version 430
+layout(local_size_x = 16, local_size_y = 16) in;
+
+uniform float time;
+writeonly uniform image2D img_output;
+
+void main() {
+	ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+	vec2 c = (vec2(pixel) / 1024.0 - 0.5) * 3.0 + vec2(-0.5 + 0.1 * sin(time), 0.0);
+	vec2 z = vec2(0.0);
+
+	int i = 0;
+	for (; i < 1024 && dot(z, z) < 4.0; i++)
+		z = vec2(z.x * z.x - z.y * z.y, 2.0 * z.x * z.y) + c;
+
+	float t = float(i) / 1024.0;
+	imageStore(img_output, pixel, vec4(t, sqrt(t), t * t, 1.0));
+}
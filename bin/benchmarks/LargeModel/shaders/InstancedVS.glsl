@@ -0,0 +1,15 @@
+#version 330
+
+uniform mat4 matVP;
+uniform mat4 matGeo;
+
+layout (location = 0) in vec3 pos;
+layout (location = 1) in vec3 normal;
+
+out vec4 color;
+
+void main() {
+	vec3 offset = vec3(gl_InstanceID % 64 - 32, 0.0, gl_InstanceID / 64 - 32) * 1.5;
+	color = vec4(abs(normal), 1.0);
+	gl_Position = matVP * (matGeo * vec4(pos, 1) + vec4(offset, 0.0));
+}
@@ -0,0 +1,15 @@
+#version 330
+
+in vec2 outUV;
+out vec4 fragColor;
+
+uniform sampler2D tex;
+uniform vec2 texel;
+
+void main() {
+	vec4 sum = vec4(0.0);
+	for (int x = -2; x <= 2; x++)
+		for (int y = -2; y <= 2; y++)
+			sum += texture(tex, outUV + vec2(x, y) * texel);
+	fragColor = sum / 25.0;
+}
@@ -0,0 +1,10 @@
+#version 330
+
+in vec2 outUV;
+out vec4 fragColor;
+
+uniform float time;
+
+void main() {
+	fragColor = vec4(fract(sin(dot(outUV + time, vec2(12.9898, 78.233))) * 43758.5453), outUV, 1.0);
+}
@@ -0,0 +1,522 @@
+#version 330
+
+in vec4 color;
+out vec4 outColor;
+
+uniform vec4 u0;
+uniform vec4 u1;
+uniform vec4 u2;
+uniform vec4 u3;
+uniform vec4 u4;
+uniform vec4 u5;
+uniform vec4 u6;
+uniform vec4 u7;
+uniform vec4 u8;
+uniform vec4 u9;
+uniform vec4 u10;
+uniform vec4 u11;
+uniform vec4 u12;
+uniform vec4 u13;
+uniform vec4 u14;
+uniform vec4 u15;
+uniform vec4 u16;
+uniform vec4 u17;
+uniform vec4 u18;
+uniform vec4 u19;
+uniform vec4 u20;
+uniform vec4 u21;
+uniform vec4 u22;
+uniform vec4 u23;
+uniform vec4 u24;
+uniform vec4 u25;
+uniform vec4 u26;
+uniform vec4 u27;
+uniform vec4 u28;
+uniform vec4 u29;
+uniform vec4 u30;
+uniform vec4 u31;
+uniform vec4 u32;
+uniform vec4 u33;
+uniform vec4 u34;
+uniform vec4 u35;
+uniform vec4 u36;
+uniform vec4 u37;
+uniform vec4 u38;
+uniform vec4 u39;
+uniform vec4 u40;
+uniform vec4 u41;
+uniform vec4 u42;
+uniform vec4 u43;
+uniform vec4 u44;
+uniform vec4 u45;
+uniform vec4 u46;
+uniform vec4 u47;
+uniform vec4 u48;
+uniform vec4 u49;
+uniform vec4 u50;
+uniform vec4 u51;
+uniform vec4 u52;
+uniform vec4 u53;
+uniform vec4 u54;
+uniform vec4 u55;
+uniform vec4 u56;
+uniform vec4 u57;
+uniform vec4 u58;
+uniform vec4 u59;
+uniform vec4 u60;
+uniform vec4 u61;
+uniform vec4 u62;
+uniform vec4 u63;
+uniform vec4 u64;
+uniform vec4 u65;
+uniform vec4 u66;
+uniform vec4 u67;
+uniform vec4 u68;
+uniform vec4 u69;
+uniform vec4 u70;
+uniform vec4 u71;
+uniform vec4 u72;
+uniform vec4 u73;
+uniform vec4 u74;
+uniform vec4 u75;
+uniform vec4 u76;
+uniform vec4 u77;
+uniform vec4 u78;
+uniform vec4 u79;
+uniform vec4 u80;
+uniform vec4 u81;
+uniform vec4 u82;
+uniform vec4 u83;
+uniform vec4 u84;
+uniform vec4 u85;
+uniform vec4 u86;
+uniform vec4 u87;
+uniform vec4 u88;
+uniform vec4 u89;
+uniform vec4 u90;
+uniform vec4 u91;
+uniform vec4 u92;
+uniform vec4 u93;
+uniform vec4 u94;
+uniform vec4 u95;
+uniform vec4 u96;
+uniform vec4 u97;
+uniform vec4 u98;
+uniform vec4 u99;
+uniform vec4 u100;
+uniform vec4 u101;
+uniform vec4 u102;
+uniform vec4 u103;
+uniform vec4 u104;
+uniform vec4 u105;
+uniform vec4 u106;
+uniform vec4 u107;
+uniform vec4 u108;
+uniform vec4 u109;
+uniform vec4 u110;
+uniform vec4 u111;
+uniform vec4 u112;
+uniform vec4 u113;
+uniform vec4 u114;
+uniform vec4 u115;
+uniform vec4 u116;
+uniform vec4 u117;
+uniform vec4 u118;
+uniform vec4 u119;
+uniform vec4 u120;
+uniform vec4 u121;
+uniform vec4 u122;
+uniform vec4 u123;
+uniform vec4 u124;
+uniform vec4 u125;
+uniform vec4 u126;
+uniform vec4 u127;
+uniform vec4 u128;
+uniform vec4 u129;
+uniform vec4 u130;
+uniform vec4 u131;
+uniform vec4 u132;
+uniform vec4 u133;
+uniform vec4 u134;
+uniform vec4 u135;
+uniform vec4 u136;
+uniform vec4 u137;
+uniform vec4 u138;
+uniform vec4 u139;
+uniform vec4 u140;
+uniform vec4 u141;
+uniform vec4 u142;
+uniform vec4 u143;
+uniform vec4 u144;
+uniform vec4 u145;
+uniform vec4 u146;
+uniform vec4 u147;
+uniform vec4 u148;
+uniform vec4 u149;
+uniform vec4 u150;
+uniform vec4 u151;
+uniform vec4 u152;
+uniform vec4 u153;
+uniform vec4 u154;
+uniform vec4 u155;
+uniform vec4 u156;
+uniform vec4 u157;
+uniform vec4 u158;
+uniform vec4 u159;
+uniform vec4 u160;
+uniform vec4 u161;
+uniform vec4 u162;
+uniform vec4 u163;
+uniform vec4 u164;
+uniform vec4 u165;
+uniform vec4 u166;
+uniform vec4 u167;
+uniform vec4 u168;
+uniform vec4 u169;
+uniform vec4 u170;
+uniform vec4 u171;
+uniform vec4 u172;
+uniform vec4 u173;
+uniform vec4 u174;
+uniform vec4 u175;
+uniform vec4 u176;
+uniform vec4 u177;
+uniform vec4 u178;
+uniform vec4 u179;
+uniform vec4 u180;
+uniform vec4 u181;
+uniform vec4 u182;
+uniform vec4 u183;
+uniform vec4 u184;
+uniform vec4 u185;
+uniform vec4 u186;
+uniform vec4 u187;
+uniform vec4 u188;
+uniform vec4 u189;
+uniform vec4 u190;
+uniform vec4 u191;
+uniform vec4 u192;
+uniform vec4 u193;
+uniform vec4 u194;
+uniform vec4 u195;
+uniform vec4 u196;
+uniform vec4 u197;
+uniform vec4 u198;
+uniform vec4 u199;
+uniform vec4 u200;
+uniform vec4 u201;
+uniform vec4 u202;
+uniform vec4 u203;
+uniform vec4 u204;
+uniform vec4 u205;
+uniform vec4 u206;
+uniform vec4 u207;
+uniform vec4 u208;
+uniform vec4 u209;
+uniform vec4 u210;
+uniform vec4 u211;
+uniform vec4 u212;
+uniform vec4 u213;
+uniform vec4 u214;
+uniform vec4 u215;
+uniform vec4 u216;
+uniform vec4 u217;
+uniform vec4 u218;
+uniform vec4 u219;
+uniform vec4 u220;
+uniform vec4 u221;
+uniform vec4 u222;
+uniform vec4 u223;
+uniform vec4 u224;
+uniform vec4 u225;
+uniform vec4 u226;
+uniform vec4 u227;
+uniform vec4 u228;
+uniform vec4 u229;
+uniform vec4 u230;
+uniform vec4 u231;
+uniform vec4 u232;
+uniform vec4 u233;
+uniform vec4 u234;
+uniform vec4 u235;
+uniform vec4 u236;
+uniform vec4 u237;
+uniform vec4 u238;
+uniform vec4 u239;
+uniform vec4 u240;
+uniform vec4 u241;
+uniform vec4 u242;
+uniform vec4 u243;
+uniform vec4 u244;
+uniform vec4 u245;
+uniform vec4 u246;
+uniform vec4 u247;
+uniform vec4 u248;
+uniform vec4 u249;
+uniform vec4 u250;
+uniform vec4 u251;
+uniform vec4 u252;
+uniform vec4 u253;
+uniform vec4 u254;
+uniform vec4 u255;
+
+void main() {
+	vec4 sum = vec4(0.0);
+	sum += u0;
+	sum += u1;
+	sum += u2;
+	sum += u3;
+	sum += u4;
+	sum += u5;
+	sum += u6;
+	sum += u7;
+	sum += u8;
+	sum += u9;
+	sum += u10;
+	sum += u11;
+	sum += u12;
+	sum += u13;
+	sum += u14;
+	sum += u15;
+	sum += u16;
+	sum += u17;
+	sum += u18;
+	sum += u19;
+	sum += u20;
+	sum += u21;
+	sum += u22;
+	sum += u23;
+	sum += u24;
+	sum += u25;
+	sum += u26;
+	sum += u27;
+	sum += u28;
+	sum += u29;
+	sum += u30;
+	sum += u31;
+	sum += u32;
+	sum += u33;
+	sum += u34;
+	sum += u35;
+	sum += u36;
+	sum += u37;
+	sum += u38;
+	sum += u39;
+	sum += u40;
+	sum += u41;
+	sum += u42;
+	sum += u43;
+	sum += u44;
+	sum += u45;
+	sum += u46;
+	sum += u47;
+	sum += u48;
+	sum += u49;
+	sum += u50;
+	sum += u51;
+	sum += u52;
+	sum += u53;
+	sum += u54;
+	sum += u55;
+	sum += u56;
+	sum += u57;
+	sum += u58;
+	sum += u59;
+	sum += u60;
+	sum += u61;
+	sum += u62;
+	sum += u63;
+	sum += u64;
+	sum += u65;
+	sum += u66;
+	sum += u67;
+	sum += u68;
+	sum += u69;
+	sum += u70;
+	sum += u71;
+	sum += u72;
+	sum += u73;
+	sum += u74;
+	sum += u75;
+	sum += u76;
+	sum += u77;
+	sum += u78;
+	sum += u79;
+	sum += u80;
+	sum += u81;
+	sum += u82;
+	sum += u83;
+	sum += u84;
+	sum += u85;
+	sum += u86;
+	sum += u87;
+	sum += u88;
+	sum += u89;
+	sum += u90;
+	sum += u91;
+	sum += u92;
+	sum += u93;
+	sum += u94;
+	sum += u95;
+	sum += u96;
+	sum += u97;
+	sum += u98;
+	sum += u99;
+	sum += u100;
+	sum += u101;
+	sum += u102;
+	sum += u103;
+	sum += u104;
+	sum += u105;
+	sum += u106;
+	sum += u107;
+	sum += u108;
+	sum += u109;
+	sum += u110;
+	sum += u111;
+	sum += u112;
+	sum += u113;
+	sum += u114;
+	sum += u115;
+	sum += u116;
+	sum += u117;
+	sum += u118;
+	sum += u119;
+	sum += u120;
+	sum += u121;
+	sum += u122;
+	sum += u123;
+	sum += u124;
+	sum += u125;
+	sum += u126;
+	sum += u127;
+	sum += u128;
+	sum += u129;
+	sum += u130;
+	sum += u131;
+	sum += u132;
+	sum += u133;
+	sum += u134;
+	sum += u135;
+	sum += u136;
+	sum += u137;
+	sum += u138;
+	sum += u139;
+	sum += u140;
+	sum += u141;
+	sum += u142;
+	sum += u143;
+	sum += u144;
+	sum += u145;
+	sum += u146;
+	sum += u147;
+	sum += u148;
+	sum += u149;
+	sum += u150;
+	sum += u151;
+	sum += u152;
+	sum += u153;
+	sum += u154;
+	sum += u155;
+	sum += u156;
+	sum += u157;
+	sum += u158;
+	sum += u159;
+	sum += u160;
+	sum += u161;
+	sum += u162;
+	sum += u163;
+	sum += u164;
+	sum += u165;
+	sum += u166;
+	sum += u167;
+	sum += u168;
+	sum += u169;
+	sum += u170;
+	sum += u171;
+	sum += u172;
+	sum += u173;
+	sum += u174;
+	sum += u175;
+	sum += u176;
+	sum += u177;
+	sum += u178;
+	sum += u179;
+	sum += u180;
+	sum += u181;
+	sum += u182;
+	sum += u183;
+	sum += u184;
+	sum += u185;
+	sum += u186;
+	sum += u187;
+	sum += u188;
+	sum += u189;
+	sum += u190;
+	sum += u191;
+	sum += u192;
+	sum += u193;
+	sum += u194;
+	sum += u195;
+	sum += u196;
+	sum += u197;
+	sum += u198;
+	sum += u199;
+	sum += u200;
+	sum += u201;
+	sum += u202;
+	sum += u203;
+	sum += u204;
+	sum += u205;
+	sum += u206;
+	sum += u207;
+	sum += u208;
+	sum += u209;
+	sum += u210;
+	sum += u211;
+	sum += u212;
+	sum += u213;
+	sum += u214;
+	sum += u215;
+	sum += u216;
+	sum += u217;
+	sum += u218;
+	sum += u219;
+	sum += u220;
+	sum += u221;
+	sum += u222;
+	sum += u223;
+	sum += u224;
+	sum += u225;
+	sum += u226;
+	sum += u227;
+	sum += u228;
+	sum += u229;
+	sum += u230;
+	sum += u231;
+	sum += u232;
+	sum += u233;
+	sum += u234;
+	sum += u235;
+	sum += u236;
+	sum += u237;
+	sum += u238;
+	sum += u239;
+	sum += u240;
+	sum += u241;
+	sum += u242;
+	sum += u243;
+	sum += u244;
+	sum += u245;
+	sum += u246;
+	sum += u247;
+	sum += u248;
+	sum += u249;
+	sum += u250;
+	sum += u251;
+	sum += u252;
+	sum += u253;
+	sum += u254;
+	sum += u255;
+	outColor = color * sum / 256.0;
+}
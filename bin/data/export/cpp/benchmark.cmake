@@ -0,0 +1,21 @@
+# benchmark - renders SED_BENCHMARK_FRAMES frames and prints the GPU time of each shader pass
+add_executable([$$project_name$$]_benchmark ${SOURCES})
+target_compile_definitions([$$project_name$$]_benchmark PRIVATE SED_BENCHMARK)
+
+set_target_properties([$$project_name$$]_benchmark PROPERTIES
+    CXX_STANDARD 17
+    CXX_STANDARD_REQUIRED YES
+)
+
+target_include_directories([$$project_name$$]_benchmark PRIVATE  ${SDL2_INCLUDE_DIRS} ${GLEW_INCLUDE_DIRS} ${OPENGL_INCLUDE_DIRS} ${GLM_INCLUDE_DIRS})
+target_link_libraries([$$project_name$$]_benchmark ${GLM_LIBRARY_DIRS} ${OPENGL_LIBRARIES})
+
+if(WIN32)
+	target_link_libraries([$$project_name$$]_benchmark GLEW::GLEW SDL2::SDL2)
+else()
+	target_link_libraries([$$project_name$$]_benchmark ${GLEW_LIBRARIES} ${SDL2_LIBRARIES})
+endif()
+
+if (NOT MSVC)
+	target_compile_options([$$project_name$$]_benchmark PRIVATE -Wno-narrowing)
+endif()
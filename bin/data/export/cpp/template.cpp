@@ -1,6 +1,8 @@
 #include <fstream>
 #include <chrono>
 #include <string>
+#include <vector>
+#include <functional>
 
 #include <SDL2/SDL.h>
 #include <GL/glew.h>
@@ -27,7 +29,8 @@ GLuint CreatePlane(GLuint& vbo, float sx, float sy);
 GLuint CreateScreenQuadNDC(GLuint& vbo);
 GLuint CreateCube(GLuint& vbo, float sx, float sy, float sz);
 std::string LoadFile(const std::string& filename);
-GLuint CreateShader(const char* vsCode, const char* psCode);
+GLuint CreateShader(const char* vsCode, const char* psCode, bool retrievable = false);
+GLuint CreateShaderCached(const char* vsCode, const char* psCode, const std::string& cacheFile);
 GLuint LoadTexture(const std::string& filename);
 
 const GLenum FBO_Buffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2, GL_COLOR_ATTACHMENT3, GL_COLOR_ATTACHMENT4, GL_COLOR_ATTACHMENT5, GL_COLOR_ATTACHMENT6, GL_COLOR_ATTACHMENT7, GL_COLOR_ATTACHMENT8, GL_COLOR_ATTACHMENT9, GL_COLOR_ATTACHMENT10, GL_COLOR_ATTACHMENT11, GL_COLOR_ATTACHMENT12, GL_COLOR_ATTACHMENT13, GL_COLOR_ATTACHMENT14, GL_COLOR_ATTACHMENT15 };
@@ -73,6 +76,8 @@ int main()
 	// init
 	[$$init$$]
 
+	[$$benchmark_setup$$]
+
 	SDL_Event event;
 	bool run = true;
 	while (run) {
@@ -102,6 +107,8 @@ int main()
 		// RENDER
 		[$$render$$]
 
+		[$$benchmark_frame$$]
+
 		float curTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now() - timerStart).count() / 1000000.0f;
 		sysTimeDelta = curTime - sysTime;
 		sysTime = curTime;
@@ -280,7 +287,7 @@ std::string LoadFile(const std::string& filename)
 	file.close();
 	return src;
 }
-GLuint CreateShader(const char* vsCode, const char* psCode)
+GLuint CreateShader(const char* vsCode, const char* psCode, bool retrievable)
 {
 	GLint success = 0;
 	char infoLog[512];
@@ -311,6 +318,8 @@ GLuint CreateShader(const char* vsCode, const char* psCode)
 	GLuint retShader = glCreateProgram();
 	glAttachShader(retShader, vs);
 	glAttachShader(retShader, ps);
+	if (retrievable)
+		glProgramParameteri(retShader, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 	glLinkProgram(retShader);
 	glGetProgramiv(retShader, GL_LINK_STATUS, &success);
 	if (!success) {
@@ -324,6 +333,56 @@ GLuint CreateShader(const char* vsCode, const char* psCode)
 
 	return retShader;
 }
+GLuint CreateShaderCached(const char* vsCode, const char* psCode, const std::string& cacheFile)
+{
+	if (!GLEW_ARB_get_program_binary)
+		return CreateShader(vsCode, psCode);
+
+	// the binary is only used if it was built from the same shaders
+	size_t srcHash = std::hash<std::string>()(std::string(vsCode) + psCode);
+
+	std::ifstream cacheReader(cacheFile, std::ios::binary);
+	size_t cacheHash = 0;
+	GLenum binFormat = 0;
+	GLint binLength = 0;
+	cacheReader.read((char*)&cacheHash, sizeof(cacheHash));
+	cacheReader.read((char*)&binFormat, sizeof(binFormat));
+	cacheReader.read((char*)&binLength, sizeof(binLength));
+	if (cacheReader && cacheHash == srcHash && binLength > 0) {
+		std::vector<char> bin(binLength);
+		if (cacheReader.read(bin.data(), binLength)) {
+			GLuint retShader = glCreateProgram();
+			glProgramBinary(retShader, binFormat, bin.data(), binLength);
+
+			// the driver rejects the binaries of other drivers & versions
+			GLint success = 0;
+			glGetProgramiv(retShader, GL_LINK_STATUS, &success);
+			if (success)
+				return retShader;
+			glDeleteProgram(retShader);
+		}
+	}
+	cacheReader.close();
+
+	GLuint retShader = CreateShader(vsCode, psCode, true);
+	if (retShader == 0)
+		return 0;
+
+	glGetProgramiv(retShader, GL_PROGRAM_BINARY_LENGTH, &binLength);
+	if (binLength > 0) {
+		std::vector<char> bin(binLength);
+		glGetProgramBinary(retShader, binLength, &binLength, &binFormat, bin.data());
+
+		std::ofstream cacheWriter(cacheFile, std::ios::binary);
+		cacheWriter.write((char*)&srcHash, sizeof(srcHash));
+		cacheWriter.write((char*)&binFormat, sizeof(binFormat));
+		cacheWriter.write((char*)&binLength, sizeof(binLength));
+		cacheWriter.write(bin.data(), binLength);
+		cacheWriter.close();
+	}
+
+	return retShader;
+}
 GLuint LoadTexture(const std::string& file)
 {
 	int width, height, nrChannels;
@@ -0,0 +1,100 @@
+#
+# Runs the projects in bin/benchmarks with the headless benchmark mode and
+# compares the results with the previous run.
+#
+# Used by the SHADERed-bench target, but it can be run directly:
+#   cmake -DSHADERED=bin/SHADERed -DBENCHMARK_DIR=bin/benchmarks -DBASELINE_DIR=build/bench -P cmake/RunBenchmarks.cmake
+#
+# The following variables can be set as arguments for the script.
+# - SHADERED : path to the SHADERed executable
+# - BENCHMARK_DIR : directory with the benchmark projects (every subdirectory contains <name>/<name>.sprj)
+# - BASELINE_DIR : directory where the reports are stored - the first report of a project becomes its baseline
+# - THRESHOLD : allowed slowdown in percent, 10 by default
+# - WARMUP, FRAMES, SIZE : passed to SHADERed --render, 60, 300 and 1280x720 by default
+# - UPDATE_BASELINE : replace the baselines with the new results
+#
+
+if (NOT THRESHOLD)
+	set(THRESHOLD 10)
+endif()
+if (NOT WARMUP)
+	set(WARMUP 60)
+endif()
+if (NOT FRAMES)
+	set(FRAMES 300)
+endif()
+if (NOT SIZE)
+	set(SIZE 1280x720)
+endif()
+
+file(MAKE_DIRECTORY "${BASELINE_DIR}")
+file(GLOB BENCHMARKS RELATIVE "${BENCHMARK_DIR}" "${BENCHMARK_DIR}/*")
+
+# reads the average of a timing from a report written by SHADERed --benchmark
+function(read_average REPORT METRIC OUT)
+	file(READ "${REPORT}" CONTENTS)
+	string(REGEX MATCH "\"${METRIC}\": { \"min\": [^,]+, \"average\": ([^,]+)," MATCHED "${CONTENTS}")
+	set(${OUT} "${CMAKE_MATCH_1}" PARENT_SCOPE)
+endfunction()
+
+# cmake has no floating point math - timings are compared in microseconds
+function(to_microseconds VALUE OUT)
+	string(REGEX MATCH "^[0-9]+" INTEGER "${VALUE}")
+	string(REGEX MATCH "\\.[0-9]+" FRACTION "${VALUE}")
+	string(SUBSTRING "${FRACTION}0000" 1 3 FRACTION)
+	math(EXPR RESULT "${INTEGER} * 1000 + 1${FRACTION} - 1000")
+	set(${OUT} ${RESULT} PARENT_SCOPE)
+endfunction()
+
+set(FAILED "")
+foreach (NAME ${BENCHMARKS})
+	set(PROJECT "${BENCHMARK_DIR}/${NAME}/${NAME}.sprj")
+	if (NOT EXISTS "${PROJECT}")
+		continue()
+	endif()
+
+	set(REPORT "${BASELINE_DIR}/${NAME}.json")
+	set(BASELINE "${BASELINE_DIR}/${NAME}.baseline.json")
+
+	execute_process(
+		COMMAND "${SHADERED}" --render "${PROJECT}" --benchmark "${REPORT}" --warmup ${WARMUP} --frames ${FRAMES} --size ${SIZE}
+		RESULT_VARIABLE RESULT
+		OUTPUT_QUIET)
+	if (NOT RESULT EQUAL 0)
+		message(SEND_ERROR "${NAME}: SHADERed failed with exit code ${RESULT}")
+		list(APPEND FAILED ${NAME})
+		continue()
+	endif()
+
+	if (UPDATE_BASELINE OR NOT EXISTS "${BASELINE}")
+		configure_file("${REPORT}" "${BASELINE}" COPYONLY)
+		message(STATUS "${NAME}: stored as the baseline")
+		continue()
+	endif()
+
+	foreach (METRIC cpu_frame_ms gpu_frame_ms)
+		read_average("${REPORT}" ${METRIC} CURRENT)
+		read_average("${BASELINE}" ${METRIC} PREVIOUS)
+		if (CURRENT STREQUAL "" OR PREVIOUS STREQUAL "")
+			message(SEND_ERROR "${NAME}: ${METRIC} is missing from the report")
+			list(APPEND FAILED ${NAME})
+			continue()
+		endif()
+
+		to_microseconds("${CURRENT}" CURRENT_US)
+		to_microseconds("${PREVIOUS}" PREVIOUS_US)
+
+		math(EXPR LIMIT_US "${PREVIOUS_US} * (100 + ${THRESHOLD}) / 100")
+		if (CURRENT_US GREATER LIMIT_US)
+			message(SEND_ERROR "${NAME}: ${METRIC} went from ${PREVIOUS} to ${CURRENT} (more than ${THRESHOLD}% slower)")
+			list(APPEND FAILED ${NAME})
+		else()
+			message(STATUS "${NAME}: ${METRIC} ${CURRENT} (baseline ${PREVIOUS})")
+		endif()
+	endforeach()
+endforeach()
+
+if (FAILED)
+	list(REMOVE_DUPLICATES FAILED)
+	message(FATAL_ERROR "Benchmarks that regressed or failed: ${FAILED}")
+endif()
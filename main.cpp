@@ -3,12 +3,20 @@
 #endif
 
 #include <SDL2/SDL.h>
-#include <glslang/Public/ShaderLang.h>
 #include "Objects/AudioShaderStream.h"
 #include "Objects/Settings.h"
 #include "Objects/Logger.h"
+#include "Objects/UIRefresh.h"
+#include "Objects/RenderDocCapture.h"
+#include "Objects/ProfilerZones.h"
+#include "Objects/FrameProfiler.h"
+#include "Objects/TraceRecorder.h"
+#include "Objects/StartupTimeline.h"
+#include "Objects/ShaderTranscompiler.h"
 #include "EditorEngine.h"
+#include "HeadlessRenderer.h"
 #include "Engine/GeometryFactory.h"
+#include "Engine/FramePacer.h"
 
 #include <thread>
 #include <chrono>
@@ -76,6 +84,8 @@ void setIcon(SDL_Window* wnd)
 
 int main(int argc, char* argv[])
 {
+	ed::StartupTimeline& startup = ed::StartupTimeline::Instance(); // measured from here
+
 	ghc::filesystem::path cmdDir = ghc::filesystem::current_path();
 	if (argc > 0) {
 		if (ghc::filesystem::exists(ghc::filesystem::path(argv[0]).parent_path())) {
@@ -88,7 +98,7 @@ int main(int argc, char* argv[])
 #if defined(__linux__) || defined(__unix__)
 	// currently the only supported argument is a path to set the working directory... dont do this check if user wants to explicitly set the working directory,
 	// TODO: if more arguments get added, use different methods to check if working directory is being set explicitly
-	if (argc <= 1) { 
+	if (argc <= 1 || ed::HeadlessRenderer::IsRequested(argc, argv)) { 
 		char result[PATH_MAX];
 		ssize_t readlinkRes = readlink("/proc/self/exe", result, PATH_MAX);
 		std::string exePath = "";
@@ -125,23 +135,33 @@ int main(int argc, char* argv[])
 	stbi_flip_vertically_on_write(1);
 	stbi_set_flip_vertically_on_load(1);
 
-	// start glslang process
-	bool glslangInit = glslang::InitializeProcess();
-	ed::Logger::Get().Log("Initializing glslang...");
+	startup.Mark("Working directory");
+
+	// render the project given through --render without creating the UI (glslang is initialized when it's first needed)
+	if (ed::HeadlessRenderer::IsRequested(argc, argv)) {
+		ed::HeadlessRenderer headless;
+		int ret = headless.ParseArguments(argc, argv, cmdDir.generic_string()) ? headless.Run() : 1;
 
-	if (glslangInit)
-		ed::Logger::Get().Log("Finished glslang initialization");
-	else
-		ed::Logger::Get().Log("Failed to initialize glslang", true);
+		ed::Logger::Get().Save();
 
+		return ret;
+	}
 	
+	// glslang is only needed once the first HLSL/Vulkan shader is transcompiled
+	ed::Logger::Get().Log("Initializing glslang in the background...");
+	std::thread glslangInit(ed::ShaderTranscompiler::Initialize);
+
 	// init sdl2
 	if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER | SDL_INIT_AUDIO) < 0) {
 		ed::Logger::Get().Log("Failed to initialize SDL2", true);
 		ed::Logger::Get().Save();
+		glslangInit.join();
 		return 0;
 	} else
 		ed::Logger::Get().Log("Initialized SDL2");
+	startup.Mark("SDL2");
+
+	ed::UIRefresh::Instance().Init();
 
 	// load window size
 	short wndWidth = 800, wndHeight = 600, wndPosX = -1, wndPosY = -1;
@@ -193,6 +213,11 @@ int main(int argc, char* argv[])
 		SDL_MaximizeWindow(wnd);
 	if (fullscreen)
 		SDL_SetWindowFullscreen(wnd, SDL_WINDOW_FULLSCREEN_DESKTOP);
+	startup.Mark("Window");
+
+	// renderdoc has to hook the GL functions before the context is created
+	ed::Settings::Instance().Load();
+	ed::RenderDocCapture::Instance().Init(ed::Settings::Instance().Debug.RenderDoc);
 
 	// get GL context
 	SDL_GLContext glContext = SDL_GL_CreateContext(wnd);
@@ -205,9 +230,13 @@ int main(int argc, char* argv[])
 	if (glewInit() != GLEW_OK) {
 		ed::Logger::Get().Log("Failed to initialize GLEW", true);
 		ed::Logger::Get().Save();
+		glslangInit.join();
 		return 0;
 	} else
 		ed::Logger::Get().Log("Initialized GLEW");
+	startup.Mark("OpenGL context");
+
+	ED_GPU_CONTEXT();
 
 	// create engine
 	ed::EditorEngine engine(wnd, &glContext);
@@ -224,6 +253,7 @@ int main(int argc, char* argv[])
 			engine.UI().Open(argv[1]);
 		else if (ghc::filesystem::exists(argFile))
 			engine.UI().Open(argFile.c_str());
+		startup.Mark("Opening " + std::string(argv[1]));
 	}
 
 	engine.UI().SetPerformanceMode(perfMode);
@@ -231,13 +261,41 @@ int main(int argc, char* argv[])
 
 	// timer for time delta
 	ed::eng::Timer timer;
+	ed::eng::FramePacer pacer; // whole app FPS limit
 	SDL_Event event;
 	bool run = true;
-	bool minimized = false;
+	bool minimized = false, hidden = false;
 	bool hasFocus = true;
+	int idleFrames = 0; // frames in a row without any events
+	bool startupCompiled = false;
 	while (run) {
+		// the preview can't change until something happens - give ImGui a few frames to settle and then sleep until the next
+		// event (the timeout keeps the file watchers and other background work going)
+		ed::RenderEngine& renderer = engine.Interface().Renderer;
+		ed::Settings& settings = ed::Settings::Instance();
+		bool idle = idleFrames >= 3 && !renderer.IsCompiling() && !engine.Interface().Objects.IsLoading() && (renderer.IsPaused() || renderer.CanReuseFrame());
+		if (idle && settings.General.EventDrivenUI) {
+			// the UI isn't rebuilt at all until there's input or something asked for a refresh (file watcher, background compile...)
+			ed::UIRefresh& refresh = ed::UIRefresh::Instance();
+			ed::FrameProfiler::Scope idleScope(ed::FrameProfiler::Idle);
+			if (!SDL_WaitEventTimeout(nullptr, refresh.GetTimeout(UI_IDLE_TIMEOUT)) && !refresh.IsDue()) {
+				timer.Restart();
+				continue;
+			}
+		}
+		else if (idle && settings.Preview.SkipIdleFrames) {
+			ed::FrameProfiler::Scope idleScope(ed::FrameProfiler::Idle);
+			SDL_WaitEventTimeout(nullptr, 250);
+		}
+		idleFrames++;
+
+		ed::FrameProfiler& frameProfiler = ed::FrameProfiler::Instance();
+		auto eventStart = std::chrono::steady_clock::now();
 		while (SDL_PollEvent(&event))
 		{
+			idleFrames = 0;
+			renderer.InvalidateFrame();
+
 			if (event.type == SDL_QUIT) {
 				bool cont = true;
 				if (engine.Interface().Parser.IsProjectModified()) {
@@ -273,6 +331,12 @@ int main(int argc, char* argv[])
 				}
 				else if (event.window.event == SDL_WINDOWEVENT_MINIMIZED)
 					minimized = true;
+				else if (event.window.event == SDL_WINDOWEVENT_RESTORED)
+					minimized = false;
+				else if (event.window.event == SDL_WINDOWEVENT_HIDDEN)
+					hidden = true;
+				else if (event.window.event == SDL_WINDOWEVENT_SHOWN || event.window.event == SDL_WINDOWEVENT_EXPOSED)
+					hidden = false;
 				else if (event.window.event == SDL_WINDOWEVENT_FOCUS_LOST)
 					hasFocus = false;
 				else if (event.window.event == SDL_WINDOWEVENT_FOCUS_GAINED)
@@ -280,24 +344,69 @@ int main(int argc, char* argv[])
 			}
 			engine.OnEvent(event);
 		}
+		frameProfiler.Add(ed::FrameProfiler::Events, eventStart);
 
 		if (!run) break;
 
+		// nothing is drawn or presented while the window can't be seen, the preview only runs its background passes
+		bool visible = !minimized && !hidden;
+		engine.UI().SetWindowVisible(visible);
+
 		float delta = timer.Restart();
-		engine.Update(delta);
+		{
+			ed::FrameProfiler::Scope uiScope(ed::FrameProfiler::UI);
+			engine.Update(delta);
+		}
+
+		{
+			ed::FrameProfiler::Scope drawScope(ed::FrameProfiler::Draw);
+
+			if (visible) {
+				glBindFramebuffer(GL_FRAMEBUFFER, 0);
+				glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+			}
 
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+			engine.Render();
+		}
 
-		engine.Render();
+		// without the wait the GPU time would be a part of the swap (or of some later GL call)
+		if (frameProfiler.IsEnabled() && visible) {
+			ed::FrameProfiler::Scope gpuScope(ed::FrameProfiler::GPUWait);
+			GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+			glDeleteSync(fence);
+		}
 
-		SDL_GL_SwapWindow(wnd);
+		if (visible) {
+			ed::FrameProfiler::Scope swapScope(ed::FrameProfiler::Swap);
+			SDL_GL_SwapWindow(wnd);
+		}
+		ED_GPU_COLLECT();
+		ED_FRAME();
+
+		// the shaders of the template/project are still compiling in the background at this point
+		if (!startup.IsFinished())
+			startup.Finish();
+		else if (!startupCompiled && !renderer.IsCompiling()) {
+			startup.MarkBackground("Shader compilation");
+			startupCompiled = true;
+		}
 
-		if (minimized && delta * 1000 < 33)
-			std::this_thread::sleep_for(std::chrono::milliseconds(33 - (int)(delta * 1000)));
-		else if (!hasFocus && ed::Settings::Instance().Preview.LostFocusLimitFPS && delta * 1000 < 16)
-			std::this_thread::sleep_for(std::chrono::milliseconds(16 - (int)(delta * 1000)));
+		if (!visible)
+			pacer.SetTarget(30.0f);
+		else if (settings.Preview.ApplyFPSLimitToApp && settings.Preview.FPSLimit > 0)
+			pacer.SetTarget(settings.Preview.FPSLimit);
+		else if (!hasFocus && settings.Preview.LostFocusLimitFPS)
+			pacer.SetTarget(60.0f);
+		else
+			pacer.SetTarget(0.0f);
+		{
+			ed::FrameProfiler::Scope idleScope(ed::FrameProfiler::Idle);
+			pacer.Wait();
+		}
+		frameProfiler.EndFrame();
+		ed::TraceRecorder::Instance().EndFrame();
 	}
 
 	// union for converting short to bytes
@@ -337,6 +446,8 @@ int main(int argc, char* argv[])
 
 	ed::Logger::Get().Log("Destroyed EditorEngine and SDL2");
 
+	glslangInit.join();
+
 	ed::Logger::Get().Save();
 
 	return 0;